@@ -70,7 +70,7 @@ endif
 LOCAL_LDLIBS	:= -L$(SYSROOT)/usr/lib -landroid -lEGL $(GLES_LIB) $(LOGGER_LDLIBS) -ldl
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/$(RARCH_DIR)/libretro-common/include/
 
-LOCAL_CFLAGS += -DHAVE_SL
+LOCAL_CFLAGS += -DHAVE_SL -DHAVE_AAUDIO
 LOCAL_LDLIBS += -lOpenSLES -lz
 
 include $(BUILD_SHARED_LIBRARY)
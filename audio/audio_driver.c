@@ -19,11 +19,28 @@
 #include "audio_driver.h"
 #include "audio_utils.h"
 #include "audio_thread_wrapper.h"
+#include "audio_profiler.h"
+#include "../performance.h"
 #include "../driver.h"
 #include "../general.h"
 #include "../retroarch.h"
 #include "../runloop.h"
 
+/* Gains of the rate control loop. The error is the distance of the 
+ * driver buffer from half full, normalised to [-1, 1], and the output 
+ * is scaled by audio_rate_control_delta. The integral term soaks up 
+ * constant clock drift, so the proportional term only has to deal 
+ * with jitter and the buffer settles at half full. */
+#define AUDIO_RATE_CONTROL_KP 2.0
+#define AUDIO_RATE_CONTROL_KI 0.004
+
+/* write_avail moves in steps of the driver period, smooth it 
+ * a little so that does not turn into pitch wobble. */
+#define AUDIO_RATE_CONTROL_SMOOTHING 0.125
+
+/* How often the audio_show_stats OSD line is updated, in frames. */
+#define AUDIO_STATS_FRAMES 60
+
 static const audio_driver_t *audio_drivers[] = {
 #ifdef HAVE_ALSA
    &audio_alsa,
@@ -43,6 +60,9 @@ static const audio_driver_t *audio_drivers[] = {
 #ifdef HAVE_AL
    &audio_openal,
 #endif
+#ifdef HAVE_AAUDIO
+   &audio_aaudio,
+#endif
 #ifdef HAVE_SL
    &audio_opensl,
 #endif
@@ -61,6 +81,9 @@ static const audio_driver_t *audio_drivers[] = {
 #ifdef HAVE_DSOUND
    &audio_dsound,
 #endif
+#ifdef HAVE_WASAPI
+   &audio_wasapi,
+#endif
 #ifdef HAVE_PULSE
    &audio_pulse,
 #endif
@@ -93,16 +116,9 @@ static const audio_driver_t * audio_get_ptr(const driver_t *driver)
    return NULL;
 }
 
-/**
- * compute_audio_buffer_statistics:
- *
- * Computes audio buffer statistics.
- *
- **/
-static void compute_audio_buffer_statistics(void)
+bool compute_audio_buffer_statistics(audio_statistics_t *stats)
 {
    unsigned i, low_water_size, high_water_size, avg, stddev;
-   float avg_filled, deviation;
    uint64_t accum = 0, accum_var = 0;
    unsigned low_water_count = 0, high_water_count = 0;
    unsigned samples = 0;
@@ -112,8 +128,8 @@ static void compute_audio_buffer_statistics(void)
    samples = min(runloop->measure_data.buffer_free_samples_count,
          AUDIO_BUFFER_FREE_SAMPLES_COUNT);
 
-   if (samples < 3)
-      return;
+   if (samples < 3 || !global->audio_data.driver_buffer_size)
+      return false;
 
    for (i = 1; i < samples; i++)
       accum += runloop->measure_data.buffer_free_samples[i];
@@ -127,8 +143,6 @@ static void compute_audio_buffer_statistics(void)
    }
 
    stddev          = (unsigned)sqrt((double)accum_var / (samples - 2));
-   avg_filled      = 1.0f - (float)avg / global->audio_data.driver_buffer_size;
-   deviation       = (float)stddev / global->audio_data.driver_buffer_size;
 
    low_water_size  = global->audio_data.driver_buffer_size * 3 / 4;
    high_water_size = global->audio_data.driver_buffer_size / 4;
@@ -141,11 +155,26 @@ static void compute_audio_buffer_statistics(void)
          high_water_count++;
    }
 
-   RARCH_LOG("Average audio buffer saturation: %.2f %%, standard deviation (percentage points): %.2f %%.\n",
-         avg_filled * 100.0, deviation * 100.0);
-   RARCH_LOG("Amount of time spent close to underrun: %.2f %%. Close to blocking: %.2f %%.\n",
-         (100.0 * low_water_count) / (samples - 1),
-         (100.0 * high_water_count) / (samples - 1));
+   stats->average_buffer_saturation = (1.0f - 
+         (float)avg / global->audio_data.driver_buffer_size) * 100.0;
+   stats->std_deviation_percentage  = 
+      (float)stddev / global->audio_data.driver_buffer_size * 100.0;
+   stats->current_buffer_saturation = (1.0f - (float)
+         runloop->measure_data.buffer_free_samples[
+         (runloop->measure_data.buffer_free_samples_count - 1) &
+         (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1)] /
+         global->audio_data.driver_buffer_size) * 100.0;
+   stats->close_to_underrun         = 
+      (100.0 * low_water_count) / (samples - 1);
+   stats->close_to_blocking         = 
+      (100.0 * high_water_count) / (samples - 1);
+   stats->underruns                 = global->audio_data.underruns;
+   stats->overruns                  = global->audio_data.overruns;
+   stats->rate_adjust               = global->audio_data.src_ratio /
+      global->audio_data.orig_src_ratio;
+   stats->samples                   = samples;
+
+   return true;
 }
 
 /**
@@ -253,17 +282,32 @@ void uninit_audio(void)
    driver_t *driver     = driver_get_ptr();
    global_t *global     = global_get_ptr();
    settings_t *settings = config_get_ptr();
+   audio_statistics_t stats;
+
+#ifdef HAVE_THREADS
+   /* Joins the audio thread before anything it uses goes away. */
+   audio_thread_dsp_deinit();
+   global->audio_data.threaded_dsp = false;
+#endif
 
    if (driver->audio_data && driver->audio)
       driver->audio->free(driver->audio_data);
 
    free(global->audio_data.conv_outsamples);
    global->audio_data.conv_outsamples = NULL;
+
+   free(global->audio_data.sample_buf);
+   global->audio_data.sample_buf      = NULL;
+   global->audio_data.sample_buf_size = 0;
    global->audio_data.data_ptr        = 0;
 
    free(global->audio_data.rewind_buf);
    global->audio_data.rewind_buf = NULL;
 
+   free(global->audio_data.rewind_history);
+   global->audio_data.rewind_history       = NULL;
+   global->audio_data.rewind_history_avail = 0;
+
    if (!settings->audio.enable)
    {
       driver->audio_active = false;
@@ -281,7 +325,15 @@ void uninit_audio(void)
 
    event_command(EVENT_CMD_DSP_FILTER_DEINIT);
 
-   compute_audio_buffer_statistics();
+   if (compute_audio_buffer_statistics(&stats))
+   {
+      RARCH_LOG("Average audio buffer saturation: %.2f %%, standard deviation (percentage points): %.2f %%.\n",
+            stats.average_buffer_saturation, stats.std_deviation_percentage);
+      RARCH_LOG("Amount of time spent close to underrun: %.2f %%. Close to blocking: %.2f %%.\n",
+            stats.close_to_underrun, stats.close_to_blocking);
+      RARCH_LOG("Audio underruns: %u, overruns: %u. Final rate adjustment: %.5f.\n",
+            stats.underruns, stats.overruns, stats.rate_adjust);
+   }
 }
 
 void init_audio(void)
@@ -309,6 +361,16 @@ void init_audio(void)
    if (!global->audio_data.conv_outsamples)
       goto error;
 
+   /* Holds about a frame of per-sample audio, see audio_sample(). */
+   rarch_assert(global->audio_data.sample_buf =
+         (int16_t*)malloc(max_bufsamples * sizeof(int16_t)));
+
+   if (!global->audio_data.sample_buf)
+      goto error;
+
+   global->audio_data.sample_buf_size     = max_bufsamples;
+   global->audio_data.data_ptr            = 0;
+
    global->audio_data.block_chunk_size    = AUDIO_CHUNK_SIZE_BLOCKING;
    global->audio_data.nonblock_chunk_size = AUDIO_CHUNK_SIZE_NONBLOCKING;
    global->audio_data.chunk_size          = global->audio_data.block_chunk_size;
@@ -323,6 +385,14 @@ void init_audio(void)
 
    global->audio_data.rewind_size             = max_bufsamples;
 
+   /* Not having it only makes rewind sound worse. */
+   global->audio_data.rewind_history = (int16_t*)
+      malloc(AUDIO_REWIND_HISTORY_SIZE * sizeof(int16_t));
+   global->audio_data.rewind_history_size  = 
+      global->audio_data.rewind_history ? AUDIO_REWIND_HISTORY_SIZE : 0;
+   global->audio_data.rewind_history_ptr   = 0;
+   global->audio_data.rewind_history_avail = 0;
+
    if (!settings->audio.enable)
    {
       driver->audio_active = false;
@@ -356,6 +426,8 @@ void init_audio(void)
       RARCH_ERR("Failed to initialize audio driver. Will continue without audio.\n");
       driver->audio_active = false;
    }
+   else
+      audio_profiler_init(settings->audio.driver);
 
    global->audio_data.use_float = false;
    if (driver->audio_active && driver->audio->use_float(driver->audio_data))
@@ -382,7 +454,8 @@ void init_audio(void)
 
    if (!rarch_resampler_realloc(&driver->resampler_data,
             &driver->resampler,
-         settings->audio.resampler, global->audio_data.orig_src_ratio))
+         settings->audio.resampler, global->audio_data.orig_src_ratio,
+         (enum resampler_quality)settings->audio.resampler_quality))
    {
       RARCH_ERR("Failed to initialize resampler \"%s\".\n",
             settings->audio.resampler);
@@ -424,6 +497,19 @@ void init_audio(void)
    event_command(EVENT_CMD_DSP_FILTER_INIT);
 
    runloop->measure_data.buffer_free_samples_count = 0;
+   global->audio_data.rate_control_error           = 0.0;
+   global->audio_data.rate_control_integral        = 0.0;
+   global->audio_data.last_write_size              = 0;
+   global->audio_data.underruns                    = 0;
+   global->audio_data.overruns                     = 0;
+
+#ifdef HAVE_THREADS
+   global->audio_data.threaded_dsp = false;
+   if (driver->audio_active && settings->audio.threaded_dsp &&
+         !global->system.audio_callback.callback)
+      global->audio_data.threaded_dsp = audio_thread_dsp_init(
+            global->audio_data.sample_buf_size);
+#endif
 
    if (driver->audio_active && !settings->audio.mute_enable &&
          global->system.audio_callback.callback)
@@ -438,12 +524,19 @@ error:
    if (global->audio_data.conv_outsamples)
       free(global->audio_data.conv_outsamples);
    global->audio_data.conv_outsamples = NULL;
+   if (global->audio_data.sample_buf)
+      free(global->audio_data.sample_buf);
+   global->audio_data.sample_buf      = NULL;
+   global->audio_data.sample_buf_size = 0;
    if (global->audio_data.data)
       free(global->audio_data.data);
    global->audio_data.data = NULL;
    if (global->audio_data.rewind_buf)
       free(global->audio_data.rewind_buf);
    global->audio_data.rewind_buf = NULL;
+   if (global->audio_data.rewind_history)
+      free(global->audio_data.rewind_history);
+   global->audio_data.rewind_history = NULL;
    if (global->audio_data.outsamples)
       free(global->audio_data.outsamples);
    global->audio_data.outsamples = NULL;
@@ -478,10 +571,46 @@ static int audio_driver_write_avail(void)
    return audio->write_avail(driver->audio_data);
 }
 
+/**
+ * audio_driver_show_stats:
+ *
+ * Shows driver buffer fill, rate adjustment and underrun/overrun 
+ * counts on screen if audio_show_stats is enabled.
+ **/
+static void audio_driver_show_stats(void)
+{
+   char msg[128];
+   audio_statistics_t stats;
+   runloop_t *runloop   = rarch_main_get_ptr();
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->audio.show_stats ||
+         runloop->measure_data.buffer_free_samples_count % AUDIO_STATS_FRAMES)
+      return;
+
+   if (!compute_audio_buffer_statistics(&stats))
+      return;
+
+   snprintf(msg, sizeof(msg),
+         "Audio: %.0f%% full (avg %.1f%%, sd %.1f%%), rate x%.5f, "
+         "%u underruns, %u overruns",
+         stats.current_buffer_saturation, stats.average_buffer_saturation,
+         stats.std_deviation_percentage, stats.rate_adjust,
+         stats.underruns, stats.overruns);
+   rarch_main_msg_queue_push(msg, 1, AUDIO_STATS_FRAMES, true);
+}
+
 /*
  * audio_driver_readjust_input_rate:
  *
- * Readjust the audio input rate.
+ * Readjust the audio input rate to keep the driver 
+ * buffer half full.
+ *
+ * This is a PI controller over the buffer fill. The output is 
+ * clamped to [-1, 1] before scaling by audio_rate_control_delta, so 
+ * the pitch never moves by more than that. The integral stops 
+ * growing while the output is clamped, so it can't wind up during 
+ * long stalls.
  */
 void audio_driver_readjust_input_rate(void)
 {
@@ -492,22 +621,51 @@ void audio_driver_readjust_input_rate(void)
       (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1);
    int      half_size   = global->audio_data.driver_buffer_size / 2;
    int      avail       = audio_driver_write_avail();
-   int      delta_mid   = avail - half_size;
-   double   direction   = (double)delta_mid / half_size;
-   double   adjust      = 1.0 + settings->audio.rate_control_delta * direction;
+   double   error       = (double)(avail - half_size) / half_size;
+   double   integral    = global->audio_data.rate_control_integral;
+   double   control;
+   bool     underrun    = avail >= (int)global->audio_data.driver_buffer_size;
+   bool     overrun     = !underrun &&
+      avail < (int)global->audio_data.last_write_size;
+
+   if (underrun)
+      global->audio_data.underruns++;
+   else if (overrun)
+      global->audio_data.overruns++;
+
+   audio_profiler_fill(underrun ? 0 : (unsigned)(100 - (100.0 * avail) /
+            global->audio_data.driver_buffer_size), underrun, overrun);
 
 #if 0
    RARCH_LOG_OUTPUT("Audio buffer is %u%% full\n",
          (unsigned)(100 - (avail * 100) / global->audio_data.driver_buffer_size));
 #endif
 
+   global->audio_data.rate_control_error += AUDIO_RATE_CONTROL_SMOOTHING *
+      (error - global->audio_data.rate_control_error);
+   error   = global->audio_data.rate_control_error;
+
+   control = AUDIO_RATE_CONTROL_KP * error + integral;
+   if (!(control >= 1.0 && error > 0.0) && !(control <= -1.0 && error < 0.0))
+   {
+      integral += AUDIO_RATE_CONTROL_KI * error;
+      integral  = max(min(integral, 1.0), -1.0);
+      control   = AUDIO_RATE_CONTROL_KP * error + integral;
+   }
+   control = max(min(control, 1.0), -1.0);
+
+   global->audio_data.rate_control_integral = integral;
+
    runloop->measure_data.buffer_free_samples[write_idx] = avail;
-   global->audio_data.src_ratio = global->audio_data.orig_src_ratio * adjust;
+   global->audio_data.src_ratio = global->audio_data.orig_src_ratio *
+      (1.0 + settings->audio.rate_control_delta * control);
 
 #if 0
    RARCH_LOG_OUTPUT("New rate: %lf, Orig rate: %lf\n",
          global->audio_data.src_ratio, global->audio_data.orig_src_ratio);
 #endif
+
+   audio_driver_show_stats();
 }
 
 bool audio_driver_alive(void)
@@ -521,18 +679,36 @@ bool audio_driver_alive(void)
 
 bool audio_driver_start(void)
 {
+   bool ret;
    driver_t *driver      = driver_get_ptr();
    const audio_driver_t *audio = audio_get_ptr(driver);
 
-   return audio->start(driver->audio_data);
+#ifdef HAVE_THREADS
+   audio_thread_dsp_lock();
+#endif
+   ret = audio->start(driver->audio_data);
+#ifdef HAVE_THREADS
+   audio_thread_dsp_unlock();
+#endif
+
+   return ret;
 }
 
 bool audio_driver_stop(void)
 {
+   bool ret;
    driver_t *driver      = driver_get_ptr();
    const audio_driver_t *audio = audio_get_ptr(driver);
 
-   return audio->stop(driver->audio_data);
+#ifdef HAVE_THREADS
+   audio_thread_dsp_lock();
+#endif
+   ret = audio->stop(driver->audio_data);
+#ifdef HAVE_THREADS
+   audio_thread_dsp_unlock();
+#endif
+
+   return ret;
 }
 
 void audio_driver_set_nonblock_state(bool toggle)
@@ -540,13 +716,30 @@ void audio_driver_set_nonblock_state(bool toggle)
    driver_t *driver     = driver_get_ptr();
    const audio_driver_t *audio = audio_get_ptr(driver);
 
+   if (!audio || !driver->audio_data)
+      return;
+
+#ifdef HAVE_THREADS
+   audio_thread_dsp_lock();
+#endif
    audio->set_nonblock_state(driver->audio_data, toggle);
+#ifdef HAVE_THREADS
+   audio_thread_dsp_unlock();
+#endif
 }
 
 ssize_t audio_driver_write(const void *buf, size_t size)
 {
    driver_t *driver      = driver_get_ptr();
+   global_t *global      = global_get_ptr();
    const audio_driver_t *audio = audio_get_ptr(driver);
+   retro_time_t start          = rarch_get_time_usec();
+   ssize_t ret                 = 0;
+
+   global->audio_data.last_write_size = size;
+
+   ret = audio->write(driver->audio_data, buf, size);
+   audio_profiler_write(rarch_get_time_usec() - start);
 
-   return audio->write(driver->audio_data, buf, size);
+   return ret;
 }
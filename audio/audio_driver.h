@@ -79,11 +79,13 @@ extern audio_driver_t audio_alsathread;
 extern audio_driver_t audio_roar;
 extern audio_driver_t audio_openal;
 extern audio_driver_t audio_opensl;
+extern audio_driver_t audio_aaudio;
 extern audio_driver_t audio_jack;
 extern audio_driver_t audio_sdl;
 extern audio_driver_t audio_xa;
 extern audio_driver_t audio_pulse;
 extern audio_driver_t audio_dsound;
+extern audio_driver_t audio_wasapi;
 extern audio_driver_t audio_coreaudio;
 extern audio_driver_t audio_xenon360;
 extern audio_driver_t audio_ps3;
@@ -113,10 +115,41 @@ const char *audio_driver_find_ident(int index);
 
 bool audio_driver_mute_toggle(void);
 
+typedef struct audio_statistics
+{
+   /* Driver buffer fill, in percent. */
+   float average_buffer_saturation;
+   float std_deviation_percentage;
+   float current_buffer_saturation;
+   /* Share of samples with the buffer less than a quarter
+    * full or more than three quarters full, in percent. */
+   float close_to_underrun;
+   float close_to_blocking;
+   unsigned underruns;
+   unsigned overruns;
+   /* Current resampling ratio relative to the nominal one. */
+   double rate_adjust;
+   unsigned samples;
+} audio_statistics_t;
+
+/**
+ * compute_audio_buffer_statistics:
+ * @stats              : filled in with the statistics.
+ *
+ * Computes driver buffer statistics over the most recent 
+ * AUDIO_BUFFER_FREE_SAMPLES_COUNT frames. Only gathered 
+ * while audio rate control is active.
+ *
+ * Returns: true (1) if enough samples were available, 
+ * otherwise false (0).
+ **/
+bool compute_audio_buffer_statistics(audio_statistics_t *stats);
+
 /*
  * audio_driver_readjust_input_rate:
  *
- * Readjust the audio input rate.
+ * Readjust the audio input rate to keep the driver 
+ * buffer half full.
  */
 void audio_driver_readjust_input_rate(void);
 
@@ -37,6 +37,10 @@ struct chorus_data
    float mix_wet;
    unsigned lfo_ptr;
    unsigned lfo_period;
+
+   // The LFO is a rotating phasor, which saves a sin() per frame.
+   double lfo_cos, lfo_sin;
+   double lfo_rot_cos, lfo_rot_sin;
 };
 
 static void chorus_free(void *data)
@@ -58,10 +62,22 @@ static void chorus_process(void *data, struct dspfilter_output *output,
    {
       float in[2] = { out[0], out[1] };
 
-      float delay = ch->delay + ch->depth * sin((2.0 * M_PI * ch->lfo_ptr++) / ch->lfo_period);
+      float delay = ch->delay + ch->depth * ch->lfo_sin;
       delay *= ch->input_rate;
-      if (ch->lfo_ptr >= ch->lfo_period)
+
+      if (++ch->lfo_ptr >= ch->lfo_period)
+      {
+         // Restart from an exact phase so rounding can't build up.
          ch->lfo_ptr = 0;
+         ch->lfo_cos = 1.0;
+         ch->lfo_sin = 0.0;
+      }
+      else
+      {
+         double lfo_cos = ch->lfo_cos * ch->lfo_rot_cos - ch->lfo_sin * ch->lfo_rot_sin;
+         ch->lfo_sin    = ch->lfo_sin * ch->lfo_rot_cos + ch->lfo_cos * ch->lfo_rot_sin;
+         ch->lfo_cos    = lfo_cos;
+      }
 
       unsigned delay_int = (unsigned)delay;
       if (delay_int >= CHORUS_MAX_DELAY - 1)
@@ -120,6 +136,11 @@ static void *chorus_init(const struct dspfilter_info *info,
    ch->input_rate = info->input_rate;
    if (!ch->lfo_period)
       ch->lfo_period = 1;
+
+   ch->lfo_cos     = 1.0;
+   ch->lfo_sin     = 0.0;
+   ch->lfo_rot_cos = cos(2.0 * M_PI / ch->lfo_period);
+   ch->lfo_rot_sin = sin(2.0 * M_PI / ch->lfo_period);
    return ch;
 }
 
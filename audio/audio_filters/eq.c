@@ -40,6 +40,7 @@ struct eq_data
    fft_complex_t *fftblock;
    unsigned block_size;
    unsigned block_ptr;
+   bool simd;
 };
 
 struct eq_gain
@@ -62,6 +63,33 @@ static void eq_free(void *data)
    free(eq);
 }
 
+static void eq_apply_filter(struct eq_data *eq)
+{
+   unsigned i = 0;
+   unsigned samples = 2 * eq->block_size;
+   fft_complex_t *block = eq->fftblock;
+   const fft_complex_t *filter = eq->filter;
+
+#if defined(FFT_SIMD_SSE2)
+   if (eq->simd)
+   {
+      for (; i + 2 <= samples; i += 2)
+         _mm_storeu_ps(&block[i].real, fft_complex_mul_sse(
+                  _mm_loadu_ps(&block[i].real), _mm_loadu_ps(&filter[i].real)));
+   }
+#elif defined(FFT_SIMD_NEON)
+   if (eq->simd)
+   {
+      for (; i + 2 <= samples; i += 2)
+         vst1q_f32(&block[i].real, fft_complex_mul_neon(
+                  vld1q_f32(&block[i].real), vld1q_f32(&filter[i].real)));
+   }
+#endif
+
+   for (; i < samples; i++)
+      block[i] = fft_complex_mul(block[i], filter[i]);
+}
+
 static void eq_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
@@ -89,15 +117,16 @@ static void eq_process(void *data, struct dspfilter_output *output,
       // Convolve a new block.
       if (eq->block_ptr == eq->block_size)
       {
-         unsigned i, c;
+         unsigned i;
 
-         for (c = 0; c < 2; c++)
-         {
-            fft_process_forward(eq->fft, eq->fftblock, eq->block + c, 2);
-            for (i = 0; i < 2 * eq->block_size; i++)
-               eq->fftblock[i] = fft_complex_mul(eq->fftblock[i], eq->filter[i]);
-            fft_process_inverse(eq->fft, out + c, eq->fftblock, 2);
-         }
+         // The filter is real in the time domain, so left and right
+         // can ride along as the real and imaginary parts of a single
+         // complex signal and share one forward and inverse transform.
+         fft_process_forward_complex(eq->fft, eq->fftblock,
+               (const fft_complex_t*)eq->block, 1);
+         eq_apply_filter(eq);
+         fft_process_inverse_complex(eq->fft, (fft_complex_t*)out,
+               eq->fftblock, 1);
 
          // Overlap add method, so add in saved block now.
          for (i = 0; i < 2 * eq->block_size; i++)
@@ -224,7 +253,7 @@ static void create_filter(struct eq_data *eq, unsigned size_log2,
    int half_block_size = eq->block_size >> 1;
    double window_mod = 1.0 / kaiser_window(0.0, beta);
 
-   fft_t *fft = fft_new(size_log2);
+   fft_t *fft = fft_new(size_log2, false);
    float *time_filter = (float*)calloc(eq->block_size * 2 + 1, sizeof(*time_filter));
    if (!fft || !time_filter)
       goto end;
@@ -279,8 +308,8 @@ end:
    free(time_filter);
 }
 
-static void *eq_init(const struct dspfilter_info *info,
-      const struct dspfilter_config *config, void *userdata)
+static void *eq_init_common(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata, bool simd)
 {
    unsigned i;
    struct eq_data *eq = (struct eq_data*)calloc(1, sizeof(*eq));
@@ -325,6 +354,7 @@ static void *eq_init(const struct dspfilter_info *info,
    config->free(gain);
 
    eq->block_size = size;
+   eq->simd       = simd;
 
    eq->save     = (float*)calloc(    size, 2 * sizeof(*eq->save));
    eq->block    = (float*)calloc(2 * size, 2 * sizeof(*eq->block));
@@ -333,7 +363,7 @@ static void *eq_init(const struct dspfilter_info *info,
 
    // Use an FFT which is twice the block size with zero-padding
    // to make circular convolution => proper convolution.
-   eq->fft = fft_new(size_log2 + 1);
+   eq->fft = fft_new(size_log2 + 1, simd);
 
    if (!eq->fft || !eq->fftblock || !eq->save || !eq->block || !eq->filter)
       goto error;
@@ -351,6 +381,12 @@ error:
    return NULL;
 }
 
+static void *eq_init(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   return eq_init_common(info, config, userdata, false);
+}
+
 static const struct dspfilter_implementation eq_plug = {
    eq_init,
    eq_process,
@@ -361,12 +397,37 @@ static const struct dspfilter_implementation eq_plug = {
    "eq",
 };
 
+#if defined(FFT_SIMD_SSE2) || defined(FFT_SIMD_NEON)
+static void *eq_init_simd(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   return eq_init_common(info, config, userdata, true);
+}
+
+static const struct dspfilter_implementation eq_plug_simd = {
+   eq_init_simd,
+   eq_process,
+   eq_free,
+
+   DSPFILTER_API_VERSION,
+   "Linear-Phase FFT Equalizer",
+   "eq",
+};
+#endif
+
 #ifdef HAVE_FILTERS_BUILTIN
 #define dspfilter_get_implementation eq_dspfilter_get_implementation
 #endif
 
 const struct dspfilter_implementation *dspfilter_get_implementation(dspfilter_simd_mask_t mask)
 {
+#if defined(FFT_SIMD_SSE2)
+   if (mask & DSPFILTER_SIMD_SSE2)
+      return &eq_plug_simd;
+#elif defined(FFT_SIMD_NEON)
+   if (mask & DSPFILTER_SIMD_NEON)
+      return &eq_plug_simd;
+#endif
    (void)mask;
    return &eq_plug;
 }
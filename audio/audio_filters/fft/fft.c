@@ -27,6 +27,7 @@ struct fft
    fft_complex_t *phase_lut;
    unsigned *bitinverse_buffer;
    unsigned size;
+   bool simd;
 };
 
 static unsigned bitswap(unsigned x, unsigned size_log2)
@@ -90,7 +91,18 @@ static void resolve_float(float *out, const fft_complex_t *in, unsigned samples,
       *out = gain * in->real;
 }
 
-fft_t *fft_new(unsigned block_size_log2)
+static void resolve_complex(fft_complex_t *out, const fft_complex_t *in,
+      unsigned samples, float gain, unsigned step)
+{
+   unsigned i;
+   for (i = 0; i < samples; i++, in++, out += step)
+   {
+      out->real = gain * in->real;
+      out->imag = gain * in->imag;
+   }
+}
+
+fft_t *fft_new(unsigned block_size_log2, bool simd)
 {
    fft_t *fft = (fft_t*)calloc(1, sizeof(*fft));
    if (!fft)
@@ -106,6 +118,7 @@ fft_t *fft_new(unsigned block_size_log2)
       goto error;
 
    fft->size = size;
+   fft->simd = simd && size >= 4;
 
    build_bitinverse(fft->bitinverse_buffer, block_size_log2);
    build_phase_lut(fft->phase_lut, size);
@@ -134,7 +147,7 @@ static void butterfly(fft_complex_t *a, fft_complex_t *b, fft_complex_t mod)
    *a = fft_complex_add(*a, mod);
 }
 
-static void butterflies(fft_complex_t *butterfly_buf,
+static void butterflies_c(fft_complex_t *butterfly_buf,
       const fft_complex_t *phase_lut,
       int phase_dir, unsigned step_size, unsigned samples)
 {
@@ -147,6 +160,106 @@ static void butterflies(fft_complex_t *butterfly_buf,
    }
 }
 
+#if defined(FFT_SIMD_SSE2)
+/* Two butterflies per iteration. The first pass has a twiddle
+ * factor of exactly 1, so it is done with adds only. */
+static void butterflies_sse(fft_complex_t *butterfly_buf,
+      const fft_complex_t *phase_lut,
+      int phase_dir, unsigned step_size, unsigned samples)
+{
+   unsigned i, j;
+
+   if (step_size == 1)
+   {
+      const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0x80000000, 0, 0));
+      for (i = 0; i < samples; i += 2)
+      {
+         __m128 v = _mm_loadu_ps(&butterfly_buf[i].real);
+         __m128 a = _mm_movelh_ps(v, v);
+         __m128 b = _mm_xor_ps(_mm_movehl_ps(v, v), sign);
+         _mm_storeu_ps(&butterfly_buf[i].real, _mm_add_ps(a, b));
+      }
+      return;
+   }
+
+   for (i = 0; i < samples; i += step_size << 1)
+   {
+      int phase_step = (int)samples * phase_dir / (int)step_size;
+      for (j = i; j < i + step_size; j += 2)
+      {
+         const fft_complex_t *mod = &phase_lut[phase_step * (int)(j - i)];
+         __m128 w = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)mod);
+         __m128 a = _mm_loadu_ps(&butterfly_buf[j].real);
+         __m128 b = _mm_loadu_ps(&butterfly_buf[j + step_size].real);
+
+         w = _mm_loadh_pi(w, (const __m64*)(mod + phase_step));
+         b = fft_complex_mul_sse(w, b);
+
+         _mm_storeu_ps(&butterfly_buf[j + step_size].real, _mm_sub_ps(a, b));
+         _mm_storeu_ps(&butterfly_buf[j].real, _mm_add_ps(a, b));
+      }
+   }
+}
+#elif defined(FFT_SIMD_NEON)
+static void butterflies_neon(fft_complex_t *butterfly_buf,
+      const fft_complex_t *phase_lut,
+      int phase_dir, unsigned step_size, unsigned samples)
+{
+   unsigned i, j;
+
+   if (step_size == 1)
+   {
+      for (i = 0; i < samples; i += 2)
+      {
+         float32x2_t a = vld1_f32(&butterfly_buf[i].real);
+         float32x2_t b = vld1_f32(&butterfly_buf[i + 1].real);
+         vst1q_f32(&butterfly_buf[i].real,
+               vcombine_f32(vadd_f32(a, b), vsub_f32(a, b)));
+      }
+      return;
+   }
+
+   for (i = 0; i < samples; i += step_size << 1)
+   {
+      int phase_step = (int)samples * phase_dir / (int)step_size;
+      for (j = i; j < i + step_size; j += 2)
+      {
+         const fft_complex_t *mod = &phase_lut[phase_step * (int)(j - i)];
+         float32x4_t w = vcombine_f32(vld1_f32(&mod->real),
+               vld1_f32(&mod[phase_step].real));
+         float32x4_t a = vld1q_f32(&butterfly_buf[j].real);
+         float32x4_t b = fft_complex_mul_neon(w,
+               vld1q_f32(&butterfly_buf[j + step_size].real));
+
+         vst1q_f32(&butterfly_buf[j + step_size].real, vsubq_f32(a, b));
+         vst1q_f32(&butterfly_buf[j].real, vaddq_f32(a, b));
+      }
+   }
+}
+#endif
+
+static void butterflies(const fft_t *fft, fft_complex_t *butterfly_buf,
+      int phase_dir, unsigned step_size)
+{
+   const fft_complex_t *phase_lut = fft->phase_lut + fft->size;
+
+#if defined(FFT_SIMD_SSE2)
+   if (fft->simd)
+   {
+      butterflies_sse(butterfly_buf, phase_lut, phase_dir, step_size, fft->size);
+      return;
+   }
+#elif defined(FFT_SIMD_NEON)
+   if (fft->simd)
+   {
+      butterflies_neon(butterfly_buf, phase_lut, phase_dir, step_size, fft->size);
+      return;
+   }
+#endif
+
+   butterflies_c(butterfly_buf, phase_lut, phase_dir, step_size, fft->size);
+}
+
 void fft_process_forward_complex(fft_t *fft,
       fft_complex_t *out, const fft_complex_t *in, unsigned step)
 {
@@ -156,9 +269,7 @@ void fft_process_forward_complex(fft_t *fft,
 
    for (step_size = 1; step_size < samples; step_size <<= 1)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      butterflies(fft, out, -1, step_size);
    }
 }
 
@@ -171,9 +282,7 @@ void fft_process_forward(fft_t *fft,
 
    for (step_size = 1; step_size < fft->size; step_size <<= 1)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      butterflies(fft, out, -1, step_size);
    }
 }
 
@@ -186,11 +295,22 @@ void fft_process_inverse(fft_t *fft,
 
    for (step_size = 1; step_size < samples; step_size <<= 1)
    {
-      butterflies(fft->interleave_buffer,
-            fft->phase_lut + samples,
-            1, step_size, samples);
+      butterflies(fft, fft->interleave_buffer, 1, step_size);
    }
 
    resolve_float(out, fft->interleave_buffer, samples, 1.0f / samples, step);
 }
 
+
+void fft_process_inverse_complex(fft_t *fft,
+      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+{
+   unsigned step_size;
+   unsigned samples = fft->size;
+   interleave_complex(fft->bitinverse_buffer, fft->interleave_buffer, in, samples, 1);
+
+   for (step_size = 1; step_size < samples; step_size <<= 1)
+      butterflies(fft, fft->interleave_buffer, 1, step_size);
+
+   resolve_complex(out, fft->interleave_buffer, samples, 1.0f / samples, step);
+}
@@ -17,6 +17,15 @@
 #define RARCH_FFT_H__
 
 #include <retro_inline.h>
+#include <boolean.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_SIMD_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FFT_SIMD_NEON
+#endif
 
 typedef struct fft fft_t;
 
@@ -72,7 +81,41 @@ static INLINE fft_complex_t fft_complex_conj(fft_complex_t a)
    return out;
 }
 
-fft_t *fft_new(unsigned block_size_log2);
+#if defined(FFT_SIMD_SSE2)
+/* Multiplies two pairs of complex numbers, laid out as
+ * { real0, imag0, real1, imag1 }. */
+static INLINE __m128 fft_complex_mul_sse(__m128 a, __m128 b)
+{
+   const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0, 0x80000000, 0, 0x80000000));
+   __m128 b_real     = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+   __m128 b_imag     = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+   __m128 a_swap     = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+
+   return _mm_add_ps(_mm_mul_ps(a, b_real),
+         _mm_xor_ps(_mm_mul_ps(a_swap, b_imag), sign));
+}
+#elif defined(FFT_SIMD_NEON)
+static INLINE float32x4_t fft_complex_mul_neon(float32x4_t a, float32x4_t b)
+{
+   static const float sign[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+   float32x4x2_t b_trn = vtrnq_f32(b, b);
+   float32x4_t a_swap  = vrev64q_f32(a);
+
+   return vmlaq_f32(vmulq_f32(a, b_trn.val[0]),
+         a_swap, vmulq_f32(b_trn.val[1], vld1q_f32(sign)));
+}
+#endif
+
+/**
+ * fft_new:
+ * @block_size_log2     : log2 of the transform size.
+ * @simd                : Use SSE2/NEON butterflies if they were
+ *                        compiled in. Transforms smaller than
+ *                        4 points always run scalar.
+ *
+ * Returns: new FFT handle, or NULL on allocation failure.
+ **/
+fft_t *fft_new(unsigned block_size_log2, bool simd);
 
 void fft_free(fft_t *fft);
 
@@ -85,6 +128,12 @@ void fft_process_forward(fft_t *fft,
 void fft_process_inverse(fft_t *fft,
       float *out, const fft_complex_t *in, unsigned step);
 
+/* Like fft_process_inverse(), but keeps the imaginary part.
+ * Two real signals which share a real filter can be packed into
+ * one complex signal and convolved with a single transform pair. */
+void fft_process_inverse_complex(fft_t *fft,
+      fft_complex_t *out, const fft_complex_t *in, unsigned step);
+
 
 #endif
 
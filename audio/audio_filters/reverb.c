@@ -19,7 +19,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <retro_inline.h>
+#include <boolean.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Left and right share the same tunings and parameters, so the
+ * delay lines hold interleaved stereo frames and both channels
+ * are filtered together. */
 struct comb
 {
    float *buffer;
@@ -27,7 +37,7 @@ struct comb
    unsigned bufidx;
 
    float feedback;
-   float filterstore;
+   float filterstore[2];
    float damp1, damp2;
 };
 
@@ -39,32 +49,95 @@ struct allpass
    unsigned bufidx;
 };
 
-static INLINE float comb_process(struct comb *c, float input)
+static void comb_process(struct comb *c, const float *input,
+      float *output, unsigned frames)
 {
-   float output = c->buffer[c->bufidx];
-   c->filterstore = (output * c->damp2) + (c->filterstore * c->damp1);
+   unsigned i;
+   unsigned bufidx     = c->bufidx;
+   float feedback      = c->feedback;
+   float damp1         = c->damp1;
+   float damp2         = c->damp2;
+   float filterstore_l = c->filterstore[0];
+   float filterstore_r = c->filterstore[1];
+
+   for (i = 0; i < frames; i++, input += 2, output += 2)
+   {
+      float *buffer  = c->buffer + 2 * bufidx;
+      float bufout_l = buffer[0];
+      float bufout_r = buffer[1];
 
-   c->buffer[c->bufidx] = input + (c->filterstore * c->feedback);
+      filterstore_l = (bufout_l * damp2) + (filterstore_l * damp1);
+      filterstore_r = (bufout_r * damp2) + (filterstore_r * damp1);
 
-   c->bufidx++;
-   if (c->bufidx >= c->bufsize)
-      c->bufidx = 0;
+      buffer[0]  = input[0] + (filterstore_l * feedback);
+      buffer[1]  = input[1] + (filterstore_r * feedback);
+      output[0] += bufout_l;
+      output[1] += bufout_r;
 
-   return output;
-}
+      if (++bufidx >= c->bufsize)
+         bufidx = 0;
+   }
 
+   c->bufidx         = bufidx;
+   c->filterstore[0] = filterstore_l;
+   c->filterstore[1] = filterstore_r;
+}
 
-static INLINE float allpass_process(struct allpass *a, float input)
+/* An allpass only reads back what it wrote a full delay line
+ * ago, so it can filter a whole block at once, one wrap-free
+ * stretch of the delay line at a time. */
+static void allpass_process(struct allpass *a, float *samples,
+      unsigned frames, bool simd)
 {
-   float bufout = a->buffer[a->bufidx];
-   float output = -input + bufout;
-   a->buffer[a->bufidx] = input + bufout * a->feedback;
-
-   a->bufidx++;
-   if (a->bufidx >= a->bufsize)
-      a->bufidx = 0;
+   while (frames)
+   {
+      unsigned i = 0;
+      unsigned avail = a->bufsize - a->bufidx;
+      float *buffer = a->buffer + 2 * a->bufidx;
+
+      if (avail > frames)
+         avail = frames;
+
+#if defined(__SSE2__)
+      if (simd)
+      {
+         __m128 feedback = _mm_set1_ps(a->feedback);
+         for (; i + 4 <= avail * 2; i += 4)
+         {
+            __m128 in     = _mm_loadu_ps(samples + i);
+            __m128 bufout = _mm_loadu_ps(buffer + i);
+            _mm_storeu_ps(samples + i, _mm_sub_ps(bufout, in));
+            _mm_storeu_ps(buffer + i, _mm_add_ps(in, _mm_mul_ps(bufout, feedback)));
+         }
+      }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+      if (simd)
+      {
+         float32x4_t feedback = vdupq_n_f32(a->feedback);
+         for (; i + 4 <= avail * 2; i += 4)
+         {
+            float32x4_t in     = vld1q_f32(samples + i);
+            float32x4_t bufout = vld1q_f32(buffer + i);
+            vst1q_f32(samples + i, vsubq_f32(bufout, in));
+            vst1q_f32(buffer + i, vmlaq_f32(in, bufout, feedback));
+         }
+      }
+#endif
 
-   return output;
+      for (; i < avail * 2; i++)
+      {
+         float in     = samples[i];
+         float bufout = buffer[i];
+         samples[i]   = -in + bufout;
+         buffer[i]    = in + bufout * a->feedback;
+      }
+
+      samples    += avail * 2;
+      frames     -= avail;
+      a->bufidx  += avail;
+      if (a->bufidx >= a->bufsize)
+         a->bufidx = 0;
+   }
 }
 
 #define numcombs 8
@@ -97,24 +170,29 @@ static const float freezemode = 0.5f;
 #define allpasstuningL3 341
 #define allpasstuningL4 225
 
+#define REVERB_BLOCK_FRAMES 256
+
 struct revmodel
 {
-   struct comb combL[numcombs];
-   struct allpass allpassL[numallpasses];
-
-   float bufcombL1[combtuningL1];
-   float bufcombL2[combtuningL2];
-   float bufcombL3[combtuningL3];
-   float bufcombL4[combtuningL4];
-   float bufcombL5[combtuningL5];
-   float bufcombL6[combtuningL6];
-   float bufcombL7[combtuningL7];
-   float bufcombL8[combtuningL8];
-
-   float bufallpassL1[allpasstuningL1];
-   float bufallpassL2[allpasstuningL2];
-   float bufallpassL3[allpasstuningL3];
-   float bufallpassL4[allpasstuningL4];
+   struct comb combs[numcombs];
+   struct allpass allpasses[numallpasses];
+
+   float bufcomb1[combtuningL1 * 2];
+   float bufcomb2[combtuningL2 * 2];
+   float bufcomb3[combtuningL3 * 2];
+   float bufcomb4[combtuningL4 * 2];
+   float bufcomb5[combtuningL5 * 2];
+   float bufcomb6[combtuningL6 * 2];
+   float bufcomb7[combtuningL7 * 2];
+   float bufcomb8[combtuningL8 * 2];
+
+   float bufallpass1[allpasstuningL1 * 2];
+   float bufallpass2[allpasstuningL2 * 2];
+   float bufallpass3[allpasstuningL3 * 2];
+   float bufallpass4[allpasstuningL4 * 2];
+
+   float input[REVERB_BLOCK_FRAMES * 2];
+   float output[REVERB_BLOCK_FRAMES * 2];
 
    float gain;
    float roomsize, roomsize1;
@@ -123,21 +201,159 @@ struct revmodel
    float dry;
    float width;
    float mode;
+   bool simd;
 };
 
-static float revmodel_process(struct revmodel *rev, float in)
+#if defined(__SSE2__)
+/* The combs are serial in time, so run two of them for both
+ * channels in one vector instead. All combs share feedback and
+ * damping, only their delay lengths differ. */
+static void revmodel_process_combs_sse(struct revmodel *rev, unsigned frames)
 {
-   int i;
-   float mono_out = 0.0f;
-   float mono_in = in;
-   float input = mono_in * rev->gain;
-   for (i = 0; i < numcombs; i++)
-      mono_out += comb_process(&rev->combL[i], input);
+   unsigned i, j;
+   struct comb *combs = rev->combs;
+   __m128 feedback    = _mm_set1_ps(combs[0].feedback);
+   __m128 damp1       = _mm_set1_ps(combs[0].damp1);
+   __m128 damp2       = _mm_set1_ps(combs[0].damp2);
+   __m128 filterstore[numcombs / 2];
+
+   for (j = 0; j < numcombs / 2; j++)
+      filterstore[j] = _mm_set_ps(
+            combs[2 * j + 1].filterstore[1], combs[2 * j + 1].filterstore[0],
+            combs[2 * j + 0].filterstore[1], combs[2 * j + 0].filterstore[0]);
+
+   for (i = 0; i < frames; i++)
+   {
+      __m128 input = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(rev->input + 2 * i));
+      __m128 sum   = _mm_setzero_ps();
+
+      input = _mm_movelh_ps(input, input);
+
+      for (j = 0; j < numcombs / 2; j++)
+      {
+         struct comb *c0 = &combs[2 * j + 0];
+         struct comb *c1 = &combs[2 * j + 1];
+         float *buf0     = c0->buffer + 2 * c0->bufidx;
+         float *buf1     = c1->buffer + 2 * c1->bufidx;
+         __m128 bufout   = _mm_loadh_pi(
+               _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)buf0),
+               (const __m64*)buf1);
+         __m128 store;
+
+         filterstore[j] = _mm_add_ps(_mm_mul_ps(bufout, damp2),
+               _mm_mul_ps(filterstore[j], damp1));
+         store = _mm_add_ps(input, _mm_mul_ps(filterstore[j], feedback));
+
+         _mm_storel_pi((__m64*)buf0, store);
+         _mm_storeh_pi((__m64*)buf1, store);
+         sum = _mm_add_ps(sum, bufout);
+
+         if (++c0->bufidx >= c0->bufsize)
+            c0->bufidx = 0;
+         if (++c1->bufidx >= c1->bufsize)
+            c1->bufidx = 0;
+      }
+
+      _mm_storel_pi((__m64*)(rev->output + 2 * i),
+            _mm_add_ps(sum, _mm_movehl_ps(sum, sum)));
+   }
 
-   for (i = 0; i < numallpasses; i++)
-      mono_out = allpass_process(&rev->allpassL[i], mono_out);
+   for (j = 0; j < numcombs / 2; j++)
+   {
+      float store[4];
+      _mm_storeu_ps(store, filterstore[j]);
+      combs[2 * j + 0].filterstore[0] = store[0];
+      combs[2 * j + 0].filterstore[1] = store[1];
+      combs[2 * j + 1].filterstore[0] = store[2];
+      combs[2 * j + 1].filterstore[1] = store[3];
+   }
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+static void revmodel_process_combs_neon(struct revmodel *rev, unsigned frames)
+{
+   unsigned i, j;
+   struct comb *combs   = rev->combs;
+   float32x4_t feedback = vdupq_n_f32(combs[0].feedback);
+   float32x4_t damp1    = vdupq_n_f32(combs[0].damp1);
+   float32x4_t damp2    = vdupq_n_f32(combs[0].damp2);
+   float32x4_t filterstore[numcombs / 2];
+
+   for (j = 0; j < numcombs / 2; j++)
+      filterstore[j] = vcombine_f32(
+            vld1_f32(combs[2 * j + 0].filterstore),
+            vld1_f32(combs[2 * j + 1].filterstore));
+
+   for (i = 0; i < frames; i++)
+   {
+      float32x2_t input_lr = vld1_f32(rev->input + 2 * i);
+      float32x4_t input    = vcombine_f32(input_lr, input_lr);
+      float32x4_t sum      = vdupq_n_f32(0.0f);
+
+      for (j = 0; j < numcombs / 2; j++)
+      {
+         struct comb *c0    = &combs[2 * j + 0];
+         struct comb *c1    = &combs[2 * j + 1];
+         float *buf0        = c0->buffer + 2 * c0->bufidx;
+         float *buf1        = c1->buffer + 2 * c1->bufidx;
+         float32x4_t bufout = vcombine_f32(vld1_f32(buf0), vld1_f32(buf1));
+         float32x4_t store;
+
+         filterstore[j] = vmlaq_f32(vmulq_f32(bufout, damp2),
+               filterstore[j], damp1);
+         store = vmlaq_f32(input, filterstore[j], feedback);
+
+         vst1_f32(buf0, vget_low_f32(store));
+         vst1_f32(buf1, vget_high_f32(store));
+         sum = vaddq_f32(sum, bufout);
+
+         if (++c0->bufidx >= c0->bufsize)
+            c0->bufidx = 0;
+         if (++c1->bufidx >= c1->bufsize)
+            c1->bufidx = 0;
+      }
+
+      vst1_f32(rev->output + 2 * i,
+            vadd_f32(vget_low_f32(sum), vget_high_f32(sum)));
+   }
 
-   return mono_in * rev->dry + mono_out * rev->wet1;
+   for (j = 0; j < numcombs / 2; j++)
+   {
+      vst1_f32(combs[2 * j + 0].filterstore, vget_low_f32(filterstore[j]));
+      vst1_f32(combs[2 * j + 1].filterstore, vget_high_f32(filterstore[j]));
+   }
+}
+#endif
+
+/* Filters up to REVERB_BLOCK_FRAMES interleaved stereo frames in place. */
+static void revmodel_process(struct revmodel *rev, float *samples, unsigned frames)
+{
+   unsigned i, j;
+
+   for (i = 0; i < frames * 2; i++)
+   {
+      rev->input[i]  = samples[i] * rev->gain;
+      rev->output[i] = 0.0f;
+   }
+
+#if defined(__SSE2__)
+   if (rev->simd)
+      revmodel_process_combs_sse(rev, frames);
+   else
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (rev->simd)
+      revmodel_process_combs_neon(rev, frames);
+   else
+#endif
+   {
+      for (j = 0; j < numcombs; j++)
+         comb_process(&rev->combs[j], rev->input, rev->output, frames);
+   }
+
+   for (j = 0; j < numallpasses; j++)
+      allpass_process(&rev->allpasses[j], rev->output, frames, rev->simd);
+
+   for (i = 0; i < frames * 2; i++)
+      samples[i] = samples[i] * rev->dry + rev->output[i] * rev->wet1;
 }
 
 static void revmodel_update(struct revmodel *rev)
@@ -160,9 +376,9 @@ static void revmodel_update(struct revmodel *rev)
 
    for (i = 0; i < numcombs; i++)
    {
-      rev->combL[i].feedback = rev->roomsize1;
-      rev->combL[i].damp1 = rev->damp1;
-      rev->combL[i].damp2 = 1.0f - rev->damp1;
+      rev->combs[i].feedback = rev->roomsize1;
+      rev->combs[i].damp1 = rev->damp1;
+      rev->combs[i].damp2 = 1.0f - rev->damp1;
    }
 }
 
@@ -202,26 +418,28 @@ static void revmodel_setmode(struct revmodel *rev, float value)
    revmodel_update(rev);
 }
 
-static void revmodel_init(struct revmodel *rev)
+static void revmodel_init(struct revmodel *rev, bool simd)
 {
-   rev->combL[0].buffer = rev->bufcombL1; rev->combL[0].bufsize = combtuningL1;
-   rev->combL[1].buffer = rev->bufcombL2; rev->combL[1].bufsize = combtuningL2;
-   rev->combL[2].buffer = rev->bufcombL3; rev->combL[2].bufsize = combtuningL3;
-   rev->combL[3].buffer = rev->bufcombL4; rev->combL[3].bufsize = combtuningL4;
-   rev->combL[4].buffer = rev->bufcombL5; rev->combL[4].bufsize = combtuningL5;
-   rev->combL[5].buffer = rev->bufcombL6; rev->combL[5].bufsize = combtuningL6;
-   rev->combL[6].buffer = rev->bufcombL7; rev->combL[6].bufsize = combtuningL7;
-   rev->combL[7].buffer = rev->bufcombL8; rev->combL[7].bufsize = combtuningL8;
-
-   rev->allpassL[0].buffer = rev->bufallpassL1; rev->allpassL[0].bufsize = allpasstuningL1;
-   rev->allpassL[1].buffer = rev->bufallpassL2; rev->allpassL[1].bufsize = allpasstuningL2;
-   rev->allpassL[2].buffer = rev->bufallpassL3; rev->allpassL[2].bufsize = allpasstuningL3;
-   rev->allpassL[3].buffer = rev->bufallpassL4; rev->allpassL[3].bufsize = allpasstuningL4;
-
-   rev->allpassL[0].feedback = 0.5f;
-   rev->allpassL[1].feedback = 0.5f;
-   rev->allpassL[2].feedback = 0.5f;
-   rev->allpassL[3].feedback = 0.5f;
+   rev->combs[0].buffer = rev->bufcomb1; rev->combs[0].bufsize = combtuningL1;
+   rev->combs[1].buffer = rev->bufcomb2; rev->combs[1].bufsize = combtuningL2;
+   rev->combs[2].buffer = rev->bufcomb3; rev->combs[2].bufsize = combtuningL3;
+   rev->combs[3].buffer = rev->bufcomb4; rev->combs[3].bufsize = combtuningL4;
+   rev->combs[4].buffer = rev->bufcomb5; rev->combs[4].bufsize = combtuningL5;
+   rev->combs[5].buffer = rev->bufcomb6; rev->combs[5].bufsize = combtuningL6;
+   rev->combs[6].buffer = rev->bufcomb7; rev->combs[6].bufsize = combtuningL7;
+   rev->combs[7].buffer = rev->bufcomb8; rev->combs[7].bufsize = combtuningL8;
+
+   rev->allpasses[0].buffer = rev->bufallpass1; rev->allpasses[0].bufsize = allpasstuningL1;
+   rev->allpasses[1].buffer = rev->bufallpass2; rev->allpasses[1].bufsize = allpasstuningL2;
+   rev->allpasses[2].buffer = rev->bufallpass3; rev->allpasses[2].bufsize = allpasstuningL3;
+   rev->allpasses[3].buffer = rev->bufallpass4; rev->allpasses[3].bufsize = allpasstuningL4;
+
+   rev->allpasses[0].feedback = 0.5f;
+   rev->allpasses[1].feedback = 0.5f;
+   rev->allpasses[2].feedback = 0.5f;
+   rev->allpasses[3].feedback = 0.5f;
+
+   rev->simd = simd;
 
    revmodel_setwet(rev, initialwet);
    revmodel_setroomsize(rev, initialroom);
@@ -233,7 +451,7 @@ static void revmodel_init(struct revmodel *rev)
 
 struct reverb_data
 {
-   struct revmodel left, right;
+   struct revmodel rev;
 };
 
 static void reverb_free(void *data)
@@ -244,24 +462,26 @@ static void reverb_free(void *data)
 static void reverb_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
-   unsigned i;
+   unsigned frames;
    struct reverb_data *rev = (struct reverb_data*)data;
 
    output->samples = input->samples;
    output->frames  = input->frames;
    float *out = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   for (frames = input->frames; frames; )
    {
-      float in[2] = { out[0], out[1] };
+      unsigned block = frames < REVERB_BLOCK_FRAMES ? frames : REVERB_BLOCK_FRAMES;
+
+      revmodel_process(&rev->rev, out, block);
 
-      out[0] = revmodel_process(&rev->left, in[0]);
-      out[1] = revmodel_process(&rev->right, in[1]);
+      out    += block * 2;
+      frames -= block;
    }
 }
 
-static void *reverb_init(const struct dspfilter_info *info,
-      const struct dspfilter_config *config, void *userdata)
+static void *reverb_init_common(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata, bool simd)
 {
    struct reverb_data *rev = (struct reverb_data*)calloc(1, sizeof(*rev));
    if (!rev)
@@ -274,24 +494,23 @@ static void *reverb_init(const struct dspfilter_info *info,
    config->get_float(userdata, "roomwidth", &roomwidth, 0.56f);
    config->get_float(userdata, "roomsize", &roomsize, 0.56f);
 
-   revmodel_init(&rev->left);
-   revmodel_init(&rev->right);
+   revmodel_init(&rev->rev, simd);
 
-   revmodel_setdamp(&rev->left, damping);
-   revmodel_setdry(&rev->left, drytime);
-   revmodel_setwet(&rev->left, wettime);
-   revmodel_setwidth(&rev->left, roomwidth);
-   revmodel_setroomsize(&rev->left, roomsize);
-
-   revmodel_setdamp(&rev->right, damping);
-   revmodel_setdry(&rev->right, drytime);
-   revmodel_setwet(&rev->right, wettime);
-   revmodel_setwidth(&rev->right, roomwidth);
-   revmodel_setroomsize(&rev->right, roomsize);
+   revmodel_setdamp(&rev->rev, damping);
+   revmodel_setdry(&rev->rev, drytime);
+   revmodel_setwet(&rev->rev, wettime);
+   revmodel_setwidth(&rev->rev, roomwidth);
+   revmodel_setroomsize(&rev->rev, roomsize);
 
    return rev;
 }
 
+static void *reverb_init(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   return reverb_init_common(info, config, userdata, false);
+}
+
 static const struct dspfilter_implementation reverb_plug = {
    reverb_init,
    reverb_process,
@@ -302,16 +521,39 @@ static const struct dspfilter_implementation reverb_plug = {
    "reverb",
 };
 
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+static void *reverb_init_simd(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   return reverb_init_common(info, config, userdata, true);
+}
+
+static const struct dspfilter_implementation reverb_plug_simd = {
+   reverb_init_simd,
+   reverb_process,
+   reverb_free,
+
+   DSPFILTER_API_VERSION,
+   "Reverb",
+   "reverb",
+};
+#endif
+
 #ifdef HAVE_FILTERS_BUILTIN
 #define dspfilter_get_implementation reverb_dspfilter_get_implementation
 #endif
 
 const struct dspfilter_implementation *dspfilter_get_implementation(dspfilter_simd_mask_t mask)
 {
+#if defined(__SSE2__)
+   if (mask & DSPFILTER_SIMD_SSE2)
+      return &reverb_plug_simd;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (mask & DSPFILTER_SIMD_NEON)
+      return &reverb_plug_simd;
+#endif
    (void)mask;
    return &reverb_plug;
 }
 
 #undef dspfilter_get_implementation
-
-
@@ -32,7 +32,9 @@ void audio_monitor_adjust_system_rates(void)
                                  settings->video.refresh_rate);
    global->audio_data.in_rate = info->sample_rate;
 
-   if (timing_skew <= settings->audio.max_timing_skew)
+   /* With variable refresh rate, frames run at the core's own rate. */
+   if (!settings->video.vrr_enable &&
+         timing_skew <= settings->audio.max_timing_skew)
       global->audio_data.in_rate *= (settings->video.refresh_rate / info->fps);
 
    RARCH_LOG("Set audio input rate to: %.2f Hz.\n",
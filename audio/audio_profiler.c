@@ -0,0 +1,185 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include "audio_profiler.h"
+#include "../general.h"
+#include "../performance.h"
+
+#define AUDIO_PROFILER_MAX_DRIVERS 8
+
+/* Bucket i counts writes that blocked for [2^i, 2^(i+1)) us,
+ * the first bucket also takes everything shorter. */
+#define AUDIO_PROFILER_TIME_BUCKETS 16
+
+/* Buffer fill in 10% steps. */
+#define AUDIO_PROFILER_FILL_BUCKETS 10
+
+/* Most recent underruns kept with their time. */
+#define AUDIO_PROFILER_EVENTS 32
+
+typedef struct audio_profile
+{
+   char ident[32];
+
+   /* When the driver was first and last used. */
+   retro_time_t start_usec;
+   retro_time_t last_usec;
+
+   uint64_t writes;
+   retro_time_t write_usec_total;
+   retro_time_t write_usec_max;
+   unsigned write_usec[AUDIO_PROFILER_TIME_BUCKETS];
+
+   unsigned fill[AUDIO_PROFILER_FILL_BUCKETS];
+
+   unsigned underruns;
+   unsigned overruns;
+   retro_time_t underrun_usec[AUDIO_PROFILER_EVENTS];
+} audio_profile_t;
+
+static audio_profile_t audio_profiles[AUDIO_PROFILER_MAX_DRIVERS];
+static unsigned audio_profiles_count;
+static audio_profile_t *audio_profile_current;
+
+void audio_profiler_init(const char *ident)
+{
+   unsigned i;
+   audio_profile_t *profile = NULL;
+
+   for (i = 0; i < audio_profiles_count; i++)
+   {
+      if (!strcmp(audio_profiles[i].ident, ident))
+      {
+         profile = &audio_profiles[i];
+         break;
+      }
+   }
+
+   if (!profile)
+   {
+      /* Out of slots, keep accumulating into the last one. */
+      if (audio_profiles_count == AUDIO_PROFILER_MAX_DRIVERS)
+         profile = &audio_profiles[AUDIO_PROFILER_MAX_DRIVERS - 1];
+      else
+      {
+         profile = &audio_profiles[audio_profiles_count++];
+         strlcpy(profile->ident, ident, sizeof(profile->ident));
+         profile->start_usec = rarch_get_time_usec();
+      }
+   }
+
+   audio_profile_current = profile;
+}
+
+void audio_profiler_write(retro_time_t usec)
+{
+   unsigned bucket          = 0;
+   audio_profile_t *profile = audio_profile_current;
+
+   if (!profile)
+      return;
+
+   while (bucket < AUDIO_PROFILER_TIME_BUCKETS - 1 && (usec >> (bucket + 1)))
+      bucket++;
+
+   profile->write_usec[bucket]++;
+   profile->writes++;
+   profile->write_usec_total += usec;
+   if (usec > profile->write_usec_max)
+      profile->write_usec_max = usec;
+   profile->last_usec = rarch_get_time_usec();
+}
+
+void audio_profiler_fill(unsigned percent, bool underrun, bool overrun)
+{
+   audio_profile_t *profile = audio_profile_current;
+
+   if (!profile)
+      return;
+
+   profile->fill[min(percent / 10, AUDIO_PROFILER_FILL_BUCKETS - 1)]++;
+
+   if (underrun)
+      profile->underrun_usec[profile->underruns++ %
+         AUDIO_PROFILER_EVENTS] = rarch_get_time_usec();
+   if (overrun)
+      profile->overruns++;
+}
+
+static void audio_profile_dump(FILE *file, const audio_profile_t *profile)
+{
+   unsigned i, fill_total = 0, events;
+
+   fprintf(file, "driver %s: %llu writes over %.3f s, "
+         "%.3f ms blocked on average, %.3f ms at most\n",
+         profile->ident, (unsigned long long)profile->writes,
+         (profile->last_usec - profile->start_usec) / 1000000.0,
+         profile->writes ?
+         profile->write_usec_total / 1000.0 / profile->writes : 0.0,
+         profile->write_usec_max / 1000.0);
+
+   fprintf(file, "  write blocking time:\n");
+   for (i = 0; i < AUDIO_PROFILER_TIME_BUCKETS; i++)
+   {
+      if (!profile->write_usec[i])
+         continue;
+      fprintf(file, "    %6u - %6u us: %u\n",
+            i ? 1u << i : 0u, 1u << (i + 1), profile->write_usec[i]);
+   }
+
+   for (i = 0; i < AUDIO_PROFILER_FILL_BUCKETS; i++)
+      fill_total += profile->fill[i];
+
+   fprintf(file, "  buffer fill (%u samples):\n", fill_total);
+   for (i = 0; fill_total && i < AUDIO_PROFILER_FILL_BUCKETS; i++)
+      fprintf(file, "    %3u - %3u %%: %u (%.1f %%)\n",
+            i * 10, i * 10 + 10, profile->fill[i],
+            100.0 * profile->fill[i] / fill_total);
+
+   fprintf(file, "  %u underruns, %u overruns\n",
+         profile->underruns, profile->overruns);
+
+   events = min(profile->underruns, AUDIO_PROFILER_EVENTS);
+   for (i = profile->underruns - events; i < profile->underruns; i++)
+      fprintf(file, "    underrun at %.3f s\n",
+            (profile->underrun_usec[i % AUDIO_PROFILER_EVENTS] -
+             profile->start_usec) / 1000000.0);
+}
+
+bool audio_profiler_dump(const char *path)
+{
+   unsigned i;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+   {
+      RARCH_ERR("Failed to open \"%s\" for the audio profile.\n", path);
+      return false;
+   }
+
+   for (i = 0; i < audio_profiles_count; i++)
+      audio_profile_dump(file, &audio_profiles[i]);
+
+   fclose(file);
+   RARCH_LOG("Wrote audio profile to \"%s\".\n", path);
+   return true;
+}
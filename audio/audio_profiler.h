@@ -0,0 +1,70 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AUDIO_PROFILER_H
+#define __AUDIO_PROFILER_H
+
+#include <boolean.h>
+#include "../libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * audio_profiler_init:
+ * @ident                : Ident of the audio driver in use.
+ *
+ * Selects the profile further measurements go to. Profiles are
+ * kept per driver for the whole session, so drivers can be
+ * compared by switching between them.
+ **/
+void audio_profiler_init(const char *ident);
+
+/**
+ * audio_profiler_write:
+ * @usec                 : Time spent in the driver's write().
+ *
+ * Records how long a write to the audio driver blocked.
+ **/
+void audio_profiler_write(retro_time_t usec);
+
+/**
+ * audio_profiler_fill:
+ * @percent              : How full the driver buffer is, 0 - 100.
+ * @underrun             : Driver buffer was found empty.
+ * @overrun              : Driver buffer was too full for the last write.
+ *
+ * Records the driver buffer fill level, as sampled by rate control.
+ **/
+void audio_profiler_fill(unsigned percent, bool underrun, bool overrun);
+
+/**
+ * audio_profiler_dump:
+ * @path                 : File to write the profiles to.
+ *
+ * Writes the histograms of every driver used this session
+ * as plain text.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool audio_profiler_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
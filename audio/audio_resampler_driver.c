@@ -18,7 +18,9 @@
 #ifdef RARCH_INTERNAL
 #include "../performance.h"
 #endif
+#ifndef RESAMPLER_TEST
 #include <file/config_file_userdata.h>
+#endif
 #include <string.h>
 #ifndef DONT_HAVE_STRING_LIST
 #include <string/string_list.h>
@@ -31,6 +33,10 @@ static const rarch_resampler_t *resampler_drivers[] = {
    NULL,
 };
 
+#ifdef RESAMPLER_TEST
+/* The standalone test harnesses never load a config file. */
+static const struct resampler_config resampler_config;
+#else
 static const struct resampler_config resampler_config = {
    config_userdata_get_float,
    config_userdata_get_int,
@@ -39,6 +45,7 @@ static const struct resampler_config resampler_config = {
    config_userdata_get_string,
    config_userdata_free,
 };
+#endif
 
 /**
  * find_resampler_driver_index:
@@ -146,7 +153,9 @@ done:
  **/
 static const rarch_resampler_t *find_resampler_driver(const char *ident)
 {
+#ifdef RARCH_INTERNAL
    unsigned d;
+#endif
    int i = find_resampler_driver_index(ident);
 
    if (i >= 0)
@@ -191,6 +200,7 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  * @re                         : Resampler handle
  * @backend                    : Resampler backend that is about to be set.
  * @bw_ratio                   : Bandwidth ratio.
+ * @quality                    : Desired quality level.
  *
  * Initializes resampler driver based on queried CPU features.
  *
@@ -198,11 +208,11 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  **/
 static bool resampler_append_plugs(void **re,
       const rarch_resampler_t **backend,
-      double bw_ratio)
+      double bw_ratio, enum resampler_quality quality)
 {
    resampler_simd_mask_t mask = resampler_get_cpu_features();
 
-   *re = (*backend)->init(&resampler_config, bw_ratio, mask);
+   *re = (*backend)->init(&resampler_config, bw_ratio, quality, mask);
 
    if (!*re)
       return false;
@@ -215,6 +225,7 @@ static bool resampler_append_plugs(void **re,
  * @backend                    : Resampler backend that is about to be set.
  * @ident                      : Identifier name for resampler we want.
  * @bw_ratio                   : Bandwidth ratio.
+ * @quality                    : Desired quality level.
  *
  * Reallocates resampler. Will free previous handle before 
  * allocating a new one. If ident is NULL, first resampler will be used.
@@ -222,7 +233,7 @@ static bool resampler_append_plugs(void **re,
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
-      const char *ident, double bw_ratio)
+      const char *ident, double bw_ratio, enum resampler_quality quality)
 {
    if (*re && *backend)
       (*backend)->free(*re);
@@ -230,7 +241,7 @@ bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
    *re      = NULL;
    *backend = find_resampler_driver(ident);
 
-   if (!resampler_append_plugs(re, backend, bw_ratio))
+   if (!resampler_append_plugs(re, backend, bw_ratio, quality))
       goto error;
 
    return true;
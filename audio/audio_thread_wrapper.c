@@ -18,6 +18,7 @@
 #include <rthreads/rthreads.h>
 #include "../general.h"
 #include "../performance.h"
+#include "../libretro_version_1.h"
 #include <queues/fifo_buffer.h>
 #include <stdlib.h>
 #include <string.h>
@@ -94,6 +95,10 @@ static void audio_thread_loop(void *data)
 
       slock_unlock(thr->lock);
       global->system.audio_callback.callback();
+
+      /* Audio is rendered here rather than in retro_run(),
+       * so batched samples are flushed here too. */
+      retro_flush_audio_samples(true);
    }
 
    RARCH_LOG("[Audio Thread]: Tearing down driver.\n");
@@ -300,3 +305,217 @@ error:
    audio_thread_free(thr);
    return false;
 }
+
+typedef struct audio_dsp_thread
+{
+   sthread_t *thread;
+
+   /* Guards queue and alive. */
+   slock_t *lock;
+   scond_t *cond;
+   /* Held while samples go through the DSP, resampler and
+    * driver, so the main thread can change them in between. */
+   slock_t *chain_lock;
+
+   fifo_buffer_t *queue;
+   int16_t *block;
+   size_t block_size;
+
+   bool alive;
+} audio_dsp_thread_t;
+
+static audio_dsp_thread_t *audio_dsp_thread;
+
+static void audio_dsp_thread_loop(void *data)
+{
+   audio_dsp_thread_t *dsp = (audio_dsp_thread_t*)data;
+
+   for (;;)
+   {
+      size_t size;
+
+      slock_lock(dsp->lock);
+
+      while (dsp->alive && !fifo_read_avail(dsp->queue))
+         scond_wait(dsp->cond, dsp->lock);
+
+      if (!dsp->alive)
+      {
+         slock_unlock(dsp->lock);
+         break;
+      }
+
+      size = fifo_read_avail(dsp->queue);
+      if (size > dsp->block_size)
+         size = dsp->block_size;
+      fifo_read(dsp->queue, dsp->block, size);
+
+      /* Room for the emulation thread again. */
+      scond_signal(dsp->cond);
+      slock_unlock(dsp->lock);
+
+      slock_lock(dsp->chain_lock);
+      retro_process_audio(dsp->block, size / sizeof(int16_t));
+      slock_unlock(dsp->chain_lock);
+   }
+}
+
+static void audio_dsp_thread_free(audio_dsp_thread_t *dsp)
+{
+   if (!dsp)
+      return;
+
+   if (dsp->thread)
+   {
+      slock_lock(dsp->lock);
+      dsp->alive = false;
+      scond_signal(dsp->cond);
+      slock_unlock(dsp->lock);
+
+      sthread_join(dsp->thread);
+   }
+
+   if (dsp->lock)
+      slock_free(dsp->lock);
+   if (dsp->cond)
+      scond_free(dsp->cond);
+   if (dsp->chain_lock)
+      slock_free(dsp->chain_lock);
+   if (dsp->queue)
+      fifo_free(dsp->queue);
+   free(dsp->block);
+   free(dsp);
+}
+
+/**
+ * audio_thread_dsp_init:
+ * @block_samples             : most samples the chain takes at once.
+ *
+ * Starts a thread which runs samples pushed with
+ * audio_thread_dsp_push() through the DSP filter and
+ * resampler, and writes them to the audio driver.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool audio_thread_dsp_init(size_t block_samples)
+{
+   audio_dsp_thread_t *dsp = NULL;
+
+   if (audio_dsp_thread)
+      return true;
+
+   dsp = (audio_dsp_thread_t*)calloc(1, sizeof(*dsp));
+   if (!dsp)
+      return false;
+
+   /* Whole stereo frames only, so reads never split one. */
+   block_samples  &= ~(size_t)1;
+   dsp->block_size = block_samples * sizeof(int16_t);
+
+   if (!(dsp->block      = (int16_t*)malloc(dsp->block_size)))
+      goto error;
+   /* A block in flight plus about one queued keeps the
+    * latency added on top of the driver buffer low. */
+   if (!(dsp->queue      = fifo_new(dsp->block_size)))
+      goto error;
+   if (!(dsp->cond       = scond_new()))
+      goto error;
+   if (!(dsp->lock       = slock_new()))
+      goto error;
+   if (!(dsp->chain_lock = slock_new()))
+      goto error;
+
+   dsp->alive = true;
+
+   if (!(dsp->thread     = sthread_create(audio_dsp_thread_loop, dsp)))
+      goto error;
+
+   RARCH_LOG("[Audio Thread]: Running DSP and resampler on a thread.\n");
+   audio_dsp_thread = dsp;
+   return true;
+
+error:
+   dsp->alive = false;
+   audio_dsp_thread_free(dsp);
+   return false;
+}
+
+/**
+ * audio_thread_dsp_deinit:
+ *
+ * Stops the thread started by audio_thread_dsp_init().
+ * Samples still queued are dropped.
+ **/
+void audio_thread_dsp_deinit(void)
+{
+   audio_dsp_thread_free(audio_dsp_thread);
+   audio_dsp_thread = NULL;
+}
+
+/**
+ * audio_thread_dsp_push:
+ * @data                      : pointer to audio buffer.
+ * @samples                   : amount of samples in @data.
+ * @nonblock                  : drop what does not fit rather
+ *                              than wait for the thread.
+ *
+ * Queues samples for the thread started by audio_thread_dsp_init().
+ * Waiting for room in the queue paces the emulation thread
+ * like a blocking audio driver would.
+ **/
+void audio_thread_dsp_push(const int16_t *data, size_t samples,
+      bool nonblock)
+{
+   const uint8_t *src      = (const uint8_t*)data;
+   size_t size             = samples * sizeof(int16_t);
+   audio_dsp_thread_t *dsp = audio_dsp_thread;
+
+   if (!dsp)
+      return;
+
+   slock_lock(dsp->lock);
+
+   while (size)
+   {
+      size_t avail = fifo_write_avail(dsp->queue) & ~(size_t)3;
+
+      if (!avail)
+      {
+         if (nonblock)
+            break;
+         scond_wait(dsp->cond, dsp->lock);
+         continue;
+      }
+
+      if (avail > size)
+         avail = size;
+
+      fifo_write(dsp->queue, src, avail);
+      src  += avail;
+      size -= avail;
+
+      scond_signal(dsp->cond);
+   }
+
+   slock_unlock(dsp->lock);
+}
+
+/**
+ * audio_thread_dsp_lock:
+ *
+ * Waits for the thread started by audio_thread_dsp_init()
+ * to finish its current block, and keeps it from starting
+ * another until audio_thread_dsp_unlock(). Does nothing
+ * when the thread is not running.
+ **/
+void audio_thread_dsp_lock(void)
+{
+   if (audio_dsp_thread)
+      slock_lock(audio_dsp_thread->chain_lock);
+}
+
+void audio_thread_dsp_unlock(void)
+{
+   if (audio_dsp_thread)
+      slock_unlock(audio_dsp_thread->chain_lock);
+}
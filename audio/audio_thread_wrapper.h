@@ -18,6 +18,8 @@
 #define RARCH_AUDIO_THREAD_H__
 
 #include "../driver.h"
+#include <stdint.h>
+#include <stddef.h>
 #include <boolean.h>
 
 /**
@@ -39,5 +41,51 @@ bool rarch_threaded_audio_init(const audio_driver_t **out_driver, void **out_dat
       const char *device, unsigned out_rate, unsigned latency,
       const audio_driver_t *driver);
 
+/**
+ * audio_thread_dsp_init:
+ * @block_samples             : most samples the chain takes at once.
+ *
+ * Starts a thread which runs samples pushed with
+ * audio_thread_dsp_push() through the DSP filter and
+ * resampler, and writes them to the audio driver.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool audio_thread_dsp_init(size_t block_samples);
+
+/**
+ * audio_thread_dsp_deinit:
+ *
+ * Stops the thread started by audio_thread_dsp_init().
+ * Samples still queued are dropped.
+ **/
+void audio_thread_dsp_deinit(void);
+
+/**
+ * audio_thread_dsp_push:
+ * @data                      : pointer to audio buffer.
+ * @samples                   : amount of samples in @data.
+ * @nonblock                  : drop what does not fit rather
+ *                              than wait for the thread.
+ *
+ * Queues samples for the thread started by audio_thread_dsp_init().
+ * Waiting for room in the queue paces the emulation thread
+ * like a blocking audio driver would.
+ **/
+void audio_thread_dsp_push(const int16_t *data, size_t samples,
+      bool nonblock);
+
+/**
+ * audio_thread_dsp_lock:
+ *
+ * Waits for the thread started by audio_thread_dsp_init()
+ * to finish its current block, and keeps it from starting
+ * another until audio_thread_dsp_unlock(). Does nothing
+ * when the thread is not running.
+ **/
+void audio_thread_dsp_lock(void);
+
+void audio_thread_dsp_unlock(void);
+
 #endif
 
@@ -0,0 +1,454 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <queues/fifo_spsc.h>
+
+#include "../../driver.h"
+#include "../../general.h"
+#include "../../dylib.h"
+
+/* AAudio only exists from Android 8.0 on, while we still run on
+ * far older releases, so libaaudio.so is opened at runtime and
+ * the few parts of <aaudio/AAudio.h> we use are declared here.
+ * Where it is missing, the driver runs on OpenSL ES instead. */
+
+typedef int32_t aaudio_result_t;
+typedef struct AAudioStreamStruct AAudioStream;
+typedef struct AAudioStreamBuilderStruct AAudioStreamBuilder;
+
+#define AAUDIO_OK                              0
+#define AAUDIO_UNSPECIFIED                     0
+#define AAUDIO_DIRECTION_OUTPUT                0
+#define AAUDIO_FORMAT_PCM_I16                  1
+#define AAUDIO_FORMAT_PCM_FLOAT                2
+#define AAUDIO_SHARING_MODE_SHARED             1
+#define AAUDIO_PERFORMANCE_MODE_LOW_LATENCY    12
+#define AAUDIO_CALLBACK_RESULT_CONTINUE        0
+
+typedef int32_t (*aaudio_data_callback_t)(AAudioStream *stream,
+      void *user, void *data, int32_t frames);
+typedef void (*aaudio_error_callback_t)(AAudioStream *stream,
+      void *user, aaudio_result_t error);
+
+static struct
+{
+   dylib_t lib;
+   aaudio_result_t (*create_builder)(AAudioStreamBuilder**);
+   void (*set_direction)(AAudioStreamBuilder*, int32_t);
+   void (*set_sharing_mode)(AAudioStreamBuilder*, int32_t);
+   void (*set_performance_mode)(AAudioStreamBuilder*, int32_t);
+   void (*set_format)(AAudioStreamBuilder*, int32_t);
+   void (*set_channel_count)(AAudioStreamBuilder*, int32_t);
+   void (*set_sample_rate)(AAudioStreamBuilder*, int32_t);
+   void (*set_data_callback)(AAudioStreamBuilder*,
+         aaudio_data_callback_t, void*);
+   void (*set_error_callback)(AAudioStreamBuilder*,
+         aaudio_error_callback_t, void*);
+   aaudio_result_t (*open_stream)(AAudioStreamBuilder*, AAudioStream**);
+   aaudio_result_t (*delete_builder)(AAudioStreamBuilder*);
+   aaudio_result_t (*request_start)(AAudioStream*);
+   aaudio_result_t (*request_pause)(AAudioStream*);
+   aaudio_result_t (*request_stop)(AAudioStream*);
+   aaudio_result_t (*close)(AAudioStream*);
+   int32_t (*get_sample_rate)(AAudioStream*);
+   int32_t (*get_format)(AAudioStream*);
+   int32_t (*get_frames_per_burst)(AAudioStream*);
+   int32_t (*get_performance_mode)(AAudioStream*);
+   aaudio_result_t (*set_buffer_size)(AAudioStream*, int32_t);
+} aaudio;
+
+typedef struct aaudio_audio
+{
+   AAudioStream *stream;
+
+   bool nonblock;
+   bool is_paused;
+   bool has_float;
+   volatile bool disconnected;
+
+   unsigned rate;
+   size_t frame_size;
+   size_t buffer_size;
+   int32_t burst_frames;
+
+   fifo_spsc_t *buffer;
+   scond_t *cond;
+   slock_t *cond_lock;
+
+   /* Set when running on OpenSL ES instead. */
+   void *sl;
+} aaudio_t;
+
+static bool aaudio_load(void)
+{
+   if (aaudio.lib)
+      return true;
+
+   aaudio.lib = dylib_load("libaaudio.so");
+   if (!aaudio.lib)
+      return false;
+
+#define AAUDIO_SYM(field, name) do { \
+   function_t func = dylib_proc(aaudio.lib, name); \
+   if (!func) \
+      goto error; \
+   memcpy(&aaudio.field, &func, sizeof(func)); \
+} while (0)
+
+   AAUDIO_SYM(create_builder,       "AAudio_createStreamBuilder");
+   AAUDIO_SYM(set_direction,        "AAudioStreamBuilder_setDirection");
+   AAUDIO_SYM(set_sharing_mode,     "AAudioStreamBuilder_setSharingMode");
+   AAUDIO_SYM(set_performance_mode, "AAudioStreamBuilder_setPerformanceMode");
+   AAUDIO_SYM(set_format,           "AAudioStreamBuilder_setFormat");
+   AAUDIO_SYM(set_channel_count,    "AAudioStreamBuilder_setChannelCount");
+   AAUDIO_SYM(set_sample_rate,      "AAudioStreamBuilder_setSampleRate");
+   AAUDIO_SYM(set_data_callback,    "AAudioStreamBuilder_setDataCallback");
+   AAUDIO_SYM(set_error_callback,   "AAudioStreamBuilder_setErrorCallback");
+   AAUDIO_SYM(open_stream,          "AAudioStreamBuilder_openStream");
+   AAUDIO_SYM(delete_builder,       "AAudioStreamBuilder_delete");
+   AAUDIO_SYM(request_start,        "AAudioStream_requestStart");
+   AAUDIO_SYM(request_pause,        "AAudioStream_requestPause");
+   AAUDIO_SYM(request_stop,         "AAudioStream_requestStop");
+   AAUDIO_SYM(close,                "AAudioStream_close");
+   AAUDIO_SYM(get_sample_rate,      "AAudioStream_getSampleRate");
+   AAUDIO_SYM(get_format,           "AAudioStream_getFormat");
+   AAUDIO_SYM(get_frames_per_burst, "AAudioStream_getFramesPerBurst");
+   AAUDIO_SYM(get_performance_mode, "AAudioStream_getPerformanceMode");
+   AAUDIO_SYM(set_buffer_size,      "AAudioStream_setBufferSizeInFrames");
+
+#undef AAUDIO_SYM
+
+   return true;
+
+error:
+   dylib_close(aaudio.lib);
+   aaudio.lib = NULL;
+   return false;
+}
+
+static int32_t aaudio_data_cb(AAudioStream *stream,
+      void *user, void *data, int32_t frames)
+{
+   aaudio_t *aa = (aaudio_t*)user;
+   size_t size  = frames * aa->frame_size;
+   size_t avail = min(fifo_spsc_read_avail(aa->buffer), size);
+
+   fifo_spsc_read(aa->buffer, data, avail);
+
+   /* Never take a lock on the audio thread. A writer that
+    * misses this wakeup gets the next one, a burst later. */
+   scond_signal(aa->cond);
+
+   /* If underrun, fill rest with silence. */
+   memset((uint8_t*)data + avail, 0, size - avail);
+
+   return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+static void aaudio_error_cb(AAudioStream *stream,
+      void *user, aaudio_result_t error)
+{
+   aaudio_t *aa = (aaudio_t*)user;
+
+   /* The stream can't be closed from its own callbacks,
+    * aaudio_write() reopens it. */
+   aa->disconnected = true;
+   scond_signal(aa->cond);
+}
+
+static bool aaudio_open_stream(aaudio_t *aa, unsigned rate)
+{
+   AAudioStreamBuilder *builder = NULL;
+   aaudio_result_t res;
+
+   if (aaudio.create_builder(&builder) != AAUDIO_OK)
+      return false;
+
+   aaudio.set_direction(builder, AAUDIO_DIRECTION_OUTPUT);
+   aaudio.set_sharing_mode(builder, AAUDIO_SHARING_MODE_SHARED);
+   aaudio.set_performance_mode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+   aaudio.set_format(builder, AAUDIO_FORMAT_PCM_FLOAT);
+   aaudio.set_channel_count(builder, 2);
+   /* Left unspecified, the stream runs at the native rate of the
+    * device, which is the one the fast mixer path needs. */
+   aaudio.set_sample_rate(builder, rate);
+   aaudio.set_data_callback(builder, aaudio_data_cb, aa);
+   aaudio.set_error_callback(builder, aaudio_error_cb, aa);
+
+   res = aaudio.open_stream(builder, &aa->stream);
+   aaudio.delete_builder(builder);
+
+   if (res != AAUDIO_OK)
+   {
+      aa->stream = NULL;
+      RARCH_ERR("[AAudio]: Failed to open stream, error code: [%d].\n",
+            (int)res);
+      return false;
+   }
+
+   aa->has_float    = aaudio.get_format(aa->stream) ==
+      AAUDIO_FORMAT_PCM_FLOAT;
+   aa->frame_size   = 2 * (aa->has_float ? sizeof(float) : sizeof(int16_t));
+   aa->rate         = aaudio.get_sample_rate(aa->stream);
+   aa->burst_frames = aaudio.get_frames_per_burst(aa->stream);
+
+   /* Two bursts is the least the device buffer
+    * can hold without glitching. */
+   aaudio.set_buffer_size(aa->stream, 2 * aa->burst_frames);
+
+   if (aaudio.get_performance_mode(aa->stream) !=
+         AAUDIO_PERFORMANCE_MODE_LOW_LATENCY)
+      RARCH_WARN("[AAudio]: Low latency mode unavailable.\n");
+
+   return true;
+}
+
+static void aaudio_close_stream(aaudio_t *aa)
+{
+   if (!aa->stream)
+      return;
+
+   aaudio.request_stop(aa->stream);
+   aaudio.close(aa->stream);
+   aa->stream = NULL;
+}
+
+static void aaudio_free(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (!aa)
+      return;
+
+   if (aa->sl)
+      audio_opensl.free(aa->sl);
+
+   aaudio_close_stream(aa);
+
+   if (aa->buffer)
+      fifo_spsc_free(aa->buffer);
+   if (aa->cond)
+      scond_free(aa->cond);
+   if (aa->cond_lock)
+      slock_free(aa->cond_lock);
+   free(aa);
+}
+
+static void *aaudio_init(const char *device, unsigned rate, unsigned latency)
+{
+   settings_t *settings = config_get_ptr();
+   aaudio_t *aa         = (aaudio_t*)calloc(1, sizeof(aaudio_t));
+
+   (void)device;
+
+   if (!aa)
+      return NULL;
+
+   if (!aaudio_load() || !aaudio_open_stream(aa, AAUDIO_UNSPECIFIED))
+   {
+      RARCH_WARN("[AAudio]: AAudio unavailable, using OpenSL ES.\n");
+      aaudio_close_stream(aa);
+      aa->sl = audio_opensl.init(device, rate, latency);
+      if (!aa->sl)
+         goto error;
+      return aa;
+   }
+
+   aa->buffer_size = max(latency * aa->rate / 1000,
+         4 * (unsigned)aa->burst_frames) * aa->frame_size;
+
+   RARCH_LOG("[AAudio]: %s, %u Hz, %d frames per burst.\n",
+         aa->has_float ? "float" : "s16", aa->rate, (int)aa->burst_frames);
+
+   if (aa->rate != rate)
+      settings->audio.out_rate = aa->rate;
+
+   aa->cond_lock = slock_new();
+   aa->cond      = scond_new();
+   aa->buffer    = fifo_spsc_new(aa->buffer_size);
+   if (!aa->cond_lock || !aa->cond || !aa->buffer)
+      goto error;
+
+   if (aaudio.request_start(aa->stream) != AAUDIO_OK)
+      goto error;
+
+   return aa;
+
+error:
+   RARCH_ERR("[AAudio]: Failed to initialize...\n");
+   aaudio_free(aa);
+   return NULL;
+}
+
+static bool aaudio_reopen(aaudio_t *aa)
+{
+   unsigned rate = aa->rate;
+
+   RARCH_LOG("[AAudio]: Stream disconnected, reopening.\n");
+
+   aaudio_close_stream(aa);
+   aa->disconnected = false;
+
+   /* Keep the rate and format the rest of the
+    * audio pipeline was set up for. */
+   if (!aaudio_open_stream(aa, rate) || aa->rate != rate)
+      return false;
+
+   if (!aa->is_paused && aaudio.request_start(aa->stream) != AAUDIO_OK)
+      return false;
+
+   return true;
+}
+
+static ssize_t aaudio_write(void *data, const void *buf, size_t size)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.write(aa->sl, buf, size);
+
+   if (aa->disconnected)
+   {
+      bool has_float = aa->has_float;
+      if (!aaudio_reopen(aa) || aa->has_float != has_float)
+         return -1;
+   }
+
+   if (aa->nonblock)
+   {
+      size_t avail = fifo_spsc_write_avail(aa->buffer);
+      size_t write_amt = min(avail, size);
+      fifo_spsc_write(aa->buffer, buf, write_amt);
+      return write_amt;
+   }
+   else
+   {
+      size_t written = 0;
+      while (written < size && !aa->disconnected)
+      {
+         size_t avail = fifo_spsc_write_avail(aa->buffer);
+
+         if (avail == 0)
+         {
+            slock_lock(aa->cond_lock);
+            if (!aa->disconnected && !fifo_spsc_write_avail(aa->buffer))
+               scond_wait(aa->cond, aa->cond_lock);
+            slock_unlock(aa->cond_lock);
+         }
+         else
+         {
+            size_t write_amt = min(size - written, avail);
+            fifo_spsc_write(aa->buffer, (const char*)buf + written, write_amt);
+            written += write_amt;
+         }
+      }
+      return written;
+   }
+}
+
+static bool aaudio_stop(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.stop(aa->sl);
+
+   if (!aa->is_paused && !aa->disconnected &&
+         aaudio.request_pause(aa->stream) != AAUDIO_OK)
+      return false;
+   aa->is_paused = true;
+   return true;
+}
+
+static bool aaudio_start(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.start(aa->sl);
+
+   if (aa->is_paused && !aa->disconnected &&
+         aaudio.request_start(aa->stream) != AAUDIO_OK)
+      return false;
+   aa->is_paused = false;
+   return true;
+}
+
+static bool aaudio_alive(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+   if (!aa)
+      return false;
+   if (aa->sl)
+      return audio_opensl.alive(aa->sl);
+   return !aa->is_paused;
+}
+
+static void aaudio_set_nonblock_state(void *data, bool state)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      audio_opensl.set_nonblock_state(aa->sl, state);
+   aa->nonblock = state;
+}
+
+static bool aaudio_use_float(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.use_float(aa->sl);
+   return aa->has_float;
+}
+
+static size_t aaudio_write_avail(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.write_avail(aa->sl);
+   return fifo_spsc_write_avail(aa->buffer);
+}
+
+static size_t aaudio_buffer_size(void *data)
+{
+   aaudio_t *aa = (aaudio_t*)data;
+
+   if (aa->sl)
+      return audio_opensl.buffer_size(aa->sl);
+   return aa->buffer_size;
+}
+
+audio_driver_t audio_aaudio = {
+   aaudio_init,
+   aaudio_write,
+   aaudio_stop,
+   aaudio_start,
+   aaudio_alive,
+   aaudio_set_nonblock_state,
+   aaudio_free,
+   aaudio_use_float,
+   "aaudio",
+   aaudio_write_avail,
+   aaudio_buffer_size,
+};
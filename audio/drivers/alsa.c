@@ -16,6 +16,7 @@
 
 #include "../../driver.h"
 #include <stdlib.h>
+#include <string.h>
 #include <alsa/asoundlib.h>
 #include "../../general.h"
 
@@ -31,6 +32,8 @@ typedef struct alsa
    bool has_float;
    bool can_pause;
    bool is_paused;
+   bool mmap;
+   snd_pcm_uframes_t start_threshold;
 } alsa_t;
 
 static bool alsa_use_float(void *data)
@@ -59,6 +62,7 @@ static void *alsa_init(const char *device, unsigned rate, unsigned latency)
    snd_pcm_uframes_t buffer_size;
    snd_pcm_hw_params_t *params = NULL;
    snd_pcm_sw_params_t *sw_params = NULL;
+   settings_t *settings = config_get_ptr();
 
    unsigned latency_usec = latency * 1000;
    unsigned channels = 2;
@@ -80,8 +84,20 @@ static void *alsa_init(const char *device, unsigned rate, unsigned latency)
    format = alsa->has_float ? SND_PCM_FORMAT_FLOAT : SND_PCM_FORMAT_S16;
 
    TRY_ALSA(snd_pcm_hw_params_any(alsa->pcm, params));
+
+   /* In exclusive mode, write straight into the device ring buffer
+    * instead of going through snd_pcm_writei(). */
+   if (settings->audio.exclusive_mode)
+   {
+      alsa->mmap = snd_pcm_hw_params_test_access(alsa->pcm, params,
+            SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+      if (!alsa->mmap)
+         RARCH_WARN("ALSA: Device cannot be mmap'ed, using regular writes.\n");
+   }
+
    TRY_ALSA(snd_pcm_hw_params_set_access(
-            alsa->pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED));
+            alsa->pcm, params, alsa->mmap ?
+            SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED));
    TRY_ALSA(snd_pcm_hw_params_set_format(alsa->pcm, params, format));
    TRY_ALSA(snd_pcm_hw_params_set_channels(alsa->pcm, params, channels));
    TRY_ALSA(snd_pcm_hw_params_set_rate(alsa->pcm, params, rate, 0));
@@ -104,11 +120,13 @@ static void *alsa_init(const char *device, unsigned rate, unsigned latency)
    alsa->buffer_size = snd_pcm_frames_to_bytes(alsa->pcm, buffer_size);
    alsa->can_pause = snd_pcm_hw_params_can_pause(params);
    RARCH_LOG("ALSA: Can pause: %s.\n", alsa->can_pause ? "yes" : "no");
+   RARCH_LOG("ALSA: Using %s access.\n", alsa->mmap ? "mmap" : "read/write");
+   alsa->start_threshold = buffer_size / 2;
 
    TRY_ALSA(snd_pcm_sw_params_malloc(&sw_params));
    TRY_ALSA(snd_pcm_sw_params_current(alsa->pcm, sw_params));
    TRY_ALSA(snd_pcm_sw_params_set_start_threshold(
-            alsa->pcm, sw_params, buffer_size / 2));
+            alsa->pcm, sw_params, alsa->start_threshold));
    TRY_ALSA(snd_pcm_sw_params(alsa->pcm, sw_params));
 
    snd_pcm_hw_params_free(params);
@@ -134,6 +152,115 @@ error:
    return NULL;
 }
 
+/**
+ * alsa_recover:
+ * @alsa                 : ALSA handle.
+ * @err                  : Error code returned by ALSA.
+ *
+ * Recovers from an xrun or a suspend. A recovered stream goes
+ * back to the prepared state and is restarted by the next write.
+ *
+ * Returns: true (1) if the stream can be written to again,
+ * otherwise false (0).
+ **/
+static bool alsa_recover(alsa_t *alsa, int err)
+{
+   if (snd_pcm_recover(alsa->pcm, err, 1) < 0)
+   {
+      RARCH_ERR("[ALSA]: Failed to recover from error (%s)\n",
+            snd_strerror(err));
+      return false;
+   }
+   return true;
+}
+
+/**
+ * alsa_write_mmap:
+ * @alsa                 : ALSA handle.
+ * @buf                  : Interleaved samples (resampler output).
+ * @size                 : Number of frames in @buf.
+ *
+ * Copies @buf straight into the mmap'ed device buffer, in as many
+ * pieces as the ring buffer wraps. Unlike snd_pcm_writei(), committing
+ * mmap'ed frames never starts the stream, so start it here once the
+ * start threshold is buffered.
+ *
+ * Returns: number of frames written, or -1 on error.
+ **/
+static ssize_t alsa_write_mmap(alsa_t *alsa,
+      const uint8_t *buf, snd_pcm_sframes_t size)
+{
+   snd_pcm_sframes_t written = 0;
+   size_t frame_size         = snd_pcm_frames_to_bytes(alsa->pcm, 1);
+
+   while (size)
+   {
+      const snd_pcm_channel_area_t *areas;
+      snd_pcm_uframes_t offset;
+      snd_pcm_uframes_t frames;
+      snd_pcm_sframes_t committed;
+      snd_pcm_sframes_t avail = snd_pcm_avail_update(alsa->pcm);
+      int rc;
+
+      if (avail < 0)
+      {
+         if (!alsa_recover(alsa, avail))
+            return -1;
+         continue;
+      }
+
+      if (avail == 0)
+      {
+         if (alsa->nonblock)
+            break;
+
+         if (snd_pcm_state(alsa->pcm) == SND_PCM_STATE_PREPARED)
+            snd_pcm_start(alsa->pcm);
+
+         rc = snd_pcm_wait(alsa->pcm, -1);
+         if (rc < 0 && !alsa_recover(alsa, rc))
+            return -1;
+         continue;
+      }
+
+      frames = (snd_pcm_uframes_t)(avail < size ? avail : size);
+      rc     = snd_pcm_mmap_begin(alsa->pcm, &areas, &offset, &frames);
+      if (rc < 0)
+      {
+         if (!alsa_recover(alsa, rc))
+            return -1;
+         continue;
+      }
+
+      /* Interleaved access, so every channel shares the first area. */
+      memcpy((uint8_t*)areas[0].addr + areas[0].first / 8
+            + offset * (areas[0].step / 8), buf, frames * frame_size);
+
+      committed = snd_pcm_mmap_commit(alsa->pcm, offset, frames);
+      if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+      {
+         if (!alsa_recover(alsa, committed < 0 ? committed : -EPIPE))
+            return -1;
+         continue;
+      }
+
+      written += committed;
+      buf     += committed * frame_size;
+      size    -= committed;
+   }
+
+   if (snd_pcm_state(alsa->pcm) == SND_PCM_STATE_PREPARED)
+   {
+      snd_pcm_sframes_t delay = 0;
+
+      if (snd_pcm_delay(alsa->pcm, &delay) == 0
+            && delay >= (snd_pcm_sframes_t)alsa->start_threshold)
+         snd_pcm_start(alsa->pcm);
+   }
+
+   return written;
+}
+
 static ssize_t alsa_write(void *data, const void *buf_, size_t size_)
 {
    alsa_t *alsa              = (alsa_t*)data;
@@ -142,6 +269,9 @@ static ssize_t alsa_write(void *data, const void *buf_, size_t size_)
    snd_pcm_sframes_t written = 0;
    snd_pcm_sframes_t size    = snd_pcm_bytes_to_frames(alsa->pcm, size_);
 
+   if (alsa->mmap)
+      return alsa_write_mmap(alsa, buf, size);
+
    while (size)
    {
       snd_pcm_sframes_t frames;
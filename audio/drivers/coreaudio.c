@@ -16,7 +16,7 @@
 
 #include "../../driver.h"
 #include "../../general.h"
-#include <queues/fifo_buffer.h>
+#include <queues/fifo_spsc.h>
 #include <stdlib.h>
 #include <boolean.h>
 #include <pthread.h>
@@ -52,7 +52,7 @@ typedef struct coreaudio
    bool dev_alive;
    bool is_paused;
 
-   fifo_buffer_t *buffer;
+   fifo_spsc_t *buffer;
    bool nonblock;
    size_t buffer_size;
 } coreaudio_t;
@@ -77,7 +77,7 @@ static void coreaudio_free(void *data)
    }
 
    if (dev->buffer)
-      fifo_free(dev->buffer);
+      fifo_spsc_free(dev->buffer);
 
    pthread_mutex_destroy(&dev->lock);
    pthread_cond_destroy(&dev->cond);
@@ -106,24 +106,21 @@ static OSStatus audio_write_cb(void *userdata,
    write_avail = io_data->mBuffers[0].mDataByteSize;
    outbuf = io_data->mBuffers[0].mData;
 
-   pthread_mutex_lock(&dev->lock);
-
-   if (fifo_read_avail(dev->buffer) < write_avail)
+   /* The render callback runs on a realtime thread, 
+    * so it never takes dev->lock. */
+   if (fifo_spsc_read_avail(dev->buffer) < write_avail)
    {
       *action_flags = kAudioUnitRenderAction_OutputIsSilence;
 
       /* Seems to be needed. */
       memset(outbuf, 0, write_avail);
 
-      pthread_mutex_unlock(&dev->lock);
-
       /* Technically possible to deadlock without. */
       pthread_cond_signal(&dev->cond); 
       return noErr;
    }
 
-   fifo_read(dev->buffer, outbuf, write_avail);
-   pthread_mutex_unlock(&dev->lock);
+   fifo_spsc_read(dev->buffer, outbuf, write_avail);
    pthread_cond_signal(&dev->cond);
    return noErr;
 }
@@ -318,7 +315,7 @@ static void *coreaudio_init(const char *device,
    fifo_size *= 2 * sizeof(float);
    dev->buffer_size = fifo_size;
 
-   dev->buffer = fifo_new(fifo_size);
+   dev->buffer = fifo_spsc_new(fifo_size);
    if (!dev->buffer)
       goto error;
 
@@ -355,31 +352,30 @@ static ssize_t coreaudio_write(void *data, const void *buf_, size_t size)
 
    while (!g_interrupted && size > 0)
    {
-      size_t write_avail;
-
-      pthread_mutex_lock(&dev->lock);
-
-      write_avail = fifo_write_avail(dev->buffer);
+      size_t write_avail = fifo_spsc_write_avail(dev->buffer);
       if (write_avail > size)
          write_avail = size;
 
-      fifo_write(dev->buffer, buf, write_avail);
+      fifo_spsc_write(dev->buffer, buf, write_avail);
       buf += write_avail;
       written += write_avail;
       size -= write_avail;
 
       if (dev->nonblock)
-      {
-         pthread_mutex_unlock(&dev->lock);
          break;
-      }
 
+      if (write_avail != 0)
+         continue;
+
+      /* The callback signals without the lock, so recheck 
+       * before sleeping. A missed wakeup costs one callback. */
+      pthread_mutex_lock(&dev->lock);
 #ifdef IOS
-      if (write_avail == 0 && pthread_cond_timedwait(
+      if (!fifo_spsc_write_avail(dev->buffer) && pthread_cond_timedwait(
                &dev->cond, &dev->lock, &timeout) == ETIMEDOUT)
          g_interrupted = true;
 #else
-      if (write_avail == 0)
+      if (!fifo_spsc_write_avail(dev->buffer))
          pthread_cond_wait(&dev->cond, &dev->lock);
 #endif
       pthread_mutex_unlock(&dev->lock);
@@ -432,9 +428,7 @@ static size_t coreaudio_write_avail(void *data)
    size_t avail;
    coreaudio_t *dev = (coreaudio_t*)data;
 
-   pthread_mutex_lock(&dev->lock);
-   avail = fifo_write_avail(dev->buffer);
-   pthread_mutex_unlock(&dev->lock);
+   avail = fifo_spsc_write_avail(dev->buffer);
 
    return avail;
 }
@@ -40,6 +40,7 @@ typedef struct al
    ALuint *res_buf;
    size_t res_ptr;
    ALenum format;
+   bool has_float;
    size_t num_buffers;
    int rate;
 
@@ -97,10 +98,28 @@ static void *al_init(const char *device, unsigned rate, unsigned latency)
 
    alcMakeContextCurrent(al->ctx);
 
-   al->rate = rate;
+   al->rate   = rate;
+   al->format = AL_FORMAT_STEREO16;
+
+   /* Take float samples as they come out of the resampler 
+    * if the implementation has them. */
+   if (alIsExtensionPresent("AL_EXT_FLOAT32"))
+   {
+      ALenum format = alGetEnumValue("AL_FORMAT_STEREO_FLOAT32");
+
+      if (format && format != -1)
+      {
+         al->format    = format;
+         al->has_float = true;
+      }
+   }
+
+   RARCH_LOG("[OpenAL]: Using %s samples.\n",
+         al->has_float ? "floating point" : "signed 16-bit");
 
    /* We already use one buffer for tmpbuf. */
-   al->num_buffers = (latency * rate * 2 * sizeof(int16_t)) / (1000 * BUFSIZE) - 1;
+   al->num_buffers = (latency * rate * 2 *
+         (al->has_float ? sizeof(float) : sizeof(int16_t))) / (1000 * BUFSIZE) - 1;
    if (al->num_buffers < 2)
       al->num_buffers = 2;
 
@@ -189,7 +208,7 @@ static ssize_t al_write(void *data, const void *buf_, size_t size)
       if (!al_get_buffer(al, &buffer))
          break;
 
-      alBufferData(buffer, AL_FORMAT_STEREO16, al->tmpbuf, BUFSIZE, al->rate);
+      alBufferData(buffer, al->format, al->tmpbuf, BUFSIZE, al->rate);
       al->tmpbuf_ptr = 0;
       alSourceQueueBuffers(al->source, 1, &buffer);
       if (alGetError() != AL_NO_ERROR)
@@ -252,8 +271,8 @@ static size_t al_buffer_size(void *data)
 
 static bool al_use_float(void *data)
 {
-   (void)data;
-   return false;
+   al_t *al = (al_t*)data;
+   return al->has_float;
 }
 
 audio_driver_t audio_openal = {
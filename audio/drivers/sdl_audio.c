@@ -26,26 +26,28 @@
 #include <rthreads/rthreads.h>
 
 #include "../../general.h"
-#include <queues/fifo_buffer.h>
+#include <queues/fifo_spsc.h>
 #include <retro_inline.h>
 
 typedef struct sdl_audio
 {
    bool nonblock;
    bool is_paused;
+   bool has_float;
 
    slock_t *lock;
    scond_t *cond;
-   fifo_buffer_t *buffer;
+   fifo_spsc_t *buffer;
 } sdl_audio_t;
 
 static void sdl_audio_cb(void *data, Uint8 *stream, int len)
 {
    sdl_audio_t *sdl = (sdl_audio_t*)data;
-   size_t avail = fifo_read_avail(sdl->buffer);
+   size_t avail = fifo_spsc_read_avail(sdl->buffer);
    size_t write_size = len > (int)avail ? avail : len;
 
-   fifo_read(sdl->buffer, stream, write_size);
+   /* Lock-free, so the writer can never stall the audio thread. */
+   fifo_spsc_read(sdl->buffer, stream, write_size);
    scond_signal(sdl->cond);
 
    /* If underrun, fill rest with silence. */
@@ -93,7 +95,12 @@ static void *sdl_audio_init(const char *device,
    frames = find_num_frames(rate, latency / 4);
 
    spec.freq = rate;
+#ifdef HAVE_SDL2
+   /* SDL2 takes float, so samples stay float until the OS mixer. */
+   spec.format = AUDIO_F32SYS;
+#else
    spec.format = AUDIO_S16SYS;
+#endif
    spec.channels = 2;
    spec.samples = frames; // This is in audio frames, not samples ... :(
    spec.callback = sdl_audio_cb;
@@ -106,6 +113,24 @@ static void *sdl_audio_init(const char *device,
       return 0;
    }
 
+   /* SDL may hand back another format since we ask for the 
+    * obtained spec. */
+   if (out.format != AUDIO_S16SYS
+#ifdef HAVE_SDL2
+         && out.format != AUDIO_F32SYS
+#endif
+      )
+   {
+      RARCH_ERR("SDL audio: Unsupported sample format 0x%x.\n",
+            (unsigned)out.format);
+      SDL_CloseAudio();
+      free(sdl);
+      return 0;
+   }
+
+#ifdef HAVE_SDL2
+   sdl->has_float = out.format == AUDIO_F32SYS;
+#endif
    settings->audio.out_rate = out.freq;
 
    sdl->lock = slock_new();
@@ -115,13 +140,14 @@ static void *sdl_audio_init(const char *device,
          latency, (int)(out.samples * 4 * 1000 / settings->audio.out_rate));
 
    /* Create a buffer twice as big as needed and prefill the buffer. */
-   bufsize = out.samples * 4 * sizeof(int16_t);
+   bufsize = out.samples * 4 *
+      (sdl->has_float ? sizeof(float) : sizeof(int16_t));
    tmp = calloc(1, bufsize);
-   sdl->buffer = fifo_new(bufsize);
+   sdl->buffer = fifo_spsc_new(bufsize);
 
    if (tmp)
    {
-      fifo_write(sdl->buffer, tmp, bufsize);
+      fifo_spsc_write(sdl->buffer, tmp, bufsize);
       free(tmp);
    }
 
@@ -138,11 +164,9 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
    {
       size_t avail, write_amt;
 
-      SDL_LockAudio();
-      avail = fifo_write_avail(sdl->buffer);
+      avail = fifo_spsc_write_avail(sdl->buffer);
       write_amt = avail > size ? size : avail;
-      fifo_write(sdl->buffer, buf, write_amt);
-      SDL_UnlockAudio();
+      fifo_spsc_write(sdl->buffer, buf, write_amt);
       ret = write_amt;
    }
    else
@@ -153,21 +177,21 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
       {
          size_t avail;
 
-         SDL_LockAudio();
-         avail = fifo_write_avail(sdl->buffer);
+         avail = fifo_spsc_write_avail(sdl->buffer);
 
          if (avail == 0)
          {
-            SDL_UnlockAudio();
+            /* The callback signals without the lock, so a missed 
+             * wakeup only costs one callback period. */
             slock_lock(sdl->lock);
-            scond_wait(sdl->cond, sdl->lock);
+            if (!fifo_spsc_write_avail(sdl->buffer))
+               scond_wait(sdl->cond, sdl->lock);
             slock_unlock(sdl->lock);
          }
          else
          {
             size_t write_amt = size - written > avail ? avail : size - written;
-            fifo_write(sdl->buffer, (const char*)buf + written, write_amt);
-            SDL_UnlockAudio();
+            fifo_spsc_write(sdl->buffer, (const char*)buf + written, write_amt);
             written += write_amt;
          }
       }
@@ -218,7 +242,7 @@ static void sdl_audio_free(void *data)
 
    if (sdl)
    {
-      fifo_free(sdl->buffer);
+      fifo_spsc_free(sdl->buffer);
       slock_free(sdl->lock);
       scond_free(sdl->cond);
    }
@@ -227,8 +251,8 @@ static void sdl_audio_free(void *data)
 
 static bool sdl_audio_use_float(void *data)
 {
-   (void)data;
-   return false;
+   sdl_audio_t *sdl = (sdl_audio_t*)data;
+   return sdl->has_float;
 }
 
 static size_t sdl_audio_write_avail(void *data)
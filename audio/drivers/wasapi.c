@@ -0,0 +1,555 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(_MSC_VER)
+#pragma comment(lib, "ole32")
+#pragma comment(lib, "avrt")
+#endif
+
+#define COBJMACROS
+#include <windows.h>
+#include <mmreg.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <avrt.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <queues/fifo_spsc.h>
+
+#include "../../driver.h"
+#include "../../general.h"
+
+#ifndef SPEAKER_FRONT_LEFT
+#define SPEAKER_FRONT_LEFT  0x1
+#define SPEAKER_FRONT_RIGHT 0x2
+#endif
+
+/* Not every MinGW-w64 release exports these, so carry our own copies. */
+static const GUID wasapi_clsid_enumerator =
+{ 0xbcde0395, 0xe52f, 0x467c, { 0x8e, 0x3d, 0xc4, 0x57, 0x92, 0x91, 0x69, 0x2e } };
+static const GUID wasapi_iid_enumerator =
+{ 0xa95664d2, 0x9614, 0x4f35, { 0xa7, 0x46, 0xde, 0x8d, 0xb6, 0x36, 0x17, 0xe6 } };
+static const GUID wasapi_iid_audio_client =
+{ 0x1cb9ad4c, 0xdbfa, 0x4c32, { 0xb1, 0x78, 0xc2, 0xf5, 0x68, 0xa7, 0x03, 0xb2 } };
+static const GUID wasapi_iid_render_client =
+{ 0xf294acfc, 0x3146, 0x4483, { 0xa7, 0xbf, 0xad, 0xdc, 0xa7, 0xc2, 0x60, 0xe2 } };
+static const GUID wasapi_subtype_float =
+{ 0x00000003, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 } };
+static const GUID wasapi_subtype_pcm =
+{ 0x00000001, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 } };
+
+typedef struct wasapi
+{
+   IMMDevice *device;
+   IAudioClient *client;
+   IAudioRenderClient *renderer;
+   HANDLE event;
+
+   bool com_initialized;
+   bool exclusive;
+   bool nonblock;
+   bool is_paused;
+   bool has_float;
+   volatile bool thread_dead;
+
+   UINT32 buffer_frames;
+   size_t frame_size;
+   size_t buffer_size;
+
+   fifo_spsc_t *buffer;
+   sthread_t *worker_thread;
+   scond_t *cond;
+   slock_t *cond_lock;
+} wasapi_t;
+
+/**
+ * wasapi_set_format:
+ * @wf                   : Format to fill in.
+ * @float_fmt            : Use 32-bit float samples if true, s16 otherwise.
+ * @rate                 : Sample rate.
+ *
+ * Describes an interleaved stereo stream to WASAPI.
+ **/
+static void wasapi_set_format(WAVEFORMATEXTENSIBLE *wf,
+      bool float_fmt, unsigned rate)
+{
+   WORD bits = float_fmt ? 32 : 16;
+
+   memset(wf, 0, sizeof(*wf));
+   wf->Format.wFormatTag           = WAVE_FORMAT_EXTENSIBLE;
+   wf->Format.nChannels            = 2;
+   wf->Format.nSamplesPerSec       = rate;
+   wf->Format.wBitsPerSample       = bits;
+   wf->Format.nBlockAlign          = 2 * bits / 8;
+   wf->Format.nAvgBytesPerSec      = rate * wf->Format.nBlockAlign;
+   wf->Format.cbSize               =
+      sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+   wf->Samples.wValidBitsPerSample = bits;
+   wf->dwChannelMask               = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+   wf->SubFormat                   = float_fmt ?
+      wasapi_subtype_float : wasapi_subtype_pcm;
+}
+
+/**
+ * wasapi_init_device:
+ * @id                   : Endpoint ID string, or NULL.
+ *
+ * Opens the endpoint with the given ID, falling back to
+ * the default render endpoint.
+ *
+ * Returns: endpoint, or NULL if there is none.
+ **/
+static IMMDevice *wasapi_init_device(const char *id)
+{
+   IMMDeviceEnumerator *enumerator = NULL;
+   IMMDevice *device               = NULL;
+   HRESULT hr = CoCreateInstance(&wasapi_clsid_enumerator, NULL,
+         CLSCTX_ALL, &wasapi_iid_enumerator, (void**)&enumerator);
+
+   if (FAILED(hr))
+      return NULL;
+
+   if (id && *id)
+   {
+      wchar_t wide_id[256];
+
+      if (MultiByteToWideChar(CP_UTF8, 0, id, -1, wide_id,
+               sizeof(wide_id) / sizeof(wide_id[0])))
+         hr = IMMDeviceEnumerator_GetDevice(enumerator, wide_id, &device);
+      if (!device)
+         RARCH_WARN("[WASAPI]: Device \"%s\" not found, using default.\n", id);
+   }
+
+   if (!device)
+      hr = IMMDeviceEnumerator_GetDefaultAudioEndpoint(enumerator,
+            eRender, eConsole, &device);
+
+   IMMDeviceEnumerator_Release(enumerator);
+   return SUCCEEDED(hr) ? device : NULL;
+}
+
+static IAudioClient *wasapi_activate(IMMDevice *device)
+{
+   IAudioClient *client = NULL;
+
+   if (FAILED(IMMDevice_Activate(device, &wasapi_iid_audio_client,
+               CLSCTX_ALL, NULL, (void**)&client)))
+      return NULL;
+   return client;
+}
+
+/**
+ * wasapi_init_exclusive:
+ * @w                    : WASAPI handle.
+ * @rate                 : Requested sample rate.
+ *
+ * Opens the endpoint in exclusive, event-driven mode with the
+ * smallest period the device supports. Float and s16 are tried
+ * at the requested rate first, then at 48 and 44.1 kHz.
+ *
+ * Returns: negotiated sample rate, or 0 if the device cannot be
+ * opened exclusively.
+ **/
+static unsigned wasapi_init_exclusive(wasapi_t *w, unsigned rate)
+{
+   unsigned i;
+   const unsigned rates[] = { rate, 48000, 44100 };
+
+   for (i = 0; i < 2 * ARRAY_SIZE(rates); i++)
+   {
+      WAVEFORMATEXTENSIBLE wf;
+      REFERENCE_TIME period_default, period;
+      HRESULT hr;
+      bool float_fmt = !(i & 1);
+
+      if (i >= 2 && rates[i / 2] == rate)
+         continue;
+
+      wasapi_set_format(&wf, float_fmt, rates[i / 2]);
+      if (IAudioClient_IsFormatSupported(w->client,
+               AUDCLNT_SHAREMODE_EXCLUSIVE, &wf.Format, NULL) != S_OK)
+         continue;
+
+      if (FAILED(IAudioClient_GetDevicePeriod(w->client,
+                  &period_default, &period)))
+         return 0;
+
+      /* In exclusive event mode the buffer is one period long. */
+      hr = IAudioClient_Initialize(w->client, AUDCLNT_SHAREMODE_EXCLUSIVE,
+            AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_NOPERSIST,
+            period, period, &wf.Format, NULL);
+
+      if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+      {
+         /* The client has to be thrown away and the period rounded
+          * to what the hardware can actually do. */
+         UINT32 frames;
+
+         if (FAILED(IAudioClient_GetBufferSize(w->client, &frames)))
+            return 0;
+         IAudioClient_Release(w->client);
+         if (!(w->client = wasapi_activate(w->device)))
+            return 0;
+
+         period = (REFERENCE_TIME)(10000000.0 * frames / rates[i / 2] + 0.5);
+         hr = IAudioClient_Initialize(w->client, AUDCLNT_SHAREMODE_EXCLUSIVE,
+               AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_NOPERSIST,
+               period, period, &wf.Format, NULL);
+      }
+
+      if (FAILED(hr))
+         return 0;
+
+      w->has_float = float_fmt;
+      return rates[i / 2];
+   }
+
+   return 0;
+}
+
+/**
+ * wasapi_init_shared:
+ * @w                    : WASAPI handle.
+ *
+ * Opens the endpoint through the system mixer, event-driven,
+ * as float stereo at the mixer's rate.
+ *
+ * Returns: mixer sample rate, or 0 on failure.
+ **/
+static unsigned wasapi_init_shared(wasapi_t *w)
+{
+   WAVEFORMATEXTENSIBLE wf;
+   WAVEFORMATEX *mix_format = NULL;
+   REFERENCE_TIME period_default, period_min;
+   unsigned rate;
+
+   if (FAILED(IAudioClient_GetMixFormat(w->client, &mix_format)))
+      return 0;
+   rate = mix_format->nSamplesPerSec;
+   CoTaskMemFree(mix_format);
+
+   if (FAILED(IAudioClient_GetDevicePeriod(w->client,
+               &period_default, &period_min)))
+      return 0;
+
+   wasapi_set_format(&wf, true, rate);
+   if (FAILED(IAudioClient_Initialize(w->client, AUDCLNT_SHAREMODE_SHARED,
+               AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_NOPERSIST,
+               period_default, 0, &wf.Format, NULL)))
+      return 0;
+
+   w->has_float = true;
+   return rate;
+}
+
+static void wasapi_worker_thread(void *data)
+{
+   DWORD task_index = 0;
+   HANDLE task;
+   wasapi_t *w = (wasapi_t*)data;
+
+   CoInitializeEx(NULL, COINIT_MULTITHREADED);
+   task = AvSetMmThreadCharacteristicsW(L"Pro Audio", &task_index);
+
+   while (!w->thread_dead)
+   {
+      BYTE *dst;
+      size_t avail, bytes, fifo_size;
+      UINT32 frames = w->buffer_frames;
+
+      if (WaitForSingleObject(w->event, 200) != WAIT_OBJECT_0)
+         continue;
+
+      /* Exclusive mode hands over the whole buffer every period,
+       * shared mode whatever the mixer has not consumed yet. */
+      if (!w->exclusive)
+      {
+         UINT32 padding = 0;
+
+         if (FAILED(IAudioClient_GetCurrentPadding(w->client, &padding)))
+            break;
+         frames -= padding;
+      }
+
+      if (!frames)
+         continue;
+      if (FAILED(IAudioRenderClient_GetBuffer(w->renderer, frames, &dst)))
+         break;
+
+      bytes     = frames * w->frame_size;
+      avail     = fifo_spsc_read_avail(w->buffer);
+      fifo_size = min(bytes, avail);
+      fifo_spsc_read(w->buffer, dst, fifo_size);
+
+      /* Never take a lock on the audio thread. A writer that
+       * misses this wakeup gets the next one, a period later. */
+      scond_signal(w->cond);
+
+      /* If underrun, fill rest with silence. */
+      memset(dst + fifo_size, 0, bytes - fifo_size);
+
+      IAudioRenderClient_ReleaseBuffer(w->renderer, frames, 0);
+   }
+
+   if (task)
+      AvRevertMmThreadCharacteristics(task);
+   CoUninitialize();
+
+   slock_lock(w->cond_lock);
+   w->thread_dead = true;
+   scond_signal(w->cond);
+   slock_unlock(w->cond_lock);
+}
+
+static void wasapi_free(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+
+   if (!w)
+      return;
+
+   if (w->worker_thread)
+   {
+      w->thread_dead = true;
+      sthread_join(w->worker_thread);
+   }
+   if (w->client)
+      IAudioClient_Stop(w->client);
+   if (w->renderer)
+      IAudioRenderClient_Release(w->renderer);
+   if (w->client)
+      IAudioClient_Release(w->client);
+   if (w->device)
+      IMMDevice_Release(w->device);
+   if (w->event)
+      CloseHandle(w->event);
+   if (w->buffer)
+      fifo_spsc_free(w->buffer);
+   if (w->cond)
+      scond_free(w->cond);
+   if (w->cond_lock)
+      slock_free(w->cond_lock);
+   if (w->com_initialized)
+      CoUninitialize();
+   free(w);
+}
+
+static void *wasapi_init(const char *device, unsigned rate, unsigned latency)
+{
+   BYTE *dst;
+   unsigned out_rate = 0;
+   settings_t *settings = config_get_ptr();
+   wasapi_t *w = (wasapi_t*)calloc(1, sizeof(wasapi_t));
+   HRESULT hr;
+
+   if (!w)
+      return NULL;
+
+   /* RPC_E_CHANGED_MODE means COM is already up on this thread. */
+   hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+   w->com_initialized = SUCCEEDED(hr);
+   if (FAILED(hr) && hr != RPC_E_CHANGED_MODE)
+      goto error;
+
+   if (!(w->device = wasapi_init_device(device)))
+      goto error;
+   if (!(w->client = wasapi_activate(w->device)))
+      goto error;
+
+   if (settings->audio.exclusive_mode)
+   {
+      out_rate = wasapi_init_exclusive(w, rate);
+      if (out_rate)
+         w->exclusive = true;
+      else
+      {
+         RARCH_WARN("[WASAPI]: Exclusive mode unavailable, using shared mode.\n");
+         if (w->client)
+            IAudioClient_Release(w->client);
+         if (!(w->client = wasapi_activate(w->device)))
+            goto error;
+      }
+   }
+
+   if (!out_rate)
+      out_rate = wasapi_init_shared(w);
+   if (!out_rate)
+      goto error;
+
+   if (!(w->event = CreateEvent(NULL, FALSE, FALSE, NULL)))
+      goto error;
+   if (FAILED(IAudioClient_SetEventHandle(w->client, w->event)))
+      goto error;
+   if (FAILED(IAudioClient_GetBufferSize(w->client, &w->buffer_frames)))
+      goto error;
+   if (FAILED(IAudioClient_GetService(w->client,
+               &wasapi_iid_render_client, (void**)&w->renderer)))
+      goto error;
+
+   w->frame_size  = 2 * (w->has_float ? sizeof(float) : sizeof(int16_t));
+   w->buffer_size = max(latency * out_rate / 1000,
+         2 * w->buffer_frames) * w->frame_size;
+
+   RARCH_LOG("[WASAPI]: %s mode, %s, %u Hz, %u frames device buffer.\n",
+         w->exclusive ? "Exclusive" : "Shared",
+         w->has_float ? "float" : "s16", out_rate,
+         (unsigned)w->buffer_frames);
+
+   if (out_rate != rate)
+      settings->audio.out_rate = out_rate;
+
+   w->cond_lock = slock_new();
+   w->cond      = scond_new();
+   w->buffer    = fifo_spsc_new(w->buffer_size);
+   if (!w->cond_lock || !w->cond || !w->buffer)
+      goto error;
+
+   /* Start on silence so the first period
+    * does not play whatever the buffer held. */
+   if (SUCCEEDED(IAudioRenderClient_GetBuffer(w->renderer,
+               w->buffer_frames, &dst)))
+      IAudioRenderClient_ReleaseBuffer(w->renderer, w->buffer_frames,
+            AUDCLNT_BUFFERFLAGS_SILENT);
+
+   w->worker_thread = sthread_create(wasapi_worker_thread, w);
+   if (!w->worker_thread)
+   {
+      RARCH_ERR("[WASAPI]: Failed to create worker thread.\n");
+      goto error;
+   }
+
+   if (FAILED(IAudioClient_Start(w->client)))
+      goto error;
+
+   return w;
+
+error:
+   RARCH_ERR("[WASAPI]: Failed to initialize...\n");
+   wasapi_free(w);
+   return NULL;
+}
+
+static ssize_t wasapi_write(void *data, const void *buf, size_t size)
+{
+   wasapi_t *w = (wasapi_t*)data;
+
+   if (w->thread_dead)
+      return -1;
+
+   if (w->nonblock)
+   {
+      size_t avail = fifo_spsc_write_avail(w->buffer);
+      size_t write_amt = min(avail, size);
+      fifo_spsc_write(w->buffer, buf, write_amt);
+      return write_amt;
+   }
+   else
+   {
+      size_t written = 0;
+      while (written < size && !w->thread_dead)
+      {
+         size_t avail = fifo_spsc_write_avail(w->buffer);
+
+         if (avail == 0)
+         {
+            slock_lock(w->cond_lock);
+            if (!w->thread_dead && !fifo_spsc_write_avail(w->buffer))
+               scond_wait(w->cond, w->cond_lock);
+            slock_unlock(w->cond_lock);
+         }
+         else
+         {
+            size_t write_amt = min(size - written, avail);
+            fifo_spsc_write(w->buffer, (const char*)buf + written, write_amt);
+            written += write_amt;
+         }
+      }
+      return written;
+   }
+}
+
+static bool wasapi_stop(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+
+   if (!w->is_paused && FAILED(IAudioClient_Stop(w->client)))
+      return false;
+   w->is_paused = true;
+   return true;
+}
+
+static bool wasapi_start(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+
+   if (w->is_paused && FAILED(IAudioClient_Start(w->client)))
+      return false;
+   w->is_paused = false;
+   return true;
+}
+
+static bool wasapi_alive(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+   if (!w)
+      return false;
+   return !w->is_paused;
+}
+
+static void wasapi_set_nonblock_state(void *data, bool state)
+{
+   wasapi_t *w = (wasapi_t*)data;
+   w->nonblock = state;
+}
+
+static bool wasapi_use_float(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+   return w->has_float;
+}
+
+static size_t wasapi_write_avail(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+
+   if (w->thread_dead)
+      return 0;
+   return fifo_spsc_write_avail(w->buffer);
+}
+
+static size_t wasapi_buffer_size(void *data)
+{
+   wasapi_t *w = (wasapi_t*)data;
+   return w->buffer_size;
+}
+
+audio_driver_t audio_wasapi = {
+   wasapi_init,
+   wasapi_write,
+   wasapi_stop,
+   wasapi_start,
+   wasapi_alive,
+   wasapi_set_nonblock_state,
+   wasapi_free,
+   wasapi_use_float,
+   "wasapi",
+   wasapi_write_avail,
+   wasapi_buffer_size,
+};
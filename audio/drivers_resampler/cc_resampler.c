@@ -22,6 +22,9 @@
 #ifdef __SSE__
 #include <xmmintrin.h>
 #endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include <retro_inline.h>
 
 /* Since SSE and NEON don't provide support for trigonometric functions
@@ -46,6 +49,23 @@
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+#if defined(__SSE__) && defined(__GNUC__) && \
+   (defined(__x86_64__) || defined(__i386__)) && \
+   (defined(__clang__) || __GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+/* Built for AVX regardless of the compiler flags,
+ * only picked when the CPU reports support for it. */
+#define CC_TARGET_AVX __attribute__((target("avx")))
+#define HAVE_CC_AVX
+#elif defined(__AVX__)
+#define CC_TARGET_AVX
+#define HAVE_CC_AVX
+#endif
+
+#ifdef HAVE_CC_AVX
+#include <immintrin.h>
+#endif
+
 typedef struct rarch_CC_resampler
 {
    audio_frame_float_t buffer[4];
@@ -183,9 +203,11 @@ static void resampler_CC_free(void *re_)
 }
 
 static void *resampler_CC_init(const struct resampler_config *config,
-      double bandwidth_mod, resampler_simd_mask_t mask)
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask)
 {
    (void)mask;
+   (void)quality;
    (void)bandwidth_mod;
    (void)config;
 
@@ -401,6 +423,141 @@ static void resampler_CC_upsample(void *re_, struct resampler_data *data)
          data->data_out, data->data_in, re_, data->input_frames, data->ratio);
 }
 
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+/* The NEON assembly is ARMv7 only, AArch64 runs
+ * the SSE code written with NEON intrinsics. */
+
+#define CC_RESAMPLER_IDENT "NEON"
+
+static INLINE float32x4_t resampler_CC_weights_neon(
+      float32x4_t vec_w, float b)
+{
+   float32x4_t vec_w1 = vmulq_n_f32(vaddq_f32(vec_w, vdupq_n_f32(0.5f)), b);
+   float32x4_t vec_w2 = vmulq_n_f32(vsubq_f32(vec_w, vdupq_n_f32(0.5f)), b);
+
+#if (CC_RESAMPLER_PRECISION > 0)
+   float32x4_t vec_ww1 = vmulq_f32(vec_w1, vec_w1);
+   float32x4_t vec_ww2 = vmulq_f32(vec_w2, vec_w2);
+
+   vec_ww1 = vmulq_f32(vec_ww1, vsubq_f32(vdupq_n_f32(3.0f), vec_ww1));
+   vec_ww2 = vmulq_f32(vec_ww2, vsubq_f32(vdupq_n_f32(3.0f), vec_ww2));
+
+   vec_ww1 = vmulq_n_f32(vec_ww1, 1.0f / 4.0f);
+   vec_ww2 = vmulq_n_f32(vec_ww2, 1.0f / 4.0f);
+
+   vec_w1  = vmulq_f32(vec_w1, vsubq_f32(vdupq_n_f32(1.0f), vec_ww1));
+   vec_w2  = vmulq_f32(vec_w2, vsubq_f32(vdupq_n_f32(1.0f), vec_ww2));
+#endif
+
+   vec_w1  = vminq_f32(vec_w1, vdupq_n_f32( 0.5f));
+   vec_w2  = vminq_f32(vec_w2, vdupq_n_f32( 0.5f));
+   vec_w1  = vmaxq_f32(vec_w1, vdupq_n_f32(-0.5f));
+   vec_w2  = vmaxq_f32(vec_w2, vdupq_n_f32(-0.5f));
+
+   return vsubq_f32(vec_w1, vec_w2);
+}
+
+static void resampler_CC_downsample(void *re_, struct resampler_data *data)
+{
+   float32x4_t vec_previous, vec_current, vec_offsets;
+   float ratio, b;
+   static const float offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+   rarch_CC_resampler_t *re     = (rarch_CC_resampler_t*)re_;
+
+   audio_frame_float_t *inp     = (audio_frame_float_t*)data->data_in;
+   audio_frame_float_t *inp_max = (audio_frame_float_t*)(inp + data->input_frames);
+   audio_frame_float_t *outp    = (audio_frame_float_t*)data->data_out;
+
+   ratio = 1.0 / data->ratio;
+   b = data->ratio; /* cutoff frequency. */
+
+   vec_offsets  = vld1q_f32(offsets);
+   vec_previous = vld1q_f32((const float*)&re->buffer[0]);
+   vec_current  = vld1q_f32((const float*)&re->buffer[2]);
+
+   while (inp != inp_max)
+   {
+      float32x4_t vec_w = resampler_CC_weights_neon(
+            vmlsq_n_f32(vdupq_n_f32(re->distance), vec_offsets, ratio), b);
+      float32x2_t vec_frame = vld1_f32((const float*)inp);
+      float32x4_t vec_in    = vcombine_f32(vec_frame, vec_frame);
+
+      vec_previous = vmlaq_f32(vec_previous, vec_in, vzip1q_f32(vec_w, vec_w));
+      vec_current  = vmlaq_f32(vec_current,  vec_in, vzip2q_f32(vec_w, vec_w));
+
+      re->distance++;
+      inp++;
+
+      if (re->distance > (ratio + 0.5))
+      {
+         vst1_f32((float*)outp, vget_low_f32(vec_previous));
+         vec_previous = vextq_f32(vec_previous, vec_current, 2);
+         vec_current  = vextq_f32(vec_current, vdupq_n_f32(0.0f), 2);
+
+         re->distance -= ratio;
+         outp++;
+      }
+   }
+
+   vst1q_f32((float*)&re->buffer[0], vec_previous);
+   vst1q_f32((float*)&re->buffer[2], vec_current);
+
+   data->output_frames = outp - (audio_frame_float_t*)data->data_out;
+}
+
+static void resampler_CC_upsample(void *re_, struct resampler_data *data)
+{
+   float32x4_t vec_previous, vec_current, vec_offsets;
+   float b, ratio;
+   static const float offsets[4] = { 1.0f, 0.0f, -1.0f, -2.0f };
+   rarch_CC_resampler_t *re = (rarch_CC_resampler_t*)re_;
+
+   audio_frame_float_t *inp     = (audio_frame_float_t*)data->data_in;
+   audio_frame_float_t *inp_max = (audio_frame_float_t*)(inp + data->input_frames);
+   audio_frame_float_t *outp    = (audio_frame_float_t*)data->data_out;
+
+   b = min(data->ratio, 1.00); /* cutoff frequency. */
+   ratio = 1.0 / data->ratio;
+
+   vec_offsets  = vld1q_f32(offsets);
+   vec_previous = vld1q_f32((const float*)&re->buffer[0]);
+   vec_current  = vld1q_f32((const float*)&re->buffer[2]);
+
+   while (inp != inp_max)
+   {
+      float32x2_t vec_frame = vld1_f32((const float*)inp);
+
+      vec_previous = vextq_f32(vec_previous, vec_current, 2);
+      vec_current  = vextq_f32(vec_current,
+            vcombine_f32(vec_frame, vec_frame), 2);
+
+      while (re->distance < 1.0)
+      {
+         float32x4_t vec_w = resampler_CC_weights_neon(
+               vaddq_f32(vdupq_n_f32(re->distance), vec_offsets), b);
+         float32x4_t vec_out = vmulq_f32(vec_previous,
+               vzip1q_f32(vec_w, vec_w));
+
+         vec_out = vmlaq_f32(vec_out, vec_current, vzip2q_f32(vec_w, vec_w));
+
+         vst1_f32((float*)outp,
+               vadd_f32(vget_low_f32(vec_out), vget_high_f32(vec_out)));
+
+         re->distance += ratio;
+         outp++;
+      }
+
+      re->distance -= 1.0;
+      inp++;
+   }
+
+   vst1q_f32((float*)&re->buffer[0], vec_previous);
+   vst1q_f32((float*)&re->buffer[2], vec_current);
+
+   data->output_frames = outp - (audio_frame_float_t*)data->data_out;
+}
+
 #else
 
 /* C reference version. Not optimized. */
@@ -527,6 +684,155 @@ static void resampler_CC_upsample(void *re_, struct resampler_data *data)
 }
 #endif
 
+#ifdef HAVE_CC_AVX
+/* Same layout of the buffer as the SSE code, all four frames
+ * in one register with the oldest at the bottom. */
+
+/**
+ * resampler_CC_weights_avx:
+ * @vec_w                : Distance of each of the four frames.
+ * @b                    : Cutoff frequency.
+ *
+ * Works out both ends of the kernel integral in one
+ * register, rather than one after the other as SSE does.
+ *
+ * Returns: kernel weight of each frame, twice over
+ * for the left and right channels.
+ **/
+CC_TARGET_AVX
+static INLINE __m256 resampler_CC_weights_avx(__m128 vec_w, float b)
+{
+   __m256 vec_x = _mm256_insertf128_ps(_mm256_castps128_ps256(
+            _mm_add_ps(vec_w, _mm_set1_ps(0.5))),
+         _mm_sub_ps(vec_w, _mm_set1_ps(0.5)), 1);
+
+   vec_x = _mm256_mul_ps(vec_x, _mm256_set1_ps(b));
+
+#if (CC_RESAMPLER_PRECISION > 0)
+   {
+      __m256 vec_xx = _mm256_mul_ps(vec_x, vec_x);
+
+      vec_xx = _mm256_mul_ps(vec_xx,
+            _mm256_sub_ps(_mm256_set1_ps(3.0), vec_xx));
+      vec_xx = _mm256_mul_ps(_mm256_set1_ps(1.0 / 4.0), vec_xx);
+      vec_x  = _mm256_mul_ps(vec_x,
+            _mm256_sub_ps(_mm256_set1_ps(1.0), vec_xx));
+   }
+#endif
+
+   vec_x = _mm256_min_ps(vec_x, _mm256_set1_ps( 0.5));
+   vec_x = _mm256_max_ps(vec_x, _mm256_set1_ps(-0.5));
+
+   vec_w = _mm_sub_ps(_mm256_castps256_ps128(vec_x),
+         _mm256_extractf128_ps(vec_x, 1));
+
+   return _mm256_insertf128_ps(_mm256_castps128_ps256(
+            _mm_unpacklo_ps(vec_w, vec_w)),
+         _mm_unpackhi_ps(vec_w, vec_w), 1);
+}
+
+CC_TARGET_AVX
+static void resampler_CC_downsample_avx(void *re_,
+      struct resampler_data *data)
+{
+   __m256 vec_buffer;
+   float ratio, b;
+   rarch_CC_resampler_t *re     = (rarch_CC_resampler_t*)re_;
+
+   audio_frame_float_t *inp     = (audio_frame_float_t*)data->data_in;
+   audio_frame_float_t *inp_max = (audio_frame_float_t*)(inp + data->input_frames);
+   audio_frame_float_t *outp    = (audio_frame_float_t*)data->data_out;
+
+   ratio = 1.0 / data->ratio;
+   b = data->ratio; /* cutoff frequency. */
+
+   vec_buffer = _mm256_loadu_ps((float*)re->buffer);
+
+   while (inp != inp_max)
+   {
+      __m128 vec_w = _mm_sub_ps(_mm_set1_ps(re->distance),
+            _mm_mul_ps(_mm_set1_ps(ratio), _mm_set_ps(3.0, 2.0, 1.0, 0.0)));
+      __m256 vec_in = _mm256_castpd_ps(
+            _mm256_broadcast_sd((const double*)inp));
+
+      vec_buffer = _mm256_add_ps(vec_buffer,
+            _mm256_mul_ps(vec_in, resampler_CC_weights_avx(vec_w, b)));
+
+      re->distance++;
+      inp++;
+
+      if (re->distance > (ratio + 0.5))
+      {
+         _mm_storel_pi((__m64*)outp, _mm256_castps256_ps128(vec_buffer));
+
+         /* Frames move down by one, a silent one comes in on top. */
+         vec_buffer = _mm256_shuffle_ps(vec_buffer,
+               _mm256_permute2f128_ps(vec_buffer, vec_buffer, 0x81),
+               _MM_SHUFFLE(1, 0, 3, 2));
+
+         re->distance -= ratio;
+         outp++;
+      }
+   }
+
+   _mm256_storeu_ps((float*)re->buffer, vec_buffer);
+
+   data->output_frames = outp - (audio_frame_float_t*)data->data_out;
+}
+
+CC_TARGET_AVX
+static void resampler_CC_upsample_avx(void *re_,
+      struct resampler_data *data)
+{
+   __m256 vec_buffer;
+   float b, ratio;
+   rarch_CC_resampler_t *re = (rarch_CC_resampler_t*)re_;
+
+   audio_frame_float_t *inp     = (audio_frame_float_t*)data->data_in;
+   audio_frame_float_t *inp_max = (audio_frame_float_t*)(inp + data->input_frames);
+   audio_frame_float_t *outp    = (audio_frame_float_t*)data->data_out;
+
+   b = min(data->ratio, 1.00); /* cutoff frequency. */
+   ratio = 1.0 / data->ratio;
+
+   vec_buffer = _mm256_loadu_ps((float*)re->buffer);
+
+   while (inp != inp_max)
+   {
+      __m256 vec_in = _mm256_castpd_ps(
+            _mm256_broadcast_sd((const double*)inp));
+
+      /* Frames move down by one, the input frame comes in on top. */
+      vec_buffer = _mm256_shuffle_ps(vec_buffer,
+            _mm256_permute2f128_ps(vec_buffer, vec_in, 0x21),
+            _MM_SHUFFLE(1, 0, 3, 2));
+
+      while (re->distance < 1.0)
+      {
+         __m128 vec_w = _mm_add_ps(_mm_set1_ps(re->distance),
+               _mm_set_ps(-2.0, -1.0, 0.0, 1.0));
+         __m256 vec_out = _mm256_mul_ps(vec_buffer,
+               resampler_CC_weights_avx(vec_w, b));
+         __m128 vec_sum = _mm_add_ps(_mm256_castps256_ps128(vec_out),
+               _mm256_extractf128_ps(vec_out, 1));
+
+         vec_sum = _mm_add_ps(vec_sum, _mm_movehl_ps(vec_sum, vec_sum));
+         _mm_storel_pi((__m64*)outp, vec_sum);
+
+         re->distance += ratio;
+         outp++;
+      }
+
+      re->distance -= 1.0;
+      inp++;
+   }
+
+   _mm256_storeu_ps((float*)re->buffer, vec_buffer);
+
+   data->output_frames = outp - (audio_frame_float_t*)data->data_out;
+}
+#endif
+
 static void resampler_CC_process(void *re_, struct resampler_data *data)
 {
    rarch_CC_resampler_t *re = (rarch_CC_resampler_t*)re_;
@@ -542,7 +848,8 @@ static void resampler_CC_free(void *re_)
 }
 
 static void *resampler_CC_init(const struct resampler_config *config,
-      double bandwidth_mod, resampler_simd_mask_t mask)
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask)
 {
    int i;
    rarch_CC_resampler_t *re = (rarch_CC_resampler_t*)
@@ -553,6 +860,7 @@ static void *resampler_CC_init(const struct resampler_config *config,
     * C codepath or NEON codepath. This will help out
     * Android. */
    (void)mask;
+   (void)quality;
    (void)config;
 
    if (!re)
@@ -570,11 +878,19 @@ static void *resampler_CC_init(const struct resampler_config *config,
    {
       re->process = resampler_CC_downsample;
       re->distance = 0.0;
+#ifdef HAVE_CC_AVX
+      if (mask & RESAMPLER_SIMD_AVX)
+         re->process = resampler_CC_downsample_avx;
+#endif
    }
    else
    {
       re->process = resampler_CC_upsample;
       re->distance = 2.0;
+#ifdef HAVE_CC_AVX
+      if (mask & RESAMPLER_SIMD_AVX)
+         re->process = resampler_CC_upsample_avx;
+#endif
    }
 
    return re;
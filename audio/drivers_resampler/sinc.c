@@ -26,78 +26,92 @@
 #endif
 #include <retro_inline.h>
 
-/* Rough SNR values for upsampling:
- * LOWEST: 40 dB
- * LOWER: 55 dB
- * NORMAL: 70 dB
- * HIGHER: 110 dB
- * HIGHEST: 140 dB
+enum sinc_window
+{
+   SINC_WINDOW_LANCZOS = 0,
+   SINC_WINDOW_KAISER
+};
+
+struct sinc_quality
+{
+   enum sinc_window window;
+   double kaiser_beta;
+   double cutoff;
+   unsigned phase_bits;
+   unsigned subphase_bits;
+   /* Interpolate coefficients between phases. */
+   bool coeff_lerp;
+   unsigned sidelobes;
+};
+
+/* Indexed by enum resampler_quality - 1.
+ * Worst SNR for 44.1 kHz to 48 kHz over frequencies up to 0.20 
+ * and 0.40 of the input rate, and CPU cost relative to NORMAL, 
+ * as printed by audio/test/test-quality.sh on an AVX2 machine:
+ *
+ * LOWEST:   39 dB,   9 dB, 0.7x
+ * LOWER:    47 dB,  21 dB, 0.8x
+ * NORMAL:   66 dB,  65 dB, 1.0x
+ * HIGHER:  122 dB, 114 dB, 1.6x
+ * HIGHEST: 139 dB, 132 dB, 4.4x
  */
+static const struct sinc_quality sinc_qualities[] = {
+   { SINC_WINDOW_LANCZOS, 0.0,  0.98,  12, 10, false, 2   },
+   { SINC_WINDOW_LANCZOS, 0.0,  0.98,  12, 10, false, 4   },
+   { SINC_WINDOW_KAISER,  5.5,  0.825, 8,  16, true,  8   },
+   { SINC_WINDOW_KAISER,  10.5, 0.90,  10, 14, true,  32  },
+   { SINC_WINDOW_KAISER,  14.5, 0.962, 10, 14, true,  128 },
+};
 
-/* TODO, make all this more configurable. */
+/* Quality used when the caller does not care. */
 #if defined(SINC_LOWEST_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SINC_COEFF_LERP 0
-#define SUBPHASE_BITS 10
-#define SIDELOBES 2
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWEST
 #elif defined(SINC_LOWER_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SUBPHASE_BITS 10
-#define SINC_COEFF_LERP 0
-#define SIDELOBES 4
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWER
 #elif defined(SINC_HIGHER_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 10.5
-#define CUTOFF 0.90
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 32
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHER
 #elif defined(SINC_HIGHEST_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 14.5
-#define CUTOFF 0.962
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 128
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHEST
 #else
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 5.5
-#define CUTOFF 0.825
-#define PHASE_BITS 8
-#define SUBPHASE_BITS 16
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 8
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_NORMAL
 #endif
 
 /* For the little amount of taps we're using,
  * SSE1 is faster than AVX for some reason.
- * AVX code is kept here though as by increasing number
- * of sinc taps, the AVX code is clearly faster than SSE1.
+ * The AVX kernels are only picked once the quality level or 
+ * downsampling raises the number of taps enough for them 
+ * to be clearly faster than SSE1.
  */
+#define SINC_AVX_MIN_TAPS 64
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+   (defined(__clang__) || __GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+/* Built for AVX and FMA regardless of the compiler flags, 
+ * only picked when the CPU reports support for them. */
+#define SINC_TARGET_AVX __attribute__((target("avx")))
+#define SINC_TARGET_FMA __attribute__((target("avx,fma")))
+#define HAVE_SINC_AVX
+#define HAVE_SINC_FMA
+#else
+#if defined(__AVX__)
+#define SINC_TARGET_AVX
+#define HAVE_SINC_AVX
+#endif
+#if defined(__FMA__) || defined(__AVX2__)
+#define SINC_TARGET_FMA
+#define HAVE_SINC_FMA
+#endif
+#endif
 
-#if defined(__AVX__) && ENABLE_AVX
+#if defined(HAVE_SINC_AVX) || defined(HAVE_SINC_FMA)
 #include <immintrin.h>
 #endif
 
-#define PHASES (1 << (PHASE_BITS + SUBPHASE_BITS))
-
-#define TAPS (SIDELOBES * 2)
-#define SUBPHASE_MASK ((1 << SUBPHASE_BITS) - 1)
-#define SUBPHASE_MOD (1.0f / (1 << SUBPHASE_BITS))
-
 typedef struct rarch_sinc_resampler
 {
+   void (*process)(struct rarch_sinc_resampler *resamp, float *out_buffer);
+
    float *phase_table;
    float *buffer_l;
    float *buffer_r;
@@ -107,6 +121,12 @@ typedef struct rarch_sinc_resampler
    unsigned ptr;
    uint32_t time;
 
+   const struct sinc_quality *quality;
+   uint32_t phases;
+   unsigned subphase_bits;
+   uint32_t subphase_mask;
+   float subphase_mod;
+
    /* A buffer for phase_table, buffer_l and buffer_r 
     * are created in a single calloc().
     * Ensure that we get as good cache locality as we can hope for. */
@@ -120,12 +140,6 @@ static INLINE double sinc(double val)
    return sin(val) / val;
 }
 
-#if defined(SINC_WINDOW_LANCZOS)
-static INLINE double window_function(double idx)
-{
-   return sinc(M_PI * idx);
-}
-#elif defined(SINC_WINDOW_KAISER)
 /* Modified Bessel function of first order.
  * Check Wiki for mathematical definition ... */
 static INLINE double besseli0(double x)
@@ -154,19 +168,28 @@ static INLINE double besseli0(double x)
    return sum;
 }
 
-static INLINE double window_function(double idx)
+static INLINE double window_function(const struct sinc_quality *quality,
+      double idx)
 {
-   return besseli0(SINC_WINDOW_KAISER_BETA * sqrt(1 - idx * idx));
+   switch (quality->window)
+   {
+      case SINC_WINDOW_KAISER:
+         return besseli0(quality->kaiser_beta * sqrt(1 - idx * idx));
+      case SINC_WINDOW_LANCZOS:
+      default:
+         break;
+   }
+
+   return sinc(M_PI * idx);
 }
-#else
-#error "No SINC window function defined."
-#endif
 
 static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
 {
    int i, j, p;
-   double window_mod = window_function(0.0); /* Need to normalize w(0) to 1.0. */
+   const struct sinc_quality *quality = resamp->quality;
+   /* Need to normalize w(0) to 1.0. */
+   double window_mod = window_function(quality, 0.0);
    int stride = calculate_delta ? 2 : 1;
    double sidelobes = taps / 2.0;
 
@@ -182,7 +205,7 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(quality, window_phase) / window_mod;
          phase_table[i * stride * taps + j] = val;
       }
    }
@@ -211,7 +234,7 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(quality, window_phase) / window_mod;
          delta = (val - phase_table[phase * stride * taps + j]);
          phase_table[(phase * stride + 1) * taps + j] = delta;
       }
@@ -239,11 +262,16 @@ static void *aligned_alloc__(size_t boundary, size_t size)
 static void aligned_free__(void *ptr)
 {
    void **p = (void**)ptr;
+   if (!p)
+      return;
    free(p[-1]);
 }
 
-#if !(defined(__AVX__) && ENABLE_AVX) && !defined(__SSE__)
-static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
+/* The kernels below test coeff_lerp once per output frame,
+ * outside the loop over the taps. */
+
+#if !defined(__SSE__)
+static void process_sinc_C(rarch_sinc_resampler_t *resamp,
       float *out_buffer)
 {
    unsigned i;
@@ -253,24 +281,32 @@ static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
    unsigned taps  = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   float delta = (float)(resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD;
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+   unsigned phase = resamp->time >> resamp->subphase_bits;
 
-   for (i = 0; i < taps; i++)
+   if (resamp->quality->coeff_lerp)
    {
-#if SINC_COEFF_LERP
-      float sinc_val = phase_table[i] + delta_table[i] * delta;
-#else
-      float sinc_val = phase_table[i];
-#endif
-      sum_l         += buffer_l[i] * sinc_val;
-      sum_r         += buffer_r[i] * sinc_val;
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      float delta = (float)(resamp->time & resamp->subphase_mask) *
+         resamp->subphase_mod;
+
+      for (i = 0; i < taps; i++)
+      {
+         float sinc_val = phase_table[i] + delta_table[i] * delta;
+         sum_l         += buffer_l[i] * sinc_val;
+         sum_r         += buffer_r[i] * sinc_val;
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i++)
+      {
+         float sinc_val = phase_table[i];
+         sum_l         += buffer_l[i] * sinc_val;
+         sum_r         += buffer_r[i] * sinc_val;
+      }
    }
 
    out_buffer[0] = sum_l;
@@ -278,94 +314,52 @@ static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
 }
 #endif
 
-#if defined(__AVX__) && ENABLE_AVX
-#define process_sinc_func process_sinc
+#if defined(__SSE__)
+#define process_sinc_default process_sinc
 static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
 {
    unsigned i;
-   __m256 sum_l = _mm256_setzero_ps();
-   __m256 sum_r = _mm256_setzero_ps();
+   __m128 sum_l = _mm_setzero_ps();
+   __m128 sum_r = _mm_setzero_ps();
 
    const float *buffer_l = resamp->buffer_l + resamp->ptr;
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
    unsigned taps = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   __m256 delta = _mm256_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+   unsigned phase = resamp->time >> resamp->subphase_bits;
 
-   for (i = 0; i < taps; i += 8)
+   if (resamp->quality->coeff_lerp)
    {
-      __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
-      __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m128 delta = _mm_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
 
-#if SINC_COEFF_LERP
-      __m256 deltas = _mm256_load_ps(delta_table + i);
-      __m256 sinc = _mm256_add_ps(_mm256_load_ps(phase_table + i),
-            _mm256_mul_ps(deltas, delta));
-#else
-      __m256 sinc = _mm256_load_ps(phase_table + i);
-#endif
-      sum_l       = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
-      sum_r       = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 buf_l = _mm_loadu_ps(buffer_l + i);
+         __m128 buf_r = _mm_loadu_ps(buffer_r + i);
+
+         __m128 deltas = _mm_load_ps(delta_table + i);
+         __m128 _sinc = _mm_add_ps(_mm_load_ps(phase_table + i),
+               _mm_mul_ps(deltas, delta));
+         sum_l       = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
+         sum_r       = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      }
    }
-
-   /* hadd on AVX is weird, and acts on low-lanes 
-    * and high-lanes separately. */
-   __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
-   __m256 res_r = _mm256_hadd_ps(sum_r, sum_r);
-   res_l = _mm256_hadd_ps(res_l, res_l);
-   res_r = _mm256_hadd_ps(res_r, res_r);
-   res_l = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l);
-   res_r = _mm256_add_ps(_mm256_permute2f128_ps(res_r, res_r, 1), res_r);
-
-   /* This is optimized to mov %xmmN, [mem].
-    * There doesn't seem to be any _mm256_store_ss intrinsic. */
-   _mm_store_ss(out_buffer + 0, _mm256_extractf128_ps(res_l, 0));
-   _mm_store_ss(out_buffer + 1, _mm256_extractf128_ps(res_r, 0));
-}
-#elif defined(__SSE__)
-#define process_sinc_func process_sinc
-static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
-{
-   unsigned i;
-   __m128 sum_l = _mm_setzero_ps();
-   __m128 sum_r = _mm_setzero_ps();
-
-   const float *buffer_l = resamp->buffer_l + resamp->ptr;
-   const float *buffer_r = resamp->buffer_r + resamp->ptr;
-
-   unsigned taps = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   __m128 delta = _mm_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
-
-   for (i = 0; i < taps; i += 4)
+   else
    {
-      __m128 buf_l = _mm_loadu_ps(buffer_l + i);
-      __m128 buf_r = _mm_loadu_ps(buffer_r + i);
+      const float *phase_table = resamp->phase_table + phase * taps;
 
-#if SINC_COEFF_LERP
-      __m128 deltas = _mm_load_ps(delta_table + i);
-      __m128 _sinc = _mm_add_ps(_mm_load_ps(phase_table + i),
-            _mm_mul_ps(deltas, delta));
-#else
-      __m128 _sinc = _mm_load_ps(phase_table + i);
-#endif
-      sum_l       = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
-      sum_r       = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 buf_l = _mm_loadu_ps(buffer_l + i);
+         __m128 buf_r = _mm_loadu_ps(buffer_r + i);
+
+         __m128 _sinc = _mm_load_ps(phase_table + i);
+         sum_l       = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
+         sum_r       = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      }
    }
 
    /* Them annoying shuffles.
@@ -394,17 +388,10 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    _mm_store_ss(out_buffer + 1, _mm_movehl_ps(sum, sum));
 }
 #elif defined(__ARM_NEON__)
-
-#if SINC_COEFF_LERP
-#error "NEON asm does not support SINC lerp."
-#endif
-
-/* Need to make this function pointer as Android doesn't 
+/* Picked at runtime as Android doesn't 
  * have built-in targets for NEON and plain ARMv7a.
+ * Only used without SINC lerp, which the asm does not support.
  */
-static void (*process_sinc_func)(rarch_sinc_resampler_t *resamp,
-      float *out_buffer);
-
 /* Assumes that taps >= 8, and that taps is a multiple of 8. */
 void process_sinc_neon_asm(float *out, const float *left, 
       const float *right, const float *coeff, unsigned taps);
@@ -415,21 +402,147 @@ static void process_sinc_neon(rarch_sinc_resampler_t *resamp,
    const float *buffer_l = resamp->buffer_l + resamp->ptr;
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
    unsigned taps = resamp->taps;
    const float *phase_table = resamp->phase_table + phase * taps;
 
    process_sinc_neon_asm(out_buffer, buffer_l, buffer_r, phase_table, taps);
 }
+
+#define process_sinc_default process_sinc_C
 #else /* Plain ol' C99 */
-#define process_sinc_func process_sinc_C
+#define process_sinc_default process_sinc_C
+#endif
+
+#if defined(HAVE_SINC_AVX) || defined(HAVE_SINC_FMA)
+/* hadd on AVX is weird, and acts on low-lanes 
+ * and high-lanes separately. */
+#define SINC_AVX_STORE(sum_l, sum_r, out_buffer) do { \
+   __m256 res_l = _mm256_hadd_ps(sum_l, sum_l); \
+   __m256 res_r = _mm256_hadd_ps(sum_r, sum_r); \
+   res_l = _mm256_hadd_ps(res_l, res_l); \
+   res_r = _mm256_hadd_ps(res_r, res_r); \
+   res_l = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l); \
+   res_r = _mm256_add_ps(_mm256_permute2f128_ps(res_r, res_r, 1), res_r); \
+   /* This is optimized to mov %xmmN, [mem]. \
+    * There doesn't seem to be any _mm256_store_ss intrinsic. */ \
+   _mm_store_ss((out_buffer) + 0, _mm256_castps256_ps128(res_l)); \
+   _mm_store_ss((out_buffer) + 1, _mm256_castps256_ps128(res_r)); \
+} while (0)
+#endif
+
+#if defined(HAVE_SINC_AVX)
+SINC_TARGET_AVX
+static void process_sinc_avx(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   __m256 sum_l = _mm256_setzero_ps();
+   __m256 sum_r = _mm256_setzero_ps();
+
+   const float *buffer_l = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
+
+   if (resamp->quality->coeff_lerp)
+   {
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m256 delta = _mm256_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+      for (i = 0; i < taps; i += 8)
+      {
+         __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
+         __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+
+         __m256 deltas = _mm256_load_ps(delta_table + i);
+         __m256 sinc = _mm256_add_ps(_mm256_load_ps(phase_table + i),
+               _mm256_mul_ps(deltas, delta));
+         sum_l       = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
+         sum_r       = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i += 8)
+      {
+         __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
+         __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+
+         __m256 sinc = _mm256_load_ps(phase_table + i);
+         sum_l       = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
+         sum_r       = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+      }
+   }
+
+   SINC_AVX_STORE(sum_l, sum_r, out_buffer);
+}
+#endif
+
+#if defined(HAVE_SINC_FMA)
+/* Same as process_sinc_avx(), with the multiply-adds fused. */
+SINC_TARGET_FMA
+static void process_sinc_fma(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   __m256 sum_l = _mm256_setzero_ps();
+   __m256 sum_r = _mm256_setzero_ps();
+
+   const float *buffer_l = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
+
+   if (resamp->quality->coeff_lerp)
+   {
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m256 delta = _mm256_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+      for (i = 0; i < taps; i += 8)
+      {
+         __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
+         __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+
+         __m256 sinc = _mm256_fmadd_ps(_mm256_load_ps(delta_table + i),
+               delta, _mm256_load_ps(phase_table + i));
+         sum_l       = _mm256_fmadd_ps(buf_l, sinc, sum_l);
+         sum_r       = _mm256_fmadd_ps(buf_r, sinc, sum_r);
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i += 8)
+      {
+         __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
+         __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+
+         __m256 sinc = _mm256_load_ps(phase_table + i);
+         sum_l       = _mm256_fmadd_ps(buf_l, sinc, sum_l);
+         sum_r       = _mm256_fmadd_ps(buf_r, sinc, sum_r);
+      }
+   }
+
+   SINC_AVX_STORE(sum_l, sum_r, out_buffer);
+}
 #endif
 
 static void resampler_sinc_process(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)re_;
 
-   uint32_t ratio = PHASES / data->ratio;
+   uint32_t phases = re->phases;
+   uint32_t ratio  = phases / data->ratio;
 
    const float *input = data->data_in;
    float *output      = data->data_out;
@@ -438,7 +551,7 @@ static void resampler_sinc_process(void *re_, struct resampler_data *data)
 
    while (frames)
    {
-      while (frames && re->time >= PHASES)
+      while (frames && re->time >= phases)
       {
          /* Push in reverse to make filter more obvious. */
          if (!re->ptr)
@@ -448,13 +561,13 @@ static void resampler_sinc_process(void *re_, struct resampler_data *data)
          re->buffer_l[re->ptr + re->taps] = re->buffer_l[re->ptr] = *input++;
          re->buffer_r[re->ptr + re->taps] = re->buffer_r[re->ptr] = *input++;
 
-         re->time -= PHASES;
+         re->time -= phases;
          frames--;
       }
 
-      while (re->time < PHASES)
+      while (re->time < phases)
       {
-         process_sinc_func(re, output);
+         re->process(re, output);
          output += 2;
          out_frames++;
          re->time += ratio;
@@ -473,10 +586,12 @@ static void resampler_sinc_free(void *re)
 }
 
 static void *resampler_sinc_new(const struct resampler_config *config,
-      double bandwidth_mod, resampler_simd_mask_t mask)
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask)
 {
    size_t phase_elems, elems;
    double cutoff;
+   unsigned phase_bits;
    rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
    (void)config;
@@ -486,8 +601,19 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 
    memset(re, 0, sizeof(*re));
 
-   re->taps = TAPS;
-   cutoff = CUTOFF;
+   if (quality == RESAMPLER_QUALITY_DONTCARE ||
+         quality > RESAMPLER_QUALITY_HIGHEST)
+      quality = SINC_DEFAULT_QUALITY;
+
+   re->quality       = &sinc_qualities[quality - 1];
+   phase_bits        = re->quality->phase_bits;
+   re->subphase_bits = re->quality->subphase_bits;
+   re->subphase_mask = (1 << re->subphase_bits) - 1;
+   re->subphase_mod  = 1.0f / (1 << re->subphase_bits);
+   re->phases        = 1 << (phase_bits + re->subphase_bits);
+
+   re->taps = re->quality->sidelobes * 2;
+   cutoff = re->quality->cutoff;
 
    /* Downsampling, must lower cutoff, and extend number of 
     * taps accordingly to keep same stopband attenuation. */
@@ -497,35 +623,52 @@ static void *resampler_sinc_new(const struct resampler_config *config,
       re->taps = (unsigned)ceil(re->taps / bandwidth_mod);
    }
 
-   /* Be SIMD-friendly. */
-#if (defined(__AVX__) && ENABLE_AVX) || defined(__ARM_NEON__)
-   re->taps = (re->taps + 7) & ~7;
+#if defined(__ARM_NEON__)
+   re->process = (mask & RESAMPLER_SIMD_NEON) && !re->quality->coeff_lerp
+      ? process_sinc_neon : process_sinc_C;
 #else
-   re->taps = (re->taps + 3) & ~3;
+   re->process = process_sinc_default;
 #endif
 
-   phase_elems = (1 << PHASE_BITS) * re->taps;
-#if SINC_COEFF_LERP
-   phase_elems *= 2;
+#if defined(HAVE_SINC_AVX) || defined(HAVE_SINC_FMA)
+   if ((mask & RESAMPLER_SIMD_AVX) && re->taps >= SINC_AVX_MIN_TAPS)
+   {
+#if defined(HAVE_SINC_AVX)
+      re->process = process_sinc_avx;
+#endif
+#if defined(HAVE_SINC_FMA)
+      /* There is no FMA bit in the mask, but every CPU with AVX2 
+       * also has FMA3. */
+      if (mask & RESAMPLER_SIMD_AVX2)
+         re->process = process_sinc_fma;
 #endif
+   }
+#endif
+
+   /* Be SIMD-friendly. */
+   if (re->process != process_sinc_default)
+      re->taps = (re->taps + 7) & ~7;
+   else
+      re->taps = (re->taps + 3) & ~3;
+
+   phase_elems = (1 << phase_bits) * re->taps;
+   if (re->quality->coeff_lerp)
+      phase_elems *= 2;
    elems = phase_elems + 4 * re->taps;
 
    re->main_buffer = (float*)
       aligned_alloc__(128, sizeof(float) * elems);
    if (!re->main_buffer)
       goto error;
+   /* The history starts out as silence. */
+   memset(re->main_buffer, 0, sizeof(float) * elems);
 
    re->phase_table = re->main_buffer;
    re->buffer_l = re->main_buffer + phase_elems;
    re->buffer_r = re->buffer_l + 2 * re->taps;
 
    init_sinc_table(re, cutoff, re->phase_table,
-         1 << PHASE_BITS, re->taps, SINC_COEFF_LERP);
-
-#if defined(__ARM_NEON__)
-   process_sinc_func = mask & RESAMPLER_SIMD_NEON 
-      ? process_sinc_neon : process_sinc_C;
-#endif
+         1 << phase_bits, re->taps, re->quality->coeff_lerp);
 
    return re;
 
@@ -542,4 +685,3 @@ rarch_resampler_t sinc_resampler = {
    "sinc",
    "sinc"
 };
-
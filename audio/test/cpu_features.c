@@ -0,0 +1,45 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stands in for the frontend's get_cpu_features callback so the
+// resamplers pick the same SIMD paths they would inside RetroArch.
+
+#include "../../libretro.h"
+
+extern retro_get_cpu_features_t perf_get_cpu_features_cb;
+
+static uint64_t test_get_cpu_features(void)
+{
+   uint64_t cpu = 0;
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse"))
+      cpu |= RETRO_SIMD_SSE;
+   if (__builtin_cpu_supports("sse2"))
+      cpu |= RETRO_SIMD_SSE2;
+   if (__builtin_cpu_supports("avx"))
+      cpu |= RETRO_SIMD_AVX;
+   if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      cpu |= RETRO_SIMD_AVX2;
+#elif defined(__ARM_NEON__)
+   cpu |= RETRO_SIMD_NEON;
+#endif
+   return cpu;
+}
+
+void test_init_cpu_features(void)
+{
+   perf_get_cpu_features_cb = test_get_cpu_features;
+}
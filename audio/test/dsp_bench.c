@@ -0,0 +1,221 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmarks the DSP filter plugins with their default settings.
+// Every plugin is run once with an empty SIMD mask (scalar code) and
+// once with the host's mask, and ns/frame is reported for both along
+// with the largest difference between the two outputs.
+//
+// Usage: ./dsp-bench [plugin ident] [seconds of audio]
+
+#include "../audio_filters/dspfilter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_RATE 48000
+#define BENCH_BLOCK_FRAMES 256
+
+extern const struct dspfilter_implementation *panning_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *iir_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *echo_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *phaser_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *wahwah_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *eq_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *chorus_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *reverb_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+
+static const dspfilter_get_implementation_t bench_plugs[] = {
+   panning_dspfilter_get_implementation,
+   iir_dspfilter_get_implementation,
+   echo_dspfilter_get_implementation,
+   phaser_dspfilter_get_implementation,
+   wahwah_dspfilter_get_implementation,
+   eq_dspfilter_get_implementation,
+   chorus_dspfilter_get_implementation,
+   reverb_dspfilter_get_implementation,
+};
+
+static dspfilter_simd_mask_t bench_cpu_features(void)
+{
+   dspfilter_simd_mask_t cpu = 0;
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse"))
+      cpu |= DSPFILTER_SIMD_SSE;
+   if (__builtin_cpu_supports("sse2"))
+      cpu |= DSPFILTER_SIMD_SSE2;
+   if (__builtin_cpu_supports("avx"))
+      cpu |= DSPFILTER_SIMD_AVX;
+#elif defined(__ARM_NEON__)
+   cpu |= DSPFILTER_SIMD_NEON;
+#endif
+   return cpu;
+}
+
+// Config callbacks which always hand back the plugin defaults.
+static int bench_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   *values = (float*)calloc(num_default_values, sizeof(float));
+   memcpy(*values, default_values, num_default_values * sizeof(float));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   *values = (int*)calloc(num_default_values, sizeof(int));
+   memcpy(*values, default_values, num_default_values * sizeof(int));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = strdup(default_output);
+   return 0;
+}
+
+static const struct dspfilter_config bench_config = {
+   bench_get_float,
+   bench_get_int,
+   bench_get_float_array,
+   bench_get_int_array,
+   bench_get_string,
+   free,
+};
+
+static double get_time_ns(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec * 1e9 + tv.tv_nsec;
+}
+
+// Runs @frames of @in through the plugin in driver-sized blocks and
+// stores whatever it outputs in @out. Returns ns/frame.
+static double bench_run(const struct dspfilter_implementation *impl,
+      const float *in, float *out, float *block, size_t frames)
+{
+   size_t i, out_frames = 0;
+   double start, end;
+   struct dspfilter_info info = { BENCH_RATE };
+   void *data = impl->init(&info, &bench_config, NULL);
+
+   if (!data)
+      return -1.0;
+
+   start = get_time_ns();
+   for (i = 0; i < frames; i += BENCH_BLOCK_FRAMES)
+   {
+      struct dspfilter_input input;
+      struct dspfilter_output output = {0};
+
+      // Several plugins filter in place.
+      memcpy(block, in + i * 2, BENCH_BLOCK_FRAMES * 2 * sizeof(float));
+      input.samples = block;
+      input.frames  = BENCH_BLOCK_FRAMES;
+
+      impl->process(data, &output, &input);
+
+      memcpy(out + out_frames * 2, output.samples,
+            output.frames * 2 * sizeof(float));
+      out_frames += output.frames;
+   }
+   end = get_time_ns();
+
+   impl->free(data);
+   return (end - start) / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   size_t j;
+   const char *only = argc > 1 ? argv[1] : NULL;
+   double seconds   = argc > 2 ? strtod(argv[2], NULL) : 20.0;
+   size_t frames    = (size_t)(seconds * BENCH_RATE);
+   dspfilter_simd_mask_t mask = bench_cpu_features();
+   float *in, *out_c, *out_simd, *block;
+
+   frames = (frames + BENCH_BLOCK_FRAMES - 1) & ~(size_t)(BENCH_BLOCK_FRAMES - 1);
+   if (!frames)
+      frames = BENCH_BLOCK_FRAMES;
+
+   // Some plugins buffer up and output more than one block at a time.
+   in       = (float*)calloc(frames * 2, sizeof(float));
+   out_c    = (float*)calloc(frames * 2 + 16 * 1024, sizeof(float));
+   out_simd = (float*)calloc(frames * 2 + 16 * 1024, sizeof(float));
+   block    = (float*)calloc(BENCH_BLOCK_FRAMES * 2, sizeof(float));
+   if (!in || !out_c || !out_simd || !block)
+      return 1;
+
+   srand(1);
+   for (j = 0; j < frames * 2; j++)
+      in[j] = 0.5f * ((float)rand() / RAND_MAX - 0.5f);
+
+   printf("%-10s %12s %12s %8s %12s\n",
+         "plugin", "C ns/frame", "SIMD ns/frame", "speedup", "max diff");
+
+   for (i = 0; i < sizeof(bench_plugs) / sizeof(bench_plugs[0]); i++)
+   {
+      double c_ns, simd_ns, max_diff = 0.0;
+      const struct dspfilter_implementation *c_impl    = bench_plugs[i](0);
+      const struct dspfilter_implementation *simd_impl = bench_plugs[i](mask);
+
+      if (only && strcmp(only, c_impl->short_ident))
+         continue;
+
+      c_ns    = bench_run(c_impl, in, out_c, block, frames);
+      simd_ns = bench_run(simd_impl, in, out_simd, block, frames);
+
+      for (j = 0; j < frames * 2; j++)
+      {
+         double diff = fabs(out_c[j] - out_simd[j]);
+         if (diff > max_diff)
+            max_diff = diff;
+      }
+
+      printf("%-10s %12.2f %12.2f %7.2fx %12g\n",
+            c_impl->short_ident, c_ns, simd_ns, c_ns / simd_ns, max_diff);
+   }
+
+   free(in);
+   free(out_c);
+   free(out_simd);
+   free(block);
+   return 0;
+}
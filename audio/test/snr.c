@@ -13,7 +13,7 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "../resamplers/resampler.h"
+#include "../audio_resampler_driver.h"
 #include "../audio_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <time.h>
 
 #ifndef RESAMPLER_IDENT
 #define RESAMPLER_IDENT "sinc"
@@ -30,6 +31,19 @@
 #undef min
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 
+// Frequency bounds for the summary line. Lower quality levels
+// roll off early, so report both the low band and most of the passband.
+static const float summary_freqs[] = { 0.20, 0.40 };
+
+void test_init_cpu_features(void);
+
+static double get_time_ns(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec * 1e9 + tv.tv_nsec;
+}
+
 static void gen_signal(float *out, double omega, double bias_samples, size_t samples)
 {
    for (size_t i = 0; i < samples; i += 2)
@@ -241,13 +255,16 @@ static void calculate_snr(struct snr_result *res,
 
 int main(int argc, char *argv[])
 {
-   if (argc != 2)
+   if (argc < 2 || argc > 3)
    {
-      fprintf(stderr, "Usage: %s <ratio> (out-rate is fixed for FFT).\n", argv[0]);
+      fprintf(stderr, "Usage: %s <ratio> [quality] (out-rate is fixed for FFT).\n", argv[0]);
       return 1;
    }
 
    double ratio = strtod(argv[1], NULL);
+   enum resampler_quality quality = RESAMPLER_QUALITY_DONTCARE;
+   if (argc == 3)
+      quality = (enum resampler_quality)strtoul(argv[2], NULL, 0);
 
    const unsigned fft_samples = 1024 * 128;
    unsigned out_rate = fft_samples / 2;
@@ -273,11 +290,16 @@ int main(int argc, char *argv[])
 
    void *re = NULL;
    const rarch_resampler_t *resampler = NULL;
-   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, ratio))
+   test_init_cpu_features();
+   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, ratio, quality))
       return 1;
 
    test_fft();
 
+   double worst_snr[2] = { INFINITY, INFINITY };
+   double process_ns = 0.0;
+   size_t process_frames = 0;
+
    for (unsigned i = 0; i < sizeof(freq_list) / sizeof(freq_list[0]); i++)
    {
       unsigned freq = freq_list[i] * in_rate;
@@ -291,7 +313,10 @@ int main(int argc, char *argv[])
          .ratio = ratio,
       };
 
+      double start = get_time_ns();
       rarch_resampler_process(resampler, re, &data);
+      process_ns += get_time_ns() - start;
+      process_frames += data.output_frames;
 
       // We generate 2 seconds worth of audio, however, only the last second is considered so phase has stabilized.
       struct snr_result res = {0};
@@ -304,12 +329,21 @@ int main(int argc, char *argv[])
       printf("SNR @ w = %5.3f : %6.2lf dB, Gain: %6.1lf dB\n",
             freq_list[i], res.snr, res.gain);
 
+      for (unsigned j = 0; j < 2; j++)
+         if (freq_list[i] <= summary_freqs[j] && res.snr < worst_snr[j])
+            worst_snr[j] = res.snr;
+
       printf("\tAliases: #1 (w = %5.3f, %6.2lf dB), #2 (w = %5.3f, %6.2lf dB), #3 (w = %5.3f, %6.2lf dB)\n",
             res.alias_freq[0] / (float)in_rate, res.alias_power[0],
             res.alias_freq[1] / (float)in_rate, res.alias_power[1],
             res.alias_freq[2] / (float)in_rate, res.alias_power[2]);
    }
 
+   printf("Summary: quality %u, worst SNR %6.2lf dB (w <= %4.2f), %6.2lf dB (w <= %4.2f), %6.1lf ns/frame\n",
+         (unsigned)quality,
+         worst_snr[0], summary_freqs[0], worst_snr[1], summary_freqs[1],
+         process_ns / process_frames);
+
    rarch_resampler_freep(&resampler, &re);
    free(input);
    free(output);
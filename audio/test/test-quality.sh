@@ -0,0 +1,10 @@
+#!/bin/sh
+
+# Prints SNR and CPU cost for every sinc quality level.
+# Usage: test-quality.sh [ratio] (default: 44.1 kHz to 48 kHz).
+
+ratio=${1:-1.088435}
+
+for quality in 1 2 3 4 5; do
+   ./test-snr-sinc $ratio $quality 2>/dev/null | grep "^Summary"
+done
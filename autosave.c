@@ -22,6 +22,15 @@
 #include <stdio.h>
 #include "general.h"
 
+#if defined(_WIN32) && !defined(_XBOX)
+#include <io.h>
+#elif !defined(RARCH_CONSOLE)
+#include <unistd.h>
+#endif
+
+/* SRAM is compared and written back in chunks of this size. */
+#define AUTOSAVE_CHUNK_SIZE 4096
+
 struct autosave
 {
    volatile bool quit;
@@ -36,6 +45,12 @@ struct autosave
    const char *path;
    size_t bufsize;
    unsigned interval;
+
+   /* Chunks of buffer not yet written to path. */
+   bool *dirty;
+   size_t num_chunks;
+   /* Set if the file has to be written out in full. */
+   bool rewrite;
 };
 
 /**
@@ -60,6 +75,125 @@ static void autosave_unlock(autosave_t *handle)
    slock_unlock(handle->lock);
 }
 
+/**
+ * autosave_diff:
+ * @save            : pointer to autosave object
+ *
+ * Copies the chunks of SRAM that changed since the last 
+ * check and marks them dirty. Must be called with the
+ * autosave locked.
+ *
+ * Returns: number of chunks that changed.
+ **/
+static size_t autosave_diff(autosave_t *save)
+{
+   size_t i, changed = 0;
+
+   for (i = 0; i < save->num_chunks; i++)
+   {
+      size_t offset     = i * AUTOSAVE_CHUNK_SIZE;
+      size_t size       = save->bufsize - offset;
+      uint8_t *dst      = (uint8_t*)save->buffer + offset;
+      const uint8_t *src = (const uint8_t*)save->retro_buffer + offset;
+
+      if (size > AUTOSAVE_CHUNK_SIZE)
+         size = AUTOSAVE_CHUNK_SIZE;
+
+      if (!memcmp(dst, src, size))
+         continue;
+
+      memcpy(dst, src, size);
+      save->dirty[i] = true;
+      changed++;
+   }
+
+   return changed;
+}
+
+/**
+ * autosave_sync_file:
+ * @file            : file to sync.
+ *
+ * Flushes @file down to the disk.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool autosave_sync_file(FILE *file)
+{
+   if (fflush(file) != 0)
+      return false;
+#if defined(_WIN32) && !defined(_XBOX)
+   return _commit(_fileno(file)) == 0;
+#elif !defined(RARCH_CONSOLE)
+   return fsync(fileno(file)) == 0;
+#else
+   return true;
+#endif
+}
+
+/**
+ * autosave_write:
+ * @save            : pointer to autosave object
+ *
+ * Writes the dirty chunks of SRAM in place, each run of 
+ * consecutive dirty chunks with one write, and syncs the
+ * file once they are all written. The whole file is 
+ * written instead the first time and after a failure.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool autosave_write(autosave_t *save)
+{
+   size_t i;
+   bool failed = false;
+   FILE *file  = NULL;
+
+   if (!save->rewrite)
+      file = fopen(save->path, "r+b");
+
+   if (!file)
+   {
+      file = fopen(save->path, "wb");
+      if (!file)
+         return false;
+
+      failed |= fwrite(save->buffer, 1, save->bufsize, file)
+         != save->bufsize;
+      memset(save->dirty, 0, save->num_chunks * sizeof(*save->dirty));
+   }
+
+   for (i = 0; i < save->num_chunks && !failed; i++)
+   {
+      size_t first = i, offset, size;
+
+      if (!save->dirty[i])
+         continue;
+
+      while (i + 1 < save->num_chunks && save->dirty[i + 1])
+         i++;
+
+      offset = first * AUTOSAVE_CHUNK_SIZE;
+      size   = (i + 1) * AUTOSAVE_CHUNK_SIZE;
+      if (size > save->bufsize)
+         size = save->bufsize;
+      size  -= offset;
+
+      failed |= fseek(file, (long)offset, SEEK_SET) != 0;
+      failed |= !failed && fwrite((const uint8_t*)save->buffer + offset,
+            1, size, file) != size;
+
+      memset(save->dirty + first, 0, (i + 1 - first) * sizeof(*save->dirty));
+   }
+
+   failed |= !autosave_sync_file(file);
+   failed |= fclose(file) != 0;
+
+   /* What made it to the disk is unknown. */
+   save->rewrite = failed;
+
+   return !failed;
+}
+
 /**
  * autosave_thread:
  * @data            : pointer to autosave object
@@ -69,45 +203,32 @@ static void autosave_unlock(autosave_t *handle)
 static void autosave_thread(void *data)
 {
    bool first_log = true;
+   bool retry     = false;
    autosave_t *save = (autosave_t*)data;
 
    while (!save->quit)
    {
-      bool differ = false;
+      size_t changed = 0;
 
       autosave_lock(save);
-      differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
+      changed = autosave_diff(save);
       autosave_unlock(save);
 
-      if (differ)
+      if (changed || retry)
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
-
-         if (file)
+         /* Avoid spamming down stderr ... */
+         if (first_log)
          {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
          }
+         else
+            RARCH_LOG("SRAM changed ... autosaving ...\n");
+
+         retry = !autosave_write(save);
+         if (retry)
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
       }
 
       slock_lock(save->cond_lock);
@@ -144,9 +265,15 @@ autosave_t *autosave_new(const char *path, const void *data, size_t size,
    handle->path = path;
    handle->buffer = malloc(size);
    handle->retro_buffer = data;
+   handle->num_chunks = (size + AUTOSAVE_CHUNK_SIZE - 1) / AUTOSAVE_CHUNK_SIZE;
+   handle->dirty = (bool*)calloc(handle->num_chunks + 1, sizeof(*handle->dirty));
+   /* The file may not match the buffer yet. */
+   handle->rewrite = true;
 
-   if (!handle->buffer)
+   if (!handle->buffer || !handle->dirty)
    {
+      free(handle->buffer);
+      free(handle->dirty);
       free(handle);
       return NULL;
    }
@@ -183,6 +310,7 @@ void autosave_free(autosave_t *handle)
    scond_free(handle->cond);
 
    free(handle->buffer);
+   free(handle->dirty);
    free(handle);
 }
 
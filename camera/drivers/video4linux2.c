@@ -37,10 +37,32 @@
 #include <asm/types.h>
 #include <linux/videodev2.h>
 
+#if defined(HAVE_EGL) && (defined(HAVE_OPENGL) || defined(HAVE_OPENGLES))
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glsym/glsym.h>
+
+#ifdef EGL_LINUX_DMA_BUF_EXT
+#define V4L_HAVE_DMABUF
+#endif
+#endif
+
+#ifdef V4L_HAVE_DMABUF
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+typedef void (*v4l_image_target_texture_t)(GLenum target, void *image);
+#endif
+
 struct buffer
 {
    void *start;
    size_t length;
+#ifdef V4L_HAVE_DMABUF
+   int dmabuf_fd;
+   EGLImageKHR image;
+#endif
 };
 
 typedef struct video4linux
@@ -56,6 +78,21 @@ typedef struct video4linux
    uint32_t *buffer_output;
    bool ready;
 
+#ifdef V4L_HAVE_DMABUF
+   /* When the core takes OpenGL textures, the capture buffers
+    * are imported as EGLImages and bound to an external texture,
+    * which converts from YUYV when sampled. The buffer the texture
+    * shows is only queued again once the next frame is bound. */
+   uint64_t caps;
+   bool gl;
+   GLuint tex;
+   int held;
+   EGLDisplay egl_dpy;
+   PFNEGLCREATEIMAGEKHRPROC create_image;
+   PFNEGLDESTROYIMAGEKHRPROC destroy_image;
+   v4l_image_target_texture_t image_target_texture;
+#endif
+
    char dev_name[PATH_MAX_LENGTH];
 } video4linux_t;
 
@@ -141,6 +178,10 @@ static bool init_mmap(void *data)
          RARCH_ERR("Error - mmap.\n");
          return false;
       }
+
+#ifdef V4L_HAVE_DMABUF
+      v4l->buffers[v4l->n_buffers].dmabuf_fd = -1;
+#endif
    }
 
    return true;
@@ -228,6 +269,110 @@ static bool init_device(void *data)
    return init_mmap(v4l);
 }
 
+#ifdef V4L_HAVE_DMABUF
+static void v4l_deinit_gl(video4linux_t *v4l)
+{
+   unsigned i;
+
+   for (i = 0; i < v4l->n_buffers; i++)
+   {
+      struct buffer *buffer = &v4l->buffers[i];
+
+      if (buffer->image != EGL_NO_IMAGE_KHR)
+         v4l->destroy_image(v4l->egl_dpy, buffer->image);
+      if (buffer->dmabuf_fd >= 0)
+         close(buffer->dmabuf_fd);
+
+      buffer->image     = EGL_NO_IMAGE_KHR;
+      buffer->dmabuf_fd = -1;
+   }
+
+   if (v4l->tex)
+      glDeleteTextures(1, &v4l->tex);
+
+   v4l->tex = 0;
+   v4l->gl  = false;
+}
+
+/**
+ * v4l_init_gl:
+ * @v4l                      : V4L2 camera handle.
+ *
+ * Exports the capture buffers as DMABUFs and imports them as
+ * EGLImages, in the EGL context current on this thread.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool v4l_init_gl(video4linux_t *v4l)
+{
+   unsigned i;
+
+   v4l->egl_dpy = eglGetCurrentDisplay();
+   if (v4l->egl_dpy == EGL_NO_DISPLAY)
+      return false;
+
+   v4l->create_image = (PFNEGLCREATEIMAGEKHRPROC)
+      eglGetProcAddress("eglCreateImageKHR");
+   v4l->destroy_image = (PFNEGLDESTROYIMAGEKHRPROC)
+      eglGetProcAddress("eglDestroyImageKHR");
+   v4l->image_target_texture = (v4l_image_target_texture_t)
+      eglGetProcAddress("glEGLImageTargetTexture2DOES");
+
+   if (!v4l->create_image || !v4l->destroy_image ||
+         !v4l->image_target_texture)
+      return false;
+
+   for (i = 0; i < v4l->n_buffers; i++)
+   {
+      struct v4l2_exportbuffer expbuf;
+      EGLint attribs[] = {
+         EGL_WIDTH,                     (EGLint)v4l->width,
+         EGL_HEIGHT,                    (EGLint)v4l->height,
+         /* Same code as DRM_FORMAT_YUYV. */
+         EGL_LINUX_DRM_FOURCC_EXT,      V4L2_PIX_FMT_YUYV,
+         EGL_DMA_BUF_PLANE0_FD_EXT,     -1,
+         EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+         EGL_DMA_BUF_PLANE0_PITCH_EXT,  (EGLint)v4l->pitch,
+         EGL_NONE
+      };
+
+      memset(&expbuf, 0, sizeof(expbuf));
+
+      expbuf.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      expbuf.index = i;
+      expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+      if (xioctl(v4l->fd, VIDIOC_EXPBUF, &expbuf) == -1)
+         goto error;
+
+      v4l->buffers[i].dmabuf_fd = expbuf.fd;
+      attribs[7]                = expbuf.fd;
+
+      v4l->buffers[i].image = v4l->create_image(v4l->egl_dpy,
+            EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+
+      if (v4l->buffers[i].image == EGL_NO_IMAGE_KHR)
+         goto error;
+   }
+
+   glGenTextures(1, &v4l->tex);
+   glBindTexture(GL_TEXTURE_EXTERNAL_OES, v4l->tex);
+   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+
+   v4l->gl   = true;
+   v4l->held = -1;
+
+   RARCH_LOG("V4L2: Passing frames to the core as EGLImage textures.\n");
+   return true;
+
+error:
+   v4l_deinit_gl(v4l);
+   return false;
+}
+#endif
+
 static void v4l_stop(void *data)
 {
    video4linux_t *v4l = (video4linux_t*)data;
@@ -236,6 +381,11 @@ static void v4l_stop(void *data)
    if (xioctl(v4l->fd, VIDIOC_STREAMOFF, &type) == -1)
       RARCH_ERR("Error - VIDIOC_STREAMOFF.\n");
 
+#ifdef V4L_HAVE_DMABUF
+   if (v4l->gl)
+      v4l_deinit_gl(v4l);
+#endif
+
    v4l->ready = false;
 }
 
@@ -245,6 +395,17 @@ static bool v4l_start(void *data)
    unsigned i;
    enum v4l2_buf_type type;
 
+#ifdef V4L_HAVE_DMABUF
+   if (v4l->caps & (1ULL << RETRO_CAMERA_BUFFER_OPENGL_TEXTURE))
+      v4l_init_gl(v4l);
+
+   if (!v4l->gl && !v4l->buffer_output)
+   {
+      RARCH_ERR("V4L2: Cannot import frames as OpenGL textures.\n");
+      return false;
+   }
+#endif
+
    for (i = 0; i < v4l->n_buffers; i++)
    {
       struct v4l2_buffer buf;
@@ -280,6 +441,12 @@ static void v4l_free(void *data)
    video4linux_t *v4l = (video4linux_t*)data;
 
    unsigned i;
+
+#ifdef V4L_HAVE_DMABUF
+   if (v4l->gl)
+      v4l_deinit_gl(v4l);
+#endif
+
    for (i = 0; i < v4l->n_buffers; i++)
       if (munmap(v4l->buffers[i].start, v4l->buffers[i].length) == -1)
          RARCH_ERR("munmap failed.\n");
@@ -297,11 +464,20 @@ static void *v4l_init(const char *device, uint64_t caps,
 {
    struct stat st;
 
+#ifdef V4L_HAVE_DMABUF
+   if ((caps & ((1ULL << RETRO_CAMERA_BUFFER_RAW_FRAMEBUFFER) |
+               (1ULL << RETRO_CAMERA_BUFFER_OPENGL_TEXTURE))) == 0)
+   {
+      RARCH_ERR("video4linux2 returns raw framebuffers or OpenGL textures.\n");
+      return NULL;
+   }
+#else
    if ((caps & (1ULL << RETRO_CAMERA_BUFFER_RAW_FRAMEBUFFER)) == 0)
    {
       RARCH_ERR("video4linux2 returns raw framebuffers.\n");
       return NULL;
    }
+#endif
 
    video4linux_t *v4l = (video4linux_t*)calloc(1, sizeof(video4linux_t));
    if (!v4l)
@@ -313,6 +489,9 @@ static void *v4l_init(const char *device, uint64_t caps,
    v4l->width  = width;
    v4l->height = height;
    v4l->ready  = false;
+#ifdef V4L_HAVE_DMABUF
+   v4l->caps   = caps;
+#endif
 
    if (stat(v4l->dev_name, &st) == -1)
    {
@@ -339,6 +518,10 @@ static void *v4l_init(const char *device, uint64_t caps,
    if (!init_device(v4l))
       goto error;
 
+   /* Cores taking only OpenGL textures never see the CPU path. */
+   if ((caps & (1ULL << RETRO_CAMERA_BUFFER_RAW_FRAMEBUFFER)) == 0)
+      return v4l;
+
    v4l->buffer_output = (uint32_t*)
       malloc(v4l->width * v4l->height * sizeof(uint32_t));
 
@@ -401,6 +584,60 @@ static bool preprocess_image(void *data)
    return true;
 }
 
+#ifdef V4L_HAVE_DMABUF
+static bool v4l_poll_gl(video4linux_t *v4l,
+      retro_camera_frame_opengl_texture_t frame_gl_cb)
+{
+   struct v4l2_buffer buf;
+   /* Flips the image, which starts at the top-left. */
+   static const float affine[] = {
+      1.0f,  0.0f, 0.0f,
+      0.0f, -1.0f, 0.0f,
+      0.0f,  1.0f, 1.0f
+   };
+
+   memset(&buf, 0, sizeof(buf));
+
+   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   buf.memory = V4L2_MEMORY_MMAP;
+
+   if (xioctl(v4l->fd, VIDIOC_DQBUF, &buf) == -1)
+   {
+      if (errno != EAGAIN)
+         RARCH_ERR("VIDIOC_DQBUF.\n");
+      return false;
+   }
+
+   rarch_assert(buf.index < v4l->n_buffers);
+
+   glBindTexture(GL_TEXTURE_EXTERNAL_OES, v4l->tex);
+   v4l->image_target_texture(GL_TEXTURE_EXTERNAL_OES,
+         v4l->buffers[buf.index].image);
+   glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+
+   if (v4l->held >= 0)
+   {
+      struct v4l2_buffer held;
+
+      memset(&held, 0, sizeof(held));
+
+      held.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      held.memory = V4L2_MEMORY_MMAP;
+      held.index = v4l->held;
+
+      if (xioctl(v4l->fd, VIDIOC_QBUF, &held) == -1)
+         RARCH_ERR("VIDIOC_QBUF\n");
+   }
+
+   v4l->held = buf.index;
+
+   if (frame_gl_cb)
+      frame_gl_cb(v4l->tex, GL_TEXTURE_EXTERNAL_OES, affine);
+
+   return true;
+}
+#endif
+
 static bool v4l_poll(void *data,
       retro_camera_frame_raw_framebuffer_t frame_raw_cb,
       retro_camera_frame_opengl_texture_t frame_gl_cb)
@@ -409,7 +646,12 @@ static bool v4l_poll(void *data,
    if (!v4l->ready)
       return false;
 
+#ifdef V4L_HAVE_DMABUF
+   if (v4l->gl)
+      return v4l_poll_gl(v4l, frame_gl_cb);
+#else
    (void)frame_gl_cb;
+#endif
 
    if (preprocess_image(data))
    {
@@ -0,0 +1,472 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+
+#include "cheat_search.h"
+#include "dynamic.h"
+#include "general.h"
+#include "performance.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Candidates are kept as a bitmap, one bit per value,
+ * and compared a 64-bit word of the bitmap at a time. */
+#define CHUNK_ELEMS 64
+
+struct cheat_search
+{
+   unsigned width;
+   /* Values in the RAM. */
+   size_t elems;
+   /* RAM as of the last pass. */
+   uint8_t *prev;
+   uint64_t *candidates;
+   size_t count;
+};
+
+struct cheat_poke
+{
+   size_t addr;
+   unsigned width;
+   uint32_t value;
+};
+
+static struct cheat_search *search;
+static struct cheat_poke pokes[CHEAT_SEARCH_MAX_POKES];
+static unsigned num_pokes;
+
+static unsigned popcount64(uint64_t v)
+{
+   v = v - ((v >> 1) & 0x5555555555555555ULL);
+   v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+   v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+   return (unsigned)((v * 0x0101010101010101ULL) >> 56);
+}
+
+static INLINE uint32_t read_value(const uint8_t *data, unsigned width)
+{
+   uint8_t  v8;
+   uint16_t v16;
+   uint32_t v32;
+
+   switch (width)
+   {
+      case 1:
+         v8 = *data;
+         return v8;
+      case 2:
+         memcpy(&v16, data, sizeof(v16));
+         return v16;
+      default:
+         memcpy(&v32, data, sizeof(v32));
+         return v32;
+   }
+}
+
+static INLINE bool compare(uint32_t a, uint32_t b,
+      enum cheat_search_cmp cmp)
+{
+   switch (cmp)
+   {
+      case CHEAT_SEARCH_EQUAL:
+         return a == b;
+      case CHEAT_SEARCH_NOT_EQUAL:
+         return a != b;
+      case CHEAT_SEARCH_GREATER:
+         return a > b;
+      case CHEAT_SEARCH_LESS:
+         return a < b;
+   }
+
+   return false;
+}
+
+static uint64_t match_chunk_C(const uint8_t *cur, const uint8_t *prev,
+      unsigned width, size_t elems, enum cheat_search_cmp cmp,
+      bool previous, uint32_t value)
+{
+   size_t i;
+   uint64_t mask = 0;
+
+   for (i = 0; i < elems; i++)
+   {
+      uint32_t a = read_value(cur + i * width, width);
+      uint32_t b = previous ? read_value(prev + i * width, width) : value;
+
+      if (compare(a, b, cmp))
+         mask |= 1ULL << i;
+   }
+
+   return mask;
+}
+
+#if __SSE2__
+/* Lanes of a and b compared as unsigned values of @width bytes,
+ * all ones where @cmp holds. NOT_EQUAL is inverted by the caller. */
+static INLINE __m128i compare_sse2(__m128i a, __m128i b,
+      unsigned width, enum cheat_search_cmp cmp)
+{
+   __m128i bias;
+
+   switch (width)
+   {
+      case 1:
+         if (cmp == CHEAT_SEARCH_EQUAL || cmp == CHEAT_SEARCH_NOT_EQUAL)
+            return _mm_cmpeq_epi8(a, b);
+         bias = _mm_set1_epi8((char)0x80);
+         a    = _mm_xor_si128(a, bias);
+         b    = _mm_xor_si128(b, bias);
+         return cmp == CHEAT_SEARCH_GREATER ?
+            _mm_cmpgt_epi8(a, b) : _mm_cmplt_epi8(a, b);
+      case 2:
+         if (cmp == CHEAT_SEARCH_EQUAL || cmp == CHEAT_SEARCH_NOT_EQUAL)
+            return _mm_cmpeq_epi16(a, b);
+         bias = _mm_set1_epi16((short)0x8000);
+         a    = _mm_xor_si128(a, bias);
+         b    = _mm_xor_si128(b, bias);
+         return cmp == CHEAT_SEARCH_GREATER ?
+            _mm_cmpgt_epi16(a, b) : _mm_cmplt_epi16(a, b);
+      default:
+         if (cmp == CHEAT_SEARCH_EQUAL || cmp == CHEAT_SEARCH_NOT_EQUAL)
+            return _mm_cmpeq_epi32(a, b);
+         bias = _mm_set1_epi32((int)0x80000000);
+         a    = _mm_xor_si128(a, bias);
+         b    = _mm_xor_si128(b, bias);
+         return cmp == CHEAT_SEARCH_GREATER ?
+            _mm_cmpgt_epi32(a, b) : _mm_cmplt_epi32(a, b);
+   }
+}
+
+/* Same result as match_chunk_C for a whole chunk,
+ * 16 values at a time. */
+static uint64_t match_chunk_sse2(const uint8_t *cur, const uint8_t *prev,
+      unsigned width, enum cheat_search_cmp cmp,
+      bool previous, uint32_t value)
+{
+   unsigned group, i;
+   __m128i ref      = _mm_setzero_si128();
+   uint64_t mask    = 0;
+   const __m128i *a = (const __m128i*)cur;
+   const __m128i *b = (const __m128i*)prev;
+
+   if (!previous)
+   {
+      switch (width)
+      {
+         case 1:
+            ref = _mm_set1_epi8((char)value);
+            break;
+         case 2:
+            ref = _mm_set1_epi16((short)value);
+            break;
+         default:
+            ref = _mm_set1_epi32((int)value);
+            break;
+      }
+   }
+
+   for (group = 0; group < CHUNK_ELEMS / 16; group++)
+   {
+      /* 16 values take @width vectors,
+       * packed down to one byte per value. */
+      __m128i m[4];
+      uint32_t bits;
+
+      for (i = 0; i < width; i++, a++, b++)
+         m[i] = compare_sse2(_mm_loadu_si128(a),
+               previous ? _mm_loadu_si128(b) : ref, width, cmp);
+
+      switch (width)
+      {
+         case 1:
+            bits = _mm_movemask_epi8(m[0]);
+            break;
+         case 2:
+            bits = _mm_movemask_epi8(_mm_packs_epi16(m[0], m[1]));
+            break;
+         default:
+            bits = _mm_movemask_epi8(_mm_packs_epi16(
+                     _mm_packs_epi32(m[0], m[1]),
+                     _mm_packs_epi32(m[2], m[3])));
+            break;
+      }
+
+      if (cmp == CHEAT_SEARCH_NOT_EQUAL)
+         bits = ~bits & 0xffff;
+
+      mask |= (uint64_t)bits << (group * 16);
+   }
+
+   return mask;
+}
+#endif
+
+static void cheat_search_free(void)
+{
+   if (!search)
+      return;
+
+   free(search->prev);
+   free(search->candidates);
+   free(search);
+   search = NULL;
+}
+
+bool cheat_search_start(unsigned width)
+{
+   size_t size, words;
+   const uint8_t *ram = (const uint8_t*)
+      pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+
+   cheat_search_free();
+
+   if (width != 1 && width != 2 && width != 4)
+      return false;
+
+   size = pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM);
+   if (!ram || size < width)
+   {
+      RARCH_WARN("Core has no system RAM to search.\n");
+      return false;
+   }
+
+   search = (struct cheat_search*)calloc(1, sizeof(*search));
+   if (!search)
+      return false;
+
+   search->width      = width;
+   search->elems      = size / width;
+   search->count      = search->elems;
+   words              = (search->elems + CHUNK_ELEMS - 1) / CHUNK_ELEMS;
+   search->prev       = (uint8_t*)malloc(search->elems * width);
+   search->candidates = (uint64_t*)malloc(words * sizeof(uint64_t));
+
+   if (!search->prev || !search->candidates)
+   {
+      cheat_search_free();
+      return false;
+   }
+
+   memcpy(search->prev, ram, search->elems * width);
+   memset(search->candidates, 0xff, words * sizeof(uint64_t));
+   if (search->elems % CHUNK_ELEMS)
+      search->candidates[words - 1] =
+         (1ULL << (search->elems % CHUNK_ELEMS)) - 1;
+
+   RARCH_LOG("Cheat search: %u values of %u bytes.\n",
+         (unsigned)search->elems, width);
+   return true;
+}
+
+bool cheat_search_filter(enum cheat_search_cmp cmp,
+      bool previous, uint32_t value)
+{
+   size_t w, words, count = 0;
+   const uint8_t *ram;
+   unsigned width;
+   RARCH_PERFORMANCE_INIT(cheat_search_filter);
+
+   if (!search)
+      return false;
+
+   ram = (const uint8_t*)pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+   if (!ram || pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM) <
+         search->elems * search->width)
+      return false;
+
+   RARCH_PERFORMANCE_START(cheat_search_filter);
+
+   width = search->width;
+   words = (search->elems + CHUNK_ELEMS - 1) / CHUNK_ELEMS;
+
+   for (w = 0; w < words; w++)
+   {
+      uint64_t mask;
+      size_t offset       = w * CHUNK_ELEMS * width;
+      size_t elems        = search->elems - w * CHUNK_ELEMS;
+      const uint8_t *cur  = ram + offset;
+      uint8_t *prev       = search->prev + offset;
+
+      /* Most of the RAM is ruled out after a pass or two. */
+      if (!search->candidates[w])
+         continue;
+
+      if (elems > CHUNK_ELEMS)
+         elems = CHUNK_ELEMS;
+
+#if __SSE2__
+      if (elems == CHUNK_ELEMS)
+         mask = match_chunk_sse2(cur, prev, width, cmp, previous, value);
+      else
+#endif
+         mask = match_chunk_C(cur, prev, width, elems, cmp, previous, value);
+
+      search->candidates[w] &= mask;
+      count += popcount64(search->candidates[w]);
+      memcpy(prev, cur, elems * width);
+   }
+
+   search->count = count;
+
+   RARCH_PERFORMANCE_STOP(cheat_search_filter);
+   return true;
+}
+
+size_t cheat_search_count(void)
+{
+   return search ? search->count : 0;
+}
+
+unsigned cheat_search_width(void)
+{
+   return search ? search->width : 0;
+}
+
+bool cheat_search_next(size_t *addr, uint32_t *value)
+{
+   size_t i;
+
+   if (!search)
+      return false;
+
+   for (i = (*addr + search->width - 1) / search->width;
+         i < search->elems; i++)
+   {
+      uint64_t word = search->candidates[i / CHUNK_ELEMS];
+
+      if (!word)
+      {
+         /* Skip to the next word. */
+         i |= CHUNK_ELEMS - 1;
+         continue;
+      }
+
+      if (!(word & (1ULL << (i % CHUNK_ELEMS))))
+         continue;
+
+      *addr  = i * search->width;
+      *value = read_value(search->prev + *addr, search->width);
+      return true;
+   }
+
+   return false;
+}
+
+bool cheat_search_poke_add(size_t addr, unsigned width, uint32_t value)
+{
+   unsigned i;
+
+   if (width != 1 && width != 2 && width != 4)
+      return false;
+
+   if (addr + width > pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM))
+      return false;
+
+   for (i = 0; i < num_pokes; i++)
+      if (pokes[i].addr == addr)
+         break;
+
+   if (i == CHEAT_SEARCH_MAX_POKES)
+      return false;
+   if (i == num_pokes)
+      num_pokes++;
+
+   pokes[i].addr  = addr;
+   pokes[i].width = width;
+   pokes[i].value = value;
+   return true;
+}
+
+void cheat_search_poke_remove(size_t addr)
+{
+   unsigned i;
+
+   for (i = 0; i < num_pokes; i++)
+   {
+      if (pokes[i].addr != addr)
+         continue;
+
+      pokes[i] = pokes[--num_pokes];
+      return;
+   }
+}
+
+void cheat_search_poke_clear(void)
+{
+   num_pokes = 0;
+}
+
+void cheat_search_poke_apply(void)
+{
+   unsigned i;
+   uint8_t *ram;
+   size_t size;
+   global_t *global = global_get_ptr();
+   driver_t *driver = driver_get_ptr();
+
+   (void)driver;
+
+   if (!num_pokes || global->bsv.movie)
+      return;
+#ifdef HAVE_NETPLAY
+   if (driver->netplay_data)
+      return;
+#endif
+
+   ram  = (uint8_t*)pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+   size = pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM);
+   if (!ram)
+      return;
+
+   for (i = 0; i < num_pokes; i++)
+   {
+      uint8_t  v8  = pokes[i].value;
+      uint16_t v16 = pokes[i].value;
+      uint32_t v32 = pokes[i].value;
+
+      if (pokes[i].addr + pokes[i].width > size)
+         continue;
+
+      switch (pokes[i].width)
+      {
+         case 1:
+            ram[pokes[i].addr] = v8;
+            break;
+         case 2:
+            memcpy(ram + pokes[i].addr, &v16, sizeof(v16));
+            break;
+         default:
+            memcpy(ram + pokes[i].addr, &v32, sizeof(v32));
+            break;
+      }
+   }
+}
+
+void cheat_search_deinit(void)
+{
+   cheat_search_free();
+   cheat_search_poke_clear();
+}
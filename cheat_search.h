@@ -0,0 +1,143 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_CHEAT_SEARCH_H
+#define __RARCH_CHEAT_SEARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Searches the system RAM of the core for values, to find
+ * new cheats. Every value of the chosen width, at an offset
+ * aligned to it, starts out as a candidate. Each pass keeps
+ * the candidates matching a comparison, against a given value
+ * or against their value in the previous pass. Values are
+ * read in the byte order of the host. */
+
+enum cheat_search_cmp
+{
+   CHEAT_SEARCH_EQUAL = 0,
+   CHEAT_SEARCH_NOT_EQUAL,
+   CHEAT_SEARCH_GREATER,
+   CHEAT_SEARCH_LESS
+};
+
+#define CHEAT_SEARCH_MAX_POKES 64
+
+/**
+ * cheat_search_start:
+ * @width                    : Width of the values, 1, 2 or 4 bytes.
+ *
+ * Starts a new search, with all values of the system RAM as
+ * candidates.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool cheat_search_start(unsigned width);
+
+/**
+ * cheat_search_filter:
+ * @cmp                      : Comparison candidates have to match.
+ * @previous                 : Compare against the values of the
+ *                             previous pass, rather than @value.
+ * @value                    : Value to compare against.
+ *
+ * Keeps the candidates for which "current @cmp reference" holds,
+ * comparing unsigned. Not equal to the previous value finds
+ * values which changed, equal finds values which didn't.
+ *
+ * Returns: true (1) if a search is running, otherwise false (0).
+ **/
+bool cheat_search_filter(enum cheat_search_cmp cmp,
+      bool previous, uint32_t value);
+
+/**
+ * cheat_search_count:
+ *
+ * Returns: amount of candidates left.
+ **/
+size_t cheat_search_count(void);
+
+/**
+ * cheat_search_next:
+ * @addr                     : Offset to search from, set to the offset
+ *                             of the candidate found.
+ * @value                    : Set to the value of the candidate, as of
+ *                             the last pass.
+ *
+ * Finds the first candidate at or after @addr.
+ *
+ * Returns: true (1) if one was found, otherwise false (0).
+ **/
+bool cheat_search_next(size_t *addr, uint32_t *value);
+
+/**
+ * cheat_search_width:
+ *
+ * Returns: width of the values searched, or 0 if no search is running.
+ **/
+unsigned cheat_search_width(void);
+
+/**
+ * cheat_search_poke_add:
+ * @addr                     : Offset in the system RAM.
+ * @width                    : Width of the value, 1, 2 or 4 bytes.
+ * @value                    : Value to keep there.
+ *
+ * Adds a RAM cheat, written before every frame the core runs.
+ * Replaces the one already at @addr.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool cheat_search_poke_add(size_t addr, unsigned width, uint32_t value);
+
+/**
+ * cheat_search_poke_remove:
+ * @addr                     : Offset in the system RAM.
+ *
+ * Drops the RAM cheat at @addr, if there is one.
+ **/
+void cheat_search_poke_remove(size_t addr);
+
+void cheat_search_poke_clear(void);
+
+/**
+ * cheat_search_poke_apply:
+ *
+ * Writes the RAM cheats. Called once per frame, before the
+ * core runs. Does nothing during netplay or movies, where
+ * the core has to stay deterministic.
+ **/
+void cheat_search_poke_apply(void);
+
+/**
+ * cheat_search_deinit:
+ *
+ * Ends the search and drops the RAM cheats,
+ * for when the content is unloaded.
+ **/
+void cheat_search_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,6 +18,7 @@
 #include "general.h"
 #include "runloop.h"
 #include "dynamic.h"
+#include "cheat_search.h"
 #include <file/config_file.h>
 #include <file/file_path.h>
 #include <compat/strl.h>
@@ -30,21 +31,200 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <ctype.h>
+
+struct cheat_ram_poke
+{
+   size_t addr;
+   unsigned width;
+   uint32_t value;
+};
+
+/**
+ * cheat_manager_parse_ram:
+ * @code                     : Code of the cheat.
+ * @pokes                    : Set to the values the code writes.
+ *
+ * Returns: amount of values written by a RAM code,
+ * or 0 if @code is not one.
+ **/
+static unsigned cheat_manager_parse_ram(const char *code,
+      struct cheat_ram_poke *pokes)
+{
+   unsigned num = 0;
+
+   if (!code || strncmp(code, "ram:", 4) != 0)
+      return 0;
+
+   code += 4;
+
+   for (;;)
+   {
+      char *end;
+      size_t digits;
+      unsigned long addr, value;
+
+      if (!isxdigit((unsigned char)*code))
+         return 0;
+      addr = strtoul(code, &end, 16);
+      if (*end != ':' || !isxdigit((unsigned char)end[1]))
+         return 0;
+
+      code   = end + 1;
+      value  = strtoul(code, &end, 16);
+      digits = end - code;
+
+      if (digits > 8 || num == CHEAT_SEARCH_MAX_POKES)
+         return 0;
+
+      pokes[num].addr  = addr;
+      pokes[num].width = digits <= 2 ? 1 : digits <= 4 ? 2 : 4;
+      pokes[num].value = value;
+      num++;
+
+      if (*end == '\0')
+         return num;
+      if (*end != '+')
+         return 0;
+      code = end + 1;
+   }
+}
+
+static bool cheat_manager_is_ram(const char *code)
+{
+   return code && strncmp(code, "ram:", 4) == 0;
+}
+
+static void cheat_manager_apply_ram(const char *code, bool enable)
+{
+   unsigned i;
+   struct cheat_ram_poke pokes[CHEAT_SEARCH_MAX_POKES];
+   unsigned num = cheat_manager_parse_ram(code, pokes);
+
+   if (!num && enable)
+      RARCH_WARN("Invalid RAM cheat: %s.\n", code);
+
+   for (i = 0; i < num; i++)
+   {
+      if (!enable)
+         cheat_search_poke_remove(pokes[i].addr);
+      else if (!cheat_search_poke_add(pokes[i].addr,
+               pokes[i].width, pokes[i].value))
+         RARCH_WARN("Could not poke RAM at 0x%x.\n",
+               (unsigned)pokes[i].addr);
+   }
+}
+
+/* Drops the RAM values of the cheats, which stay in effect
+ * for as long as they are poked. */
+static void cheat_manager_remove_ram(cheat_manager_t *handle)
+{
+   unsigned i;
+
+   for (i = 0; i < handle->size; i++)
+   {
+      struct item_cheat *cheat = &handle->cheats[i];
+
+      if (cheat->applied && cheat_manager_is_ram(cheat->code))
+         cheat_manager_apply_ram(cheat->code, false);
+      cheat->applied = false;
+   }
+}
 
 void cheat_manager_apply_cheats(cheat_manager_t *handle)
 {
    unsigned i, idx = 0;
+   bool core_dirty  = false;
+   global_t *global = global_get_ptr();
 
    if (!handle)
       return;
 
+   /* RAM codes are put in effect without the core. */
+   for (i = 0; i < handle->size; i++)
+   {
+      struct item_cheat *cheat = &handle->cheats[i];
+
+      if (!cheat->dirty)
+         continue;
+
+      if (!cheat_manager_is_ram(cheat->code))
+      {
+         core_dirty = true;
+         continue;
+      }
+
+      cheat_manager_apply_ram(cheat->code, cheat->state);
+      cheat->applied = cheat->state;
+      cheat->dirty   = false;
+   }
+
+   if (!core_dirty && !handle->reset)
+      return;
+
+   if (global->system.cheat_incremental && !handle->reset)
+   {
+      for (i = 0; i < handle->size; i++)
+      {
+         struct item_cheat *cheat = &handle->cheats[i];
+         bool enable = cheat->state && cheat->code;
+
+         if (!cheat->dirty)
+            continue;
+
+         if (enable || cheat->applied)
+            pretro_cheat_set(i, enable, cheat->code ? cheat->code : "");
+         cheat->applied = enable;
+         cheat->dirty   = false;
+      }
+      return;
+   }
+
    pretro_cheat_reset();
 
    for (i = 0; i < handle->size; i++)
    {
-      if (handle->cheats[i].state)
-         pretro_cheat_set(idx++, true, handle->cheats[i].code);
+      struct item_cheat *cheat = &handle->cheats[i];
+      bool enable = cheat->state && cheat->code;
+
+      if (cheat_manager_is_ram(cheat->code))
+         continue;
+
+      /* Incremental cores get the same index for a code
+       * in every call, until the next reset. */
+      if (enable)
+         pretro_cheat_set(global->system.cheat_incremental ? i : idx++,
+               true, cheat->code);
+      cheat->applied = enable;
+      cheat->dirty   = false;
+   }
+
+   handle->reset = false;
+}
+
+void cheat_manager_set_code(cheat_manager_t *handle, unsigned idx,
+      const char *code)
+{
+   struct item_cheat *cheat = NULL;
+
+   if (!handle || idx >= handle->size)
+      return;
+
+   cheat = &handle->cheats[idx];
+
+   if (cheat->applied)
+   {
+      /* The old code has to go before it is forgotten. */
+      if (cheat_manager_is_ram(cheat->code))
+         cheat_manager_apply_ram(cheat->code, false);
+      else if (cheat_manager_is_ram(code))
+         handle->reset = true;
+      cheat->applied = false;
    }
+
+   free(cheat->code);
+   cheat->code  = code ? strdup(code) : NULL;
+   cheat->dirty = true;
 }
 
 /**
@@ -146,6 +326,8 @@ cheat_manager_t *cheat_manager_load(const char *path)
 
       if (config_get_bool(conf, enable_key, &tmp_bool))
          cheat->cheats[i].state  = tmp_bool;
+
+      cheat->cheats[i].dirty     = true;
    }
 
    config_file_free(conf);
@@ -163,6 +345,7 @@ cheat_manager_t *cheat_manager_new(unsigned size)
       return NULL;
 
    handle->buf_size = handle->size = size;
+   handle->reset    = true;
    handle->cheats = (struct item_cheat*)
       calloc(handle->buf_size, sizeof(struct item_cheat));
 
@@ -191,6 +374,9 @@ bool cheat_manager_realloc(cheat_manager_t *handle, unsigned new_size)
    if (!handle)
       return false;
 
+   cheat_manager_remove_ram(handle);
+   handle->reset = true;
+
    if (!handle->cheats)
       handle->cheats = (struct item_cheat*)
          calloc(new_size, sizeof(struct item_cheat));
@@ -213,6 +399,8 @@ bool cheat_manager_realloc(cheat_manager_t *handle, unsigned new_size)
       handle->cheats[i].desc    = NULL;
       handle->cheats[i].code    = NULL;
       handle->cheats[i].state   = false;
+      handle->cheats[i].dirty   = false;
+      handle->cheats[i].applied = false;
    }
 
    return true;
@@ -226,6 +414,8 @@ void cheat_manager_free(cheat_manager_t *handle)
 
    if (handle->cheats)
    {
+      cheat_manager_remove_ram(handle);
+
       for (i = 0; i < handle->size; i++)
       {
          free(handle->cheats[i].desc);
@@ -261,6 +451,7 @@ void cheat_manager_toggle(cheat_manager_t *handle)
       return;
 
    handle->cheats[handle->ptr].state ^= true;
+   handle->cheats[handle->ptr].dirty  = true;
    cheat_manager_apply_cheats(handle);
    cheat_manager_update(handle, handle->ptr);
 }
@@ -28,6 +28,10 @@ struct item_cheat
    char *desc;
    bool state;
    char *code;
+   /* Enabled, disabled or edited since the last apply. */
+   bool dirty;
+   /* In effect as of the last apply. */
+   bool applied;
 };
 
 struct cheat_manager
@@ -36,12 +40,34 @@ struct cheat_manager
    unsigned ptr;
    unsigned size;
    unsigned buf_size;
+   /* The codes of the core have to be reset on the next apply. */
+   bool reset;
 };
 
 typedef struct cheat_manager cheat_manager_t;
 
 cheat_manager_t *cheat_manager_new(unsigned size);
 
+/**
+ * cheat_manager_load:
+ * @path                      : Path to cheats file (absolute path).
+ *
+ * Loads cheats from a file on disk, a config file of the form:
+ *
+ *   cheats = 2
+ *   cheat0_desc = "Infinite lives"
+ *   cheat0_code = "7E0DBE:09"
+ *   cheat0_enable = true
+ *   cheat1_desc = "Max money"
+ *   cheat1_code = "ram:1f40:03e7+1f42:ff"
+ *   cheat1_enable = false
+ *
+ * Codes are handed to the core as they are, except for codes
+ * starting with "ram:", which the frontend writes to the system
+ * RAM itself, see cheat_manager_apply_cheats().
+ *
+ * Returns: cheat manager handle on success, otherwise NULL.
+ **/
 cheat_manager_t *cheat_manager_load(const char *path);
 
 /**
@@ -64,6 +90,30 @@ void cheat_manager_index_prev(cheat_manager_t *handle);
 
 void cheat_manager_toggle(cheat_manager_t *handle);
 
+/**
+ * cheat_manager_set_code:
+ * @handle                   : Cheat manager handle.
+ * @idx                      : Index of the cheat.
+ * @code                     : New code of the cheat.
+ *
+ * Replaces the code of a cheat, to take effect on the next apply.
+ **/
+void cheat_manager_set_code(cheat_manager_t *handle, unsigned idx,
+      const char *code);
+
+/**
+ * cheat_manager_apply_cheats:
+ * @handle                   : Cheat manager handle.
+ *
+ * Puts the cheats which changed since the last apply in effect.
+ *
+ * Codes of the form "ram:<offset>:<value>[+<offset>:<value>...]",
+ * in hexadecimal, are written to the system RAM by the frontend,
+ * the width of each value following from its amount of digits.
+ * Other codes go to the core, one by one if the core set
+ * RETRO_ENVIRONMENT_SET_CHEAT_INCREMENTAL (see libretro_private.h),
+ * otherwise by resetting and setting all of its codes again.
+ **/
 void cheat_manager_apply_cheats(cheat_manager_t *handle);
 
 void cheat_manager_update(cheat_manager_t *handle, unsigned handle_idx);
@@ -19,15 +19,21 @@
 #include <net/net_compat.h>
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
 #include "netplay.h"
+#include "command_binary.h"
 #endif
 
 #include "general.h"
 #include "runloop.h"
+#include "audio/audio_profiler.h"
+#include "cheat_search.h"
+#include "gfx/video_monitor.h"
+#include "performance.h"
 #include "compat/strl.h"
 #include "compat/posix_string.h"
 #include <file/file_path.h>
 #include <retro_miscellaneous.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifndef _WIN32
@@ -38,6 +44,33 @@
 #define DEFAULT_NETWORK_CMD_PORT 55355
 #define STDIN_BUF_SIZE 4096
 
+/* Replies over the network are split at lines into datagrams
+ * of at most this size. */
+#define CMD_REPLY_PACKET_SIZE 1024
+
+/* How long --command waits for the first reply, in ms. */
+#define CMD_REPLY_TIMEOUT_MSEC 1000
+
+#define CMD_MAX_SUBSCRIBERS 4
+
+/* Where a command came from, and where its reply goes. */
+struct cmd_peer
+{
+   bool is_stdin;
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+#endif
+};
+
+struct cmd_subscriber
+{
+   struct cmd_peer peer;
+   /* Frames between replies, and frames since the last. */
+   unsigned interval;
+   unsigned frames;
+};
+
 struct rarch_cmd
 {
 #ifdef HAVE_STDIN_CMD
@@ -48,9 +81,13 @@ struct rarch_cmd
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    int net_fd;
+   cmd_binary_t *binary;
 #endif
 
    bool state[RARCH_BIND_LIST_END];
+
+   struct cmd_subscriber perf_subscribers[CMD_MAX_SUBSCRIBERS];
+   unsigned perf_subscribers_count;
 };
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
@@ -157,6 +194,8 @@ void rarch_cmd_free(rarch_cmd_t *handle)
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    if (handle && handle->net_fd >= 0)
       socket_close(handle->net_fd);
+   if (handle)
+      cmd_binary_free(handle->binary);
 #endif
 
    free(handle);
@@ -236,10 +275,308 @@ static bool cmd_set_shader(const char *arg)
    return video_driver_set_shader(type, arg);
 }
 
+static bool cmd_rewind_seek(const char *arg)
+{
+   double fps;
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+   double seconds       = strtod(arg, NULL);
+
+   if (!global->rewind.state || seconds <= 0.0)
+      return false;
+
+   fps = global->system.av_info.timing.fps > 0.0 ?
+      global->system.av_info.timing.fps : 60.0;
+
+   /* Done by check_rewind() on the next frame. */
+   global->rewind.seek = seconds * fps /
+      (settings->rewind_granularity ? settings->rewind_granularity : 1);
+   if (!global->rewind.seek)
+      global->rewind.seek = 1;
+
+   return true;
+}
+
+static bool cmd_cheat_poke(const char *arg)
+{
+   char *end        = NULL;
+   size_t addr;
+   uint32_t value;
+   unsigned width;
+
+   if (!strcmp(arg, "CLEAR"))
+   {
+      cheat_search_poke_clear();
+      return true;
+   }
+
+   addr  = strtoul(arg, &end, 0);
+   if (end == arg)
+      return false;
+   arg   = end;
+   value = strtoul(arg, &end, 0);
+   if (end == arg)
+      return false;
+   width = strtoul(end, NULL, 0);
+
+   if (!width)
+      width = cheat_search_width() ? cheat_search_width() : 1;
+
+   return cheat_search_poke_add(addr, width, value);
+}
+
 static const struct cmd_action_map action_map[] = {
    { "SET_SHADER", cmd_set_shader, "<shader path>" },
+   { "REWIND_SEEK", cmd_rewind_seek, "<seconds>" },
+   { "AUDIO_PROFILE_DUMP", audio_profiler_dump, "<file path>" },
+   { "MEMORY_DUMP", rarch_memory_dump, "<file path>" },
+   { "FRAME_TIME_DUMP", video_monitor_frame_time_dump, "<file path>" },
+   { "CHEAT_POKE", cmd_cheat_poke, "<address> <value> [<width>], or CLEAR" },
+};
+
+static void cmd_reply(rarch_cmd_t *handle, const struct cmd_peer *peer,
+      const char *msg, size_t len)
+{
+#ifdef HAVE_STDIN_CMD
+   if (peer->is_stdin)
+   {
+      fwrite(msg, 1, len, stdout);
+      fflush(stdout);
+      return;
+   }
+#endif
+
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   while (len)
+   {
+      size_t packet = min(len, CMD_REPLY_PACKET_SIZE);
+
+      /* Split after the last whole line, unless a line
+       * doesn't fit at all. */
+      if (packet < len)
+      {
+         size_t line = packet;
+         while (line && msg[line - 1] != '\n')
+            line--;
+         if (line)
+            packet = line;
+      }
+
+      sendto(handle->net_fd, msg, packet, 0,
+            (const struct sockaddr*)&peer->addr, peer->addr_len);
+      msg += packet;
+      len -= packet;
+   }
+#else
+   (void)handle;
+   (void)peer;
+   (void)msg;
+   (void)len;
+#endif
+}
+
+static bool cmd_peer_equal(const struct cmd_peer *a,
+      const struct cmd_peer *b)
+{
+   if (a->is_stdin || b->is_stdin)
+      return a->is_stdin == b->is_stdin;
+
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   return a->addr_len == b->addr_len
+      && !memcmp(&a->addr, &b->addr, a->addr_len);
+#else
+   return true;
+#endif
+}
+
+static void cmd_send_perf(rarch_cmd_t *handle, const struct cmd_peer *peer)
+{
+   static const char end[] = "PERF_END\n";
+   static char buf[2 * MAX_COUNTERS * 128];
+   size_t len = rarch_perf_print(buf, sizeof(buf) - (sizeof(end) - 1));
+
+   memcpy(buf + len, end, sizeof(end));
+   cmd_reply(handle, peer, buf, len + sizeof(end) - 1);
+}
+
+static bool cmd_get_perf(rarch_cmd_t *handle,
+      const struct cmd_peer *peer, const char *arg)
+{
+   (void)arg;
+   cmd_send_perf(handle, peer);
+   return true;
+}
+
+static bool cmd_subscribe_perf(rarch_cmd_t *handle,
+      const struct cmd_peer *peer, const char *arg)
+{
+   unsigned i;
+   struct cmd_subscriber *subscriber = NULL;
+   unsigned interval                 = *arg ? strtoul(arg, NULL, 0) : 60;
+
+   for (i = 0; i < handle->perf_subscribers_count; i++)
+   {
+      if (cmd_peer_equal(&handle->perf_subscribers[i].peer, peer))
+      {
+         subscriber = &handle->perf_subscribers[i];
+         break;
+      }
+   }
+
+   if (!interval)
+   {
+      /* Unsubscribe. */
+      if (subscriber)
+         *subscriber = handle->perf_subscribers[
+            --handle->perf_subscribers_count];
+      return true;
+   }
+
+   if (!subscriber)
+   {
+      /* Full, replace the oldest subscriber. */
+      if (handle->perf_subscribers_count == CMD_MAX_SUBSCRIBERS)
+      {
+         memmove(handle->perf_subscribers, handle->perf_subscribers + 1,
+               (CMD_MAX_SUBSCRIBERS - 1) * sizeof(*subscriber));
+         handle->perf_subscribers_count--;
+      }
+      subscriber = &handle->perf_subscribers[
+         handle->perf_subscribers_count++];
+      subscriber->peer = *peer;
+   }
+
+   subscriber->interval = interval;
+   subscriber->frames   = 0;
+   cmd_send_perf(handle, peer);
+   return true;
+}
+
+static void cmd_perf_subscribers_tick(rarch_cmd_t *handle)
+{
+   unsigned i;
+
+   for (i = 0; i < handle->perf_subscribers_count; i++)
+   {
+      struct cmd_subscriber *subscriber = &handle->perf_subscribers[i];
+
+      if (++subscriber->frames < subscriber->interval)
+         continue;
+
+      subscriber->frames = 0;
+      cmd_send_perf(handle, &subscriber->peer);
+   }
+}
+
+#define CHEAT_SEARCH_LIST_MAX 256
+
+static bool cmd_cheat_search(rarch_cmd_t *handle,
+      const struct cmd_peer *peer, const char *arg)
+{
+   static const struct
+   {
+      const char *str;
+      enum cheat_search_cmp cmp;
+   } cmps[] = {
+      { "EQ", CHEAT_SEARCH_EQUAL },
+      { "NE", CHEAT_SEARCH_NOT_EQUAL },
+      { "GT", CHEAT_SEARCH_GREATER },
+      { "LT", CHEAT_SEARCH_LESS },
+   };
+   static const char end[] = "CHEAT_SEARCH_END\n";
+   static char buf[CHEAT_SEARCH_LIST_MAX * 32 + sizeof(end)];
+   unsigned i;
+   bool ret         = false;
+   size_t len       = 0;
+   char *next       = NULL;
+   const char *val  = arg + strcspn(arg, " ");
+   uint32_t arg_val = strtoul(val, &next, 0);
+   bool has_val     = next != val;
+
+   if (!strncmp(arg, "START", 5))
+      ret = cheat_search_start(has_val ? arg_val : 1);
+   else if (!strncmp(arg, "LIST", 4))
+   {
+      size_t addr  = 0;
+      uint32_t value;
+      unsigned max = has_val ? arg_val : CHEAT_SEARCH_LIST_MAX;
+
+      if (max > CHEAT_SEARCH_LIST_MAX)
+         max = CHEAT_SEARCH_LIST_MAX;
+
+      for (i = 0; i < max && cheat_search_next(&addr, &value); i++)
+      {
+         len += snprintf(buf + len, sizeof(buf) - len, "0x%06x %u\n",
+               (unsigned)addr, (unsigned)value);
+         addr++;
+      }
+      ret = cheat_search_width() != 0;
+   }
+   else
+   {
+      for (i = 0; i < ARRAY_SIZE(cmps); i++)
+      {
+         if (strncmp(arg, cmps[i].str, 2) != 0)
+            continue;
+
+         /* Without a value, compares against the previous pass. */
+         ret = cheat_search_filter(cmps[i].cmp, !has_val, arg_val);
+         break;
+      }
+   }
+
+   len += snprintf(buf + len, sizeof(buf) - len, ret ?
+         "CANDIDATES %u\n" : "ERROR\n", (unsigned)cheat_search_count());
+   memcpy(buf + len, end, sizeof(end));
+   cmd_reply(handle, peer, buf, len + sizeof(end) - 1);
+   return ret;
+}
+
+/* Commands which reply to where they came from. The argument
+ * is optional, and every reply ends with a line ending in _END. */
+struct cmd_reply_map
+{
+   const char *str;
+   bool (*action)(rarch_cmd_t *handle,
+         const struct cmd_peer *peer, const char *arg);
+   const char *arg_desc;
+   /* Keeps replying until cancelled. */
+   bool stream;
 };
 
+static const struct cmd_reply_map reply_map[] = {
+   { "GET_PERF", cmd_get_perf, "", false },
+   { "SUBSCRIBE_PERF", cmd_subscribe_perf,
+      "[<frames between replies, 0 to stop>]", true },
+   { "CHEAT_SEARCH", cmd_cheat_search,
+      "<START [<width>], EQ|NE|GT|LT [<value>], or LIST [<max>]>", false },
+};
+
+static const struct cmd_reply_map *command_get_reply(const char *tok,
+      const char **arg)
+{
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(reply_map); i++)
+   {
+      size_t len = strlen(reply_map[i].str);
+
+      if (strncmp(tok, reply_map[i].str, len) != 0)
+         continue;
+
+      if (tok[len] == '\0')
+         *arg = tok + len;
+      else if (tok[len] == ' ')
+         *arg = tok + len + 1;
+      else
+         continue;
+
+      return &reply_map[i];
+   }
+
+   return NULL;
+}
+
 static bool command_get_arg(const char *tok,
       const char **arg, unsigned *index)
 {
@@ -281,12 +618,19 @@ static bool command_get_arg(const char *tok,
    return false;
 }
 
-static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
+static void parse_sub_msg(rarch_cmd_t *handle,
+      const struct cmd_peer *peer, const char *tok)
 {
-   const char *arg = NULL;
-   unsigned index  = 0;
+   const char *arg                    = NULL;
+   unsigned index                     = 0;
+   const struct cmd_reply_map *action = command_get_reply(tok, &arg);
 
-   if (command_get_arg(tok, &arg, &index))
+   if (action)
+   {
+      if (!action->action(handle, peer, arg))
+         RARCH_ERR("Command \"%s\" failed.\n", tok);
+   }
+   else if (command_get_arg(tok, &arg, &index))
    {
       if (arg)
       {
@@ -300,18 +644,52 @@ static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
       RARCH_WARN("Unrecognized command \"%s\" received.\n", tok);
 }
 
-static void parse_msg(rarch_cmd_t *handle, char *buf)
+static void parse_msg(rarch_cmd_t *handle,
+      const struct cmd_peer *peer, char *buf)
 {
    char *save = NULL;
    const char *tok = strtok_r(buf, "\n", &save);
 
    while (tok)
    {
-      parse_sub_msg(handle, tok);
+      parse_sub_msg(handle, peer, tok);
       tok = strtok_r(NULL, "\n", &save);
    }
 }
 
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+static bool cmd_binary_text(void *data, const char *cmd)
+{
+   rarch_cmd_t *handle = (rarch_cmd_t*)data;
+   const char *arg     = NULL;
+   unsigned index      = 0;
+
+   if (!command_get_arg(cmd, &arg, &index))
+      return false;
+
+   if (arg)
+      return action_map[index].action(arg);
+
+   handle->state[map[index].id] = true;
+   return true;
+}
+
+bool rarch_cmd_listen_binary(rarch_cmd_t *handle,
+      uint16_t port, const char *socket_path)
+{
+   cmd_binary_free(handle->binary);
+   handle->binary = cmd_binary_new(port, socket_path,
+         cmd_binary_text, handle);
+   return handle->binary != NULL;
+}
+
+void rarch_cmd_poll_binary(rarch_cmd_t *handle)
+{
+   if (handle->binary)
+      cmd_binary_poll(handle->binary);
+}
+#endif
+
 void rarch_cmd_set(rarch_cmd_t *handle, unsigned id)
 {
    if (id < RARCH_BIND_LIST_END)
@@ -344,14 +722,18 @@ static void network_cmd_poll(rarch_cmd_t *handle)
    for (;;)
    {
       char buf[1024];
-      ssize_t ret = recvfrom(handle->net_fd, buf,
-            sizeof(buf) - 1, 0, NULL, NULL);
+      struct cmd_peer peer = {0};
+      ssize_t ret;
+
+      peer.addr_len = sizeof(peer.addr);
+      ret = recvfrom(handle->net_fd, buf, sizeof(buf) - 1, 0,
+            (struct sockaddr*)&peer.addr, &peer.addr_len);
 
       if (ret <= 0)
          break;
 
       buf[ret] = '\0';
-      parse_msg(handle, buf);
+      parse_msg(handle, &peer, buf);
    }
 }
 #endif
@@ -464,6 +846,7 @@ static size_t read_stdin(char *buf, size_t size)
 
 static void stdin_cmd_poll(rarch_cmd_t *handle)
 {
+   struct cmd_peer peer = {0};
    char *last_newline;
    ssize_t ret;
    ptrdiff_t msg_len;
@@ -497,7 +880,8 @@ static void stdin_cmd_poll(rarch_cmd_t *handle)
    *last_newline++ = '\0';
    msg_len = last_newline - handle->stdin_buf;
 
-   parse_msg(handle, handle->stdin_buf);
+   peer.is_stdin = true;
+   parse_msg(handle, &peer, handle->stdin_buf);
 
    memmove(handle->stdin_buf, last_newline,
          handle->stdin_buf_ptr - msg_len);
@@ -516,11 +900,51 @@ void rarch_cmd_poll(rarch_cmd_t *handle)
 #ifdef HAVE_STDIN_CMD
    stdin_cmd_poll(handle);
 #endif
+
+   cmd_perf_subscribers_tick(handle);
 }
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+/* Prints the replies to a command sent on @fd to stdout.
+ * Returns true if any came. */
+static bool receive_udp_replies(int fd, bool stream)
+{
+   bool received = false;
+
+   for (;;)
+   {
+      fd_set fds;
+      ssize_t ret;
+      char buf[CMD_REPLY_PACKET_SIZE + 1];
+      struct timeval tv = {0};
+
+      tv.tv_sec  = CMD_REPLY_TIMEOUT_MSEC / 1000;
+      tv.tv_usec = (CMD_REPLY_TIMEOUT_MSEC % 1000) * 1000;
+
+      FD_ZERO(&fds);
+      FD_SET(fd, &fds);
+
+      /* Once started, streams go on until interrupted. */
+      if (socket_select(fd + 1, &fds, NULL, NULL,
+               (stream && received) ? NULL : &tv) <= 0)
+         return received;
+
+      ret = recv(fd, buf, sizeof(buf) - 1, 0);
+      if (ret <= 0)
+         return received;
+
+      buf[ret] = '\0';
+      fputs(buf, stdout);
+      fflush(stdout);
+      received = true;
+
+      if (!stream && ret >= 5 && !strcmp(buf + ret - 5, "_END\n"))
+         return true;
+   }
+}
+
 static bool send_udp_packet(const char *host,
-      uint16_t port, const char *msg)
+      uint16_t port, const char *msg, const struct cmd_reply_map *reply)
 {
    char port_buf[16];
    struct addrinfo hints, *res = NULL;
@@ -563,6 +987,10 @@ static bool send_udp_packet(const char *host,
          goto end;
       }
 
+      /* Only the first target that replies gets the command. */
+      if (reply && receive_udp_replies(fd, reply->stream))
+         goto end;
+
       socket_close(fd);
       fd = -1;
       tmp = tmp->ai_next;
@@ -578,8 +1006,9 @@ end:
 static bool verify_command(const char *cmd)
 {
    unsigned i;
+   const char *arg = NULL;
 
-   if (command_get_arg(cmd, NULL, NULL))
+   if (command_get_arg(cmd, NULL, NULL) || command_get_reply(cmd, &arg))
       return true;
 
    RARCH_ERR("Command \"%s\" is not recognized by RetroArch.\n", cmd);
@@ -590,6 +1019,9 @@ static bool verify_command(const char *cmd)
    for (i = 0; i < sizeof(action_map) / sizeof(action_map[0]); i++)
       RARCH_ERR("\t\t%s %s\n", action_map[i].str, action_map[i].arg_desc);
 
+   for (i = 0; i < ARRAY_SIZE(reply_map); i++)
+      RARCH_ERR("\t\t%s %s\n", reply_map[i].str, reply_map[i].arg_desc);
+
    return false;
 }
 
@@ -634,7 +1066,13 @@ bool network_cmd_send(const char *cmd_)
    RARCH_LOG("Sending command: \"%s\" to %s:%hu\n",
          cmd, host, (unsigned short)port);
 
-   ret = verify_command(cmd) && send_udp_packet(host, port, cmd);
+   if (!verify_command(cmd))
+      ret = false;
+   else
+   {
+      const char *arg = NULL;
+      ret = send_udp_packet(host, port, cmd, command_get_reply(cmd, &arg));
+   }
    free(command);
 
    global->verbosity = old_verbose;
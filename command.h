@@ -43,6 +43,29 @@ bool rarch_cmd_get(rarch_cmd_t *handle, unsigned id);
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
 bool network_cmd_send(const char *cmd);
+
+/**
+ * rarch_cmd_listen_binary:
+ * @handle               : Command interface.
+ * @port                 : TCP port to listen on, or 0.
+ * @socket_path          : Unix domain socket to listen on, or empty.
+ *
+ * Starts the binary command protocol, see command_binary.h.
+ *
+ * Returns: true (1) if it listens, otherwise false (0).
+ **/
+bool rarch_cmd_listen_binary(rarch_cmd_t *handle,
+      uint16_t port, const char *socket_path);
+
+/**
+ * rarch_cmd_poll_binary:
+ * @handle               : Command interface.
+ *
+ * Handles binary commands. Unlike rarch_cmd_poll(), which the
+ * core's input polling calls, it has to be called between frames,
+ * as the commands access the core.
+ **/
+void rarch_cmd_poll_binary(rarch_cmd_t *handle);
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,531 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <net/net_compat.h>
+#include <compat/strl.h>
+
+#if !defined(_WIN32) && !defined(HAVE_SOCKET_LEGACY)
+#include <sys/un.h>
+#include <unistd.h>
+#define HAVE_UNIX_SOCKET
+#endif
+
+#include "command_binary.h"
+#include "dynamic.h"
+#include "general.h"
+
+#define CMD_BINARY_HEADER_SIZE 8
+
+/* Requests with bigger payloads drop the connection. */
+#define CMD_BINARY_MAX_PAYLOAD (64 * 1024 * 1024)
+
+#define CMD_BINARY_MAX_CLIENTS 8
+
+/* Longest text command. */
+#define CMD_BINARY_MAX_TEXT 1024
+
+struct cmd_binary_buffer
+{
+   uint8_t *data;
+   size_t size;
+   size_t capacity;
+};
+
+struct cmd_binary_client
+{
+   int fd;
+   struct cmd_binary_buffer in;
+   struct cmd_binary_buffer out;
+};
+
+struct cmd_binary
+{
+   int tcp_fd;
+   int unix_fd;
+   char unix_path[PATH_MAX_LENGTH];
+
+   struct cmd_binary_client clients[CMD_BINARY_MAX_CLIENTS];
+   unsigned clients_count;
+
+   cmd_binary_text_cb_t text_cb;
+   void *text_data;
+};
+
+static uint32_t cmd_binary_read_u32(const uint8_t *data)
+{
+   return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void cmd_binary_write_u32(uint8_t *data, uint32_t value)
+{
+   data[0] = value;
+   data[1] = value >> 8;
+   data[2] = value >> 16;
+   data[3] = value >> 24;
+}
+
+/* Makes room for @size more bytes, and returns where they go. */
+static uint8_t *cmd_binary_buffer_reserve(struct cmd_binary_buffer *buf,
+      size_t size)
+{
+   if (buf->capacity - buf->size < size)
+   {
+      uint8_t *data;
+      size_t capacity = buf->capacity ? buf->capacity : 4096;
+
+      while (capacity - buf->size < size)
+         capacity *= 2;
+
+      if (!(data = (uint8_t*)realloc(buf->data, capacity)))
+         return NULL;
+
+      buf->data     = data;
+      buf->capacity = capacity;
+   }
+
+   return buf->data + buf->size;
+}
+
+static void cmd_binary_buffer_consume(struct cmd_binary_buffer *buf,
+      size_t size)
+{
+   memmove(buf->data, buf->data + size, buf->size - size);
+   buf->size -= size;
+}
+
+/* Appends a response header and makes room for its payload,
+ * which the caller writes to the returned pointer. */
+static uint8_t *cmd_binary_respond(struct cmd_binary_client *client,
+      enum cmd_binary_status status, unsigned tag, size_t size)
+{
+   uint8_t *header = cmd_binary_buffer_reserve(&client->out,
+         CMD_BINARY_HEADER_SIZE + size);
+
+   if (!header)
+      return NULL;
+
+   cmd_binary_write_u32(header, size);
+   header[4] = status;
+   header[5] = status >> 8;
+   header[6] = tag;
+   header[7] = tag >> 8;
+
+   client->out.size += CMD_BINARY_HEADER_SIZE + size;
+   return header + CMD_BINARY_HEADER_SIZE;
+}
+
+/* Finds @size bytes at @offset of memory @id, or returns NULL. */
+static uint8_t *cmd_binary_memory(uint32_t id, uint32_t offset, size_t size)
+{
+   uint8_t *data = (uint8_t*)pretro_get_memory_data(id);
+   size_t total  = pretro_get_memory_size(id);
+
+   if (!data || offset > total || size > total - offset)
+      return NULL;
+   return data + offset;
+}
+
+static bool cmd_binary_handle(cmd_binary_t *bin,
+      struct cmd_binary_client *client, unsigned op, unsigned tag,
+      const uint8_t *payload, size_t size)
+{
+   uint8_t *out = NULL;
+
+   switch (op)
+   {
+      case CMD_BINARY_OP_PING:
+         if (!(out = cmd_binary_respond(client,
+                     CMD_BINARY_STATUS_OK, tag, size)))
+            return false;
+         memcpy(out, payload, size);
+         return true;
+
+      case CMD_BINARY_OP_COMMAND:
+         {
+            char cmd[CMD_BINARY_MAX_TEXT];
+            enum cmd_binary_status status = CMD_BINARY_STATUS_BAD_REQUEST;
+
+            if (size < sizeof(cmd))
+            {
+               memcpy(cmd, payload, size);
+               cmd[size] = '\0';
+               status    = bin->text_cb(bin->text_data, cmd) ?
+                  CMD_BINARY_STATUS_OK : CMD_BINARY_STATUS_FAILED;
+            }
+
+            return cmd_binary_respond(client, status, tag, 0) != NULL;
+         }
+
+      case CMD_BINARY_OP_SAVE_STATE:
+         {
+            size_t state_size = pretro_serialize_size();
+
+            if (!state_size)
+               return cmd_binary_respond(client,
+                     CMD_BINARY_STATUS_UNSUPPORTED, tag, 0) != NULL;
+
+            if (!(out = cmd_binary_respond(client,
+                        CMD_BINARY_STATUS_OK, tag, state_size)))
+               return false;
+
+            if (!pretro_serialize(out, state_size))
+            {
+               /* Take the response back. */
+               client->out.size -= CMD_BINARY_HEADER_SIZE + state_size;
+               return cmd_binary_respond(client,
+                     CMD_BINARY_STATUS_FAILED, tag, 0) != NULL;
+            }
+            return true;
+         }
+
+      case CMD_BINARY_OP_LOAD_STATE:
+         return cmd_binary_respond(client,
+               pretro_unserialize(payload, size) ?
+               CMD_BINARY_STATUS_OK : CMD_BINARY_STATUS_FAILED,
+               tag, 0) != NULL;
+
+      case CMD_BINARY_OP_READ_MEMORY:
+         {
+            uint8_t *memory;
+            uint32_t length;
+
+            if (size != 12)
+               break;
+
+            length = cmd_binary_read_u32(payload + 8);
+            memory = cmd_binary_memory(cmd_binary_read_u32(payload),
+                  cmd_binary_read_u32(payload + 4), length);
+
+            if (!memory)
+               return cmd_binary_respond(client,
+                     CMD_BINARY_STATUS_UNSUPPORTED, tag, 0) != NULL;
+
+            if (!(out = cmd_binary_respond(client,
+                        CMD_BINARY_STATUS_OK, tag, length)))
+               return false;
+            memcpy(out, memory, length);
+            return true;
+         }
+
+      case CMD_BINARY_OP_WRITE_MEMORY:
+         {
+            uint8_t *memory;
+
+            if (size < 8)
+               break;
+
+            memory = cmd_binary_memory(cmd_binary_read_u32(payload),
+                  cmd_binary_read_u32(payload + 4), size - 8);
+
+            if (!memory)
+               return cmd_binary_respond(client,
+                     CMD_BINARY_STATUS_UNSUPPORTED, tag, 0) != NULL;
+
+            memcpy(memory, payload + 8, size - 8);
+            return cmd_binary_respond(client,
+                  CMD_BINARY_STATUS_OK, tag, 0) != NULL;
+         }
+
+      default:
+         return cmd_binary_respond(client,
+               CMD_BINARY_STATUS_UNKNOWN_OP, tag, 0) != NULL;
+   }
+
+   return cmd_binary_respond(client,
+         CMD_BINARY_STATUS_BAD_REQUEST, tag, 0) != NULL;
+}
+
+/* Receives what arrived, and handles all complete requests.
+ * Returns false if the client is gone. */
+static bool cmd_binary_receive(cmd_binary_t *bin,
+      struct cmd_binary_client *client)
+{
+   size_t pos = 0;
+
+   for (;;)
+   {
+      ssize_t ret;
+      uint8_t *data = cmd_binary_buffer_reserve(&client->in, 64 * 1024);
+
+      if (!data)
+         return false;
+
+      ret = recv(client->fd, (char*)data,
+            client->in.capacity - client->in.size, 0);
+
+      if (ret == 0)
+         return false;
+      if (ret < 0)
+      {
+         if (isagain(ret))
+            break;
+         return false;
+      }
+
+      client->in.size += ret;
+   }
+
+   while (client->in.size - pos >= CMD_BINARY_HEADER_SIZE)
+   {
+      const uint8_t *header = client->in.data + pos;
+      uint32_t size         = cmd_binary_read_u32(header);
+
+      if (size > CMD_BINARY_MAX_PAYLOAD)
+      {
+         RARCH_ERR("Binary command of %u bytes is too big.\n", size);
+         return false;
+      }
+
+      if (client->in.size - pos - CMD_BINARY_HEADER_SIZE < size)
+         break;
+
+      if (!cmd_binary_handle(bin, client, header[4] | (header[5] << 8),
+               header[6] | (header[7] << 8),
+               header + CMD_BINARY_HEADER_SIZE, size))
+         return false;
+
+      pos += CMD_BINARY_HEADER_SIZE + size;
+   }
+
+   cmd_binary_buffer_consume(&client->in, pos);
+   return true;
+}
+
+/* Sends what can be sent without blocking.
+ * Returns false if the client is gone. */
+static bool cmd_binary_send(struct cmd_binary_client *client)
+{
+   size_t pos = 0;
+
+   while (pos < client->out.size)
+   {
+      ssize_t ret = send(client->fd, (const char*)client->out.data + pos,
+            client->out.size - pos, MSG_NOSIGNAL);
+
+      if (ret < 0)
+      {
+         if (isagain(ret))
+            break;
+         return false;
+      }
+
+      pos += ret;
+   }
+
+   cmd_binary_buffer_consume(&client->out, pos);
+   return true;
+}
+
+static void cmd_binary_accept(cmd_binary_t *bin, int listen_fd)
+{
+   for (;;)
+   {
+      struct cmd_binary_client *client = NULL;
+      int fd = accept(listen_fd, NULL, NULL);
+
+      if (fd < 0)
+         return;
+
+      if (bin->clients_count == CMD_BINARY_MAX_CLIENTS
+            || !socket_nonblock(fd))
+      {
+         RARCH_WARN("Refused binary command client.\n");
+         socket_close(fd);
+         continue;
+      }
+
+      client = &bin->clients[bin->clients_count++];
+      memset(client, 0, sizeof(*client));
+      client->fd = fd;
+   }
+}
+
+static void cmd_binary_close(cmd_binary_t *bin, unsigned i)
+{
+   struct cmd_binary_client *client = &bin->clients[i];
+
+   socket_close(client->fd);
+   free(client->in.data);
+   free(client->out.data);
+
+   *client = bin->clients[--bin->clients_count];
+}
+
+void cmd_binary_poll(cmd_binary_t *bin)
+{
+   unsigned i;
+
+   if (bin->tcp_fd >= 0)
+      cmd_binary_accept(bin, bin->tcp_fd);
+   if (bin->unix_fd >= 0)
+      cmd_binary_accept(bin, bin->unix_fd);
+
+   for (i = 0; i < bin->clients_count; )
+   {
+      struct cmd_binary_client *client = &bin->clients[i];
+
+      if (!cmd_binary_receive(bin, client) || !cmd_binary_send(client))
+      {
+         cmd_binary_close(bin, i);
+         continue;
+      }
+
+      i++;
+   }
+}
+
+static int cmd_binary_listen_tcp(uint16_t port)
+{
+   char port_buf[16];
+   struct addrinfo hints, *res = NULL;
+   int yes = 1;
+   int fd  = -1;
+
+   memset(&hints, 0, sizeof(hints));
+#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
+   hints.ai_family   = AF_INET;
+#else
+   hints.ai_family   = AF_UNSPEC;
+#endif
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags    = AI_PASSIVE;
+
+   snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
+   if (getaddrinfo_rarch(NULL, port_buf, &hints, &res) < 0)
+      return -1;
+
+   fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+   if (fd < 0)
+      goto error;
+
+   setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(int));
+   if (bind(fd, res->ai_addr, res->ai_addrlen) < 0
+         || listen(fd, CMD_BINARY_MAX_CLIENTS) < 0
+         || !socket_nonblock(fd))
+      goto error;
+
+   freeaddrinfo_rarch(res);
+   return fd;
+
+error:
+   RARCH_ERR("Failed to listen for binary commands on port %hu.\n",
+         (unsigned short)port);
+   if (fd >= 0)
+      socket_close(fd);
+   freeaddrinfo_rarch(res);
+   return -1;
+}
+
+#ifdef HAVE_UNIX_SOCKET
+static int cmd_binary_listen_unix(const char *path)
+{
+   struct sockaddr_un addr;
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+   if (fd < 0)
+      return -1;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+   /* Left behind by an earlier run. */
+   unlink(path);
+
+   if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+         || listen(fd, CMD_BINARY_MAX_CLIENTS) < 0
+         || !socket_nonblock(fd))
+   {
+      RARCH_ERR("Failed to listen for binary commands on \"%s\".\n", path);
+      socket_close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+#endif
+
+cmd_binary_t *cmd_binary_new(uint16_t port, const char *socket_path,
+      cmd_binary_text_cb_t text_cb, void *data)
+{
+   cmd_binary_t *bin = (cmd_binary_t*)calloc(1, sizeof(*bin));
+
+   if (!bin)
+      return NULL;
+
+   bin->tcp_fd    = -1;
+   bin->unix_fd   = -1;
+   bin->text_cb   = text_cb;
+   bin->text_data = data;
+
+   if (!network_init())
+      goto error;
+
+   if (port)
+   {
+      if ((bin->tcp_fd = cmd_binary_listen_tcp(port)) < 0)
+         goto error;
+      RARCH_LOG("Listening for binary commands on port %hu.\n",
+            (unsigned short)port);
+   }
+
+   if (socket_path && *socket_path)
+   {
+#ifdef HAVE_UNIX_SOCKET
+      if ((bin->unix_fd = cmd_binary_listen_unix(socket_path)) < 0)
+         goto error;
+      strlcpy(bin->unix_path, socket_path, sizeof(bin->unix_path));
+      RARCH_LOG("Listening for binary commands on \"%s\".\n", socket_path);
+#else
+      RARCH_WARN("Unix domain sockets are not supported here.\n");
+#endif
+   }
+
+   if (bin->tcp_fd < 0 && bin->unix_fd < 0)
+      goto error;
+
+   return bin;
+
+error:
+   cmd_binary_free(bin);
+   return NULL;
+}
+
+void cmd_binary_free(cmd_binary_t *bin)
+{
+   if (!bin)
+      return;
+
+   while (bin->clients_count)
+      cmd_binary_close(bin, 0);
+
+   if (bin->tcp_fd >= 0)
+      socket_close(bin->tcp_fd);
+
+   if (bin->unix_fd >= 0)
+   {
+      socket_close(bin->unix_fd);
+#ifdef HAVE_UNIX_SOCKET
+      unlink(bin->unix_path);
+#endif
+   }
+
+   free(bin);
+}
@@ -0,0 +1,106 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_COMMAND_BINARY_H
+#define __RARCH_COMMAND_BINARY_H
+
+#include <stdint.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Binary command protocol, over TCP and Unix domain sockets.
+ *
+ * Every request is an 8 byte header followed by its payload:
+ *    uint32 payload size, uint16 op, uint16 tag
+ * and gets a response of the same form:
+ *    uint32 payload size, uint16 status, uint16 tag
+ * All numbers are little endian. The tag is the client's own,
+ * and is sent back as is.
+ *
+ * Requests can be sent back to back without waiting for the
+ * responses. All requests which arrived by the time a frame
+ * starts are handled before it, in order, and their responses
+ * are sent together. */
+
+enum cmd_binary_op
+{
+   /* Responds with the payload. */
+   CMD_BINARY_OP_PING = 1,
+   /* Payload is a text command, like the network command
+    * interface takes: a hotkey name, or a command and its
+    * argument. */
+   CMD_BINARY_OP_COMMAND,
+   /* Responds with the core's serialized state. */
+   CMD_BINARY_OP_SAVE_STATE,
+   /* Payload is a serialized state to load. */
+   CMD_BINARY_OP_LOAD_STATE,
+   /* Payload is uint32 memory id (RETRO_MEMORY_*), uint32 offset
+    * and uint32 size. Responds with that part of the memory. */
+   CMD_BINARY_OP_READ_MEMORY,
+   /* Payload is uint32 memory id and uint32 offset, followed by
+    * the bytes to write there. */
+   CMD_BINARY_OP_WRITE_MEMORY
+};
+
+enum cmd_binary_status
+{
+   CMD_BINARY_STATUS_OK = 0,
+   CMD_BINARY_STATUS_UNKNOWN_OP,
+   CMD_BINARY_STATUS_BAD_REQUEST,
+   CMD_BINARY_STATUS_FAILED,
+   /* The core doesn't support it, or has no such memory. */
+   CMD_BINARY_STATUS_UNSUPPORTED
+};
+
+typedef struct cmd_binary cmd_binary_t;
+
+/* Runs a text command for CMD_BINARY_OP_COMMAND. */
+typedef bool (*cmd_binary_text_cb_t)(void *data, const char *cmd);
+
+/**
+ * cmd_binary_new:
+ * @port                 : TCP port to listen on, or 0.
+ * @socket_path          : Unix domain socket to listen on, or NULL
+ *                         or empty.
+ * @text_cb              : Runs text commands.
+ * @data                 : Passed to @text_cb.
+ *
+ * Returns: the server if it listens on at least one of them,
+ * otherwise NULL.
+ **/
+cmd_binary_t *cmd_binary_new(uint16_t port, const char *socket_path,
+      cmd_binary_text_cb_t text_cb, void *data);
+
+void cmd_binary_free(cmd_binary_t *bin);
+
+/**
+ * cmd_binary_poll:
+ * @bin                  : Server.
+ *
+ * Accepts new clients, handles the requests which arrived and
+ * sends what it can of the responses, without blocking. Has to be
+ * called outside of the core's retro_run().
+ **/
+void cmd_binary_poll(cmd_binary_t *bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
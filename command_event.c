@@ -19,6 +19,7 @@
 #include "runloop.h"
 #include "dynamic.h"
 #include "content.h"
+#include "runahead.h"
 #include "screenshot.h"
 #include "intl/intl.h"
 #include "retroarch.h"
@@ -27,6 +28,16 @@
 #include <file/dir_list.h>
 
 #include "input/input_remapping.h"
+#include "input/input_latency.h"
+#include "cheat_search.h"
+
+#ifdef HAVE_SHM
+#include "shm_export.h"
+#endif
+
+#ifdef HAVE_THREADS
+#include "audio/audio_thread_wrapper.h"
+#endif
 
 #ifdef HAVE_MENU
 #include "menu/menu.h"
@@ -48,7 +59,9 @@ static void event_init_command(void)
    driver_t *driver     = driver_get_ptr();
    settings_t *settings = config_get_ptr();
 
-   if (!settings->stdin_cmd_enable && !settings->network_cmd_enable)
+   if (!settings->stdin_cmd_enable && !settings->network_cmd_enable
+         && !settings->network_cmd_binary_port
+         && !*settings->network_cmd_binary_socket)
       return;
 
    if (settings->stdin_cmd_enable && driver->stdin_claimed)
@@ -60,7 +73,19 @@ static void event_init_command(void)
    if (!(driver->command = rarch_cmd_new(settings->stdin_cmd_enable
                && !driver->stdin_claimed,
                settings->network_cmd_enable, settings->network_cmd_port)))
+   {
       RARCH_ERR("Failed to initialize command interface.\n");
+      return;
+   }
+
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   if ((settings->network_cmd_binary_port
+            || *settings->network_cmd_binary_socket)
+         && !rarch_cmd_listen_binary(driver->command,
+            settings->network_cmd_binary_port,
+            settings->network_cmd_binary_socket))
+      RARCH_ERR("Failed to initialize binary command interface.\n");
+#endif
 }
 #endif
 
@@ -485,8 +510,18 @@ static void event_deinit_core(bool reinit)
 {
    global_t *global = global_get_ptr();
    
+   input_latency_free();
+   cheat_search_deinit();
+#ifdef HAVE_SHM
+   shm_export_free();
+#endif
+
+   runahead_deinit();
    pretro_unload_game();
    pretro_deinit();
+   retro_coroutine_deinit();
+
+   content_state_buffer_free();
 
    if (reinit)
       event_command(EVENT_CMD_DRIVERS_DEINIT);
@@ -622,6 +657,7 @@ static void event_set_savestate_auto_index(void)
 
 static bool event_init_content(void)
 {
+   bool ret;
    global_t *global = global_get_ptr();
 
    /* No content to be loaded for dummy core,
@@ -632,7 +668,11 @@ static bool event_init_content(void)
    if (!global->libretro_no_content)
       rarch_fill_pathnames();
 
-   if (!init_content_file())
+   RARCH_TRACE_BEGIN("init_content_file");
+   ret = init_content_file();
+   RARCH_TRACE_END("init_content_file");
+
+   if (!ret)
       return false;
 
    if (global->libretro_no_content)
@@ -670,6 +710,9 @@ static bool event_init_core(void)
       config_load_remap();
 
    rarch_verify_api_version();
+
+   /* Inflate zipped content while the core initializes. */
+   content_extract_start();
    pretro_init();
 
    global->use_sram = !global->libretro_dummy &&
@@ -681,6 +724,15 @@ static bool event_init_core(void)
    retro_init_libretro_cbs(&driver->retro_ctx);
    rarch_init_system_av_info();
 
+   if (*settings->input.latency_log_path)
+      input_latency_init(settings->input.latency_log_path,
+            settings->input.latency_flash_enable);
+
+#ifdef HAVE_SHM
+   if (*settings->shm_export_name)
+      shm_export_init(settings->shm_export_name);
+#endif
+
    return true;
 }
 
@@ -829,8 +881,24 @@ static bool event_save_core_config(void)
 static void event_save_state(const char *path,
       char *msg, size_t sizeof_msg)
 {
+   char done_msg[PATH_MAX_LENGTH];
    settings_t *settings = config_get_ptr();
 
+   if (settings->state_slot < 0)
+      snprintf(done_msg, sizeof(done_msg),
+            "Saved state to slot #-1 (auto).");
+   else
+      snprintf(done_msg, sizeof(done_msg),
+            "Saved state to slot #%d.", settings->state_slot);
+
+   /* The data runloop posts done_msg once the write has finished. */
+   if (settings->savestate_async_write && save_state_async(path, done_msg))
+   {
+      snprintf(msg, sizeof_msg, "Saving state to slot #%d...",
+            settings->state_slot);
+      return;
+   }
+
    if (!save_state(path))
    {
       snprintf(msg, sizeof_msg,
@@ -838,12 +906,7 @@ static void event_save_state(const char *path,
       return;
    }
 
-   if (settings->state_slot < 0)
-      snprintf(msg, sizeof_msg,
-            "Saved state to slot #-1 (auto).");
-   else
-      snprintf(msg, sizeof_msg,
-            "Saved state to slot #%d.", settings->state_slot);
+   strlcpy(msg, done_msg, sizeof_msg);
 }
 
 /**
@@ -1203,17 +1266,33 @@ bool event_command(enum event_command cmd)
          if (!global)
             break;
 
+#ifdef HAVE_THREADS
+         audio_thread_dsp_lock();
+#endif
          if (global->audio_data.dsp)
             rarch_dsp_filter_free(global->audio_data.dsp);
          global->audio_data.dsp = NULL;
+#ifdef HAVE_THREADS
+         audio_thread_dsp_unlock();
+#endif
          break;
       case EVENT_CMD_DSP_FILTER_INIT:
          event_command(EVENT_CMD_DSP_FILTER_DEINIT);
          if (!*settings->audio.dsp_plugin)
             break;
 
-         global->audio_data.dsp = rarch_dsp_filter_new(
-               settings->audio.dsp_plugin, global->audio_data.in_rate);
+         {
+            rarch_dsp_filter_t *dsp = rarch_dsp_filter_new(
+                  settings->audio.dsp_plugin, global->audio_data.in_rate);
+
+#ifdef HAVE_THREADS
+            audio_thread_dsp_lock();
+#endif
+            global->audio_data.dsp = dsp;
+#ifdef HAVE_THREADS
+            audio_thread_dsp_unlock();
+#endif
+         }
          if (!global->audio_data.dsp)
             RARCH_ERR("[DSP]: Failed to initialize DSP filter \"%s\".\n",
                   settings->audio.dsp_plugin);
@@ -1264,7 +1343,11 @@ bool event_command(enum event_command cmd)
          event_command(EVENT_CMD_CORE_INFO_DEINIT);
 
          if (*settings->libretro_directory)
+         {
+            RARCH_TRACE_BEGIN("core_info_list_new");
             global->core_info = core_info_list_new(settings->libretro_directory);
+            RARCH_TRACE_END("core_info_list_new");
+         }
          break;
       case EVENT_CMD_CORE_DEINIT:
          event_deinit_core(true);
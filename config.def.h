@@ -54,6 +54,7 @@ enum
    AUDIO_ROAR,
    AUDIO_AL,
    AUDIO_SL,
+   AUDIO_AAUDIO,
    AUDIO_JACK,
    AUDIO_SDL,
    AUDIO_SDL2,
@@ -61,6 +62,7 @@ enum
    AUDIO_PULSE,
    AUDIO_EXT,
    AUDIO_DSOUND,
+   AUDIO_WASAPI,
    AUDIO_COREAUDIO,
    AUDIO_PS3,
    AUDIO_XENON360,
@@ -185,6 +187,8 @@ enum
 #define AUDIO_DEFAULT_DRIVER AUDIO_COREAUDIO
 #elif defined(HAVE_AL)
 #define AUDIO_DEFAULT_DRIVER AUDIO_AL
+#elif defined(HAVE_AAUDIO)
+#define AUDIO_DEFAULT_DRIVER AUDIO_AAUDIO
 #elif defined(HAVE_SL)
 #define AUDIO_DEFAULT_DRIVER AUDIO_SL
 #elif defined(HAVE_DSOUND)
@@ -383,6 +387,11 @@ static const bool disable_composition = false;
 /* Video VSYNC (recommended) */
 static const bool vsync = true;
 
+/* For displays with variable refresh rate (FreeSync, G-Sync).
+ * Frames are presented as soon as they are ready, paced by
+ * RetroArch at exactly the core's frame rate. */
+static const bool vrr_enable = false;
+
 /* Attempts to hard-synchronize CPU and GPU.
  * Can reduce latency at cost of performance. */
 static const bool hard_sync = false;
@@ -394,11 +403,30 @@ static const bool hard_sync = false;
  */
 static const unsigned hard_sync_frames = 0;
 
+/* Lets hard GPU sync run up to 3 frames ahead when syncing 
+ * to hard_sync_frames makes frames miss VSync, and goes back 
+ * to hard_sync_frames once they are on time again.
+ */
+static const bool hard_sync_adaptive = false;
+
+/* Sets how many images the video driver may have in flight,
+ * counting the one on screen. More than 2 lets the next frame be
+ * written while a flip is still pending, at the cost of latency.
+ * Only used by the dispmanx driver for now.
+ */
+static const unsigned max_swapchain_images = 3;
+
 /* Sets how many milliseconds to delay after VSync before running the core.
  * Can reduce latency at cost of higher risk of stuttering.
  */
 static const unsigned frame_delay = 0;
 
+/* Picks the frame delay automatically from how long the core 
+ * takes to run a frame, so it runs as late as possible before VSync.
+ * Overrides frame_delay.
+ */
+static const bool frame_delay_auto = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated 
  * ghosting. video_refresh_rate should still be configured as if it 
@@ -406,6 +434,12 @@ static const unsigned frame_delay = 0;
  */
 static bool black_frame_insertion = false;
 
+/* KMS context only. Retimes the display mode to the refresh rate
+ * of the core, e.g. to drive a CRT at the rate of the original
+ * hardware.
+ */
+static const bool kms_match_core_refresh = false;
+
 /* Uses a custom swap interval for VSync.
  * Set this to effectively halve monitor refresh rate.
  */
@@ -425,6 +459,12 @@ static const bool threaded_data_runloop_enable = false;
 /* Set to true if HW render cores should get their private context. */
 static const bool video_shared_context = false;
 
+/* Uploads only the rows of software rendered frames which changed.
+ * Saves bandwidth with mostly static frames, at the cost of
+ * comparing every frame to the last one on the CPU.
+ */
+static const bool video_dirty_rows = false;
+
 /* Sets GC/Wii screen width. */
 static const unsigned video_viwidth = 640;
 
@@ -478,6 +518,10 @@ static bool default_block_config_read = true;
 
 static bool collapse_subgroups_enable = true;
 static bool show_advanced_settings    = true;
+
+/* Keeps the last menu frame on screen while nothing changes,
+ * instead of redrawing it every frame. */
+static bool menu_throttle             = true;
 static const uint32_t menu_entry_normal_color = 0xffffffff;
 static const uint32_t menu_entry_hover_color  = 0xff64ff64;
 static const uint32_t menu_title_color        = 0xff64ff64;
@@ -566,9 +610,21 @@ static const char *audio_device = NULL;
  * if driver can't provide given latency. */
 static const int out_latency = 64;
 
+/* Lets the audio driver take the device for itself and skip the
+ * system mixer where it can (WASAPI exclusive mode, ALSA mmap). */
+static const bool audio_exclusive_mode = false;
+
 /* Will sync audio. (recommended) */
 static const bool audio_sync = true;
 
+/* Opens the audio device when content first runs instead of 
+ * at startup, so the menu comes up sooner. */
+static const bool audio_lazy_init = false;
+
+/* Runs the DSP filter, resampler and audio driver writes
+ * on an audio thread instead of the emulation thread. */
+static const bool audio_threaded_dsp = false;
+
 /* Audio rate control. */
 #if defined(GEKKO) || !defined(RARCH_CONSOLE)
 static const bool rate_control = true;
@@ -580,10 +636,19 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Show driver buffer fill, rate control adjustment and 
+ * underrun/overrun counts on screen. */
+static const bool audio_show_stats = false;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
 
+/* Audio resampler quality level. Higher levels cost more CPU
+ * but give a better SNR. Only honored by the sinc resampler. 
+ * RESAMPLER_QUALITY_DONTCARE will use the build default. */
+static const unsigned audio_resampler_quality = RESAMPLER_QUALITY_DONTCARE;
+
 /* Default audio volume in dB. (0.0 dB == unity gain). */
 static const float audio_volume = 0.0;
 
@@ -592,6 +657,9 @@ static const float audio_volume = 0.0;
 /* Enables displaying the current frames per second. */
 static const bool fps_show = false;
 
+/* Enables displaying a graph of the frame times. */
+static const bool frame_time_graph_show = false;
+
 /* Enables use of rewind. This will incur some memory footprint 
  * depending on the save state buffer. */
 static const bool rewind_enable = false;
@@ -603,6 +671,33 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Maximum number of states to rewind per frame. More than one 
+ * gives faster rewinding, as far as the frame time allows. */
+static const unsigned rewind_speed = 1;
+
+/* Generates rewind deltas on a separate thread, so the main 
+ * thread doesn't stall on big savestates. */
+static const bool rewind_threaded = false;
+
+/* Rewind history older than this many seconds is deflated to 
+ * fit more of it in the rewind buffer. 0 disables it. */
+static const unsigned rewind_cold_after = 0;
+
+/* Stores a full savestate in the rewind buffer every this many 
+ * seconds, which allows jumping far back in one go 
+ * (REWIND_SEEK command). 0 disables it. */
+static const unsigned rewind_keyframe_interval = 0;
+
+/* Runs the core this many frames ahead and rolls it back every 
+ * frame, which hides as many frames of the game's own input lag. 
+ * Needs a core that can save states. 0 disables it. */
+static const unsigned run_ahead_frames = 0;
+
+/* Runs ahead on a second instance of the core instead of rolling 
+ * back the main one, for cores that misbehave when states are 
+ * loaded all the time. Takes effect when content is loaded. */
+static const bool run_ahead_secondary_instance = false;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = false;
 
@@ -614,6 +709,15 @@ static const unsigned autosave_interval = 0;
  * user 1 rather than user 2. */
 static const bool netplay_client_swap_input = true;
 
+/* When hosting netplay, send a checksum of the savestate every 
+ * this many frames, so clients that desynced resync with the host.
+ * A value of 0 disables desync detection. */
+static const unsigned netplay_check_frames = 60;
+
+/* Show round trip time, jitter, packet loss and stalls 
+ * of netplay on screen. */
+static const bool netplay_show_stats = false;
+
 /* On save state load, block SRAM from being overwritten.
  * This could potentially lead to buggy games. */
 static const bool block_sram_overwrite = false;
@@ -624,6 +728,19 @@ static const bool block_sram_overwrite = false;
  * to the highest existing value. */
 static const bool savestate_auto_index = false;
 
+/* Serialize savestates into memory and write them out
+ * from the data runloop, instead of blocking the main loop
+ * until the file has hit the disk. */
+static const bool savestate_async_write = false;
+
+/* Deflate savestates into a compressed container.
+ * Loading detects compressed states automatically. */
+static const bool savestate_compression = false;
+
+/* With savestate_compression, store slots other than slot 0
+ * as a delta against the state in slot 0. */
+static const bool savestate_delta = false;
+
 /* Automatically saves a savestate at the end of RetroArch's lifetime.
  * The path is $SRAM_PATH.auto.
  * RetroArch will automatically load any savestate with this path on 
@@ -640,9 +757,16 @@ static const float fastforward_ratio = 1.0;
 /* Throttle fast forward. */
 static const bool fastforward_ratio_throttle_enable = false;
 
+/* Skip video and audio of fast forwarded frames 
+ * which come faster than the display can show them. */
+static const bool fastforward_frameskip = true;
+
 /* Enable stdin/network command interface. */
 static const bool network_cmd_enable = false;
 static const uint16_t network_cmd_port = 55355;
+
+/* TCP port of the binary command protocol, 0 to disable. */
+static const uint16_t network_cmd_binary_port = 0;
 static const bool stdin_cmd_enable = false;
 
 /* Number of entries that will be kept in content history playlist file. */
@@ -672,6 +796,15 @@ static const unsigned turbo_duty_cycle = 3;
  * gamepads, plug-and-play style. */
 static const bool input_autodetect_enable = true;
 
+/* Holds back the input poll a core asks for until the core
+ * first reads input, so it sees the freshest input. */
+static const bool input_poll_late = false;
+
+/* Runs the core on a coroutine and suspends it when it polls 
+ * input, so that the frame delay is spent there instead of 
+ * before the frame. Needs libco. */
+static const bool input_poll_yield = false;
+
 /* Show the input descriptors set by the core instead 
  * of the default ones. */
 static const bool input_descriptor_label_show = true;
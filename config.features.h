@@ -176,6 +176,12 @@ static const bool _dsound_supp = true;
 static const bool _dsound_supp = false;
 #endif
 
+#ifdef HAVE_WASAPI
+static const bool _wasapi_supp = true;
+#else
+static const bool _wasapi_supp = false;
+#endif
+
 #ifdef HAVE_XAUDIO
 static const bool _xaudio_supp = true;
 #else
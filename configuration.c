@@ -93,12 +93,16 @@ const char *config_get_default_audio(void)
          return "openal";
       case AUDIO_SL:
          return "opensl";
+      case AUDIO_AAUDIO:
+         return "aaudio";
       case AUDIO_SDL:
          return "sdl";
       case AUDIO_SDL2:
          return "sdl2";
       case AUDIO_DSOUND:
          return "dsound";
+      case AUDIO_WASAPI:
+         return "wasapi";
       case AUDIO_XAUDIO:
          return "xaudio";
       case AUDIO_PULSE:
@@ -453,10 +457,15 @@ static void config_set_defaults(void)
    settings->video.fullscreen_y          = fullscreen_y;
    settings->video.disable_composition   = disable_composition;
    settings->video.vsync                 = vsync;
+   settings->video.vrr_enable            = vrr_enable;
    settings->video.hard_sync             = hard_sync;
    settings->video.hard_sync_frames      = hard_sync_frames;
+   settings->video.max_swapchain_images  = max_swapchain_images;
+   settings->video.hard_sync_adaptive    = hard_sync_adaptive;
    settings->video.frame_delay           = frame_delay;
+   settings->video.frame_delay_auto      = frame_delay_auto;
    settings->video.black_frame_insertion = black_frame_insertion;
+   settings->video.kms_match_core_refresh = kms_match_core_refresh;
    settings->video.swap_interval         = swap_interval;
    settings->video.threaded              = video_threaded;
 
@@ -467,6 +476,7 @@ static void config_set_defaults(void)
    settings->menu.threaded_data_runloop_enable = threaded_data_runloop_enable;
 #endif
    settings->video.shared_context              = video_shared_context;
+   settings->video.dirty_rows                  = video_dirty_rows;
    settings->video.force_srgb_disable          = false;
 #ifdef GEKKO
    settings->video.viwidth                     = video_viwidth;
@@ -514,9 +524,14 @@ static void config_set_defaults(void)
       g_defaults.settings.out_latency          = out_latency;
 
    settings->audio.latency                     = g_defaults.settings.out_latency;
+   settings->audio.exclusive_mode              = audio_exclusive_mode;
    settings->audio.sync                        = audio_sync;
+   settings->audio.lazy_init                   = audio_lazy_init;
+   settings->audio.threaded_dsp                = audio_threaded_dsp;
    settings->audio.rate_control                = rate_control;
    settings->audio.rate_control_delta          = rate_control_delta;
+   settings->audio.show_stats                  = audio_show_stats;
+   settings->audio.resampler_quality           = audio_resampler_quality;
    settings->audio.max_timing_skew             = max_timing_skew;
    settings->audio.volume                      = audio_volume;
    global->audio_data.volume_gain              = db_to_gain(settings->audio.volume);
@@ -524,19 +539,33 @@ static void config_set_defaults(void)
    settings->rewind_enable                     = rewind_enable;
    settings->rewind_buffer_size                = rewind_buffer_size;
    settings->rewind_granularity                = rewind_granularity;
+   settings->rewind_speed                      = rewind_speed;
+   settings->rewind_threaded                   = rewind_threaded;
+   settings->rewind_cold_after                 = rewind_cold_after;
+   settings->rewind_keyframe_interval          = rewind_keyframe_interval;
+   settings->run_ahead_frames                  = run_ahead_frames;
+   settings->run_ahead_secondary_instance      = run_ahead_secondary_instance;
    settings->slowmotion_ratio                  = slowmotion_ratio;
    settings->fastforward_ratio                 = fastforward_ratio;
    settings->fastforward_ratio_throttle_enable = fastforward_ratio_throttle_enable;
+   settings->fastforward_frameskip             = fastforward_frameskip;
+   settings->frame_time_graph_show             = frame_time_graph_show;
    settings->pause_nonactive                   = pause_nonactive;
    settings->autosave_interval                 = autosave_interval;
 
    settings->block_sram_overwrite = block_sram_overwrite;
    settings->savestate_auto_index = savestate_auto_index;
+   settings->savestate_async_write = savestate_async_write;
+   settings->savestate_compression = savestate_compression;
+   settings->savestate_delta = savestate_delta;
    settings->savestate_auto_save  = savestate_auto_save;
    settings->savestate_auto_load  = savestate_auto_load;
    settings->network_cmd_enable   = network_cmd_enable;
    settings->network_cmd_port     = network_cmd_port;
+   settings->network_cmd_binary_port = network_cmd_binary_port;
+   *settings->network_cmd_binary_socket = '\0';
    settings->stdin_cmd_enable     = stdin_cmd_enable;
+   *settings->shm_export_name     = '\0';
    settings->content_history_size = default_content_history_size;
    settings->libretro_log_level   = libretro_log_level;
 
@@ -550,6 +579,7 @@ static void config_set_defaults(void)
    *settings->menu.wallpaper                        = '\0';
    settings->menu.collapse_subgroups_enable         = collapse_subgroups_enable;
    settings->menu.show_advanced_settings            = show_advanced_settings;
+   settings->menu.throttle                          = menu_throttle;
    settings->menu.entry_normal_color                = menu_entry_normal_color;
    settings->menu.entry_hover_color                 = menu_entry_hover_color;
    settings->menu.title_color                       = menu_title_color;
@@ -604,6 +634,8 @@ static void config_set_defaults(void)
 
    settings->input.axis_threshold = axis_threshold;
    settings->input.netplay_client_swap_input = netplay_client_swap_input;
+   settings->netplay_check_frames = netplay_check_frames;
+   settings->netplay_show_stats = netplay_show_stats;
    settings->input.turbo_period = turbo_period;
    settings->input.turbo_duty_cycle = turbo_duty_cycle;
 
@@ -617,6 +649,8 @@ static void config_set_defaults(void)
    settings->input.overlay_opacity = 0.7f;
    settings->input.overlay_scale = 1.0f;
    settings->input.autodetect_enable = input_autodetect_enable;
+   settings->input.poll_late         = input_poll_late;
+   settings->input.poll_yield        = input_poll_yield;
    *settings->input.keyboard_layout = '\0';
 
    for (i = 0; i < MAX_USERS; i++)
@@ -666,12 +700,16 @@ static void config_set_defaults(void)
    *settings->extraction_directory = '\0';
    *settings->input_remapping_directory = '\0';
    *settings->input.autoconfig_dir = '\0';
+   *settings->input.latency_log_path = '\0';
+   settings->input.latency_flash_enable = false;
    *settings->input.overlay = '\0';
    *settings->core_assets_directory = '\0';
    *settings->assets_directory = '\0';
    *settings->playlist_directory = '\0';
+   *settings->thumbnails_directory = '\0';
    *settings->video.shader_path = '\0';
    *settings->video.shader_dir = '\0';
+   *settings->video.shader_cache_dir = '\0';
    *settings->video.filter_dir = '\0';
    *settings->audio.filter_dir = '\0';
    *settings->video.softfilter_plugin = '\0';
@@ -1177,6 +1215,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE (conf, settings, video.monitor_index, "video_monitor_index");
    CONFIG_GET_BOOL_BASE(conf, settings, video.disable_composition, "video_disable_composition");
    CONFIG_GET_BOOL_BASE(conf, settings, video.vsync, "video_vsync");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.vrr_enable, "video_vrr_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, video.hard_sync, "video_hard_sync");
 
 #ifdef HAVE_MENU
@@ -1193,6 +1232,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, menu.navigation.browser.filter.supported_extensions_enable,   "menu_navigation_browser_filter_supported_extensions_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, menu.collapse_subgroups_enable,   "menu_collapse_subgroups_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, menu.show_advanced_settings,   "menu_show_advanced_settings");
+   CONFIG_GET_BOOL_BASE(conf, settings, menu.throttle,   "menu_throttle");
    CONFIG_GET_HEX_BASE(conf, settings, menu.entry_normal_color,   "menu_entry_normal_color");
    CONFIG_GET_HEX_BASE(conf, settings, menu.entry_hover_color,   "menu_entry_hover_color");
    CONFIG_GET_HEX_BASE(conf, settings, menu.title_color,   "menu_title_color");
@@ -1205,16 +1245,26 @@ static bool config_load_file(const char *path, bool set_defaults)
    if (settings->video.hard_sync_frames > 3)
       settings->video.hard_sync_frames = 3;
 
+   CONFIG_GET_INT_BASE(conf, settings, video.max_swapchain_images, "video_max_swapchain_images");
+   if (settings->video.max_swapchain_images < 2)
+      settings->video.max_swapchain_images = 2;
+   if (settings->video.max_swapchain_images > 4)
+      settings->video.max_swapchain_images = 4;
+   CONFIG_GET_BOOL_BASE(conf, settings, video.hard_sync_adaptive, "video_hard_sync_adaptive");
+
    CONFIG_GET_INT_BASE(conf, settings, video.frame_delay, "video_frame_delay");
    if (settings->video.frame_delay > 15)
       settings->video.frame_delay = 15;
+   CONFIG_GET_BOOL_BASE(conf, settings, video.frame_delay_auto, "video_frame_delay_auto");
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.black_frame_insertion, "video_black_frame_insertion");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.kms_match_core_refresh, "video_kms_match_core_refresh");
    CONFIG_GET_INT_BASE(conf, settings, video.swap_interval, "video_swap_interval");
    settings->video.swap_interval = max(settings->video.swap_interval, 1);
    settings->video.swap_interval = min(settings->video.swap_interval, 4);
    CONFIG_GET_BOOL_BASE(conf, settings, video.threaded, "video_threaded");
    CONFIG_GET_BOOL_BASE(conf, settings, video.shared_context, "video_shared_context");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.dirty_rows, "video_dirty_rows");
 #ifdef GEKKO
    CONFIG_GET_INT_BASE(conf, settings, video.viwidth, "video_viwidth");
    CONFIG_GET_BOOL_BASE(conf, settings, video.vfilter, "video_vfilter");
@@ -1289,6 +1339,10 @@ static bool config_load_file(const char *path, bool set_defaults)
    if (!strcmp(settings->video.shader_dir, "default"))
       *settings->video.shader_dir = '\0';
 
+   config_get_path(conf, "video_shader_cache_dir", settings->video.shader_cache_dir, sizeof(settings->video.shader_cache_dir));
+   if (!strcmp(settings->video.shader_cache_dir, "default"))
+      *settings->video.shader_cache_dir = '\0';
+
    config_get_path(conf, "video_filter_dir", settings->video.filter_dir, sizeof(settings->video.filter_dir));
    if (!strcmp(settings->video.filter_dir, "default"))
       *settings->video.filter_dir = '\0';
@@ -1300,6 +1354,8 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, input.remap_binds_enable, "input_remap_binds_enable");
    CONFIG_GET_FLOAT_BASE(conf, settings, input.axis_threshold, "input_axis_threshold");
    CONFIG_GET_BOOL_BASE(conf, settings, input.netplay_client_swap_input, "netplay_client_swap_input");
+   CONFIG_GET_INT_BASE(conf, settings, netplay_check_frames, "netplay_check_frames");
+   CONFIG_GET_BOOL_BASE(conf, settings, netplay_show_stats, "netplay_show_stats");
    CONFIG_GET_INT_BASE(conf, settings, input.max_users, "input_max_users");
    CONFIG_GET_BOOL_BASE(conf, settings, input.input_descriptor_label_show, "input_descriptor_label_show");
    CONFIG_GET_BOOL_BASE(conf, settings, input.input_descriptor_hide_unbound, "input_descriptor_hide_unbound");
@@ -1349,12 +1405,17 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, audio.block_frames, "audio_block_frames");
    CONFIG_GET_STRING_BASE(conf, settings, audio.device, "audio_device");
    CONFIG_GET_INT_BASE(conf, settings, audio.latency, "audio_latency");
+   CONFIG_GET_BOOL_BASE(conf, settings, audio.exclusive_mode, "audio_exclusive_mode");
    CONFIG_GET_BOOL_BASE(conf, settings, audio.sync, "audio_sync");
+   CONFIG_GET_BOOL_BASE(conf, settings, audio.lazy_init, "audio_lazy_init");
+   CONFIG_GET_BOOL_BASE(conf, settings, audio.threaded_dsp, "audio_threaded_dsp");
    CONFIG_GET_BOOL_BASE(conf, settings, audio.rate_control, "audio_rate_control");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.rate_control_delta, "audio_rate_control_delta");
+   CONFIG_GET_BOOL_BASE(conf, settings, audio.show_stats, "audio_show_stats");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.max_timing_skew, "audio_max_timing_skew");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.volume, "audio_volume");
    CONFIG_GET_STRING_BASE(conf, settings, audio.resampler, "audio_resampler");
+   CONFIG_GET_INT_BASE(conf, settings, audio.resampler_quality, "audio_resampler_quality");
    global->audio_data.volume_gain = db_to_gain(settings->audio.volume);
 
    CONFIG_GET_STRING_BASE(conf, settings, camera.device, "camera_device");
@@ -1367,6 +1428,7 @@ static bool config_load_file(const char *path, bool set_defaults)
 #endif
    CONFIG_GET_STRING_BASE(conf, settings, video.context_driver, "video_context_driver");
    CONFIG_GET_STRING_BASE(conf, settings, audio.driver, "audio_driver");
+   CONFIG_GET_STRING_BASE(conf, settings, record.driver, "record_driver");
    config_get_path(conf, "video_filter", settings->video.softfilter_plugin, sizeof(settings->video.softfilter_plugin));
    config_get_path(conf, "audio_dsp_plugin", settings->audio.dsp_plugin, sizeof(settings->audio.dsp_plugin));
    CONFIG_GET_STRING_BASE(conf, settings, input.driver, "input_driver");
@@ -1390,6 +1452,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, ui.menubar_enable, "ui_menubar_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, ui.suspend_screensaver_enable, "suspend_screensaver_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, fps_show, "fps_show");
+   CONFIG_GET_BOOL_BASE(conf, settings, frame_time_graph_show, "frame_time_graph_show");
    CONFIG_GET_BOOL_BASE(conf, settings, load_dummy_on_core_shutdown, "load_dummy_on_core_shutdown");
 
    config_get_path(conf, "libretro_info_path", settings->libretro_info_path, sizeof(settings->libretro_info_path));
@@ -1421,6 +1484,9 @@ static bool config_load_file(const char *path, bool set_defaults)
       *settings->assets_directory = '\0';
    if (!strcmp(settings->playlist_directory, "default"))
       *settings->playlist_directory = '\0';
+   config_get_path(conf, "thumbnails_directory", settings->thumbnails_directory, sizeof(settings->thumbnails_directory));
+   if (!strcmp(settings->thumbnails_directory, "default"))
+      *settings->thumbnails_directory = '\0';
 #ifdef HAVE_MENU
    config_get_path(conf, "rgui_browser_directory", settings->menu_content_directory, sizeof(settings->menu_content_directory));
    if (!strcmp(settings->menu_content_directory, "default"))
@@ -1467,6 +1533,14 @@ static bool config_load_file(const char *path, bool set_defaults)
       settings->rewind_buffer_size = buffer_size * UINT64_C(1000000);
 
    CONFIG_GET_INT_BASE(conf, settings, rewind_granularity, "rewind_granularity");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_speed, "rewind_speed");
+   CONFIG_GET_BOOL_BASE(conf, settings, rewind_threaded, "rewind_threaded");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_cold_after, "rewind_cold_after");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_keyframe_interval, "rewind_keyframe_interval");
+   CONFIG_GET_INT_BASE(conf, settings, run_ahead_frames, "run_ahead_frames");
+   if (settings->run_ahead_frames > 6)
+      settings->run_ahead_frames = 6;
+   CONFIG_GET_BOOL_BASE(conf, settings, run_ahead_secondary_instance, "run_ahead_secondary_instance");
    CONFIG_GET_FLOAT_BASE(conf, settings, slowmotion_ratio, "slowmotion_ratio");
    if (settings->slowmotion_ratio < 1.0f)
       settings->slowmotion_ratio = 1.0f;
@@ -1479,6 +1553,7 @@ static bool config_load_file(const char *path, bool set_defaults)
       settings->fastforward_ratio = 1.0f;
 
    CONFIG_GET_BOOL_BASE(conf, settings, fastforward_ratio_throttle_enable, "fastforward_ratio_throttle_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, fastforward_frameskip, "fastforward_frameskip");
 
    CONFIG_GET_BOOL_BASE(conf, settings, pause_nonactive, "pause_nonactive");
    CONFIG_GET_INT_BASE(conf, settings, autosave_interval, "autosave_interval");
@@ -1490,12 +1565,18 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    CONFIG_GET_BOOL_BASE(conf, settings, block_sram_overwrite, "block_sram_overwrite");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_index, "savestate_auto_index");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_async_write, "savestate_async_write");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_compression, "savestate_compression");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_delta, "savestate_delta");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_save, "savestate_auto_save");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_load, "savestate_auto_load");
 
    CONFIG_GET_BOOL_BASE(conf, settings, network_cmd_enable, "network_cmd_enable");
    CONFIG_GET_INT_BASE(conf, settings, network_cmd_port, "network_cmd_port");
+   CONFIG_GET_INT_BASE(conf, settings, network_cmd_binary_port, "network_cmd_binary_port");
+   CONFIG_GET_PATH_BASE(conf, settings, network_cmd_binary_socket, "network_cmd_binary_socket");
    CONFIG_GET_BOOL_BASE(conf, settings, stdin_cmd_enable, "stdin_cmd_enable");
+   CONFIG_GET_PATH_BASE(conf, settings, shm_export_name, "shm_export_name");
 
    CONFIG_GET_PATH_BASE(conf, settings, content_history_directory, "content_history_dir");
 
@@ -1508,7 +1589,11 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, input.turbo_duty_cycle, "input_duty_cycle");
 
    CONFIG_GET_BOOL_BASE(conf, settings, input.autodetect_enable, "input_autodetect_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.poll_late, "input_poll_late");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.poll_yield, "input_poll_yield");
    CONFIG_GET_PATH_BASE(conf, settings, input.autoconfig_dir, "joypad_autoconfig_dir");
+   CONFIG_GET_PATH_BASE(conf, settings, input.latency_log_path, "input_latency_log_path");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.latency_flash_enable, "input_latency_flash_enable");
 
    if (!global->has_set_username)
       CONFIG_GET_PATH_BASE(conf, settings, username, "netplay_nickname");
@@ -1523,8 +1608,16 @@ static bool config_load_file(const char *path, bool set_defaults)
       CONFIG_GET_PATH_BASE(conf, global, netplay_server, "netplay_ip_address");
    if (!global->has_set_netplay_delay_frames)
       CONFIG_GET_INT_BASE(conf, global, netplay_sync_frames, "netplay_delay_frames");
+   if (!global->has_set_netplay_input_delay_frames)
+      CONFIG_GET_INT_BASE(conf, global, netplay_input_delay_frames,
+            "netplay_input_delay_frames");
+   if (!global->has_set_netplay_users)
+      CONFIG_GET_INT_BASE(conf, global, netplay_users, "netplay_users");
    if (!global->has_set_netplay_ip_port)
       CONFIG_GET_INT_BASE(conf, global, netplay_port, "netplay_ip_port");
+   if (!global->has_set_netplay_rendezvous)
+      CONFIG_GET_PATH_BASE(conf, global, netplay_rendezvous,
+            "netplay_rendezvous_server");
 #endif
 
    CONFIG_GET_BOOL_BASE(conf, settings, config_save_on_exit, "config_save_on_exit");
@@ -1600,6 +1693,28 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, auto_overrides_enable, "auto_overrides_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, auto_remaps_enable, "auto_remaps_enable");
 
+   if (global->benchmark.frames)
+   {
+      /* Nothing may wait on the display, the audio device 
+       * or the clock during a benchmark. */
+      global->perfcnt_enable           = true;
+      settings->video.vsync            = false;
+      settings->video.vrr_enable       = false;
+      settings->video.frame_delay      = 0;
+      settings->video.frame_delay_auto = false;
+      settings->audio.sync             = false;
+
+      if (!global->benchmark.real_drivers)
+      {
+         strlcpy(settings->video.driver, "null",
+               sizeof(settings->video.driver));
+         strlcpy(settings->audio.driver, "null",
+               sizeof(settings->audio.driver));
+         strlcpy(settings->input.driver, "null",
+               sizeof(settings->input.driver));
+      }
+   }
+
    config_file_free(conf);
    return true;
 }
@@ -2184,6 +2299,10 @@ bool config_save_file(const char *path)
          settings->input.remap_binds_enable);
    config_set_bool(conf, "netplay_client_swap_input",
          settings->input.netplay_client_swap_input);
+   config_set_int(conf, "netplay_check_frames",
+         settings->netplay_check_frames);
+   config_set_bool(conf, "netplay_show_stats",
+         settings->netplay_show_stats);
    config_set_bool(conf, "input_descriptor_label_show",
          settings->input.input_descriptor_label_show);
    config_set_bool(conf, "autoconfig_descriptor_label_show",
@@ -2193,6 +2312,7 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "load_dummy_on_core_shutdown",
          settings->load_dummy_on_core_shutdown);
    config_set_bool(conf,  "fps_show", settings->fps_show);
+   config_set_bool(conf,  "frame_time_graph_show", settings->frame_time_graph_show);
    config_set_bool(conf,  "ui_menubar_enable", settings->ui.menubar_enable);
    config_set_path(conf,  "libretro_path", settings->libretro);
    config_set_path(conf,  "core_options_path", settings->core_options_path);
@@ -2209,9 +2329,19 @@ bool config_save_file(const char *path)
    config_set_path(conf,  "content_history_dir", settings->content_history_directory);
    config_set_bool(conf,  "rewind_enable", settings->rewind_enable);
    config_set_int(conf,   "audio_latency", settings->audio.latency);
+   config_set_bool(conf,  "audio_exclusive_mode", settings->audio.exclusive_mode);
    config_set_bool(conf,  "audio_sync",    settings->audio.sync);
+   config_set_bool(conf,  "audio_lazy_init", settings->audio.lazy_init);
+   config_set_bool(conf,  "audio_threaded_dsp", settings->audio.threaded_dsp);
    config_set_int(conf,   "audio_block_frames", settings->audio.block_frames);
    config_set_int(conf,   "rewind_granularity", settings->rewind_granularity);
+   config_set_int(conf,   "rewind_speed", settings->rewind_speed);
+   config_set_bool(conf,  "rewind_threaded", settings->rewind_threaded);
+   config_set_int(conf,   "rewind_cold_after", settings->rewind_cold_after);
+   config_set_int(conf,   "rewind_keyframe_interval", settings->rewind_keyframe_interval);
+   config_set_int(conf,   "run_ahead_frames", settings->run_ahead_frames);
+   config_set_bool(conf,  "run_ahead_secondary_instance",
+         settings->run_ahead_secondary_instance);
    config_set_path(conf,  "video_shader", settings->video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          settings->video.shader_enable);
@@ -2231,6 +2361,8 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "video_threaded", settings->video.threaded);
    config_set_bool(conf,  "video_shared_context",
          settings->video.shared_context);
+   config_set_bool(conf,  "video_dirty_rows",
+         settings->video.dirty_rows);
    config_set_bool(conf,  "video_force_srgb_disable",
          settings->video.force_srgb_disable);
    config_set_bool(conf,  "video_fullscreen", settings->video.fullscreen);
@@ -2253,12 +2385,21 @@ bool config_save_file(const char *path)
    config_set_path(conf, "menu_wallpaper", settings->menu.wallpaper);
 #endif
    config_set_bool(conf,  "video_vsync", settings->video.vsync);
+   config_set_bool(conf,  "video_vrr_enable", settings->video.vrr_enable);
    config_set_bool(conf,  "video_hard_sync", settings->video.hard_sync);
    config_set_int(conf,   "video_hard_sync_frames",
          settings->video.hard_sync_frames);
+   config_set_int(conf,   "video_max_swapchain_images",
+         settings->video.max_swapchain_images);
+   config_set_bool(conf,  "video_hard_sync_adaptive",
+         settings->video.hard_sync_adaptive);
    config_set_int(conf,   "video_frame_delay", settings->video.frame_delay);
+   config_set_bool(conf,  "video_frame_delay_auto",
+         settings->video.frame_delay_auto);
    config_set_bool(conf,  "video_black_frame_insertion",
          settings->video.black_frame_insertion);
+   config_set_bool(conf,  "video_kms_match_core_refresh",
+         settings->video.kms_match_core_refresh);
    config_set_bool(conf,  "video_disable_composition",
          settings->video.disable_composition);
    config_set_bool(conf,  "pause_nonactive", settings->pause_nonactive);
@@ -2280,11 +2421,13 @@ bool config_save_file(const char *path)
    config_set_bool(conf, "audio_rate_control", settings->audio.rate_control);
    config_set_float(conf, "audio_rate_control_delta",
          settings->audio.rate_control_delta);
+   config_set_bool(conf, "audio_show_stats", settings->audio.show_stats);
    config_set_float(conf, "audio_max_timing_skew",
          settings->audio.max_timing_skew);
    config_set_float(conf, "audio_volume", settings->audio.volume);
    config_set_string(conf, "video_context_driver", settings->video.context_driver);
    config_set_string(conf, "audio_driver", settings->audio.driver);
+   config_set_string(conf, "record_driver", settings->record.driver);
    config_set_bool(conf, "audio_enable", settings->audio.enable);
    config_set_bool(conf, "audio_mute_enable", settings->audio.mute_enable);
    config_set_int(conf, "audio_out_rate", settings->audio.out_rate);
@@ -2313,6 +2456,8 @@ bool config_save_file(const char *path)
    config_set_path(conf, "resampler_directory",
          settings->resampler_directory);
    config_set_string(conf, "audio_resampler", settings->audio.resampler);
+   config_set_int(conf, "audio_resampler_quality",
+         settings->audio.resampler_quality);
    config_set_path(conf, "savefile_directory",
          *global->savefile_dir ? global->savefile_dir : "default");
    config_set_path(conf, "savestate_directory",
@@ -2320,6 +2465,9 @@ bool config_save_file(const char *path)
    config_set_path(conf, "video_shader_dir",
          *settings->video.shader_dir ?
          settings->video.shader_dir : "default");
+   config_set_path(conf, "video_shader_cache_dir",
+         *settings->video.shader_cache_dir ?
+         settings->video.shader_cache_dir : "default");
    config_set_path(conf, "video_filter_dir",
          *settings->video.filter_dir ?
          settings->video.filter_dir : "default");
@@ -2336,6 +2484,9 @@ bool config_save_file(const char *path)
    config_set_path(conf, "playlist_directory",
          *settings->playlist_directory ?
          settings->playlist_directory : "default");
+   config_set_path(conf, "thumbnails_directory",
+         *settings->thumbnails_directory ?
+         settings->thumbnails_directory : "default");
 #ifdef HAVE_MENU
    config_set_path(conf, "rgui_browser_directory",
          *settings->menu_content_directory ?
@@ -2355,6 +2506,8 @@ bool config_save_file(const char *path)
          settings->menu.collapse_subgroups_enable);
    config_set_bool(conf, "menu_show_advanced_settings",
          settings->menu.show_advanced_settings);
+   config_set_bool(conf, "menu_throttle",
+         settings->menu.throttle);
    config_set_hex(conf, "menu_entry_normal_color",
          settings->menu.entry_normal_color);
    config_set_hex(conf, "menu_entry_hover_color",
@@ -2367,8 +2520,16 @@ bool config_save_file(const char *path)
    config_set_int(conf, "game_history_size", settings->content_history_size);
    config_set_path(conf, "joypad_autoconfig_dir",
          settings->input.autoconfig_dir);
+   config_set_path(conf, "input_latency_log_path",
+         settings->input.latency_log_path);
+   config_set_bool(conf, "input_latency_flash_enable",
+         settings->input.latency_flash_enable);
    config_set_bool(conf, "input_autodetect_enable",
          settings->input.autodetect_enable);
+   config_set_bool(conf, "input_poll_late",
+         settings->input.poll_late);
+   config_set_bool(conf, "input_poll_yield",
+         settings->input.poll_yield);
 
 #ifdef HAVE_OVERLAY
    config_set_path(conf, "overlay_directory",
@@ -2417,6 +2578,12 @@ bool config_save_file(const char *path)
          settings->block_sram_overwrite);
    config_set_bool(conf, "savestate_auto_index",
          settings->savestate_auto_index);
+   config_set_bool(conf, "savestate_async_write",
+         settings->savestate_async_write);
+   config_set_bool(conf, "savestate_compression",
+         settings->savestate_compression);
+   config_set_bool(conf, "savestate_delta",
+         settings->savestate_delta);
    config_set_bool(conf, "savestate_auto_save",
          settings->savestate_auto_save);
    config_set_bool(conf, "savestate_auto_load",
@@ -2426,6 +2593,7 @@ bool config_save_file(const char *path)
 
    config_set_float(conf, "fastforward_ratio", settings->fastforward_ratio);
    config_set_bool(conf, "fastforward_ratio_throttle_enable", settings->fastforward_ratio_throttle_enable);
+   config_set_bool(conf, "fastforward_frameskip", settings->fastforward_frameskip);
    config_set_float(conf, "slowmotion_ratio", settings->slowmotion_ratio);
 
    config_set_bool(conf, "config_save_on_exit",
@@ -2440,6 +2608,11 @@ bool config_save_file(const char *path)
    config_set_string(conf, "netplay_ip_address", global->netplay_server);
    config_set_int(conf, "netplay_ip_port", global->netplay_port);
    config_set_int(conf, "netplay_delay_frames", global->netplay_sync_frames);
+   config_set_int(conf, "netplay_input_delay_frames",
+         global->netplay_input_delay_frames);
+   config_set_int(conf, "netplay_users", global->netplay_users);
+   config_set_string(conf, "netplay_rendezvous_server",
+         global->netplay_rendezvous);
 #endif
    config_set_string(conf, "netplay_nickname", settings->username);
    config_set_int(conf, "user_language", settings->user_language);
@@ -44,11 +44,16 @@ typedef struct settings
       unsigned fullscreen_x;
       unsigned fullscreen_y;
       bool vsync;
+      bool vrr_enable;
       bool hard_sync;
       bool black_frame_insertion;
+      bool kms_match_core_refresh;
       unsigned swap_interval;
       unsigned hard_sync_frames;
+      bool hard_sync_adaptive;
+      unsigned max_swapchain_images;
       unsigned frame_delay;
+      bool frame_delay_auto;
 #ifdef GEKKO
       unsigned viwidth;
       bool vfilter;
@@ -71,6 +76,7 @@ typedef struct settings
 
       char filter_dir[PATH_MAX_LENGTH];
       char shader_dir[PATH_MAX_LENGTH];
+      char shader_cache_dir[PATH_MAX_LENGTH];
 
       char font_path[PATH_MAX_LENGTH];
       float font_size;
@@ -89,6 +95,7 @@ typedef struct settings
 
       bool allow_rotate;
       bool shared_context;
+      bool dirty_rows;
       bool force_srgb_disable;
    } video;
 
@@ -177,16 +184,21 @@ typedef struct settings
       unsigned block_frames;
       char device[PATH_MAX_LENGTH];
       unsigned latency;
+      bool exclusive_mode;
       bool sync;
+      bool lazy_init;
+      bool threaded_dsp;
 
       char dsp_plugin[PATH_MAX_LENGTH];
       char filter_dir[PATH_MAX_LENGTH];
 
       bool rate_control;
       float rate_control_delta;
+      bool show_stats;
       float max_timing_skew;
       float volume; /* dB scale. */
       char resampler[32];
+      unsigned resampler_quality;
    } audio;
 
    struct
@@ -209,6 +221,8 @@ typedef struct settings
       unsigned analog_dpad_mode[MAX_USERS];
 
       bool remap_binds_enable;
+      bool poll_late;
+      bool poll_yield;
       float axis_threshold;
       unsigned joypad_map[MAX_USERS];
       unsigned device[MAX_USERS];
@@ -225,6 +239,9 @@ typedef struct settings
       float overlay_scale;
 
       char autoconfig_dir[PATH_MAX_LENGTH];
+
+      char latency_log_path[PATH_MAX_LENGTH];
+      bool latency_flash_enable;
       bool autoconfig_descriptor_label_show;
       bool input_descriptor_label_show;
       bool input_descriptor_hide_unbound;
@@ -275,28 +292,44 @@ typedef struct settings
 
    char extraction_directory[PATH_MAX_LENGTH];
    char playlist_directory[PATH_MAX_LENGTH];
+   char thumbnails_directory[PATH_MAX_LENGTH];
 
    bool history_list_enable;
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
+   unsigned rewind_speed;
+   bool rewind_threaded;
+   unsigned rewind_cold_after;
+   unsigned rewind_keyframe_interval;
+
+   unsigned run_ahead_frames;
+   bool run_ahead_secondary_instance;
 
    float slowmotion_ratio;
    float fastforward_ratio;
    bool fastforward_ratio_throttle_enable;
+   bool fastforward_frameskip;
 
    bool pause_nonactive;
    unsigned autosave_interval;
 
    bool block_sram_overwrite;
    bool savestate_auto_index;
+   bool savestate_async_write;
+   bool savestate_compression;
+   bool savestate_delta;
    bool savestate_auto_save;
    bool savestate_auto_load;
 
    bool network_cmd_enable;
    uint16_t network_cmd_port;
+   uint16_t network_cmd_binary_port;
+   char network_cmd_binary_socket[PATH_MAX_LENGTH];
    bool stdin_cmd_enable;
 
+   char shm_export_name[PATH_MAX_LENGTH];
+
    char core_assets_directory[PATH_MAX_LENGTH];
    char assets_directory[PATH_MAX_LENGTH];
    char menu_config_directory[PATH_MAX_LENGTH];
@@ -305,6 +338,7 @@ typedef struct settings
    bool menu_show_start_screen;
 #endif
    bool fps_show;
+   bool frame_time_graph_show;
    bool load_dummy_on_core_shutdown;
 
    bool core_specific_config;
@@ -312,6 +346,8 @@ typedef struct settings
    bool auto_remaps_enable;
 
    char username[32];
+   unsigned netplay_check_frames;
+   bool netplay_show_stats;
    unsigned int user_language;
 
    bool config_save_on_exit;
@@ -17,8 +17,11 @@
 #include "content.h"
 #include "file_ops.h"
 #include <file/file_path.h>
+#include <file/dir_list.h>
+#include <string/string_list.h>
 #include "general.h"
 #include <stdlib.h>
+#include <ctype.h>
 #include <boolean.h>
 #include <string.h>
 #include <time.h>
@@ -27,8 +30,15 @@
 #include "patch.h"
 #include "compat/strl.h"
 #include "hash.h"
+#include "performance.h"
+#include "runloop_data.h"
+#include "runahead.h"
 #include <file/file_extract.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #ifdef _WIN32
 #ifdef _XBOX
 #include <xtl.h>
@@ -39,6 +49,278 @@
 #include <fcntl.h>
 #include <windows.h>
 #endif
+#include <malloc.h>
+#endif
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define STATE_BUFFER_ALIGN 4096
+
+/* Content at least this large is mapped rather than read. */
+#define CONTENT_MMAP_MIN_SIZE (16 * 1024 * 1024)
+
+/* Scratch buffer for serialized states, kept around between
+ * saves/loads so they don't go through the allocator every time. */
+static void *state_buffer;
+static size_t state_buffer_size;
+
+static void state_buffer_release(void)
+{
+#if defined(_WIN32)
+   _aligned_free(state_buffer);
+#else
+   free(state_buffer);
+#endif
+   state_buffer      = NULL;
+   state_buffer_size = 0;
+}
+
+void *content_state_buffer_get(size_t size)
+{
+   if (!size)
+      size = 1;
+
+   if (size <= state_buffer_size)
+      return state_buffer;
+
+   state_buffer_release();
+
+   size = (size + STATE_BUFFER_ALIGN - 1) & ~(size_t)(STATE_BUFFER_ALIGN - 1);
+
+#if defined(_WIN32)
+   state_buffer = _aligned_malloc(size, STATE_BUFFER_ALIGN);
+#elif defined(HAVE_MMAP)
+   if (posix_memalign(&state_buffer, STATE_BUFFER_ALIGN, size) != 0)
+      state_buffer = NULL;
+#else
+   state_buffer = malloc(size);
+#endif
+
+   if (state_buffer)
+      state_buffer_size = size;
+
+   return state_buffer;
+}
+
+void content_state_buffer_free(void)
+{
+   state_buffer_release();
+}
+
+#ifdef HAVE_ZLIB
+/* Zipped content extracted in the background, so inflating
+ * it overlaps with the initialization of the core. Content
+ * the core doesn't need a path for is extracted into memory
+ * rather than to a temporary file. */
+struct content_extract
+{
+   unsigned index;
+   bool to_file;
+   bool done;
+   bool ok;
+   const char *valid_exts;
+   const char *extraction_directory;
+   char archive[PATH_MAX_LENGTH];
+   /* Extracted file, or archive#file when in memory. */
+   char path[PATH_MAX_LENGTH];
+   void *data;
+   size_t size;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+#endif
+};
+
+static struct content_extract *content_extract_jobs;
+static unsigned content_extract_count;
+
+static void content_extract_thread(void *data)
+{
+   struct content_extract *job = (struct content_extract*)data;
+
+   RARCH_TRACE_BEGIN("content_extract");
+
+   if (job->to_file)
+      job->ok = zlib_extract_first_content_file(job->path,
+            sizeof(job->path), job->valid_exts, job->extraction_directory);
+   else
+      job->ok = zlib_extract_first_content_to_memory(job->path,
+            sizeof(job->path), job->valid_exts, &job->data, &job->size);
+
+   RARCH_TRACE_END("content_extract");
+   job->done = true;
+}
+
+/**
+ * content_extract_finish:
+ * @i            : index of the content.
+ * @path         : path of the zipped content.
+ *
+ * Waits for the extraction of zipped content started by
+ * content_extract_start().
+ *
+ * Returns: the finished job, or NULL if none was started
+ * for @path.
+ **/
+static struct content_extract *content_extract_finish(unsigned i,
+      const char *path)
+{
+   unsigned j;
+
+   for (j = 0; j < content_extract_count; j++)
+   {
+      struct content_extract *job = &content_extract_jobs[j];
+
+      if (job->index != i || strcmp(job->archive, path))
+         continue;
+
+#ifdef HAVE_THREADS
+      if (job->thread)
+      {
+         sthread_join(job->thread);
+         job->thread = NULL;
+      }
+#endif
+      if (!job->done)
+         content_extract_thread(job);
+
+      return job;
+   }
+
+   return NULL;
+}
+
+/**
+ * content_extract_take:
+ * @i            : index of the content.
+ * @buf          : set to the content extracted into memory.
+ * @length       : set to the size of @buf.
+ *
+ * Hands content extracted into memory over to the caller.
+ *
+ * Returns: true if content @i was extracted into memory.
+ **/
+static bool content_extract_take(unsigned i, void **buf, ssize_t *length)
+{
+   unsigned j;
+
+   for (j = 0; j < content_extract_count; j++)
+   {
+      struct content_extract *job = &content_extract_jobs[j];
+
+      if (job->index != i || !job->done || !job->data)
+         continue;
+
+      *buf       = job->data;
+      *length    = job->size;
+      job->data  = NULL;
+      return true;
+   }
+
+   return false;
+}
+
+static void content_extract_free(void)
+{
+   unsigned i;
+
+   for (i = 0; i < content_extract_count; i++)
+   {
+#ifdef HAVE_THREADS
+      if (content_extract_jobs[i].thread)
+         sthread_join(content_extract_jobs[i].thread);
+#endif
+      free(content_extract_jobs[i].data);
+   }
+
+   free(content_extract_jobs);
+   content_extract_jobs  = NULL;
+   content_extract_count = 0;
+}
+
+/**
+ * content_extract_start:
+ *
+ * Starts extracting the zipped content that is going to be
+ * loaded, one thread per archive. init_content_file() picks
+ * the results up.
+ **/
+void content_extract_start(void)
+{
+   unsigned i, count                          = 1;
+   const struct retro_subsystem_info *special = NULL;
+   settings_t *settings                       = config_get_ptr();
+   global_t   *global                         = global_get_ptr();
+
+   content_extract_free();
+
+   if (global->libretro_dummy || global->libretro_no_content)
+      return;
+
+   if (*global->subsystem)
+   {
+      special = libretro_find_subsystem_info(global->system.special,
+            global->system.num_special, global->subsystem);
+
+      /* init_content_file() reports mismatches. */
+      if (!special || !global->subsystem_fullpaths ||
+            special->num_roms != global->subsystem_fullpaths->size)
+         return;
+
+      count = special->num_roms;
+   }
+
+   if (!count)
+      return;
+
+   content_extract_jobs = (struct content_extract*)
+      calloc(count, sizeof(*content_extract_jobs));
+
+   if (!content_extract_jobs)
+      return;
+
+   for (i = 0; i < count; i++)
+   {
+      struct content_extract *job = NULL;
+      const char *path            = special ?
+         global->subsystem_fullpaths->elems[i].data : global->fullpath;
+      const char *valid_exts      = special ?
+         special->roms[i].valid_extensions :
+         global->system.info.valid_extensions;
+      bool block_extract          = special ?
+         special->roms[i].block_extract :
+         global->system.info.block_extract;
+      bool need_fullpath          = special ?
+         special->roms[i].need_fullpath :
+         global->system.info.need_fullpath;
+      const char *ext             = path_get_extension(path);
+
+      if (block_extract || !valid_exts || !ext || strcasecmp(ext, "zip"))
+         continue;
+
+      job                         = 
+         &content_extract_jobs[content_extract_count++];
+      job->index                  = i;
+      job->to_file                = need_fullpath;
+      job->valid_exts             = valid_exts;
+      job->extraction_directory   = *settings->extraction_directory ?
+         settings->extraction_directory : NULL;
+      strlcpy(job->archive, path, sizeof(job->archive));
+      strlcpy(job->path,    path, sizeof(job->path));
+
+#ifdef HAVE_THREADS
+      job->thread = sthread_create(content_extract_thread, job);
+#endif
+   }
+}
+#else
+void content_extract_start(void)
+{
+}
 #endif
 
 /**
@@ -46,6 +328,9 @@
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @mapped       : set to the size of the mapping if @buf is mapped
+ *                 rather than allocated, see release_file().
+ *                 Patching in place can leave @length smaller.
  *
  * Read the content file. If read into memory, also performs soft patching
  * (see patch_content function) in case soft patching has not been
@@ -54,30 +339,50 @@
  * Returns: true if successful, false on error.
  **/
 static bool read_content_file(unsigned i, const char *path, void **buf,
-      ssize_t *length)
+      ssize_t *length, size_t *mapped)
 {
    uint8_t *ret_buf = NULL;
    global_t *global = global_get_ptr();
 
+   *mapped = 0;
+
    RARCH_LOG("Loading content file: %s.\n", path);
-   if (!read_file(path, (void**) &ret_buf, length))
+
+#ifdef HAVE_ZLIB
+   content_extract_take(i, (void**)&ret_buf, length);
+#endif
+
+   if (!ret_buf && !read_file_mapped(path, CONTENT_MMAP_MIN_SIZE,
+            (void**)&ret_buf, length, mapped))
       return false;
 
    if (*length <= 0)
+   {
+      release_file(ret_buf, *mapped);
       return false;
+   }
 
-   if (i != 0)
-      return true;
+   if (i == 0)
+   {
+      /* Attempt to apply a patch. */
+      if (!global->block_patch)
+      {
+         uint8_t *content_buf = ret_buf;
 
-   /* Attempt to apply a patch. */
-   if (!global->block_patch)
-      patch_content(&ret_buf, length);
-   
-#ifdef HAVE_ZLIB
-   global->content_crc = zlib_crc32_calculate(ret_buf, *length);
+         patch_content(&ret_buf, length);
+
+         if (ret_buf != content_buf)
+         {
+            release_file(content_buf, *mapped);
+            *mapped = 0;
+         }
+      }
+
+      global->content_crc = crc32_calculate(ret_buf, *length);
+
+      RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
+   }
 
-   RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
-#endif
    *buf = ret_buf;
 
    return true;
@@ -132,6 +437,615 @@ struct sram_block
    size_t size;
 };
 
+#define STATE_CONTAINER_MAGIC       "RAST"
+#define STATE_CONTAINER_VERSION     1
+#define STATE_CONTAINER_FLAG_DELTA  (1 << 0)
+#define STATE_CONTAINER_HEADER_SIZE 28
+
+/* Compressed savestates are stored as a STATE_CONTAINER_HEADER_SIZE
+ * byte little-endian header, followed by the base state's file name
+ * (delta states only) and the deflated state:
+ *
+ *  0: magic "RAST"
+ *  4: version, flags, 2 bytes reserved
+ *  8: size of the serialized state
+ * 12: size of the deflated data
+ * 16: CRC32 of the serialized state
+ * 20: CRC32 of the base state (delta states only)
+ * 24: length of the base state's file name (delta states only)
+ *
+ * A delta state is XORed against the base state before deflating,
+ * so everything that matches the base compresses down to nothing.
+ * The base state is looked up in the same directory as the delta.
+ * Deltas are made against a frozen copy of the base slot named
+ * after its CRC32, see state_freeze_base(), so saving over the
+ * base slot doesn't break the deltas made against it. */
+
+static void state_container_write_le(uint8_t *data, uint32_t val)
+{
+   data[0] = (uint8_t)(val >>  0);
+   data[1] = (uint8_t)(val >>  8);
+   data[2] = (uint8_t)(val >> 16);
+   data[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t state_container_read_le(const uint8_t *data)
+{
+   return ((uint32_t)data[0] <<  0) | ((uint32_t)data[1] <<  8) |
+          ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static bool state_is_container(const void *data, size_t size)
+{
+   return size >= STATE_CONTAINER_HEADER_SIZE &&
+      !memcmp(data, STATE_CONTAINER_MAGIC, 4);
+}
+
+#ifdef HAVE_ZLIB_DEFLATE
+static void state_xor(uint8_t *data, size_t size,
+      const uint8_t *base, size_t base_size)
+{
+   size_t i;
+   size_t len = size < base_size ? size : base_size;
+
+   for (i = 0; i < len; i++)
+      data[i] ^= base[i];
+}
+
+static void *state_decode(const char *path, const void *data,
+      size_t size, size_t *out_size, bool allow_delta);
+static void *state_encode(const char *base_path, void *data,
+      size_t size, size_t *out_size);
+
+/**
+ * state_read_base:
+ * @path      : path of the base state.
+ * @size      : set to the size of the serialized base state.
+ *
+ * Reads a base state for delta states, inflating it if needed.
+ *
+ * Returns: serialized base state, which has to be free()'d,
+ * or NULL on error.
+ **/
+static void *state_read_base(const char *path, size_t *size)
+{
+   void *buf     = NULL;
+   void *decoded = NULL;
+   ssize_t len   = 0;
+
+   if (!read_file(path, &buf, &len) || len <= 0)
+   {
+      free(buf);
+      return NULL;
+   }
+
+   *size = len;
+
+   if (!state_is_container(buf, len))
+      return buf;
+
+   decoded = state_decode(path, buf, len, size, false);
+   free(buf);
+   return decoded;
+}
+
+/**
+ * state_freeze_base:
+ * @base_path : path of the base slot.
+ * @base      : serialized base state.
+ * @base_size : size of @base.
+ * @base_crc  : CRC32 of @base.
+ * @path      : set to the path of the frozen copy.
+ * @size      : size of @path.
+ *
+ * Writes @base out deflated next to the base slot, named after
+ * @base_crc, unless that copy exists already. It is never
+ * overwritten, as every delta made against this base refers to it,
+ * but deleted once none do, see state_prune_bases().
+ *
+ * Returns: true if the frozen copy exists, false otherwise.
+ **/
+static bool state_freeze_base(const char *base_path,
+      void *base, size_t base_size, uint32_t base_crc,
+      char *path, size_t size)
+{
+   bool ret               = false;
+   void *compressed       = NULL;
+   size_t compressed_size = 0;
+   int len = snprintf(path, size, "%s.%08x", base_path, (unsigned)base_crc);
+
+   if (len < 0 || (size_t)len >= size)
+      return false;
+   if (path_file_exists(path))
+      return true;
+
+   compressed = state_encode(NULL, base, base_size, &compressed_size);
+   if (compressed)
+      ret = write_file_atomic(path, compressed, compressed_size);
+   else
+      ret = write_file_atomic(path, base, base_size);
+
+   free(compressed);
+   return ret;
+}
+
+/**
+ * state_container_base_name:
+ * @data      : start of a state file.
+ * @size      : size of @data.
+ * @name      : set to the file name of the base state.
+ * @name_size : size of @name.
+ *
+ * Returns: true if @data is a delta state, and its base state's
+ * file name fits into @name, otherwise false.
+ **/
+static bool state_container_base_name(const uint8_t *data, size_t size,
+      char *name, size_t name_size)
+{
+   uint32_t name_len;
+
+   if (!state_is_container(data, size)
+         || !(data[5] & STATE_CONTAINER_FLAG_DELTA))
+      return false;
+
+   name_len = state_container_read_le(data + 24);
+   if (name_len >= name_size
+         || STATE_CONTAINER_HEADER_SIZE + name_len > size)
+      return false;
+
+   memcpy(name, data + STATE_CONTAINER_HEADER_SIZE, name_len);
+   name[name_len] = '\0';
+   return true;
+}
+
+/**
+ * state_read_base_name:
+ * @path      : path of a state file.
+ * @name      : set to the file name of the base state.
+ * @name_size : size of @name.
+ *
+ * Reads just the header of a state file.
+ *
+ * Returns: true if @path is a delta state, otherwise false.
+ **/
+static bool state_read_base_name(const char *path,
+      char *name, size_t name_size)
+{
+   uint8_t hdr[STATE_CONTAINER_HEADER_SIZE + PATH_MAX_LENGTH];
+   size_t len = 0;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   len = fread(hdr, 1, sizeof(hdr), file);
+   fclose(file);
+
+   return state_container_base_name(hdr, len, name, name_size);
+}
+
+/* Frozen copies are named after the base slot, followed
+ * by a dot and eight hex digits. */
+static bool state_is_frozen_base(const char *name, const char *base,
+      size_t base_len)
+{
+   size_t i;
+
+   if (strncmp(name, base, base_len) || name[base_len] != '.')
+      return false;
+
+   name += base_len + 1;
+   for (i = 0; i < 8; i++)
+      if (!isxdigit((unsigned char)name[i]))
+         return false;
+
+   return name[8] == '\0';
+}
+
+/**
+ * state_prune_bases:
+ * @keep      : file name of a frozen base to keep, or NULL.
+ *
+ * Deletes the frozen copies of the base slot which no state
+ * next to it refers to any more. The state about to be written
+ * still counts with what is on disk, so it stays loadable if
+ * writing it fails; the base it leaves behind goes next time.
+ **/
+static void state_prune_bases(const char *keep)
+{
+   size_t i;
+   char dir[PATH_MAX_LENGTH], name[PATH_MAX_LENGTH];
+   union string_list_elem_attr attr;
+   struct string_list *files = NULL;
+   struct string_list *refs  = NULL;
+   global_t *global          = global_get_ptr();
+   const char *base          = path_basename(global->savestate_name);
+   size_t base_len           = strlen(base);
+
+   if (!*global->savestate_name)
+      return;
+
+   attr.i = 0;
+   fill_pathname_basedir(dir, global->savestate_name, sizeof(dir));
+
+   files = dir_list_new(dir, NULL, false);
+   refs  = string_list_new();
+   if (!files || !refs)
+      goto end;
+
+   if (keep && !string_list_append(refs, keep, attr))
+      goto end;
+
+   for (i = 0; i < files->size; i++)
+   {
+      const char *file = path_basename(files->elems[i].data);
+
+      if (strncmp(file, base, base_len)
+            || state_is_frozen_base(file, base, base_len))
+         continue;
+
+      if (state_read_base_name(files->elems[i].data, name, sizeof(name))
+            && !string_list_append(refs, name, attr))
+         goto end;
+   }
+
+   for (i = 0; i < files->size; i++)
+   {
+      const char *file = path_basename(files->elems[i].data);
+
+      if (!state_is_frozen_base(file, base, base_len)
+            || string_list_find_elem(refs, file))
+         continue;
+
+      RARCH_LOG("Removing unused base state \"%s\".\n",
+            files->elems[i].data);
+      remove(files->elems[i].data);
+   }
+
+end:
+   string_list_free(files);
+   string_list_free(refs);
+}
+
+/**
+ * state_encode:
+ * @base_path : path of the state to delta against, or NULL.
+ * @data      : serialized state.
+ * @size      : size of @data.
+ * @out_size  : set to the size of the returned container.
+ *
+ * Deflates a serialized state into the container format.
+ * @data is clobbered when a delta against @base_path is made
+ * successfully.
+ *
+ * Returns: container, which has to be free()'d, or NULL if
+ * the state could not be compressed and should be saved as is.
+ **/
+static void *state_encode(const char *base_path, void *data,
+      size_t size, size_t *out_size)
+{
+   char frozen_path[PATH_MAX_LENGTH];
+   size_t base_size   = 0;
+   size_t name_len    = 0;
+   size_t bound       = 0;
+   uint8_t *out       = NULL;
+   uint8_t *base      = NULL;
+   void *stream       = NULL;
+   const char *name   = NULL;
+   uint32_t crc       = crc32_calculate((const uint8_t*)data, size);
+   uint32_t base_crc  = 0;
+
+   if (base_path)
+      base = (uint8_t*)state_read_base(base_path, &base_size);
+
+   if (base)
+   {
+      base_crc = crc32_calculate(base, base_size);
+
+      if (!state_freeze_base(base_path, base, base_size, base_crc,
+               frozen_path, sizeof(frozen_path)))
+      {
+         RARCH_WARN("Failed to freeze base state \"%s\", "
+               "saving state on its own.\n", base_path);
+         free(base);
+         base = NULL;
+      }
+   }
+
+   if (base)
+   {
+      name     = path_basename(frozen_path);
+      name_len = strlen(name);
+      state_xor((uint8_t*)data, size, base, base_size);
+   }
+
+   /* Stay well clear of deflateBound() for incompressible states. */
+   bound = STATE_CONTAINER_HEADER_SIZE + name_len + size + (size >> 8) + 64;
+   out   = (uint8_t*)malloc(bound);
+   if (!out)
+      goto error;
+
+   stream = zlib_stream_new();
+   if (!stream)
+      goto error;
+
+   zlib_set_stream(stream, size,
+         bound - STATE_CONTAINER_HEADER_SIZE - name_len,
+         (const uint8_t*)data, out + STATE_CONTAINER_HEADER_SIZE + name_len);
+   zlib_deflate_init(stream, 6);
+
+   if (zlib_deflate_data_to_file(stream) != 1)
+      goto error;
+
+   memcpy(out, STATE_CONTAINER_MAGIC, 4);
+   out[4] = STATE_CONTAINER_VERSION;
+   out[5] = name_len ? STATE_CONTAINER_FLAG_DELTA : 0;
+   out[6] = out[7] = 0;
+   state_container_write_le(out +  8, size);
+   state_container_write_le(out + 12, zlib_stream_get_total_out(stream));
+   state_container_write_le(out + 16, crc);
+   state_container_write_le(out + 20, base_crc);
+   state_container_write_le(out + 24, name_len);
+   if (name_len)
+      memcpy(out + STATE_CONTAINER_HEADER_SIZE, name, name_len);
+
+   *out_size = STATE_CONTAINER_HEADER_SIZE + name_len +
+      zlib_stream_get_total_out(stream);
+
+   zlib_stream_deflate_free(stream);
+   free(stream);
+   free(base);
+
+   if (name_len)
+      RARCH_LOG("Compressed state to %u bytes (delta against \"%s\").\n",
+            (unsigned)*out_size, frozen_path);
+   else
+      RARCH_LOG("Compressed state to %u bytes.\n", (unsigned)*out_size);
+
+   return out;
+
+error:
+   if (stream)
+   {
+      zlib_stream_deflate_free(stream);
+      free(stream);
+   }
+   /* The caller falls back to writing out @data as is. */
+   if (base)
+      state_xor((uint8_t*)data, size, base, base_size);
+   free(base);
+   free(out);
+   return NULL;
+}
+
+/**
+ * state_decode:
+ * @path      : path the container was read from.
+ * @data      : container.
+ * @size      : size of @data.
+ * @out_size  : set to the size of the serialized state.
+ * @allow_delta : whether @data may be a delta state.
+ *
+ * Inflates a state container, applying the base state
+ * for delta states.
+ *
+ * Returns: serialized state, which has to be free()'d,
+ * or NULL on error.
+ **/
+static void *state_decode(const char *path, const void *data,
+      size_t size, size_t *out_size, bool allow_delta)
+{
+   char name[PATH_MAX_LENGTH], base_path[PATH_MAX_LENGTH];
+   uint8_t *out       = NULL;
+   uint8_t *base      = NULL;
+   void *stream       = NULL;
+   size_t base_size   = 0;
+   const uint8_t *hdr = (const uint8_t*)data;
+   uint32_t raw_size  = state_container_read_le(hdr +  8);
+   uint32_t comp_size = state_container_read_le(hdr + 12);
+   uint32_t crc       = state_container_read_le(hdr + 16);
+   uint32_t base_crc  = state_container_read_le(hdr + 20);
+   uint32_t name_len  = state_container_read_le(hdr + 24);
+   bool is_delta      = hdr[5] & STATE_CONTAINER_FLAG_DELTA;
+
+   if (hdr[4] != STATE_CONTAINER_VERSION || raw_size == 0
+         || name_len >= sizeof(name)
+         || STATE_CONTAINER_HEADER_SIZE + name_len + comp_size > size)
+   {
+      RARCH_ERR("Invalid compressed state \"%s\".\n", path);
+      return NULL;
+   }
+
+   if (is_delta)
+   {
+      if (!allow_delta || !name_len)
+      {
+         RARCH_ERR("Base state of \"%s\" is a delta state itself.\n", path);
+         return NULL;
+      }
+
+      memcpy(name, hdr + STATE_CONTAINER_HEADER_SIZE, name_len);
+      name[name_len] = '\0';
+      fill_pathname_resolve_relative(base_path, path, name, sizeof(base_path));
+
+      base = (uint8_t*)state_read_base(base_path, &base_size);
+      if (!base || crc32_calculate(base, base_size) != base_crc)
+      {
+         RARCH_ERR("Base state \"%s\" is missing or has changed.\n",
+               base_path);
+         goto error;
+      }
+   }
+
+   out = (uint8_t*)malloc(raw_size);
+   if (!out)
+      goto error;
+
+   stream = zlib_stream_new();
+   if (!stream || !zlib_inflate_init(stream))
+      goto error;
+
+   zlib_set_stream(stream, comp_size, raw_size,
+         hdr + STATE_CONTAINER_HEADER_SIZE + name_len, out);
+
+   if (zlib_inflate_data_to_file_iterate(stream) != 1
+         || zlib_stream_get_total_out(stream) != raw_size)
+   {
+      RARCH_ERR("Failed to inflate state \"%s\".\n", path);
+      goto error;
+   }
+
+   if (base)
+      state_xor(out, raw_size, base, base_size);
+
+   if (crc32_calculate(out, raw_size) != crc)
+   {
+      RARCH_ERR("CRC32 mismatch in state \"%s\".\n", path);
+      goto error;
+   }
+
+   zlib_stream_free(stream);
+   free(stream);
+   free(base);
+
+   *out_size = raw_size;
+   return out;
+
+error:
+   if (stream)
+   {
+      zlib_stream_free(stream);
+      free(stream);
+   }
+   free(out);
+   free(base);
+   return NULL;
+}
+#endif
+
+/**
+ * state_delta_base:
+ * @path      : path of saved state that shall be written to.
+ *
+ * Returns: path of the state @path should be stored as a delta
+ * against, or NULL if it should be stored on its own.
+ **/
+static const char *state_delta_base(const char *path)
+{
+   settings_t *settings = config_get_ptr();
+   global_t *global     = global_get_ptr();
+   const char *base     = global->savestate_name;
+
+   if (!settings->savestate_delta || !path_file_exists(base))
+      return NULL;
+   /* The base slot itself and the auto state stand on their own. */
+   if (!strcmp(path, base) || !strcmp(path_get_extension(path), "auto"))
+      return NULL;
+   return base;
+}
+
+/**
+ * state_compress:
+ * @path      : path of saved state that shall be written to.
+ * @data      : serialized state, clobbered on success.
+ * @size      : size of @data.
+ * @out_size  : set to the size of the returned data.
+ *
+ * Returns: compressed state which has to be free()'d, or NULL
+ * if compression is disabled or failed, and @data should be
+ * written out as is.
+ **/
+static void *state_compress(const char *path, void *data,
+      size_t size, size_t *out_size)
+{
+   void *out = NULL;
+#ifdef HAVE_ZLIB_DEFLATE
+   char name[PATH_MAX_LENGTH];
+   settings_t *settings = config_get_ptr();
+   bool is_delta        = false;
+
+   if (settings->savestate_compression)
+      out = state_encode(state_delta_base(path), data, size, out_size);
+
+   if (out)
+      is_delta = state_container_base_name((const uint8_t*)out,
+            *out_size, name, sizeof(name));
+
+   /* Every save may leave a frozen base behind. */
+   state_prune_bases(is_delta ? name : NULL);
+#endif
+   return out;
+}
+
+#ifdef HAVE_MMAP
+/**
+ * save_state_mmap:
+ * @path      : path of saved state that shall be written to.
+ * @size      : serialized size of the state.
+ * @ret       : set to whether the state was saved.
+ *
+ * Serializes straight into a mapping of a temporary file,
+ * which is renamed to @path on success, so a failed save
+ * doesn't destroy the previous state.
+ *
+ * The blocks of the file are reserved up front, as running out
+ * of disk space while writing to the mapping raises SIGBUS.
+ * Where they can't be reserved, the regular path is used.
+ *
+ * Returns: false if the mapping could not be set up, and
+ * the regular path should be used instead, otherwise true.
+ **/
+static bool save_state_mmap(const char *path, size_t size, bool *ret)
+{
+#if defined(__linux__)
+   int fd, len;
+   void *map = NULL;
+   char tmp_path[PATH_MAX_LENGTH];
+
+   *ret = false;
+
+   /* A truncated name could be @path itself, which O_TRUNC
+    * would wipe before the state is serialized. */
+   len = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+   if (len < 0 || (size_t)len >= sizeof(tmp_path))
+      return false;
+
+   fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      return false;
+
+   if (posix_fallocate(fd, 0, size) != 0)
+      goto error;
+
+   map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (map == MAP_FAILED)
+      goto error;
+
+   *ret = pretro_serialize(map, size);
+
+   munmap(map, size);
+   close(fd);
+
+   if (*ret)
+      *ret = rename(tmp_path, path) == 0;
+   if (!*ret)
+      remove(tmp_path);
+
+   return true;
+
+error:
+   close(fd);
+   remove(tmp_path);
+   return false;
+#else
+   (void)path;
+   (void)size;
+   *ret = false;
+   return false;
+#endif
+}
+#endif
+
 /**
  * save_state:
  * @path      : path of saved state that shall be written to.
@@ -144,14 +1058,32 @@ bool save_state(const char *path)
 {
    bool ret = false;
    void *data = NULL;
+   void *compressed = NULL;
+   size_t compressed_size = 0;
    size_t size = pretro_serialize_size();
+   settings_t *settings = config_get_ptr();
 
    RARCH_LOG("Saving state: \"%s\".\n", path);
 
    if (size == 0)
       return false;
 
-   data = malloc(size);
+   RARCH_LOG("State size: %d bytes.\n", (int)size);
+
+#ifdef HAVE_MMAP
+   if (!settings->savestate_compression && save_state_mmap(path, size, &ret))
+   {
+      if (!ret)
+         RARCH_ERR("Failed to save state to \"%s\".\n", path);
+#ifdef HAVE_ZLIB_DEFLATE
+      else
+         state_prune_bases(NULL);
+#endif
+      return ret;
+   }
+#endif
+
+   data = content_state_buffer_get(size);
 
    if (!data)
    {
@@ -159,18 +1091,120 @@ bool save_state(const char *path)
       return false;
    }
 
-   RARCH_LOG("State size: %d bytes.\n", (int)size);
    ret = pretro_serialize(data, size);
 
    if (ret)
-      ret = write_file(path, data, size);
+      compressed = state_compress(path, data, size, &compressed_size);
+
+   if (compressed)
+      ret = write_file_atomic(path, compressed, compressed_size);
+   else if (ret)
+      ret = write_file_atomic(path, data, size);
+
+   free(compressed);
 
    if (!ret)
       RARCH_ERR("Failed to save state to \"%s\".\n", path);
 
+   return ret;
+}
+
+/**
+ * save_state_async:
+ * @path      : path of saved state that shall be written to.
+ * @msg       : message to display once the state has been written.
+ *
+ * Serializes a state into memory and hands it over to the
+ * data runloop, which writes it to disk in the background.
+ *
+ * Returns: true if the state was queued for writing, false
+ * if it could not be serialized or queued.
+ **/
+bool save_state_async(const char *path, const char *msg)
+{
+   void *data             = NULL;
+   void *compressed       = NULL;
+   size_t compressed_size = 0;
+   size_t size            = pretro_serialize_size();
+
+   RARCH_LOG("Saving state in the background: \"%s\".\n", path);
+
+   if (size == 0)
+      return false;
+
+   data = malloc(size);
+
+   if (!data)
+   {
+      RARCH_ERR("Failed to allocate memory for save state buffer.\n");
+      return false;
+   }
+
+   if (!pretro_serialize(data, size))
+      goto error;
+
+   /* Deltas are made against the base slot as it is on disk,
+    * which may still be pending. */
+   rarch_main_data_state_flush();
+
+   compressed = state_compress(path, data, size, &compressed_size);
+   if (compressed)
+   {
+      free(data);
+      data = compressed;
+      size = compressed_size;
+   }
+
+   if (!rarch_main_data_state_push(path, msg, data, size))
+      goto error;
+
+   return true;
+
+error:
    free(data);
+   return false;
+}
 
-   return ret;
+/**
+ * read_state_file:
+ * @path      : path that state will be loaded from.
+ * @buf       : set to the contents of the file.
+ * @size      : set to the size of the file.
+ * @mapped    : set to the size of the mapping, see release_file(),
+ *              or 0 if @buf is the state buffer.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool read_state_file(const char *path, void **buf,
+      ssize_t *size, size_t *mapped)
+{
+   long len;
+   FILE *file = NULL;
+
+   *mapped = 0;
+
+   if (map_file(path, 0, buf, size, mapped))
+      return true;
+
+   file = fopen(path, "rb");
+   if (!file)
+      return false;
+
+   if (fseek(file, 0, SEEK_END) != 0 || (len = ftell(file)) < 0)
+      goto error;
+   rewind(file);
+
+   *buf  = content_state_buffer_get(len);
+   *size = len;
+   if (!*buf || fread(*buf, 1, len, file) != (size_t)len)
+      goto error;
+
+   fclose(file);
+   return true;
+
+error:
+   fclose(file);
+   return false;
 }
 
 /**
@@ -184,13 +1218,20 @@ bool save_state(const char *path)
 bool load_state(const char *path)
 {
    unsigned i;
-   ssize_t size;
+   ssize_t size              = 0;
+   size_t mapped             = 0;
    unsigned num_blocks       = 0;
    void *buf                 = NULL;
+   void *decoded             = NULL;
    struct sram_block *blocks = NULL;
    settings_t *settings      = config_get_ptr();
    global_t *global          = global_get_ptr();
-   bool ret                  = read_file(path, &buf, &size);
+   bool ret                  = false;
+
+   /* Don't read a state that is still being written out. */
+   rarch_main_data_state_flush();
+
+   ret = read_state_file(path, &buf, &size, &mapped);
 
    RARCH_LOG("Loading state: \"%s\".\n", path);
 
@@ -200,6 +1241,29 @@ bool load_state(const char *path)
       return false;
    }
 
+   if (state_is_container(buf, size))
+   {
+      size_t decoded_size = 0;
+
+#ifdef HAVE_ZLIB_DEFLATE
+      decoded = state_decode(path, buf, size, &decoded_size, true);
+#else
+      RARCH_ERR("Compressed states are not supported in this build.\n");
+#endif
+      if (mapped)
+         release_file(buf, mapped);
+      mapped = 0;
+
+      if (!decoded)
+      {
+         RARCH_ERR("Failed to load state from \"%s\".\n", path);
+         return false;
+      }
+
+      buf  = decoded;
+      size = decoded_size;
+   }
+
    RARCH_LOG("State size: %u bytes.\n", (unsigned)size);
 
    if (settings->block_sram_overwrite && global->savefiles
@@ -251,7 +1315,9 @@ bool load_state(const char *path)
    for (i = 0; i < num_blocks; i++)
       free(blocks[i].data);
    free(blocks);
-   free(buf);
+   if (mapped)
+      release_file(buf, mapped);
+   free(decoded);
    return ret;
 }
 
@@ -313,7 +1379,7 @@ void save_ram_file(const char *path, int type)
    if (size <= 0)
       return;
 
-   if (!write_file(path, data, size))
+   if (!write_file_atomic(path, data, size))
    {
       RARCH_ERR("Failed to save SRAM.\n");
       RARCH_WARN("Attempting to recover ...\n");
@@ -325,14 +1391,15 @@ void save_ram_file(const char *path, int type)
 }
 
 static bool load_content_dont_need_fullpath(
-      struct retro_game_info *info, unsigned i, const char *path)
+      struct retro_game_info *info, unsigned i, const char *path,
+      size_t *mapped)
 {
    ssize_t len;
    /* Load the content into memory. */
 
    /* First content file is significant, attempt to do patching,
     * CRC checking, etc. */
-   bool ret = read_content_file(i, path, (void**)&info->data, &len);
+   bool ret = read_content_file(i, path, (void**)&info->data, &len, mapped);
 
    if (!ret || len < 0)
    {
@@ -430,10 +1497,13 @@ static bool load_content(const struct retro_subsystem_info *special,
    struct string_list* additional_path_allocs = string_list_new();
    struct retro_game_info *info = (struct retro_game_info*)
       calloc(content->size, sizeof(*info));
+   size_t *mapped = (size_t*)calloc(content->size, sizeof(*mapped));
 
-   if (!info)
+   if (!info || !mapped)
    {
       string_list_free(additional_path_allocs);
+      free(info);
+      free(mapped);
       return false;
    }
 
@@ -458,7 +1528,8 @@ static bool load_content(const struct retro_subsystem_info *special,
 
       if (!need_fullpath && *path)
       {
-         if (!load_content_dont_need_fullpath(&info[i], i, path))
+         if (!load_content_dont_need_fullpath(&info[i], i, path,
+                  &mapped[i]))
             goto end;
       }
       else
@@ -479,14 +1550,21 @@ static bool load_content(const struct retro_subsystem_info *special,
 
    if (!ret)
       RARCH_ERR("Failed to load content.\n");
+   else
+      runahead_load_secondary(special,
+            (special || *content->elems[0].data) ? info : NULL,
+            content->size);
 
 end:
    for (i = 0; i < content->size; i++)
-      free((void*)info[i].data);
+   {
+      if (info[i].data)
+         release_file((void*)info[i].data, mapped[i]);
+   }
 
    string_list_free(additional_path_allocs);
-   if (info)
-      free(info);
+   free(mapped);
+   free(info);
    return ret;
 }
 
@@ -597,6 +1675,26 @@ bool init_content_file(void)
       if (ext && !strcasecmp(ext, "zip"))
       {
          char temporary_content[PATH_MAX_LENGTH];
+         struct content_extract *job = content_extract_finish(i,
+               content->elems[i].data);
+
+         if (job)
+         {
+            if (!job->ok)
+            {
+               RARCH_ERR("Failed to extract content from zipped file: %s.\n",
+                     job->archive);
+               goto error;
+            }
+
+            string_list_set(content, i, job->path);
+
+            /* Content extracted into memory has no file to clean up. */
+            if (job->to_file)
+               string_list_append(global->temporary_content,
+                     job->path, attr);
+            continue;
+         }
 
          strlcpy(temporary_content, content->elems[i].data,
                sizeof(temporary_content));
@@ -621,6 +1719,9 @@ bool init_content_file(void)
    ret = load_content(special, content);
 
 error:
+#ifdef HAVE_ZLIB
+   content_extract_free();
+#endif
    global->content_is_init = (ret) ? true : false;
 
    if (content)
@@ -49,6 +49,37 @@ bool load_state(const char *path);
  **/
 bool save_state(const char *path);
 
+/**
+ * save_state_async:
+ * @path      : path of saved state that shall be written to.
+ * @msg       : message to display once the state has been written.
+ *
+ * Snapshots a state into memory and writes it to disk
+ * in the background on the data runloop.
+ *
+ * Returns: true if the state was queued for writing, false otherwise.
+ **/
+bool save_state_async(const char *path, const char *msg);
+
+/**
+ * content_state_buffer_get:
+ * @size      : minimum size of the buffer.
+ *
+ * Gets a page-aligned scratch buffer for serialized states,
+ * which is reused between calls. The contents are only valid
+ * until the next call, and the buffer must not be freed.
+ *
+ * Returns: pointer to the buffer, or NULL on allocation failure.
+ **/
+void *content_state_buffer_get(size_t size);
+
+/**
+ * content_state_buffer_free:
+ *
+ * Frees the buffer returned by content_state_buffer_get().
+ **/
+void content_state_buffer_free(void);
+
 /**
  * load_ram_file:
  * @path             : path of RAM state that will be loaded from.
@@ -70,6 +101,14 @@ void load_ram_file(const char *path, int type);
  */
 void save_ram_file(const char *path, int type);
 
+/**
+ * content_extract_start:
+ *
+ * Starts extracting zipped content in the background, so it
+ * can overlap with the initialization of the core.
+ **/
+void content_extract_start(void);
+
 /**
  * init_content_file:
  *
@@ -15,8 +15,13 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include "core_info.h"
 #include "general.h"
+#include "file_ops.h"
 #include <file/file_path.h>
 #include "file_ext.h"
 #include <file/file_extract.h>
@@ -27,6 +32,282 @@
 #include "config.h"
 #endif
 
+#define CORE_INFO_CACHE_FILE    "core_info.cache"
+#define CORE_INFO_CACHE_MAGIC   "RACI"
+#define CORE_INFO_CACHE_VERSION 1
+
+/* The cache holds the contents of every .info file along with
+ * the size and modification time they had, so the files only
+ * have to be stat()ed rather than read. It is laid out as a
+ * header followed by the records, each one a record header
+ * followed by the NUL-terminated path and contents. */
+struct core_info_cache_header
+{
+   char magic[4];
+   uint32_t version;
+   uint32_t count;
+};
+
+struct core_info_cache_record_header
+{
+   uint64_t size;
+   uint64_t mtime;
+   uint32_t path_len;
+   uint32_t text_len;
+};
+
+typedef struct
+{
+   uint64_t size;
+   uint64_t mtime;
+   const char *path;
+   const char *text;
+   size_t text_len;
+   /* Whether path and text were allocated rather than
+    * pointing into the cache. */
+   bool allocated;
+} core_info_cache_record_t;
+
+typedef struct
+{
+   void *buf;
+   core_info_cache_record_t *records;
+   size_t count;
+} core_info_cache_t;
+
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   free(cache->buf);
+   free(cache->records);
+   memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * core_info_cache_load:
+ * @cache                : Cache to fill in.
+ * @path                 : Path of the cache file.
+ *
+ * Reads the cache file in one go. The records point into
+ * the buffer it was read into.
+ *
+ * Returns: true (1) if the cache was read, otherwise false (0).
+ **/
+static bool core_info_cache_load(core_info_cache_t *cache, const char *path)
+{
+   size_t i, pos;
+   struct core_info_cache_header header;
+   ssize_t len = 0;
+   uint8_t *buf = NULL;
+
+   memset(cache, 0, sizeof(*cache));
+
+   if (!path_file_exists(path))
+      return false;
+   if (!read_file(path, (void**)&buf, &len) || len < (ssize_t)sizeof(header))
+      goto error;
+
+   memcpy(&header, buf, sizeof(header));
+
+   if (memcmp(header.magic, CORE_INFO_CACHE_MAGIC, sizeof(header.magic)) != 0
+         || header.version != CORE_INFO_CACHE_VERSION
+         || header.count > (size_t)len)
+      goto error;
+
+   cache->buf     = buf;
+   cache->records = (core_info_cache_record_t*)
+      calloc(header.count + 1, sizeof(*cache->records));
+
+   if (!cache->records)
+      goto error;
+
+   pos = sizeof(header);
+
+   for (i = 0; i < header.count; i++)
+   {
+      struct core_info_cache_record_header rec;
+      core_info_cache_record_t *record = &cache->records[i];
+
+      if ((size_t)len - pos < sizeof(rec))
+         goto error;
+
+      memcpy(&rec, buf + pos, sizeof(rec));
+      pos += sizeof(rec);
+
+      if (!rec.path_len || !rec.text_len
+            || rec.path_len > (size_t)len - pos
+            || rec.text_len > (size_t)len - pos - rec.path_len
+            || buf[pos + rec.path_len - 1] != '\0'
+            || buf[pos + rec.path_len + rec.text_len - 1] != '\0')
+         goto error;
+
+      record->size     = rec.size;
+      record->mtime    = rec.mtime;
+      record->path     = (const char*)buf + pos;
+      record->text     = (const char*)buf + pos + rec.path_len;
+      record->text_len = rec.text_len - 1;
+      pos             += rec.path_len + rec.text_len;
+   }
+
+   cache->count = header.count;
+   return true;
+
+error:
+   if (cache->buf)
+      core_info_cache_free(cache);
+   else
+      free(buf);
+   return false;
+}
+
+/* Finds the record of @path, trying @hint first since the cores
+ * are usually listed in the same order as when it was saved. */
+static const core_info_cache_record_t *core_info_cache_find(
+      const core_info_cache_t *cache, const char *path, size_t hint)
+{
+   size_t i;
+
+   if (hint < cache->count && !strcmp(cache->records[hint].path, path))
+      return &cache->records[hint];
+
+   for (i = 0; i < cache->count; i++)
+      if (!strcmp(cache->records[i].path, path))
+         return &cache->records[i];
+
+   return NULL;
+}
+
+static void core_info_cache_free_records(core_info_cache_record_t *records,
+      size_t count)
+{
+   size_t i;
+
+   if (!records)
+      return;
+
+   for (i = 0; i < count; i++)
+   {
+      if (!records[i].allocated)
+         continue;
+      free((void*)records[i].path);
+      free((void*)records[i].text);
+   }
+
+   free(records);
+}
+
+/**
+ * core_info_cache_get:
+ * @cache                : Cache loaded from disk.
+ * @info_path            : Path of the .info file.
+ * @record               : Record to fill in for the cache to save.
+ * @hint                 : Where the record is likely to be in @cache.
+ * @dirty                : Set to true if @cache is out of date.
+ *
+ * Parses the .info file at @info_path from @cache, or from
+ * disk if the file has changed since the cache was saved.
+ * @record is left zeroed if there is no such file.
+ *
+ * Returns: config file of the .info file, or NULL.
+ **/
+static config_file_t *core_info_cache_get(const core_info_cache_t *cache,
+      const char *info_path, core_info_cache_record_t *record,
+      size_t hint, bool *dirty)
+{
+   struct stat st;
+   ssize_t len   = 0;
+   void *text    = NULL;
+   const core_info_cache_record_t *cached = NULL;
+
+   if (stat(info_path, &st) != 0)
+      return NULL;
+
+   cached = core_info_cache_find(cache, info_path, hint);
+
+   if (cached && cached->size == (uint64_t)st.st_size
+         && cached->mtime == (uint64_t)st.st_mtime)
+   {
+      *record = *cached;
+      return config_file_new_from_string(record->text);
+   }
+
+   *dirty = true;
+
+   if (!read_file(info_path, &text, &len) || len < 0)
+   {
+      free(text);
+      return NULL;
+   }
+
+   record->path      = strdup(info_path);
+   if (!record->path)
+   {
+      free(text);
+      return NULL;
+   }
+
+   record->size      = st.st_size;
+   record->mtime     = st.st_mtime;
+   record->text      = (const char*)text;
+   record->text_len  = strlen((const char*)text);
+   record->allocated = true;
+
+   return config_file_new_from_string(record->text);
+}
+
+/**
+ * core_info_cache_save:
+ * @path                 : Path of the cache file.
+ * @records              : Records to save.
+ * @count                : Number of @records.
+ *
+ * Writes the cache file in one go.
+ **/
+static void core_info_cache_save(const char *path,
+      const core_info_cache_record_t *records, size_t count)
+{
+   size_t i, pos;
+   uint8_t *buf = NULL;
+   size_t size  = sizeof(struct core_info_cache_header);
+   struct core_info_cache_header header;
+
+   for (i = 0; i < count; i++)
+      size += sizeof(struct core_info_cache_record_header)
+         + strlen(records[i].path) + 1 + records[i].text_len + 1;
+
+   buf = (uint8_t*)malloc(size);
+   if (!buf)
+      return;
+
+   memcpy(header.magic, CORE_INFO_CACHE_MAGIC, sizeof(header.magic));
+   header.version = CORE_INFO_CACHE_VERSION;
+   header.count   = count;
+   memcpy(buf, &header, sizeof(header));
+   pos            = sizeof(header);
+
+   for (i = 0; i < count; i++)
+   {
+      struct core_info_cache_record_header rec;
+
+      rec.size     = records[i].size;
+      rec.mtime    = records[i].mtime;
+      rec.path_len = strlen(records[i].path) + 1;
+      rec.text_len = records[i].text_len + 1;
+
+      memcpy(buf + pos, &rec, sizeof(rec));
+      pos += sizeof(rec);
+      memcpy(buf + pos, records[i].path, rec.path_len);
+      pos += rec.path_len;
+      memcpy(buf + pos, records[i].text, records[i].text_len);
+      pos += records[i].text_len;
+      buf[pos++] = '\0';
+   }
+
+   if (!write_file(path, buf, size))
+      RARCH_WARN("Failed to save core info cache: \"%s\".\n", path);
+
+   free(buf);
+}
+
 static void core_info_list_resolve_all_extensions(
       core_info_list_t *core_info_list)
 {
@@ -100,18 +381,187 @@ static void core_info_list_resolve_all_firmware(
    }
 }
 
+typedef struct
+{
+   uint32_t hash;
+   char *ext;
+   size_t *cores;
+   size_t num_cores;
+   size_t cap_cores;
+} core_info_ext_slot_t;
+
+/* Open addressing hash table from lowercase extension to the
+ * indices of the cores supporting it, at most half full. */
+struct core_info_ext_index
+{
+   core_info_ext_slot_t *slots;
+   size_t size;
+
+   /* Scratch space for core_info_list_get_supported_cores(),
+    * marks[i] == mark once core i has been picked. */
+   core_info_t *supported;
+   uint32_t *marks;
+   uint32_t mark;
+};
+
+static uint32_t core_info_ext_hash(const char *ext)
+{
+   uint32_t hash = 5381;
+
+   for (; *ext; ext++)
+      hash = (hash << 5) + hash + (uint8_t)tolower((uint8_t)*ext);
+
+   return hash;
+}
+
+static core_info_ext_slot_t *core_info_ext_index_find(
+      const struct core_info_ext_index *index, const char *ext)
+{
+   uint32_t hash = core_info_ext_hash(ext);
+   size_t    pos = hash & (index->size - 1);
+
+   for (; index->slots[pos].ext; pos = (pos + 1) & (index->size - 1))
+      if (index->slots[pos].hash == hash
+            && !strcasecmp(index->slots[pos].ext, ext))
+         break;
+
+   return &index->slots[pos];
+}
+
+static bool core_info_ext_index_add(struct core_info_ext_index *index,
+      const char *ext, size_t core)
+{
+   core_info_ext_slot_t *slot = NULL;
+
+   /* Extensions match with or without a leading dot. */
+   if (*ext == '.')
+      ext++;
+
+   slot = core_info_ext_index_find(index, ext);
+
+   if (!slot->ext)
+   {
+      if (!(slot->ext = strdup(ext)))
+         return false;
+      slot->hash = core_info_ext_hash(ext);
+   }
+
+   if (slot->num_cores && slot->cores[slot->num_cores - 1] == core)
+      return true;
+
+   if (slot->num_cores == slot->cap_cores)
+   {
+      size_t cap   = slot->cap_cores ? slot->cap_cores * 2 : 4;
+      size_t *cores = (size_t*)realloc(slot->cores, cap * sizeof(*cores));
+
+      if (!cores)
+         return false;
+
+      slot->cores     = cores;
+      slot->cap_cores = cap;
+   }
+
+   slot->cores[slot->num_cores++] = core;
+   return true;
+}
+
+static void core_info_ext_index_free(struct core_info_ext_index *index)
+{
+   size_t i;
+
+   if (!index)
+      return;
+
+   for (i = 0; i < index->size; i++)
+   {
+      free(index->slots[i].ext);
+      free(index->slots[i].cores);
+   }
+
+   free(index->slots);
+   free(index->supported);
+   free(index->marks);
+   free(index);
+}
+
+/**
+ * core_info_ext_index_new:
+ * @core_info_list       : Core info list.
+ *
+ * Indexes the cores of @core_info_list by the extensions
+ * they support.
+ *
+ * Returns: index on success, otherwise NULL.
+ **/
+static struct core_info_ext_index *core_info_ext_index_new(
+      const core_info_list_t *core_info_list)
+{
+   size_t i, j, num_exts = 0;
+   struct core_info_ext_index *index = (struct core_info_ext_index*)
+      calloc(1, sizeof(*index));
+
+   if (!index)
+      return NULL;
+
+   for (i = 0; i < core_info_list->count; i++)
+      if (core_info_list->list[i].supported_extensions_list)
+         num_exts += core_info_list->list[i].supported_extensions_list->size;
+
+   for (index->size = 16; index->size < num_exts * 2; index->size *= 2);
+
+   index->slots     = (core_info_ext_slot_t*)
+      calloc(index->size, sizeof(*index->slots));
+   index->supported = (core_info_t*)
+      calloc(core_info_list->count + 1, sizeof(*index->supported));
+   index->marks     = (uint32_t*)
+      calloc(core_info_list->count + 1, sizeof(*index->marks));
+
+   if (!index->slots || !index->supported || !index->marks)
+      goto error;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const struct string_list *exts =
+         core_info_list->list[i].supported_extensions_list;
+
+      if (!exts)
+         continue;
+
+      for (j = 0; j < exts->size; j++)
+         if (!core_info_ext_index_add(index, exts->elems[j].data, i))
+            goto error;
+   }
+
+   return index;
+
+error:
+   core_info_ext_index_free(index);
+   return NULL;
+}
+
 core_info_list_t *core_info_list_new(const char *modules_path)
 {
    size_t i;
+   char cache_path[PATH_MAX_LENGTH];
+   core_info_cache_t cache;
    core_info_t *core_info = NULL;
    core_info_list_t *core_info_list = NULL;
+   core_info_cache_record_t *records = NULL;
+   size_t num_records = 0;
+   bool cache_dirty   = false;
    settings_t *settings = config_get_ptr();
+   const char *info_dir = (*settings->libretro_info_path) ?
+      settings->libretro_info_path : modules_path;
    struct string_list *contents = (struct string_list*)
       dir_list_new(modules_path, EXT_EXECUTABLES, false);
 
    if (!contents)
       return NULL;
 
+   fill_pathname_join(cache_path, info_dir, CORE_INFO_CACHE_FILE,
+         sizeof(cache_path));
+   cache_dirty = !core_info_cache_load(&cache, cache_path);
+
    core_info_list = (core_info_list_t*)calloc(1, sizeof(*core_info_list));
    if (!core_info_list)
       goto error;
@@ -123,6 +573,11 @@ core_info_list_t *core_info_list_new(const char *modules_path)
    core_info_list->list = core_info;
    core_info_list->count = contents->size;
 
+   records = (core_info_cache_record_t*)
+      calloc(contents->size + 1, sizeof(*records));
+   if (!records)
+      goto error;
+
    for (i = 0; i < contents->size; i++)
    {
       char info_path_base[PATH_MAX_LENGTH], info_path[PATH_MAX_LENGTH];
@@ -143,11 +598,14 @@ core_info_list_t *core_info_list_new(const char *modules_path)
 
       strlcat(info_path_base, ".info", sizeof(info_path_base));
 
-      fill_pathname_join(info_path, (*settings->libretro_info_path) ?
-            settings->libretro_info_path : modules_path,
+      fill_pathname_join(info_path, info_dir,
             info_path_base, sizeof(info_path));
 
-      core_info[i].data = config_file_new(info_path);
+      core_info[i].data = core_info_cache_get(&cache, info_path,
+            &records[num_records], num_records, &cache_dirty);
+
+      if (records[num_records].path)
+         num_records++;
 
       if (core_info[i].data)
       {
@@ -211,13 +669,24 @@ core_info_list_t *core_info_list_new(const char *modules_path)
          core_info[i].display_name = strdup(path_basename(core_info[i].path));
    }
 
+   if (cache_dirty || num_records != cache.count)
+      core_info_cache_save(cache_path, records, num_records);
+
    core_info_list_resolve_all_extensions(core_info_list);
    core_info_list_resolve_all_firmware(core_info_list);
 
+   core_info_list->ext_index = core_info_ext_index_new(core_info_list);
+   if (!core_info_list->ext_index)
+      goto error;
+
+   core_info_cache_free_records(records, num_records);
+   core_info_cache_free(&cache);
    dir_list_free(contents);
    return core_info_list;
 
 error:
+   core_info_cache_free_records(records, num_records);
+   core_info_cache_free(&cache);
    if (contents)
       dir_list_free(contents);
    core_info_list_free(core_info_list);
@@ -267,6 +736,7 @@ void core_info_list_free(core_info_list_t *core_info_list)
       free(info->firmware);
    }
 
+   core_info_ext_index_free(core_info_list->ext_index);
    free(core_info_list->all_ext);
    free(core_info_list->list);
    free(core_info_list);
@@ -358,72 +828,91 @@ const char *core_info_list_get_all_extensions(core_info_list_t *core_info_list)
    return core_info_list->all_ext;
 }
 
-/* qsort_r() is not in standard C, sadly. */
-static const char *core_info_tmp_path;
-static const struct string_list *core_info_tmp_list;
-
 static int core_info_qsort_cmp(const void *a_, const void *b_)
 {
    const core_info_t *a = (const core_info_t*)a_;
    const core_info_t *b = (const core_info_t*)b_;
-   int support_a        = core_info_does_support_any_file(a, core_info_tmp_list) ||
-      core_info_does_support_file(a, core_info_tmp_path);
-   int support_b        = core_info_does_support_any_file(b, core_info_tmp_list) ||
-      core_info_does_support_file(b, core_info_tmp_path);
 
-   if (support_a != support_b)
-      return support_b - support_a;
    return strcasecmp(a->display_name, b->display_name);
 }
 
-void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
-      const char *path, const core_info_t **infos, size_t *num_infos)
+/**
+ * core_info_list_pick_cores:
+ * @core_info_list       : Core info list.
+ * @path                 : Path whose extension to look up.
+ * @num_infos            : Number of cores picked so far.
+ *
+ * Appends the cores supporting the extension of @path that
+ * haven't been picked yet to the supported cores.
+ **/
+static void core_info_list_pick_cores(core_info_list_t *core_info_list,
+      const char *path, size_t *num_infos)
 {
-   struct string_list *list = NULL;
-   size_t supported = 0, i;
+   size_t i;
+   struct core_info_ext_index *index = core_info_list->ext_index;
+   const core_info_ext_slot_t *slot  =
+      core_info_ext_index_find(index, path_get_extension(path));
 
-   if (!core_info_list)
+   if (!slot->ext)
       return;
 
-   (void)list;
+   for (i = 0; i < slot->num_cores; i++)
+   {
+      size_t core = slot->cores[i];
+
+      if (index->marks[core] == index->mark)
+         continue;
 
-   core_info_tmp_path = path;
+      index->marks[core]              = index->mark;
+      index->supported[(*num_infos)++] = core_info_list->list[core];
+   }
+}
 
-#ifdef HAVE_ZLIB
-   if (!strcasecmp(path_get_extension(path), "zip"))
-      list = zlib_get_file_list(path, NULL);
-   core_info_tmp_list = list;
-#endif
+void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
+      const char *path, const core_info_t **infos, size_t *num_infos)
+{
+   size_t supported = 0;
+   struct core_info_ext_index *index = NULL;
+
+   if (!core_info_list || !core_info_list->ext_index)
+      return;
 
-   /* Let supported core come first in list so we can return 
-    * a pointer to them. */
-   qsort(core_info_list->list, core_info_list->count,
-         sizeof(core_info_t), core_info_qsort_cmp);
+   index = core_info_list->ext_index;
 
-   for (i = 0; i < core_info_list->count; i++, supported++)
+   /* Wrapping around would leave stale marks behind. */
+   if (++index->mark == 0)
    {
-      const core_info_t *core = &core_info_list->list[i];
-
-      if (!core)
-         continue;
+      memset(index->marks, 0, core_info_list->count * sizeof(*index->marks));
+      index->mark = 1;
+   }
 
-      if (core_info_does_support_file(core, path))
-         continue;
+   if (path)
+   {
+      core_info_list_pick_cores(core_info_list, path, &supported);
 
 #ifdef HAVE_ZLIB
-      if (core_info_does_support_any_file(core, list))
-         continue;
-#endif
+      if (!strcasecmp(path_get_extension(path), "zip"))
+      {
+         struct string_list *list = zlib_get_file_list(path, NULL);
 
-      break;
-   }
+         if (list)
+         {
+            size_t i;
 
-#ifdef HAVE_ZLIB
-   if (list)
-      string_list_free(list);
+            for (i = 0; i < list->size; i++)
+               core_info_list_pick_cores(core_info_list,
+                     list->elems[i].data, &supported);
+
+            string_list_free(list);
+         }
+      }
 #endif
+   }
+
+   qsort(index->supported, supported, sizeof(*index->supported),
+         core_info_qsort_cmp);
 
-   *infos = core_info_list->list;
+   *infos     = index->supported;
    *num_infos = supported;
 }
 
@@ -64,11 +64,15 @@ typedef struct
    void *userdata;
 } core_info_t;
 
+struct core_info_ext_index;
+
 typedef struct
 {
    core_info_t *list;
    size_t count;
    char *all_ext;
+   /* Cores by supported extension. */
+   struct core_info_ext_index *ext_index;
 } core_info_list_t;
 
 core_info_list_t *core_info_list_new(const char *modules_path);
@@ -82,7 +86,8 @@ bool core_info_does_support_file(const core_info_t *info,
 bool core_info_does_support_any_file(const core_info_t *info,
       const struct string_list *list);
 
-/* Non-reentrant, does not allocate. Returns pointer to internal state. */
+/* Non-reentrant, does not allocate. Returns pointer to internal state,
+ * shallow copies of the supporting cores sorted by display name. */
 void core_info_list_get_supported_cores(core_info_list_t *list,
       const char *path, const core_info_t **infos, size_t *num_infos);
 
@@ -15,6 +15,7 @@
  */
 
 #include "core_options.h"
+#include <stdint.h>
 #include <string.h>
 #include <file/config_file.h>
 #include <file/dir_list.h>
@@ -38,8 +39,121 @@ struct core_option_manager
    struct core_option *opts;
    size_t size;
    bool updated;
+   unsigned generation;
+
+   /* Open addressed index of the keys, holding option index + 1,
+    * 0 for a free slot. */
+   size_t *table;
+   uint32_t *hashes;
+   size_t mask;
 };
 
+static uint32_t core_option_hash(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (unsigned char)*key++;
+
+   return hash;
+}
+
+/**
+ * core_option_find:
+ * @opt              : options manager handle
+ * @key              : key of the option
+ *
+ * Returns: index of the option with @key, or the number of
+ * options if there is none.
+ **/
+static size_t core_option_find(core_option_manager_t *opt, const char *key)
+{
+   size_t i;
+   uint32_t hash;
+
+   if (!opt->table)
+   {
+      for (i = 0; i < opt->size; i++)
+         if (!strcmp(opt->opts[i].key, key))
+            break;
+      return i;
+   }
+
+   hash = core_option_hash(key);
+
+   for (i = hash & opt->mask; opt->table[i]; i = (i + 1) & opt->mask)
+   {
+      size_t idx = opt->table[i] - 1;
+
+      if (opt->hashes[i] == hash && !strcmp(opt->opts[idx].key, key))
+         return idx;
+   }
+
+   return opt->size;
+}
+
+/**
+ * core_option_build_index:
+ * @opt              : options manager handle
+ *
+ * Hashes the keys of the options for core_option_find().
+ * Without the memory for it, keys are searched linearly.
+ **/
+static void core_option_build_index(core_option_manager_t *opt)
+{
+   size_t i, idx, size = 16;
+
+   while (size < opt->size * 2)
+      size *= 2;
+
+   opt->table  = (size_t*)calloc(size, sizeof(*opt->table));
+   opt->hashes = (uint32_t*)calloc(size, sizeof(*opt->hashes));
+
+   if (!opt->table || !opt->hashes)
+   {
+      free(opt->table);
+      free(opt->hashes);
+      opt->table  = NULL;
+      opt->hashes = NULL;
+      return;
+   }
+
+   opt->mask = size - 1;
+
+   for (idx = 0; idx < opt->size; idx++)
+   {
+      const char *key = opt->opts[idx].key;
+      uint32_t hash   = core_option_hash(key);
+
+      /* Keep the first of several options sharing a key,
+       * that is the one a linear search would find. */
+      for (i = hash & opt->mask; opt->table[i]; i = (i + 1) & opt->mask)
+      {
+         if (opt->hashes[i] == hash &&
+               !strcmp(opt->opts[opt->table[i] - 1].key, key))
+            break;
+      }
+
+      if (opt->table[i])
+         continue;
+
+      opt->table[i]  = idx + 1;
+      opt->hashes[i] = hash;
+   }
+}
+
+/**
+ * core_option_changed:
+ * @opt              : options manager handle
+ *
+ * Marks the options as updated, for the core to read them again.
+ **/
+static void core_option_changed(core_option_manager_t *opt)
+{
+   opt->updated = true;
+   opt->generation++;
+}
+
 /**
  * core_option_free:
  * @opt              : options manager handle
@@ -62,26 +176,20 @@ void core_option_free(core_option_manager_t *opt)
 
    if (opt->conf)
       config_file_free(opt->conf);
+   free(opt->table);
+   free(opt->hashes);
    free(opt->opts);
    free(opt);
 }
 
 void core_option_get(core_option_manager_t *opt, struct retro_variable *var)
 {
-   size_t i;
+   size_t idx;
 
    opt->updated = false;
 
-   for (i = 0; i < opt->size; i++)
-   {
-      if (!strcmp(opt->opts[i].key, var->key))
-      {
-         var->value = core_option_get_val(opt, i);
-         return;
-      }
-   }
-
-   var->value = NULL;
+   idx = core_option_find(opt, var->key);
+   var->value = idx < opt->size ? core_option_get_val(opt, idx) : NULL;
 }
 
 static bool parse_variable(core_option_manager_t *opt, size_t idx,
@@ -181,6 +289,8 @@ core_option_manager_t *core_option_new(const char *conf_path,
          goto error;
    }
 
+   core_option_build_index(opt);
+
    return opt;
 
 error:
@@ -204,6 +314,20 @@ bool core_option_updated(core_option_manager_t *opt)
    return opt->updated;
 }
 
+/**
+ * core_option_generation:
+ * @opt              : options manager handle
+ *
+ * Returns: a counter bumped whenever a core option changes,
+ * to tell whether one changed since it was last read.
+ **/
+unsigned core_option_generation(core_option_manager_t *opt)
+{
+   if (!opt)
+      return 0;
+   return opt->generation;
+}
+
 /**
  * core_option_flush:
  * @opt              : options manager handle
@@ -303,7 +427,7 @@ void core_option_set_val(core_option_manager_t *opt,
       return;
 
    option->index = val_idx % option->vals->size;
-   opt->updated  = true;
+   core_option_changed(opt);
 }
 
 /**
@@ -322,7 +446,7 @@ void core_option_next(core_option_manager_t *opt, size_t idx)
       return;
 
    option->index = (option->index + 1) % option->vals->size;
-   opt->updated  = true;
+   core_option_changed(opt);
 }
 
 /**
@@ -343,7 +467,7 @@ void core_option_prev(core_option_manager_t *opt, size_t idx)
 
    option->index = (option->index + option->vals->size - 1) %
       option->vals->size;
-   opt->updated  = true;
+   core_option_changed(opt);
 }
 
 /**
@@ -359,5 +483,5 @@ void core_option_set_default(core_option_manager_t *opt, size_t idx)
       return;
 
    opt->opts[idx].index = 0;
-   opt->updated         = true;
+   core_option_changed(opt);
 }
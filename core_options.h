@@ -51,6 +51,18 @@ core_option_manager_t *core_option_new(const char *conf_path,
  **/
 bool core_option_updated(core_option_manager_t *opt);
 
+/**
+ * core_option_generation:
+ * @opt              : options manager handle
+ *
+ * Unlike the flag of core_option_updated(), which reading any
+ * option clears, the counter lets several readers keep track
+ * of changes on their own.
+ *
+ * Returns: a counter bumped whenever a core option changes.
+ **/
+unsigned core_option_generation(core_option_manager_t *opt);
+
 /**
  * core_option_flush:
  * @opt              : options manager handle
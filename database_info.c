@@ -24,11 +24,35 @@
 #include <file/file_path.h>
 #include "file_ext.h"
 #include <file/dir_list.h>
+#include <string/string_list.h>
+#include <retro_miscellaneous.h>
+#include "performance.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#ifdef HAVE_7ZIP
+#include "decompress/7zip_support.h"
+#endif
+
 int database_open_cursor(libretrodb_t *db,
       libretrodb_cursor_t *cur, const char *query)
 {
@@ -47,17 +71,616 @@ int database_open_cursor(libretrodb_t *db,
    return 0;
 }
 
+/* Files are hashed this much at a time instead of read whole. */
+#define DATABASE_SCAN_CHUNK_SIZE (64 * 1024)
+
+#define DATABASE_SCAN_MAX_THREADS 8
+
+/* How often the cache is written while scanning, so an interrupted
+ * scan can pick up where it stopped. */
+#define DATABASE_SCAN_CACHE_CHECKPOINT_USEC (30 * 1000000LL)
+
+enum database_scan_state
+{
+   DATABASE_SCAN_PENDING = 0,
+   DATABASE_SCAN_CRC,
+   DATABASE_SCAN_ARCHIVE,
+   DATABASE_SCAN_FAILED
+};
+
+typedef struct database_scan_entry
+{
+   enum database_scan_state state;
+   uint32_t crc;
+   uint64_t size;
+   int64_t mtime;
+   /* CRC was taken from the cache instead of hashed. */
+   bool cached;
+   /* Files in an archive, with their CRC32 in attr.i. */
+   struct string_list *members;
+} database_scan_entry_t;
+
+/* What an earlier scan found for a file. */
+typedef struct database_scan_cache_entry
+{
+   char *path;
+   uint64_t size;
+   int64_t mtime;
+   uint32_t crc;
+} database_scan_cache_entry_t;
+
+struct database_info_scan
+{
+   /* One per list entry, written once by whoever scanned it. */
+   database_scan_entry_t *entries;
+   size_t num_entries;
+   /* Sorted by path, read-only while scanning. */
+   database_scan_cache_entry_t *cache;
+   size_t cache_size;
+   size_t cache_hits;
+   char cache_path[PATH_MAX_LENGTH];
+   retro_time_t cache_written;
+   /* Files hashed since the cache was last written. */
+   bool cache_dirty;
+   /* Next list entry nobody has started on. */
+   size_t next;
+   uint8_t *chunk;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   sthread_t *threads[DATABASE_SCAN_MAX_THREADS];
+   unsigned num_threads;
+   bool quit;
+#endif
+};
+
+static int database_info_scan_cache_cmp(const void *a, const void *b)
+{
+   const database_scan_cache_entry_t *left  =
+      (const database_scan_cache_entry_t*)a;
+   const database_scan_cache_entry_t *right =
+      (const database_scan_cache_entry_t*)b;
+
+   return strcmp(left->path, right->path);
+}
+
+static const database_scan_cache_entry_t *database_info_scan_cache_find(
+      const struct database_info_scan *scan, const char *path)
+{
+   database_scan_cache_entry_t key;
+
+   if (!scan->cache_size)
+      return NULL;
+
+   key.path = (char*)path;
+   return (const database_scan_cache_entry_t*)bsearch(&key, scan->cache,
+         scan->cache_size, sizeof(*scan->cache),
+         database_info_scan_cache_cmp);
+}
+
 #ifdef HAVE_ZLIB
-static int zlib_compare_crc32(const char *name, const char *valid_exts,
-      const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
+static int database_info_scan_zip_cb(const char *name, uint32_t size,
       uint32_t crc32, void *userdata)
 {
-   RARCH_LOG("CRC32: 0x%x\n", crc32);
+   union string_list_elem_attr attr;
+
+   attr.i = (int)crc32;
+   return string_list_append((struct string_list*)userdata, name, attr);
+}
+#endif
+
+#ifdef HAVE_7ZIP
+static int database_info_scan_7zip_cb(const char *name, uint64_t size,
+      uint32_t crc32, bool crc_defined, void *userdata)
+{
+   union string_list_elem_attr attr;
+
+   /* Only files in solid blocks too large to decode while
+    * scanning come without a CRC. */
+   if (!crc_defined)
+      return 1;
+
+   attr.i = (int)crc32;
+   return string_list_append((struct string_list*)userdata, name, attr);
+}
+#endif
+
+/* Archives are not extracted to disk, the CRCs come from their
+ * headers, or from a single decode pass for 7z files lacking them. */
+static enum database_scan_state database_info_scan_archive(const char *name,
+      database_scan_entry_t *entry)
+{
+   bool parsed      = false;
+   const char *ext  = path_get_extension(name);
+
+   if (!(entry->members = string_list_new()))
+      return DATABASE_SCAN_FAILED;
+
+#ifdef HAVE_ZLIB
+   if (!strcmp(ext, "zip"))
+      parsed = zlib_parse_file_crc(name,
+            database_info_scan_zip_cb, entry->members);
+#endif
+#ifdef HAVE_7ZIP
+   if (!strcmp(ext, "7z"))
+      parsed = read_7zip_file_crc(name,
+            database_info_scan_7zip_cb, entry->members);
+#endif
+
+   if (!parsed)
+   {
+      string_list_free(entry->members);
+      entry->members = NULL;
+      return DATABASE_SCAN_FAILED;
+   }
+
+   return DATABASE_SCAN_ARCHIVE;
+}
+
+static enum database_scan_state database_info_scan_file(
+      const struct database_info_scan *scan, const char *name,
+      uint8_t *chunk, database_scan_entry_t *entry)
+{
+   FILE *file;
+   size_t len;
+   struct stat st;
+   void *map       = NULL;
+   ssize_t map_len = 0;
+   size_t mapped   = 0;
+   const database_scan_cache_entry_t *cached = NULL;
+
+   if (!strcmp(path_get_extension(name), "zip") ||
+         !strcmp(path_get_extension(name), "7z"))
+      return database_info_scan_archive(name, entry);
+
+   if (stat(name, &st) != 0)
+      return DATABASE_SCAN_FAILED;
+
+   entry->size  = st.st_size;
+   entry->mtime = st.st_mtime;
+
+   cached = database_info_scan_cache_find(scan, name);
+   if (cached && cached->size == entry->size && cached->mtime == entry->mtime)
+   {
+      entry->crc    = cached->crc;
+      entry->cached = true;
+      return DATABASE_SCAN_CRC;
+   }
+
+   entry->crc = 0;
+
+   /* Hash large files straight from the page cache. */
+   if (map_file(name, DATABASE_SCAN_CHUNK_SIZE, &map, &map_len, &mapped))
+   {
+      entry->crc = crc32_update(0, (const uint8_t*)map, map_len);
+      release_file(map, mapped);
+      return DATABASE_SCAN_CRC;
+   }
+
+   if (!(file = fopen(name, "rb")))
+      return DATABASE_SCAN_FAILED;
+
+   while ((len = fread(chunk, 1, DATABASE_SCAN_CHUNK_SIZE, file)) > 0)
+      entry->crc = crc32_update(entry->crc, chunk, len);
+
+   if (ferror(file))
+   {
+      fclose(file);
+      return DATABASE_SCAN_FAILED;
+   }
+
+   fclose(file);
+   return DATABASE_SCAN_CRC;
+}
+
+#ifdef HAVE_THREADS
+static void database_info_scan_thread(void *data)
+{
+   database_info_handle_t *db      = (database_info_handle_t*)data;
+   struct database_info_scan *scan = db->scan;
+   uint8_t *chunk = (uint8_t*)malloc(DATABASE_SCAN_CHUNK_SIZE);
+
+   if (!chunk)
+      return;
+
+   for (;;)
+   {
+      size_t i;
+      database_scan_entry_t entry = {0};
+
+      slock_lock(scan->lock);
+      if (scan->quit || scan->next >= db->list->size)
+      {
+         slock_unlock(scan->lock);
+         break;
+      }
+      i = scan->next++;
+      slock_unlock(scan->lock);
+
+      entry.state = database_info_scan_file(scan,
+            db->list->elems[i].data, chunk, &entry);
+
+      slock_lock(scan->lock);
+      scan->entries[i] = entry;
+      slock_unlock(scan->lock);
+   }
+
+   free(chunk);
+}
+#endif
+
+/**
+ * database_info_scan_cache_path:
+ * @dir                : Directory being scanned.
+ * @path               : Cache path for @dir.
+ * @size               : Size of @path.
+ *
+ * Each scanned directory gets its own cache, next to the
+ * playlists or else next to the config file.
+ *
+ * Returns: true (1) if there is somewhere to keep the cache,
+ * otherwise false (0).
+ **/
+static bool database_info_scan_cache_path(const char *dir,
+      char *path, size_t size)
+{
+   char name[PATH_MAX_LENGTH];
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+
+   snprintf(name, sizeof(name), "scan_%08x.rdb",
+         (unsigned)crc32_calculate((const uint8_t*)dir, strlen(dir)));
+
+   if (*settings->playlist_directory)
+      fill_pathname_join(path, settings->playlist_directory, name, size);
+   else if (*global->config_path)
+      fill_pathname_resolve_relative(path, global->config_path, name, size);
+   else
+      return false;
+
+   return true;
+}
+
+static bool database_info_scan_cache_parse(
+      const struct rmsgpack_dom_value *item,
+      database_scan_cache_entry_t *entry)
+{
+   unsigned i;
+   bool has_crc = false;
+
+   if (item->type != RDT_MAP)
+      return false;
+
+   for (i = 0; i < item->map.len; i++)
+   {
+      const struct rmsgpack_dom_value *key = &item->map.items[i].key;
+      const struct rmsgpack_dom_value *val = &item->map.items[i].value;
+
+      if (key->type != RDT_STRING)
+         continue;
+
+      if (!strcmp(key->string.buff, "path") && val->type == RDT_STRING)
+         entry->path = val->string.buff;
+      else if (!strcmp(key->string.buff, "size") && val->type == RDT_UINT)
+         entry->size = val->uint_;
+      else if (!strcmp(key->string.buff, "mtime") &&
+            (val->type == RDT_INT || val->type == RDT_UINT))
+         entry->mtime = val->int_;
+      else if (!strcmp(key->string.buff, "crc") &&
+            val->type == RDT_BINARY && val->binary.len == 4)
+      {
+         const uint8_t *crc = (const uint8_t*)val->binary.buff;
+         entry->crc = ((uint32_t)crc[0] << 24) | (crc[1] << 16) |
+            (crc[2] << 8) | crc[3];
+         has_crc = true;
+      }
+   }
+
+   return entry->path && has_crc;
+}
+
+static void database_info_scan_cache_load(struct database_info_scan *scan)
+{
+   libretrodb_t db;
+   libretrodb_cursor_t cur;
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_arena arena;
+   size_t capacity = 0;
+
+   if (libretrodb_open(scan->cache_path, &db) != 0)
+      return;
+
+   if (libretrodb_cursor_open(&db, &cur, NULL) != 0)
+   {
+      libretrodb_close(&db);
+      return;
+   }
+
+   rmsgpack_dom_arena_init(&arena, LIBRETRODB_ARENA_BLOCK_SIZE);
+
+   while (libretrodb_cursor_read_item_arena(&cur, &item, &arena) == 0)
+   {
+      database_scan_cache_entry_t entry = {0};
+
+      if (database_info_scan_cache_parse(&item, &entry))
+      {
+         if (scan->cache_size == capacity)
+         {
+            size_t new_capacity = capacity ? capacity * 2 : 256;
+            database_scan_cache_entry_t *cache =
+               (database_scan_cache_entry_t*)realloc(scan->cache,
+                     new_capacity * sizeof(*cache));
+
+            if (!cache)
+               break;
+
+            scan->cache = cache;
+            capacity    = new_capacity;
+         }
+
+         if ((entry.path = strdup(entry.path)))
+            scan->cache[scan->cache_size++] = entry;
+      }
+
+      rmsgpack_dom_arena_reset(&arena);
+   }
+
+   rmsgpack_dom_arena_free(&arena);
+   libretrodb_cursor_close(&cur);
+   libretrodb_close(&db);
+
+   if (scan->cache_size)
+      qsort(scan->cache, scan->cache_size, sizeof(*scan->cache),
+            database_info_scan_cache_cmp);
+
+   RARCH_LOG("Loaded %u cached scan results from \"%s\".\n",
+         (unsigned)scan->cache_size, scan->cache_path);
+}
+
+typedef struct database_scan_cache_writer
+{
+   database_info_handle_t *db;
+   size_t index;
+} database_scan_cache_writer_t;
+
+static void database_info_scan_cache_set(struct rmsgpack_dom_pair *pair,
+      const char *key)
+{
+   pair->key.type        = RDT_STRING;
+   pair->key.string.len  = strlen(key);
+   pair->key.string.buff = strdup(key);
+}
+
+static int database_info_scan_cache_value(void *ctx,
+      struct rmsgpack_dom_value *out)
+{
+   database_scan_cache_writer_t *writer = (database_scan_cache_writer_t*)ctx;
+   database_info_handle_t *db           = writer->db;
+   struct database_info_scan *scan      = db->scan;
+
+   /* libretrodb_create() hands us a zeroed item, and frees
+    * what we fill in once it has been written. */
+   while (writer->index < db->list->size)
+   {
+      uint8_t *crc;
+      database_scan_cache_entry_t entry;
+      struct rmsgpack_dom_pair *pairs = NULL;
+      size_t i                        = writer->index++;
+
+      entry.path = db->list->elems[i].data;
+
+      if (i < db->list_ptr)
+      {
+         /* Reported entries are final, workers are done with them. */
+         const database_scan_entry_t *scanned = &scan->entries[i];
+
+         if (scanned->state != DATABASE_SCAN_CRC)
+            continue;
+
+         entry.size  = scanned->size;
+         entry.mtime = scanned->mtime;
+         entry.crc   = scanned->crc;
+      }
+      else
+      {
+         /* Not reached yet, keep what the last scan had. */
+         const database_scan_cache_entry_t *cached =
+            database_info_scan_cache_find(scan, entry.path);
+
+         if (!cached)
+            continue;
+
+         entry = *cached;
+      }
+
+      pairs = (struct rmsgpack_dom_pair*)calloc(4, sizeof(*pairs));
+      crc   = (uint8_t*)malloc(4);
+      if (!pairs || !crc)
+      {
+         free(pairs);
+         free(crc);
+         return -1;
+      }
+
+      crc[0] = entry.crc >> 24;
+      crc[1] = entry.crc >> 16;
+      crc[2] = entry.crc >>  8;
+      crc[3] = entry.crc;
+
+      database_info_scan_cache_set(&pairs[0], "path");
+      pairs[0].value.type        = RDT_STRING;
+      pairs[0].value.string.len  = strlen(entry.path);
+      pairs[0].value.string.buff = strdup(entry.path);
+
+      database_info_scan_cache_set(&pairs[1], "size");
+      pairs[1].value.type        = RDT_UINT;
+      pairs[1].value.uint_       = entry.size;
+
+      database_info_scan_cache_set(&pairs[2], "mtime");
+      pairs[2].value.type        = RDT_INT;
+      pairs[2].value.int_        = entry.mtime;
+
+      database_info_scan_cache_set(&pairs[3], "crc");
+      pairs[3].value.type        = RDT_BINARY;
+      pairs[3].value.binary.len  = 4;
+      pairs[3].value.binary.buff = (char*)crc;
+
+      out->type      = RDT_MAP;
+      out->map.len   = 4;
+      out->map.items = pairs;
+
+      if (!pairs[0].key.string.buff || !pairs[1].key.string.buff ||
+            !pairs[2].key.string.buff || !pairs[3].key.string.buff ||
+            !pairs[0].value.string.buff)
+         return -1;
+
+      return 0;
+   }
 
    return 1;
 }
+
+/**
+ * database_info_scan_cache_write:
+ * @db                 : Scan handle.
+ *
+ * Writes what is known about every file in the list to the cache,
+ * through a temporary file so an interrupted write leaves the
+ * previous cache intact.
+ **/
+static void database_info_scan_cache_write(database_info_handle_t *db)
+{
+   int fd;
+   int rv;
+   char tmp_path[PATH_MAX_LENGTH + sizeof(".tmp")];
+   database_scan_cache_writer_t writer = {0};
+   struct database_info_scan *scan     = db->scan;
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", scan->cache_path);
+
+   fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+   if (fd < 0)
+   {
+      RARCH_WARN("Could not write scan cache \"%s\".\n", tmp_path);
+      return;
+   }
+
+   writer.db = db;
+   rv        = libretrodb_create(fd, database_info_scan_cache_value, &writer);
+   close(fd);
+
+   if (rv < 0)
+   {
+      RARCH_WARN("Could not write scan cache \"%s\".\n", tmp_path);
+      remove(tmp_path);
+      return;
+   }
+
+#ifdef _WIN32
+   remove(scan->cache_path);
+#endif
+   if (rename(tmp_path, scan->cache_path) != 0)
+   {
+      RARCH_WARN("Could not replace scan cache \"%s\".\n", scan->cache_path);
+      remove(tmp_path);
+      return;
+   }
+
+   scan->cache_written = rarch_get_time_usec();
+   scan->cache_dirty   = false;
+}
+
+static void database_info_scan_free(struct database_info_scan *scan)
+{
+   size_t i;
+
+#ifdef HAVE_THREADS
+   if (scan->lock)
+   {
+      slock_lock(scan->lock);
+      scan->quit = true;
+      slock_unlock(scan->lock);
+   }
+
+   for (i = 0; i < scan->num_threads; i++)
+      sthread_join(scan->threads[i]);
+
+   if (scan->lock)
+      slock_free(scan->lock);
 #endif
 
+   for (i = 0; scan->entries && i < scan->num_entries; i++)
+      string_list_free(scan->entries[i].members);
+   for (i = 0; i < scan->cache_size; i++)
+      free(scan->cache[i].path);
+   free(scan->cache);
+   free(scan->chunk);
+   free(scan->entries);
+   free(scan);
+}
+
+static struct database_info_scan *database_info_scan_new(
+      database_info_handle_t *db, const char *dir)
+{
+   struct database_info_scan *scan = (struct database_info_scan*)
+      calloc(1, sizeof(*scan));
+
+   if (!scan)
+      return NULL;
+
+   scan->entries = (database_scan_entry_t*)calloc(
+         db->list->size ? db->list->size : 1, sizeof(*scan->entries));
+   if (!scan->entries)
+      goto error;
+   scan->num_entries = db->list->size;
+
+   db->scan = scan;
+
+   /* Workers look files up in the cache, so it is loaded first. */
+   if (database_info_scan_cache_path(dir, scan->cache_path,
+            sizeof(scan->cache_path)))
+      database_info_scan_cache_load(scan);
+   scan->cache_written = rarch_get_time_usec();
+
+#ifdef HAVE_THREADS
+   {
+      unsigned i;
+      /* Hashing spends much of its time waiting on reads,
+       * so run more threads than cores to keep the disk busy. */
+      unsigned threads = min(rarch_get_cpu_cores() * 2,
+            DATABASE_SCAN_MAX_THREADS);
+
+      if (!(scan->lock = slock_new()))
+         goto error;
+
+      for (i = 0; i < threads; i++)
+      {
+         scan->threads[i] = sthread_create(database_info_scan_thread, db);
+         if (!scan->threads[i])
+            break;
+         scan->num_threads++;
+      }
+
+      if (scan->num_threads)
+      {
+         RARCH_LOG("Scanning %u files on %u threads.\n",
+               (unsigned)db->list->size, scan->num_threads);
+         return scan;
+      }
+   }
+#endif
+
+   /* Scan on the caller, one file per iteration. */
+   if (!(scan->chunk = (uint8_t*)malloc(DATABASE_SCAN_CHUNK_SIZE)))
+      goto error;
+
+   return scan;
+
+error:
+   db->scan = NULL;
+   database_info_scan_free(scan);
+   return NULL;
+}
+
 database_info_handle_t *database_info_init(const char *dir, enum database_type type)
 {
    const char *exts                = "";
@@ -79,11 +702,17 @@ database_info_handle_t *database_info_init(const char *dir, enum database_type t
    db->status         = DATABASE_STATUS_ITERATE;
    db->type           = type;
 
+   if (!database_info_scan_new(db, dir))
+      goto error;
+
    return db;
 
 error:
    if (db)
+   {
+      string_list_free(db->list);
       free(db);
+   }
    return NULL;
 }
 
@@ -92,88 +721,123 @@ void database_info_free(database_info_handle_t *db)
    if (!db)
       return;
 
+   if (db->scan)
+   {
+      /* Also covers scans cut short, which resume from here. */
+      if (*db->scan->cache_path && db->list_ptr)
+         database_info_scan_cache_write(db);
+      database_info_scan_free(db->scan);
+   }
    string_list_free(db->list);
    free(db);
 }
 
+static void database_info_scan_report(struct database_info_scan *scan,
+      database_scan_entry_t *entry, const char *name)
+{
+   if (entry->state == DATABASE_SCAN_ARCHIVE)
+   {
+      size_t i;
+
+      for (i = 0; i < entry->members->size; i++)
+         RARCH_LOG("CRC32: 0x%x (%s#%s).\n",
+               (unsigned)entry->members->elems[i].attr.i, name,
+               entry->members->elems[i].data);
+
+      string_list_free(entry->members);
+      entry->members = NULL;
+      return;
+   }
+
+   if (entry->state != DATABASE_SCAN_CRC)
+      return;
+
+   if (entry->cached)
+      scan->cache_hits++;
+   else
+      scan->cache_dirty = true;
+
+   RARCH_LOG("CRC32: 0x%x (%s).\n", (unsigned)entry->crc, name);
+}
+
 static int database_info_iterate_rdl_write(
-      database_info_handle_t *db, const char *name)
+      database_info_handle_t *db)
 {
-   char parent_dir[PATH_MAX_LENGTH];
-   bool to_continue = (db->list_ptr < db->list->size);
+   char msg[PATH_MAX_LENGTH];
+   const char *name                = NULL;
+   struct database_info_scan *scan = db->scan;
 
-   if (!to_continue)
+   if (db->list_ptr >= db->list->size)
    {
+      if (scan->cache_hits)
+         RARCH_LOG("%u of %u files unchanged since the last scan.\n",
+               (unsigned)scan->cache_hits, (unsigned)db->list->size);
       rarch_main_msg_queue_push("Scanning of directory finished.\n", 1, 180, true);
       db->status = DATABASE_STATUS_FREE;
       return -1;
    }
 
-   path_parent_dir(parent_dir);
+#ifdef HAVE_THREADS
+   if (scan->num_threads)
+      slock_lock(scan->lock);
+#endif
 
-   if (!strcmp(path_get_extension(name), "zip"))
+   if (!scan->chunk)
    {
-#ifdef HAVE_ZLIB
-      RARCH_LOG("[ZIP]: name: %s\n", name);
+      /* Workers are ahead, report everything they finished since. */
+      while (db->list_ptr < db->list->size &&
+            scan->entries[db->list_ptr].state != DATABASE_SCAN_PENDING)
+      {
+         database_scan_entry_t *entry = &scan->entries[db->list_ptr];
 
-      if (!zlib_parse_file(name, NULL, zlib_compare_crc32,
-               (void*)parent_dir))
-         RARCH_LOG("Could not process ZIP file.\n");
-#endif
+         name = db->list->elems[db->list_ptr].data;
+
+         database_info_scan_report(scan, entry, name);
+         db->list_ptr++;
+      }
    }
    else
    {
-      char msg[PATH_MAX_LENGTH];
-      ssize_t ret;
-      uint32_t crc, target_crc = 0;
-      uint8_t *ret_buf         = NULL;
-      int read_from            = read_file(name, (void**)&ret_buf, &ret);
+      database_scan_entry_t *entry = &scan->entries[db->list_ptr];
+
+      name         = db->list->elems[db->list_ptr].data;
+      entry->state = database_info_scan_file(scan, name, scan->chunk, entry);
+
+      database_info_scan_report(scan, entry, name);
+      db->list_ptr++;
+   }
 
-      (void)target_crc;
+#ifdef HAVE_THREADS
+   if (scan->num_threads)
+      slock_unlock(scan->lock);
+#endif
 
-      if (read_from != 1)
-         return 0;
-      if (ret <= 0)
-         return 0;
+   if (scan->cache_dirty && *scan->cache_path &&
+         rarch_get_time_usec() - scan->cache_written >=
+         DATABASE_SCAN_CACHE_CHECKPOINT_USEC)
+      database_info_scan_cache_write(db);
 
+   if (name)
+   {
       snprintf(msg, sizeof(msg), "%zu/%zu: Scanning %s...\n",
             db->list_ptr, db->list->size, name);
-
       rarch_main_msg_queue_push(msg, 1, 180, true);
-
-#ifdef HAVE_ZLIB
-      crc = zlib_crc32_calculate(ret_buf, ret);
-
-      RARCH_LOG("CRC32: 0x%x .\n", (unsigned)crc);
-#endif
-
-      if (ret_buf)
-         free(ret_buf);
    }
 
-   db->list_ptr++;
-
    return 0;
 }
 
 int database_info_iterate(database_info_handle_t *db)
 {
-   const char *name = NULL;
-
    if (!db || !db->list)
       return -1;
 
-   name = db->list->elems[db->list_ptr].data;
-
-   if (!name)
-      return 0;
-
    switch (db->type)
    {
       case DATABASE_TYPE_NONE:
          break;
       case DATABASE_TYPE_RDL_WRITE:
-         if (database_info_iterate_rdl_write(db, name) != 0)
+         if (database_info_iterate_rdl_write(db) != 0)
             return -1;
          break;
    }
@@ -199,6 +863,7 @@ database_info_list_t *database_info_list_new(const char *rdb_path, const char *q
    libretrodb_t db;
    libretrodb_cursor_t cur;
    struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_arena arena;
    size_t j;
    unsigned k                               = 0;
    database_info_t *database_info           = NULL;
@@ -209,15 +874,22 @@ database_info_list_t *database_info_list_new(const char *rdb_path, const char *q
    if ((database_open_cursor(&db, &cur, query) != 0))
       return NULL;
 
+   /* Each item only lives until its fields are copied out,
+    * so one arena is reused for all of them. */
+   rmsgpack_dom_arena_init(&arena, LIBRETRODB_ARENA_BLOCK_SIZE);
+
    database_info_list = (database_info_list_t*)calloc(1, sizeof(*database_info_list));
    if (!database_info_list)
       goto error;
 
-   while (libretrodb_cursor_read_item(&cur, &item) == 0)
+   while (libretrodb_cursor_read_item_arena(&cur, &item, &arena) == 0)
    {
       database_info_t *db_info = NULL;
       if (item.type != RDT_MAP)
+      {
+         rmsgpack_dom_arena_reset(&arena);
          continue;
+      }
 
       database_info = (database_info_t*)realloc(database_info, (k+1) * sizeof(database_info_t));
 
@@ -330,14 +1002,20 @@ database_info_list_t *database_info_list_new(const char *rdb_path, const char *q
             db_info->md5 = bin_to_hex_alloc((uint8_t*)val->binary.buff, val->binary.len);
       }
       k++;
+      rmsgpack_dom_arena_reset(&arena);
    }
 
    database_info_list->list  = database_info;
    database_info_list->count = k;
 
+   rmsgpack_dom_arena_free(&arena);
+   libretrodb_cursor_close(&cur);
+   libretrodb_close(&db);
+
    return database_info_list;
 
 error:
+   rmsgpack_dom_arena_free(&arena);
    libretrodb_cursor_close(&cur);
    libretrodb_close(&db);
    database_info_list_free(database_info_list);
@@ -40,12 +40,16 @@ enum database_type
    DATABASE_TYPE_RDL_WRITE,
 };
 
+struct database_info_scan;
+
 typedef struct
 {
    enum database_status status;
    enum database_type type;
    size_t list_ptr;
    struct string_list *list;
+   /* Hashes files ahead of list_ptr on worker threads. */
+   struct database_info_scan *scan;
 } database_info_handle_t;
 
 typedef struct
@@ -19,9 +19,11 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #include <string.h>
 #include <retro_miscellaneous.h>
+#include <compat/strl.h>
 #include <file/file_path.h>
 #include <string/string_list.h>
 #include "7zip_support.h"
@@ -37,6 +39,33 @@
  */
 #define RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX 16384
 
+/* Largest decoded solid block kept around after an extraction. */
+#ifndef SEVENZIP_CACHE_SIZE_MAX
+#define SEVENZIP_CACHE_SIZE_MAX (32 * 1024 * 1024)
+#endif
+
+/* Largest solid block decoded while scanning, to hash the files
+ * which have no CRC stored in the headers. */
+#ifndef SEVENZIP_SCAN_SIZE_MAX
+#define SEVENZIP_SCAN_SIZE_MAX (256 * 1024 * 1024)
+#endif
+
+/* The LZMA SDK can only decode whole solid blocks, so loading
+ * several files of the same block, one after the other, decodes
+ * it over and over. The last block decoded is kept instead,
+ * together with the stat of its archive to notice changes. */
+typedef struct sevenzip_block_cache
+{
+   char path[PATH_MAX_LENGTH];
+   int64_t size;
+   int64_t mtime;
+   uint32_t block_index;
+   uint8_t *buffer;
+   size_t buffer_size;
+} sevenzip_block_cache_t;
+
+static sevenzip_block_cache_t sevenzip_cache;
+
 static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 
 static int Buf_EnsureSize(CBuf *dest, size_t size)
@@ -168,6 +197,55 @@ static SRes ConvertUtf16toCharString(const uint16_t *s, char *outstring)
    return res;
 }
 
+void read_7zip_file_cache_free(void)
+{
+   IAlloc_Free(&g_Alloc, sevenzip_cache.buffer);
+   memset(&sevenzip_cache, 0, sizeof(sevenzip_cache));
+}
+
+/* Hands the block cached for archive_path over to the caller,
+ * or drops the cache when it belongs to another archive. */
+static void read_7zip_file_cache_take(const char *archive_path,
+      const struct stat *st, uint32_t *blockIndex,
+      uint8_t **outBuffer, size_t *outBufferSize)
+{
+   if (sevenzip_cache.buffer
+         && sevenzip_cache.size  == (int64_t)st->st_size
+         && sevenzip_cache.mtime == (int64_t)st->st_mtime
+         && !strcmp(sevenzip_cache.path, archive_path))
+   {
+      *blockIndex            = sevenzip_cache.block_index;
+      *outBuffer             = sevenzip_cache.buffer;
+      *outBufferSize         = sevenzip_cache.buffer_size;
+      sevenzip_cache.buffer  = NULL;
+      return;
+   }
+
+   read_7zip_file_cache_free();
+}
+
+/* Keeps the block decoded last if it fits in the budget,
+ * otherwise frees it. */
+static void read_7zip_file_cache_store(const char *archive_path,
+      const struct stat *st, uint32_t blockIndex,
+      uint8_t *outBuffer, size_t outBufferSize)
+{
+   read_7zip_file_cache_free();
+
+   if (!outBuffer || outBufferSize > SEVENZIP_CACHE_SIZE_MAX)
+   {
+      IAlloc_Free(&g_Alloc, outBuffer);
+      return;
+   }
+
+   strlcpy(sevenzip_cache.path, archive_path, sizeof(sevenzip_cache.path));
+   sevenzip_cache.size        = st->st_size;
+   sevenzip_cache.mtime       = st->st_mtime;
+   sevenzip_cache.block_index = blockIndex;
+   sevenzip_cache.buffer      = outBuffer;
+   sevenzip_cache.buffer_size = outBufferSize;
+}
+
 /* Extract the relative path relative_path from a 7z archive 
  * archive_path and allocate a buf for it to write it in.
  * If optional_outfile is set, extract to that instead and don't alloc buffer.
@@ -213,9 +291,17 @@ int read_7zip_file(const char * archive_path,
    if (res == SZ_OK)
    {
       uint32_t i;
+      struct stat st;
       uint32_t blockIndex = 0xFFFFFFFF;
       uint8_t *outBuffer = 0;
       size_t outBufferSize = 0;
+      bool cacheable = stat(archive_path, &st) == 0;
+
+      if (cacheable)
+         read_7zip_file_cache_take(archive_path, &st,
+               &blockIndex, &outBuffer, &outBufferSize);
+      else
+         read_7zip_file_cache_free();
 
       for (i = 0; i < db.db.NumFiles; i++)
       {
@@ -254,6 +340,7 @@ int read_7zip_file(const char * archive_path,
          {
             /* C LZMA SDK does not support chunked extraction - see here:
              * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
+             * If the file is in the cached block, it is not decoded again.
              * */
             file_found = true;
             res = SzArEx_Extract(&db, &lookStream.s, i,&blockIndex,
@@ -271,11 +358,8 @@ int read_7zip_file(const char * archive_path,
                {
                   RARCH_ERR("Could not open outfilepath %s.\n",
                         optional_outfile);
-                  IAlloc_Free(&allocImp, outBuffer);
-                  SzArEx_Free(&db, &allocImp);
-                  free(temp);
-                  File_Close(&archiveStream.file);
-                  return -1;
+                  outsize = -1;
+                  break;
                }
                fwrite(outBuffer+offset,1,outsize,outsink);
                fclose(outsink);
@@ -291,10 +375,15 @@ int read_7zip_file(const char * archive_path,
                ((char*)(*buf))[outsize] = '\0';
                memcpy(*buf,outBuffer+offset,outsize);
             }
-            IAlloc_Free(&allocImp, outBuffer);
             break;
          }
       }
+
+      if (cacheable && res == SZ_OK)
+         read_7zip_file_cache_store(archive_path, &st,
+               blockIndex, outBuffer, outBufferSize);
+      else
+         IAlloc_Free(&allocImp, outBuffer);
    }
    SzArEx_Free(&db, &allocImp);
    free(temp);
@@ -322,14 +411,10 @@ struct string_list *compressed_7zip_file_list_new(const char *path,
       const char* ext)
 {
 
-   struct string_list *ext_list = NULL;
    struct string_list *list = string_list_new();
    if (!list)
       return NULL;
 
-   if (ext)
-      ext_list = string_split(ext, "|");
-
    /* 7Zip part begin */
    CFileInStream archiveStream;
    CLookToRead lookStream;
@@ -409,7 +494,7 @@ struct string_list *compressed_7zip_file_list_new(const char *path,
 
          union string_list_elem_attr attr;
 
-         if (string_list_find_elem_prefix(ext_list, ".", file_ext))
+         if (string_find_token_prefix(ext, "|", ".", file_ext))
             supported_by_core = true;
 
          /*
@@ -448,7 +533,6 @@ struct string_list *compressed_7zip_file_list_new(const char *path,
       goto error;
    }
 
-   string_list_free(ext_list);
    return list;
 
 error:
@@ -457,8 +541,121 @@ error:
    free(temp);
    File_Close(&archiveStream.file);
    string_list_free(list);
-   string_list_free(ext_list);
    return NULL;
 }
 
+/* Enumerate the CRC32 the 7z archive archive_path stores for each of
+ * its files. Files without a stored CRC are hashed instead, which
+ * decodes their solid block. Files come in block order, so each block
+ * is decoded at most once. Files in blocks larger than
+ * SEVENZIP_SCAN_SIZE_MAX are passed to crc_cb with crc_defined
+ * set to false.
+ */
+bool read_7zip_file_crc(const char *archive_path,
+      sevenzip_crc_cb crc_cb, void *userdata)
+{
+   CFileInStream archiveStream;
+   CLookToRead lookStream;
+   CSzArEx db;
+   SRes res;
+   ISzAlloc allocImp;
+   ISzAlloc allocTempImp;
+   uint16_t *temp = NULL;
+   size_t tempSize = 0;
+
+   allocImp.Alloc = SzAlloc;
+   allocImp.Free = SzFree;
+   allocTempImp.Alloc = SzAllocTemp;
+   allocTempImp.Free = SzFreeTemp;
+
+   if (InFile_Open(&archiveStream.file, archive_path))
+   {
+      RARCH_ERR("Could not open %s as 7z archive.\n", archive_path);
+      return false;
+   }
+
+   FileInStream_CreateVTable(&archiveStream);
+   LookToRead_CreateVTable(&lookStream, False);
+   lookStream.realStream = &archiveStream.s;
+   LookToRead_Init(&lookStream);
+   CrcGenerateTable();
+   SzArEx_Init(&db);
+   res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
+   if (res == SZ_OK)
+   {
+      uint32_t i;
+      uint32_t blockIndex = 0xFFFFFFFF;
+      uint8_t *outBuffer = 0;
+      size_t outBufferSize = 0;
+
+      for (i = 0; i < db.db.NumFiles; i++)
+      {
+         char infile[PATH_MAX_LENGTH];
+         const CSzFileItem *f = db.db.Files + i;
+         uint32_t crc = f->Crc;
+         bool crc_defined = f->CrcDefined;
+         uint32_t folder = db.FileIndexToFolderIndexMap[i];
+         size_t len;
+
+         if (f->IsDir)
+            continue;
+
+         len = SzArEx_GetFileNameUtf16(&db, i, NULL);
+         if (len > tempSize)
+         {
+            free(temp);
+            tempSize = len;
+            temp = (uint16_t *)malloc(tempSize * sizeof(temp[0]));
+            if (temp == 0)
+            {
+               res = SZ_ERROR_MEM;
+               break;
+            }
+         }
+         SzArEx_GetFileNameUtf16(&db, i, temp);
+         res = ConvertUtf16toCharString(temp, infile);
+
+         if (!crc_defined && folder != (uint32_t)-1 &&
+               SzFolder_GetUnpackSize(db.db.Folders + folder)
+               <= SEVENZIP_SCAN_SIZE_MAX)
+         {
+            size_t offset = 0;
+            size_t outSizeProcessed = 0;
+
+            res = SzArEx_Extract(&db, &lookStream.s, i, &blockIndex,
+                  &outBuffer, &outBufferSize, &offset, &outSizeProcessed,
+                  &allocImp, &allocTempImp);
+            if (res != SZ_OK)
+               break;
+
+            crc         = CrcCalc(outBuffer + offset, outSizeProcessed);
+            crc_defined = true;
+         }
+         else if (!crc_defined && folder == (uint32_t)-1)
+         {
+            /* Empty file. */
+            crc         = 0;
+            crc_defined = true;
+         }
+
+         if (!crc_cb(infile, f->Size, crc, crc_defined, userdata))
+            break;
+      }
+
+      IAlloc_Free(&allocImp, outBuffer);
+   }
+   SzArEx_Free(&db, &allocImp);
+   free(temp);
+   File_Close(&archiveStream.file);
+
+   if (res != SZ_OK)
+   {
+      RARCH_ERR("Could not read the headers of 7z archive %s, error #%d.\n",
+            archive_path, res);
+      return false;
+   }
+
+   return true;
+}
+
 #undef RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX
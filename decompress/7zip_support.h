@@ -17,16 +17,32 @@
 #ifndef __RARCH_7ZIP_SUPPORT_H
 #define __RARCH_7ZIP_SUPPORT_H
 
+#include <stdint.h>
+#include <boolean.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Returns true when parsing should continue. False to stop. */
+typedef int (*sevenzip_crc_cb)(const char *name, uint64_t size,
+      uint32_t crc32, bool crc_defined, void *userdata);
+
 int read_7zip_file(const char * archive_path,
       const char *relative_path, void **buf, char const* optional_outfileq);
 
+/* Frees the decoded solid block read_7zip_file() keeps around
+ * to serve further files of the same block. */
+void read_7zip_file_cache_free(void);
+
 struct string_list *compressed_7zip_file_list_new(const char *path,
       const char* ext);
 
+/* Enumerates the CRC32 of each file, from the archive headers when
+ * stored there, otherwise by decoding the archive in one pass. */
+bool read_7zip_file_crc(const char *archive_path,
+      sevenzip_crc_cb crc_cb, void *userdata);
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@
 #include "general.h"
 #include "retroarch.h"
 #include "runloop.h"
+#include "performance.h"
 #include "compat/posix_string.h"
 #include "gfx/video_monitor.h"
 #include "audio/audio_monitor.h"
@@ -347,6 +348,8 @@ void init_drivers(int flags)
    driver_t *driver = driver_get_ptr();
    global_t *global = global_get_ptr();
 
+   RARCH_TRACE_BEGIN("init_drivers");
+
    if (flags & DRIVER_VIDEO)
       driver->video_data_own = false;
    if (flags & DRIVER_AUDIO)
@@ -368,18 +371,35 @@ void init_drivers(int flags)
 
    if (flags & DRIVER_VIDEO)
    {
+      RARCH_TRACE_BEGIN("init_video");
       init_video();
+      RARCH_TRACE_END("init_video");
 
       if (!driver->video_cache_context_ack
             && global->system.hw_render_callback.context_reset)
+      {
+         RARCH_TRACE_BEGIN("hw_render_context_reset");
          global->system.hw_render_callback.context_reset();
+         RARCH_TRACE_END("hw_render_context_reset");
+      }
       driver->video_cache_context_ack = false;
 
       global->system.frame_time_last = 0;
    }
 
    if (flags & DRIVER_AUDIO)
-      init_audio();
+   {
+      settings_t *settings = config_get_ptr();
+
+      if (settings->audio.lazy_init && !driver->audio_data)
+         driver->audio_init_deferred = true;
+      else
+      {
+         RARCH_TRACE_BEGIN("init_audio");
+         init_audio();
+         RARCH_TRACE_END("init_audio");
+      }
+   }
 
    /* Only initialize camera driver if we're ever going to use it. */
    if ((flags & DRIVER_CAMERA) && driver->camera_active)
@@ -392,8 +412,10 @@ void init_drivers(int flags)
 #ifdef HAVE_MENU
    if (flags & DRIVER_MENU)
    {
+      RARCH_TRACE_BEGIN("init_menu");
       init_menu();
       menu_update_libretro_info();
+      RARCH_TRACE_END("init_menu");
    }
 #endif
 
@@ -403,6 +425,25 @@ void init_drivers(int flags)
       if (driver->nonblock_state)
          driver_set_nonblock_state(driver->nonblock_state);
    }
+
+   RARCH_TRACE_END("init_drivers");
+}
+
+void init_drivers_deferred(void)
+{
+   driver_t *driver = driver_get_ptr();
+
+   if (!driver->audio_init_deferred)
+      return;
+
+   driver->audio_init_deferred = false;
+
+   RARCH_TRACE_BEGIN("init_audio");
+   init_audio();
+   RARCH_TRACE_END("init_audio");
+
+   if (driver->nonblock_state)
+      driver_set_nonblock_state(driver->nonblock_state);
 }
 
 
@@ -418,7 +459,12 @@ void uninit_drivers(int flags)
    driver_t *driver = driver_get_ptr();
 
    if (flags & DRIVER_AUDIO)
-      uninit_audio();
+   {
+      if (driver->audio_init_deferred)
+         driver->audio_init_deferred = false;
+      else
+         uninit_audio();
+   }
 
    if (flags & DRIVER_VIDEO)
    {
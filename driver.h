@@ -51,6 +51,8 @@
 extern "C" {
 #endif
 
+/* Per-sample audio is held back at the end of a frame 
+ * until at least this many samples are pending. */
 #define AUDIO_CHUNK_SIZE_BLOCKING 512
 
 /* So we don't get complete line-noise when fast-forwarding audio. */
@@ -58,6 +60,13 @@ extern "C" {
 
 #define AUDIO_MAX_RATIO 16
 
+/* Frames taken through conversion, DSP and resampling at a time, 
+ * so intermediate float data stays in cache. */
+#define AUDIO_BLOCK_FRAMES 256
+
+/* Samples of forward audio kept around for rewinding. */
+#define AUDIO_REWIND_HISTORY_SIZE (AUDIO_CHUNK_SIZE_NONBLOCKING * 64)
+
 /* Specialized _POINTER that targets the full screen regardless of viewport.
  * Should not be used by a libretro implementation as coordinates returned
  * make no sense.
@@ -236,6 +245,10 @@ typedef struct driver
    /* Set to true by driver if context caching succeeded. */
    bool video_cache_context_ack;
 
+   /* Set by init_drivers() if audio is left for 
+    * init_drivers_deferred() to initialize. */
+   bool audio_init_deferred;
+
    /* Set this to true if the platform in question needs to 'own' 
     * the respective handle and therefore skip regular RetroArch 
     * driver teardown/reiniting procedure.
@@ -309,6 +322,14 @@ typedef struct driver
  **/
 void init_drivers(int flags);
 
+/**
+ * init_drivers_deferred:
+ *
+ * Initializes the drivers init_drivers() left for when
+ * content first runs, see audio_lazy_init.
+ **/
+void init_drivers_deferred(void);
+
 /**
  * init_drivers_pre:
  *
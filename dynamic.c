@@ -32,6 +32,7 @@
 #include "dynamic_dummy.h"
 #include "retroarch.h"
 #include "runloop.h"
+#include "libretro_version_1.h"
 
 #include "input/input_sensor.h"
 
@@ -671,6 +672,20 @@ bool rarch_environment_cb(unsigned cmd, void *data)
                settings->user_language);
          break;
 
+      case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+         return video_driver_get_current_software_framebuffer(
+               (struct retro_framebuffer*)data);
+
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+         *(int*)data = retro_get_audio_video_enable();
+         break;
+
+      case RETRO_ENVIRONMENT_SET_CHEAT_INCREMENTAL:
+         global->system.cheat_incremental = *(const bool*)data;
+         RARCH_LOG("Environ SET_CHEAT_INCREMENTAL: %s.\n",
+               global->system.cheat_incremental ? "yes" : "no");
+         break;
+
       case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
       {
          enum retro_pixel_format pix_fmt = 
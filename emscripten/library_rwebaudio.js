@@ -1,5 +1,7 @@
 //"use strict";
 
+// In threaded builds these run on the main thread, which owns the
+// AudioContext, and are called synchronously from the worker.
 var LibraryRWebAudio = {
    $RA__deps: ['$Browser', 'usleep'],
    $RA: {
@@ -14,6 +16,96 @@ var LibraryRWebAudio = {
       nonblock: false,
       currentTimeWorkaround: false,
 
+      // AudioWorklet mode: the worklet pulls interleaved frames from a
+      // ring in a SharedArrayBuffer, so playback no longer depends on
+      // the main thread scheduling buffers in time. ringIndex holds the
+      // read and write positions, as frame counts that wrap at 2^32.
+      worklet: false,
+      workletNode: null,
+      ringIndex: null,
+      ringData: null,
+      ringFrames: 0,
+
+      workletSource: [
+         'class RWebAudioProcessor extends AudioWorkletProcessor {',
+         '   constructor(options) {',
+         '      super();',
+         '      var sab = options.processorOptions.sab;',
+         '      this.index = new Int32Array(sab, 0, 2);',
+         '      this.data = new Float32Array(sab, 8);',
+         '      this.mask = (this.data.length >> 1) - 1;',
+         '   }',
+         '   process(inputs, outputs) {',
+         '      var left = outputs[0][0], right = outputs[0][1];',
+         '      var frames = left.length, i;',
+         '      var read = Atomics.load(this.index, 0);',
+         '      var avail = (Atomics.load(this.index, 1) - read) | 0;',
+         '      if (avail > frames) avail = frames;',
+         '      for (i = 0; i < avail; i++) {',
+         '         var pos = ((read + i) & this.mask) << 1;',
+         '         left[i] = this.data[pos];',
+         '         right[i] = this.data[pos + 1];',
+         '      }',
+         '      for (; i < frames; i++) left[i] = right[i] = 0;',
+         '      Atomics.store(this.index, 0, (read + avail) | 0);',
+         '      return true;',
+         '   }',
+         '}',
+         'registerProcessor("rwebaudio", RWebAudioProcessor);'
+      ].join('\n'),
+
+      initBuffers: function(latency) {
+         RA.numBuffers = ((latency * RA.context.sampleRate) / (1000 * RA.BUFFER_SIZE))|0;
+         if (RA.numBuffers < 2) RA.numBuffers = 2;
+
+         for (var i = 0; i < RA.numBuffers; i++) RA.buffers[i] = RA.context.createBuffer(2, RA.BUFFER_SIZE, RA.context.sampleRate);
+      },
+
+      initWorklet: function(latency) {
+         var frames = 1024;
+         var wanted = (latency * RA.context.sampleRate / 1000)|0;
+         while (frames < wanted) frames *= 2;
+
+         var sab = new SharedArrayBuffer(8 + frames * 8);
+         RA.ringIndex = new Int32Array(sab, 0, 2);
+         RA.ringData = new Float32Array(sab, 8);
+         RA.ringFrames = frames;
+
+         var url = window['URL']['createObjectURL'](new Blob([RA.workletSource], { 'type': 'application/javascript' }));
+         RA.context['audioWorklet']['addModule'](url).then(function() {
+            RA.workletNode = new AudioWorkletNode(RA.context, 'rwebaudio', {
+               'numberOfInputs': 0,
+               'outputChannelCount': [2],
+               'processorOptions': { 'sab': sab }
+            });
+            RA.workletNode.connect(RA.context.destination);
+            Module["resumeMainLoop"]();
+         }, function() {
+            RA.worklet = false;
+            RA.initBuffers(latency);
+            RA.setStartTime();
+         });
+      },
+
+      ringAvail: function() {
+         return (Atomics.load(RA.ringIndex, 1) - Atomics.load(RA.ringIndex, 0)) | 0;
+      },
+
+      ringWrite: function(buf, frames) {
+         var free = RA.ringFrames - RA.ringAvail();
+         if (frames > free) frames = free;
+
+         var write = Atomics.load(RA.ringIndex, 1);
+         var pos = (write & (RA.ringFrames - 1)) << 1;
+         var first = Math.min(frames * 2, RA.ringData.length - pos);
+         var src = buf >> 2;
+
+         RA.ringData.set(HEAPF32.subarray(src, src + first), pos);
+         RA.ringData.set(HEAPF32.subarray(src + first, src + frames * 2), 0);
+         Atomics.store(RA.ringIndex, 1, (write + frames) | 0);
+         return frames;
+      },
+
       setStartTime: function() {
          if (RA.context.currentTime) {
             RA.startTime = window['performance']['now']() - RA.context.currentTime * 1000;
@@ -77,20 +169,28 @@ var LibraryRWebAudio = {
       }
    },
 
+   RWebAudioInit__proxy: 'sync',
+   RWebAudioInit__sig: 'ii',
    RWebAudioInit: function(latency) {
       var ac = window['AudioContext'] || window['webkitAudioContext'];
 
       if (!ac) return 0;
 
-      RA.context = new ac();
-
-      RA.numBuffers = ((latency * RA.context.sampleRate) / (1000 * RA.BUFFER_SIZE))|0;
-      if (RA.numBuffers < 2) RA.numBuffers = 2;
-
-      for (var i = 0; i < RA.numBuffers; i++) RA.buffers[i] = RA.context.createBuffer(2, RA.BUFFER_SIZE, RA.context.sampleRate);
+      // SharedArrayBuffer is only there on cross-origin isolated pages.
+      RA.worklet = typeof SharedArrayBuffer !== 'undefined' &&
+         typeof AudioWorkletNode !== 'undefined';
 
+      RA.context = RA.worklet ? new ac({ 'latencyHint': 'interactive' }) : new ac();
       RA.nonblock = false;
       RA.startTime = 0;
+
+      if (RA.worklet) {
+         RA.initWorklet(latency);
+         Module["pauseMainLoop"]();
+         return 1;
+      }
+
+      RA.initBuffers(latency);
       // chrome hack to get currentTime running
       RA.context.createGain();
       window['setTimeout'](RA.setStartTime, 0);
@@ -98,15 +198,39 @@ var LibraryRWebAudio = {
       return 1;
    },
    
+   RWebAudioSampleRate__proxy: 'sync',
+   RWebAudioSampleRate__sig: 'i',
    RWebAudioSampleRate: function() {
       return RA.context.sampleRate;
    },
 
+   RWebAudioWrite__proxy: 'sync',
+   RWebAudioWrite__sig: 'iii',
    RWebAudioWrite: function (buf, size) {
-      RA.process();
       var samples = size / 8;
       var count = 0;
 
+      if (RA.worklet) {
+         // Drop audio until the worklet is up. Threaded builds keep
+         // running meanwhile, and spinning here would keep the module
+         // from ever loading.
+         if (!RA.workletNode) return size;
+
+         // The main thread can't sleep, so blocking spins on the ring.
+         while (samples) {
+            var written = RA.ringWrite(buf, samples);
+            samples -= written;
+            count += written;
+            buf += written * 8;
+
+            if (RA.nonblock) break;
+         }
+
+         return count * 8;
+      }
+
+      RA.process();
+
       while (samples) {
          var fill = RA.fillBuffer(buf, samples);
          samples -= fill;
@@ -125,31 +249,58 @@ var LibraryRWebAudio = {
       return count * 8;
    },
 
+   RWebAudioStop__proxy: 'sync',
+   RWebAudioStop__sig: 'i',
    RWebAudioStop: function() {
+      if (RA.worklet) {
+         RA.context['suspend']();
+         return true;
+      }
+
       RA.bufIndex = 0;
       RA.bufOffset = 0;
       return true;
    },
 
+   RWebAudioStart__proxy: 'sync',
+   RWebAudioStart__sig: 'i',
    RWebAudioStart: function() {
+      if (RA.worklet) RA.context['resume']();
       return true;
    },
 
+   RWebAudioSetNonblockState__proxy: 'sync',
+   RWebAudioSetNonblockState__sig: 'vi',
    RWebAudioSetNonblockState: function(state) {
       RA.nonblock = state;
    },
 
+   RWebAudioFree__proxy: 'sync',
+   RWebAudioFree__sig: 'v',
    RWebAudioFree: function() {
+      if (RA.worklet) {
+         if (RA.workletNode) RA.workletNode.disconnect();
+         RA.workletNode = null;
+         RA.context['close']();
+         return;
+      }
+
       RA.bufIndex = 0;
       RA.bufOffset = 0;
       return;
    },
 
+   RWebAudioBufferSize__proxy: 'sync',
+   RWebAudioBufferSize__sig: 'i',
    RWebAudioBufferSize: function() {
+      if (RA.worklet) return RA.ringFrames * 8;
       return RA.numBuffers * RA.BUFFER_SIZE + RA.BUFFER_SIZE;
    },
 
+   RWebAudioWriteAvail__proxy: 'sync',
+   RWebAudioWriteAvail__sig: 'i',
    RWebAudioWriteAvail: function() {
+      if (RA.worklet) return (RA.ringFrames - RA.ringAvail()) * 8;
       RA.process();
       return ((RA.numBuffers - RA.bufIndex) * RA.BUFFER_SIZE - RA.bufOffset) * 8;
    }
@@ -1,5 +1,7 @@
 //"use strict";
 
+// In threaded builds these run on the main thread, where the
+// DOM events arrive, and are called synchronously from the worker.
 var LibraryRWebInput = {
    $RI__deps: ['$Browser'],
    $RI: {
@@ -58,6 +60,8 @@ var LibraryRWebInput = {
       }
    },
 
+   RWebInputInit__proxy: 'sync',
+   RWebInputInit__sig: 'i',
    RWebInputInit: function() {
       if (RI.contexts.length === 0) {
          document.addEventListener('keyup', RI.eventHandler, false);
@@ -78,6 +82,8 @@ var LibraryRWebInput = {
       return RI.contexts.length;
    },
    
+   RWebInputPoll__proxy: 'sync',
+   RWebInputPoll__sig: 'ii',
    RWebInputPoll: function(context) {
       context -= 1;
       var state = RI.contexts[context].state;
@@ -88,6 +94,8 @@ var LibraryRWebInput = {
       return RI.temp;
    },
 
+   RWebInputDestroy__proxy: 'sync',
+   RWebInputDestroy__sig: 'vi',
    RWebInputDestroy: function (context) {
       if (context === RI.contexts.length) {
          RI.contexts.pop();
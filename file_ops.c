@@ -14,6 +14,10 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include "file_ops.h"
 #include <file/file_path.h>
 #include <stdlib.h>
@@ -61,6 +65,11 @@
 #include <unistd.h>
 #endif
 
+#if defined(HAVE_MMAP) && !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
 /**
  * write_file:
  * @path             : path to file.
@@ -83,6 +92,47 @@ bool write_file(const char *path, const void *data, ssize_t size)
    return ret;
 }
 
+/**
+ * write_file_atomic:
+ * @path             : path to file.
+ * @data             : contents to write to the file.
+ * @size             : size of the contents.
+ *
+ * Writes data to a temporary file next to @path, which then
+ * replaces @path. Whatever was at @path is left alone if
+ * writing fails part way, e.g. when the disk is full.
+ *
+ * Returns: true (1) on success, false (0) otherwise.
+ */
+bool write_file_atomic(const char *path, const void *data, ssize_t size)
+{
+   bool ret = false;
+   char tmp_path[PATH_MAX_LENGTH];
+   int len  = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+   /* A truncated name could be another file, or @path itself. */
+   if (len < 0 || (size_t)len >= sizeof(tmp_path))
+      return false;
+
+   if (!write_file(tmp_path, data, size))
+      goto end;
+
+#if defined(_WIN32) && !defined(_XBOX)
+   ret = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+#ifdef _WIN32
+   /* rename() doesn't replace files here. */
+   remove(path);
+#endif
+   ret = rename(tmp_path, path) == 0;
+#endif
+
+end:
+   if (!ret)
+      remove(tmp_path);
+   return ret;
+}
+
 /**
  * read_generic_file:
  * @path             : path to file.
@@ -244,6 +294,142 @@ int read_file(const char *path, void **buf, ssize_t *length)
    return read_generic_file(path, buf, length);
 }
 
+/**
+ * map_file:
+ * @path             : path to file.
+ * @min_size         : smallest file worth mapping.
+ * @buf              : set to the mapping of the file.
+ * @length           : set to the size of the file.
+ * @mapped           : set to the size of the mapping.
+ *
+ * Maps a file copy-on-write. Reading it is driven by page
+ * faults and the pages are shared with the page cache; writes
+ * go to private copies of the pages touched. Unlike read_file(),
+ * the contents are not NUL-terminated. Release with release_file().
+ *
+ * Returns: true (1) if mapped, false (0) if the file is smaller
+ * than @min_size, empty, compressed or can't be mapped here.
+ */
+bool map_file(const char *path, size_t min_size,
+      void **buf, ssize_t *length, size_t *mapped)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   LARGE_INTEGER size;
+   void *map       = NULL;
+   HANDLE mapping  = NULL;
+   HANDLE file     = INVALID_HANDLE_VALUE;
+
+   if (path_contains_compressed_file(path))
+      return false;
+
+   file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+   if (GetFileSizeEx(file, &size) && size.QuadPart > 0
+         && (uint64_t)size.QuadPart >= min_size
+         && (uint64_t)size.QuadPart <= (size_t)-1 / 2)
+      mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+   /* The view keeps the file open. */
+   if (mapping)
+   {
+      map = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+      CloseHandle(mapping);
+   }
+   CloseHandle(file);
+
+   if (!map)
+      return false;
+
+   *buf    = map;
+   *length = (ssize_t)size.QuadPart;
+   *mapped = (size_t)size.QuadPart;
+   return true;
+#elif defined(HAVE_MMAP)
+   struct stat fds;
+   void *map = MAP_FAILED;
+   int fd    = -1;
+
+   if (path_contains_compressed_file(path))
+      return false;
+
+   if ((fd = open(path, O_RDONLY)) < 0)
+      return false;
+
+   if (fstat(fd, &fds) == 0 && S_ISREG(fds.st_mode)
+         && fds.st_size > 0 && (size_t)fds.st_size >= min_size)
+      map = mmap(NULL, fds.st_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE, fd, 0);
+
+   close(fd);
+
+   if (map == MAP_FAILED)
+      return false;
+
+   *buf    = map;
+   *length = fds.st_size;
+   *mapped = fds.st_size;
+   return true;
+#else
+   (void)path;
+   (void)min_size;
+   (void)buf;
+   (void)length;
+   (void)mapped;
+   return false;
+#endif
+}
+
+/**
+ * read_file_mapped:
+ * @path             : path to file.
+ * @min_size         : smallest file worth mapping.
+ * @buf              : set to the contents of the file.
+ * @length           : Number of items read, -1 on error.
+ * @mapped           : set to the size of the mapping, or 0
+ *                     if @buf was read into memory.
+ *
+ * Maps files of at least @min_size with map_file(), and reads
+ * everything else, including compressed files and on platforms
+ * without mappings, with read_file(). Release with release_file().
+ *
+ * Returns: 1 if file read, 0 on error.
+ */
+int read_file_mapped(const char *path, size_t min_size,
+      void **buf, ssize_t *length, size_t *mapped)
+{
+   *mapped = 0;
+
+   if (map_file(path, min_size, buf, length, mapped))
+      return 1;
+
+   return read_file(path, buf, length);
+}
+
+/**
+ * release_file:
+ * @buf              : contents from map_file() or read_file_mapped().
+ * @mapped           : size of the mapping, 0 if @buf was read.
+ *
+ * Unmaps or frees file contents.
+ */
+void release_file(void *buf, size_t mapped)
+{
+   if (!mapped)
+   {
+      free(buf);
+      return;
+   }
+
+#if defined(_WIN32) && !defined(_XBOX)
+   UnmapViewOfFile(buf);
+#elif defined(HAVE_MMAP)
+   munmap(buf, mapped);
+#endif
+}
+
 struct string_list *compressed_file_list_new(const char *path,
       const char* ext)
 {
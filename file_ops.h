@@ -63,6 +63,66 @@ int read_file(const char *path, void **buf, ssize_t *length);
  */
 bool write_file(const char *path, const void *buf, ssize_t size);
 
+/**
+ * write_file_atomic:
+ * @path             : path to file.
+ * @data             : contents to write to the file.
+ * @size             : size of the contents.
+ *
+ * Writes data to a temporary file next to @path, which then
+ * replaces @path. Whatever was at @path is left alone if
+ * writing fails part way, e.g. when the disk is full.
+ *
+ * Returns: true (1) on success, false (0) otherwise.
+ */
+bool write_file_atomic(const char *path, const void *data, ssize_t size);
+
+/**
+ * map_file:
+ * @path             : path to file.
+ * @min_size         : smallest file worth mapping.
+ * @buf              : set to the mapping of the file.
+ * @length           : set to the size of the file.
+ * @mapped           : set to the size of the mapping.
+ *
+ * Maps a file copy-on-write. Reading it is driven by page
+ * faults and the pages are shared with the page cache; writes
+ * go to private copies of the pages touched. Unlike read_file(),
+ * the contents are not NUL-terminated. Release with release_file().
+ *
+ * Returns: true (1) if mapped, false (0) if the file is smaller
+ * than @min_size, empty, compressed or can't be mapped here.
+ */
+bool map_file(const char *path, size_t min_size,
+      void **buf, ssize_t *length, size_t *mapped);
+
+/**
+ * read_file_mapped:
+ * @path             : path to file.
+ * @min_size         : smallest file worth mapping.
+ * @buf              : set to the contents of the file.
+ * @length           : Number of items read, -1 on error.
+ * @mapped           : set to the size of the mapping, or 0
+ *                     if @buf was read into memory.
+ *
+ * Maps files of at least @min_size with map_file(), and reads
+ * everything else, including compressed files and on platforms
+ * without mappings, with read_file(). Release with release_file().
+ *
+ * Returns: 1 if file read, 0 on error.
+ */
+int read_file_mapped(const char *path, size_t min_size,
+      void **buf, ssize_t *length, size_t *mapped);
+
+/**
+ * release_file:
+ * @buf              : contents from map_file() or read_file_mapped().
+ * @mapped           : size of the mapping, 0 if @buf was read.
+ *
+ * Unmaps or frees file contents.
+ */
+void release_file(void *buf, size_t mapped);
+
 #ifdef __cplusplus
 }
 #endif
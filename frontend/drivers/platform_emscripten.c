@@ -35,7 +35,12 @@ int main(int argc, char *argv[])
 {
    settings_t *settings = config_get_ptr();
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+   /* Running in a worker, on the canvas handed over to it. */
+   emscripten_set_canvas_element_size("#canvas", 800, 600);
+#else
    emscripten_set_canvas_size(800, 600);
+#endif
    rarch_main(argc, argv, NULL);
    emscripten_set_main_loop(emscripten_mainloop,
          settings->video.vsync ? 0 : INT_MAX, 1);
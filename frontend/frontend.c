@@ -20,6 +20,7 @@
 #include "../general.h"
 #include "../retroarch.h"
 #include "../runloop.h"
+#include "../performance.h"
 #include <file/file_path.h>
 
 #define MAX_ARGS 32
@@ -35,7 +36,9 @@ void main_exit_save_config(void)
    settings_t *settings = config_get_ptr();
    global_t   *global   = global_get_ptr();
 
-   if (settings->config_save_on_exit && *global->config_path)
+   /* The settings were overridden for the benchmark. */
+   if (settings->config_save_on_exit && *global->config_path
+         && !global->benchmark.frames)
    {
       /* Save last core-specific config to the default config location,
        * needed on consoles for core switching and reusing last good 
@@ -81,8 +84,11 @@ void main_exit(void *args)
       rarch_main_deinit();
    }
 
+   rarch_zone_sampler_free();
    event_command(EVENT_CMD_PERFCNT_REPORT_FRONTEND_LOG);
 
+   rarch_trace_free();
+
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
 #endif
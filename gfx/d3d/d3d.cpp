@@ -107,6 +107,17 @@ static void d3d_deinitialize(d3d_video_t *d3d)
    font_ctx = NULL;
    d3d_deinit_chain(d3d);
 
+#if defined(HAVE_D3D9) && !defined(_XBOX)
+   for (unsigned i = 0; i < D3D_MAX_QUERIES; i++)
+   {
+      if (d3d->queries[i])
+         d3d->queries[i]->Release();
+      d3d->queries[i] = NULL;
+   }
+   d3d->query_first = 0;
+   d3d->query_count = 0;
+#endif
+
 #ifndef _XBOX
    d3d->needs_restore = false;
 #endif
@@ -1573,6 +1584,51 @@ static void d3d_get_overlay_interface(void *data,
 }
 #endif
 
+#if defined(HAVE_D3D9) && !defined(_XBOX)
+/**
+ * d3d_hard_sync:
+ * @d3d                  : D3D driver handle.
+ *
+ * Marks the end of the frame with an event query and waits 
+ * until the GPU is done with the frame video_hard_sync_frames 
+ * ago, the same way the GL driver does with fences.
+ **/
+static void d3d_hard_sync(d3d_video_t *d3d)
+{
+   LPDIRECT3DQUERY9 *query;
+   retro_time_t stall_start = rarch_get_time_usec();
+   unsigned frames = video_hard_sync_get_frames(&d3d->hard_sync);
+
+   query = &d3d->queries[(d3d->query_first + d3d->query_count) 
+      % D3D_MAX_QUERIES];
+   if (!*query && FAILED(d3d->dev->CreateQuery(D3DQUERYTYPE_EVENT, query)))
+   {
+      *query = NULL;
+      return;
+   }
+
+   RARCH_PERFORMANCE_INIT(d3d_query);
+   RARCH_PERFORMANCE_START(d3d_query);
+
+   (*query)->Issue(D3DISSUE_END);
+   d3d->query_count++;
+
+   while (d3d->query_count > frames)
+   {
+      /* Fails once the device is lost, no point to wait then. */
+      while ((d3d->queries[d3d->query_first]->GetData(NULL, 0,
+                  D3DGETDATA_FLUSH)) == S_FALSE);
+
+      d3d->query_first = (d3d->query_first + 1) % D3D_MAX_QUERIES;
+      d3d->query_count--;
+   }
+
+   RARCH_PERFORMANCE_STOP(d3d_query);
+   video_hard_sync_update(&d3d->hard_sync,
+         rarch_get_time_usec() - stall_start);
+}
+#endif
+
 static bool d3d_frame(void *data, const void *frame,
       unsigned width, unsigned height, unsigned pitch,
       const char *msg)
@@ -1703,6 +1759,11 @@ static bool d3d_frame(void *data, const void *frame,
 
    gfx_ctx_swap_buffers(d3d);
 
+#if defined(HAVE_D3D9) && !defined(_XBOX)
+   if (settings->video.hard_sync && !d3d->needs_restore)
+      d3d_hard_sync(d3d);
+#endif
+
    return true;
 }
 
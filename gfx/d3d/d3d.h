@@ -141,6 +141,15 @@ typedef struct d3d_video
 
    /* TODO - refactor this away properly. */
    bool resolution_hd_enable;
+
+#if defined(HAVE_D3D9) && !defined(_XBOX)
+   /* Event queries marking the frames in flight for hard GPU sync. */
+#define D3D_MAX_QUERIES (VIDEO_HARD_SYNC_MAX_FRAMES + 1)
+   LPDIRECT3DQUERY9 queries[D3D_MAX_QUERIES];
+   unsigned query_first;
+   unsigned query_count;
+   video_hard_sync_t hard_sync;
+#endif
 } d3d_video_t;
 
 void d3d_make_d3dpp(void *data,
@@ -97,11 +97,8 @@ LPDIRECT3DVERTEXBUFFER d3d_vertex_buffer_new(LPDIRECT3DDEVICE dev,
    HRESULT hr;
    LPDIRECT3DVERTEXBUFFER buf;
 #ifndef _XBOX
-   if (usage == 0)
-   {
-	  if (dev->GetSoftwareVertexProcessing())
-         usage = D3DUSAGE_SOFTWAREPROCESSING;
-   }
+   if (dev->GetSoftwareVertexProcessing())
+      usage |= D3DUSAGE_SOFTWAREPROCESSING;
 #endif
 
 #if defined(HAVE_D3D8)
@@ -152,6 +149,23 @@ void *d3d_vertex_buffer_lock(LPDIRECT3DVERTEXBUFFER vertbuf)
    return buf;
 }
 
+/* Lets the driver hand out fresh memory instead of waiting for
+ * the GPU to be done with the old contents. The buffer has to be
+ * created with D3DUSAGE_DYNAMIC. */
+void *d3d_vertex_buffer_lock_discard(LPDIRECT3DVERTEXBUFFER vertbuf)
+{
+#if defined(_XBOX)
+   return d3d_vertex_buffer_lock(vertbuf);
+#else
+   void *buf = NULL;
+
+   if (FAILED(vertbuf->Lock(0, 0, &buf, D3DLOCK_DISCARD)))
+      return NULL;
+
+   return buf;
+#endif
+}
+
 void d3d_vertex_buffer_free(void *vertex_data, void *vertex_declaration)
 {
    if (vertex_data)
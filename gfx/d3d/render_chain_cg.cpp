@@ -47,9 +47,18 @@ struct Pass
    LPDIRECT3DTEXTURE tex;
    LPDIRECT3DVERTEXBUFFER vertex_buf;
    CGprogram vPrg, fPrg;
+   /* Sizes the vertices were last written for. */
    unsigned last_width, last_height;
+   unsigned last_out_width, last_out_height;
    LPDIRECT3DVERTEXDECLARATION vertex_decl;
    std::vector<unsigned> attrib_map;
+   /* PREV* parameters of the shaders, looked up once. */
+   struct
+   {
+      CGparameter video_size_v, video_size_f;
+      CGparameter texture_size_v, texture_size_f;
+      CGparameter texture, tex_coord;
+   } prev[TEXTURES - 1];
 };
 
 typedef struct cg_renderchain
@@ -67,6 +76,8 @@ typedef struct cg_renderchain
       unsigned ptr;
       unsigned last_width[TEXTURES];
       unsigned last_height[TEXTURES];
+      unsigned last_out_width[TEXTURES];
+      unsigned last_out_height[TEXTURES];
    } prev;
    std::vector<Pass> passes;
    CGprogram vStock, fStock;
@@ -531,13 +542,17 @@ static void renderchain_bind_orig(void *data, void *pass_data)
    }
 }
 
-static void renderchain_bind_prev(void *data, void *pass_data)
+/**
+ * renderchain_init_prev:
+ * @pass                  : Pass whose shaders were just compiled.
+ *
+ * Looks up the PREV* parameters of the pass once, so binding the
+ * previous frames doesn't have to look them up by name every frame.
+ **/
+static void renderchain_init_prev(Pass *pass)
 {
-   unsigned i, index;
+   unsigned i;
    char attr_texture[64], attr_input_size[64], attr_tex_size[64], attr_coord[64];
-   D3DXVECTOR2 texture_size;
-   Pass           *pass = (Pass*)pass_data;
-   cg_renderchain_t *chain = (cg_renderchain_t*)data;
    static const char *prev_names[] = {
       "PREV",
       "PREV1",
@@ -548,36 +563,60 @@ static void renderchain_bind_prev(void *data, void *pass_data)
       "PREV6",
    };
 
-   texture_size.x = chain->passes[0].info.tex_w;
-   texture_size.y = chain->passes[0].info.tex_h;
-
    for (i = 0; i < TEXTURES - 1; i++)
    {
-      CGparameter param;
-      D3DXVECTOR2 video_size;
-
       snprintf(attr_texture,    sizeof(attr_texture),    "%s.texture",      prev_names[i]);
       snprintf(attr_input_size, sizeof(attr_input_size), "%s.video_size",   prev_names[i]);
       snprintf(attr_tex_size,   sizeof(attr_tex_size),   "%s.texture_size", prev_names[i]);
       snprintf(attr_coord,      sizeof(attr_coord),      "%s.tex_coord",    prev_names[i]);
 
-      video_size.x = chain->prev.last_width[(chain->prev.ptr - (i + 1)) & TEXTURESMASK];
-      video_size.y = chain->prev.last_height[(chain->prev.ptr - (i + 1)) & TEXTURESMASK];
+      pass->prev[i].video_size_v   = cgGetNamedParameter(pass->vPrg, attr_input_size);
+      pass->prev[i].video_size_f   = cgGetNamedParameter(pass->fPrg, attr_input_size);
+      pass->prev[i].texture_size_v = cgGetNamedParameter(pass->vPrg, attr_tex_size);
+      pass->prev[i].texture_size_f = cgGetNamedParameter(pass->fPrg, attr_tex_size);
+      pass->prev[i].texture        = cgGetNamedParameter(pass->fPrg, attr_texture);
+      pass->prev[i].tex_coord      = cgGetNamedParameter(pass->vPrg, attr_coord);
+   }
+}
 
-      set_cg_param(pass->vPrg, attr_input_size, video_size);
-      set_cg_param(pass->fPrg, attr_input_size, video_size);
-      set_cg_param(pass->vPrg, attr_tex_size, texture_size);
-      set_cg_param(pass->fPrg, attr_tex_size, texture_size);
+static void renderchain_bind_prev(void *data, void *pass_data)
+{
+   unsigned i, index;
+   D3DXVECTOR2 texture_size;
+   Pass           *pass = (Pass*)pass_data;
+   cg_renderchain_t *chain = (cg_renderchain_t*)data;
 
-      param = cgGetNamedParameter(pass->fPrg, attr_texture);
+   texture_size.x = chain->passes[0].info.tex_w;
+   texture_size.y = chain->passes[0].info.tex_h;
+
+   for (i = 0; i < TEXTURES - 1; i++)
+   {
+      CGparameter param;
+      D3DXVECTOR2 video_size;
+      /* The ring holds the previous frames by index, nothing has
+       * to be moved around as it rotates. */
+      unsigned slot = (chain->prev.ptr - (i + 1)) & TEXTURESMASK;
+
+      video_size.x = chain->prev.last_width[slot];
+      video_size.y = chain->prev.last_height[slot];
+
+      if (pass->prev[i].video_size_v)
+         cgD3D9SetUniform(pass->prev[i].video_size_v, &video_size);
+      if (pass->prev[i].video_size_f)
+         cgD3D9SetUniform(pass->prev[i].video_size_f, &video_size);
+      if (pass->prev[i].texture_size_v)
+         cgD3D9SetUniform(pass->prev[i].texture_size_v, &texture_size);
+      if (pass->prev[i].texture_size_f)
+         cgD3D9SetUniform(pass->prev[i].texture_size_f, &texture_size);
+
+      param = pass->prev[i].texture;
       if (param)
       {
          LPDIRECT3DTEXTURE tex;
 
          index = cgGetParameterResourceIndex(param);
 
-         tex = (LPDIRECT3DTEXTURE)
-            chain->prev.tex[(chain->prev.ptr - (i + 1)) & TEXTURESMASK];
+         tex = (LPDIRECT3DTEXTURE)chain->prev.tex[slot];
 
          d3d_set_texture(chain->dev, index, tex);
          chain->bound_tex.push_back(index);
@@ -590,14 +629,13 @@ static void renderchain_bind_prev(void *data, void *pass_data)
          d3d_set_sampler_address_v(chain->dev, index, D3DTADDRESS_BORDER);
       }
 
-      param = cgGetNamedParameter(pass->vPrg, attr_coord);
+      param = pass->prev[i].tex_coord;
       if (param)
       {
          LPDIRECT3DVERTEXBUFFER vert_buf;
 
          index = pass->attrib_map[cgGetParameterResourceIndex(param)];
-         vert_buf = (LPDIRECT3DVERTEXBUFFER)
-            chain->prev.vertex_buf[(chain->prev.ptr - (i + 1)) & TEXTURESMASK];
+         vert_buf = (LPDIRECT3DVERTEXBUFFER)chain->prev.vertex_buf[slot];
          chain->bound_vert.push_back(index);
 
          d3d_set_stream_source(chain->dev, index, vert_buf, 0, sizeof(Vertex));
@@ -883,18 +921,23 @@ static bool renderchain_create_first_pass(void *data, const void *info_data,
    d3d_set_transform(d3dr, D3DTS_WORLD, &ident);
    d3d_set_transform(d3dr, D3DTS_VIEW, &ident);
 
-   pass.info        = *info;
-   pass.last_width  = 0;
-   pass.last_height = 0;
+   pass.info            = *info;
+   pass.last_width      = 0;
+   pass.last_height     = 0;
+   pass.last_out_width  = 0;
+   pass.last_out_height = 0;
 
    chain->prev.ptr  = 0;
 
    for (i = 0; i < TEXTURES; i++)
    {
-      chain->prev.last_width[i]  = 0;
-      chain->prev.last_height[i] = 0;
+      chain->prev.last_width[i]      = 0;
+      chain->prev.last_height[i]     = 0;
+      chain->prev.last_out_width[i]  = 0;
+      chain->prev.last_out_height[i] = 0;
       chain->prev.vertex_buf[i]  = d3d_vertex_buffer_new(
-            d3dr, 4 * sizeof(Vertex), 0, 0, D3DPOOL_DEFAULT, NULL);
+            d3dr, 4 * sizeof(Vertex), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY,
+            0, D3DPOOL_DEFAULT, NULL);
 
       if (!chain->prev.vertex_buf[i])
          return false;
@@ -919,6 +962,7 @@ static bool renderchain_create_first_pass(void *data, const void *info_data,
 
    renderchain_compile_shaders(chain, &pass.fPrg,
          &pass.vPrg, info->pass->source.path);
+   renderchain_init_prev(&pass);
 
    if (!cg_d3d9_renderchain_init_shader_fvf(chain, &pass))
       return false;
@@ -979,6 +1023,10 @@ static bool renderchain_set_pass_size(void *data, unsigned pass_index,
       if (!pass->tex)
          return false;
 
+      /* Texture coordinates are relative to the texture size. */
+      pass->last_width  = 0;
+      pass->last_height = 0;
+
       d3d_set_texture(d3dr, 0, pass->tex);
       d3d_set_sampler_address_u(d3dr, 0, D3DTADDRESS_BORDER);
       d3d_set_sampler_address_v(d3dr, 0, D3DTADDRESS_BORDER);
@@ -1101,15 +1149,18 @@ static bool cg_d3d9_renderchain_add_pass(void *data, const void *info_data)
    pass.info                = *info;
    pass.last_width          = 0;
    pass.last_height         = 0;
+   pass.last_out_width      = 0;
+   pass.last_out_height     = 0;
 
    renderchain_compile_shaders(chain, &pass.fPrg, 
         &pass.vPrg, info->pass->source.path);
+   renderchain_init_prev(&pass);
 
    if (!cg_d3d9_renderchain_init_shader_fvf(chain, &pass))
       return false;
 
    pass.vertex_buf = (LPDIRECT3DVERTEXBUFFER)d3d_vertex_buffer_new(d3dr, 4 * sizeof(Vertex),
-	   0, 0, D3DPOOL_DEFAULT, NULL);
+	   D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, NULL);
 
    if (!pass.vertex_buf)
       return false;
@@ -1194,6 +1245,10 @@ static void renderchain_start_render(void *data)
    chain->passes[0].vertex_buf  = chain->prev.vertex_buf[chain->prev.ptr];
    chain->passes[0].last_width  = chain->prev.last_width[chain->prev.ptr];
    chain->passes[0].last_height = chain->prev.last_height[chain->prev.ptr];
+   chain->passes[0].last_out_width  =
+      chain->prev.last_out_width[chain->prev.ptr];
+   chain->passes[0].last_out_height =
+      chain->prev.last_out_height[chain->prev.ptr];
 }
 
 static void renderchain_end_render(void *data)
@@ -1205,6 +1260,10 @@ static void renderchain_end_render(void *data)
 
    chain->prev.last_width[chain->prev.ptr]  = chain->passes[0].last_width;
    chain->prev.last_height[chain->prev.ptr] = chain->passes[0].last_height;
+   chain->prev.last_out_width[chain->prev.ptr]  =
+      chain->passes[0].last_out_width;
+   chain->prev.last_out_height[chain->prev.ptr] =
+      chain->passes[0].last_out_height;
    chain->prev.ptr                          = (chain->prev.ptr + 1) & TEXTURESMASK;
 }
 
@@ -1240,7 +1299,11 @@ static void renderchain_set_vertices(
    cg_renderchain_t *chain = (cg_renderchain_t*)data;
    const LinkInfo *info = (const LinkInfo*)&pass->info;
 
-   if (pass->last_width != width || pass->last_height != height)
+   /* The vertices only change with the sizes,
+    * rewrite them only then. */
+   if (pass->last_width != width || pass->last_height != height ||
+         pass->last_out_width  != out_width ||
+         pass->last_out_height != out_height)
    {
       Vertex vert[4];
       unsigned i;
@@ -1248,8 +1311,10 @@ static void renderchain_set_vertices(
       float _u          = float(width)  / info->tex_w;
       float _v          = float(height) / info->tex_h;
 
-      pass->last_width  = width;
-      pass->last_height = height;
+      pass->last_width      = width;
+      pass->last_height     = height;
+      pass->last_out_width  = out_width;
+      pass->last_out_height = out_height;
 
       for (i = 0; i < 4; i++)
       {
@@ -1291,9 +1356,12 @@ static void renderchain_set_vertices(
          vert[i].y     += 0.5f;
       }
 
-      verts             = d3d_vertex_buffer_lock(pass->vertex_buf);
-      memcpy(verts, vert, sizeof(vert));
-      d3d_vertex_buffer_unlock(pass->vertex_buf);
+      verts             = d3d_vertex_buffer_lock_discard(pass->vertex_buf);
+      if (verts)
+      {
+         memcpy(verts, vert, sizeof(vert));
+         d3d_vertex_buffer_unlock(pass->vertex_buf);
+      }
    }
 
    renderchain_set_mvp(chain, pass->vPrg, vp_width, vp_height, rotation);
@@ -33,8 +33,6 @@
 #include "config.h"
 #endif
 
-#define NUMPAGES 2
-
 struct dispmanx_video
 { 
    DISPMANX_DISPLAY_HANDLE_T display;
@@ -61,10 +59,17 @@ struct dispmanx_video
    bool aspectRatioCorrection;
    void *pixmem;
 
+   /* Page pool. The vsync callback puts the page that was on screen
+    * back on the free list, so frames are written while a flip is
+    * still pending whenever there are more than two pages. */
    struct dispmanx_page *pages;
+   unsigned int numpages;
+   struct dispmanx_page *free_pages;
    struct dispmanx_page *currentPage;
-   struct dispmanx_page *nextPage;
-   bool pageflip_pending;
+   struct dispmanx_page *pendingPage;
+   /* Frame waiting for the pending flip, in nonblocking mode. */
+   struct dispmanx_page *queuedPage;
+   bool nonblock;
 
    /* For console blanking */
    int fd;
@@ -97,6 +102,7 @@ struct dispmanx_video
 struct dispmanx_page
 {
    DISPMANX_RESOURCE_HANDLE_T resource;
+   struct dispmanx_page *next;
 };
 
 static void dispmanx_blank_console(void *data)
@@ -164,24 +170,79 @@ static void dispmanx_vsync_callback(DISPMANX_UPDATE_HANDLE_T u, void *data)
 {
    struct dispmanx_video *_dispvars = data;
 
-   /* Changing the page to write must be done before the signaling
-    * so we have the right page in nextPage when update_main continues */
+   slock_lock(_dispvars->pending_mutex);
 
-   if (_dispvars->nextPage == &_dispvars->pages[0])	
-      _dispvars->nextPage = &_dispvars->pages[1];
-   else 
-      _dispvars->nextPage = &_dispvars->pages[0];
+   /* The flipped page is on screen now, so the one
+    * shown until now can be written again. */
+   if (_dispvars->currentPage)
+   {
+      _dispvars->currentPage->next = _dispvars->free_pages;
+      _dispvars->free_pages        = _dispvars->currentPage;
+   }
+   _dispvars->currentPage = _dispvars->pendingPage;
+   _dispvars->pendingPage = NULL;
 
-   /* These two things must be isolated "atomically" to avoid getting 
-    * a false positive in the pending_mutex test in update_main. */ 
-   slock_lock(_dispvars->pending_mutex);
-   
-   _dispvars->pageflip_pending = false;	
    scond_signal(_dispvars->vsync_condition);
-  
    slock_unlock(_dispvars->pending_mutex);
 }
 
+/* Waits until the last issued flip completes.
+ * Dispmanx doesn't support issuing more than one. */
+static void dispmanx_wait_flip(struct dispmanx_video *_dispvars)
+{
+   slock_lock(_dispvars->pending_mutex);
+   while (_dispvars->pendingPage)
+      scond_wait(_dispvars->vsync_condition, _dispvars->pending_mutex);
+   slock_unlock(_dispvars->pending_mutex);
+}
+
+static struct dispmanx_page *dispmanx_get_free_page(
+      struct dispmanx_video *_dispvars)
+{
+   struct dispmanx_page *page = NULL;
+
+   slock_lock(_dispvars->pending_mutex);
+
+   while (!_dispvars->free_pages)
+   {
+      /* Rather than wait, replace the frame
+       * that is waiting for its flip. */
+      if (_dispvars->nonblock && _dispvars->queuedPage)
+      {
+         page                  = _dispvars->queuedPage;
+         _dispvars->queuedPage = NULL;
+         slock_unlock(_dispvars->pending_mutex);
+         return page;
+      }
+      scond_wait(_dispvars->vsync_condition, _dispvars->pending_mutex);
+   }
+
+   page                  = _dispvars->free_pages;
+   _dispvars->free_pages = page->next;
+
+   slock_unlock(_dispvars->pending_mutex);
+   return page;
+}
+
+/* Issues a page flip that will be done at the next vsync.
+ * No other flip may be pending. */
+static void dispmanx_flip(struct dispmanx_video *_dispvars,
+      struct dispmanx_page *page)
+{
+   /* Set before submitting, the callback can come right away. */
+   slock_lock(_dispvars->pending_mutex);
+   _dispvars->pendingPage = page;
+   slock_unlock(_dispvars->pending_mutex);
+
+   _dispvars->update = vc_dispmanx_update_start(0);
+
+   vc_dispmanx_element_change_source(_dispvars->update, _dispvars->element,
+         page->resource);
+
+   vc_dispmanx_update_submit(_dispvars->update,
+         dispmanx_vsync_callback, (void*)_dispvars);
+}
+
 static void dispmanx_free_main_resources(void *data)
 {
    int i;	
@@ -190,9 +251,12 @@ static void dispmanx_free_main_resources(void *data)
    if (!_dispvars)
       return;
 
+   /* The pending flip still uses its resource. */
+   dispmanx_wait_flip(_dispvars);
+
    _dispvars->update = vc_dispmanx_update_start(0);
 
-   for (i = 0; i < NUMPAGES; i++) 
+   for (i = 0; i < _dispvars->numpages; i++)
       vc_dispmanx_resource_delete(_dispvars->pages[i].resource);
 
    vc_dispmanx_element_remove(_dispvars->update, _dispvars->element);
@@ -285,11 +349,23 @@ static bool dispmanx_setup_scale(void *data, unsigned width,
    vc_dispmanx_rect_set(&(_dispvars->bmpRect), 0, 0, _dispvars->width, _dispvars->height);	
    vc_dispmanx_rect_set(&(_dispvars->srcRect), 0, 0, _dispvars->width << 16, _dispvars->height << 16);	
 
-   /* We create as many resources as pages */
-   for (i = 0; i < NUMPAGES; i++)
+   /* We create as many resources as pages. The first one is
+    * shown by the new element, the others are free. */
+   _dispvars->free_pages = NULL;
+   for (i = _dispvars->numpages - 1; i >= 0; i--)
+   {
       _dispvars->pages[i].resource = vc_dispmanx_resource_create(_dispvars->pixFormat, 
 	 _dispvars->visible_width, _dispvars->height, &(_dispvars->vcImagePtr));
 
+      if (i == 0)
+         break;
+      _dispvars->pages[i].next = _dispvars->free_pages;
+      _dispvars->free_pages    = &_dispvars->pages[i];
+   }
+   _dispvars->currentPage = &_dispvars->pages[0];
+   _dispvars->pendingPage = NULL;
+   _dispvars->queuedPage  = NULL;
+
    /* Add element. */
    _dispvars->update = vc_dispmanx_update_start(0);
 
@@ -304,52 +380,77 @@ static bool dispmanx_setup_scale(void *data, unsigned width,
 
 static void dispmanx_update_main(void *data, const void *frame)
 {
+   bool pending;
+   struct dispmanx_page *page       = NULL;
    struct dispmanx_video *_dispvars = data;
 
-   /* Wait until last issued flip completes to get the free page 
-    * that the vsync cb will put in nextPage. Also, dispmanx doesn't 
-    * support issuing more than one pageflip.*/
+   /* A frame queued in nonblocking mode goes out
+    * as soon as its flip can be issued. */
    slock_lock(_dispvars->pending_mutex);
-   if (_dispvars->pageflip_pending)
+   if (!_dispvars->pendingPage && _dispvars->queuedPage)
    {
-      scond_wait(_dispvars->vsync_condition, _dispvars->pending_mutex);
+      page                  = _dispvars->queuedPage;
+      _dispvars->queuedPage = NULL;
    }
    slock_unlock(_dispvars->pending_mutex);
-   
-   /* Frame blitting */
-   vc_dispmanx_resource_write_data(_dispvars->nextPage->resource, _dispvars->pixFormat,
-         _dispvars->pitch, (void *)frame, &(_dispvars->bmpRect));
 
-   /* Issue a page flip that will be done at the next vsync. */
-   _dispvars->update = vc_dispmanx_update_start(0);
+   if (page)
+      dispmanx_flip(_dispvars, page);
 
-   vc_dispmanx_element_change_source(_dispvars->update, _dispvars->element,
-         _dispvars->nextPage->resource);
+   /* Frame blitting. With more than two pages this
+    * overlaps with the flip that is still pending. */
+   page = dispmanx_get_free_page(_dispvars);
+   vc_dispmanx_resource_write_data(page->resource, _dispvars->pixFormat,
+         _dispvars->pitch, (void *)frame, &(_dispvars->bmpRect));
 
-   vc_dispmanx_update_submit(_dispvars->update, dispmanx_vsync_callback, (void*)_dispvars);
+   if (_dispvars->nonblock)
+   {
+      slock_lock(_dispvars->pending_mutex);
+      pending = _dispvars->pendingPage != NULL;
+      if (pending)
+      {
+         /* Replaces the frame queued before, if any. */
+         if (_dispvars->queuedPage)
+         {
+            _dispvars->queuedPage->next = _dispvars->free_pages;
+            _dispvars->free_pages       = _dispvars->queuedPage;
+         }
+         _dispvars->queuedPage = page;
+      }
+      slock_unlock(_dispvars->pending_mutex);
+
+      if (pending)
+         return;
+   }
+   else
+      dispmanx_wait_flip(_dispvars);
 
-   slock_lock(_dispvars->pending_mutex);
-   _dispvars->pageflip_pending = true;	
-   slock_unlock(_dispvars->pending_mutex);
+   dispmanx_flip(_dispvars, page);
 }
 
 static void *dispmanx_gfx_init(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
    int i; 
+   settings_t *settings = config_get_ptr();
    struct dispmanx_video *_dispvars = calloc(1, sizeof(struct dispmanx_video));
 
    if (!_dispvars)
       return NULL;
 
+   _dispvars->numpages         = settings->video.max_swapchain_images;
+   if (_dispvars->numpages < 2)
+      _dispvars->numpages      = 2;
+
    _dispvars->bytes_per_pixel  = video->rgb32 ? 4 : 2;
    _dispvars->screen           = 0;
    _dispvars->vcImagePtr       = 0;
-   _dispvars->pageflip_pending = false;	
    _dispvars->currentPage      = NULL;
-   _dispvars->pages            = calloc(NUMPAGES, sizeof(struct dispmanx_page));
+   _dispvars->pendingPage      = NULL;
+   _dispvars->queuedPage       = NULL;
+   _dispvars->nonblock         = !video->vsync;
+   _dispvars->pages            = calloc(_dispvars->numpages, sizeof(struct dispmanx_page));
    _dispvars->menu_active      = false;
-   _dispvars->nextPage         = &_dispvars->pages[0];
  
    if (!_dispvars->pages)
    {
@@ -514,12 +615,10 @@ static void dispmanx_set_texture_frame(void *data, const void *frame, bool rgb32
 
 static void dispmanx_gfx_set_nonblock_state(void *data, bool state)
 {
-   struct dispmanx_video *vid = data;
-
-   (void)data;
-   (void)vid;
+   struct dispmanx_video *_dispvars = data;
 
-   /* TODO */
+   if (_dispvars)
+      _dispvars->nonblock = state;
 }
 
 static bool dispmanx_gfx_alive(void *data)
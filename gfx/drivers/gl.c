@@ -22,6 +22,7 @@
 #include "../../driver.h"
 #include "../../performance.h"
 #include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
 #include <formats/image.h>
 #include <retro_inline.h>
 
@@ -43,6 +44,10 @@
 #include "../video_viewport.h"
 #include "../video_pixel_converter.h"
 #include "../video_context_driver.h"
+#include "../video_texture.h"
+#ifdef HAVE_THREADS
+#include "../video_thread_wrapper.h"
+#endif
 #include <compat/strl.h>
 
 #ifdef HAVE_GLSL
@@ -568,6 +573,7 @@ static void gl_deinit_fbo(gl_t *gl)
    memset(gl->fbo, 0, sizeof(gl->fbo));
    gl->fbo_inited = false;
    gl->fbo_pass = 0;
+   gl->fbo_cache_valid = false;
 }
 
 /* Set up render to texture. */
@@ -646,6 +652,14 @@ static void gl_deinit_hw_render(gl_t *gl)
    if (!gl)
       return;
 
+   /* The framebuffers belong to the core's context, on its thread.
+    * They're remade there for the new textures. */
+   if (gl->hw_render_threaded)
+   {
+      gl->hw_render_fbo_init = false;
+      return;
+   }
+
    context_bind_hw_render(gl, true);
 
    if (gl->hw_render_fbo_init)
@@ -657,27 +671,25 @@ static void gl_deinit_hw_render(gl_t *gl)
    context_bind_hw_render(gl, false);
 }
 
-static bool gl_init_hw_render(gl_t *gl, unsigned width, unsigned height)
+/**
+ * gl_create_hw_render_fbos:
+ * @gl                    : GL handle.
+ * @width                 : Width of the depth buffers.
+ * @height                : Height of the depth buffers.
+ *
+ * Makes the framebuffers the core renders to, one for each
+ * texture, in the context current on the calling thread.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool gl_create_hw_render_fbos(gl_t *gl,
+      unsigned width, unsigned height)
 {
    GLenum status;
    unsigned i;
    bool depth = false, stencil = false;
-   GLint max_fbo_size = 0, max_renderbuffer_size = 0;
    global_t *global = global_get_ptr();
 
-   /* We can only share texture objects through contexts.
-    * FBOs are "abstract" objects and are not shared. */
-   context_bind_hw_render(gl, true);
-
-   RARCH_LOG("[GL]: Initializing HW render (%u x %u).\n", width, height);
-   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_fbo_size);
-   glGetIntegerv(RARCH_GL_MAX_RENDERBUFFER_SIZE, &max_renderbuffer_size);
-   RARCH_LOG("[GL]: Max texture size: %d px, renderbuffer size: %d px.\n",
-         max_fbo_size, max_renderbuffer_size);
-
-   if (!gl_check_fbo_proc(gl))
-      return false;
-
    glBindTexture(GL_TEXTURE_2D, 0);
    glGenFramebuffers(gl->textures, gl->hw_render_fbo);
 
@@ -744,6 +756,39 @@ static bool gl_init_hw_render(gl_t *gl, unsigned width, unsigned height)
       }
    }
 
+   return true;
+}
+
+static bool gl_init_hw_render(gl_t *gl, unsigned width, unsigned height)
+{
+   GLint max_fbo_size = 0, max_renderbuffer_size = 0;
+
+   /* We can only share texture objects through contexts.
+    * FBOs are "abstract" objects and are not shared. */
+   context_bind_hw_render(gl, true);
+
+   RARCH_LOG("[GL]: Initializing HW render (%u x %u).\n", width, height);
+   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_fbo_size);
+   glGetIntegerv(RARCH_GL_MAX_RENDERBUFFER_SIZE, &max_renderbuffer_size);
+   RARCH_LOG("[GL]: Max texture size: %d px, renderbuffer size: %d px.\n",
+         max_fbo_size, max_renderbuffer_size);
+
+   if (!gl_check_fbo_proc(gl))
+      return false;
+
+   if (gl->hw_render_threaded)
+   {
+      /* The textures have to be complete before the core's
+       * context, on the other thread, attaches them. */
+      glFinish();
+      gl->hw_render_gen++;
+      gl->hw_render_fbo_init = true;
+      return true;
+   }
+
+   if (!gl_create_hw_render_fbos(gl, width, height))
+      return false;
+
    gl_bind_backbuffer();
    gl->hw_render_fbo_init = true;
 
@@ -957,6 +1002,53 @@ static void gl_check_fbo_dimensions(gl_t *gl)
    }
 }
 
+/**
+ * gl_get_fbo_dirty_pass:
+ * @gl                   : GL driver handle.
+ * @frame_changed        : The core produced a new frame.
+ *
+ * Finds the first FBO pass that has to be rendered this frame.
+ * Cacheable passes keep their FBO contents from the last frame 
+ * as long as the frame, FBO sizes and shader parameters stay 
+ * the same, which is the case while paused or in the menu.
+ *
+ * Returns: index of the first FBO pass to render.
+ **/
+static int gl_get_fbo_dirty_pass(gl_t *gl, bool frame_changed)
+{
+   int i;
+   bool valid                  = gl->fbo_cache_valid && !frame_changed;
+   struct video_shader *shader = gl->shader->get_current_shader();
+
+   gl->fbo_cache_valid = true;
+
+   if (memcmp(gl->fbo_cache_rect, gl->fbo_rect, sizeof(gl->fbo_rect)))
+   {
+      memcpy(gl->fbo_cache_rect, gl->fbo_rect, sizeof(gl->fbo_rect));
+      valid = false;
+   }
+
+   if (!shader)
+      return 0;
+
+   for (i = 0; i < (int)shader->num_parameters; i++)
+   {
+      if (gl->fbo_cache_params[i] != shader->parameters[i].current)
+      {
+         gl->fbo_cache_params[i] = shader->parameters[i].current;
+         valid = false;
+      }
+   }
+
+   if (!valid)
+      return 0;
+
+   for (i = 0; i < gl->fbo_pass; i++)
+      if (i >= (int)shader->passes || !shader->pass[i].cacheable)
+         return i;
+   return gl->fbo_pass;
+}
+
 static void gl_frame_fbo(gl_t *gl,
       const struct gl_tex_info *tex_info)
 {
@@ -994,6 +1086,10 @@ static void gl_frame_fbo(gl_t *gl,
       memcpy(fbo_info->coord, fbo_tex_coords, sizeof(fbo_tex_coords));
       fbo_tex_info_cnt++;
 
+      /* Still holds what it rendered last frame. */
+      if (i < gl->fbo_dirty_pass)
+         continue;
+
       glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->fbo[i]);
 
       gl->shader->use(gl, i + 1);
@@ -1086,6 +1182,7 @@ static void gl_update_input_size(gl_t *gl, unsigned width,
 
       if (clear)
       {
+         gl->frame_diff_serial[gl->tex_index] = 0;
          glPixelStorei(GL_UNPACK_ALIGNMENT,
                video_pixel_get_alignment(width * sizeof(uint32_t)));
 #if defined(HAVE_PSGL)
@@ -1244,7 +1341,22 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
    }
 #endif
 
+#ifdef HAVE_OPENGLES2
+   {
+      driver_t *driver = driver_get_ptr();
+
+      /* Swapping red and blue when sampling saves converting 
+       * every frame on the CPU. */
+      gl->rgba_swizzle = driver->gfx_use_rgba && gl->have_texture_swizzle
+         && !gl->hw_render_use && !gl->egl_images
+         && gl->base_size == sizeof(uint32_t);
+      if (gl->rgba_swizzle)
+         RARCH_LOG("[GL]: Swizzling 32-bit frames instead of converting them.\n");
+   }
+#endif
+
    glGenTextures(gl->textures, gl->texture);
+   memset(gl->frame_diff_serial, 0, sizeof(gl->frame_diff_serial));
 
    for (i = 0; i < gl->textures; i++)
    {
@@ -1265,6 +1377,15 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
       if (gl->egl_images)
          continue;
 
+#ifdef HAVE_OPENGLES2
+      if (gl->rgba_swizzle)
+      {
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_ONE);
+      }
+#endif
+
       glTexImage2D(GL_TEXTURE_2D,
             0, internal_fmt, gl->tex_w, gl->tex_h, 0, texture_type,
             texture_fmt, gl->empty_buf ? gl->empty_buf : NULL);
@@ -1273,12 +1394,373 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
 }
 
+#ifdef HAVE_GL_SYNC
+#define PBO_UNPACK_FLAGS (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | \
+      GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+static void gl_deinit_pbo_unpack(gl_t *gl)
+{
+   unsigned i;
+
+   if (gl->pbo_stream)
+      glDeleteBuffers(1, &gl->pbo_stream);
+   gl->pbo_stream = 0;
+
+   if (!gl->pbo_unpack_enable)
+      return;
+
+   for (i = 0; i < MAX_UNPACK_PBOS; i++)
+   {
+      if (gl->pbo_unpack_fence[i])
+      {
+         glClientWaitSync(gl->pbo_unpack_fence[i],
+               GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+         glDeleteSync(gl->pbo_unpack_fence[i]);
+         gl->pbo_unpack_fence[i] = NULL;
+      }
+
+      if (gl->pbo_unpack_map[i])
+      {
+         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_unpack[i]);
+         glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+         gl->pbo_unpack_map[i] = NULL;
+      }
+   }
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   glDeleteBuffers(MAX_UNPACK_PBOS, gl->pbo_unpack);
+   memset(gl->pbo_unpack, 0, sizeof(gl->pbo_unpack));
+   gl->pbo_unpack_enable = false;
+}
+
+/**
+ * gl_init_pbo_unpack:
+ * @gl                   : GL driver handle.
+ *
+ * Creates persistently mapped PBOs software cores can render 
+ * to directly, so the texture is updated without copying the 
+ * frame on the CPU. Frames in client memory are copied into 
+ * them instead, so the texture upload doesn't stall.
+ * Needs ARB_buffer_storage and ARB_sync, falls back to a single 
+ * orphaned PBO otherwise.
+ **/
+static void gl_init_pbo_unpack(gl_t *gl)
+{
+   unsigned i;
+   GLsizeiptr size = gl->tex_w * gl->tex_h * gl->base_size;
+
+   if (gl->hw_render_use)
+      return;
+
+   /* RGB565 frames get converted on the CPU without ES2 compat. */
+   if (gl->base_size == 2 && !gl->have_es2_compat)
+      return;
+
+   if (!glMapBufferRange)
+      return;
+
+   if (!gl->have_sync || !gl_query_extension(gl, "ARB_buffer_storage")
+         || !glBufferStorage)
+   {
+      glGenBuffers(1, &gl->pbo_stream);
+      RARCH_LOG("[GL]: Streaming frames through an orphaned PBO.\n");
+      return;
+   }
+
+   glGenBuffers(MAX_UNPACK_PBOS, gl->pbo_unpack);
+   for (i = 0; i < MAX_UNPACK_PBOS; i++)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_unpack[i]);
+      glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, PBO_UNPACK_FLAGS);
+      gl->pbo_unpack_map[i] = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+            0, size, PBO_UNPACK_FLAGS);
+
+      if (!gl->pbo_unpack_map[i])
+      {
+         RARCH_WARN("[GL]: Failed to map unpack PBO.\n");
+         gl_deinit_pbo_unpack(gl);
+         return;
+      }
+   }
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   RARCH_LOG("[GL]: Persistently mapped unpack PBOs enabled.\n");
+   gl->pbo_unpack_index  = 0;
+   gl->pbo_unpack_enable = true;
+}
+
+/**
+ * gl_copy_frame_pbo_unpack:
+ * @gl                   : GL driver handle.
+ * @frame                : Frame the core rendered.
+ * @width                : Width of frame.
+ * @height               : Height of frame.
+ * @pitch                : Pitch of frame.
+ *
+ * Updates the texture straight from one of the mapped unpack PBOs 
+ * if the core rendered into it, see 
+ * gl_get_current_software_framebuffer().
+ *
+ * Returns: true (1) if @frame lives in an unpack PBO, 
+ * otherwise false (0).
+ **/
+static bool gl_copy_frame_pbo_unpack(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   unsigned i;
+
+   if (!gl->pbo_unpack_enable)
+      return false;
+
+   for (i = 0; i < MAX_UNPACK_PBOS; i++)
+      if (frame == gl->pbo_unpack_map[i])
+         break;
+
+   if (i == MAX_UNPACK_PBOS)
+      return false;
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_unpack[i]);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
+
+   glTexSubImage2D(GL_TEXTURE_2D,
+         0, 0, 0, width, height, gl->texture_type,
+         gl->texture_fmt, NULL);
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   /* The core must not write to this buffer again 
+    * before the GPU is done reading from it. */
+   if (gl->pbo_unpack_fence[i])
+      glDeleteSync(gl->pbo_unpack_fence[i]);
+   gl->pbo_unpack_fence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+   gl->pbo_unpack_index = (i + 1) % MAX_UNPACK_PBOS;
+   return true;
+}
+
+/**
+ * gl_wait_pbo_unpack:
+ * @gl                   : GL driver handle.
+ * @index                : Unpack PBO to wait for.
+ *
+ * Waits until the GPU is done updating the texture from 
+ * unpack PBO @index, so it can be written to again.
+ **/
+static void gl_wait_pbo_unpack(gl_t *gl, unsigned index)
+{
+   if (!gl->pbo_unpack_fence[index])
+      return;
+
+   glClientWaitSync(gl->pbo_unpack_fence[index],
+         GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+   glDeleteSync(gl->pbo_unpack_fence[index]);
+   gl->pbo_unpack_fence[index] = NULL;
+}
+
+/**
+ * gl_copy_frame_pbo_stream:
+ * @gl                   : GL driver handle.
+ * @frame                : Frame the core rendered.
+ * @width                : Width of frame.
+ * @height               : Height of frame.
+ * @pitch                : Pitch of frame.
+ *
+ * Copies a frame in client memory into the next unpack PBO, 
+ * or the orphaned stream PBO, and updates the texture from 
+ * there. The driver can then upload it asynchronously instead 
+ * of copying it out of client memory before returning.
+ *
+ * Returns: true (1) if the texture was updated, 
+ * otherwise false (0).
+ **/
+static bool gl_copy_frame_pbo_stream(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   unsigned h;
+   uint8_t *dst          = NULL;
+   const uint8_t *src    = (const uint8_t*)frame;
+   unsigned index        = gl->pbo_unpack_index;
+   size_t line_size      = width * gl->base_size;
+   GLsizeiptr size       = line_size * height;
+
+   if (gl->pbo_unpack_enable)
+   {
+      gl_wait_pbo_unpack(gl, index);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_unpack[index]);
+      dst = (uint8_t*)gl->pbo_unpack_map[index];
+   }
+   else if (gl->pbo_stream)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_stream);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+      dst = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+   }
+   else
+      return false;
+
+   if (!dst)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      return false;
+   }
+
+   if (pitch == line_size)
+      memcpy(dst, src, size);
+   else
+      for (h = 0; h < height; h++, src += pitch, dst += line_size)
+         memcpy(dst, src, line_size);
+
+   if (!gl->pbo_unpack_enable)
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(line_size));
+   glTexSubImage2D(GL_TEXTURE_2D,
+         0, 0, 0, width, height, gl->texture_type,
+         gl->texture_fmt, NULL);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   if (gl->pbo_unpack_enable)
+   {
+      gl->pbo_unpack_fence[index] = glFenceSync(
+            GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      gl->pbo_unpack_index = (index + 1) % MAX_UNPACK_PBOS;
+   }
+
+   return true;
+}
+#endif
+
+#if !defined(HAVE_PSGL)
+/* Accumulates the bytes per frame which didn't need uploading,
+ * as the upload time saved depends on the driver. */
+static struct retro_perf_counter copy_frame_bytes_skipped =
+   {"copy_frame_bytes_skipped"};
+
+/**
+ * gl_copy_frame_dirty_rows:
+ * @gl                   : GL driver handle.
+ * @frame                : Frame the core rendered.
+ * @width                : Width of frame.
+ * @height               : Height of frame.
+ * @pitch                : Pitch of frame.
+ *
+ * Updates only the rows of the texture which changed since
+ * the frame it got last, for cores which redraw mostly
+ * identical frames.
+ *
+ * Returns: true (1) if the texture was updated,
+ * otherwise false (0).
+ **/
+static bool gl_copy_frame_dirty_rows(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   uint64_t since, serial;
+   unsigned y = 0, rows = 0, uploaded = 0;
+   const uint8_t *src = (const uint8_t*)frame;
+   bool convert       = false;
+   global_t *global   = global_get_ptr();
+
+   if (!gl->frame_diff)
+      return false;
+
+#if defined(HAVE_OPENGLES2)
+   {
+      driver_t *driver = driver_get_ptr();
+
+      if (gl->egl_images || !gl->support_unpack_row_length
+            || (gl->base_size == 4 && driver->gfx_use_rgba
+               && !gl->rgba_swizzle))
+         goto full;
+   }
+#else
+   /* Converted run by run, see gl_convert_frame_rgb16_32(). */
+   convert = gl->base_size == 2 && !gl->have_es2_compat;
+#endif
+
+#ifdef HAVE_GL_SYNC
+   /* Already on the GPU side. */
+   if (gl->pbo_unpack_enable)
+   {
+      unsigned i;
+      for (i = 0; i < MAX_UNPACK_PBOS; i++)
+         if (frame == gl->pbo_unpack_map[i])
+            goto full;
+   }
+#endif
+
+   since  = gl->frame_diff_serial[gl->tex_index];
+   serial = video_frame_diff_update(gl->frame_diff,
+         frame, width, height, pitch, gl->base_size);
+   if (!serial)
+      goto full;
+
+   if (convert)
+      glPixelStorei(GL_UNPACK_ALIGNMENT,
+            video_pixel_get_alignment(width * sizeof(uint32_t)));
+   else
+   {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
+   }
+
+   while (video_frame_diff_next_run(gl->frame_diff, since, &y, &rows))
+   {
+      const GLvoid *data_buf = src + y * pitch;
+
+      if (convert)
+      {
+         conv_rgb565_argb8888(gl->conv_buffer, data_buf,
+               width, rows, width * sizeof(uint32_t), pitch);
+         data_buf = gl->conv_buffer;
+      }
+
+      glTexSubImage2D(GL_TEXTURE_2D,
+            0, 0, y, width, rows, gl->texture_type,
+            gl->texture_fmt, data_buf);
+
+      uploaded += rows;
+      y        += rows;
+   }
+
+   if (!convert)
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   gl->frame_diff_serial[gl->tex_index] = serial;
+
+   if (global->perfcnt_enable)
+   {
+      copy_frame_bytes_skipped.total +=
+         (height - uploaded) * width * gl->base_size;
+      copy_frame_bytes_skipped.call_cnt++;
+   }
+
+   return true;
+
+full:
+   /* The whole frame gets uploaded elsewhere,
+    * leaving the last frame we know of behind. */
+   video_frame_diff_invalidate(gl->frame_diff);
+   return false;
+}
+#endif
+
 static INLINE void gl_copy_frame(gl_t *gl, const void *frame,
       unsigned width, unsigned height, unsigned pitch)
 {
    RARCH_PERFORMANCE_INIT(copy_frame);
    RARCH_PERFORMANCE_START(copy_frame);
 
+#if !defined(HAVE_PSGL)
+   if (gl_copy_frame_dirty_rows(gl, frame, width, height, pitch))
+   {
+      RARCH_PERFORMANCE_STOP(copy_frame);
+      return;
+   }
+#endif
+
 #if defined(HAVE_OPENGLES2)
 #if defined(HAVE_EGL)
    if (gl->egl_images)
@@ -1305,7 +1787,7 @@ static INLINE void gl_copy_frame(gl_t *gl, const void *frame,
       glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(width * gl->base_size));
 
       /* Fallback for GLES devices without GL_BGRA_EXT. */
-      if (gl->base_size == 4 && driver->gfx_use_rgba)
+      if (gl->base_size == 4 && driver->gfx_use_rgba && !gl->rgba_swizzle)
       {
          gl_convert_frame_argb8888_abgr8888(gl, gl->conv_buffer,
                frame, width, height, pitch);
@@ -1365,6 +1847,21 @@ static INLINE void gl_copy_frame(gl_t *gl, const void *frame,
    glUnmapBuffer(GL_TEXTURE_REFERENCE_BUFFER_SCE);
 #else
    const GLvoid *data_buf = frame;
+
+#ifdef HAVE_GL_SYNC
+   if (gl_copy_frame_pbo_unpack(gl, frame, width, height, pitch))
+   {
+      RARCH_PERFORMANCE_STOP(copy_frame);
+      return;
+   }
+
+   if (gl_copy_frame_pbo_stream(gl, frame, width, height, pitch))
+   {
+      RARCH_PERFORMANCE_STOP(copy_frame);
+      return;
+   }
+#endif
+
    glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
 
    if (gl->base_size == 2 && !gl->have_es2_compat)
@@ -1401,15 +1898,312 @@ static INLINE void gl_set_shader_viewport(gl_t *gl, unsigned shader)
    gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
 }
 
-#if defined(HAVE_GL_ASYNC_READBACK) && defined(HAVE_MENU)
-static void gl_pbo_async_readback(gl_t *gl)
+#ifdef HAVE_GL_YUV_READBACK
+static const char *gl_pbo_yuv_vertex =
+   "attribute vec2 VertexCoord;\n"
+   "void main()\n"
+   "{\n"
+   "   gl_Position = vec4(VertexCoord * 2.0 - 1.0, 0.0, 1.0);\n"
+   "}\n";
+
+/* Packs the viewport, scaled to OutputSize, into an RGBA 
+ * target a quarter as wide and half again as high, so that 
+ * the bytes read back are the Y, U and V planes of an I420 
+ * frame, top row first. BT.601 limited range. Samples are 
+ * bilinear-filtered, each chroma sample averages its 2x2 block. */
+static const char *gl_pbo_yuv_fragment =
+   "uniform sampler2D Source;\n"
+   "uniform vec2 OutputSize;\n"
+   "const vec3 y_coef = vec3(0.256788, 0.504129, 0.097906);\n"
+   "const vec3 u_coef = vec3(-0.148223, -0.290993, 0.439216);\n"
+   "const vec3 v_coef = vec3(0.439216, -0.367788, -0.071427);\n"
+   "vec3 source(vec2 pos)\n"
+   "{\n"
+   "   vec2 coord = pos / OutputSize;\n"
+   "   return texture2D(Source, vec2(coord.x, 1.0 - coord.y)).rgb;\n"
+   "}\n"
+   "float luma(float x, float y)\n"
+   "{\n"
+   "   return 0.062745 + dot(source(vec2(x + 0.5, y + 0.5)), y_coef);\n"
+   "}\n"
+   "float chroma(float x, float y, vec3 coef)\n"
+   "{\n"
+   "   return 0.501961 + dot(source(vec2(2.0 * x + 1.0, 2.0 * y + 1.0)), coef);\n"
+   "}\n"
+   "void main()\n"
+   "{\n"
+   "   vec2 pos = floor(gl_FragCoord.xy);\n"
+   "   float x  = 4.0 * pos.x;\n"
+   "   if (pos.y < OutputSize.y)\n"
+   "   {\n"
+   "      gl_FragColor = vec4(luma(x, pos.y), luma(x + 1.0, pos.y),\n"
+   "            luma(x + 2.0, pos.y), luma(x + 3.0, pos.y));\n"
+   "   }\n"
+   "   else\n"
+   "   {\n"
+   "      float y    = pos.y - OutputSize.y;\n"
+   "      vec3 coef  = u_coef;\n"
+   "      if (y >= 0.25 * OutputSize.y)\n"
+   "      {\n"
+   "         y    -= 0.25 * OutputSize.y;\n"
+   "         coef  = v_coef;\n"
+   "      }\n"
+   "      /* Each row holds two rows of a chroma plane. */\n"
+   "      y *= 2.0;\n"
+   "      if (x >= 0.5 * OutputSize.x)\n"
+   "      {\n"
+   "         x -= 0.5 * OutputSize.x;\n"
+   "         y += 1.0;\n"
+   "      }\n"
+   "      gl_FragColor = vec4(chroma(x, y, coef), chroma(x + 1.0, y, coef),\n"
+   "            chroma(x + 2.0, y, coef), chroma(x + 3.0, y, coef));\n"
+   "   }\n"
+   "}\n";
+
+static void gl_pbo_yuv420_free(gl_t *gl)
 {
-   glBindBuffer(GL_PIXEL_PACK_BUFFER,
-         gl->pbo_readback[gl->pbo_readback_index++]);
-   gl->pbo_readback_index &= 3;
+   if (gl->pbo_yuv_prog)
+      glDeleteProgram(gl->pbo_yuv_prog);
+   if (gl->pbo_yuv_fbo)
+      glDeleteFramebuffers(1, &gl->pbo_yuv_fbo);
+   if (gl->pbo_yuv_tex)
+      glDeleteTextures(1, &gl->pbo_yuv_tex);
+   if (gl->pbo_yuv_target)
+      glDeleteTextures(1, &gl->pbo_yuv_target);
+
+   gl->pbo_yuv_prog     = 0;
+   gl->pbo_yuv_fbo      = 0;
+   gl->pbo_yuv_tex      = 0;
+   gl->pbo_yuv_target   = 0;
+   gl->pbo_yuv_width    = 0;
+   gl->pbo_yuv_height   = 0;
+   gl->pbo_readback_yuv = false;
+}
 
-   /* 4 frames back, we can readback. */
-   gl->pbo_readback_valid[gl->pbo_readback_index] = true;
+static GLuint gl_pbo_yuv420_compile(GLenum type, const char *source)
+{
+   GLint status  = GL_FALSE;
+   GLuint shader = glCreateShader(type);
+
+   glShaderSource(shader, 1, &source, NULL);
+   glCompileShader(shader);
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+   if (status == GL_TRUE)
+      return shader;
+
+   glDeleteShader(shader);
+   return 0;
+}
+
+/**
+ * gl_pbo_yuv420_init:
+ * @gl                       : pointer to GL driver data.
+ * @width                    : Width of the frames read back.
+ * @height                   : Height of the frames read back.
+ *
+ * Sets up the pass that scales the viewport to @width x @height
+ * and converts it to planar YUV 4:2:0 before it is read back 
+ * asynchronously. The width has to be a multiple of 8 and the
+ * height a multiple of 4, so that the planes pack into whole 
+ * RGBA texels.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool gl_pbo_yuv420_init(gl_t *gl, unsigned width, unsigned height)
+{
+   unsigned i;
+   GLint status     = GL_FALSE;
+   GLint prev_prog  = 0;
+   GLint prev_tex   = 0;
+   GLuint vert      = 0;
+   GLuint frag      = 0;
+   size_t pbo_size  = gl->vp.width * gl->vp.height * sizeof(uint32_t);
+
+   if (!gl->pbo_readback_enable || gl->core_context)
+      return false;
+   if (!width || !height || (width & 7) || (height & 3))
+      return false;
+   if (gl->pbo_readback_yuv)
+   {
+      if (width == gl->pbo_yuv_width && height == gl->pbo_yuv_height)
+         return true;
+      gl_pbo_yuv420_free(gl);
+   }
+
+   /* The PBOs are sized for RGBA readbacks of the viewport,
+    * upscaled frames may not fit. */
+   if (width * height * 3 / 2 > pbo_size)
+   {
+      for (i = 0; i < 4; i++)
+      {
+         glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[i]);
+         glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 3 / 2,
+               NULL, GL_STREAM_READ);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   }
+
+   vert = gl_pbo_yuv420_compile(GL_VERTEX_SHADER, gl_pbo_yuv_vertex);
+   frag = gl_pbo_yuv420_compile(GL_FRAGMENT_SHADER, gl_pbo_yuv_fragment);
+
+   if (vert && frag)
+   {
+      gl->pbo_yuv_prog = glCreateProgram();
+      glAttachShader(gl->pbo_yuv_prog, vert);
+      glAttachShader(gl->pbo_yuv_prog, frag);
+      glLinkProgram(gl->pbo_yuv_prog);
+      glGetProgramiv(gl->pbo_yuv_prog, GL_LINK_STATUS, &status);
+   }
+
+   if (vert)
+      glDeleteShader(vert);
+   if (frag)
+      glDeleteShader(frag);
+
+   if (status != GL_TRUE)
+      goto error;
+
+   glGetIntegerv(GL_CURRENT_PROGRAM, &prev_prog);
+   glUseProgram(gl->pbo_yuv_prog);
+   glUniform1i(glGetUniformLocation(gl->pbo_yuv_prog, "Source"), 0);
+   glUniform2f(glGetUniformLocation(gl->pbo_yuv_prog, "OutputSize"),
+         width, height);
+   glUseProgram(prev_prog);
+
+   gl->pbo_yuv_attrib = glGetAttribLocation(gl->pbo_yuv_prog, "VertexCoord");
+   if (gl->pbo_yuv_attrib < 0)
+      goto error;
+
+   glGetIntegerv(GL_TEXTURE_BINDING_2D, &prev_tex);
+
+   /* Copy of the viewport, filtered so chroma 
+    * samples average their 2x2 block. */
+   glGenTextures(1, &gl->pbo_yuv_tex);
+   glBindTexture(GL_TEXTURE_2D, gl->pbo_yuv_tex);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, gl->vp.width, gl->vp.height, 0,
+         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+   /* Render target the planes are packed into. */
+   glGenTextures(1, &gl->pbo_yuv_target);
+   glBindTexture(GL_TEXTURE_2D, gl->pbo_yuv_target);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width / 4, height + height / 2,
+         0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+   glBindTexture(GL_TEXTURE_2D, prev_tex);
+
+   glGenFramebuffers(1, &gl->pbo_yuv_fbo);
+   glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->pbo_yuv_fbo);
+   glFramebufferTexture2D(RARCH_GL_FRAMEBUFFER, RARCH_GL_COLOR_ATTACHMENT0,
+         GL_TEXTURE_2D, gl->pbo_yuv_target, 0);
+   status = glCheckFramebufferStatus(RARCH_GL_FRAMEBUFFER);
+   gl_bind_backbuffer();
+
+   if (status != RARCH_GL_FRAMEBUFFER_COMPLETE)
+      goto error;
+
+   /* Frames already in flight are still RGB. */
+   for (i = 0; i < 4; i++)
+      gl->pbo_readback_valid[i] = false;
+
+   gl->pbo_yuv_width    = width;
+   gl->pbo_yuv_height   = height;
+   gl->pbo_readback_yuv = true;
+   RARCH_LOG("[GL]: Scaling readbacks to %ux%u and converting them "
+         "to YUV 4:2:0 on the GPU.\n", width, height);
+   return true;
+
+error:
+   RARCH_WARN("[GL]: Cannot convert readbacks to YUV 4:2:0, reading back RGB.\n");
+   gl_pbo_yuv420_free(gl);
+   return false;
+}
+#endif
+
+#if defined(HAVE_GL_ASYNC_READBACK) && defined(HAVE_MENU)
+#ifdef HAVE_GL_YUV_READBACK
+/**
+ * gl_pbo_yuv420_readback:
+ * @gl                       : pointer to GL driver data.
+ *
+ * Scales the viewport in the back buffer and converts it 
+ * to planar YUV 4:2:0, then reads it into the bound PBO.
+ * Leaves the GL state the way it found it.
+ **/
+static void gl_pbo_yuv420_readback(gl_t *gl)
+{
+   static const GLfloat quad[] = {
+      0, 0,
+      1, 0,
+      0, 1,
+      1, 1,
+   };
+   GLint prev_prog         = 0;
+   GLint prev_tex          = 0;
+   GLint prev_active       = 0;
+   GLint prev_vbo          = 0;
+   GLint prev_fbo          = 0;
+   GLint prev_enabled      = 0;
+   GLint prev_viewport[4]  = {0};
+   GLboolean prev_blend    = glIsEnabled(GL_BLEND);
+
+   glGetIntegerv(GL_CURRENT_PROGRAM, &prev_prog);
+   glGetIntegerv(GL_ACTIVE_TEXTURE, &prev_active);
+   glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_vbo);
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+   glGetIntegerv(GL_VIEWPORT, prev_viewport);
+   glGetVertexAttribiv(gl->pbo_yuv_attrib,
+         GL_VERTEX_ATTRIB_ARRAY_ENABLED, &prev_enabled);
+
+   glActiveTexture(GL_TEXTURE0);
+   glGetIntegerv(GL_TEXTURE_BINDING_2D, &prev_tex);
+   glBindTexture(GL_TEXTURE_2D, gl->pbo_yuv_tex);
+   glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+         gl->vp.x, gl->vp.y, gl->vp.width, gl->vp.height);
+
+   glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->pbo_yuv_fbo);
+   glViewport(0, 0, gl->pbo_yuv_width / 4,
+         gl->pbo_yuv_height + gl->pbo_yuv_height / 2);
+   glDisable(GL_BLEND);
+   glUseProgram(gl->pbo_yuv_prog);
+
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glEnableVertexAttribArray(gl->pbo_yuv_attrib);
+   glVertexAttribPointer(gl->pbo_yuv_attrib, 2, GL_FLOAT,
+         GL_FALSE, 0, quad);
+   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   if (!prev_enabled)
+      glDisableVertexAttribArray(gl->pbo_yuv_attrib);
+
+   glReadPixels(0, 0, gl->pbo_yuv_width / 4,
+         gl->pbo_yuv_height + gl->pbo_yuv_height / 2,
+         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+   glBindBuffer(GL_ARRAY_BUFFER, prev_vbo);
+   glUseProgram(prev_prog);
+   if (prev_blend)
+      glEnable(GL_BLEND);
+   glViewport(prev_viewport[0], prev_viewport[1],
+         prev_viewport[2], prev_viewport[3]);
+   glBindFramebuffer(RARCH_GL_FRAMEBUFFER, prev_fbo);
+   glBindTexture(GL_TEXTURE_2D, prev_tex);
+   glActiveTexture(prev_active);
+}
+#endif
+
+static void gl_pbo_async_readback(gl_t *gl)
+{
+   glBindBuffer(GL_PIXEL_PACK_BUFFER,
+         gl->pbo_readback[gl->pbo_readback_index++]);
+   gl->pbo_readback_index &= 3;
+
+   /* 4 frames back, we can readback. */
+   gl->pbo_readback_valid[gl->pbo_readback_index] = true;
 
    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
    glPixelStorei(GL_PACK_ALIGNMENT,
@@ -1419,6 +2213,11 @@ static void gl_pbo_async_readback(gl_t *gl)
    RARCH_PERFORMANCE_INIT(async_readback);
    RARCH_PERFORMANCE_START(async_readback);
    glReadBuffer(GL_BACK);
+#ifdef HAVE_GL_YUV_READBACK
+   if (gl->pbo_readback_yuv)
+      gl_pbo_yuv420_readback(gl);
+   else
+#endif
 #ifdef HAVE_OPENGLES3
    glReadPixels(gl->vp.x, gl->vp.y,
          gl->vp.width, gl->vp.height,
@@ -1475,6 +2274,11 @@ static INLINE void gl_draw_texture(gl_t *gl)
 }
 #endif
 
+#ifdef HAVE_GL_ASYNC_SHADER
+static void gl_shader_async_poll(gl_t *gl);
+static void gl_shader_async_deinit(gl_t *gl);
+#endif
+
 static bool gl_frame(void *data, const void *frame,
       unsigned width, unsigned height, unsigned pitch, const char *msg)
 {
@@ -1482,6 +2286,7 @@ static bool gl_frame(void *data, const void *frame,
    gl_t                    *gl = (gl_t*)data;
    runloop_t *runloop          = rarch_main_get_ptr();
    driver_t *driver            = driver_get_ptr();
+   global_t *global            = global_get_ptr();
    settings_t *settings        = config_get_ptr();
 
    RARCH_PERFORMANCE_INIT(frame_run);
@@ -1491,6 +2296,12 @@ static bool gl_frame(void *data, const void *frame,
 
    context_bind_hw_render(gl, false);
 
+   video_texture_set_compressed_formats(NULL, 0);
+
+#ifdef HAVE_GL_ASYNC_SHADER
+   gl_shader_async_poll(gl);
+#endif
+
 #ifndef HAVE_OPENGLES
    if (gl->core_context)
       glBindVertexArray(gl->vao);
@@ -1533,8 +2344,10 @@ static bool gl_frame(void *data, const void *frame,
          gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
    }
 
-   gl->tex_index = frame ?
-      ((gl->tex_index + 1) % gl->textures) : (gl->tex_index);
+   /* Frames of a core on another thread come with their index,
+    * see gl_set_hw_render_frame(). */
+   if (frame && !gl->hw_render_threaded)
+      gl->tex_index = (gl->tex_index + 1) % gl->textures;
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
 
    /* Can be NULL for frame dupe / NULL render. */
@@ -1587,18 +2400,32 @@ static bool gl_frame(void *data, const void *frame,
    gl->tex_info.tex_size[0]   = gl->tex_w;
    gl->tex_info.tex_size[1]   = gl->tex_h;
 
-   glClear(GL_COLOR_BUFFER_BIT);
+#ifdef HAVE_FBO
+   if (gl->fbo_inited)
+   {
+      /* Frames re-presented from the threaded video wrapper 
+       * can't be told apart from new ones. */
+      bool frame_changed = frame && (settings->video.threaded
+            || !global->frame_cache.redraw);
+      gl->fbo_dirty_pass = gl_get_fbo_dirty_pass(gl, frame_changed);
+   }
 
-   gl->shader->set_params(gl, width, height,
-         gl->tex_w, gl->tex_h,
-         gl->vp.width, gl->vp.height,
-         runloop->frames.video.count, 
-         &gl->tex_info, gl->prev_info, NULL, 0);
+   if (!gl->fbo_inited || gl->fbo_dirty_pass == 0)
+#endif
+   {
+      glClear(GL_COLOR_BUFFER_BIT);
 
-   gl->coords.vertices = 4;
-   gl->shader->set_coords(&gl->coords);
-   gl->shader->set_mvp(gl, &gl->mvp);
-   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+      gl->shader->set_params(gl, width, height,
+            gl->tex_w, gl->tex_h,
+            gl->vp.width, gl->vp.height,
+            runloop->frames.video.count, 
+            &gl->tex_info, gl->prev_info, NULL, 0);
+
+      gl->coords.vertices = 4;
+      gl->shader->set_coords(&gl->coords);
+      gl->shader->set_mvp(gl, &gl->mvp);
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   }
 
 #ifdef HAVE_FBO
    if (gl->fbo_inited)
@@ -1675,13 +2502,16 @@ static bool gl_frame(void *data, const void *frame,
 #ifdef HAVE_GL_SYNC
    if (settings->video.hard_sync && gl->have_sync)
    {
+      retro_time_t stall_start = rarch_get_time_usec();
+      unsigned frames = video_hard_sync_get_frames(&gl->hard_sync);
+
       RARCH_PERFORMANCE_INIT(gl_fence);
       RARCH_PERFORMANCE_START(gl_fence);
       glClear(GL_COLOR_BUFFER_BIT);
       gl->fences[gl->fence_count++] = 
          glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-      while (gl->fence_count > settings->video.hard_sync_frames)
+      while (gl->fence_count > frames)
       {
          glClientWaitSync(gl->fences[0],
                GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
@@ -1693,6 +2523,8 @@ static bool gl_frame(void *data, const void *frame,
       }
 
       RARCH_PERFORMANCE_STOP(gl_fence);
+      video_hard_sync_update(&gl->hard_sync,
+            rarch_get_time_usec() - stall_start);
    }
 #endif
 
@@ -1712,7 +2544,7 @@ static void gl_free_overlay(gl_t *gl)
    if (!gl)
       return;
 
-   glDeleteTextures(gl->overlays, gl->overlay_tex);
+   glDeleteTextures(gl->overlay_atlas ? 1 : gl->overlays, gl->overlay_tex);
 
    free(gl->overlay_tex);
    free(gl->overlay_vertex_coord);
@@ -1723,6 +2555,7 @@ static void gl_free_overlay(gl_t *gl)
    gl->overlay_tex_coord    = NULL;
    gl->overlay_color_coord  = NULL;
    gl->overlays             = 0;
+   gl->overlay_atlas        = false;
 }
 #endif
 
@@ -1751,10 +2584,15 @@ static void gl_free(void *data)
       }
       gl->fence_count = 0;
    }
+
+   gl_deinit_pbo_unpack(gl);
 #endif
 
    if (font_driver && gl->font_handle)
       font_driver->free(gl->font_handle);
+#ifdef HAVE_GL_ASYNC_SHADER
+   gl_shader_async_deinit(gl);
+#endif
    gl_shader_deinit(gl);
 
 #ifndef NO_GL_FF_VERTEX
@@ -1786,6 +2624,9 @@ static void gl_free(void *data)
       scaler_ctx_gen_reset(&gl->pbo_readback_scaler);
    }
 #endif
+#ifdef HAVE_GL_YUV_READBACK
+   gl_pbo_yuv420_free(gl);
+#endif
 
 #ifdef HAVE_FBO
    gl_deinit_fbo(gl);
@@ -1802,6 +2643,7 @@ static void gl_free(void *data)
 
    gfx_ctx_free(gl);
 
+   video_frame_diff_free(gl->frame_diff);
    free(gl->empty_buf);
    free(gl->conv_buffer);
    free(gl);
@@ -1896,9 +2738,10 @@ static bool resolve_extensions(gl_t *gl)
       gles3 = true;
    }
 
-   /* GLES3 has unpack_subimage and sRGB in core. */
+   /* GLES3 has unpack_subimage, texture swizzles and sRGB in core. */
 
    gl->support_unpack_row_length = gles3;
+   gl->have_texture_swizzle      = gles3;
    if (!gles3 && gl_query_extension(gl, "GL_EXT_unpack_subimage"))
    {
       RARCH_LOG("[GL]: Extension GL_EXT_unpack_subimage, can copy textures faster using UNPACK_ROW_LENGTH.\n");
@@ -2073,7 +2916,9 @@ static const gfx_ctx_driver_t *gl_get_context(gl_t *gl)
     
    (void)api_name;
 
-   gl->shared_context_use = settings->video.shared_context
+   /* A core on another thread needs a context of its own. */
+   gl->shared_context_use = (settings->video.shared_context
+         || gl->video_info.hw_render_threaded)
       && cb->context_type != RETRO_HW_CONTEXT_NONE;
 
    return gfx_ctx_init_first(gl, settings->video.context_driver,
@@ -2216,9 +3061,42 @@ static void gl_begin_debug(gl_t *gl)
 }
 #endif
 
+/* Lets menu and overlay assets be loaded pre-compressed
+ * in the formats the GPU reports. */
+static void gl_init_compressed_formats(void)
+{
+#if defined(GL_NUM_COMPRESSED_TEXTURE_FORMATS) && !defined(HAVE_PSGL)
+   GLint i, count = 0;
+   GLint *formats     = NULL;
+   unsigned *list     = NULL;
+
+   glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+   if (count <= 0)
+      return;
+
+   formats = (GLint*)calloc(count, sizeof(*formats));
+   list    = (unsigned*)calloc(count, sizeof(*list));
+
+   if (formats && list)
+   {
+      glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats);
+
+      for (i = 0; i < count; i++)
+         list[i] = formats[i];
+
+      video_texture_set_compressed_formats(list, count);
+      RARCH_LOG("[GL]: %d compressed texture formats supported.\n", count);
+   }
+
+   free(formats);
+   free(list);
+#endif
+}
+
 static void *gl_init(const video_info_t *video, const input_driver_t **input, void **input_data)
 {
    unsigned win_width, win_height;
+   bool ret                           = false;
    bool force_smooth                  = false;
    gl_t *gl                           = NULL;
    const gfx_ctx_driver_t *ctx_driver = NULL;
@@ -2234,12 +3112,13 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
    if (!gl)
       return NULL;
 
+   gl->video_info        = *video;
+
    ctx_driver = gl_get_context(gl);
    if (!ctx_driver)
       goto error;
 
    driver->video_context = ctx_driver;
-   gl->video_info        = *video;
 
    RARCH_LOG("Found GL context: %s\n", ctx_driver->ident);
 
@@ -2315,6 +3194,17 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
       /* All on GPU, no need to excessively
        * create textures. */
       gl->textures = 1;
+
+#ifdef HAVE_THREADS
+      gl->hw_render_threaded = video->hw_render_threaded
+         && ctx_driver->bind_hw_render_thread
+         && !driver->video_cache_context;
+
+      /* One for the core to render to, one ready
+       * and one shown, see video_thread_wrapper.c. */
+      if (gl->hw_render_threaded)
+         gl->textures = THREAD_FRAME_BUFFERS;
+#endif
 #ifdef GL_DEBUG
       context_bind_hw_render(gl, true);
       gl_begin_debug(gl);
@@ -2338,7 +3228,11 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
             gl->shader->ident);
    }
 
-   if (!gl_shader_init(gl))
+   RARCH_TRACE_BEGIN("gl_shader_init");
+   ret = gl_shader_init(gl);
+   RARCH_TRACE_END("gl_shader_init");
+
+   if (!ret)
    {
       RARCH_ERR("[GL]: Shader initialization failed.\n");
       goto error;
@@ -2402,6 +3296,12 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
 
    if (!gl->conv_buffer)
       goto error;
+
+   if (settings->video.dirty_rows && !gl->hw_render_use)
+   {
+      gl->frame_diff = video_frame_diff_new();
+      rarch_perf_register(&copy_frame_bytes_skipped);
+   }
 #endif
 
    gl_init_textures(gl, video);
@@ -2430,6 +3330,12 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
    gl_init_pbo_readback(gl);
 #endif
 
+#ifdef HAVE_GL_SYNC
+   gl_init_pbo_unpack(gl);
+#endif
+
+   gl_init_compressed_formats();
+
    if (!gl_check_error())
       goto error;
 
@@ -2522,65 +3428,32 @@ static void gl_update_tex_filter_frame(gl_t *gl)
    context_bind_hw_render(gl, true);
 }
 
-static bool gl_set_shader(void *data,
-      enum rarch_shader_type type, const char *path)
-{
 #if defined(HAVE_GLSL) || defined(HAVE_CG)
-   gl_t *gl = (gl_t*)data;
-
-   if (!gl)
-      return false;
-
-   context_bind_hw_render(gl, false);
-
-   if (type == RARCH_SHADER_NONE)
-      return false;
-
-   gl_shader_deinit(gl);
-
+static const shader_backend_t *gl_shader_backend_for_type(
+      enum rarch_shader_type type)
+{
    switch (type)
    {
 #ifdef HAVE_GLSL
       case RARCH_SHADER_GLSL:
-         gl->shader = &gl_glsl_backend;
-         break;
+         return &gl_glsl_backend;
 #endif
 
 #ifdef HAVE_CG
       case RARCH_SHADER_CG:
-         gl->shader = &gl_cg_backend;
-         break;
+         return &gl_cg_backend;
 #endif
 
       default:
          break;
    }
 
-   if (!gl->shader)
-   {
-      RARCH_ERR("[GL]: Cannot find shader core for path: %s.\n", path);
-      context_bind_hw_render(gl, true);
-      return false;
-   }
-
-#ifdef HAVE_FBO
-   gl_deinit_fbo(gl);
-   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
-#endif
-
-   if (!gl->shader->init(gl, path))
-   {
-      bool ret = false;
-
-      RARCH_WARN("[GL]: Failed to set multipass shader. Falling back to stock.\n");
-      ret = gl->shader->init(gl, NULL);
-
-      if (!ret)
-         gl->shader = NULL;
-      context_bind_hw_render(gl, true);
-      return false;
-   }
+   return NULL;
+}
 
+/* Sets up the resources which depend on the active shader. */
+static void gl_shader_reinit_resources(gl_t *gl)
+{
    gl_update_tex_filter_frame(gl);
 
    if (gl->shader)
@@ -2618,11 +3491,244 @@ static bool gl_set_shader(void *data,
    /* Apparently need to set viewport for passes when we aren't using FBOs. */
    gl_set_shader_viewport(gl, 0);
    gl_set_shader_viewport(gl, 1);
-   context_bind_hw_render(gl, true);
 #if defined(_WIN32) && !defined(_XBOX)
    shader_dlg_params_reload();
 #endif
+}
+
+static bool gl_set_shader_sync(gl_t *gl,
+      enum rarch_shader_type type, const char *path)
+{
+   gl_shader_deinit(gl);
+
+   gl->shader = gl_shader_backend_for_type(type);
+
+   if (!gl->shader)
+   {
+      RARCH_ERR("[GL]: Cannot find shader core for path: %s.\n", path);
+      return false;
+   }
+
+#ifdef HAVE_FBO
+   gl_deinit_fbo(gl);
+   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+#endif
+
+   if (!gl->shader->init(gl, path))
+   {
+      bool ret = false;
+
+      RARCH_WARN("[GL]: Failed to set multipass shader. Falling back to stock.\n");
+      ret = gl->shader->init(gl, NULL);
+
+      if (!ret)
+         gl->shader = NULL;
+      return false;
+   }
+
+   gl_shader_reinit_resources(gl);
+   return true;
+}
+#endif
+
+#ifdef HAVE_GL_ASYNC_SHADER
+static void gl_shader_async_thread(void *data)
+{
+   gl_t *gl     = (gl_t*)data;
+   void *result = NULL;
+   bool bound   = gfx_ctx_bind_shared_context(gl, true);
+
+   if (bound)
+   {
+      RARCH_TRACE_BEGIN("gl_shader_compile");
+      result = gl->shader_async.backend->compile(gl, gl->shader_async.path);
+      RARCH_TRACE_END("gl_shader_compile");
+
+      /* Everything has to be complete before the 
+       * main context can use the new objects. */
+      glFinish();
+      gfx_ctx_bind_shared_context(gl, false);
+   }
+
+   slock_lock(gl->shader_async.lock);
+   gl->shader_async.result = result;
+   gl->shader_async.bound  = bound;
+   gl->shader_async.done   = true;
+   slock_unlock(gl->shader_async.lock);
+}
+
+/**
+ * gl_shader_async_start:
+ * @gl                   : GL handle.
+ * @type                 : Shader type.
+ * @path                 : Path to shader.
+ *
+ * Starts compiling @path in the background. If a compile is 
+ * already running, @path is queued and replaces its result.
+ *
+ * Returns: true (1) if the shader will be set by 
+ * gl_shader_async_poll(), false (0) if it has to be 
+ * set synchronously.
+ **/
+static bool gl_shader_async_start(gl_t *gl,
+      enum rarch_shader_type type, const char *path)
+{
+   const shader_backend_t *backend = gl_shader_backend_for_type(type);
+
+   /* Stock shaders are cheap enough to compile directly. */
+   if (!backend || !backend->compile || !path || !*path)
+      return false;
+   if (gl->shader_async.unsupported)
+      return false;
+
+   if (gl->shader_async.thread)
+   {
+      gl->shader_async.next_type = type;
+      strlcpy(gl->shader_async.next_path, path,
+            sizeof(gl->shader_async.next_path));
+      return true;
+   }
+
+   if (!gl->shader_async.lock)
+      gl->shader_async.lock = slock_new();
+   if (!gl->shader_async.lock)
+      return false;
+
+   gl->shader_async.backend = backend;
+   gl->shader_async.result  = NULL;
+   gl->shader_async.bound   = false;
+   gl->shader_async.done    = false;
+   strlcpy(gl->shader_async.path, path, sizeof(gl->shader_async.path));
+
+   gl->shader_async.thread = sthread_create(gl_shader_async_thread, gl);
+   if (!gl->shader_async.thread)
+      return false;
+
+   RARCH_LOG("[GL]: Compiling shader in the background: %s.\n", path);
    return true;
+}
+
+/* Waits for a running compile and drops its result. */
+static void gl_shader_async_cancel(gl_t *gl)
+{
+   if (!gl->shader_async.thread)
+      return;
+
+   sthread_join(gl->shader_async.thread);
+   gl->shader_async.thread = NULL;
+
+   if (gl->shader_async.result)
+      gl->shader_async.backend->free_compiled(gl->shader_async.result);
+   gl->shader_async.result    = NULL;
+   gl->shader_async.next_type = RARCH_SHADER_NONE;
+}
+
+/**
+ * gl_shader_async_poll:
+ * @gl                   : GL handle.
+ *
+ * Swaps in the shader compiled by gl_shader_async_start() 
+ * once it's ready. Called at the start of every frame.
+ **/
+static void gl_shader_async_poll(gl_t *gl)
+{
+   bool done;
+   void *result;
+   const shader_backend_t *backend;
+
+   if (!gl->shader_async.thread)
+      return;
+
+   slock_lock(gl->shader_async.lock);
+   done = gl->shader_async.done;
+   slock_unlock(gl->shader_async.lock);
+
+   if (!done)
+      return;
+
+   sthread_join(gl->shader_async.thread);
+   gl->shader_async.thread = NULL;
+
+   result  = gl->shader_async.result;
+   backend = gl->shader_async.backend;
+   gl->shader_async.result = NULL;
+
+   if (gl->shader_async.next_type != RARCH_SHADER_NONE)
+   {
+      enum rarch_shader_type type = gl->shader_async.next_type;
+
+      gl->shader_async.next_type = RARCH_SHADER_NONE;
+      if (result)
+         backend->free_compiled(result);
+
+      if (!gl_shader_async_start(gl, type, gl->shader_async.next_path))
+         gl_set_shader_sync(gl, type, gl->shader_async.next_path);
+      return;
+   }
+
+   if (!gl->shader_async.bound)
+   {
+      RARCH_WARN("[GL]: No shared context for compiling shaders in the background.\n");
+      gl->shader_async.unsupported = true;
+      gl_set_shader_sync(gl, backend->type, gl->shader_async.path);
+      return;
+   }
+
+   if (!result)
+   {
+      RARCH_ERR("[GL]: Failed to compile shader, keeping the current one: %s.\n",
+            gl->shader_async.path);
+      return;
+   }
+
+   gl_shader_deinit(gl);
+   gl->shader = backend;
+
+#ifdef HAVE_FBO
+   gl_deinit_fbo(gl);
+   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+#endif
+
+   backend->init_compiled(gl, result);
+   gl_shader_reinit_resources(gl);
+}
+
+static void gl_shader_async_deinit(gl_t *gl)
+{
+   gl_shader_async_cancel(gl);
+
+   if (gl->shader_async.lock)
+      slock_free(gl->shader_async.lock);
+   gl->shader_async.lock = NULL;
+}
+#endif
+
+static bool gl_set_shader(void *data,
+      enum rarch_shader_type type, const char *path)
+{
+#if defined(HAVE_GLSL) || defined(HAVE_CG)
+   bool ret;
+   gl_t *gl = (gl_t*)data;
+
+   if (!gl)
+      return false;
+
+   context_bind_hw_render(gl, false);
+
+   if (type == RARCH_SHADER_NONE)
+      return false;
+
+#ifdef HAVE_GL_ASYNC_SHADER
+   if (gl_shader_async_start(gl, type, path))
+      return true;
+
+   /* Don't let an older compile replace this shader later on. */
+   gl_shader_async_cancel(gl);
+#endif
+
+   ret = gl_set_shader_sync(gl, type, path);
+   context_bind_hw_render(gl, true);
+   return ret;
 #else
    return false;
 #endif
@@ -2663,7 +3769,13 @@ static bool gl_read_viewport(void *data, uint8_t *buffer)
    RARCH_PERFORMANCE_START(read_viewport);
 
 #ifdef HAVE_GL_ASYNC_READBACK
+   /* The PBOs hold YUV frames for the recording driver, 
+    * see gl_read_viewport_yuv420(). */
+#ifdef HAVE_GL_YUV_READBACK
+   if (gl->pbo_readback_enable && !gl->pbo_readback_yuv)
+#else
    if (gl->pbo_readback_enable)
+#endif
    {
       const uint8_t *ptr  = NULL;
 
@@ -2764,6 +3876,64 @@ error:
 }
 #endif
 
+#ifdef HAVE_GL_YUV_READBACK
+static bool gl_init_viewport_yuv420(void *data,
+      unsigned width, unsigned height)
+{
+   bool ret = false;
+   gl_t *gl = (gl_t*)data;
+
+   if (!gl)
+      return false;
+
+   context_bind_hw_render(gl, false);
+   ret = gl_pbo_yuv420_init(gl, width, height);
+   context_bind_hw_render(gl, true);
+
+   return ret;
+}
+
+static bool gl_read_viewport_yuv420(void *data, uint8_t *buffer)
+{
+   const uint8_t *ptr = NULL;
+   bool ret           = false;
+   gl_t *gl           = (gl_t*)data;
+
+   if (!gl)
+      return false;
+
+   context_bind_hw_render(gl, false);
+
+   /* We haven't buffered up enough frames yet, come back later. */
+   if (!gl->pbo_readback_yuv 
+         || !gl->pbo_readback_valid[gl->pbo_readback_index])
+      goto end;
+
+   RARCH_PERFORMANCE_INIT(read_viewport_yuv420);
+   RARCH_PERFORMANCE_START(read_viewport_yuv420);
+
+   gl->pbo_readback_valid[gl->pbo_readback_index] = false;
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[gl->pbo_readback_index]);
+
+   ptr = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+   if (ptr)
+   {
+      memcpy(buffer, ptr, gl->pbo_yuv_width * gl->pbo_yuv_height * 3 / 2);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      ret = true;
+   }
+   else
+      RARCH_ERR("[GL]: Failed to map pixel unpack buffer.\n");
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   RARCH_PERFORMANCE_STOP(read_viewport_yuv420);
+
+end:
+   context_bind_hw_render(gl, true);
+   return ret;
+}
+#endif
+
 #if 0
 #define READ_RAW_GL_FRAME_TEST
 #endif
@@ -2825,10 +3995,64 @@ unsigned *height_p, size_t *pitch_p)
 
 #ifdef HAVE_OVERLAY
 static void gl_free_overlay(gl_t *gl);
+
+/* Vertices per quad, a strip of 4 or two triangles. */
+#define GL_OVERLAY_QUAD_VERTICES(gl) ((gl)->overlay_atlas ? 6 : 4)
+
+/**
+ * gl_overlay_alloc:
+ * @gl                    : GL handle.
+ * @num_images            : Number of quads.
+ * @num_textures          : Number of textures.
+ * @atlas                 : Whether the quads share one texture.
+ *
+ * Frees the current overlay and allocates the textures and
+ * coordinates of a new one, every quad stretched over the
+ * whole screen and fully opaque.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool gl_overlay_alloc(gl_t *gl, unsigned num_images,
+      unsigned num_textures, bool atlas)
+{
+   unsigned i, verts;
+
+   gl_free_overlay(gl);
+
+   gl->overlay_atlas = atlas;
+   verts             = GL_OVERLAY_QUAD_VERTICES(gl);
+   gl->overlay_tex   = (GLuint*)calloc(num_textures, sizeof(*gl->overlay_tex));
+
+   if (!gl->overlay_tex)
+      return false;
+
+   gl->overlay_vertex_coord = (GLfloat*)calloc(2 * verts * num_images, sizeof(GLfloat));
+   gl->overlay_tex_coord    = (GLfloat*)calloc(2 * verts * num_images, sizeof(GLfloat));
+   gl->overlay_color_coord  = (GLfloat*)calloc(4 * verts * num_images, sizeof(GLfloat));
+
+   if (!gl->overlay_vertex_coord || !gl->overlay_tex_coord || !gl->overlay_color_coord)
+      return false;
+
+   gl->overlays             = num_images;
+   glGenTextures(num_textures, gl->overlay_tex);
+
+   for (i = 0; i < num_images; i++)
+   {
+      /* Default. Stretch to whole screen. */
+      gl_overlay_tex_geom(gl, i, 0, 0, 1, 1);
+      gl_overlay_vertex_geom(gl, i, 0, 0, 1, 1);
+   }
+
+   for (i = 0; i < 4 * verts * num_images; i++)
+      gl->overlay_color_coord[i] = 1.0f;
+
+   return true;
+}
+
 static bool gl_overlay_load(void *data, 
       const struct texture_image *images, unsigned num_images)
 {
-   unsigned i, j;
+   unsigned i;
    gl_t *gl = (gl_t*)data;
 
    if (!gl)
@@ -2836,62 +4060,94 @@ static bool gl_overlay_load(void *data,
 
    context_bind_hw_render(gl, false);
 
-   gl_free_overlay(gl);
-   gl->overlay_tex = (GLuint*)calloc(num_images, sizeof(*gl->overlay_tex));
-
-   if (!gl->overlay_tex)
+   if (!gl_overlay_alloc(gl, num_images, num_images, false))
    {
       context_bind_hw_render(gl, true);
       return false;
    }
 
-   gl->overlay_vertex_coord = (GLfloat*)calloc(2 * 4 * num_images, sizeof(GLfloat));
-   gl->overlay_tex_coord    = (GLfloat*)calloc(2 * 4 * num_images, sizeof(GLfloat));
-   gl->overlay_color_coord  = (GLfloat*)calloc(4 * 4 * num_images, sizeof(GLfloat));
-
-   if (!gl->overlay_vertex_coord || !gl->overlay_tex_coord || !gl->overlay_color_coord)
-      return false;
-
-   gl->overlays             = num_images;
-   glGenTextures(num_images, gl->overlay_tex);
-
    for (i = 0; i < num_images; i++)
    {
       unsigned alignment = video_pixel_get_alignment(images[i].width 
             * sizeof(uint32_t));
 
-      gl_load_texture_data(gl->overlay_tex[i],
-            RARCH_WRAP_EDGE, TEXTURE_FILTER_LINEAR,
-            alignment,
-            images[i].width, images[i].height, images[i].pixels,
-            sizeof(uint32_t));
+      if (images[i].compressed)
+         gl_load_texture_compressed(gl->overlay_tex[i],
+               RARCH_WRAP_EDGE, TEXTURE_FILTER_LINEAR,
+               images[i].compressed, images[i].compressed_size);
+      else
+         gl_load_texture_data(gl->overlay_tex[i],
+               RARCH_WRAP_EDGE, TEXTURE_FILTER_LINEAR,
+               alignment,
+               images[i].width, images[i].height, images[i].pixels,
+               sizeof(uint32_t));
+   }
 
-      /* Default. Stretch to whole screen. */
-      gl_overlay_tex_geom(gl, i, 0, 0, 1, 1);
-      gl_overlay_vertex_geom(gl, i, 0, 0, 1, 1);
+   context_bind_hw_render(gl, true);
+   return true;
+}
+
+static bool gl_overlay_load_atlas(void *data,
+      const struct texture_image *atlas, unsigned num_images)
+{
+   gl_t *gl = (gl_t*)data;
 
-      for (j = 0; j < 16; j++)
-         gl->overlay_color_coord[16 * i + j] = 1.0f;
+   if (!gl)
+      return false;
+
+   context_bind_hw_render(gl, false);
+
+   if (!gl_overlay_alloc(gl, num_images, 1, true))
+   {
+      context_bind_hw_render(gl, true);
+      return false;
    }
 
+   gl_load_texture_data(gl->overlay_tex[0],
+         RARCH_WRAP_EDGE, TEXTURE_FILTER_LINEAR,
+         video_pixel_get_alignment(atlas->width * sizeof(uint32_t)),
+         atlas->width, atlas->height, atlas->pixels,
+         sizeof(uint32_t));
+
    context_bind_hw_render(gl, true);
    return true;
 }
 
+/**
+ * gl_overlay_set_quad:
+ * @gl                    : GL handle.
+ * @coords                : Coordinate array of the overlay.
+ * @image                 : Index of the quad.
+ * @size                  : Components per vertex.
+ * @corners               : The 4 corners, in strip order.
+ *
+ * Stores the corners of a quad, as a strip or, for atlases,
+ * as two triangles, the second one reusing corners 2 and 1.
+ **/
+static void gl_overlay_set_quad(gl_t *gl, GLfloat *coords,
+      unsigned image, unsigned size, const GLfloat *corners)
+{
+   GLfloat *quad = coords + image * GL_OVERLAY_QUAD_VERTICES(gl) * size;
+
+   memcpy(quad, corners, 4 * size * sizeof(GLfloat));
+
+   if (!gl->overlay_atlas)
+      return;
+
+   memcpy(quad + 3 * size, corners + 2 * size, size * sizeof(GLfloat));
+   memcpy(quad + 4 * size, corners + 1 * size, size * sizeof(GLfloat));
+   memcpy(quad + 5 * size, corners + 3 * size, size * sizeof(GLfloat));
+}
+
 static void gl_overlay_tex_geom(void *data,
       unsigned image,
       GLfloat x, GLfloat y,
       GLfloat w, GLfloat h)
 {
-   GLfloat *tex = NULL;
-   gl_t *gl     = (gl_t*)data;
-
-   if (!gl)
-      return;
-
-   tex          = (GLfloat*)&gl->overlay_tex_coord[image * 8];
+   GLfloat tex[8];
+   gl_t *gl = (gl_t*)data;
 
-   if (!tex)
+   if (!gl || !gl->overlay_tex_coord)
       return;
 
    tex[0]       = x;
@@ -2902,6 +4158,8 @@ static void gl_overlay_tex_geom(void *data,
    tex[5]       = y + h;
    tex[6]       = x + w;
    tex[7]       = y + h;
+
+   gl_overlay_set_quad(gl, gl->overlay_tex_coord, image, 2, tex);
 }
 
 static void gl_overlay_vertex_geom(void *data,
@@ -2909,21 +4167,16 @@ static void gl_overlay_vertex_geom(void *data,
       float x, float y,
       float w, float h)
 {
-   GLfloat *vertex = NULL;
-   gl_t *gl        = (gl_t*)data;
+   GLfloat vertex[8];
+   gl_t *gl = (gl_t*)data;
 
-   if (!gl)
+   if (!gl || !gl->overlay_vertex_coord)
       return;
 
-   vertex          = (GLfloat*)&gl->overlay_vertex_coord[image * 8];
-
    /* Flipped, so we preserve top-down semantics. */
    y               = 1.0f - y;
    h               = -h;
 
-   if (!vertex)
-      return;
-
    vertex[0]       = x;
    vertex[1]       = y;
    vertex[2]       = x + w;
@@ -2932,6 +4185,8 @@ static void gl_overlay_vertex_geom(void *data,
    vertex[5]       = y + h;
    vertex[6]       = x + w;
    vertex[7]       = y + h;
+
+   gl_overlay_set_quad(gl, gl->overlay_vertex_coord, image, 2, vertex);
 }
 
 static void gl_overlay_enable(void *data, bool state)
@@ -2957,20 +4212,17 @@ static void gl_overlay_full_screen(void *data, bool enable)
 
 static void gl_overlay_set_alpha(void *data, unsigned image, float mod)
 {
+   unsigned i, verts;
    GLfloat *color = NULL;
    gl_t *gl       = (gl_t*)data;
-   if (!gl)
+   if (!gl || !gl->overlay_color_coord)
       return;
 
-   color          = (GLfloat*)&gl->overlay_color_coord[image * 16];
-
-   if (!color)
-      return;
+   verts          = GL_OVERLAY_QUAD_VERTICES(gl);
+   color          = (GLfloat*)&gl->overlay_color_coord[image * 4 * verts];
 
-   color[ 0 + 3]  = mod;
-   color[ 4 + 3]  = mod;
-   color[ 8 + 3]  = mod;
-   color[12 + 3]  = mod;
+   for (i = 0; i < verts; i++)
+      color[4 * i + 3] = mod;
 }
 
 static void gl_render_overlay(void *data)
@@ -2990,14 +4242,22 @@ static void gl_render_overlay(void *data)
    gl->coords.vertex    = gl->overlay_vertex_coord;
    gl->coords.tex_coord = gl->overlay_tex_coord;
    gl->coords.color     = gl->overlay_color_coord;
-   gl->coords.vertices  = 4 * gl->overlays;
+   gl->coords.vertices  = GL_OVERLAY_QUAD_VERTICES(gl) * gl->overlays;
    gl->shader->set_coords(&gl->coords);
    gl->shader->set_mvp(gl, &gl->mvp_no_rot);
 
-   for (i = 0; i < gl->overlays; i++)
+   if (gl->overlay_atlas)
+   {
+      glBindTexture(GL_TEXTURE_2D, gl->overlay_tex[0]);
+      glDrawArrays(GL_TRIANGLES, 0, 6 * gl->overlays);
+   }
+   else
    {
-      glBindTexture(GL_TEXTURE_2D, gl->overlay_tex[i]);
-      glDrawArrays(GL_TRIANGLE_STRIP, 4 * i, 4);
+      for (i = 0; i < gl->overlays; i++)
+      {
+         glBindTexture(GL_TEXTURE_2D, gl->overlay_tex[i]);
+         glDrawArrays(GL_TRIANGLE_STRIP, 4 * i, 4);
+      }
    }
 
    glDisable(GL_BLEND);
@@ -3016,6 +4276,7 @@ static const video_overlay_interface_t gl_overlay_interface = {
    gl_overlay_vertex_geom,
    gl_overlay_full_screen,
    gl_overlay_set_alpha,
+   gl_overlay_load_atlas,
 };
 
 static void gl_get_overlay_interface(void *data,
@@ -3039,6 +4300,103 @@ static retro_proc_address_t gl_get_proc_address(void *data, const char *sym)
    return gfx_ctx_get_proc_address(sym);
 }
 
+#ifdef HAVE_FBO
+static bool gl_bind_hw_render_thread(void *data, bool enable)
+{
+   gl_t *gl = (gl_t*)data;
+
+   if (!gl || !gl->hw_render_threaded)
+      return false;
+
+   return gfx_ctx_bind_hw_render_thread(gl, enable);
+}
+
+/**
+ * gl_get_hw_render_framebuffer:
+ * @data                  : GL handle.
+ * @index                 : Index of the texture to render to.
+ *
+ * Called on the core's thread, where its context is current.
+ * Framebuffers aren't shared between contexts, so they're
+ * made there, whenever the video thread made new textures.
+ *
+ * Returns: framebuffer rendering to texture @index, or 0.
+ **/
+static uintptr_t gl_get_hw_render_framebuffer(void *data, unsigned index)
+{
+   gl_t *gl = (gl_t*)data;
+
+   if (!gl || !gl->hw_render_threaded || index >= gl->textures)
+      return 0;
+
+   if (gl->hw_render_thread_gen != gl->hw_render_gen)
+   {
+      if (gl->hw_render_thread_fbos)
+      {
+         glDeleteFramebuffers(gl->hw_render_thread_fbos, gl->hw_render_fbo);
+         if (gl->hw_render_depth_init)
+            glDeleteRenderbuffers(gl->hw_render_thread_fbos,
+                  gl->hw_render_depth);
+         gl->hw_render_depth_init  = false;
+         gl->hw_render_thread_fbos = 0;
+      }
+
+      if (!gl_create_hw_render_fbos(gl, gl->tex_w, gl->tex_h))
+         return 0;
+
+      glBindFramebuffer(RARCH_GL_FRAMEBUFFER, 0);
+      gl->hw_render_thread_fbos = gl->textures;
+      gl->hw_render_thread_gen  = gl->hw_render_gen;
+   }
+
+   return gl->hw_render_fbo[index];
+}
+
+static void *gl_hw_render_fence(void *data, void *prev)
+{
+   gl_t *gl = (gl_t*)data;
+
+#ifdef HAVE_GL_SYNC
+   if (prev)
+      glDeleteSync((GLsync)prev);
+
+   if (gl->have_sync)
+   {
+      GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      /* Has to reach the GPU before another context waits on it. */
+      glFlush();
+      if (fence)
+         return fence;
+   }
+#endif
+
+   glFinish();
+   return NULL;
+}
+
+static void gl_set_hw_render_frame(void *data, unsigned index, void *fence)
+{
+   gl_t *gl = (gl_t*)data;
+
+#ifdef HAVE_GL_SYNC
+   if (fence)
+   {
+      /* Only holds back the GPU, not this thread. */
+      if (glWaitSync)
+         glWaitSync((GLsync)fence, 0, GL_TIMEOUT_IGNORED);
+      else
+         glClientWaitSync((GLsync)fence,
+               GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      glDeleteSync((GLsync)fence);
+   }
+#endif
+
+   if (index < gl->textures)
+      gl->tex_index = index;
+}
+#endif
+
 static void gl_set_aspect_ratio(void *data, unsigned aspect_ratio_idx)
 {
    gl_t *gl         = (gl_t*)data;
@@ -3150,6 +4508,37 @@ static struct video_shader *gl_get_current_shader(void *data)
    return (gl && gl->shader) ? gl->shader->get_current_shader() : NULL;
 }
 
+static bool gl_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+#ifdef HAVE_GL_SYNC
+   unsigned index;
+   gl_t *gl = (gl_t*)data;
+
+   if (!gl || !gl->pbo_unpack_enable)
+      return false;
+   if (framebuffer->width > gl->tex_w || framebuffer->height > gl->tex_h)
+      return false;
+
+   index = gl->pbo_unpack_index;
+
+   /* The GPU might still be updating the texture from this one. */
+   gl_wait_pbo_unpack(gl, index);
+
+   framebuffer->data         = gl->pbo_unpack_map[index];
+   framebuffer->pitch        = framebuffer->width * gl->base_size;
+   framebuffer->format       = (gl->base_size == sizeof(uint32_t)) ?
+      RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+   /* Mapped GPU memory, reading from it is slow. */
+   framebuffer->memory_flags = 0;
+   return true;
+#else
+   (void)data;
+   (void)framebuffer;
+   return false;
+#endif
+}
+
 static void gl_get_video_output_size(void *data,
       unsigned *width, unsigned *height)
 {
@@ -3189,6 +4578,25 @@ static const video_poke_interface_t gl_poke_interface = {
    NULL,
 
    gl_get_current_shader,
+   gl_get_current_software_framebuffer,
+#ifdef HAVE_GL_YUV_READBACK
+   gl_init_viewport_yuv420,
+   gl_read_viewport_yuv420,
+#else
+   NULL,
+   NULL,
+#endif
+#ifdef HAVE_FBO
+   gl_bind_hw_render_thread,
+   gl_get_hw_render_framebuffer,
+   gl_hw_render_fence,
+   gl_set_hw_render_frame,
+#else
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+#endif
 };
 
 static void gl_get_poke_interface(void *data,
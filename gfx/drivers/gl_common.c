@@ -15,6 +15,7 @@
  */
 
 #include "gl_common.h"
+#include <formats/rktx.h>
 
 void gl_ff_vertex(const void *data)
 {
@@ -109,31 +110,98 @@ void gl_load_texture_data(GLuint id,
       glGenerateMipmap(GL_TEXTURE_2D);
 }
 
+bool gl_load_texture_compressed(GLuint id,
+      enum gfx_wrap_type wrap_type,
+      enum texture_filter_type filter_type,
+      const void *data, size_t size)
+{
+   unsigned i;
+   struct rktx ktx;
+   GLint mag_filter, min_filter;
+   GLenum wrap = gl_wrap_type_to_enum(wrap_type);
+
+   if (!rktx_parse(&ktx, (const uint8_t*)data, size))
+      return false;
+
+   glBindTexture(GL_TEXTURE_2D, id);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+
+   /* Compressed textures can't have mipmaps generated, 
+    * they are only used when the file has them. */
+   switch (filter_type)
+   {
+      case TEXTURE_FILTER_MIPMAP_LINEAR:
+         min_filter = ktx.levels > 1 ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR;
+         mag_filter = GL_LINEAR;
+         break;
+      case TEXTURE_FILTER_MIPMAP_NEAREST:
+         min_filter = ktx.levels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+         mag_filter = GL_NEAREST;
+         break;
+      case TEXTURE_FILTER_NEAREST:
+         min_filter = GL_NEAREST;
+         mag_filter = GL_NEAREST;
+         break;
+      case TEXTURE_FILTER_LINEAR:
+      default:
+         min_filter = GL_LINEAR;
+         mag_filter = GL_LINEAR;
+         break;
+   }
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+#ifdef GL_TEXTURE_MAX_LEVEL
+   /* The chain may stop short of 1x1. */
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ktx.levels - 1);
+#endif
+
+   for (i = 0; i < ktx.levels; i++)
+      glCompressedTexImage2D(GL_TEXTURE_2D, i, ktx.internal_format,
+            ktx.level[i].width, ktx.level[i].height, 0,
+            ktx.level[i].size, ktx.level[i].data);
+
+   return gl_check_error();
+}
+
 bool gl_load_luts(const struct video_shader *shader,
       GLuint *textures_lut)
 {
    unsigned i;
+   const char *paths[GFX_MAX_TEXTURES];
+   struct texture_image imgs[GFX_MAX_TEXTURES];
    unsigned num_luts = min(shader->luts, GFX_MAX_TEXTURES);
 
    if (!shader->luts)
       return true;
 
-   glGenTextures(num_luts, textures_lut);
-
    for (i = 0; i < num_luts; i++)
    {
-      struct texture_image img = {0};
-      enum texture_filter_type filter_type = TEXTURE_FILTER_LINEAR;
-
       RARCH_LOG("Loading texture image from: \"%s\" ...\n",
             shader->lut[i].path);
+      paths[i] = shader->lut[i].path;
+   }
 
-      if (!texture_image_load(&img, shader->lut[i].path))
+   /* Decode them all on the worker threads first, only the
+    * uploads have to happen on this one. */
+   if (texture_image_load_batch(imgs, paths, num_luts, false) != num_luts)
+   {
+      for (i = 0; i < num_luts; i++)
       {
-         RARCH_ERR("Failed to load texture image from: \"%s\"\n",
-               shader->lut[i].path);
-         return false;
+         if (!imgs[i].pixels)
+            RARCH_ERR("Failed to load texture image from: \"%s\"\n",
+                  shader->lut[i].path);
+         texture_image_free(&imgs[i]);
       }
+      return false;
+   }
+
+   glGenTextures(num_luts, textures_lut);
+
+   for (i = 0; i < num_luts; i++)
+   {
+      enum texture_filter_type filter_type = TEXTURE_FILTER_LINEAR;
 
       if (shader->lut[i].filter == RARCH_FILTER_NEAREST)
          filter_type = TEXTURE_FILTER_NEAREST;
@@ -149,9 +217,9 @@ bool gl_load_luts(const struct video_shader *shader,
       gl_load_texture_data(textures_lut[i],
             shader->lut[i].wrap,
             filter_type, 4,
-            img.width, img.height,
-            img.pixels, sizeof(uint32_t));
-      texture_image_free(&img);
+            imgs[i].width, imgs[i].height,
+            imgs[i].pixels, sizeof(uint32_t));
+      texture_image_free(&imgs[i]);
    }
 
    glBindTexture(GL_TEXTURE_2D, 0);
@@ -24,6 +24,7 @@
 #include <formats/image.h>
 #include "../video_context_driver.h"
 #include "../video_shader_driver.h"
+#include "../video_frame_diff.h"
 #include <retro_inline.h>
 
 #ifdef HAVE_CONFIG_H
@@ -44,6 +45,16 @@
 #define HAVE_GL_ASYNC_READBACK
 #endif
 
+#if defined(HAVE_GL_ASYNC_READBACK) && defined(HAVE_FBO) && \
+   defined(HAVE_GLSL) && !defined(HAVE_OPENGLES)
+#define HAVE_GL_YUV_READBACK
+#endif
+
+#if defined(HAVE_THREADS) && (defined(HAVE_GLSL) || defined(HAVE_CG))
+#define HAVE_GL_ASYNC_SHADER
+#include <rthreads/rthreads.h>
+#endif
+
 #if defined(HAVE_PSGL)
 #define RARCH_GL_FRAMEBUFFER GL_FRAMEBUFFER_OES
 #define RARCH_GL_FRAMEBUFFER_COMPLETE GL_FRAMEBUFFER_COMPLETE_OES
@@ -177,11 +188,36 @@
 #define GL_UNPACK_ROW_LENGTH  0x0CF2
 #endif
 
+/* Core in GLES3, missing from GLES2 headers. */
+#ifndef GL_TEXTURE_SWIZZLE_R
+#define GL_TEXTURE_SWIZZLE_R  0x8E42
+#define GL_TEXTURE_SWIZZLE_B  0x8E44
+#define GL_TEXTURE_SWIZZLE_A  0x8E45
+#endif
+
+#ifndef GL_RED
+#define GL_RED  0x1903
+#endif
+
+#ifndef GL_BLUE
+#define GL_BLUE 0x1905
+#endif
+
 #ifndef GL_SRGB_ALPHA_EXT
 #define GL_SRGB_ALPHA_EXT 0x8C42
 #endif
 #endif
 
+#ifdef HAVE_GL_SYNC
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#endif
+
 
 struct gl_fbo_rect
 {
@@ -262,6 +298,11 @@ typedef struct gl
    void *conv_buffer;
    struct scaler_ctx scaler;
 
+   /* Rows of software frames which changed, and the serial
+    * of the frame each texture got, see video_frame_diff.h. */
+   video_frame_diff_t *frame_diff;
+   uint64_t frame_diff_serial[MAX_TEXTURES];
+
    unsigned frame_count;
 
 #ifdef HAVE_FBO
@@ -273,10 +314,24 @@ typedef struct gl
    int fbo_pass;
    bool fbo_inited;
 
+   /* What the FBO contents were rendered with, 
+    * passes before fbo_dirty_pass are reused. */
+   bool fbo_cache_valid;
+   struct gl_fbo_rect fbo_cache_rect[MAX_SHADERS];
+   float fbo_cache_params[GFX_MAX_PARAMETERS];
+   int fbo_dirty_pass;
+
    GLuint hw_render_fbo[MAX_TEXTURES];
    GLuint hw_render_depth[MAX_TEXTURES];
    bool hw_render_fbo_init;
    bool hw_render_depth_init;
+   /* The core renders on another thread, with the HW-render
+    * context current there, see gl_get_hw_render_framebuffer().
+    * Its framebuffers are remade there when hw_render_gen changes. */
+   bool hw_render_threaded;
+   unsigned hw_render_gen;
+   unsigned hw_render_thread_gen;
+   unsigned hw_render_thread_fbos;
    bool has_fp_fbo;
    bool has_srgb_fbo;
    bool has_srgb_fbo_gles3;
@@ -315,6 +370,10 @@ typedef struct gl
    unsigned base_size; /* 2 or 4 */
 #ifdef HAVE_OPENGLES
    bool support_unpack_row_length;
+   bool have_texture_swizzle;
+   /* 32-bit frames are uploaded as RGBA without BGRA8888, 
+    * red and blue are swapped back when sampling. */
+   bool rgba_swizzle;
 #else
    bool have_es2_compat;
 #endif
@@ -330,6 +389,9 @@ typedef struct gl
    unsigned overlays;
    bool overlay_enable;
    bool overlay_full_screen;
+   /* All quads sample overlay_tex[0], and are drawn as
+    * triangles in one go rather than as separate strips. */
+   bool overlay_atlas;
    GLuint *overlay_tex;
    GLfloat *overlay_vertex_coord;
    GLfloat *overlay_tex_coord;
@@ -343,6 +405,18 @@ typedef struct gl
    bool pbo_readback_enable;
    unsigned pbo_readback_index;
    struct scaler_ctx pbo_readback_scaler;
+#endif
+#ifdef HAVE_GL_YUV_READBACK
+   /* Converts the viewport to planar YUV 4:2:0 before 
+    * it is read back into the PBOs. */
+   bool pbo_readback_yuv;
+   GLuint pbo_yuv_tex;
+   GLuint pbo_yuv_target;
+   GLuint pbo_yuv_fbo;
+   GLuint pbo_yuv_prog;
+   GLint pbo_yuv_attrib;
+   unsigned pbo_yuv_width;
+   unsigned pbo_yuv_height;
 #endif
    void *readback_buffer_screenshot;
 
@@ -358,6 +432,39 @@ typedef struct gl
    bool have_sync;
    GLsync fences[MAX_FENCES];
    unsigned fence_count;
+   video_hard_sync_t hard_sync;
+
+   /* Persistently mapped PBOs software cores render to. */
+#define MAX_UNPACK_PBOS 3
+   bool pbo_unpack_enable;
+   GLuint pbo_unpack[MAX_UNPACK_PBOS];
+   void *pbo_unpack_map[MAX_UNPACK_PBOS];
+   GLsync pbo_unpack_fence[MAX_UNPACK_PBOS];
+   unsigned pbo_unpack_index;
+
+   /* PBO frames are streamed through, orphaned every frame,
+    * when they can't be mapped persistently. */
+   GLuint pbo_stream;
+#endif
+
+#ifdef HAVE_GL_ASYNC_SHADER
+   /* Shader compiled on a shared context, while the old one 
+    * stays active until it's ready. */
+   struct
+   {
+      sthread_t *thread;
+      slock_t *lock;
+      const shader_backend_t *backend;
+      char path[PATH_MAX_LENGTH];
+      void *result;
+      bool bound;
+      bool done;
+      bool unsupported;
+
+      /* Requested while another compile was running. */
+      enum rarch_shader_type next_type;
+      char next_path[PATH_MAX_LENGTH];
+   } shader_async;
 #endif
 
    bool core_context;
@@ -369,6 +476,12 @@ static INLINE void context_bind_hw_render(gl_t *gl, bool enable)
    if (!gl)
       return;
 
+   /* With the core on another thread, its context stays there. */
+#ifdef HAVE_FBO
+   if (gl->hw_render_threaded)
+      return;
+#endif
+
    if (gl->shared_context_use)
       gfx_ctx_bind_hw_render(gl, enable);
 }
@@ -409,6 +522,25 @@ void gl_load_texture_data(GLuint id,
       const void *frame,
       unsigned base_size);
 
+/**
+ * gl_load_texture_compressed:
+ * @id                   : Texture to load into.
+ * @wrap_type            : Wrap mode of the texture.
+ * @filter_type          : Filter of the texture.
+ * @data                 : Contents of a KTX file.
+ * @size                 : Size of @data.
+ *
+ * Uploads a pre-compressed texture and the mipmaps stored 
+ * with it. The format must be one the GPU supports, see 
+ * video_texture_compressed_supported().
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool gl_load_texture_compressed(GLuint id,
+      enum gfx_wrap_type wrap_type,
+      enum texture_filter_type filter_type,
+      const void *data, size_t size);
+
 bool gl_load_luts(const struct video_shader *generic_shader,
       GLuint *lut_textures);
 
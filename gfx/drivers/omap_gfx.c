@@ -782,10 +782,13 @@ typedef struct omap_video
    unsigned width;
    unsigned height;
 
+   /* The menu is shown on the plane at its own size, for the
+    * overlay to scale. The CPU only converts its pixel format. */
    struct
    {
       bool active;
       void *frame;
+      size_t frame_size;
       struct scaler_ctx scaler;
    } menu;
 } omap_video_t;
@@ -959,11 +962,7 @@ static void *omap_gfx_init(const video_info_t *video,
 
    omap_init_font(vid, settings->video.font_path, settings->video.font_size);
 
-   vid->menu.frame = calloc(vid->width * vid->height, vid->bytes_per_pixel);
-   if (!vid->menu.frame)
-      goto fail_omapfb;
-
-   vid->menu.scaler.scaler_type = SCALER_TYPE_BILINEAR;
+   vid->menu.scaler.scaler_type = SCALER_TYPE_POINT;
    vid->menu.scaler.out_fmt = (vid->bytes_per_pixel == 4)
       ? SCALER_FMT_ARGB8888 : SCALER_FMT_RGB565;
 
@@ -981,11 +980,18 @@ fail:
 static bool omap_gfx_frame(void *data, const void *frame, unsigned width,
       unsigned height, unsigned pitch, const char *msg)
 {
-   omap_video_t *vid;
+   omap_video_t *vid = (omap_video_t*)data;
+
+   if (vid->menu.active && vid->menu.frame)
+   {
+      frame  = vid->menu.frame;
+      width  = vid->menu.scaler.out_width;
+      height = vid->menu.scaler.out_height;
+      pitch  = vid->menu.scaler.out_stride;
+   }
 
    if (!frame)
       return true;
-   vid = data;
 
    if (width > 4 && height > 4 && (width != vid->width || height != vid->height))
    {
@@ -1003,10 +1009,6 @@ static bool omap_gfx_frame(void *data, const void *frame, unsigned width,
 
    omapfb_prepare(vid->omap);
    omapfb_blit_frame(vid->omap, frame, vid->height, pitch);
-   if (vid->menu.active)
-      omapfb_blit_frame(vid->omap, vid->menu.frame,
-            vid->menu.scaler.out_height,
-            vid->menu.scaler.out_stride);
    if (msg)
       omap_render_msg(vid, msg);
 
@@ -1089,29 +1091,48 @@ static bool omap_gfx_read_viewport(void *data, uint8_t *buffer)
    return true;
 }
 
-static void update_scaler(omap_video_t *vid, struct scaler_ctx *scaler,
+static bool update_scaler(omap_video_t *vid, struct scaler_ctx *scaler,
       enum scaler_pix_fmt format, unsigned width,
       unsigned height, unsigned pitch)
 {
+   size_t size;
+
    if (
-         width  != scaler->in_width
-         || height != scaler->in_height
-         || format != scaler->in_fmt
-         || pitch  != scaler->in_stride
+         width  == scaler->in_width
+         && height == scaler->in_height
+         && format == scaler->in_fmt
+         && pitch  == scaler->in_stride
       )
+      return true;
+
+   size = width * height * vid->bytes_per_pixel;
+   if (size > vid->menu.frame_size)
    {
-      scaler->in_fmt    = format;
-      scaler->in_width  = width;
-      scaler->in_height = height;
-      scaler->in_stride = pitch;
+      void *frame = realloc(vid->menu.frame, size);
+      if (!frame)
+         return false;
+      vid->menu.frame      = frame;
+      vid->menu.frame_size = size;
+   }
+
+   scaler->in_fmt    = format;
+   scaler->in_width  = width;
+   scaler->in_height = height;
+   scaler->in_stride = pitch;
 
-      scaler->out_width  = vid->width;
-      scaler->out_height = vid->height;
-      scaler->out_stride = vid->width * vid->bytes_per_pixel;
+   /* Same size, the overlay does the scaling. */
+   scaler->out_width  = width;
+   scaler->out_height = height;
+   scaler->out_stride = width * vid->bytes_per_pixel;
 
-      if (!scaler_ctx_gen_filter(scaler))
-         RARCH_ERR("[video_omap]: scaler_ctx_gen_filter failed\n");
+   if (!scaler_ctx_gen_filter(scaler))
+   {
+      RARCH_ERR("[video_omap]: scaler_ctx_gen_filter failed\n");
+      scaler->in_width = 0;
+      return false;
    }
+
+   return true;
 }
 
 static void omap_gfx_set_texture_frame(void *data, const void *frame, bool rgb32,
@@ -1122,8 +1143,9 @@ static void omap_gfx_set_texture_frame(void *data, const void *frame, bool rgb32
 
    (void) alpha;
 
-   update_scaler(vid, &vid->menu.scaler, format, width, height,
-         width * (rgb32 ? sizeof(uint32_t) : sizeof(uint16_t)));
+   if (!update_scaler(vid, &vid->menu.scaler, format, width, height,
+         width * (rgb32 ? sizeof(uint32_t) : sizeof(uint16_t))))
+      return;
 
    scaler_ctx_scale(&vid->menu.scaler, vid->menu.frame, frame);
 }
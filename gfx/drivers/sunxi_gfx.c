@@ -467,19 +467,28 @@ static int sunxi_disp_close(sunxi_disp_t *ctx)
 }
 /* END of lowlevel SunxiG2D functions block */
 
-void pixman_composite_src_0565_8888_asm_neon(int width,
+void pixman_composite_src_8888_8888_asm_neon(int width,
    int height,
    uint32_t *dst,
    int dst_stride_pixels,
    uint16_t *src,
    int src_stride_pixels);
 
-void pixman_composite_src_8888_8888_asm_neon(int width,
+/* The DISP scaler reads RGB565 as well, and converts it while
+ * scaling, so 16-bit frames are only copied. */
+static void sunxi_copy_rgb565(int width,
    int height,
    uint32_t *dst,
    int dst_stride_pixels,
    uint16_t *src,
-   int src_stride_pixels);
+   int src_stride_pixels)
+{
+   int i;
+
+   for (i = 0; i < height; i++, dst += dst_stride_pixels,
+         src += src_stride_pixels)
+      memcpy(dst, src, width * sizeof(uint16_t));
+}
 
 /* Pointer to the blitting function. Will be asigned 
  * when we find out what bpp the core uses. */
@@ -635,7 +644,7 @@ static void *sunxi_gfx_init(const video_info_t *video,
    switch (_dispvars->bytes_per_pixel)
    {
       case 2:
-         pixman_blit = pixman_composite_src_0565_8888_asm_neon;
+         pixman_blit = sunxi_copy_rgb565;
          break;
       case 4:
          pixman_blit = pixman_composite_src_8888_8888_asm_neon;
@@ -704,8 +713,9 @@ static void sunxi_update_main(const void *frame, struct sunxi_video *_dispvars)
       _dispvars->src_pixels_per_line
       );
 
-   /* Issue pageflip. Will flip on next vsync. */
-   sunxi_layer_set_rgb_input_buffer(_dispvars->sunxi_disp, _dispvars->sunxi_disp->bits_per_pixel, 
+   /* Issue pageflip. Will flip on next vsync.
+    * The layer takes the frame in the core's format. */
+   sunxi_layer_set_rgb_input_buffer(_dispvars->sunxi_disp, _dispvars->bytes_per_pixel * 8,
       _dispvars->nextPage->offset,
       _dispvars->src_width, _dispvars->src_height, _dispvars->sunxi_disp->xres);
 
@@ -893,39 +903,45 @@ static void sunxi_set_texture_enable(void *data, bool state, bool full_screen)
 static void sunxi_set_texture_frame(void *data, const void *frame, bool rgb32,
       unsigned width, unsigned height, float alpha)
 {
-   uint32_t line[dst_width]; 
-   uint16_t src_pix;
-   uint32_t R, G, B, dst_pix;
    unsigned int i, j;
    struct sunxi_video *_dispvars = (struct sunxi_video*)data;
-   
-   /* We have to go on a pixel format conversion adventure for now, until we can
-    * convince RGUI to output in an 8888 format. */
-   unsigned int src_pitch        = width * 2; 
    unsigned int dst_pitch        = _dispvars->sunxi_disp->xres * 4;
-   unsigned int dst_width        = _dispvars->sunxi_disp->xres;
+   uint8_t *dst                  = (uint8_t*)_dispvars->pages[0].address;
 
-   /* Remember, memcpy() works with 8bits pointers for increments. */
-   char *dst_base_addr           = (char*)(_dispvars->pages[0].address);
-   char *src_base_addr           = (char*)frame;  
+   (void)alpha;
 
-   for (i = 0; i < height; i++)
+   if (rgb32)
+   {
+      for (i = 0; i < height; i++)
+         memcpy(dst + dst_pitch * i, (const uint32_t*)frame + width * i,
+               width * sizeof(uint32_t));
+   }
+   else
    {
-      for (j = 0; j < src_pitch / 2; j++)
+      /* The layer has no RGBA4444 mode, RGB565 is the
+       * closest it scales, and only needs the bits moved. */
+      for (i = 0; i < height; i++)
       {
-         src_pix = *((uint16_t*)frame + (src_pitch / 2 * i) + j); 
-         /* The hex AND is for keeping only the part we need for each component. */
-         R = (src_pix << 8) & 0x00FF0000;
-         G = (src_pix << 4) & 0x0000FF00;
-         B = (src_pix << 0) & 0x000000FF;
-         line[j] = (0 | R | G | B); 
+         const uint16_t *src = (const uint16_t*)frame + width * i;
+         uint16_t *line      = (uint16_t*)(dst + dst_pitch * i);
+
+         for (j = 0; j < width; j++)
+         {
+            uint16_t pix = src[j];
+            unsigned r   = pix >> 12;
+            unsigned g   = (pix >> 8) & 0xf;
+            unsigned b   = (pix >> 4) & 0xf;
+
+            line[j] = (((r << 1) | (r >> 3)) << 11)
+               | (((g << 2) | (g >> 2)) << 5)
+               | ((b << 1) | (b >> 3));
+         }
       }
-      memcpy(dst_base_addr + (dst_pitch * i), (char*)line, dst_pitch);
    }
 
    /* Issue pageflip. Will flip on next vsync. */
    sunxi_layer_set_rgb_input_buffer(_dispvars->sunxi_disp,
-         _dispvars->sunxi_disp->bits_per_pixel, 
+         rgb32 ? 32 : 16,
          _dispvars->pages[0].offset, width, height, _dispvars->sunxi_disp->xres);
 }
 
@@ -17,6 +17,7 @@
 #include "../../driver.h"
 #include "../../general.h"
 #include "../../runloop.h"
+#include "../../dylib.h"
 #include "../video_monitor.h"
 #include "../drivers/gl_common.h"
 
@@ -26,10 +27,16 @@
 #include <formats/image.h>
 
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 /* forward declaration */
 int system_property_get(const char *name, char *value);
 
+/* EGL_ANDROID_presentation_time. */
+typedef EGLBoolean (*android_presentation_time_t)(EGLDisplay,
+      EGLSurface, int64_t);
+
 typedef struct gfx_ctx_android_data
 {
    bool g_use_hw_ctx;
@@ -38,10 +45,202 @@ typedef struct gfx_ctx_android_data
    EGLSurface g_egl_surf;
    EGLDisplay g_egl_dpy;
    EGLConfig g_egl_config;
+
+   unsigned swap_interval;
+   android_presentation_time_t presentation_time;
 } gfx_ctx_android_data_t;
 
 static bool g_es3;
 
+/* AChoreographer only exists from Android 7.0 on, so libandroid.so
+ * is searched for it at runtime, and the little we use of
+ * <android/choreographer.h> is declared here. Without it, frames
+ * are paced by eglSwapInterval() alone, as before. */
+
+typedef struct AChoreographer AChoreographer;
+typedef void (*android_frame_callback_t)(long frame_time_nanos,
+      void *data);
+typedef void (*android_frame_callback64_t)(int64_t frame_time_nanos,
+      void *data);
+
+static struct
+{
+   dylib_t lib;
+   AChoreographer *(*get_instance)(void);
+   void (*post_frame_callback)(AChoreographer*,
+         android_frame_callback_t, void*);
+   /* Android 10 on, the other one truncates to 32 bits there. */
+   void (*post_frame_callback64)(AChoreographer*,
+         android_frame_callback64_t, void*);
+} choreographer;
+
+/* Vsync timestamps from the Choreographer, in nanoseconds on
+ * CLOCK_MONOTONIC. Kept outside the context data, as a posted
+ * callback can still come in after the context is gone. */
+static struct
+{
+   AChoreographer *instance;
+   bool active;
+   bool pending;
+   int64_t last_ns;
+   int64_t period_ns;
+} android_vsync;
+
+static int64_t android_gfx_ctx_monotonic_ns(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return (int64_t)tv.tv_sec * 1000000000 + tv.tv_nsec;
+}
+
+static bool android_gfx_ctx_choreographer_load(void)
+{
+   if (choreographer.lib)
+      return true;
+
+   choreographer.lib = dylib_load("libandroid.so");
+   if (!choreographer.lib)
+      return false;
+
+#define CHOREOGRAPHER_SYM(field, name) do { \
+   function_t func = dylib_proc(choreographer.lib, name); \
+   memcpy(&choreographer.field, &func, sizeof(func)); \
+} while (0)
+
+   CHOREOGRAPHER_SYM(get_instance,          "AChoreographer_getInstance");
+   CHOREOGRAPHER_SYM(post_frame_callback,   "AChoreographer_postFrameCallback");
+   CHOREOGRAPHER_SYM(post_frame_callback64, "AChoreographer_postFrameCallback64");
+
+#undef CHOREOGRAPHER_SYM
+
+   if (choreographer.get_instance && (choreographer.post_frame_callback
+            || choreographer.post_frame_callback64))
+      return true;
+
+   dylib_close(choreographer.lib);
+   memset(&choreographer, 0, sizeof(choreographer));
+   return false;
+}
+
+static void android_gfx_ctx_vsync(int64_t frame_time_nanos)
+{
+   int64_t ns = frame_time_nanos;
+
+   /* The 32-bit callback cuts the timestamp off. The rest comes
+    * from the clock, the vsync being at most a few frames back. */
+   if (!choreographer.post_frame_callback64 && sizeof(long) < 8)
+   {
+      int64_t now = android_gfx_ctx_monotonic_ns();
+      ns = now - (int64_t)(uint32_t)
+         ((uint32_t)now - (uint32_t)frame_time_nanos);
+   }
+
+   android_vsync.pending = false;
+
+   if (!android_vsync.active)
+      return;
+
+   if (android_vsync.last_ns)
+   {
+      int64_t diff   = ns - android_vsync.last_ns;
+      int64_t period = android_vsync.period_ns;
+
+      /* Only back to back vsyncs tell the period,
+       * others are several of them apart. */
+      if (diff > period / 2 && diff < period + period / 2)
+         android_vsync.period_ns = period + (diff - period) / 16;
+   }
+
+   android_vsync.last_ns = ns;
+   video_monitor_frame_presented((retro_time_t)(ns / 1000));
+}
+
+static void android_gfx_ctx_frame_callback(long frame_time_nanos,
+      void *data)
+{
+   (void)data;
+   android_gfx_ctx_vsync(frame_time_nanos);
+}
+
+static void android_gfx_ctx_frame_callback64(int64_t frame_time_nanos,
+      void *data)
+{
+   (void)data;
+   android_gfx_ctx_vsync(frame_time_nanos);
+}
+
+static void android_gfx_ctx_vsync_init(void)
+{
+   settings_t *settings = config_get_ptr();
+   float refresh_rate   = settings->video.refresh_rate;
+
+   memset(&android_vsync, 0, sizeof(android_vsync));
+
+   if (!android_gfx_ctx_choreographer_load())
+      return;
+
+   /* Callbacks come in on the looper of this thread, which
+    * the input driver polls every frame. Threaded video has
+    * no looper on its thread, and goes without. */
+   android_vsync.instance = choreographer.get_instance();
+   if (!android_vsync.instance)
+      return;
+
+   if (refresh_rate <= 0.0f)
+      refresh_rate = 60.0f;
+
+   android_vsync.active    = true;
+   android_vsync.period_ns = (int64_t)(1000000000.0 / refresh_rate);
+
+   RARCH_LOG("[Android/EGL]: Using Choreographer vsync timestamps.\n");
+}
+
+static void android_gfx_ctx_vsync_post(void)
+{
+   if (!android_vsync.active || android_vsync.pending)
+      return;
+
+   android_vsync.pending = true;
+
+   if (choreographer.post_frame_callback64)
+      choreographer.post_frame_callback64(android_vsync.instance,
+            android_gfx_ctx_frame_callback64, NULL);
+   else
+      choreographer.post_frame_callback(android_vsync.instance,
+            android_gfx_ctx_frame_callback, NULL);
+}
+
+/**
+ * android_gfx_ctx_set_presentation_time:
+ * @android              : Android EGL context data.
+ *
+ * Asks for the next frame to be shown on the vsync the swap
+ * interval puts it on, predicted from the last Choreographer
+ * timestamp. The compositor then holds it for that vsync
+ * instead of showing it early and queueing up more.
+ **/
+static void android_gfx_ctx_set_presentation_time(
+      gfx_ctx_android_data_t *android)
+{
+   int64_t now, next;
+   int64_t period = android_vsync.period_ns;
+
+   if (!android->presentation_time || !android->swap_interval)
+      return;
+   if (!android_vsync.last_ns || period <= 0)
+      return;
+
+   now  = android_gfx_ctx_monotonic_ns();
+   next = android_vsync.last_ns +
+      ((now - android_vsync.last_ns) / period + 1) * period;
+   next += (int64_t)(android->swap_interval - 1) * period;
+
+   /* Half a period early, so jitter in the prediction
+    * never pushes a frame to the vsync after. */
+   android->presentation_time(android->g_egl_dpy,
+         android->g_egl_surf, next - period / 2);
+}
+
 static void android_gfx_ctx_set_swap_interval(void *data, unsigned interval)
 {
    driver_t *driver = driver_get_ptr();
@@ -53,6 +252,7 @@ static void android_gfx_ctx_set_swap_interval(void *data, unsigned interval)
    if (!android)
       return;
 
+   android->swap_interval = interval;
    eglSwapInterval(android->g_egl_dpy, interval);
 }
 
@@ -80,6 +280,8 @@ static void android_gfx_ctx_destroy_resources(gfx_ctx_android_data_t *android)
 
    /* Be as careful as possible in deinit. */
 
+   android_vsync.active   = false;
+
    android->g_egl_ctx     = NULL;
    android->g_egl_hw_ctx  = NULL;
    android->g_egl_surf    = NULL;
@@ -221,6 +423,21 @@ static bool android_gfx_ctx_init(void *data)
             android->g_egl_surf, android->g_egl_ctx))
       goto error;
 
+   android->swap_interval = 1;
+
+   android_gfx_ctx_vsync_init();
+
+   if (android_vsync.active)
+   {
+      const char *ext = eglQueryString(android->g_egl_dpy, EGL_EXTENSIONS);
+
+      if (ext && strstr(ext, "EGL_ANDROID_presentation_time"))
+      {
+         void *sym = (void*)eglGetProcAddress("eglPresentationTimeANDROID");
+         memcpy(&android->presentation_time, &sym, sizeof(sym));
+      }
+   }
+
    driver->video_context_data = android;
 
    return true;
@@ -243,8 +460,12 @@ static void android_gfx_ctx_swap_buffers(void *data)
 
    (void)data;
 
-   if (android)
-      eglSwapBuffers(android->g_egl_dpy, android->g_egl_surf);
+   if (!android)
+      return;
+
+   android_gfx_ctx_set_presentation_time(android);
+   eglSwapBuffers(android->g_egl_dpy, android->g_egl_surf);
+   android_gfx_ctx_vsync_post();
 }
 
 static void android_gfx_ctx_check_window(void *data, bool *quit,
@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <signal.h>
 #include <unistd.h>
 #include <sched.h>
@@ -64,6 +65,9 @@ typedef struct gfx_ctx_drm_egl_data
    unsigned g_interval;
 
    drmModeModeInfo *g_drm_mode;
+   /* Mode derived from one of the connector's,
+    * retimed to the refresh rate of the core. */
+   drmModeModeInfo g_custom_mode;
    drmModeCrtcPtr g_orig_crtc;
    drmModeRes *g_resources;
    drmModeConnector *g_connector;
@@ -661,6 +665,44 @@ static EGLint *egl_fill_attribs(EGLint *attr)
    EGL_ALPHA_SIZE,      0, \
    EGL_DEPTH_SIZE,      0
 
+/**
+ * drm_mode_retime:
+ * @mode                     : Mode the connector reported.
+ * @hz                       : Refresh rate to retime it to.
+ * @out                      : Retimed mode.
+ *
+ * Stretches the vertical blanking of @mode so it refreshes at @hz,
+ * keeping the line rate as it is, like CRTs expect. If that takes
+ * more than a few lines, the pixel clock is scaled instead.
+ *
+ * Returns: true (1) if @out was filled in, otherwise false (0).
+ **/
+static bool drm_mode_retime(const drmModeModeInfo *mode,
+      float hz, drmModeModeInfo *out)
+{
+   unsigned vtotal;
+
+   if (hz <= 0.0f || !mode->htotal || !mode->vtotal)
+      return false;
+   if (mode->flags & (DRM_MODE_FLAG_INTERLACE | DRM_MODE_FLAG_DBLSCAN))
+      return false;
+
+   *out   = *mode;
+   vtotal = (unsigned)(mode->clock * 1000.0 / (mode->htotal * hz) + 0.5);
+
+   if (vtotal > mode->vsync_end &&
+         abs((int)vtotal - (int)mode->vtotal) <= mode->vtotal / 20)
+      out->vtotal = vtotal;
+   else
+      out->clock  = (uint32_t)(mode->htotal * mode->vtotal * hz / 1000.0 + 0.5);
+
+   out->vrefresh = (uint32_t)(hz + 0.5f);
+   out->type     = DRM_MODE_TYPE_USERDEF;
+   snprintf(out->name, sizeof(out->name), "%ux%u@%.2f",
+         mode->hdisplay, mode->vdisplay, hz);
+   return true;
+}
+
 static bool gfx_ctx_drm_egl_set_video_mode(void *data,
       unsigned width, unsigned height,
       bool fullscreen)
@@ -697,8 +739,10 @@ static bool gfx_ctx_drm_egl_set_video_mode(void *data,
    int i, ret = 0;
    struct sigaction sa = {{0}};
    struct drm_fb *fb = NULL;
+   drmModeModeInfo *listed_mode = NULL;
    driver_t *driver     = driver_get_ptr();
    settings_t *settings = config_get_ptr();
+   global_t *global     = global_get_ptr();
    gfx_ctx_drm_egl_data_t *drm = (gfx_ctx_drm_egl_data_t*)
       driver->video_context_data;
 
@@ -771,6 +815,24 @@ static bool gfx_ctx_drm_egl_set_video_mode(void *data,
       goto error;
    }
 
+   listed_mode = drm->g_drm_mode;
+
+   if (settings->video.kms_match_core_refresh)
+   {
+      const drmModeModeInfo *mode = drm->g_drm_mode;
+      float core_hz = global->system.av_info.timing.fps / refresh_mod;
+      float mode_hz = (mode->htotal && mode->vtotal) ?
+         mode->clock * 1000.0f / (mode->htotal * mode->vtotal) : 0.0f;
+
+      if (fabsf(mode_hz - core_hz) > 0.01f &&
+            drm_mode_retime(mode, core_hz, &drm->g_custom_mode))
+      {
+         RARCH_LOG("[KMS/EGL]: Retimed %s (%.3f Hz) to %s.\n",
+               mode->name, mode_hz, drm->g_custom_mode.name);
+         drm->g_drm_mode = &drm->g_custom_mode;
+      }
+   }
+
    drm->g_fb_width  = drm->g_drm_mode->hdisplay;
    drm->g_fb_height = drm->g_drm_mode->vdisplay;
 
@@ -836,6 +898,17 @@ static bool gfx_ctx_drm_egl_set_video_mode(void *data,
 
    ret = drmModeSetCrtc(drm->g_drm_fd,
          drm->g_crtc_id, fb->fb_id, 0, 0, &drm->g_connector_id, 1, drm->g_drm_mode);
+
+   /* Not every display takes a retimed mode. */
+   if (ret < 0 && drm->g_drm_mode == &drm->g_custom_mode)
+   {
+      RARCH_WARN("[KMS/EGL]: Retimed mode was rejected, using %s.\n",
+            listed_mode->name);
+      drm->g_drm_mode = listed_mode;
+      ret = drmModeSetCrtc(drm->g_drm_fd,
+            drm->g_crtc_id, fb->fb_id, 0, 0, &drm->g_connector_id, 1, drm->g_drm_mode);
+   }
+
    if (ret < 0)
       goto error;
 
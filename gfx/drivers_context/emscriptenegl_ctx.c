@@ -56,7 +56,11 @@ static void gfx_ctx_emscripten_check_window(void *data, bool *quit,
    (void)data;
    (void)frame_count;
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+   emscripten_get_canvas_element_size("#canvas", &iWidth, &iHeight);
+#else
    emscripten_get_canvas_size(&iWidth, &iHeight, &isFullscreen);
+#endif
    *width  = (unsigned) iWidth;
    *height = (unsigned) iHeight;
    *resize = false;
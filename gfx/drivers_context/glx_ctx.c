@@ -50,7 +50,8 @@ typedef struct gfx_ctx_glx_data
    XIM g_xim;
    XIC g_xic;
 
-   GLXContext g_ctx, g_hw_ctx;
+   GLXContext g_ctx, g_hw_ctx, g_shared_ctx;
+   GLXPbuffer g_shared_pbuf;
    GLXFBConfig g_fbc;
 
    XF86VidModeModeInfo g_desktop_mode;
@@ -271,9 +272,15 @@ static void ctx_glx_destroy_resources(gfx_ctx_glx_data_t *glx)
       {
          if (glx->g_hw_ctx)
             glXDestroyContext(glx->g_dpy, glx->g_hw_ctx);
+         if (glx->g_shared_ctx)
+            glXDestroyContext(glx->g_dpy, glx->g_shared_ctx);
+         if (glx->g_shared_pbuf)
+            glXDestroyPbuffer(glx->g_dpy, glx->g_shared_pbuf);
          glXDestroyContext(glx->g_dpy, glx->g_ctx);
          glx->g_ctx = NULL;
          glx->g_hw_ctx = NULL;
+         glx->g_shared_ctx = NULL;
+         glx->g_shared_pbuf = 0;
       }
    }
 
@@ -417,6 +424,38 @@ error:
 }
 
 
+/* The worker context needs a drawable of its own, 
+ * since the window belongs to the main thread. */
+static void ctx_glx_init_shared_pbuffer(gfx_ctx_glx_data_t *glx)
+{
+   static const int pbuffer_attribs[] = {
+      GLX_PBUFFER_WIDTH,  1,
+      GLX_PBUFFER_HEIGHT, 1,
+      None
+   };
+   int drawable_type = 0;
+   int (*old_handler)(Display*, XErrorEvent*) = NULL;
+
+   glXGetFBConfigAttrib(glx->g_dpy, glx->g_fbc,
+         GLX_DRAWABLE_TYPE, &drawable_type);
+
+   if (drawable_type & GLX_PBUFFER_BIT)
+   {
+      old_handler = XSetErrorHandler(glx_nul_handler);
+      glx->g_shared_pbuf = glXCreatePbuffer(glx->g_dpy,
+            glx->g_fbc, pbuffer_attribs);
+      XSync(glx->g_dpy, False);
+      XSetErrorHandler(old_handler);
+   }
+
+   if (!glx->g_shared_pbuf)
+   {
+      RARCH_WARN("[GLX]: Cannot create pbuffer, shaders will be compiled synchronously.\n");
+      glXDestroyContext(glx->g_dpy, glx->g_shared_ctx);
+      glx->g_shared_ctx = NULL;
+   }
+}
+
 static bool gfx_ctx_glx_set_video_mode(void *data,
       unsigned width, unsigned height,
       bool fullscreen)
@@ -574,6 +613,7 @@ static bool gfx_ctx_glx_set_video_mode(void *data,
             if (!glx->g_hw_ctx)
                RARCH_ERR("[GLX]: Failed to create new shared context.\n");
          }
+         glx->g_shared_ctx = glx_create_context_attribs(glx->g_dpy, glx->g_fbc, glx->g_ctx, True, attribs);
       }
       else
       {
@@ -584,6 +624,7 @@ static bool gfx_ctx_glx_set_video_mode(void *data,
             if (!glx->g_hw_ctx)
                RARCH_ERR("[GLX]: Failed to create new shared context.\n");
          }
+         glx->g_shared_ctx = glXCreateNewContext(glx->g_dpy, glx->g_fbc, GLX_RGBA_TYPE, glx->g_ctx, True);
       }
 
       if (!glx->g_ctx)
@@ -591,6 +632,9 @@ static bool gfx_ctx_glx_set_video_mode(void *data,
          RARCH_ERR("[GLX]: Failed to create new context.\n");
          goto error;
       }
+
+      if (glx->g_shared_ctx)
+         ctx_glx_init_shared_pbuffer(glx);
    }
    else
    {
@@ -784,6 +828,42 @@ static void gfx_ctx_glx_bind_hw_render(void *data, bool enable)
          glx->g_glx_win, enable ? glx->g_hw_ctx : glx->g_ctx);
 }
 
+static bool gfx_ctx_glx_bind_shared_context(void *data, bool enable)
+{
+   driver_t *driver = driver_get_ptr();
+   gfx_ctx_glx_data_t *glx = (gfx_ctx_glx_data_t*)driver->video_context_data;
+
+   (void)data;
+
+   if (!glx || !glx->g_dpy || !glx->g_shared_ctx)
+      return false;
+
+   if (!enable)
+      return glXMakeContextCurrent(glx->g_dpy, None, None, NULL);
+
+   return glXMakeContextCurrent(glx->g_dpy, glx->g_shared_pbuf,
+         glx->g_shared_pbuf, glx->g_shared_ctx);
+}
+
+static bool gfx_ctx_glx_bind_hw_render_thread(void *data, bool enable)
+{
+   driver_t *driver = driver_get_ptr();
+   gfx_ctx_glx_data_t *glx = (gfx_ctx_glx_data_t*)driver->video_context_data;
+
+   (void)data;
+
+   if (!glx || !glx->g_dpy || !glx->g_glx_win || !glx->g_hw_ctx)
+      return false;
+
+   if (!enable)
+      return glXMakeContextCurrent(glx->g_dpy, None, None, NULL);
+
+   /* GLX lets the window be current on both threads.
+    * The core only renders to its framebuffers. */
+   return glXMakeContextCurrent(glx->g_dpy, glx->g_glx_win,
+         glx->g_glx_win, glx->g_hw_ctx);
+}
+
 static bool gfx_ctx_glx_get_metrics(void *data,
 	enum display_metric_types type, float *value)
 {
@@ -817,5 +897,7 @@ const gfx_ctx_driver_t gfx_ctx_glx = {
    "glx",
 
    gfx_ctx_glx_bind_hw_render,
+   gfx_ctx_glx_bind_shared_context,
+   gfx_ctx_glx_bind_hw_render_thread,
 };
 
@@ -17,6 +17,7 @@
 #include "../../driver.h"
 #include "../../general.h"
 #include "../../runloop.h"
+#include "../../performance.h"
 #include "../video_monitor.h"
 #include "../drivers/gl_common.h"
 
@@ -29,6 +30,10 @@
 #include <sys/poll.h>
 #include <unistd.h>
 
+/* Longest to wait for the compositor to ask for a frame,
+ * it stops asking while the window is hidden. */
+#define WL_FRAME_CALLBACK_TIMEOUT 100
+
 typedef struct gfx_ctx_wayland_data
 {
    EGLContext g_egl_ctx;
@@ -51,8 +56,71 @@ typedef struct gfx_ctx_wayland_data
    struct wl_egl_window *g_win;
    struct wl_keyboard *g_wl_keyboard;
    struct wl_pointer  *g_wl_pointer;
+   /* wp_presentation, if the compositor has it. */
+   struct wl_proxy *g_presentation;
+   /* Frame callback of the last frame, until the
+    * compositor is ready for the next one. */
+   struct wl_callback *g_frame_cb;
 } gfx_ctx_wayland_data_t;
 
+/* The presentation-time protocol, as wayland-scanner
+ * generates it from presentation-time.xml. */
+extern const struct wl_interface wp_presentation_feedback_interface;
+
+static const struct wl_interface *presentation_time_types[] = {
+   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+   &wl_surface_interface,
+   &wp_presentation_feedback_interface,
+   &wl_output_interface,
+};
+
+static const struct wl_message wp_presentation_requests[] = {
+   { "destroy", "", presentation_time_types + 0 },
+   { "feedback", "on", presentation_time_types + 7 },
+};
+
+static const struct wl_message wp_presentation_events[] = {
+   { "clock_id", "u", presentation_time_types + 0 },
+};
+
+const struct wl_interface wp_presentation_interface = {
+   "wp_presentation", 1,
+   2, wp_presentation_requests,
+   1, wp_presentation_events,
+};
+
+static const struct wl_message wp_presentation_feedback_events[] = {
+   { "sync_output", "o", presentation_time_types + 9 },
+   { "presented", "uuuuuuu", presentation_time_types + 0 },
+   { "discarded", "", presentation_time_types + 0 },
+};
+
+const struct wl_interface wp_presentation_feedback_interface = {
+   "wp_presentation_feedback", 1,
+   0, NULL,
+   3, wp_presentation_feedback_events,
+};
+
+#define WP_PRESENTATION_DESTROY  0
+#define WP_PRESENTATION_FEEDBACK 1
+
+struct wp_presentation_listener
+{
+   void (*clock_id)(void *data, struct wl_proxy *presentation,
+         uint32_t clk_id);
+};
+
+struct wp_presentation_feedback_listener
+{
+   void (*sync_output)(void *data, struct wl_proxy *feedback,
+         struct wl_output *output);
+   void (*presented)(void *data, struct wl_proxy *feedback,
+         uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+         uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo,
+         uint32_t flags);
+   void (*discarded)(void *data, struct wl_proxy *feedback);
+};
+
 
 static enum gfx_ctx_api g_api;
 static unsigned g_major;
@@ -111,6 +179,76 @@ static const struct wl_shell_surface_listener shell_surface_listener = {
    shell_surface_handle_popup_done,
 };
 
+/* Presentation callbacks. */
+static void presentation_handle_clock_id(void *data,
+      struct wl_proxy *presentation, uint32_t clk_id)
+{
+   (void)data;
+   (void)presentation;
+   (void)clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+   presentation_handle_clock_id,
+};
+
+static void feedback_handle_sync_output(void *data,
+      struct wl_proxy *feedback, struct wl_output *output)
+{
+   (void)data;
+   (void)feedback;
+   (void)output;
+}
+
+static void feedback_handle_presented(void *data,
+      struct wl_proxy *feedback,
+      uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+      uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo,
+      uint32_t flags)
+{
+   uint64_t sec = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+
+   (void)data;
+   (void)refresh;
+   (void)seq_hi;
+   (void)seq_lo;
+   (void)flags;
+
+   video_monitor_frame_presented(
+         (retro_time_t)(sec * 1000000 + tv_nsec / 1000));
+   wl_proxy_destroy(feedback);
+}
+
+static void feedback_handle_discarded(void *data,
+      struct wl_proxy *feedback)
+{
+   (void)data;
+   wl_proxy_destroy(feedback);
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+   feedback_handle_sync_output,
+   feedback_handle_presented,
+   feedback_handle_discarded,
+};
+
+/* Frame callbacks. */
+static void frame_handle_done(void *data,
+      struct wl_callback *callback, uint32_t time)
+{
+   gfx_ctx_wayland_data_t *wl = (gfx_ctx_wayland_data_t*)data;
+
+   (void)time;
+
+   wl_callback_destroy(callback);
+   if (wl->g_frame_cb == callback)
+      wl->g_frame_cb = NULL;
+}
+
+static const struct wl_callback_listener frame_listener = {
+   frame_handle_done,
+};
+
 /* Registry callbacks. */
 static void registry_handle_global(void *data, struct wl_registry *reg,
       uint32_t id, const char *interface, uint32_t version)
@@ -126,6 +264,13 @@ static void registry_handle_global(void *data, struct wl_registry *reg,
       wl->g_compositor = (struct wl_compositor*)wl_registry_bind(reg, id, &wl_compositor_interface, 1);
    else if (!strcmp(interface, "wl_shell"))
       wl->g_shell = (struct wl_shell*)wl_registry_bind(reg, id, &wl_shell_interface, 1);
+   else if (!strcmp(interface, "wp_presentation"))
+   {
+      wl->g_presentation = (struct wl_proxy*)wl_registry_bind(reg, id,
+            &wp_presentation_interface, 1);
+      wl_proxy_add_listener(wl->g_presentation,
+            (void (**)(void))&presentation_listener, NULL);
+   }
 }
 
 static void registry_handle_global_remove(void *data,
@@ -143,6 +288,7 @@ static const struct wl_registry_listener registry_listener = {
 
 
 
+
 static void gfx_ctx_wl_get_video_size(void *data,
       unsigned *width, unsigned *height);
 
@@ -174,6 +320,13 @@ static void gfx_ctx_wl_destroy_resources(gfx_ctx_wayland_data_t *wl)
    wl->g_egl_dpy     = NULL;
    wl->g_egl_config  = 0;
 
+   if (wl->g_frame_cb)
+      wl_callback_destroy(wl->g_frame_cb);
+   if (wl->g_presentation)
+   {
+      wl_proxy_marshal(wl->g_presentation, WP_PRESENTATION_DESTROY);
+      wl_proxy_destroy(wl->g_presentation);
+   }
    if (wl->g_win)
       wl_egl_window_destroy(wl->g_win);
    if (wl->g_shell)
@@ -193,6 +346,8 @@ static void gfx_ctx_wl_destroy_resources(gfx_ctx_wayland_data_t *wl)
       wl_display_disconnect(wl->g_dpy);
    }
 
+   wl->g_frame_cb     = NULL;
+   wl->g_presentation = NULL;
    wl->g_win        = NULL;
    wl->g_shell      = NULL;
    wl->g_compositor = NULL;
@@ -249,10 +404,12 @@ static void gfx_ctx_wl_swap_interval(void *data, unsigned interval)
 
    wl->g_interval = interval;
 
+   /* Swaps are paced by gfx_ctx_wl_swap_buffers() with
+    * frame callbacks instead, EGL must not block on its own. */
    if (wl->g_egl_dpy && eglGetCurrentContext())
    {
-      RARCH_LOG("[Wayland/EGL]: eglSwapInterval(%u)\n", wl->g_interval);
-      if (!eglSwapInterval(wl->g_egl_dpy, wl->g_interval))
+      RARCH_LOG("[Wayland/EGL]: eglSwapInterval(0), paced by frame callbacks.\n");
+      if (!eglSwapInterval(wl->g_egl_dpy, 0))
       {
          RARCH_ERR("[Wayland/EGL]: eglSwapInterval() failed.\n");
          egl_report_error();
@@ -313,6 +470,49 @@ static void gfx_ctx_wl_check_window(void *data, bool *quit,
    *quit = g_quit;
 }
 
+/**
+ * wait_frame_callback:
+ * @wl                       : Wayland context.
+ *
+ * Dispatches events until the compositor is ready for the
+ * next frame, or WL_FRAME_CALLBACK_TIMEOUT ms have passed.
+ **/
+static void wait_frame_callback(gfx_ctx_wayland_data_t *wl)
+{
+   retro_time_t deadline = rarch_get_time_usec() +
+      WL_FRAME_CALLBACK_TIMEOUT * 1000;
+
+   while (wl->g_frame_cb && !g_quit)
+   {
+      struct pollfd fd = {0};
+      retro_time_t now = rarch_get_time_usec();
+
+      if (now >= deadline)
+         break;
+
+      if (wl_display_prepare_read(wl->g_dpy) != 0)
+      {
+         wl_display_dispatch_pending(wl->g_dpy);
+         continue;
+      }
+
+      wl_display_flush(wl->g_dpy);
+
+      fd.fd     = wl->g_fd;
+      fd.events = POLLIN;
+
+      if (poll(&fd, 1, (int)((deadline - now + 999) / 1000)) <= 0 ||
+            (fd.revents & (POLLERR | POLLHUP)))
+      {
+         wl_display_cancel_read(wl->g_dpy);
+         break;
+      }
+
+      wl_display_read_events(wl->g_dpy);
+      wl_display_dispatch_pending(wl->g_dpy);
+   }
+}
+
 static void gfx_ctx_wl_swap_buffers(void *data)
 {
    driver_t *driver = driver_get_ptr();
@@ -321,6 +521,26 @@ static void gfx_ctx_wl_swap_buffers(void *data)
 
    (void)data;
 
+   /* Only swap once the compositor asked for the frame,
+    * so it is shown at the next refresh rather than queued. */
+   if (wl->g_interval)
+      wait_frame_callback(wl);
+
+   if (wl->g_frame_cb)
+      wl_callback_destroy(wl->g_frame_cb);
+   wl->g_frame_cb = wl_surface_frame(wl->g_surface);
+   wl_callback_add_listener(wl->g_frame_cb, &frame_listener, wl);
+
+   if (wl->g_presentation)
+   {
+      struct wl_proxy *feedback = wl_proxy_marshal_constructor(
+            wl->g_presentation, WP_PRESENTATION_FEEDBACK,
+            &wp_presentation_feedback_interface, wl->g_surface, NULL);
+      if (feedback)
+         wl_proxy_add_listener(feedback,
+               (void (**)(void))&feedback_listener, NULL);
+   }
+
    eglSwapBuffers(wl->g_egl_dpy, wl->g_egl_surf);
 }
 
@@ -21,35 +21,104 @@
 /* TODO: Move viewport side effects to the caller: it's a source of bugs. */
 
 #define gl_raster_font_emit(c, vx, vy) do { \
-   font_vertex[     2 * (6 * i + c) + 0] = (x + (delta_x + off_x + vx * width) * scale) * inv_win_width; \
-   font_vertex[     2 * (6 * i + c) + 1] = (y + (delta_y - off_y - vy * height) * scale) * inv_win_height; \
-   font_tex_coords[ 2 * (6 * i + c) + 0] = (tex_x + vx * width) * inv_tex_size_x; \
-   font_tex_coords[ 2 * (6 * i + c) + 1] = (tex_y + vy * height) * inv_tex_size_y; \
-   font_color[      4 * (6 * i + c) + 0] = color[0]; \
-   font_color[      4 * (6 * i + c) + 1] = color[1]; \
-   font_color[      4 * (6 * i + c) + 2] = color[2]; \
-   font_color[      4 * (6 * i + c) + 3] = color[3]; \
+   font->vertex[   2 * (v + c) + 0] = (x + (glyph->x + vx * glyph->width) * scale) * inv_win_width; \
+   font->vertex[   2 * (v + c) + 1] = (y + (glyph->y - vy * glyph->height) * scale) * inv_win_height; \
+   font->tex_coord[2 * (v + c) + 0] = (glyph->tex_x + vx * glyph->width) * inv_tex_size_x; \
+   font->tex_coord[2 * (v + c) + 1] = (glyph->tex_y + vy * glyph->height) * inv_tex_size_y; \
+   font->color[    4 * (v + c) + 0] = color[0]; \
+   font->color[    4 * (v + c) + 1] = color[1]; \
+   font->color[    4 * (v + c) + 2] = color[2]; \
+   font->color[    4 * (v + c) + 3] = color[3]; \
 } while(0)
 
-#define MAX_MSG_LEN_CHUNK 64
+/* Strings whose layout is kept around, power of two. */
+#define GL_RASTER_LAYOUT_CACHE_SIZE 256
+
+typedef struct gl_raster_glyph
+{
+   /* Top-left corner, relative to where the string starts. */
+   int x, y;
+   int width, height;
+   int tex_x, tex_y;
+} gl_raster_glyph_t;
+
+typedef struct gl_raster_layout
+{
+   char *msg;
+   uint32_t hash;
+   /* Advance of the whole string, for alignment. */
+   int width;
+   unsigned size;
+   gl_raster_glyph_t *glyphs;
+} gl_raster_layout_t;
 
 typedef struct
 {
    gl_t *gl;
    GLuint tex;
    unsigned tex_width, tex_height;
+   unsigned atlas_version;
 
    const font_renderer_driver_t *font_driver;
    void *font_data;
 
    gl_font_raster_block_t *block;
+
+   gl_raster_layout_t layouts[GL_RASTER_LAYOUT_CACHE_SIZE];
+
+   /* Vertices of the message being rendered. */
+   GLfloat *vertex;
+   GLfloat *tex_coord;
+   GLfloat *color;
+   unsigned vertices_allocated;
 } gl_raster_t;
 
+/**
+ * gl_raster_font_upload_atlas:
+ * @font                : GL raster font handle.
+ *
+ * Copies the glyph atlas of the font renderer into the
+ * font texture, if glyphs have been added since.
+ **/
+static void gl_raster_font_upload_atlas(gl_raster_t *font,
+      const struct font_atlas *atlas)
+{
+   unsigned i;
+   uint8_t *tmp_buffer, *dst;
+   const uint8_t *src;
+
+   if (font->atlas_version == atlas->version)
+      return;
+
+   tmp_buffer = (uint8_t*)malloc(atlas->width * atlas->height * 4);
+
+   if (!tmp_buffer)
+      return;
+
+   dst = tmp_buffer;
+   src = atlas->buffer;
+
+   for (i = 0; i < atlas->width * atlas->height; i++)
+   {
+      *dst++ = 0xff;
+      *dst++ = 0xff;
+      *dst++ = 0xff;
+      *dst++ = *src++;
+   }
+
+   glBindTexture(GL_TEXTURE_2D, font->tex);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlas->width,
+         atlas->height, GL_RGBA, GL_UNSIGNED_BYTE, tmp_buffer);
+   glBindTexture(GL_TEXTURE_2D, font->gl->texture[font->gl->tex_index]);
+
+   free(tmp_buffer);
+   font->atlas_version = atlas->version;
+}
+
 static void *gl_raster_font_init_font(void *data,
       const char *font_path, float font_size)
 {
    unsigned width, height;
-   uint8_t *tmp_buffer;
    const struct font_atlas *atlas = NULL;
    gl_raster_t *font = (gl_raster_t*)calloc(1, sizeof(*font));
 
@@ -84,37 +153,18 @@ static void *gl_raster_font_init_font(void *data,
    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
          0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
-   tmp_buffer = (uint8_t*)malloc(atlas->width * atlas->height * 4);
-
-   if (tmp_buffer)
-   {
-      unsigned i;
-      uint8_t       *dst = tmp_buffer;
-      const uint8_t *src = atlas->buffer;
-
-      for (i = 0; i < atlas->width * atlas->height; i++)
-      {
-         *dst++ = 0xff;
-         *dst++ = 0xff;
-         *dst++ = 0xff;
-         *dst++ = *src++;
-      }
-
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlas->width,
-            atlas->height, GL_RGBA, GL_UNSIGNED_BYTE, tmp_buffer);
-      free(tmp_buffer);
-   }
-
-   font->tex_width  = width;
-   font->tex_height = height;
+   font->tex_width     = width;
+   font->tex_height    = height;
+   font->atlas_version = atlas->version - 1;
 
-   glBindTexture(GL_TEXTURE_2D, font->gl->texture[font->gl->tex_index]);
+   gl_raster_font_upload_atlas(font, atlas);
 
    return font;
 }
 
 static void gl_raster_font_free_font(void *data)
 {
+   unsigned i;
    gl_raster_t *font = (gl_raster_t*)data;
    if (!font)
       return;
@@ -122,37 +172,157 @@ static void gl_raster_font_free_font(void *data)
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
+   for (i = 0; i < GL_RASTER_LAYOUT_CACHE_SIZE; i++)
+   {
+      free(font->layouts[i].msg);
+      free(font->layouts[i].glyphs);
+   }
+
+   free(font->vertex);
+   free(font->tex_coord);
+   free(font->color);
+
    glDeleteTextures(1, &font->tex);
    free(font);
 }
 
-static int get_message_width(gl_raster_t *font, const char *msg)
+/**
+ * gl_raster_font_utf8_next:
+ * @str                 : advanced past the character read.
+ *
+ * Returns: code point of the UTF-8 character at @str. Bytes
+ * that don't start a valid UTF-8 sequence are taken as is.
+ **/
+static uint32_t gl_raster_font_utf8_next(const char **str)
 {
-   unsigned i;
-   unsigned msg_len_full   = strlen(msg);
-   unsigned msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
-   int      delta_x        = 0;
+   unsigned i, extra  = 0;
+   const uint8_t *s   = (const uint8_t*)*str;
+   uint32_t code      = *s;
 
-   while (msg_len_full)
+   if (code >= 0xf0 && code < 0xf8)
+      extra = 3;
+   else if (code >= 0xe0 && code < 0xf0)
+      extra = 2;
+   else if (code >= 0xc0 && code < 0xe0)
+      extra = 1;
+
+   if (extra)
+      code &= 0x7f >> (extra + 1);
+
+   for (i = 1; i <= extra; i++)
    {
-      for (i = 0; i < msg_len; i++)
+      if ((s[i] & 0xc0) != 0x80)
       {
-         const struct font_glyph *glyph = 
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
-         if (!glyph)
-            continue;
-
-         delta_x += glyph->advance_x;
+         *str += 1;
+         return *s;
       }
+      code = (code << 6) | (s[i] & 0x3f);
+   }
+
+   *str += extra + 1;
+   return code;
+}
 
-      msg_len_full -= msg_len;
-      msg          += msg_len;
-      msg_len       = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+/**
+ * gl_raster_font_get_layout:
+ * @font                : GL raster font handle.
+ * @msg                 : UTF-8 string.
+ *
+ * Looks the glyphs of @msg up and places them, or takes the
+ * layout from the last time @msg was rendered.
+ *
+ * Returns: layout of @msg, or NULL on error.
+ **/
+static const gl_raster_layout_t *gl_raster_font_get_layout(
+      gl_raster_t *font, const char *msg)
+{
+   int delta_x              = 0;
+   int delta_y              = 0;
+   uint32_t hash            = 5381;
+   const char *str          = msg;
+   size_t len               = 0;
+   gl_raster_layout_t *layout;
+
+   for (; *str; str++, len++)
+      hash = (hash << 5) + hash + (uint8_t)*str;
+
+   layout = &font->layouts[hash & (GL_RASTER_LAYOUT_CACHE_SIZE - 1)];
+
+   if (layout->msg && layout->hash == hash && !strcmp(layout->msg, msg))
+      return layout;
+
+   free(layout->msg);
+   free(layout->glyphs);
+   memset(layout, 0, sizeof(*layout));
+
+   /* A glyph takes at least one byte. */
+   layout->msg    = strdup(msg);
+   layout->glyphs = (gl_raster_glyph_t*)malloc(
+         (len + 1) * sizeof(*layout->glyphs));
+
+   if (!layout->msg || !layout->glyphs)
+   {
+      free(layout->msg);
+      free(layout->glyphs);
+      memset(layout, 0, sizeof(*layout));
+      return NULL;
+   }
+
+   while (*msg)
+   {
+      gl_raster_glyph_t *dst         = NULL;
+      uint32_t code                  = gl_raster_font_utf8_next(&msg);
+      const struct font_glyph *glyph =
+         font->font_driver->get_glyph(font->font_data, code);
+
+      if (!glyph) /* Do something smarter here ... */
+         glyph = font->font_driver->get_glyph(font->font_data, '?');
+      if (!glyph)
+         continue;
+
+      dst         = &layout->glyphs[layout->size++];
+      dst->x      = delta_x + glyph->draw_offset_x;
+      dst->y      = delta_y - glyph->draw_offset_y;
+      dst->width  = glyph->width;
+      dst->height = glyph->height;
+      dst->tex_x  = glyph->atlas_offset_x;
+      dst->tex_y  = glyph->atlas_offset_y;
+
+      delta_x += glyph->advance_x;
+      delta_y -= glyph->advance_y;
    }
 
-   return delta_x;
+   layout->hash  = hash;
+   layout->width = delta_x;
+
+   return layout;
+}
+
+static bool gl_raster_font_reserve(gl_raster_t *font, unsigned vertices)
+{
+   GLfloat *vertex, *tex_coord, *color;
+
+   if (vertices <= font->vertices_allocated)
+      return true;
+
+   vertex    = (GLfloat*)realloc(font->vertex,
+         2 * vertices * sizeof(GLfloat));
+   if (vertex)
+      font->vertex = vertex;
+   tex_coord = (GLfloat*)realloc(font->tex_coord,
+         2 * vertices * sizeof(GLfloat));
+   if (tex_coord)
+      font->tex_coord = tex_coord;
+   color     = (GLfloat*)realloc(font->color,
+         4 * vertices * sizeof(GLfloat));
+   if (color)
+      font->color = color;
+
+   if (!vertex || !tex_coord || !color)
+      return false;
+
+   font->vertices_allocated = vertices;
+   return true;
 }
 
 static void gl_raster_font_draw_vertices(gl_t *gl, const gl_coords_t *coords)
@@ -166,38 +336,34 @@ static void gl_raster_font_draw_vertices(gl_t *gl, const gl_coords_t *coords)
    glDrawArrays(GL_TRIANGLES, 0, coords->vertices);
 }
 
+/**
+ * gl_raster_font_render_message:
+ * @font                : GL raster font handle.
+ * @layout              : layout of the message.
+ * @first               : first vertex to write to.
+ *
+ * Writes the vertices of a laid out message, six per glyph.
+ **/
 static void gl_raster_font_render_message(
-      gl_raster_t *font, const char *msg, GLfloat scale,
+      gl_raster_t *font, const gl_raster_layout_t *layout, GLfloat scale,
       const GLfloat color[4], GLfloat pos_x, GLfloat pos_y,
-      unsigned text_align)
+      unsigned text_align, unsigned first)
 {
-   int x, y, delta_x, delta_y;
+   int x, y;
    float inv_tex_size_x, inv_tex_size_y, inv_win_width, inv_win_height;
-   unsigned i, msg_len_full, msg_len;
-   GLfloat font_tex_coords[2 * 6 * MAX_MSG_LEN_CHUNK];
-   GLfloat font_vertex[2 * 6 * MAX_MSG_LEN_CHUNK]; 
-   GLfloat font_color[4 * 6 * MAX_MSG_LEN_CHUNK];
-   struct gl_coords coords;
-   gl_t *gl       = font ? font->gl : NULL;
-
-   if (!gl)
-      return;
-
-   msg_len_full   = strlen(msg);
-   msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+   unsigned i;
+   gl_t *gl       = font->gl;
 
    x              = roundf(pos_x * gl->vp.width);
    y              = roundf(pos_y * gl->vp.height);
-   delta_x        = 0;
-   delta_y        = 0;
 
    switch (text_align)
    {
       case TEXT_ALIGN_RIGHT:
-         x -= get_message_width(font, msg);
+         x -= layout->width;
          break;
       case TEXT_ALIGN_CENTER:
-         x -= get_message_width(font, msg) / 2.0;
+         x -= layout->width / 2.0;
          break;
    }
 
@@ -206,52 +372,18 @@ static void gl_raster_font_render_message(
    inv_win_width  = 1.0f / font->gl->vp.width;
    inv_win_height = 1.0f / font->gl->vp.height;
 
-   while (msg_len_full)
+   for (i = 0; i < layout->size; i++)
    {
-      for (i = 0; i < msg_len; i++)
-      {
-         int off_x, off_y, tex_x, tex_y, width, height;
-         const struct font_glyph *glyph =
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
-         if (!glyph)
-            continue;
-
-         off_x  = glyph->draw_offset_x;
-         off_y  = glyph->draw_offset_y;
-         tex_x  = glyph->atlas_offset_x;
-         tex_y  = glyph->atlas_offset_y;
-         width  = glyph->width;
-         height = glyph->height;
-
-         gl_raster_font_emit(0, 0, 1); /* Bottom-left */
-         gl_raster_font_emit(1, 1, 1); /* Bottom-right */
-         gl_raster_font_emit(2, 0, 0); /* Top-left */
-
-         gl_raster_font_emit(3, 1, 0); /* Top-right */
-         gl_raster_font_emit(4, 0, 0); /* Top-left */
-         gl_raster_font_emit(5, 1, 1); /* Bottom-right */
-
-         delta_x += glyph->advance_x;
-         delta_y -= glyph->advance_y;
-      }
-
-      coords.tex_coord     = font_tex_coords;
-      coords.vertex        = font_vertex;
-      coords.color         = font_color;
-      coords.vertices      = 6 * msg_len;
-      coords.lut_tex_coord = gl->coords.lut_tex_coord;
+      const gl_raster_glyph_t *glyph = &layout->glyphs[i];
+      unsigned v                     = first + 6 * i;
 
-      if (font->block)
-         gl_coord_array_add(&font->block->carr, &coords, coords.vertices);
-      else
-         gl_raster_font_draw_vertices(gl, &coords);
+      gl_raster_font_emit(0, 0, 1); /* Bottom-left */
+      gl_raster_font_emit(1, 1, 1); /* Bottom-right */
+      gl_raster_font_emit(2, 0, 0); /* Top-left */
 
-      msg_len_full -= msg_len;
-      msg          += msg_len;
-      msg_len       = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+      gl_raster_font_emit(3, 1, 0); /* Top-right */
+      gl_raster_font_emit(4, 0, 0); /* Top-left */
+      gl_raster_font_emit(5, 1, 1); /* Bottom-right */
    }
 }
 
@@ -288,8 +420,10 @@ static void gl_raster_font_render_msg(void *data, const char *msg,
    GLfloat x, y, scale, drop_mod;
    GLfloat color[4], color_dark[4];
    int drop_x, drop_y;
+   unsigned passes;
    bool full_screen;
    enum text_alignment text_align;
+   const gl_raster_layout_t *layout = NULL;
    gl_t *gl = NULL;
    gl_raster_t *font = (gl_raster_t*)data;
    settings_t *settings = config_get_ptr();
@@ -338,24 +472,52 @@ static void gl_raster_font_render_msg(void *data, const char *msg,
       drop_mod = 0.3f;
    }
 
+   layout = gl_raster_font_get_layout(font, msg);
+
+   /* Glyphs added by the layout have to be in the texture
+    * before anything gets drawn with it. */
+   gl_raster_font_upload_atlas(font,
+         font->font_driver->get_atlas(font->font_data));
+
    if (font->block)
       font->block->fullscreen = full_screen;
    else
       gl_raster_font_setup_viewport(font, full_screen);
 
-   if (drop_x || drop_y)
+   passes = (drop_x || drop_y) ? 2 : 1;
+
+   if (layout && layout->size
+         && gl_raster_font_reserve(font, passes * 6 * layout->size))
    {
-      color_dark[0] = color[0] * drop_mod;
-      color_dark[1] = color[1] * drop_mod;
-      color_dark[2] = color[2] * drop_mod;
-      color_dark[3] = color[3];
-
-      gl_raster_font_render_message(font, msg, scale, color_dark,
-            x + scale * drop_x / gl->vp.width, y + 
-            scale * drop_y / gl->vp.height, text_align);
-   }
+      gl_coords_t coords;
 
-   gl_raster_font_render_message(font, msg, scale, color, x, y, text_align);
+      if (passes == 2)
+      {
+         color_dark[0] = color[0] * drop_mod;
+         color_dark[1] = color[1] * drop_mod;
+         color_dark[2] = color[2] * drop_mod;
+         color_dark[3] = color[3];
+
+         gl_raster_font_render_message(font, layout, scale, color_dark,
+               x + scale * drop_x / gl->vp.width, y + 
+               scale * drop_y / gl->vp.height, text_align, 0);
+      }
+
+      /* Shadow and text go out in a single draw. */
+      gl_raster_font_render_message(font, layout, scale, color, x, y,
+            text_align, (passes - 1) * 6 * layout->size);
+
+      coords.tex_coord     = font->tex_coord;
+      coords.vertex        = font->vertex;
+      coords.color         = font->color;
+      coords.vertices      = passes * 6 * layout->size;
+      coords.lut_tex_coord = gl->coords.lut_tex_coord;
+
+      if (font->block)
+         gl_coord_array_add(&font->block->carr, &coords, coords.vertices);
+      else
+         gl_raster_font_draw_vertices(gl, &coords);
+   }
 
    if (!font->block)
       gl_raster_font_restore_viewport(gl);
@@ -370,7 +532,7 @@ static const struct font_glyph *gl_raster_font_get_glyph(
       return NULL;
    if (!font->font_driver->ident)
        return NULL;
-   return font->font_driver->get_glyph((void*)font->font_driver, code);
+   return font->font_driver->get_glyph(font->font_data, code);
 }
 
 static void gl_raster_font_flush_block(void *data)
@@ -17,6 +17,7 @@
 #include "../font_renderer_driver.h"
 #include <file/file_path.h>
 #include "../../general.h"
+#include <retro_miscellaneous.h>
 #include <string.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -24,9 +25,16 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
-#define FT_ATLAS_ROWS 8
-#define FT_ATLAS_COLS 16
-#define FT_ATLAS_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
+/* The atlas is about FT_ATLAS_LINES lines of text high and wide.
+ * Glyphs are rasterized into it the first time they are asked
+ * for, and never move once they are in. */
+#define FT_ATLAS_LINES     16
+#define FT_ATLAS_MIN_SIZE 256
+#define FT_ATLAS_MAX_SIZE 2048
+
+#define FT_MAX_GLYPHS 1024
+/* Power of two, at least twice FT_MAX_GLYPHS. */
+#define FT_GLYPH_MAP_SIZE 2048
 
 typedef struct freetype_renderer
 {
@@ -34,7 +42,18 @@ typedef struct freetype_renderer
    FT_Face face;
 
    struct font_atlas atlas;
-   struct font_glyph glyphs[FT_ATLAS_SIZE];
+   struct font_glyph glyphs[FT_MAX_GLYPHS];
+   unsigned glyphs_count;
+
+   /* Code point to glyph, 1-based, 0 marks a free slot. */
+   uint32_t map_codes[FT_GLYPH_MAP_SIZE];
+   uint16_t map_glyphs[FT_GLYPH_MAP_SIZE];
+
+   /* Shelf the next glyph goes to. */
+   unsigned pen_x;
+   unsigned pen_y;
+   unsigned shelf_height;
+   bool is_full;
 } ft_font_renderer_t;
 
 static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
@@ -45,13 +64,111 @@ static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
    return &handle->atlas;
 }
 
+static unsigned font_renderer_ft_map_slot(const ft_font_renderer_t *handle,
+      uint32_t code)
+{
+   unsigned slot = (code * 2654435761u) & (FT_GLYPH_MAP_SIZE - 1);
+
+   while (handle->map_glyphs[slot] && handle->map_codes[slot] != code)
+      slot = (slot + 1) & (FT_GLYPH_MAP_SIZE - 1);
+
+   return slot;
+}
+
+/**
+ * font_renderer_ft_add_glyph:
+ * @handle              : FreeType renderer handle.
+ * @code                : Unicode code point.
+ *
+ * Rasterizes a glyph into the next free spot of the atlas
+ * and bumps the atlas version.
+ *
+ * Returns: the new glyph, or NULL if the font has no glyph
+ * for @code or the atlas is full.
+ **/
+static struct font_glyph *font_renderer_ft_add_glyph(
+      ft_font_renderer_t *handle, uint32_t code)
+{
+   unsigned r;
+   uint8_t *dst;
+   const uint8_t *src;
+   FT_GlyphSlot slot;
+   struct font_glyph *glyph = NULL;
+
+   if (handle->is_full || handle->glyphs_count == FT_MAX_GLYPHS)
+      return NULL;
+
+   if (!FT_Get_Char_Index(handle->face, code))
+      return NULL;
+
+   if (FT_Load_Char(handle->face, code, FT_LOAD_RENDER))
+      return NULL;
+
+   slot = handle->face->glyph;
+
+   /* Leave a texel between glyphs, so filtering doesn't bleed. */
+   if (handle->pen_x + slot->bitmap.width + 1 > handle->atlas.width)
+   {
+      handle->pen_x         = 0;
+      handle->pen_y        += handle->shelf_height;
+      handle->shelf_height  = 0;
+   }
+
+   if (slot->bitmap.width + 1 > handle->atlas.width ||
+         handle->pen_y + slot->bitmap.rows + 1 > handle->atlas.height)
+   {
+      RARCH_WARN("[freetype]: Glyph atlas is full.\n");
+      handle->is_full = true;
+      return NULL;
+   }
+
+   glyph                 = &handle->glyphs[handle->glyphs_count++];
+   glyph->width          = slot->bitmap.width;
+   glyph->height         = slot->bitmap.rows;
+   glyph->atlas_offset_x = handle->pen_x;
+   glyph->atlas_offset_y = handle->pen_y;
+   glyph->advance_x      = slot->advance.x >> 6;
+   glyph->advance_y      = slot->advance.y >> 6;
+   glyph->draw_offset_x  = slot->bitmap_left;
+   glyph->draw_offset_y  = -slot->bitmap_top;
+
+   dst = handle->atlas.buffer + glyph->atlas_offset_x
+      + glyph->atlas_offset_y * handle->atlas.width;
+   src = slot->bitmap.buffer;
+
+   for (r = 0; src && r < glyph->height;
+         r++, dst += handle->atlas.width, src += slot->bitmap.pitch)
+      memcpy(dst, src, glyph->width);
+
+   handle->pen_x        += glyph->width + 1;
+   handle->shelf_height  = max(handle->shelf_height, glyph->height + 1);
+   handle->atlas.version++;
+
+   return glyph;
+}
+
 static const struct font_glyph *font_renderer_ft_get_glyph(
       void *data, uint32_t code)
 {
+   unsigned slot;
+   struct font_glyph *glyph   = NULL;
    ft_font_renderer_t *handle = (ft_font_renderer_t*)data;
+
    if (!handle)
       return NULL;
-   return code < FT_ATLAS_SIZE ? &handle->glyphs[code] : NULL;
+
+   slot = font_renderer_ft_map_slot(handle, code);
+
+   if (handle->map_glyphs[slot])
+      return &handle->glyphs[handle->map_glyphs[slot] - 1];
+
+   if (!(glyph = font_renderer_ft_add_glyph(handle, code)))
+      return NULL;
+
+   handle->map_codes[slot]  = code;
+   handle->map_glyphs[slot] = handle->glyphs_count;
+
+   return glyph;
 }
 
 static void font_renderer_ft_free(void *data)
@@ -72,90 +189,23 @@ static void font_renderer_ft_free(void *data)
 static bool font_renderer_create_atlas(ft_font_renderer_t *handle)
 {
    unsigned i;
-   bool ret = true;
-
-   uint8_t *buffer[FT_ATLAS_SIZE] = {NULL};
-   unsigned pitches[FT_ATLAS_SIZE] = {0};
-
-   unsigned max_width = 0;
-   unsigned max_height = 0;
-
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-   {
-      struct font_glyph *glyph = &handle->glyphs[i];
+   unsigned line = handle->face->size->metrics.height >> 6;
+   unsigned size = next_pow2(max(line, 1) * FT_ATLAS_LINES);
 
-      if (!glyph)
-         continue;
+   size = min(max(size, FT_ATLAS_MIN_SIZE), FT_ATLAS_MAX_SIZE);
 
-      if (FT_Load_Char(handle->face, i, FT_LOAD_RENDER))
-      {
-         ret = false;
-         goto end;
-      }
-
-      FT_Render_Glyph(handle->face->glyph, FT_RENDER_MODE_NORMAL);
-      FT_GlyphSlot slot = handle->face->glyph;
-
-      /* Some glyphs can be blank. */
-      buffer[i] = (uint8_t*)calloc(slot->bitmap.rows * slot->bitmap.pitch, 1);
-
-      glyph->width = slot->bitmap.width;
-      glyph->height = slot->bitmap.rows;
-      pitches[i] = slot->bitmap.pitch;
-
-      glyph->advance_x = slot->advance.x >> 6;
-      glyph->advance_y = slot->advance.y >> 6;
-      glyph->draw_offset_x = slot->bitmap_left;
-      glyph->draw_offset_y = -slot->bitmap_top;
-
-      if (buffer[i])
-         memcpy(buffer[i], slot->bitmap.buffer,
-               slot->bitmap.rows * pitches[i]);
-      max_width = max(max_width, (unsigned)slot->bitmap.width);
-      max_height = max(max_height, (unsigned)slot->bitmap.rows);
-   }
-
-   handle->atlas.width = max_width * FT_ATLAS_COLS;
-   handle->atlas.height = max_height * FT_ATLAS_ROWS;
-
-   handle->atlas.buffer = (uint8_t*)
-      calloc(handle->atlas.width * handle->atlas.height, 1);
+   handle->atlas.width  = size;
+   handle->atlas.height = size;
+   handle->atlas.buffer = (uint8_t*)calloc(size * size, 1);
 
    if (!handle->atlas.buffer)
-   {
-      ret = false;
-      goto end;
-   }
+      return false;
 
-   /* Blit our texture atlas. */
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-   {
-      unsigned r, c;
-      uint8_t *dst      = NULL;
-      unsigned offset_x = (i % FT_ATLAS_COLS) * max_width;
-      unsigned offset_y = (i / FT_ATLAS_COLS) * max_height;
-
-      handle->glyphs[i].atlas_offset_x = offset_x;
-      handle->glyphs[i].atlas_offset_y = offset_y;
-
-      dst = (uint8_t*)handle->atlas.buffer;
-      dst += offset_x + offset_y * handle->atlas.width;
-
-      if (buffer[i])
-      {
-         const uint8_t *src = (const uint8_t*)buffer[i];
-
-         for (r = 0; r < handle->glyphs[i].height;
-               r++, dst += handle->atlas.width, src += pitches[i])
-            for (c = 0; c < handle->glyphs[i].width; c++)
-               dst[c] = src[c];
-      }
-   }
+   /* Printable ASCII goes in up front, everything else on demand. */
+   for (i = 32; i < 127; i++)
+      font_renderer_ft_get_glyph(handle, i);
 
-end:
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-      free(buffer[i]);
-   return ret;
+   return handle->glyphs_count > 0;
 }
 
 static void *font_renderer_ft_init(const char *font_path, float font_size)
@@ -35,6 +35,7 @@
 #include <compat/posix_string.h>
 #include <file/config_file.h>
 #include "../../dynamic.h"
+#include "../../file_ops.h"
 #include <file/file_path.h>
 
 #include "../video_state_tracker.h"
@@ -492,15 +493,151 @@ static void gl_cg_deinit(void)
       listing_##type = strdup(list); \
 }
 
+/**
+ * program_cache_path:
+ * @cg                   : Cg shader handle.
+ * @source               : Source of the program.
+ * @argv                 : NULL-terminated compiler arguments.
+ * @path                 : Path of the cache entry.
+ * @size                 : Size of @path.
+ *
+ * Gets where the compiled object code of a program is cached. 
+ * The runtime version and profiles are hashed along with the 
+ * source, as those determine the generated code. Sources with 
+ * #include are not cached, since their dependencies aren't 
+ * part of the key.
+ *
+ * Returns: true (1) if the program can be cached, 
+ * otherwise false (0).
+ **/
+static bool program_cache_path(cg_shader_data_t *cg,
+      const char *source, const char **argv,
+      char *path, size_t size)
+{
+   unsigned i;
+   bool ret;
+   char *key;
+   size_t key_size = 0;
+   const char *parts[5 + GFX_MAX_SHADERS];
+   unsigned count  = 0;
+
+   if (!source || strstr(source, "#include"))
+      return false;
+
+   parts[count++] = cgGetString(CG_VERSION);
+   parts[count++] = cgGetProfileString(cg->cgFProf);
+   parts[count++] = cgGetProfileString(cg->cgVProf);
+   for (i = 0; argv[i]; i++)
+      parts[count++] = argv[i];
+   parts[count++] = source;
+
+   for (i = 0; i < count; i++)
+      key_size += (parts[i] ? strlen(parts[i]) : 0) + 1;
+
+   key = (char*)calloc(key_size, 1);
+   if (!key)
+      return false;
+
+   for (i = 0, key_size = 0; i < count; i++)
+   {
+      if (parts[i])
+      {
+         memcpy(key + key_size, parts[i], strlen(parts[i]));
+         key_size += strlen(parts[i]);
+      }
+      key_size++;
+   }
+
+   ret = video_shader_driver_get_cache_path(path, size, key, key_size);
+   free(key);
+   return ret;
+}
+
+/* Cache entries hold the fragment and vertex object code, 
+ * each terminated by '\0'. */
+static bool program_cache_load(cg_shader_data_t *cg,
+      unsigned idx, const char *path, const char **argv)
+{
+   ssize_t len;
+   size_t frag_len;
+   const char *end;
+   char *buf = NULL;
+
+   if (!path_file_exists(path))
+      return false;
+
+   if (!read_file(path, (void**)&buf, &len) || len <= 0)
+   {
+      free(buf);
+      return false;
+   }
+
+   end = (const char*)memchr(buf, '\0', len);
+   frag_len = end ? (size_t)(end - buf) : (size_t)len;
+   if (frag_len + 1 >= (size_t)len || buf[len - 1] != '\0')
+   {
+      free(buf);
+      return false;
+   }
+
+   cg->prg[idx].fprg = cgCreateProgram(cg->cgCtx, CG_OBJECT,
+         buf, cg->cgFProf, "main_fragment", argv);
+   cg->prg[idx].vprg = cgCreateProgram(cg->cgCtx, CG_OBJECT,
+         buf + frag_len + 1, cg->cgVProf, "main_vertex", argv);
+   free(buf);
+
+   if (cg->prg[idx].fprg && cg->prg[idx].vprg)
+      return true;
+
+   if (cg->prg[idx].fprg)
+      cgDestroyProgram(cg->prg[idx].fprg);
+   if (cg->prg[idx].vprg)
+      cgDestroyProgram(cg->prg[idx].vprg);
+   cg->prg[idx].fprg = NULL;
+   cg->prg[idx].vprg = NULL;
+   return false;
+}
+
+static void program_cache_save(cg_shader_data_t *cg,
+      unsigned idx, const char *path)
+{
+   char *buf;
+   size_t frag_len, vert_len;
+   const char *frag = cgGetProgramString(cg->prg[idx].fprg,
+         CG_COMPILED_PROGRAM);
+   const char *vert = cgGetProgramString(cg->prg[idx].vprg,
+         CG_COMPILED_PROGRAM);
+
+   if (!frag || !vert || !*frag || !*vert)
+      return;
+
+   frag_len = strlen(frag) + 1;
+   vert_len = strlen(vert) + 1;
+
+   buf = (char*)malloc(frag_len + vert_len);
+   if (!buf)
+      return;
+
+   memcpy(buf, frag, frag_len);
+   memcpy(buf + frag_len, vert, vert_len);
+
+   if (!write_file(path, buf, frag_len + vert_len))
+      RARCH_WARN("Failed to write shader cache: %s.\n", path);
+   free(buf);
+}
+
 static bool load_program(
       cg_shader_data_t *cg,
       unsigned idx,
       const char *prog,
       bool path_is_file)
 {
+   char cache_path[PATH_MAX_LENGTH];
    bool ret = true;
+   bool cache = false;
    char *listing_f = NULL;
    char *listing_v = NULL;
+   char *source    = NULL;
 
    unsigned i, argc = 0;
    const char *argv[2 + GFX_MAX_SHADERS];
@@ -513,6 +650,24 @@ static bool load_program(
    }
    argv[argc] = NULL;
 
+   if (path_is_file)
+   {
+      ssize_t len;
+      if (read_file(prog, (void**)&source, &len))
+         cache = program_cache_path(cg, source, argv,
+               cache_path, sizeof(cache_path));
+      free(source);
+   }
+   else
+      cache = program_cache_path(cg, prog, argv,
+            cache_path, sizeof(cache_path));
+
+   if (cache && program_cache_load(cg, idx, cache_path, argv))
+   {
+      RARCH_LOG("Loaded Cg program #%u from cache.\n", idx);
+      goto load;
+   }
+
    if (path_is_file)
    {
       cg->prg[idx].fprg = cgCreateProgramFromFile(cg->cgCtx, CG_SOURCE,
@@ -544,6 +699,10 @@ static bool load_program(
       goto end;
    }
 
+   if (cache)
+      program_cache_save(cg, idx, cache_path);
+
+load:
    cgGLLoadProgram(cg->prg[idx].fprg);
    cgGLLoadProgram(cg->prg[idx].vprg);
 
@@ -594,6 +753,7 @@ static bool load_plain(cg_shader_data_t *cg, const char *path)
    }
 
    video_shader_resolve_parameters(NULL, cg->cg_shader);
+   video_shader_resolve_dependencies(cg->cg_shader);
    return true;
 }
 
@@ -693,6 +853,7 @@ static bool load_preset(cg_shader_data_t *cg, const char *path)
 
    video_shader_resolve_relative(cg->cg_shader, path);
    video_shader_resolve_parameters(conf, cg->cg_shader);
+   video_shader_resolve_dependencies(cg->cg_shader);
    config_file_free(conf);
 
    if (cg->cg_shader->passes > GFX_MAX_SHADERS - 3)
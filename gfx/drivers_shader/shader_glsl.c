@@ -41,19 +41,41 @@
 
 #define PREV_TEXTURES (MAX_TEXTURES - 1)
 
+#ifdef HAVE_OPENGLES2
+#define glsl_get_program_binary glGetProgramBinaryOES
+#define glsl_program_binary glProgramBinaryOES
+#else
+#define glsl_get_program_binary glGetProgramBinary
+#define glsl_program_binary glProgramBinary
+#endif
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
 
-/* Cache the VBO. */
+/* Cache the VBO. Data which keeps changing from draw to draw 
+ * (menus, overlays) is marked dynamic, and goes to the stream 
+ * VBO instead until it settles. */
 struct cache_vbo
 {
    GLuint vbo_primary;
    GLfloat *buffer_primary;
    size_t size_primary;
+   bool dynamic_primary;
 
    GLuint vbo_secondary;
    GLfloat *buffer_secondary;
    size_t size_secondary;
+   bool dynamic_secondary;
 };
 
+#define GLSL_STREAM_VBO_SIZE (256 * 1024)
+
 struct glsl_attrib
 {
    GLint loc;
@@ -61,6 +83,23 @@ struct glsl_attrib
    GLsizei offset;
 };
 
+/* Last values set on the uniforms of a program, so unchanged 
+ * ones are not uploaded again every frame. Uniform locations are 
+ * small and dense in practice, any beyond the cache are always set. */
+#define GLSL_UNIFORM_CACHE_SIZE 256
+
+struct glsl_uniform_value
+{
+   GLfloat f[2];
+   GLint i;
+   bool valid;
+};
+
+struct glsl_uniform_cache
+{
+   struct glsl_uniform_value value[GLSL_UNIFORM_CACHE_SIZE];
+};
+
 static gfx_ctx_proc_t (*glsl_get_proc_address)(const char*);
 
 struct shader_uniforms_frame
@@ -92,6 +131,12 @@ struct shader_uniforms
    struct shader_uniforms_frame orig;
    struct shader_uniforms_frame pass[GFX_MAX_SHADERS];
    struct shader_uniforms_frame prev[PREV_TEXTURES];
+
+   int parameters[GFX_MAX_PARAMETERS];
+   int state[GFX_MAX_VARIABLES];
+
+   /* Shared by every pass which uses the same program. */
+   struct glsl_uniform_cache *cache;
 };
 
 
@@ -215,6 +260,11 @@ typedef struct glsl_shader_data
    GLuint gl_teximage[GFX_MAX_TEXTURES];
    GLint gl_attribs[PREV_TEXTURES + 1 + 4 + GFX_MAX_SHADERS];
    state_tracker_t *gl_state_tracker;
+   struct glsl_uniform_cache uniform_cache[GFX_MAX_SHADERS];
+
+   /* Ring of vertex data for dynamic draws, orphaned when full. */
+   GLuint stream_vbo;
+   size_t stream_offset;
 } glsl_shader_data_t;
 
 static bool glsl_core;
@@ -367,14 +417,158 @@ static bool link_program(GLuint prog)
    return true;
 }
 
+/**
+ * program_cache_path:
+ * @glsl                 : GLSL shader handle.
+ * @vertex               : Vertex shader source.
+ * @fragment             : Fragment shader source.
+ * @path                 : Path of the cache entry.
+ * @size                 : Size of @path.
+ *
+ * Gets where the binary of a program is cached. Binaries are only 
+ * valid for the exact same driver, so the driver strings are 
+ * hashed along with the sources.
+ *
+ * Returns: true (1) if program binaries can be cached, 
+ * otherwise false (0).
+ **/
+static bool program_cache_path(glsl_shader_data_t *glsl,
+      const char *vertex, const char *fragment,
+      char *path, size_t size)
+{
+   unsigned i;
+   bool ret;
+   char *key;
+   size_t key_size = 0;
+   GLint formats   = 0;
+   const char *parts[6];
+
+   if (!glsl_get_program_binary || !glsl_program_binary)
+      return false;
+
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+   if (formats <= 0)
+      return false;
+
+   parts[0] = (const char*)glGetString(GL_VENDOR);
+   parts[1] = (const char*)glGetString(GL_RENDERER);
+   parts[2] = (const char*)glGetString(GL_VERSION);
+   parts[3] = glsl->glsl_alias_define;
+   parts[4] = vertex;
+   parts[5] = fragment;
+
+   for (i = 0; i < ARRAY_SIZE(parts); i++)
+      key_size += (parts[i] ? strlen(parts[i]) : 0) + 1;
+
+   key = (char*)calloc(key_size, 1);
+   if (!key)
+      return false;
+
+   for (i = 0, key_size = 0; i < ARRAY_SIZE(parts); i++)
+   {
+      if (parts[i])
+      {
+         memcpy(key + key_size, parts[i], strlen(parts[i]));
+         key_size += strlen(parts[i]);
+      }
+      /* Keep the separator, so parts can't run into each other. */
+      key_size++;
+   }
+
+   ret = video_shader_driver_get_cache_path(path, size, key, key_size);
+   free(key);
+   return ret;
+}
+
+/**
+ * program_cache_load:
+ * @prog                 : Program to load the binary into.
+ * @path                 : Path of the cache entry.
+ *
+ * Returns: true (1) if @prog was linked from the cached binary, 
+ * otherwise false (0), e.g. if the driver has been updated since.
+ **/
+static bool program_cache_load(GLuint prog, const char *path)
+{
+   GLint status = GL_FALSE;
+   GLenum format;
+   ssize_t len;
+   uint8_t *buf = NULL;
+
+   if (!path_file_exists(path))
+      return false;
+
+   if (!read_file(path, (void**)&buf, &len) || len <= (ssize_t)sizeof(format))
+   {
+      free(buf);
+      return false;
+   }
+
+   memcpy(&format, buf, sizeof(format));
+   glsl_program_binary(prog, format, buf + sizeof(format),
+         len - sizeof(format));
+   free(buf);
+
+   glGetProgramiv(prog, GL_LINK_STATUS, &status);
+   return status == GL_TRUE;
+}
+
+static void program_cache_save(GLuint prog, const char *path)
+{
+   GLenum format;
+   GLint len  = 0;
+   uint8_t *buf;
+
+   glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &len);
+   if (len <= 0)
+      return;
+
+   buf = (uint8_t*)malloc(sizeof(format) + len);
+   if (!buf)
+      return;
+
+   glsl_get_program_binary(prog, len, NULL, &format, buf + sizeof(format));
+   memcpy(buf, &format, sizeof(format));
+
+   if (!write_file(path, buf, sizeof(format) + len))
+      RARCH_WARN("Failed to write shader cache: %s.\n", path);
+   free(buf);
+}
+
 static GLuint compile_program(glsl_shader_data_t *glsl,
       const char *vertex,
       const char *fragment, unsigned i)
 {
+   char cache_path[PATH_MAX_LENGTH];
+   bool cache = false;
    GLuint vert = 0, frag = 0, prog = glCreateProgram();
    if (!prog)
       return 0;
 
+   if (vertex || fragment)
+   {
+      cache = program_cache_path(glsl, vertex, fragment,
+            cache_path, sizeof(cache_path));
+
+      if (cache && program_cache_load(prog, cache_path))
+      {
+         RARCH_LOG("Loaded GLSL program #%u from cache.\n", i);
+         glUseProgram(prog);
+         glUniform1i(get_uniform(glsl, prog, "Texture"), 0);
+         glUseProgram(0);
+         return prog;
+      }
+
+      /* A failed binary can leave the program unusable. */
+      if (cache)
+      {
+         glDeleteProgram(prog);
+         prog = glCreateProgram();
+         if (!prog)
+            return 0;
+      }
+   }
+
    if (vertex)
    {
       RARCH_LOG("Found GLSL vertex shader.\n");
@@ -421,6 +615,9 @@ static GLuint compile_program(glsl_shader_data_t *glsl,
       if (frag)
          glDeleteShader(frag);
 
+      if (cache)
+         program_cache_save(prog, cache_path);
+
       glUseProgram(prog);
       GLint location = get_uniform(glsl, prog, "Texture");
       glUniform1i(location, 0);
@@ -491,38 +688,85 @@ static void gl_glsl_reset_attrib(glsl_shader_data_t *glsl)
    glsl->gl_attrib_index = 0;
 }
 
-static void gl_glsl_set_vbo(GLfloat **buffer, size_t *buffer_elems,
+static void gl_glsl_cache_vbo(GLfloat **buffer, size_t *buffer_elems,
       const GLfloat *data, size_t elems)
 {
-   if (elems != *buffer_elems || 
-         memcmp(data, *buffer, elems * sizeof(GLfloat)))
+   if (elems > *buffer_elems)
    {
-      if (elems > *buffer_elems)
-      {
-         GLfloat *new_buffer = (GLfloat*)
-            realloc(*buffer, elems * sizeof(GLfloat));
-         rarch_assert(new_buffer);
-         *buffer = new_buffer;
-      }
+      GLfloat *new_buffer = (GLfloat*)
+         realloc(*buffer, elems * sizeof(GLfloat));
+      rarch_assert(new_buffer);
+      *buffer = new_buffer;
+   }
+
+   memcpy(*buffer, data, elems * sizeof(GLfloat));
+   *buffer_elems = elems;
+}
 
-      memcpy(*buffer, data, elems * sizeof(GLfloat));
-      glBufferData(GL_ARRAY_BUFFER, elems * sizeof(GLfloat),
-            data, GL_STATIC_DRAW);
-      *buffer_elems = elems;
+/**
+ * gl_glsl_stream_vbo:
+ * @glsl                 : GLSL shader handle.
+ * @data                 : Vertex data.
+ * @size                 : Size of @data in bytes.
+ *
+ * Appends @data to the stream VBO, which is left bound. 
+ * Once it is full, it is orphaned rather than overwritten, 
+ * so draws still reading from it never stall the upload.
+ *
+ * Returns: offset of @data in the stream VBO.
+ **/
+static size_t gl_glsl_stream_vbo(glsl_shader_data_t *glsl,
+      const GLfloat *data, size_t size)
+{
+   size_t offset;
+
+   glBindBuffer(GL_ARRAY_BUFFER, glsl->stream_vbo);
+
+   if (glsl->stream_offset + size > GLSL_STREAM_VBO_SIZE)
+   {
+      glBufferData(GL_ARRAY_BUFFER, GLSL_STREAM_VBO_SIZE,
+            NULL, GL_STREAM_DRAW);
+      glsl->stream_offset = 0;
    }
+
+   offset = glsl->stream_offset;
+   glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+   glsl->stream_offset += (size + 15) & ~(size_t)15;
+
+   return offset;
 }
 
 static void gl_glsl_set_attribs(glsl_shader_data_t *glsl,
       GLuint vbo,
-      GLfloat **buffer, size_t *buffer_elems,
+      GLfloat **buffer, size_t *buffer_elems, bool *dynamic,
       const GLfloat *data, size_t elems,
       const struct glsl_attrib *attrs, size_t num_attrs)
 {
-   size_t i;
+   size_t i, base = 0;
+   size_t size  = elems * sizeof(GLfloat);
+   bool changed = elems != *buffer_elems || 
+      memcmp(data, *buffer, size);
 
-   glBindBuffer(GL_ARRAY_BUFFER, vbo);
+   if (changed && *dynamic && size <= GLSL_STREAM_VBO_SIZE)
+   {
+      /* Redefining the VBO for every draw makes the driver 
+       * wait for, or copy, the previous contents. */
+      base = gl_glsl_stream_vbo(glsl, data, size);
+      gl_glsl_cache_vbo(buffer, buffer_elems, data, elems);
+   }
+   else
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-   gl_glsl_set_vbo(buffer, buffer_elems, data, elems);
+      /* Dynamic data which stayed the same since the last 
+       * draw is only in the stream VBO so far. */
+      if (changed || *dynamic)
+      {
+         gl_glsl_cache_vbo(buffer, buffer_elems, data, elems);
+         glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+      }
+      *dynamic = changed;
+   }
 
    for (i = 0; i < num_attrs; i++)
    {
@@ -532,7 +776,7 @@ static void gl_glsl_set_attribs(glsl_shader_data_t *glsl,
       {
          glEnableVertexAttribArray(loc);
          glVertexAttribPointer(loc, attrs[i].size, GL_FLOAT, GL_FALSE, 0,
-               (const GLvoid*)(uintptr_t)attrs[i].offset);
+               (const GLvoid*)(uintptr_t)(base + attrs[i].offset));
          glsl->gl_attribs[glsl->gl_attrib_index++] = loc;
       }
       else
@@ -626,6 +870,14 @@ static void find_uniforms(glsl_shader_data_t *glsl,
       find_uniforms_frame(glsl, prog, &uni->prev[i], frame_base);
    }
 
+   for (i = 0; i < glsl->glsl_shader->num_parameters; i++)
+      uni->parameters[i] = glGetUniformLocation(prog,
+            glsl->glsl_shader->parameters[i].id);
+
+   for (i = 0; i < glsl->glsl_shader->variables; i++)
+      uni->state[i] = glGetUniformLocation(prog,
+            glsl->glsl_shader->variable[i].id);
+
    glUseProgram(0);
 }
 
@@ -689,6 +941,10 @@ static void gl_glsl_destroy_resources(glsl_shader_data_t *glsl)
       free(glsl->glsl_vbo[i].buffer_secondary);
    }
    memset(&glsl->glsl_vbo, 0, sizeof(glsl->glsl_vbo));
+
+   if (glsl->stream_vbo)
+      glDeleteBuffers(1, &glsl->stream_vbo);
+   glsl->stream_vbo = 0;
 }
 
 static void gl_glsl_deinit(void)
@@ -706,21 +962,40 @@ static void gl_glsl_deinit(void)
    driver->video_shader_data = NULL;
 }
 
-static bool gl_glsl_init(void *data, const char *path)
+static void gl_glsl_free_compiled(void *shader_data)
+{
+   glsl_shader_data_t *glsl = (glsl_shader_data_t*)shader_data;
+
+   if (!glsl)
+      return;
+
+   gl_glsl_destroy_resources(glsl);
+   free(glsl);
+}
+
+static void gl_glsl_init_compiled(void *data, void *shader_data)
+{
+   driver_t *driver = driver_get_ptr();
+
+   (void)data;
+
+   driver->video_shader_data = shader_data;
+}
+
+static void *gl_glsl_compile(void *data, const char *path)
 {
    unsigned i;
    config_file_t *conf        = NULL;
    glsl_shader_data_t *glsl   = NULL;
    const char *stock_vertex   = NULL;
    const char *stock_fragment = NULL;
-   driver_t *driver = driver_get_ptr();
 
    (void)data;
 
    glsl = (glsl_shader_data_t*)calloc(1, sizeof(glsl_shader_data_t));
 
    if (!glsl)
-      return false;
+      return NULL;
 
 #ifndef HAVE_OPENGLES2
    RARCH_LOG("Checking GLSL shader support ...\n");
@@ -741,7 +1016,7 @@ static bool gl_glsl_init(void *data, const char *path)
    {
       RARCH_ERR("GLSL shaders aren't supported by your OpenGL driver.\n");
       free(glsl);
-      return false;
+      return NULL;
    }
 #endif
 
@@ -749,7 +1024,7 @@ static bool gl_glsl_init(void *data, const char *path)
    if (!glsl->glsl_shader)
    {
       free(glsl);
-      return false;
+      return NULL;
    }
 
    if (path)
@@ -782,7 +1057,7 @@ static bool gl_glsl_init(void *data, const char *path)
          RARCH_ERR("[GL]: Failed to parse GLSL shader.\n");
          free(glsl->glsl_shader);
          free(glsl);
-         return false;
+         return NULL;
       }
    }
    else
@@ -798,6 +1073,7 @@ static bool gl_glsl_init(void *data, const char *path)
 
    video_shader_resolve_relative(glsl->glsl_shader, path);
    video_shader_resolve_parameters(conf, glsl->glsl_shader);
+   video_shader_resolve_dependencies(glsl->glsl_shader);
 
    if (conf)
    {
@@ -860,7 +1136,10 @@ static bool gl_glsl_init(void *data, const char *path)
    }
 
    for (i = 0; i <= glsl->glsl_shader->passes; i++)
+   {
       find_uniforms(glsl, i, glsl->gl_program[i], &glsl->gl_uniforms[i]);
+      glsl->gl_uniforms[i].cache = &glsl->uniform_cache[i];
+   }
 
 #ifdef GLSL_DEBUG
    if (!gl_check_error())
@@ -900,6 +1179,8 @@ static bool gl_glsl_init(void *data, const char *path)
             GL_SHADER_STOCK_BLEND);
       find_uniforms(glsl, 0, glsl->gl_program[GL_SHADER_STOCK_BLEND],
             &glsl->gl_uniforms[GL_SHADER_STOCK_BLEND]);
+      glsl->gl_uniforms[GL_SHADER_STOCK_BLEND].cache =
+         &glsl->uniform_cache[GL_SHADER_STOCK_BLEND];
    }
    else
    {
@@ -915,17 +1196,97 @@ static bool gl_glsl_init(void *data, const char *path)
       glGenBuffers(1, &glsl->glsl_vbo[i].vbo_secondary);
    }
 
-   driver->video_shader_data = glsl;
+   glGenBuffers(1, &glsl->stream_vbo);
+   glBindBuffer(GL_ARRAY_BUFFER, glsl->stream_vbo);
+   glBufferData(GL_ARRAY_BUFFER, GLSL_STREAM_VBO_SIZE, NULL, GL_STREAM_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-   return true;
+   return glsl;
 
 error:
-   gl_glsl_destroy_resources(glsl);
+   gl_glsl_free_compiled(glsl);
+   return NULL;
+}
 
-   if (glsl)
-      free(glsl);
+static bool gl_glsl_init(void *data, const char *path)
+{
+   void *glsl = gl_glsl_compile(data, path);
 
-   return false;
+   if (!glsl)
+      return false;
+
+   gl_glsl_init_compiled(data, glsl);
+   return true;
+}
+
+static INLINE struct glsl_uniform_value *gl_glsl_uniform_value(
+      const struct shader_uniforms *uni, GLint loc)
+{
+   if (!uni->cache || loc >= GLSL_UNIFORM_CACHE_SIZE)
+      return NULL;
+   return &uni->cache->value[loc];
+}
+
+static INLINE void gl_glsl_uniform1i(const struct shader_uniforms *uni,
+      GLint loc, GLint value)
+{
+   struct glsl_uniform_value *cached = NULL;
+
+   if (loc < 0)
+      return;
+
+   cached = gl_glsl_uniform_value(uni, loc);
+   if (cached)
+   {
+      if (cached->valid && cached->i == value)
+         return;
+      cached->i     = value;
+      cached->valid = true;
+   }
+
+   glUniform1i(loc, value);
+}
+
+static INLINE void gl_glsl_uniform1f(const struct shader_uniforms *uni,
+      GLint loc, GLfloat value)
+{
+   struct glsl_uniform_value *cached = NULL;
+
+   if (loc < 0)
+      return;
+
+   cached = gl_glsl_uniform_value(uni, loc);
+   if (cached)
+   {
+      if (cached->valid && cached->f[0] == value)
+         return;
+      cached->f[0]  = value;
+      cached->valid = true;
+   }
+
+   glUniform1f(loc, value);
+}
+
+static INLINE void gl_glsl_uniform2fv(const struct shader_uniforms *uni,
+      GLint loc, const GLfloat *value)
+{
+   struct glsl_uniform_value *cached = NULL;
+
+   if (loc < 0)
+      return;
+
+   cached = gl_glsl_uniform_value(uni, loc);
+   if (cached)
+   {
+      if (cached->valid && cached->f[0] == value[0]
+            && cached->f[1] == value[1])
+         return;
+      cached->f[0]  = value[0];
+      cached->f[1]  = value[1];
+      cached->valid = true;
+   }
+
+   glUniform2fv(loc, 1, value);
 }
 
 static void gl_glsl_set_params(void *data, unsigned width, unsigned height, 
@@ -967,14 +1328,9 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
    texture_size[0] = (float)tex_width;
    texture_size[1] = (float)tex_height;
 
-   if (uni->input_size >= 0)
-      glUniform2fv(uni->input_size, 1, input_size);
-
-   if (uni->output_size >= 0)
-      glUniform2fv(uni->output_size, 1, output_size);
-
-   if (uni->texture_size >= 0)
-      glUniform2fv(uni->texture_size, 1, texture_size);
+   gl_glsl_uniform2fv(uni, uni->input_size, input_size);
+   gl_glsl_uniform2fv(uni, uni->output_size, output_size);
+   gl_glsl_uniform2fv(uni, uni->texture_size, texture_size);
 
    if (uni->frame_count >= 0 && glsl->glsl_active_index)
    {
@@ -982,11 +1338,11 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
 
       if (modulo)
          frame_count %= modulo;
-      glUniform1i(uni->frame_count, frame_count);
+      gl_glsl_uniform1i(uni, uni->frame_count, frame_count);
    }
 
-   if (uni->frame_direction >= 0)
-      glUniform1i(uni->frame_direction, global->rewind.frame_is_reverse ? -1 : 1);
+   gl_glsl_uniform1i(uni, uni->frame_direction,
+         global->rewind.frame_is_reverse ? -1 : 1);
 
 
    for (i = 0; i < glsl->glsl_shader->luts; i++)
@@ -997,7 +1353,7 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
       /* Have to rebind as HW render could override this. */
       glActiveTexture(GL_TEXTURE0 + texunit);
       glBindTexture(GL_TEXTURE_2D, glsl->gl_teximage[i]);
-      glUniform1i(uni->lut_texture[i], texunit);
+      gl_glsl_uniform1i(uni, uni->lut_texture[i], texunit);
       texunit++;
    }
 
@@ -1008,16 +1364,13 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
       {
          /* Bind original texture. */
          glActiveTexture(GL_TEXTURE0 + texunit);
-         glUniform1i(uni->orig.texture, texunit);
+         gl_glsl_uniform1i(uni, uni->orig.texture, texunit);
          glBindTexture(GL_TEXTURE_2D, info->tex);
          texunit++;
       }
 
-      if (uni->orig.texture_size >= 0)
-         glUniform2fv(uni->orig.texture_size, 1, info->tex_size);
-
-      if (uni->orig.input_size >= 0)
-         glUniform2fv(uni->orig.input_size, 1, info->input_size);
+      gl_glsl_uniform2fv(uni, uni->orig.texture_size, info->tex_size);
+      gl_glsl_uniform2fv(uni, uni->orig.input_size, info->input_size);
 
       /* Pass texture coordinates. */
       if (uni->orig.tex_coord >= 0)
@@ -1039,15 +1392,14 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
          {
             glActiveTexture(GL_TEXTURE0 + texunit);
             glBindTexture(GL_TEXTURE_2D, fbo_info[i].tex);
-            glUniform1i(uni->pass[i].texture, texunit);
+            gl_glsl_uniform1i(uni, uni->pass[i].texture, texunit);
             texunit++;
          }
 
-         if (uni->pass[i].texture_size >= 0)
-            glUniform2fv(uni->pass[i].texture_size, 1, fbo_info[i].tex_size);
-
-         if (uni->pass[i].input_size >= 0)
-            glUniform2fv(uni->pass[i].input_size, 1, fbo_info[i].input_size);
+         gl_glsl_uniform2fv(uni, uni->pass[i].texture_size,
+               fbo_info[i].tex_size);
+         gl_glsl_uniform2fv(uni, uni->pass[i].input_size,
+               fbo_info[i].input_size);
 
          if (uni->pass[i].tex_coord >= 0)
          {
@@ -1070,15 +1422,14 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
       {
          glActiveTexture(GL_TEXTURE0 + texunit);
          glBindTexture(GL_TEXTURE_2D, prev_info[i].tex);
-         glUniform1i(uni->prev[i].texture, texunit);
+         gl_glsl_uniform1i(uni, uni->prev[i].texture, texunit);
          texunit++;
       }
 
-      if (uni->prev[i].texture_size >= 0)
-         glUniform2fv(uni->prev[i].texture_size, 1, prev_info[i].tex_size);
-
-      if (uni->prev[i].input_size >= 0)
-         glUniform2fv(uni->prev[i].input_size, 1, prev_info[i].input_size);
+      gl_glsl_uniform2fv(uni, uni->prev[i].texture_size,
+            prev_info[i].tex_size);
+      gl_glsl_uniform2fv(uni, uni->prev[i].input_size,
+            prev_info[i].input_size);
 
       /* Pass texture coordinates. */
       if (uni->prev[i].tex_coord >= 0)
@@ -1099,6 +1450,7 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
       gl_glsl_set_attribs(glsl, glsl->glsl_vbo[glsl->glsl_active_index].vbo_secondary,
             &glsl->glsl_vbo[glsl->glsl_active_index].buffer_secondary,
             &glsl->glsl_vbo[glsl->glsl_active_index].size_secondary,
+            &glsl->glsl_vbo[glsl->glsl_active_index].dynamic_secondary,
             buffer, size, attribs, attribs_size);
    }
 
@@ -1106,12 +1458,8 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
 
    /* #pragma parameters. */
    for (i = 0; i < glsl->glsl_shader->num_parameters; i++)
-   {
-      int location = glGetUniformLocation(
-            glsl->gl_program[glsl->glsl_active_index],
-            glsl->glsl_shader->parameters[i].id);
-      glUniform1f(location, glsl->glsl_shader->parameters[i].current);
-   }
+      gl_glsl_uniform1f(uni, uni->parameters[i],
+            glsl->glsl_shader->parameters[i].current);
 
    /* Set state parameters. */
    if (glsl->gl_state_tracker)
@@ -1124,12 +1472,7 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
                GFX_MAX_VARIABLES, frame_count);
 
       for (i = 0; i < cnt; i++)
-      {
-         int location = glGetUniformLocation(
-               glsl->gl_program[glsl->glsl_active_index],
-               state_info[i].id);
-         glUniform1f(location, state_info[i].value);
-      }
+         gl_glsl_uniform1f(uni, uni->state[i], state_info[i].value);
    }
 }
 
@@ -1245,6 +1588,7 @@ static bool gl_glsl_set_coords(const void *data)
             glsl->glsl_vbo[glsl->glsl_active_index].vbo_primary,
             &glsl->glsl_vbo[glsl->glsl_active_index].buffer_primary,
             &glsl->glsl_vbo[glsl->glsl_active_index].size_primary,
+            &glsl->glsl_vbo[glsl->glsl_active_index].dynamic_primary,
             buffer, size,
             attribs, attribs_size);
    }
@@ -1378,6 +1722,10 @@ const shader_backend_t gl_glsl_backend = {
    gl_glsl_get_current_shader,
 
    RARCH_SHADER_GLSL,
-   "glsl"
+   "glsl",
+
+   gl_glsl_compile,
+   gl_glsl_init_compiled,
+   gl_glsl_free_compiled,
 };
 
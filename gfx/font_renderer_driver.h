@@ -57,6 +57,10 @@ struct font_atlas
    uint8_t *buffer; /* Alpha channel. */
    unsigned width;
    unsigned height;
+
+   /* Bumped whenever glyphs are added to the buffer, which
+    * get_glyph() may do for glyphs it hasn't seen before. */
+   unsigned version;
 };
 
 typedef struct font_renderer
@@ -23,10 +23,14 @@
 #include <formats/rpng.h>
 #endif
 #include <formats/tga.h>
+#include <formats/rktx.h>
+#include <file/file_path.h>
 #ifdef _XBOX1
 #include "../d3d/d3d_wrapper.h"
 #endif
 #include "../../file_ops.h"
+#include "../video_work_pool.h"
+#include "../video_texture.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -159,6 +163,8 @@ void texture_image_free(struct texture_image *img)
 #endif
    if (img->pixels)
       free(img->pixels);
+   if (img->compressed)
+      free(img->compressed);
    memset(img, 0, sizeof(*img));
 }
 
@@ -423,3 +429,126 @@ bool texture_image_load(struct texture_image *out_img, const char *path)
    return ret;
 }
 #endif
+
+#if !defined(_XBOX1) && !defined(__CELLOS_LV2__)
+static bool texture_image_load_ktx(struct texture_image *out_img,
+      const char *path)
+{
+   struct rktx ktx;
+   void *buf = NULL;
+   ssize_t len;
+
+   if (!read_file(path, &buf, &len) || len <= 0)
+   {
+      RARCH_ERR("Failed to read image: %s.\n", path);
+      free(buf);
+      return false;
+   }
+
+   if (!rktx_parse(&ktx, (const uint8_t*)buf, len))
+   {
+      RARCH_ERR("Invalid KTX texture: %s.\n", path);
+      free(buf);
+      return false;
+   }
+
+   if (!video_texture_compressed_supported(ktx.internal_format))
+   {
+      RARCH_LOG("Texture format 0x%x of %s is not supported by the GPU.\n",
+            ktx.internal_format, path);
+      free(buf);
+      return false;
+   }
+
+   out_img->width           = ktx.width;
+   out_img->height          = ktx.height;
+   out_img->pixels          = NULL;
+   out_img->compressed      = buf;
+   out_img->compressed_size = len;
+
+   return true;
+}
+#endif
+
+bool texture_image_load_compressed(struct texture_image *out_img,
+      const char *path)
+{
+#if !defined(_XBOX1) && !defined(__CELLOS_LV2__)
+   char ktx_path[PATH_MAX_LENGTH];
+
+   fill_pathname(ktx_path, path, ".ktx", sizeof(ktx_path));
+
+   if (strcmp(ktx_path, path) != 0 && path_file_exists(ktx_path)
+         && texture_image_load_ktx(out_img, ktx_path))
+      return true;
+#endif
+
+   return texture_image_load(out_img, path);
+}
+
+struct texture_image_batch
+{
+   struct texture_image *imgs;
+   const char * const *paths;
+   bool *loaded;
+   bool compressed;
+};
+
+static void texture_image_load_batch_work(void *userdata,
+      unsigned index, unsigned thread)
+{
+   struct texture_image_batch *batch = (struct texture_image_batch*)userdata;
+
+   (void)thread;
+
+   memset(&batch->imgs[index], 0, sizeof(batch->imgs[index]));
+
+   if (!batch->paths[index])
+      return;
+
+   if (batch->compressed)
+      batch->loaded[index] = texture_image_load_compressed(
+            &batch->imgs[index], batch->paths[index]);
+   else
+      batch->loaded[index] = texture_image_load(&batch->imgs[index],
+            batch->paths[index]);
+}
+
+unsigned texture_image_load_batch(struct texture_image *imgs,
+      const char * const *paths, unsigned count, bool compressed)
+{
+   unsigned i;
+   unsigned loaded_count = 0;
+   struct texture_image_batch batch;
+   bool *loaded = (bool*)calloc(count ? count : 1, sizeof(*loaded));
+
+   if (!loaded)
+      return 0;
+
+   batch.imgs   = imgs;
+   batch.paths  = paths;
+   batch.loaded = loaded;
+   batch.compressed = compressed;
+
+#if defined(_XBOX1) || defined(__CELLOS_LV2__)
+   /* These loaders go through the GPU or system decoders,
+    * which can't be called from several threads. */
+   for (i = 0; i < count; i++)
+      texture_image_load_batch_work(&batch, i, 0);
+#else
+   video_work_pool_init();
+   video_work_pool_run(texture_image_load_batch_work, &batch, count);
+   video_work_pool_deinit();
+#endif
+
+   for (i = 0; i < count; i++)
+   {
+      if (loaded[i])
+         loaded_count++;
+      else
+         texture_image_free(&imgs[i]);
+   }
+
+   free(loaded);
+   return loaded_count;
+}
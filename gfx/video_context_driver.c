@@ -16,6 +16,7 @@
 
 #include "../general.h"
 #include "video_context_driver.h"
+#include "../input/input_latency.h"
 #include <string.h>
 
 #ifdef HAVE_CONFIG_H
@@ -138,6 +139,8 @@ void gfx_ctx_swap_buffers(void *data)
    
    if (ctx->swap_buffers)
       ctx->swap_buffers(data);
+
+   input_latency_swap();
 }
 
 void gfx_ctx_bind_hw_render(void *data, bool enable)
@@ -148,6 +151,24 @@ void gfx_ctx_bind_hw_render(void *data, bool enable)
       ctx->bind_hw_render(data, enable);
 }
 
+bool gfx_ctx_bind_shared_context(void *data, bool enable)
+{
+   const gfx_ctx_driver_t *ctx = gfx_ctx_get_ptr();
+
+   if (ctx && ctx->bind_shared_context)
+      return ctx->bind_shared_context(data, enable);
+   return false;
+}
+
+bool gfx_ctx_bind_hw_render_thread(void *data, bool enable)
+{
+   const gfx_ctx_driver_t *ctx = gfx_ctx_get_ptr();
+
+   if (ctx && ctx->bind_hw_render_thread)
+      return ctx->bind_hw_render_thread(data, enable);
+   return false;
+}
+
 bool gfx_ctx_focus(void *data)
 {
    const gfx_ctx_driver_t *ctx = gfx_ctx_get_ptr();
@@ -366,8 +387,6 @@ static const gfx_ctx_driver_t *gfx_ctx_init(void *data,
       enum gfx_ctx_api api, unsigned major,
       unsigned minor, bool hw_render_ctx)
 {
-   settings_t *settings = config_get_ptr();
-
    if (ctx->bind_api(data, api, major, minor))
    {
       bool initialized = ctx->init(data);
@@ -376,8 +395,7 @@ static const gfx_ctx_driver_t *gfx_ctx_init(void *data,
          return NULL;
 
       if (ctx->bind_hw_render)
-         ctx->bind_hw_render(data,
-               settings->video.shared_context && hw_render_ctx);
+         ctx->bind_hw_render(data, hw_render_ctx);
 
       return ctx;
    }
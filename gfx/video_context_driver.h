@@ -148,6 +148,18 @@ typedef struct gfx_ctx_driver
 
    /* Optional. Binds HW-render offscreen context. */
    void (*bind_hw_render)(void *data, bool enable);
+
+   /* Optional. Makes an offscreen context sharing objects with the 
+    * main context current on the calling thread, or releases it.
+    * Meant for worker threads, e.g. to compile shaders without 
+    * stalling rendering. Returns false if not supported. */
+   bool (*bind_shared_context)(void *data, bool enable);
+
+   /* Optional. Makes the HW-render context current on the calling
+    * thread, or releases it, for cores running on another thread
+    * than the one rendering to the window. Returns false if not
+    * supported. */
+   bool (*bind_hw_render_thread)(void *data, bool enable);
 } gfx_ctx_driver_t;
 
 extern const gfx_ctx_driver_t gfx_ctx_sdl_gl;
@@ -236,6 +248,10 @@ void gfx_ctx_swap_interval(void *data, unsigned interval);
 
 void gfx_ctx_bind_hw_render(void *data, bool enable);
 
+bool gfx_ctx_bind_shared_context(void *data, bool enable);
+
+bool gfx_ctx_bind_hw_render_thread(void *data, bool enable);
+
 void gfx_ctx_get_video_output_size(void *data,
       unsigned *width, unsigned *height);
 
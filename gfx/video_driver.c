@@ -23,6 +23,7 @@
 #include "../general.h"
 #include "../retroarch.h"
 #include "../runloop.h"
+#include "../performance.h"
 
 static const video_driver_t *video_drivers[] = {
 #ifdef HAVE_OPENGL
@@ -148,6 +149,9 @@ const char* config_get_video_driver_options(void)
    return options;
 }
 
+/* Set while the video driver runs behind the threaded wrapper. */
+static bool video_driver_threaded;
+
 void find_video_driver(void)
 {
    int i;
@@ -196,6 +200,11 @@ void find_video_driver(void)
    }
 }
 
+bool video_driver_is_threaded(void)
+{
+   return video_driver_threaded;
+}
+
 /**
  * video_driver_get_ptr:
  * @drv                : real video driver will be set to this.
@@ -208,12 +217,9 @@ void find_video_driver(void)
 void *video_driver_get_ptr(const video_driver_t **drv)
 {
    driver_t *driver     = driver_get_ptr();
-   global_t *global     = global_get_ptr();
-   settings_t *settings = config_get_ptr();
 
 #ifdef HAVE_THREADS
-   if (settings->video.threaded
-         && !global->system.hw_render_callback.context_type)
+   if (video_driver_threaded)
       return rarch_threaded_video_get_ptr(drv);
 #endif
    if (drv)
@@ -268,6 +274,99 @@ retro_proc_address_t video_driver_get_proc_address(const char *sym)
    return NULL;
 }
 
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *framebuffer)
+{
+   driver_t                   *driver = driver_get_ptr();
+   global_t                   *global = global_get_ptr();
+   const video_poke_interface_t *poke = video_driver_get_poke_ptr();
+
+   if (!framebuffer || !driver->video_data)
+      return false;
+
+   /* Frames that are converted or filtered first 
+    * never reach the driver as the core rendered them. */
+   if (global->system.pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555 
+         || global->filter.filter)
+      return false;
+
+   if (poke && poke->get_current_software_framebuffer)
+      return poke->get_current_software_framebuffer(
+            driver->video_data, framebuffer);
+   return false;
+}
+
+/* Frames on time before trying one less frame in flight, 
+ * doubled every time that fails. */
+#define HARD_SYNC_CALM_FRAMES 300
+#define HARD_SYNC_CALM_FRAMES_MAX 9600
+
+unsigned video_hard_sync_get_frames(video_hard_sync_t *sync)
+{
+   settings_t *settings = config_get_ptr();
+   unsigned target      = settings->video.hard_sync_frames;
+
+   if (!settings->video.hard_sync_adaptive)
+      return target;
+
+   if (sync->frames < target)
+      sync->frames = target;
+   return sync->frames;
+}
+
+void video_hard_sync_update(video_hard_sync_t *sync, retro_time_t stall)
+{
+   retro_time_t period, interval;
+   settings_t *settings = config_get_ptr();
+   driver_t     *driver = driver_get_ptr();
+   retro_time_t    now  = rarch_get_time_usec();
+
+   interval        = now - sync->last_time;
+   sync->last_time = now;
+
+   if (!settings->video.hard_sync_adaptive || driver->nonblock_state
+         || settings->video.refresh_rate <= 0.0f || interval == now)
+      return;
+
+   if (!sync->calm_needed)
+      sync->calm_needed = HARD_SYNC_CALM_FRAMES;
+
+   period = (retro_time_t)(1000000.0f * settings->video.swap_interval 
+         / settings->video.refresh_rate);
+
+   /* Missed VSync. Only running further ahead helps if we 
+    * spent a good part of the frame waiting on the GPU, 
+    * otherwise the core itself is too slow. */
+   if (interval > period + period / 2)
+   {
+      if (stall > period / 4 && sync->frames < VIDEO_HARD_SYNC_MAX_FRAMES)
+      {
+         sync->frames++;
+         RARCH_LOG("Hard GPU sync: %u frames in flight.\n", sync->frames);
+
+         /* Lowering the frame count didn't stick, 
+          * wait longer before the next try. */
+         if (sync->lowered && sync->calm_needed < HARD_SYNC_CALM_FRAMES_MAX)
+            sync->calm_needed *= 2;
+      }
+      sync->lowered     = false;
+      sync->calm_frames = 0;
+      return;
+   }
+
+   if (++sync->calm_frames < sync->calm_needed)
+      return;
+
+   sync->calm_frames = 0;
+   sync->lowered     = false;
+   if (sync->frames > settings->video.hard_sync_frames)
+   {
+      sync->frames--;
+      sync->lowered = true;
+      RARCH_LOG("Hard GPU sync: %u frames in flight.\n", sync->frames);
+   }
+}
+
 bool video_driver_is_alive(void)
 {
    driver_t *driver = driver_get_ptr();
@@ -413,7 +512,10 @@ void uninit_video_input(void)
          driver->video_data &&
          driver->video &&
          driver->video->free)
+   {
       driver->video->free(driver->video_data);
+      video_driver_threaded = false;
+   }
 
    deinit_pixel_converter();
 
@@ -522,20 +624,37 @@ void init_video(void)
    find_video_driver();
 
 #ifdef HAVE_THREADS
-   if (settings->video.threaded && !global->system.hw_render_callback.context_type)
+   video_driver_threaded = false;
+
+   if (settings->video.threaded)
    {
-      /* Can't do hardware rendering with threaded driver currently. */
+      /* Hardware rendering cores keep running on this thread,
+       * rendering with a context of their own. */
+      video.hw_render_threaded =
+         global->system.hw_render_callback.context_type
+         != RETRO_HW_CONTEXT_NONE;
+
       RARCH_LOG("Starting threaded video driver ...\n");
 
-      if (!rarch_threaded_video_init(&driver->video, &driver->video_data,
-               &driver->input, &driver->input_data,
-               driver->video, &video))
+      video_driver_threaded = rarch_threaded_video_init(
+            &driver->video, &driver->video_data,
+            &driver->input, &driver->input_data,
+            driver->video, &video);
+
+      if (!video_driver_threaded && !video.hw_render_threaded)
       {
          RARCH_ERR("Cannot open threaded video driver ... Exiting ...\n");
          rarch_fail(1, "init_video()");
       }
+
+      if (!video_driver_threaded)
+      {
+         RARCH_WARN("Threaded video can't be used with this hardware rendering core here, falling back to regular video driver.\n");
+         video.hw_render_threaded = false;
+      }
    }
-   else
+
+   if (!video_driver_threaded)
 #endif
       driver->video_data = driver->video->init(&video, &driver->input,
             &driver->input_data);
@@ -571,6 +690,8 @@ void init_video(void)
    event_command(EVENT_CMD_OVERLAY_INIT);
 
    runloop->measure_data.frame_time_samples_count = 0;
+   runloop->measure_data.frame_time_presented     = false;
+   video_monitor_frame_time_reset();
 
    global->frame_cache.width  = 4;
    global->frame_cache.height = 4;
@@ -722,6 +843,26 @@ bool video_driver_read_viewport(uint8_t *buffer)
    return false;
 }
 
+bool video_driver_init_viewport_yuv420(unsigned width, unsigned height)
+{
+   driver_t                   *driver = driver_get_ptr();
+   const video_poke_interface_t *poke = video_driver_get_poke_ptr();
+
+   if (poke && poke->init_viewport_yuv420)
+      return poke->init_viewport_yuv420(driver->video_data, width, height);
+   return false;
+}
+
+bool video_driver_read_viewport_yuv420(uint8_t *buffer)
+{
+   driver_t                   *driver = driver_get_ptr();
+   const video_poke_interface_t *poke = video_driver_get_poke_ptr();
+
+   if (poke && poke->read_viewport_yuv420)
+      return poke->read_viewport_yuv420(driver->video_data, buffer);
+   return false;
+}
+
 bool video_driver_focus(void)
 {
    driver_t            *driver = driver_get_ptr();
@@ -55,6 +55,9 @@ typedef struct video_info
    unsigned input_scale;
    /* Use 32bit RGBA rather than native XBGR1555. */
    bool rgb32;
+   /* The core renders on another thread than the one calling
+    * frame(), see poke bind_hw_render_thread. */
+   bool hw_render_threaded;
 } video_info_t;
 
   enum text_alignment
@@ -127,6 +130,34 @@ typedef struct video_poke_interface
    void (*grab_mouse_toggle)(void *data);
 
    struct video_shader *(*get_current_shader)(void *data);
+
+   /* Framebuffer for the core to render the next frame to. */
+   bool (*get_current_software_framebuffer)(void *data,
+         struct retro_framebuffer *framebuffer);
+
+   /* Switches readbacks to planar YUV 4:2:0 (I420), scaled 
+    * to width x height, and returns whether the driver could. */
+   bool (*init_viewport_yuv420)(void *data,
+         unsigned width, unsigned height);
+   /* Reads back the viewport as set up by init_viewport_yuv420,
+    * top row first. */
+   bool (*read_viewport_yuv420)(void *data, uint8_t *buffer);
+
+   /* For hardware rendering cores running on another thread than
+    * the one calling frame(), as with threaded video. Called on the
+    * core's thread: makes its context current there, or releases it.
+    * Returns false if the driver can't do this. */
+   bool (*bind_hw_render_thread)(void *data, bool enable);
+   /* Called on the core's thread. Returns the framebuffer rendering
+    * to texture @index, or 0. */
+   uintptr_t (*get_hw_render_framebuffer)(void *data, unsigned index);
+   /* Called on the core's thread once it rendered a frame. Deletes
+    * @prev, a fence nothing waited on, and returns a fence for
+    * set_hw_render_frame(), or NULL if rendering finished already. */
+   void *(*hw_render_fence)(void *data, void *prev);
+   /* Makes the next frame() show texture @index,
+    * once @fence (if not NULL) signaled, and deletes @fence. */
+   void (*set_hw_render_frame)(void *data, unsigned index, void *fence);
 } video_poke_interface_t;
 
 typedef struct video_driver
@@ -257,6 +288,14 @@ void find_video_driver(void);
  **/
 void *video_driver_get_ptr(const video_driver_t **drv);
 
+/**
+ * video_driver_is_threaded:
+ *
+ * Returns: true (1) if the video driver runs on its own thread,
+ * behind the threaded video wrapper, otherwise false (0).
+ **/
+bool video_driver_is_threaded(void);
+
 /**
  * video_driver_get_current_framebuffer:
  *
@@ -269,6 +308,61 @@ uintptr_t video_driver_get_current_framebuffer(void);
 
 retro_proc_address_t video_driver_get_proc_address(const char *sym);
 
+/**
+ * video_driver_get_current_software_framebuffer:
+ * @framebuffer          : framebuffer the core asks for.
+ *
+ * Gets memory for the core to render the next frame to, 
+ * which saves copying the frame.
+ * Used by RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+ *
+ * Returns: true (1) if @framebuffer was set up, otherwise false (0).
+ **/
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *framebuffer);
+
+/* Most frames the CPU may run ahead of the GPU with hard sync. */
+#define VIDEO_HARD_SYNC_MAX_FRAMES 3
+
+typedef struct video_hard_sync
+{
+   /* Frames the CPU may currently run ahead of the GPU. */
+   unsigned frames;
+   /* Frames in a row presented on time. */
+   unsigned calm_frames;
+   /* Calm frames needed before trying fewer frames again. */
+   unsigned calm_needed;
+   /* The frame count was just lowered. */
+   bool lowered;
+   retro_time_t last_time;
+} video_hard_sync_t;
+
+/**
+ * video_hard_sync_get_frames:
+ * @sync                 : hard sync state of the driver.
+ *
+ * Gets how many frames the CPU may run ahead of the GPU 
+ * before the driver waits on the oldest frame. With 
+ * video_hard_sync_adaptive, this moves between 
+ * video_hard_sync_frames and VIDEO_HARD_SYNC_MAX_FRAMES.
+ *
+ * Returns: number of frames.
+ **/
+unsigned video_hard_sync_get_frames(video_hard_sync_t *sync);
+
+/**
+ * video_hard_sync_update:
+ * @sync                 : hard sync state of the driver.
+ * @stall                : time the driver spent waiting on the GPU 
+ *                         this frame, in microseconds.
+ *
+ * Call once per frame after the hard sync wait. Allows one more 
+ * frame in flight when a frame missed VSync because of waiting 
+ * on the GPU, and goes back towards video_hard_sync_frames once 
+ * frames have been on time for a while.
+ **/
+void video_hard_sync_update(video_hard_sync_t *sync, retro_time_t stall);
+
 bool video_driver_is_alive(void);
 
 bool video_driver_has_focus(void);
@@ -308,6 +402,33 @@ bool video_driver_viewport_info(struct video_viewport *vp);
 
 bool video_driver_read_viewport(uint8_t *buffer);
 
+/**
+ * video_driver_init_viewport_yuv420:
+ * @width                    : Width of the frames to read back,
+ *                             a multiple of 8.
+ * @height                   : Height of the frames to read back,
+ *                             a multiple of 4.
+ *
+ * Switches the readbacks of the video driver to planar YUV 4:2:0
+ * (I420). The video driver scales the viewport to @width x @height
+ * and converts it, so the CPU only has to copy the frames.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool video_driver_init_viewport_yuv420(unsigned width, unsigned height);
+
+/**
+ * video_driver_read_viewport_yuv420:
+ * @buffer                   : Buffer of width * height * 3 / 2 bytes,
+ *                             see video_driver_init_viewport_yuv420().
+ *
+ * Reads back the viewport as planar YUV 4:2:0 (I420), top row
+ * first, scaled and converted by the video driver.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool video_driver_read_viewport_yuv420(uint8_t *buffer);
+
 bool video_driver_set_shader(enum rarch_shader_type type,
       const char *path);
 
@@ -22,6 +22,7 @@
 #include "../file_ext.h"
 #include <file/dir_list.h>
 #include "../performance.h"
+#include "video_work_pool.h"
 #include <stdlib.h>
 
 struct rarch_soft_plug
@@ -32,53 +33,40 @@ struct rarch_soft_plug
    const struct softfilter_implementation *impl;
 };
 
-#ifdef HAVE_THREADS
-#include <rthreads/rthreads.h>
+/* Input rows per work item of tile-based filters. 
+ * For chains, rows of the last filter's input. */
+#define SOFTFILTER_BAND_ROWS 16
 
-struct filter_thread_data
-{
-   sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
-   slock_t *lock;
-   void *userdata;
-   bool die;
-   bool done;
-};
+#define SOFTFILTER_MAX_STAGES 8
 
-static void filter_thread_loop(void *data)
-{
-   struct filter_thread_data *thr = (struct filter_thread_data*)data;
+/* Filters may read a few pixels past either end of a row, 
+ * so keep some slack around each intermediate band. */
+#define SOFTFILTER_SCRATCH_PAD 64
 
-   for (;;)
-   {
-      bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
-
-      if (die)
-         break;
+struct softfilter_stage
+{
+   const struct softfilter_implementation *impl;
+   softfilter_process_rows_t process_rows;
+   softfilter_end_frame_t end_frame;
+   void *impl_data;
 
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
+   unsigned in_fmt, out_fmt;
+   /* Output rows per input row. */
+   unsigned scale;
+   unsigned context_rows;
 
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
-   }
-}
-#endif
+   /* Where this stage's output band lives in per-thread scratch 
+    * memory. Unused by the last stage, which writes the output. */
+   size_t scratch_offset;
+};
 
 struct rarch_softfilter
 {
    config_file_t *conf;
 
-   const struct softfilter_implementation *impl;
-   void *impl_data;
+   struct softfilter_stage stages[SOFTFILTER_MAX_STAGES];
+   unsigned num_stages;
+   bool banded;
 
    struct rarch_soft_plug *plugs;
    unsigned num_plugs;
@@ -88,12 +76,144 @@ struct rarch_softfilter
 
    struct softfilter_work_packet *packets;
    unsigned threads;
+   bool pool;
 
-#ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
-#endif
+   /* One block of scratch_size bytes per pool thread. */
+   uint8_t *scratch;
+   size_t scratch_size;
+};
+
+struct softfilter_rows_job
+{
+   rarch_softfilter_t *filt;
+   void *output;
+   size_t output_stride;
+   const void *input;
+   size_t input_stride;
+   /* Input size of each stage, then the output size. */
+   unsigned width[SOFTFILTER_MAX_STAGES + 1];
+   unsigned height[SOFTFILTER_MAX_STAGES + 1];
+   /* Output stride of each stage in scratch memory. */
+   size_t scratch_stride[SOFTFILTER_MAX_STAGES];
 };
 
+/**
+ * softfilter_impl_usable:
+ * @impl                 : Softfilter implementation.
+ * @mask                 : SIMD features of the CPU.
+ *
+ * Returns: true (1) if the host can use @impl, otherwise false (0).
+ **/
+static bool softfilter_impl_usable(
+      const struct softfilter_implementation *impl,
+      softfilter_simd_mask_t mask)
+{
+   if (impl->api_version < SOFTFILTER_API_VERSION_MIN ||
+         impl->api_version > SOFTFILTER_API_VERSION)
+      return false;
+
+   if (impl->api_version >= 3 && (impl->simd & ~mask))
+   {
+      RARCH_WARN("[SoftFilter]: %s needs SIMD features this CPU lacks.\n",
+            impl->ident);
+      return false;
+   }
+
+   return true;
+}
+
+static void softfilter_packet_work(void *data, unsigned index,
+      unsigned thread)
+{
+   rarch_softfilter_t *filt = (rarch_softfilter_t*)data;
+
+   (void)thread;
+
+   if (filt->packets[index].work)
+      filt->packets[index].work(filt->stages[0].impl_data,
+            filt->packets[index].thread_data);
+}
+
+/**
+ * softfilter_band_rows:
+ * @filt                 : Softfilter handle.
+ * @height               : Input height of each stage.
+ * @band                 : Band index.
+ * @first                : First input row of each stage for @band.
+ * @rows                 : Number of input rows of each stage for @band.
+ *
+ * Band @band covers SOFTFILTER_BAND_ROWS input rows of the last 
+ * stage. Works backwards through the chain to find which rows 
+ * the earlier stages have to produce for it, including the context 
+ * rows the next stage reads around its band.
+ **/
+static void softfilter_band_rows(const rarch_softfilter_t *filt,
+      const unsigned *height, unsigned band,
+      unsigned *first, unsigned *rows)
+{
+   int i;
+   unsigned last = filt->num_stages - 1;
+
+   first[last] = band * SOFTFILTER_BAND_ROWS;
+   rows[last]  = SOFTFILTER_BAND_ROWS;
+   if (first[last] + rows[last] > height[last])
+      rows[last] = height[last] - first[last];
+
+   for (i = last - 1; i >= 0; i--)
+   {
+      unsigned context = filt->stages[i + 1].context_rows;
+      unsigned scale   = filt->stages[i].scale;
+      unsigned lo      = first[i + 1] > context ? 
+         first[i + 1] - context : 0;
+      unsigned hi      = first[i + 1] + rows[i + 1] + context;
+
+      if (hi > height[i + 1])
+         hi = height[i + 1];
+
+      first[i] = lo / scale;
+      rows[i]  = (hi + scale - 1) / scale - first[i];
+   }
+}
+
+static void softfilter_rows_work(void *data, unsigned index,
+      unsigned thread)
+{
+   unsigned i;
+   unsigned first[SOFTFILTER_MAX_STAGES], rows[SOFTFILTER_MAX_STAGES];
+   struct softfilter_rows_job *job = (struct softfilter_rows_job*)data;
+   rarch_softfilter_t *filt        = job->filt;
+   uint8_t *scratch                = filt->scratch + 
+      thread * filt->scratch_size;
+   const void *input               = job->input;
+   size_t input_stride             = job->input_stride;
+
+   softfilter_band_rows(filt, job->height, index, first, rows);
+
+   for (i = 0; i < filt->num_stages; i++)
+   {
+      const struct softfilter_stage *stage = &filt->stages[i];
+      uint8_t *output      = (uint8_t*)job->output;
+      size_t output_stride = job->output_stride;
+
+      if (i + 1 < filt->num_stages)
+      {
+         /* Point to where row 0 of the whole intermediate frame 
+          * would be, so the band keeps its frame row numbers. */
+         output_stride = job->scratch_stride[i];
+         output        = scratch + stage->scratch_offset - 
+            first[i] * stage->scale * output_stride;
+      }
+
+      stage->process_rows(stage->impl_data,
+            output, output_stride,
+            input, job->width[i], job->height[i], input_stride,
+            first[i], rows[i]);
+
+      input        = output;
+      input_stride = output_stride;
+   }
+}
+
 static const struct softfilter_implementation *
 softfilter_find_implementation(rarch_softfilter_t *filt, const char *ident)
 {
@@ -117,32 +237,43 @@ static const struct softfilter_config softfilter_config = {
    config_userdata_free,
 };
 
-static bool create_softfilter_graph(rarch_softfilter_t *filt,
-      enum retro_pixel_format in_pixel_format,
+static size_t softfilter_scratch_stride(unsigned width, unsigned fmt)
+{
+   size_t bpp = fmt == SOFTFILTER_FMT_XRGB8888 ? 
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+   return (width * bpp + 15) & ~15;
+}
+
+/**
+ * create_softfilter_stage:
+ * @filt                 : Softfilter handle.
+ * @stage                : Stage to create.
+ * @key                  : Config key naming the filter.
+ * @in_fmt               : Input format, SOFTFILTER_FMT_*.
+ * @max_width            : Maximum input width.
+ * @max_height           : Maximum input height.
+ * @cpu_features         : SIMD features of the CPU.
+ * @threads              : Number of threads passed to the filter.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool create_softfilter_stage(rarch_softfilter_t *filt,
+      struct softfilter_stage *stage, const char *key, unsigned in_fmt,
       unsigned max_width, unsigned max_height,
-      softfilter_simd_mask_t cpu_features,
-      unsigned threads)
+      softfilter_simd_mask_t cpu_features, unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts, i;
-   char key[64], name[64];
+   unsigned output_fmts;
+   char name[64];
    struct config_file_userdata userdata;
 
-   snprintf(key, sizeof(key), "filter");
-
    if (!config_get_array(filt->conf, key, name, sizeof(name)))
    {
-      RARCH_ERR("Could not find 'filter' array in config.\n");
-      return false;
-   }
-
-   if (filt->num_plugs == 0)
-   {
-      RARCH_ERR("No filter plugs found. Exiting...\n");
+      RARCH_ERR("Could not find '%s' array in config.\n", key);
       return false;
    }
 
-   filt->impl = softfilter_find_implementation(filt, name);
-   if (!filt->impl)
+   stage->impl = softfilter_find_implementation(filt, name);
+   if (!stage->impl)
    {
       RARCH_ERR("Could not find implementation.\n");
       return false;
@@ -151,59 +282,207 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    userdata.conf = filt->conf;
    /* Index-specific configs take priority over ident-specific. */
    userdata.prefix[0] = key; 
-   userdata.prefix[1] = filt->impl->short_ident;
+   userdata.prefix[1] = stage->impl->short_ident;
+
+   if (!(in_fmt & stage->impl->query_input_formats()))
+   {
+      RARCH_ERR("Softfilter does not support input format.\n");
+      return false;
+   }
+
+   output_fmts = stage->impl->query_output_formats(in_fmt);
+   /* If we have a match of input/output formats, use that. */
+   if (output_fmts & in_fmt)
+      stage->out_fmt = in_fmt;
+   else if (output_fmts & SOFTFILTER_FMT_XRGB8888)
+      stage->out_fmt = SOFTFILTER_FMT_XRGB8888;
+   else if (output_fmts & SOFTFILTER_FMT_RGB565)
+      stage->out_fmt = SOFTFILTER_FMT_RGB565;
+   else
+   {
+      RARCH_ERR("Did not find suitable output format for softfilter.\n");
+      return false;
+   }
+   stage->in_fmt = in_fmt;
+
+   stage->impl_data = stage->impl->create(
+         &softfilter_config, in_fmt, stage->out_fmt, max_width, max_height,
+         threads, cpu_features, &userdata);
+   if (!stage->impl_data)
+   {
+      RARCH_ERR("Failed to create softfilter state.\n");
+      return false;
+   }
+
+   if (stage->impl->api_version >= 3)
+      stage->process_rows = stage->impl->process_rows;
+   if (stage->impl->api_version >= 4)
+   {
+      /* Filters that look at neighbouring rows tend to read a pixel
+       * or two past the ends of a row as well, which wraps into the 
+       * rows before and after, so chains produce one more row. */
+      stage->context_rows = stage->impl->context_rows ? 
+         stage->impl->context_rows + 1 : 0;
+      stage->end_frame    = stage->impl->end_frame;
+   }
+
+   return true;
+}
+
+/**
+ * create_softfilter_scratch:
+ * @filt                 : Softfilter handle.
+ * @max_width            : Maximum output width of each stage.
+ *
+ * Lays out per-thread memory for the intermediate bands of a chain. 
+ * Each band is sized for the worst case, where no context rows 
+ * are clipped by the frame edges.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool create_softfilter_scratch(rarch_softfilter_t *filt,
+      const unsigned *max_width)
+{
+   int i;
+   size_t offset;
+   unsigned rows[SOFTFILTER_MAX_STAGES];
+   unsigned last = filt->num_stages - 1;
+
+   rows[last] = SOFTFILTER_BAND_ROWS;
+   for (i = last - 1; i >= 0; i--)
+   {
+      unsigned scale = filt->stages[i].scale;
+      /* One extra row for bands not aligned to the scale. */
+      rows[i] = (rows[i + 1] + 2 * filt->stages[i + 1].context_rows 
+            + scale - 1) / scale + 1;
+   }
+
+   offset = 0;
+   for (i = 0; i < (int)last; i++)
+   {
+      struct softfilter_stage *stage = &filt->stages[i];
+
+      stage->scratch_offset = offset + SOFTFILTER_SCRATCH_PAD;
+      offset = stage->scratch_offset + rows[i] * stage->scale * 
+         softfilter_scratch_stride(max_width[i], stage->out_fmt);
+   }
+   filt->scratch_size = (offset + SOFTFILTER_SCRATCH_PAD + 63) & ~63;
+
+   filt->scratch = (uint8_t*)calloc(video_work_pool_num_threads(),
+         filt->scratch_size);
+   return filt->scratch != NULL;
+}
+
+static bool create_softfilter_graph(rarch_softfilter_t *filt,
+      enum retro_pixel_format in_pixel_format,
+      unsigned max_width, unsigned max_height,
+      softfilter_simd_mask_t cpu_features,
+      unsigned threads)
+{
+   unsigned i, fmt, num_stages = 1;
+   unsigned width[SOFTFILTER_MAX_STAGES];
+   bool chain = config_get_uint(filt->conf, "filters", &num_stages);
+
+   if (num_stages < 1 || num_stages > SOFTFILTER_MAX_STAGES)
+   {
+      RARCH_ERR("Softfilter chains need 1 to %u filters.\n",
+            SOFTFILTER_MAX_STAGES);
+      return false;
+   }
+
+   if (filt->num_plugs == 0)
+   {
+      RARCH_ERR("No filter plugs found. Exiting...\n");
+      return false;
+   }
 
    /* Simple assumptions. */
    filt->pix_fmt = in_pixel_format;
-   input_fmts = filt->impl->query_input_formats();
 
    switch (in_pixel_format)
    {
       case RETRO_PIXEL_FORMAT_XRGB8888:
-         input_fmt = SOFTFILTER_FMT_XRGB8888;
+         fmt = SOFTFILTER_FMT_XRGB8888;
          break;
       case RETRO_PIXEL_FORMAT_RGB565:
-         input_fmt = SOFTFILTER_FMT_RGB565;
+         fmt = SOFTFILTER_FMT_RGB565;
          break;
       default:
          return false;
    }
 
-   if (!(input_fmt & input_fmts))
-   {
-      RARCH_ERR("Softfilter does not support input format.\n");
-      return false;
-   }
+   filt->max_width = max_width;
+   filt->max_height = max_height;
 
-   output_fmts = filt->impl->query_output_formats(input_fmt);
-   /* If we have a match of input/output formats, use that. */
-   if (output_fmts & input_fmt)
-      filt->out_pix_fmt = in_pixel_format;
-   else if (output_fmts & SOFTFILTER_FMT_XRGB8888)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_XRGB8888;
-   else if (output_fmts & SOFTFILTER_FMT_RGB565)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_RGB565;
-   else
+   filt->pool = true;
+   video_work_pool_init();
+
+   if (threads == RARCH_SOFTFILTER_THREADS_AUTO)
+      threads = video_work_pool_num_threads();
+
+   for (i = 0; i < num_stages; i++)
    {
-      RARCH_ERR("Did not find suitable output format for softfilter.\n");
-      return false;
+      char key[64];
+      unsigned out_width, out_height;
+      struct softfilter_stage *stage = &filt->stages[i];
+
+      if (chain)
+         snprintf(key, sizeof(key), "filter%u", i);
+      else
+         snprintf(key, sizeof(key), "filter");
+
+      if (!create_softfilter_stage(filt, stage, key, fmt,
+               max_width, max_height, cpu_features, threads))
+         return false;
+      filt->num_stages++;
+
+      if (num_stages > 1 && !stage->process_rows)
+      {
+         RARCH_ERR("Softfilter %s cannot be chained, "
+               "it does not process rows.\n", stage->impl->ident);
+         return false;
+      }
+
+      stage->impl->query_output_size(stage->impl_data,
+            &out_width, &out_height, max_width, max_height);
+      stage->scale = max_height ? out_height / max_height : 1;
+      if (num_stages > 1 && 
+            (!stage->scale || out_height != max_height * stage->scale))
+      {
+         RARCH_ERR("Softfilter %s cannot be chained, "
+               "it does not scale height by an integer factor.\n",
+               stage->impl->ident);
+         return false;
+      }
+
+      width[i]   = out_width;
+      max_width  = out_width;
+      max_height = out_height;
+      fmt        = stage->out_fmt;
    }
 
-   filt->max_width = max_width;
-   filt->max_height = max_height;
+   filt->out_pix_fmt = fmt == SOFTFILTER_FMT_XRGB8888 ? 
+      RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+
+   filt->banded = filt->stages[0].process_rows != NULL;
 
-   filt->impl_data = filt->impl->create(
-         &softfilter_config, input_fmt, input_fmt, max_width, max_height,
-         threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads : 
-         rarch_get_cpu_cores(), cpu_features,
-         &userdata);
-   if (!filt->impl_data)
+   if (filt->banded)
    {
-      RARCH_ERR("Failed to create softfilter state.\n");
-      return false;
+      if (num_stages > 1 && !create_softfilter_scratch(filt, width))
+      {
+         RARCH_ERR("Failed to allocate softfilter scratch memory.\n");
+         return false;
+      }
+
+      RARCH_LOG("Using %u threads for %u softfilter(s), "
+            "in bands of %u rows.\n",
+            video_work_pool_num_threads(), num_stages, 
+            SOFTFILTER_BAND_ROWS);
+      return true;
    }
 
-   threads = filt->impl->query_num_threads(filt->impl_data);
+   threads = filt->stages[0].impl->query_num_threads(
+         filt->stages[0].impl_data);
    if (!threads)
    {
       RARCH_ERR("Invalid number of threads.\n");
@@ -219,32 +498,8 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       RARCH_ERR("Failed to allocate softfilter packets.\n");
       return false;
    }
-
-#ifdef HAVE_THREADS
-   filt->thread_data = (struct filter_thread_data*)
-      calloc(threads, sizeof(*filt->thread_data));
-   if (!filt->thread_data)
-      return false;
    filt->threads = threads;
 
-   for (i = 0; i < threads; i++)
-   {
-      filt->thread_data[i].userdata = filt->impl_data;
-      filt->thread_data[i].done = true;
-
-      filt->thread_data[i].lock = slock_new();
-      if (!filt->thread_data[i].lock)
-         return false;
-      filt->thread_data[i].cond = scond_new();
-      if (!filt->thread_data[i].cond)
-         return false;
-      filt->thread_data[i].thread = sthread_create(
-            filter_thread_loop, &filt->thread_data[i]);
-      if (!filt->thread_data[i].thread)
-         return false;
-   }
-#endif
-
    return true;
 }
 
@@ -281,7 +536,7 @@ static bool append_softfilter_plugs(rarch_softfilter_t *filt,
          continue;
       }
 
-      if (impl->api_version != SOFTFILTER_API_VERSION)
+      if (!softfilter_impl_usable(impl, mask))
       {
          dylib_close(lib);
          continue;
@@ -353,6 +608,8 @@ static bool append_softfilter_plugs(rarch_softfilter_t *filt,
       filt->plugs[i].impl = soft_plugs_builtin[i](mask);
       if (!filt->plugs[i].impl)
          return false;
+      if (!softfilter_impl_usable(filt->plugs[i].impl, mask))
+         return false;
    }
 
    return true;
@@ -431,14 +688,17 @@ error:
 void rarch_softfilter_free(rarch_softfilter_t *filt)
 {
    unsigned i = 0;
-   (void)i;
 
    if (!filt)
       return;
 
    free(filt->packets);
-   if (filt->impl && filt->impl_data)
-      filt->impl->destroy(filt->impl_data);
+   free(filt->scratch);
+   for (i = 0; i < filt->num_stages; i++)
+   {
+      if (filt->stages[i].impl_data)
+         filt->stages[i].impl->destroy(filt->stages[i].impl_data);
+   }
 
 #ifdef HAVE_DYLIB
    for (i = 0; i < filt->num_plugs; i++)
@@ -449,21 +709,8 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    free(filt->plugs);
 #endif
 
-#ifdef HAVE_THREADS
-   for (i = 0; i < filt->threads; i++)
-   {
-      if (!filt->thread_data[i].thread)
-         continue;
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].die = true;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-      sthread_join(filt->thread_data[i].thread);
-      slock_free(filt->thread_data[i].lock);
-      scond_free(filt->thread_data[i].cond);
-   }
-   free(filt->thread_data);
-#endif
+   if (filt->pool)
+      video_work_pool_deinit();
    free(filt);
 }
 
@@ -478,9 +725,18 @@ void rarch_softfilter_get_output_size(rarch_softfilter_t *filt,
       unsigned *out_width, unsigned *out_height,
       unsigned width, unsigned height)
 {
-   if (filt && filt->impl && filt->impl->query_output_size)
-      filt->impl->query_output_size(filt->impl_data, out_width,
-            out_height, width, height);
+   unsigned i;
+
+   if (!filt || !filt->num_stages)
+      return;
+
+   for (i = 0; i < filt->num_stages; i++)
+   {
+      filt->stages[i].impl->query_output_size(filt->stages[i].impl_data,
+            out_width, out_height, width, height);
+      width  = *out_width;
+      height = *out_height;
+   }
 }
 
 enum retro_pixel_format rarch_softfilter_get_output_format(
@@ -495,38 +751,51 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
 {
    unsigned i;
 
-   if (filt && filt->impl && filt->impl->get_work_packets)
-      filt->impl->get_work_packets(filt->impl_data, filt->packets,
-            output, output_stride, input, width, height, input_stride);
-   
-#ifdef HAVE_THREADS
-   /* Fire off workers */
-   for (i = 0; i < filt->threads; i++)
+   if (!filt || !filt->num_stages)
+      return;
+
+   if (filt->banded)
    {
-#if 0
-      RARCH_LOG("Firing off filter thread %u ...\n", i);
-#endif
-      filt->thread_data[i].packet = &filt->packets[i];
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].done = false;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
+      struct softfilter_rows_job job;
+      unsigned last = filt->num_stages - 1;
+
+      job.filt          = filt;
+      job.output        = output;
+      job.output_stride = output_stride;
+      job.input         = input;
+      job.input_stride  = input_stride;
+      job.width[0]      = width;
+      job.height[0]     = height;
+
+      for (i = 0; i < last; i++)
+      {
+         filt->stages[i].impl->query_output_size(filt->stages[i].impl_data,
+               &job.width[i + 1], &job.height[i + 1],
+               job.width[i], job.height[i]);
+         /* Pack intermediate rows by the actual width, so pixels 
+          * read past a row's end are the next row's, as they 
+          * would be in a tightly packed frame. */
+         job.scratch_stride[i] = softfilter_scratch_stride(
+               job.width[i + 1], filt->stages[i].out_fmt);
+      }
+
+      video_work_pool_run(softfilter_rows_work, &job,
+            (job.height[last] + SOFTFILTER_BAND_ROWS - 1) / 
+            SOFTFILTER_BAND_ROWS);
+   }
+   else
+   {
+      if (filt->stages[0].impl->get_work_packets)
+         filt->stages[0].impl->get_work_packets(filt->stages[0].impl_data,
+               filt->packets, output, output_stride,
+               input, width, height, input_stride);
+
+      video_work_pool_run(softfilter_packet_work, filt, filt->threads);
    }
 
-   /* Wait for workers */
-   for (i = 0; i < filt->threads; i++)
+   for (i = 0; i < filt->num_stages; i++)
    {
-#if 0
-      RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-      slock_lock(filt->thread_data[i].lock);
-      while (!filt->thread_data[i].done)
-         scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-      slock_unlock(filt->thread_data[i].lock);
+      if (filt->stages[i].end_frame)
+         filt->stages[i].end_frame(filt->stages[i].impl_data);
    }
-#else
-   for (i = 0; i < filt->threads; i++)
-      filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
-#endif
 }
-
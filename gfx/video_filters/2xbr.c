@@ -34,6 +34,7 @@
 */
  
 #include "softfilter.h"
+#include "softfilter_vec.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -57,6 +58,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   unsigned frame_height;
 };
 
 struct filter_data
@@ -534,6 +536,41 @@ int eq8(uint32_t A, uint32_t B,
      }\
  
  
+#ifndef twoxbr_declare_variables
+#define twoxbr_declare_variables(typename_t, in) \
+         typename_t E[4]; \
+         typename_t ex, e, i, ke, ki, ex2, ex3, px; \
+         typename_t A1 = *(in - prevline2 - 1); \
+         typename_t B1 = *(in - prevline2); \
+         typename_t C1 = *(in - prevline2 + 1); \
+         typename_t A0 = *(in - prevline - 2); \
+         typename_t PA = *(in - prevline - 1); \
+         typename_t PB = *(in - prevline); \
+         typename_t PC = *(in - prevline + 1); \
+         typename_t C4 = *(in - prevline + 2); \
+         typename_t D0 = *(in - 2); \
+         typename_t PD = *(in - 1); \
+         typename_t PE = *(in); \
+         typename_t PF = *(in + 1); \
+         typename_t F4 = *(in + 2); \
+         typename_t G0 = *(in + nextline - 2); \
+         typename_t PG = *(in + nextline - 1); \
+         typename_t PH = *(in + nextline); \
+         typename_t _PI = *(in + nextline + 1); \
+         typename_t I4 = *(in + nextline + 2); \
+         typename_t G5 = *(in + nextline2 - 1); \
+         typename_t H5 = *(in + nextline2); \
+         typename_t I5 = *(in + nextline2 + 1)
+
+/*
+ * Map of the pixels:          A1 B1 C1
+ *                          A0 PA PB PC C4
+ *                          D0 PD PE PF F4
+ *                          G0 PG PH _PI I4
+ *                             G5 H5 I5
+ */
+#endif
+
 #ifndef twoxbr_function
 #define twoxbr_function(FILTRO, Z) \
             E[0] = E[1] = E[2] = E[3] = PE;\
@@ -551,10 +588,10 @@ int eq8(uint32_t A, uint32_t B,
  
  
 static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
-      int first, int last, uint32_t *src,
+      unsigned first_row, unsigned frame_height, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
+   unsigned prevline, prevline2, nextline, nextline2, finish;
    uint32_t pg_red_mask      = RED_MASK8888;
    uint32_t pg_green_mask    = GREEN_MASK8888;
    uint32_t pg_blue_mask     = BLUE_MASK8888;
@@ -564,46 +601,20 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
 
    (void)filt;
 
-   nextline = (last) ? 0 : src_stride;
-   
-   for (; height; height--)
+   for (; height; height--, first_row++)
    {
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
+
+      /* Clamp to the frame edges. */
+      prevline  = first_row >= 1 ? src_stride : 0;
+      prevline2 = first_row >= 2 ? 2 * src_stride : prevline;
+      nextline  = first_row + 1 < frame_height ? src_stride : 0;
+      nextline2 = first_row + 2 < frame_height ? 2 * src_stride : nextline;
  
       for (finish = width; finish; finish -= 1)
       {
-         uint32_t E[4];
-         uint32_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint32_t A1 = *(in - nextline - nextline - 1);
-         uint32_t B1 = *(in - nextline - nextline);
-         uint32_t C1 = *(in - nextline - nextline + 1);
-         uint32_t A0 = *(in - nextline - 2);
-         uint32_t PA = *(in - nextline - 1);
-         uint32_t PB = *(in - nextline);
-         uint32_t PC = *(in - nextline + 1);
-         uint32_t C4 = *(in - nextline + 2);
-         uint32_t D0 = *(in - 2);
-         uint32_t PD = *(in - 1);
-         uint32_t PE = *(in);
-         uint32_t PF = *(in + 1);
-         uint32_t F4 = *(in + 2);
-         uint32_t G0 = *(in + nextline - 2);
-         uint32_t PG = *(in + nextline - 1);
-         uint32_t PH = *(in + nextline);
-         uint32_t _PI = *(in + nextline + 1);
-         uint32_t I4 = *(in + nextline + 2);
-         uint32_t G5 = *(in + nextline + nextline - 1);
-         uint32_t H5 = *(in + nextline + nextline);
-         uint32_t I5 = *(in + nextline + nextline + 1);
- 
-         /*
-          * Map of the pixels:          A1 B1 C1
-          *                          A0 PA PB PC C4
-          *                          D0 PD PE PF F4
-          *                          G0 PG PH _PI I4
-          *                             G5 H5 I5
-          */
+         twoxbr_declare_variables(uint32_t, in);
  
          twoxbr_function(FILTRO_RGB8888, filt);
       }
@@ -614,58 +625,31 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
 }
  
 static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
-      int first, int last, uint16_t *src,
+      unsigned first_row, unsigned frame_height, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    uint16_t pg_red_mask, pg_green_mask, pg_blue_mask, pg_lbmask;
-   unsigned nextline, finish;
+   unsigned prevline, prevline2, nextline, nextline2, finish;
    struct filter_data *filt = (struct filter_data*)data;
 
    pg_red_mask   = RED_MASK565;
    pg_green_mask = GREEN_MASK565;
    pg_blue_mask  = BLUE_MASK565;
    pg_lbmask     = PG_LBMASK565;
-   nextline = (last) ? 0 : src_stride;
-   
- 
-   for (; height; height--)
+   for (; height; height--, first_row++)
    {
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
+
+      /* Clamp to the frame edges. */
+      prevline  = first_row >= 1 ? src_stride : 0;
+      prevline2 = first_row >= 2 ? 2 * src_stride : prevline;
+      nextline  = first_row + 1 < frame_height ? src_stride : 0;
+      nextline2 = first_row + 2 < frame_height ? 2 * src_stride : nextline;
  
       for (finish = width; finish; finish -= 1)
       {
-         uint16_t E[4];
-         uint16_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint16_t A1 = *(in - nextline - nextline - 1);
-         uint16_t B1 = *(in - nextline - nextline);
-         uint16_t C1 = *(in - nextline - nextline + 1);
-         uint16_t A0 = *(in - nextline - 2);
-         uint16_t PA = *(in - nextline - 1);
-         uint16_t PB = *(in - nextline);
-         uint16_t PC = *(in - nextline + 1);
-         uint16_t C4 = *(in - nextline + 2);
-         uint16_t D0 = *(in - 2);
-         uint16_t PD = *(in - 1);
-         uint16_t PE = *(in);
-         uint16_t PF = *(in + 1);
-         uint16_t F4 = *(in + 2);
-         uint16_t G0 = *(in + nextline - 2);
-         uint16_t PG = *(in + nextline - 1);
-         uint16_t PH = *(in + nextline);
-         uint16_t _PI = *(in + nextline + 1);
-         uint16_t I4 = *(in + nextline + 2);
-         uint16_t G5 = *(in + nextline + nextline - 1);
-         uint16_t H5 = *(in + nextline + nextline);
-         uint16_t I5 = *(in + nextline + nextline + 1);
- 
-         /*
-          * Map of the pixels:          A1 B1 C1
-          *                          A0 PA PB PC C4
-          *                          D0 PD PE PF F4
-          *                          G0 PG PH _PI I4
-          *                             G5 H5 I5
-          */
+         twoxbr_declare_variables(uint16_t, in);
  
          twoxbr_function(FILTRO_RGB565, filt);
       }
@@ -675,6 +659,255 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
    }
 }
  
+#ifdef SOFTFILTER_VEC_SIMD
+/* The RGB565 vector version does 8 pixels at a time, keeping
+ * every branch of FILTRO_RGB565() as a mask. The YUV table and
+ * the 16-bit wraparound of e and i are reproduced exactly, so
+ * its output is the same as the generic one.
+ *
+ * The XRGB8888 metric is computed in floating point, and stays
+ * with the generic code. Only skipping the runs of pixels no
+ * rotation touches measured no faster than it. */
+
+/* RGBtoYUV[] of 8 pixels. (x * 527 + 23) >> 6 and
+ * (x * 259 + 33) >> 6 give tbl_5_to_8[] and tbl_6_to_8[]. */
+static INLINE sfv16_t twoxbr_vec_yuv_rgb565(sfv16_t c)
+{
+   const sfv16_t mul5 = SFV16_DUP(527);
+   const sfv16_t add5 = SFV16_DUP(23);
+   sfv16_t r = SFV16_SHR(SFV16_ADD(SFV16_MUL(SFV16_SHR(c, 11), mul5), add5), 6);
+   sfv16_t g = SFV16_SHR(SFV16_ADD(SFV16_MUL(
+               SFV16_AND(SFV16_SHR(c, 5), SFV16_DUP(0x3F)), SFV16_DUP(259)),
+            SFV16_DUP(33)), 6);
+   sfv16_t b = SFV16_SHR(SFV16_ADD(SFV16_MUL(
+               SFV16_AND(c, SFV16_DUP(0x1F)), mul5), add5), 6);
+
+   /* y + u + v */
+   return SFV16_SUB(SFV16_ADD(SFV16_ADD(SFV16_MUL(r, SFV16_DUP(17)),
+               SFV16_MUL(g, SFV16_DUP(28))), SFV16_SHL(b, 3)),
+         SFV16_SHR(b, 1));
+}
+
+static INLINE sfv16_t twoxbr_vec_df(sfv16_t a, sfv16_t b)
+{
+   sfv16_t d    = SFV16_SUB(a, b);
+   sfv16_t sign = SFV16_SRA(d, 15);
+   return SFV16_SUB(SFV16_XOR(d, sign), sign);
+}
+
+/* ALPHA_BLEND_*_W() for a weight w of 32, 64, 192 or 224.
+ * Scaled by w / 256, the red and green differences stay whole
+ * numbers, and the blue one fits 16 bits. */
+static INLINE sfv16_t twoxbr_vec_blend_rgb565(sfv16_t dst, sfv16_t src,
+      unsigned w)
+{
+   const sfv16_t red_mask   = SFV16_DUP(RED_MASK565);
+   const sfv16_t green_mask = SFV16_DUP(GREEN_MASK565);
+   const sfv16_t blue_mask  = SFV16_DUP(BLUE_MASK565);
+   sfv16_t dst_green        = SFV16_AND(dst, green_mask);
+   sfv16_t dst_blue         = SFV16_AND(dst, blue_mask);
+   sfv16_t red              = SFV16_AND(SFV16_ADD(SFV16_AND(dst, red_mask),
+            SFV16_MUL(SFV16_SUB(SFV16_SHR(src, 11), SFV16_SHR(dst, 11)),
+               SFV16_DUP(w << 3))), red_mask);
+   sfv16_t green            = SFV16_AND(SFV16_ADD(dst_green,
+            SFV16_MUL(SFV16_SRA(SFV16_SUB(SFV16_AND(src, green_mask),
+                     dst_green), 5), SFV16_DUP(w >> 3))), green_mask);
+   sfv16_t blue             = SFV16_AND(SFV16_ADD(dst_blue,
+            SFV16_SRA(SFV16_MUL(SFV16_SUB(SFV16_AND(src, blue_mask),
+                     dst_blue), SFV16_DUP(w)), 8)), blue_mask);
+
+   return SFV16_OR(SFV16_OR(red, green), blue);
+}
+
+static INLINE sfv16_t twoxbr_vec_blend_128_rgb565(sfv16_t dst, sfv16_t src)
+{
+   const sfv16_t lbmask = SFV16_DUP(PG_LBMASK565);
+   return SFV16_ADD(SFV16_SHR(SFV16_AND(src, lbmask), 1),
+         SFV16_SHR(SFV16_AND(dst, lbmask), 1));
+}
+
+#define twoxbr_vec_eq(A, B)  SFV16_LT(twoxbr_vec_df(Y##A, Y##B), SFV16_DUP(155))
+#define twoxbr_vec_neq(A, B) SFV16_GT(twoxbr_vec_df(Y##A, Y##B), SFV16_DUP(154))
+
+#define FILTRO_VEC_RGB565(PE, _PI, PH, PF, PG, PC, PD, PB, PA, G5, C4, G0, D0, C1, B1, F4, I4, H5, I5, A0, A1, N0, N1, N2, N3) \
+     ex = SFV16_AND(SFV16_NE(PE, PH), SFV16_NE(PE, PF)); \
+     if (sfv16_any(ex)) \
+     { \
+          e = SFV16_ADD(SFV16_ADD( \
+                   SFV16_ADD(twoxbr_vec_df(Y##PE, Y##PC), twoxbr_vec_df(Y##PE, Y##PG)), \
+                   SFV16_ADD(twoxbr_vec_df(Y##_PI, Y##H5), twoxbr_vec_df(Y##_PI, Y##F4))), \
+                SFV16_SHL(twoxbr_vec_df(Y##PH, Y##PF), 2)); \
+          i = SFV16_ADD(SFV16_ADD( \
+                   SFV16_ADD(twoxbr_vec_df(Y##PH, Y##PD), twoxbr_vec_df(Y##PH, Y##I5)), \
+                   SFV16_ADD(twoxbr_vec_df(Y##PF, Y##I4), twoxbr_vec_df(Y##PF, Y##PB))), \
+                SFV16_SHL(twoxbr_vec_df(Y##PE, Y##_PI), 2)); \
+          act = SFV16_OR(SFV16_OR( \
+                   SFV16_AND(twoxbr_vec_neq(PF, PB), twoxbr_vec_neq(PF, PC)), \
+                   SFV16_AND(twoxbr_vec_neq(PH, PD), twoxbr_vec_neq(PH, PG))), \
+                SFV16_OR(SFV16_AND(twoxbr_vec_eq(PE, _PI), SFV16_OR( \
+                         SFV16_AND(twoxbr_vec_neq(PF, F4), twoxbr_vec_neq(PF, I4)), \
+                         SFV16_AND(twoxbr_vec_neq(PH, H5), twoxbr_vec_neq(PH, I5)))), \
+                   SFV16_OR(twoxbr_vec_eq(PE, PG), twoxbr_vec_eq(PE, PC)))); \
+          act = SFV16_AND(SFV16_AND(ex, sfv16_ltu(e, i)), act); \
+          ke = twoxbr_vec_df(Y##PF, Y##PG); \
+          ki = twoxbr_vec_df(Y##PH, Y##PC); \
+          ex2 = SFV16_AND(SFV16_NE(PE, PC), SFV16_NE(PB, PC)); \
+          ex3 = SFV16_AND(SFV16_NE(PE, PG), SFV16_NE(PD, PG)); \
+          left = SFV16_AND(act, SFV16_ANDNOT(ex3, SFV16_GT(SFV16_SHL(ke, 1), ki))); \
+          up = SFV16_AND(act, SFV16_ANDNOT(ex2, SFV16_GT(SFV16_SHL(ki, 1), ke))); \
+          px = sfv16_sel(SFV16_GT(twoxbr_vec_df(Y##PE, Y##PF), \
+                   twoxbr_vec_df(Y##PE, Y##PH)), PH, PF); \
+          /* DIA_2X(), or the blend when e <= i. */ \
+          dia = SFV16_OR(SFV16_ANDNOT(SFV16_ANDNOT(act, left), up), \
+                SFV16_ANDNOT(SFV16_ANDNOT(ex, sfv16_ltu(i, e)), act)); \
+          blend = twoxbr_vec_blend_rgb565(E[N2], px, 64); \
+          E[N3] = sfv16_sel(SFV16_AND(left, up), twoxbr_vec_blend_rgb565(E[N3], px, 224), \
+                sfv16_sel(SFV16_OR(left, up), twoxbr_vec_blend_rgb565(E[N3], px, 192), \
+                   sfv16_sel(dia, twoxbr_vec_blend_128_rgb565(E[N3], px), E[N3]))); \
+          E[N1] = sfv16_sel(SFV16_AND(left, up), blend, \
+                sfv16_sel(up, twoxbr_vec_blend_rgb565(E[N1], px, 64), E[N1])); \
+          E[N2] = sfv16_sel(left, blend, E[N2]); \
+     }
+
+#define twoxbr_vec_declare_variables(bits, in) \
+         const sfv##bits##_t A1 = SFV##bits##_LOAD(in - prevline2 - 1); \
+         const sfv##bits##_t B1 = SFV##bits##_LOAD(in - prevline2); \
+         const sfv##bits##_t C1 = SFV##bits##_LOAD(in - prevline2 + 1); \
+         const sfv##bits##_t A0 = SFV##bits##_LOAD(in - prevline - 2); \
+         const sfv##bits##_t PA = SFV##bits##_LOAD(in - prevline - 1); \
+         const sfv##bits##_t PB = SFV##bits##_LOAD(in - prevline); \
+         const sfv##bits##_t PC = SFV##bits##_LOAD(in - prevline + 1); \
+         const sfv##bits##_t C4 = SFV##bits##_LOAD(in - prevline + 2); \
+         const sfv##bits##_t D0 = SFV##bits##_LOAD(in - 2); \
+         const sfv##bits##_t PD = SFV##bits##_LOAD(in - 1); \
+         const sfv##bits##_t PE = SFV##bits##_LOAD(in); \
+         const sfv##bits##_t PF = SFV##bits##_LOAD(in + 1); \
+         const sfv##bits##_t F4 = SFV##bits##_LOAD(in + 2); \
+         const sfv##bits##_t G0 = SFV##bits##_LOAD(in + nextline - 2); \
+         const sfv##bits##_t PG = SFV##bits##_LOAD(in + nextline - 1); \
+         const sfv##bits##_t PH = SFV##bits##_LOAD(in + nextline); \
+         const sfv##bits##_t _PI = SFV##bits##_LOAD(in + nextline + 1); \
+         const sfv##bits##_t I4 = SFV##bits##_LOAD(in + nextline + 2); \
+         const sfv##bits##_t G5 = SFV##bits##_LOAD(in + nextline2 - 1); \
+         const sfv##bits##_t H5 = SFV##bits##_LOAD(in + nextline2); \
+         const sfv##bits##_t I5 = SFV##bits##_LOAD(in + nextline2 + 1)
+
+/* Lanes where any of the four rotations of FILTRO_*() runs. */
+#define twoxbr_vec_active(bits) \
+         SFV##bits##_OR( \
+               SFV##bits##_AND(SFV##bits##_NE(PE, PH), \
+                  SFV##bits##_OR(SFV##bits##_NE(PE, PF), SFV##bits##_NE(PE, PD))), \
+               SFV##bits##_AND(SFV##bits##_NE(PE, PB), \
+                  SFV##bits##_OR(SFV##bits##_NE(PE, PF), SFV##bits##_NE(PE, PD))))
+
+#define twoxbr_vec_store_flat(bits) \
+         SFV##bits##_STORE(out, SFV##bits##_ZIPLO(PE, PE)); \
+         SFV##bits##_STORE(out + 128 / bits, SFV##bits##_ZIPHI(PE, PE)); \
+         SFV##bits##_STORE(out + dst_stride, SFV##bits##_ZIPLO(PE, PE)); \
+         SFV##bits##_STORE(out + dst_stride + 128 / bits, SFV##bits##_ZIPHI(PE, PE))
+
+static void twoxbr_simd_rgb565(void *data, unsigned width, unsigned height,
+      unsigned first_row, unsigned frame_height, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned prevline, prevline2, nextline, nextline2, x;
+
+   if (width < 8)
+   {
+      twoxbr_generic_rgb565(data, width, height, first_row, frame_height,
+            src, src_stride, dst, dst_stride);
+      return;
+   }
+
+   for (; height; height--, first_row++)
+   {
+      /* Clamp to the frame edges. */
+      prevline  = first_row >= 1 ? src_stride : 0;
+      prevline2 = first_row >= 2 ? 2 * src_stride : prevline;
+      nextline  = first_row + 1 < frame_height ? src_stride : 0;
+      nextline2 = first_row + 2 < frame_height ? 2 * src_stride : nextline;
+
+      for (x = 0; x < width; x += 8)
+      {
+         if (x + 8 > width)
+            x = width - 8;
+
+         {
+            const uint16_t *in = src + x;
+            uint16_t *out      = dst + 2 * x;
+            sfv16_t E[4];
+            sfv16_t ex, e, i, ke, ki, ex2, ex3, px, act, left, up, dia, blend;
+            sfv16_t YA1, YB1, YC1, YA0, YPA, YPB, YPC, YC4, YD0, YPD, YPE,
+                    YPF, YF4, YG0, YPG, YPH, Y_PI, YI4, YG5, YH5, YI5;
+            twoxbr_vec_declare_variables(16, in);
+
+            if (!sfv16_any(twoxbr_vec_active(16)))
+            {
+               twoxbr_vec_store_flat(16);
+               continue;
+            }
+
+            YA1  = twoxbr_vec_yuv_rgb565(A1);
+            YB1  = twoxbr_vec_yuv_rgb565(B1);
+            YC1  = twoxbr_vec_yuv_rgb565(C1);
+            YA0  = twoxbr_vec_yuv_rgb565(A0);
+            YPA  = twoxbr_vec_yuv_rgb565(PA);
+            YPB  = twoxbr_vec_yuv_rgb565(PB);
+            YPC  = twoxbr_vec_yuv_rgb565(PC);
+            YC4  = twoxbr_vec_yuv_rgb565(C4);
+            YD0  = twoxbr_vec_yuv_rgb565(D0);
+            YPD  = twoxbr_vec_yuv_rgb565(PD);
+            YPE  = twoxbr_vec_yuv_rgb565(PE);
+            YPF  = twoxbr_vec_yuv_rgb565(PF);
+            YF4  = twoxbr_vec_yuv_rgb565(F4);
+            YG0  = twoxbr_vec_yuv_rgb565(G0);
+            YPG  = twoxbr_vec_yuv_rgb565(PG);
+            YPH  = twoxbr_vec_yuv_rgb565(PH);
+            Y_PI = twoxbr_vec_yuv_rgb565(_PI);
+            YI4  = twoxbr_vec_yuv_rgb565(I4);
+            YG5  = twoxbr_vec_yuv_rgb565(G5);
+            YH5  = twoxbr_vec_yuv_rgb565(H5);
+            YI5  = twoxbr_vec_yuv_rgb565(I5);
+
+            E[0] = E[1] = E[2] = E[3] = PE;
+            FILTRO_VEC_RGB565(PE, _PI, PH, PF, PG, PC, PD, PB, PA, G5, C4, G0, D0, C1, B1, F4, I4, H5, I5, A0, A1, 0, 1, 2, 3);
+            FILTRO_VEC_RGB565(PE, PC, PF, PB, _PI, PA, PH, PD, PG, I4, A1, I5, H5, A0, D0, B1, C1, F4, C4, G5, G0, 2, 0, 3, 1);
+            FILTRO_VEC_RGB565(PE, PA, PB, PD, PC, PG, PF, PH, _PI, C1, G0, C4, F4, G5, H5, D0, A0, B1, A1, I4, I5, 3, 2, 1, 0);
+            FILTRO_VEC_RGB565(PE, PG, PD, PH, PA, _PI, PB, PF, PC, A0, I5, A1, B1, I4, F4, H5, G5, D0, G0, C1, C4, 1, 3, 0, 2);
+
+            SFV16_STORE(out, SFV16_ZIPLO(E[0], E[1]));
+            SFV16_STORE(out + 8, SFV16_ZIPHI(E[0], E[1]));
+            SFV16_STORE(out + dst_stride, SFV16_ZIPLO(E[2], E[3]));
+            SFV16_STORE(out + dst_stride + 8, SFV16_ZIPHI(E[2], E[3]));
+         }
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+
+static void twoxbr_simd_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   uint8_t *out             = (uint8_t*)output + first_row *
+      TWOXBR_SCALE * output_stride;
+   const uint8_t *in        = (const uint8_t*)input + first_row * input_stride;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      twoxbr_simd_rgb565(data, width, rows, first_row, height,
+            (uint16_t*)in, input_stride / SOFTFILTER_BPP_RGB565,
+            (uint16_t*)out, output_stride / SOFTFILTER_BPP_RGB565);
+   else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      twoxbr_generic_xrgb8888(data, width, rows, first_row, height,
+            (uint32_t*)in, input_stride / SOFTFILTER_BPP_XRGB8888,
+            (uint32_t*)out, output_stride / SOFTFILTER_BPP_XRGB8888);
+}
+#endif
+
 static void twoxbr_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = 
@@ -685,7 +918,7 @@ static void twoxbr_work_cb_rgb565(void *data, void *thread_data)
    unsigned height = thr->height;
  
    twoxbr_generic_rgb565(data, width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->frame_height, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565, output,
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
 }
@@ -700,7 +933,7 @@ static void twoxbr_work_cb_xrgb8888(void *data, void *thread_data)
    unsigned height = thr->height;
  
    twoxbr_generic_xrgb8888(data, width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->frame_height, input,
          thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output,
          thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
 }
@@ -732,6 +965,7 @@ static void twoxbr_generic_packets(void *data,
        * pixels outside their given buffer. */
       thr->first = y_start;
       thr->last = y_end == height;
+      thr->frame_height = height;
  
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = twoxbr_work_cb_rgb565;
@@ -745,6 +979,26 @@ static void twoxbr_generic_packets(void *data,
    }
 }
  
+static void twoxbr_generic_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   uint8_t *out             = (uint8_t*)output + first_row * 
+      TWOXBR_SCALE * output_stride;
+   const uint8_t *in        = (const uint8_t*)input + first_row * input_stride;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      twoxbr_generic_rgb565(data, width, rows, first_row, height,
+            (uint16_t*)in, input_stride / SOFTFILTER_BPP_RGB565,
+            (uint16_t*)out, output_stride / SOFTFILTER_BPP_RGB565);
+   else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      twoxbr_generic_xrgb8888(data, width, rows, first_row, height,
+            (uint32_t*)in, input_stride / SOFTFILTER_BPP_XRGB8888,
+            (uint32_t*)out, output_stride / SOFTFILTER_BPP_XRGB8888);
+}
+
 static const struct softfilter_implementation twoxbr_generic = {
    twoxbr_generic_input_fmts,
    twoxbr_generic_output_fmts,
@@ -758,11 +1012,42 @@ static const struct softfilter_implementation twoxbr_generic = {
    SOFTFILTER_API_VERSION,
    "2xBR",
    "2xbr",
+
+   twoxbr_generic_rows,
+   0,
+   2,
+   NULL,
 };
  
+#ifdef SOFTFILTER_VEC_SIMD
+static const struct softfilter_implementation twoxbr_simd = {
+   twoxbr_generic_input_fmts,
+   twoxbr_generic_output_fmts,
+
+   twoxbr_generic_create,
+   twoxbr_generic_destroy,
+
+   twoxbr_generic_threads,
+   twoxbr_generic_output,
+   twoxbr_generic_packets,
+   SOFTFILTER_API_VERSION,
+   "2xBR",
+   "2xbr",
+
+   twoxbr_simd_rows,
+   SOFTFILTER_VEC_SIMD,
+   2,
+   NULL,
+};
+#endif
+
 const struct softfilter_implementation *softfilter_get_implementation(
       softfilter_simd_mask_t simd)
 {
+#ifdef SOFTFILTER_VEC_SIMD
+   if (simd & SOFTFILTER_VEC_SIMD)
+      return &twoxbr_simd;
+#endif
    (void)simd;
    return &twoxbr_generic;
 }
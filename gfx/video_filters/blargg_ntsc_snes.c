@@ -22,6 +22,15 @@
 #include "snes_ntsc/snes_ntsc.h"
 #include "snes_ntsc/snes_ntsc.c"
 
+/* The blitters use vectors when built for them, see snes_ntsc.c. */
+#if defined(__SSE2__)
+#define BLARGG_NTSC_SNES_SIMD SOFTFILTER_SIMD_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define BLARGG_NTSC_SNES_SIMD SOFTFILTER_SIMD_NEON
+#else
+#define BLARGG_NTSC_SNES_SIMD 0
+#endif
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation blargg_ntsc_snes_get_implementation
 #define softfilter_thread_data blargg_ntsc_snes_softfilter_thread_data
@@ -175,8 +184,6 @@ static void blargg_ntsc_snes_render_rgb565(void *data, int width, int height,
    else
       snes_ntsc_blit_hires(filt->ntsc, input, pitch, filt->burst,
             width, height, output, outpitch * 2, first, last);
-
-   filt->burst ^= filt->burst_toggle;
 }
 
 static void blargg_ntsc_snes_rgb565(void *data, unsigned width, unsigned height,
@@ -206,6 +213,39 @@ static void blargg_ntsc_snes_work_cb_rgb565(void *data, void *thread_data)
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
 }
 
+static void blargg_ntsc_snes_generic_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   /* Burst phase advances by one every row. */
+   int burst = (filt->burst + first_row) % snes_ntsc_burst_count;
+   uint16_t *in  = (uint16_t*)((const uint8_t*)input + 
+         first_row * input_stride);
+   uint16_t *out = (uint16_t*)((uint8_t*)output + 
+         first_row * output_stride);
+
+   (void)height;
+
+   if (filt->in_fmt != SOFTFILTER_FMT_RGB565)
+      return;
+
+   if (width <= 256)
+      snes_ntsc_blit(filt->ntsc, in, input_stride / SOFTFILTER_BPP_RGB565,
+            burst, width, rows, out, output_stride, 0, 0);
+   else
+      snes_ntsc_blit_hires(filt->ntsc, in,
+            input_stride / SOFTFILTER_BPP_RGB565,
+            burst, width, rows, out, output_stride, 0, 0);
+}
+
+static void blargg_ntsc_snes_generic_end_frame(void *data)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   filt->burst ^= filt->burst_toggle;
+}
+
 static void blargg_ntsc_snes_generic_packets(void *data,
       struct softfilter_work_packet *packets,
       void *output, size_t output_stride,
@@ -251,6 +291,11 @@ static const struct softfilter_implementation blargg_ntsc_snes_generic = {
    SOFTFILTER_API_VERSION,
    "Blargg NTSC SNES",
    "blargg_ntsc_snes",
+
+   blargg_ntsc_snes_generic_rows,
+   BLARGG_NTSC_SNES_SIMD,
+   0,
+   blargg_ntsc_snes_generic_end_frame,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -265,3 +310,5 @@ const struct softfilter_implementation *softfilter_get_implementation(
 #undef softfilter_thread_data
 #undef filter_data
 #endif
+
+#undef BLARGG_NTSC_SNES_SIMD
@@ -163,6 +163,27 @@ static void darken_packets(void *data,
    }
 }
 
+static void darken_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct softfilter_thread_data thr;
+   struct filter_data *filt = (struct filter_data*)data;
+
+   thr.out_data  = (uint8_t*)output + first_row * output_stride;
+   thr.in_data   = (const uint8_t*)input + first_row * input_stride;
+   thr.out_pitch = output_stride;
+   thr.in_pitch  = input_stride;
+   thr.width     = width;
+   thr.height    = rows;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      darken_work_cb_xrgb8888(data, &thr);
+   else if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      darken_work_cb_rgb565(data, &thr);
+}
+
 static const struct softfilter_implementation darken = {
    darken_input_fmts,
    darken_output_fmts,
@@ -176,6 +197,11 @@ static const struct softfilter_implementation darken = {
    SOFTFILTER_API_VERSION,
    "Darken",
    "darken",
+
+   darken_rows,
+   0,
+   0,
+   NULL,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_vec.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -104,6 +105,48 @@ static void lq2x_generic_destroy(void *data)
    free(filt);
 }
 
+static INLINE void lq2x_pixel_rgb565(uint16_t A, uint16_t B,
+      uint16_t C, uint16_t D, uint16_t E, uint16_t *out0, uint16_t *out1)
+{
+   uint16_t c = C;
+
+   if(A != E && B != D)
+   {
+      out0[0] = (A == B ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
+      out0[1] = (A == D ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
+      out1[0] = (E == B ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
+      out1[1] = (E == D ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
+   }
+   else
+   {
+      out0[0] = c;
+      out0[1] = c;
+      out1[0] = c;
+      out1[1] = c;
+   }
+}
+
+static INLINE void lq2x_pixel_xrgb8888(uint32_t A, uint32_t B,
+      uint32_t C, uint32_t D, uint32_t E, uint32_t *out0, uint32_t *out1)
+{
+   uint32_t c = C;
+
+   if(A != E && B != D)
+   {
+      out0[0] = (A == B ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
+      out0[1] = (A == D ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
+      out1[0] = (E == B ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
+      out1[1] = (E == D ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
+   }
+   else
+   {
+      out0[0] = c;
+      out0[1] = c;
+      out1[0] = c;
+      out1[1] = c;
+   }
+}
+
 static void lq2x_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
@@ -116,33 +159,21 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
    for(y = 0; y < height; y++)
    {
       int prevline, nextline;
-      prevline = (y == 0 ? 0 : src_stride);
-      nextline = (y == height - 1 || last) ? 0 : src_stride;
+      prevline = (y == 0 && first) ? 0 : src_stride;
+      nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
-         uint16_t A, B, C, D, E, c;
+         uint16_t A, B, C, D, E;
          A = *(src - prevline);
          B = (x > 0) ? *(src - 1) : *src;
          C = *src;
          D = (x < width - 1) ? *(src + 1) : *src;
          E = *(src++ + nextline);
-         c = C;
-
-         if(A != E && B != D)
-         {
-            *out0++ = (A == B ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
-            *out0++ = (A == D ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
-            *out1++ = (E == B ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
-            *out1++ = (E == D ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
-         }
-         else
-         {
-            *out0++ = c;
-            *out0++ = c;
-            *out1++ = c;
-            *out1++ = c;
-         }
+
+         lq2x_pixel_rgb565(A, B, C, D, E, out0, out1);
+         out0 += 2;
+         out1 += 2;
       }
 
       src += src_stride - width;
@@ -162,8 +193,8 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -172,22 +203,10 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
          uint32_t C = *src;
          uint32_t D = (x < width - 1) ? *(src + 1) : *src;
          uint32_t E = *(src++ + nextline);
-         uint32_t c = C;
-
-         if(A != E && B != D)
-         {
-            *out0++ = (A == B ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
-            *out0++ = (A == D ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
-            *out1++ = (E == B ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
-            *out1++ = (E == D ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
-         }
-         else
-         {
-            *out0++ = c;
-            *out0++ = c;
-            *out1++ = c;
-            *out1++ = c;
-         }
+
+         lq2x_pixel_xrgb8888(A, B, C, D, E, out0, out1);
+         out0 += 2;
+         out1 += 2;
       }
 
       src += src_stride - width;
@@ -196,6 +215,141 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
    }
 }
 
+#ifdef SOFTFILTER_VEC_SIMD
+/* The vector versions do the columns between the first and the
+ * last one 8 (RGB565) or 4 (XRGB8888) at a time, and the edge
+ * columns, which clamp, like the generic ones. The last vector
+ * of a row overlaps the one before it rather than running past
+ * the row. */
+
+/* (C + A - ((C ^ A) & 0x0821)) >> 1, keeping the bit that
+ * carries out of 16 bits. */
+static INLINE sfv16_t lq2x_blend_rgb565(sfv16_t C, sfv16_t A)
+{
+   return SFV16_ADD(SFV16_AND(C, A), SFV16_SHR(
+            SFV16_ANDNOT(SFV16_XOR(C, A), SFV16_DUP(0x0821)), 1));
+}
+
+static void lq2x_simd_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+
+   if (width < 10)
+   {
+      lq2x_generic_rgb565(width, height, first, last,
+            src, src_stride, dst, dst_stride);
+      return;
+   }
+
+   for(y = 0; y < height; y++)
+   {
+      int prevline    = (y == 0 && first) ? 0 : src_stride;
+      int nextline    = (y == height - 1 && last) ? 0 : src_stride;
+      const uint16_t *in = src + y * src_stride;
+      const uint16_t *up = in - prevline;
+      const uint16_t *down = in + nextline;
+      uint16_t *out0  = dst + 2 * y * dst_stride;
+      uint16_t *out1  = out0 + dst_stride;
+
+      lq2x_pixel_rgb565(up[0], in[0], in[0], in[1],
+            down[0], out0, out1);
+      lq2x_pixel_rgb565(up[width - 1], in[width - 2],
+            in[width - 1], in[width - 1], down[width - 1],
+            out0 + 2 * (width - 1), out1 + 2 * (width - 1));
+
+      for(x = 1; x < width - 1; x += 8)
+      {
+         sfv16_t A, B, C, D, E, CA, CE, edge, o00, o01, o10, o11;
+
+         if (x + 8 > width - 1)
+            x = width - 9;
+
+         A    = SFV16_LOAD(up + x);
+         B    = SFV16_LOAD(in + x - 1);
+         C    = SFV16_LOAD(in + x);
+         D    = SFV16_LOAD(in + x + 1);
+         E    = SFV16_LOAD(down + x);
+         CA   = lq2x_blend_rgb565(C, A);
+         CE   = lq2x_blend_rgb565(C, E);
+         edge = SFV16_NOT(SFV16_OR(SFV16_EQ(A, E), SFV16_EQ(B, D)));
+
+         o00  = sfv16_sel(SFV16_AND(edge, SFV16_EQ(A, B)), CA, C);
+         o01  = sfv16_sel(SFV16_AND(edge, SFV16_EQ(A, D)), CA, C);
+         o10  = sfv16_sel(SFV16_AND(edge, SFV16_EQ(E, B)), CE, C);
+         o11  = sfv16_sel(SFV16_AND(edge, SFV16_EQ(E, D)), CE, C);
+
+         SFV16_STORE(out0 + 2 * x,     SFV16_ZIPLO(o00, o01));
+         SFV16_STORE(out0 + 2 * x + 8, SFV16_ZIPHI(o00, o01));
+         SFV16_STORE(out1 + 2 * x,     SFV16_ZIPLO(o10, o11));
+         SFV16_STORE(out1 + 2 * x + 8, SFV16_ZIPHI(o10, o11));
+      }
+   }
+}
+
+static void lq2x_simd_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src,
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+
+   if (width < 6)
+   {
+      lq2x_generic_xrgb8888(width, height, first, last,
+            src, src_stride, dst, dst_stride);
+      return;
+   }
+
+   for(y = 0; y < height; y++)
+   {
+      int prevline    = (y == 0 && first) ? 0 : src_stride;
+      int nextline    = (y == height - 1 && last) ? 0 : src_stride;
+      const uint32_t *in = src + y * src_stride;
+      const uint32_t *up = in - prevline;
+      const uint32_t *down = in + nextline;
+      uint32_t *out0  = dst + 2 * y * dst_stride;
+      uint32_t *out1  = out0 + dst_stride;
+
+      lq2x_pixel_xrgb8888(up[0], in[0], in[0], in[1],
+            down[0], out0, out1);
+      lq2x_pixel_xrgb8888(up[width - 1], in[width - 2],
+            in[width - 1], in[width - 1], down[width - 1],
+            out0 + 2 * (width - 1), out1 + 2 * (width - 1));
+
+      for(x = 1; x < width - 1; x += 4)
+      {
+         sfv32_t A, B, C, D, E, CA, CE, edge, o00, o01, o10, o11;
+         const sfv32_t mask = SFV32_DUP(0x0421);
+
+         if (x + 4 > width - 1)
+            x = width - 5;
+
+         A    = SFV32_LOAD(up + x);
+         B    = SFV32_LOAD(in + x - 1);
+         C    = SFV32_LOAD(in + x);
+         D    = SFV32_LOAD(in + x + 1);
+         E    = SFV32_LOAD(down + x);
+         CA   = SFV32_SHR(SFV32_SUB(SFV32_ADD(C, A),
+                  SFV32_AND(SFV32_XOR(C, A), mask)), 1);
+         CE   = SFV32_SHR(SFV32_SUB(SFV32_ADD(C, E),
+                  SFV32_AND(SFV32_XOR(C, E), mask)), 1);
+         edge = SFV32_NOT(SFV32_OR(SFV32_EQ(A, E), SFV32_EQ(B, D)));
+
+         o00  = sfv32_sel(SFV32_AND(edge, SFV32_EQ(A, B)), CA, C);
+         o01  = sfv32_sel(SFV32_AND(edge, SFV32_EQ(A, D)), CA, C);
+         o10  = sfv32_sel(SFV32_AND(edge, SFV32_EQ(E, B)), CE, C);
+         o11  = sfv32_sel(SFV32_AND(edge, SFV32_EQ(E, D)), CE, C);
+
+         SFV32_STORE(out0 + 2 * x,     SFV32_ZIPLO(o00, o01));
+         SFV32_STORE(out0 + 2 * x + 4, SFV32_ZIPHI(o00, o01));
+         SFV32_STORE(out1 + 2 * x,     SFV32_ZIPLO(o10, o11));
+         SFV32_STORE(out1 + 2 * x + 4, SFV32_ZIPHI(o10, o11));
+      }
+   }
+}
+#endif
+
 static void lq2x_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = 
@@ -254,7 +408,7 @@ static void lq2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -269,6 +423,52 @@ static void lq2x_generic_packets(void *data,
    }
 }
 
+static void lq2x_generic_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   uint8_t *out             = (uint8_t*)output + first_row *
+      LQ2X_SCALE * output_stride;
+   const uint8_t *in        = (const uint8_t*)input + first_row * input_stride;
+   int first                = first_row == 0;
+   int last                 = first_row + rows == height;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      lq2x_generic_rgb565(width, rows, first, last,
+            (uint16_t*)in, input_stride / SOFTFILTER_BPP_RGB565,
+            (uint16_t*)out, output_stride / SOFTFILTER_BPP_RGB565);
+   else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      lq2x_generic_xrgb8888(width, rows, first, last,
+            (uint32_t*)in, input_stride / SOFTFILTER_BPP_XRGB8888,
+            (uint32_t*)out, output_stride / SOFTFILTER_BPP_XRGB8888);
+}
+
+#ifdef SOFTFILTER_VEC_SIMD
+static void lq2x_simd_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   uint8_t *out             = (uint8_t*)output + first_row *
+      LQ2X_SCALE * output_stride;
+   const uint8_t *in        = (const uint8_t*)input + first_row * input_stride;
+   int first                = first_row == 0;
+   int last                 = first_row + rows == height;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      lq2x_simd_rgb565(width, rows, first, last,
+            (uint16_t*)in, input_stride / SOFTFILTER_BPP_RGB565,
+            (uint16_t*)out, output_stride / SOFTFILTER_BPP_RGB565);
+   else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      lq2x_simd_xrgb8888(width, rows, first, last,
+            (uint32_t*)in, input_stride / SOFTFILTER_BPP_XRGB8888,
+            (uint32_t*)out, output_stride / SOFTFILTER_BPP_XRGB8888);
+}
+#endif
+
 static const struct softfilter_implementation lq2x_generic = {
    lq2x_generic_input_fmts,
    lq2x_generic_output_fmts,
@@ -282,11 +482,42 @@ static const struct softfilter_implementation lq2x_generic = {
    SOFTFILTER_API_VERSION,
    "LQ2x",
    "lq2x",
+
+   lq2x_generic_rows,
+   0,
+   1,
+   NULL,
+};
+
+#ifdef SOFTFILTER_VEC_SIMD
+static const struct softfilter_implementation lq2x_simd = {
+   lq2x_generic_input_fmts,
+   lq2x_generic_output_fmts,
+
+   lq2x_generic_create,
+   lq2x_generic_destroy,
+
+   lq2x_generic_threads,
+   lq2x_generic_output,
+   lq2x_generic_packets,
+   SOFTFILTER_API_VERSION,
+   "LQ2x",
+   "lq2x",
+
+   lq2x_simd_rows,
+   SOFTFILTER_VEC_SIMD,
+   1,
+   NULL,
 };
+#endif
 
 const struct softfilter_implementation *softfilter_get_implementation(
       softfilter_simd_mask_t simd)
 {
+#ifdef SOFTFILTER_VEC_SIMD
+   if (simd & SOFTFILTER_VEC_SIMD)
+      return &lq2x_simd;
+#endif
    (void)simd;
    return &lq2x_generic;
 }
@@ -223,7 +223,7 @@ static void scale2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
@@ -234,6 +234,28 @@ static void scale2x_generic_packets(void *data,
    }
 }
 
+static void scale2x_generic_rows(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride, unsigned first_row, unsigned rows)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   uint8_t *out             = (uint8_t*)output + first_row * 
+      SCALE2X_SCALE * output_stride;
+   const uint8_t *in        = (const uint8_t*)input + first_row * input_stride;
+   int first                = first_row == 0;
+   int last                 = first_row + rows == height;
+
+   if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+      scale2x_generic_rgb565(width, rows, first, last,
+            (const uint16_t*)in, input_stride / SOFTFILTER_BPP_RGB565,
+            (uint16_t*)out, output_stride / SOFTFILTER_BPP_RGB565);
+   else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+      scale2x_generic_xrgb8888(width, rows, first, last,
+            (const uint32_t*)in, input_stride / SOFTFILTER_BPP_XRGB8888,
+            (uint32_t*)out, output_stride / SOFTFILTER_BPP_XRGB8888);
+}
+
 static const struct softfilter_implementation scale2x_generic = {
    scale2x_generic_input_fmts,
    scale2x_generic_output_fmts,
@@ -247,6 +269,11 @@ static const struct softfilter_implementation scale2x_generic = {
    SOFTFILTER_API_VERSION,
    "Scale2x",
    "scale2x",
+
+   scale2x_generic_rows,
+   0,
+   1,
+   NULL,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
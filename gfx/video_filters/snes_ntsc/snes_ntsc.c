@@ -118,6 +118,296 @@ void snes_ntsc_init( snes_ntsc_t* ntsc, snes_ntsc_setup_t const* setup )
 
 #ifndef SNES_NTSC_NO_BLITTERS
 
+#if SNES_NTSC_OUT_DEPTH == 16 && (defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON))
+
+/* Vector blitters. They sum the kernels of a whole chunk, seven output
+pixels, at once and give the same output as the scalar ones below.
+
+Each of the input pixels of a chunk has a slot, and contributes through the
+kernel of the pixel in that slot in this chunk (b), the previous chunk (a)
+and the one before (z). Output pixel x of the chunk gets a [s + x], plus
+z [s + 7 + x] while x < t and b [s - 7 + x] from then on, with s and t fixed
+per slot. Vectors hold pixels 0-3 and 4-7, where pixel 7 is junk that the
+next chunk overwrites. */
+
+#include <retro_inline.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128i snes_ntsc_vec_t;
+
+#define SNES_NTSC_VLOAD( p )    _mm_loadu_si128( (__m128i const*) (p) )
+#define SNES_NTSC_VADD( a, b )  _mm_add_epi32( a, b )
+
+/* lanes z [0], b [0], b [1], b [2] */
+#define SNES_NTSC_VMIX1( z, b ) \
+	_mm_or_si128( _mm_slli_si128( SNES_NTSC_VLOAD( b ), 4 ), _mm_cvtsi32_si128( (z) [0] ) )
+
+/* lanes z [0], z [1], b [0], b [1] */
+#define SNES_NTSC_VMIX2( z, b ) \
+	_mm_unpacklo_epi64( SNES_NTSC_VLOAD( z ), SNES_NTSC_VLOAD( b ) )
+
+/* lanes z [0], z [1], z [2], b [3] */
+#define SNES_NTSC_VMIX3( z, b ) \
+	_mm_or_si128( _mm_and_si128( mask_, SNES_NTSC_VLOAD( z ) ),\
+			_mm_andnot_si128( mask_, SNES_NTSC_VLOAD( b ) ) )
+#define SNES_NTSC_VMASK3_ \
+	__m128i const mask_ = _mm_set_epi32( 0, -1, -1, -1 )
+
+#define SNES_NTSC_VCLAMP_( io, shift ) {\
+	__m128i sub_ = _mm_and_si128( _mm_srli_epi32( io, 9 - (shift) ),\
+			_mm_set1_epi32( snes_ntsc_clamp_mask ) );\
+	__m128i clamp_ = _mm_sub_epi32( _mm_set1_epi32( snes_ntsc_clamp_add ), sub_ );\
+	io = _mm_or_si128( io, clamp_ );\
+	clamp_ = _mm_sub_epi32( clamp_, sub_ );\
+	io = _mm_and_si128( io, clamp_ );\
+}
+
+#define SNES_NTSC_VRGB16_( io, shift ) \
+	_mm_or_si128( _mm_or_si128(\
+		_mm_and_si128( _mm_srli_epi32( io, 13 - (shift) ), _mm_set1_epi32( 0xF800 ) ),\
+		_mm_and_si128( _mm_srli_epi32( io,  8 - (shift) ), _mm_set1_epi32( 0x07E0 ) ) ),\
+		_mm_and_si128( _mm_srli_epi32( io,  4 - (shift) ), _mm_set1_epi32( 0x001F ) ) )
+
+/* Colors fit in 16 bits, so sign extending them keeps the signed pack exact */
+#define SNES_NTSC_VPACK_( lo, hi ) \
+	_mm_packs_epi32( _mm_srai_epi32( _mm_slli_epi32( lo, 16 ), 16 ),\
+			_mm_srai_epi32( _mm_slli_epi32( hi, 16 ), 16 ) )
+
+#define SNES_NTSC_VSTORE8_( out, v ) \
+	_mm_storeu_si128( (__m128i*) (out), v )
+
+#define SNES_NTSC_VSTORE7_( out, v ) {\
+	_mm_storel_epi64( (__m128i*) (out), v );\
+	(out) [4] = (snes_ntsc_out_t) _mm_extract_epi16( v, 4 );\
+	(out) [5] = (snes_ntsc_out_t) _mm_extract_epi16( v, 5 );\
+	(out) [6] = (snes_ntsc_out_t) _mm_extract_epi16( v, 6 );\
+}
+
+typedef __m128i snes_ntsc_vout_t;
+
+#else
+#include <arm_neon.h>
+
+typedef uint32x4_t snes_ntsc_vec_t;
+
+#define SNES_NTSC_VLOAD( p )    vld1q_u32( p )
+#define SNES_NTSC_VADD( a, b )  vaddq_u32( a, b )
+
+#define SNES_NTSC_VMIX1( z, b ) \
+	vextq_u32( vdupq_n_u32( (z) [0] ), SNES_NTSC_VLOAD( b ), 3 )
+
+#define SNES_NTSC_VMIX2( z, b ) \
+	vcombine_u32( vld1_u32( z ), vld1_u32( b ) )
+
+#define SNES_NTSC_VMIX3( z, b ) \
+	vbslq_u32( mask_, SNES_NTSC_VLOAD( z ), SNES_NTSC_VLOAD( b ) )
+#define SNES_NTSC_VMASK3_ \
+	static uint32_t const mask_bits_ [4] = { ~0u, ~0u, ~0u, 0 };\
+	uint32x4_t const mask_ = vld1q_u32( mask_bits_ )
+
+#define SNES_NTSC_VCLAMP_( io, shift ) {\
+	uint32x4_t sub_ = vandq_u32( vshrq_n_u32( io, 9 - (shift) ),\
+			vdupq_n_u32( snes_ntsc_clamp_mask ) );\
+	uint32x4_t clamp_ = vsubq_u32( vdupq_n_u32( snes_ntsc_clamp_add ), sub_ );\
+	io = vorrq_u32( io, clamp_ );\
+	clamp_ = vsubq_u32( clamp_, sub_ );\
+	io = vandq_u32( io, clamp_ );\
+}
+
+#define SNES_NTSC_VRGB16_( io, shift ) \
+	vorrq_u32( vorrq_u32(\
+		vandq_u32( vshrq_n_u32( io, 13 - (shift) ), vdupq_n_u32( 0xF800 ) ),\
+		vandq_u32( vshrq_n_u32( io,  8 - (shift) ), vdupq_n_u32( 0x07E0 ) ) ),\
+		vandq_u32( vshrq_n_u32( io,  4 - (shift) ), vdupq_n_u32( 0x001F ) ) )
+
+#define SNES_NTSC_VPACK_( lo, hi ) \
+	vcombine_u16( vmovn_u32( lo ), vmovn_u32( hi ) )
+
+#define SNES_NTSC_VSTORE8_( out, v ) \
+	vst1q_u16( (uint16_t*) (out), v )
+
+#define SNES_NTSC_VSTORE7_( out, v ) {\
+	vst1_u16( (uint16_t*) (out), vget_low_u16( v ) );\
+	vst1q_lane_u16( (uint16_t*) (out) + 4, v, 4 );\
+	vst1q_lane_u16( (uint16_t*) (out) + 5, v, 5 );\
+	vst1q_lane_u16( (uint16_t*) (out) + 6, v, 6 );\
+}
+
+typedef uint16x8_t snes_ntsc_vout_t;
+
+#endif
+
+/* Adds the kernels of a slot to pixels 0-7 */
+#define SNES_NTSC_VSLOT( s, t, a, z, b ) {\
+	lo = SNES_NTSC_VADD( lo, SNES_NTSC_VADD( SNES_NTSC_VLOAD( (a) + (s) ),\
+			SNES_NTSC_VMIX_LO_##t( (z) + (s) + 7, (b) + ((s) - 7 + (t)) ) ) );\
+	hi = SNES_NTSC_VADD( hi, SNES_NTSC_VADD( SNES_NTSC_VLOAD( (a) + (s) + 4 ),\
+			SNES_NTSC_VMIX_HI_##t( (z) + (s) + 11, (b) + ((s) - 7 + (t)) ) ) );\
+}
+
+/* b points at the pixel of b that lane t takes */
+#define SNES_NTSC_VMIX_LO_0( z, b ) SNES_NTSC_VLOAD( b )
+#define SNES_NTSC_VMIX_LO_1( z, b ) SNES_NTSC_VMIX1( z, b )
+#define SNES_NTSC_VMIX_LO_2( z, b ) SNES_NTSC_VMIX2( z, b )
+#define SNES_NTSC_VMIX_LO_3( z, b ) SNES_NTSC_VMIX3( z, (b) - 3 )
+#define SNES_NTSC_VMIX_LO_4( z, b ) SNES_NTSC_VLOAD( z )
+#define SNES_NTSC_VMIX_LO_5( z, b ) SNES_NTSC_VLOAD( z )
+#define SNES_NTSC_VMIX_HI_0( z, b ) SNES_NTSC_VLOAD( (b) + 4 )
+#define SNES_NTSC_VMIX_HI_1( z, b ) SNES_NTSC_VLOAD( (b) + 3 )
+#define SNES_NTSC_VMIX_HI_2( z, b ) SNES_NTSC_VLOAD( (b) + 2 )
+#define SNES_NTSC_VMIX_HI_3( z, b ) SNES_NTSC_VLOAD( (b) + 1 )
+#define SNES_NTSC_VMIX_HI_4( z, b ) SNES_NTSC_VLOAD( b )
+#define SNES_NTSC_VMIX_HI_5( z, b ) SNES_NTSC_VMIX1( z, b )
+
+#define SNES_NTSC_VKERNEL( ktable, n ) \
+	SNES_NTSC_IN_FORMAT( ktable, n )
+
+static INLINE snes_ntsc_vout_t snes_ntsc_vchunk_( snes_ntsc_rgb_t const* const* a,
+		snes_ntsc_rgb_t const* const* z, snes_ntsc_rgb_t const* const* b )
+{
+	snes_ntsc_vec_t lo = SNES_NTSC_VLOAD( b [0] );
+	snes_ntsc_vec_t hi = SNES_NTSC_VLOAD( b [0] + 4 );
+	lo = SNES_NTSC_VADD( lo, SNES_NTSC_VLOAD( a [0] + 7 ) );
+	hi = SNES_NTSC_VADD( hi, SNES_NTSC_VLOAD( a [0] + 11 ) );
+	SNES_NTSC_VSLOT( 19, 2, a [1], z [1], b [1] );
+	SNES_NTSC_VSLOT( 31, 4, a [2], z [2], b [2] );
+	SNES_NTSC_VCLAMP_( lo, 1 );
+	SNES_NTSC_VCLAMP_( hi, 1 );
+	return SNES_NTSC_VPACK_( SNES_NTSC_VRGB16_( lo, 1 ), SNES_NTSC_VRGB16_( hi, 1 ) );
+}
+
+static INLINE snes_ntsc_vout_t snes_ntsc_vchunk_hires_( snes_ntsc_rgb_t const* const* a,
+		snes_ntsc_rgb_t const* const* z, snes_ntsc_rgb_t const* const* b )
+{
+	SNES_NTSC_VMASK3_;
+	snes_ntsc_vec_t lo = SNES_NTSC_VLOAD( b [0] );
+	snes_ntsc_vec_t hi = SNES_NTSC_VLOAD( b [0] + 4 );
+	lo = SNES_NTSC_VADD( lo, SNES_NTSC_VLOAD( a [0] + 7 ) );
+	hi = SNES_NTSC_VADD( hi, SNES_NTSC_VLOAD( a [0] + 11 ) );
+	SNES_NTSC_VSLOT(  6, 1, a [1], z [1], b [1] );
+	SNES_NTSC_VSLOT( 19, 2, a [2], z [2], b [2] );
+	SNES_NTSC_VSLOT( 18, 3, a [3], z [3], b [3] );
+	SNES_NTSC_VSLOT( 31, 4, a [4], z [4], b [4] );
+	SNES_NTSC_VSLOT( 30, 5, a [5], z [5], b [5] );
+	SNES_NTSC_VCLAMP_( lo, 0 );
+	SNES_NTSC_VCLAMP_( hi, 0 );
+	return SNES_NTSC_VPACK_( SNES_NTSC_VRGB16_( lo, 0 ), SNES_NTSC_VRGB16_( hi, 0 ) );
+}
+
+void snes_ntsc_blit( snes_ntsc_t const* ntsc, SNES_NTSC_IN_T const* input, long in_row_width,
+		int burst_phase, int in_width, int in_height, void* rgb_out, long out_pitch, int first, int last )
+{
+	int chunk_count = (in_width - 1) / snes_ntsc_in_chunk;
+	for ( ; in_height; --in_height )
+	{
+		char const* ktable =
+				(char const*) ntsc->table + burst_phase * (snes_ntsc_burst_size * sizeof (snes_ntsc_rgb_t));
+		snes_ntsc_rgb_t const* black = SNES_NTSC_VKERNEL( ktable, snes_ntsc_black );
+		snes_ntsc_rgb_t const* k [3 * 3];
+		SNES_NTSC_IN_T const* line_in = input;
+		snes_ntsc_out_t* line_out = (snes_ntsc_out_t*) rgb_out;
+		/* k holds z, a and b of each slot, in that order */
+		snes_ntsc_rgb_t const** z = k;
+		snes_ntsc_rgb_t const** a = k + 3;
+		snes_ntsc_rgb_t const** b = k + 6;
+		unsigned color = SNES_NTSC_ADJ_IN( line_in [0] );
+		int n;
+		z [0] = z [1] = z [2] = a [0] = a [1] = black;
+		a [2] = SNES_NTSC_VKERNEL( ktable, color );
+		++line_in;
+		
+		for ( n = chunk_count; n; --n )
+		{
+			snes_ntsc_rgb_t const** t = z;
+			snes_ntsc_vout_t v;
+			color = SNES_NTSC_ADJ_IN( line_in [0] );
+			b [0] = SNES_NTSC_VKERNEL( ktable, color );
+			color = SNES_NTSC_ADJ_IN( line_in [1] );
+			b [1] = SNES_NTSC_VKERNEL( ktable, color );
+			color = SNES_NTSC_ADJ_IN( line_in [2] );
+			b [2] = SNES_NTSC_VKERNEL( ktable, color );
+			v = snes_ntsc_vchunk_( a, z, b );
+			SNES_NTSC_VSTORE8_( line_out, v );
+			z = a;
+			a = b;
+			b = t;
+			line_in  += 3;
+			line_out += 7;
+		}
+		
+		/* finish final pixels */
+		b [0] = b [1] = b [2] = black;
+		{
+			snes_ntsc_vout_t v = snes_ntsc_vchunk_( a, z, b );
+			SNES_NTSC_VSTORE7_( line_out, v );
+		}
+		
+		burst_phase = (burst_phase + 1) % snes_ntsc_burst_count;
+		input += in_row_width;
+		rgb_out = (char*) rgb_out + out_pitch;
+	}
+}
+
+void snes_ntsc_blit_hires( snes_ntsc_t const* ntsc, SNES_NTSC_IN_T const* input, long in_row_width,
+		int burst_phase, int in_width, int in_height, void* rgb_out, long out_pitch, int first, int last )
+{
+	int chunk_count = (in_width - 2) / (snes_ntsc_in_chunk * 2);
+	for ( ; in_height; --in_height )
+	{
+		char const* ktable =
+				(char const*) ntsc->table + burst_phase * (snes_ntsc_burst_size * sizeof (snes_ntsc_rgb_t));
+		snes_ntsc_rgb_t const* black = SNES_NTSC_VKERNEL( ktable, snes_ntsc_black );
+		snes_ntsc_rgb_t const* k [6 * 3];
+		SNES_NTSC_IN_T const* line_in = input;
+		snes_ntsc_out_t* line_out = (snes_ntsc_out_t*) rgb_out;
+		snes_ntsc_rgb_t const** z = k;
+		snes_ntsc_rgb_t const** a = k + 6;
+		snes_ntsc_rgb_t const** b = k + 12;
+		unsigned color;
+		int n, i;
+		for ( i = 0; i < 6; i++ )
+			z [i] = a [i] = black;
+		color = SNES_NTSC_ADJ_IN( line_in [0] );
+		a [4] = SNES_NTSC_VKERNEL( ktable, color );
+		color = SNES_NTSC_ADJ_IN( line_in [1] );
+		a [5] = SNES_NTSC_VKERNEL( ktable, color );
+		line_in += 2;
+		
+		for ( n = chunk_count; n; --n )
+		{
+			snes_ntsc_rgb_t const** t = z;
+			snes_ntsc_vout_t v;
+			for ( i = 0; i < 6; i++ )
+			{
+				color = SNES_NTSC_ADJ_IN( line_in [i] );
+				b [i] = SNES_NTSC_VKERNEL( ktable, color );
+			}
+			v = snes_ntsc_vchunk_hires_( a, z, b );
+			SNES_NTSC_VSTORE8_( line_out, v );
+			z = a;
+			a = b;
+			b = t;
+			line_in  += 6;
+			line_out += 7;
+		}
+		
+		for ( i = 0; i < 6; i++ )
+			b [i] = black;
+		{
+			snes_ntsc_vout_t v = snes_ntsc_vchunk_hires_( a, z, b );
+			SNES_NTSC_VSTORE7_( line_out, v );
+		}
+		
+		burst_phase = (burst_phase + 1) % snes_ntsc_burst_count;
+		input += in_row_width;
+		rgb_out = (char*) rgb_out + out_pitch;
+	}
+}
+
+#else
+
 void snes_ntsc_blit( snes_ntsc_t const* ntsc, SNES_NTSC_IN_T const* input, long in_row_width,
 		int burst_phase, int in_width, int in_height, void* rgb_out, long out_pitch, int first, int last )
 {
@@ -240,3 +530,5 @@ void snes_ntsc_blit_hires( snes_ntsc_t const* ntsc, SNES_NTSC_IN_T const* input,
 #endif
 
 #endif
+
+#endif
@@ -92,7 +92,11 @@ typedef const struct softfilter_implementation
 const struct softfilter_implementation *softfilter_get_implementation(
       softfilter_simd_mask_t simd);
 
-#define SOFTFILTER_API_VERSION  2
+#define SOFTFILTER_API_VERSION  4
+
+/* Oldest API version the host can still load. 
+ * Older implementations lack the fields added after their version. */
+#define SOFTFILTER_API_VERSION_MIN 2
 
 /* Required base color formats */
 
@@ -159,6 +163,26 @@ typedef void (*softfilter_get_work_packets_t)(void *data,
  * compared to the value passed to create(). */
 typedef unsigned (*softfilter_query_num_threads_t)(void *data);
 
+/* Processes input rows [first_row, first_row + rows) of a frame 
+ * into the corresponding output rows. @input, @output and @height 
+ * always describe the whole frame, so rows outside the band can 
+ * be read for context.
+ *
+ * The host splits each frame into many more bands than it has 
+ * threads and hands them out to whichever thread is idle, so this 
+ * gets called concurrently, in any order, and must not modify 
+ * filter state. When set, the host uses this instead of 
+ * get_work_packets. */
+typedef void (*softfilter_process_rows_t)(void *data,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, 
+      size_t input_stride, unsigned first_row, unsigned rows);
+
+/* Called once after all rows of a frame have been processed, 
+ * so the filter can advance per-frame state (field phase, etc). 
+ * process_rows must only read such state. */
+typedef void (*softfilter_end_frame_t)(void *data);
+
 struct softfilter_implementation
 {
    softfilter_query_input_formats_t query_input_formats;
@@ -178,6 +202,25 @@ struct softfilter_implementation
    /* Computer-friendly short version of ident.
     * Lower case, no spaces and special characters, etc. */
    const char *short_ident;
+
+   /* Fields below were added in API version 3. */
+
+   /* Optional. Tile-based replacement for get_work_packets. */
+   softfilter_process_rows_t process_rows;
+
+   /* SOFTFILTER_SIMD_* instruction sets this implementation uses.
+    * The host refuses it if the CPU lacks any of them. */
+   softfilter_simd_mask_t simd;
+
+   /* Fields below were added in API version 4. */
+
+   /* Number of input rows above and below a band that process_rows 
+    * reads. Lets the host chain filters band by band without 
+    * full-frame intermediate buffers. */
+   unsigned context_rows;
+
+   /* Optional. */
+   softfilter_end_frame_t end_frame;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,181 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFTFILTER_VEC_H__
+#define SOFTFILTER_VEC_H__
+
+/* 128-bit vectors for softfilters, on SSE2 or NEON.
+ *
+ * SFV16_* work on 8 lanes of 16 bits (RGB565 pixels),
+ * SFV32_* on 4 lanes of 32 bits (XRGB8888 pixels).
+ * Comparisons give all ones in lanes where they hold, which
+ * sfv16_sel() and sfv32_sel() use to pick between two vectors.
+ *
+ * SOFTFILTER_VEC_SIMD is the SOFTFILTER_SIMD_* flag of the
+ * instruction set used, and is left undefined when there is
+ * none. Filters return their vector implementation from
+ * softfilter_get_implementation() when the host has it. */
+
+#include <stdint.h>
+#include <retro_inline.h>
+
+#include "softfilter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+#define SOFTFILTER_VEC_SIMD SOFTFILTER_SIMD_SSE2
+
+typedef __m128i sfv16_t;
+typedef __m128i sfv32_t;
+
+#define SFV16_LOAD(p)        _mm_loadu_si128((const __m128i*)(p))
+#define SFV16_STORE(p, v)    _mm_storeu_si128((__m128i*)(p), v)
+#define SFV16_DUP(x)         _mm_set1_epi16((short)(x))
+#define SFV16_AND(a, b)      _mm_and_si128(a, b)
+#define SFV16_OR(a, b)       _mm_or_si128(a, b)
+#define SFV16_XOR(a, b)      _mm_xor_si128(a, b)
+/* a & ~b */
+#define SFV16_ANDNOT(a, b)   _mm_andnot_si128(b, a)
+#define SFV16_ADD(a, b)      _mm_add_epi16(a, b)
+#define SFV16_SUB(a, b)      _mm_sub_epi16(a, b)
+#define SFV16_MUL(a, b)      _mm_mullo_epi16(a, b)
+#define SFV16_SHR(v, n)      _mm_srli_epi16(v, n)
+#define SFV16_SHL(v, n)      _mm_slli_epi16(v, n)
+#define SFV16_SRA(v, n)      _mm_srai_epi16(v, n)
+#define SFV16_EQ(a, b)       _mm_cmpeq_epi16(a, b)
+#define SFV16_LT(a, b)       _mm_cmplt_epi16(a, b)
+#define SFV16_GT(a, b)       _mm_cmpgt_epi16(a, b)
+#define SFV16_ZIPLO(a, b)    _mm_unpacklo_epi16(a, b)
+#define SFV16_ZIPHI(a, b)    _mm_unpackhi_epi16(a, b)
+
+#define SFV32_LOAD(p)        _mm_loadu_si128((const __m128i*)(p))
+#define SFV32_STORE(p, v)    _mm_storeu_si128((__m128i*)(p), v)
+#define SFV32_DUP(x)         _mm_set1_epi32((int)(x))
+#define SFV32_AND(a, b)      _mm_and_si128(a, b)
+#define SFV32_OR(a, b)       _mm_or_si128(a, b)
+#define SFV32_XOR(a, b)      _mm_xor_si128(a, b)
+#define SFV32_ANDNOT(a, b)   _mm_andnot_si128(b, a)
+#define SFV32_ADD(a, b)      _mm_add_epi32(a, b)
+#define SFV32_SUB(a, b)      _mm_sub_epi32(a, b)
+#define SFV32_SHR(v, n)      _mm_srli_epi32(v, n)
+#define SFV32_SHL(v, n)      _mm_slli_epi32(v, n)
+#define SFV32_EQ(a, b)       _mm_cmpeq_epi32(a, b)
+#define SFV32_LT(a, b)       _mm_cmplt_epi32(a, b)
+#define SFV32_GT(a, b)       _mm_cmpgt_epi32(a, b)
+#define SFV32_ZIPLO(a, b)    _mm_unpacklo_epi32(a, b)
+#define SFV32_ZIPHI(a, b)    _mm_unpackhi_epi32(a, b)
+
+static INLINE sfv16_t sfv16_sel(sfv16_t mask, sfv16_t a, sfv16_t b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static INLINE sfv16_t sfv16_ltu(sfv16_t a, sfv16_t b)
+{
+   const __m128i bias = _mm_set1_epi16((short)0x8000);
+   return _mm_cmplt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+static INLINE int sfv16_any(sfv16_t mask)
+{
+   return _mm_movemask_epi8(mask) != 0;
+}
+
+#define sfv32_sel sfv16_sel
+#define sfv32_any sfv16_any
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#define SOFTFILTER_VEC_SIMD SOFTFILTER_SIMD_NEON
+
+typedef uint16x8_t sfv16_t;
+typedef uint32x4_t sfv32_t;
+
+#define SFV16_LOAD(p)        vld1q_u16((const uint16_t*)(p))
+#define SFV16_STORE(p, v)    vst1q_u16((uint16_t*)(p), v)
+#define SFV16_DUP(x)         vdupq_n_u16((uint16_t)(x))
+#define SFV16_AND(a, b)      vandq_u16(a, b)
+#define SFV16_OR(a, b)       vorrq_u16(a, b)
+#define SFV16_XOR(a, b)      veorq_u16(a, b)
+#define SFV16_ANDNOT(a, b)   vbicq_u16(a, b)
+#define SFV16_ADD(a, b)      vaddq_u16(a, b)
+#define SFV16_SUB(a, b)      vsubq_u16(a, b)
+#define SFV16_MUL(a, b)      vmulq_u16(a, b)
+#define SFV16_SHR(v, n)      vshrq_n_u16(v, n)
+#define SFV16_SHL(v, n)      vshlq_n_u16(v, n)
+#define SFV16_SRA(v, n)      vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(v), n))
+#define SFV16_EQ(a, b)       vceqq_u16(a, b)
+#define SFV16_LT(a, b)       vcltq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b))
+#define SFV16_GT(a, b)       vcgtq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b))
+#define SFV16_ZIPLO(a, b)    vzipq_u16(a, b).val[0]
+#define SFV16_ZIPHI(a, b)    vzipq_u16(a, b).val[1]
+
+#define SFV32_LOAD(p)        vld1q_u32((const uint32_t*)(p))
+#define SFV32_STORE(p, v)    vst1q_u32((uint32_t*)(p), v)
+#define SFV32_DUP(x)         vdupq_n_u32((uint32_t)(x))
+#define SFV32_AND(a, b)      vandq_u32(a, b)
+#define SFV32_OR(a, b)       vorrq_u32(a, b)
+#define SFV32_XOR(a, b)      veorq_u32(a, b)
+#define SFV32_ANDNOT(a, b)   vbicq_u32(a, b)
+#define SFV32_ADD(a, b)      vaddq_u32(a, b)
+#define SFV32_SUB(a, b)      vsubq_u32(a, b)
+#define SFV32_SHR(v, n)      vshrq_n_u32(v, n)
+#define SFV32_SHL(v, n)      vshlq_n_u32(v, n)
+#define SFV32_EQ(a, b)       vceqq_u32(a, b)
+#define SFV32_LT(a, b)       vcltq_s32(vreinterpretq_s32_u32(a), vreinterpretq_s32_u32(b))
+#define SFV32_GT(a, b)       vcgtq_s32(vreinterpretq_s32_u32(a), vreinterpretq_s32_u32(b))
+#define SFV32_ZIPLO(a, b)    vzipq_u32(a, b).val[0]
+#define SFV32_ZIPHI(a, b)    vzipq_u32(a, b).val[1]
+
+static INLINE sfv16_t sfv16_sel(sfv16_t mask, sfv16_t a, sfv16_t b)
+{
+   return vbslq_u16(mask, a, b);
+}
+
+static INLINE sfv16_t sfv16_ltu(sfv16_t a, sfv16_t b)
+{
+   return vcltq_u16(a, b);
+}
+
+static INLINE int sfv16_any(sfv16_t mask)
+{
+   uint32x2_t m = vreinterpret_u32_u16(
+         vorr_u16(vget_low_u16(mask), vget_high_u16(mask)));
+   return (vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) != 0;
+}
+
+static INLINE sfv32_t sfv32_sel(sfv32_t mask, sfv32_t a, sfv32_t b)
+{
+   return vbslq_u32(mask, a, b);
+}
+
+static INLINE int sfv32_any(sfv32_t mask)
+{
+   return sfv16_any(vreinterpretq_u16_u32(mask));
+}
+
+#endif
+
+#ifdef SOFTFILTER_VEC_SIMD
+#define SFV16_NOT(a)         SFV16_XOR(a, SFV16_DUP(0xffff))
+#define SFV16_NE(a, b)       SFV16_NOT(SFV16_EQ(a, b))
+#define SFV32_NOT(a)         SFV32_XOR(a, SFV32_DUP(0xffffffff))
+#define SFV32_NE(a, b)       SFV32_NOT(SFV32_EQ(a, b))
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 // Compile: gcc -o supereagle.so -shared supereagle.c -std=c99 -O3 -Wall -pedantic -fPIC
 
 #include "softfilter.h"
+#include "softfilter_vec.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -263,6 +264,209 @@ static void supereagle_generic_rgb565(unsigned width, unsigned height,
    }
 }
 
+#ifdef SOFTFILTER_VEC_SIMD
+/* Vector versions, 8 (RGB565) or 4 (XRGB8888) pixels at a time.
+ * Every case is computed and the result picked per lane. The
+ * last vector of a row overlaps the one before it rather than
+ * running past the row. */
+
+static INLINE sfv16_t supereagle_vec_interpolate_rgb565(sfv16_t A, sfv16_t B)
+{
+   const sfv16_t hi = SFV16_DUP(0xF7DE);
+   return SFV16_ADD(SFV16_ADD(SFV16_SHR(SFV16_AND(A, hi), 1),
+            SFV16_SHR(SFV16_AND(B, hi), 1)),
+         SFV16_AND(SFV16_AND(A, B), SFV16_DUP(0x0821)));
+}
+
+static INLINE sfv16_t supereagle_vec_interpolate2_rgb565(sfv16_t A, sfv16_t B,
+      sfv16_t C, sfv16_t D)
+{
+   const sfv16_t hi = SFV16_DUP(0xE79C);
+   const sfv16_t lo = SFV16_DUP(0x1863);
+   sfv16_t sum_hi = SFV16_ADD(
+         SFV16_ADD(SFV16_SHR(SFV16_AND(A, hi), 2), SFV16_SHR(SFV16_AND(B, hi), 2)),
+         SFV16_ADD(SFV16_SHR(SFV16_AND(C, hi), 2), SFV16_SHR(SFV16_AND(D, hi), 2)));
+   sfv16_t sum_lo = SFV16_ADD(
+         SFV16_ADD(SFV16_AND(A, lo), SFV16_AND(B, lo)),
+         SFV16_ADD(SFV16_AND(C, lo), SFV16_AND(D, lo)));
+   return SFV16_ADD(sum_hi, SFV16_AND(SFV16_SHR(sum_lo, 2), lo));
+}
+
+static INLINE sfv32_t supereagle_vec_interpolate_xrgb8888(sfv32_t A, sfv32_t B)
+{
+   const sfv32_t hi = SFV32_DUP(0xFEFEFEFE);
+   return SFV32_ADD(SFV32_ADD(SFV32_SHR(SFV32_AND(A, hi), 1),
+            SFV32_SHR(SFV32_AND(B, hi), 1)),
+         SFV32_AND(SFV32_AND(A, B), SFV32_DUP(0x01010101)));
+}
+
+static INLINE sfv32_t supereagle_vec_interpolate2_xrgb8888(sfv32_t A, sfv32_t B,
+      sfv32_t C, sfv32_t D)
+{
+   const sfv32_t hi = SFV32_DUP(0xFCFCFCFC);
+   const sfv32_t lo = SFV32_DUP(0x03030303);
+   sfv32_t sum_hi = SFV32_ADD(
+         SFV32_ADD(SFV32_SHR(SFV32_AND(A, hi), 2), SFV32_SHR(SFV32_AND(B, hi), 2)),
+         SFV32_ADD(SFV32_SHR(SFV32_AND(C, hi), 2), SFV32_SHR(SFV32_AND(D, hi), 2)));
+   sfv32_t sum_lo = SFV32_ADD(
+         SFV32_ADD(SFV32_AND(A, lo), SFV32_AND(B, lo)),
+         SFV32_ADD(SFV32_AND(C, lo), SFV32_AND(D, lo)));
+   return SFV32_ADD(sum_hi, SFV32_AND(SFV32_SHR(sum_lo, 2), lo));
+}
+
+/* supereagle_result() of each lane. Masks are -1 where they
+ * hold, so B's mask minus A's is A's flag minus B's. */
+#define supereagle_vec_result(bits, A, B, C, D) \
+   SFV##bits##_SUB( \
+         SFV##bits##_OR(SFV##bits##_NE(B, C), SFV##bits##_NE(B, D)), \
+         SFV##bits##_OR(SFV##bits##_NE(A, C), SFV##bits##_NE(A, D)))
+
+#define supereagle_vec_declare_variables(bits, in, nextline) \
+         sfv##bits##_t product1a, product1b, product2a, product2b; \
+         sfv##bits##_t mask, r, i56; \
+         const sfv##bits##_t colorB1 = SFV##bits##_LOAD(in - nextline + 0); \
+         const sfv##bits##_t colorB2 = SFV##bits##_LOAD(in - nextline + 1); \
+         const sfv##bits##_t color4  = SFV##bits##_LOAD(in - 1); \
+         const sfv##bits##_t color5  = SFV##bits##_LOAD(in + 0); \
+         const sfv##bits##_t color6  = SFV##bits##_LOAD(in + 1); \
+         const sfv##bits##_t colorS2 = SFV##bits##_LOAD(in + 2); \
+         const sfv##bits##_t color1  = SFV##bits##_LOAD(in + nextline - 1); \
+         const sfv##bits##_t color2  = SFV##bits##_LOAD(in + nextline + 0); \
+         const sfv##bits##_t color3  = SFV##bits##_LOAD(in + nextline + 1); \
+         const sfv##bits##_t colorS1 = SFV##bits##_LOAD(in + nextline + 2); \
+         const sfv##bits##_t colorA1 = SFV##bits##_LOAD(in + nextline + nextline + 0); \
+         const sfv##bits##_t colorA2 = SFV##bits##_LOAD(in + nextline + nextline + 1); \
+         const sfv##bits##_t eq26    = SFV##bits##_EQ(color2, color6); \
+         const sfv##bits##_t eq53    = SFV##bits##_EQ(color5, color3); \
+         const sfv##bits##_t zero    = SFV##bits##_DUP(0)
+
+#define supereagle_vec_function(bits, interpolate_cb, interpolate2_cb) \
+         /* neither */ \
+         product2b = interpolate_cb(color2, color6); \
+         product1a = interpolate2_cb(color5, color5, color5, product2b); \
+         product2b = interpolate2_cb(color3, color3, color3, product2b); \
+         product2a = interpolate_cb(color5, color3); \
+         product1b = interpolate2_cb(color6, color6, color6, product2a); \
+         product2a = interpolate2_cb(color2, color2, color2, product2a); \
+         /* color5 == color3 && color2 == color6 */ \
+         i56  = interpolate_cb(color5, color6); \
+         r    = supereagle_vec_result(bits, color6, color5, color1, colorA1); \
+         r    = SFV##bits##_ADD(r, supereagle_vec_result(bits, color6, color5, color4, colorB1)); \
+         r    = SFV##bits##_ADD(r, supereagle_vec_result(bits, color6, color5, colorA2, colorS1)); \
+         r    = SFV##bits##_ADD(r, supereagle_vec_result(bits, color6, color5, colorB2, colorS2)); \
+         mask = SFV##bits##_AND(eq53, eq26); \
+         product1b = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_LT(r, zero), i56, color2), product1b); \
+         product2a = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_LT(r, zero), i56, color2), product2a); \
+         product1a = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_GT(r, zero), i56, color5), product1a); \
+         product2b = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_GT(r, zero), i56, color5), product2b); \
+         /* color5 == color3 && color2 != color6 */ \
+         mask = SFV##bits##_ANDNOT(eq53, eq26); \
+         product1a = sfv##bits##_sel(mask, color5, product1a); \
+         product2b = sfv##bits##_sel(mask, color5, product2b); \
+         product1b = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_OR(SFV##bits##_EQ(colorB1, color5), \
+                     SFV##bits##_EQ(color3, colorS1)), \
+                  interpolate_cb(color5, i56), i56), product1b); \
+         product2a = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_OR(SFV##bits##_EQ(color3, colorA2), \
+                     SFV##bits##_EQ(color4, color5)), \
+                  interpolate_cb(color5, interpolate_cb(color5, color2)), \
+                  interpolate_cb(color2, color3)), product2a); \
+         /* color2 == color6 && color5 != color3 */ \
+         mask = SFV##bits##_ANDNOT(eq26, eq53); \
+         product1b = sfv##bits##_sel(mask, color2, product1b); \
+         product2a = sfv##bits##_sel(mask, color2, product2a); \
+         product1a = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_OR(SFV##bits##_EQ(color1, color2), \
+                     SFV##bits##_EQ(color6, colorB2)), \
+                  interpolate_cb(color2, interpolate_cb(color2, color5)), i56), product1a); \
+         r    = interpolate_cb(color2, color3); \
+         product2b = sfv##bits##_sel(mask, \
+               sfv##bits##_sel(SFV##bits##_OR(SFV##bits##_EQ(color6, colorS2), \
+                     SFV##bits##_EQ(color2, colorA1)), \
+                  interpolate_cb(color2, r), r), product2b); \
+         SFV##bits##_STORE(out, SFV##bits##_ZIPLO(product1a, product1b)); \
+         SFV##bits##_STORE(out + 128 / bits, SFV##bits##_ZIPHI(product1a, product1b)); \
+         SFV##bits##_STORE(out + dst_stride, SFV##bits##_ZIPLO(product2a, product2b)); \
+         SFV##bits##_STORE(out + dst_stride + 128 / bits, SFV##bits##_ZIPHI(product2a, product2b))
+
+static void supereagle_simd_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src,
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned nextline, x;
+
+   if (width < 4)
+   {
+      supereagle_generic_xrgb8888(width, height, first, last,
+            src, src_stride, dst, dst_stride);
+      return;
+   }
+
+   nextline = (last) ? 0 : src_stride;
+
+   for (; height; height--)
+   {
+      for (x = 0; x < width; x += 4)
+      {
+         if (x + 4 > width)
+            x = width - 4;
+
+         {
+            const uint32_t *in = src + x;
+            uint32_t *out      = dst + 2 * x;
+            supereagle_vec_declare_variables(32, in, nextline);
+            supereagle_vec_function(32, supereagle_vec_interpolate_xrgb8888,
+                  supereagle_vec_interpolate2_xrgb8888);
+         }
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+
+static void supereagle_simd_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned nextline, x;
+
+   if (width < 8)
+   {
+      supereagle_generic_rgb565(width, height, first, last,
+            src, src_stride, dst, dst_stride);
+      return;
+   }
+
+   nextline = (last) ? 0 : src_stride;
+
+   for (; height; height--)
+   {
+      for (x = 0; x < width; x += 8)
+      {
+         if (x + 8 > width)
+            x = width - 8;
+
+         {
+            const uint16_t *in = src + x;
+            uint16_t *out      = dst + 2 * x;
+            supereagle_vec_declare_variables(16, in, nextline);
+            supereagle_vec_function(16, supereagle_vec_interpolate_rgb565,
+                  supereagle_vec_interpolate2_rgb565);
+         }
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+#endif
+
 static void supereagle_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
@@ -334,8 +538,74 @@ static const struct softfilter_implementation supereagle_generic = {
    "supereagle",
 };
 
+#ifdef SOFTFILTER_VEC_SIMD
+static void supereagle_simd_work_cb_rgb565(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+
+   supereagle_simd_rgb565(thr->width, thr->height,
+         thr->first, thr->last, (uint16_t*)thr->in_data,
+         thr->in_pitch / SOFTFILTER_BPP_RGB565, (uint16_t*)thr->out_data,
+         thr->out_pitch / SOFTFILTER_BPP_RGB565);
+}
+
+static void supereagle_simd_work_cb_xrgb8888(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+
+   supereagle_simd_xrgb8888(thr->width, thr->height,
+         thr->first, thr->last, (uint32_t*)thr->in_data,
+         thr->in_pitch / SOFTFILTER_BPP_XRGB8888, (uint32_t*)thr->out_data,
+         thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+}
+
+static void supereagle_simd_packets(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   unsigned i;
+
+   supereagle_generic_packets(data, packets, output, output_stride,
+         input, width, height, input_stride);
+
+   for (i = 0; i < filt->threads; i++)
+   {
+      if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+         packets[i].work = supereagle_simd_work_cb_rgb565;
+      else if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+         packets[i].work = supereagle_simd_work_cb_xrgb8888;
+   }
+}
+
+static const struct softfilter_implementation supereagle_simd = {
+   supereagle_generic_input_fmts,
+   supereagle_generic_output_fmts,
+
+   supereagle_generic_create,
+   supereagle_generic_destroy,
+
+   supereagle_generic_threads,
+   supereagle_generic_output,
+   supereagle_simd_packets,
+   SOFTFILTER_API_VERSION,
+   "SuperEagle",
+   "supereagle",
+
+   NULL,
+   SOFTFILTER_VEC_SIMD,
+   0,
+   NULL,
+};
+#endif
+
 const struct softfilter_implementation *softfilter_get_implementation(softfilter_simd_mask_t simd)
 {
+#ifdef SOFTFILTER_VEC_SIMD
+   if (simd & SOFTFILTER_VEC_SIMD)
+      return &supereagle_simd;
+#endif
    (void)simd;
    return &supereagle_generic;
 }
@@ -0,0 +1,208 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <retro_inline.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "video_frame_diff.h"
+
+/* Unchanged rows between two runs which get uploaded anyway,
+ * rather than splitting the run. */
+#define VIDEO_FRAME_DIFF_MERGE_ROWS 4
+
+struct video_frame_diff
+{
+   uint8_t *last;
+   uint64_t *row_serial;
+   uint64_t serial;
+
+   unsigned width;
+   unsigned height;
+   size_t line_size;
+};
+
+/**
+ * video_frame_diff_row_equal:
+ * @a                    : First row.
+ * @b                    : Second row.
+ * @size                 : Size of the rows in bytes.
+ *
+ * Compares 64 bytes at a time, bailing out on the first
+ * block which differs, as changed rows tend to differ early.
+ *
+ * Returns: true (1) if the rows are equal, otherwise false (0).
+ **/
+static INLINE bool video_frame_diff_row_equal(const uint8_t *a,
+      const uint8_t *b, size_t size)
+{
+   size_t i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 64 <= size; i += 64)
+   {
+      __m128i eq0 = _mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i*)(a + i)),
+            _mm_loadu_si128((const __m128i*)(b + i)));
+      __m128i eq1 = _mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i*)(a + i + 16)),
+            _mm_loadu_si128((const __m128i*)(b + i + 16)));
+      __m128i eq2 = _mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i*)(a + i + 32)),
+            _mm_loadu_si128((const __m128i*)(b + i + 32)));
+      __m128i eq3 = _mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i*)(a + i + 48)),
+            _mm_loadu_si128((const __m128i*)(b + i + 48)));
+      __m128i eq  = _mm_and_si128(_mm_and_si128(eq0, eq1),
+            _mm_and_si128(eq2, eq3));
+
+      if (_mm_movemask_epi8(eq) != 0xffff)
+         return false;
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 64 <= size; i += 64)
+   {
+      uint8x16_t eq0 = vceqq_u8(vld1q_u8(a + i),      vld1q_u8(b + i));
+      uint8x16_t eq1 = vceqq_u8(vld1q_u8(a + i + 16), vld1q_u8(b + i + 16));
+      uint8x16_t eq2 = vceqq_u8(vld1q_u8(a + i + 32), vld1q_u8(b + i + 32));
+      uint8x16_t eq3 = vceqq_u8(vld1q_u8(a + i + 48), vld1q_u8(b + i + 48));
+      uint8x16_t eq  = vandq_u8(vandq_u8(eq0, eq1), vandq_u8(eq2, eq3));
+      uint8x8_t  m   = vand_u8(vget_low_u8(eq), vget_high_u8(eq));
+
+      m = vpmin_u8(m, m);
+      m = vpmin_u8(m, m);
+      m = vpmin_u8(m, m);
+
+      if (vget_lane_u8(m, 0) != 0xff)
+         return false;
+   }
+#endif
+
+   return !memcmp(a + i, b + i, size - i);
+}
+
+video_frame_diff_t *video_frame_diff_new(void)
+{
+   return (video_frame_diff_t*)calloc(1, sizeof(video_frame_diff_t));
+}
+
+void video_frame_diff_free(video_frame_diff_t *diff)
+{
+   if (!diff)
+      return;
+
+   free(diff->last);
+   free(diff->row_serial);
+   free(diff);
+}
+
+void video_frame_diff_invalidate(video_frame_diff_t *diff)
+{
+   if (diff)
+      diff->height = 0;
+}
+
+uint64_t video_frame_diff_update(video_frame_diff_t *diff,
+      const void *frame, unsigned width, unsigned height,
+      size_t pitch, unsigned bpp)
+{
+   unsigned y;
+   const uint8_t *src = (const uint8_t*)frame;
+   size_t line_size   = width * bpp;
+   uint8_t *last      = NULL;
+
+   diff->serial++;
+
+   if (width != diff->width || height != diff->height
+         || line_size != diff->line_size)
+   {
+      uint8_t  *new_last   = (uint8_t*)realloc(diff->last,
+            line_size * height);
+      uint64_t *new_serial = NULL;
+
+      if (new_last)
+         diff->last = new_last;
+      new_serial = (uint64_t*)realloc(diff->row_serial,
+            height * sizeof(uint64_t));
+      if (new_serial)
+         diff->row_serial = new_serial;
+
+      if (!new_last || !new_serial)
+      {
+         diff->height = 0;
+         return 0;
+      }
+
+      diff->width     = width;
+      diff->height    = height;
+      diff->line_size = line_size;
+
+      for (y = 0, last = diff->last; y < height;
+            y++, src += pitch, last += line_size)
+      {
+         memcpy(last, src, line_size);
+         diff->row_serial[y] = diff->serial;
+      }
+
+      return diff->serial;
+   }
+
+   for (y = 0, last = diff->last; y < height;
+         y++, src += pitch, last += line_size)
+   {
+      if (video_frame_diff_row_equal(last, src, line_size))
+         continue;
+
+      memcpy(last, src, line_size);
+      diff->row_serial[y] = diff->serial;
+   }
+
+   return diff->serial;
+}
+
+bool video_frame_diff_next_run(const video_frame_diff_t *diff,
+      uint64_t since, unsigned *y, unsigned *rows)
+{
+   unsigned first, end, gap;
+
+   for (first = *y; first < diff->height; first++)
+      if (diff->row_serial[first] > since)
+         break;
+
+   if (first >= diff->height)
+      return false;
+
+   for (end = first + 1, gap = 0; end + gap < diff->height; )
+   {
+      if (diff->row_serial[end + gap] > since)
+      {
+         end += gap + 1;
+         gap  = 0;
+      }
+      else if (++gap > VIDEO_FRAME_DIFF_MERGE_ROWS)
+         break;
+   }
+
+   *y    = first;
+   *rows = end - first;
+   return true;
+}
@@ -0,0 +1,91 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VIDEO_FRAME_DIFF_H
+#define __VIDEO_FRAME_DIFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Finds the rows of a frame which changed, so uploads can skip
+ * the rest. Keeps a copy of the last frame, and for every row
+ * the serial of the frame which last changed it. A texture
+ * which got the frame with serial S only needs the rows changed
+ * after S, which also works for drivers cycling through several
+ * textures. Serial 0 stands for a texture with unknown contents. */
+
+typedef struct video_frame_diff video_frame_diff_t;
+
+video_frame_diff_t *video_frame_diff_new(void);
+
+void video_frame_diff_free(video_frame_diff_t *diff);
+
+/**
+ * video_frame_diff_update:
+ * @diff                 : Frame diff handle.
+ * @frame                : Frame from the core.
+ * @width                : Width of @frame.
+ * @height               : Height of @frame.
+ * @pitch                : Pitch of @frame.
+ * @bpp                  : Bytes per pixel of @frame.
+ *
+ * Compares @frame to the last one row by row, and keeps the
+ * rows which changed. A new size changes all rows.
+ *
+ * Returns: serial of @frame, to pass to
+ * video_frame_diff_next_run() once @frame is uploaded.
+ **/
+uint64_t video_frame_diff_update(video_frame_diff_t *diff,
+      const void *frame, unsigned width, unsigned height,
+      size_t pitch, unsigned bpp);
+
+/**
+ * video_frame_diff_next_run:
+ * @diff                 : Frame diff handle.
+ * @since                : Serial of the frame the texture has.
+ * @y                    : Row to search from, set to the first
+ *                         row of the run found.
+ * @rows                 : Set to the number of rows in the run.
+ *
+ * Finds the next run of rows changed after frame @since, at
+ * or below @y. Runs close to each other are merged, as every
+ * upload has a cost of its own.
+ *
+ * Returns: true (1) if a run was found, otherwise false (0).
+ **/
+bool video_frame_diff_next_run(const video_frame_diff_t *diff,
+      uint64_t since, unsigned *y, unsigned *rows);
+
+/**
+ * video_frame_diff_invalidate:
+ * @diff                 : Frame diff handle.
+ *
+ * Forgets the last frame, for when a frame got uploaded
+ * without video_frame_diff_update(). All rows of the next
+ * frame count as changed.
+ **/
+void video_frame_diff_invalidate(video_frame_diff_t *diff);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
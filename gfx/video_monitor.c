@@ -14,12 +14,23 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
 #include "video_monitor.h"
 #include "../general.h"
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../performance.h"
 
+static const char *frame_time_stage_names[VIDEO_MONITOR_STAGE_LAST] = {
+   "total",
+   "core",
+   "present",
+   "wait",
+};
+
 void video_monitor_adjust_system_rates(void)
 {
    float timing_skew;
@@ -33,6 +44,16 @@ void video_monitor_adjust_system_rates(void)
    if (info->fps <= 0.0)
       return;
 
+   if (settings->video.vrr_enable)
+   {
+      /* The display follows the frames, which rarch_limit_frame_time()
+       * paces, so they must not wait for VSync. */
+      global->system.force_nonblock = true;
+      RARCH_LOG("Variable refresh rate: pacing frames at %.4f Hz.\n",
+            (float)info->fps);
+      return;
+   }
+
    timing_skew = fabs(1.0f - info->fps / settings->video.refresh_rate);
 
    /* We don't want to adjust pitch too much. If we have extreme cases,
@@ -73,15 +94,28 @@ void video_monitor_set_refresh_rate(float hz)
 /**
  * video_monitor_compute_fps_statistics:
  *
- * Computes monitor FPS statistics.
+ * Computes monitor FPS statistics, and logs the frame time
+ * statistics.
  **/
 void video_monitor_compute_fps_statistics(void)
 {
+   unsigned i;
    double avg_fps = 0.0, stddev = 0.0;
    unsigned samples = 0;
    runloop_t *runloop   = rarch_main_get_ptr();
    settings_t *settings = config_get_ptr();
 
+   for (i = 0; i < VIDEO_MONITOR_STAGE_LAST; i++)
+   {
+      struct video_monitor_frame_time_stats stats;
+
+      if (!video_monitor_frame_time_stats((enum video_monitor_stage)i, &stats))
+         continue;
+      RARCH_LOG("Frame time (%s): p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms, %u frames.\n",
+            frame_time_stage_names[i], stats.p50 / 1000.0, stats.p95 / 1000.0,
+            stats.p99 / 1000.0, stats.max / 1000.0, stats.count);
+   }
+
    if (settings->video.threaded)
    {
       RARCH_LOG("Monitor FPS estimation is disabled for threaded video.\n");
@@ -166,6 +200,32 @@ bool video_monitor_fps_statistics(double *refresh_rate,
 
 #define FPS_UPDATE_INTERVAL 256
 
+/**
+ * video_monitor_frame_presented:
+ * @usec               : Time the frame reached the display,
+ *                       in microseconds on any steady clock.
+ *
+ * For contexts which know when frames were actually shown.
+ * Once called, the frame time samples are the intervals between
+ * these, rather than between calls to video_monitor_get_fps().
+ **/
+void video_monitor_frame_presented(retro_time_t usec)
+{
+   runloop_t *runloop = rarch_main_get_ptr();
+
+   if (runloop->measure_data.frame_time_presented)
+   {
+      unsigned write_index =
+         runloop->measure_data.frame_time_samples_count++ &
+         (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1);
+      runloop->measure_data.frame_time_samples[write_index] =
+         usec - runloop->measure_data.last_presented;
+   }
+
+   runloop->measure_data.frame_time_presented = true;
+   runloop->measure_data.last_presented       = usec;
+}
+
 /**
  * video_monitor_get_fps:
  * @buf           : string suitable for Window title
@@ -196,11 +256,15 @@ bool video_monitor_get_fps(char *buf, size_t size,
    if (runloop->frames.video.count)
    {
       bool ret = false;
-      unsigned write_index = 
-         runloop->measure_data.frame_time_samples_count++ &
-         (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1);
-      runloop->measure_data.frame_time_samples[write_index] = 
-         new_time - fps_time;
+
+      if (!runloop->measure_data.frame_time_presented)
+      {
+         unsigned write_index =
+            runloop->measure_data.frame_time_samples_count++ &
+            (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1);
+         runloop->measure_data.frame_time_samples[write_index] =
+            new_time - fps_time;
+      }
       fps_time = new_time;
 
       if ((runloop->frames.video.count % FPS_UPDATE_INTERVAL) == 0)
@@ -227,3 +291,253 @@ bool video_monitor_get_fps(char *buf, size_t size,
 
    return true;
 }
+
+/* Log-linear buckets: below 32 us one per microsecond, then 16
+ * per power of two, so every bucket is at most 1/16th of its value
+ * wide. The last bucket also takes everything longer (~67 s). */
+#define FRAME_TIME_SUB_BITS 4
+#define FRAME_TIME_BUCKETS  368
+
+/* Frames drawn by video_monitor_frame_time_graph(). */
+#define FRAME_TIME_HISTORY  48
+
+/* Longer gaps between frames are pauses, not frames. */
+#define FRAME_TIME_MAX_GAP_USEC 1000000
+
+static struct
+{
+   uint32_t buckets[VIDEO_MONITOR_STAGE_LAST][FRAME_TIME_BUCKETS];
+   unsigned count[VIDEO_MONITOR_STAGE_LAST];
+   retro_time_t max[VIDEO_MONITOR_STAGE_LAST];
+
+   /* Current frame. */
+   retro_time_t current[VIDEO_MONITOR_STAGE_LAST];
+   retro_time_t core_start;
+   retro_time_t core_other;
+   bool core_ran;
+   retro_time_t last_commit;
+
+   retro_time_t history[FRAME_TIME_HISTORY];
+   unsigned history_index;
+} frame_time;
+
+static unsigned frame_time_bucket(retro_time_t usec)
+{
+   unsigned shift = 0;
+
+   if (usec < 0)
+      return 0;
+
+   while ((usec >> shift) >= (2 << FRAME_TIME_SUB_BITS))
+      shift++;
+
+   return min((shift << FRAME_TIME_SUB_BITS) + (unsigned)(usec >> shift),
+         FRAME_TIME_BUCKETS - 1);
+}
+
+/* Smallest time counted in bucket @index. */
+static retro_time_t frame_time_bucket_floor(unsigned index)
+{
+   unsigned shift;
+
+   if (index < (2 << FRAME_TIME_SUB_BITS))
+      return index;
+
+   shift = (index >> FRAME_TIME_SUB_BITS) - 1;
+   return (retro_time_t)(index - (shift << FRAME_TIME_SUB_BITS)) << shift;
+}
+
+/* Middle of bucket @index. */
+static retro_time_t frame_time_bucket_value(unsigned index)
+{
+   retro_time_t floor_usec = frame_time_bucket_floor(index);
+
+   if (index + 1 >= FRAME_TIME_BUCKETS)
+      return floor_usec;
+   return (floor_usec + frame_time_bucket_floor(index + 1)) / 2;
+}
+
+static void frame_time_record(enum video_monitor_stage stage,
+      retro_time_t usec)
+{
+   frame_time.buckets[stage][frame_time_bucket(usec)]++;
+   frame_time.count[stage]++;
+   if (usec > frame_time.max[stage])
+      frame_time.max[stage] = usec;
+}
+
+void video_monitor_frame_time_add(enum video_monitor_stage stage,
+      retro_time_t usec)
+{
+   frame_time.current[stage] += usec;
+}
+
+void video_monitor_frame_time_core_begin(void)
+{
+   frame_time.core_start = rarch_get_time_usec();
+   frame_time.core_other =
+      frame_time.current[VIDEO_MONITOR_STAGE_PRESENT] +
+      frame_time.current[VIDEO_MONITOR_STAGE_WAIT];
+}
+
+void video_monitor_frame_time_core_end(void)
+{
+   retro_time_t other = 
+      frame_time.current[VIDEO_MONITOR_STAGE_PRESENT] +
+      frame_time.current[VIDEO_MONITOR_STAGE_WAIT] -
+      frame_time.core_other;
+
+   frame_time.current[VIDEO_MONITOR_STAGE_CORE] += 
+      rarch_get_time_usec() - frame_time.core_start - other;
+   frame_time.core_ran = true;
+}
+
+void video_monitor_frame_time_commit(void)
+{
+   unsigned i;
+   retro_time_t now   = rarch_get_time_usec();
+   retro_time_t total = now - frame_time.last_commit;
+   bool record        = frame_time.core_ran && frame_time.last_commit
+      && total < FRAME_TIME_MAX_GAP_USEC;
+   settings_t *settings = config_get_ptr();
+
+   if (record)
+   {
+      frame_time.current[VIDEO_MONITOR_STAGE_TOTAL] = total;
+      for (i = 0; i < VIDEO_MONITOR_STAGE_LAST; i++)
+         frame_time_record((enum video_monitor_stage)i,
+               frame_time.current[i]);
+
+      frame_time.history[frame_time.history_index++ % 
+         FRAME_TIME_HISTORY] = total;
+   }
+
+   memset(frame_time.current, 0, sizeof(frame_time.current));
+   frame_time.core_ran    = false;
+   frame_time.last_commit = now;
+
+   if (record && settings->frame_time_graph_show)
+   {
+      char msg[PATH_MAX_LENGTH];
+
+      video_monitor_frame_time_graph(msg, sizeof(msg));
+      rarch_main_msg_queue_push(msg, 1, 1, false);
+   }
+}
+
+void video_monitor_frame_time_reset(void)
+{
+   memset(&frame_time, 0, sizeof(frame_time));
+}
+
+bool video_monitor_frame_time_stats(enum video_monitor_stage stage,
+      struct video_monitor_frame_time_stats *stats)
+{
+   unsigned i, seen = 0;
+   unsigned count   = frame_time.count[stage];
+   /* Frames at or below each percentile, rounded up. */
+   unsigned p50     = (count * 50 + 99) / 100;
+   unsigned p95     = (count * 95 + 99) / 100;
+   unsigned p99     = (count * 99 + 99) / 100;
+
+   memset(stats, 0, sizeof(*stats));
+   if (!count)
+      return false;
+
+   stats->count = count;
+   stats->max   = frame_time.max[stage];
+
+   for (i = 0; i < FRAME_TIME_BUCKETS; i++)
+   {
+      unsigned prev = seen;
+
+      seen += frame_time.buckets[stage][i];
+      if (prev < p50 && seen >= p50)
+         stats->p50 = frame_time_bucket_value(i);
+      if (prev < p95 && seen >= p95)
+         stats->p95 = frame_time_bucket_value(i);
+      if (prev < p99 && seen >= p99)
+         stats->p99 = frame_time_bucket_value(i);
+   }
+
+   /* The middle of a bucket can lie above anything in it. */
+   stats->p50 = min(stats->p50, stats->max);
+   stats->p95 = min(stats->p95, stats->max);
+   stats->p99 = min(stats->p99, stats->max);
+
+   return true;
+}
+
+void video_monitor_frame_time_graph(char *buf, size_t size)
+{
+   static const char ramp[] = " .:-=+*#%@";
+   unsigned i;
+   size_t len;
+   char graph[FRAME_TIME_HISTORY + 1];
+   retro_time_t peak = 1;
+   unsigned frames   = min(frame_time.history_index, FRAME_TIME_HISTORY);
+   unsigned first    = frame_time.history_index - frames;
+   struct video_monitor_frame_time_stats stats[VIDEO_MONITOR_STAGE_LAST];
+
+   for (i = 0; i < frames; i++)
+      peak = max(peak, frame_time.history[(first + i) % FRAME_TIME_HISTORY]);
+
+   for (i = 0; i < frames; i++)
+   {
+      retro_time_t usec = frame_time.history[(first + i) % FRAME_TIME_HISTORY];
+      graph[i] = ramp[usec * (sizeof(ramp) - 2) / peak];
+   }
+   graph[frames] = '\0';
+
+   for (i = 0; i < VIDEO_MONITOR_STAGE_LAST; i++)
+      video_monitor_frame_time_stats((enum video_monitor_stage)i, &stats[i]);
+
+   len = snprintf(buf, size, "[%s] %.1f ms", graph, peak / 1000.0);
+   if (len < size)
+      snprintf(buf + len, size - len,
+            " || p99: %.1f ms (core %.1f, present %.1f, wait %.1f)",
+            stats[VIDEO_MONITOR_STAGE_TOTAL].p99 / 1000.0,
+            stats[VIDEO_MONITOR_STAGE_CORE].p99 / 1000.0,
+            stats[VIDEO_MONITOR_STAGE_PRESENT].p99 / 1000.0,
+            stats[VIDEO_MONITOR_STAGE_WAIT].p99 / 1000.0);
+}
+
+bool video_monitor_frame_time_dump(const char *path)
+{
+   unsigned i, j;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+   {
+      RARCH_ERR("Failed to open \"%s\" for the frame times.\n", path);
+      return false;
+   }
+
+   for (i = 0; i < VIDEO_MONITOR_STAGE_LAST; i++)
+   {
+      struct video_monitor_frame_time_stats stats;
+
+      video_monitor_frame_time_stats((enum video_monitor_stage)i, &stats);
+      fprintf(file, "stage %s: %u frames, p50 %.3f ms, p95 %.3f ms, "
+            "p99 %.3f ms, max %.3f ms\n",
+            frame_time_stage_names[i], stats.count,
+            stats.p50 / 1000.0, stats.p95 / 1000.0,
+            stats.p99 / 1000.0, stats.max / 1000.0);
+
+      for (j = 0; j < FRAME_TIME_BUCKETS; j++)
+      {
+         if (!frame_time.buckets[i][j])
+            continue;
+         fprintf(file, "    %8lld - %8lld us: %u\n",
+               (long long)frame_time_bucket_floor(j),
+               j + 1 < FRAME_TIME_BUCKETS ?
+               (long long)frame_time_bucket_floor(j + 1) : -1LL,
+               (unsigned)frame_time.buckets[i][j]);
+      }
+   }
+
+   fclose(file);
+   RARCH_LOG("Wrote frame times to \"%s\".\n", path);
+   return true;
+}
+
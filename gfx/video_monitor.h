@@ -20,6 +20,8 @@
 #include <boolean.h>
 #include <stddef.h>
 
+#include "../libretro.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -59,6 +61,17 @@ void video_monitor_compute_fps_statistics(void);
 bool video_monitor_fps_statistics(double *refresh_rate,
       double *deviation, unsigned *sample_points);
 
+/**
+ * video_monitor_frame_presented:
+ * @usec               : Time the frame reached the display,
+ *                       in microseconds on any steady clock.
+ *
+ * For contexts which know when frames were actually shown.
+ * Once called, the frame time samples are the intervals between
+ * these, rather than between calls to video_monitor_get_fps().
+ **/
+void video_monitor_frame_presented(retro_time_t usec);
+
 /**
  * video_monitor_get_fps:
  * @buf           : string suitable for Window title
@@ -75,6 +88,105 @@ bool video_monitor_fps_statistics(double *refresh_rate,
 bool video_monitor_get_fps(char *buf, size_t size,
       char *buf_fps, size_t size_fps);
 
+/* Where the time of a frame goes. TOTAL is the time from one
+ * frame to the next, the others are parts of it. */
+enum video_monitor_stage
+{
+   VIDEO_MONITOR_STAGE_TOTAL = 0,
+   /* Running the core, minus presenting and waiting within it. */
+   VIDEO_MONITOR_STAGE_CORE,
+   /* Converting, filtering and handing the frame to the video driver,
+    * including blocking on VSync. */
+   VIDEO_MONITOR_STAGE_PRESENT,
+   /* Sleeping for frame delay and frame limiting. */
+   VIDEO_MONITOR_STAGE_WAIT,
+
+   VIDEO_MONITOR_STAGE_LAST
+};
+
+struct video_monitor_frame_time_stats
+{
+   unsigned count;
+   /* Microseconds. */
+   retro_time_t p50;
+   retro_time_t p95;
+   retro_time_t p99;
+   retro_time_t max;
+};
+
+/**
+ * video_monitor_frame_time_add:
+ * @stage              : Stage the time was spent in.
+ * @usec               : Time spent, in microseconds.
+ *
+ * Adds to the time the current frame spent in @stage.
+ **/
+void video_monitor_frame_time_add(enum video_monitor_stage stage,
+      retro_time_t usec);
+
+/**
+ * video_monitor_frame_time_core_begin:
+ *
+ * Starts timing the core. Presenting and waiting added until
+ * video_monitor_frame_time_core_end() is not counted as core time.
+ **/
+void video_monitor_frame_time_core_begin(void);
+
+/**
+ * video_monitor_frame_time_core_end:
+ *
+ * Stops timing the core.
+ **/
+void video_monitor_frame_time_core_end(void);
+
+/**
+ * video_monitor_frame_time_commit:
+ *
+ * Ends the current frame, adding its stages to the histograms.
+ * Frames the core didn't run in, like menu frames, are dropped.
+ **/
+void video_monitor_frame_time_commit(void);
+
+/**
+ * video_monitor_frame_time_reset:
+ *
+ * Clears the histograms.
+ **/
+void video_monitor_frame_time_reset(void);
+
+/**
+ * video_monitor_frame_time_stats:
+ * @stage              : Stage to get the statistics of.
+ * @stats              : Set to the statistics.
+ *
+ * Percentiles are accurate to 1/32nd of their value.
+ *
+ * Returns: true (1) if any frames were recorded, otherwise false (0).
+ **/
+bool video_monitor_frame_time_stats(enum video_monitor_stage stage,
+      struct video_monitor_frame_time_stats *stats);
+
+/**
+ * video_monitor_frame_time_graph:
+ * @buf                : Set to the graph.
+ * @size               : Size of @buf.
+ *
+ * Draws the time of the last frames as a line of text,
+ * followed by the 99th percentiles of the stages.
+ **/
+void video_monitor_frame_time_graph(char *buf, size_t size);
+
+/**
+ * video_monitor_frame_time_dump:
+ * @path               : Path to write the histograms to.
+ *
+ * Writes the statistics and non-empty histogram buckets of all
+ * stages as plain text.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool video_monitor_frame_time_dump(const char *path);
+
 #ifdef __cplusplus
 }
 #endif
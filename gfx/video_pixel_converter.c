@@ -15,13 +15,49 @@
  */
 
 #include "video_pixel_converter.h"
+#include "video_work_pool.h"
 #include <gfx/scaler/pixconv.h>
 #include "../general.h"
+#include "../performance.h"
+
+/* Smaller frames convert faster than it takes to wake up workers. */
+#define PIXEL_CONVERTER_THREAD_MIN_PIXELS (512 * 448)
+/* Rows per work item. */
+#define PIXEL_CONVERTER_BAND_ROWS 32
+
+static bool pixel_converter_pool;
+
+struct pixel_converter_job
+{
+   struct scaler_ctx *scaler;
+   void *output;
+   const void *input;
+};
+
+static void pixel_converter_band(void *data, unsigned index,
+      unsigned thread)
+{
+   struct pixel_converter_job *job = (struct pixel_converter_job*)data;
+   int first_row = index * PIXEL_CONVERTER_BAND_ROWS;
+   int rows      = PIXEL_CONVERTER_BAND_ROWS;
+
+   (void)thread;
+
+   if (first_row + rows > job->scaler->out_height)
+      rows = job->scaler->out_height - first_row;
+
+   scaler_ctx_scale_rows(job->scaler, job->output, job->input,
+         first_row, rows);
+}
 
 void deinit_pixel_converter(void)
 {
    driver_t *driver = driver_get_ptr();
 
+   if (pixel_converter_pool)
+      video_work_pool_deinit();
+   pixel_converter_pool = false;
+
    scaler_ctx_gen_reset(&driver->scaler);
    memset(&driver->scaler, 0, sizeof(driver->scaler));
    free(driver->scaler_out);
@@ -58,9 +94,38 @@ bool init_video_pixel_converter(unsigned size)
    if (!driver->scaler_out)
       return false;
 
+   /* Failing here is not fatal, conversion just stays 
+    * on the calling thread. */
+   pixel_converter_pool = true;
+   video_work_pool_init();
+
    return true;
 }
 
+void video_pixel_scale(void *output, const void *input)
+{
+   struct pixel_converter_job job;
+   driver_t *driver          = driver_get_ptr();
+   struct scaler_ctx *scaler = &driver->scaler;
+
+   if (!pixel_converter_pool || video_work_pool_num_threads() < 2 ||
+         !scaler->unscaled ||
+         scaler->in_width * scaler->in_height 
+         < PIXEL_CONVERTER_THREAD_MIN_PIXELS)
+   {
+      scaler_ctx_scale(scaler, output, input);
+      return;
+   }
+
+   job.scaler = scaler;
+   job.output = output;
+   job.input  = input;
+
+   video_work_pool_run(pixel_converter_band, &job,
+         (scaler->out_height + PIXEL_CONVERTER_BAND_ROWS - 1) 
+         / PIXEL_CONVERTER_BAND_ROWS);
+}
+
 unsigned video_pixel_get_alignment(unsigned pitch)
 {
    if (pitch & 1)
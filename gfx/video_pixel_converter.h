@@ -27,6 +27,17 @@ void deinit_pixel_converter(void);
 
 bool init_video_pixel_converter(unsigned size);
 
+/**
+ * video_pixel_scale:
+ * @output               : converted frame.
+ * @input                : frame from the core.
+ *
+ * Converts a frame with the pixel converter set up by 
+ * init_video_pixel_converter(). Big frames are split into 
+ * horizontal slices that are converted in parallel.
+ **/
+void video_pixel_scale(void *output, const void *input);
+
 unsigned video_pixel_get_alignment(unsigned pitch);
 
 #ifdef __cplusplus
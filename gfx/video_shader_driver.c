@@ -15,7 +15,11 @@
 
 #include "video_shader_driver.h"
 #include "../retroarch_logger.h"
+#include "../general.h"
+#include "../hash.h"
 #include <string.h>
+#include <file/file_path.h>
+#include <compat/strl.h>
 
 static const shader_backend_t *shader_ctx_drivers[] = {
 #ifdef HAVE_GLSL
@@ -80,3 +84,25 @@ struct video_shader *video_shader_driver_get_current_shader(void)
       return NULL;
    return driver->video_poke->get_current_shader(driver->video_data);
 }
+
+bool video_shader_driver_get_cache_path(char *path, size_t size,
+      const void *key, size_t key_size)
+{
+   char hash[65];
+   settings_t *settings = config_get_ptr();
+   const char *dir      = settings->video.shader_cache_dir;
+
+   if (!*dir)
+      return false;
+
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+   {
+      RARCH_WARN("Failed to create shader cache directory: %s.\n", dir);
+      return false;
+   }
+
+   sha256_hash(hash, (const uint8_t*)key, key_size);
+   fill_pathname_join(path, dir, hash, size);
+   strlcat(path, ".bin", size);
+   return true;
+}
@@ -53,6 +53,19 @@ typedef struct shader_backend
 
    /* Human readable string. */
    const char *ident;
+
+   /* Optional. Same as init(), but returns the new shader 
+    * instead of activating it, so it can be called from a thread 
+    * with a shared context current while the old shader is in use.
+    * The result must be passed to either init_compiled() or 
+    * free_compiled() on the rendering thread. */
+   void *(*compile)(void *data, const char *path);
+
+   /* Activates a shader returned by compile(). 
+    * The active shader must have been deinitialized first. */
+   void (*init_compiled)(void *data, void *shader_data);
+
+   void (*free_compiled)(void *shader_data);
 } shader_backend_t;
 
 extern const shader_backend_t gl_glsl_backend;
@@ -105,4 +118,19 @@ const shader_backend_t *shader_ctx_init_first(void);
 
 struct video_shader *video_shader_driver_get_current_shader(void);
 
+/**
+ * video_shader_driver_get_cache_path:
+ * @path                    : Path of the cache entry.
+ * @size                    : Size of @path.
+ * @key                     : Everything the compiled program depends on.
+ * @key_size                : Size of @key.
+ *
+ * Gets the file in video_shader_cache_dir a compiled shader 
+ * program for @key is cached in, creating the directory if needed.
+ *
+ * Returns: true (1) if shader caching is enabled, otherwise false (0).
+ **/
+bool video_shader_driver_get_cache_path(char *path, size_t size,
+      const void *key, size_t key_size);
+
 #endif
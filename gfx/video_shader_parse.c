@@ -16,12 +16,16 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "video_shader_parse.h"
 #include <compat/posix_string.h>
 #include <compat/msvc.h>
 #include <compat/strl.h>
 #include <file/file_path.h>
 #include "../general.h"
+#include "../file_ops.h"
 
 /**
  * wrap_mode_to_str:
@@ -326,6 +330,138 @@ static struct video_shader_parameter *video_shader_parse_find_parameter(
    return NULL;
 }
 
+/* Parameters found in the last few pass sources, so switching
+ * presets and opening the menu doesn't read every source again.
+ * Entries are dropped when the file changes size or mtime. */
+#define VIDEO_SHADER_PARAM_CACHE_SIZE 32
+
+struct video_shader_param_cache
+{
+   char path[PATH_MAX_LENGTH];
+   time_t mtime;
+   long size;
+   unsigned num_parameters;
+   struct video_shader_parameter *parameters;
+};
+
+static struct video_shader_param_cache
+   video_shader_param_cache[VIDEO_SHADER_PARAM_CACHE_SIZE];
+static unsigned video_shader_param_cache_next;
+
+/**
+ * video_shader_scan_parameters:
+ * @path              : Path of the pass source.
+ * @params            : Parameters to fill in.
+ * @max_params        : Number of parameters @params has room for.
+ *
+ * Reads the #pragma parameter lines of a pass source.
+ *
+ * Returns: number of parameters found, or -1 if @path
+ * can't be opened.
+ **/
+static int video_shader_scan_parameters(const char *path,
+      struct video_shader_parameter *params, unsigned max_params)
+{
+   char line[4096];
+   unsigned num_params = 0;
+   struct video_shader_parameter *param = params;
+   FILE *file = fopen(path, "r");
+
+   if (!file)
+      return -1;
+
+   while (num_params < max_params && fgets(line, sizeof(line), file))
+   {
+      int ret = sscanf(line,
+            "#pragma parameter %63s \"%63[^\"]\" %f %f %f %f",
+            param->id, param->desc, &param->initial,
+            &param->minimum, &param->maximum, &param->step);
+
+      if (ret < 5)
+         continue;
+
+      param->id[63] = '\0';
+      param->desc[63] = '\0';
+
+      if (ret == 5)
+         param->step = 0.1f * (param->maximum - param->minimum);
+
+      RARCH_LOG("Found #pragma parameter %s (%s) %f %f %f %f\n",
+            param->desc, param->id, param->initial,
+            param->minimum, param->maximum, param->step);
+      param->current = param->initial;
+
+      num_params++;
+      param++;
+   }
+
+   fclose(file);
+   return num_params;
+}
+
+/**
+ * video_shader_get_parameters:
+ * @path              : Path of the pass source.
+ * @params            : Parameters to fill in.
+ * @max_params        : Number of parameters @params has room for.
+ *
+ * Like video_shader_scan_parameters(), but takes the parameters
+ * from the cache while the file is unchanged.
+ *
+ * Returns: number of parameters found, or -1 if @path
+ * can't be opened.
+ **/
+static int video_shader_get_parameters(const char *path,
+      struct video_shader_parameter *params, unsigned max_params)
+{
+   int num_params;
+   unsigned i;
+   struct stat st;
+   struct video_shader_param_cache *entry = NULL;
+
+   if (stat(path, &st) != 0)
+      return video_shader_scan_parameters(path, params, max_params);
+
+   for (i = 0; i < VIDEO_SHADER_PARAM_CACHE_SIZE; i++)
+   {
+      entry = &video_shader_param_cache[i];
+
+      if (entry->parameters && entry->mtime == st.st_mtime &&
+            entry->size == (long)st.st_size && !strcmp(entry->path, path))
+      {
+         num_params = min(entry->num_parameters, max_params);
+         memcpy(params, entry->parameters, num_params * sizeof(*params));
+         return num_params;
+      }
+   }
+
+   num_params = video_shader_scan_parameters(path, params, max_params);
+
+   /* Only complete scans can be handed out again. */
+   if (num_params < 0 || (unsigned)num_params == max_params)
+      return num_params;
+
+   entry = &video_shader_param_cache[video_shader_param_cache_next];
+
+   free(entry->parameters);
+   entry->parameters = (struct video_shader_parameter*)
+      malloc((num_params ? num_params : 1) * sizeof(*params));
+
+   if (!entry->parameters)
+      return num_params;
+
+   memcpy(entry->parameters, params, num_params * sizeof(*params));
+   strlcpy(entry->path, path, sizeof(entry->path));
+   entry->mtime          = st.st_mtime;
+   entry->size           = (long)st.st_size;
+   entry->num_parameters = num_params;
+
+   video_shader_param_cache_next = (video_shader_param_cache_next + 1)
+      % VIDEO_SHADER_PARAM_CACHE_SIZE;
+
+   return num_params;
+}
+
 /** 
  * video_shader_resolve_parameters:
  * @conf              : Preset file to read from.
@@ -339,49 +475,19 @@ bool video_shader_resolve_parameters(config_file_t *conf,
       struct video_shader *shader)
 {
    unsigned i;
-   struct video_shader_parameter *param = NULL;
 
    shader->num_parameters = 0;
-   param = (struct video_shader_parameter*)
-      &shader->parameters[shader->num_parameters];
 
    /* Find all parameters in our shaders. */
 
    for (i = 0; i < shader->passes; i++)
    {
-      char line[4096];
-      FILE *file = fopen(shader->pass[i].source.path, "r");
-
-      if (!file)
-         continue;
-
-      while (shader->num_parameters < ARRAY_SIZE(shader->parameters)
-            && fgets(line, sizeof(line), file))
-      {
-         int ret = sscanf(line,
-               "#pragma parameter %63s \"%63[^\"]\" %f %f %f %f",
-               param->id, param->desc, &param->initial,
-               &param->minimum, &param->maximum, &param->step);
-
-         if (ret < 5)
-            continue;
-
-         param->id[63] = '\0';
-         param->desc[63] = '\0';
-
-         if (ret == 5)
-            param->step = 0.1f * (param->maximum - param->minimum);
+      int found = video_shader_get_parameters(shader->pass[i].source.path,
+            &shader->parameters[shader->num_parameters],
+            ARRAY_SIZE(shader->parameters) - shader->num_parameters);
 
-         RARCH_LOG("Found #pragma parameter %s (%s) %f %f %f %f\n",
-               param->desc, param->id, param->initial,
-               param->minimum, param->maximum, param->step);
-         param->current = param->initial;
-
-         shader->num_parameters++;
-         param++;
-      }
-
-      fclose(file);
+      if (found > 0)
+         shader->num_parameters += found;
    }
 
    if (conf)
@@ -886,3 +992,63 @@ void video_shader_resolve_relative(struct video_shader *shader,
    }
 }
 
+/**
+ * video_shader_source_is_cacheable:
+ * @source            : Shader source.
+ *
+ * Looks for anything in @source that changes between frames.
+ * Both the Cg and GLSL names are checked. Included files can't 
+ * be followed, so sources including others never pass.
+ *
+ * Returns: true (1) if @source only depends on its input, 
+ * otherwise false (0).
+ **/
+static bool video_shader_source_is_cacheable(const char *source)
+{
+   unsigned i;
+   static const char *varying[] = {
+      "FrameCount", "frame_count",
+      "FrameDirection", "frame_direction",
+      "Prev", "PREV",
+      "#include",
+   };
+
+   if (!source)
+      return false;
+
+   for (i = 0; i < ARRAY_SIZE(varying); i++)
+      if (strstr(source, varying[i]))
+         return false;
+
+   return true;
+}
+
+void video_shader_resolve_dependencies(struct video_shader *shader)
+{
+   unsigned i;
+
+   for (i = 0; i < shader->passes; i++)
+   {
+      struct video_shader_pass *pass = &shader->pass[i];
+
+      pass->cacheable = false;
+
+      /* Imports and scripts change uniforms behind our back. */
+      if (shader->variables || shader->script || *shader->script_path)
+         continue;
+
+      if (pass->source.string.vertex || pass->source.string.fragment)
+         pass->cacheable = 
+            video_shader_source_is_cacheable(pass->source.string.vertex) &&
+            video_shader_source_is_cacheable(pass->source.string.fragment);
+      else if (*pass->source.path)
+      {
+         char *source = NULL;
+         ssize_t len  = 0;
+
+         if (read_file(pass->source.path, (void**)&source, &len) && len > 0)
+            pass->cacheable = video_shader_source_is_cacheable(source);
+         free(source);
+      }
+   }
+}
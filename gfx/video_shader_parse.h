@@ -116,6 +116,10 @@ struct video_shader_pass
    enum gfx_wrap_type wrap;
    unsigned frame_count_mod;
    bool mipmap;
+
+   /* Output only depends on the input of the pass, 
+    * see video_shader_resolve_dependencies(). */
+   bool cacheable;
 };
 
 struct video_shader_lut
@@ -199,6 +203,17 @@ void video_shader_resolve_relative(struct video_shader *shader,
 bool video_shader_resolve_parameters(config_file_t *conf,
       struct video_shader *shader);
 
+/**
+ * video_shader_resolve_dependencies:
+ * @shader            : Shader passes handle.
+ *
+ * Marks passes as cacheable when their source doesn't refer to 
+ * the frame count, frame direction or frame history, so they 
+ * render the same output as long as their input is the same.
+ * Passes which can't be checked are never cacheable.
+ **/
+void video_shader_resolve_dependencies(struct video_shader *shader);
+
 /**
  * video_shader_parse_type:
  * @path              : Shader path.
@@ -221,12 +221,24 @@ static PyObject* PyInit_Retro(void)
    return mod;
 }
 
+#define PY_STATE_MAX_METHODS 64
+
+struct py_state_method
+{
+   char id[64];
+   PyObject *method;
+};
+
 struct py_state
 {
    PyObject *main;
    PyObject *dict;
    PyObject *inst;
 
+   /* Bound methods of inst, looked up once instead of every frame. */
+   struct py_state_method methods[PY_STATE_MAX_METHODS];
+   unsigned num_methods;
+
    bool warned_ret;
    bool warned_type;
 };
@@ -372,12 +384,17 @@ error:
 
 void py_state_free(py_state_t *handle)
 {
+   unsigned i;
+
    if (!handle)
       return;
 
    PyErr_Print();
    PyErr_Clear();
 
+   for (i = 0; i < handle->num_methods; i++)
+      Py_CLEAR(handle->methods[i].method);
+
    Py_CLEAR(handle->inst);
    Py_CLEAR(handle->dict);
    Py_CLEAR(handle->main);
@@ -386,29 +403,52 @@ void py_state_free(py_state_t *handle)
    Py_Finalize();
 }
 
-float py_state_get(py_state_t *handle, const char *id,
-      unsigned frame_count)
+static PyObject *py_state_method(py_state_t *handle, const char *id)
 {
    unsigned i;
-   float retval;
-   PyObject *ret = NULL;
-   settings_t *settings = config_get_ptr();
+   PyObject *method = NULL;
 
-   for (i = 0; i < MAX_USERS; i++)
-   {
-      input_push_analog_dpad(settings->input.binds[i],
-            settings->input.analog_dpad_mode[i]);
-      input_push_analog_dpad(settings->input.autoconf_binds[i],
-            settings->input.analog_dpad_mode[i]);
-   }
+   for (i = 0; i < handle->num_methods; i++)
+      if (!strcmp(handle->methods[i].id, id))
+         return handle->methods[i].method;
 
-   ret = PyObject_CallMethod(handle->inst, (char*)id, (char*)"I", frame_count);
+   if (handle->num_methods >= PY_STATE_MAX_METHODS ||
+         strlen(id) >= sizeof(handle->methods[0].id))
+      return NULL;
 
-   for (i = 0; i < MAX_USERS; i++)
-   {
-      input_pop_analog_dpad(settings->input.binds[i]);
-      input_pop_analog_dpad(settings->input.autoconf_binds[i]);
-   }
+   method = PyObject_GetAttrString(handle->inst, id);
+   if (!method)
+      return NULL;
+
+   strlcpy(handle->methods[handle->num_methods].id, id,
+         sizeof(handle->methods[0].id));
+   handle->methods[handle->num_methods++].method = method;
+   return method;
+}
+
+/**
+ * py_state_get:
+ * @handle                   : Python state handle.
+ * @id                       : Name of the method to call.
+ * @frame_count              : Frame count passed to the method.
+ *
+ * The caller pushes the analog dpad binds around the calls
+ * it makes for a frame, see state_tracker_get_uniform().
+ *
+ * Returns: value the method returned, or 0.0 on error.
+ **/
+float py_state_get(py_state_t *handle, const char *id,
+      unsigned frame_count)
+{
+   float retval;
+   PyObject *ret    = NULL;
+   PyObject *method = py_state_method(handle, id);
+
+   if (method)
+      ret = PyObject_CallFunction(method, (char*)"I", frame_count);
+   else if (!PyErr_Occurred())
+      ret = PyObject_CallMethod(handle->inst, (char*)id,
+            (char*)"I", frame_count);
 
    if (!ret)
    {
@@ -31,6 +31,7 @@ struct state_tracker_internal
 
    bool is_input;
    const uint16_t *input_ptr;
+   /* Byte of RAM the element watches. */
    const uint8_t *ptr;
 #ifdef HAVE_PYTHON
    py_state_t *py;
@@ -56,6 +57,11 @@ struct state_tracker
    unsigned info_elem;
 
    uint16_t input_state[2];
+   /* Only poll input if an element watches it. */
+   bool has_input;
+
+   /* Values of all elements, fetched in one pass per frame. */
+   uint16_t *values;
 
 #ifdef HAVE_PYTHON
    py_state_t *py;
@@ -94,10 +100,14 @@ state_tracker_t* state_tracker_init(const struct state_tracker_info *info)
 
    tracker->info = (struct state_tracker_internal*)
       calloc(info->info_elem, sizeof(struct state_tracker_internal));
+   tracker->values = (uint16_t*)
+      calloc(info->info_elem + 1, sizeof(uint16_t));
 
-   if (!tracker->info)
+   if (!tracker->info || !tracker->values)
    {
       RARCH_ERR("Allocation of state tracker info failed.\n");
+      free(tracker->info);
+      free(tracker->values);
       free(tracker);
       return NULL;
    }
@@ -123,6 +133,7 @@ state_tracker_t* state_tracker_init(const struct state_tracker_info *info)
          if (!tracker->py)
          {
             free(tracker->info);
+            free(tracker->values);
             free(tracker);
             RARCH_ERR("Python semantic was requested, but Python tracker is not loaded.\n");
             return NULL;
@@ -134,15 +145,18 @@ state_tracker_t* state_tracker_init(const struct state_tracker_info *info)
       switch (info->info[i].ram_type)
       {
          case RARCH_STATE_WRAM:
-            tracker->info[i].ptr = info->wram ? info->wram : &empty;
+            tracker->info[i].ptr = info->wram ?
+               info->wram + tracker->info[i].addr : &empty;
             break;
          case RARCH_STATE_INPUT_SLOT1:
             tracker->info[i].input_ptr = &tracker->input_state[0];
             tracker->info[i].is_input = true;
+            tracker->has_input        = true;
             break;
          case RARCH_STATE_INPUT_SLOT2:
             tracker->info[i].input_ptr = &tracker->input_state[1];
             tracker->info[i].is_input = true;
+            tracker->has_input        = true;
             break;
 
          default:
@@ -164,6 +178,7 @@ void state_tracker_free(state_tracker_t *tracker)
    if (tracker)
    {
       free(tracker->info);
+      free(tracker->values);
 #ifdef HAVE_PYTHON
       py_state_free(tracker->py);
 #endif
@@ -172,66 +187,77 @@ void state_tracker_free(state_tracker_t *tracker)
    free(tracker);
 }
 
-static INLINE uint16_t state_tracker_fetch(
-      const struct state_tracker_internal *info)
+/**
+ * state_tracker_fetch:
+ * @tracker                      : State tracker handle.
+ * @elems                        : Amount of elements to fetch.
+ *
+ * Reads the RAM and input all elements watch in one go, 
+ * so each is only read once per frame.
+ **/
+static void state_tracker_fetch(state_tracker_t *tracker, unsigned elems)
 {
-   uint16_t val = info->ptr[info->addr];
+   unsigned i;
+   const struct state_tracker_internal *info = tracker->info;
+   uint16_t *values                          = tracker->values;
 
-   if (info->is_input)
-      val = *info->input_ptr;
+   for (i = 0; i < elems; i++, info++)
+   {
+      uint16_t val = info->is_input ? *info->input_ptr : *info->ptr;
 
-   val &= info->mask;
+      val &= info->mask;
 
-   if (info->equal && val != info->equal)
-      val = 0;
+      if (info->equal && val != info->equal)
+         val = 0;
 
-   return val;
+      values[i] = val;
+   }
 }
 
 static void state_tracker_update_element(
       struct state_tracker_uniform *uniform,
       struct state_tracker_internal *info,
-      unsigned frame_count)
+      uint16_t val, unsigned frame_count)
 {
    uniform->id = info->id;
 
    switch (info->type)
    {
       case RARCH_STATE_CAPTURE:
-         uniform->value = state_tracker_fetch(info);
+         uniform->value = val;
          break;
 
       case RARCH_STATE_CAPTURE_PREV:
-         if (info->prev[0] != state_tracker_fetch(info))
+         if (info->prev[0] != val)
          {
             info->prev[1] = info->prev[0];
-            info->prev[0] = state_tracker_fetch(info);
+            info->prev[0] = val;
          }
          uniform->value = info->prev[1];
          break;
 
       case RARCH_STATE_TRANSITION:
-         if (info->old_value != state_tracker_fetch(info))
+         if (info->old_value != val)
          {
-            info->old_value = state_tracker_fetch(info);
+            info->old_value = val;
             info->frame_count = frame_count;
          }
          uniform->value = info->frame_count;
          break;
 
       case RARCH_STATE_TRANSITION_COUNT:
-         if (info->old_value != state_tracker_fetch(info))
+         if (info->old_value != val)
          {
-            info->old_value = state_tracker_fetch(info);
+            info->old_value = val;
             info->transition_count++;
          }
          uniform->value = info->transition_count;
          break;
 
       case RARCH_STATE_TRANSITION_PREV:
-         if (info->old_value != state_tracker_fetch(info))
+         if (info->old_value != val)
          {
-            info->old_value = state_tracker_fetch(info);
+            info->old_value = val;
             info->frame_count_prev = info->frame_count;
             info->frame_count = frame_count;
          }
@@ -286,13 +312,6 @@ static void state_tracker_update_input(state_tracker_t *tracker)
    if (!driver->input)
       return;
 
-   for (i = 0; i < 2; i++)
-      input_push_analog_dpad(settings->input.binds[i],
-            settings->input.analog_dpad_mode[i]);
-   for (i = 0; i < MAX_USERS; i++)
-      input_push_analog_dpad(settings->input.autoconf_binds[i],
-            settings->input.analog_dpad_mode[i]);
-
    if (!driver->block_libretro_input)
    {
       for (i = 4; i < 16; i++)
@@ -305,12 +324,33 @@ static void state_tracker_update_input(state_tracker_t *tracker)
    }
 
    for (i = 0; i < 2; i++)
-      input_pop_analog_dpad(settings->input.binds[i]);
+      tracker->input_state[i] = state[i];
+}
+
+static void state_tracker_push_analog_dpad(void)
+{
+   unsigned i;
+   settings_t *settings = config_get_ptr();
+
    for (i = 0; i < MAX_USERS; i++)
-      input_pop_analog_dpad(settings->input.autoconf_binds[i]);
+   {
+      input_push_analog_dpad(settings->input.binds[i],
+            settings->input.analog_dpad_mode[i]);
+      input_push_analog_dpad(settings->input.autoconf_binds[i],
+            settings->input.analog_dpad_mode[i]);
+   }
+}
 
-   for (i = 0; i < 2; i++)
-      tracker->input_state[i] = state[i];
+static void state_tracker_pop_analog_dpad(void)
+{
+   unsigned i;
+   settings_t *settings = config_get_ptr();
+
+   for (i = 0; i < MAX_USERS; i++)
+   {
+      input_pop_analog_dpad(settings->input.binds[i]);
+      input_pop_analog_dpad(settings->input.autoconf_binds[i]);
+   }
 }
 
 /**
@@ -320,8 +360,10 @@ static void state_tracker_update_input(state_tracker_t *tracker)
  * @elem                         : Amount of uniform elements.
  * @frame_count                  : Frame count.
  *
- * Calls state_tracker_update_input(), and updates each uniform
- * element accordingly.
+ * Polls input if any element watches it, fetches the values of
+ * all elements in one pass and updates each uniform element
+ * accordingly. The analog dpad binds are pushed once for the
+ * whole update, rather than for every script call.
  *
  * Returns: Amount of state elements (either equal to @elem
  * or equal to @tracker->info_eleme).
@@ -331,15 +373,30 @@ unsigned state_tracker_get_uniform(state_tracker_t *tracker,
       unsigned elem, unsigned frame_count)
 {
    unsigned i, elems = elem;
+   bool push_dpad    = tracker->has_input;
    
    if (tracker->info_elem < elem)
       elems = tracker->info_elem;
 
-   state_tracker_update_input(tracker);
+#ifdef HAVE_PYTHON
+   if (tracker->py)
+      push_dpad = true;
+#endif
+
+   if (push_dpad)
+      state_tracker_push_analog_dpad();
+
+   if (tracker->has_input)
+      state_tracker_update_input(tracker);
+
+   state_tracker_fetch(tracker, elems);
 
    for (i = 0; i < elems; i++)
-      state_tracker_update_element(
-            &uniforms[i], &tracker->info[i], frame_count);
+      state_tracker_update_element(&uniforms[i], &tracker->info[i],
+            tracker->values[i], frame_count);
+
+   if (push_dpad)
+      state_tracker_pop_analog_dpad();
 
    return elems;
 }
@@ -19,6 +19,37 @@
 #include "video_pixel_converter.h"
 #include "video_thread_wrapper.h"
 
+#define VIDEO_TEXTURE_MAX_COMPRESSED_FORMATS 64
+
+static unsigned video_texture_compressed_formats[VIDEO_TEXTURE_MAX_COMPRESSED_FORMATS];
+static unsigned video_texture_num_compressed_formats;
+
+void video_texture_set_compressed_formats(const unsigned *formats,
+      unsigned count)
+{
+   unsigned i;
+
+   if (count > VIDEO_TEXTURE_MAX_COMPRESSED_FORMATS)
+      count = VIDEO_TEXTURE_MAX_COMPRESSED_FORMATS;
+
+   for (i = 0; i < count; i++)
+      video_texture_compressed_formats[i] = formats[i];
+   video_texture_num_compressed_formats = count;
+}
+
+bool video_texture_compressed_supported(unsigned internal_format)
+{
+   unsigned i;
+
+   for (i = 0; i < video_texture_num_compressed_formats; i++)
+   {
+      if (video_texture_compressed_formats[i] == internal_format)
+         return true;
+   }
+
+   return false;
+}
+
 #ifdef HAVE_OPENGL
 #include "drivers/gl_common.h"
 
@@ -28,6 +59,15 @@ static void video_texture_png_load_gl(struct texture_image *ti,
 {
    /* Generate the OpenGL texture object */
    glGenTextures(1, (GLuint*)id);
+
+   if (ti->compressed)
+   {
+      if (!gl_load_texture_compressed((GLuint)*id, RARCH_WRAP_EDGE,
+               filter_type, ti->compressed, ti->compressed_size))
+         RARCH_ERR("Failed to upload compressed texture.\n");
+      return;
+   }
+
    gl_load_texture_data((GLuint)*id, 
          RARCH_WRAP_EDGE, filter_type,
          4 /* TODO/FIXME - dehardcode */,
@@ -83,11 +123,7 @@ unsigned video_texture_load(void *data,
       enum texture_backend_type type,
       enum texture_filter_type  filter_type)
 {
-   settings_t *settings = config_get_ptr();
-   global_t   *global   = global_get_ptr();
-
-   if (settings->video.threaded
-         && !global->system.hw_render_callback.context_type)
+   if (video_driver_is_threaded())
    {
       driver_t     *driver = driver_get_ptr();
       thread_video_t *thr  = (thread_video_t*)driver->video_data;
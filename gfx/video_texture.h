@@ -33,6 +33,26 @@ unsigned video_texture_load(void *data,
       enum texture_backend_type type,
       enum texture_filter_type  filter_type);
 
+/**
+ * video_texture_set_compressed_formats:
+ * @formats              : Compressed internal formats the GPU supports.
+ * @count                : Number of formats.
+ *
+ * Called by the video driver once its context is up, and with 
+ * no formats when it goes away.
+ **/
+void video_texture_set_compressed_formats(const unsigned *formats,
+      unsigned count);
+
+/**
+ * video_texture_compressed_supported:
+ * @internal_format      : Compressed internal format of a texture.
+ *
+ * Returns: true (1) if textures in @internal_format can be 
+ * loaded by video_texture_load(), otherwise false (0).
+ **/
+bool video_texture_compressed_supported(unsigned internal_format);
+
 #ifdef __cplusplus
 }
 #endif
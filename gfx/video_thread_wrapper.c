@@ -23,6 +23,90 @@
 #include <string.h>
 #include <limits.h>
 
+#if defined(_MSC_VER) && !defined(__GNUC__)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define THREAD_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <windows.h>
+#define THREAD_BARRIER() MemoryBarrier()
+#else
+/* Only safe on single-core or strongly ordered targets. */
+#define THREAD_BARRIER()
+#endif
+
+enum
+{
+   THREAD_WINDOW_ALIVE        = 1 << 0,
+   THREAD_WINDOW_FOCUS        = 1 << 1,
+   THREAD_WINDOW_HAS_WINDOWED = 1 << 2
+};
+
+static unsigned thread_window_state(const thread_video_t *thr)
+{
+   unsigned state = thr->window_state;
+   THREAD_BARRIER();
+   return state;
+}
+
+/* Only called by the video thread. */
+static void thread_set_viewport(thread_video_t *thr,
+      const struct video_viewport *vp)
+{
+   thr->vp_seq++;
+   THREAD_BARRIER();
+   thr->vp = *vp;
+   THREAD_BARRIER();
+   thr->vp_seq++;
+}
+
+static void thread_get_viewport(const thread_video_t *thr,
+      struct video_viewport *vp)
+{
+   unsigned seq;
+
+   do
+   {
+      /* Odd while the video thread is writing. */
+      while ((seq = thr->vp_seq) & 1);
+      THREAD_BARRIER();
+      *vp = thr->vp;
+      THREAD_BARRIER();
+   } while (seq != thr->vp_seq);
+}
+
+/**
+ * thread_frame_exchange:
+ * @thr                  : threaded video handle.
+ * @value                : buffer index to put in ready.
+ *
+ * Atomically swaps @value with the triple buffer's ready index. 
+ * Acts as a full memory barrier, so whatever was written to the 
+ * buffer before is seen by the thread that gets it.
+ *
+ * Returns: previous value of ready.
+ **/
+static unsigned thread_frame_exchange(thread_video_t *thr, unsigned value)
+{
+#if defined(__GNUC__)
+   /* __sync_lock_test_and_set() is only an acquire barrier. */
+   __sync_synchronize();
+   return __sync_lock_test_and_set(&thr->frame.ready, value);
+#elif defined(_MSC_VER)
+   return _InterlockedExchange((volatile long*)&thr->frame.ready, value);
+#else
+   unsigned ret;
+
+   slock_lock(thr->lock);
+   ret               = thr->frame.ready;
+   thr->frame.ready  = value;
+   slock_unlock(thr->lock);
+   return ret;
+#endif
+}
+
 static void *thread_init_never_call(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
@@ -84,10 +168,36 @@ static void thread_update_driver_state(thread_video_t *thr)
    }
 }
 
+/**
+ * thread_release_hw_fences:
+ * @thr                  : threaded video handle.
+ *
+ * Deletes the fences of frames the video thread never took.
+ * Only called by the video thread.
+ **/
+static void thread_release_hw_fences(thread_video_t *thr)
+{
+   unsigned i;
+
+   if (!thr->hw_render)
+      return;
+
+   for (i = 0; i < THREAD_FRAME_BUFFERS; i++)
+   {
+      if (!thr->frame.buffers[i].hw_fence)
+         continue;
+
+      thr->poke->set_hw_render_frame(thr->driver_data, i,
+            thr->frame.buffers[i].hw_fence);
+      thr->frame.buffers[i].hw_fence = NULL;
+   }
+}
+
 static void thread_loop(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
    unsigned i = 0;
+   char redraw_msg[PATH_MAX_LENGTH];
    (void)i;
 
    for (;;)
@@ -95,12 +205,26 @@ static void thread_loop(void *data)
       enum thread_cmd send_cmd;
       bool ret = false;
       bool updated = false;
+      bool redraw = false;
 
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_NONE && !thr->frame.updated)
-         scond_wait(thr->cond_thread, thr->lock);
-      if (thr->frame.updated)
+      while (thr->send_cmd == CMD_NONE 
+            && !(thr->frame.ready & THREAD_FRAME_FRESH)
+            && !thr->frame.redraw)
+      {
+         slock_unlock(thr->lock);
+         sevent_wait(thr->wake_thread);
+         slock_lock(thr->lock);
+      }
+      if (thr->frame.ready & THREAD_FRAME_FRESH)
          updated = true;
+      else if (thr->frame.redraw)
+      {
+         redraw = true;
+         strlcpy(redraw_msg, thr->frame.redraw_msg, sizeof(redraw_msg));
+      }
+      /* A new frame shows whatever a redraw would have. */
+      thr->frame.redraw = false;
 
       /* To avoid race condition where send_cmd is updated 
        * right after the switch is checked. */
@@ -114,13 +238,19 @@ static void thread_loop(void *data)
             thr->driver_data = thr->driver->init(&thr->info,
                   thr->input, thr->input_data);
             thr->cmd_data.b = thr->driver_data;
-            thr->driver->viewport_info(thr->driver_data, &thr->vp);
+            {
+               struct video_viewport vp = {0};
+               thr->driver->viewport_info(thr->driver_data, &vp);
+               thread_set_viewport(thr, &vp);
+            }
             thread_reply(thr, CMD_INIT);
             break;
 
          case CMD_FREE:
             if (thr->driver_data)
             {
+               thread_release_hw_fences(thr);
+
                if (thr->driver && thr->driver->free)
                   thr->driver->free(thr->driver_data);
             }
@@ -199,8 +329,16 @@ static void thread_loop(void *data)
             break;
 
          case CMD_OVERLAY_LOAD:
+         case CMD_OVERLAY_LOAD_ATLAS:
 
-            if (thr->overlay && thr->overlay->load)
+            if (send_cmd == CMD_OVERLAY_LOAD_ATLAS)
+            {
+               if (thr->overlay && thr->overlay->load_atlas)
+                  ret = thr->overlay->load_atlas(thr->driver_data,
+                        thr->cmd_data.image.data,
+                        thr->cmd_data.image.num);
+            }
+            else if (thr->overlay && thr->overlay->load)
                ret = thr->overlay->load(thr->driver_data,
                      thr->cmd_data.image.data,
                      thr->cmd_data.image.num);
@@ -215,7 +353,7 @@ static void thread_loop(void *data)
                /* Avoid temporary garbage data. */
                thr->alpha_mod[i] = 1.0f;
             }
-            thread_reply(thr, CMD_OVERLAY_LOAD);
+            thread_reply(thr, send_cmd);
 
             break;
 
@@ -330,13 +468,42 @@ static void thread_loop(void *data)
             break;
       }
 
-      if (updated)
+      if (updated || redraw)
       {
-         ret = false;
-         bool alive = false;
-         bool focus = false;
-         bool has_windowed = true;
+         unsigned window_state = 0;
          struct video_viewport vp = {0};
+         const void *frame_data = NULL;
+         const char *msg = NULL;
+         struct thread_frame_buffer *frame = NULL;
+         ret = false;
+
+         if (updated)
+         {
+            /* Take the newest frame. The main thread can
+             * already fill the next one while we render. */
+            thr->frame.front = thread_frame_exchange(thr, thr->frame.front)
+               & ~THREAD_FRAME_FRESH;
+            frame = &thr->frame.buffers[thr->frame.front];
+
+            frame_data = frame->data;
+            msg        = *frame->msg ? frame->msg : NULL;
+
+            if (thr->hw_render)
+            {
+               thr->poke->set_hw_render_frame(thr->driver_data,
+                     thr->frame.front, frame->hw_fence);
+               frame->hw_fence = NULL;
+               frame_data      = RETRO_HW_FRAME_BUFFER_VALID;
+            }
+         }
+         else
+         {
+            /* Shows the last frame again. */
+            frame = &thr->frame.buffers[thr->frame.front];
+            msg   = *redraw_msg ? redraw_msg : NULL;
+         }
+
+         sevent_signal(thr->frame_taken);
 
          slock_lock(thr->frame.lock);
 
@@ -344,31 +511,29 @@ static void thread_loop(void *data)
 
          if (thr->driver && thr->driver->frame)
             ret = thr->driver->frame(thr->driver_data,
-               thr->frame.buffer, thr->frame.width, thr->frame.height,
-               thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
+               frame_data, frame->width, frame->height,
+               frame->pitch, msg);
 
          slock_unlock(thr->frame.lock);
 
-         if (thr->driver && thr->driver->alive)
-            alive = ret && thr->driver->alive(thr->driver_data);
+         if (thr->driver && thr->driver->alive && ret
+               && thr->driver->alive(thr->driver_data))
+            window_state |= THREAD_WINDOW_ALIVE;
 
-         if (thr->driver && thr->driver->focus)
-            focus = ret && thr->driver->focus(thr->driver_data);
+         if (thr->driver && thr->driver->focus && ret
+               && thr->driver->focus(thr->driver_data))
+            window_state |= THREAD_WINDOW_FOCUS;
 
-         if (thr->driver && thr->driver->has_windowed)
-            has_windowed = ret && thr->driver->has_windowed(thr->driver_data);
+         if (!thr->driver || !thr->driver->has_windowed ||
+               (ret && thr->driver->has_windowed(thr->driver_data)))
+            window_state |= THREAD_WINDOW_HAS_WINDOWED;
 
          if (thr->driver && thr->driver->viewport_info)
             thr->driver->viewport_info(thr->driver_data, &vp);
 
-         slock_lock(thr->lock);
-         thr->alive = alive;
-         thr->focus = focus;
-         thr->has_windowed = has_windowed;
-         thr->frame.updated = false;
-         thr->vp = vp;
-         scond_signal(thr->cond_cmd);
-         slock_unlock(thr->lock);
+         thread_set_viewport(thr, &vp);
+         THREAD_BARRIER();
+         thr->window_state = window_state;
       }
    }
 }
@@ -378,8 +543,9 @@ static void thread_send_cmd(thread_video_t *thr, enum thread_cmd cmd)
    slock_lock(thr->lock);
    thr->send_cmd = cmd;
    thr->reply_cmd = CMD_NONE;
-   scond_signal(thr->cond_thread);
    slock_unlock(thr->lock);
+
+   sevent_signal(thr->wake_thread);
 }
 
 static void thread_wait_reply(thread_video_t *thr, enum thread_cmd cmd)
@@ -392,7 +558,6 @@ static void thread_wait_reply(thread_video_t *thr, enum thread_cmd cmd)
 
 static bool thread_alive(void *data)
 {
-   bool ret;
    thread_video_t *thr = (thread_video_t*)data;
    runloop_t *runloop  = rarch_main_get_ptr();
 
@@ -403,58 +568,184 @@ static bool thread_alive(void *data)
       return thr->cmd_data.b;
    }
 
-   slock_lock(thr->lock);
-   ret = thr->alive;
-   slock_unlock(thr->lock);
-
-   return ret;
+   return thread_window_state(thr) & THREAD_WINDOW_ALIVE;
 }
 
 static bool thread_focus(void *data)
 {
-   bool ret;
    thread_video_t *thr = (thread_video_t*)data;
 
-   slock_lock(thr->lock);
-   ret = thr->focus;
-   slock_unlock(thr->lock);
-
-   return ret;
+   return thread_window_state(thr) & THREAD_WINDOW_FOCUS;
 }
 
 static bool thread_suppress_screensaver(void *data, bool enable)
 {
-   bool ret;
    thread_video_t *thr = (thread_video_t*)data;
 
-   slock_lock(thr->lock);
-   ret = thr->suppress_screensaver;
-   slock_unlock(thr->lock);
-
-   return ret;
+   /* Never changes after init. */
+   return thr->suppress_screensaver;
 }
 
 static bool thread_has_windowed(void *data)
 {
-   bool ret;
    thread_video_t *thr = (thread_video_t*)data;
 
-   slock_lock(thr->lock);
-   ret = thr->has_windowed;
-   slock_unlock(thr->lock);
+   return thread_window_state(thr) & THREAD_WINDOW_HAS_WINDOWED;
+}
 
-   return ret;
+/**
+ * thread_publish_frame:
+ * @thr                  : threaded video handle.
+ * @frame_               : frame of the core, or NULL for a dupe.
+ * @width                : width of the frame.
+ * @height               : height of the frame.
+ * @pitch                : pitch of the frame.
+ * @msg                  : message to show with it, or NULL.
+ *
+ * Copies the frame to the back buffer, unless the core rendered
+ * there already, and hands it to the video thread.
+ **/
+static void thread_publish_frame(thread_video_t *thr, const void *frame_,
+      unsigned width, unsigned height, unsigned pitch, const char *msg)
+{
+   unsigned copy_stride, ready;
+   struct thread_frame_buffer *back = NULL;
+   const uint8_t *src  = NULL;
+
+   back = &thr->frame.buffers[thr->frame.back];
+   src  = (const uint8_t*)frame_;
+
+   /* Duped frame, show the last one again. */
+   if (!src)
+   {
+      const struct thread_frame_buffer *last = 
+         &thr->frame.buffers[thr->frame.last];
+
+      src    = last->data;
+      width  = last->width;
+      height = last->height;
+      pitch  = last->pitch;
+   }
+
+   copy_stride = width * (thr->info.rgb32 
+         ? sizeof(uint32_t) : sizeof(uint16_t));
+
+   /* The core rendered to the framebuffer we gave it, 
+    * see thread_get_current_software_framebuffer(). */
+   if (src == back->data)
+      back->pitch = pitch;
+   else
+   {
+      unsigned h;
+      uint8_t *dst = back->data;
+
+      for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+         memcpy(dst, src, copy_stride);
+      back->pitch = copy_stride;
+   }
+
+   back->width  = width;
+   back->height = height;
+
+   if (msg)
+      strlcpy(back->msg, msg, sizeof(back->msg));
+   else
+      *back->msg = '\0';
+
+   ready = thread_frame_exchange(thr, thr->frame.back | THREAD_FRAME_FRESH);
+   thr->frame.last = thr->frame.back;
+   thr->frame.back = ready & ~THREAD_FRAME_FRESH;
+
+   /* Replaced a frame the video thread did not get to. */
+   if (ready & THREAD_FRAME_FRESH)
+      thr->miss_count++;
+   else
+      thr->hit_count++;
+
+   sevent_signal(thr->wake_thread);
+}
+
+/**
+ * thread_publish_hw_frame:
+ * @thr                  : threaded video handle.
+ * @frame_               : RETRO_HW_FRAME_BUFFER_VALID, or NULL for a dupe.
+ * @width                : width of the frame.
+ * @height               : height of the frame.
+ * @pitch                : pitch of the frame.
+ * @msg                  : message to show with it, or NULL.
+ *
+ * Hands the texture the core rendered to over to the video thread,
+ * along with a fence for its rendering, so the core can go on with
+ * the next frame while this one is presented. There is nothing to
+ * copy for dupes, or frames sent again while paused or in the menu,
+ * so the video thread shows the frame it has again for those.
+ **/
+static void thread_publish_hw_frame(thread_video_t *thr, const void *frame_,
+      unsigned width, unsigned height, unsigned pitch, const char *msg)
+{
+   unsigned ready;
+   struct thread_frame_buffer *back = &thr->frame.buffers[thr->frame.back];
+
+   if (!frame_ || !thr->frame.hw_rendered)
+   {
+      slock_lock(thr->lock);
+      thr->frame.redraw = true;
+      if (msg)
+         strlcpy(thr->frame.redraw_msg, msg, sizeof(thr->frame.redraw_msg));
+      else
+         *thr->frame.redraw_msg = '\0';
+      slock_unlock(thr->lock);
+
+      sevent_signal(thr->wake_thread);
+
+      if (thr->nonblock)
+         return;
+
+      /* Paced by the video thread, as new frames are. */
+      slock_lock(thr->lock);
+      while (thr->frame.redraw)
+      {
+         slock_unlock(thr->lock);
+         sevent_wait(thr->frame_taken);
+         slock_lock(thr->lock);
+      }
+      slock_unlock(thr->lock);
+      return;
+   }
+
+   thr->frame.hw_rendered = false;
+
+   /* A fence still set here is of a frame that got replaced
+    * before the video thread took it. */
+   back->hw_fence = thr->poke->hw_render_fence(thr->driver_data,
+         back->hw_fence);
+   back->width    = width;
+   back->height   = height;
+   back->pitch    = pitch;
+
+   if (msg)
+      strlcpy(back->msg, msg, sizeof(back->msg));
+   else
+      *back->msg = '\0';
+
+   ready = thread_frame_exchange(thr, thr->frame.back | THREAD_FRAME_FRESH);
+   thr->frame.last = thr->frame.back;
+   thr->frame.back = ready & ~THREAD_FRAME_FRESH;
+
+   if (ready & THREAD_FRAME_FRESH)
+      thr->miss_count++;
+   else
+      thr->hit_count++;
+
+   sevent_signal(thr->wake_thread);
 }
 
 static bool thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, unsigned pitch, const char *msg)
 {
-   unsigned copy_stride;
-   const uint8_t *src  = NULL;
-   uint8_t *dst        = NULL;
    thread_video_t *thr = (thread_video_t*)data;
 
-   /* If called from within read_viewport, we're actually in the 
+   /* If called from within read_viewport, we're actually in the
     * driver thread, so just render directly. */
    if (thr->frame.within_thread)
    {
@@ -469,14 +760,6 @@ static bool thread_frame(void *data, const void *frame_,
    RARCH_PERFORMANCE_INIT(thr_frame);
    RARCH_PERFORMANCE_START(thr_frame);
 
-   copy_stride = width * (thr->info.rgb32 
-         ? sizeof(uint32_t) : sizeof(uint16_t));
-
-   src = (const uint8_t*)frame_;
-   dst = thr->frame.buffer;
-
-   slock_lock(thr->lock);
-
    if (!thr->nonblock)
    {
       settings_t *settings = config_get_ptr();
@@ -485,8 +768,9 @@ static bool thread_frame(void *data, const void *frame_,
          roundf(1000000LL / settings->video.refresh_rate);
       retro_time_t target = thr->last_time + target_frame_time;
 
-      /* Ideally, use absolute time, but that is only a good idea on POSIX. */
-      while (thr->frame.updated)
+      /* Don't run ahead of the video thread by more than a frame.
+       * Ideally, use absolute time, but that is only a good idea on POSIX. */
+      while (thr->frame.ready & THREAD_FRAME_FRESH)
       {
          retro_time_t current = rarch_get_time_usec();
          retro_time_t delta = target - current;
@@ -494,47 +778,23 @@ static bool thread_frame(void *data, const void *frame_,
          if (delta <= 0)
             break;
 
-         if (!scond_wait_timeout(thr->cond_cmd, thr->lock, delta))
+         if (!sevent_wait_timeout(thr->frame_taken, delta))
             break;
       }
    }
 
-   /* Drop frame if updated flag is still set, as thread is 
-    * still working on last frame. */
-   if (!thr->frame.updated)
-   {
-      if (src)
-      {
-         unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
-
-      thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.pitch  = copy_stride;
-
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
-
-      scond_signal(thr->cond_thread);
+   if (thr->hw_render)
+      thread_publish_hw_frame(thr, frame_, width, height, pitch, msg);
+   else
+      thread_publish_frame(thr, frame_, width, height, pitch, msg);
 
 #if defined(HAVE_MENU)
-      if (thr->texture.enable)
-      {
-         while (thr->frame.updated)
-            scond_wait(thr->cond_cmd, thr->lock);
-      }
-#endif
-      thr->hit_count++;
+   if (thr->texture.enable)
+   {
+      while (thr->frame.ready & THREAD_FRAME_FRESH)
+         sevent_wait(thr->frame_taken);
    }
-   else
-      thr->miss_count++;
-
-   slock_unlock(thr->lock);
+#endif
 
    RARCH_PERFORMANCE_STOP(thr_frame);
 
@@ -552,30 +812,41 @@ static void thread_set_nonblock_state(void *data, bool state)
 static bool thread_init(thread_video_t *thr, const video_info_t *info,
       const input_driver_t **input, void **input_data)
 {
+   unsigned i;
    size_t max_size;
 
    thr->lock                 = slock_new();
    thr->alpha_lock           = slock_new();
    thr->frame.lock           = slock_new();
    thr->cond_cmd             = scond_new();
-   thr->cond_thread          = scond_new();
+   thr->wake_thread          = sevent_new();
+   thr->frame_taken          = sevent_new();
    thr->input                = input;
    thr->input_data           = input_data;
    thr->info                 = *info;
-   thr->alive                = true;
-   thr->focus                = true;
-   thr->has_windowed         = true;
+   thr->window_state         = THREAD_WINDOW_ALIVE
+      | THREAD_WINDOW_FOCUS | THREAD_WINDOW_HAS_WINDOWED;
    thr->suppress_screensaver = true;
 
    max_size                  = info->input_scale * RARCH_SCALE_BASE;
    max_size                 *= max_size;
    max_size                 *= info->rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
-   thr->frame.buffer        = (uint8_t*)malloc(max_size);
+   thr->frame.size           = max_size;
 
-   if (!thr->frame.buffer)
-      return false;
+   for (i = 0; i < THREAD_FRAME_BUFFERS; i++)
+   {
+      thr->frame.buffers[i].data = (uint8_t*)malloc(max_size);
+
+      if (!thr->frame.buffers[i].data)
+         return false;
 
-   memset(thr->frame.buffer, 0x80, max_size);
+      memset(thr->frame.buffers[i].data, 0x80, max_size);
+   }
+
+   thr->frame.back           = 0;
+   thr->frame.ready          = 1;
+   thr->frame.front          = 2;
+   thr->frame.last           = 1;
 
    thr->last_time       = rarch_get_time_usec();
    thr->thread          = sthread_create(thread_loop, thr);
@@ -631,12 +902,12 @@ static void thread_viewport_info(void *data, struct video_viewport *vp)
    if (!thr)
       return;
 
-   slock_lock(thr->lock);
-   *vp = thr->vp;
+   thread_get_viewport(thr, vp);
 
-   /* Explicitly mem-copied so we can use memcmp correctly later. */
-   memcpy(&thr->read_vp, &thr->vp, sizeof(thr->vp));
-   slock_unlock(thr->lock);
+   /* Explicitly mem-copied so we can use memcmp correctly later.
+    * Only read by the video thread while the caller waits for
+    * CMD_READ_VIEWPORT, so this needs no lock either. */
+   memcpy(&thr->read_vp, vp, sizeof(*vp));
 }
 
 static bool thread_read_viewport(void *data, uint8_t *buffer)
@@ -654,10 +925,15 @@ static bool thread_read_viewport(void *data, uint8_t *buffer)
 
 static void thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    if (!thr)
       return;
 
+   /* The context of the core goes away with the driver. */
+   if (thr->hw_render)
+      thr->poke->bind_hw_render_thread(thr->driver_data, false);
+
    thread_send_cmd(thr, CMD_FREE);
    thread_wait_reply(thr, CMD_FREE);
    sthread_join(thr->thread);
@@ -665,11 +941,13 @@ static void thread_free(void *data)
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
-   free(thr->frame.buffer);
+   for (i = 0; i < THREAD_FRAME_BUFFERS; i++)
+      free(thr->frame.buffers[i].data);
    slock_free(thr->frame.lock);
    slock_free(thr->lock);
    scond_free(thr->cond_cmd);
-   scond_free(thr->cond_thread);
+   sevent_free(thr->wake_thread);
+   sevent_free(thr->frame_taken);
 
    free(thr->alpha_mod);
    slock_free(thr->alpha_lock);
@@ -708,6 +986,22 @@ static bool thread_overlay_load(void *data,
    return thr->cmd_data.b;
 }
 
+static bool thread_overlay_load_atlas(void *data,
+      const struct texture_image *atlas, unsigned num_images)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+
+   if (!thr)
+      return false;
+
+   thr->cmd_data.image.data = atlas;
+   thr->cmd_data.image.num = num_images;
+   thread_send_cmd(thr, CMD_OVERLAY_LOAD_ATLAS);
+   thread_wait_reply(thr, CMD_OVERLAY_LOAD_ATLAS);
+
+   return thr->cmd_data.b;
+}
+
 static void thread_overlay_tex_geom(void *data,
       unsigned idx, float x, float y, float w, float h)
 {
@@ -769,6 +1063,18 @@ static const video_overlay_interface_t thread_overlay = {
    thread_overlay_vertex_geom,
    thread_overlay_full_screen,
    thread_overlay_set_alpha,
+   NULL,
+};
+
+/* For drivers which can load overlay atlases. */
+static const video_overlay_interface_t thread_overlay_atlas = {
+   thread_overlay_enable,
+   thread_overlay_load,
+   thread_overlay_tex_geom,
+   thread_overlay_vertex_geom,
+   thread_overlay_full_screen,
+   thread_overlay_set_alpha,
+   thread_overlay_load_atlas,
 };
 
 static void thread_get_overlay_interface(void *data,
@@ -777,8 +1083,9 @@ static void thread_get_overlay_interface(void *data,
    thread_video_t *thr = (thread_video_t*)data;
    if (!thr)
       return;
-   *iface = &thread_overlay;
    thr->driver->overlay_interface(thr->driver_data, &thr->overlay);
+   *iface = (thr->overlay && thr->overlay->load_atlas) ?
+      &thread_overlay_atlas : &thread_overlay;
 }
 #endif
 
@@ -932,6 +1239,72 @@ static struct video_shader *thread_get_current_shader(void *data)
    return thr->poke->get_current_shader(thr->driver_data);
 }
 
+/**
+ * thread_get_current_software_framebuffer:
+ * @data                 : threaded video handle.
+ * @framebuffer          : framebuffer the core asks for.
+ *
+ * Lets the core render straight into the buffer the next frame 
+ * is handed to the video thread in, which thread_frame() then 
+ * does not have to copy.
+ *
+ * Returns: true (1) if the frame fits, otherwise false (0).
+ **/
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+   size_t pixel_size   = thr->info.rgb32 
+      ? sizeof(uint32_t) : sizeof(uint16_t);
+
+   if ((size_t)framebuffer->width * framebuffer->height * pixel_size 
+         > thr->frame.size)
+      return false;
+
+   framebuffer->data         = thr->frame.buffers[thr->frame.back].data;
+   framebuffer->pitch        = framebuffer->width * pixel_size;
+   framebuffer->format       = thr->info.rgb32 
+      ? RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+   return true;
+}
+
+#ifdef HAVE_FBO
+/**
+ * thread_get_current_framebuffer:
+ * @data                 : threaded video handle.
+ *
+ * Gives the core the framebuffer of the texture of the back
+ * buffer, which thread_publish_hw_frame() hands to the video
+ * thread next.
+ *
+ * Returns: framebuffer for the core to render to, or 0.
+ **/
+static uintptr_t thread_get_current_framebuffer(void *data)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+
+   if (!thr || !thr->hw_render)
+      return 0;
+
+   thr->frame.hw_rendered = true;
+   return thr->poke->get_hw_render_framebuffer(thr->driver_data,
+         thr->frame.back);
+}
+#endif
+
+static retro_proc_address_t thread_get_proc_address(void *data,
+      const char *sym)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+
+   if (!thr || !thr->poke || !thr->poke->get_proc_address)
+      return NULL;
+
+   /* Only looks up symbols, which works from any thread. */
+   return thr->poke->get_proc_address(thr->driver_data, sym);
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_set_video_mode,
    thread_set_filtering,
@@ -939,9 +1312,9 @@ static const video_poke_interface_t thread_poke = {
    thread_get_video_output_prev,
    thread_get_video_output_next,
 #ifdef HAVE_FBO
-   NULL,
+   thread_get_current_framebuffer,
 #endif
-   NULL,
+   thread_get_proc_address,
    thread_set_aspect_ratio,
    thread_apply_state_changes,
 #if defined(HAVE_MENU)
@@ -954,6 +1327,7 @@ static const video_poke_interface_t thread_poke = {
    NULL,
 
    thread_get_current_shader,
+   thread_get_current_software_framebuffer,
 };
 
 static void thread_get_poke_interface(void *data,
@@ -1013,6 +1387,37 @@ static void thread_set_callbacks(thread_video_t *thr,
       thr->video_thread.poke_interface = NULL;
 }
 
+/**
+ * thread_init_hw_render:
+ * @thr                  : threaded video handle.
+ *
+ * Makes the context of the hardware rendering core current
+ * on this thread, which keeps running the core.
+ *
+ * Returns: true (1) if the driver supports this, otherwise false (0).
+ **/
+static bool thread_init_hw_render(thread_video_t *thr)
+{
+   if (!thr->driver_data || !thr->driver->poke_interface)
+      return false;
+
+   if (!thr->poke)
+      thr->driver->poke_interface(thr->driver_data, &thr->poke);
+
+   if (!thr->poke
+         || !thr->poke->bind_hw_render_thread
+         || !thr->poke->get_hw_render_framebuffer
+         || !thr->poke->hw_render_fence
+         || !thr->poke->set_hw_render_frame)
+      return false;
+
+   if (!thr->poke->bind_hw_render_thread(thr->driver_data, true))
+      return false;
+
+   thr->hw_render = true;
+   return true;
+}
+
 /**
  * rarch_threaded_video_init:
  * @out_driver                : Output video driver
@@ -1040,7 +1445,29 @@ bool rarch_threaded_video_init(const video_driver_t **out_driver,
    thr->driver = drv;
    *out_driver = &thr->video_thread;
    *out_data   = thr;
-   return thread_init(thr, info, input, input_data);
+
+   if (thread_init(thr, info, input, input_data)
+         && (!info->hw_render_threaded || thread_init_hw_render(thr)))
+      return true;
+
+   if (!info->hw_render_threaded)
+      return false;
+
+   /* Hardware rendering cores fall back to the driver without
+    * the wrapper, so leave nothing of it behind. */
+   RARCH_WARN("[Thread]: Video driver can't take frames rendered on another thread.\n");
+
+   if (thr->driver_data && *input && *input_data
+         && *input_data != thr->driver_data && (*input)->free)
+      (*input)->free(*input_data);
+   *input      = NULL;
+   *input_data = NULL;
+
+   if (thr->thread)
+      thread_free(thr);
+   *out_driver = drv;
+   *out_data   = NULL;
+   return false;
 }
 
 /**
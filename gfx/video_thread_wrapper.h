@@ -36,6 +36,7 @@ enum thread_cmd
 #ifdef HAVE_OVERLAY
    CMD_OVERLAY_ENABLE,
    CMD_OVERLAY_LOAD,
+   CMD_OVERLAY_LOAD_ATLAS,
    CMD_OVERLAY_TEX_GEOM,
    CMD_OVERLAY_VERTEX_GEOM,
    CMD_OVERLAY_FULL_SCREEN,
@@ -58,11 +59,31 @@ enum thread_cmd
    CMD_DUMMY = INT_MAX
 };
 
+#define THREAD_FRAME_BUFFERS 3
+/* Set in ready while the frame there was not picked up 
+ * by the video thread yet. */
+#define THREAD_FRAME_FRESH 4
+
+struct thread_frame_buffer
+{
+   uint8_t *data;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   char msg[PATH_MAX_LENGTH];
+   /* With hw_render, signaled once the core's rendering to
+    * the texture of this buffer finished. */
+   void *hw_fence;
+};
+
 typedef struct thread_video
 {
    slock_t *lock;
    scond_t *cond_cmd;
-   scond_t *cond_thread;
+   /* Set for new commands and frames. */
+   sevent_t *wake_thread;
+   /* Set when the video thread takes a frame. */
+   sevent_t *frame_taken;
    sthread_t *thread;
 
    video_info_t info;
@@ -93,10 +114,15 @@ typedef struct thread_video
 #endif
    bool apply_state_changes;
 
-   bool alive;
-   bool focus;
+   /* The core renders on the main thread, with a context of its
+    * own, to the driver's texture of the buffer it'd otherwise
+    * write the frame to. See thread_get_current_framebuffer(). */
+   bool hw_render;
+
+   /* THREAD_WINDOW_* flags, published by the video thread
+    * after every frame and read without taking any lock. */
+   volatile unsigned window_state;
    bool suppress_screensaver;
-   bool has_windowed;
    bool nonblock;
 
    retro_time_t last_time;
@@ -186,19 +212,38 @@ typedef struct thread_video
 
    } cmd_data;
 
+   /* Written by the video thread only, under the vp_seq
+    * sequence count, so readers never wait for it. */
    struct video_viewport vp;
+   volatile unsigned vp_seq;
    struct video_viewport read_vp; /* Last viewport reported to caller. */
 
    struct
    {
+      /* Guards the menu texture and state changes 
+       * the video thread applies before rendering. */
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      bool updated;
+
+      /* Triple buffer. The main thread fills buffers[back] and the 
+       * video thread renders buffers[front], so neither waits for 
+       * the other. They swap their buffer with the one in ready, 
+       * which is only ever exchanged atomically. */
+      struct thread_frame_buffer buffers[THREAD_FRAME_BUFFERS];
+      size_t size;
+      unsigned back;
+      unsigned front;
+      volatile unsigned ready;
+      /* Buffer published last, shown again on duped frames. */
+      unsigned last;
       bool within_thread;
-      char msg[PATH_MAX_LENGTH];
+
+      /* With hw_render, set when the core asked for the framebuffer
+       * to render the next frame to. */
+      bool hw_rendered;
+      /* With hw_render, set for the video thread to show its frame
+       * again, since duped frames have no buffer to copy. */
+      bool redraw;
+      char redraw_msg[PATH_MAX_LENGTH];
    } frame;
 
    video_driver_t video_thread;
@@ -0,0 +1,103 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "video_work_pool.h"
+#include "../general.h"
+#include "../performance.h"
+
+#ifdef HAVE_THREADS
+#include <rthreads/rpool.h>
+
+#define VIDEO_WORK_POOL_MAX_THREADS 8
+
+static rpool_t *work_pool;
+static unsigned work_pool_refs;
+
+static rpool_t *video_work_pool_start(void)
+{
+   rpool_t *pool;
+   struct rpool_attr attr = {0};
+   unsigned threads       = rarch_get_cpu_cores();
+
+   /* The calling thread works as well. */
+   if (threads > VIDEO_WORK_POOL_MAX_THREADS)
+      threads = VIDEO_WORK_POOL_MAX_THREADS;
+   if (threads < 2)
+      return NULL;
+
+   attr.num_threads = threads - 1;
+   attr.priority    = RPOOL_PRIORITY_NORMAL;
+
+   pool = rpool_new(&attr);
+   if (!pool)
+   {
+      RARCH_WARN("Failed to start video worker threads.\n");
+      return NULL;
+   }
+
+   RARCH_LOG("Started %u video worker threads.\n", rpool_num_threads(pool));
+   return pool;
+}
+#endif
+
+bool video_work_pool_init(void)
+{
+#ifdef HAVE_THREADS
+   if (work_pool_refs++ == 0)
+      work_pool = video_work_pool_start();
+   return work_pool != NULL;
+#else
+   return false;
+#endif
+}
+
+void video_work_pool_deinit(void)
+{
+#ifdef HAVE_THREADS
+   if (!work_pool_refs)
+      return;
+
+   if (--work_pool_refs == 0)
+   {
+      rpool_free(work_pool);
+      work_pool = NULL;
+   }
+#endif
+}
+
+unsigned video_work_pool_num_threads(void)
+{
+#ifdef HAVE_THREADS
+   return rpool_num_threads(work_pool) + 1;
+#else
+   return 1;
+#endif
+}
+
+void video_work_pool_run(video_work_pool_work_t work,
+      void *userdata, unsigned count)
+{
+#ifdef HAVE_THREADS
+   /* Runs serially without a pool. */
+   rpool_run(work_pool, work, userdata, count);
+#else
+   unsigned i;
+
+   for (i = 0; i < count; i++)
+      work(userdata, i, 0);
+#endif
+}
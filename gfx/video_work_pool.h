@@ -0,0 +1,80 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VIDEO_WORK_POOL_H
+#define __VIDEO_WORK_POOL_H
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Processes work item @index on thread @thread, which goes from 0 
+ * to video_work_pool_num_threads() - 1. No two items of one 
+ * video_work_pool_run() call run on the same @thread at once, 
+ * so it can index per-thread scratch memory. */
+typedef void (*video_work_pool_work_t)(void *userdata,
+      unsigned index, unsigned thread);
+
+/**
+ * video_work_pool_init:
+ *
+ * Takes a reference to the worker pool shared by the CPU-side 
+ * video paths (pixel conversion, softfilters, image decoding), 
+ * starting it on first use.
+ *
+ * Returns: true (1) if workers are available, otherwise false (0), 
+ * in which case video_work_pool_run() runs everything on the caller.
+ **/
+bool video_work_pool_init(void);
+
+/**
+ * video_work_pool_deinit:
+ *
+ * Drops a reference taken by video_work_pool_init().
+ * The workers are stopped with the last one.
+ **/
+void video_work_pool_deinit(void);
+
+/**
+ * video_work_pool_num_threads:
+ *
+ * Returns: number of threads running work items, 
+ * including the calling thread.
+ **/
+unsigned video_work_pool_num_threads(void);
+
+/**
+ * video_work_pool_run:
+ * @work                 : Callback processing one work item.
+ * @userdata             : Passed to @work.
+ * @count                : Number of work items.
+ *
+ * Runs items 0 to @count - 1 and waits for all of them.
+ * Threads claim items one by one as they become idle, 
+ * including the calling thread, so splitting work into more 
+ * items than threads evens out uneven item costs. Several 
+ * threads can call this at once, sharing the workers.
+ **/
+void video_work_pool_run(video_work_pool_work_t work,
+      void *userdata, unsigned count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
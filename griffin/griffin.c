@@ -81,6 +81,7 @@ CONFIG FILE
 CHEATS
 ============================================================ */
 #include "../cheats.c"
+#include "../cheat_search.c"
 #include "../hash.c"
 
 /*============================================================
@@ -173,6 +174,7 @@ VIDEO IMAGE
 #include "../gfx/video_texture.c"
 
 #include "../libretro-common/formats/tga/tga_decode.c"
+#include "../libretro-common/formats/ktx/rktx.c"
 
 #ifdef HAVE_RPNG
 #include "../libretro-common/formats/png/rpng_fbio.c"
@@ -274,12 +276,14 @@ FONTS
 INPUT
 ============================================================ */
 #include "../input/input_autodetect.c"
+#include "../input/input_autoconfig_db.c"
 #include "../input/input_joypad_driver.c"
 #include "../input/input_joypad.c"
 #include "../input/input_hid_driver.c"
 #include "../input/input_common.c"
 #include "../input/input_keymaps.c"
 #include "../input/input_remapping.c"
+#include "../input/input_latency.c"
 #include "../input/input_sensor.c"
 #include "../input/keyboard_line.c"
 
@@ -374,6 +378,7 @@ INPUT (HID)
 #include "../input/connect/connect_ps3.c"
 #include "../input/connect/connect_ps4.c"
 #include "../input/connect/connect_wii.c"
+#include "../input/connect/connect_generic.c"
 #endif
 
 /*============================================================
@@ -409,6 +414,7 @@ STATE TRACKER
 FIFO BUFFER
 ============================================================ */
 #include "../libretro-common/queues/fifo_buffer.c"
+#include "../libretro-common/queues/fifo_spsc.c"
 
 /*============================================================
 AUDIO RESAMPLER
@@ -471,10 +477,18 @@ AUDIO
 #include "../audio/drivers/dsound.c"
 #endif
 
+#ifdef HAVE_WASAPI
+#include "../audio/drivers/wasapi.c"
+#endif
+
 #ifdef HAVE_SL
 #include "../audio/drivers/opensl.c"
 #endif
 
+#ifdef HAVE_AAUDIO
+#include "../audio/drivers/aaudio.c"
+#endif
+
 #ifdef HAVE_ALSA
 #ifdef __QNX__
 #include "../audio/drivers/alsa_qsa.c"
@@ -500,10 +514,13 @@ DRIVERS
 #include "../gfx/video_driver.c"
 #include "../gfx/video_monitor.c"
 #include "../gfx/video_pixel_converter.c"
+#include "../gfx/video_frame_diff.c"
+#include "../gfx/video_work_pool.c"
 #include "../gfx/video_viewport.c"
 #include "../input/input_driver.c"
 #include "../audio/audio_driver.c"
 #include "../audio/audio_monitor.c"
+#include "../audio/audio_profiler.c"
 #include "../camera/camera_driver.c"
 #include "../location/location_driver.c"
 #include "../menu/menu_driver.c"
@@ -560,9 +577,18 @@ FILE
 #include "../file_path_special.c"
 #include "../libretro-common/file/dir_list.c"
 #include "../libretro-common/string/string_list.c"
+#include "../libretro-common/memory/ralloc.c"
 #include "../libretro-common/string/stdstring.c"
 #include "../file_ops.c"
+#if defined(_WIN32) && !defined(_XBOX)
+#include "../libretro-common/file/nbio/nbio_windows.c"
+#elif defined(HAVE_IO_URING)
+#include "../libretro-common/file/nbio/nbio_linux.c"
+#elif defined(HAVE_MMAP)
+#include "../libretro-common/file/nbio/nbio_unixmmap.c"
+#else
 #include "../libretro-common/file/nbio/nbio_stdio.c"
+#endif
 #include "../libretro-common/file/file_list.c"
 
 /*============================================================
@@ -584,6 +610,11 @@ CONFIGURATION
 REWIND
 ============================================================ */
 #include "../rewind.c"
+#include "../runahead.c"
+
+#ifdef HAVE_SHM
+#include "../shm_export.c"
+#endif
 
 /*============================================================
 FRONTEND
@@ -649,6 +680,10 @@ GIT
 /*============================================================
 RETROARCH
 ============================================================ */
+/* libco.h has to be seen by libco.c first. */
+#ifdef HAVE_LIBCO
+#include "../libretro-common/libco/libco.c"
+#endif
 #include "../libretro_version_1.c"
 #include "../retroarch.c"
 #include "../runloop.c"
@@ -660,6 +695,7 @@ RECORDING
 #include "../movie.c"
 #include "../record/record_driver.c"
 #include "../record/drivers/record_null.c"
+#include "../record/drivers/record_raw.c"
 
 /*============================================================
 THREAD
@@ -668,6 +704,7 @@ THREAD
 #include "../thread/xenon_sdl_threads.c"
 #elif defined(HAVE_THREADS)
 #include "../libretro-common/rthreads/rthreads.c"
+#include "../libretro-common/rthreads/rpool.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
 #include "../autosave.c"
@@ -680,6 +717,7 @@ NETPLAY
 #ifdef HAVE_NETPLAY
 #include "../netplay.c"
 #include "../libretro-common/net/net_compat.c"
+#include "../libretro-common/net/net_resolve.c"
 #include "../libretro-common/net/net_http.c"
 #endif
 
@@ -702,6 +740,7 @@ MENU
 #include "../menu/menu_common_list.c"
 #include "../menu/menu_setting.c"
 #include "../menu/menu_list.c"
+#include "../menu/menu_search.c"
 #include "../menu/menu_entries.c"
 #include "../menu/menu_entries_cbs_ok.c"
 #include "../menu/menu_entries_cbs_cancel.c"
@@ -747,6 +786,9 @@ MENU
 
 #ifdef HAVE_COMMAND
 #include "../command.c"
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+#include "../command_binary.c"
+#endif
 #endif
 
 #include "../command_event.c"
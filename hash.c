@@ -23,9 +23,27 @@
 #include <unistd.h>
 #endif
 #include "hash.h"
+#include <boolean.h>
 #include <retro_miscellaneous.h>
 #include <retro_endianness.h>
 
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && \
+   ((defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || \
+    defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1500))
+#define CRC32_CLMUL
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_CLMUL_TARGET
+#else
+/* Only the CLMUL path is built for these, dispatch is at runtime. */
+#define CRC32_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#endif
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 #define LSL32(x, n) ((uint32_t)(x) << (n))
 #define LSR32(x, n) ((uint32_t)(x) >> (n))
 #define ROR32(x, n) (LSR32(x, n) | LSL32(x, 32 - (n)))
@@ -183,7 +201,6 @@ void sha256_hash(char *out, const uint8_t *in, size_t size)
       snprintf(out + 2 * i, 3, "%02x", (unsigned)shahash.u8[i]);
 }
 
-#ifndef HAVE_ZLIB
 /* Zlib CRC32. */
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -231,21 +248,269 @@ static const uint32_t crc32_table[256] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-uint32_t crc32_adjust(uint32_t checksum, uint8_t input)
+static INLINE uint32_t crc32_adjust(uint32_t checksum, uint8_t input)
 {
    return ((checksum >> 8) & 0x00ffffff) ^ crc32_table[(checksum ^ input) & 0xff];
 }
 
-uint32_t crc32_calculate(const uint8_t *data, size_t length)
+/* crc32_table advanced by 1 to 7 more zero bytes, so eight bytes
+ * can be folded in with one lookup each (slice-by-8). */
+static uint32_t crc32_slice_table[7][256];
+static bool crc32_slice_table_ready;
+
+static void crc32_init_slice_table(void)
+{
+   unsigned i, j;
+
+   /* Every thread computes the same values, so racing here is harmless. */
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t crc = crc32_table[i];
+
+      for (j = 0; j < 7; j++)
+      {
+         crc = (crc >> 8) ^ crc32_table[crc & 0xff];
+         crc32_slice_table[j][i] = crc;
+      }
+   }
+
+   crc32_slice_table_ready = true;
+}
+
+static uint32_t crc32_update_slice8(uint32_t crc,
+      const uint8_t *data, size_t length)
+{
+#ifndef MSB_FIRST
+   if (!crc32_slice_table_ready)
+      crc32_init_slice_table();
+
+   for (; length >= 8; data += 8, length -= 8)
+   {
+      uint32_t lo = crc ^ (data[0] | (data[1] << 8) |
+            (data[2] << 16) | ((uint32_t)data[3] << 24));
+      uint32_t hi = data[4] | (data[5] << 8) |
+         (data[6] << 16) | ((uint32_t)data[7] << 24);
+
+      crc = crc32_slice_table[6][lo & 0xff]
+         ^ crc32_slice_table[5][(lo >> 8) & 0xff]
+         ^ crc32_slice_table[4][(lo >> 16) & 0xff]
+         ^ crc32_slice_table[3][lo >> 24]
+         ^ crc32_slice_table[2][hi & 0xff]
+         ^ crc32_slice_table[1][(hi >> 8) & 0xff]
+         ^ crc32_slice_table[0][(hi >> 16) & 0xff]
+         ^ crc32_table[hi >> 24];
+   }
+#endif
+
+   for (; length; length--)
+      crc = crc32_adjust(crc, *data++);
+
+   return crc;
+}
+
+#ifdef CRC32_CLMUL
+/* Folds 64 bytes at a time with carry-less multiplies and reduces
+ * the result with Barrett reduction, after Intel's "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ * @crc is in the inverted domain and @length a multiple of 16,
+ * at least 64. */
+CRC32_CLMUL_TARGET
+static uint32_t crc32_update_clmul(uint32_t crc,
+      const uint8_t *data, size_t length)
+{
+   static const uint64_t k1k2[] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+   static const uint64_t k3k4[] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+   static const uint64_t k5k0[] = { 0x0163cd6124ULL, 0x0000000000ULL };
+   static const uint64_t poly[] = { 0x01db710641ULL, 0x01f7011641ULL };
+   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+   x1 = _mm_loadu_si128((const __m128i*)(data + 0x00));
+   x2 = _mm_loadu_si128((const __m128i*)(data + 0x10));
+   x3 = _mm_loadu_si128((const __m128i*)(data + 0x20));
+   x4 = _mm_loadu_si128((const __m128i*)(data + 0x30));
+   x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+   x0 = _mm_loadu_si128((const __m128i*)k1k2);
+
+   data   += 64;
+   length -= 64;
+
+   /* Four independent folds keep the multiplier busy. */
+   for (; length >= 64; data += 64, length -= 64)
+   {
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+            _mm_loadu_si128((const __m128i*)(data + 0x00)));
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+            _mm_loadu_si128((const __m128i*)(data + 0x10)));
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+            _mm_loadu_si128((const __m128i*)(data + 0x20)));
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+            _mm_loadu_si128((const __m128i*)(data + 0x30)));
+   }
+
+   /* Fold the four lanes into one. */
+   x0 = _mm_loadu_si128((const __m128i*)k3k4);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+   for (; length >= 16; data += 16, length -= 16)
+   {
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+            _mm_loadu_si128((const __m128i*)data));
+   }
+
+   /* 128 to 64 bits. */
+   x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+   x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+   x1 = _mm_srli_si128(x1, 8);
+   x1 = _mm_xor_si128(x1, x2);
+
+   x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+
+   x2 = _mm_srli_si128(x1, 4);
+   x1 = _mm_and_si128(x1, x3);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   /* Barrett reduction to 32 bits. */
+   x0 = _mm_loadu_si128((const __m128i*)poly);
+
+   x2 = _mm_and_si128(x1, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+   x2 = _mm_and_si128(x2, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static bool crc32_have_clmul(void)
 {
-   size_t i;
-   uint32_t checksum = ~0;
-   for (i = 0; i < length; i++)
-      checksum = crc32_adjust(checksum, data[i]);
-   return ~checksum;
+   static int have_clmul = -1;
+
+   if (have_clmul < 0)
+   {
+#if defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 1);
+      /* PCLMULQDQ and SSE4.1 */
+      have_clmul = (info[2] & (1 << 1)) && (info[2] & (1 << 19));
+#else
+      have_clmul = __builtin_cpu_supports("pclmul") &&
+         __builtin_cpu_supports("sse4.1");
+#endif
+   }
+
+   return have_clmul;
 }
 #endif
 
+/**
+ * crc32_update:
+ * @crc               : CRC32 of the data so far, 0 to start.
+ * @data              : Data to add.
+ * @length            : Size of @data.
+ *
+ * Continues a zlib-compatible CRC32. Uses carry-less multiplies
+ * (x86) or CRC32 instructions (ARMv8) where available, slice-by-8
+ * table lookups otherwise.
+ *
+ * Returns: CRC32 of the data so far and @data.
+ **/
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+   crc = ~crc;
+
+#if defined(CRC32_CLMUL)
+   if (length >= 64 && crc32_have_clmul())
+   {
+      size_t blocks = length & ~(size_t)15;
+
+      crc     = crc32_update_clmul(crc, data, blocks);
+      data   += blocks;
+      length -= blocks;
+   }
+#elif defined(__ARM_FEATURE_CRC32)
+   for (; length >= 8; data += 8, length -= 8)
+   {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+      crc = __crc32d(crc, word);
+   }
+
+   for (; length; length--)
+      crc = __crc32b(crc, *data++);
+#endif
+
+   return ~crc32_update_slice8(crc, data, length);
+}
+
+/**
+ * crc32_calculate:
+ * @data              : Data to hash.
+ * @length            : Size of @data.
+ *
+ * Returns: zlib-compatible CRC32 of @data.
+ **/
+uint32_t crc32_calculate(const uint8_t *data, size_t length)
+{
+   return crc32_update(0, data, length);
+}
+
+/**
+ * crc32_calculate_file:
+ * @path              : Path of the file to hash.
+ * @crc               : Set to the CRC32 of the file.
+ *
+ * Hashes the file a block at a time, without loading it whole.
+ *
+ * Returns: true (1) if the file could be read, otherwise false (0).
+ **/
+bool crc32_calculate_file(const char *path, uint32_t *crc)
+{
+   uint8_t buff[64 * 1024];
+   size_t len;
+   uint32_t value = 0;
+   FILE *file     = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   while ((len = fread(buff, 1, sizeof(buff), file)) > 0)
+      value = crc32_update(value, buff, len);
+
+   if (ferror(file))
+   {
+      fclose(file);
+      return false;
+   }
+
+   fclose(file);
+   *crc = value;
+   return true;
+}
+
 /* SHA-1 implementation. */
 
 /*
@@ -42,6 +42,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <boolean.h>
 
 #include <compat/msvc.h>
 #ifdef HAVE_CONFIG_H
@@ -76,5 +77,36 @@ typedef struct SHA1Context
 
 int sha1_calculate(const char *path, char *result);
 
+/**
+ * crc32_update:
+ * @crc               : CRC32 of the data so far, 0 to start.
+ * @data              : Data to add.
+ * @length            : Size of @data.
+ *
+ * Continues a zlib-compatible CRC32, using CPU instructions for
+ * it where available.
+ *
+ * Returns: CRC32 of the data so far and @data.
+ **/
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length);
+
+/**
+ * crc32_calculate:
+ * @data              : Data to hash.
+ * @length            : Size of @data.
+ *
+ * Returns: zlib-compatible CRC32 of @data.
+ **/
+uint32_t crc32_calculate(const uint8_t *data, size_t length);
+
+/**
+ * crc32_calculate_file:
+ * @path              : Path of the file to hash.
+ * @crc               : Set to the CRC32 of the file.
+ *
+ * Returns: true (1) if the file could be read, otherwise false (0).
+ **/
+bool crc32_calculate_file(const char *path, uint32_t *crc);
+
 #endif
 
@@ -0,0 +1,509 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2014-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <boolean.h>
+#include "joypad_connection.h"
+
+/* Generic HID joypad.
+ *
+ * Input reports are decoded from the layout given in the
+ * device's report descriptor, so any pad reporting as a
+ * joystick or gamepad works without pad specific code.
+ *
+ * Buttons are reported in HID order, followed by the four
+ * directions of the first hat switch (up, right, down, left).
+ * Axes are X, Y, Z, Rx, Ry and Rz, in that order.
+ */
+
+#define HIDPAD_GENERIC_MAX_FIELDS  64
+#define HIDPAD_GENERIC_MAX_USAGES  32
+#define HIDPAD_GENERIC_MAX_BUTTONS 28
+#define HIDPAD_GENERIC_MAX_AXES    6
+#define HIDPAD_GENERIC_STACK_SIZE  4
+
+enum hidpad_generic_field_type
+{
+   HIDPAD_GENERIC_BUTTON = 0,
+   HIDPAD_GENERIC_AXIS,
+   HIDPAD_GENERIC_HAT
+};
+
+struct hidpad_generic_field
+{
+   enum hidpad_generic_field_type type;
+   uint8_t report_id;
+   uint8_t index;
+   uint16_t bit_offset;
+   uint8_t bit_size;
+   int32_t logical_min;
+   int32_t logical_max;
+};
+
+struct hidpad_generic_globals
+{
+   uint16_t usage_page;
+   int32_t logical_min;
+   int32_t logical_max;
+   uint32_t report_size;
+   uint32_t report_count;
+   uint8_t report_id;
+};
+
+struct hidpad_generic_data
+{
+   struct hidpad_generic_field fields[HIDPAD_GENERIC_MAX_FIELDS];
+   unsigned num_fields;
+   unsigned num_buttons;
+   bool has_report_id;
+
+   uint32_t buttons;
+   int16_t axes[HIDPAD_GENERIC_MAX_AXES];
+};
+
+static uint32_t hidpad_generic_item_data(const uint8_t *data, unsigned size)
+{
+   switch (size)
+   {
+      case 1:
+         return data[0];
+      case 2:
+         return data[0] | (data[1] << 8);
+      case 4:
+         return data[0] | (data[1] << 8) | (data[2] << 16)
+            | ((uint32_t)data[3] << 24);
+   }
+
+   return 0;
+}
+
+static int32_t hidpad_generic_item_signed(const uint8_t *data, unsigned size)
+{
+   switch (size)
+   {
+      case 1:
+         return (int8_t)data[0];
+      case 2:
+         return (int16_t)(data[0] | (data[1] << 8));
+      case 4:
+         return (int32_t)hidpad_generic_item_data(data, size);
+   }
+
+   return 0;
+}
+
+static void hidpad_generic_add_field(struct hidpad_generic_data *device,
+      const struct hidpad_generic_globals *globals,
+      uint32_t usage, unsigned bit_offset)
+{
+   struct hidpad_generic_field *field = NULL;
+   uint16_t page = usage >> 16;
+   uint16_t id   = usage & 0xffff;
+
+   if (device->num_fields >= HIDPAD_GENERIC_MAX_FIELDS
+         || globals->report_size > 32)
+      return;
+
+   field = &device->fields[device->num_fields];
+
+   if (page == 0x09 && id >= 1)
+   {
+      if (device->num_buttons >= HIDPAD_GENERIC_MAX_BUTTONS)
+         return;
+      field->type  = HIDPAD_GENERIC_BUTTON;
+      field->index = device->num_buttons++;
+   }
+   else if (page == 0x01 && id >= 0x30 && id <= 0x35)
+   {
+      field->type  = HIDPAD_GENERIC_AXIS;
+      field->index = id - 0x30;
+   }
+   else if (page == 0x01 && id == 0x39)
+   {
+      field->type  = HIDPAD_GENERIC_HAT;
+      field->index = 0;
+   }
+   else
+      return;
+
+   field->report_id   = globals->report_id;
+   field->bit_offset  = bit_offset;
+   field->bit_size    = globals->report_size;
+   field->logical_min = globals->logical_min;
+   field->logical_max = globals->logical_max;
+   device->num_fields++;
+}
+
+/**
+ * hidpad_generic_parse:
+ * @device               : device to fill in fields of.
+ * @desc                 : HID report descriptor.
+ * @size                 : size of @desc in bytes.
+ *
+ * Collects the buttons, axes and hat switch inputs of the
+ * joystick or gamepad application collections in @desc.
+ *
+ * Returns: true (1) if @desc describes a joystick or gamepad
+ * with at least one button, otherwise false (0).
+ **/
+static bool hidpad_generic_parse(struct hidpad_generic_data *device,
+      const uint8_t *desc, size_t size)
+{
+   struct hidpad_generic_globals globals = {0};
+   struct hidpad_generic_globals stack[HIDPAD_GENERIC_STACK_SIZE];
+   uint32_t usages[HIDPAD_GENERIC_MAX_USAGES];
+   uint16_t offsets[256] = {0};
+   unsigned num_usages    = 0;
+   unsigned stack_ptr     = 0;
+   uint32_t usage_min     = 0;
+   uint32_t usage_max     = 0;
+   bool has_usage_range   = false;
+   unsigned depth         = 0;
+   unsigned pad_depth     = 0;
+   size_t i               = 0;
+
+   while (i < size)
+   {
+      uint8_t prefix    = desc[i];
+      unsigned item_size = prefix & 0x3;
+      unsigned type      = (prefix >> 2) & 0x3;
+      unsigned tag       = prefix >> 4;
+      const uint8_t *data = &desc[i + 1];
+      uint32_t value;
+
+      if (item_size == 3)
+         item_size = 4;
+
+      /* Long items carry nothing of interest here. */
+      if (prefix == 0xfe)
+      {
+         if (i + 2 >= size)
+            break;
+         i += 3 + desc[i + 1];
+         continue;
+      }
+
+      if (i + 1 + item_size > size)
+         break;
+      i += 1 + item_size;
+
+      value = hidpad_generic_item_data(data, item_size);
+
+      switch (type)
+      {
+         case 0: /* Main */
+            switch (tag)
+            {
+               case 0x8: /* Input */
+               {
+                  unsigned j;
+                  uint16_t *offset = &offsets[globals.report_id];
+                  bool constant    = value & 0x1;
+
+                  for (j = 0; j < globals.report_count; j++)
+                  {
+                     uint32_t usage = 0;
+
+                     if (has_usage_range)
+                        usage = usage_min + j;
+                     else if (num_usages)
+                        usage = usages[j < num_usages ? j : num_usages - 1];
+
+                     if (!constant && pad_depth && usage
+                           && (!has_usage_range || usage <= usage_max))
+                        hidpad_generic_add_field(device, &globals,
+                              usage, *offset);
+
+                     *offset += globals.report_size;
+                  }
+                  break;
+               }
+               case 0xa: /* Collection */
+                  depth++;
+                  /* Application collection of a joystick, gamepad
+                   * or multi-axis controller. */
+                  if (!pad_depth && value == 0x01 && num_usages
+                        && (usages[0] == 0x10004 || usages[0] == 0x10005
+                           || usages[0] == 0x10008))
+                     pad_depth = depth;
+                  break;
+               case 0xc: /* End Collection */
+                  if (depth == pad_depth)
+                     pad_depth = 0;
+                  if (depth)
+                     depth--;
+                  break;
+            }
+
+            num_usages      = 0;
+            has_usage_range = false;
+            break;
+
+         case 1: /* Global */
+            switch (tag)
+            {
+               case 0x0:
+                  globals.usage_page   = value;
+                  break;
+               case 0x1:
+                  globals.logical_min  = hidpad_generic_item_signed(data, item_size);
+                  break;
+               case 0x2:
+                  globals.logical_max  = hidpad_generic_item_signed(data, item_size);
+                  break;
+               case 0x7:
+                  globals.report_size  = value;
+                  break;
+               case 0x8:
+                  globals.report_id    = value;
+                  device->has_report_id = true;
+                  break;
+               case 0x9:
+                  globals.report_count = value;
+                  break;
+               case 0xa: /* Push */
+                  if (stack_ptr < HIDPAD_GENERIC_STACK_SIZE)
+                     stack[stack_ptr++] = globals;
+                  break;
+               case 0xb: /* Pop */
+                  if (stack_ptr)
+                     globals = stack[--stack_ptr];
+                  break;
+            }
+            break;
+
+         case 2: /* Local */
+            /* Usages without a page take the current usage page. */
+            if (item_size < 4)
+               value |= (uint32_t)globals.usage_page << 16;
+
+            switch (tag)
+            {
+               case 0x0:
+                  if (num_usages < HIDPAD_GENERIC_MAX_USAGES)
+                     usages[num_usages++] = value;
+                  break;
+               case 0x1:
+                  usage_min       = value;
+                  has_usage_range = true;
+                  break;
+               case 0x2:
+                  usage_max       = value;
+                  has_usage_range = true;
+                  break;
+            }
+            break;
+      }
+   }
+
+   /* Only the first byte of a report holds its ID. */
+   if (device->has_report_id)
+      for (i = 0; i < device->num_fields; i++)
+         device->fields[i].bit_offset += 8;
+
+   return device->num_buttons > 0;
+}
+
+static bool hidpad_generic_get_field(const struct hidpad_generic_field *field,
+      const uint8_t *report, size_t size, int32_t *out)
+{
+   unsigned i;
+   uint32_t value = 0;
+
+   /* Short reports leave the field as it was. */
+   if (((size_t)field->bit_offset + field->bit_size + 7) / 8 > size)
+      return false;
+
+   for (i = 0; i < field->bit_size; i++)
+   {
+      unsigned bit = field->bit_offset + i;
+      if (report[bit >> 3] & (1 << (bit & 7)))
+         value |= 1u << i;
+   }
+
+   /* Sign extend fields which can be negative. */
+   if (field->logical_min < 0 && field->bit_size < 32
+         && (value & (1u << (field->bit_size - 1))))
+      value |= ~0u << field->bit_size;
+
+   *out = (int32_t)value;
+   return true;
+}
+
+static int16_t hidpad_generic_scale_axis(const struct hidpad_generic_field *field,
+      int32_t value)
+{
+   int64_t range = (int64_t)field->logical_max - field->logical_min;
+   int64_t axis;
+
+   if (range <= 0)
+      return 0;
+
+   axis = ((int64_t)value - field->logical_min) * 0xfffe / range - 0x7fff;
+
+   if (axis > 0x7fff)
+      return 0x7fff;
+   if (axis < -0x7fff)
+      return -0x7fff;
+   return axis;
+}
+
+static void* hidpad_generic_init(void *data, uint32_t slot, send_control_t ptr)
+{
+   struct pad_connection_report_desc *desc =
+      (struct pad_connection_report_desc*)data;
+   struct hidpad_generic_data *device = NULL;
+
+   (void)slot;
+   (void)ptr;
+
+   if (!desc || !desc->data)
+      return NULL;
+
+   device = (struct hidpad_generic_data*)
+      calloc(1, sizeof(struct hidpad_generic_data));
+
+   if (!device)
+      return NULL;
+
+   if (!hidpad_generic_parse(device, desc->data, desc->size))
+   {
+      free(device);
+      return NULL;
+   }
+
+   return device;
+}
+
+static void hidpad_generic_deinit(void *data)
+{
+   struct hidpad_generic_data *device = (struct hidpad_generic_data*)data;
+
+   if (device)
+      free(device);
+}
+
+static void hidpad_generic_packet_handler(void *data,
+      uint8_t *packet, uint16_t size)
+{
+   unsigned i;
+   uint32_t buttons                   = 0;
+   struct hidpad_generic_data *device = (struct hidpad_generic_data*)data;
+   const uint8_t *report              = NULL;
+
+   /* First byte is reserved by the HID driver. */
+   if (!device || size < 2)
+      return;
+
+   report = &packet[1];
+   size--;
+
+   for (i = 0; i < device->num_fields; i++)
+   {
+      const struct hidpad_generic_field *field = &device->fields[i];
+      int32_t value;
+
+      if (device->has_report_id && report[0] != field->report_id)
+         continue;
+
+      if (!hidpad_generic_get_field(field, report, size, &value))
+         continue;
+
+      switch (field->type)
+      {
+         case HIDPAD_GENERIC_BUTTON:
+            if (value)
+               buttons |= 1u << field->index;
+            break;
+         case HIDPAD_GENERIC_AXIS:
+            device->axes[field->index] = hidpad_generic_scale_axis(field, value);
+            break;
+         case HIDPAD_GENERIC_HAT:
+         {
+            /* Eight directions clockwise from up,
+             * anything out of range is centered. */
+            static const uint8_t hat_dirs[8] = {
+               0x1, 0x3, 0x2, 0x6, 0x4, 0xc, 0x8, 0x9
+            };
+            int32_t dir = value - field->logical_min;
+
+            if (value >= field->logical_min && dir < 8
+                  && value <= field->logical_max)
+               buttons |= (uint32_t)hat_dirs[dir] << device->num_buttons;
+            break;
+         }
+      }
+   }
+
+   /* Keep buttons of other reports. */
+   if (device->has_report_id)
+   {
+      uint32_t mask = 0;
+
+      for (i = 0; i < device->num_fields; i++)
+      {
+         const struct hidpad_generic_field *field = &device->fields[i];
+
+         if (field->report_id != report[0])
+            continue;
+         if (field->type == HIDPAD_GENERIC_BUTTON)
+            mask |= 1u << field->index;
+         else if (field->type == HIDPAD_GENERIC_HAT)
+            mask |= 0xfu << device->num_buttons;
+      }
+
+      buttons |= device->buttons & ~mask;
+   }
+
+   device->buttons = buttons;
+}
+
+static void hidpad_generic_set_rumble(void *data,
+      enum retro_rumble_effect effect, uint16_t strength)
+{
+   (void)data;
+   (void)effect;
+   (void)strength;
+}
+
+static uint64_t hidpad_generic_get_buttons(void *data)
+{
+   struct hidpad_generic_data *device = (struct hidpad_generic_data*)data;
+
+   if (!device)
+      return 0;
+   return device->buttons;
+}
+
+static int16_t hidpad_generic_get_axis(void *data, unsigned axis)
+{
+   struct hidpad_generic_data *device = (struct hidpad_generic_data*)data;
+
+   if (!device || axis >= HIDPAD_GENERIC_MAX_AXES)
+      return 0;
+   return device->axes[axis];
+}
+
+pad_connection_interface_t pad_connection_generic = {
+   hidpad_generic_init,
+   hidpad_generic_deinit,
+   hidpad_generic_packet_handler,
+   hidpad_generic_set_rumble,
+   hidpad_generic_get_buttons,
+   hidpad_generic_get_axis,
+};
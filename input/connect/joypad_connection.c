@@ -108,6 +108,30 @@ int32_t pad_connection_pad_init(joypad_connection_t *joyconn,
    return -1;
 }
 
+int32_t pad_connection_pad_init_generic(joypad_connection_t *joyconn,
+   const uint8_t *desc, size_t desc_size)
+{
+   struct pad_connection_report_desc report_desc;
+   joypad_connection_t *s = NULL;
+   int pad                = pad_connection_find_vacant_pad(joyconn);
+
+   if (pad == -1)
+      return -1;
+
+   s                  = (joypad_connection_t*)&joyconn[pad];
+   report_desc.data   = desc;
+   report_desc.size   = desc_size;
+
+   s->data            = pad_connection_generic.init(&report_desc, pad, NULL);
+   if (!s->data)
+      return -1;
+
+   s->iface           = &pad_connection_generic;
+   s->connected       = true;
+
+   return pad;
+}
+
 void pad_connection_pad_deinit(joypad_connection_t *joyconn, uint32_t pad)
 {
    if (!joyconn || !joyconn->connected)
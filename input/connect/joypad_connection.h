@@ -34,9 +34,17 @@ typedef struct pad_connection_interface
    int16_t  (*get_axis)(void *data, unsigned axis);
 } pad_connection_interface_t;
 
+/* Passed as data to the init of pad_connection_generic. */
+struct pad_connection_report_desc
+{
+   const uint8_t *data;
+   size_t size;
+};
+
 extern pad_connection_interface_t pad_connection_wii;
 extern pad_connection_interface_t pad_connection_ps3;
 extern pad_connection_interface_t pad_connection_ps4;
+extern pad_connection_interface_t pad_connection_generic;
 
 typedef struct joypad_connection
 {
@@ -49,6 +57,12 @@ int32_t pad_connection_pad_init(joypad_connection_t *joyconn,
    const char* name, uint16_t vid, uint16_t pid,
    void *data, send_control_t ptr);
 
+/* Connects a pad no pad specific interface is known for,
+ * decoding its reports from its HID report descriptor @desc.
+ * Returns the slot of the pad, or -1 if @desc describes no pad. */
+int32_t pad_connection_pad_init_generic(joypad_connection_t *joyconn,
+   const uint8_t *desc, size_t desc_size);
+
 void *pad_connection_init(unsigned pads);
 
 void pad_connection_destroy(joypad_connection_t *joyconn);
@@ -70,6 +70,9 @@ struct dinput_input
    int mouse_x;
    int mouse_y;
    bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd, mouse_hwu, mouse_hwd;
+   /* Buttons pressed since the last poll, from window messages,
+    * so clicks shorter than a frame aren't lost. */
+   bool mouse_l_press, mouse_r_press, mouse_m_press;
    struct pointer_status pointer_head;  /* dummy head for easier iteration */
 };
 
@@ -204,9 +207,13 @@ static void dinput_poll(void *data)
 
       di->mouse_rel_x = mouse_state.lX;
       di->mouse_rel_y = mouse_state.lY;
-      di->mouse_l  = mouse_state.rgbButtons[0];
-      di->mouse_r  = mouse_state.rgbButtons[1];
-      di->mouse_m  = mouse_state.rgbButtons[2];
+      di->mouse_l  = mouse_state.rgbButtons[0] || di->mouse_l_press;
+      di->mouse_r  = mouse_state.rgbButtons[1] || di->mouse_r_press;
+      di->mouse_m  = mouse_state.rgbButtons[2] || di->mouse_m_press;
+
+      di->mouse_l_press = false;
+      di->mouse_r_press = false;
+      di->mouse_m_press = false;
 
       /* No simple way to get absolute coordinates 
        * for RETRO_DEVICE_POINTER. Just use Win32 APIs. */
@@ -595,6 +602,15 @@ bool dinput_handle_message(void *dinput, UINT message, WPARAM wParam, LPARAM lPa
                  di->mouse_hwd = true;
           }
           break;
+      case WM_LBUTTONDOWN:
+         di->mouse_l_press = true;
+         break;
+      case WM_RBUTTONDOWN:
+         di->mouse_r_press = true;
+         break;
+      case WM_MBUTTONDOWN:
+         di->mouse_m_press = true;
+         break;
    }
 
    return false;
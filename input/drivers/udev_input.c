@@ -97,9 +97,22 @@ struct udev_input
    struct input_device **devices;
    unsigned num_devices;
 
-   int16_t mouse_x;
-   int16_t mouse_y;
-   bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd, mouse_whu, mouse_whd;
+   /* Motion since the last poll, summed over every event so
+    * fast movements of high resolution mice can't wrap around. */
+   int32_t mouse_x;
+   int32_t mouse_y;
+   /* Buttons held, and buttons pressed since the last poll, so
+    * clicks shorter than a frame aren't lost. */
+   uint8_t mouse_buttons;
+   uint8_t mouse_presses;
+   bool mouse_wu, mouse_wd, mouse_whu, mouse_whd;
+};
+
+enum
+{
+   UDEV_MOUSE_LEFT   = 1 << 0,
+   UDEV_MOUSE_RIGHT  = 1 << 1,
+   UDEV_MOUSE_MIDDLE = 1 << 2
 };
 
 #ifdef HAVE_XKBCOMMON
@@ -149,7 +162,7 @@ static void udev_handle_touchpad(udev_input_t *udev,
                float rel_x = x_norm - dev->state.touchpad.x;
 
                if (dev->state.touchpad.touch)
-                  udev->mouse_x += (int16_t)
+                  udev->mouse_x += (int32_t)
                      roundf(dev->state.touchpad.mod_x * rel_x);
 
                dev->state.touchpad.x = x_norm;
@@ -168,7 +181,7 @@ static void udev_handle_touchpad(udev_input_t *udev,
                float rel_y = y_norm - dev->state.touchpad.y;
 
                if (dev->state.touchpad.touch)
-                  udev->mouse_y += (int16_t)roundf(dev->state.touchpad.mod_y * rel_y);
+                  udev->mouse_y += (int32_t)roundf(dev->state.touchpad.mod_y * rel_y);
 
                dev->state.touchpad.y = y_norm;
 
@@ -197,6 +210,18 @@ static void udev_handle_touchpad(udev_input_t *udev,
    }
 }
 
+static void udev_handle_mouse_button(udev_input_t *udev,
+      uint8_t button, int value)
+{
+   if (value)
+   {
+      udev->mouse_buttons |= button;
+      udev->mouse_presses |= button;
+   }
+   else
+      udev->mouse_buttons &= ~button;
+}
+
 static void udev_handle_mouse(udev_input_t *udev,
       const struct input_event *event, struct input_device *dev)
 {
@@ -207,15 +232,15 @@ static void udev_handle_mouse(udev_input_t *udev,
          switch (event->code)
          {
             case BTN_LEFT:
-               udev->mouse_l = event->value;
+               udev_handle_mouse_button(udev, UDEV_MOUSE_LEFT, event->value);
                break;
 
             case BTN_RIGHT:
-               udev->mouse_r = event->value;
+               udev_handle_mouse_button(udev, UDEV_MOUSE_RIGHT, event->value);
                break;
 
             case BTN_MIDDLE:
-               udev->mouse_m = event->value;
+               udev_handle_mouse_button(udev, UDEV_MOUSE_MIDDLE, event->value);
                break;
             default:
                break;
@@ -414,6 +439,7 @@ static void udev_input_poll(void *data)
    udev_input_t *udev = (udev_input_t*)data;
 
    udev->mouse_x = udev->mouse_y = 0;
+   udev->mouse_presses = 0;
    udev->mouse_wu = udev->mouse_wd = 0;
    udev->mouse_whu = udev->mouse_whd = 0;
 
@@ -443,20 +469,36 @@ static void udev_input_poll(void *data)
       udev->joypad->poll();
 }
 
+static int16_t udev_mouse_delta(int32_t delta)
+{
+   if (delta > INT16_MAX)
+      return INT16_MAX;
+   if (delta < INT16_MIN)
+      return INT16_MIN;
+   return delta;
+}
+
+/* A button pressed since the last poll reads as pressed
+ * for that poll even if it has already been released. */
+static bool udev_mouse_button(udev_input_t *udev, uint8_t button)
+{
+   return ((udev->mouse_buttons | udev->mouse_presses) & button) != 0;
+}
+
 static int16_t udev_mouse_state(udev_input_t *udev, unsigned id)
 {
    switch (id)
    {
       case RETRO_DEVICE_ID_MOUSE_X:
-         return udev->mouse_x;
+         return udev_mouse_delta(udev->mouse_x);
       case RETRO_DEVICE_ID_MOUSE_Y:
-         return udev->mouse_y;
+         return udev_mouse_delta(udev->mouse_y);
       case RETRO_DEVICE_ID_MOUSE_LEFT:
-         return udev->mouse_l;
+         return udev_mouse_button(udev, UDEV_MOUSE_LEFT);
       case RETRO_DEVICE_ID_MOUSE_RIGHT:
-         return udev->mouse_r;
+         return udev_mouse_button(udev, UDEV_MOUSE_RIGHT);
       case RETRO_DEVICE_ID_MOUSE_MIDDLE:
-         return udev->mouse_m;
+         return udev_mouse_button(udev, UDEV_MOUSE_MIDDLE);
       case RETRO_DEVICE_ID_MOUSE_WHEELUP:
          return udev->mouse_wu;
       case RETRO_DEVICE_ID_MOUSE_WHEELDOWN:
@@ -472,22 +514,26 @@ static int16_t udev_mouse_state(udev_input_t *udev, unsigned id)
 
 static int16_t udev_lightgun_state(udev_input_t *udev, unsigned id)
 {
+   bool l = udev_mouse_button(udev, UDEV_MOUSE_LEFT);
+   bool r = udev_mouse_button(udev, UDEV_MOUSE_RIGHT);
+   bool m = udev_mouse_button(udev, UDEV_MOUSE_MIDDLE);
+
    switch (id)
    {
       case RETRO_DEVICE_ID_LIGHTGUN_X:
-         return udev->mouse_x;
+         return udev_mouse_delta(udev->mouse_x);
       case RETRO_DEVICE_ID_LIGHTGUN_Y:
-         return udev->mouse_y;
+         return udev_mouse_delta(udev->mouse_y);
       case RETRO_DEVICE_ID_LIGHTGUN_TRIGGER:
-         return udev->mouse_l;
+         return l;
       case RETRO_DEVICE_ID_LIGHTGUN_CURSOR:
-         return udev->mouse_m;
+         return m;
       case RETRO_DEVICE_ID_LIGHTGUN_TURBO:
-         return udev->mouse_r;
+         return r;
       case RETRO_DEVICE_ID_LIGHTGUN_START:
-         return udev->mouse_m && udev->mouse_r; 
+         return m && r; 
       case RETRO_DEVICE_ID_LIGHTGUN_PAUSE:
-         return udev->mouse_m && udev->mouse_l; 
+         return m && l; 
    }
 
    return 0;
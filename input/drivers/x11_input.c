@@ -39,6 +39,9 @@ typedef struct x11_input
 
    char state[32];
    bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd;
+   /* Buttons pressed since the last poll, from ButtonPress events,
+    * so clicks shorter than a frame aren't lost. */
+   bool mouse_l_press, mouse_r_press, mouse_m_press;
    int mouse_x, mouse_y;
    int mouse_last_x, mouse_last_y;
 
@@ -287,9 +290,13 @@ static void x_input_poll_mouse(x11_input_t *x11)
 
    x11->mouse_x  = win_x;
    x11->mouse_y  = win_y;
-   x11->mouse_l  = mask & Button1Mask; 
-   x11->mouse_m  = mask & Button2Mask; 
-   x11->mouse_r  = mask & Button3Mask; 
+   x11->mouse_l  = (mask & Button1Mask) || x11->mouse_l_press; 
+   x11->mouse_m  = (mask & Button2Mask) || x11->mouse_m_press; 
+   x11->mouse_r  = (mask & Button3Mask) || x11->mouse_r_press; 
+
+   x11->mouse_l_press = false;
+   x11->mouse_m_press = false;
+   x11->mouse_r_press = false;
 
    /* Somewhat hacky, but seem to do the job. */
    if (x11->grab_mouse && video_driver_focus())
@@ -322,6 +329,15 @@ void x_input_poll_wheel(void *data, XButtonEvent *event, bool latch)
 
    switch (event->button)
    {
+      case 1:
+         x11->mouse_l_press = true;
+         break;
+      case 2:
+         x11->mouse_m_press = true;
+         break;
+      case 3:
+         x11->mouse_r_press = true;
+         break;
       case 4:
          x11->mouse_wu = 1;
          break;
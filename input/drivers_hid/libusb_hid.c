@@ -38,6 +38,7 @@ struct libusb_adapter
    struct libusb_device *device;
    libusb_device_handle *handle;
    int interface_number;
+   int interface_class;
    int endpoint_in;
    int endpoint_out;
    int endpoint_in_max_size;
@@ -147,6 +148,7 @@ static void libusb_get_description(struct libusb_device *device,
          //if (interdesc->bInterfaceClass == LIBUSB_CLASS_HID)
          {
             adapter->interface_number = (int)interdesc->bInterfaceNumber;
+            adapter->interface_class  = (int)interdesc->bInterfaceClass;
 
             for(k = 0; k < (int)interdesc->bNumEndpoints; k++)
             {
@@ -177,6 +179,37 @@ static void libusb_get_description(struct libusb_device *device,
    libusb_free_config_descriptor(config);
 }
 
+/**
+ * libusb_hid_pad_init_generic:
+ * @hid                  : HID handle.
+ * @adapter              : adapter of a pad without its own interface.
+ *
+ * Connects @adapter as a generic pad, decoded by the
+ * report descriptor of its HID interface.
+ *
+ * Returns: slot of the pad, or -1 if it isn't one.
+ **/
+static int32_t libusb_hid_pad_init_generic(libusb_hid_t *hid,
+      struct libusb_adapter *adapter)
+{
+   uint8_t desc[4096];
+   int size;
+
+   if (adapter->interface_class != LIBUSB_CLASS_HID)
+      return -1;
+
+   size = libusb_control_transfer(adapter->handle,
+         LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_STANDARD
+         | LIBUSB_RECIPIENT_INTERFACE,
+         LIBUSB_REQUEST_GET_DESCRIPTOR, LIBUSB_DT_REPORT << 8,
+         adapter->interface_number, desc, sizeof(desc), 1000);
+
+   if (size <= 0)
+      return -1;
+
+   return pad_connection_pad_init_generic(hid->slots, desc, size);
+}
+
 static int add_adapter(void *data, struct libusb_device *dev)
 {
    int rc;
@@ -253,6 +286,9 @@ static int add_adapter(void *data, struct libusb_device *dev)
    adapter->slot = pad_connection_pad_init(hid->slots,
          device_name, desc.idVendor, desc.idProduct, adapter, &libusb_hid_device_send_control);
 
+   if (!pad_connection_has_interface(hid->slots, adapter->slot))
+      adapter->slot = libusb_hid_pad_init_generic(hid, adapter);
+
    if (!pad_connection_has_interface(hid->slots, adapter->slot))
    {
       fprintf(stderr, " Interface not found (%s).\n", adapter->name);
@@ -428,14 +464,14 @@ static int16_t libusb_hid_joypad_axis(void *data, unsigned port, uint32_t joyaxi
    if (joyaxis == AXIS_NONE)
       return 0;
 
-   if (AXIS_NEG_GET(joyaxis) < 4)
+   if (AXIS_NEG_GET(joyaxis) < 6)
    {
       val = pad_connection_get_axis(&hid->slots[port], port, AXIS_NEG_GET(joyaxis));
 
       if (val >= 0)
          val = 0;
    }
-   else if(AXIS_POS_GET(joyaxis) < 4)
+   else if(AXIS_POS_GET(joyaxis) < 6)
    {
       val = pad_connection_get_axis(&hid->slots[port], port, AXIS_POS_GET(joyaxis));
 
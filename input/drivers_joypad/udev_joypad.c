@@ -23,6 +23,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/poll.h>
+#include <sys/epoll.h>
 #include <fcntl.h>
 #include <libudev.h>
 #include <linux/types.h>
@@ -30,6 +31,11 @@
 
 #include <retro_inline.h>
 
+#if defined(HAVE_THREADS) && !defined(IS_JOYCONFIG)
+#include <rthreads/rthreads.h>
+#define HAVE_UDEV_JOYPAD_THREAD
+#endif
+
 /* Udev/evdev Linux joypad driver.
  * More complex and extremely low level,
  * but only Linux driver which can support joypad rumble.
@@ -37,21 +43,45 @@
  * Uses udev for device detection + hotplug.
  *
  * Code adapted from SDL 2.0's implementation.
+ *
+ * With threads, pads are read by a thread blocking on their
+ * fds, so events are applied as soon as they arrive rather than
+ * on the next poll. Each pad publishes its state through a
+ * seqlock, polling just copies out the latest one.
  */
 
 #define UDEV_NUM_BUTTONS 32
 #define NUM_AXES 32
 #define NUM_HATS 4
 
+struct udev_joypad_state
+{
+   uint64_t buttons;
+   int16_t axes[NUM_AXES];
+   int8_t hats[NUM_HATS][2];
+
+   /* Timestamp of the newest event applied, in microseconds
+    * of CLOCK_MONOTONIC where the kernel supports it. */
+   retro_time_t time;
+};
+
 struct udev_joypad
 {
    int fd;
    dev_t device;
 
    /* Input state polled. */
-   uint64_t buttons;
-   int16_t axes[NUM_AXES];
-   int8_t hats[NUM_HATS][2];
+   struct udev_joypad_state state;
+
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   /* State the pad thread applies events to. */
+   struct udev_joypad_state thread_state;
+
+   /* Last state published by the pad thread,
+    * seq is odd while it is being written. */
+   struct udev_joypad_state shared;
+   volatile unsigned seq;
+#endif
 
    /* Maps keycodes -> button/axes */
    uint8_t button_bind[KEY_MAX];
@@ -74,6 +104,16 @@ static struct udev *g_udev;
 static struct udev_monitor *g_udev_mon;
 static struct udev_joypad udev_pads[MAX_USERS];
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+static sthread_t *g_pad_thread;
+/* Held by the pad thread while it reads pads, and by
+ * hotplug while it adds or removes them. */
+static slock_t *g_pad_lock;
+static int g_pad_epfd = -1;
+static int g_pad_wake[2] = {-1, -1};
+static volatile bool g_pad_thread_quit;
+#endif
+
 static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int value)
 {
    int range = info->maximum - info->minimum;
@@ -86,7 +126,8 @@ static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int va
    return axis;
 }
 
-static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
+static void udev_poll_pad(struct udev_joypad *pad,
+      struct udev_joypad_state *state)
 {
    int i, len;
    struct input_event events[32];
@@ -106,9 +147,9 @@ static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
                if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
                {
                   if (events[i].value)
-                     BIT64_SET(pad->buttons, pad->button_bind[code]);
+                     BIT64_SET(state->buttons, pad->button_bind[code]);
                   else
-                     BIT64_CLEAR(pad->buttons, pad->button_bind[code]);
+                     BIT64_CLEAR(state->buttons, pad->button_bind[code]);
                }
                break;
 
@@ -128,14 +169,14 @@ static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
                   case ABS_HAT3Y:
                   {
                      code                           -= ABS_HAT0X;
-                     pad->hats[code >> 1][code & 1]  = events[i].value;
+                     state->hats[code >> 1][code & 1] = events[i].value;
                      break;
                   }
 
                   default:
                   {
-                     unsigned axis   = pad->axes_bind[code];
-                     pad->axes[axis] = udev_compute_axis(&pad->absinfo[axis], events[i].value);
+                     unsigned axis     = pad->axes_bind[code];
+                     state->axes[axis] = udev_compute_axis(&pad->absinfo[axis], events[i].value);
                      break;
                   }
                }
@@ -145,9 +186,186 @@ static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
                break;
          }
       }
+
+      state->time = (retro_time_t)events[len - 1].time.tv_sec * 1000000
+         + events[len - 1].time.tv_usec;
    }
 }
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+static void udev_joypad_lock(void)
+{
+   if (g_pad_lock)
+      slock_lock(g_pad_lock);
+}
+
+static void udev_joypad_unlock(void)
+{
+   if (g_pad_lock)
+      slock_unlock(g_pad_lock);
+}
+
+/**
+ * udev_joypad_publish:
+ * @pad                  : pad the pad thread has read.
+ *
+ * Publishes the state the pad thread has built up.
+ **/
+static void udev_joypad_publish(struct udev_joypad *pad)
+{
+   pad->seq++;
+   __sync_synchronize();
+   pad->shared = pad->thread_state;
+   __sync_synchronize();
+   pad->seq++;
+}
+
+/**
+ * udev_joypad_fetch:
+ * @pad                  : pad to fetch state of.
+ *
+ * Copies the last published state of @pad into pad->state,
+ * retrying while the pad thread is writing it.
+ **/
+static void udev_joypad_fetch(struct udev_joypad *pad)
+{
+   unsigned seq;
+
+   do
+   {
+      seq = pad->seq;
+      __sync_synchronize();
+      pad->state = pad->shared;
+      __sync_synchronize();
+   } while ((seq & 1) || seq != pad->seq);
+}
+
+static void udev_joypad_thread(void *data)
+{
+   struct epoll_event events[MAX_USERS + 1];
+
+   (void)data;
+
+   for (;;)
+   {
+      int i;
+      int ret = epoll_wait(g_pad_epfd, events, ARRAY_SIZE(events), -1);
+
+      if (ret < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         RARCH_ERR("[udev]: Pad thread failed to wait (%s).\n",
+               strerror(errno));
+         break;
+      }
+
+      slock_lock(g_pad_lock);
+
+      if (g_pad_thread_quit)
+      {
+         slock_unlock(g_pad_lock);
+         break;
+      }
+
+      for (i = 0; i < ret; i++)
+      {
+         struct udev_joypad *pad = NULL;
+
+         if (events[i].data.u32 >= MAX_USERS)
+            continue;
+
+         /* Events can still be in flight for pads
+          * removed since epoll_wait() returned. */
+         pad = &udev_pads[events[i].data.u32];
+         if (pad->fd < 0)
+            continue;
+
+         udev_poll_pad(pad, &pad->thread_state);
+         udev_joypad_publish(pad);
+      }
+
+      slock_unlock(g_pad_lock);
+   }
+}
+
+static void udev_joypad_thread_stop(void)
+{
+   if (g_pad_thread)
+   {
+      slock_lock(g_pad_lock);
+      g_pad_thread_quit = true;
+      slock_unlock(g_pad_lock);
+
+      if (write(g_pad_wake[1], "", 1) < 0)
+         RARCH_ERR("[udev]: Failed to wake pad thread.\n");
+
+      sthread_join(g_pad_thread);
+      g_pad_thread = NULL;
+   }
+
+   if (g_pad_wake[0] >= 0)
+      close(g_pad_wake[0]);
+   if (g_pad_wake[1] >= 0)
+      close(g_pad_wake[1]);
+   g_pad_wake[0] = g_pad_wake[1] = -1;
+
+   if (g_pad_epfd >= 0)
+      close(g_pad_epfd);
+   g_pad_epfd = -1;
+
+   if (g_pad_lock)
+      slock_free(g_pad_lock);
+   g_pad_lock = NULL;
+}
+
+/**
+ * udev_joypad_thread_start:
+ *
+ * Starts the pad thread. Pads are polled from udev_joypad_poll()
+ * instead if it can't be started.
+ **/
+static void udev_joypad_thread_start(void)
+{
+   unsigned i;
+   struct epoll_event event = {0};
+
+   g_pad_thread_quit = false;
+
+   g_pad_lock = slock_new();
+   g_pad_epfd = epoll_create(MAX_USERS + 1);
+
+   if (!g_pad_lock || g_pad_epfd < 0 || pipe(g_pad_wake) < 0)
+      goto error;
+
+   event.events   = EPOLLIN;
+   event.data.u32 = MAX_USERS;
+   if (epoll_ctl(g_pad_epfd, EPOLL_CTL_ADD, g_pad_wake[0], &event) < 0)
+      goto error;
+
+   for (i = 0; i < MAX_USERS; i++)
+   {
+      if (udev_pads[i].fd < 0)
+         continue;
+
+      event.data.u32 = i;
+      if (epoll_ctl(g_pad_epfd, EPOLL_CTL_ADD, udev_pads[i].fd, &event) < 0)
+         goto error;
+   }
+
+   g_pad_thread = sthread_create(udev_joypad_thread, NULL);
+   if (!g_pad_thread)
+      goto error;
+
+   RARCH_LOG("[udev]: Reading pads on a thread.\n");
+   return;
+
+error:
+   RARCH_WARN("[udev]: Failed to start pad thread, polling pads instead.\n");
+   udev_joypad_thread_stop();
+}
+#endif
+
 static bool udev_hotplug_available(void)
 {
    struct pollfd fds = {0};
@@ -268,8 +486,18 @@ static void udev_joypad_poll(void)
    while (udev_hotplug_available())
       udev_joypad_handle_hotplug();
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   if (g_pad_thread)
+   {
+      for (i = 0; i < MAX_USERS; i++)
+         if (udev_pads[i].fd >= 0)
+            udev_joypad_fetch(&udev_pads[i]);
+      return;
+   }
+#endif
+
    for (i = 0; i < MAX_USERS; i++)
-      udev_poll_pad(&udev_pads[i], i);
+      udev_poll_pad(&udev_pads[i], &udev_pads[i].state);
 }
 
 #define test_bit(nr, addr) \
@@ -283,9 +511,15 @@ static int udev_open_joystick(const char *path)
    unsigned long absbit[NBITS(ABS_MAX)] = {0};
    int fd = open(path, O_RDWR | O_NONBLOCK);
 
+   int clock = CLOCK_MONOTONIC;
+
    if (fd < 0)
       return fd;
 
+   /* Timestamp events on the same clock as rarch_get_time_usec(),
+    * older kernels keep wall clock time. */
+   ioctl(fd, EVIOCSCLOCKID, &clock);
+
    if ((ioctl(fd, EVIOCGBIT(0, sizeof(evbit)), evbit) < 0) ||
          (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybit)), keybit) < 0) ||
          (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) < 0))
@@ -317,6 +551,12 @@ static void udev_free_pad(unsigned pad, bool hotplug)
    settings_t *settings = config_get_ptr();
    autoconfig_params_t params = {{0}};
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_lock();
+   if (udev_pads[pad].fd >= 0 && g_pad_epfd >= 0)
+      epoll_ctl(g_pad_epfd, EPOLL_CTL_DEL, udev_pads[pad].fd, NULL);
+#endif
+
    if (udev_pads[pad].fd >= 0)
       close(udev_pads[pad].fd);
 
@@ -328,6 +568,10 @@ static void udev_free_pad(unsigned pad, bool hotplug)
    udev_pads[pad].fd    = -1;
    udev_pads[pad].ident = settings->input.device_names[pad];
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_unlock();
+#endif
+
    /* Avoid autoconfig spam if we're reiniting driver. */
    /* TODO - implement VID/PID? */
    if (hotplug)
@@ -405,7 +649,7 @@ static bool udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
             continue;
          if (abs->maximum > abs->minimum)
          {
-            pad->axes[axes]   = udev_compute_axis(abs, abs->value);
+            pad->state.axes[axes] = udev_compute_axis(abs, abs->value);
             pad->axes_bind[i] = axes++;
          }
       }
@@ -415,6 +659,22 @@ static bool udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
    pad->fd = fd;
    pad->path = strdup(path);
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   pad->thread_state = pad->state;
+   pad->shared       = pad->state;
+
+   if (g_pad_epfd >= 0)
+   {
+      struct epoll_event event = {0};
+
+      event.events   = EPOLLIN;
+      event.data.u32 = p;
+      if (epoll_ctl(g_pad_epfd, EPOLL_CTL_ADD, fd, &event) < 0)
+         RARCH_ERR("[udev]: Failed to add pad #%u to pad thread (%s).\n",
+               p, strerror(errno));
+   }
+#endif
+
    if (*pad->ident)
    {
       params.idx = p;
@@ -441,6 +701,7 @@ static bool udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
 
 static void udev_check_device(struct udev_device *dev, const char *path, bool hotplugged)
 {
+   bool ret;
    int pad, fd;
    unsigned i;
    struct stat st;
@@ -465,7 +726,15 @@ static void udev_check_device(struct udev_device *dev, const char *path, bool ho
    if (fd < 0)
       return;
 
-   if (udev_add_pad(dev, pad, fd, path))
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_lock();
+#endif
+   ret = udev_add_pad(dev, pad, fd, path);
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_unlock();
+#endif
+
+   if (ret)
    {
 #ifndef IS_JOYCONFIG
       if (hotplugged)
@@ -510,6 +779,10 @@ static void udev_joypad_destroy(void)
 {
    unsigned i;
 
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_thread_stop();
+#endif
+
    for (i = 0; i < MAX_USERS; i++)
       udev_free_pad(i, false);
 
@@ -566,6 +839,10 @@ static bool udev_joypad_init(void)
    }
 
    udev_enumerate_unref(enumerate);
+
+#ifdef HAVE_UDEV_JOYPAD_THREAD
+   udev_joypad_thread_start();
+#endif
    return true;
 
 error:
@@ -585,13 +862,13 @@ static bool udev_joypad_hat(const struct udev_joypad *pad, uint16_t hat)
    switch (GET_HAT_DIR(hat))
    {
       case HAT_LEFT_MASK:
-         return pad->hats[h][0] < 0;
+         return pad->state.hats[h][0] < 0;
       case HAT_RIGHT_MASK:
-         return pad->hats[h][0] > 0;
+         return pad->state.hats[h][0] > 0;
       case HAT_UP_MASK:
-         return pad->hats[h][1] < 0;
+         return pad->state.hats[h][1] < 0;
       case HAT_DOWN_MASK:
-         return pad->hats[h][1] > 0;
+         return pad->state.hats[h][1] > 0;
    }
 
    return 0;
@@ -603,7 +880,7 @@ static bool udev_joypad_button(unsigned port, uint16_t joykey)
 
    if (GET_HAT_DIR(joykey))
       return udev_joypad_hat(pad, joykey);
-   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->buttons, joykey);
+   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->state.buttons, joykey);
 }
 
 static uint64_t udev_joypad_get_buttons(unsigned port)
@@ -611,7 +888,7 @@ static uint64_t udev_joypad_get_buttons(unsigned port)
    const struct udev_joypad *pad = (const struct udev_joypad*)&udev_pads[port];
    if (!pad)
       return 0;
-   return pad->buttons;
+   return pad->state.buttons;
 }
 
 static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
@@ -625,13 +902,13 @@ static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
 
    if (AXIS_NEG_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_NEG_GET(joyaxis)];
+      val = pad->state.axes[AXIS_NEG_GET(joyaxis)];
       if (val > 0)
          val = 0;
    }
    else if (AXIS_POS_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_POS_GET(joyaxis)];
+      val = pad->state.axes[AXIS_POS_GET(joyaxis)];
       if (val < 0)
          val = 0;
    }
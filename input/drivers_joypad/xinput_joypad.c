@@ -34,6 +34,12 @@
 
 #include <retro_inline.h>
 
+#if defined(HAVE_THREADS) && !defined(IS_JOYCONFIG)
+#include <rthreads/rthreads.h>
+#include "../../performance.h"
+#define HAVE_XINPUT_JOYPAD_THREAD
+#endif
+
 /* Check if the definitions do not already exist.
  * Official and mingw xinput headers have different include guards.
  */
@@ -118,12 +124,51 @@ typedef struct
 {
    XINPUT_STATE xstate;
    bool         connected;
+   /* When xstate last changed, in microseconds
+    * of rarch_get_time_usec(). */
+   retro_time_t time;
 } xinput_joypad_state;
 
 static XINPUT_VIBRATION g_xinput_rumble_states[4];
 
 static xinput_joypad_state g_xinput_states[4];
 
+#ifdef HAVE_XINPUT_JOYPAD_THREAD
+/* With threads, pads are sampled at about 1 kHz by a thread
+ * rather than once per frame by xinput_joypad_poll(). Buttons
+ * pressed at any point between two polls show up as pressed,
+ * so presses shorter than a frame are not lost. Each pad
+ * publishes its state through a seqlock, as udev pads do. */
+
+#define XINPUT_THREAD_INTERVAL_MS 1
+
+typedef struct
+{
+   /* State the pad thread samples into. */
+   xinput_joypad_state thread_state;
+   /* Buttons down at some point since the last fetched state. */
+   uint16_t latched;
+
+   /* Last state published by the pad thread,
+    * seq is odd while it is being written. */
+   xinput_joypad_state shared;
+   volatile unsigned seq;
+   /* seq of the state xinput_joypad_poll() last fetched. */
+   volatile unsigned fetched;
+} xinput_joypad_thread_state;
+
+static xinput_joypad_thread_state g_xinput_thread_states[4];
+static sthread_t *g_xinput_thread;
+static volatile bool g_xinput_thread_quit;
+
+/* timeBeginPeriod() from winmm.dll, so sleeps last about
+ * a millisecond instead of a whole scheduler tick. */
+typedef UINT (WINAPI *timePeriod_t)(UINT);
+static dylib_t g_winmm_dll;
+static timePeriod_t g_timeBeginPeriod;
+static timePeriod_t g_timeEndPeriod;
+#endif
+
 static INLINE int pad_index_to_xuser_index(unsigned pad)
 {
    return g_xinput_pad_indexes[pad];
@@ -150,6 +195,164 @@ const char *xinput_joypad_name(unsigned pad)
    return XBOX_CONTROLLER_NAMES[xuser];
 }
 
+#ifdef HAVE_XINPUT_JOYPAD_THREAD
+/**
+ * xinput_joypad_publish:
+ * @pad                  : pad the pad thread has sampled.
+ *
+ * Publishes the state the pad thread has built up.
+ **/
+static void xinput_joypad_publish(xinput_joypad_thread_state *pad)
+{
+   pad->seq++;
+   MemoryBarrier();
+   pad->shared = pad->thread_state;
+   MemoryBarrier();
+   pad->seq++;
+}
+
+/**
+ * xinput_joypad_fetch:
+ * @xuser                : XInput user to fetch state of.
+ *
+ * Copies the last published state of @xuser into
+ * g_xinput_states, retrying while the pad thread is
+ * writing it.
+ **/
+static void xinput_joypad_fetch(unsigned xuser)
+{
+   unsigned seq;
+   xinput_joypad_thread_state *pad = &g_xinput_thread_states[xuser];
+
+   do
+   {
+      seq = pad->seq;
+      MemoryBarrier();
+      g_xinput_states[xuser] = pad->shared;
+      MemoryBarrier();
+   } while ((seq & 1) || seq != pad->seq);
+
+   pad->fetched = seq;
+}
+
+static void xinput_joypad_sample(unsigned xuser)
+{
+   XINPUT_STATE xstate;
+   bool changed                    = false;
+   xinput_joypad_thread_state *pad = &g_xinput_thread_states[xuser];
+
+   if (!pad->thread_state.connected)
+      return;
+
+   if (g_XInputGetStateEx(xuser, &xstate) == ERROR_DEVICE_NOT_CONNECTED)
+   {
+      pad->thread_state.connected = false;
+      xinput_joypad_publish(pad);
+      return;
+   }
+
+   /* Everything latched so far has been seen, start over
+    * from the buttons down now. */
+   if (pad->fetched == pad->seq)
+   {
+      changed      = pad->latched != xstate.Gamepad.wButtons;
+      pad->latched = 0;
+   }
+
+   pad->latched |= xstate.Gamepad.wButtons;
+
+   if (xstate.dwPacketNumber != pad->thread_state.xstate.dwPacketNumber)
+   {
+      pad->thread_state.time = rarch_get_time_usec();
+      changed                = true;
+   }
+
+   if (!changed)
+      return;
+
+   pad->thread_state.xstate                  = xstate;
+   pad->thread_state.xstate.Gamepad.wButtons = pad->latched;
+   xinput_joypad_publish(pad);
+}
+
+static void xinput_joypad_thread(void *data)
+{
+   (void)data;
+
+   if (g_timeBeginPeriod)
+      g_timeBeginPeriod(XINPUT_THREAD_INTERVAL_MS);
+
+   while (!g_xinput_thread_quit)
+   {
+      unsigned i;
+
+      for (i = 0; i < 4; i++)
+         xinput_joypad_sample(i);
+
+      rarch_sleep(XINPUT_THREAD_INTERVAL_MS);
+   }
+
+   if (g_timeEndPeriod)
+      g_timeEndPeriod(XINPUT_THREAD_INTERVAL_MS);
+}
+
+static void xinput_joypad_thread_stop(void)
+{
+   if (g_xinput_thread)
+   {
+      g_xinput_thread_quit = true;
+      sthread_join(g_xinput_thread);
+      g_xinput_thread = NULL;
+   }
+
+   if (g_winmm_dll)
+      dylib_close(g_winmm_dll);
+   g_winmm_dll       = NULL;
+   g_timeBeginPeriod = NULL;
+   g_timeEndPeriod   = NULL;
+}
+
+/**
+ * xinput_joypad_thread_start:
+ *
+ * Starts the pad thread. Pads are polled from xinput_joypad_poll()
+ * instead if it can't be started.
+ **/
+static void xinput_joypad_thread_start(void)
+{
+   unsigned i;
+
+   for (i = 0; i < 4; i++)
+   {
+      memset(&g_xinput_thread_states[i], 0,
+            sizeof(g_xinput_thread_states[i]));
+      g_xinput_thread_states[i].thread_state = g_xinput_states[i];
+      g_xinput_thread_states[i].shared       = g_xinput_states[i];
+   }
+
+   g_winmm_dll = dylib_load("winmm.dll");
+   if (g_winmm_dll)
+   {
+      g_timeBeginPeriod = (timePeriod_t)dylib_proc(g_winmm_dll, "timeBeginPeriod");
+      g_timeEndPeriod   = (timePeriod_t)dylib_proc(g_winmm_dll, "timeEndPeriod");
+      if (!g_timeBeginPeriod || !g_timeEndPeriod)
+         g_timeBeginPeriod = g_timeEndPeriod = NULL;
+   }
+
+   g_xinput_thread_quit = false;
+   g_xinput_thread      = sthread_create(xinput_joypad_thread, NULL);
+
+   if (!g_xinput_thread)
+   {
+      RARCH_WARN("XInput: Failed to start pad thread, polling pads instead.\n");
+      xinput_joypad_thread_stop();
+      return;
+   }
+
+   RARCH_LOG("XInput: Sampling pads on a thread.\n");
+}
+#endif
+
 static bool xinput_joypad_init(void)
 {
    unsigned i, autoconf_pad;
@@ -262,6 +465,10 @@ static bool xinput_joypad_init(void)
       }
    }
 
+#ifdef HAVE_XINPUT_JOYPAD_THREAD
+   xinput_joypad_thread_start();
+#endif
+
    return true;
 }
 
@@ -277,6 +484,10 @@ static void xinput_joypad_destroy(void)
 {
    unsigned i;
 
+#ifdef HAVE_XINPUT_JOYPAD_THREAD
+   xinput_joypad_thread_stop();
+#endif
+
    for (i = 0; i < 4; ++i)
       memset(&g_xinput_states[i], 0, sizeof(xinput_joypad_state));
 
@@ -423,6 +634,17 @@ static void xinput_joypad_poll(void)
 {
    unsigned i;
 
+#ifdef HAVE_XINPUT_JOYPAD_THREAD
+   if (g_xinput_thread)
+   {
+      for (i = 0; i < 4; ++i)
+         xinput_joypad_fetch(i);
+
+      dinput_joypad.poll();
+      return;
+   }
+#endif
+
    for (i = 0; i < 4; ++i)
    {
       if (g_xinput_states[i].connected)
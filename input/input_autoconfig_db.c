@@ -0,0 +1,712 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <file/dir_list.h>
+#include <file/file_path.h>
+#include <compat/strl.h>
+
+#include "input_autoconfig_db.h"
+#include "input_common.h"
+
+#include "../file_ops.h"
+#include "../general.h"
+
+#define AUTOCONFIG_DB_FILE    "autoconfig.db"
+#define AUTOCONFIG_DB_MAGIC   "RADB"
+#define AUTOCONFIG_DB_VERSION 1
+
+/* The database is a single blob, laid out as a header followed
+ * by the entries, their binds, both indices and the string pool.
+ * It is saved as is, so every part keeps 8 byte alignment. */
+struct autoconfig_db_header
+{
+   char magic[4];
+   uint32_t version;
+   uint64_t signature;
+   uint32_t bind_count;
+   uint32_t entry_count;
+   uint32_t vid_index_count;
+   uint32_t string_size;
+};
+
+struct autoconfig_db_entry
+{
+   int32_t vid;
+   int32_t pid;
+   uint32_t ident;
+   uint32_t ident_len;
+};
+
+struct autoconfig_db_bind
+{
+   uint64_t joykey;
+   uint32_t joyaxis;
+   uint32_t joykey_label;
+   uint32_t joyaxis_label;
+   uint32_t padding;
+};
+
+/* Keyed by vendor and product ID, or by length and hash of the
+ * device name. Sorted by key, then entry. */
+struct autoconfig_db_index
+{
+   uint64_t key;
+   uint32_t entry;
+   uint32_t padding;
+};
+
+struct autoconfig_db
+{
+   uint8_t *blob;
+   size_t size;
+
+   struct autoconfig_db_header *header;
+   struct autoconfig_db_entry *entries;
+   struct autoconfig_db_bind *binds;
+   struct autoconfig_db_index *vid_index;
+   struct autoconfig_db_index *ident_index;
+   char *strings;
+};
+
+typedef struct autoconfig_db_builder
+{
+   struct autoconfig_db_entry *entries;
+   struct autoconfig_db_bind *binds;
+   size_t entries_size;
+   size_t entries_cap;
+
+   char *strings;
+   size_t strings_size;
+   size_t strings_cap;
+
+   struct retro_keybind scratch[RARCH_BIND_LIST_END];
+} autoconfig_db_builder_t;
+
+static uint32_t autoconfig_db_hash_step(uint32_t hash, char c)
+{
+   return (hash << 5) + hash + (uint8_t)c;
+}
+
+static uint64_t autoconfig_db_vid_key(int32_t vid, int32_t pid)
+{
+   return ((uint64_t)(uint32_t)vid << 32) | (uint32_t)pid;
+}
+
+static uint64_t autoconfig_db_ident_key(uint32_t len, uint32_t hash)
+{
+   return ((uint64_t)len << 32) | hash;
+}
+
+static uint64_t autoconfig_db_signature_step(uint64_t sig,
+      const void *data, size_t size)
+{
+   size_t i;
+   const uint8_t *bytes = (const uint8_t*)data;
+
+   /* FNV-1a */
+   for (i = 0; i < size; i++)
+   {
+      sig ^= bytes[i];
+      sig *= UINT64_C(0x100000001b3);
+   }
+
+   return sig;
+}
+
+uint64_t autoconfig_db_dir_signature(const char *dir)
+{
+   size_t i;
+   uint32_t version         = AUTOCONFIG_DB_VERSION;
+   uint64_t sig             = UINT64_C(0xcbf29ce484222325);
+   struct string_list *list = dir_list_new(dir, "cfg", false);
+
+   sig = autoconfig_db_signature_step(sig, &version, sizeof(version));
+   sig = autoconfig_db_signature_step(sig, dir, strlen(dir) + 1);
+
+   if (!list)
+      return sig;
+
+   for (i = 0; i < list->size; i++)
+   {
+      struct stat buf;
+      const char *path = list->elems[i].data;
+      uint64_t size    = 0;
+      uint64_t mtime   = 0;
+
+      if (stat(path, &buf) == 0)
+      {
+         size  = buf.st_size;
+         mtime = buf.st_mtime;
+      }
+
+      sig = autoconfig_db_signature_step(sig, path, strlen(path) + 1);
+      sig = autoconfig_db_signature_step(sig, &size, sizeof(size));
+      sig = autoconfig_db_signature_step(sig, &mtime, sizeof(mtime));
+   }
+
+   string_list_free(list);
+
+   return sig;
+}
+
+static bool autoconfig_db_builder_reserve_strings(
+      autoconfig_db_builder_t *builder, size_t size)
+{
+   char *strings;
+   size_t cap = builder->strings_cap ? builder->strings_cap : 4096;
+
+   if (size <= builder->strings_cap)
+      return true;
+
+   while (cap < size)
+      cap *= 2;
+
+   strings = (char*)realloc(builder->strings, cap);
+   if (!strings)
+      return false;
+
+   builder->strings     = strings;
+   builder->strings_cap = cap;
+   return true;
+}
+
+/* Offset 0 is the empty string. */
+static bool autoconfig_db_builder_add_string(autoconfig_db_builder_t *builder,
+      const char *str, uint32_t *offset)
+{
+   size_t len = strlen(str) + 1;
+
+   *offset = 0;
+   if (len == 1)
+      return true;
+
+   if (!autoconfig_db_builder_reserve_strings(builder,
+            builder->strings_size + len))
+      return false;
+
+   *offset = builder->strings_size;
+   memcpy(builder->strings + builder->strings_size, str, len);
+   builder->strings_size += len;
+
+   return true;
+}
+
+static bool autoconfig_db_builder_add(autoconfig_db_builder_t *builder,
+      config_file_t *conf)
+{
+   unsigned i;
+   char ident[PATH_MAX_LENGTH];
+   struct autoconfig_db_entry *entry = NULL;
+   struct autoconfig_db_bind *binds  = NULL;
+
+   if (builder->entries_size == builder->entries_cap)
+   {
+      size_t cap = builder->entries_cap ? builder->entries_cap * 2 : 64;
+
+      entry = (struct autoconfig_db_entry*)realloc(builder->entries,
+            cap * sizeof(*entry));
+      if (!entry)
+         return false;
+      builder->entries = entry;
+
+      binds = (struct autoconfig_db_bind*)realloc(builder->binds,
+            cap * RARCH_BIND_LIST_END * sizeof(*binds));
+      if (!binds)
+         return false;
+      builder->binds = binds;
+
+      builder->entries_cap = cap;
+   }
+
+   entry = &builder->entries[builder->entries_size];
+   binds = &builder->binds[builder->entries_size * RARCH_BIND_LIST_END];
+
+   *ident     = '\0';
+   entry->vid = 0;
+   entry->pid = 0;
+   config_get_array(conf, "input_device", ident, sizeof(ident));
+   config_get_int  (conf, "input_vendor_id", &entry->vid);
+   config_get_int  (conf, "input_product_id", &entry->pid);
+
+   entry->ident_len = strlen(ident);
+   if (!autoconfig_db_builder_add_string(builder, ident, &entry->ident))
+      return false;
+
+   for (i = 0; i < RARCH_BIND_LIST_END; i++)
+   {
+      struct retro_keybind *bind = &builder->scratch[i];
+
+      bind->joykey           = NO_BTN;
+      bind->joyaxis          = AXIS_NONE;
+      bind->joykey_label[0]  = '\0';
+      bind->joyaxis_label[0] = '\0';
+
+      input_config_parse_joy_button(conf, "input",
+            input_config_bind_map[i].base, bind);
+      input_config_parse_joy_axis(conf, "input",
+            input_config_bind_map[i].base, bind);
+
+      binds[i].joykey  = bind->joykey;
+      binds[i].joyaxis = bind->joyaxis;
+      binds[i].padding = 0;
+
+      if (!autoconfig_db_builder_add_string(builder,
+               bind->joykey_label, &binds[i].joykey_label))
+         return false;
+      if (!autoconfig_db_builder_add_string(builder,
+               bind->joyaxis_label, &binds[i].joyaxis_label))
+         return false;
+   }
+
+   builder->entries_size++;
+
+   return true;
+}
+
+static int autoconfig_db_index_compare(const void *a, const void *b)
+{
+   const struct autoconfig_db_index *ia = (const struct autoconfig_db_index*)a;
+   const struct autoconfig_db_index *ib = (const struct autoconfig_db_index*)b;
+
+   if (ia->key != ib->key)
+      return ia->key < ib->key ? -1 : 1;
+   if (ia->entry != ib->entry)
+      return ia->entry < ib->entry ? -1 : 1;
+   return 0;
+}
+
+static size_t autoconfig_db_blob_size(const struct autoconfig_db_header *header)
+{
+   return sizeof(*header)
+      + header->entry_count * sizeof(struct autoconfig_db_entry)
+      + header->entry_count * header->bind_count
+         * sizeof(struct autoconfig_db_bind)
+      + header->vid_index_count * sizeof(struct autoconfig_db_index)
+      + header->entry_count * sizeof(struct autoconfig_db_index)
+      + header->string_size;
+}
+
+static void autoconfig_db_map(autoconfig_db_t *db)
+{
+   uint8_t *ptr = db->blob;
+
+   db->header      = (struct autoconfig_db_header*)ptr;
+   ptr            += sizeof(*db->header);
+   db->entries     = (struct autoconfig_db_entry*)ptr;
+   ptr            += db->header->entry_count * sizeof(*db->entries);
+   db->binds       = (struct autoconfig_db_bind*)ptr;
+   ptr            += db->header->entry_count * db->header->bind_count
+      * sizeof(*db->binds);
+   db->vid_index   = (struct autoconfig_db_index*)ptr;
+   ptr            += db->header->vid_index_count * sizeof(*db->vid_index);
+   db->ident_index = (struct autoconfig_db_index*)ptr;
+   ptr            += db->header->entry_count * sizeof(*db->ident_index);
+   db->strings     = (char*)ptr;
+}
+
+static autoconfig_db_t *autoconfig_db_builder_finish(
+      autoconfig_db_builder_t *builder, uint64_t signature)
+{
+   size_t i;
+   struct autoconfig_db_header header;
+   struct autoconfig_db_index *vid_index   = NULL;
+   struct autoconfig_db_index *ident_index = NULL;
+   autoconfig_db_t *db = (autoconfig_db_t*)calloc(1, sizeof(*db));
+
+   if (!db)
+      return NULL;
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, AUTOCONFIG_DB_MAGIC, sizeof(header.magic));
+   header.version     = AUTOCONFIG_DB_VERSION;
+   header.signature   = signature;
+   header.bind_count  = RARCH_BIND_LIST_END;
+   header.entry_count = builder->entries_size;
+   header.string_size = builder->strings_size;
+
+   for (i = 0; i < builder->entries_size; i++)
+   {
+      if (builder->entries[i].vid && builder->entries[i].pid)
+         header.vid_index_count++;
+   }
+
+   db->size = autoconfig_db_blob_size(&header);
+   db->blob = (uint8_t*)calloc(1, db->size);
+   if (!db->blob)
+   {
+      free(db);
+      return NULL;
+   }
+
+   memcpy(db->blob, &header, sizeof(header));
+   autoconfig_db_map(db);
+
+   memcpy(db->entries, builder->entries,
+         builder->entries_size * sizeof(*db->entries));
+   memcpy(db->binds, builder->binds,
+         builder->entries_size * RARCH_BIND_LIST_END * sizeof(*db->binds));
+   memcpy(db->strings, builder->strings, builder->strings_size);
+
+   vid_index   = db->vid_index;
+   ident_index = db->ident_index;
+
+   for (i = 0; i < builder->entries_size; i++)
+   {
+      const struct autoconfig_db_entry *entry = &db->entries[i];
+      const char *ident = db->strings + entry->ident;
+      uint32_t hash     = 5381;
+
+      if (entry->vid && entry->pid)
+      {
+         vid_index->key   = autoconfig_db_vid_key(entry->vid, entry->pid);
+         vid_index->entry = i;
+         vid_index++;
+      }
+
+      while (*ident)
+         hash = autoconfig_db_hash_step(hash, *ident++);
+
+      ident_index[i].key   = autoconfig_db_ident_key(entry->ident_len, hash);
+      ident_index[i].entry = i;
+   }
+
+   qsort(db->vid_index, header.vid_index_count,
+         sizeof(*db->vid_index), autoconfig_db_index_compare);
+   qsort(db->ident_index, header.entry_count,
+         sizeof(*db->ident_index), autoconfig_db_index_compare);
+
+   return db;
+}
+
+static bool autoconfig_db_builder_init(autoconfig_db_builder_t *builder)
+{
+   memset(builder, 0, sizeof(*builder));
+
+   /* Reserve offset 0 for the empty string. */
+   if (!autoconfig_db_builder_reserve_strings(builder, 1))
+      return false;
+
+   builder->strings[0]   = '\0';
+   builder->strings_size = 1;
+   return true;
+}
+
+static void autoconfig_db_builder_free(autoconfig_db_builder_t *builder)
+{
+   free(builder->entries);
+   free(builder->binds);
+   free(builder->strings);
+}
+
+static bool autoconfig_db_validate(const autoconfig_db_t *db)
+{
+   size_t i;
+   const struct autoconfig_db_header *header = db->header;
+   size_t bind_size  = header->entry_count * header->bind_count;
+
+   if (!header->string_size || db->strings[header->string_size - 1] != '\0')
+      return false;
+
+   for (i = 0; i < header->entry_count; i++)
+   {
+      if (db->entries[i].ident >= header->string_size)
+         return false;
+      if (db->ident_index[i].entry >= header->entry_count)
+         return false;
+   }
+
+   for (i = 0; i < header->vid_index_count; i++)
+   {
+      if (db->vid_index[i].entry >= header->entry_count)
+         return false;
+   }
+
+   for (i = 0; i < bind_size; i++)
+   {
+      if (db->binds[i].joykey_label  >= header->string_size)
+         return false;
+      if (db->binds[i].joyaxis_label >= header->string_size)
+         return false;
+   }
+
+   return true;
+}
+
+static autoconfig_db_t *autoconfig_db_load(const char *path,
+      uint64_t signature)
+{
+   struct autoconfig_db_header header;
+   void *buf           = NULL;
+   ssize_t len         = 0;
+   autoconfig_db_t *db = NULL;
+
+   if (!path_file_exists(path))
+      return NULL;
+   if (!read_file(path, &buf, &len) || len < (ssize_t)sizeof(header))
+      goto error;
+
+   memcpy(&header, buf, sizeof(header));
+
+   if (memcmp(header.magic, AUTOCONFIG_DB_MAGIC, sizeof(header.magic)) != 0
+         || header.version    != AUTOCONFIG_DB_VERSION
+         || header.signature  != signature
+         || header.bind_count != RARCH_BIND_LIST_END
+         || header.vid_index_count > header.entry_count
+         || autoconfig_db_blob_size(&header) != (size_t)len)
+      goto error;
+
+   db = (autoconfig_db_t*)calloc(1, sizeof(*db));
+   if (!db)
+      goto error;
+
+   db->blob = (uint8_t*)buf;
+   db->size = len;
+   autoconfig_db_map(db);
+
+   if (!autoconfig_db_validate(db))
+   {
+      autoconfig_db_free(db);
+      return NULL;
+   }
+
+   return db;
+
+error:
+   free(buf);
+   return NULL;
+}
+
+autoconfig_db_t *autoconfig_db_new_from_dir(const char *dir,
+      uint64_t signature)
+{
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   autoconfig_db_builder_t *builder = NULL;
+   autoconfig_db_t *db              = NULL;
+   struct string_list *list         = NULL;
+
+   fill_pathname_join(path, dir, AUTOCONFIG_DB_FILE, sizeof(path));
+
+   if ((db = autoconfig_db_load(path, signature)))
+      return db;
+
+   list = dir_list_new(dir, "cfg", false);
+   if (!list)
+      return NULL;
+
+   builder = (autoconfig_db_builder_t*)calloc(1, sizeof(*builder));
+   if (!builder || !autoconfig_db_builder_init(builder))
+      goto end;
+
+   for (i = 0; i < list->size; i++)
+   {
+      bool ret            = false;
+      config_file_t *conf = config_file_new(list->elems[i].data);
+
+      if (!conf)
+         continue;
+
+      ret = autoconfig_db_builder_add(builder, conf);
+      config_file_free(conf);
+
+      if (!ret)
+         goto end;
+   }
+
+   db = autoconfig_db_builder_finish(builder, signature);
+   if (!db)
+      goto end;
+
+   RARCH_LOG("Compiled %u autoconfig profiles from: \"%s\".\n",
+         db->header->entry_count, dir);
+
+   if (!write_file(path, db->blob, db->size))
+      RARCH_WARN("Failed to save autoconfig database: \"%s\".\n", path);
+
+end:
+   if (builder)
+      autoconfig_db_builder_free(builder);
+   free(builder);
+   string_list_free(list);
+   return db;
+}
+
+autoconfig_db_t *autoconfig_db_new_from_strings(const char * const *confs)
+{
+   size_t i;
+   autoconfig_db_t *db              = NULL;
+   autoconfig_db_builder_t *builder = (autoconfig_db_builder_t*)
+      calloc(1, sizeof(*builder));
+
+   if (!builder || !autoconfig_db_builder_init(builder))
+      goto end;
+
+   for (i = 0; confs[i]; i++)
+   {
+      bool ret            = false;
+      config_file_t *conf = config_file_new_from_string(confs[i]);
+
+      if (!conf)
+         continue;
+
+      ret = autoconfig_db_builder_add(builder, conf);
+      config_file_free(conf);
+
+      if (!ret)
+         goto end;
+   }
+
+   db = autoconfig_db_builder_finish(builder, 0);
+
+end:
+   if (builder)
+      autoconfig_db_builder_free(builder);
+   free(builder);
+   return db;
+}
+
+uint64_t autoconfig_db_signature(const autoconfig_db_t *db)
+{
+   return db ? db->header->signature : 0;
+}
+
+static const struct autoconfig_db_index *autoconfig_db_index_find(
+      const struct autoconfig_db_index *index, size_t size, uint64_t key)
+{
+   size_t lo = 0, hi = size;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (index[mid].key < key)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return (lo < size && index[lo].key == key) ? &index[lo] : NULL;
+}
+
+/* Same rules as scanning the profiles one by one. */
+static bool autoconfig_db_entry_matches(const autoconfig_db_t *db,
+      const struct autoconfig_db_entry *entry,
+      const autoconfig_params_t *params)
+{
+   char ident_idx[PATH_MAX_LENGTH];
+   const char *ident = db->strings + entry->ident;
+
+   if (     (params->vid == entry->vid)
+         && (params->pid == entry->pid)
+         && params->vid != 0
+         && params->pid != 0)
+      return true;
+
+   snprintf(ident_idx, sizeof(ident_idx), "%s_p%u", ident, params->idx);
+   if (!strcmp(ident_idx, params->name))
+      return true;
+
+   return *ident && !strncmp(params->name, ident, entry->ident_len);
+}
+
+int autoconfig_db_find(const autoconfig_db_t *db,
+      const autoconfig_params_t *params)
+{
+   size_t len;
+   uint32_t hash  = 5381;
+   int64_t best   = -1;
+   const struct autoconfig_db_header *header = NULL;
+   const struct autoconfig_db_index *end     = NULL;
+   const struct autoconfig_db_index *match   = NULL;
+
+   if (!db)
+      return -1;
+
+   header = db->header;
+
+   if (params->vid && params->pid)
+   {
+      uint64_t key = autoconfig_db_vid_key(params->vid, params->pid);
+
+      /* The first one is the earliest profile. */
+      if ((match = autoconfig_db_index_find(db->vid_index,
+                  header->vid_index_count, key)))
+         best = match->entry;
+   }
+
+   /* Every profile the device name can match has a device name
+    * that is a prefix of it, so look up the hash of each prefix. */
+   end = db->ident_index + header->entry_count;
+
+   for (len = 0; ; len++)
+   {
+      uint64_t key = autoconfig_db_ident_key(len, hash);
+
+      for (match = autoconfig_db_index_find(db->ident_index,
+               header->entry_count, key);
+            match && match < end && match->key == key; match++)
+      {
+         if (best >= 0 && match->entry >= best)
+            break;
+
+         if (autoconfig_db_entry_matches(db,
+                  &db->entries[match->entry], params))
+         {
+            best = match->entry;
+            break;
+         }
+      }
+
+      if (!params->name[len])
+         break;
+
+      hash = autoconfig_db_hash_step(hash, params->name[len]);
+   }
+
+   return (int)best;
+}
+
+void autoconfig_db_get_binds(const autoconfig_db_t *db, unsigned idx,
+      struct retro_keybind *binds)
+{
+   unsigned i;
+   const struct autoconfig_db_bind *src =
+      &db->binds[idx * db->header->bind_count];
+
+   for (i = 0; i < RARCH_BIND_LIST_END; i++)
+   {
+      binds[i].joykey  = src[i].joykey;
+      binds[i].joyaxis = src[i].joyaxis;
+      strlcpy(binds[i].joykey_label,  db->strings + src[i].joykey_label,
+            sizeof(binds[i].joykey_label));
+      strlcpy(binds[i].joyaxis_label, db->strings + src[i].joyaxis_label,
+            sizeof(binds[i].joyaxis_label));
+   }
+}
+
+void autoconfig_db_free(autoconfig_db_t *db)
+{
+   if (!db)
+      return;
+
+   free(db->blob);
+   free(db);
+}
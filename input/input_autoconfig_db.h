@@ -0,0 +1,103 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INPUT_AUTOCONFIG_DB_H
+#define _INPUT_AUTOCONFIG_DB_H
+
+#include <stdint.h>
+#include <boolean.h>
+
+#include "input_autodetect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct retro_keybind;
+
+typedef struct autoconfig_db autoconfig_db_t;
+
+/**
+ * autoconfig_db_dir_signature:
+ * @dir                      : Autoconfig directory.
+ *
+ * Hashes the names, sizes and modification times of the
+ * autoconfig profiles in @dir, to tell whether a database
+ * compiled from them is still up to date.
+ *
+ * Returns: signature of the profiles in @dir.
+ **/
+uint64_t autoconfig_db_dir_signature(const char *dir);
+
+/**
+ * autoconfig_db_new_from_dir:
+ * @dir                      : Autoconfig directory.
+ * @signature                : Signature of @dir, see
+ *                             autoconfig_db_dir_signature().
+ *
+ * Loads the database compiled from the autoconfig profiles
+ * in @dir, recompiling and saving it next to them if it is
+ * missing or out of date.
+ *
+ * Returns: database handle on success, otherwise NULL.
+ **/
+autoconfig_db_t *autoconfig_db_new_from_dir(const char *dir,
+      uint64_t signature);
+
+/**
+ * autoconfig_db_new_from_strings:
+ * @confs                    : NULL-terminated array of profiles.
+ *
+ * Compiles a database from profiles held in memory.
+ *
+ * Returns: database handle on success, otherwise NULL.
+ **/
+autoconfig_db_t *autoconfig_db_new_from_strings(const char * const *confs);
+
+uint64_t autoconfig_db_signature(const autoconfig_db_t *db);
+
+/**
+ * autoconfig_db_find:
+ * @db                       : Database handle.
+ * @params                   : Joypad to look up.
+ *
+ * Finds the profile for a joypad, by vendor and product ID
+ * or by device name. Where several profiles match, the one
+ * compiled first wins.
+ *
+ * Returns: index of the profile, or -1 if none matches.
+ **/
+int autoconfig_db_find(const autoconfig_db_t *db,
+      const autoconfig_params_t *params);
+
+/**
+ * autoconfig_db_get_binds:
+ * @db                       : Database handle.
+ * @idx                      : Index of the profile.
+ * @binds                    : Binds to fill in, RARCH_BIND_LIST_END
+ *                             of them.
+ *
+ * Copies the joypad binds of a profile.
+ **/
+void autoconfig_db_get_binds(const autoconfig_db_t *db, unsigned idx,
+      struct retro_keybind *binds);
+
+void autoconfig_db_free(autoconfig_db_t *db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
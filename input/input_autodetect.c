@@ -16,93 +16,23 @@
 
 #include "input_common.h"
 #include "input_autodetect.h"
-#include <file/dir_list.h>
+#include "input_autoconfig_db.h"
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
 
 #include "../general.h"
 
-enum
-{
-   AUTODETECT_MATCH_NONE = 0,
-   AUTODETECT_MATCH_VID,
-   AUTODETECT_MATCH_PID,
-   AUTODETECT_MATCH_IDENT,
-   AUTODETECT_MATCH_DRIVER,
-   AUTODETECT_MATCH_NAME,
-};
-
-static void input_autoconfigure_joypad_conf(config_file_t *conf,
-      struct retro_keybind *binds)
-{
-   unsigned i;
-
-   for (i = 0; i < RARCH_BIND_LIST_END; i++)
-   {
-      input_config_parse_joy_button(conf, "input",
-            input_config_bind_map[i].base, &binds[i]);
-      input_config_parse_joy_axis(conf, "input",
-            input_config_bind_map[i].base, &binds[i]);
-   }
-}
-
-static bool input_try_autoconfigure_joypad_from_conf(config_file_t *conf,
-      autoconfig_params_t *params, unsigned *match)
-{
-   char ident[PATH_MAX_LENGTH], ident_idx[PATH_MAX_LENGTH];
-   char input_driver[PATH_MAX_LENGTH];
-   int input_vid = 0, input_pid = 0;
-   bool ret = false;
-
-   if (!conf)
-      return false;
-
-   *ident = *input_driver = '\0';
-
-   config_get_array(conf, "input_device", ident, sizeof(ident));
-   config_get_array(conf, "input_driver", input_driver, sizeof(input_driver));
-   config_get_int  (conf, "input_vendor_id", &input_vid);
-   config_get_int  (conf, "input_product_id", &input_pid);
-
-   snprintf(ident_idx,
-         sizeof(ident_idx), "%s_p%u", ident, params->idx);
-
-   /* If Vendor ID and Product ID matches, we've found our
-    * entry. */
-   if (     (params->vid == input_vid)
-         && (params->pid == input_pid)
-         && params->vid != 0
-         && params->pid != 0
-         && input_vid   != 0
-         && input_pid   != 0)
-   {
-      BIT32_SET(*match, AUTODETECT_MATCH_VID);
-      BIT32_SET(*match, AUTODETECT_MATCH_PID);
-      ret = true;
-   }
-
-   /* Check for name match. */
-   if (!strcmp(ident_idx, params->name))
-   {
-      BIT32_SET(*match, AUTODETECT_MATCH_NAME);
-      ret = true;
-   }
+/* Profiles compiled from the autoconfig directory, kept until
+ * the directory changes. */
+static autoconfig_db_t *autoconfig_dir_db;
 
-   /* Check for name match - name starts with ident */
-   if (ident[0] != '\0' && !strncmp(params->name, ident, strlen(ident)))
-   {
-      BIT32_SET(*match, AUTODETECT_MATCH_IDENT);
-      ret = true;
-      if (!strcmp(params->driver, input_driver))
-          BIT32_SET(*match, AUTODETECT_MATCH_DRIVER);
-   }
-
-   return ret;
-}
+#if defined(HAVE_BUILTIN_AUTOCONFIG)
+static autoconfig_db_t *autoconfig_builtin_db;
+#endif
 
 static void input_autoconfigure_joypad_add(
-      config_file_t *conf,
+      const autoconfig_db_t *db, unsigned db_idx,
       autoconfig_params_t *params)
 {
    char msg[PATH_MAX_LENGTH];
@@ -117,7 +47,7 @@ static void input_autoconfigure_joypad_add(
       return;
 
    settings->input.autoconfigured[params->idx] = true;
-   input_autoconfigure_joypad_conf(conf,
+   autoconfig_db_get_binds(db, db_idx,
          settings->input.autoconf_binds[params->idx]);
 
    snprintf(msg, sizeof(msg), "Device port #%u (%s) configured.",
@@ -128,68 +58,55 @@ static void input_autoconfigure_joypad_add(
    RARCH_LOG("%s\n", msg);
 }
 
-static bool input_autoconfigure_joypad_from_conf(
-      config_file_t *conf, autoconfig_params_t *params)
+static bool input_autoconfigure_joypad_from_db(
+      const autoconfig_db_t *db, autoconfig_params_t *params)
 {
-   bool ret = false;
-   uint32_t match = 0;
+   int db_idx = autoconfig_db_find(db, params);
 
-   if (!conf)
+   if (db_idx < 0)
       return false;
-   
-   ret = input_try_autoconfigure_joypad_from_conf(conf,
-         params, &match);
-
-   if (ret)
-      input_autoconfigure_joypad_add(conf, params);
-
-   config_file_free(conf);
 
-   return ret;
+   input_autoconfigure_joypad_add(db, db_idx, params);
+   return true;
 }
 
 static bool input_autoconfigure_joypad_from_conf_dir(
       autoconfig_params_t *params)
 {
-   size_t i;
-   bool ret = false;
+   uint64_t signature;
    settings_t *settings = config_get_ptr();
-   struct string_list *list = settings ? dir_list_new(
-         settings->input.autoconfig_dir, "cfg", false) : NULL;
 
-   if (!list)
+   if (!settings || !*settings->input.autoconfig_dir)
       return false;
 
-   for (i = 0; i < list->size; i++)
-   {
-      config_file_t *conf = config_file_new(list->elems[i].data);
+   /* Rebuilding is only needed when profiles have been added,
+    * removed or edited, or the directory setting has changed. */
+   signature = autoconfig_db_dir_signature(settings->input.autoconfig_dir);
 
-      if ((ret = input_autoconfigure_joypad_from_conf(conf, params)))
-         break;
+   if (!autoconfig_dir_db ||
+         autoconfig_db_signature(autoconfig_dir_db) != signature)
+   {
+      autoconfig_db_free(autoconfig_dir_db);
+      autoconfig_dir_db = autoconfig_db_new_from_dir(
+            settings->input.autoconfig_dir, signature);
    }
 
-   string_list_free(list);
-
-   return ret;
+   return input_autoconfigure_joypad_from_db(autoconfig_dir_db, params);
 }
 
 #if defined(HAVE_BUILTIN_AUTOCONFIG)
 static bool input_autoconfigure_joypad_from_conf_internal(
       autoconfig_params_t *params)
 {
-   size_t i;
    settings_t *settings = config_get_ptr();
-   bool ret = false;
+   bool ret             = false;
 
    /* Load internal autoconfig files  */
-   for (i = 0; input_builtin_autoconfs[i]; i++)
-   {
-      config_file_t *conf = config_file_new_from_string(
-            input_builtin_autoconfs[i]);
+   if (!autoconfig_builtin_db)
+      autoconfig_builtin_db = autoconfig_db_new_from_strings(
+            input_builtin_autoconfs);
 
-      if ((ret = input_autoconfigure_joypad_from_conf(conf, params)))
-         break;
-   }
+   ret = input_autoconfigure_joypad_from_db(autoconfig_builtin_db, params);
 
    if (ret || !*settings->input.autoconfig_dir)
       return true;
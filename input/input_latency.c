@@ -0,0 +1,155 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input_latency.h"
+
+#include "../general.h"
+#include "../performance.h"
+
+/* Times are in microseconds since logging started,
+ * -1 for steps the frame being logged hasn't reached. */
+static struct
+{
+   FILE *file;
+   bool flash;
+
+   retro_time_t start;
+   uint64_t frame;
+   uint64_t buttons;
+
+   bool pressed;
+   bool flashed;
+   retro_time_t poll_time;
+   retro_time_t frame_time;
+   volatile retro_time_t swap_time;
+
+   uint8_t *flash_frame;
+   size_t flash_frame_size;
+} input_latency;
+
+static void input_latency_write_frame(void)
+{
+   if (input_latency.poll_time < 0)
+      return;
+
+   fprintf(input_latency.file, "%llu,%lld,%d,%d,%lld,%lld\n",
+         (unsigned long long)input_latency.frame,
+         (long long)input_latency.poll_time,
+         input_latency.pressed,
+         input_latency.flashed,
+         (long long)input_latency.frame_time,
+         (long long)input_latency.swap_time);
+
+   input_latency.frame++;
+}
+
+bool input_latency_init(const char *path, bool flash)
+{
+   input_latency_free();
+
+   input_latency.file = fopen(path, "w");
+   if (!input_latency.file)
+   {
+      RARCH_ERR("Failed to open latency log: \"%s\".\n", path);
+      return false;
+   }
+
+   fprintf(input_latency.file,
+         "frame,poll_usec,pressed,flashed,frame_usec,swap_usec\n");
+
+   input_latency.flash      = flash;
+   input_latency.start      = rarch_get_time_usec();
+   input_latency.poll_time  = -1;
+   input_latency.frame_time = -1;
+   input_latency.swap_time  = -1;
+
+   RARCH_LOG("Logging input latency to: \"%s\".\n", path);
+   return true;
+}
+
+void input_latency_free(void)
+{
+   if (input_latency.file)
+   {
+      input_latency_write_frame();
+      fclose(input_latency.file);
+   }
+
+   free(input_latency.flash_frame);
+   memset(&input_latency, 0, sizeof(input_latency));
+}
+
+bool input_latency_active(void)
+{
+   return input_latency.file != NULL;
+}
+
+void input_latency_poll(uint64_t buttons)
+{
+   if (!input_latency.file)
+      return;
+
+   input_latency_write_frame();
+
+   input_latency.poll_time  = rarch_get_time_usec() - input_latency.start;
+   input_latency.frame_time = -1;
+   input_latency.swap_time  = -1;
+   input_latency.flashed    = false;
+
+   /* Only presses count, not held buttons. */
+   input_latency.pressed    = (buttons & ~input_latency.buttons) != 0;
+   input_latency.buttons    = buttons;
+}
+
+const void *input_latency_frame(unsigned height, size_t pitch)
+{
+   size_t size = height * pitch;
+
+   if (!input_latency.file || input_latency.frame_time >= 0)
+      return NULL;
+
+   input_latency.frame_time = rarch_get_time_usec() - input_latency.start;
+
+   if (!input_latency.flash || !input_latency.pressed)
+      return NULL;
+
+   if (size > input_latency.flash_frame_size)
+   {
+      uint8_t *flash_frame = (uint8_t*)realloc(input_latency.flash_frame, size);
+
+      if (!flash_frame)
+         return NULL;
+
+      /* All ones is white in every pixel format. */
+      memset(flash_frame, 0xff, size);
+      input_latency.flash_frame      = flash_frame;
+      input_latency.flash_frame_size = size;
+   }
+
+   input_latency.flashed = true;
+   return input_latency.flash_frame;
+}
+
+void input_latency_swap(void)
+{
+   if (!input_latency.file || input_latency.swap_time >= 0)
+      return;
+
+   input_latency.swap_time = rarch_get_time_usec() - input_latency.start;
+}
@@ -0,0 +1,86 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INPUT_LATENCY_H
+#define _INPUT_LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * input_latency_init:
+ * @path                     : Path of the CSV log to write.
+ * @flash                    : Flash frames after button presses.
+ *
+ * Starts logging the input poll, frame submission and buffer
+ * swap times of every frame to @path, one frame per line,
+ * so they can be lined up with an external latency rig.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool input_latency_init(const char *path, bool flash);
+
+/**
+ * input_latency_free:
+ *
+ * Writes out the last frame and stops logging.
+ **/
+void input_latency_free(void);
+
+/**
+ * input_latency_active:
+ *
+ * Returns: true (1) if input latency is being logged.
+ **/
+bool input_latency_active(void);
+
+/**
+ * input_latency_poll:
+ * @buttons                  : Joypad buttons of user 1 as polled.
+ *
+ * Marks the start of a frame, at the input poll of the core.
+ **/
+void input_latency_poll(uint64_t buttons);
+
+/**
+ * input_latency_frame:
+ * @height                   : Height of the frame.
+ * @pitch                    : Pitch of the frame.
+ *
+ * Marks the submission of the frame.
+ *
+ * Returns: a white frame of @height lines of @pitch bytes if
+ * the frame should flash for a button press, otherwise NULL.
+ **/
+const void *input_latency_frame(unsigned height, size_t pitch);
+
+/**
+ * input_latency_swap:
+ *
+ * Marks the completion of the buffer swap of the frame.
+ * Can be called from the video thread.
+ **/
+void input_latency_swap(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
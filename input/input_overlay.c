@@ -26,6 +26,40 @@
 #include <stddef.h>
 #include <math.h>
 
+#if defined(HAVE_THREADS) && !defined(_XBOX1) && !defined(__CELLOS_LV2__)
+#include "../gfx/video_work_pool.h"
+#define OVERLAY_DECODE_THREADS 4
+#else
+/* Decode on the calling thread only, either without threads
+ * or where image loading goes through the video device. */
+#define OVERLAY_DECODE_THREADS 1
+#endif
+
+/* Images decoded per step of the data runloop. */
+#define OVERLAY_IMAGE_BATCH_SIZE (2 * OVERLAY_DECODE_THREADS)
+
+/* Pre-compressed images have no pixels, nor have images
+ * packed into the atlas of their overlay, which keep their size. */
+#define OVERLAY_IMAGE_LOADED(img) ((img)->pixels || (img)->compressed \
+      || (img)->width)
+
+/* Largest side of an overlay atlas. Overlays which do not fit
+ * keep a texture per image. */
+#ifndef OVERLAY_ATLAS_SIZE_MAX
+#define OVERLAY_ATLAS_SIZE_MAX 2048
+#endif
+
+/* Border around each image in an atlas, repeating its edge
+ * pixels so linear filtering does not pull in its neighbours. */
+#define OVERLAY_ATLAS_PADDING 1
+
+struct overlay_atlas_entry
+{
+   unsigned index;
+   unsigned x, y;
+   unsigned width, height;
+};
+
 /**
  * input_overlay_scale:
  * @ol                    : Overlay handle.
@@ -79,7 +113,7 @@ static void input_overlay_set_vertex_geom(input_overlay_t *ol)
 
    if (!ol)
       return;
-   if (ol->active->image.pixels)
+   if (OVERLAY_IMAGE_LOADED(&ol->active->image))
       ol->iface->vertex_geom(ol->iface_data, 0,
             ol->active->mod_x, ol->active->mod_y,
             ol->active->mod_w, ol->active->mod_h);
@@ -91,11 +125,13 @@ static void input_overlay_set_vertex_geom(input_overlay_t *ol)
       if (!desc)
          continue;
 
-      if (!desc->image.pixels)
+      if (!OVERLAY_IMAGE_LOADED(&desc->image))
          continue;
 
       ol->iface->vertex_geom(ol->iface_data, desc->image_index,
             desc->mod_x, desc->mod_y, desc->mod_w, desc->mod_h);
+      desc->geom_delta_x = 0.0f;
+      desc->geom_delta_y = 0.0f;
    }
 }
 
@@ -131,6 +167,9 @@ static void input_overlay_free_overlay(struct overlay *overlay)
 
    free(overlay->load_images);
    free(overlay->descs);
+   free(overlay->grid_descs);
+   free(overlay->atlas_coords);
+   texture_image_free(&overlay->atlas);
    texture_image_free(&overlay->image);
 }
 
@@ -147,44 +186,352 @@ static void input_overlay_free_overlays(input_overlay_t *ol)
    free(ol->overlays);
 }
 
-static bool input_overlay_load_texture_image(struct overlay *overlay,
-      struct texture_image *image, const char *path)
+static bool input_overlay_queue_image(input_overlay_t *ol,
+      const char *path, unsigned ol_idx, int desc_idx)
 {
-   struct texture_image img = {0};
+   char resolved_path[PATH_MAX_LENGTH];
+   struct overlay_image_job *job = NULL;
+
+   if (ol->decode.size == ol->decode.capacity)
+   {
+      size_t capacity = ol->decode.capacity ? ol->decode.capacity * 2 : 16;
+      struct overlay_image_job *jobs = (struct overlay_image_job*)
+         realloc(ol->decode.jobs, capacity * sizeof(*jobs));
+
+      if (!jobs)
+         return false;
+
+      ol->decode.jobs     = jobs;
+      ol->decode.capacity = capacity;
+   }
+
+   fill_pathname_resolve_relative(resolved_path, ol->overlay_path,
+         path, sizeof(resolved_path));
 
-   if (!texture_image_load(&img, path))
+   job = &ol->decode.jobs[ol->decode.size];
+   memset(job, 0, sizeof(*job));
+
+   job->path = strdup(resolved_path);
+   if (!job->path)
       return false;
 
-   *image = img;
-   overlay->load_images[overlay->load_images_size++] = *image;
-   
+   job->overlay_index = ol_idx;
+   job->desc_index    = desc_idx;
+   ol->decode.size++;
+
    return true;
 }
 
-static bool input_overlay_load_desc_image(input_overlay_t *ol,
-      struct overlay_desc *desc,
-      struct overlay *input_overlay,
-      unsigned ol_idx, unsigned desc_idx)
+static bool input_overlay_queue_desc_images(input_overlay_t *ol,
+      unsigned ol_idx, unsigned size)
+{
+   unsigned i;
+
+   for (i = 0; i < size; i++)
+   {
+      char overlay_desc_image_key[64], image_path[PATH_MAX_LENGTH];
+
+      snprintf(overlay_desc_image_key, sizeof(overlay_desc_image_key),
+            "overlay%u_desc%u_overlay", ol_idx, i);
+
+      if (!config_get_path(ol->conf, overlay_desc_image_key,
+               image_path, sizeof(image_path)))
+         continue;
+
+      if (!input_overlay_queue_image(ol, image_path, ol_idx, i))
+         return false;
+   }
+
+   return true;
+}
+
+static void input_overlay_free_decode_jobs(input_overlay_t *ol)
+{
+   size_t i;
+
+   for (i = 0; i < ol->decode.size; i++)
+   {
+      if (ol->decode.jobs[i].loaded)
+         texture_image_free(&ol->decode.jobs[i].image);
+      free(ol->decode.jobs[i].path);
+   }
+
+   free(ol->decode.jobs);
+   memset(&ol->decode, 0, sizeof(ol->decode));
+}
+
+#if OVERLAY_DECODE_THREADS > 1
+static void input_overlay_decode_work(void *data,
+      unsigned index, unsigned thread)
+{
+   struct overlay_image_job *job = (struct overlay_image_job*)data + index;
+
+   (void)thread;
+
+   job->loaded = texture_image_load_compressed(&job->image, job->path);
+}
+#endif
+
+/* Decodes a batch of images, on the video worker pool
+ * along with the calling thread where threads are usable. */
+static void input_overlay_decode_images(struct overlay_image_job *jobs,
+      size_t size)
+{
+#if OVERLAY_DECODE_THREADS > 1
+   video_work_pool_init();
+   video_work_pool_run(input_overlay_decode_work, jobs, size);
+   video_work_pool_deinit();
+#else
+   size_t i;
+
+   for (i = 0; i < size; i++)
+      jobs[i].loaded = texture_image_load_compressed(
+            &jobs[i].image, jobs[i].path);
+#endif
+}
+
+static int input_overlay_atlas_entry_cmp(const void *a, const void *b)
+{
+   const struct overlay_atlas_entry *entry_a =
+      (const struct overlay_atlas_entry*)a;
+   const struct overlay_atlas_entry *entry_b =
+      (const struct overlay_atlas_entry*)b;
+
+   if (entry_a->height != entry_b->height)
+      return entry_a->height < entry_b->height ? 1 : -1;
+   return entry_a->index < entry_b->index ? -1 : 1;
+}
+
+/* Copies @img into @atlas with its edges repeated
+ * OVERLAY_ATLAS_PADDING times all around. */
+static void input_overlay_atlas_blit(struct texture_image *atlas,
+      const struct overlay_atlas_entry *entry,
+      const struct texture_image *img)
 {
-   char overlay_desc_image_key[64], image_path[PATH_MAX_LENGTH];
+   int y;
+   const int pad = OVERLAY_ATLAS_PADDING;
 
-   snprintf(overlay_desc_image_key, sizeof(overlay_desc_image_key),
-         "overlay%u_desc%u_overlay", ol_idx, desc_idx);
+   for (y = -pad; y < (int)img->height + pad; y++)
+   {
+      int i;
+      int src_y           = y < 0 ? 0 :
+         (y >= (int)img->height ? (int)img->height - 1 : y);
+      const uint32_t *src = img->pixels + src_y * img->width;
+      uint32_t *dst       = atlas->pixels
+         + (entry->y + pad + y) * atlas->width + entry->x + pad;
+
+      memcpy(dst, src, img->width * sizeof(uint32_t));
+      for (i = 1; i <= pad; i++)
+      {
+         dst[-i]                 = src[0];
+         dst[img->width - 1 + i] = src[img->width - 1];
+      }
+   }
+}
 
-   if (config_get_path(ol->conf, overlay_desc_image_key,
-            image_path, sizeof(image_path)))
+/**
+ * input_overlay_pack_atlas:
+ * @overlay               : Overlay.
+ *
+ * Packs the images of @overlay into one atlas, on shelves
+ * filled with the tallest images first, so drivers can draw
+ * the overlay with a single texture. Frees the pixels of the
+ * images once packed. Overlays with pre-compressed images, or
+ * which do not fit in OVERLAY_ATLAS_SIZE_MAX, are left alone.
+ *
+ * Returns: true (1) if @overlay got an atlas, otherwise false (0).
+ **/
+static bool input_overlay_pack_atlas(struct overlay *overlay)
+{
+   unsigned i, x = 0, y = 0, shelf_height = 0;
+   unsigned width                      = 0;
+   uint64_t area                       = 0;
+   unsigned num_images                 = overlay->load_images_size;
+   struct overlay_atlas_entry *entries = NULL;
+   struct texture_image atlas          = {0};
+
+   if (num_images < 2)
+      return false;
+
+   for (i = 0; i < num_images; i++)
    {
-      char path[PATH_MAX_LENGTH];
-      fill_pathname_resolve_relative(path, ol->overlay_path,
-            image_path, sizeof(path));
+      const struct texture_image *img = &overlay->load_images[i];
+      unsigned w = img->width  + 2 * OVERLAY_ATLAS_PADDING;
+      unsigned h = img->height + 2 * OVERLAY_ATLAS_PADDING;
 
-      if (input_overlay_load_texture_image(input_overlay, &desc->image, path))
-         desc->image_index = input_overlay->load_images_size - 1;
+      if (!img->pixels || !img->width || !img->height)
+         return false;
+
+      area += (uint64_t)w * h;
+      if (w > width)
+         width = w;
    }
 
-   input_overlay->pos ++;
+   /* Square-ish, unless an image is wider. */
+   while ((uint64_t)width * width < area)
+      width += 64;
+
+   if (width > OVERLAY_ATLAS_SIZE_MAX)
+      return false;
+
+   entries = (struct overlay_atlas_entry*)calloc(num_images, sizeof(*entries));
+   if (!entries)
+      return false;
+
+   for (i = 0; i < num_images; i++)
+   {
+      entries[i].index  = i;
+      entries[i].width  = overlay->load_images[i].width
+         + 2 * OVERLAY_ATLAS_PADDING;
+      entries[i].height = overlay->load_images[i].height
+         + 2 * OVERLAY_ATLAS_PADDING;
+   }
+
+   qsort(entries, num_images, sizeof(*entries),
+         input_overlay_atlas_entry_cmp);
+
+   for (i = 0; i < num_images; i++)
+   {
+      if (x + entries[i].width > width)
+      {
+         x            = 0;
+         y           += shelf_height;
+         shelf_height = 0;
+      }
+
+      entries[i].x = x;
+      entries[i].y = y;
+      x           += entries[i].width;
+
+      if (entries[i].height > shelf_height)
+         shelf_height = entries[i].height;
+   }
+
+   atlas.width  = width;
+   atlas.height = y + shelf_height;
+
+   if (atlas.height > OVERLAY_ATLAS_SIZE_MAX)
+      goto error;
+
+   atlas.pixels          = (uint32_t*)calloc(
+         atlas.width * atlas.height, sizeof(uint32_t));
+   overlay->atlas_coords = (float*)malloc(
+         4 * num_images * sizeof(float));
+
+   if (!atlas.pixels || !overlay->atlas_coords)
+      goto error;
+
+   for (i = 0; i < num_images; i++)
+   {
+      const struct overlay_atlas_entry *entry = &entries[i];
+      const struct texture_image *img = &overlay->load_images[entry->index];
+      float *coords = &overlay->atlas_coords[4 * entry->index];
+
+      input_overlay_atlas_blit(&atlas, entry, img);
+
+      coords[0] = (float)(entry->x + OVERLAY_ATLAS_PADDING) / atlas.width;
+      coords[1] = (float)(entry->y + OVERLAY_ATLAS_PADDING) / atlas.height;
+      coords[2] = (float)img->width  / atlas.width;
+      coords[3] = (float)img->height / atlas.height;
+   }
+
+   /* The base image and the desc images share their
+    * pixels with load_images. */
+   overlay->image.pixels = NULL;
+   for (i = 0; i < overlay->size; i++)
+      overlay->descs[i].image.pixels = NULL;
+
+   for (i = 0; i < num_images; i++)
+   {
+      free(overlay->load_images[i].pixels);
+      overlay->load_images[i].pixels = NULL;
+   }
+
+   overlay->atlas = atlas;
+
+   free(entries);
+   return true;
+
+error:
+   free(atlas.pixels);
+   free(overlay->atlas_coords);
+   overlay->atlas_coords = NULL;
+   free(entries);
+   return false;
+}
+
+/**
+ * input_overlay_load_overlays_image_iterate:
+ * @ol                    : Overlay handle.
+ *
+ * Decodes the next batch of queued overlay images and hands
+ * them over to their overlays. Runs on the data runloop, so
+ * that only uploading the images is left to the main thread.
+ *
+ * Returns: false if a base image failed to load, otherwise true.
+ **/
+bool input_overlay_load_overlays_image_iterate(input_overlay_t *ol)
+{
+   size_t i, end;
+
+   if (!ol)
+      return false;
+
+   end = ol->decode.pos + OVERLAY_IMAGE_BATCH_SIZE;
+   if (end > ol->decode.size)
+      end = ol->decode.size;
+
+   input_overlay_decode_images(&ol->decode.jobs[ol->decode.pos],
+         end - ol->decode.pos);
+
+   for (i = ol->decode.pos; i < end; i++)
+   {
+      struct overlay_image_job *job = &ol->decode.jobs[i];
+      struct overlay *overlay       = &ol->overlays[job->overlay_index];
+
+      if (!job->loaded)
+      {
+         if (job->desc_index < 0)
+         {
+            RARCH_ERR("[Overlay]: Failed to load image: %s.\n", job->path);
+            goto error;
+         }
+         continue;
+      }
+
+      if (job->desc_index < 0)
+         overlay->image = job->image;
+      else
+      {
+         struct overlay_desc *desc = &overlay->descs[job->desc_index];
+
+         desc->image       = job->image;
+         desc->image_index = overlay->load_images_size;
+      }
+
+      overlay->load_images[overlay->load_images_size++] = job->image;
+      job->loaded = false;
+   }
+
+   ol->decode.pos = end;
+
+   if (ol->decode.pos >= ol->decode.size)
+   {
+      input_overlay_free_decode_jobs(ol);
+
+      if (ol->iface->load_atlas)
+         for (i = 0; i < ol->size; i++)
+            input_overlay_pack_atlas(&ol->overlays[i]);
+
+      ol->state = OVERLAY_STATUS_DEFERRED_LOADING;
+   }
 
    return true;
+
+error:
+   ol->state = OVERLAY_STATUS_DEFERRED_ERROR;
+
+   return false;
 }
 
 static bool input_overlay_load_desc(input_overlay_t *ol,
@@ -354,6 +701,87 @@ end:
    return ret;
 }
 
+static unsigned input_overlay_grid_cell(float pos)
+{
+   int cell = (int)floorf(pos * OVERLAY_GRID_SIZE);
+
+   if (cell < 0)
+      return 0;
+   if (cell >= OVERLAY_GRID_SIZE)
+      return OVERLAY_GRID_SIZE - 1;
+   return cell;
+}
+
+/**
+ * input_overlay_build_grid:
+ * @ol                    : Overlay with all its descs loaded.
+ *
+ * Sorts the descs of @ol into a grid, by the cells their
+ * hitboxes can reach into when pressed or not, so that hit-testing
+ * only has to look at the descs of one cell.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool input_overlay_build_grid(struct overlay *ol)
+{
+   size_t i;
+   size_t fill[OVERLAY_GRID_SIZE * OVERLAY_GRID_SIZE];
+   unsigned pass, x, y;
+
+   free(ol->grid_descs);
+   ol->grid_descs = NULL;
+   memset(ol->grid_offsets, 0, sizeof(ol->grid_offsets));
+
+   /* Count the descs of each cell first, then fill them in. */
+   for (pass = 0; pass < 2; pass++)
+   {
+      for (i = 0; i < ol->size; i++)
+      {
+         const struct overlay_desc *desc = &ol->descs[i];
+         float range_mod = desc->range_mod > 1.0f ? desc->range_mod : 1.0f;
+         float range_x   = desc->range_x * range_mod;
+         float range_y   = desc->range_y * range_mod;
+         unsigned x_min  = input_overlay_grid_cell(desc->x - range_x);
+         unsigned x_max  = input_overlay_grid_cell(desc->x + range_x);
+         unsigned y_min  = input_overlay_grid_cell(desc->y - range_y);
+         unsigned y_max  = input_overlay_grid_cell(desc->y + range_y);
+
+         for (y = y_min; y <= y_max; y++)
+         {
+            for (x = x_min; x <= x_max; x++)
+            {
+               unsigned cell = y * OVERLAY_GRID_SIZE + x;
+
+               if (pass == 0)
+                  ol->grid_offsets[cell + 1]++;
+               else
+                  ol->grid_descs[fill[cell]++] = i;
+            }
+         }
+      }
+
+      if (pass == 1)
+         break;
+
+      for (i = 0; i < OVERLAY_GRID_SIZE * OVERLAY_GRID_SIZE; i++)
+      {
+         ol->grid_offsets[i + 1] += ol->grid_offsets[i];
+         fill[i] = ol->grid_offsets[i];
+      }
+
+      if (!ol->grid_offsets[OVERLAY_GRID_SIZE * OVERLAY_GRID_SIZE])
+         return true;
+
+      ol->grid_descs = (unsigned*)malloc(
+            ol->grid_offsets[OVERLAY_GRID_SIZE * OVERLAY_GRID_SIZE]
+            * sizeof(*ol->grid_descs));
+      if (!ol->grid_descs)
+         return false;
+   }
+
+   return true;
+}
+
 static ssize_t input_overlay_find_index(const struct overlay *ol,
       const char *name, size_t size)
 {
@@ -412,8 +840,24 @@ static void input_overlay_load_active(input_overlay_t *ol,
    if (!ol)
       return;
 
-   ol->iface->load(ol->iface_data, ol->active->load_images,
-         ol->active->load_images_size);
+   if (ol->active->atlas.pixels)
+   {
+      /* Texture coordinates do not change with the scale,
+       * so unlike the vertices they are only set here. */
+      unsigned i;
+      const float *coords = ol->active->atlas_coords;
+
+      if (!ol->iface->load_atlas(ol->iface_data, &ol->active->atlas,
+               ol->active->load_images_size))
+         RARCH_ERR("[Overlay]: Failed to load atlas.\n");
+
+      for (i = 0; i < ol->active->load_images_size; i++, coords += 4)
+         ol->iface->tex_geom(ol->iface_data, i,
+               coords[0], coords[1], coords[2], coords[3]);
+   }
+   else
+      ol->iface->load(ol->iface_data, ol->active->load_images,
+            ol->active->load_images_size);
 
    input_overlay_set_alpha_mod(ol, opacity);
    input_overlay_set_vertex_geom(ol);
@@ -500,27 +944,9 @@ bool input_overlay_load_overlays_iterate(input_overlay_t *ol)
          break;
       case OVERLAY_IMAGE_TRANSFER_DONE:
          input_overlay_load_overlay_image_done(&ol->overlays[ol->pos]);
-         ol->loading_status = OVERLAY_IMAGE_TRANSFER_DESC_IMAGE_ITERATE;
+         ol->loading_status = OVERLAY_IMAGE_TRANSFER_DESC_ITERATE;
          ol->overlays[ol->pos].pos = 0;
          break;
-      case OVERLAY_IMAGE_TRANSFER_DESC_IMAGE_ITERATE:
-         for (i = 0; i < overlay->pos_increment; i++)
-         {
-            if (overlay->pos < overlay->size)
-            {
-               input_overlay_load_desc_image(ol,
-                     &overlay->descs[overlay->pos], overlay,
-                     ol->pos, overlay->pos);
-            }
-            else
-            {
-               overlay->pos       = 0;
-               ol->loading_status = OVERLAY_IMAGE_TRANSFER_DESC_ITERATE;
-               break;
-            }
-
-         }
-         break;
       case OVERLAY_IMAGE_TRANSFER_DESC_ITERATE:
          for (i = 0; i < overlay->pos_increment; i++)
          {
@@ -548,6 +974,13 @@ bool input_overlay_load_overlays_iterate(input_overlay_t *ol)
          }
          break;
       case OVERLAY_IMAGE_TRANSFER_DESC_DONE:
+         if (!input_overlay_build_grid(overlay))
+         {
+            RARCH_ERR("[Overlay]: Failed to build hit-testing grid for overlay #%u.\n",
+                  (unsigned)ol->pos);
+            goto error;
+         }
+
          if (ol->pos == 0)
             input_overlay_load_overlays_resolve_iterate(ol);
          ol->pos += 1;
@@ -580,7 +1013,7 @@ bool input_overlay_load_overlays(input_overlay_t *ol)
       if (!to_cont)
       {
          ol->pos   = 0;
-         ol->state = OVERLAY_STATUS_DEFERRED_LOADING;
+         ol->state = OVERLAY_STATUS_DEFERRED_LOADING_IMAGE;
          break;
       }
 
@@ -645,21 +1078,22 @@ bool input_overlay_load_overlays(input_overlay_t *ol)
       config_get_path(ol->conf, overlay->config.paths.key,
                overlay->config.paths.path, sizeof(overlay->config.paths.path));
 
-      if (overlay->config.paths.path[0] != '\0')
+      /* Images are decoded later on, in batches. The base image
+       * is queued first so it takes the first load_images slot. */
+      if (overlay->config.paths.path[0] != '\0' &&
+            !input_overlay_queue_image(ol, overlay->config.paths.path,
+               ol->pos, -1))
       {
-         char overlay_resolved_path[PATH_MAX_LENGTH];
-
-         fill_pathname_resolve_relative(overlay_resolved_path, ol->overlay_path,
-               overlay->config.paths.path, sizeof(overlay_resolved_path));
-
-         if (!input_overlay_load_texture_image(overlay, &overlay->image, overlay_resolved_path))
-         {
-            RARCH_ERR("[Overlay]: Failed to load image: %s.\n",
-                  overlay_resolved_path);
-            ol->loading_status = OVERLAY_IMAGE_TRANSFER_ERROR;
-            goto error;
-         }
+         RARCH_ERR("[Overlay]: Failed to queue image: %s.\n",
+               overlay->config.paths.path);
+         goto error;
+      }
 
+      if (!input_overlay_queue_desc_images(ol, ol->pos, overlay->size))
+      {
+         RARCH_ERR("[Overlay]: Failed to queue desc images for overlay #%u.\n",
+               ol->pos);
+         goto error;
       }
 
       snprintf(overlay->config.names.key, sizeof(overlay->config.names.key),
@@ -882,6 +1316,8 @@ void input_overlay_poll(input_overlay_t *ol, input_overlay_state_t *out,
 {
    size_t i;
    float x, y;
+   const size_t *offsets = ol->active->grid_offsets;
+   unsigned cell;
 
    memset(out, 0, sizeof(*out));
 
@@ -901,10 +1337,14 @@ void input_overlay_poll(input_overlay_t *ol, input_overlay_state_t *out,
    x /= ol->active->mod_w;
    y /= ol->active->mod_h;
 
-   for (i = 0; i < ol->active->size; i++)
+   cell = input_overlay_grid_cell(y) * OVERLAY_GRID_SIZE
+      + input_overlay_grid_cell(x);
+
+   for (i = offsets[cell]; i < offsets[cell + 1]; i++)
    {
       float x_dist, y_dist;
-      struct overlay_desc *desc = &ol->active->descs[i];
+      struct overlay_desc *desc =
+         &ol->active->descs[ol->active->grid_descs[i]];
 
       if (!desc)
          continue;
@@ -967,19 +1407,45 @@ void input_overlay_poll(input_overlay_t *ol, input_overlay_state_t *out,
 static void input_overlay_update_desc_geom(input_overlay_t *ol,
       struct overlay_desc *desc)
 {
-   if (!desc || !desc->image.pixels)
+   if (!desc || !OVERLAY_IMAGE_LOADED(&desc->image))
       return;
    if (!desc->movable)
       return;
 
-   ol->iface->vertex_geom(ol->iface_data, desc->image_index,
-      desc->mod_x + desc->delta_x, desc->mod_y + desc->delta_y,
-      desc->mod_w, desc->mod_h);
+   /* Only upload geometry which moved. */
+   if (desc->delta_x != desc->geom_delta_x ||
+         desc->delta_y != desc->geom_delta_y)
+   {
+      ol->iface->vertex_geom(ol->iface_data, desc->image_index,
+            desc->mod_x + desc->delta_x, desc->mod_y + desc->delta_y,
+            desc->mod_w, desc->mod_h);
+
+      desc->geom_delta_x = desc->delta_x;
+      desc->geom_delta_y = desc->delta_y;
+   }
 
    desc->delta_x = 0.0f;
    desc->delta_y = 0.0f;
 }
 
+/**
+ * input_overlay_set_desc_alpha:
+ * @ol                    : overlay handle.
+ * @desc                  : overlay descriptor of the active overlay.
+ * @alpha                 : alpha to apply to the image of @desc.
+ *
+ * Applies @alpha to the image of @desc, unless it already is.
+ **/
+static void input_overlay_set_desc_alpha(input_overlay_t *ol,
+      struct overlay_desc *desc, float alpha)
+{
+   if (!OVERLAY_IMAGE_LOADED(&desc->image) || desc->alpha == alpha)
+      return;
+
+   ol->iface->set_alpha(ol->iface_data, desc->image_index, alpha);
+   desc->alpha = alpha;
+}
+
 /**
  * input_overlay_post_poll:
  * @ol                    : overlay handle
@@ -995,7 +1461,8 @@ void input_overlay_post_poll(input_overlay_t *ol, float opacity)
    if (!ol)
       return;
 
-   input_overlay_set_alpha_mod(ol, opacity);
+   if (ol->alpha_mod != opacity)
+      input_overlay_set_alpha_mod(ol, opacity);
 
    for (i = 0; i < ol->active->size; i++)
    {
@@ -1013,10 +1480,10 @@ void input_overlay_post_poll(input_overlay_t *ol, float opacity)
          desc->range_x_mod *= desc->range_mod;
          desc->range_y_mod *= desc->range_mod;
 
-         if (desc->image.pixels)
-            ol->iface->set_alpha(ol->iface_data, desc->image_index,
-                  desc->alpha_mod * opacity);
+         input_overlay_set_desc_alpha(ol, desc, desc->alpha_mod * opacity);
       }
+      else
+         input_overlay_set_desc_alpha(ol, desc, opacity);
 
       input_overlay_update_desc_geom(ol, desc);
       desc->updated = false;
@@ -1039,7 +1506,8 @@ void input_overlay_poll_clear(input_overlay_t *ol, float opacity)
 
    ol->blocked = false;
 
-   input_overlay_set_alpha_mod(ol, opacity);
+   if (ol->alpha_mod != opacity)
+      input_overlay_set_alpha_mod(ol, opacity);
 
    for (i = 0; i < ol->active->size; i++)
    {
@@ -1048,6 +1516,8 @@ void input_overlay_poll_clear(input_overlay_t *ol, float opacity)
       if (!desc)
          continue;
 
+      input_overlay_set_desc_alpha(ol, desc, opacity);
+
       desc->range_x_mod = desc->range_x;
       desc->range_y_mod = desc->range_y;
       desc->updated = false;
@@ -1106,6 +1576,7 @@ void input_overlay_free(input_overlay_t *ol)
       return;
 
    input_overlay_free_overlays(ol);
+   input_overlay_free_decode_jobs(ol);
 
    if (ol->conf)
       config_file_free(ol->conf);
@@ -1135,4 +1606,8 @@ void input_overlay_set_alpha_mod(input_overlay_t *ol, float mod)
 
    for (i = 0; i < ol->active->load_images_size; i++)
       ol->iface->set_alpha(ol->iface_data, i, mod);
+
+   for (i = 0; i < ol->active->size; i++)
+      ol->active->descs[i].alpha = mod;
+   ol->alpha_mod = mod;
 }
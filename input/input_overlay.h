@@ -32,6 +32,9 @@ extern "C" {
 #define OVERLAY_SET_KEY(state, key) (state)->keys[(key) / 32] |= 1 << ((key) % 32)
 #define OVERLAY_CLEAR_KEY(state, key) (state)->keys[(key) / 32] &= ~(1 << ((key) % 32))
 
+/* Cells per side of the hit-testing grid of an overlay. */
+#define OVERLAY_GRID_SIZE 16
+
 /* Overlay driver acts as a medium between input drivers 
  * and video driver.
  *
@@ -53,6 +56,10 @@ typedef struct video_overlay_interface
          float x, float y, float w, float h);
    void (*full_screen)(void *data, bool enable);
    void (*set_alpha)(void *data, unsigned image, float mod);
+   /* Optional. Like load, but all @num_images quads sample
+    * the one @atlas image, each from the part tex_geom sets. */
+   bool (*load_atlas)(void *data,
+         const struct texture_image *atlas, unsigned num_images);
 } video_overlay_interface_t;
 
 enum overlay_hitbox
@@ -87,7 +94,6 @@ enum overlay_image_transfer_status
    OVERLAY_IMAGE_TRANSFER_NONE = 0,
    OVERLAY_IMAGE_TRANSFER_BUSY,
    OVERLAY_IMAGE_TRANSFER_DONE,
-   OVERLAY_IMAGE_TRANSFER_DESC_IMAGE_ITERATE,
    OVERLAY_IMAGE_TRANSFER_DESC_ITERATE,
    OVERLAY_IMAGE_TRANSFER_DESC_DONE,
    OVERLAY_IMAGE_TRANSFER_ERROR,
@@ -117,6 +123,10 @@ struct overlay_desc
    float alpha_mod;
    float range_mod;
 
+   /* Alpha and movement last handed to the video driver. */
+   float alpha;
+   float geom_delta_x, geom_delta_y;
+
    bool updated;
    bool movable;
 };
@@ -172,6 +182,30 @@ struct overlay
 
    struct texture_image *load_images;
    unsigned load_images_size;
+
+   /* All of load_images packed into one image, for drivers with
+    * load_atlas. Their pixels are freed once packed. Image i is
+    * at atlas_coords[4 * i] (x, y, w, h), in texture coordinates. */
+   struct texture_image atlas;
+   float *atlas_coords;
+
+   /* Indices of the descs whose hitboxes can reach into
+    * each cell of a grid over the overlay, in desc order.
+    * Those of cell i start at grid_descs[grid_offsets[i]]. */
+   size_t grid_offsets[OVERLAY_GRID_SIZE * OVERLAY_GRID_SIZE + 1];
+   unsigned *grid_descs;
+};
+
+/* An image queued for decoding, base image of its overlay
+ * if desc_index is negative, otherwise image of that desc. */
+struct overlay_image_job
+{
+   char *path;
+   unsigned overlay_index;
+   int desc_index;
+
+   bool loaded;
+   struct texture_image image;
 };
 
 struct input_overlay
@@ -197,6 +231,17 @@ struct input_overlay
 
    enum overlay_status state;
 
+   /* Alpha last applied to all images of the active overlay. */
+   float alpha_mod;
+
+   struct
+   {
+      struct overlay_image_job *jobs;
+      size_t size;
+      size_t capacity;
+      size_t pos;
+   } decode;
+
    struct
    {
       struct
@@ -83,6 +83,7 @@
 #define RETRO_MSG_INIT_RECORDING_FAILED "Failed to start recording."
 #define RETRO_MSG_TAKE_SCREENSHOT "Taking screenshot."
 #define RETRO_MSG_TAKE_SCREENSHOT_FAILED "Failed to take screenshot."
+#define RETRO_MSG_TAKE_SCREENSHOT_SAVED "Screenshot saved."
 #define RETRO_MSG_TAKE_SCREENSHOT_ERROR "Cannot take screenshot. GPU rendering is used and read_viewport is not supported."
 #define RETRO_MSG_AUDIO_WRITE_FAILED "Audio backend failed to write. Will continue without sound."
 #define RETRO_MSG_MOVIE_STARTED_INIT_NETPLAY_FAILED "Movie playback has started. Cannot start netplay."
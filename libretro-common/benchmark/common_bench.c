@@ -0,0 +1,529 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (common_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Benchmarks the libretro-common modules on the hot paths of the
+ * frontend. All inputs are generated from fixed seeds, and every
+ * benchmark runs a fixed number of iterations several times over,
+ * reporting the median and the fastest run, so results of two
+ * builds can be compared directly.
+ *
+ * Usage: ./common_bench [benchmark name] [scratch directory]
+ *
+ * Prints JSON to stdout, in the same order on every run. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <formats/rpng.h>
+#include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
+#include <queues/fifo_buffer.h>
+#include <file/config_file.h>
+#include <file/dir_list.h>
+#include <file/file_path.h>
+#include <string/string_list.h>
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+
+#define BENCH_REPEATS 7
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 480
+
+#define BENCH_PNG_SIZE 512
+#define BENCH_FIFO_SIZE (64 * 1024)
+#define BENCH_FIFO_CHUNK 4096
+#define BENCH_CONFIG_ENTRIES 2000
+#define BENCH_SPLIT_TOKENS 10000
+#define BENCH_DIR_FILES 10000
+
+struct bench
+{
+   const char *name;
+   bool (*init)(void);
+   void (*run)(void);
+   void (*deinit)(void);
+   unsigned iterations;
+   /* Bytes processed per iteration, for the throughput. */
+   size_t bytes;
+};
+
+static char scratch_dir[PATH_MAX_LENGTH];
+static char png_path[PATH_MAX_LENGTH];
+static char config_path[PATH_MAX_LENGTH];
+static char tree_path[PATH_MAX_LENGTH];
+
+static uint32_t bench_seed;
+
+/* Provided by the frontend, config_file.c only needs them for
+ * paths starting with ~ or :, which the benchmark leaves as is. */
+void fill_pathname_expand_special(char *out_path,
+      const char *in_path, size_t size)
+{
+   strlcpy(out_path, in_path, size);
+}
+
+void fill_pathname_abbreviate_special(char *out_path,
+      const char *in_path, size_t size)
+{
+   strlcpy(out_path, in_path, size);
+}
+
+static uint32_t bench_random(void)
+{
+   bench_seed ^= bench_seed << 13;
+   bench_seed ^= bench_seed >> 17;
+   bench_seed ^= bench_seed << 5;
+   return bench_seed;
+}
+
+static uint64_t bench_time_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Frames look like game screens: flat areas and gradients, with
+ * some noise, so compression and conversions see realistic data. */
+static void bench_fill_argb(uint32_t *data, unsigned width, unsigned height)
+{
+   unsigned x, y;
+
+   bench_seed = 0x12345678;
+   for (y = 0; y < height; y++)
+      for (x = 0; x < width; x++)
+      {
+         uint32_t color = ((x / 16 + y / 16) & 1) ? 0xff204080 :
+            (0xff000000 | ((x & 0xff) << 16) | ((y & 0xff) << 8));
+         if (!(bench_random() & 15))
+            color ^= bench_random() & 0x00ffffff;
+         data[y * width + x] = color;
+      }
+}
+
+/* rpng */
+
+static uint32_t *png_data;
+
+static bool png_init(void)
+{
+   png_data = (uint32_t*)malloc(BENCH_PNG_SIZE * BENCH_PNG_SIZE
+         * sizeof(uint32_t));
+   if (!png_data)
+      return false;
+
+   bench_fill_argb(png_data, BENCH_PNG_SIZE, BENCH_PNG_SIZE);
+   return rpng_save_image_argb(png_path, png_data,
+         BENCH_PNG_SIZE, BENCH_PNG_SIZE,
+         BENCH_PNG_SIZE * sizeof(uint32_t));
+}
+
+static void png_deinit(void)
+{
+   free(png_data);
+   png_data = NULL;
+}
+
+static void png_encode_run(void)
+{
+   rpng_save_image_argb(png_path, png_data,
+         BENCH_PNG_SIZE, BENCH_PNG_SIZE,
+         BENCH_PNG_SIZE * sizeof(uint32_t));
+}
+
+static void png_decode_run(void)
+{
+   uint32_t *data = NULL;
+   unsigned width = 0, height = 0;
+
+   if (rpng_load_image_argb(png_path, &data, &width, &height))
+      free(data);
+}
+
+/* pixconv and scaler */
+
+static uint32_t *frame_argb;
+static uint16_t *frame_16;
+static uint32_t *frame_out;
+
+static bool frame_init(void)
+{
+   unsigned i;
+
+   frame_argb = (uint32_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+   frame_16   = (uint16_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint16_t));
+   /* Large enough for 2x scaling. */
+   frame_out  = (uint32_t*)malloc(4 * BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+   if (!frame_argb || !frame_16 || !frame_out)
+      return false;
+
+   bench_fill_argb(frame_argb, BENCH_WIDTH, BENCH_HEIGHT);
+   for (i = 0; i < BENCH_WIDTH * BENCH_HEIGHT; i++)
+      frame_16[i] = ((frame_argb[i] >> 8) & 0xf800)
+         | ((frame_argb[i] >> 5) & 0x07e0) | ((frame_argb[i] >> 3) & 0x001f);
+   return true;
+}
+
+static void frame_deinit(void)
+{
+   free(frame_argb);
+   free(frame_16);
+   free(frame_out);
+   frame_argb = NULL;
+   frame_16   = NULL;
+   frame_out  = NULL;
+}
+
+static void pixconv_rgb565_argb8888_run(void)
+{
+   conv_rgb565_argb8888(frame_out, frame_16, BENCH_WIDTH, BENCH_HEIGHT,
+         BENCH_WIDTH * sizeof(uint32_t), BENCH_WIDTH * sizeof(uint16_t));
+}
+
+static void pixconv_0rgb1555_argb8888_run(void)
+{
+   conv_0rgb1555_argb8888(frame_out, frame_16, BENCH_WIDTH, BENCH_HEIGHT,
+         BENCH_WIDTH * sizeof(uint32_t), BENCH_WIDTH * sizeof(uint16_t));
+}
+
+static void pixconv_argb8888_0rgb1555_run(void)
+{
+   conv_argb8888_0rgb1555(frame_out, frame_argb, BENCH_WIDTH, BENCH_HEIGHT,
+         BENCH_WIDTH * sizeof(uint16_t), BENCH_WIDTH * sizeof(uint32_t));
+}
+
+static void pixconv_argb8888_abgr8888_run(void)
+{
+   conv_argb8888_abgr8888(frame_out, frame_argb, BENCH_WIDTH, BENCH_HEIGHT,
+         BENCH_WIDTH * sizeof(uint32_t), BENCH_WIDTH * sizeof(uint32_t));
+}
+
+static struct scaler_ctx scaler;
+
+static bool scaler_init(enum scaler_type type)
+{
+   if (!frame_init())
+      return false;
+
+   memset(&scaler, 0, sizeof(scaler));
+   scaler.in_width    = BENCH_WIDTH;
+   scaler.in_height   = BENCH_HEIGHT;
+   scaler.in_stride   = BENCH_WIDTH * sizeof(uint32_t);
+   scaler.out_width   = BENCH_WIDTH * 2;
+   scaler.out_height  = BENCH_HEIGHT * 2;
+   scaler.out_stride  = BENCH_WIDTH * 2 * sizeof(uint32_t);
+   scaler.in_fmt      = SCALER_FMT_ARGB8888;
+   scaler.out_fmt     = SCALER_FMT_ARGB8888;
+   scaler.scaler_type = type;
+   return scaler_ctx_gen_filter(&scaler);
+}
+
+static bool scaler_point_init(void)
+{
+   return scaler_init(SCALER_TYPE_POINT);
+}
+
+static bool scaler_bilinear_init(void)
+{
+   return scaler_init(SCALER_TYPE_BILINEAR);
+}
+
+static void scaler_deinit(void)
+{
+   scaler_ctx_gen_reset(&scaler);
+   frame_deinit();
+}
+
+static void scaler_run(void)
+{
+   scaler_ctx_scale(&scaler, frame_out, frame_argb);
+}
+
+/* fifo_buffer */
+
+static fifo_buffer_t *fifo;
+static uint8_t fifo_chunk[BENCH_FIFO_CHUNK];
+
+static bool fifo_init(void)
+{
+   memset(fifo_chunk, 0x5a, sizeof(fifo_chunk));
+   fifo = fifo_new(BENCH_FIFO_SIZE);
+   return fifo != NULL;
+}
+
+static void fifo_deinit(void)
+{
+   fifo_free(fifo);
+   fifo = NULL;
+}
+
+/* Fills the buffer, then drains it, with chunks the size of
+ * audio driver writes. */
+static void fifo_run(void)
+{
+   while (fifo_write_avail(fifo) >= BENCH_FIFO_CHUNK)
+      fifo_write(fifo, fifo_chunk, BENCH_FIFO_CHUNK);
+   while (fifo_read_avail(fifo) >= BENCH_FIFO_CHUNK)
+      fifo_read(fifo, fifo_chunk, BENCH_FIFO_CHUNK);
+}
+
+/* config_file */
+
+static size_t config_size;
+
+static bool config_init(void)
+{
+   unsigned i;
+   long size;
+   FILE *file = fopen(config_path, "w");
+
+   if (!file)
+      return false;
+
+   for (i = 0; i < BENCH_CONFIG_ENTRIES; i++)
+   {
+      if (!(i % 50))
+         fprintf(file, "# Section %u\n", i / 50);
+      switch (i % 4)
+      {
+         case 0:
+            fprintf(file, "setting_bool_%u = \"%s\"\n", i,
+                  (i & 4) ? "true" : "false");
+            break;
+         case 1:
+            fprintf(file, "setting_int_%u = \"%u\"\n", i, i * 7);
+            break;
+         case 2:
+            fprintf(file, "setting_float_%u = \"%u.250000\"\n", i, i);
+            break;
+         default:
+            fprintf(file, "setting_path_%u = \"~/.config/retroarch/dir_%u/file_%u.cfg\"\n",
+                  i, i / 10, i);
+            break;
+      }
+   }
+
+   size = ftell(file);
+   fclose(file);
+   config_size = size > 0 ? size : 0;
+   return true;
+}
+
+static void config_run(void)
+{
+   config_file_t *conf = config_file_new(config_path);
+   if (conf)
+      config_file_free(conf);
+}
+
+/* string_split */
+
+static char *split_string;
+
+static bool split_init(void)
+{
+   unsigned i;
+   size_t len = 0;
+
+   split_string = (char*)malloc(BENCH_SPLIT_TOKENS * 16);
+   if (!split_string)
+      return false;
+
+   bench_seed = 0x9abcdef0;
+   for (i = 0; i < BENCH_SPLIT_TOKENS; i++)
+      len += sprintf(split_string + len, "%s%x", i ? "|" : "",
+            bench_random() & 0xffffff);
+   return true;
+}
+
+static void split_deinit(void)
+{
+   free(split_string);
+   split_string = NULL;
+}
+
+static void split_run(void)
+{
+   struct string_list *list = string_split(split_string, "|");
+   if (list)
+      string_list_free(list);
+}
+
+/* dir_list */
+
+static bool dir_init(void)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH + 32];
+
+   if (path_is_directory(tree_path))
+      return true;
+
+   if (!path_mkdir(tree_path))
+      return false;
+
+   for (i = 0; i < BENCH_DIR_FILES; i++)
+   {
+      FILE *file;
+      /* A quarter matches the extension filter. */
+      snprintf(path, sizeof(path), "%s/content_%05u.%s", tree_path, i,
+            (i & 3) ? "bin" : "png");
+      file = fopen(path, "w");
+      if (!file)
+         return false;
+      fclose(file);
+   }
+
+   return true;
+}
+
+static void dir_run(void)
+{
+   struct string_list *list = dir_list_new(tree_path, "png", false);
+   if (list)
+      dir_list_free(list);
+}
+
+static void dir_all_run(void)
+{
+   struct string_list *list = dir_list_new(tree_path, NULL, true);
+   if (list)
+      dir_list_free(list);
+}
+
+#define FRAME_BYTES (BENCH_WIDTH * BENCH_HEIGHT)
+#define PNG_BYTES (BENCH_PNG_SIZE * BENCH_PNG_SIZE * 4)
+
+static const struct bench benches[] = {
+   /* The encoder tries every filter on every row, so it is slow. */
+   { "rpng_encode", png_init, png_encode_run, png_deinit, 1, PNG_BYTES },
+   { "rpng_decode", png_init, png_decode_run, png_deinit, 20, PNG_BYTES },
+   { "pixconv_rgb565_argb8888", frame_init, pixconv_rgb565_argb8888_run,
+      frame_deinit, 200, FRAME_BYTES * 2 },
+   { "pixconv_0rgb1555_argb8888", frame_init, pixconv_0rgb1555_argb8888_run,
+      frame_deinit, 200, FRAME_BYTES * 2 },
+   { "pixconv_argb8888_0rgb1555", frame_init, pixconv_argb8888_0rgb1555_run,
+      frame_deinit, 200, FRAME_BYTES * 4 },
+   { "pixconv_argb8888_abgr8888", frame_init, pixconv_argb8888_abgr8888_run,
+      frame_deinit, 200, FRAME_BYTES * 4 },
+   { "scaler_point_2x", scaler_point_init, scaler_run, scaler_deinit,
+      50, FRAME_BYTES * 4 },
+   { "scaler_bilinear_2x", scaler_bilinear_init, scaler_run, scaler_deinit,
+      20, FRAME_BYTES * 4 },
+   { "fifo_buffer", fifo_init, fifo_run, fifo_deinit,
+      2000, 2 * (BENCH_FIFO_SIZE - BENCH_FIFO_CHUNK) },
+   { "config_file_new", config_init, config_run, NULL, 50, 0 },
+   { "string_split", split_init, split_run, split_deinit, 100, 0 },
+   { "dir_list_new", dir_init, dir_run, NULL, 20, 0 },
+   { "dir_list_new_all", dir_init, dir_all_run, NULL, 20, 0 },
+};
+
+static int bench_compare(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+   return (x > y) - (x < y);
+}
+
+static void bench_print(const struct bench *bench, bool first,
+      const uint64_t *ns)
+{
+   double median = (double)ns[BENCH_REPEATS / 2] / bench->iterations;
+   double fastest = (double)ns[0] / bench->iterations;
+   size_t bytes = bench->bytes;
+
+   /* Sizes only known once the input was made. */
+   if (!bytes && bench->init == config_init)
+      bytes = config_size;
+   else if (!bytes && bench->init == split_init)
+      bytes = strlen(split_string);
+
+   printf("%s    {\"name\": \"%s\", \"iterations\": %u, \"repeats\": %u, "
+         "\"ns_per_op\": %.0f, \"ns_per_op_min\": %.0f, \"mb_per_s\": %.1f}",
+         first ? "" : ",\n", bench->name, bench->iterations, BENCH_REPEATS,
+         median, fastest, bytes ? bytes * 1000.0 / median : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j, k;
+   bool first        = true;
+   /* An empty name runs everything, to pass a scratch directory. */
+   const char *only  = argc > 1 && *argv[1] ? argv[1] : NULL;
+   int ret           = 0;
+
+   snprintf(scratch_dir, sizeof(scratch_dir), "%s",
+         argc > 2 ? argv[2] : "common_bench_data");
+   if (!path_is_directory(scratch_dir) && !path_mkdir(scratch_dir))
+   {
+      fprintf(stderr, "Cannot create %s.\n", scratch_dir);
+      return 1;
+   }
+
+   fill_pathname_join(png_path, scratch_dir, "bench.png", sizeof(png_path));
+   fill_pathname_join(config_path, scratch_dir, "bench.cfg", sizeof(config_path));
+   fill_pathname_join(tree_path, scratch_dir, "tree", sizeof(tree_path));
+
+   printf("{\n  \"benchmarks\": [\n");
+
+   for (i = 0; i < ARRAY_SIZE(benches); i++)
+   {
+      uint64_t ns[BENCH_REPEATS];
+      const struct bench *bench = &benches[i];
+
+      if (only && strcmp(only, bench->name))
+         continue;
+
+      if (bench->init && !bench->init())
+      {
+         fprintf(stderr, "Failed to set up %s.\n", bench->name);
+         ret = 1;
+         continue;
+      }
+
+      /* Warms up caches and the allocator. */
+      bench->run();
+
+      for (j = 0; j < BENCH_REPEATS; j++)
+      {
+         uint64_t start = bench_time_ns();
+         for (k = 0; k < bench->iterations; k++)
+            bench->run();
+         ns[j] = bench_time_ns() - start;
+      }
+
+      qsort(ns, BENCH_REPEATS, sizeof(ns[0]), bench_compare);
+      bench_print(bench, first, ns);
+      first = false;
+
+      if (bench->deinit)
+         bench->deinit();
+   }
+
+   printf("\n  ]\n}\n");
+   return ret;
+}
@@ -30,8 +30,8 @@
 #include <compat/posix_string.h>
 #include <compat/msvc.h>
 #include <file/file_path.h>
+#include <memory/ralloc.h>
 #include <retro_miscellaneous.h>
-#include <string/string_list.h>
 
 #if !defined(_WIN32) && !defined(__CELLOS_LV2__) && !defined(_XBOX)
 #include <sys/param.h> /* PATH_MAX */
@@ -48,38 +48,220 @@
 static config_file_t *config_file_new_internal(const char *path, unsigned depth);
 void config_file_free(config_file_t *conf);
 
-static char *getaline(FILE *file)
+/* Every key maps to the first entry holding it, which is what
+ * the getters return, and to the first entry that isn't from an
+ * #include, which is what the setters overwrite. Both are found
+ * in list order, so the index gives the same answers as walking
+ * the list. */
+struct config_index_slot
 {
-   char* newline = (char*)malloc(9);
-   char* newline_tmp = NULL;
-   size_t cur_size = 8;
-   size_t idx = 0;
-   int in = getc(file);
+   uint32_t hash;
+   struct config_entry_list *first;
+   struct config_entry_list *writable;
+};
 
-   if (!newline)
-      return NULL;
+static uint32_t config_index_hash(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (unsigned char)*key++;
+
+   return hash;
+}
 
-   while (in != EOF && in != '\n')
+static struct config_index_slot *config_index_slot_find(
+      struct config_index_slot *index, size_t size,
+      uint32_t hash, const char *key)
+{
+   size_t mask = size - 1;
+   size_t i    = hash & mask;
+
+   /* Linear probing, the table is never more than half full. */
+   while (index[i].first)
    {
-      if (idx == cur_size)
-      {
-         cur_size *= 2;
-         newline_tmp = (char*)realloc(newline, cur_size + 1);
+      if (index[i].hash == hash && !strcmp(index[i].first->key, key))
+         break;
+      i = (i + 1) & mask;
+   }
+
+   return &index[i];
+}
+
+static bool config_index_grow(config_file_t *conf)
+{
+   size_t i;
+   size_t size = conf->index_size ? conf->index_size * 2 : 64;
+   struct config_index_slot *index = (struct config_index_slot*)
+      ralloc_calloc(RALLOC_TAG_CONFIG, size, sizeof(*index));
+
+   if (!index)
+      return false;
+
+   for (i = 0; i < conf->index_size; i++)
+   {
+      struct config_index_slot *slot = &conf->index[i];
+
+      if (slot->first)
+         *config_index_slot_find(index, size, slot->hash,
+               slot->first->key) = *slot;
+   }
+
+   ralloc_free(conf->index);
+   conf->index      = index;
+   conf->index_size = size;
+   return true;
+}
+
+/* Indexes an entry appended to the end of the list. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   uint32_t hash;
+   struct config_index_slot *slot = NULL;
+
+   if (conf->index_dirty)
+      return;
+
+   if ((conf->index_count + 1) * 2 > conf->index_size
+         && !config_index_grow(conf))
+   {
+      conf->index_dirty = true;
+      return;
+   }
+
+   hash = config_index_hash(entry->key);
+   slot = config_index_slot_find(conf->index, conf->index_size,
+         hash, entry->key);
+
+   if (!slot->first)
+   {
+      slot->hash  = hash;
+      slot->first = entry;
+      conf->index_count++;
+   }
+
+   if (!slot->writable && !entry->readonly)
+      slot->writable = entry;
+}
+
+static void config_index_rebuild(config_file_t *conf)
+{
+   struct config_entry_list *list = conf->entries;
+
+   if (conf->index)
+      memset(conf->index, 0, conf->index_size * sizeof(*conf->index));
+   conf->index_count = 0;
+   conf->index_dirty = false;
+
+   while (list)
+   {
+      config_index_add(conf, list);
+      list = list->next;
+   }
+}
 
-         if (!newline_tmp)
+/**
+ * config_index_lookup:
+ * @conf                : Config file.
+ * @key                 : Key to look up.
+ * @writable            : If non-NULL, set to the first entry of @key
+ *                        that isn't from an #include, if any.
+ *
+ * Returns: first entry of @key, or NULL if there is none.
+ **/
+static struct config_entry_list *config_index_lookup(
+      config_file_t *conf, const char *key,
+      struct config_entry_list **writable)
+{
+   struct config_index_slot *slot = NULL;
+
+   if (conf->index_dirty)
+      config_index_rebuild(conf);
+
+   /* Failing to allocate the index leaves it dirty. */
+   if (conf->index_dirty)
+   {
+      struct config_entry_list *first = NULL;
+      struct config_entry_list *list  = conf->entries;
+
+      if (writable)
+         *writable = NULL;
+
+      for (; list; list = list->next)
+      {
+         if (strcmp(key, list->key))
+            continue;
+         if (!first)
+            first = list;
+         if (!list->readonly)
          {
-            free(newline);
-            return NULL;
+            if (writable)
+               *writable = list;
+            break;
          }
-
-         newline = newline_tmp;
       }
 
-      newline[idx++] = in;
-      in = getc(file);
+      return first;
+   }
+
+   if (!conf->index)
+   {
+      if (writable)
+         *writable = NULL;
+      return NULL;
    }
-   newline[idx] = '\0';
-   return newline; 
+
+   slot = config_index_slot_find(conf->index, conf->index_size,
+         config_index_hash(key), key);
+
+   if (writable)
+      *writable = slot->writable;
+   return slot->first;
+}
+
+static struct config_entry_list *config_get_entry(
+      config_file_t *conf, const char *key)
+{
+   return config_index_lookup(conf, key, NULL);
+}
+
+/**
+ * config_file_read:
+ * @path                : Path of the config file.
+ * @size                : Set to the size of the file.
+ *
+ * Reads a whole config file in one go.
+ *
+ * Returns: NUL-terminated contents of the file, or NULL
+ * on error. Needs to be freed manually.
+ **/
+static char *config_file_read(const char *path, size_t *size)
+{
+   long len;
+   char *buf  = NULL;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   if (fseek(file, 0, SEEK_END) != 0)
+      goto end;
+   if ((len = ftell(file)) < 0)
+      goto end;
+   if (fseek(file, 0, SEEK_SET) != 0)
+      goto end;
+
+   buf = (char*)ralloc_malloc(RALLOC_TAG_CONFIG, len + 1);
+   if (!buf)
+      goto end;
+
+   *size      = fread(buf, 1, len, file);
+   buf[*size] = '\0';
+
+end:
+   fclose(file);
+   return buf;
 }
 
 static char *extract_value(char *line, bool is_value)
@@ -109,16 +291,29 @@ static char *extract_value(char *line, bool is_value)
       tok = strtok_r(line, "\"", &save);
       if (!tok)
          return NULL;
-      return strdup(tok);
+      return tok;
    }
    else if (*line == '\0') /* Nothing */
       return NULL;
 
    /* We don't have that. Read until next space. */
-   tok = strtok_r(line, " \n\t\f\r\v", &save);
-   if (tok)
-      return strdup(tok);
-   return NULL;
+   return strtok_r(line, " \n\t\f\r\v", &save);
+}
+
+/* Hands the buffers the entries of @child point into over to @parent. */
+static void move_buffer_list(config_file_t *parent, config_file_t *child)
+{
+   struct config_buffer_list *head = child->buffers;
+
+   if (!head)
+      return;
+
+   while (head->next)
+      head = head->next;
+
+   head->next      = parent->buffers;
+   parent->buffers = child->buffers;
+   child->buffers  = NULL;
 }
 
 static void set_list_readonly(struct config_entry_list *list)
@@ -148,7 +343,10 @@ static void add_child_list(config_file_t *parent, config_file_t *child)
       parent->entries = child->entries;
    }
 
-   child->entries = NULL;
+   child->entries     = NULL;
+   parent->index_dirty = true;
+
+   move_buffer_list(parent, child);
 
    /* Rebase tail. */
    if (parent->entries)
@@ -167,12 +365,13 @@ static void add_child_list(config_file_t *parent, config_file_t *child)
 static void add_include_list(config_file_t *conf, const char *path)
 {
    struct config_include_list *head = conf->includes;
-   struct config_include_list *node = (struct config_include_list*)calloc(1, sizeof(*node));
+   struct config_include_list *node = (struct config_include_list*)
+      ralloc_calloc(RALLOC_TAG_CONFIG, 1, sizeof(*node));
 
    if (!node)
       return;
 
-   node->path = strdup(path);
+   node->path = ralloc_strdup(RALLOC_TAG_CONFIG, path);
 
    if (head)
    {
@@ -215,15 +414,11 @@ static void add_sub_conf(config_file_t *conf, char *line)
    sub_conf = (config_file_t*)
       config_file_new_internal(real_path, conf->include_depth + 1);
    if (!sub_conf)
-   {
-      free(path);
       return;
-   }
 
    /* Pilfer internal list. */
    add_child_list(conf, sub_conf);
    config_file_free(sub_conf);
-   free(path);
 }
 
 static char *strip_comment(char *str)
@@ -268,20 +463,11 @@ static char *strip_comment(char *str)
 static bool parse_line(config_file_t *conf,
       struct config_entry_list *list, char *line)
 {
-   char* comment = NULL;
-   char* key = (char*)malloc(9);
-   char* key_tmp = NULL;
-   size_t cur_size = 8;
-   size_t idx = 0;
-
-   if (!key)
-      return false;
+   char *comment = NULL;
+   char *key     = NULL;
 
    if (!line || !*line)
-   {
-      free(key);
       return false;
-   }
 
    comment = strip_comment(line);
 
@@ -292,7 +478,6 @@ static bool parse_line(config_file_t *conf,
       if (strstr(comment, "include ") == comment)
       {
          add_sub_conf(conf, comment + strlen("include "));
-         free(key);
          return false;
       }
    }
@@ -305,35 +490,90 @@ static bool parse_line(config_file_t *conf,
    while (isspace(*line))
       line++;
 
+   key = line;
    while (isgraph(*line))
-   {
-      if (idx == cur_size)
-      {
-         cur_size *= 2;
-         key_tmp = (char*)realloc(key, cur_size + 1);
-
-         if (!key_tmp)
-         {
-            free(key);
-            return false;
-         }
-
-         key = key_tmp;
-      }
+      line++;
 
-      key[idx++] = *line++;
+   /* Terminate the key in place. Anything but whitespace
+    * between key and value makes for an invalid line. */
+   if (*line)
+   {
+      if (!isspace(*line))
+         return false;
+      *line++ = '\0';
    }
-   key[idx] = '\0';
-   list->key = key;
 
    list->value = extract_value(line, true);
    if (!list->value)
+      return false;
+
+   list->key             = key;
+   list->key_in_buffer   = true;
+   list->value_in_buffer = true;
+   return true;
+}
+
+/**
+ * config_file_parse:
+ * @conf                : Config file to add the entries to.
+ * @buf                 : NUL-terminated contents of the file.
+ *                        Taken over by @conf.
+ * @size                : Size of @buf.
+ *
+ * Splits @buf into lines and parses them in place, keys and
+ * values of the entries pointing into @buf.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool config_file_parse(config_file_t *conf, char *buf, size_t size)
+{
+   char *line = buf;
+   char *end  = buf + size;
+   struct config_buffer_list *node = (struct config_buffer_list*)
+      ralloc_calloc(RALLOC_TAG_CONFIG, 1, sizeof(*node));
+
+   if (!node)
    {
-      list->key = NULL;
-      free(key);
+      ralloc_free(buf);
       return false;
    }
 
+   node->data    = buf;
+   node->next    = conf->buffers;
+   conf->buffers = node;
+
+   while (line < end)
+   {
+      struct config_entry_list entry = {0};
+      char *next = (char*)memchr(line, '\n', end - line);
+
+      if (next)
+         *next++ = '\0';
+      else
+         next = end;
+
+      if (parse_line(conf, &entry, line))
+      {
+         struct config_entry_list *list = (struct config_entry_list*)
+            ralloc_malloc(RALLOC_TAG_CONFIG, sizeof(*list));
+
+         if (!list)
+            return false;
+
+         *list = entry;
+
+         if (conf->entries)
+            conf->tail->next = list;
+         else
+            conf->entries = list;
+
+         conf->tail        = list;
+         conf->index_dirty = true;
+      }
+
+      line = next;
+   }
+
    return true;
 }
 
@@ -348,8 +588,14 @@ bool config_append_file(config_file_t *conf, const char *path)
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+
+      if (!conf->tail)
+         conf->tail        = new_conf->tail;
+      conf->index_dirty    = true;
    }
 
+   move_buffer_list(conf, new_conf);
+
    config_file_free(new_conf);
    return true;
 }
@@ -357,74 +603,47 @@ bool config_append_file(config_file_t *conf, const char *path)
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth)
 {
-   FILE *file = NULL;
-   struct config_file *conf = (struct config_file*)calloc(1, sizeof(*conf));
+   size_t size = 0;
+   char *buf   = NULL;
+   struct config_file *conf = (struct config_file*)
+      ralloc_calloc(RALLOC_TAG_CONFIG, 1, sizeof(*conf));
    if (!conf)
       return NULL;
 
    if (!path)
       return conf;
 
-   conf->path = strdup(path);
+   conf->path = ralloc_strdup(RALLOC_TAG_CONFIG, path);
    if (!conf->path)
    {
-      free(conf);
+      ralloc_free(conf);
       return NULL;
    }
 
    conf->include_depth = depth;
-   file = fopen(path, "r");
+   buf = config_file_read(path, &size);
 
-   if (!file)
+   if (!buf)
    {
-      free(conf->path);
-      free(conf);
+      ralloc_free(conf->path);
+      ralloc_free(conf);
       return NULL;
    }
 
-   while (!feof(file))
+   if (!config_file_parse(conf, buf, size))
    {
-      struct config_entry_list *list = (struct config_entry_list*)
-         calloc(1, sizeof(*list));
-      char *line = NULL;
-
-      if (!list)
-      {
-         config_file_free(conf);
-         fclose(file);
-         return NULL;
-      }
-
-      line = getaline(file);
-
-      if (line)
-      {
-         if (parse_line(conf, list, line))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries = list;
-
-            conf->tail = list;
-         }
-
-         free(line);
-      }
-
-      if (list != conf->tail)
-         free(list);
+      config_file_free(conf);
+      return NULL;
    }
-   fclose(file);
 
    return conf;
 }
 
 config_file_t *config_file_new_from_string(const char *from_string)
 {
-   size_t i;
-   struct string_list *lines = NULL;
-   struct config_file *conf = (struct config_file*)calloc(1, sizeof(*conf));
+   char *buf = NULL;
+   struct config_file *conf = (struct config_file*)
+      ralloc_calloc(RALLOC_TAG_CONFIG, 1, sizeof(*conf));
    if (!conf)
       return NULL;
 
@@ -433,43 +652,17 @@ config_file_t *config_file_new_from_string(const char *from_string)
 
    conf->path = NULL;
    conf->include_depth = 0;
-   
-   lines = string_split(from_string, "\n");
-   if (!lines)
+
+   buf = ralloc_strdup(RALLOC_TAG_CONFIG, from_string);
+   if (!buf)
       return conf;
 
-   for (i = 0; i < lines->size; i++)
+   if (!config_file_parse(conf, buf, strlen(buf)))
    {
-      struct config_entry_list *list = (struct config_entry_list*)
-         calloc(1, sizeof(*list));
-      char* line = lines->elems[i].data;
-
-      if (!list)
-      {
-         string_list_free(lines);
-         config_file_free(conf);
-         return NULL;
-      }
-
-      if (line)
-      {
-         if (parse_line(conf, list, line))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries = list;
-
-            conf->tail = list;
-         }
-      }
-
-      if (list != conf->tail)
-         free(list);
+      config_file_free(conf);
+      return NULL;
    }
 
-   string_list_free(lines);
-
    return conf;
 }
 
@@ -489,199 +682,166 @@ void config_file_free(config_file_t *conf)
    while (tmp)
    {
       struct config_entry_list *hold = NULL;
-      free(tmp->key);
-      free(tmp->value);
+      if (!tmp->key_in_buffer)
+         ralloc_free(tmp->key);
+      if (!tmp->value_in_buffer)
+         ralloc_free(tmp->value);
       hold = tmp;
       tmp = tmp->next;
-      free(hold);
+      ralloc_free(hold);
    }
 
    inc_tmp = (struct config_include_list*)conf->includes;
    while (inc_tmp)
    {
       struct config_include_list *hold = NULL;
-      free(inc_tmp->path);
+      ralloc_free(inc_tmp->path);
       hold = (struct config_include_list*)inc_tmp;
       inc_tmp = inc_tmp->next;
-      free(hold);
+      ralloc_free(hold);
    }
 
-   free(conf->path);
-   free(conf);
+   while (conf->buffers)
+   {
+      struct config_buffer_list *hold = conf->buffers;
+      conf->buffers = hold->next;
+      ralloc_free(hold->data);
+      ralloc_free(hold);
+   }
+
+   ralloc_free(conf->index);
+   ralloc_free(conf->path);
+   ralloc_free(conf);
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         *in = strtod(list->value, NULL);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   *in = strtod(entry->value, NULL);
+   return true;
 }
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         /* strtof() is C99/POSIX. Just use the more portable kind. */
-         *in = (float)strtod(list->value, NULL);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   /* strtof() is C99/POSIX. Just use the more portable kind. */
+   *in = (float)strtod(entry->value, NULL);
+   return true;
 }
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   struct config_entry_list *list = conf->entries;
+   int val;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
+   if (!entry)
+      return false;
+
+   errno = 0;
+   val = strtol(entry->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         int val;
-         errno = 0;
-         val = strtol(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   struct config_entry_list *list = conf->entries;
+   uint64_t val;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
+   if (!entry)
+      return false;
+
+   errno = 0;
+   val = strtoull(entry->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         uint64_t val;
-         errno = 0;
-         val = strtoull(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   struct config_entry_list *list = conf->entries;
+   unsigned val;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list != NULL)
+   if (!entry)
+      return false;
+
+   errno = 0;
+   val = strtoul(entry->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         unsigned val;
-         errno = 0;
-         val = strtoul(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
-
    return false;
 }
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   struct config_entry_list *list = conf->entries;
+   unsigned val;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
+   if (!entry)
+      return false;
+
+   errno = 0;
+   val = strtoul(entry->value, NULL, 16);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         unsigned val;
-         errno = 0;
-         val = strtoul(list->value, NULL, 16);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         if (list->value[0] && list->value[1])
-            return false;
-         *in = *list->value;
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   if (entry->value[0] && entry->value[1])
+      return false;
+   *in = *entry->value;
+   return true;
 }
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         *str = strdup(list->value);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   *str = strdup(entry->value);
+   return true;
 }
 
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-         return strlcpy(buf, list->value, size) < size;
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   return strlcpy(buf, entry->value, size) < size;
 }
 
 bool config_get_path(config_file_t *conf, const char *key,
@@ -690,77 +850,68 @@ bool config_get_path(config_file_t *conf, const char *key,
 #if defined(RARCH_CONSOLE)
    return config_get_array(conf, key, buf, size);
 #else
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         fill_pathname_expand_special(buf, list->value, size);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!entry)
+      return false;
+
+   fill_pathname_expand_special(buf, entry->value, size);
+   return true;
 #endif
 }
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   struct config_entry_list *list = conf->entries;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         if (strcasecmp(list->value, "true") == 0)
-            *in = true;
-         else if (strcasecmp(list->value, "1") == 0)
-            *in = true;
-         else if (strcasecmp(list->value, "false") == 0)
-            *in = false;
-         else if (strcasecmp(list->value, "0") == 0)
-            *in = false;
-         else
-            return false;
+   if (!entry)
+      return false;
 
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (strcasecmp(entry->value, "true") == 0)
+      *in = true;
+   else if (strcasecmp(entry->value, "1") == 0)
+      *in = true;
+   else if (strcasecmp(entry->value, "false") == 0)
+      *in = false;
+   else if (strcasecmp(entry->value, "0") == 0)
+      *in = false;
+   else
+      return false;
+
+   return true;
 }
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *elem = NULL;
-   struct config_entry_list *list = conf->entries;
-   struct config_entry_list *last = list;
-   while (list)
-   {
-      if (!list->readonly && (strcmp(key, list->key) == 0))
-      {
-         free(list->value);
-         list->value = strdup(val);
-         return;
-      }
+   struct config_entry_list *elem     = NULL;
+   struct config_entry_list *writable = NULL;
 
-      last = list;
-      list = list->next;
+   config_index_lookup(conf, key, &writable);
+
+   if (writable)
+   {
+      if (!writable->value_in_buffer)
+         ralloc_free(writable->value);
+      writable->value           = ralloc_strdup(RALLOC_TAG_CONFIG, val);
+      writable->value_in_buffer = false;
+      return;
    }
 
-   elem = (struct config_entry_list*)calloc(1, sizeof(*elem));
+   elem = (struct config_entry_list*)ralloc_calloc(RALLOC_TAG_CONFIG, 1, sizeof(*elem));
 
    if (!elem)
       return;
 
-   elem->key = strdup(key);
-   elem->value = strdup(val);
+   elem->key = ralloc_strdup(RALLOC_TAG_CONFIG, key);
+   elem->value = ralloc_strdup(RALLOC_TAG_CONFIG, val);
 
-   if (last)
-      last->next = elem;
+   if (conf->tail)
+      conf->tail->next = elem;
    else
       conf->entries = elem;
+   conf->tail = elem;
+
+   config_index_add(conf, elem);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -871,16 +1022,7 @@ void config_file_dump(config_file_t *conf, FILE *file)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (strcmp(entry, list->key) == 0)
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
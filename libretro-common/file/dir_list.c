@@ -45,6 +45,8 @@
 #include <unistd.h>
 #endif
 
+#include <stdlib.h>
+
 #include <retro_miscellaneous.h>
 
 static int qstrcmp_plain(const void *a_, const void *b_)
@@ -190,112 +192,195 @@ static int parse_dir_entry(const char *name, char *file_path,
    return 0;
 }
 
+struct dir_list_reader
+{
+   char dir[PATH_MAX_LENGTH];
+   struct string_list *ext_list;
+   bool include_dirs;
+#ifdef _WIN32
+   WIN32_FIND_DATA ffd;
+   HANDLE hFind;
+   bool has_entry;
+#else
+   DIR *directory;
+#endif
+};
+
 /**
- * dir_list_new:
+ * dir_list_reader_new:
  * @dir          : directory path.
  * @ext          : allowed extensions of file directory entries to include.
  * @include_dirs : include directories as part of the finished directory listing?
  *
- * Create a directory listing.
+ * Opens a directory for reading its listing a few entries at a time
+ * with dir_list_reader_iterate().
  *
- * Returns: pointer to a directory listing of type 'struct string_list *' on success,
- * NULL in case of error. Has to be freed manually.
+ * Returns: pointer to a directory reader on success, NULL in case of
+ * error. Has to be freed with dir_list_reader_free().
  **/
-struct string_list *dir_list_new(const char *dir,
+struct dir_list_reader *dir_list_reader_new(const char *dir,
       const char *ext, bool include_dirs)
 {
-   char path_buf[PATH_MAX_LENGTH];
-   struct string_list *ext_list, *list;
 #ifdef _WIN32
-   WIN32_FIND_DATA ffd;
-   HANDLE hFind = INVALID_HANDLE_VALUE;
-#else
-   DIR *directory = NULL;
-   const struct dirent *entry = NULL;
+   char path_buf[PATH_MAX_LENGTH];
 #endif
+   struct dir_list_reader *reader = (struct dir_list_reader*)
+      calloc(1, sizeof(*reader));
 
-   ext_list = NULL;
-   (void)path_buf;
-
-   if (!(list = string_list_new()))
+   if (!reader)
       return NULL;
 
+   strlcpy(reader->dir, dir, sizeof(reader->dir));
+   reader->include_dirs = include_dirs;
+
    if (ext)
-      ext_list = string_split(ext, "|");
+      reader->ext_list = string_split(ext, "|");
 
 #ifdef _WIN32
    snprintf(path_buf, sizeof(path_buf), "%s\\*", dir);
 
-   hFind = FindFirstFile(path_buf, &ffd);
-   if (hFind == INVALID_HANDLE_VALUE)
+   reader->hFind     = FindFirstFile(path_buf, &reader->ffd);
+   reader->has_entry = true;
+   if (reader->hFind == INVALID_HANDLE_VALUE)
       goto error;
+#else
+   reader->directory = opendir(dir);
+   if (!reader->directory)
+      goto error;
+#endif
 
-   do
+   return reader;
+
+error:
+   dir_list_reader_free(reader);
+   return NULL;
+}
+
+/**
+ * dir_list_reader_iterate:
+ * @reader       : pointer to the directory reader.
+ * @list         : pointer to the directory listing entries are appended to.
+ * @max_entries  : most directory entries to read in this call.
+ *
+ * Reads up to @max_entries further entries of the directory and appends
+ * the ones that pass the filters of dir_list_reader_new() to @list.
+ *
+ * Returns: 1 if there are entries left to read, 0 once the whole
+ * directory has been read, -1 on error.
+ **/
+int dir_list_reader_iterate(struct dir_list_reader *reader,
+      struct string_list *list, size_t max_entries)
+{
+   size_t i;
+
+   if (!reader || !list)
+      return -1;
+
+   for (i = 0; i < max_entries; i++)
    {
       int ret = 0;
       char file_path[PATH_MAX_LENGTH];
-      const char *name        = ffd.cFileName;
+#ifdef _WIN32
+      const char *name        = reader->ffd.cFileName;
       const char *file_ext    = path_get_extension(name);
-      bool is_dir             = ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+      bool is_dir             = reader->ffd.dwFileAttributes
+         & FILE_ATTRIBUTE_DIRECTORY;
 
-      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+      if (!reader->has_entry)
+         return 0;
 
-      ret = parse_dir_entry(name, file_path, is_dir,
-            include_dirs, list, ext_list, file_ext);
-
-      if (ret == -1)
-         goto error;
+      fill_pathname_join(file_path, reader->dir, name, sizeof(file_path));
 
-      if (ret == 1)
-         continue;
-   }while (FindNextFile(hFind, &ffd) != 0);
-
-   FindClose(hFind);
-   string_list_free(ext_list);
-   return list;
+      ret = parse_dir_entry(name, file_path, is_dir,
+            reader->include_dirs, list, reader->ext_list, file_ext);
 
-error:
-   if (hFind != INVALID_HANDLE_VALUE)
-      FindClose(hFind);
+      reader->has_entry = FindNextFile(reader->hFind, &reader->ffd) != 0;
 #else
-   directory = opendir(dir);
-   if (!directory)
-      goto error;
+      const char *name     = NULL;
+      const char *file_ext = NULL;
+      bool is_dir          = false;
+      const struct dirent *entry = readdir(reader->directory);
 
-   while ((entry = readdir(directory)))
-   {
-      int ret = 0;
-      char file_path[PATH_MAX_LENGTH];
-      const char *name     = entry->d_name;
-      const char *file_ext = path_get_extension(name);
-      bool is_dir = false;
+      if (!entry)
+         return 0;
 
-      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+      name     = entry->d_name;
+      file_ext = path_get_extension(name);
+
+      fill_pathname_join(file_path, reader->dir, name, sizeof(file_path));
 
       is_dir = dirent_is_directory(file_path, entry);
 
       ret = parse_dir_entry(name, file_path, is_dir,
-            include_dirs, list, ext_list, file_ext);
+            reader->include_dirs, list, reader->ext_list, file_ext);
+#endif
 
       if (ret == -1)
-         goto error;
-
-      if (ret == 1)
-         continue;
+         return -1;
    }
 
-   closedir(directory);
+   return 1;
+}
 
-   string_list_free(ext_list);
-   return list;
+/**
+ * dir_list_reader_free:
+ * @reader       : pointer to the directory reader.
+ *
+ * Closes the directory and frees the reader.
+ **/
+void dir_list_reader_free(struct dir_list_reader *reader)
+{
+   if (!reader)
+      return;
 
-error:
+#ifdef _WIN32
+   if (reader->hFind != INVALID_HANDLE_VALUE)
+      FindClose(reader->hFind);
+#else
+   if (reader->directory)
+      closedir(reader->directory);
+#endif
 
-   if (directory)
-      closedir(directory);
+   string_list_free(reader->ext_list);
+   free(reader);
+}
 
-#endif
+/**
+ * dir_list_new:
+ * @dir          : directory path.
+ * @ext          : allowed extensions of file directory entries to include.
+ * @include_dirs : include directories as part of the finished directory listing?
+ *
+ * Create a directory listing.
+ *
+ * Returns: pointer to a directory listing of type 'struct string_list *' on success,
+ * NULL in case of error. Has to be freed manually.
+ **/
+struct string_list *dir_list_new(const char *dir,
+      const char *ext, bool include_dirs)
+{
+   int ret                        = 1;
+   struct string_list *list       = NULL;
+   struct dir_list_reader *reader = dir_list_reader_new(dir,
+         ext, include_dirs);
+
+   if (!reader)
+      return NULL;
+
+   if (!(list = string_list_new()))
+      goto error;
+
+   while (ret == 1)
+      ret = dir_list_reader_iterate(reader, list, 256);
+
+   if (ret == -1)
+      goto error;
+
+   dir_list_reader_free(reader);
+   return list;
+
+error:
+   dir_list_reader_free(reader);
    string_list_free(list);
-   string_list_free(ext_list);
    return NULL;
 }
@@ -314,6 +314,15 @@ void zlib_deflate_init(void *data, int level)
       deflateInit(stream, level);
 }
 
+void zlib_deflate_init2(void *data, int level)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (stream)
+      deflateInit2(stream, level, Z_DEFLATED, -MAX_WBITS,
+            8, Z_DEFAULT_STRATEGY);
+}
+
 bool zlib_inflate_init(void *data)
 {
    z_stream *stream = (z_stream*)data;
@@ -398,6 +407,19 @@ int zlib_deflate_data_to_file(void *data)
    return 0;
 }
 
+bool zlib_deflate_data_flush(void *data)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return false;
+
+   /* Out of space if the flush could not complete. */
+   if (deflate(stream, Z_SYNC_FLUSH) != Z_OK)
+      return false;
+   return !stream->avail_in && stream->avail_out;
+}
+
 int zlib_inflate_data_to_file_iterate(void *data)
 {
    int zstatus;
@@ -422,6 +444,17 @@ uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length)
    return crc32(0, data, length);
 }
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length)
+{
+   return adler32(adler32(0, NULL, 0), data, length);
+}
+
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2)
+{
+   return adler32_combine(adler1, adler2, length2);
+}
+
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data)
 {
    /* zlib and nall have different assumptions on "sign" for this 
@@ -580,6 +613,96 @@ end:
    return ret;
 }
 
+/* Longest end of central directory record, with its comment. */
+#define ZIP_FOOTER_MAX_SIZE (22 + 0xffff)
+
+/**
+ * zlib_parse_file_crc:
+ * @file                        : filename path of archive
+ * @crc_cb                      : called for each file in the archive.
+ * @userdata                    : userdata to pass to crc_cb function pointer.
+ *
+ * Enumerates the CRC32 of every file in the archive from its central
+ * directory. Only the directory is read, a few bytes at a time, so
+ * memory use does not depend on the size of the archive.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_parse_file_crc(const char *file, zlib_crc_cb crc_cb,
+      void *userdata)
+{
+   long zip_size, footer_size, i;
+   uint32_t entries, offset;
+   uint8_t *footer = NULL;
+   bool ret        = true;
+   FILE *zip       = fopen(file, "rb");
+
+   if (!zip)
+      GOTO_END_ERROR();
+
+   if (fseek(zip, 0, SEEK_END) != 0)
+      GOTO_END_ERROR();
+
+   zip_size = ftell(zip);
+   if (zip_size < 22)
+      GOTO_END_ERROR();
+
+   footer_size = zip_size < ZIP_FOOTER_MAX_SIZE ? zip_size : ZIP_FOOTER_MAX_SIZE;
+   footer      = (uint8_t*)malloc(footer_size);
+
+   if (!footer || fseek(zip, zip_size - footer_size, SEEK_SET) != 0
+         || fread(footer, 1, footer_size, zip) != (size_t)footer_size)
+      GOTO_END_ERROR();
+
+   for (i = footer_size - 22; ; i--)
+   {
+      if (i < 0)
+         GOTO_END_ERROR();
+      if (read_le(footer + i, 4) == END_OF_CENTRAL_DIR_SIGNATURE
+            && i + 22 + read_le(footer + i + 20, 2) == footer_size)
+         break;
+   }
+
+   entries = read_le(footer + i + 10, 2);
+   offset  = read_le(footer + i + 16, 4);
+
+   if (fseek(zip, offset, SEEK_SET) != 0)
+      GOTO_END_ERROR();
+
+   while (entries--)
+   {
+      uint8_t header[46];
+      unsigned namelength, skip;
+      char filename[PATH_MAX_LENGTH] = {0};
+
+      if (fread(header, 1, sizeof(header), zip) != sizeof(header)
+            || read_le(header, 4) != CENTRAL_FILE_HEADER_SIGNATURE)
+         GOTO_END_ERROR();
+
+      namelength = read_le(header + 28, 2);
+      skip       = read_le(header + 30, 2) + read_le(header + 32, 2);
+
+      if (namelength >= PATH_MAX_LENGTH
+            || fread(filename, 1, namelength, zip) != namelength
+            || fseek(zip, skip, SEEK_CUR) != 0)
+         GOTO_END_ERROR();
+
+      /* Directories have a trailing slash and nothing to hash. */
+      if (namelength && filename[namelength - 1] == '/')
+         continue;
+
+      if (!crc_cb(filename, read_le(header + 24, 4),
+               read_le(header + 16, 4), userdata))
+         break;
+   }
+
+end:
+   free(footer);
+   if (zip)
+      fclose(zip);
+   return ret;
+}
+
 struct zip_extract_userdata
 {
    char *zip_path;
@@ -587,6 +710,9 @@ struct zip_extract_userdata
    size_t zip_path_size;
    struct string_list *ext;
    bool found_content;
+   /* Extract to memory rather than to a file if set. */
+   void **buf;
+   size_t *size;
 };
 
 enum
@@ -595,6 +721,58 @@ enum
    ZLIB_MODE_DEFLATE      = 8,
 } zlib_compression_mode;
 
+static int zip_extract_to_memory(const char *name, const uint8_t *cdata,
+      unsigned cmode, uint32_t csize, uint32_t size,
+      struct zip_extract_userdata *data)
+{
+   uint8_t *buf = (uint8_t*)malloc(size + 1);
+
+   if (!buf)
+      return 0;
+
+   switch (cmode)
+   {
+      case ZLIB_MODE_UNCOMPRESSED:
+         memcpy(buf, cdata, size);
+         break;
+      case ZLIB_MODE_DEFLATE:
+         {
+            int ret          = -1;
+            z_stream *stream = (z_stream*)zlib_stream_new();
+
+            if (stream && zlib_inflate_init2(stream))
+            {
+               zlib_set_stream(stream, csize, size, cdata, buf);
+
+               do{
+                  ret = zlib_inflate_data_to_file_iterate(stream);
+               }while(ret == 0);
+
+               zlib_stream_free(stream);
+            }
+            free(stream);
+
+            if (ret == 1)
+               break;
+         }
+         /* fall-through */
+      default:
+         free(buf);
+         return 0;
+   }
+
+   /* Allow for easy reading of strings, like read_file(). */
+   buf[size] = '\0';
+
+   *data->buf  = buf;
+   *data->size = size;
+
+   strlcat(data->zip_path, "#", data->zip_path_size);
+   strlcat(data->zip_path, name, data->zip_path_size);
+   data->found_content = true;
+   return 0;
+}
+
 static int zip_extract_cb(const char *name, const char *valid_exts,
       const uint8_t *cdata,
       unsigned cmode, uint32_t csize, uint32_t size,
@@ -609,6 +787,9 @@ static int zip_extract_cb(const char *name, const char *valid_exts,
    {
       char new_path[PATH_MAX_LENGTH];
 
+      if (data->buf)
+         return zip_extract_to_memory(name, cdata, cmode, csize, size, data);
+
       if (data->extraction_directory)
          fill_pathname_join(new_path, data->extraction_directory,
                path_basename(name), sizeof(new_path));
@@ -650,24 +831,10 @@ static int zip_extract_cb(const char *name, const char *valid_exts,
    return 1;
 }
 
-/**
- * zlib_extract_first_content_file:
- * @zip_path                    : filename path to ZIP archive.
- * @zip_path_size               : size of ZIP archive.
- * @valid_exts                  : valid extensions for a content file.
- * @extraction_directory        : the directory to extract temporary
- *                                unzipped content to.
- *
- * Extract first content file from archive.
- *
- * Returns : true (1) on success, otherwise false (0).
- **/
-bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
-      const char *valid_exts, const char *extraction_directory)
+static bool zlib_extract_first_content(struct zip_extract_userdata *userdata,
+      const char *valid_exts)
 {
-   struct string_list *list;
    bool ret = true;
-   struct zip_extract_userdata userdata = {0};
 
    if (!valid_exts)
    {
@@ -676,22 +843,18 @@ bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
       return false;
    }
 
-   list = string_split(valid_exts, "|");
-   if (!list)
+   userdata->ext = string_split(valid_exts, "|");
+   if (!userdata->ext)
       GOTO_END_ERROR();
 
-   userdata.zip_path             = zip_path;
-   userdata.zip_path_size        = zip_path_size;
-   userdata.extraction_directory = extraction_directory;
-   userdata.ext                  = list;
-
-   if (!zlib_parse_file(zip_path, valid_exts, zip_extract_cb, &userdata))
+   if (!zlib_parse_file(userdata->zip_path, valid_exts,
+            zip_extract_cb, userdata))
    {
       /* Parsing ZIP failed. */
       GOTO_END_ERROR();
    }
 
-   if (!userdata.found_content)
+   if (!userdata->found_content)
    {
       /* Didn't find any content that matched valid extensions
        * for libretro implementation. */
@@ -699,18 +862,70 @@ bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
    }
 
 end:
-   if (list)
-      string_list_free(list);
+   if (userdata->ext)
+      string_list_free(userdata->ext);
    return ret;
 }
 
+/**
+ * zlib_extract_first_content_file:
+ * @zip_path                    : filename path to ZIP archive.
+ * @zip_path_size               : size of ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ * @extraction_directory        : the directory to extract temporary
+ *                                unzipped content to.
+ *
+ * Extract first content file from archive.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
+      const char *valid_exts, const char *extraction_directory)
+{
+   struct zip_extract_userdata userdata = {0};
+
+   userdata.zip_path             = zip_path;
+   userdata.zip_path_size        = zip_path_size;
+   userdata.extraction_directory = extraction_directory;
+
+   return zlib_extract_first_content(&userdata, valid_exts);
+}
+
+/**
+ * zlib_extract_first_content_to_memory:
+ * @zip_path                    : filename path to ZIP archive.
+ * @zip_path_size               : size of ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ * @buf                         : set to the extracted content.
+ *                                Needs to be freed manually.
+ * @size                        : set to the size of @buf.
+ *
+ * Extract first content file from archive into memory.
+ * @zip_path is suffixed with '#' and the name of the file in
+ * the archive.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_first_content_to_memory(char *zip_path,
+      size_t zip_path_size, const char *valid_exts,
+      void **buf, size_t *size)
+{
+   struct zip_extract_userdata userdata = {0};
+
+   userdata.zip_path             = zip_path;
+   userdata.zip_path_size        = zip_path_size;
+   userdata.buf                  = buf;
+   userdata.size                 = size;
+
+   return zlib_extract_first_content(&userdata, valid_exts);
+}
+
 static int zlib_get_file_list_cb(const char *path, const char *valid_exts,
       const uint8_t *cdata,
       unsigned cmode, uint32_t csize, uint32_t size, uint32_t checksum,
       void *userdata)
 {
    union string_list_elem_attr attr;
-   struct string_list *ext_list = NULL;
    const char *file_ext = NULL;
    struct string_list *list = (struct string_list*)userdata;
 
@@ -719,16 +934,10 @@ static int zlib_get_file_list_cb(const char *path, const char *valid_exts,
    (void)csize;
    (void)size;
    (void)checksum;
-   (void)valid_exts;
-   (void)file_ext;
-   (void)ext_list;
 
    memset(&attr, 0, sizeof(attr));
 
    if (valid_exts)
-      ext_list = string_split(valid_exts, "|");
-
-   if (ext_list)
    {
       char last_char = ' ';
 
@@ -736,22 +945,20 @@ static int zlib_get_file_list_cb(const char *path, const char *valid_exts,
       last_char = path[strlen(path)-1];
 
       if (last_char == '/' || last_char == '\\' ) /* Skip if directory. */
-         goto error;
+         return 0;
 
       file_ext = path_get_extension(path);
 
+      /* Called for every file in the archive, so match
+       * against the extensions without splitting them. */
       if (!file_ext || 
-            !string_list_find_elem_prefix(ext_list, ".", file_ext))
-         goto error;
+            !string_find_token_prefix(valid_exts, "|", ".", file_ext))
+         return 0;
 
       attr.i = RARCH_COMPRESSED_FILE_IN_ARCHIVE;
-      string_list_free(ext_list);
    }
 
    return string_list_append(list, path, attr);
-error:
-   string_list_free(ext_list);
-   return 0;
 }
 
 /**
@@ -21,11 +21,317 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <file/file_list.h>
+#include <memory/ralloc.h>
 #include <compat/strcasestr.h>
 #include <compat/posix_string.h>
 
+#define FILE_LIST_BLOCK_SIZE (16 * 1024)
+
+/* Alignment of the entry data handed out by file_list_alloc(). */
+#define FILE_LIST_ALIGN 16
+
+#define FILE_LIST_ALIGN_UP(x) (((x) + FILE_LIST_ALIGN - 1) & ~(size_t)(FILE_LIST_ALIGN - 1))
+
+struct file_list_block
+{
+   struct file_list_block *prev;
+   size_t size;
+   size_t used;
+};
+
+#define FILE_LIST_BLOCK_DATA(block) \
+   ((char*)(block) + FILE_LIST_ALIGN_UP(sizeof(struct file_list_block)))
+
+/* Big directories and playlists repeat most labels and
+ * alts, so every distinct string is stored only once, packed
+ * into blocks that are released together. */
+struct file_list_string_slot
+{
+   uint32_t hash;
+   char *str;
+};
+
+/* Header in front of every file_list_alloc() allocation. */
+struct file_list_chunk
+{
+   size_t size;
+   struct file_list_chunk *next;
+};
+
+#define FILE_LIST_CHUNK_HEADER FILE_LIST_ALIGN_UP(sizeof(struct file_list_chunk))
+
+struct file_list_pool
+{
+   struct file_list_block *strings;
+   struct file_list_string_slot *table;
+   size_t table_size;
+   size_t count;
+
+   /* userdata/actiondata of the entries, and the
+    * chunks given back by file_list_release(). */
+   struct file_list_block *chunks;
+   struct file_list_chunk *free_chunks;
+};
+
+static uint32_t file_list_hash(const char *str)
+{
+   uint32_t hash = 5381;
+
+   while (*str)
+      hash = (hash << 5) + hash + (unsigned char)*str++;
+
+   return hash;
+}
+
+static void *file_list_block_alloc(struct file_list_block **head,
+      size_t len, size_t align)
+{
+   void *ptr;
+   struct file_list_block *block = *head;
+   size_t used = block ? (block->used + align - 1) & ~(align - 1) : 0;
+
+   if (!block || used > block->size || block->size - used < len)
+   {
+      size_t size = len > FILE_LIST_BLOCK_SIZE ? len : FILE_LIST_BLOCK_SIZE;
+
+      block = (struct file_list_block*)ralloc_malloc(RALLOC_TAG_FILE_LIST,
+            FILE_LIST_ALIGN_UP(sizeof(*block)) + size);
+      if (!block)
+         return NULL;
+
+      block->prev = *head;
+      block->size = size;
+      block->used = 0;
+      used        = 0;
+      *head       = block;
+   }
+
+   ptr         = FILE_LIST_BLOCK_DATA(block) + used;
+   block->used = used + len;
+   return ptr;
+}
+
+/**
+ * file_list_blocks_reset:
+ * @head                 : Most recent block of a chain.
+ *
+ * Drops everything allocated from the chain, keeping
+ * one block around for the next time the list fills up.
+ **/
+static void file_list_blocks_reset(struct file_list_block **head)
+{
+   struct file_list_block *keep = *head;
+
+   if (!keep)
+      return;
+
+   while (keep->prev)
+   {
+      struct file_list_block *prev = keep->prev->prev;
+      ralloc_free(keep->prev);
+      keep->prev = prev;
+   }
+
+   if (keep->size != FILE_LIST_BLOCK_SIZE)
+   {
+      ralloc_free(keep);
+      keep = NULL;
+   }
+   else
+      keep->used = 0;
+
+   *head = keep;
+}
+
+static void file_list_blocks_free(struct file_list_block **head)
+{
+   while (*head)
+   {
+      struct file_list_block *prev = (*head)->prev;
+      ralloc_free(*head);
+      *head = prev;
+   }
+}
+
+static struct file_list_pool *file_list_get_pool(file_list_t *list)
+{
+   if (!list->pool)
+      list->pool = (struct file_list_pool*)ralloc_calloc(
+            RALLOC_TAG_FILE_LIST, 1, sizeof(*list->pool));
+   return list->pool;
+}
+
+static bool file_list_strings_grow(struct file_list_pool *pool)
+{
+   size_t i;
+   size_t size = pool->table_size ? pool->table_size * 2 : 256;
+   struct file_list_string_slot *table = (struct file_list_string_slot*)
+      ralloc_calloc(RALLOC_TAG_FILE_LIST, size, sizeof(*table));
+
+   if (!table)
+      return false;
+
+   for (i = 0; i < pool->table_size; i++)
+   {
+      size_t j;
+
+      if (!pool->table[i].str)
+         continue;
+
+      for (j = pool->table[i].hash & (size - 1); table[j].str;
+            j = (j + 1) & (size - 1));
+      table[j] = pool->table[i];
+   }
+
+   ralloc_free(pool->table);
+   pool->table      = table;
+   pool->table_size = size;
+   return true;
+}
+
+static void file_list_pool_reset(struct file_list_pool *pool)
+{
+   if (!pool)
+      return;
+
+   file_list_blocks_reset(&pool->strings);
+   file_list_blocks_reset(&pool->chunks);
+
+   if (pool->table)
+      memset(pool->table, 0, pool->table_size * sizeof(*pool->table));
+   pool->count       = 0;
+   pool->free_chunks = NULL;
+}
+
+/**
+ * file_list_intern:
+ * @list                 : File list handle.
+ * @str                  : String to store.
+ *
+ * Looks @str up in the string table of the list and stores
+ * it if it is not there yet.
+ *
+ * Returns: the stored copy of @str, or NULL if @str is NULL
+ * or memory ran out.
+ **/
+static char *file_list_intern(file_list_t *list, const char *str)
+{
+   size_t i, mask, len;
+   uint32_t hash;
+   struct file_list_pool *pool = NULL;
+
+   if (!str || !(pool = file_list_get_pool(list)))
+      return NULL;
+
+   if ((pool->count + 1) * 4 > pool->table_size * 3
+         && !file_list_strings_grow(pool))
+      return NULL;
+
+   mask = pool->table_size - 1;
+   hash = file_list_hash(str);
+
+   for (i = hash & mask; pool->table[i].str; i = (i + 1) & mask)
+   {
+      if (pool->table[i].hash == hash && !strcmp(pool->table[i].str, str))
+         return pool->table[i].str;
+   }
+
+   len = strlen(str) + 1;
+   if (!(pool->table[i].str = (char*)file_list_block_alloc(
+               &pool->strings, len, 1)))
+      return NULL;
+
+   memcpy(pool->table[i].str, str, len);
+   pool->table[i].hash = hash;
+   pool->count++;
+   return pool->table[i].str;
+}
+
+/**
+ * file_list_alloc:
+ * @list                 : File list handle.
+ * @size                 : Size of the allocation.
+ *
+ * Allocates zeroed memory for the userdata or actiondata
+ * of an entry. It belongs to @list and goes away with the
+ * rest of its entries in file_list_clear() and file_list_free().
+ *
+ * Returns: pointer to the memory, or NULL if memory ran out.
+ **/
+void *file_list_alloc(file_list_t *list, size_t size)
+{
+   struct file_list_chunk **link = NULL;
+   struct file_list_chunk *chunk = NULL;
+   struct file_list_pool   *pool = list ? file_list_get_pool(list) : NULL;
+
+   if (!pool)
+      return NULL;
+
+   size = FILE_LIST_ALIGN_UP(size);
+
+   for (link = &pool->free_chunks; *link; link = &(*link)->next)
+   {
+      if ((*link)->size == size)
+      {
+         chunk = *link;
+         *link = chunk->next;
+         break;
+      }
+   }
+
+   if (!chunk)
+   {
+      chunk = (struct file_list_chunk*)file_list_block_alloc(&pool->chunks,
+            FILE_LIST_CHUNK_HEADER + size, FILE_LIST_ALIGN);
+      if (!chunk)
+         return NULL;
+      chunk->size = size;
+   }
+
+   chunk->next = NULL;
+   memset((char*)chunk + FILE_LIST_CHUNK_HEADER, 0, size);
+   return (char*)chunk + FILE_LIST_CHUNK_HEADER;
+}
+
+/**
+ * file_list_release:
+ * @list                 : File list handle.
+ * @data                 : Memory from file_list_alloc() on @list.
+ *
+ * Gives @data back to @list before the list is cleared,
+ * for entries that are popped off a list that keeps going.
+ **/
+void file_list_release(file_list_t *list, void *data)
+{
+   struct file_list_chunk *chunk = NULL;
+
+   if (!list || !list->pool || !data)
+      return;
+
+   chunk                   = (struct file_list_chunk*)
+      ((char*)data - FILE_LIST_CHUNK_HEADER);
+   chunk->next             = list->pool->free_chunks;
+   list->pool->free_chunks = chunk;
+}
+
+static void *file_list_dup(file_list_t *list, const void *data)
+{
+   void *copy;
+   const struct file_list_chunk *chunk = NULL;
+
+   if (!data)
+      return NULL;
+
+   chunk = (const struct file_list_chunk*)
+      ((const char*)data - FILE_LIST_CHUNK_HEADER);
+   if ((copy = file_list_alloc(list, chunk->size)))
+      memcpy(copy, data, chunk->size);
+   return copy;
+}
+
 void file_list_push(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr)
@@ -35,23 +341,20 @@ void file_list_push(file_list_t *list,
       list->capacity += 1;
       list->capacity *= 2;
 
-      list->list = (struct item_file*)realloc(list->list,
-            list->capacity * sizeof(struct item_file));
+      list->list = (struct item_file*)ralloc_realloc(RALLOC_TAG_FILE_LIST,
+            list->list, list->capacity * sizeof(struct item_file));
 
       if (!list->list)
          return;
    }
 
-   list->list[list->size].label         = NULL;
-   list->list[list->size].path          = NULL;
+   list->list[list->size].label         = file_list_intern(list, label);
+   list->list[list->size].path          = file_list_intern(list, path);
    list->list[list->size].alt           = NULL;
    list->list[list->size].type          = type;
    list->list[list->size].directory_ptr = directory_ptr;
-
-   if (label)
-      list->list[list->size].label      = strdup(label);
-   if (path)
-      list->list[list->size].path       = strdup(path);
+   list->list[list->size].userdata      = NULL;
+   list->list[list->size].actiondata    = NULL;
 
    list->size++;
 }
@@ -75,16 +378,14 @@ void file_list_pop(file_list_t *list, size_t *directory_ptr)
    if (!list)
       return;
 
+   /* The strings stay in the table until the list is cleared,
+    * a menu stack pushes the same few over and over. */
    if (list->size != 0)
    {
       --list->size;
-      if (list->list[list->size].path)
-         free(list->list[list->size].path);
-      list->list[list->size].path = NULL;
-
-      if (list->list[list->size].label)
-         free(list->list[list->size].label);
+      list->list[list->size].path  = NULL;
       list->list[list->size].label = NULL;
+      list->list[list->size].alt   = NULL;
    }
 
    if (directory_ptr)
@@ -93,54 +394,30 @@ void file_list_pop(file_list_t *list, size_t *directory_ptr)
 
 void file_list_free(file_list_t *list)
 {
-   size_t i;
-
    if (!list)
       return;
 
-   for (i = 0; i < list->size; i++)
+   if (list->pool)
    {
-      if (list->list[i].path)
-         free(list->list[i].path);
-      list->list[i].path = NULL;
-
-      if (list->list[i].label)
-         free(list->list[i].label);
-      list->list[i].label = NULL;
-
-      if (list->list[i].alt)
-         free(list->list[i].alt);
-      list->list[i].alt = NULL;
+      file_list_blocks_free(&list->pool->strings);
+      file_list_blocks_free(&list->pool->chunks);
+      ralloc_free(list->pool->table);
+      ralloc_free(list->pool);
    }
+   list->pool = NULL;
+
    if (list->list)
-      free(list->list);
+      ralloc_free(list->list);
    list->list = NULL;
-   if (list)
-      free(list);
+   free(list);
 }
 
 void file_list_clear(file_list_t *list)
 {
-   size_t i;
-
    if (!list)
       return;
 
-   for (i = 0; i < list->size; i++)
-   {
-      if (list->list[i].path)
-         free(list->list[i].path);
-      list->list[i].path = NULL;
-
-      if (list->list[i].label)
-         free(list->list[i].label);
-      list->list[i].label = NULL;
-
-      if (list->list[i].alt)
-         free(list->list[i].alt);
-      list->list[i].alt = NULL;
-   }
-
+   file_list_pool_reset(list->pool);
    list->size = 0;
 }
 
@@ -151,31 +428,30 @@ void file_list_copy(file_list_t *list, file_list_t *list_old)
    if (!list)
       return;
 
+   file_list_pool_reset(list_old->pool);
+
    list_old->size = list->size;
    list_old->capacity = list->capacity;
 
-   list_old->list = (struct item_file*)realloc(list_old->list,
-            list_old->capacity * sizeof(struct item_file));
+   list_old->list = (struct item_file*)ralloc_realloc(RALLOC_TAG_FILE_LIST,
+         list_old->list, list_old->capacity * sizeof(struct item_file));
 
    if (!list_old->list)
       return;
 
    for (i = 0; i < list->size; i++)
    {
-      list_old->list[i].path          = NULL;
-      list_old->list[i].label         = NULL;
-      list_old->list[i].alt           = NULL;
+      list_old->list[i].path          = file_list_intern(list_old,
+            list->list[i].path);
+      list_old->list[i].label         = file_list_intern(list_old,
+            list->list[i].label);
+      list_old->list[i].alt           = file_list_intern(list_old,
+            list->list[i].alt);
       list_old->list[i].type          = list->list[i].type;
       list_old->list[i].directory_ptr = list->list[i].directory_ptr;
       list_old->list[i].userdata      = list->list[i].userdata;
-      list_old->list[i].actiondata    = list->list[i].actiondata;
-
-      if (list->list[i].path)
-         list_old->list[i].path       = strdup(list->list[i].path);
-      if (list->list[i].label)
-         list_old->list[i].label      = strdup(list->list[i].label);
-      if (list->list[i].alt)
-         list_old->list[i].alt        = strdup(list->list[i].alt);
+      list_old->list[i].actiondata    = file_list_dup(list_old,
+            list->list[i].actiondata);
    }
 }
 
@@ -185,12 +461,7 @@ void file_list_set_label_at_offset(file_list_t *list, size_t idx,
    if (!list)
       return;
 
-   if (list->list[idx].label)
-      free(list->list[idx].label);
-   list->list[idx].alt      = NULL;
-
-   if (label)
-      list->list[idx].label = strdup(label);
+   list->list[idx].label = file_list_intern(list, label);
 }
 
 void file_list_get_label_at_offset(const file_list_t *list, size_t idx,
@@ -210,12 +481,7 @@ void file_list_set_alt_at_offset(file_list_t *list, size_t idx,
    if (!list)
       return;
 
-   if (list->list[idx].alt)
-      free(list->list[idx].alt);
-   list->list[idx].alt      = NULL;
-
-   if (alt)
-      list->list[idx].alt   = strdup(alt);
+   list->list[idx].alt = file_list_intern(list, alt);
 }
 
 void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
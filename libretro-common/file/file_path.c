@@ -210,16 +210,14 @@ bool path_file_exists(const char *path)
 void fill_pathname(char *out_path, const char *in_path,
       const char *replace, size_t size)
 {
-   char tmp_path[PATH_MAX_LENGTH];
-   char *tok;
-
-   rarch_assert(strlcpy(tmp_path, in_path,
-            sizeof(tmp_path)) < sizeof(tmp_path));
-   if ((tok = (char*)strrchr(path_basename(tmp_path), '.')))
-      *tok = '\0';
-
-   rarch_assert(strlcpy(out_path, tmp_path, size) < size);
-   rarch_assert(strlcat(out_path, replace, size) < size);
+   const char *tok = strrchr(path_basename(in_path), '.');
+   size_t len      = tok ? (size_t)(tok - in_path) : strlen(in_path);
+   size_t rep_len  = strlen(replace);
+
+   /* Copy once, straight into @out_path, which may be @in_path. */
+   rarch_assert(len + rep_len < size);
+   memmove(out_path, in_path, len);
+   memcpy(out_path + len, replace, rep_len + 1);
 }
 
 /**
@@ -680,11 +678,11 @@ void fill_pathname_join_delim(char *out_path, const char *dir,
 void fill_short_pathname_representation(char* out_rep,
       const char *in_path, size_t size)
 {
-   char path_short[PATH_MAX_LENGTH], *last_hash = NULL;
-   fill_pathname(path_short, path_basename(in_path), "",
-            sizeof(path_short));
+   const char *base      = path_basename(in_path);
+   const char *ext       = strrchr(base, '.');
+   const char *end       = ext ? ext : base + strlen(base);
+   const char *last_hash = (const char*)memchr(base, '#', end - base);
 
-   last_hash = (char*)strchr(path_short,'#');
    /* We handle paths like:
     * /path/to/file.7z#mygame.img
     * short_name: mygame.img:
@@ -694,9 +692,11 @@ void fill_short_pathname_representation(char* out_rep,
       /* We check whether something is actually 
        * after the hash to avoid going over the buffer.
        */
-      rarch_assert(strlen(last_hash) > 1);
-      strlcpy(out_rep,last_hash + 1, size);
+      rarch_assert(end - last_hash > 1);
+      base = last_hash + 1;
    }
-   else
-      strlcpy(out_rep,path_short, size);
+
+   /* Cut the extension like fill_pathname() would,
+    * without going through a temporary buffer. */
+   strlcpy(out_rep, base, min((size_t)(end - base) + 1, size));
 }
@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <file/nbio.h>
+
+/* Reads and writes are split into chunks of this size,
+ * with up to NBIO_QUEUE_DEPTH of them in flight at once. */
+#define NBIO_CHUNK_SIZE  (1 << 20)
+#define NBIO_QUEUE_DEPTH 8
+
+/* Used where io_uring is unavailable, e.g. kernels
+ * older than 5.1 or sandboxes which forbid it. */
+#define NBIO_SYNC_CHUNK_SIZE 65536
+
+struct nbio_ring
+{
+   int fd;
+   void *sq_ptr;
+   void *cq_ptr;
+   size_t sq_size;
+   size_t cq_size;
+   struct io_uring_sqe *sqes;
+   size_t sqes_size;
+   unsigned *sq_head;
+   unsigned *sq_tail;
+   unsigned *sq_mask;
+   unsigned *sq_array;
+   unsigned *cq_head;
+   unsigned *cq_tail;
+   unsigned *cq_mask;
+   struct io_uring_cqe *cqes;
+};
+
+struct nbio_slot
+{
+   struct iovec iov;
+   size_t offset;
+   bool busy;
+};
+
+struct nbio_t
+{
+   int fd;
+   void* data;
+   /* Bytes done, and bytes handed to the kernel so far. */
+   size_t progress;
+   size_t queued;
+   size_t len;
+   /*
+    * possible values:
+    * NBIO_READ, NBIO_WRITE - obvious
+    * -1 - currently doing nothing
+    * -2 - the pointer was reallocated since the last operation
+    */
+   signed char op;
+   signed char mode;
+
+   bool have_ring;
+   struct nbio_ring ring;
+   struct nbio_slot slots[NBIO_QUEUE_DEPTH];
+   unsigned inflight;
+};
+
+static const int modes[] = {
+   O_RDONLY,
+   O_WRONLY | O_CREAT | O_TRUNC,
+   O_RDWR,
+   O_RDONLY,
+   O_WRONLY | O_CREAT | O_TRUNC,
+   O_RDWR
+};
+
+/* Submits everything queued, optionally waiting for completions. */
+static int nbio_ring_enter(struct nbio_ring *ring, unsigned min_complete)
+{
+   int ret;
+   unsigned to_submit = *ring->sq_tail 
+      - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+   do
+   {
+      ret = syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete,
+            min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+   } while (ret < 0 && errno == EINTR);
+
+   return ret;
+}
+
+static void nbio_ring_free(struct nbio_ring *ring)
+{
+   if (ring->sqes)
+      munmap(ring->sqes, ring->sqes_size);
+   if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+      munmap(ring->cq_ptr, ring->cq_size);
+   if (ring->sq_ptr)
+      munmap(ring->sq_ptr, ring->sq_size);
+   if (ring->fd >= 0)
+      close(ring->fd);
+
+   memset(ring, 0, sizeof(*ring));
+   ring->fd = -1;
+}
+
+static bool nbio_ring_init(struct nbio_ring *ring)
+{
+   struct io_uring_params p;
+   uint8_t *sq, *cq;
+
+   memset(&p, 0, sizeof(p));
+   memset(ring, 0, sizeof(*ring));
+
+   ring->fd = syscall(__NR_io_uring_setup, NBIO_QUEUE_DEPTH, &p);
+   if (ring->fd < 0)
+      return false;
+
+   ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+   ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+   if ((p.features & IORING_FEAT_SINGLE_MMAP) && ring->cq_size > ring->sq_size)
+      ring->sq_size = ring->cq_size;
+
+   ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+   if (ring->sq_ptr == MAP_FAILED)
+   {
+      ring->sq_ptr = NULL;
+      goto error;
+   }
+
+   if (p.features & IORING_FEAT_SINGLE_MMAP)
+      ring->cq_ptr = ring->sq_ptr;
+   else
+   {
+      ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+      if (ring->cq_ptr == MAP_FAILED)
+      {
+         ring->cq_ptr = NULL;
+         goto error;
+      }
+   }
+
+   ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+   ring->sqes      = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size,
+         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         ring->fd, IORING_OFF_SQES);
+   if (ring->sqes == MAP_FAILED)
+   {
+      ring->sqes = NULL;
+      goto error;
+   }
+
+   sq             = (uint8_t*)ring->sq_ptr;
+   cq             = (uint8_t*)ring->cq_ptr;
+   ring->sq_head  = (unsigned*)(sq + p.sq_off.head);
+   ring->sq_tail  = (unsigned*)(sq + p.sq_off.tail);
+   ring->sq_mask  = (unsigned*)(sq + p.sq_off.ring_mask);
+   ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+   ring->cq_head  = (unsigned*)(cq + p.cq_off.head);
+   ring->cq_tail  = (unsigned*)(cq + p.cq_off.tail);
+   ring->cq_mask  = (unsigned*)(cq + p.cq_off.ring_mask);
+   ring->cqes     = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+   return true;
+
+error:
+   nbio_ring_free(ring);
+   return false;
+}
+
+/* Queues the rest of the chunk @offset is in, from @offset on. */
+static void nbio_queue_slot(struct nbio_t* handle, unsigned slot, size_t offset)
+{
+   struct nbio_ring *ring   = &handle->ring;
+   size_t end               = (offset / NBIO_CHUNK_SIZE + 1) * NBIO_CHUNK_SIZE;
+   unsigned tail            = *ring->sq_tail;
+   unsigned idx             = tail & *ring->sq_mask;
+   struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+   if (end > handle->len)
+      end = handle->len;
+
+   handle->slots[slot].offset       = offset;
+   handle->slots[slot].iov.iov_base = (uint8_t*)handle->data + offset;
+   handle->slots[slot].iov.iov_len  = end - offset;
+   handle->slots[slot].busy         = true;
+
+   memset(sqe, 0, sizeof(*sqe));
+   sqe->opcode    = (handle->op == NBIO_READ) ?
+      IORING_OP_READV : IORING_OP_WRITEV;
+   sqe->fd        = handle->fd;
+   sqe->off       = offset;
+   sqe->addr      = (uintptr_t)&handle->slots[slot].iov;
+   sqe->len       = 1;
+   sqe->user_data = slot;
+
+   ring->sq_array[idx] = idx;
+   __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+   handle->inflight++;
+}
+
+/* Keeps the queue full until everything has been queued. */
+static unsigned nbio_queue_chunks(struct nbio_t* handle)
+{
+   unsigned i;
+   unsigned queued = 0;
+
+   for (i = 0; i < NBIO_QUEUE_DEPTH && handle->queued < handle->len; i++)
+   {
+      size_t offset;
+
+      if (handle->slots[i].busy)
+         continue;
+
+      offset           = handle->queued;
+      handle->queued  += NBIO_CHUNK_SIZE - offset % NBIO_CHUNK_SIZE;
+      if (handle->queued > handle->len)
+         handle->queued = handle->len;
+
+      nbio_queue_slot(handle, i, offset);
+      queued++;
+   }
+
+   return queued;
+}
+
+/* Handles finished chunks, requeueing the rest of short ones.
+ * Returns the number of chunks requeued. */
+static unsigned nbio_reap_chunks(struct nbio_t* handle, bool requeue)
+{
+   struct nbio_ring *ring = &handle->ring;
+   unsigned head          = *ring->cq_head;
+   unsigned tail          = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+   unsigned requeued      = 0;
+
+   while (head != tail)
+   {
+      struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+      struct nbio_slot *slot   = &handle->slots[cqe->user_data];
+      int res                  = cqe->res;
+
+      head++;
+      handle->inflight--;
+      slot->busy = false;
+
+      if (res == -EAGAIN || res == -EINTR)
+         res = 0;
+      else if (res <= 0)
+      {
+         /* Error, or the file shrank. Give up on the chunk
+          * like a short fread() would. */
+         handle->progress += slot->iov.iov_len;
+         continue;
+      }
+
+      handle->progress += res;
+
+      if (requeue && (size_t)res < slot->iov.iov_len)
+      {
+         nbio_queue_slot(handle, (unsigned)(slot - handle->slots),
+               slot->offset + res);
+         requeued++;
+      }
+      else if ((size_t)res < slot->iov.iov_len)
+         handle->progress += slot->iov.iov_len - res;
+   }
+
+   __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+   return requeued;
+}
+
+static void nbio_wait_idle(struct nbio_t* handle)
+{
+   while (handle->inflight)
+   {
+      if (nbio_ring_enter(&handle->ring, 1) < 0)
+         break;
+      nbio_reap_chunks(handle, false);
+   }
+}
+
+struct nbio_t* nbio_open(const char * filename, unsigned mode)
+{
+   struct stat st;
+   struct nbio_t* handle = NULL;
+   int fd                = open(filename, modes[mode], 0644);
+
+   if (fd < 0)
+      return NULL;
+
+   handle                = (struct nbio_t*)calloc(1, sizeof(struct nbio_t));
+
+   if (!handle)
+      goto error;
+
+   handle->fd            = fd;
+   handle->len           = 0;
+
+   switch (mode)
+   {
+      case NBIO_WRITE:
+      case BIO_WRITE:
+         break;
+      default:
+         if (fstat(fd, &st) != 0)
+            goto error;
+         handle->len = st.st_size;
+         break;
+   }
+
+   handle->mode          = mode;
+   handle->data          = malloc(handle->len);
+
+   if (handle->len && !handle->data)
+      goto error;
+
+   handle->progress      = handle->len;
+   handle->queued        = handle->len;
+   handle->op            = -2;
+
+   /* Blocking modes do it all in nbio_iterate() anyway. */
+   if (mode != BIO_READ && mode != BIO_WRITE)
+      handle->have_ring  = nbio_ring_init(&handle->ring);
+
+   return handle;
+
+error:
+   if (handle)
+      free(handle->data);
+   free(handle);
+   handle = NULL;
+   close(fd);
+   return NULL;
+}
+
+static void nbio_begin(struct nbio_t* handle, signed char op)
+{
+   handle->op       = op;
+   handle->progress = 0;
+   handle->queued   = 0;
+
+   if (!handle->have_ring)
+      return;
+
+   /* Starts reading right away, the kernel carries on
+    * while the caller does other things. */
+   if (nbio_queue_chunks(handle))
+      nbio_ring_enter(&handle->ring, 0);
+}
+
+void nbio_begin_read(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file read operation while busy");
+      abort();
+   }
+
+   nbio_begin(handle, NBIO_READ);
+}
+
+void nbio_begin_write(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file write operation while busy");
+      abort();
+   }
+
+   nbio_begin(handle, NBIO_WRITE);
+}
+
+static size_t nbio_transfer_sync(struct nbio_t* handle, size_t amount)
+{
+   ssize_t ret;
+   uint8_t *ptr = (uint8_t*)handle->data + handle->progress;
+
+   do
+   {
+      if (handle->op == NBIO_READ)
+         ret = pread(handle->fd, ptr, amount, handle->progress);
+      else
+         ret = pwrite(handle->fd, ptr, amount, handle->progress);
+   } while (ret < 0 && errno == EINTR);
+
+   /* Like a short fread() or fwrite(), skip what failed. */
+   if (ret <= 0)
+      return amount;
+   return ret;
+}
+
+bool nbio_iterate(struct nbio_t* handle)
+{
+   if (!handle)
+      return false;
+
+   if (handle->op < 0)
+      return true;
+
+   if (handle->have_ring)
+   {
+      unsigned submit = nbio_reap_chunks(handle, true);
+
+      submit += nbio_queue_chunks(handle);
+      if (submit)
+         nbio_ring_enter(&handle->ring, 0);
+   }
+   else if (handle->mode == BIO_READ || handle->mode == BIO_WRITE)
+   {
+      while (handle->progress < handle->len)
+         handle->progress += nbio_transfer_sync(handle,
+               handle->len - handle->progress);
+   }
+   else if (handle->progress < handle->len)
+   {
+      size_t amount = NBIO_SYNC_CHUNK_SIZE;
+
+      if (amount > handle->len - handle->progress)
+         amount = handle->len - handle->progress;
+
+      handle->progress += nbio_transfer_sync(handle, amount);
+   }
+
+   if (handle->progress >= handle->len && !handle->inflight)
+      handle->op = -1;
+   return (handle->op < 0);
+}
+
+void nbio_resize(struct nbio_t* handle, size_t len)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file resize operation while busy");
+      abort();
+   }
+   if (len < handle->len)
+   {
+      puts("ERROR - attempted file shrink operation, not implemented");
+      abort();
+   }
+
+   handle->len  = len;
+   handle->data = realloc(handle->data, handle->len);
+   handle->op   = -1;
+   handle->progress = handle->len;
+   handle->queued   = handle->len;
+}
+
+void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
+{
+   if (!handle)
+      return NULL;
+   if (len)
+      *len = handle->len;
+   if (handle->op == -1)
+      return handle->data;
+   return NULL;
+}
+
+void nbio_cancel(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   /* The kernel may still be using the buffer. */
+   if (handle->have_ring)
+      nbio_wait_idle(handle);
+
+   handle->op = -1;
+   handle->progress = handle->len;
+   handle->queued   = handle->len;
+}
+
+void nbio_free(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted free() while busy");
+      abort();
+   }
+   if (handle->have_ring)
+      nbio_ring_free(&handle->ring);
+   close(handle->fd);
+   free(handle->data);
+   free(handle);
+}
@@ -194,4 +194,5 @@ void nbio_free(struct nbio_t* handle)
    }
    fclose(handle->f);
    free(handle->data);
+   free(handle);
 }
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <file/nbio.h>
+
+/* The file is mapped instead of copied. Reads ask the kernel to
+ * page the file in ahead of time, writes go to the page cache
+ * directly and are flushed in the background. */
+
+struct nbio_t
+{
+   int fd;
+   void* data;
+   size_t len;
+   /*
+    * possible values:
+    * NBIO_READ, NBIO_WRITE - obvious
+    * -1 - currently doing nothing
+    * -2 - the pointer was reallocated since the last operation
+    */
+   signed char op;
+   signed char mode;
+};
+
+static const int modes[] = {
+   O_RDONLY,
+   O_RDWR | O_CREAT | O_TRUNC,
+   O_RDWR,
+   O_RDONLY,
+   O_RDWR | O_CREAT | O_TRUNC,
+   O_RDWR
+};
+
+static bool nbio_map(struct nbio_t* handle)
+{
+   void *ptr;
+
+   handle->data = NULL;
+
+   /* Can't map nothing. */
+   if (!handle->len)
+      return true;
+
+   /* Read-only files are mapped copy-on-write, so the data
+    * is writable like a malloc'd copy would be. */
+   if (handle->mode == NBIO_READ || handle->mode == BIO_READ)
+      ptr = mmap(NULL, handle->len, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE, handle->fd, 0);
+   else
+      ptr = mmap(NULL, handle->len, PROT_READ | PROT_WRITE,
+            MAP_SHARED, handle->fd, 0);
+
+   if (ptr == MAP_FAILED)
+      return false;
+
+   handle->data = ptr;
+   return true;
+}
+
+static void nbio_unmap(struct nbio_t* handle)
+{
+   if (handle->data)
+      munmap(handle->data, handle->len);
+   handle->data = NULL;
+}
+
+struct nbio_t* nbio_open(const char * filename, unsigned mode)
+{
+   struct stat st;
+   struct nbio_t* handle = NULL;
+   int fd                = open(filename, modes[mode], 0644);
+
+   if (fd < 0)
+      return NULL;
+
+   handle                = (struct nbio_t*)calloc(1, sizeof(struct nbio_t));
+
+   if (!handle)
+      goto error;
+
+   handle->fd            = fd;
+   handle->len           = 0;
+   handle->mode          = mode;
+
+   switch (mode)
+   {
+      case NBIO_WRITE:
+      case BIO_WRITE:
+         break;
+      default:
+         if (fstat(fd, &st) != 0)
+            goto error;
+         handle->len = st.st_size;
+         break;
+   }
+
+   if (!nbio_map(handle))
+      goto error;
+
+   handle->op            = -2;
+
+   return handle;
+
+error:
+   free(handle);
+   close(fd);
+   return NULL;
+}
+
+void nbio_begin_read(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file read operation while busy");
+      abort();
+   }
+
+   /* Starts paging the file in, the kernel carries on
+    * while the caller does other things. */
+   if (handle->data)
+      madvise(handle->data, handle->len, MADV_WILLNEED);
+
+   handle->op = NBIO_READ;
+}
+
+void nbio_begin_write(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file write operation while busy");
+      abort();
+   }
+
+   if (handle->data)
+      msync(handle->data, handle->len,
+            (handle->mode == BIO_WRITE) ? MS_SYNC : MS_ASYNC);
+
+   handle->op = NBIO_WRITE;
+}
+
+bool nbio_iterate(struct nbio_t* handle)
+{
+   if (!handle)
+      return false;
+
+   /* The mapping is usable right away, pages the kernel
+    * hasn't read in yet are faulted in on access. */
+   handle->op = -1;
+   return true;
+}
+
+void nbio_resize(struct nbio_t* handle, size_t len)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file resize operation while busy");
+      abort();
+   }
+   if (len < handle->len)
+   {
+      puts("ERROR - attempted file shrink operation, not implemented");
+      abort();
+   }
+
+   nbio_unmap(handle);
+
+   if (ftruncate(handle->fd, len) != 0)
+   {
+      puts("ERROR - could not resize file");
+      abort();
+   }
+
+   handle->len = len;
+
+   if (!nbio_map(handle))
+   {
+      puts("ERROR - could not map resized file");
+      abort();
+   }
+
+   handle->op = -1;
+}
+
+void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
+{
+   if (!handle)
+      return NULL;
+   if (len)
+      *len = handle->len;
+   if (handle->op == -1)
+      return handle->data;
+   return NULL;
+}
+
+void nbio_cancel(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   handle->op = -1;
+}
+
+void nbio_free(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted free() while busy");
+      abort();
+   }
+   nbio_unmap(handle);
+   close(handle->fd);
+   free(handle);
+}
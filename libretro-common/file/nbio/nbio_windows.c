@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <windows.h>
+
+#include <file/nbio.h>
+
+/* Reads and writes are split into chunks of this size,
+ * with up to NBIO_QUEUE_DEPTH of them in flight at once. */
+#define NBIO_CHUNK_SIZE  (1 << 20)
+#define NBIO_QUEUE_DEPTH 8
+
+struct nbio_slot
+{
+   OVERLAPPED overlapped;
+   /* With several transfers in flight, each needs its own
+    * event, the file handle can't tell them apart. */
+   HANDLE event;
+   size_t offset;
+   DWORD size;
+   bool busy;
+};
+
+struct nbio_t
+{
+   HANDLE file;
+   void* data;
+   /* Bytes done, and bytes handed to the system so far. */
+   size_t progress;
+   size_t queued;
+   size_t len;
+   /*
+    * possible values:
+    * NBIO_READ, NBIO_WRITE - obvious
+    * -1 - currently doing nothing
+    * -2 - the pointer was reallocated since the last operation
+    */
+   signed char op;
+   signed char mode;
+
+   struct nbio_slot slots[NBIO_QUEUE_DEPTH];
+   unsigned inflight;
+};
+
+static const DWORD access_modes[] = {
+   GENERIC_READ,
+   GENERIC_WRITE,
+   GENERIC_READ | GENERIC_WRITE,
+   GENERIC_READ,
+   GENERIC_WRITE,
+   GENERIC_READ | GENERIC_WRITE
+};
+
+static const DWORD create_modes[] = {
+   OPEN_EXISTING,
+   CREATE_ALWAYS,
+   OPEN_EXISTING,
+   OPEN_EXISTING,
+   CREATE_ALWAYS,
+   OPEN_EXISTING
+};
+
+/* Starts transferring the rest of the chunk @offset is in.
+ * Returns false if the transfer failed right away. */
+static bool nbio_queue_slot(struct nbio_t* handle, unsigned slot, size_t offset)
+{
+   BOOL ret;
+   struct nbio_slot *s = &handle->slots[slot];
+   size_t end          = (offset / NBIO_CHUNK_SIZE + 1) * NBIO_CHUNK_SIZE;
+
+   if (end > handle->len)
+      end = handle->len;
+
+   memset(&s->overlapped, 0, sizeof(s->overlapped));
+   s->overlapped.Offset     = (DWORD)((unsigned long long)offset);
+   s->overlapped.OffsetHigh = (DWORD)((unsigned long long)offset >> 32);
+   s->overlapped.hEvent     = s->event;
+   s->offset                = offset;
+   s->size                  = (DWORD)(end - offset);
+
+   if (handle->op == NBIO_READ)
+      ret = ReadFile(handle->file, (char*)handle->data + offset,
+            s->size, NULL, &s->overlapped);
+   else
+      ret = WriteFile(handle->file, (char*)handle->data + offset,
+            s->size, NULL, &s->overlapped);
+
+   /* Cached data may complete right away, which is still
+    * reported through the OVERLAPPED. */
+   if (!ret && GetLastError() != ERROR_IO_PENDING)
+      return false;
+
+   s->busy = true;
+   handle->inflight++;
+   return true;
+}
+
+/* Keeps the queue full until everything has been queued. */
+static void nbio_queue_chunks(struct nbio_t* handle)
+{
+   unsigned i;
+
+   for (i = 0; i < NBIO_QUEUE_DEPTH && handle->queued < handle->len; i++)
+   {
+      size_t offset;
+
+      if (handle->slots[i].busy)
+         continue;
+
+      offset           = handle->queued;
+      handle->queued  += NBIO_CHUNK_SIZE - offset % NBIO_CHUNK_SIZE;
+      if (handle->queued > handle->len)
+         handle->queued = handle->len;
+
+      /* Like a short fread() or fwrite(), skip what failed. */
+      if (!nbio_queue_slot(handle, i, offset))
+         handle->progress += handle->queued - offset;
+   }
+}
+
+/* Handles finished chunks, requeueing the rest of short ones. */
+static void nbio_reap_chunks(struct nbio_t* handle, bool wait, bool requeue)
+{
+   unsigned i;
+
+   for (i = 0; i < NBIO_QUEUE_DEPTH; i++)
+   {
+      DWORD done          = 0;
+      struct nbio_slot *s = &handle->slots[i];
+
+      if (!s->busy)
+         continue;
+      if (!wait && !HasOverlappedIoCompleted(&s->overlapped))
+         continue;
+
+      s->busy = false;
+      handle->inflight--;
+
+      if (!GetOverlappedResult(handle->file, &s->overlapped, &done, TRUE)
+            || !done)
+      {
+         handle->progress += s->size;
+         continue;
+      }
+
+      handle->progress += done;
+
+      if (done < s->size)
+      {
+         DWORD rest = s->size - done;
+
+         if (!requeue || !nbio_queue_slot(handle, i, s->offset + done))
+            handle->progress += rest;
+      }
+   }
+}
+
+struct nbio_t* nbio_open(const char * filename, unsigned mode)
+{
+   unsigned i;
+   LARGE_INTEGER size;
+   struct nbio_t* handle = NULL;
+   HANDLE file           = CreateFileA(filename, access_modes[mode],
+         FILE_SHARE_READ, NULL, create_modes[mode],
+         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED
+         | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+   if (file == INVALID_HANDLE_VALUE)
+      return NULL;
+
+   handle                = (struct nbio_t*)calloc(1, sizeof(struct nbio_t));
+
+   if (!handle)
+      goto error;
+
+   handle->file          = file;
+   handle->len           = 0;
+
+   for (i = 0; i < NBIO_QUEUE_DEPTH; i++)
+   {
+      handle->slots[i].event = CreateEvent(NULL, TRUE, FALSE, NULL);
+      if (!handle->slots[i].event)
+         goto error;
+   }
+
+   switch (mode)
+   {
+      case NBIO_WRITE:
+      case BIO_WRITE:
+         break;
+      default:
+         if (!GetFileSizeEx(file, &size))
+            goto error;
+         handle->len = (size_t)size.QuadPart;
+         break;
+   }
+
+   handle->mode          = mode;
+   handle->data          = malloc(handle->len);
+
+   if (handle->len && !handle->data)
+      goto error;
+
+   handle->progress      = handle->len;
+   handle->queued        = handle->len;
+   handle->op            = -2;
+
+   return handle;
+
+error:
+   if (handle)
+   {
+      for (i = 0; i < NBIO_QUEUE_DEPTH; i++)
+      {
+         if (handle->slots[i].event)
+            CloseHandle(handle->slots[i].event);
+      }
+      free(handle->data);
+   }
+   free(handle);
+   CloseHandle(file);
+   return NULL;
+}
+
+static void nbio_begin(struct nbio_t* handle, signed char op)
+{
+   handle->op       = op;
+   handle->progress = 0;
+   handle->queued   = 0;
+
+   /* Starts right away, the system carries on
+    * while the caller does other things. */
+   nbio_queue_chunks(handle);
+}
+
+void nbio_begin_read(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file read operation while busy");
+      abort();
+   }
+
+   nbio_begin(handle, NBIO_READ);
+}
+
+void nbio_begin_write(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file write operation while busy");
+      abort();
+   }
+
+   nbio_begin(handle, NBIO_WRITE);
+}
+
+bool nbio_iterate(struct nbio_t* handle)
+{
+   if (!handle)
+      return false;
+
+   if (handle->op < 0)
+      return true;
+
+   /* Blocking modes wait for everything at once. */
+   if (handle->mode == BIO_READ || handle->mode == BIO_WRITE)
+   {
+      while (handle->inflight)
+      {
+         nbio_reap_chunks(handle, true, true);
+         nbio_queue_chunks(handle);
+      }
+   }
+   else
+   {
+      nbio_reap_chunks(handle, false, true);
+      nbio_queue_chunks(handle);
+   }
+
+   if (handle->progress >= handle->len && !handle->inflight)
+      handle->op = -1;
+   return (handle->op < 0);
+}
+
+void nbio_resize(struct nbio_t* handle, size_t len)
+{
+   if (!handle)
+      return;
+
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted file resize operation while busy");
+      abort();
+   }
+   if (len < handle->len)
+   {
+      puts("ERROR - attempted file shrink operation, not implemented");
+      abort();
+   }
+
+   handle->len  = len;
+   handle->data = realloc(handle->data, handle->len);
+   handle->op   = -1;
+   handle->progress = handle->len;
+   handle->queued   = handle->len;
+}
+
+void* nbio_get_ptr(struct nbio_t* handle, size_t* len)
+{
+   if (!handle)
+      return NULL;
+   if (len)
+      *len = handle->len;
+   if (handle->op == -1)
+      return handle->data;
+   return NULL;
+}
+
+void nbio_cancel(struct nbio_t* handle)
+{
+   if (!handle)
+      return;
+
+   /* The system may still be using the buffer. */
+   if (handle->inflight)
+   {
+      CancelIo(handle->file);
+      nbio_reap_chunks(handle, true, false);
+   }
+
+   handle->op = -1;
+   handle->progress = handle->len;
+   handle->queued   = handle->len;
+}
+
+void nbio_free(struct nbio_t* handle)
+{
+   unsigned i;
+
+   if (!handle)
+      return;
+   if (handle->op >= 0)
+   {
+      puts("ERROR - attempted free() while busy");
+      abort();
+   }
+   for (i = 0; i < NBIO_QUEUE_DEPTH; i++)
+      CloseHandle(handle->slots[i].event);
+   CloseHandle(handle->file);
+   free(handle->data);
+   free(handle);
+}
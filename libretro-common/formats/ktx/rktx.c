@@ -0,0 +1,123 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rktx.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include <formats/rktx.h>
+
+#define KTX_HEADER_SIZE 64
+
+static const uint8_t ktx_identifier[12] = {
+   0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+static uint32_t ktx_read_u32(const uint8_t *buf, bool swap)
+{
+   uint32_t val = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+
+   if (swap)
+      val = (val >> 24) | ((val >> 8) & 0xff00) 
+         | ((val << 8) & 0xff0000) | (val << 24);
+   return val;
+}
+
+bool rktx_parse(struct rktx *ktx, const uint8_t *buf, size_t size)
+{
+   unsigned i;
+   bool swap;
+   size_t offset;
+   uint32_t gl_type, depth, array_elements, faces, levels, kv_size;
+
+   if (!ktx || !buf || size < KTX_HEADER_SIZE)
+      return false;
+
+   if (memcmp(buf, ktx_identifier, sizeof(ktx_identifier)) != 0)
+      return false;
+
+   /* The file is written in the byte order of its creator. */
+   switch (ktx_read_u32(buf + 12, false))
+   {
+      case 0x04030201:
+         swap = false;
+         break;
+      case 0x01020304:
+         swap = true;
+         break;
+      default:
+         return false;
+   }
+
+   memset(ktx, 0, sizeof(*ktx));
+
+   gl_type              = ktx_read_u32(buf + 16, swap);
+   ktx->internal_format = ktx_read_u32(buf + 28, swap);
+   ktx->width           = ktx_read_u32(buf + 36, swap);
+   ktx->height          = ktx_read_u32(buf + 40, swap);
+   depth                = ktx_read_u32(buf + 44, swap);
+   array_elements       = ktx_read_u32(buf + 48, swap);
+   faces                = ktx_read_u32(buf + 52, swap);
+   levels               = ktx_read_u32(buf + 56, swap);
+   kv_size              = ktx_read_u32(buf + 60, swap);
+
+   /* Compressed textures have no type. */
+   if (gl_type != 0 || depth != 0 || array_elements != 0 || faces != 1)
+      return false;
+   if (!ktx->width || !ktx->height)
+      return false;
+
+   if (levels == 0)
+      levels = 1;
+   if (levels > RKTX_MAX_LEVELS)
+      levels = RKTX_MAX_LEVELS;
+
+   offset = KTX_HEADER_SIZE;
+   if (kv_size > size - offset)
+      return false;
+   offset += kv_size;
+
+   for (i = 0; i < levels; i++)
+   {
+      struct rktx_level *level = &ktx->level[i];
+
+      if (size - offset < 4)
+         break;
+
+      level->size   = ktx_read_u32(buf + offset, swap);
+      offset       += 4;
+
+      if (level->size > size - offset)
+         break;
+
+      level->data   = buf + offset;
+      level->width  = ktx->width  >> i ? ktx->width  >> i : 1;
+      level->height = ktx->height >> i ? ktx->height >> i : 1;
+
+      /* Levels are padded to four bytes. */
+      offset       += (level->size + 3) & ~3;
+      if (offset > size)
+         offset     = size;
+
+      ktx->levels++;
+   }
+
+   return ktx->levels != 0;
+}
@@ -33,6 +33,12 @@
 #include <malloc.h>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 enum png_chunk_type png_chunk_type(const struct png_chunk *chunk)
 {
    unsigned i;
@@ -128,11 +134,28 @@ end:
 static void png_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 8 <= width; i += 8, decoded += 24)
+      {
+         uint8x8x3_t rgb = vld3_u8(decoded);
+         uint8x8x4_t bgra;
+
+         bgra.val[0] = rgb.val[2];
+         bgra.val[1] = rgb.val[1];
+         bgra.val[2] = rgb.val[0];
+         bgra.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(data + i), bgra);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -149,11 +172,43 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   /* 8-bit RGBA only needs R and B swapped. */
+#if defined(__SSE2__)
+   if (bpp == 1)
+   {
+      const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+      const __m128i ga_mask = _mm_set1_epi32(0xff00ff00);
+
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i rgba = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i rb   = _mm_and_si128(rgba, rb_mask);
+         __m128i argb = _mm_or_si128(_mm_and_si128(rgba, ga_mask),
+               _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16)));
+
+         _mm_storeu_si128((__m128i*)(data + i), argb);
+      }
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 8 <= width; i += 8, decoded += 32)
+      {
+         uint8x8x4_t rgba = vld4_u8(decoded);
+         uint8x8_t r      = rgba.val[0];
+
+         rgba.val[0] = rgba.val[2];
+         rgba.val[2] = r;
+         vst4_u8((uint8_t*)(data + i), rgba);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -240,6 +295,225 @@ static void png_reverse_filter_copy_line_plt(uint32_t *data,
    }
 }
 
+#if defined(__SSE2__)
+static INLINE __m128i png_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   uint32_t pixel = 0;
+   /* Constant sizes, so the copies get inlined. */
+   if (bpp == 4)
+      memcpy(&pixel, p, 4);
+   else
+      memcpy(&pixel, p, 3);
+   return _mm_cvtsi32_si128(pixel);
+}
+
+static INLINE void png_store_pixel(uint8_t *p, __m128i v, unsigned bpp)
+{
+   uint32_t pixel = _mm_cvtsi128_si32(v);
+   if (bpp == 4)
+      memcpy(p, &pixel, 4);
+   else
+      memcpy(p, &pixel, 3);
+}
+
+static INLINE __m128i png_abs_epi16(__m128i v)
+{
+   return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+static INLINE __m128i png_select(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+static INLINE uint8x8_t png_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   uint32_t pixel = 0;
+   if (bpp == 4)
+      memcpy(&pixel, p, 4);
+   else
+      memcpy(&pixel, p, 3);
+   return vreinterpret_u8_u32(vdup_n_u32(pixel));
+}
+
+static INLINE void png_store_pixel(uint8_t *p, uint8x8_t v, unsigned bpp)
+{
+   uint32_t pixel = vget_lane_u32(vreinterpret_u32_u8(v), 0);
+   if (bpp == 4)
+      memcpy(p, &pixel, 4);
+   else
+      memcpy(p, &pixel, 3);
+}
+#endif
+
+/* The unfilters below work in place on a line of @pitch bytes,
+ * @prev being the already unfiltered line above it. The SIMD
+ * paths handle a whole pixel of 3 or 4 bytes at a time, as
+ * each pixel of Sub, Average and Paeth depends on the one
+ * to its left. */
+static void png_reverse_filter_sub(uint8_t *line,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i = bpp;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      __m128i a = _mm_setzero_si128();
+
+      for (i = 0; i + bpp <= pitch; i += bpp)
+      {
+         a = _mm_add_epi8(a, png_load_pixel(line + i, bpp));
+         png_store_pixel(line + i, a, bpp);
+      }
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+
+      for (i = 0; i + bpp <= pitch; i += bpp)
+      {
+         a = vadd_u8(a, png_load_pixel(line + i, bpp));
+         png_store_pixel(line + i, a, bpp);
+      }
+   }
+#endif
+
+   for (; i < pitch; i++)
+      line[i] += line[i - bpp];
+}
+
+static void png_reverse_filter_up(uint8_t *line,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+   {
+      __m128i d = _mm_loadu_si128((const __m128i*)(line + i));
+      __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+      _mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(d, b));
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(line + i, vaddq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < pitch; i++)
+      line[i] += prev[i];
+}
+
+static void png_reverse_filter_average(uint8_t *line,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i one = _mm_set1_epi8(1);
+      __m128i a         = _mm_setzero_si128();
+
+      for (; i + bpp <= pitch; i += bpp)
+      {
+         __m128i b   = png_load_pixel(prev + i, bpp);
+         /* _mm_avg_epu8 rounds up, PNG rounds down. */
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+
+         a = _mm_add_epi8(png_load_pixel(line + i, bpp), avg);
+         png_store_pixel(line + i, a, bpp);
+      }
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+
+      for (; i + bpp <= pitch; i += bpp)
+      {
+         a = vadd_u8(png_load_pixel(line + i, bpp),
+               vhadd_u8(a, png_load_pixel(prev + i, bpp)));
+         png_store_pixel(line + i, a, bpp);
+      }
+   }
+#endif
+
+   for (; i < bpp && i < pitch; i++)
+      line[i] += prev[i] >> 1;
+   for (; i < pitch; i++)
+      line[i] += (line[i - bpp] + prev[i]) >> 1;
+}
+
+static void png_reverse_filter_paeth(uint8_t *line,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i a          = zero;
+      __m128i c          = zero;
+
+      for (; i + bpp <= pitch; i += bpp)
+      {
+         __m128i b  = _mm_unpacklo_epi8(png_load_pixel(prev + i, bpp), zero);
+         __m128i pa = _mm_sub_epi16(b, c);
+         __m128i pb = _mm_sub_epi16(a, c);
+         __m128i pc = png_abs_epi16(_mm_add_epi16(pa, pb));
+         __m128i nearest;
+         __m128i d;
+
+         pa      = png_abs_epi16(pa);
+         pb      = png_abs_epi16(pb);
+
+         /* Same tie-breaking order as paeth(). */
+         nearest = png_select(_mm_cmpgt_epi16(pb, pc), c, b);
+         nearest = png_select(_mm_or_si128(_mm_cmpgt_epi16(pa, pb),
+                  _mm_cmpgt_epi16(pa, pc)), nearest, a);
+
+         d       = _mm_add_epi8(png_load_pixel(line + i, bpp),
+               _mm_packus_epi16(nearest, nearest));
+         png_store_pixel(line + i, d, bpp);
+
+         a       = _mm_unpacklo_epi8(d, zero);
+         c       = b;
+      }
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+      uint8x8_t c = vdup_n_u8(0);
+
+      for (; i + bpp <= pitch; i += bpp)
+      {
+         uint8x8_t b    = png_load_pixel(prev + i, bpp);
+         uint16x8_t pa  = vabdl_u8(b, c);
+         uint16x8_t pb  = vabdl_u8(a, c);
+         uint16x8_t pc  = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+         uint8x8_t use_a = vmovn_u16(vandq_u16(
+                  vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+         uint8x8_t use_b = vmovn_u16(vcleq_u16(pb, pc));
+         uint8x8_t nearest = vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+
+         a = vadd_u8(png_load_pixel(line + i, bpp), nearest);
+         png_store_pixel(line + i, a, bpp);
+         c = b;
+      }
+   }
+#endif
+
+   for (; i < bpp && i < pitch; i++)
+      line[i] += prev[i];
+   for (; i < pitch; i++)
+      line[i] += paeth(line[i - bpp], prev[i], prev[i - bpp]);
+}
+
 static void png_pass_geom(const struct png_ihdr *ihdr,
       unsigned width, unsigned height,
       unsigned *bpp_out, unsigned *pitch_out, size_t *pass_size)
@@ -304,9 +578,6 @@ static void png_reverse_filter_adam7_deinterlace_pass(uint32_t *data,
 
 static void png_reverse_filter_deinit(struct rpng_process_t *pngp)
 {
-   if (pngp->decoded_scanline)
-      free(pngp->decoded_scanline);
-   pngp->decoded_scanline = NULL;
    if (pngp->prev_scanline)
       free(pngp->prev_scanline);
    pngp->prev_scanline    = NULL;
@@ -375,10 +646,10 @@ static int png_reverse_filter_init(const struct png_ihdr *ihdr,
 
    pngp->restore_buf_size      = 0;
    pngp->data_restore_buf_size = 0;
+   /* The line above the first one is all zeroes. */
    pngp->prev_scanline    = (uint8_t*)calloc(1, pngp->pitch);
-   pngp->decoded_scanline = (uint8_t*)calloc(1, pngp->pitch);
 
-   if (!pngp->prev_scanline || !pngp->decoded_scanline)
+   if (!pngp->prev_scanline)
       goto error;
 
    pngp->h = 0;
@@ -394,41 +665,27 @@ error:
 static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
       struct rpng_process_t *pngp, unsigned filter)
 {
-   unsigned i;
+   /* Lines are unfiltered in place in the inflate buffer, so the
+    * previous line is the one just before the filter type byte. */
+   uint8_t *line       = pngp->inflate_buf;
+   const uint8_t *prev = pngp->h ?
+      line - 1 - pngp->pitch : pngp->prev_scanline;
 
    switch (filter)
    {
       case PNG_FILTER_NONE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_reverse_filter_sub(line, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_reverse_filter_up(line, prev, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_reverse_filter_average(line, prev, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_reverse_filter_paeth(line, prev, pngp->pitch, pngp->bpp);
          break;
 
       default:
@@ -438,26 +695,24 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
    switch (ihdr->color_type)
    {
       case PNG_IHDR_COLOR_GRAY:
-         png_reverse_filter_copy_line_bw(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_bw(data, line, ihdr->width, ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGB:
-         png_reverse_filter_copy_line_rgb(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgb(data, line, ihdr->width, ihdr->depth);
          break;
       case PNG_IHDR_COLOR_PLT:
-         png_reverse_filter_copy_line_plt(data, pngp->decoded_scanline, ihdr->width,
+         png_reverse_filter_copy_line_plt(data, line, ihdr->width,
                ihdr->depth, pngp->palette);
          break;
       case PNG_IHDR_COLOR_GRAY_ALPHA:
-         png_reverse_filter_copy_line_gray_alpha(data, pngp->decoded_scanline, ihdr->width,
+         png_reverse_filter_copy_line_gray_alpha(data, line, ihdr->width,
                ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGBA:
-         png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgba(data, line, ihdr->width, ihdr->depth);
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
-
    return PNG_PROCESS_NEXT;
 }
 
@@ -24,6 +24,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "rpng_common.h"
 
 #undef GOTO_END_ERROR
@@ -192,60 +196,65 @@ static unsigned filter_paeth(uint8_t *target,
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+/* Rows are filtered and deflated in bands, each band
+ * compressed as an independent block of one zlib stream,
+ * so that bands can be encoded in parallel. */
+#define RPNG_ENCODE_MAX_BANDS 8
+/* Smallest amount of filtered data worth a band of its own. */
+#define RPNG_ENCODE_MIN_BAND_SIZE (128 * 1024)
+
+struct rpng_encode_band
+{
+   const uint8_t *data;
+   unsigned width;
+   unsigned pitch;
+   unsigned bpp;
+   unsigned first_row;
+   unsigned num_rows;
+   bool last;
+
+   /* Filtered rows of the band. */
+   uint8_t *encoded;
+   size_t encoded_size;
+
+   /* IDAT chunk, with room for the chunk length and type
+    * in front and for the zlib header and checksum. */
+   uint8_t *idat;
+   size_t idat_size;
+   uint32_t adler;
+   bool ret;
+};
+
+static bool rpng_encode_filter_band(struct rpng_encode_band *band)
 {
    unsigned h;
    bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-
-   FILE *file = fopen(path, "wb");
-   if (!file)
-      GOTO_END_ERROR();
-
-   if (fwrite(png_magic, 1, sizeof(png_magic), file) != sizeof(png_magic))
-      GOTO_END_ERROR();
-
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
-
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
-
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
+   unsigned width          = band->width;
+   unsigned bpp            = band->bpp;
+   const uint8_t *data     = band->data + band->first_row * band->pitch;
+   uint8_t *encode_target  = band->encoded;
+   uint8_t *rgba_line      = (uint8_t*)malloc(width * bpp);
+   uint8_t *up_filtered    = (uint8_t*)malloc(width * bpp);
+   uint8_t *sub_filtered   = (uint8_t*)malloc(width * bpp);
+   uint8_t *avg_filtered   = (uint8_t*)malloc(width * bpp);
+   uint8_t *paeth_filtered = (uint8_t*)malloc(width * bpp);
+   uint8_t *prev_encoded   = (uint8_t*)calloc(1, width * bpp);
+
+   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered
+         || !paeth_filtered || !prev_encoded)
       GOTO_END_ERROR();
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+   /* Filters look at the row above, which belongs to the band before. */
+   if (band->first_row)
+   {
+      if (bpp == sizeof(uint32_t))
+         copy_argb_line(prev_encoded, (const uint32_t*)(data - band->pitch), width);
+      else
+         copy_bgr24_line(prev_encoded, data - band->pitch, width);
+   }
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   for (h = 0; h < band->num_rows;
+         h++, encode_target += width * bpp, data += band->pitch)
    {
       if (bpp == sizeof(uint32_t))
          copy_argb_line(rgba_line, (const uint32_t*)data, width);
@@ -302,37 +311,176 @@ static bool rpng_save_image(const char *path,
       memcpy(prev_encoded, rgba_line, width * bpp);
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+end:
+   free(rgba_line);
+   free(prev_encoded);
+   free(up_filtered);
+   free(sub_filtered);
+   free(avg_filtered);
+   free(paeth_filtered);
+   return ret;
+}
 
-   stream = zlib_stream_new();
+static bool rpng_encode_deflate_band(struct rpng_encode_band *band)
+{
+   bool ret           = true;
+   uint8_t *out       = NULL;
+   size_t header_size = band->first_row ? 8 : 8 + 2;
+   /* Worst case of stored blocks, plus the flush marker. */
+   size_t out_size    = band->encoded_size + (band->encoded_size >> 6) + 64;
+   void *stream       = zlib_stream_new();
 
    if (!stream)
       GOTO_END_ERROR();
 
-   zlib_set_stream(
-         stream,
-         encode_buf_size,
-         encode_buf_size * 2,
-         encode_buf,
-         deflate_buf + 8);
+   band->idat = (uint8_t*)malloc(header_size + out_size + 4);
+   if (!band->idat)
+      GOTO_END_ERROR();
 
-   zlib_deflate_init(stream, 9);
+   out = band->idat + header_size;
 
-   if (zlib_deflate_data_to_file(stream) != 1)
+   /* zlib header, for the best compression level. */
+   if (!band->first_row)
    {
-      zlib_stream_deflate_free(stream);
-      GOTO_END_ERROR();
+      band->idat[8] = 0x78;
+      band->idat[9] = 0xda;
    }
 
+   zlib_set_stream(stream, band->encoded_size, out_size,
+         band->encoded, out);
+   zlib_deflate_init2(stream, 9);
+
+   /* Only the last band ends the stream, the others end 
+    * on a byte boundary so the next one follows on. */
+   if (band->last)
+      ret = zlib_deflate_data_to_file(stream) == 1;
+   else
+      ret = zlib_deflate_data_flush(stream);
+
+   band->idat_size = header_size + zlib_stream_get_total_out(stream);
+   band->adler     = zlib_adler32_calculate(band->encoded, band->encoded_size);
    zlib_stream_deflate_free(stream);
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0, zlib_stream_get_total_out(stream));
-   if (!png_write_idat(file, deflate_buf, zlib_stream_get_total_out(stream) + 8))
+   if (!ret)
+      GOTO_END_ERROR();
+
+end:
+   free(stream);
+   return ret;
+}
+
+static void rpng_encode_band(void *data)
+{
+   struct rpng_encode_band *band = (struct rpng_encode_band*)data;
+
+   band->ret = rpng_encode_filter_band(band)
+      && rpng_encode_deflate_band(band);
+}
+
+static bool rpng_save_image(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+{
+   unsigned i, num_bands;
+   bool ret = true;
+   struct png_ihdr ihdr = {0};
+   struct rpng_encode_band bands[RPNG_ENCODE_MAX_BANDS] = {{0}};
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_ENCODE_MAX_BANDS] = {NULL};
+#endif
+   size_t line_size     = width * bpp + 1;
+   size_t encode_size   = line_size * height;
+   uint8_t *encode_buf  = NULL;
+   uint32_t adler       = 0;
+   unsigned first_row   = 0;
+
+   FILE *file = fopen(path, "wb");
+   if (!file)
+      GOTO_END_ERROR();
+
+   if (fwrite(png_magic, 1, sizeof(png_magic), file) != sizeof(png_magic))
+      GOTO_END_ERROR();
+
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
+
+   encode_buf = (uint8_t*)malloc(encode_size);
+   if (!encode_buf)
       GOTO_END_ERROR();
 
+#ifdef HAVE_THREADS
+   num_bands = encode_size / RPNG_ENCODE_MIN_BAND_SIZE;
+   if (num_bands > RPNG_ENCODE_MAX_BANDS)
+      num_bands = RPNG_ENCODE_MAX_BANDS;
+   if (num_bands > height)
+      num_bands = height;
+   if (!num_bands)
+      num_bands = 1;
+#else
+   num_bands = 1;
+#endif
+
+   for (i = 0; i < num_bands; i++)
+   {
+      struct rpng_encode_band *band = &bands[i];
+
+      band->data         = data;
+      band->width        = width;
+      band->pitch        = pitch;
+      band->bpp          = bpp;
+      band->first_row    = first_row;
+      band->num_rows     = height / num_bands + (i < height % num_bands);
+      band->last         = i == num_bands - 1;
+      band->encoded      = encode_buf + first_row * line_size;
+      band->encoded_size = band->num_rows * line_size;
+
+      first_row         += band->num_rows;
+   }
+
+#ifdef HAVE_THREADS
+   /* The first band is encoded on this thread. */
+   for (i = 1; i < num_bands; i++)
+      threads[i] = sthread_create(rpng_encode_band, &bands[i]);
+   rpng_encode_band(&bands[0]);
+
+   for (i = 1; i < num_bands; i++)
+   {
+      if (threads[i])
+         sthread_join(threads[i]);
+      else
+         rpng_encode_band(&bands[i]);
+   }
+#else
+   rpng_encode_band(&bands[0]);
+#endif
+
+   for (i = 0; i < num_bands; i++)
+   {
+      if (!bands[i].ret)
+         GOTO_END_ERROR();
+
+      adler = i ? zlib_adler32_combine(adler, bands[i].adler,
+            bands[i].encoded_size) : bands[i].adler;
+   }
+
+   /* zlib checksum of the whole stream ends the last band. */
+   dword_write_be(bands[num_bands - 1].idat + bands[num_bands - 1].idat_size,
+         adler);
+   bands[num_bands - 1].idat_size += 4;
+
+   /* One IDAT chunk per band, the decoder joins them up. */
+   for (i = 0; i < num_bands; i++)
+   {
+      memcpy(bands[i].idat + 4, "IDAT", 4);
+      dword_write_be(bands[i].idat + 0, bands[i].idat_size - 8);
+      if (!png_write_idat(file, bands[i].idat, bands[i].idat_size))
+         GOTO_END_ERROR();
+   }
+
    if (!png_write_iend(file))
       GOTO_END_ERROR();
 
@@ -340,15 +488,8 @@ end:
    if (file)
       fclose(file);
    free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   zlib_stream_free(stream);
+   for (i = 0; i < RPNG_ENCODE_MAX_BANDS; i++)
+      free(bands[i].idat);
    return ret;
 }
 
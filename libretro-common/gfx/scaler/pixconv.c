@@ -29,6 +29,11 @@
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __AVX2__
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
 #endif
 
 #if defined(__SSE2__)
@@ -93,7 +98,46 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
 
 #endif
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+void conv_0rgb1555_rgb565(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
+
+   int max_width = width - 15;
+
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w < max_width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+         __m256i b    = _mm256_and_si256(in, lo_mask);
+         __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint16_t col = input[w];
+         uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
+         uint16_t b = col & 0x1f;
+         uint16_t glow = (col >> 4) & (1 << 5);
+         output[w] = rg | b | glow;
+      }
+   }
+}
+#elif defined(__SSE2__)
 void conv_0rgb1555_rgb565(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -156,7 +200,70 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
 }
 #endif
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+void conv_0rgb1555_argb8888(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
+   const __m256i a           = _mm256_set1_epi16(0x00ff);
+
+   int max_width = width - 15;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w < max_width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(in, pix_mask_r);
+         __m256i g = _mm256_and_si256(in, pix_mask_gb);
+         __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb);
+
+         r = _mm256_mulhi_epi16(r, mul15_hi);
+         g = _mm256_mulhi_epi16(g, mul15_mid);
+         b = _mm256_mulhi_epi16(b, mul15_mid);
+
+         /* Unpacking works within each 128-bit lane, so the 
+          * lanes hold pixels 0-3, 8-11 and 4-7, 12-15. */
+         __m256i res_lo_bg = _mm256_unpacklo_epi8(b, g);
+         __m256i res_hi_bg = _mm256_unpackhi_epi8(b, g);
+         __m256i res_lo_ra = _mm256_unpacklo_epi8(r, a);
+         __m256i res_hi_ra = _mm256_unpackhi_epi8(r, a);
+
+         __m256i res_lo = _mm256_or_si256(res_lo_bg,
+               _mm256_slli_si256(res_lo_ra, 2));
+         __m256i res_hi = _mm256_or_si256(res_hi_bg,
+               _mm256_slli_si256(res_hi_ra, 2));
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r = (col >> 10) & 0x1f;
+         uint32_t g = (col >>  5) & 0x1f;
+         uint32_t b = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 3) | (g >> 2);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+#elif defined(__SSE2__)
 void conv_0rgb1555_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -243,7 +350,72 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
 }
 #endif
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+void conv_rgb565_argb8888(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g  = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b  = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r     = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g     = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b     = _mm256_set1_epi16(0x4200);
+   const __m256i a           = _mm256_set1_epi16(0x00ff);
+
+   int max_width = width - 15;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w < max_width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r);
+         __m256i g = _mm256_and_si256(in, pix_mask_g);
+         __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b);
+
+         r = _mm256_mulhi_epi16(r, mul16_r);
+         g = _mm256_mulhi_epi16(g, mul16_g);
+         b = _mm256_mulhi_epi16(b, mul16_b);
+
+         /* Unpacking works within each 128-bit lane, so the 
+          * lanes hold pixels 0-3, 8-11 and 4-7, 12-15. */
+         __m256i res_lo_bg = _mm256_unpacklo_epi8(b, g);
+         __m256i res_hi_bg = _mm256_unpackhi_epi8(b, g);
+         __m256i res_lo_ra = _mm256_unpacklo_epi8(r, a);
+         __m256i res_hi_ra = _mm256_unpackhi_epi8(r, a);
+
+         __m256i res_lo = _mm256_or_si256(res_lo_bg,
+               _mm256_slli_si256(res_lo_ra, 2));
+         __m256i res_hi = _mm256_or_si256(res_hi_bg,
+               _mm256_slli_si256(res_hi_ra, 2));
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r = (col >> 11) & 0x1f;
+         uint32_t g = (col >>  5) & 0x3f;
+         uint32_t b = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 2) | (g >> 4);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+#elif defined(__SSE2__)
 void conv_rgb565_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -250,10 +250,9 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
-   scaler_free(ctx->horiz.filter);
-   scaler_free(ctx->horiz.filter_pos);
-   scaler_free(ctx->vert.filter);
-   scaler_free(ctx->vert.filter_pos);
+   /* Filters may be shared through the cache. */
+   scaler_filter_release(&ctx->horiz);
+   scaler_filter_release(&ctx->vert);
    scaler_free(ctx->scaled.frame);
    scaler_free(ctx->input.frame);
    scaler_free(ctx->output.frame);
@@ -328,3 +327,33 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
             ctx->out_width, ctx->out_height,
             ctx->out_stride, ctx->output.stride);
 }
+
+/**
+ * scaler_ctx_scale_rows:
+ * @ctx          : pointer to scaler context object.
+ * @output       : pointer to output image.
+ * @input        : pointer to input image.
+ * @first_row    : first row to convert.
+ * @rows         : number of rows to convert.
+ *
+ * Converts only some of the rows of an image, so the work can be 
+ * split up between threads. Rows of a scaled image depend on 
+ * their neighbours, so this only works for contexts that just 
+ * convert pixel formats.
+ *
+ * Returns: true if the rows were converted, false if @ctx scales.
+ **/
+bool scaler_ctx_scale_rows(struct scaler_ctx *ctx,
+      void *output, const void *input,
+      int first_row, int rows)
+{
+   if (!ctx->unscaled)
+      return false;
+
+   ctx->direct_pixconv(
+         (uint8_t*)output + first_row * ctx->out_stride,
+         (const uint8_t*)input + first_row * ctx->in_stride,
+         ctx->out_width, rows,
+         ctx->out_stride, ctx->in_stride);
+   return true;
+}
@@ -28,15 +28,53 @@
 #include <string.h>
 #include <retro_inline.h>
 
-static bool allocate_filters(struct scaler_ctx *ctx)
+/* Filters only depend on the scaler type and the sizes of one axis,
+ * so they are shared between contexts, and kept around for a while
+ * once the last context using them is gone. Screenshots and recording
+ * tend to set up contexts for the same sizes over and over. */
+#define SCALER_FILTER_CACHE_SIZE 8
+
+/* Only built where a lock is cheap to come by,
+ * contexts might be set up from several threads. */
+#if defined(__GNUC__)
+#define HAVE_SCALER_FILTER_CACHE
+#endif
+
+#ifdef HAVE_SCALER_FILTER_CACHE
+struct scaler_filter_cache_entry
 {
-   ctx->horiz.filter     = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->horiz.filter_stride * ctx->out_width);
-   ctx->horiz.filter_pos = (int*)scaler_alloc(sizeof(int), ctx->out_width);
+   enum scaler_type type;
+   int in_len;
+   int out_len;
+   int filter_len;
+   unsigned refs;
+   unsigned last_use;
+   int16_t *filter;
+   int *filter_pos;
+};
+
+static struct scaler_filter_cache_entry filter_cache[SCALER_FILTER_CACHE_SIZE];
+static unsigned filter_cache_time;
+static volatile int filter_cache_lock;
+
+static void scaler_filter_cache_lock(void)
+{
+   while (__sync_lock_test_and_set(&filter_cache_lock, 1))
+      while (filter_cache_lock);
+}
 
-   ctx->vert.filter      = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->vert.filter_stride * ctx->out_height);
-   ctx->vert.filter_pos  = (int*)scaler_alloc(sizeof(int), ctx->out_height);
+static void scaler_filter_cache_unlock(void)
+{
+   __sync_lock_release(&filter_cache_lock);
+}
+#endif
 
-   return ctx->horiz.filter && ctx->vert.filter;
+static bool allocate_filter(struct scaler_filter *filter, int out_len)
+{
+   filter->filter     = (int16_t*)scaler_alloc(sizeof(int16_t), filter->filter_stride * out_len);
+   filter->filter_pos = (int*)scaler_alloc(sizeof(int), out_len);
+
+   return filter->filter && filter->filter_pos;
 }
 
 static void gen_filter_point_sub(struct scaler_filter *filter,
@@ -50,29 +88,13 @@ static void gen_filter_point_sub(struct scaler_filter *filter,
    }
 }
 
-static bool gen_filter_point(struct scaler_ctx *ctx)
+static void gen_filter_point(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
-   int x_pos, x_step, y_pos, y_step;
-
-   ctx->horiz.filter_len    = 1;
-   ctx->horiz.filter_stride = 1;
-   ctx->vert.filter_len     = 1;
-   ctx->vert.filter_stride  = 1;
+   int pos  = (1 << 15) * in_len / out_len - (1 << 15);
+   int step = (1 << 16) * in_len / out_len;
 
-   if (!allocate_filters(ctx))
-      return false;
-
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
-
-   gen_filter_point_sub(&ctx->horiz, ctx->out_width, x_pos, x_step);
-   gen_filter_point_sub(&ctx->vert, ctx->out_height, y_pos, y_step);
-
-   ctx->scaler_special = scaler_argb8888_point_special;
-
-   return true;
+   gen_filter_point_sub(filter, out_len, pos, step);
 }
 
 static void gen_filter_bilinear_sub(struct scaler_filter *filter,
@@ -87,27 +109,13 @@ static void gen_filter_bilinear_sub(struct scaler_filter *filter,
    }
 }
 
-static bool gen_filter_bilinear(struct scaler_ctx *ctx)
+static void gen_filter_bilinear(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
-   int x_pos, x_step, y_pos, y_step;
-
-   ctx->horiz.filter_len    = 2;
-   ctx->horiz.filter_stride = 2;
-   ctx->vert.filter_len     = 2;
-   ctx->vert.filter_stride  = 2;
+   int pos  = (1 << 15) * in_len / out_len - (1 << 15);
+   int step = (1 << 16) * in_len / out_len;
 
-   if (!allocate_filters(ctx))
-      return false;
-
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
-
-   gen_filter_bilinear_sub(&ctx->horiz, ctx->out_width, x_pos, x_step);
-   gen_filter_bilinear_sub(&ctx->vert, ctx->out_height, y_pos, y_step);
-
-   return true;
+   gen_filter_bilinear_sub(filter, out_len, pos, step);
 }
 
 static INLINE double filter_sinc(double phase)
@@ -141,60 +149,111 @@ static void gen_filter_sinc_sub(struct scaler_filter *filter,
    }
 }
 
-static bool gen_filter_sinc(struct scaler_ctx *ctx)
+static void gen_filter_sinc(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
-   int x_pos, x_step, y_pos, y_step;
-   double phase_mul_horiz, phase_mul_vert;
-   /* Need to expand the filter when downsampling 
-    * to get a proper low-pass effect. */
-   const int sinc_size      = 8 * ((ctx->in_width > ctx->out_width)
-         ? next_pow2(ctx->in_width / ctx->out_width) : 1);
-
-   ctx->horiz.filter_len    = sinc_size;
-   ctx->horiz.filter_stride = sinc_size;
-   ctx->vert.filter_len     = sinc_size;
-   ctx->vert.filter_stride  = sinc_size;
-
-   if (!allocate_filters(ctx))
-      return false;
+   const int sinc_size = filter->filter_len;
+   int pos             = (1 << 15) * in_len / out_len - (1 << 15) - (sinc_size << 15);
+   int step            = (1 << 16) * in_len / out_len;
+   double phase_mul    = in_len > out_len ? (double)out_len / in_len : 1.0;
 
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15) - (sinc_size << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15) - (sinc_size << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
+   gen_filter_sinc_sub(filter, out_len, pos, step, phase_mul);
+}
 
-   phase_mul_horiz = ctx->in_width  > ctx->out_width  ? (double)ctx->out_width  / ctx->in_width  : 1.0;
-   phase_mul_vert  = ctx->in_height > ctx->out_height ? (double)ctx->out_height / ctx->in_height : 1.0;
+/* Lanczos-3, widened by the downscaling ratio to low-pass.
+ * Taps which fall outside of the input are folded onto the edge,
+ * and the coefficients of every output sample add up to exactly
+ * FILTER_UNITY, so flat areas and edges keep their brightness. */
+#define LANCZOS_RADIUS 3
 
-   gen_filter_sinc_sub(&ctx->horiz, ctx->out_width, x_pos, x_step, phase_mul_horiz);
-   gen_filter_sinc_sub(&ctx->vert, ctx->out_height, y_pos, y_step, phase_mul_vert);
+static int lanczos_filter_len(int in_len, int out_len)
+{
+   double scale = in_len > out_len ? (double)in_len / out_len : 1.0;
+   /* Even, so the SIMD kernels don't need to take a single tap at the end. */
+   int len      = 2 * (int)ceil(LANCZOS_RADIUS * scale);
 
-   return true;
+   return len < in_len ? len : in_len;
 }
 
+static INLINE double filter_lanczos(double x)
+{
+   if (fabs(x) >= LANCZOS_RADIUS)
+      return 0.0;
+   return filter_sinc(M_PI * x) * filter_sinc(M_PI * x / LANCZOS_RADIUS);
+}
 
-static bool validate_filter(struct scaler_ctx *ctx)
+static bool gen_filter_lanczos(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
-   int i;
-   int max_h_pos;
-   int max_w_pos = ctx->in_width - ctx->horiz.filter_len;
+   int i, j;
+   const int len      = filter->filter_len;
+   const double ratio = (double)in_len / out_len;
+   const double scale = ratio > 1.0 ? ratio : 1.0;
+   double *weights    = (double*)scaler_alloc(sizeof(double), len);
 
-   for (i = 0; i < ctx->out_width; i++)
+   if (!weights)
+      return false;
+
+   for (i = 0; i < out_len; i++)
    {
-      if (ctx->horiz.filter_pos[i] > max_w_pos || ctx->horiz.filter_pos[i] < 0)
+      int first, start, sum = 0, peak = 0;
+      double total   = 0.0;
+      int16_t *coeff = filter->filter + i * filter->filter_stride;
+      /* Center of the output sample, in input samples. */
+      double center  = (i + 0.5) * ratio - 0.5;
+
+      first = (int)floor(center) - len / 2 + 1;
+      start = first;
+      if (start > in_len - len)
+         start = in_len - len;
+      if (start < 0)
+         start = 0;
+
+      for (j = 0; j < len; j++)
+         weights[j] = 0.0;
+
+      for (j = 0; j < len; j++)
       {
-         fprintf(stderr, "Out X = %d => In X = %d\n", i, ctx->horiz.filter_pos[i]); 
-         return false;
+         int x = first + j;
+         double w = filter_lanczos((x - center) / scale);
+
+         if (x < 0)
+            x = 0;
+         else if (x >= in_len)
+            x = in_len - 1;
+
+         weights[x - start] += w;
+         total += w;
       }
+
+      for (j = 0; j < len; j++)
+      {
+         coeff[j] = (int16_t)floor(weights[j] / total * FILTER_UNITY + 0.5);
+         sum     += coeff[j];
+         if (coeff[j] > coeff[peak])
+            peak = j;
+      }
+
+      /* Rounding leftovers go to the largest tap. */
+      coeff[peak] += FILTER_UNITY - sum;
+      filter->filter_pos[i] = start;
    }
 
-   max_h_pos = ctx->in_height - ctx->vert.filter_len;
+   scaler_free(weights);
+   return true;
+}
 
-   for (i = 0; i < ctx->out_height; i++)
+static bool validate_filter(const struct scaler_filter *filter,
+      int in_len, int out_len, char axis)
+{
+   int i;
+   int max_pos = in_len - filter->filter_len;
+
+   for (i = 0; i < out_len; i++)
    {
-      if (ctx->vert.filter_pos[i] > max_h_pos || ctx->vert.filter_pos[i] < 0)
+      if (filter->filter_pos[i] > max_pos || filter->filter_pos[i] < 0)
       {
-         fprintf(stderr, "Out Y = %d => In Y = %d\n", i, ctx->vert.filter_pos[i]); 
+         fprintf(stderr, "Out %c = %d => In %c = %d\n", axis, i, axis, filter->filter_pos[i]);
          return false;
       }
    }
@@ -202,6 +261,7 @@ static bool validate_filter(struct scaler_ctx *ctx)
    return true;
 }
 
+/* Makes sure that we never sample outside our rectangle. */
 static void fixup_filter_sub(struct scaler_filter *filter, int out_len, int in_len)
 {
    int i;
@@ -247,41 +307,188 @@ static void fixup_filter_sub(struct scaler_filter *filter, int out_len, int in_l
    }
 }
 
-/* Makes sure that we never sample outside our rectangle. */
-static void fixup_filter(struct scaler_ctx *ctx)
+static bool gen_filter_axis(struct scaler_filter *filter,
+      enum scaler_type type, int in_len, int out_len, char axis)
 {
-   fixup_filter_sub(&ctx->horiz, ctx->out_width, ctx->in_width);
-   fixup_filter_sub(&ctx->vert, ctx->out_height, ctx->in_height);
+   if (!allocate_filter(filter, out_len))
+      return false;
+
+   switch (type)
+   {
+      case SCALER_TYPE_POINT:
+         gen_filter_point(filter, in_len, out_len);
+         break;
+      case SCALER_TYPE_BILINEAR:
+         gen_filter_bilinear(filter, in_len, out_len);
+         break;
+      case SCALER_TYPE_SINC:
+         gen_filter_sinc(filter, in_len, out_len);
+         break;
+      case SCALER_TYPE_LANCZOS3:
+         if (!gen_filter_lanczos(filter, in_len, out_len))
+            return false;
+         break;
+      default:
+         return false;
+   }
+
+   fixup_filter_sub(filter, out_len, in_len);
+
+   return validate_filter(filter, in_len, out_len, axis);
 }
 
+/**
+ * scaler_filter_get:
+ * @filter       : Filter of one axis, with filter_len and filter_stride set.
+ * @type         : Scaler type.
+ * @in_len       : Input size along the axis.
+ * @out_len      : Output size along the axis.
+ * @axis         : 'X' or 'Y', for error messages.
+ *
+ * Looks up the filter in the cache, or generates it.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool scaler_filter_get(struct scaler_filter *filter,
+      enum scaler_type type, int in_len, int out_len, char axis)
+{
+#ifdef HAVE_SCALER_FILTER_CACHE
+   unsigned i;
+   struct scaler_filter_cache_entry *entry = NULL;
+
+   scaler_filter_cache_lock();
+
+   for (i = 0; i < SCALER_FILTER_CACHE_SIZE; i++)
+   {
+      entry = &filter_cache[i];
+
+      if (entry->filter && entry->type == type && entry->in_len == in_len
+            && entry->out_len == out_len && entry->filter_len == filter->filter_len)
+      {
+         entry->refs++;
+         entry->last_use    = ++filter_cache_time;
+         filter->filter     = entry->filter;
+         filter->filter_pos = entry->filter_pos;
+         scaler_filter_cache_unlock();
+         return true;
+      }
+   }
+
+   scaler_filter_cache_unlock();
+#endif
+
+   if (!gen_filter_axis(filter, type, in_len, out_len, axis))
+      return false;
+
+#ifdef HAVE_SCALER_FILTER_CACHE
+   scaler_filter_cache_lock();
+
+   /* Takes the free slot, or the one unused for the longest. */
+   entry = NULL;
+   for (i = 0; i < SCALER_FILTER_CACHE_SIZE; i++)
+   {
+      struct scaler_filter_cache_entry *cur = &filter_cache[i];
+
+      if (cur->refs)
+         continue;
+      if (!entry || !cur->filter || (entry->filter && cur->last_use < entry->last_use))
+         entry = cur;
+   }
+
+   if (entry)
+   {
+      scaler_free(entry->filter);
+      scaler_free(entry->filter_pos);
+
+      entry->type       = type;
+      entry->in_len     = in_len;
+      entry->out_len    = out_len;
+      entry->filter_len = filter->filter_len;
+      entry->refs       = 1;
+      entry->last_use   = ++filter_cache_time;
+      entry->filter     = filter->filter;
+      entry->filter_pos = filter->filter_pos;
+   }
+
+   scaler_filter_cache_unlock();
+#endif
+
+   return true;
+}
+
+/**
+ * scaler_filter_release:
+ * @filter       : Filter of one axis.
+ *
+ * Gives back a filter from scaler_gen_filter(), freeing it
+ * unless it stays in the cache.
+ **/
+void scaler_filter_release(struct scaler_filter *filter)
+{
+#ifdef HAVE_SCALER_FILTER_CACHE
+   unsigned i;
+
+   if (!filter->filter)
+      return;
+
+   scaler_filter_cache_lock();
+
+   for (i = 0; i < SCALER_FILTER_CACHE_SIZE; i++)
+   {
+      if (filter_cache[i].filter == filter->filter)
+      {
+         filter_cache[i].refs--;
+         scaler_filter_cache_unlock();
+         return;
+      }
+   }
+
+   scaler_filter_cache_unlock();
+#endif
+
+   scaler_free(filter->filter);
+   scaler_free(filter->filter_pos);
+}
 
 bool scaler_gen_filter(struct scaler_ctx *ctx)
 {
-   bool ret = true;
+   /* Need to expand the filter when downsampling
+    * to get a proper low-pass effect. */
+   const int sinc_size = 8 * ((ctx->in_width > ctx->out_width)
+         ? next_pow2(ctx->in_width / ctx->out_width) : 1);
 
    switch (ctx->scaler_type)
    {
       case SCALER_TYPE_POINT:
-         ret = gen_filter_point(ctx);
+         ctx->horiz.filter_len = 1;
+         ctx->vert.filter_len  = 1;
+         ctx->scaler_special   = scaler_argb8888_point_special;
          break;
 
       case SCALER_TYPE_BILINEAR:
-         ret = gen_filter_bilinear(ctx);
+         ctx->horiz.filter_len = 2;
+         ctx->vert.filter_len  = 2;
          break;
 
       case SCALER_TYPE_SINC:
-         ret = gen_filter_sinc(ctx);
+         ctx->horiz.filter_len = sinc_size;
+         ctx->vert.filter_len  = sinc_size;
+         break;
+
+      case SCALER_TYPE_LANCZOS3:
+         ctx->horiz.filter_len = lanczos_filter_len(ctx->in_width, ctx->out_width);
+         ctx->vert.filter_len  = lanczos_filter_len(ctx->in_height, ctx->out_height);
          break;
 
       default:
          return false;
    }
 
-   if (!ret)
-      return false;
-
-   fixup_filter(ctx);
+   ctx->horiz.filter_stride = ctx->horiz.filter_len;
+   ctx->vert.filter_stride  = ctx->vert.filter_len;
 
-   return validate_filter(ctx);
+   return scaler_filter_get(&ctx->horiz, ctx->scaler_type,
+         ctx->in_width, ctx->out_width, 'X')
+      && scaler_filter_get(&ctx->vert, ctx->scaler_type,
+         ctx->in_height, ctx->out_height, 'Y');
 }
-
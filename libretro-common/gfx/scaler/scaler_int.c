@@ -20,6 +20,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <string.h>
+
 #include <gfx/scaler/scaler_int.h>
 #include <retro_inline.h>
 
@@ -34,6 +36,53 @@
 #endif
 #endif
 
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define SCALER_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// AVX2 kernels are built regardless of the compiler flags,
+// and only picked when the CPU reports support for it.
+#if defined(__SSE2__) && defined(__GNUC__) && \
+   (defined(__x86_64__) || defined(__i386__)) && \
+   (defined(__clang__) || __GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SCALER_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#define SCALER_SIMD_VECTOR (1 << 0) /* SSE2 or NEON */
+#define SCALER_SIMD_AVX2   (1 << 1)
+
+#ifdef SCALER_TEST
+unsigned scaler_test_get_simd(void);
+#endif
+
+static unsigned scaler_get_simd(void)
+{
+#ifdef SCALER_TEST
+   return scaler_test_get_simd();
+#else
+   unsigned simd = 0;
+#if defined(__SSE2__) || defined(SCALER_HAVE_NEON)
+   simd |= SCALER_SIMD_VECTOR;
+#endif
+#ifdef SCALER_HAVE_AVX2
+   {
+      static int avx2 = -1;
+      if (avx2 < 0)
+      {
+         __builtin_cpu_init();
+         avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+      }
+      if (avx2)
+         simd |= SCALER_SIMD_AVX2;
+   }
+#endif
+   return simd;
+#endif
+}
+
 // ARGB8888 scaler is split in two:
 //
 // First, horizontal scaler is applied.
@@ -50,9 +99,13 @@
 // Scaling is now complete. Channels are shifted right by 3, and saturated into 8-bit values.
 //
 // The C version of scalers perform the exact same operations as the SIMD code for testing purposes.
+//
+// Every output pixel of a row shares the coefficients of the vertical filter,
+// so the SIMD versions of the vertical scaler work on several pixels at once.
+// The rows of the intermediate frame are padded to 8 pixels, which they can read past the width into.
+// Even and odd taps are summed up apart, and then added, in every version.
 
-#if defined(__SSE2__)
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+static void scaler_argb8888_vert_C(const struct scaler_ctx *ctx, void *output_, int stride)
 {
    int h, w, y;
    const uint64_t *input = ctx->scaled.frame;
@@ -66,145 +119,246 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
       for (w = 0; w < ctx->out_width; w++)
       {
-         __m128i res = _mm_setzero_si128();
+         int16_t res_a = 0;
+         int16_t res_r = 0;
+         int16_t res_g = 0;
+         int16_t res_b = 0;
 
          const uint64_t *input_base_y = input_base + w;
-
-         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+            uint64_t col = *input_base_y;
+
+            int16_t a = (col >> 48) & 0xffff;
+            int16_t r = (col >> 32) & 0xffff;
+            int16_t g = (col >> 16) & 0xffff;
+            int16_t b = (col >>  0) & 0xffff;
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+            int16_t coeff = filter_vert[y];
+
+            res_a += (a * coeff) >> 16;
+            res_r += (r * coeff) >> 16;
+            res_g += (g * coeff) >> 16;
+            res_b += (b * coeff) >> 16;
          }
 
-         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         res_a >>= (7 - 2 - 2);
+         res_r >>= (7 - 2 - 2);
+         res_g >>= (7 - 2 - 2);
+         res_b >>= (7 - 2 - 2);
+
+         output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
+      }
+   }
+}
+
+#if defined(__SSE2__)
+static void scaler_argb8888_vert_sse2(const struct scaler_ctx *ctx, void *output_, int stride)
+{
+   int h, w, y;
+   const uint64_t *input = ctx->scaled.frame;
+   uint32_t *output = (uint32_t*)output_;
+   const int in_stride = ctx->scaled.stride >> 3;
+
+   const int16_t *filter_vert = ctx->vert.filter;
+
+   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * in_stride;
+
+      // Two pixels at a time.
+      for (w = 0; w < ctx->out_width; w += 2)
+      {
+         __m128i res_even = _mm_setzero_si128();
+         __m128i res_odd  = _mm_setzero_si128();
+
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += 2 * in_stride)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+            __m128i col_even = _mm_loadu_si128((const __m128i*)input_base_y);
+            __m128i col_odd  = _mm_loadu_si128((const __m128i*)(input_base_y + in_stride));
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+            res_even = _mm_adds_epi16(_mm_mulhi_epi16(col_even, _mm_set1_epi16(filter_vert[y + 0])), res_even);
+            res_odd  = _mm_adds_epi16(_mm_mulhi_epi16(col_odd,  _mm_set1_epi16(filter_vert[y + 1])), res_odd);
          }
 
-         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
-         res = _mm_srai_epi16(res, (7 - 2 - 2));
+         for (; y < ctx->vert.filter_len; y++, input_base_y += in_stride)
+         {
+            __m128i col = _mm_loadu_si128((const __m128i*)input_base_y);
+            res_even = _mm_adds_epi16(_mm_mulhi_epi16(col, _mm_set1_epi16(filter_vert[y])), res_even);
+         }
 
-         __m128i final = _mm_packus_epi16(res, res);
+         res_even = _mm_adds_epi16(res_odd, res_even);
+         res_even = _mm_srai_epi16(res_even, (7 - 2 - 2));
+         res_even = _mm_packus_epi16(res_even, res_even);
 
-         output[w] = _mm_cvtsi128_si32(final);
+         if (w + 1 < ctx->out_width)
+            _mm_storel_epi64((__m128i*)(output + w), res_even);
+         else
+            output[w] = _mm_cvtsi128_si32(res_even);
       }
    }
 }
-#else
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+#endif
+
+#ifdef SCALER_HAVE_AVX2
+__attribute__((target("avx2")))
+static void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx, void *output_, int stride)
 {
    int h, w, y;
    const uint64_t *input = ctx->scaled.frame;
    uint32_t *output = (uint32_t*)output_;
+   const int in_stride = ctx->scaled.stride >> 3;
 
    const int16_t *filter_vert = ctx->vert.filter;
 
    for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * in_stride;
 
-      for (w = 0; w < ctx->out_width; w++)
+      // Four pixels at a time.
+      for (w = 0; w < ctx->out_width; w += 4)
       {
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         __m128i final;
+         __m256i res_even = _mm256_setzero_si256();
+         __m256i res_odd  = _mm256_setzero_si256();
 
          const uint64_t *input_base_y = input_base + w;
-         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
-         {
-            uint64_t col = *input_base_y;
 
-            int16_t a = (col >> 48) & 0xffff;
-            int16_t r = (col >> 32) & 0xffff;
-            int16_t g = (col >> 16) & 0xffff;
-            int16_t b = (col >>  0) & 0xffff;
+         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += 2 * in_stride)
+         {
+            __m256i col_even = _mm256_loadu_si256((const __m256i*)input_base_y);
+            __m256i col_odd  = _mm256_loadu_si256((const __m256i*)(input_base_y + in_stride));
 
-            int16_t coeff = filter_vert[y];
+            res_even = _mm256_adds_epi16(_mm256_mulhi_epi16(col_even, _mm256_set1_epi16(filter_vert[y + 0])), res_even);
+            res_odd  = _mm256_adds_epi16(_mm256_mulhi_epi16(col_odd,  _mm256_set1_epi16(filter_vert[y + 1])), res_odd);
+         }
 
-            res_a += (a * coeff) >> 16;
-            res_r += (r * coeff) >> 16;
-            res_g += (g * coeff) >> 16;
-            res_b += (b * coeff) >> 16;
+         for (; y < ctx->vert.filter_len; y++, input_base_y += in_stride)
+         {
+            __m256i col = _mm256_loadu_si256((const __m256i*)input_base_y);
+            res_even = _mm256_adds_epi16(_mm256_mulhi_epi16(col, _mm256_set1_epi16(filter_vert[y])), res_even);
          }
 
-         res_a >>= (7 - 2 - 2);
-         res_r >>= (7 - 2 - 2);
-         res_g >>= (7 - 2 - 2);
-         res_b >>= (7 - 2 - 2);
+         res_even = _mm256_adds_epi16(res_odd, res_even);
+         res_even = _mm256_srai_epi16(res_even, (7 - 2 - 2));
+         // Packing works within 128-bit lanes, gather both halves into the low lane.
+         res_even = _mm256_packus_epi16(res_even, res_even);
+         res_even = _mm256_permute4x64_epi64(res_even, _MM_SHUFFLE(3, 1, 2, 0));
+         final    = _mm256_castsi256_si128(res_even);
 
-         output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
+         if (w + 3 < ctx->out_width)
+            _mm_storeu_si128((__m128i*)(output + w), final);
+         else
+         {
+            int i;
+            uint32_t pixels[4];
+            _mm_storeu_si128((__m128i*)pixels, final);
+            for (i = 0; w + i < ctx->out_width; i++)
+               output[w + i] = pixels[i];
+         }
       }
    }
 }
 #endif
 
-#if defined(__SSE2__)
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+#ifdef SCALER_HAVE_NEON
+static void scaler_argb8888_vert_neon(const struct scaler_ctx *ctx, void *output_, int stride)
 {
-   int h, w, x;
-   const uint32_t *input = (const uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   int h, w, y;
+   const uint64_t *input = ctx->scaled.frame;
+   uint32_t *output = (uint32_t*)output_;
+   const int in_stride = ctx->scaled.stride >> 3;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   const int16_t *filter_vert = ctx->vert.filter;
+
+   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const int16_t *filter_horiz = ctx->horiz.filter;
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * in_stride;
 
-      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      // Two pixels at a time.
+      for (w = 0; w < ctx->out_width; w += 2)
       {
-         __m128i res = _mm_setzero_si128();
+         uint8x8_t final;
+         int16x8_t res_even = vdupq_n_s16(0);
+         int16x8_t res_odd  = vdupq_n_s16(0);
 
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+         const uint64_t *input_base_y = input_base + w;
 
-         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += 2 * in_stride)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
-
-            __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
-                     ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
-
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+            int16x8_t col_even = vld1q_s16((const int16_t*)input_base_y);
+            int16x8_t col_odd  = vld1q_s16((const int16_t*)(input_base_y + in_stride));
+            int16x4_t coeff_even = vdup_n_s16(filter_vert[y + 0]);
+            int16x4_t coeff_odd  = vdup_n_s16(filter_vert[y + 1]);
+
+            res_even = vqaddq_s16(vcombine_s16(
+                     vshrn_n_s32(vmull_s16(vget_low_s16(col_even),  coeff_even), 16),
+                     vshrn_n_s32(vmull_s16(vget_high_s16(col_even), coeff_even), 16)), res_even);
+            res_odd  = vqaddq_s16(vcombine_s16(
+                     vshrn_n_s32(vmull_s16(vget_low_s16(col_odd),  coeff_odd), 16),
+                     vshrn_n_s32(vmull_s16(vget_high_s16(col_odd), coeff_odd), 16)), res_odd);
          }
 
-         for (; x < ctx->horiz.filter_len; x++)
+         for (; y < ctx->vert.filter_len; y++, input_base_y += in_stride)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
-            __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
+            int16x8_t col   = vld1q_s16((const int16_t*)input_base_y);
+            int16x4_t coeff = vdup_n_s16(filter_vert[y]);
 
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+            res_even = vqaddq_s16(vcombine_s16(
+                     vshrn_n_s32(vmull_s16(vget_low_s16(col),  coeff), 16),
+                     vshrn_n_s32(vmull_s16(vget_high_s16(col), coeff), 16)), res_even);
          }
 
-         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         // Shift and saturate into 8-bit values in one go.
+         final = vqshrun_n_s16(vqaddq_s16(res_odd, res_even), (7 - 2 - 2));
 
-#ifdef __x86_64__
-         output[w] = _mm_cvtsi128_si64(res);
-#else // 32-bit doesn't have si64. Do it in two steps.
-         union
-         {
-            uint32_t *u32;
-            uint64_t *u64;
-         } u;
-         u.u64 = output + w;
-         u.u32[0] = _mm_cvtsi128_si32(res);
-         u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
-#endif
+         if (w + 1 < ctx->out_width)
+            vst1_u8((uint8_t*)(output + w), final);
+         else
+            vst1_lane_u32(output + w, vreinterpret_u32_u8(final), 0);
       }
    }
 }
-#else
+#endif
+
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+{
+   unsigned simd = scaler_get_simd();
+
+   (void)simd;
+
+#ifdef SCALER_HAVE_AVX2
+   if (simd & SCALER_SIMD_AVX2)
+   {
+      scaler_argb8888_vert_avx2(ctx, output_, stride);
+      return;
+   }
+#endif
+#if defined(__SSE2__)
+   if (simd & SCALER_SIMD_VECTOR)
+   {
+      scaler_argb8888_vert_sse2(ctx, output_, stride);
+      return;
+   }
+#elif defined(SCALER_HAVE_NEON)
+   if (simd & SCALER_SIMD_VECTOR)
+   {
+      scaler_argb8888_vert_neon(ctx, output_, stride);
+      return;
+   }
+#endif
+
+   scaler_argb8888_vert_C(ctx, output_, stride);
+}
+
 static INLINE uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t b)
 {
    return ((uint64_t)a << 48) | ((uint64_t)r << 32) | ((uint64_t)g << 16) | ((uint64_t)b << 0);
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+static void scaler_argb8888_horiz_C(const struct scaler_ctx *ctx, const void *input_, int stride)
 {
    int h, w, x;
    const uint32_t *input = (uint32_t*)input_;
@@ -244,6 +398,247 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
       }
    }
 }
+
+#if defined(__SSE2__)
+// Two coefficients, each repeated for the four channels of a pixel.
+// Loaded in one go, _mm_set1_epi16() ends up going through the stack with some compilers.
+static INLINE __m128i scaler_load_coeff2_sse2(const int16_t *filter)
+{
+   int32_t pair;
+   __m128i coeff;
+
+   memcpy(&pair, filter, sizeof(pair));
+   coeff = _mm_cvtsi32_si128(pair);
+   coeff = _mm_unpacklo_epi16(coeff, coeff);
+   return _mm_unpacklo_epi32(coeff, coeff);
+}
+
+// Filters one pixel, even taps end up in the low half of the result, odd taps in the high half.
+static INLINE __m128i scaler_argb8888_horiz_pixel_sse2(const int16_t *filter_horiz,
+      const uint32_t *input_base_x, int filter_len)
+{
+   int x;
+   __m128i res = _mm_setzero_si128();
+
+   for (x = 0; (x + 1) < filter_len; x += 2)
+   {
+      __m128i coeff = scaler_load_coeff2_sse2(filter_horiz + x);
+      __m128i col   = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(input_base_x + x)), _mm_setzero_si128());
+
+      col = _mm_slli_epi16(col, 7);
+      res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
+
+   for (; x < filter_len; x++)
+   {
+      __m128i coeff = _mm_cvtsi32_si128((uint16_t)filter_horiz[x]);
+      __m128i col   = _mm_unpacklo_epi8(_mm_cvtsi32_si128(input_base_x[x]), _mm_setzero_si128());
+
+      coeff = _mm_shufflelo_epi16(coeff, _MM_SHUFFLE(0, 0, 0, 0));
+
+      col = _mm_slli_epi16(col, 7);
+      res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
+
+   return res;
+}
+
+static INLINE void scaler_argb8888_store64_sse2(uint64_t *output, __m128i res)
+{
+#ifdef __x86_64__
+   *output = _mm_cvtsi128_si64(res);
+#else // 32-bit doesn't have si64.
+   _mm_storel_epi64((__m128i*)output, res);
+#endif
+}
+
+static void scaler_argb8888_horiz_sse2(const struct scaler_ctx *ctx, const void *input_, int stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         __m128i res = scaler_argb8888_horiz_pixel_sse2(filter_horiz,
+               input + ctx->horiz.filter_pos[w], ctx->horiz.filter_len);
+
+         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         scaler_argb8888_store64_sse2(output + w, res);
+      }
+   }
+}
+#endif
+
+#ifdef SCALER_HAVE_AVX2
+// Filters two pixels at a time, one in each 128-bit lane, laid out as in the SSE2 version.
+__attribute__((target("avx2")))
+static void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx, const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+   const int filter_len  = ctx->horiz.filter_len;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; (w + 1) < ctx->scaled.width; w += 2, filter_horiz += 2 * ctx->horiz.filter_stride)
+      {
+         __m128i res128;
+         __m256i res = _mm256_setzero_si256();
+         const int16_t *filter_next = filter_horiz + ctx->horiz.filter_stride;
+         const uint32_t *input_lo   = input + ctx->horiz.filter_pos[w + 0];
+         const uint32_t *input_hi   = input + ctx->horiz.filter_pos[w + 1];
+
+         for (x = 0; (x + 1) < filter_len; x += 2)
+         {
+            __m256i coeff = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                     scaler_load_coeff2_sse2(filter_horiz + x)),
+                  scaler_load_coeff2_sse2(filter_next + x), 1);
+            __m256i col   = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+                     _mm_loadl_epi64((const __m128i*)(input_lo + x)),
+                     _mm_loadl_epi64((const __m128i*)(input_hi + x))));
+
+            col = _mm256_slli_epi16(col, 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < filter_len; x++)
+         {
+            __m256i coeff = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                     _mm_shufflelo_epi16(_mm_cvtsi32_si128((uint16_t)filter_horiz[x]), 0)),
+                  _mm_shufflelo_epi16(_mm_cvtsi32_si128((uint16_t)filter_next[x]), 0), 1);
+            __m256i col   = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+                     _mm_cvtsi32_si128(input_lo[x]), _mm_cvtsi32_si128(input_hi[x])));
+
+            col = _mm256_slli_epi16(col, 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res    = _mm256_adds_epi16(_mm256_srli_si256(res, 8), res);
+         // Both pixels are in the low halves of the lanes now.
+         res128 = _mm256_castsi256_si128(_mm256_permute4x64_epi64(res, _MM_SHUFFLE(3, 1, 2, 0)));
+         _mm_storeu_si128((__m128i*)(output + w), res128);
+      }
+
+      if (w < ctx->scaled.width)
+      {
+         __m128i res = scaler_argb8888_horiz_pixel_sse2(filter_horiz,
+               input + ctx->horiz.filter_pos[w], filter_len);
+
+         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         scaler_argb8888_store64_sse2(output + w, res);
+      }
+   }
+}
+#endif
+
+#ifdef SCALER_HAVE_NEON
+static void scaler_argb8888_horiz_neon(const struct scaler_ctx *ctx, const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         int16x4_t res_even = vdup_n_s16(0);
+         int16x4_t res_odd  = vdup_n_s16(0);
+
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            int16x8_t col = vreinterpretq_s16_u16(vshlq_n_u16(
+                     vmovl_u8(vld1_u8((const uint8_t*)(input_base_x + x))), 7));
+
+            res_even = vqadd_s16(vshrn_n_s32(vmull_s16(vget_low_s16(col),
+                        vdup_n_s16(filter_horiz[x + 0])), 16), res_even);
+            res_odd  = vqadd_s16(vshrn_n_s32(vmull_s16(vget_high_s16(col),
+                        vdup_n_s16(filter_horiz[x + 1])), 16), res_odd);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            int16x4_t col = vreinterpret_s16_u16(vshl_n_u16(vget_low_u16(
+                        vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])))), 7));
+
+            res_even = vqadd_s16(vshrn_n_s32(vmull_s16(col,
+                        vdup_n_s16(filter_horiz[x])), 16), res_even);
+         }
+
+         vst1_s16((int16_t*)(output + w), vqadd_s16(res_odd, res_even));
+      }
+   }
+}
+#endif
+
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+{
+   unsigned simd = scaler_get_simd();
+
+   (void)simd;
+
+#ifdef SCALER_HAVE_AVX2
+   if (simd & SCALER_SIMD_AVX2)
+   {
+      scaler_argb8888_horiz_avx2(ctx, input_, stride);
+      return;
+   }
+#endif
+#if defined(__SSE2__)
+   if (simd & SCALER_SIMD_VECTOR)
+   {
+      scaler_argb8888_horiz_sse2(ctx, input_, stride);
+      return;
+   }
+#elif defined(SCALER_HAVE_NEON)
+   if (simd & SCALER_SIMD_VECTOR)
+   {
+      scaler_argb8888_horiz_neon(ctx, input_, stride);
+      return;
+   }
+#endif
+
+   scaler_argb8888_horiz_C(ctx, input_, stride);
+}
+
+#ifdef SCALER_HAVE_AVX2
+// Gathers eight pixels of a row at a time.
+__attribute__((target("avx2")))
+static void scaler_argb8888_point_avx2(uint32_t *output, const uint32_t *input,
+      int out_width, int out_height, int out_stride, int in_stride,
+      int x_pos, int x_step, int y_pos, int y_step)
+{
+   int h, w;
+   const __m256i x_start = _mm256_add_epi32(_mm256_set1_epi32(x_pos),
+         _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(x_step)));
+   const __m256i x_step8 = _mm256_set1_epi32(8 * x_step);
+
+   for (h = 0; h < out_height; h++, y_pos += y_step, output += out_stride >> 2)
+   {
+      int x;
+      __m256i x_vec = x_start;
+      const uint32_t *inp = input + (y_pos >> 16) * (in_stride >> 2);
+
+      for (w = 0; (w + 7) < out_width; w += 8, x_vec = _mm256_add_epi32(x_vec, x_step8))
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_i32gather_epi32((const int*)inp, _mm256_srli_epi32(x_vec, 16), 4));
+
+      for (x = x_pos + w * x_step; w < out_width; w++, x += x_step)
+         output[w] = inp[x >> 16];
+   }
+}
 #endif
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
@@ -270,6 +665,15 @@ void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
    input = (const uint32_t*)input_;
    output = (uint32_t*)output_;
 
+#ifdef SCALER_HAVE_AVX2
+   if (scaler_get_simd() & SCALER_SIMD_AVX2)
+   {
+      scaler_argb8888_point_avx2(output, input, out_width, out_height,
+            out_stride, in_stride, x_pos, x_step, y_pos, y_step);
+      return;
+   }
+#endif
+
    for (h = 0; h < out_height; h++, y_pos += y_step, output += out_stride >> 2)
    {
       int x = x_pos;
@@ -279,4 +683,3 @@ void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
          output[w] = inp[x >> 16];
    }
 }
-
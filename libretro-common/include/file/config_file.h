@@ -38,6 +38,10 @@ struct config_entry_list
    /* If we got this from an #include,
     * do not allow overwrite. */
    bool readonly;
+   /* Key and value point into the buffer the file
+    * was read into, rather than being allocated. */
+   bool key_in_buffer;
+   bool value_in_buffer;
    char *key;
    char *value;
    struct config_entry_list *next;
@@ -49,6 +53,15 @@ struct config_include_list
    struct config_include_list *next;
 };
 
+/* Files read whole, which entries are parsed in place in. */
+struct config_buffer_list
+{
+   char *data;
+   struct config_buffer_list *next;
+};
+
+struct config_index_slot;
+
 struct config_file
 {
    char *path;
@@ -57,6 +70,14 @@ struct config_file
    unsigned include_depth;
 
    struct config_include_list *includes;
+   struct config_buffer_list *buffers;
+
+   /* Hash index of the first entry for every key.
+    * Rebuilt on the next lookup when dirty. */
+   struct config_index_slot *index;
+   size_t index_size;
+   size_t index_count;
+   bool index_dirty;
 };
 
 typedef struct config_file config_file_t;
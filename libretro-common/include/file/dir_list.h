@@ -43,6 +43,46 @@ extern "C" {
 struct string_list *dir_list_new(const char *dir, const char *ext,
       bool include_dirs);
 
+struct dir_list_reader;
+
+/**
+ * dir_list_reader_new:
+ * @dir          : directory path.
+ * @ext          : allowed extensions of file directory entries to include.
+ * @include_dirs : include directories as part of the finished directory listing?
+ *
+ * Opens a directory for reading its listing a few entries at a time
+ * with dir_list_reader_iterate().
+ *
+ * Returns: pointer to a directory reader on success, NULL in case of
+ * error. Has to be freed with dir_list_reader_free().
+ **/
+struct dir_list_reader *dir_list_reader_new(const char *dir,
+      const char *ext, bool include_dirs);
+
+/**
+ * dir_list_reader_iterate:
+ * @reader       : pointer to the directory reader.
+ * @list         : pointer to the directory listing entries are appended to.
+ * @max_entries  : most directory entries to read in this call.
+ *
+ * Reads up to @max_entries further entries of the directory and appends
+ * the ones that pass the filters of dir_list_reader_new() to @list.
+ *
+ * Returns: 1 if there are entries left to read, 0 once the whole
+ * directory has been read, -1 on error.
+ **/
+int dir_list_reader_iterate(struct dir_list_reader *reader,
+      struct string_list *list, size_t max_entries);
+
+/**
+ * dir_list_reader_free:
+ * @reader       : pointer to the directory reader.
+ *
+ * Closes the directory and frees the reader.
+ **/
+void dir_list_reader_free(struct dir_list_reader *reader);
+
 /**
  * dir_list_sort:
  * @list      : pointer to the directory listing.
@@ -39,10 +39,20 @@ typedef int (*zlib_file_cb)(const char *name, const char *valid_exts,
       const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
       uint32_t crc32, void *userdata);
 
+/* Returns true when parsing should continue. False to stop. */
+typedef int (*zlib_crc_cb)(const char *name, uint32_t size,
+      uint32_t crc32, void *userdata);
+
 uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length);
 
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data);
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length);
+
+/* Checksum of two blocks in a row, from the checksums of each. */
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2);
+
 /**
  * zlib_parse_file:
  * @file                        : filename path of archive
@@ -59,6 +69,20 @@ uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data);
 bool zlib_parse_file(const char *file, const char *valid_exts,
       zlib_file_cb file_cb, void *userdata);
 
+/**
+ * zlib_parse_file_crc:
+ * @file                        : filename path of archive
+ * @crc_cb                      : called for each file in the archive.
+ * @userdata                    : userdata to pass to crc_cb function pointer.
+ *
+ * Enumerates the CRC32 of every file in the archive from its central
+ * directory, without reading the archive into memory.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_parse_file_crc(const char *file, zlib_crc_cb crc_cb,
+      void *userdata);
+
 /**
  * zlib_extract_first_content_file:
  * @zip_path                    : filename path to ZIP archive.
@@ -74,6 +98,25 @@ bool zlib_parse_file(const char *file, const char *valid_exts,
 bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size, 
       const char *valid_exts, const char *extraction_dir);
 
+/**
+ * zlib_extract_first_content_to_memory:
+ * @zip_path                    : filename path to ZIP archive.
+ * @zip_path_size               : size of ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ * @buf                         : set to the extracted content.
+ *                                Needs to be freed manually.
+ * @size                        : set to the size of @buf.
+ *
+ * Extract first content file from archive into memory.
+ * @zip_path is suffixed with '#' and the name of the file in
+ * the archive.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_first_content_to_memory(char *zip_path,
+      size_t zip_path_size, const char *valid_exts,
+      void **buf, size_t *size);
+
 /**
  * zlib_get_file_list:
  * @path                        : filename path of archive
@@ -119,8 +162,15 @@ void zlib_stream_free(void *data);
 
 void zlib_deflate_init(void *data, int level);
 
+/* Raw deflate, without zlib header and checksum. */
+void zlib_deflate_init2(void *data, int level);
+
 int zlib_deflate_data_to_file(void *data);
 
+/* Deflates all input and ends on a byte boundary 
+ * without finishing the stream. */
+bool zlib_deflate_data_flush(void *data);
+
 void zlib_stream_deflate_free(void *data);
 
 bool zlib_inflate_init(void *data);
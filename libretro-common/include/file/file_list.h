@@ -27,8 +27,11 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <boolean.h>
 
+/* Strings are owned by the list's string table, never free them.
+ * actiondata has to come from file_list_alloc() on the same list. */
 struct item_file
 {
    char *path;
@@ -40,12 +43,19 @@ struct item_file
    void *actiondata;
 };
 
+struct file_list_pool;
+
 typedef struct file_list
 {
    struct item_file *list;
 
    size_t capacity;
    size_t size;
+
+   /* Interned path, label and alt strings and the actiondata
+    * of all entries. Released all at once by file_list_clear()
+    * and file_list_free(). */
+   struct file_list_pool *pool;
 } file_list_t;
 
 
@@ -55,6 +65,29 @@ void *file_list_get_userdata_at_offset(const file_list_t *list,
 void *file_list_get_actiondata_at_offset(const file_list_t *list, 
       size_t index);
 
+/**
+ * file_list_alloc:
+ * @list                 : File list handle.
+ * @size                 : Size of the allocation.
+ *
+ * Allocates zeroed memory for the userdata or actiondata
+ * of an entry. It belongs to @list and goes away with the
+ * rest of its entries in file_list_clear() and file_list_free().
+ *
+ * Returns: pointer to the memory, or NULL if memory ran out.
+ **/
+void *file_list_alloc(file_list_t *list, size_t size);
+
+/**
+ * file_list_release:
+ * @list                 : File list handle.
+ * @data                 : Memory from file_list_alloc() on @list.
+ *
+ * Gives @data back to @list before the list is cleared,
+ * for entries that are popped off a list that keeps going.
+ **/
+void file_list_release(file_list_t *list, void *data);
+
 void file_list_free(file_list_t *list);
 
 void file_list_push(file_list_t *userdata, const char *path,
@@ -18,6 +18,7 @@
 #define __RARCH_IMAGE_CONTEXT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <boolean.h>
 
 enum image_process_code
@@ -39,9 +40,43 @@ struct texture_image
    void *vertex_buf;
 #endif
    uint32_t *pixels;
+   /* Pre-compressed texture, a whole KTX file. 
+    * Set instead of @pixels. */
+   void *compressed;
+   size_t compressed_size;
 };
 
 bool texture_image_load(struct texture_image *img, const char *path);
 void texture_image_free(struct texture_image *img);
 
+/**
+ * texture_image_load_compressed:
+ * @img                  : Image to load into.
+ * @path                 : Path of the image.
+ *
+ * Loads the .ktx file next to @path instead of @path itself, 
+ * if there is one and the video driver supports its format. 
+ * The result can only be uploaded with video_texture_load().
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool texture_image_load_compressed(struct texture_image *img,
+      const char *path);
+
+/**
+ * texture_image_load_batch:
+ * @imgs                 : Images to load into, @count of them.
+ * @paths                : Paths of the images. NULL entries are skipped.
+ * @count                : Number of images.
+ * @compressed           : Use texture_image_load_compressed().
+ *
+ * Loads several images at once, spread across worker threads
+ * where available, and returns when all of them are done.
+ * Images that fail to load are left zeroed.
+ *
+ * Returns: number of images loaded.
+ **/
+unsigned texture_image_load_batch(struct texture_image *imgs,
+      const char * const *paths, unsigned count, bool compressed);
+
 #endif
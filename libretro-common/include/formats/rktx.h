@@ -0,0 +1,74 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rktx.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_FORMAT_RKTX_H__
+#define __LIBRETRO_SDK_FORMAT_RKTX_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RKTX_MAX_LEVELS 16
+
+struct rktx_level
+{
+   const uint8_t *data;
+   uint32_t size;
+   unsigned width;
+   unsigned height;
+};
+
+/* A KTX 1.1 file holding a single compressed 2D texture. 
+ * Level data points into the buffer it was parsed from. */
+struct rktx
+{
+   uint32_t internal_format;
+   unsigned width;
+   unsigned height;
+   unsigned levels;
+   struct rktx_level level[RKTX_MAX_LEVELS];
+};
+
+/**
+ * rktx_parse:
+ * @ktx                  : Texture to fill in.
+ * @buf                  : Contents of a KTX file.
+ * @size                 : Size of @buf.
+ *
+ * Parses a KTX file holding a compressed 2D texture with 
+ * optional mipmaps. Arrays, cubemaps, 3D and uncompressed 
+ * textures are rejected.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rktx_parse(struct rktx *ktx, const uint8_t *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
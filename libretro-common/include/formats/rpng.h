@@ -67,7 +67,6 @@ struct rpng_process_t
    uint32_t *palette;
    struct png_ihdr ihdr;
    uint8_t *prev_scanline;
-   uint8_t *decoded_scanline;
    uint8_t *inflate_buf;
    size_t restore_buf_size;
    size_t adam7_restore_buf_size;
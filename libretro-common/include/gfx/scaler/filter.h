@@ -32,6 +32,8 @@ extern "C" {
 
 bool scaler_gen_filter(struct scaler_ctx *ctx);
 
+void scaler_filter_release(struct scaler_filter *filter);
+
 #ifdef __cplusplus
 }
 #endif
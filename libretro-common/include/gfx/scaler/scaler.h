@@ -50,7 +50,10 @@ enum scaler_type
    SCALER_TYPE_UNKNOWN = 0,
    SCALER_TYPE_POINT,
    SCALER_TYPE_BILINEAR,
-   SCALER_TYPE_SINC
+   SCALER_TYPE_SINC,
+   /* Lanczos-3, normalized and low-passed when downscaling.
+    * Sharper than bilinear, without the aliasing when shrinking. */
+   SCALER_TYPE_LANCZOS3
 };
 
 struct scaler_filter
@@ -125,6 +128,25 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx);
 void scaler_ctx_scale(struct scaler_ctx *ctx,
       void *output, const void *input);
 
+/**
+ * scaler_ctx_scale_rows:
+ * @ctx          : pointer to scaler context object.
+ * @output       : pointer to output image.
+ * @input        : pointer to input image.
+ * @first_row    : first row to convert.
+ * @rows         : number of rows to convert.
+ *
+ * Converts only some of the rows of an image, so the work can be 
+ * split up between threads. Rows of a scaled image depend on 
+ * their neighbours, so this only works for contexts that just 
+ * convert pixel formats.
+ *
+ * Returns: true if the rows were converted, false if @ctx scales.
+ **/
+bool scaler_ctx_scale_rows(struct scaler_ctx *ctx,
+      void *output, const void *input,
+      int first_row, int rows);
+
 /**
  * scaler_alloc:
  * @elem_size    : size of the elements to be used.
@@ -0,0 +1,177 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (ralloc.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_RALLOC_H
+#define __LIBRETRO_SDK_RALLOC_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Allocations tagged with the subsystem they belong to.
+ *
+ * With HAVE_RALLOC_STATS, every allocation carries a small header
+ * and is counted against its tag, see ralloc_get_stats(). Without
+ * it, the functions below are plain malloc() and friends.
+ *
+ * Memory from ralloc_*() has to go back through ralloc_free()
+ * and ralloc_realloc(), never free() or realloc(). */
+
+enum ralloc_tag
+{
+   RALLOC_TAG_CONFIG = 0,
+   RALLOC_TAG_FILE_LIST,
+   RALLOC_TAG_DATABASE,
+
+   RALLOC_TAG_LAST
+};
+
+struct ralloc_stats
+{
+   /* Bytes currently allocated, and the most there ever were. */
+   size_t bytes;
+   size_t peak;
+   /* Allocations currently alive, and made in total. */
+   size_t allocs;
+   size_t total_allocs;
+};
+
+#ifdef HAVE_RALLOC_STATS
+void *ralloc_malloc(enum ralloc_tag tag, size_t size);
+void *ralloc_calloc(enum ralloc_tag tag, size_t num, size_t size);
+void *ralloc_realloc(enum ralloc_tag tag, void *ptr, size_t size);
+char *ralloc_strdup(enum ralloc_tag tag, const char *str);
+void ralloc_free(void *ptr);
+#else
+#define ralloc_malloc(tag, size)       malloc(size)
+#define ralloc_calloc(tag, num, size)  calloc(num, size)
+#define ralloc_realloc(tag, ptr, size) realloc(ptr, size)
+#define ralloc_strdup(tag, str)        ralloc_strdup_untracked(str)
+#define ralloc_free(ptr)               free(ptr)
+
+char *ralloc_strdup_untracked(const char *str);
+#endif
+
+/**
+ * ralloc_get_stats:
+ * @tag                  : Subsystem to get the numbers of.
+ * @stats                : Set to the numbers.
+ *
+ * Numbers are updated atomically where the compiler supports
+ * it, and only approximate across threads otherwise.
+ *
+ * Returns: true (1) if built with HAVE_RALLOC_STATS,
+ * otherwise false (0) and @stats is zeroed.
+ **/
+bool ralloc_get_stats(enum ralloc_tag tag, struct ralloc_stats *stats);
+
+/**
+ * ralloc_tag_name:
+ * @tag                  : Subsystem.
+ *
+ * Returns: short name of @tag for reports.
+ **/
+const char *ralloc_tag_name(enum ralloc_tag tag);
+
+/* Bump allocator. Allocations share big blocks taken from
+ * ralloc_malloc() under the arena's tag, and are released all
+ * at once by rewinding, resetting or freeing the arena. */
+struct ralloc_arena_block;
+
+struct ralloc_arena
+{
+   struct ralloc_arena_block *head;
+   size_t block_size;
+   enum ralloc_tag tag;
+};
+
+struct ralloc_arena_mark
+{
+   struct ralloc_arena_block *block;
+   size_t used;
+};
+
+/**
+ * ralloc_arena_init:
+ * @arena                : Arena to set up.
+ * @block_size           : Size of the blocks to allocate from,
+ *                         bigger allocations get a block of their own.
+ * @tag                  : Subsystem the blocks are counted against.
+ *
+ * No memory is allocated until the first ralloc_arena_alloc().
+ **/
+void ralloc_arena_init(struct ralloc_arena *arena,
+      size_t block_size, enum ralloc_tag tag);
+
+/**
+ * ralloc_arena_alloc:
+ * @arena                : Arena to allocate from.
+ * @size                 : Size of the allocation.
+ *
+ * Returns: uninitialized memory aligned for any 64-bit type,
+ * or NULL if memory ran out.
+ **/
+void *ralloc_arena_alloc(struct ralloc_arena *arena, size_t size);
+
+/**
+ * ralloc_arena_mark:
+ * @arena                : Arena.
+ * @mark                 : Set to the current fill of @arena.
+ **/
+void ralloc_arena_mark(const struct ralloc_arena *arena,
+      struct ralloc_arena_mark *mark);
+
+/**
+ * ralloc_arena_rewind:
+ * @arena                : Arena.
+ * @mark                 : Taken with ralloc_arena_mark().
+ *
+ * Releases everything allocated since @mark was taken.
+ **/
+void ralloc_arena_rewind(struct ralloc_arena *arena,
+      const struct ralloc_arena_mark *mark);
+
+/**
+ * ralloc_arena_reset:
+ * @arena                : Arena.
+ *
+ * Releases everything, but keeps the first block for reuse.
+ **/
+void ralloc_arena_reset(struct ralloc_arena *arena);
+
+/**
+ * ralloc_arena_free:
+ * @arena                : Arena.
+ *
+ * Releases everything, including the blocks.
+ **/
+void ralloc_arena_free(struct ralloc_arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -38,8 +38,15 @@ void net_http_connection_free(struct http_connection_t *conn);
 
 struct http_t *net_http_new(struct http_connection_t *conn);
 
+/* Writes the body to a file as it arrives instead of keeping 
+ * it in memory. Call before the first net_http_update. The file 
+ * is complete once net_http_update returns true, unless the 
+ * transfer failed. Returns false if the file can't be created. */
+bool net_http_set_output_file(struct http_t *state, const char *path);
+
 /* You can use this to call net_http_update 
- * only when something will happen; select() it for reading. */
+ * only when something will happen; select() it for reading. 
+ * -1 while the server is still being looked up. */
 int net_http_fd(struct http_t *state);
 
 /* Returns true if it's done, or if something broke.
@@ -52,12 +59,17 @@ int net_http_status(struct http_t *state);
 /* Returns the downloaded data. The returned buffer is owned by the 
  * HTTP handler; it's freed by net_http_delete. 
  *
- * If the status is not 20x and accept_error is false, it returns NULL. */
+ * If the status is not 20x and accept_error is false, it returns NULL. 
+ * Also returns NULL if the body went to a file, 'len' is still set. */
 uint8_t* net_http_data(struct http_t *state, size_t* len, bool accept_error);
 
-/* Cleans up all memory. */
+/* Cleans up all memory. If the transfer finished, the connection 
+ * is kept open for the next request to the same server. */
 void net_http_delete(struct http_t *state);
 
+/* Closes the connections kept open by net_http_delete. */
+void net_http_close_idle(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,107 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NET_RESOLVE_H
+#define _NET_RESOLVE_H
+
+#include <boolean.h>
+#include <net/net_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Host name lookups which don't block the caller. With threads,
+ * each lookup runs getaddrinfo() on a thread of its own,
+ * otherwise it is done right away. Results are cached for a
+ * minute, so connecting to the same server again is instant. */
+typedef struct net_resolve net_resolve_t;
+
+enum net_resolve_status
+{
+   NET_RESOLVE_PENDING = 0,
+   NET_RESOLVE_DONE,
+   NET_RESOLVE_FAILED
+};
+
+/**
+ * net_resolve_new:
+ * @node                 : Host name or address, NULL for
+ *                         the local address with AI_PASSIVE.
+ * @service              : Port number.
+ * @hints                : Same as for getaddrinfo().
+ *
+ * Starts looking up @node.
+ *
+ * Returns: lookup handle, or NULL if out of memory.
+ **/
+net_resolve_t *net_resolve_new(const char *node, const char *service,
+      const struct addrinfo *hints);
+
+/**
+ * net_resolve_poll:
+ * @req                  : Lookup handle.
+ * @res                  : Set to the addresses once done, which
+ *                         stay valid until net_resolve_free().
+ *
+ * Checks for the result of a lookup without waiting.
+ *
+ * Returns: status of the lookup.
+ **/
+enum net_resolve_status net_resolve_poll(net_resolve_t *req,
+      const struct addrinfo **res);
+
+/**
+ * net_resolve_free:
+ * @req                  : Lookup handle.
+ *
+ * Frees a lookup. One still running is abandoned, and
+ * its thread cleans up after itself.
+ **/
+void net_resolve_free(net_resolve_t *req);
+
+/**
+ * net_resolve_addrinfo:
+ * @node                 : Host name or address, can be NULL.
+ * @service              : Port number.
+ * @hints                : Same as for getaddrinfo().
+ * @res                  : Set to the addresses, to be freed with
+ *                         net_resolve_freeaddrinfo().
+ * @timeout_ms           : How long to wait for the lookup.
+ *
+ * Blocking lookup through the cache, for callers which
+ * can't go on without the address. Unlike getaddrinfo(),
+ * gives up after @timeout_ms.
+ *
+ * Returns: 0 if successful, otherwise -1.
+ **/
+int net_resolve_addrinfo(const char *node, const char *service,
+      const struct addrinfo *hints, struct addrinfo **res,
+      unsigned timeout_ms);
+
+void net_resolve_freeaddrinfo(struct addrinfo *res);
+
+/**
+ * net_resolve_clear_cache:
+ *
+ * Forgets all cached lookups, e.g. after the network changed.
+ **/
+void net_resolve_clear_cache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
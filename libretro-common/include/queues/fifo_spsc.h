@@ -0,0 +1,81 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (fifo_spsc.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_FIFO_SPSC_H
+#define __LIBRETRO_SDK_FIFO_SPSC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIFO_SPSC_CACHE_LINE_SIZE
+#define FIFO_SPSC_CACHE_LINE_SIZE 64
+#endif
+
+/* Lock-free FIFO for exactly one producer thread and one 
+ * consumer thread.
+ *
+ * The producer only calls fifo_spsc_write_avail() and 
+ * fifo_spsc_write(), the consumer only calls fifo_spsc_read_avail() 
+ * and fifo_spsc_read(). Neither may move more bytes than the 
+ * matching *_avail() call returned. Creation and freeing must 
+ * not race with either side.
+ *
+ * first and end are free-running byte counters padded onto 
+ * separate cache lines, so each side only ever writes its own line. */
+struct fifo_spsc
+{
+   uint8_t *buffer;
+   size_t size;
+   size_t mask;
+
+   uint8_t pad0[FIFO_SPSC_CACHE_LINE_SIZE];
+   /* Only written by the consumer. */
+   volatile size_t first;
+   uint8_t pad1[FIFO_SPSC_CACHE_LINE_SIZE - sizeof(size_t)];
+   /* Only written by the producer. */
+   volatile size_t end;
+   uint8_t pad2[FIFO_SPSC_CACHE_LINE_SIZE - sizeof(size_t)];
+};
+
+typedef struct fifo_spsc fifo_spsc_t;
+
+fifo_spsc_t *fifo_spsc_new(size_t size);
+
+void fifo_spsc_write(fifo_spsc_t *fifo, const void *in_buf, size_t size);
+
+void fifo_spsc_read(fifo_spsc_t *fifo, void *in_buf, size_t size);
+
+void fifo_spsc_free(fifo_spsc_t *fifo);
+
+size_t fifo_spsc_read_avail(fifo_spsc_t *fifo);
+
+size_t fifo_spsc_write_avail(fifo_spsc_t *fifo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
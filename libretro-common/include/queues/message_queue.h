@@ -29,19 +29,36 @@
 extern "C" {
 #endif
 
+/* Messages can be pushed and cleared from any thread, but
+ * only one thread may pull them. Without compiler atomics
+ * (HAVE_RETRO_ATOMIC), all calls have to come from one thread. */
 typedef struct msg_queue msg_queue_t;
 
 /**
  * msg_queue_new:
- * @size              : maximum size of message
+ * @size              : maximum number of messages
  *
- * Creates a message queue with maximum size different messages.
+ * Creates a message queue for messages of up to 
+ * 1023 characters.
  *
  * Returns: NULL if allocation error, pointer to a message queue
  * if successful. Has to be freed manually.
  **/
 msg_queue_t *msg_queue_new(size_t size);
 
+/**
+ * msg_queue_new_sized:
+ * @size              : maximum number of messages
+ * @msg_size          : maximum length of a message,
+ *                      including the terminator
+ *
+ * Creates a message queue. All storage is allocated here.
+ *
+ * Returns: NULL if allocation error, pointer to a message queue
+ * if successful. Has to be freed manually.
+ **/
+msg_queue_t *msg_queue_new_sized(size_t size, size_t msg_size);
+
 /**
  * msg_queue_push:
  * @queue             : pointer to queue object
@@ -51,7 +68,8 @@ msg_queue_t *msg_queue_new(size_t size);
  *                      before it vanishes (E.g. show a message for
  *                      3 seconds @ 60fps = 180 duration).
  *
- * Push a new message onto the queue.
+ * Push a new message onto the queue. Dropped if the queue is
+ * full, and cut short if too long.
  **/
 void msg_queue_push(msg_queue_t *queue, const char *msg,
       unsigned prio, unsigned duration);
@@ -63,7 +81,7 @@ void msg_queue_push(msg_queue_t *queue, const char *msg,
  * Pulls highest priority message in queue.
  *
  * Returns: NULL if no message in queue, otherwise a string
- * containing the message.
+ * containing the message, valid until the next pull.
  **/
 const char *msg_queue_pull(msg_queue_t *queue);
 
@@ -71,7 +89,8 @@ const char *msg_queue_pull(msg_queue_t *queue);
  * msg_queue_clear:
  * @queue             : pointer to queue object
  *
- * Clears out everything in the queue.
+ * Clears out everything pushed so far. Messages
+ * pushed afterwards are kept, also from other threads.
  **/
 void msg_queue_clear(msg_queue_t *queue);
 
@@ -0,0 +1,146 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (retro_atomic.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_ATOMIC_H
+#define __LIBRETRO_SDK_ATOMIC_H
+
+#include <boolean.h>
+#include <retro_inline.h>
+
+/* Sequentially consistent operations on ints, which act as
+ * full memory barriers. HAVE_RETRO_ATOMIC is defined where
+ * the compiler has them, callers need a lock otherwise. */
+
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define HAVE_RETRO_ATOMIC 1
+
+static INLINE int retro_atomic_load_int(volatile int *p)
+{
+   return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static INLINE void retro_atomic_store_int(volatile int *p, int value)
+{
+   __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static INLINE int retro_atomic_exchange_int(volatile int *p, int value)
+{
+   return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static INLINE bool retro_atomic_cas_int(volatile int *p,
+      int expected, int desired)
+{
+   return __atomic_compare_exchange_n(p, &expected, desired, false,
+         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static INLINE int retro_atomic_add_int(volatile int *p, int value)
+{
+   return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define HAVE_RETRO_ATOMIC 1
+
+/* Older GCC, the __sync builtins are full barriers
+ * except for __sync_lock_test_and_set(). */
+static INLINE int retro_atomic_load_int(volatile int *p)
+{
+   return __sync_fetch_and_add(p, 0);
+}
+
+static INLINE int retro_atomic_exchange_int(volatile int *p, int value)
+{
+   __sync_synchronize();
+   return __sync_lock_test_and_set(p, value);
+}
+
+static INLINE void retro_atomic_store_int(volatile int *p, int value)
+{
+   retro_atomic_exchange_int(p, value);
+   __sync_synchronize();
+}
+
+static INLINE bool retro_atomic_cas_int(volatile int *p,
+      int expected, int desired)
+{
+   return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
+static INLINE int retro_atomic_add_int(volatile int *p, int value)
+{
+   return __sync_fetch_and_add(p, value);
+}
+
+#elif defined(_MSC_VER) && _MSC_VER >= 1400 && !defined(_XBOX)
+#define HAVE_RETRO_ATOMIC 1
+#include <intrin.h>
+
+static INLINE int retro_atomic_load_int(volatile int *p)
+{
+   return _InterlockedCompareExchange((volatile long*)p, 0, 0);
+}
+
+static INLINE void retro_atomic_store_int(volatile int *p, int value)
+{
+   _InterlockedExchange((volatile long*)p, value);
+}
+
+static INLINE int retro_atomic_exchange_int(volatile int *p, int value)
+{
+   return _InterlockedExchange((volatile long*)p, value);
+}
+
+static INLINE bool retro_atomic_cas_int(volatile int *p,
+      int expected, int desired)
+{
+   return _InterlockedCompareExchange((volatile long*)p,
+         desired, expected) == expected;
+}
+
+static INLINE int retro_atomic_add_int(volatile int *p, int value)
+{
+   return _InterlockedExchangeAdd((volatile long*)p, value);
+}
+#endif
+
+/**
+ * retro_cpu_relax:
+ *
+ * Tells the CPU the caller is spinning, to be called in
+ * busy-wait loops. Hands the core to the other hardware
+ * thread where there is one, and saves power.
+ **/
+static INLINE void retro_cpu_relax(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+   __asm__ __volatile__("pause");
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7))
+   __asm__ __volatile__("yield");
+#elif defined(_MSC_VER) && _MSC_VER >= 1400 && (defined(_M_IX86) || defined(_M_X64)) && !defined(_XBOX)
+   _mm_pause();
+#endif
+}
+
+#endif
@@ -0,0 +1,191 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpool.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_RPOOL_H
+#define __LIBRETRO_SDK_RPOOL_H
+
+#include <boolean.h>
+
+#if defined(__cplusplus) && !defined(_MSC_VER)
+extern "C" {
+#endif
+
+/* A pool of worker threads running tasks for any number of
+ * callers. Each worker has its own task queue and steals from
+ * the others once it runs dry. Tasks queued by a worker go to
+ * its own queue, so that nested work stays on the same core. */
+typedef struct rpool rpool_t;
+
+/* Tasks that can be waited for together. */
+typedef struct rpool_group rpool_group_t;
+
+/* A task with a result to wait for. */
+typedef struct rpool_future rpool_future_t;
+
+typedef void (*rpool_task_t)(void *userdata);
+typedef void *(*rpool_future_task_t)(void *userdata);
+
+/* Processes item @index on thread @thread, which goes from 0 to
+ * rpool_num_threads(). No two items of an rpool_run() call run
+ * on the same @thread at once, so it can index per-thread
+ * scratch memory. */
+typedef void (*rpool_work_t)(void *userdata,
+      unsigned index, unsigned thread);
+
+enum rpool_priority
+{
+   RPOOL_PRIORITY_NORMAL = 0,
+   /* For background work that must not take time
+    * from the threads driving audio and video. */
+   RPOOL_PRIORITY_LOW,
+   /* Usually needs privileges, ignored without them. */
+   RPOOL_PRIORITY_HIGH
+};
+
+struct rpool_attr
+{
+   /* Number of worker threads. Threads waiting for
+    * tasks run them too, so usually one less than the
+    * number of cores. */
+   unsigned num_threads;
+   enum rpool_priority priority;
+   /* Pins worker N to core N + 1, leaving core 0 to
+    * the threads which submit work. Ignored where
+    * unsupported. */
+   bool pin_threads;
+};
+
+/**
+ * rpool_new:
+ * @attr                    : Pool attributes.
+ *
+ * Starts a pool of worker threads.
+ *
+ * Returns: pool handle if any worker could be started,
+ * otherwise NULL.
+ **/
+rpool_t *rpool_new(const struct rpool_attr *attr);
+
+/**
+ * rpool_free:
+ * @pool                    : Pool handle.
+ *
+ * Runs the tasks left in the queues, then stops the workers.
+ **/
+void rpool_free(rpool_t *pool);
+
+/**
+ * rpool_num_threads:
+ * @pool                    : Pool handle, can be NULL.
+ *
+ * Returns: number of worker threads.
+ **/
+unsigned rpool_num_threads(rpool_t *pool);
+
+rpool_group_t *rpool_group_new(void);
+
+/**
+ * rpool_group_free:
+ * @group                   : Group handle.
+ *
+ * Frees a group. Its tasks have to be done already,
+ * see rpool_group_wait().
+ **/
+void rpool_group_free(rpool_group_t *group);
+
+/**
+ * rpool_submit:
+ * @pool                    : Pool handle, can be NULL.
+ * @group                   : Group to add the task to, can be NULL.
+ * @task                    : Task to run.
+ * @userdata                : Passed to @task.
+ *
+ * Queues a task. Without a pool, or if the task can't be
+ * queued, it is run right away on the calling thread.
+ **/
+void rpool_submit(rpool_t *pool, rpool_group_t *group,
+      rpool_task_t task, void *userdata);
+
+/**
+ * rpool_group_wait:
+ * @pool                    : Pool handle, can be NULL.
+ * @group                   : Group to wait for.
+ *
+ * Waits for all tasks of a group, running those
+ * no worker has started yet on the calling thread.
+ **/
+void rpool_group_wait(rpool_t *pool, rpool_group_t *group);
+
+/**
+ * rpool_async:
+ * @pool                    : Pool handle, can be NULL.
+ * @task                    : Task to run.
+ * @userdata                : Passed to @task.
+ *
+ * Queues a task whose result is collected with
+ * rpool_future_get().
+ *
+ * Returns: future handle, or NULL if out of memory.
+ **/
+rpool_future_t *rpool_async(rpool_t *pool,
+      rpool_future_task_t task, void *userdata);
+
+/**
+ * rpool_future_ready:
+ * @future                  : Future handle.
+ *
+ * Returns: true (1) if the task is done, otherwise false (0).
+ **/
+bool rpool_future_ready(rpool_future_t *future);
+
+/**
+ * rpool_future_get:
+ * @future                  : Future handle, freed by this call.
+ *
+ * Waits for the task, running it on the calling thread
+ * if no worker has started it yet.
+ *
+ * Returns: the value returned by the task.
+ **/
+void *rpool_future_get(rpool_future_t *future);
+
+/**
+ * rpool_run:
+ * @pool                    : Pool handle, can be NULL.
+ * @work                    : Callback processing one item.
+ * @userdata                : Passed to @work.
+ * @count                   : Number of items.
+ *
+ * Runs items 0 to @count - 1 and waits for all of them.
+ * Threads claim items one by one as they become idle,
+ * including the calling thread, so splitting work into more
+ * items than threads evens out uneven item costs. Several
+ * threads can run items at the same time, sharing the workers.
+ **/
+void rpool_run(rpool_t *pool, rpool_work_t work,
+      void *userdata, unsigned count);
+
+#if defined(__cplusplus) && !defined(_MSC_VER)
+}
+#endif
+
+#endif
@@ -34,6 +34,8 @@ extern "C" {
 typedef struct sthread sthread_t;
 typedef struct slock slock_t;
 typedef struct scond scond_t;
+typedef struct sevent sevent_t;
+typedef struct ssem ssem_t;
 
 /**
  * sthread_create:
@@ -54,7 +56,8 @@ sthread_t *sthread_create(void (*thread_func)(void*), void *userdata);
  * Detach a thread. When a detached thread terminates, its
  * resource sare automatically released back to the system
  * without the need for another thread to join with the 
- * terminated thread.
+ * terminated thread. @thread is freed and can't be used
+ * afterwards.
  *
  * Returns: 0 on success, otherwise it returns a non-zero error number.
  */
@@ -73,6 +76,14 @@ int sthread_detach(sthread_t *thread);
  */
 void sthread_join(sthread_t *thread);
 
+/**
+ * sthread_get_current_thread_id:
+ *
+ * Returns: ID of the calling thread, or 0 where threads
+ * have no ID that fits in an integer.
+ */
+uintptr_t sthread_get_current_thread_id(void);
+
 /**
  * slock_new:
  *
@@ -169,6 +180,123 @@ int scond_broadcast(scond_t *cond);
  **/
 void scond_signal(scond_t *cond);
 
+/* Events and semaphores spin for a while before putting the
+ * waiting thread to sleep, so a handoff between two busy threads
+ * costs no system calls. Sleeping goes through futexes on Linux
+ * and WaitOnAddress() on Windows 8 and up, on other systems
+ * through a mutex and a condition variable. */
+
+/**
+ * sevent_new:
+ *
+ * Creates an auto-reset event, which starts out unset. Must
+ * be manually freed.
+ *
+ * Returns: pointer to new event on success, otherwise NULL.
+ **/
+sevent_t *sevent_new(void);
+
+/**
+ * sevent_free:
+ * @event                   : pointer to event object 
+ *
+ * Frees an event.
+ **/
+void sevent_free(sevent_t *event);
+
+/**
+ * sevent_set_spin_count:
+ * @event                   : pointer to event object 
+ * @count                   : number of checks before sleeping
+ *
+ * Sets how long waiting threads spin. Zero makes them
+ * sleep right away, which suits events set rarely.
+ **/
+void sevent_set_spin_count(sevent_t *event, unsigned count);
+
+/**
+ * sevent_signal:
+ * @event                   : pointer to event object 
+ *
+ * Sets an event, waking up a thread waiting for it. If none is,
+ * the event stays set until the next sevent_wait() call.
+ **/
+void sevent_signal(sevent_t *event);
+
+/**
+ * sevent_wait:
+ * @event                   : pointer to event object 
+ *
+ * Waits until an event is set, then unsets it.
+ **/
+void sevent_wait(sevent_t *event);
+
+/**
+ * sevent_wait_timeout:
+ * @event                   : pointer to event object 
+ * @timeout_us              : timeout (in microseconds)
+ *
+ * Waits until an event is set, then unsets it, or until
+ * @timeout_us elapses.
+ *
+ * Returns: false (0) if timeout elapses before the event is set,
+ * otherwise true (1).
+ **/
+bool sevent_wait_timeout(sevent_t *event, int64_t timeout_us);
+
+/**
+ * ssem_new:
+ * @value                   : initial count
+ *
+ * Creates a counting semaphore. Must be manually freed.
+ *
+ * Returns: pointer to new semaphore on success, otherwise NULL.
+ **/
+ssem_t *ssem_new(int value);
+
+/**
+ * ssem_free:
+ * @sem                     : pointer to semaphore object 
+ *
+ * Frees a semaphore.
+ **/
+void ssem_free(ssem_t *sem);
+
+/**
+ * ssem_set_spin_count:
+ * @sem                     : pointer to semaphore object 
+ * @count                   : number of checks before sleeping
+ *
+ * Sets how long waiting threads spin, see sevent_set_spin_count().
+ **/
+void ssem_set_spin_count(ssem_t *sem, unsigned count);
+
+/**
+ * ssem_post:
+ * @sem                     : pointer to semaphore object 
+ *
+ * Increments the count, waking up a waiting thread.
+ **/
+void ssem_post(ssem_t *sem);
+
+/**
+ * ssem_wait:
+ * @sem                     : pointer to semaphore object 
+ *
+ * Waits until the count is above zero, then decrements it.
+ **/
+void ssem_wait(ssem_t *sem);
+
+/**
+ * ssem_trywait:
+ * @sem                     : pointer to semaphore object 
+ *
+ * Decrements the count if it is above zero.
+ *
+ * Returns: true (1) if the count was decremented, otherwise false (0).
+ **/
+bool ssem_trywait(ssem_t *sem);
+
 #ifndef RARCH_INTERNAL
 #if defined(__CELLOS_LV2__) && !defined(__PSL1GHT__)
 #include <sys/timer.h>
@@ -87,6 +87,37 @@ bool string_list_find_elem_prefix(const struct string_list *list,
  */
 struct string_list *string_split(const char *str, const char *delim);
 
+/**
+ * string_tokenize:
+ * @str              : pointer to the string to tokenize. Is moved
+ *                     past the returned token.
+ * @delim            : delimiter characters.
+ * @len              : set to the length of the returned token.
+ *
+ * Like strtok_r(), but leaves the string alone and doesn't
+ * allocate. Empty tokens are skipped. The token is not
+ * NUL-terminated, it ends after @len characters.
+ *
+ * Returns: start of the next token, or NULL if there is none.
+ */
+const char *string_tokenize(const char **str, const char *delim,
+      size_t *len);
+
+/**
+ * string_find_token_prefix:
+ * @str              : delimited string, e.g. "bin|.cue|iso".
+ * @delim            : delimiter characters.
+ * @prefix           : prefix to append to @elem
+ * @elem             : element to find inside @str.
+ *
+ * Same as string_list_find_elem_prefix() on the list
+ * string_split() would make of @str, without making it.
+ *
+ * Returns: true (1) if element could be found, otherwise false (0).
+ */
+bool string_find_token_prefix(const char *str, const char *delim,
+      const char *prefix, const char *elem);
+
 /**
  * string_list_new:
  *
@@ -0,0 +1,307 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (ralloc.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory/ralloc.h>
+#include <retro_atomic.h>
+
+static const char *ralloc_tag_names[RALLOC_TAG_LAST] = {
+   "config",
+   "file_list",
+   "database",
+};
+
+#ifdef HAVE_RALLOC_STATS
+/* In front of every tracked allocation, keeping what
+ * follows it aligned like malloc() would. */
+union ralloc_header
+{
+   struct
+   {
+      size_t size;
+      unsigned tag;
+   } info;
+   long double align_ld;
+   long long align_ll;
+   void *align_ptr;
+};
+
+/* Ints so they can be updated with retro_atomic; a frontend
+ * using over 2 GB in one subsystem has other problems. */
+struct ralloc_counters
+{
+   volatile int bytes;
+   volatile int peak;
+   volatile int allocs;
+   volatile int total_allocs;
+};
+
+static struct ralloc_counters ralloc_counters[RALLOC_TAG_LAST];
+
+static int ralloc_add(volatile int *counter, int value)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   return retro_atomic_add_int(counter, value) + value;
+#else
+   return *counter += value;
+#endif
+}
+
+static void ralloc_count(unsigned tag, size_t size, int allocs)
+{
+   struct ralloc_counters *counters = &ralloc_counters[tag];
+   int bytes = ralloc_add(&counters->bytes,
+         allocs < 0 ? -(int)size : (int)size);
+
+   ralloc_add(&counters->allocs, allocs);
+
+   if (allocs <= 0)
+      return;
+
+   ralloc_add(&counters->total_allocs, 1);
+
+#ifdef HAVE_RETRO_ATOMIC
+   for (;;)
+   {
+      int peak = retro_atomic_load_int(&counters->peak);
+      if (bytes <= peak || retro_atomic_cas_int(&counters->peak, peak, bytes))
+         break;
+   }
+#else
+   if (bytes > counters->peak)
+      counters->peak = bytes;
+#endif
+}
+
+void *ralloc_malloc(enum ralloc_tag tag, size_t size)
+{
+   union ralloc_header *header = NULL;
+
+   if (size > (size_t)-1 - sizeof(*header))
+      return NULL;
+
+   header = (union ralloc_header*)malloc(sizeof(*header) + size);
+   if (!header)
+      return NULL;
+
+   header->info.size = size;
+   header->info.tag  = tag;
+   ralloc_count(tag, size, 1);
+
+   return header + 1;
+}
+
+void *ralloc_calloc(enum ralloc_tag tag, size_t num, size_t size)
+{
+   void *ptr = NULL;
+
+   if (size && num > (size_t)-1 / size)
+      return NULL;
+
+   if ((ptr = ralloc_malloc(tag, num * size)))
+      memset(ptr, 0, num * size);
+   return ptr;
+}
+
+void *ralloc_realloc(enum ralloc_tag tag, void *ptr, size_t size)
+{
+   size_t old_size;
+   union ralloc_header *header = NULL;
+
+   if (!ptr)
+      return ralloc_malloc(tag, size);
+
+   if (size > (size_t)-1 - sizeof(*header))
+      return NULL;
+
+   header   = (union ralloc_header*)ptr - 1;
+   old_size = header->info.size;
+   tag      = (enum ralloc_tag)header->info.tag;
+
+   header = (union ralloc_header*)realloc(header, sizeof(*header) + size);
+   if (!header)
+      return NULL;
+
+   header->info.size = size;
+   ralloc_count(tag, old_size, -1);
+   ralloc_count(tag, size, 1);
+   /* Still the same allocation. */
+   ralloc_add(&ralloc_counters[tag].total_allocs, -1);
+
+   return header + 1;
+}
+
+char *ralloc_strdup(enum ralloc_tag tag, const char *str)
+{
+   size_t size = strlen(str) + 1;
+   char *copy  = (char*)ralloc_malloc(tag, size);
+
+   if (copy)
+      memcpy(copy, str, size);
+   return copy;
+}
+
+void ralloc_free(void *ptr)
+{
+   union ralloc_header *header = NULL;
+
+   if (!ptr)
+      return;
+
+   header = (union ralloc_header*)ptr - 1;
+   ralloc_count(header->info.tag, header->info.size, -1);
+   free(header);
+}
+
+bool ralloc_get_stats(enum ralloc_tag tag, struct ralloc_stats *stats)
+{
+   struct ralloc_counters *counters = &ralloc_counters[tag];
+
+#ifdef HAVE_RETRO_ATOMIC
+   stats->bytes        = retro_atomic_load_int(&counters->bytes);
+   stats->peak         = retro_atomic_load_int(&counters->peak);
+   stats->allocs       = retro_atomic_load_int(&counters->allocs);
+   stats->total_allocs = retro_atomic_load_int(&counters->total_allocs);
+#else
+   stats->bytes        = counters->bytes;
+   stats->peak         = counters->peak;
+   stats->allocs       = counters->allocs;
+   stats->total_allocs = counters->total_allocs;
+#endif
+   return true;
+}
+#else
+char *ralloc_strdup_untracked(const char *str)
+{
+   size_t size = strlen(str) + 1;
+   char *copy  = (char*)malloc(size);
+
+   if (copy)
+      memcpy(copy, str, size);
+   return copy;
+}
+
+bool ralloc_get_stats(enum ralloc_tag tag, struct ralloc_stats *stats)
+{
+   (void)tag;
+   memset(stats, 0, sizeof(*stats));
+   return false;
+}
+#endif
+
+const char *ralloc_tag_name(enum ralloc_tag tag)
+{
+   if ((unsigned)tag >= RALLOC_TAG_LAST)
+      return "unknown";
+   return ralloc_tag_names[tag];
+}
+
+struct ralloc_arena_block
+{
+   struct ralloc_arena_block *prev;
+   size_t size;
+   size_t used;
+   uint64_t data[1];
+};
+
+void ralloc_arena_init(struct ralloc_arena *arena,
+      size_t block_size, enum ralloc_tag tag)
+{
+   arena->head       = NULL;
+   arena->block_size = block_size;
+   arena->tag        = tag;
+}
+
+void *ralloc_arena_alloc(struct ralloc_arena *arena, size_t size)
+{
+   void *ptr;
+   struct ralloc_arena_block *block = arena->head;
+
+   size = (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+   if (!block || block->size - block->used < size)
+   {
+      size_t block_size = arena->block_size > size ? arena->block_size : size;
+
+      block = (struct ralloc_arena_block*)ralloc_malloc(arena->tag,
+            offsetof(struct ralloc_arena_block, data) + block_size);
+      if (!block)
+         return NULL;
+
+      block->prev = arena->head;
+      block->size = block_size;
+      block->used = 0;
+      arena->head = block;
+   }
+
+   ptr = (char*)block->data + block->used;
+   block->used += size;
+   return ptr;
+}
+
+void ralloc_arena_mark(const struct ralloc_arena *arena,
+      struct ralloc_arena_mark *mark)
+{
+   mark->block = arena->head;
+   mark->used  = arena->head ? arena->head->used : 0;
+}
+
+void ralloc_arena_rewind(struct ralloc_arena *arena,
+      const struct ralloc_arena_mark *mark)
+{
+   if (!mark->block)
+   {
+      ralloc_arena_reset(arena);
+      return;
+   }
+
+   while (arena->head != mark->block)
+   {
+      struct ralloc_arena_block *prev = arena->head->prev;
+      ralloc_free(arena->head);
+      arena->head = prev;
+   }
+
+   arena->head->used = mark->used;
+}
+
+void ralloc_arena_reset(struct ralloc_arena *arena)
+{
+   while (arena->head && arena->head->prev)
+   {
+      struct ralloc_arena_block *prev = arena->head->prev;
+      ralloc_free(arena->head);
+      arena->head = prev;
+   }
+
+   if (arena->head)
+      arena->head->used = 0;
+}
+
+void ralloc_arena_free(struct ralloc_arena *arena)
+{
+   ralloc_arena_reset(arena);
+   ralloc_free(arena->head);
+   arena->head = NULL;
+}
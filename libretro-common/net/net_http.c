@@ -19,6 +19,7 @@
 #include <ctype.h>
 #include <net/net_http.h>
 #include <net/net_compat.h>
+#include <net/net_resolve.h>
 #include <compat/strl.h>
 
 enum
@@ -38,6 +39,9 @@ enum
    T_CHUNK
 };
 
+/* Idle connections kept open for later requests to the same server. */
+#define NET_HTTP_IDLE_MAX 4
+
 struct http_t
 {
 	int fd;
@@ -46,13 +50,40 @@ struct http_t
 	char part;
 	char bodytype;
 	bool error;
+	/* The server lets us send another request on this socket. */
+	bool keep_alive;
+	/* The socket was kept open by an earlier request. */
+	bool reused;
 	
 	size_t pos;
 	size_t len;
 	size_t buflen;
 	char * data;
+
+	/* Body is written here as it arrives instead, see 
+	 * net_http_set_output_file(). */
+	FILE *file;
+	size_t written;
+	bool to_file;
+
+	char *domain;
+	int port;
+	char *request;
+	/* Set until the server's address is known. */
+	net_resolve_t *resolve;
+};
+
+struct net_http_idle
+{
+   char domain[256];
+   int port;
+   int fd;
 };
 
+/* Only touched by the thread running the transfers. */
+static struct net_http_idle net_http_idle[NET_HTTP_IDLE_MAX];
+static unsigned net_http_idle_count;
+
 struct http_connection_t
 {
    char *domain;
@@ -63,45 +94,35 @@ struct http_connection_t
 };
 
 
-static int net_http_new_socket(const char * domain, int port)
+/* Tries each address in turn. */
+static int net_http_new_socket(const struct addrinfo *addr)
 {
-   char portstr[16];
-   int fd, i = 1;
-#ifdef _WIN32
-   u_long mode = 1;
-#else
+   int fd = -1;
+#ifndef _WIN32
    struct timeval timeout;
 #endif
-   struct addrinfo hints, *addr = NULL;
-
-   snprintf(portstr, sizeof(portstr), "%i", port);
-
-   memset(&hints, 0, sizeof(hints));
-   hints.ai_family   = AF_UNSPEC;
-   hints.ai_socktype = SOCK_STREAM;
-   hints.ai_flags    = 0;
-
-   if (getaddrinfo_rarch(domain, portstr, &hints, &addr) < 0)
-      return -1;
 
-   (void)i;
-
-   fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+   for (; addr; addr = addr->ai_next)
+   {
+      fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+      if (fd < 0)
+         continue;
 
 #ifndef _WIN32
-   timeout.tv_sec=4;
-   timeout.tv_usec=0;
-   setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof timeout);
+      timeout.tv_sec=4;
+      timeout.tv_usec=0;
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof timeout);
 #endif
 
-   if (connect(fd, addr->ai_addr, addr->ai_addrlen) != 0)
-   {
-      freeaddrinfo_rarch(addr);
+      if (connect(fd, addr->ai_addr, addr->ai_addrlen) == 0)
+         break;
+
       socket_close(fd);
-      return -1;
+      fd = -1;
    }
 
-   freeaddrinfo_rarch(addr);
+   if (fd < 0)
+      return -1;
 
    if (!socket_nonblock(fd))
    {
@@ -124,7 +145,9 @@ static void net_http_send(int fd, bool * error,
 
       if (thislen <= 0)
       {
-         if (!isagain(thislen))
+         /* The socket is non-blocking, the request 
+          * is small enough to just try again. */
+         if (isagain(thislen))
             continue;
 
          *error=true;
@@ -162,6 +185,103 @@ static ssize_t net_http_recv(int fd, bool *error,
    return -1;
 }
 
+/* A kept-alive socket must have nothing to read, 
+ * otherwise the server closed it or sent garbage. */
+static bool net_http_socket_idle(int fd)
+{
+   char c;
+   ssize_t ret = recv(fd, &c, 1, MSG_PEEK);
+
+   return ret < 0 && isagain(ret);
+}
+
+static int net_http_take_idle(const char *domain, int port)
+{
+   unsigned i = 0;
+
+   while (i < net_http_idle_count)
+   {
+      int fd = net_http_idle[i].fd;
+
+      if (net_http_idle[i].port != port 
+            || strcmp(net_http_idle[i].domain, domain))
+      {
+         i++;
+         continue;
+      }
+
+      memmove(&net_http_idle[i], &net_http_idle[i + 1],
+            (--net_http_idle_count - i) * sizeof(net_http_idle[0]));
+
+      if (net_http_socket_idle(fd))
+         return fd;
+
+      socket_close(fd);
+   }
+
+   return -1;
+}
+
+static void net_http_put_idle(const char *domain, int port, int fd)
+{
+   if (strlen(domain) >= sizeof(net_http_idle[0].domain))
+   {
+      socket_close(fd);
+      return;
+   }
+
+   /* Drop the oldest one. */
+   if (net_http_idle_count == NET_HTTP_IDLE_MAX)
+   {
+      socket_close(net_http_idle[0].fd);
+      memmove(&net_http_idle[0], &net_http_idle[1],
+            --net_http_idle_count * sizeof(net_http_idle[0]));
+   }
+
+   strcpy(net_http_idle[net_http_idle_count].domain, domain);
+   net_http_idle[net_http_idle_count].port = port;
+   net_http_idle[net_http_idle_count].fd   = fd;
+   net_http_idle_count++;
+}
+
+void net_http_close_idle(void)
+{
+   while (net_http_idle_count)
+      socket_close(net_http_idle[--net_http_idle_count].fd);
+}
+
+/* Header names are case-insensitive. Returns the value 
+ * if @line is header @name, otherwise NULL. */
+static const char *net_http_header(const char *line, const char *name)
+{
+   size_t len = strlen(name);
+   size_t i;
+
+   for (i = 0; i < len; i++)
+   {
+      if (tolower((unsigned char)line[i]) != name[i])
+         return NULL;
+   }
+
+   if (line[len] != ':')
+      return NULL;
+
+   line += len + 1;
+   while (*line == ' ' || *line == '\t')
+      line++;
+   return line;
+}
+
+static bool net_http_value_is(const char *value, const char *text)
+{
+   for (; *text; value++, text++)
+   {
+      if (tolower((unsigned char)*value) != *text)
+         return false;
+   }
+   return *value == '\0' || *value == ' ' || *value == ',';
+}
+
 struct http_connection_t *net_http_connection_new(const char *url)
 {
    char **domain = NULL;
@@ -213,6 +333,7 @@ bool net_http_connection_iterate(struct http_connection_t *conn)
 bool net_http_connection_done(struct http_connection_t *conn)
 {
    char **location = NULL;
+   char separator;
 
    if (!conn)
       return false;
@@ -222,10 +343,11 @@ bool net_http_connection_done(struct http_connection_t *conn)
    if (*conn->scan == '\0')
       return false;
 
+   separator     = *conn->scan;
    *conn->scan   = '\0';
    conn->port   = 80;
 
-   if (*conn->scan == ':')
+   if (separator == ':')
    {
 
       if (!isdigit(conn->scan[1]))
@@ -249,57 +371,118 @@ void net_http_connection_free(struct http_connection_t *conn)
 
    if (conn->urlcopy)
       free(conn->urlcopy);
+   free(conn);
 }
 
-struct http_t *net_http_new(struct http_connection_t *conn)
+static bool net_http_send_request_now(struct http_t *state)
 {
-   bool error;
-   int fd = -1;
-   struct http_t *state      = NULL;
-
-   if (!conn)
-      goto error;
+   bool error = false;
 
-   fd = net_http_new_socket(conn->domain, conn->port);
-   if (fd == -1)
-      goto error;
+   net_http_send_str(state->fd, &error, state->request);
 
-   error=false;
+   return !error;
+}
 
-   /* This is a bit lazy, but it works. */
-   net_http_send_str(fd, &error, "GET /");
-   net_http_send_str(fd, &error, conn->location);
-   net_http_send_str(fd, &error, " HTTP/1.1\r\n");
+/* Takes an idle connection to the same server and sends the 
+ * request. Otherwise looks up the server, and net_http_update 
+ * connects once that is done, so a slow DNS server doesn't 
+ * hold up the caller. */
+static bool net_http_send_request(struct http_t *state, bool allow_reuse)
+{
+   char portstr[16];
+   struct addrinfo hints;
 
-   net_http_send_str(fd, &error, "Host: ");
-   net_http_send_str(fd, &error, conn->domain);
+   state->fd     = allow_reuse 
+      ? net_http_take_idle(state->domain, state->port) : -1;
+   state->reused = state->fd != -1;
 
-   if (conn->port != 80)
+   if (state->reused)
    {
-      char portstr[16];
+      if (net_http_send_request_now(state))
+         return true;
 
-      snprintf(portstr, sizeof(portstr), ":%i", conn->port);
-      net_http_send_str(fd, &error, portstr);
+      /* The server may have just closed it. */
+      socket_close(state->fd);
+      state->fd     = -1;
+      state->reused = false;
    }
 
-   net_http_send_str(fd, &error, "\r\n");
-   net_http_send_str(fd, &error, "Connection: close\r\n");
-   net_http_send_str(fd, &error, "\r\n");
+   snprintf(portstr, sizeof(portstr), "%i", state->port);
+
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags    = 0;
+
+   state->resolve = net_resolve_new(state->domain, portstr, &hints);
+
+   return state->resolve != NULL;
+}
+
+/* Returns 1 once connected and the request is sent, 
+ * 0 while still looking up the server, -1 on failure. */
+static int net_http_connect(struct http_t *state)
+{
+   const struct addrinfo *addr = NULL;
+   enum net_resolve_status status = net_resolve_poll(state->resolve, &addr);
+
+   if (status == NET_RESOLVE_PENDING)
+      return 0;
+
+   if (status == NET_RESOLVE_DONE)
+      state->fd = net_http_new_socket(addr);
+
+   net_resolve_free(state->resolve);
+   state->resolve = NULL;
+
+   if (state->fd == -1 || !net_http_send_request_now(state))
+      return -1;
+
+   return 1;
+}
+
+struct http_t *net_http_new(struct http_connection_t *conn)
+{
+   size_t len;
+   struct http_t *state      = NULL;
+
+   if (!conn)
+      return NULL;
+
+   state = (struct http_t*)calloc(1, sizeof(struct http_t));
+   if (!state)
+      return NULL;
+
+   state->fd      = -1;
+   state->port    = conn->port;
+   state->domain  = strdup(conn->domain);
+
+   len            = strlen(conn->location) + strlen(conn->domain) + 64;
+   state->request = (char*)malloc(len);
+
+   if (!state->domain || !state->request)
+      goto error;
 
-   if (error)
+   /* HTTP/1.1 connections stay open unless either side says 
+    * otherwise, so the next request can skip connecting. */
+   if (conn->port != 80)
+      snprintf(state->request, len, "GET /%s HTTP/1.1\r\n"
+            "Host: %s:%i\r\n\r\n",
+            conn->location, conn->domain, conn->port);
+   else
+      snprintf(state->request, len, "GET /%s HTTP/1.1\r\n"
+            "Host: %s\r\n\r\n",
+            conn->location, conn->domain);
+
+   if (!net_http_send_request(state, true))
       goto error;
 
-   state          = (struct http_t*)malloc(sizeof(struct http_t));
-   state->fd      = fd;
-   state->status  = -1;
-   state->data    = NULL;
-   state->part    = P_HEADER_TOP;
-   state->bodytype= T_FULL;
-   state->error   = false;
-   state->pos     = 0;
-   state->len     = 0;
-   state->buflen  = 512;
-   state->data    = (char*)malloc(state->buflen);
+   state->status     = -1;
+   state->part       = P_HEADER_TOP;
+   state->bodytype   = T_FULL;
+   state->keep_alive = true;
+   state->buflen     = 512;
+   state->data       = (char*)malloc(state->buflen);
 
    if (!state->data)
       goto error;
@@ -307,11 +490,64 @@ struct http_t *net_http_new(struct http_connection_t *conn)
    return state;
 
 error:
-   if (fd != -1)
-      socket_close(fd);
+   net_http_delete(state);
    return NULL;
 }
 
+bool net_http_set_output_file(struct http_t *state, const char *path)
+{
+   if (!state || state->file)
+      return false;
+
+   state->file    = fopen(path, "wb");
+   state->to_file = state->file != NULL;
+   return state->to_file;
+}
+
+/* Bytes at the start of the buffer which are body data. */
+static size_t net_http_body_size(struct http_t *state)
+{
+   if (state->part < P_BODY || state->part == P_ERROR)
+      return 0;
+   if (state->bodytype == T_CHUNK && state->part == P_BODY_CHUNKLEN)
+      return state->len;
+   return state->pos;
+}
+
+/* Moves what has arrived of the body to the output file. */
+static bool net_http_flush(struct http_t *state)
+{
+   size_t size = net_http_body_size(state);
+
+   if (!size)
+      return true;
+
+   if (fwrite(state->data, 1, size, state->file) != size)
+      return false;
+
+   memmove(state->data, state->data + size, state->pos - size);
+   state->pos     -= size;
+   state->written += size;
+
+   if (state->bodytype == T_CHUNK && state->part == P_BODY_CHUNKLEN)
+      state->len   = 0;
+
+   return true;
+}
+
+/* A kept-alive connection may be closed by the server 
+ * just as the request goes out. Retries once on a new one. */
+static bool net_http_retry(struct http_t *state)
+{
+   if (!state->reused || state->part != P_HEADER_TOP || state->pos)
+      return false;
+
+   socket_close(state->fd);
+   state->fd    = -1;
+   state->error = false;
+   return net_http_send_request(state, false);
+}
+
 int net_http_fd(struct http_t *state)
 {
    if (!state)
@@ -323,16 +559,39 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
 {
    ssize_t newlen = 0;
 
-   if (!state || state->error)
+   if (!state)
+      return true;
+   if (state->error)
       goto fail;
 
+   if (state->resolve)
+   {
+      int ret = net_http_connect(state);
+
+      if (ret < 0)
+         goto fail;
+
+      if (ret == 0)
+      {
+         if (progress)
+            *progress = 0;
+         if (total)
+            *total = 0;
+         return false;
+      }
+   }
+
    if (state->part < P_BODY)
    {
       newlen = net_http_recv(state->fd, &state->error,
             (uint8_t*)state->data + state->pos, state->buflen - state->pos);
 
       if (newlen < 0)
+      {
+         if (net_http_retry(state))
+            return false;
          goto fail;
+      }
 
       if (state->pos + newlen >= state->buflen - 64)
       {
@@ -354,22 +613,37 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
 
          if (state->part == P_HEADER_TOP)
          {
-            if (strncmp(state->data, "HTTP/1.", strlen("HTTP/1."))!=0)
+            /* Left over from the end of a chunked 
+             * response on a reused connection. */
+            if (state->data[0] == '\0')
+               ;
+            else if (strncmp(state->data, "HTTP/1.", strlen("HTTP/1."))!=0)
                goto fail;
-            state->status = strtoul(state->data + strlen("HTTP/1.1 "), NULL, 10);
-            state->part   = P_HEADER;
+            else
+            {
+               state->status = strtoul(state->data + strlen("HTTP/1.1 "), NULL, 10);
+               state->part   = P_HEADER;
+
+               /* HTTP/1.0 closes the connection by default. */
+               if (state->data[strlen("HTTP/1.")] == '0')
+                  state->keep_alive = false;
+            }
          }
          else
          {
-            if (!strncmp(state->data, "Content-Length: ",
-                     strlen("Content-Length: ")))
+            const char *value = NULL;
+
+            if ((value = net_http_header(state->data, "content-length")))
             {
                state->bodytype = T_LEN;
-               state->len = strtol(state->data + 
-                     strlen("Content-Length: "), NULL, 10);
+               state->len = strtol(value, NULL, 10);
             }
-            if (!strcmp(state->data, "Transfer-Encoding: chunked"))
+            if ((value = net_http_header(state->data, "transfer-encoding"))
+                  && net_http_value_is(value, "chunked"))
                state->bodytype = T_CHUNK;
+            if ((value = net_http_header(state->data, "connection"))
+                  && net_http_value_is(value, "close"))
+               state->keep_alive = false;
 
             /* TODO: save headers somewhere */
             if (state->data[0]=='\0')
@@ -377,6 +651,11 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
                state->part = P_BODY;
                if (state->bodytype == T_CHUNK)
                   state->part = P_BODY_CHUNKLEN;
+
+               /* Nothing follows, the connection stays open. */
+               if (state->status == 204 || state->status == 304
+                     || (state->bodytype == T_LEN && !state->len))
+                  state->part = P_DONE;
             }
          }
 
@@ -387,6 +666,19 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
       {
          newlen = state->pos;
          state->pos = 0;
+
+         /* The size is known, so allocate it all at once 
+          * instead of doubling the buffer on the way. */
+         if (state->bodytype == T_LEN && !state->file
+               && state->len + 128 > state->buflen)
+         {
+            char *data = (char*)realloc(state->data, state->len + 128);
+
+            if (!data)
+               goto fail;
+            state->data   = data;
+            state->buflen = state->len + 128;
+         }
       }
    }
 
@@ -403,7 +695,9 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
             if (state->bodytype == T_FULL)
             {
                state->part = P_DONE;
-               state->data = (char*)realloc(state->data, state->len);
+               state->len  = state->pos;
+               if (!state->file)
+                  state->data = (char*)realloc(state->data, state->len);
             }
             else
                goto fail;
@@ -456,7 +750,8 @@ parse_again:
                   {
                      state->part = P_DONE;
                      state->len  = state->pos;
-                     state->data = (char*)realloc(state->data, state->len);
+                     if (!state->file)
+                        state->data = (char*)realloc(state->data, state->len);
                   }
                   goto parse_again;
                }
@@ -483,18 +778,39 @@ parse_again:
       {
          state->pos += newlen;
 
-         if (state->pos == state->len)
+         if (state->bodytype == T_LEN)
          {
-            state->part = P_DONE;
-            state->data = (char*)realloc(state->data, state->len);
+            if (state->written + state->pos == state->len)
+            {
+               state->part = P_DONE;
+               if (!state->file)
+                  state->data = (char*)realloc(state->data, state->len);
+            }
+            if (state->written + state->pos > state->len)
+               goto fail;
          }
-         if (state->pos > state->len)
+      }
+   }
+
+   if (state->file)
+   {
+      if (!net_http_flush(state))
+         goto fail;
+
+      if (state->part == P_DONE)
+      {
+         state->len = state->written;
+         if (fclose(state->file) != 0)
+         {
+            state->file = NULL;
             goto fail;
+         }
+         state->file = NULL;
       }
    }
 
    if (progress)
-      *progress = state->pos;
+      *progress = state->written + state->pos;
 
    if (total)
    {
@@ -526,6 +842,13 @@ uint8_t* net_http_data(struct http_t *state, size_t* len, bool accept_error)
    if (!state)
       return NULL;
 
+   if (state->to_file)
+   {
+      if (len)
+         *len = state->written;
+      return NULL;
+   }
+
    if (!accept_error && 
          (state->error || state->status<200 || state->status>299))
    {
@@ -546,8 +869,18 @@ void net_http_delete(struct http_t *state)
       return;
 
    if (state->fd != -1)
-      socket_close(state->fd);
-   if (state->data)
-      free(state->data);
+   {
+      if (state->part == P_DONE && state->keep_alive 
+            && state->bodytype != T_FULL)
+         net_http_put_idle(state->domain, state->port, state->fd);
+      else
+         socket_close(state->fd);
+   }
+   if (state->file)
+      fclose(state->file);
+   net_resolve_free(state->resolve);
+   free(state->data);
+   free(state->domain);
+   free(state->request);
    free(state);
 }
@@ -0,0 +1,444 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <net/net_resolve.h>
+#include <retro_atomic.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#define NET_RESOLVE_CACHE_SIZE 16
+
+/* getaddrinfo() doesn't tell the record's TTL. A minute
+ * covers reconnecting without holding on to stale addresses. */
+#define NET_RESOLVE_TTL 60
+
+/* Lookups finish on their own thread and fill the cache from
+ * there, which needs atomics for the lock. */
+#if !defined(HAVE_THREADS) || defined(HAVE_RETRO_ATOMIC)
+#define NET_RESOLVE_HAVE_CACHE
+#endif
+
+struct net_resolve
+{
+   char *node;
+   char service[16];
+   struct addrinfo hints;
+   struct addrinfo *res;
+   enum net_resolve_status status;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond;
+   /* The owner and the lookup thread. */
+   unsigned refs;
+#endif
+};
+
+#ifdef NET_RESOLVE_HAVE_CACHE
+struct net_resolve_entry
+{
+   char node[256];
+   char service[16];
+   int family;
+   int socktype;
+   int protocol;
+   int flags;
+   time_t expires;
+   struct addrinfo *res;
+};
+
+static struct net_resolve_entry net_resolve_cache[NET_RESOLVE_CACHE_SIZE];
+
+#ifdef HAVE_THREADS
+static volatile int net_resolve_cache_busy;
+#endif
+#endif
+
+/**
+ * net_resolve_copy:
+ * @list                 : Addresses as returned by getaddrinfo().
+ *
+ * Copies an address list into a single allocation,
+ * which free() releases at once.
+ *
+ * Returns: the copy, or NULL if @list is empty or out of memory.
+ **/
+static struct addrinfo *net_resolve_copy(const struct addrinfo *list)
+{
+   const struct addrinfo *info;
+   struct addrinfo *copy          = NULL;
+   struct sockaddr_storage *addrs = NULL;
+   size_t i, count                = 0;
+
+   for (info = list; info; info = info->ai_next)
+      count++;
+
+   if (!count)
+      return NULL;
+
+   copy = (struct addrinfo*)calloc(1,
+         count * (sizeof(*copy) + sizeof(*addrs)));
+   if (!copy)
+      return NULL;
+
+   addrs = (struct sockaddr_storage*)(copy + count);
+
+   for (info = list, i = 0; info; info = info->ai_next, i++)
+   {
+      size_t addrlen = info->ai_addrlen;
+
+      if (addrlen > sizeof(*addrs))
+         addrlen = sizeof(*addrs);
+
+      copy[i].ai_flags    = info->ai_flags;
+      copy[i].ai_family   = info->ai_family;
+      copy[i].ai_socktype = info->ai_socktype;
+      copy[i].ai_protocol = info->ai_protocol;
+      copy[i].ai_addrlen  = addrlen;
+      copy[i].ai_addr     = (struct sockaddr*)&addrs[i];
+      copy[i].ai_next     = (i + 1 < count) ? &copy[i + 1] : NULL;
+      memcpy(&addrs[i], info->ai_addr, addrlen);
+   }
+
+   return copy;
+}
+
+#ifdef NET_RESOLVE_HAVE_CACHE
+static void net_resolve_cache_lock(void)
+{
+#ifdef HAVE_THREADS
+   /* Only held to copy a few addresses. */
+   while (retro_atomic_exchange_int(&net_resolve_cache_busy, 1))
+      retro_cpu_relax();
+#endif
+}
+
+static void net_resolve_cache_unlock(void)
+{
+#ifdef HAVE_THREADS
+   retro_atomic_store_int(&net_resolve_cache_busy, 0);
+#endif
+}
+
+static bool net_resolve_cache_match(const struct net_resolve_entry *entry,
+      const char *node, const char *service, const struct addrinfo *hints)
+{
+   return entry->res
+      && entry->family   == hints->ai_family
+      && entry->socktype == hints->ai_socktype
+      && entry->protocol == hints->ai_protocol
+      && entry->flags    == hints->ai_flags
+      && !strcmp(entry->node, node)
+      && !strcmp(entry->service, service);
+}
+
+static struct addrinfo *net_resolve_cache_get(const char *node,
+      const char *service, const struct addrinfo *hints)
+{
+   unsigned i;
+   struct addrinfo *res = NULL;
+   time_t now           = time(NULL);
+
+   net_resolve_cache_lock();
+
+   for (i = 0; i < NET_RESOLVE_CACHE_SIZE; i++)
+   {
+      struct net_resolve_entry *entry = &net_resolve_cache[i];
+
+      if (!net_resolve_cache_match(entry, node, service, hints))
+         continue;
+
+      if (now < entry->expires)
+         res = net_resolve_copy(entry->res);
+      break;
+   }
+
+   net_resolve_cache_unlock();
+
+   return res;
+}
+
+static void net_resolve_cache_put(const char *node,
+      const char *service, const struct addrinfo *hints,
+      const struct addrinfo *res)
+{
+   unsigned i;
+   struct net_resolve_entry *slot = NULL;
+   struct addrinfo *copy          = NULL;
+   struct addrinfo *old           = NULL;
+   time_t now                     = time(NULL);
+
+   if (strlen(node) >= sizeof(slot->node)
+         || strlen(service) >= sizeof(slot->service))
+      return;
+
+   /* Copy outside of the lock. */
+   if (!(copy = net_resolve_copy(res)))
+      return;
+
+   net_resolve_cache_lock();
+
+   /* Same lookup, else an empty slot, else the oldest one. */
+   for (i = 0; i < NET_RESOLVE_CACHE_SIZE; i++)
+   {
+      struct net_resolve_entry *entry = &net_resolve_cache[i];
+
+      if (net_resolve_cache_match(entry, node, service, hints))
+      {
+         slot = entry;
+         break;
+      }
+
+      if (!slot || (slot->res && (!entry->res
+                  || entry->expires < slot->expires)))
+         slot = entry;
+   }
+
+   old            = slot->res;
+   strcpy(slot->node, node);
+   strcpy(slot->service, service);
+   slot->family   = hints->ai_family;
+   slot->socktype = hints->ai_socktype;
+   slot->protocol = hints->ai_protocol;
+   slot->flags    = hints->ai_flags;
+   slot->expires  = now + NET_RESOLVE_TTL;
+   slot->res      = copy;
+
+   net_resolve_cache_unlock();
+
+   free(old);
+}
+#endif
+
+/* The actual, blocking lookup. */
+static struct addrinfo *net_resolve_lookup(const char *node,
+      const char *service, const struct addrinfo *hints)
+{
+   struct addrinfo *res  = NULL;
+   struct addrinfo *copy = NULL;
+
+   if (getaddrinfo_rarch(node, service, hints, &res) < 0 || !res)
+      return NULL;
+
+   copy = net_resolve_copy(res);
+   freeaddrinfo_rarch(res);
+
+#ifdef NET_RESOLVE_HAVE_CACHE
+   if (copy && node)
+      net_resolve_cache_put(node, service, hints, copy);
+#endif
+
+   return copy;
+}
+
+static void net_resolve_destroy(net_resolve_t *req)
+{
+#ifdef HAVE_THREADS
+   if (req->lock)
+      slock_free(req->lock);
+   if (req->cond)
+      scond_free(req->cond);
+#endif
+   free(req->res);
+   free(req->node);
+   free(req);
+}
+
+#ifdef HAVE_THREADS
+static void net_resolve_thread(void *data)
+{
+   bool last            = false;
+   net_resolve_t *req   = (net_resolve_t*)data;
+   struct addrinfo *res = net_resolve_lookup(req->node,
+         req->service, &req->hints);
+
+   slock_lock(req->lock);
+   req->res    = res;
+   req->status = res ? NET_RESOLVE_DONE : NET_RESOLVE_FAILED;
+   scond_signal(req->cond);
+   last        = --req->refs == 0;
+   slock_unlock(req->lock);
+
+   /* The owner has given up on it already. */
+   if (last)
+      net_resolve_destroy(req);
+}
+#endif
+
+net_resolve_t *net_resolve_new(const char *node, const char *service,
+      const struct addrinfo *hints)
+{
+   net_resolve_t *req = (net_resolve_t*)calloc(1, sizeof(*req));
+
+   if (!req)
+      return NULL;
+
+   if (strlen(service) >= sizeof(req->service))
+      goto error;
+
+   strcpy(req->service, service);
+   req->hints.ai_family   = hints->ai_family;
+   req->hints.ai_socktype = hints->ai_socktype;
+   req->hints.ai_protocol = hints->ai_protocol;
+   req->hints.ai_flags    = hints->ai_flags;
+   req->status            = NET_RESOLVE_PENDING;
+
+   if (node)
+   {
+      if (!(req->node = strdup(node)))
+         goto error;
+
+#ifdef NET_RESOLVE_HAVE_CACHE
+      if ((req->res = net_resolve_cache_get(node, service, &req->hints)))
+      {
+         req->status = NET_RESOLVE_DONE;
+         return req;
+      }
+#endif
+   }
+
+#ifdef HAVE_THREADS
+   /* Without a name there is nothing to wait for. */
+   if (node)
+   {
+      sthread_t *thread = NULL;
+
+      req->lock = slock_new();
+      req->cond = scond_new();
+      req->refs = 2;
+
+      if (req->lock && req->cond
+            && (thread = sthread_create(net_resolve_thread, req)))
+      {
+         sthread_detach(thread);
+         return req;
+      }
+
+      req->refs = 1;
+   }
+#endif
+
+   req->res    = net_resolve_lookup(req->node, req->service, &req->hints);
+   req->status = req->res ? NET_RESOLVE_DONE : NET_RESOLVE_FAILED;
+
+   return req;
+
+error:
+   net_resolve_destroy(req);
+   return NULL;
+}
+
+enum net_resolve_status net_resolve_poll(net_resolve_t *req,
+      const struct addrinfo **res)
+{
+   enum net_resolve_status status;
+
+   if (!req)
+      return NET_RESOLVE_FAILED;
+
+#ifdef HAVE_THREADS
+   if (req->lock)
+      slock_lock(req->lock);
+#endif
+   status = req->status;
+#ifdef HAVE_THREADS
+   if (req->lock)
+      slock_unlock(req->lock);
+#endif
+
+   if (res)
+      *res = (status == NET_RESOLVE_DONE) ? req->res : NULL;
+
+   return status;
+}
+
+void net_resolve_free(net_resolve_t *req)
+{
+   bool last = true;
+
+   if (!req)
+      return;
+
+#ifdef HAVE_THREADS
+   if (req->lock)
+   {
+      slock_lock(req->lock);
+      last = --req->refs == 0;
+      slock_unlock(req->lock);
+   }
+#endif
+
+   if (last)
+      net_resolve_destroy(req);
+}
+
+int net_resolve_addrinfo(const char *node, const char *service,
+      const struct addrinfo *hints, struct addrinfo **res,
+      unsigned timeout_ms)
+{
+   const struct addrinfo *list = NULL;
+   net_resolve_t *req          = net_resolve_new(node, service, hints);
+
+   *res = NULL;
+
+   if (!req)
+      return -1;
+
+#ifdef HAVE_THREADS
+   if (req->lock)
+   {
+      slock_lock(req->lock);
+      while (req->status == NET_RESOLVE_PENDING)
+      {
+         if (!scond_wait_timeout(req->cond, req->lock,
+                  (int64_t)timeout_ms * 1000))
+            break;
+      }
+      slock_unlock(req->lock);
+   }
+#endif
+
+   if (net_resolve_poll(req, &list) == NET_RESOLVE_DONE)
+      *res = net_resolve_copy(list);
+
+   net_resolve_free(req);
+
+   return *res ? 0 : -1;
+}
+
+void net_resolve_freeaddrinfo(struct addrinfo *res)
+{
+   free(res);
+}
+
+void net_resolve_clear_cache(void)
+{
+#ifdef NET_RESOLVE_HAVE_CACHE
+   unsigned i;
+
+   net_resolve_cache_lock();
+   for (i = 0; i < NET_RESOLVE_CACHE_SIZE; i++)
+   {
+      free(net_resolve_cache[i].res);
+      net_resolve_cache[i].res = NULL;
+   }
+   net_resolve_cache_unlock();
+#endif
+}
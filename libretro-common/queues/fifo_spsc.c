@@ -0,0 +1,130 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (fifo_spsc.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <queues/fifo_spsc.h>
+
+#if defined(__GNUC__)
+#define FIFO_SPSC_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <windows.h>
+#define FIFO_SPSC_BARRIER() MemoryBarrier()
+#else
+/* Only safe on single-core or strongly ordered targets. */
+#define FIFO_SPSC_BARRIER()
+#endif
+
+fifo_spsc_t *fifo_spsc_new(size_t size)
+{
+   size_t storage = 1;
+   fifo_spsc_t *fifo = (fifo_spsc_t*)calloc(1, sizeof(*fifo));
+
+   if (!fifo)
+      return NULL;
+
+   /* Power-of-two storage keeps the free-running 
+    * counters valid across wraparound. */
+   while (storage < size)
+      storage <<= 1;
+
+   fifo->buffer = (uint8_t*)calloc(1, storage);
+   if (!fifo->buffer)
+   {
+      free(fifo);
+      return NULL;
+   }
+   fifo->size = size;
+   fifo->mask = storage - 1;
+
+   return fifo;
+}
+
+void fifo_spsc_free(fifo_spsc_t *fifo)
+{
+   if (!fifo)
+      return;
+
+   free(fifo->buffer);
+   free(fifo);
+}
+
+size_t fifo_spsc_read_avail(fifo_spsc_t *fifo)
+{
+   size_t avail = fifo->end - fifo->first;
+
+   /* Don't read data before seeing end move past it. */
+   FIFO_SPSC_BARRIER();
+   return avail;
+}
+
+size_t fifo_spsc_write_avail(fifo_spsc_t *fifo)
+{
+   size_t avail = fifo->size - (fifo->end - fifo->first);
+
+   /* Don't overwrite data before seeing first move past it. */
+   FIFO_SPSC_BARRIER();
+   return avail;
+}
+
+void fifo_spsc_write(fifo_spsc_t *fifo, const void *in_buf, size_t size)
+{
+   size_t end         = fifo->end;
+   size_t pos         = end & fifo->mask;
+   size_t first_write = size;
+   size_t rest_write  = 0;
+
+   if (pos + size > fifo->mask + 1)
+   {
+      first_write = fifo->mask + 1 - pos;
+      rest_write  = size - first_write;
+   }
+
+   memcpy(fifo->buffer + pos, in_buf, first_write);
+   memcpy(fifo->buffer, (const uint8_t*)in_buf + first_write, rest_write);
+
+   /* Publish the data before the consumer can see it. */
+   FIFO_SPSC_BARRIER();
+   fifo->end = end + size;
+}
+
+void fifo_spsc_read(fifo_spsc_t *fifo, void *in_buf, size_t size)
+{
+   size_t first      = fifo->first;
+   size_t pos        = first & fifo->mask;
+   size_t first_read = size;
+   size_t rest_read  = 0;
+
+   if (pos + size > fifo->mask + 1)
+   {
+      first_read = fifo->mask + 1 - pos;
+      rest_read  = size - first_read;
+   }
+
+   memcpy(in_buf, fifo->buffer + pos, first_read);
+   memcpy((uint8_t*)in_buf + first_read, fifo->buffer, rest_read);
+
+   /* Finish reading before handing the space back. */
+   FIFO_SPSC_BARRIER();
+   fifo->first = first + size;
+}
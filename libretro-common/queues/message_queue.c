@@ -1,7 +1,7 @@
 /* Copyright  (C) 2010-2015 The RetroArch team
  *
  * ---------------------------------------------------------------------------------------
- * The following license statement only applies to this file (rthreads.c).
+ * The following license statement only applies to this file (message_queue.c).
  * ---------------------------------------------------------------------------------------
  *
  * Permission is hereby granted, free of charge,
@@ -23,54 +23,324 @@
 #include <stdlib.h>
 #include <string.h>
 #include <boolean.h>
+#include <retro_inline.h>
+#include <retro_atomic.h>
 #include <queues/message_queue.h>
 #include <compat/strl.h>
-#include <compat/posix_string.h>
+
+/* Messages are copied into a fixed pool of slots. A producer 
+ * takes a free slot off a lock-free stack, fills it in and 
+ * appends its index to a ring. Only the thread pulling moves 
+ * slots from the ring into the priority heap, and hands them 
+ * back to the stack once they expired. Pushing therefore never 
+ * allocates or locks, and is safe from any thread. */
+
+#define MSG_QUEUE_DEFAULT_MSG_SIZE 1024
+
+/* The free stack head packs a slot index + 1 into the low 
+ * 16 bits and a tag into the rest, so that a slot taken and 
+ * returned in between doesn't fool the compare-and-swap. */
+#define MSG_QUEUE_MAX_SLOTS   0xfffe
+#define MSG_QUEUE_INDEX_MASK  0xffff
+#define MSG_QUEUE_TAG_SHIFT   16
+#define MSG_QUEUE_TAG_MASK    0x7fff
+
+#ifdef HAVE_RETRO_ATOMIC
+#define msg_queue_load(p)          retro_atomic_load_int(p)
+#define msg_queue_store(p, v)      retro_atomic_store_int(p, v)
+#define msg_queue_add(p, v)        retro_atomic_add_int(p, v)
+#define msg_queue_cas(p, e, d)     retro_atomic_cas_int(p, e, d)
+#else
+/* Single-threaded use only. */
+static INLINE int msg_queue_load(volatile int *p)
+{
+   return *p;
+}
+
+static INLINE void msg_queue_store(volatile int *p, int value)
+{
+   *p = value;
+}
+
+static INLINE int msg_queue_add(volatile int *p, int value)
+{
+   int old = *p;
+   *p      = old + value;
+   return old;
+}
+
+static INLINE bool msg_queue_cas(volatile int *p, int expected, int desired)
+{
+   if (*p != expected)
+      return false;
+   *p = desired;
+   return true;
+}
+#endif
 
 struct queue_elem
 {
    unsigned duration;
    unsigned prio;
-   char *msg;
+   /* Ring position it was pushed at, orders equal 
+    * priorities and tells which clear it predates. */
+   int pos;
+};
+
+struct queue_cell
+{
+   /* Position + 1 once the slot index is written. */
+   volatile int seq;
+   int slot;
 };
 
 struct msg_queue
 {
-   struct queue_elem **elems;
-   size_t ptr;
-   size_t size;
-   char *tmp_msg;
+   struct queue_elem *elems;
+   char *text;
+   size_t msg_size;
+   size_t num_slots;
+
+   volatile int free_head;
+   volatile int *free_next;
+
+   struct queue_cell *ring;
+   size_t ring_mask;
+   volatile int tail;
+   volatile int clear_pos;
+
+   /* Only touched by the thread pulling. */
+   int head;
+   int clear_seen;
+   int *heap;
+   size_t heap_count;
+   /* Returned by the last pull, freed by the next one. */
+   int retired;
 };
 
+/* Positions wrap around, compare them by distance. */
+static INLINE bool msg_queue_before(int a, int b)
+{
+   return (int)((unsigned)a - (unsigned)b) < 0;
+}
+
+static INLINE char *msg_queue_text(msg_queue_t *queue, int slot)
+{
+   return queue->text + slot * queue->msg_size;
+}
+
+static int msg_queue_slot_take(msg_queue_t *queue)
+{
+   int head = msg_queue_load(&queue->free_head);
+
+   for (;;)
+   {
+      int index = head & MSG_QUEUE_INDEX_MASK;
+      int tag   = (head >> MSG_QUEUE_TAG_SHIFT) + 1;
+      int next;
+
+      if (!index)
+         return -1;
+
+      next = msg_queue_load(&queue->free_next[index - 1]);
+
+      if (msg_queue_cas(&queue->free_head, head,
+               ((tag & MSG_QUEUE_TAG_MASK) << MSG_QUEUE_TAG_SHIFT) | next))
+         return index - 1;
+
+      head = msg_queue_load(&queue->free_head);
+   }
+}
+
+static void msg_queue_slot_release(msg_queue_t *queue, int slot)
+{
+   int head, tag;
+
+   do
+   {
+      head = msg_queue_load(&queue->free_head);
+      tag  = (head >> MSG_QUEUE_TAG_SHIFT) + 1;
+      msg_queue_store(&queue->free_next[slot], head & MSG_QUEUE_INDEX_MASK);
+   } while (!msg_queue_cas(&queue->free_head, head,
+            ((tag & MSG_QUEUE_TAG_MASK) << MSG_QUEUE_TAG_SHIFT) | (slot + 1)));
+}
+
+/* Higher priority first, older first among equals. */
+static INLINE bool msg_queue_higher(msg_queue_t *queue, int a, int b)
+{
+   const struct queue_elem *elem_a = &queue->elems[a];
+   const struct queue_elem *elem_b = &queue->elems[b];
+
+   if (elem_a->prio != elem_b->prio)
+      return elem_a->prio > elem_b->prio;
+   return msg_queue_before(elem_a->pos, elem_b->pos);
+}
+
+static void msg_queue_sift_up(msg_queue_t *queue, size_t i)
+{
+   while (i > 0)
+   {
+      size_t parent = (i - 1) >> 1;
+      int tmp;
+
+      if (!msg_queue_higher(queue, queue->heap[i], queue->heap[parent]))
+         break;
+
+      tmp                  = queue->heap[parent];
+      queue->heap[parent]  = queue->heap[i];
+      queue->heap[i]       = tmp;
+      i                    = parent;
+   }
+}
+
+static void msg_queue_sift_down(msg_queue_t *queue, size_t i)
+{
+   for (;;)
+   {
+      size_t best  = i;
+      size_t left  = 2 * i + 1;
+      size_t right = 2 * i + 2;
+      int tmp;
+
+      if (left < queue->heap_count
+            && msg_queue_higher(queue, queue->heap[left], queue->heap[best]))
+         best = left;
+      if (right < queue->heap_count
+            && msg_queue_higher(queue, queue->heap[right], queue->heap[best]))
+         best = right;
+
+      if (best == i)
+         break;
+
+      tmp               = queue->heap[best];
+      queue->heap[best] = queue->heap[i];
+      queue->heap[i]    = tmp;
+      i                 = best;
+   }
+}
+
+/* Moves pushed messages into the heap, and drops 
+ * the ones a clear was issued after. */
+static void msg_queue_drain(msg_queue_t *queue)
+{
+   int clear_pos = msg_queue_load(&queue->clear_pos);
+
+   if (clear_pos != queue->clear_seen)
+   {
+      size_t i, count = 0;
+
+      for (i = 0; i < queue->heap_count; i++)
+      {
+         int slot = queue->heap[i];
+
+         if (msg_queue_before(queue->elems[slot].pos, clear_pos))
+            msg_queue_slot_release(queue, slot);
+         else
+            queue->heap[count++] = slot;
+      }
+
+      queue->heap_count = count;
+      for (i = count / 2; i-- > 0; )
+         msg_queue_sift_down(queue, i);
+
+      queue->clear_seen = clear_pos;
+   }
+
+   for (;;)
+   {
+      struct queue_cell *cell = &queue->ring[queue->head & queue->ring_mask];
+      int slot;
+
+      if (msg_queue_load(&cell->seq) != queue->head + 1)
+         break;
+
+      slot = cell->slot;
+      queue->head++;
+
+      if (msg_queue_before(queue->elems[slot].pos, clear_pos))
+      {
+         msg_queue_slot_release(queue, slot);
+         continue;
+      }
+
+      queue->heap[queue->heap_count] = slot;
+      msg_queue_sift_up(queue, queue->heap_count++);
+   }
+}
+
 /**
- * msg_queue_new:
- * @size              : maximum size of message
+ * msg_queue_new_sized:
+ * @size              : maximum number of messages
+ * @msg_size          : maximum length of a message,
+ *                      including the terminator
  *
- * Creates a message queue with maximum size different messages.
+ * Creates a message queue.
  *
  * Returns: NULL if allocation error, pointer to a message queue
  * if successful. Has to be freed manually.
  **/
-msg_queue_t *msg_queue_new(size_t size)
+msg_queue_t *msg_queue_new_sized(size_t size, size_t msg_size)
 {
-   msg_queue_t *queue = (msg_queue_t*)calloc(1, sizeof(*queue));
+   size_t i, ring_size = 1;
+   msg_queue_t *queue  = NULL;
+
+   /* One more for the message handed out by the last pull. */
+   size_t num_slots    = size + 1;
+
+   if (!size || !msg_size || num_slots > MSG_QUEUE_MAX_SLOTS)
+      return NULL;
+
+   /* As many cells as slots, so a producer holding 
+    * a slot always finds its cell empty. */
+   while (ring_size < num_slots)
+      ring_size <<= 1;
+
+   queue = (msg_queue_t*)calloc(1, sizeof(*queue));
    if (!queue)
       return NULL;
 
-   queue->size = size + 1;
-   queue->elems = (struct queue_elem**)
-      calloc(queue->size,sizeof(struct queue_elem*)); 
+   queue->msg_size  = msg_size;
+   queue->num_slots = num_slots;
+   queue->ring_mask = ring_size - 1;
+   queue->retired   = -1;
 
-   if (!queue->elems)
+   queue->elems     = (struct queue_elem*)
+      calloc(num_slots, sizeof(*queue->elems));
+   queue->text      = (char*)calloc(num_slots, msg_size);
+   queue->free_next = (volatile int*)calloc(num_slots, sizeof(int));
+   queue->ring      = (struct queue_cell*)
+      calloc(ring_size, sizeof(*queue->ring));
+   queue->heap      = (int*)calloc(num_slots, sizeof(int));
+
+   if (!queue->elems || !queue->text || !queue->free_next
+         || !queue->ring || !queue->heap)
    {
-      free(queue);
+      msg_queue_free(queue);
       return NULL;
    }
-   queue->ptr = 1;
+
+   for (i = 0; i < num_slots; i++)
+      queue->free_next[i] = (i + 1 < num_slots) ? (int)(i + 2) : 0;
+   queue->free_head = 1;
 
    return queue;
 }
 
+/**
+ * msg_queue_new:
+ * @size              : maximum number of messages
+ *
+ * Creates a message queue for messages of up to 
+ * 1023 characters.
+ *
+ * Returns: NULL if allocation error, pointer to a message queue
+ * if successful. Has to be freed manually.
+ **/
+msg_queue_t *msg_queue_new(size_t size)
+{
+   return msg_queue_new_sized(size, MSG_QUEUE_DEFAULT_MSG_SIZE);
+}
+
 /**
  * msg_queue_free:
  * @queue             : pointer to queue object
@@ -79,15 +349,17 @@ msg_queue_t *msg_queue_new(size_t size)
  **/
 void msg_queue_free(msg_queue_t *queue)
 {
-   if (queue)
-   {
-      msg_queue_clear(queue);
-      free(queue->elems);
-   }
+   if (!queue)
+      return;
+
+   free(queue->elems);
+   free(queue->text);
+   free((void*)queue->free_next);
+   free(queue->ring);
+   free(queue->heap);
    free(queue);
 }
 
-
 /**
  * msg_queue_push:
  * @queue             : pointer to queue object
@@ -97,70 +369,54 @@ void msg_queue_free(msg_queue_t *queue)
  *                      before it vanishes (E.g. show a message for
  *                      3 seconds @ 60fps = 180 duration).
  *
- * Push a new message onto the queue.
+ * Push a new message onto the queue. Dropped if the queue is
+ * full, and cut short if too long.
  **/
 void msg_queue_push(msg_queue_t *queue, const char *msg,
       unsigned prio, unsigned duration)
 {
-   size_t tmp_ptr = 0;
-   struct queue_elem *new_elem = NULL;
+   int slot, pos;
+   struct queue_cell *cell = NULL;
 
-   if (!queue || queue->ptr >= queue->size)
+   if (!queue)
       return;
 
-   new_elem                      = (struct queue_elem*)
-      calloc(1, sizeof(struct queue_elem));
-   if (!new_elem)
+   if ((slot = msg_queue_slot_take(queue)) < 0)
       return;
 
-   new_elem->prio                = prio;
-   new_elem->duration            = duration;
-   new_elem->msg                 = msg ? strdup(msg) : NULL;
-
-   queue->elems[queue->ptr]      = new_elem;
-
-   tmp_ptr                       = queue->ptr++;
+   strlcpy(msg_queue_text(queue, slot), msg ? msg : "", queue->msg_size);
+   queue->elems[slot].prio     = prio;
+   queue->elems[slot].duration = duration;
 
-   while (tmp_ptr > 1)
-   {
-      struct queue_elem *parent  = queue->elems[tmp_ptr >> 1];
-      struct queue_elem *child   = queue->elems[tmp_ptr];
-
-      if (child->prio <= parent->prio)
-         break;
+   pos                         = msg_queue_add(&queue->tail, 1);
+   queue->elems[slot].pos      = pos;
 
-      queue->elems[tmp_ptr >> 1] = child;
-      queue->elems[tmp_ptr]      = parent;
-
-      tmp_ptr >>= 1;
-   }
+   cell                        = &queue->ring[pos & queue->ring_mask];
+   cell->slot                  = slot;
+   msg_queue_store(&cell->seq, pos + 1);
 }
 
 /**
  * msg_queue_clear:
  * @queue             : pointer to queue object
  *
- * Clears out everything in the queue.
+ * Clears out everything pushed so far. Messages
+ * pushed afterwards are kept, also from other threads.
  **/
 void msg_queue_clear(msg_queue_t *queue)
 {
-   size_t i;
+   int tail, clear_pos;
 
    if (!queue)
       return;
 
-   for (i = 1; i < queue->ptr; i++)
-   {
-      if (queue->elems[i])
-      {
-         free(queue->elems[i]->msg);
-         free(queue->elems[i]);
-         queue->elems[i] = NULL;
-      }
-   }
-   queue->ptr = 1;
-   free(queue->tmp_msg);
-   queue->tmp_msg = NULL;
+   tail      = msg_queue_load(&queue->tail);
+   clear_pos = msg_queue_load(&queue->clear_pos);
+
+   /* Another thread may have cleared up to a later push. */
+   while (msg_queue_before(clear_pos, tail)
+         && !msg_queue_cas(&queue->clear_pos, clear_pos, tail))
+      clear_pos = msg_queue_load(&queue->clear_pos);
 }
 
 /**
@@ -170,66 +426,40 @@ void msg_queue_clear(msg_queue_t *queue)
  * Pulls highest priority message in queue.
  *
  * Returns: NULL if no message in queue, otherwise a string
- * containing the message.
+ * containing the message, valid until the next pull.
  **/
 const char *msg_queue_pull(msg_queue_t *queue)
 {
-   struct queue_elem *front  = NULL, *last = NULL,
-                     *parent = NULL, *child = NULL;
-   size_t tmp_ptr = 1;
-    
-   (void)parent;
-   (void)child;
-   (void)tmp_ptr;
-    
-   /* Nothing in queue. */
-   if (!queue || queue->ptr == 1)
-      return NULL;
-
-   front = (struct queue_elem*)queue->elems[1];
-   front->duration--;
-   if (front->duration > 0)
-      return front->msg;
-
-   free(queue->tmp_msg);
-   queue->tmp_msg = front->msg;
-   front->msg = NULL;
+   int slot;
+   struct queue_elem *front = NULL;
 
-   front = (struct queue_elem*)queue->elems[1];
-   last  = (struct queue_elem*)queue->elems[--queue->ptr];
-   queue->elems[1] = last;
-   free(front);
+   if (!queue)
+      return NULL;
 
-   for (;;)
+   if (queue->retired >= 0)
    {
-      size_t switch_index = tmp_ptr;
-      bool left = (tmp_ptr * 2 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2]);
-      bool right = (tmp_ptr * 2 + 1 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2 + 1]);
+      msg_queue_slot_release(queue, queue->retired);
+      queue->retired = -1;
+   }
 
-      if (!left && !right)
-         break;
+   msg_queue_drain(queue);
 
-      if (left && !right)
-         switch_index <<= 1;
-      else if (right && !left)
-         switch_index += switch_index + 1;
-      else
-      {
-         if (queue->elems[tmp_ptr * 2]
-               >= queue->elems[tmp_ptr * 2 + 1])
-            switch_index <<= 1;
-         else
-            switch_index += switch_index + 1;
-      }
+   /* Nothing in queue. */
+   if (!queue->heap_count)
+      return NULL;
+
+   slot  = queue->heap[0];
+   front = &queue->elems[slot];
 
-      parent = (struct queue_elem*)queue->elems[tmp_ptr];
-      child  = (struct queue_elem*)queue->elems[switch_index];
-      queue->elems[tmp_ptr] = child;
-      queue->elems[switch_index] = parent;
-      tmp_ptr = switch_index;
+   if (front->duration > 1)
+   {
+      front->duration--;
+      return msg_queue_text(queue, slot);
    }
 
-   return queue->tmp_msg;
+   queue->heap[0] = queue->heap[--queue->heap_count];
+   msg_queue_sift_down(queue, 0);
+
+   queue->retired = slot;
+   return msg_queue_text(queue, slot);
 }
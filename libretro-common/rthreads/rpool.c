@@ -0,0 +1,680 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpool.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <rthreads/rpool.h>
+#include <rthreads/rthreads.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef _XBOX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#elif defined(__linux__) && !defined(ANDROID)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#define RPOOL_QUEUE_SIZE 64
+
+struct rpool_group
+{
+   unsigned pending;
+   unsigned waiters;
+};
+
+struct rpool_future
+{
+   rpool_t *pool;
+   rpool_group_t group;
+   rpool_future_task_t task;
+   void *userdata;
+   void *result;
+};
+
+struct rpool_entry
+{
+   /* NULL once a group waiter has taken the
+    * entry out of the middle of the queue. */
+   rpool_task_t task;
+   void *userdata;
+   rpool_group_t *group;
+};
+
+struct rpool_worker
+{
+   rpool_t *pool;
+   sthread_t *thread;
+   uintptr_t id;
+   unsigned index;
+
+   /* The owner pushes and pops at the tail,
+    * thieves take the oldest entries at the head. */
+   slock_t *lock;
+   struct rpool_entry *entries;
+   unsigned mask;
+   unsigned head;
+   unsigned tail;
+};
+
+struct rpool
+{
+   struct rpool_worker *workers;
+   unsigned num_threads;
+   enum rpool_priority priority;
+   bool pin_threads;
+
+   /* Guards everything below, and group counters. */
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done_cond;
+   unsigned queued;
+   unsigned started;
+   unsigned next_queue;
+   bool die;
+};
+
+struct rpool_run_state
+{
+   rpool_t *pool;
+   rpool_work_t work;
+   void *userdata;
+   unsigned next;
+   unsigned count;
+   unsigned helpers;
+};
+
+static void rpool_thread_setup(rpool_t *pool, unsigned index)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   /* Core 0 is left to the threads which submit work. */
+   if (pool->pin_threads && index + 1 < sizeof(DWORD_PTR) * 8)
+      SetThreadAffinityMask(GetCurrentThread(),
+            (DWORD_PTR)1 << (index + 1));
+
+   if (pool->priority == RPOOL_PRIORITY_LOW)
+      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+   else if (pool->priority == RPOOL_PRIORITY_HIGH)
+      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+#elif defined(__linux__) && !defined(ANDROID)
+   pid_t tid = (pid_t)syscall(SYS_gettid);
+
+   /* Only declared with _GNU_SOURCE, which may have been
+    * missed when this file is included after others. */
+#ifdef CPU_SETSIZE
+   if (pool->pin_threads && index + 1 < CPU_SETSIZE)
+   {
+      cpu_set_t set;
+
+      CPU_ZERO(&set);
+      CPU_SET(index + 1, &set);
+      /* Fails if the core is offline, the thread
+       * then runs wherever the scheduler likes. */
+      sched_setaffinity(0, sizeof(set), &set);
+   }
+#endif
+
+   /* Linux threads have their own nice value. */
+   if (pool->priority == RPOOL_PRIORITY_LOW)
+      setpriority(PRIO_PROCESS, tid, 10);
+   else if (pool->priority == RPOOL_PRIORITY_HIGH)
+      setpriority(PRIO_PROCESS, tid, -5);
+#else
+   (void)pool;
+   (void)index;
+#endif
+}
+
+static struct rpool_worker *rpool_current_worker(rpool_t *pool)
+{
+   unsigned i;
+   uintptr_t id = sthread_get_current_thread_id();
+
+   /* Some platforms have no thread IDs. */
+   if (!id)
+      return NULL;
+
+   for (i = 0; i < pool->num_threads; i++)
+   {
+      if (pool->workers[i].id == id)
+         return &pool->workers[i];
+   }
+
+   return NULL;
+}
+
+static bool rpool_push(struct rpool_worker *w,
+      const struct rpool_entry *entry)
+{
+   slock_lock(w->lock);
+
+   if (w->tail - w->head > w->mask)
+   {
+      unsigned i;
+      unsigned size                = w->tail - w->head;
+      struct rpool_entry *entries  = (struct rpool_entry*)
+         malloc(2 * size * sizeof(*entries));
+
+      if (!entries)
+      {
+         slock_unlock(w->lock);
+         return false;
+      }
+
+      for (i = 0; i < size; i++)
+         entries[i] = w->entries[(w->head + i) & w->mask];
+
+      free(w->entries);
+      w->entries = entries;
+      w->mask    = 2 * size - 1;
+      w->head    = 0;
+      w->tail    = size;
+   }
+
+   w->entries[w->tail++ & w->mask] = *entry;
+   slock_unlock(w->lock);
+   return true;
+}
+
+/* Takes the newest entry, which is most likely still in cache. */
+static bool rpool_pop(struct rpool_worker *w, struct rpool_entry *entry)
+{
+   bool ret = false;
+
+   slock_lock(w->lock);
+   while (w->tail != w->head)
+   {
+      *entry = w->entries[--w->tail & w->mask];
+      if (entry->task)
+      {
+         ret = true;
+         break;
+      }
+   }
+   slock_unlock(w->lock);
+   return ret;
+}
+
+/* Takes the oldest entry, which is usually the largest piece
+ * of work left, so thieves don't need to come back soon. */
+static bool rpool_steal(struct rpool_worker *w, struct rpool_entry *entry)
+{
+   bool ret = false;
+
+   slock_lock(w->lock);
+   while (w->tail != w->head)
+   {
+      *entry = w->entries[w->head++ & w->mask];
+      if (entry->task)
+      {
+         ret = true;
+         break;
+      }
+   }
+   slock_unlock(w->lock);
+   return ret;
+}
+
+static bool rpool_take_group(struct rpool_worker *w,
+      rpool_group_t *group, struct rpool_entry *entry)
+{
+   unsigned i;
+   bool ret = false;
+
+   slock_lock(w->lock);
+   for (i = w->head; i != w->tail; i++)
+   {
+      struct rpool_entry *e = &w->entries[i & w->mask];
+
+      if (e->task && e->group == group)
+      {
+         *entry  = *e;
+         e->task = NULL;
+         ret     = true;
+         break;
+      }
+   }
+   slock_unlock(w->lock);
+   return ret;
+}
+
+/**
+ * rpool_take:
+ * @pool                    : Pool handle.
+ * @self                    : Worker of the calling thread, or NULL.
+ * @group                   : Only take tasks of this group, or NULL.
+ * @entry                   : Where to store the task.
+ *
+ * Returns: true (1) if a task was taken, otherwise false (0).
+ **/
+static bool rpool_take(rpool_t *pool, struct rpool_worker *self,
+      rpool_group_t *group, struct rpool_entry *entry)
+{
+   unsigned i;
+   bool ret     = false;
+   unsigned n   = pool->num_threads;
+   unsigned ofs = self ? self->index : 0;
+
+   if (group)
+   {
+      for (i = 0; i < n && !ret; i++)
+         ret = rpool_take_group(&pool->workers[(ofs + i) % n], group, entry);
+   }
+   else
+   {
+      if (self)
+         ret = rpool_pop(self, entry);
+
+      for (i = self ? 1 : 0; i < n && !ret; i++)
+         ret = rpool_steal(&pool->workers[(ofs + i) % n], entry);
+   }
+
+   if (ret)
+   {
+      slock_lock(pool->lock);
+      pool->queued--;
+      slock_unlock(pool->lock);
+   }
+
+   return ret;
+}
+
+static void rpool_finish(rpool_t *pool, rpool_group_t *group)
+{
+   if (!group)
+      return;
+
+   slock_lock(pool->lock);
+   if (--group->pending == 0 && group->waiters)
+      scond_broadcast(pool->done_cond);
+   slock_unlock(pool->lock);
+}
+
+static void rpool_thread_loop(void *data)
+{
+   struct rpool_worker *w = (struct rpool_worker*)data;
+   rpool_t *pool          = w->pool;
+
+   w->id = sthread_get_current_thread_id();
+   rpool_thread_setup(pool, w->index);
+
+   slock_lock(pool->lock);
+   pool->started++;
+   scond_broadcast(pool->done_cond);
+   slock_unlock(pool->lock);
+
+   for (;;)
+   {
+      struct rpool_entry entry = {0};
+
+      if (rpool_take(pool, w, NULL, &entry))
+      {
+         entry.task(entry.userdata);
+         rpool_finish(pool, entry.group);
+         continue;
+      }
+
+      /* Tasks are run before quitting, their
+       * submitters may still be waiting for them. */
+      slock_lock(pool->lock);
+      if (!pool->queued)
+      {
+         if (pool->die)
+         {
+            slock_unlock(pool->lock);
+            break;
+         }
+         scond_wait(pool->cond, pool->lock);
+      }
+      slock_unlock(pool->lock);
+   }
+}
+
+static void rpool_destroy(rpool_t *pool)
+{
+   unsigned i;
+
+   for (i = 0; i < pool->num_threads; i++)
+   {
+      free(pool->workers[i].entries);
+      if (pool->workers[i].lock)
+         slock_free(pool->workers[i].lock);
+   }
+   free(pool->workers);
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   free(pool);
+}
+
+rpool_t *rpool_new(const struct rpool_attr *attr)
+{
+   unsigned i;
+   unsigned threads = attr->num_threads;
+   rpool_t *pool    = NULL;
+
+   if (!threads)
+      return NULL;
+
+   pool = (rpool_t*)calloc(1, sizeof(*pool));
+   if (!pool)
+      return NULL;
+
+   pool->priority    = attr->priority;
+   pool->pin_threads = attr->pin_threads;
+   pool->lock        = slock_new();
+   pool->cond        = scond_new();
+   pool->done_cond   = scond_new();
+   pool->workers     = (struct rpool_worker*)
+      calloc(threads, sizeof(*pool->workers));
+
+   if (!pool->lock || !pool->cond || !pool->done_cond || !pool->workers)
+      goto error;
+
+   for (i = 0; i < threads; i++)
+   {
+      struct rpool_worker *w = &pool->workers[i];
+
+      w->pool    = pool;
+      w->index   = i;
+      w->mask    = RPOOL_QUEUE_SIZE - 1;
+      w->lock    = slock_new();
+      w->entries = (struct rpool_entry*)
+         malloc(RPOOL_QUEUE_SIZE * sizeof(*w->entries));
+
+      pool->num_threads++;
+
+      if (!w->lock || !w->entries)
+         goto error;
+   }
+
+   /* With some threads missing, the pool gets by with the others. */
+   for (i = 0; i < threads; i++)
+   {
+      pool->workers[i].thread = sthread_create(rpool_thread_loop,
+            &pool->workers[i]);
+      if (!pool->workers[i].thread)
+         break;
+   }
+
+   if (!i)
+      goto error;
+
+   for (; pool->num_threads > i; pool->num_threads--)
+   {
+      struct rpool_worker *w = &pool->workers[pool->num_threads - 1];
+
+      free(w->entries);
+      slock_free(w->lock);
+   }
+
+   /* Workers have to know their IDs before any task is
+    * submitted, see rpool_current_worker(). */
+   slock_lock(pool->lock);
+   while (pool->started < pool->num_threads)
+      scond_wait(pool->done_cond, pool->lock);
+   slock_unlock(pool->lock);
+
+   return pool;
+
+error:
+   rpool_destroy(pool);
+   return NULL;
+}
+
+void rpool_free(rpool_t *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   slock_lock(pool->lock);
+   pool->die = true;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   for (i = 0; i < pool->num_threads; i++)
+      sthread_join(pool->workers[i].thread);
+
+   rpool_destroy(pool);
+}
+
+unsigned rpool_num_threads(rpool_t *pool)
+{
+   return pool ? pool->num_threads : 0;
+}
+
+rpool_group_t *rpool_group_new(void)
+{
+   return (rpool_group_t*)calloc(1, sizeof(rpool_group_t));
+}
+
+void rpool_group_free(rpool_group_t *group)
+{
+   free(group);
+}
+
+void rpool_submit(rpool_t *pool, rpool_group_t *group,
+      rpool_task_t task, void *userdata)
+{
+   struct rpool_entry entry;
+   struct rpool_worker *self = NULL;
+   struct rpool_worker *w    = NULL;
+
+   if (!pool)
+   {
+      task(userdata);
+      return;
+   }
+
+   entry.task     = task;
+   entry.userdata = userdata;
+   entry.group    = group;
+
+   self = rpool_current_worker(pool);
+
+   slock_lock(pool->lock);
+   w = self ? self
+      : &pool->workers[pool->next_queue++ % pool->num_threads];
+   if (group)
+      group->pending++;
+   pool->queued++;
+   slock_unlock(pool->lock);
+
+   if (!rpool_push(w, &entry))
+   {
+      slock_lock(pool->lock);
+      pool->queued--;
+      slock_unlock(pool->lock);
+
+      task(userdata);
+      rpool_finish(pool, group);
+      return;
+   }
+
+   slock_lock(pool->lock);
+   scond_signal(pool->cond);
+   /* A waiter may be able to help with the new task. */
+   if (group && group->waiters)
+      scond_broadcast(pool->done_cond);
+   slock_unlock(pool->lock);
+}
+
+void rpool_group_wait(rpool_t *pool, rpool_group_t *group)
+{
+   struct rpool_worker *self = NULL;
+
+   if (!pool)
+      return;
+
+   self = rpool_current_worker(pool);
+
+   for (;;)
+   {
+      struct rpool_entry entry = {0};
+
+      /* Only tasks of this group are run here. Others could
+       * take much longer and leave the caller stalled. */
+      if (rpool_take(pool, self, group, &entry))
+      {
+         entry.task(entry.userdata);
+         rpool_finish(pool, entry.group);
+         continue;
+      }
+
+      slock_lock(pool->lock);
+      if (!group->pending)
+      {
+         slock_unlock(pool->lock);
+         break;
+      }
+      group->waiters++;
+      scond_wait(pool->done_cond, pool->lock);
+      group->waiters--;
+      slock_unlock(pool->lock);
+   }
+}
+
+static void rpool_future_run(void *data)
+{
+   rpool_future_t *future = (rpool_future_t*)data;
+
+   future->result = future->task(future->userdata);
+}
+
+rpool_future_t *rpool_async(rpool_t *pool,
+      rpool_future_task_t task, void *userdata)
+{
+   rpool_future_t *future = (rpool_future_t*)calloc(1, sizeof(*future));
+
+   if (!future)
+      return NULL;
+
+   future->pool     = pool;
+   future->task     = task;
+   future->userdata = userdata;
+
+   rpool_submit(pool, &future->group, rpool_future_run, future);
+   return future;
+}
+
+bool rpool_future_ready(rpool_future_t *future)
+{
+   bool ready;
+
+   /* Without a pool the task ran in rpool_async(). */
+   if (!future->pool)
+      return true;
+
+   slock_lock(future->pool->lock);
+   ready = !future->group.pending;
+   slock_unlock(future->pool->lock);
+   return ready;
+}
+
+void *rpool_future_get(rpool_future_t *future)
+{
+   void *result;
+
+   rpool_group_wait(future->pool, &future->group);
+
+   result = future->result;
+   free(future);
+   return result;
+}
+
+static void rpool_run_items(rpool_t *pool,
+      struct rpool_run_state *run, unsigned thread)
+{
+   slock_lock(pool->lock);
+   while (run->next < run->count)
+   {
+      unsigned index = run->next++;
+
+      slock_unlock(pool->lock);
+      run->work(run->userdata, index, thread);
+      slock_lock(pool->lock);
+   }
+   slock_unlock(pool->lock);
+}
+
+static void rpool_run_helper(void *data)
+{
+   struct rpool_run_state *run = (struct rpool_run_state*)data;
+   rpool_t *pool               = run->pool;
+   unsigned thread;
+
+   /* Helpers number themselves in the order they start,
+    * so thread indices stay unique within the call. */
+   slock_lock(pool->lock);
+   thread = ++run->helpers;
+   slock_unlock(pool->lock);
+
+   rpool_run_items(pool, run, thread);
+}
+
+void rpool_run(rpool_t *pool, rpool_work_t work,
+      void *userdata, unsigned count)
+{
+   unsigned i;
+   unsigned helpers;
+   rpool_group_t group;
+   struct rpool_run_state run;
+
+   if (!pool || count < 2)
+   {
+      for (i = 0; i < count; i++)
+         work(userdata, i, 0);
+      return;
+   }
+
+   memset(&group, 0, sizeof(group));
+   run.pool     = pool;
+   run.work     = work;
+   run.userdata = userdata;
+   run.next     = 0;
+   run.count    = count;
+   run.helpers  = 0;
+
+   helpers = count - 1;
+   if (helpers > pool->num_threads)
+      helpers = pool->num_threads;
+
+   for (i = 0; i < helpers; i++)
+      rpool_submit(pool, &group, rpool_run_helper, &run);
+
+   /* The calling thread is 0. */
+   rpool_run_items(pool, &run, 0);
+   rpool_group_wait(pool, &group);
+}
@@ -21,7 +21,9 @@
  */
 
 #include <rthreads/rthreads.h>
+#include <retro_atomic.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(_WIN32)
 #ifdef _XBOX
@@ -44,6 +46,24 @@
 #include <mach/mach.h>
 #endif
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_RETRO_ATOMIC) && defined(__linux__)
+#define RTHREADS_FUTEX
+#include <errno.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#elif defined(HAVE_RETRO_ATOMIC) && defined(_WIN32) && !defined(_XBOX)
+#define RTHREADS_WAIT_ON_ADDRESS
+#endif
+
+/* Checks before a waiting thread goes to sleep. A handoff
+ * between threads running on two cores takes less. */
+#define RTHREADS_SPIN_COUNT 200
+
 struct thread_data
 {
    void (*func)(void*);
@@ -137,7 +157,8 @@ sthread_t *sthread_create(void (*thread_func)(void*), void *userdata)
  * Detach a thread. When a detached thread terminates, its
  * resource sare automatically released back to the system
  * without the need for another thread to join with the 
- * terminated thread.
+ * terminated thread. @thread is freed and can't be used
+ * afterwards.
  *
  * Returns: 0 on success, otherwise it returns a non-zero error number.
  */
@@ -148,7 +169,9 @@ int sthread_detach(sthread_t *thread)
    free(thread);
    return 0;
 #else
-   return pthread_detach(thread->id);
+   int ret = pthread_detach(thread->id);
+   free(thread);
+   return ret;
 #endif
 }
 
@@ -174,6 +197,28 @@ void sthread_join(sthread_t *thread)
    free(thread);
 }
 
+/**
+ * sthread_get_current_thread_id:
+ *
+ * Returns: ID of the calling thread, or 0 where threads
+ * have no ID that fits in an integer.
+ */
+uintptr_t sthread_get_current_thread_id(void)
+{
+#if defined(_WIN32)
+   return (uintptr_t)GetCurrentThreadId();
+#elif defined(GEKKO) || defined(PSP)
+   return 0;
+#else
+   uintptr_t id   = 0;
+   pthread_t self = pthread_self();
+
+   /* pthread_t is opaque, it may not be an integer. */
+   memcpy(&id, &self, sizeof(self) < sizeof(id) ? sizeof(self) : sizeof(id));
+   return id;
+#endif
+}
+
 /**
  * slock_new:
  *
@@ -420,3 +465,400 @@ bool scond_wait_timeout(scond_t *cond, slock_t *lock, int64_t timeout_us)
    return (ret == 0);
 #endif
 }
+
+struct sevent
+{
+   /* 0 unset, 1 set, 2 unset with sleeping waiters. */
+   volatile int state;
+   unsigned spin;
+   /* Only where threads can't sleep on an address. */
+   slock_t *lock;
+   scond_t *cond;
+};
+
+struct ssem
+{
+   volatile int count;
+   volatile int waiters;
+   unsigned spin;
+   slock_t *lock;
+   scond_t *cond;
+};
+
+#ifdef RTHREADS_WAIT_ON_ADDRESS
+typedef BOOL (WINAPI *wait_on_address_t)(volatile VOID*, PVOID, SIZE_T, DWORD);
+typedef VOID (WINAPI *wake_by_address_t)(PVOID);
+
+static wait_on_address_t wait_on_address;
+static wake_by_address_t wake_by_address_single;
+static wake_by_address_t wake_by_address_all;
+
+/* WaitOnAddress() is new in Windows 8. */
+static bool rthreads_load_wait_on_address(void)
+{
+   HMODULE mod;
+   const char *name = "api-ms-win-core-synch-l1-2-0.dll";
+
+   if (wait_on_address)
+      return true;
+
+   mod = GetModuleHandleA(name);
+   if (!mod)
+      mod = LoadLibraryA(name);
+   if (!mod)
+      return false;
+
+   wake_by_address_single = (wake_by_address_t)
+      GetProcAddress(mod, "WakeByAddressSingle");
+   wake_by_address_all    = (wake_by_address_t)
+      GetProcAddress(mod, "WakeByAddressAll");
+   if (!wake_by_address_single || !wake_by_address_all)
+      return false;
+
+   /* Set last, other threads check it first. */
+   MemoryBarrier();
+   wait_on_address = (wait_on_address_t)
+      GetProcAddress(mod, "WaitOnAddress");
+   return wait_on_address != NULL;
+}
+#endif
+
+/* On a single core, the thread being waited for can't run
+ * while we spin. */
+static unsigned rthreads_default_spin_count(void)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   SYSTEM_INFO info;
+
+   GetSystemInfo(&info);
+   if (info.dwNumberOfProcessors < 2)
+      return 0;
+#elif defined(_SC_NPROCESSORS_ONLN)
+   if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+      return 0;
+#endif
+   return RTHREADS_SPIN_COUNT;
+}
+
+#ifdef HAVE_RETRO_ATOMIC
+/**
+ * rthreads_new_park_lock:
+ * @lock                    : where to store the mutex
+ * @cond                    : where to store the condition variable
+ *
+ * Creates what threads sleep on, if they can't sleep
+ * on an address.
+ *
+ * Returns: false (0) if out of memory, otherwise true (1).
+ **/
+static bool rthreads_new_park_lock(slock_t **lock, scond_t **cond)
+{
+#if defined(RTHREADS_FUTEX)
+   (void)lock;
+   (void)cond;
+   return true;
+#else
+#if defined(RTHREADS_WAIT_ON_ADDRESS)
+   if (rthreads_load_wait_on_address())
+      return true;
+#endif
+   *lock = slock_new();
+   *cond = scond_new();
+   return *lock && *cond;
+#endif
+}
+
+/**
+ * rthreads_park:
+ * @addr                    : address to sleep on
+ * @value                   : expected value at @addr
+ * @lock                    : mutex from rthreads_new_park_lock()
+ * @cond                    : condition variable from rthreads_new_park_lock()
+ * @timeout_us              : timeout (in microseconds), negative for none
+ *
+ * Sleeps until woken up by rthreads_unpark(), unless @addr
+ * no longer holds @value. May return early for no reason.
+ *
+ * Returns: false (0) if timeout elapses, otherwise true (1).
+ **/
+static bool rthreads_park(volatile int *addr, int value,
+      slock_t *lock, scond_t *cond, int64_t timeout_us)
+{
+   bool ret = true;
+
+   if (lock)
+   {
+      /* The waker changes @addr before taking the lock,
+       * so checking it with the lock held can't miss it. */
+      slock_lock(lock);
+      if (retro_atomic_load_int(addr) == value)
+      {
+         if (timeout_us < 0)
+            scond_wait(cond, lock);
+         else
+            ret = scond_wait_timeout(cond, lock, timeout_us);
+      }
+      slock_unlock(lock);
+      return ret;
+   }
+
+#if defined(RTHREADS_FUTEX)
+   {
+      struct timespec ts;
+      struct timespec *timeout = NULL;
+
+      if (timeout_us >= 0)
+      {
+         ts.tv_sec  = timeout_us / 1000000;
+         ts.tv_nsec = (timeout_us % 1000000) * 1000;
+         timeout    = &ts;
+      }
+
+      if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value,
+               timeout, NULL, 0) != 0 && errno == ETIMEDOUT)
+         ret = false;
+   }
+#elif defined(RTHREADS_WAIT_ON_ADDRESS)
+   if (!wait_on_address(addr, &value, sizeof(value),
+            timeout_us < 0 ? INFINITE : (DWORD)((timeout_us + 999) / 1000))
+         && GetLastError() == ERROR_TIMEOUT)
+      ret = false;
+#endif
+
+   return ret;
+}
+
+static void rthreads_unpark(volatile int *addr,
+      slock_t *lock, scond_t *cond, bool all)
+{
+   if (lock)
+   {
+      slock_lock(lock);
+      if (all)
+         scond_broadcast(cond);
+      else
+         scond_signal(cond);
+      slock_unlock(lock);
+      return;
+   }
+
+#if defined(RTHREADS_FUTEX)
+   syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE,
+         all ? INT_MAX : 1, NULL, NULL, 0);
+#elif defined(RTHREADS_WAIT_ON_ADDRESS)
+   if (all)
+      wake_by_address_all((PVOID)addr);
+   else
+      wake_by_address_single((PVOID)addr);
+#endif
+}
+#endif
+
+sevent_t *sevent_new(void)
+{
+   sevent_t *event = (sevent_t*)calloc(1, sizeof(*event));
+
+   if (!event)
+      return NULL;
+
+   event->spin = rthreads_default_spin_count();
+
+#ifdef HAVE_RETRO_ATOMIC
+   if (!rthreads_new_park_lock(&event->lock, &event->cond))
+#else
+   event->lock = slock_new();
+   event->cond = scond_new();
+   if (!event->lock || !event->cond)
+#endif
+   {
+      sevent_free(event);
+      return NULL;
+   }
+
+   return event;
+}
+
+void sevent_free(sevent_t *event)
+{
+   if (!event)
+      return;
+
+   slock_free(event->lock);
+   scond_free(event->cond);
+   free(event);
+}
+
+void sevent_set_spin_count(sevent_t *event, unsigned count)
+{
+   event->spin = count;
+}
+
+void sevent_signal(sevent_t *event)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   /* Everyone wakes up, as a waiter which loses the race for
+    * the event marks it again before going back to sleep. */
+   if (retro_atomic_exchange_int(&event->state, 1) == 2)
+      rthreads_unpark(&event->state, event->lock, event->cond, true);
+#else
+   slock_lock(event->lock);
+   event->state = 1;
+   scond_signal(event->cond);
+   slock_unlock(event->lock);
+#endif
+}
+
+bool sevent_wait_timeout(sevent_t *event, int64_t timeout_us)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   unsigned i;
+
+   for (i = 0; i < event->spin; i++)
+   {
+      if (retro_atomic_load_int(&event->state) == 1
+            && retro_atomic_cas_int(&event->state, 1, 0))
+         return true;
+      retro_cpu_relax();
+   }
+
+   for (;;)
+   {
+      if (retro_atomic_cas_int(&event->state, 1, 0))
+         return true;
+
+      /* Tells sevent_signal() to wake us up. */
+      if (!retro_atomic_cas_int(&event->state, 0, 2)
+            && retro_atomic_load_int(&event->state) != 2)
+         continue;
+
+      if (!rthreads_park(&event->state, 2,
+               event->lock, event->cond, timeout_us))
+         return retro_atomic_cas_int(&event->state, 1, 0);
+   }
+#else
+   bool ret;
+
+   slock_lock(event->lock);
+   while (!event->state)
+   {
+      if (timeout_us < 0)
+         scond_wait(event->cond, event->lock);
+      else if (!scond_wait_timeout(event->cond, event->lock, timeout_us))
+         break;
+   }
+   ret          = event->state != 0;
+   event->state = 0;
+   slock_unlock(event->lock);
+   return ret;
+#endif
+}
+
+void sevent_wait(sevent_t *event)
+{
+   sevent_wait_timeout(event, -1);
+}
+
+ssem_t *ssem_new(int value)
+{
+   ssem_t *sem = (ssem_t*)calloc(1, sizeof(*sem));
+
+   if (!sem)
+      return NULL;
+
+   sem->count = value;
+   sem->spin  = rthreads_default_spin_count();
+
+#ifdef HAVE_RETRO_ATOMIC
+   if (!rthreads_new_park_lock(&sem->lock, &sem->cond))
+#else
+   sem->lock = slock_new();
+   sem->cond = scond_new();
+   if (!sem->lock || !sem->cond)
+#endif
+   {
+      ssem_free(sem);
+      return NULL;
+   }
+
+   return sem;
+}
+
+void ssem_free(ssem_t *sem)
+{
+   if (!sem)
+      return;
+
+   slock_free(sem->lock);
+   scond_free(sem->cond);
+   free(sem);
+}
+
+void ssem_set_spin_count(ssem_t *sem, unsigned count)
+{
+   sem->spin = count;
+}
+
+void ssem_post(ssem_t *sem)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   retro_atomic_add_int(&sem->count, 1);
+   /* Pairs with the waiters increment in ssem_wait(),
+    * one side always sees the other. */
+   if (retro_atomic_load_int(&sem->waiters))
+      rthreads_unpark(&sem->count, sem->lock, sem->cond, false);
+#else
+   slock_lock(sem->lock);
+   sem->count++;
+   scond_signal(sem->cond);
+   slock_unlock(sem->lock);
+#endif
+}
+
+bool ssem_trywait(ssem_t *sem)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   for (;;)
+   {
+      int count = retro_atomic_load_int(&sem->count);
+
+      if (count <= 0)
+         return false;
+      if (retro_atomic_cas_int(&sem->count, count, count - 1))
+         return true;
+   }
+#else
+   bool ret;
+
+   slock_lock(sem->lock);
+   ret = sem->count > 0;
+   if (ret)
+      sem->count--;
+   slock_unlock(sem->lock);
+   return ret;
+#endif
+}
+
+void ssem_wait(ssem_t *sem)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   unsigned i;
+
+   for (i = 0; i < sem->spin; i++)
+   {
+      if (ssem_trywait(sem))
+         return;
+      retro_cpu_relax();
+   }
+
+   retro_atomic_add_int(&sem->waiters, 1);
+   while (!ssem_trywait(sem))
+      rthreads_park(&sem->count, 0, sem->lock, sem->cond, -1);
+   retro_atomic_add_int(&sem->waiters, -1);
+#else
+   slock_lock(sem->lock);
+   while (sem->count <= 0)
+      scond_wait(sem->cond, sem->lock);
+   sem->count--;
+   slock_unlock(sem->lock);
+#endif
+}
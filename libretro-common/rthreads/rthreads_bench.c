@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rthreads/rthreads.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Measures how long it takes to hand control back and forth
+ * between two threads, like the video thread wrapper does
+ * with every frame. */
+
+#define ROUND_TRIPS 100000
+
+struct bench
+{
+   slock_t *lock;
+   scond_t *cond;
+   int turn;
+
+   sevent_t *ping;
+   sevent_t *pong;
+   ssem_t *sem_ping;
+   ssem_t *sem_pong;
+};
+
+static double bench_time(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER freq, count;
+
+   QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&count);
+   return (double)count.QuadPart / freq.QuadPart;
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+static void cond_thread(void *data)
+{
+   unsigned i;
+   struct bench *b = (struct bench*)data;
+
+   slock_lock(b->lock);
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      while (b->turn != 1)
+         scond_wait(b->cond, b->lock);
+      b->turn = 0;
+      scond_signal(b->cond);
+   }
+   slock_unlock(b->lock);
+}
+
+static void cond_main(struct bench *b)
+{
+   unsigned i;
+
+   slock_lock(b->lock);
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      b->turn = 1;
+      scond_signal(b->cond);
+      while (b->turn != 0)
+         scond_wait(b->cond, b->lock);
+   }
+   slock_unlock(b->lock);
+}
+
+static void event_thread(void *data)
+{
+   unsigned i;
+   struct bench *b = (struct bench*)data;
+
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      sevent_wait(b->ping);
+      sevent_signal(b->pong);
+   }
+}
+
+static void event_main(struct bench *b)
+{
+   unsigned i;
+
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      sevent_signal(b->ping);
+      sevent_wait(b->pong);
+   }
+}
+
+static void sem_thread(void *data)
+{
+   unsigned i;
+   struct bench *b = (struct bench*)data;
+
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      ssem_wait(b->sem_ping);
+      ssem_post(b->sem_pong);
+   }
+}
+
+static void sem_main(struct bench *b)
+{
+   unsigned i;
+
+   for (i = 0; i < ROUND_TRIPS; i++)
+   {
+      ssem_post(b->sem_ping);
+      ssem_wait(b->sem_pong);
+   }
+}
+
+static void run(const char *name, struct bench *b,
+      void (*thread_func)(void*), void (*main_func)(struct bench*))
+{
+   double start;
+   sthread_t *thread = sthread_create(thread_func, b);
+
+   if (!thread)
+   {
+      printf("%-24s could not start thread\n", name);
+      return;
+   }
+
+   start = bench_time();
+   main_func(b);
+   sthread_join(thread);
+
+   printf("%-24s %8.0f ns per round trip\n", name,
+         (bench_time() - start) * 1e9 / ROUND_TRIPS);
+}
+
+int main(void)
+{
+   struct bench b = {0};
+
+   b.lock     = slock_new();
+   b.cond     = scond_new();
+   b.ping     = sevent_new();
+   b.pong     = sevent_new();
+   b.sem_ping = ssem_new(0);
+   b.sem_pong = ssem_new(0);
+
+   if (!b.lock || !b.cond || !b.ping || !b.pong
+         || !b.sem_ping || !b.sem_pong)
+   {
+      puts("ERROR - could not create primitives");
+      return 1;
+   }
+
+   run("slock/scond", &b, cond_thread, cond_main);
+   run("sevent", &b, event_thread, event_main);
+   run("ssem", &b, sem_thread, sem_main);
+
+   sevent_set_spin_count(b.ping, 0);
+   sevent_set_spin_count(b.pong, 0);
+   ssem_set_spin_count(b.sem_ping, 0);
+   ssem_set_spin_count(b.sem_pong, 0);
+
+   run("sevent (no spinning)", &b, event_thread, event_main);
+   run("ssem (no spinning)", &b, sem_thread, sem_main);
+
+   sevent_free(b.ping);
+   sevent_free(b.pong);
+   ssem_free(b.sem_ping);
+   ssem_free(b.sem_pong);
+   scond_free(b.cond);
+   slock_free(b.lock);
+   return 0;
+}
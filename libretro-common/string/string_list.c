@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <ctype.h>
 #include <string/string_list.h>
 #include <string.h>
 #include <retro_miscellaneous.h>
@@ -235,6 +236,55 @@ bool string_list_find_elem(const struct string_list *list, const char *elem)
    return false;
 }
 
+/**
+ * string_equal_len:
+ * @a                : string, not necessarily NUL-terminated.
+ * @b                : string, not necessarily NUL-terminated.
+ * @len              : number of characters to compare.
+ *
+ * Case-insensitive comparison of the first @len characters.
+ *
+ * Returns: true (1) if they are the same, otherwise false (0).
+ */
+static bool string_equal_len(const char *a, const char *b, size_t len)
+{
+   size_t i;
+
+   for (i = 0; i < len; i++)
+   {
+      if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * string_match_prefix:
+ * @str              : string to compare, not necessarily NUL-terminated.
+ * @len              : length of @str.
+ * @prefix           : optional prefix of @elem.
+ * @prefix_len       : length of @prefix.
+ * @elem             : element to compare @str with.
+ * @elem_len         : length of @elem.
+ *
+ * Checks whether @str is @elem or @elem prefixed by @prefix,
+ * ignoring case, without building the prefixed string.
+ *
+ * Returns: true (1) if it matches, otherwise false (0).
+ */
+static bool string_match_prefix(const char *str, size_t len,
+      const char *prefix, size_t prefix_len,
+      const char *elem, size_t elem_len)
+{
+   if (len == elem_len)
+      return string_equal_len(str, elem, len);
+
+   return len == prefix_len + elem_len
+      && string_equal_len(str, prefix, prefix_len)
+      && string_equal_len(str + prefix_len, elem, elem_len);
+}
+
 /**
  * string_list_find_elem_prefix:
  * @list             : pointer to string list
@@ -249,18 +299,84 @@ bool string_list_find_elem(const struct string_list *list, const char *elem)
 bool string_list_find_elem_prefix(const struct string_list *list,
       const char *prefix, const char *elem)
 {
-   size_t i;
-   char prefixed[PATH_MAX_LENGTH];
+   size_t i, prefix_len, elem_len;
 
    if (!list)
       return false;
 
-   snprintf(prefixed, sizeof(prefixed), "%s%s", prefix, elem);
+   prefix_len = strlen(prefix);
+   elem_len   = strlen(elem);
 
    for (i = 0; i < list->size; i++)
    {
-      if (strcasecmp(list->elems[i].data, elem) == 0 ||
-            strcasecmp(list->elems[i].data, prefixed) == 0)
+      const char *data = list->elems[i].data;
+
+      if (string_match_prefix(data, strlen(data),
+               prefix, prefix_len, elem, elem_len))
+         return true;
+   }
+
+   return false;
+}
+
+/**
+ * string_tokenize:
+ * @str              : pointer to the string to tokenize. Is moved
+ *                     past the returned token.
+ * @delim            : delimiter characters.
+ * @len              : set to the length of the returned token.
+ *
+ * Like strtok_r(), but leaves the string alone and doesn't
+ * allocate. Empty tokens are skipped. The token is not
+ * NUL-terminated, it ends after @len characters.
+ *
+ * Returns: start of the next token, or NULL if there is none.
+ */
+const char *string_tokenize(const char **str, const char *delim,
+      size_t *len)
+{
+   const char *tok = *str + strspn(*str, delim);
+
+   if (!*tok)
+   {
+      *str = tok;
+      return NULL;
+   }
+
+   *len = strcspn(tok, delim);
+   *str = tok + *len;
+
+   return tok;
+}
+
+/**
+ * string_find_token_prefix:
+ * @str              : delimited string, e.g. "bin|.cue|iso".
+ * @delim            : delimiter characters.
+ * @prefix           : prefix to append to @elem
+ * @elem             : element to find inside @str.
+ *
+ * Same as string_list_find_elem_prefix() on the list
+ * string_split() would make of @str, without making it.
+ *
+ * Returns: true (1) if element could be found, otherwise false (0).
+ */
+bool string_find_token_prefix(const char *str, const char *delim,
+      const char *prefix, const char *elem)
+{
+   size_t len, prefix_len, elem_len;
+   const char *tok = NULL;
+
+   if (!str)
+      return false;
+
+   prefix_len = strlen(prefix);
+   elem_len   = strlen(elem);
+
+   while ((tok = string_tokenize(&str, delim, &len)))
+   {
+      if (string_match_prefix(tok, len,
+               prefix, prefix_len, elem, elem_len))
          return true;
    }
 
@@ -1,295 +1,945 @@
+/* Converts clrmamepro DAT files to libretro databases.
+ *
+ * Games are parsed one at a time and written to the database as
+ * soon as they are complete, with the indexes built in the same
+ * pass. Only merging several DAT files on a match key has to
+ * keep the games in memory, until the last file is read.
+ */
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <fcntl.h>
-#include <errno.h>
-#include <string.h>
-#include <stdlib.h>
-#include <unistd.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
 
-#include "rarchdb.h"
-#include "db_parser.h"
+#define DAT_MAX_INDEXES 8
+#define DAT_MAX_BINARY 64
 
-#define MAX_TOKEN 256
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
 
-static char *strndup_(const char *s, size_t n)
+struct dat_lexer
 {
-	char* buff = calloc(n, sizeof(char));
+   FILE *file;
+   const char *path;
+   char buff[64 * 1024];
+   size_t pos;
+   size_t len;
+   unsigned line;
+   unsigned column;
+
+   /* Last token read, and where it started. */
+   char *tok;
+   size_t tok_len;
+   size_t tok_cap;
+   unsigned tok_line;
+   unsigned tok_column;
+};
+
+/* Fields of a game, nested ones named like "rom.crc". */
+struct dat_field
+{
+   char *key;
+   char *value;
+};
 
-	if (!buff)
-		return 0;
+struct dat_game
+{
+   struct dat_field *fields;
+   size_t count;
+   size_t cap;
+};
 
-	strncpy(buff, s, n);
-	return buff;
+/* Games merged on a match key, in the order they first appeared. */
+struct dat_merge
+{
+   const char *match_key;
+   struct dat_game *games;
+   size_t count;
+   size_t cap;
+   size_t *table;
+   size_t mask;
+};
+
+enum dat_value_type
+{
+   DAT_STRING = 0,
+   DAT_UINT,
+   DAT_HEX,
+   DAT_BINARY
+};
+
+/* Fields written to the database, and where they come from. */
+static const struct
+{
+   const char *name;
+   const char *key;
+   const char *fallback;
+   enum dat_value_type type;
+} dat_fields[] = {
+   { "name",           "name",           NULL,         DAT_STRING },
+   { "description",    "description",    NULL,         DAT_STRING },
+   { "rom_name",       "rom.name",       NULL,         DAT_STRING },
+   { "size",           "rom.size",       NULL,         DAT_UINT },
+   { "users",          "users",          NULL,         DAT_UINT },
+   { "releasemonth",   "releasemonth",   NULL,         DAT_UINT },
+   { "releaseyear",    "releaseyear",    NULL,         DAT_UINT },
+   { "rumble",         "rumble",         NULL,         DAT_UINT },
+   { "analog",         "analog",         NULL,         DAT_UINT },
+   { "famitsu_rating", "famitsu_rating", NULL,         DAT_UINT },
+   { "edge_rating",    "edge_rating",    NULL,         DAT_UINT },
+   { "edge_issue",     "edge_issue",     NULL,         DAT_UINT },
+   { "edge_review",    "edge_review",    NULL,         DAT_STRING },
+   { "enhancement_hw", "enhancement_hw", NULL,         DAT_STRING },
+   { "barcode",        "barcode",        NULL,         DAT_STRING },
+   { "esrb_rating",    "esrb_rating",    NULL,         DAT_STRING },
+   { "elspa_rating",   "elspa_rating",   NULL,         DAT_STRING },
+   { "pegi_rating",    "pegi_rating",    NULL,         DAT_STRING },
+   { "cero_rating",    "cero_rating",    NULL,         DAT_STRING },
+   { "franchise",      "franchise",      NULL,         DAT_STRING },
+   { "developer",      "developer",      NULL,         DAT_STRING },
+   { "publisher",      "publisher",      NULL,         DAT_STRING },
+   { "origin",         "origin",         NULL,         DAT_STRING },
+   { "crc",            "rom.crc",        NULL,         DAT_HEX },
+   { "md5",            "rom.md5",        NULL,         DAT_HEX },
+   { "sha1",           "rom.sha1",       NULL,         DAT_HEX },
+   { "serial",         "serial",         "rom.serial", DAT_BINARY },
+};
+
+static int dat_lexer_peek(struct dat_lexer *lex)
+{
+   if (lex->pos == lex->len)
+   {
+      lex->len = fread(lex->buff, 1, sizeof(lex->buff), lex->file);
+      lex->pos = 0;
+      if (!lex->len)
+         return EOF;
+   }
+
+   return (unsigned char)lex->buff[lex->pos];
 }
 
-static struct rmsgpack_dom_value *get_map_value(
-      const struct rmsgpack_dom_value *m, char* key)
+static void dat_lexer_skip(struct dat_lexer *lex)
 {
-   struct rmsgpack_dom_value v;
-
-   v.type = RDT_STRING;
-   v.string.len = strlen(key);
-   v.string.buff = key;
-   return rmsgpack_dom_value_map_value(m, &v);
+   if (lex->buff[lex->pos++] == '\n')
+   {
+      lex->line++;
+      lex->column = 1;
+   }
+   else
+      lex->column++;
 }
 
-static int load_string(int fd, struct rmsgpack_dom_value *out)
+static int dat_lexer_push(struct dat_lexer *lex, char c)
 {
-   char tok[MAX_TOKEN];
-   ssize_t tok_size;
+   if (lex->tok_len + 1 >= lex->tok_cap)
+   {
+      size_t cap = lex->tok_cap ? lex->tok_cap * 2 : 256;
+      char *tok  = (char*)realloc(lex->tok, cap);
 
-   if ((tok_size = get_token(fd, tok, MAX_TOKEN)) < 0)
-      return tok_size;
+      if (!tok)
+         return -ENOMEM;
+      lex->tok     = tok;
+      lex->tok_cap = cap;
+   }
 
-   out->type = RDT_STRING;
-   out->string.len = tok_size;
-   out->string.buff = strndup_(tok, tok_size);
+   lex->tok[lex->tok_len++] = c;
+   lex->tok[lex->tok_len]   = '\0';
    return 0;
 }
 
-static int load_uint(int fd, struct rmsgpack_dom_value *out)
+/**
+ * dat_lexer_next:
+ * @lex                 : Lexer to read from.
+ *
+ * Reads the next token into lex->tok. Parentheses are tokens of
+ * their own, quoted strings are read without their quotes.
+ *
+ * Returns: 1 if a token was read, 0 at the end of the file,
+ * otherwise negative.
+ **/
+static int dat_lexer_next(struct dat_lexer *lex)
 {
-	char tok[MAX_TOKEN], *c;
-	ssize_t tok_size;
-	uint64_t value = 0;
+   int c, rv;
+
+   while ((c = dat_lexer_peek(lex)) == ' ' || c == '\t' ||
+         c == '\r' || c == '\n')
+      dat_lexer_skip(lex);
+
+   if (c == EOF)
+      return 0;
+
+   lex->tok_len    = 0;
+   lex->tok_line   = lex->line;
+   lex->tok_column = lex->column;
+   dat_lexer_skip(lex);
+
+   if ((rv = dat_lexer_push(lex, c == '"' ? '\0' : c)) < 0)
+      return rv;
+
+   if (c == '(' || c == ')')
+      return 1;
+
+   if (c == '"')
+   {
+      lex->tok_len = 0;
+
+      while ((c = dat_lexer_peek(lex)) != EOF)
+      {
+         dat_lexer_skip(lex);
+         if (c == '"')
+            return 1;
+         if ((rv = dat_lexer_push(lex, c)) < 0)
+            return rv;
+      }
 
-	if ((tok_size = get_token(fd, tok, MAX_TOKEN)) < 0)
-		return tok_size;
+      fprintf(stderr, "%s:%u:%u: fatal error: Missing '\"'\n",
+            lex->path, lex->tok_line, lex->tok_column);
+      return -EINVAL;
+   }
 
-	for (c = tok; c < tok + tok_size; c++)
+   while ((c = dat_lexer_peek(lex)) != EOF && c != ' ' && c != '\t' &&
+         c != '\r' && c != '\n' && c != '(' && c != ')')
    {
-		value *= 10;
-		value += *c - '0';
-	}
+      dat_lexer_skip(lex);
+      if ((rv = dat_lexer_push(lex, c)) < 0)
+         return rv;
+   }
+
+   return 1;
+}
 
-	out->type = RDT_UINT;
-	out->uint_ = value;
-	return 0;
+static void dat_game_free(struct dat_game *game)
+{
+   size_t i;
+
+   for (i = 0; i < game->count; i++)
+   {
+      free(game->fields[i].key);
+      free(game->fields[i].value);
+   }
+   free(game->fields);
+   memset(game, 0, sizeof(*game));
 }
 
-static int load_bin(int fd, struct rmsgpack_dom_value *out)
+static const char *dat_game_get(const struct dat_game *game, const char *key)
 {
-   char tok[MAX_TOKEN];
-   ssize_t tok_size;
-   uint8_t h;
-   uint8_t l;
-   int i;
+   size_t i;
 
-   if ((tok_size = get_token(fd, tok, MAX_TOKEN)) < 0)
-      return tok_size;
+   for (i = 0; i < game->count; i++)
+      if (!strcmp(game->fields[i].key, key))
+         return game->fields[i].value;
 
-   out->type = RDT_BINARY;
-   out->binary.len = tok_size / 2;
+   return NULL;
+}
+
+/* Drops the value @key, or the table @key with everything in it. */
+static void dat_game_remove(struct dat_game *game, const char *key,
+      size_t key_len)
+{
+   size_t i, j;
 
-   for (i = 0; i < tok_size; i += 2)
+   for (i = j = 0; i < game->count; i++)
    {
-      if (tok[i] <= '9')
-         h = tok[i] - '0';
-      else
-         h = (tok[i] - 'A') + 10;
-      if (tok[i+1] <= '9')
-         l = tok[i+1] - '0';
-      else
-         l = (tok[i+1] - 'A') + 10;
-      tok[i/2] = h * 16 + l;
+      const char *k = game->fields[i].key;
+
+      if (!strncmp(k, key, key_len) &&
+            (k[key_len] == '\0' || k[key_len] == '.'))
+      {
+         free(game->fields[i].key);
+         free(game->fields[i].value);
+         continue;
+      }
+
+      game->fields[j++] = game->fields[i];
    }
 
-   out->binary.buff = malloc(out->binary.len);
-   memcpy(out->binary.buff, tok, out->binary.len);
+   game->count = j;
+}
+
+/* Takes ownership of @key and @value. */
+static int dat_game_add(struct dat_game *game, char *key, char *value)
+{
+   if (!key || !value)
+      goto error;
+
+   if (game->count == game->cap)
+   {
+      size_t cap = game->cap ? game->cap * 2 : 16;
+      struct dat_field *fields = (struct dat_field*)
+         realloc(game->fields, cap * sizeof(*fields));
+
+      if (!fields)
+         goto error;
+      game->fields = fields;
+      game->cap    = cap;
+   }
+
+   game->fields[game->count].key   = key;
+   game->fields[game->count].value = value;
+   game->count++;
    return 0;
+
+error:
+   free(key);
+   free(value);
+   return -ENOMEM;
 }
 
-static int dat_value_provider(void *ctx, struct rmsgpack_dom_value *out)
+static char *dat_join_key(const char *prefix, const char *key)
 {
-   int rv, i;
-   static const int field_count = 22;
-   int fd = *((int*)ctx);
-   char* key;
+   size_t prefix_len = prefix ? strlen(prefix) + 1 : 0;
+   size_t key_len    = strlen(key);
+   char *joined      = (char*)malloc(prefix_len + key_len + 1);
 
-   out->type = RDT_MAP;
-   out->map.len = field_count;
-   out->map.items = calloc(field_count, sizeof(struct rmsgpack_dom_pair));
+   if (!joined)
+      return NULL;
 
-   if (find_token(fd, "game") < 0)
-      return 1;
+   if (prefix_len)
+   {
+      memcpy(joined, prefix, prefix_len - 1);
+      joined[prefix_len - 1] = '.';
+   }
+   memcpy(joined + prefix_len, key, key_len + 1);
+   return joined;
+}
+
+/**
+ * dat_parse_table:
+ * @lex                 : Lexer, right past the opening parenthesis.
+ * @game                : Game to add the fields to.
+ * @prefix              : Name of the table, NULL for the game itself.
+ *
+ * Reads key/value pairs up to the closing parenthesis. Later keys
+ * replace earlier ones of the same name.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int dat_parse_table(struct dat_lexer *lex, struct dat_game *game,
+      const char *prefix)
+{
+   int rv;
+   unsigned line   = lex->tok_line;
+   unsigned column = lex->tok_column;
 
-   for (i = 0; i < field_count; i++)
+   while ((rv = dat_lexer_next(lex)) > 0)
    {
-      if ((rv = load_string(fd, &out->map.items[i].key)) < 0)
-         goto failed;
+      char *key;
 
-      key = out->map.items[i].key.string.buff;
+      if (!strcmp(lex->tok, ")"))
+         return 0;
 
-      if (strncmp(key, "name", sizeof("name")) == 0)
-      {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "description", sizeof("description")) == 0)
-      {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "users", sizeof("users")) == 0)
-      {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "releasemonth", sizeof("releasemonth")) == 0)
-      {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "releaseyear", sizeof("releaseyear")) == 0)
-      {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "rumble", sizeof("rumble")) == 0)
-      {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "analog", sizeof("analog")) == 0)
+      if (!strcmp(lex->tok, "("))
       {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         fprintf(stderr,
+               "%s:%u:%u: fatal error: Unexpected '(' instead of key\n",
+               lex->path, lex->tok_line, lex->tok_column);
+         return -EINVAL;
       }
-      else if (strncmp(key, "serial", sizeof("serial")) == 0)
-      {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "esrb_rating", sizeof("esrb_rating")) == 0)
-      {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "elspa_rating", sizeof("elspa_rating")) == 0)
+
+      if (!(key = dat_join_key(prefix, lex->tok)))
+         return -ENOMEM;
+
+      if ((rv = dat_lexer_next(lex)) <= 0)
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         free(key);
+         break;
       }
-      else if (strncmp(key, "pegi_rating", sizeof("pegi_rating")) == 0)
+
+      dat_game_remove(game, key, strlen(key));
+
+      if (!strcmp(lex->tok, "("))
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         rv = dat_parse_table(lex, game, key);
+         free(key);
+         if (rv < 0)
+            return rv;
       }
-      else if (strncmp(key, "cero_rating", sizeof("cero_rating")) == 0)
+      else if (!strcmp(lex->tok, ")"))
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         free(key);
+         fprintf(stderr,
+               "%s:%u:%u: fatal error: Unexpected ')' instead of value\n",
+               lex->path, lex->tok_line, lex->tok_column);
+         return -EINVAL;
       }
-      else if (strncmp(key, "developer", sizeof("developer")) == 0)
+      else if ((rv = dat_game_add(game, key, strdup(lex->tok))) < 0)
+         return rv;
+   }
+
+   if (rv < 0)
+      return rv;
+
+   fprintf(stderr, "%s:%u:%u: fatal error: Missing ')' for '('\n",
+         lex->path, line, column);
+   return -EINVAL;
+}
+
+/**
+ * dat_parse_game:
+ * @lex                 : Lexer to read from.
+ * @game                : Set to the next game.
+ *
+ * Skips the other top level tables, like the clrmamepro header.
+ *
+ * Returns: 1 if a game was read, 0 at the end of the file,
+ * otherwise negative.
+ **/
+static int dat_parse_game(struct dat_lexer *lex, struct dat_game *game)
+{
+   int rv;
+
+   while ((rv = dat_lexer_next(lex)) > 0)
+   {
+      int is_game = !strcmp(lex->tok, "game");
+
+      if ((rv = dat_lexer_next(lex)) <= 0)
+         break;
+
+      if (strcmp(lex->tok, "("))
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         fprintf(stderr,
+               "%s:%u:%u: fatal error: Expected '(' found '%s'\n",
+               lex->path, lex->tok_line, lex->tok_column, lex->tok);
+         return -EINVAL;
       }
-      else if (strncmp(key, "publisher", sizeof("publisher")) == 0)
+
+      rv = dat_parse_table(lex, game, NULL);
+
+      if (rv == 0 && is_game)
+         return 1;
+
+      dat_game_free(game);
+
+      if (rv < 0)
+         return rv;
+   }
+
+   return rv;
+}
+
+static int dat_hex_digit(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+   return -1;
+}
+
+static int dat_unhex(const char *hex, char *out, uint32_t *len)
+{
+   uint32_t i;
+   size_t hex_len = strlen(hex) / 2;
+
+   if (hex_len > DAT_MAX_BINARY)
+      return -EINVAL;
+
+   for (i = 0; i < hex_len; i++)
+   {
+      int h = dat_hex_digit(hex[i * 2]);
+      int l = dat_hex_digit(hex[i * 2 + 1]);
+
+      if (h < 0 || l < 0)
+         return -EINVAL;
+      out[i] = (char)(h * 16 + l);
+   }
+
+   *len = hex_len;
+   return 0;
+}
+
+/**
+ * dat_write_game:
+ * @writer              : Database to write to.
+ * @game                : Game to write.
+ *
+ * Writes the fields of dat_fields @game has. Numbers that
+ * don't parse are left out.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int dat_write_game(libretrodb_writer_t *writer,
+      const struct dat_game *game)
+{
+   unsigned i;
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_pair pairs[ARRAY_SIZE(dat_fields)];
+   char binary[ARRAY_SIZE(dat_fields)][DAT_MAX_BINARY];
+
+   item.type      = RDT_MAP;
+   item.map.len   = 0;
+   item.map.items = pairs;
+
+   for (i = 0; i < ARRAY_SIZE(dat_fields); i++)
+   {
+      char *end;
+      struct rmsgpack_dom_pair *pair = &pairs[item.map.len];
+      const char *value = dat_game_get(game, dat_fields[i].key);
+
+      if (!value && dat_fields[i].fallback)
+         value = dat_game_get(game, dat_fields[i].fallback);
+      if (!value)
+         continue;
+
+      switch (dat_fields[i].type)
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         case DAT_STRING:
+            pair->value.type        = RDT_STRING;
+            pair->value.string.len  = strlen(value);
+            pair->value.string.buff = (char*)value;
+            break;
+         case DAT_UINT:
+            errno           = 0;
+            pair->value.type  = RDT_UINT;
+            pair->value.uint_ = strtoull(value, &end, 10);
+            if (errno || end == value || *end)
+               continue;
+            break;
+         case DAT_HEX:
+            pair->value.type        = RDT_BINARY;
+            pair->value.binary.buff = binary[i];
+            if (dat_unhex(value, binary[i], &pair->value.binary.len) < 0)
+            {
+               fprintf(stderr, "Invalid %s '%s' in '%s'\n",
+                     dat_fields[i].key, value, dat_game_get(game, "name"));
+               return -EINVAL;
+            }
+            break;
+         case DAT_BINARY:
+            pair->value.type        = RDT_BINARY;
+            pair->value.binary.len  = strlen(value);
+            pair->value.binary.buff = (char*)value;
+            break;
       }
-      else if (strncmp(key, "origin", sizeof("origin")) == 0)
+
+      pair->key.type        = RDT_STRING;
+      pair->key.string.len  = strlen(dat_fields[i].name);
+      pair->key.string.buff = (char*)dat_fields[i].name;
+      item.map.len++;
+   }
+
+   return libretrodb_writer_append(writer, &item);
+}
+
+static uint32_t dat_hash(const char *str)
+{
+   uint32_t hash = 5381;
+
+   while (*str)
+      hash = (hash << 5) + hash + (unsigned char)*str++;
+
+   return hash;
+}
+
+static int dat_merge_grow(struct dat_merge *merge)
+{
+   size_t i, j, size = (merge->mask + 1) * 2;
+   size_t *table     = NULL;
+   struct dat_game *games = (struct dat_game*)realloc(merge->games,
+         merge->cap * 2 * sizeof(*games));
+
+   if (!games)
+      return -ENOMEM;
+   merge->games = games;
+   merge->cap  *= 2;
+
+   /* Keep the table at most half full. */
+   if (!(table = (size_t*)calloc(size, sizeof(*table))))
+      return -ENOMEM;
+
+   for (i = 0; i < merge->count; i++)
+   {
+      const char *mk = dat_game_get(&merge->games[i], merge->match_key);
+
+      for (j = dat_hash(mk) & (size - 1); table[j]; j = (j + 1) & (size - 1));
+      table[j] = i + 1;
+   }
+
+   free(merge->table);
+   merge->table = table;
+   merge->mask  = size - 1;
+   return 0;
+}
+
+/**
+ * dat_merge_add:
+ * @merge               : Games merged so far.
+ * @game                : Game to merge, taken over.
+ *
+ * Adds @game, or replaces the fields of the game with the same
+ * match key by those @game has. Tables are replaced as a whole.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int dat_merge_add(struct dat_merge *merge, struct dat_game *game)
+{
+   size_t i, j;
+   int rv;
+   struct dat_game *found = NULL;
+   const char *mk = dat_game_get(game, merge->match_key);
+
+   if (!mk)
+   {
+      fprintf(stderr, "missing match key '%s' in one of the entries\n",
+            merge->match_key);
+      dat_game_free(game);
+      return -EINVAL;
+   }
+
+   if (merge->count == merge->cap && (rv = dat_merge_grow(merge)) < 0)
+   {
+      dat_game_free(game);
+      return rv;
+   }
+
+   for (j = dat_hash(mk) & merge->mask; merge->table[j];
+         j = (j + 1) & merge->mask)
+   {
+      struct dat_game *other = &merge->games[merge->table[j] - 1];
+
+      if (!strcmp(dat_game_get(other, merge->match_key), mk))
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         found = other;
+         break;
       }
-      else if (strncmp(key, "rom", sizeof("rom")) == 0)
-      {
-         if (find_token(fd, "name") < 0)
-            goto failed;
+   }
 
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
-      }
-      else if (strncmp(key, "size", sizeof("size")) == 0)
+   if (!found)
+   {
+      merge->games[merge->count] = *game;
+      merge->table[j]            = ++merge->count;
+      memset(game, 0, sizeof(*game));
+      return 0;
+   }
+
+   for (i = 0; i < game->count; i++)
+      dat_game_remove(found, game->fields[i].key,
+            strcspn(game->fields[i].key, "."));
+
+   for (i = 0; i < game->count; i++)
+   {
+      if ((rv = dat_game_add(found, game->fields[i].key,
+                  game->fields[i].value)) < 0)
       {
-         if ((rv = load_uint(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         for (i++; i < game->count; i++)
+         {
+            free(game->fields[i].key);
+            free(game->fields[i].value);
+         }
+         game->count = 0;
+         dat_game_free(game);
+         return rv;
       }
-      else if (strncmp(key, "sha1", sizeof("sha1")) == 0)
+   }
+
+   game->count = 0;
+   dat_game_free(game);
+   return 0;
+}
+
+static void dat_merge_free(struct dat_merge *merge)
+{
+   size_t i;
+
+   for (i = 0; i < merge->count; i++)
+      dat_game_free(&merge->games[i]);
+   free(merge->games);
+   free(merge->table);
+}
+
+/**
+ * dat_convert:
+ * @db_path             : Database to create.
+ * @match_key           : Key to merge games on, or NULL.
+ * @dat_paths           : DAT files to read.
+ * @dat_count           : Number of DAT files.
+ * @indexes             : Fields to index.
+ * @index_count         : Number of indexes.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int dat_convert(const char *db_path, const char *match_key,
+      char **dat_paths, unsigned dat_count,
+      const char **indexes, unsigned index_count)
+{
+   unsigned i;
+   int rv = 0;
+   struct dat_lexer *lex        = NULL;
+   struct dat_game game         = {0};
+   struct dat_merge merge       = {0};
+   libretrodb_writer_t *writer  = NULL;
+   int dst = open(db_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+
+   if (dst == -1)
+   {
+      fprintf(stderr, "Could not open destination file '%s': %s\n",
+            db_path, strerror(errno));
+      return -errno;
+   }
+
+   lex    = (struct dat_lexer*)calloc(1, sizeof(*lex));
+   writer = libretrodb_writer_new(dst, indexes, indexes, index_count);
+
+   if (!lex || !writer)
+   {
+      rv = -ENOMEM;
+      goto clean;
+   }
+
+   if (match_key)
+   {
+      merge.match_key = match_key;
+      merge.cap       = 1;
+      merge.mask      = 1;
+      merge.games     = (struct dat_game*)calloc(1, sizeof(*merge.games));
+      merge.table     = (size_t*)calloc(2, sizeof(*merge.table));
+
+      if (!merge.games || !merge.table)
       {
-         if ((rv = load_bin(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         rv = -ENOMEM;
+         goto clean;
       }
-      else if (strncmp(key, "crc", sizeof("crc")) == 0)
+   }
+
+   for (i = 0; i < dat_count; i++)
+   {
+      lex->path   = dat_paths[i];
+      lex->pos    = 0;
+      lex->len    = 0;
+      lex->line   = 1;
+      lex->column = 1;
+
+      if (!(lex->file = fopen(dat_paths[i], "rb")))
       {
-         if ((rv = load_bin(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         fprintf(stderr, "could not open dat file '%s': %s\n",
+               dat_paths[i], strerror(errno));
+         rv = -errno;
+         goto clean;
       }
-      else if (strncmp(key, "md5", sizeof("md5")) == 0)
+
+      printf("Parsing dat file '%s'...\n", dat_paths[i]);
+
+      while ((rv = dat_parse_game(lex, &game)) > 0)
       {
-         if ((rv = load_bin(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         if (match_key)
+            rv = dat_merge_add(&merge, &game);
+         else
+         {
+            rv = dat_write_game(writer, &game);
+            dat_game_free(&game);
+         }
+
+         if (rv < 0)
+            break;
       }
-      else if (strncmp(key, "serial", sizeof("serial")) == 0)
+
+      fclose(lex->file);
+      lex->file = NULL;
+
+      if (rv < 0)
+         goto clean;
+   }
+
+   for (i = 0; i < merge.count; i++)
+   {
+      if ((rv = dat_write_game(writer, &merge.games[i])) < 0)
+         goto clean;
+   }
+
+   rv     = libretrodb_writer_finish(writer);
+   writer = NULL;
+
+clean:
+   dat_game_free(&game);
+   dat_merge_free(&merge);
+   libretrodb_writer_free(writer);
+   if (lex)
+      free(lex->tok);
+   free(lex);
+   close(dst);
+
+   /* Don't leave half a database behind. */
+   if (rv < 0)
+      unlink(db_path);
+   return rv;
+}
+
+/* Names the database of @dat_path in @dir, like dir/name.rdb. */
+static void dat_db_path(char *out, size_t size, const char *dir,
+      const char *dat_path)
+{
+   const char *base = strrchr(dat_path, '/');
+   const char *ext  = NULL;
+
+   base = base ? base + 1 : dat_path;
+   ext  = strrchr(base, '.');
+
+   snprintf(out, size, "%s/%.*s.rdb", dir,
+         (int)(ext ? (size_t)(ext - base) : strlen(base)), base);
+}
+
+/**
+ * dat_convert_batch:
+ * @dir                 : Directory to create the databases in.
+ * @jobs                : Conversions to run at once.
+ * @dat_paths           : DAT files to convert, one database each.
+ * @dat_count           : Number of DAT files.
+ * @indexes             : Fields to index.
+ * @index_count         : Number of indexes.
+ *
+ * Converts each DAT file in a process of its own.
+ *
+ * Returns: number of conversions which failed.
+ **/
+static unsigned dat_convert_batch(const char *dir, unsigned jobs,
+      char **dat_paths, unsigned dat_count,
+      const char **indexes, unsigned index_count)
+{
+   unsigned i;
+   unsigned failed  = 0;
+#ifndef _WIN32
+   unsigned running = 0;
+
+   for (i = 0; i < dat_count || running; )
+   {
+      int status;
+
+      if (i < dat_count && running < jobs)
       {
-         if ((rv = load_string(fd, &out->map.items[i].value)) < 0)
-            goto failed;
+         pid_t pid;
+         char db_path[4096];
+
+         dat_db_path(db_path, sizeof(db_path), dir, dat_paths[i]);
+
+         fflush(stdout);
+         pid = fork();
+
+         if (pid == 0)
+            exit(dat_convert(db_path, NULL, &dat_paths[i], 1,
+                     indexes, index_count) < 0);
+
+         if (pid < 0)
+         {
+            fprintf(stderr, "Could not start converting '%s': %s\n",
+                  dat_paths[i], strerror(errno));
+            failed++;
+         }
+         else
+            running++;
+
+         i++;
+         continue;
       }
-      else if (strncmp(key, ")", sizeof(")")) == 0)
-      {
-         rmsgpack_dom_value_free(&out->map.items[i].key);
-         out->map.len = i;
-         printf("Couldn't find all fields for item\n");
+
+      if (wait(&status) < 0)
          break;
-      }
-      else
-      {
-         rmsgpack_dom_value_free(&out->map.items[i].key);
-         i--;
-      }
+
+      running--;
+      if (!WIFEXITED(status) || WEXITSTATUS(status))
+         failed++;
    }
-   printf("Inserting '%s' (%02X%02X%02X%02X)...\n",
-         get_map_value(out, "name")->string.buff,
-         (unsigned char)get_map_value(out, "crc")->binary.buff[0],
-         (unsigned char)get_map_value(out, "crc")->binary.buff[1],
-         (unsigned char)get_map_value(out, "crc")->binary.buff[2],
-         (unsigned char)get_map_value(out, "crc")->binary.buff[3]
-         );
-   return 0;
+#else
+   (void)jobs;
 
-failed:
-   rmsgpack_dom_value_free(out);
-   out->type = RDT_NULL;
-   return rv;
+   for (i = 0; i < dat_count; i++)
+   {
+      char db_path[4096];
+
+      dat_db_path(db_path, sizeof(db_path), dir, dat_paths[i]);
+
+      if (dat_convert(db_path, NULL, &dat_paths[i], 1,
+               indexes, index_count) < 0)
+         failed++;
+   }
+#endif
+
+   return failed;
+}
+
+static void dat_usage(const char *name)
+{
+   printf("usage:\n");
+   printf("\t%s [-i <field>]... <db file> <dat file>\n", name);
+   printf("\t%s [-i <field>]... <db file> <match key> <dat file> ...\n",
+         name);
+   printf("\t%s [-i <field>]... -j <jobs> -o <directory> <dat file> ...\n",
+         name);
 }
 
 int main(int argc, char **argv)
 {
-	int rv = 0;
-	int src = -1;
-	int dst = -1;
+   int rv;
+   int i           = 1;
+   int jobs        = -1;
+   const char *dir = NULL;
+   const char *indexes[DAT_MAX_INDEXES];
+   unsigned index_count = 0;
+
+   for (; i < argc && argv[i][0] == '-'; i++)
+   {
+      if (i + 1 == argc)
+         break;
 
-	if (argc != 3)
-		printf("Usage: %s <dat file> <output file>\n", argv[0]);
+      if (!strcmp(argv[i], "-i") && index_count < DAT_MAX_INDEXES)
+         indexes[index_count++] = argv[++i];
+      else if (!strcmp(argv[i], "-j"))
+         jobs = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-o"))
+         dir = argv[++i];
+      else
+         break;
+   }
 
-	src = open(argv[1], O_RDONLY);
+   argc -= i;
+   argv += i;
 
-	if (src == -1)
+   if (dir)
    {
-		printf("Could not open source file '%s': %s\n", argv[1], strerror(errno));
-		rv = errno;
-		goto clean;
-	}
+      if (argc < 1)
+      {
+         dat_usage(argv[-i]);
+         return 1;
+      }
 
-	dst = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+      /* One job per core unless told otherwise. */
+#if !defined(_WIN32) && defined(_SC_NPROCESSORS_ONLN)
+      if (jobs <= 0)
+         jobs = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+      if (jobs <= 0)
+         jobs = 1;
+
+      return dat_convert_batch(dir, jobs, argv, argc,
+            indexes, index_count) ? 1 : 0;
+   }
 
-	if (dst == -1)
+   if (argc < 2)
    {
-		printf("Could not open destination file '%s': %s\n", argv[1], strerror(errno));
-		rv = errno;
-		goto clean;
-	}
+      dat_usage(argv[-i]);
+      return 1;
+   }
 
-	rv = rarchdb_create(dst, &dat_value_provider, &src);
+   /* As with the Lua converter, a match key comes first whenever
+    * there is more than one argument after the database. */
+   if (argc > 2)
+      rv = dat_convert(argv[0], argv[1], argv + 2, argc - 2,
+            indexes, index_count);
+   else
+      rv = dat_convert(argv[0], NULL, argv + 1, 1,
+            indexes, index_count);
 
-clean:
-	if (src != -1)
-		close(src);
-	if (dst != -1)
-		close(dst);
-	return rv;
+   return rv < 0 ? 1 : 0;
 }
@@ -16,16 +16,9 @@
 
 #include "rmsgpack_dom.h"
 #include "rmsgpack.h"
-#include "bintree.h"
 #include "libretrodb_endian.h"
 #include "query.h"
 
-struct node_iter_ctx
-{
-	libretrodb_t *db;
-	libretrodb_index_t *idx;
-};
-
 static struct rmsgpack_dom_value sentinal;
 
 static int libretrodb_read_metadata(int fd, libretrodb_metadata_t *md)
@@ -78,44 +71,29 @@ int libretrodb_create(int fd, libretrodb_value_provider value_provider,
         void * ctx)
 {
    int rv;
-   off_t root;
-   libretrodb_metadata_t md;
-   uint64_t item_count = 0;
    struct rmsgpack_dom_value item = {};
-   libretrodb_header_t header = {};
-
-   memcpy(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1);
-   root = lseek(fd, 0, SEEK_CUR);
-
-   /* We write the header in the end because we need to know the size of
-    * the db first */
+   libretrodb_writer_t *writer = libretrodb_writer_new(fd, NULL, NULL, 0);
 
-   lseek(fd, sizeof(libretrodb_header_t), SEEK_CUR);
+   if (!writer)
+      return -ENOMEM;
 
    while ((rv = value_provider(ctx, &item)) == 0)
    {
-      if ((rv = validate_document(&item)) < 0)
-         goto clean;
-
-      if ((rv = rmsgpack_dom_write(fd, &item)) < 0)
+      if ((rv = libretrodb_writer_append(writer, &item)) < 0)
          goto clean;
 
-      item_count++;
+      rmsgpack_dom_value_free(&item);
+      memset(&item, 0, sizeof(item));
    }
 
    if (rv < 0)
       goto clean;
 
-   if ((rv = rmsgpack_dom_write(fd, &sentinal)) < 0)
-      goto clean;
-
-   header.metadata_offset = httobe64(lseek(fd, 0, SEEK_CUR));
-   md.count = item_count;
-   libretrodb_write_metadata(fd, &md);
-   lseek(fd, root, SEEK_SET);
-   write(fd, &header, sizeof(header));
+   rv = libretrodb_writer_finish(writer);
+   writer = NULL;
 clean:
    rmsgpack_dom_value_free(&item);
+   libretrodb_writer_free(writer);
    return rv;
 }
 
@@ -164,7 +142,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER) - 1) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -196,9 +174,10 @@ static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
 
    while (offset < eof)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      if (libretrodb_read_index_header(db->fd, idx) < 0)
+         return -1;
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
+      if (strcmp(index_name, idx->name) == 0)
          return 0;
 
       offset = lseek(db->fd, idx->next, SEEK_CUR);
@@ -207,33 +186,74 @@ static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
    return -1;
 }
 
-static int node_compare(const void * a, const void * b, void * ctx)
+/* An index holds one entry per item, sorted by key: the key padded
+ * with zeroes to key_size bytes, followed by the item offset. */
+static int libretrodb_load_index(libretrodb_t *db, const char *index_name,
+      libretrodb_index_t *idx, uint8_t **entries)
 {
-   return memcmp(a, b, *(uint8_t *)ctx);
+   ssize_t rv;
+   uint64_t nread = 0;
+   uint8_t *buff  = NULL;
+
+   if (libretrodb_find_index(db, index_name, idx) < 0)
+      return -1;
+
+   if (!idx->key_size ||
+         idx->next != db->count * (idx->key_size + sizeof(uint64_t)))
+      return -EINVAL;
+
+   buff = (uint8_t *)malloc(idx->next ? idx->next : 1);
+
+   if (!buff)
+      return -ENOMEM;
+
+   while (nread < idx->next)
+   {
+      rv = read(db->fd, buff + nread, idx->next - nread);
+
+      if (rv <= 0)
+      {
+         free(buff);
+         return rv < 0 ? -errno : -EINVAL;
+      }
+      nread += rv;
+   }
+
+   *entries = buff;
+   return 0;
 }
 
-static int binsearch(const void * buff, const void * item,
-      uint64_t count, uint8_t field_size, uint64_t * offset)
+/* First entry whose key is not below @key, or above it if @upper.
+ * Only the first @len bytes of each key are compared. */
+static uint64_t libretrodb_index_bound(const uint8_t *entries,
+      uint64_t count, uint64_t key_size, const void *key, size_t len,
+      int upper)
 {
-   int mid            = count / 2;
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t * current = (uint64_t *)buff + (mid * item_size);
-   int rv             = node_compare(current, item, &field_size);
+   uint64_t lo        = 0;
+   uint64_t hi        = count;
+   size_t entry_size  = key_size + sizeof(uint64_t);
 
-   if (rv == 0)
+   while (lo < hi)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
-   }
+      uint64_t mid = lo + (hi - lo) / 2;
+      int cmp      = memcmp(entries + mid * entry_size, key, len);
 
-   if (count == 0)
-      return -1;
+      if (cmp < 0 || (upper && cmp == 0))
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+   return lo;
+}
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+static uint64_t libretrodb_index_offset(const uint8_t *entries,
+      uint64_t key_size, uint64_t i)
+{
+   uint64_t offset;
+   memcpy(&offset, entries + i * (key_size + sizeof(uint64_t)) + key_size,
+         sizeof(uint64_t));
+   return offset;
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
@@ -241,60 +261,163 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
 {
    libretrodb_index_t idx;
    int rv;
-   void * buff;
+   uint64_t i;
    uint64_t offset;
-   ssize_t bufflen, nread = 0;
+   uint8_t *entries = NULL;
+
+   if ((rv = libretrodb_load_index(db, index_name, &idx, &entries)) < 0)
+      return rv;
+
+   i = libretrodb_index_bound(entries, db->count, idx.key_size,
+         key, idx.key_size, 0);
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
+   if (i == db->count || memcmp(entries +
+            i * (idx.key_size + sizeof(uint64_t)), key, idx.key_size) != 0)
+   {
+      free(entries);
       return -1;
+   }
 
-   bufflen = idx.next;
-   buff = malloc(bufflen);
+   offset = libretrodb_index_offset(entries, idx.key_size, i);
+   free(entries);
 
-   if (!buff)
-      return -ENOMEM;
+   lseek(db->fd, offset, SEEK_SET);
+
+   return rmsgpack_dom_read(db->fd, out);
+}
 
-   while (nread < bufflen)
+static int offset_compare(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t *)a;
+   uint64_t y = *(const uint64_t *)b;
+   return (x > y) - (x < y);
+}
+
+/**
+ * libretrodb_cursor_use_index:
+ * @cursor              : Handle to database cursor.
+ * @field               : Field the query tests.
+ * @key                 : Value the field has to be equal to.
+ * @prefix              : @key only has to be a prefix of the field.
+ *
+ * Narrows the cursor down to the items an index on @field says can
+ * match. The query still filters every item, the index only spares
+ * reading the ones that cannot match.
+ *
+ * Returns: 0 if an index was used, otherwise negative.
+ **/
+static int libretrodb_cursor_use_index(libretrodb_cursor_t *cursor,
+      const char *field, const struct rmsgpack_dom_value *key, int prefix)
+{
+   libretrodb_index_t idx;
+   uint64_t i, first, last;
+   const char *key_buff;
+   uint32_t key_len;
+   uint8_t *padded   = NULL;
+   uint8_t *entries  = NULL;
+   libretrodb_t *db  = cursor->db;
+
+   switch (key->type)
    {
-      void * buff_ = (uint64_t *)buff + nread;
-      rv = read(db->fd, buff_, bufflen - nread);
+      case RDT_STRING:
+         key_buff = key->string.buff;
+         key_len  = key->string.len;
+         break;
+      case RDT_BINARY:
+         key_buff = key->binary.buff;
+         key_len  = key->binary.len;
+         break;
+      default:
+         return -1;
+   }
 
-      if (rv <= 0)
+   if (prefix && !key_len)
+      return -1;
+
+   if (libretrodb_load_index(db, field, &idx, &entries) < 0)
+      return -1;
+
+   first = last = 0;
+
+   if (key_len <= idx.key_size)
+   {
+      if (prefix)
       {
-         free(buff);
-         return -errno;
+         first = libretrodb_index_bound(entries, db->count, idx.key_size,
+               key_buff, key_len, 0);
+         last  = libretrodb_index_bound(entries, db->count, idx.key_size,
+               key_buff, key_len, 1);
+      }
+      else if ((padded = (uint8_t *)calloc(1, idx.key_size)))
+      {
+         memcpy(padded, key_buff, key_len);
+         first = libretrodb_index_bound(entries, db->count, idx.key_size,
+               padded, idx.key_size, 0);
+         last  = libretrodb_index_bound(entries, db->count, idx.key_size,
+               padded, idx.key_size, 1);
+         free(padded);
+      }
+      else
+      {
+         free(entries);
+         return -1;
       }
-      nread += rv;
    }
 
-   rv = binsearch(buff, key, db->count, idx.key_size, &offset);
-   free(buff);
+   cursor->index_offsets = (uint64_t *)malloc(
+         sizeof(uint64_t) * (last > first ? last - first : 1));
 
-   if (rv == 0)
-      lseek(db->fd, offset, SEEK_SET);
+   if (!cursor->index_offsets)
+   {
+      free(entries);
+      return -1;
+   }
 
-   rv = rmsgpack_dom_read(db->fd, out);
+   for (i = first; i < last; i++)
+      cursor->index_offsets[i - first] =
+         libretrodb_index_offset(entries, idx.key_size, i);
+   free(entries);
 
-   if (rv < 0)
-      return rv;
+   /* Visit matches in file order, as a full scan would. */
+   cursor->index_count = last - first;
+   qsort(cursor->index_offsets, cursor->index_count,
+         sizeof(uint64_t), offset_compare);
 
-   return rv;
+   return 0;
 }
 
 /**
  * libretrodb_cursor_reset:
  * @cursor              : Handle to database cursor.
  *
- * Resets cursor.
+ * Rewinds cursor to the first item of the database.
  *
- * Returns: ???.
+ * Returns: 0.
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
 	cursor->eof = 0;
-	return lseek(cursor->fd,
-         cursor->db->root + sizeof(libretrodb_header_t),
-         SEEK_SET);
+	cursor->index_pos = 0;
+	rmsgpack_reader_seek(&cursor->reader,
+         cursor->db->root + sizeof(libretrodb_header_t));
+	return 0;
+}
+
+/* Moves to the next item the index allows, if one narrowed the scan. */
+static int libretrodb_cursor_next(libretrodb_cursor_t *cursor)
+{
+   if (!cursor->index_offsets)
+      return 0;
+
+   if (cursor->index_pos == cursor->index_count)
+   {
+      cursor->eof = 1;
+      return EOF;
+   }
+
+   rmsgpack_reader_seek(&cursor->reader,
+         cursor->index_offsets[cursor->index_pos++]);
+   return 0;
 }
 
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
@@ -306,9 +429,65 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       return EOF;
 
 retry:
-   rv = rmsgpack_dom_read(cursor->fd, out);
+   if ((rv = libretrodb_cursor_next(cursor)) != 0)
+      return rv;
+
+   rv = rmsgpack_dom_reader_read(&cursor->reader, out);
+   if (rv < 0)
+      return rv;
+
+   if (out->type == RDT_NULL)
+   {
+      cursor->eof = 1;
+      return EOF;
+   }
+
+   if (cursor->query)
+   {
+      if (!libretrodb_query_filter(cursor->query, out))
+      {
+         rmsgpack_dom_value_free(out);
+         goto retry;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * libretrodb_cursor_read_item_arena:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Item read.
+ * @arena               : Arena the item is allocated from.
+ *
+ * Like libretrodb_cursor_read_item(), but allocates the whole item
+ * from @arena. Items rejected by the query are released right away,
+ * so @arena only grows by the items returned.
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * otherwise negative.
+ **/
+int libretrodb_cursor_read_item_arena(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out, struct rmsgpack_dom_arena *arena)
+{
+   int rv;
+   struct rmsgpack_dom_arena_mark mark;
+
+   if (cursor->eof)
+      return EOF;
+
+   rmsgpack_dom_arena_mark(arena, &mark);
+
+retry:
+   if ((rv = libretrodb_cursor_next(cursor)) != 0)
+      return rv;
+
+   rv = rmsgpack_dom_reader_read_arena(&cursor->reader, out, arena);
    if (rv < 0)
+   {
+      rmsgpack_dom_arena_rewind(arena, &mark);
       return rv;
+   }
 
    if (out->type == RDT_NULL)
    {
@@ -319,7 +498,10 @@ retry:
    if (cursor->query)
    {
       if (!libretrodb_query_filter(cursor->query, out))
+      {
+         rmsgpack_dom_arena_rewind(arena, &mark);
          goto retry;
+      }
    }
 
    return 0;
@@ -336,6 +518,9 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (!cursor)
       return;
 
+	rmsgpack_reader_free(&cursor->reader);
+	free(cursor->index_offsets);
+	cursor->index_offsets = NULL;
 	close(cursor->fd);
 	cursor->is_valid = 0;
 	cursor->fd = -1;
@@ -354,7 +539,9 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
  * @cursor              : Handle to database cursor.
  * @q                   : Query to execute.
  *
- * Opens cursor to database based on query @q.
+ * Opens cursor to database based on query @q. When @q tests a field
+ * with an index for equality or a glob() prefix, only the items the
+ * index points to are read.
  *
  * Returns: 0 if successful, otherwise negative.
  **/
@@ -366,151 +553,633 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    if (cursor->fd == -1)
       return -errno;
 
+   if (rmsgpack_reader_init(&cursor->reader, cursor->fd,
+            LIBRETRODB_CURSOR_BUFFER_SIZE) < 0)
+   {
+      close(cursor->fd);
+      cursor->fd = -1;
+      return -ENOMEM;
+   }
+
    cursor->db = db;
    cursor->is_valid = 1;
+   cursor->index_offsets = NULL;
+   cursor->index_count = 0;
    libretrodb_cursor_reset(cursor);
    cursor->query = q;
 
    if (q)
+   {
+      unsigned i;
+      int prefix;
+      const char *field;
+      struct rmsgpack_dom_value key;
+
       libretrodb_query_inc_ref(q);
 
+      for (i = 0; libretrodb_query_index_key(q, i,
+               &field, &key, &prefix) == 0; i++)
+      {
+         if (libretrodb_cursor_use_index(cursor, field, &key, prefix) == 0)
+            break;
+      }
+   }
+
    return 0;
 }
 
-static int node_iter(void * value, void * ctx)
+static struct rmsgpack_dom_value *libretrodb_index_field(
+      struct rmsgpack_dom_value *item, const struct rmsgpack_dom_value *key,
+      int *rv)
 {
-	struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
+	struct rmsgpack_dom_value *field;
 
-	if (write(nictx->db->fd, value,
-            nictx->idx->key_size + sizeof(uint64_t)) > 0)
-		return 0;
+	if (item->type != RDT_MAP)
+   {
+		*rv = -EINVAL;
+		printf("Only map keys are supported\n");
+		return NULL;
+	}
 
-	return -1;
+	field = rmsgpack_dom_value_map_value(item, key);
+
+	if (!field)
+   {
+		*rv = -EINVAL;
+		printf("field not found in item\n");
+		return NULL;
+	}
+
+	if (field->type != RDT_BINARY && field->type != RDT_STRING)
+   {
+		*rv = -EINVAL;
+		printf("field is not binary or string\n");
+		return NULL;
+	}
+
+	/* string and binary share their layout */
+	if (field->binary.len == 0)
+   {
+		*rv = -EINVAL;
+		printf("field is empty\n");
+		return NULL;
+	}
+
+	return field;
 }
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
+/* Keys of one index being built, each followed by the offset of
+ * its item. */
+struct libretrodb_index_builder
 {
-	return lseek(db->fd, 0, SEEK_CUR);
-}
+	const char *name;
+	struct rmsgpack_dom_value field_name;
+	int field_type;
+	uint64_t key_size;
+	uint8_t *records;
+	uint8_t *scratch;
+
+	/* Keys a writer gathers before the longest is known,
+	 * packed back to back. */
+	uint8_t *keys;
+	uint64_t keys_len;
+	uint64_t keys_cap;
+	uint32_t *key_lens;
+	uint64_t *offsets;
+	uint64_t cap;
+};
 
-int libretrodb_create_index(libretrodb_t *db,
+static void libretrodb_index_builder_init(struct libretrodb_index_builder *b,
       const char *name, const char *field_name)
 {
-	int rv;
-	struct node_iter_ctx nictx;
-	struct rmsgpack_dom_value key;
+	memset(b, 0, sizeof(*b));
+	b->name                   = name;
+	b->field_type             = RDT_NULL;
+	b->field_name.type        = RDT_STRING;
+	b->field_name.string.len  = strlen(field_name);
+	/* We know we aren't going to change it */
+	b->field_name.string.buff = (char *) field_name;
+}
+
+static void libretrodb_index_builder_free(struct libretrodb_index_builder *b)
+{
+	free(b->records);
+	free(b->scratch);
+	free(b->keys);
+	free(b->key_lens);
+	free(b->offsets);
+}
+
+/* Checks @field has the type of the other keys, and grows the
+ * key size to fit it. */
+static int libretrodb_index_builder_check(struct libretrodb_index_builder *b,
+      const struct rmsgpack_dom_value *field)
+{
+	if (b->field_type == RDT_NULL)
+		b->field_type = field->type;
+	else if (field->type != b->field_type)
+   {
+		printf("field is not of the same type in all items\n");
+		return -EINVAL;
+	}
+
+	if (b->field_type == RDT_BINARY && b->key_size &&
+         field->binary.len != b->key_size)
+   {
+		printf("field is not of correct size\n");
+		return -EINVAL;
+	}
+
+	if (field->binary.len > b->key_size)
+		b->key_size = field->binary.len;
+
+	return 0;
+}
+
+static int libretrodb_index_builder_alloc(struct libretrodb_index_builder *b,
+      uint64_t item_count)
+{
+	size_t size = item_count * (b->key_size + sizeof(uint64_t));
+
+	b->records = (uint8_t*)calloc(1, size ? size : 1);
+	b->scratch = (uint8_t*)malloc(size ? size : 1);
+
+	if (!b->records || !b->scratch)
+		return -ENOMEM;
+	return 0;
+}
+
+/* Stable merge sort on the key part of each record, so duplicate
+ * string keys keep their items in file order. Sorted DAT files
+ * cost no more than shuffled ones. */
+static void libretrodb_sort_records(uint8_t *records, uint8_t *scratch,
+      uint64_t count, uint64_t key_size)
+{
+	uint64_t width, i;
+	uint64_t record_size = key_size + sizeof(uint64_t);
+	uint8_t *src = records;
+	uint8_t *dst = scratch;
+
+	for (width = 1; width < count; width *= 2)
+   {
+		for (i = 0; i < count; i += 2 * width)
+      {
+			uint64_t left      = i;
+			uint64_t middle    = i + width < count ? i + width : count;
+			uint64_t right     = middle;
+			uint64_t end       = i + 2 * width < count ? i + 2 * width : count;
+			uint8_t *out       = dst + i * record_size;
+
+			while (left < middle && right < end)
+         {
+				const uint8_t *a = src + left * record_size;
+				const uint8_t *b = src + right * record_size;
+
+				if (memcmp(b, a, key_size) < 0)
+            {
+					memcpy(out, b, record_size);
+					right++;
+				}
+				else
+            {
+					memcpy(out, a, record_size);
+					left++;
+				}
+				out += record_size;
+			}
+
+			memcpy(out, src + left * record_size, (middle - left) * record_size);
+			out += (middle - left) * record_size;
+			memcpy(out, src + right * record_size, (end - right) * record_size);
+		}
+
+		{
+			uint8_t *tmp = src;
+			src          = dst;
+			dst          = tmp;
+		}
+	}
+
+	if (src != records)
+		memcpy(records, src, count * record_size);
+}
+
+/* Sorts the records, and checks binary keys (hashes) are unique. */
+static int libretrodb_index_builder_sort(struct libretrodb_index_builder *b,
+      uint64_t item_count)
+{
+	uint64_t j;
+	uint64_t record_size = b->key_size + sizeof(uint64_t);
+
+	libretrodb_sort_records(b->records, b->scratch, item_count, b->key_size);
+
+	if (b->field_type != RDT_BINARY)
+		return 0;
+
+	for (j = 1; j < item_count; j++)
+   {
+		const uint8_t *key = b->records + j * record_size;
+
+		if (memcmp(key - record_size, key, b->key_size) == 0)
+      {
+			uint64_t k;
+
+			printf("Value is not unique in %s: ", b->name);
+			for (k = 0; k < b->key_size; k++)
+				printf("%02X", key[k]);
+			printf("\n");
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int libretrodb_index_builder_write(int fd,
+      struct libretrodb_index_builder *b, uint64_t item_count)
+{
 	libretrodb_index_t idx;
+	size_t size = item_count * (b->key_size + sizeof(uint64_t));
+
+	lseek(fd, 0, SEEK_END);
+	strncpy(idx.name, b->name, 50);
+
+	idx.name[49] = '\0';
+	idx.key_size = b->key_size;
+	idx.next     = size;
+	libretrodb_write_index_header(fd, &idx);
+
+	if (write(fd, b->records, size) != (ssize_t)size)
+		return -errno;
+	return 0;
+}
+
+/**
+ * libretrodb_create_indexes:
+ * @db                  : Handle to database.
+ * @names               : Names of the indexes.
+ * @field_names         : Field to index for each name.
+ * @count               : Number of indexes.
+ *
+ * Appends indexes on binary or string fields to the database,
+ * reading it only twice however many there are. Keys are sorted
+ * in bulk rather than inserted one by one.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_create_indexes(libretrodb_t *db, const char **names,
+      const char **field_names, unsigned count)
+{
+	int rv = 0;
+	unsigned i;
+	uint64_t j;
+	uint64_t item_count = 0;
+	uint64_t item_loc;
 	struct rmsgpack_dom_value item;
 	struct rmsgpack_dom_value * field;
-	struct bintree tree;
+	struct rmsgpack_dom_arena arena;
 	libretrodb_cursor_t cur;
-	uint64_t idx_header_offset;
-	void * buff = NULL;
-	uint64_t * buff_u64 = NULL;
-	uint8_t field_size = 0;
-	uint64_t item_loc = libretrodb_tell(db);
+	struct libretrodb_index_builder *builders = NULL;
 
-	bintree_new(&tree, node_compare, &field_size);
+	rmsgpack_dom_arena_init(&arena, LIBRETRODB_ARENA_BLOCK_SIZE);
+	cur.is_valid = 0;
 
-	if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+	builders = (struct libretrodb_index_builder*)
+		calloc(count ? count : 1, sizeof(*builders));
+	if (!builders)
    {
-		rv = -1;
+		rv = -ENOMEM;
 		goto clean;
 	}
 
-	key.type = RDT_STRING;
-	key.string.len = strlen(field_name);
+	for (i = 0; i < count; i++)
+		libretrodb_index_builder_init(&builders[i], names[i], field_names[i]);
 
-	/* We know we aren't going to change it */
-	key.string.buff = (char *) field_name;
+	if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+   {
+		rv = -1;
+		goto clean;
+	}
 
-	while (libretrodb_cursor_read_item(&cur, &item) == 0)
+	/* Strings are padded to the longest one, so size the keys first. */
+	while (libretrodb_cursor_read_item_arena(&cur, &item, &arena) == 0)
    {
-		if (item.type != RDT_MAP)
+		for (i = 0; i < count; i++)
       {
-			rv = -EINVAL;
-			printf("Only map keys are supported\n");
-			goto clean;
-		}
+			struct libretrodb_index_builder *b = &builders[i];
 
-		field = rmsgpack_dom_value_map_value(&item, &key);
+			if (!(field = libretrodb_index_field(&item, &b->field_name, &rv)))
+				goto clean;
 
-		if (!field)
-      {
-			rv = -EINVAL;
-			printf("field not found in item\n");
-			goto clean;
+			if ((rv = libretrodb_index_builder_check(b, field)) < 0)
+				goto clean;
 		}
 
-		if (field->type != RDT_BINARY)
-      {
-			rv = -EINVAL;
-			printf("field is not binary\n");
+		item_count++;
+		rmsgpack_dom_arena_reset(&arena);
+	}
+
+	for (i = 0; i < count; i++)
+   {
+		if ((rv = libretrodb_index_builder_alloc(&builders[i], item_count)) < 0)
 			goto clean;
-		}
+	}
+
+	libretrodb_cursor_reset(&cur);
+
+	/* The cursor reads ahead of the items it returns, so take item
+	 * offsets from its reader rather than from the descriptor. */
+	item_loc = rmsgpack_reader_tell(&cur.reader);
 
-		if (field->binary.len == 0)
+	for (j = 0; j < item_count &&
+         libretrodb_cursor_read_item_arena(&cur, &item, &arena) == 0; j++)
+   {
+		for (i = 0; i < count; i++)
       {
-			rv = -EINVAL;
-			printf("field is empty\n");
-			goto clean;
+			struct libretrodb_index_builder *b = &builders[i];
+			uint8_t *record = b->records + j * (b->key_size + sizeof(uint64_t));
+
+			if (!(field = libretrodb_index_field(&item, &b->field_name, &rv)))
+				goto clean;
+
+			memcpy(record, field->binary.buff, field->binary.len);
+			memcpy(record + b->key_size, &item_loc, sizeof(uint64_t));
 		}
 
-		if (field_size == 0)
-			field_size = field->binary.len;
-		else if (field->binary.len != field_size)
-      {
-			rv = -EINVAL;
-			printf("field is not of correct size\n");
+		rmsgpack_dom_arena_reset(&arena);
+		item_loc = rmsgpack_reader_tell(&cur.reader);
+	}
+
+	if (j != item_count)
+   {
+		rv = -EINVAL;
+		printf("database changed while indexing\n");
+		goto clean;
+	}
+
+	/* Check every index before writing any of them. */
+	for (i = 0; i < count; i++)
+   {
+		if ((rv = libretrodb_index_builder_sort(&builders[i], item_count)) < 0)
 			goto clean;
-		}
+	}
 
-		buff = malloc(field_size + sizeof(uint64_t));
-		if (!buff)
-      {
-			rv = -ENOMEM;
+	for (i = 0; i < count; i++)
+   {
+		if ((rv = libretrodb_index_builder_write(db->fd, &builders[i],
+                  item_count)) < 0)
 			goto clean;
-		}
+	}
 
-		memcpy(buff, field->binary.buff, field_size);
+clean:
+	if (builders)
+   {
+		for (i = 0; i < count; i++)
+			libretrodb_index_builder_free(&builders[i]);
+		free(builders);
+	}
+	rmsgpack_dom_arena_free(&arena);
+	if (cur.is_valid)
+		libretrodb_cursor_close(&cur);
+	return rv;
+}
 
-		buff_u64 = (uint64_t *)buff + field_size;
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the index.
+ * @field_name          : Field to index.
+ *
+ * Appends an index on a binary or string field to the database.
+ * Queries only use indexes named after the field they test.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_create_index(libretrodb_t *db,
+      const char *name, const char *field_name)
+{
+	return libretrodb_create_indexes(db, &name, &field_name, 1);
+}
 
-		memcpy(buff_u64, &item_loc, sizeof(uint64_t));
+struct libretrodb_writer
+{
+	int fd;
+	off_t root;
+	uint64_t count;
+	unsigned index_count;
+	struct libretrodb_index_builder *builders;
+};
 
-		if (bintree_insert(&tree, buff) != 0)
-      {
-			printf("Value is not unique: ");
-			rmsgpack_dom_value_print(field);
-			printf("\n");
-			rv = -EINVAL;
+/**
+ * libretrodb_writer_new:
+ * @fd                  : Descriptor to write the database to.
+ * @names               : Names of the indexes.
+ * @field_names         : Field to index for each name.
+ * @count               : Number of indexes.
+ *
+ * Starts writing a database at the current offset of @fd.
+ * The indexes are gathered while items are appended, and
+ * written along with the database, without reading it again.
+ *
+ * Returns: handle to the writer, or NULL if out of memory.
+ **/
+libretrodb_writer_t *libretrodb_writer_new(int fd, const char **names,
+      const char **field_names, unsigned count)
+{
+	unsigned i;
+	libretrodb_writer_t *writer = (libretrodb_writer_t*)
+		calloc(1, sizeof(*writer));
+
+	if (!writer)
+		return NULL;
+
+	writer->builders = (struct libretrodb_index_builder*)
+		calloc(count ? count : 1, sizeof(*writer->builders));
+	if (!writer->builders)
+   {
+		free(writer);
+		return NULL;
+	}
+
+	for (i = 0; i < count; i++)
+		libretrodb_index_builder_init(&writer->builders[i],
+            names[i], field_names[i]);
+
+	writer->fd          = fd;
+	writer->index_count = count;
+	writer->root        = lseek(fd, 0, SEEK_CUR);
+
+	/* We write the header in the end because we need to know the
+	 * size of the db first */
+	lseek(fd, sizeof(libretrodb_header_t), SEEK_CUR);
+
+	return writer;
+}
+
+static int libretrodb_writer_add_key(struct libretrodb_index_builder *b,
+      const struct rmsgpack_dom_value *field, uint64_t offset, uint64_t index)
+{
+	if (index == b->cap)
+   {
+		uint64_t cap      = b->cap ? b->cap * 2 : 256;
+		uint32_t *lens    = (uint32_t*)realloc(b->key_lens,
+            cap * sizeof(*lens));
+		uint64_t *offsets;
+
+		if (!lens)
+			return -ENOMEM;
+		b->key_lens = lens;
+
+		offsets = (uint64_t*)realloc(b->offsets, cap * sizeof(*offsets));
+		if (!offsets)
+			return -ENOMEM;
+		b->offsets = offsets;
+		b->cap     = cap;
+	}
+
+	if (b->keys_len + field->binary.len > b->keys_cap)
+   {
+		uint64_t cap  = b->keys_cap ? b->keys_cap : 4096;
+		uint8_t *keys = NULL;
+
+		while (cap < b->keys_len + field->binary.len)
+			cap *= 2;
+
+		if (!(keys = (uint8_t*)realloc(b->keys, cap)))
+			return -ENOMEM;
+		b->keys     = keys;
+		b->keys_cap = cap;
+	}
+
+	memcpy(b->keys + b->keys_len, field->binary.buff, field->binary.len);
+	b->keys_len       += field->binary.len;
+	b->key_lens[index] = field->binary.len;
+	b->offsets[index]  = offset;
+	return 0;
+}
+
+/**
+ * libretrodb_writer_append:
+ * @writer              : Handle to the writer.
+ * @item                : Item to write.
+ *
+ * Writes @item right away. The writer keeps no reference to it.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_writer_append(libretrodb_writer_t *writer,
+      const struct rmsgpack_dom_value *item)
+{
+	int rv;
+	unsigned i;
+	uint64_t offset;
+
+	if ((rv = validate_document(item)) < 0)
+		return rv;
+
+	offset = lseek(writer->fd, 0, SEEK_CUR);
+
+	for (i = 0; i < writer->index_count; i++)
+   {
+		struct libretrodb_index_builder *b = &writer->builders[i];
+		struct rmsgpack_dom_value *field   = libretrodb_index_field(
+            (struct rmsgpack_dom_value*)item, &b->field_name, &rv);
+
+		if (!field)
+			return rv;
+
+		if ((rv = libretrodb_index_builder_check(b, field)) < 0)
+			return rv;
+
+		if ((rv = libretrodb_writer_add_key(b, field, offset,
+                  writer->count)) < 0)
+			return rv;
+	}
+
+	if ((rv = rmsgpack_dom_write(writer->fd, item)) < 0)
+		return rv;
+
+	writer->count++;
+	return 0;
+}
+
+/**
+ * libretrodb_writer_finish:
+ * @writer              : Handle to the writer, freed by this.
+ *
+ * Ends the items, then writes the header and the indexes.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_writer_finish(libretrodb_writer_t *writer)
+{
+	int rv;
+	unsigned i;
+	uint64_t j;
+	libretrodb_metadata_t md;
+	libretrodb_header_t header = {};
+
+	if ((rv = rmsgpack_dom_write(writer->fd, &sentinal)) < 0)
+		goto clean;
+
+	memcpy(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1);
+	header.metadata_offset = httobe64(lseek(writer->fd, 0, SEEK_CUR));
+	md.count = writer->count;
+	libretrodb_write_metadata(writer->fd, &md);
+	lseek(writer->fd, writer->root, SEEK_SET);
+	write(writer->fd, &header, sizeof(header));
+
+	/* Pad the keys gathered to the longest, as
+	 * libretrodb_create_indexes() would have. */
+	for (i = 0; i < writer->index_count; i++)
+   {
+		struct libretrodb_index_builder *b = &writer->builders[i];
+		uint64_t record_size = b->key_size + sizeof(uint64_t);
+		const uint8_t *key   = b->keys;
+
+		if ((rv = libretrodb_index_builder_alloc(b, writer->count)) < 0)
 			goto clean;
+
+		for (j = 0; j < writer->count; j++)
+      {
+			uint8_t *record = b->records + j * record_size;
+
+			memcpy(record, key, b->key_lens[j]);
+			memcpy(record + b->key_size, &b->offsets[j], sizeof(uint64_t));
+			key += b->key_lens[j];
 		}
-		buff = NULL;
-		rmsgpack_dom_value_free(&item);
-		item_loc = libretrodb_tell(db);
-	}
 
-	(void)rv;
-	(void)idx_header_offset;
+		if ((rv = libretrodb_index_builder_sort(b, writer->count)) < 0)
+			goto clean;
+	}
 
-	idx_header_offset = lseek(db->fd, 0, SEEK_END);
-	strncpy(idx.name, name, 50);
+	for (i = 0; i < writer->index_count; i++)
+   {
+		if ((rv = libretrodb_index_builder_write(writer->fd,
+                  &writer->builders[i], writer->count)) < 0)
+			goto clean;
+	}
 
-	idx.name[49] = '\0';
-	idx.key_size = field_size;
-	idx.next = db->count * (field_size + sizeof(uint64_t));
-	libretrodb_write_index_header(db->fd, &idx);
-
-	nictx.db = db;
-	nictx.idx = &idx;
-	bintree_iterate(&tree, node_iter, &nictx);
-	bintree_free(&tree);
 clean:
-	rmsgpack_dom_value_free(&item);
-	if (buff)
-		free(buff);
-	if (cur.is_valid)
-		libretrodb_cursor_close(&cur);
-	return 0;
+	libretrodb_writer_free(writer);
+	return rv;
+}
+
+/**
+ * libretrodb_writer_free:
+ * @writer              : Handle to the writer.
+ *
+ * Drops a writer without finishing the database.
+ **/
+void libretrodb_writer_free(libretrodb_writer_t *writer)
+{
+	unsigned i;
+
+	if (!writer)
+		return;
+
+	for (i = 0; i < writer->index_count; i++)
+		libretrodb_index_builder_free(&writer->builders[i]);
+	free(writer->builders);
+	free(writer);
 }
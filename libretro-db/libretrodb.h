@@ -11,6 +11,12 @@
 
 #define MAGIC_NUMBER "RARCHDB"
 
+/* Cursors read the database in chunks of this size. */
+#define LIBRETRODB_CURSOR_BUFFER_SIZE (64 * 1024)
+
+/* Arena block size that holds a typical database item. */
+#define LIBRETRODB_ARENA_BLOCK_SIZE (4 * 1024)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,6 +55,11 @@ typedef struct libretrodb_cursor
 	int is_valid;
 	int fd;
 	int eof;
+	struct rmsgpack_reader reader;
+	/* Offsets of the items an index narrowed the query to. */
+	uint64_t * index_offsets;
+	uint64_t index_count;
+	uint64_t index_pos;
 	libretrodb_query_t * query;
 	libretrodb_t * db;
 } libretrodb_cursor_t;
@@ -59,13 +70,86 @@ typedef int (* libretrodb_value_provider)(void * ctx,
 int libretrodb_create(int fd, libretrodb_value_provider value_provider,
       void * ctx);
 
+typedef struct libretrodb_writer libretrodb_writer_t;
+
+/**
+ * libretrodb_writer_new:
+ * @fd                  : Descriptor to write the database to.
+ * @names               : Names of the indexes.
+ * @field_names         : Field to index for each name.
+ * @count               : Number of indexes.
+ *
+ * Starts writing a database at the current offset of @fd, for
+ * items to be appended one at a time. The indexes are built
+ * in the same pass, so the database is never read back.
+ *
+ * Returns: handle to the writer, or NULL if out of memory.
+ **/
+libretrodb_writer_t *libretrodb_writer_new(int fd, const char **names,
+      const char **field_names, unsigned count);
+
+/**
+ * libretrodb_writer_append:
+ * @writer              : Handle to the writer.
+ * @item                : Item to write.
+ *
+ * Writes @item right away. The writer keeps no reference to it.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_writer_append(libretrodb_writer_t *writer,
+      const struct rmsgpack_dom_value *item);
+
+/**
+ * libretrodb_writer_finish:
+ * @writer              : Handle to the writer, freed by this.
+ *
+ * Ends the items, then writes the header and the indexes.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_writer_finish(libretrodb_writer_t *writer);
+
+/**
+ * libretrodb_writer_free:
+ * @writer              : Handle to the writer.
+ *
+ * Drops a writer without finishing the database.
+ **/
+void libretrodb_writer_free(libretrodb_writer_t *writer);
+
 void libretrodb_close(libretrodb_t * db);
 
 int libretrodb_open(const char * path, libretrodb_t * db);
 
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the index.
+ * @field_name          : Field to index.
+ *
+ * Appends an index on a binary or string field to the database.
+ * Queries only use indexes named after the field they test.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
 int libretrodb_create_index(libretrodb_t * db, const char *name,
       const char *field_name);
 
+/**
+ * libretrodb_create_indexes:
+ * @db                  : Handle to database.
+ * @names               : Names of the indexes.
+ * @field_names         : Field to index for each name.
+ * @count               : Number of indexes.
+ *
+ * Appends several indexes while reading the database only twice.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_create_indexes(libretrodb_t * db, const char **names,
+      const char **field_names, unsigned count);
+
 int libretrodb_find_entry(
         libretrodb_t * db,
         const char * index_name,
@@ -93,9 +177,9 @@ int libretrodb_cursor_open(
  * libretrodb_cursor_reset:
  * @cursor              : Handle to database cursor.
  *
- * Resets cursor.
+ * Rewinds cursor to the first item of the database.
  *
- * Returns: ???.
+ * Returns: 0.
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t * cursor);
 
@@ -119,6 +203,21 @@ void libretrodb_query_free(void *q);
 int libretrodb_cursor_read_item(libretrodb_cursor_t * cursor,
       struct rmsgpack_dom_value * out);
 
+/**
+ * libretrodb_cursor_read_item_arena:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Item read.
+ * @arena               : Arena the item is allocated from.
+ *
+ * Reads the next item matching the cursor query into @arena.
+ * The item is released with the arena, not rmsgpack_dom_value_free().
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * otherwise negative.
+ **/
+int libretrodb_cursor_read_item_arena(libretrodb_cursor_t * cursor,
+      struct rmsgpack_dom_value * out, struct rmsgpack_dom_arena * arena);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+#define BENCH_RUNS 3
+#define BENCH_OPENS 20
+#define BENCH_FINDS 10000
+
+static const char *bench_queries[] = {
+   "{name:'Game 0000042'}",
+   "{name:glob('Game 00001*')}",
+   "{crc:b\"DEADBEEF\"}",
+   "{year:1995}",
+   "{users:between(2,3), rumble:true}",
+   "{serial:glob('*123*')}",
+   "or({year:1990},{users:4})",
+};
+
+struct bench_provider
+{
+   uint32_t count;
+   uint32_t n;
+};
+
+static double bench_now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static uint32_t bench_crc(uint32_t n)
+{
+   return n * 2654435761u ^ 0x5bd1e995;
+}
+
+static void bench_set_key(struct rmsgpack_dom_pair *pair, const char *key)
+{
+   pair->key.type        = RDT_STRING;
+   pair->key.string.len  = strlen(key);
+   pair->key.string.buff = strdup(key);
+}
+
+static void bench_set_string(struct rmsgpack_dom_pair *pair,
+      const char *key, const char *value)
+{
+   bench_set_key(pair, key);
+   pair->value.type        = RDT_STRING;
+   pair->value.string.len  = strlen(value);
+   pair->value.string.buff = strdup(value);
+}
+
+static void bench_set_uint(struct rmsgpack_dom_pair *pair,
+      const char *key, uint64_t value)
+{
+   bench_set_key(pair, key);
+   pair->value.type  = RDT_UINT;
+   pair->value.uint_ = value;
+}
+
+static int bench_provide(void *ctx, struct rmsgpack_dom_value *out)
+{
+   char buff[64];
+   uint32_t crc;
+   uint8_t *crc_buff;
+   struct rmsgpack_dom_pair *items;
+   struct bench_provider *provider = (struct bench_provider*)ctx;
+
+   if (provider->n >= provider->count)
+      return 1;
+
+   /* libretrodb_create() hands us a zeroed item, and frees
+    * what we fill in once it has been written. */
+   items = (struct rmsgpack_dom_pair*)calloc(6, sizeof(*items));
+   if (!items)
+      return -1;
+
+   out->type      = RDT_MAP;
+   out->map.len   = 6;
+   out->map.items = items;
+
+   snprintf(buff, sizeof(buff), "Game %07u", provider->n);
+   bench_set_string(&items[0], "name", buff);
+
+   crc      = bench_crc(provider->n);
+   crc_buff = (uint8_t*)malloc(4);
+   crc_buff[0] = crc >> 24;
+   crc_buff[1] = crc >> 16;
+   crc_buff[2] = crc >> 8;
+   crc_buff[3] = crc;
+   bench_set_key(&items[1], "crc");
+   items[1].value.type        = RDT_BINARY;
+   items[1].value.binary.len  = 4;
+   items[1].value.binary.buff = (char*)crc_buff;
+
+   snprintf(buff, sizeof(buff), "SLUS-%05u", provider->n % 100000);
+   bench_set_string(&items[2], "serial", buff);
+
+   bench_set_uint(&items[3], "year", 1980 + provider->n % 30);
+   bench_set_uint(&items[4], "users", 1 + provider->n % 4);
+
+   bench_set_key(&items[5], "rumble");
+   items[5].value.type  = RDT_BOOL;
+   items[5].value.bool_ = provider->n % 3 == 0;
+
+   provider->n++;
+   return 0;
+}
+
+static int bench_generate(const char *path, uint32_t count)
+{
+   int rv;
+   double start;
+   libretrodb_t db;
+   struct bench_provider provider;
+   const char *names[]  = { "name", "crc" };
+   int fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+
+   if (fd < 0)
+   {
+      printf("Could not create '%s'\n", path);
+      return -1;
+   }
+
+   provider.count = count;
+   provider.n     = 0;
+
+   start = bench_now();
+   rv    = libretrodb_create(fd, bench_provide, &provider);
+   close(fd);
+
+   if (rv < 0)
+   {
+      printf("Could not write '%s': %s\n", path, strerror(-rv));
+      return rv;
+   }
+
+   printf("  create         %10.3f ms\n", (bench_now() - start) * 1000.0);
+
+   if ((rv = libretrodb_open(path, &db)) < 0)
+      return rv;
+
+   start = bench_now();
+   rv    = libretrodb_create_indexes(&db, names, names, 2);
+   libretrodb_close(&db);
+
+   if (rv < 0)
+   {
+      printf("Could not index '%s': %s\n", path, strerror(-rv));
+      return rv;
+   }
+
+   printf("  create-index   %10.3f ms\n", (bench_now() - start) * 1000.0);
+   return 0;
+}
+
+static int bench_open(const char *path)
+{
+   unsigned i;
+   libretrodb_t db;
+   double start = bench_now();
+
+   for (i = 0; i < BENCH_OPENS; i++)
+   {
+      if (libretrodb_open(path, &db) < 0)
+         return -1;
+      libretrodb_close(&db);
+   }
+
+   printf("  open           %10.3f ms\n",
+         (bench_now() - start) * 1000.0 / BENCH_OPENS);
+   return 0;
+}
+
+/* Best of BENCH_RUNS full passes, with and without an arena. */
+static int bench_scan(libretrodb_t *db, uint32_t count)
+{
+   unsigned run, arena;
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_arena dom_arena;
+   libretrodb_cursor_t cur;
+
+   rmsgpack_dom_arena_init(&dom_arena, LIBRETRODB_ARENA_BLOCK_SIZE);
+
+   for (arena = 0; arena < 2; arena++)
+   {
+      double best = 0.0;
+
+      for (run = 0; run < BENCH_RUNS; run++)
+      {
+         uint32_t items = 0;
+         double start   = bench_now();
+         double elapsed;
+
+         if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+            return -1;
+
+         if (arena)
+         {
+            while (libretrodb_cursor_read_item_arena(&cur,
+                     &item, &dom_arena) == 0)
+            {
+               rmsgpack_dom_arena_reset(&dom_arena);
+               items++;
+            }
+         }
+         else
+         {
+            while (libretrodb_cursor_read_item(&cur, &item) == 0)
+            {
+               rmsgpack_dom_value_free(&item);
+               items++;
+            }
+         }
+
+         libretrodb_cursor_close(&cur);
+         elapsed = bench_now() - start;
+
+         if (items != count)
+         {
+            printf("Cursor read %u of %u items\n", items, count);
+            return -1;
+         }
+
+         if (run == 0 || elapsed < best)
+            best = elapsed;
+      }
+
+      printf("  %-14s %10.3f ms  %8.0f items/ms\n",
+            arena ? "scan (arena)" : "scan",
+            best * 1000.0, count / (best * 1000.0));
+   }
+
+   rmsgpack_dom_arena_free(&dom_arena);
+   return 0;
+}
+
+static int bench_find(libretrodb_t *db, uint32_t count)
+{
+   unsigned i;
+   uint8_t key[4];
+   struct rmsgpack_dom_value item;
+   double start = bench_now();
+
+   for (i = 0; i < BENCH_FINDS; i++)
+   {
+      uint32_t crc = bench_crc(i * 7919u % count);
+
+      key[0] = crc >> 24;
+      key[1] = crc >> 16;
+      key[2] = crc >> 8;
+      key[3] = crc;
+
+      if (libretrodb_find_entry(db, "crc", key, &item) < 0)
+      {
+         printf("Could not find crc %08x\n", crc);
+         return -1;
+      }
+      rmsgpack_dom_value_free(&item);
+   }
+
+   printf("  find           %10.3f us\n",
+         (bench_now() - start) * 1000000.0 / BENCH_FINDS);
+   return 0;
+}
+
+static int bench_query(libretrodb_t *db)
+{
+   unsigned i, run;
+
+   for (i = 0; i < sizeof(bench_queries) / sizeof(bench_queries[0]); i++)
+   {
+      double compile;
+      double best       = 0.0;
+      uint32_t matches  = 0;
+      const char *error = NULL;
+      const char *exp   = bench_queries[i];
+      double start      = bench_now();
+      libretrodb_query_t *q = (libretrodb_query_t*)
+         libretrodb_query_compile(db, exp, strlen(exp), &error);
+
+      compile = bench_now() - start;
+
+      if (error)
+      {
+         printf("Could not compile %s: %s\n", exp, error);
+         return -1;
+      }
+
+      for (run = 0; run < BENCH_RUNS; run++)
+      {
+         double elapsed;
+         libretrodb_cursor_t cur;
+         struct rmsgpack_dom_value item;
+
+         start   = bench_now();
+         matches = 0;
+
+         if (libretrodb_cursor_open(db, &cur, q) != 0)
+         {
+            libretrodb_query_free(q);
+            return -1;
+         }
+
+         while (libretrodb_cursor_read_item(&cur, &item) == 0)
+         {
+            rmsgpack_dom_value_free(&item);
+            matches++;
+         }
+
+         libretrodb_cursor_close(&cur);
+         elapsed = bench_now() - start;
+
+         if (run == 0 || elapsed < best)
+            best = elapsed;
+      }
+
+      libretrodb_query_free(q);
+      printf("  query          %10.3f ms  %8u hits  %6.1f us compile  %s\n",
+            best * 1000.0, matches, compile * 1000000.0, exp);
+   }
+
+   return 0;
+}
+
+static int bench_run(const char *dir, uint32_t count)
+{
+   int rv;
+   char path[1024];
+   libretrodb_t db;
+
+   snprintf(path, sizeof(path), "%s/bench_%u.rdb", dir, count);
+   printf("%u records (%s):\n", count, path);
+
+   if (bench_generate(path, count) < 0 || bench_open(path) < 0)
+      return -1;
+
+   if ((rv = libretrodb_open(path, &db)) < 0)
+   {
+      printf("Could not open db file '%s': %s\n", path, strerror(-rv));
+      return -1;
+   }
+
+   rv = 0;
+   if (bench_scan(&db, count) < 0 || bench_find(&db, count) < 0
+         || bench_query(&db) < 0)
+      rv = -1;
+
+   libretrodb_close(&db);
+   unlink(path);
+   return rv;
+}
+
+int main(int argc, char **argv)
+{
+   int i;
+   const char *dir = ".";
+   uint32_t default_counts[] = { 1000, 100000, 1000000 };
+
+   if (argc > 1 && strcmp(argv[1], "-h") == 0)
+   {
+      printf("Usage: %s [directory] [record count...]\n", argv[0]);
+      printf("Times open, cursor scans, indexed finds and queries on\n");
+      printf("generated databases of 1k, 100k and 1M records by default.\n");
+      return 1;
+   }
+
+   if (argc > 1)
+      dir = argv[1];
+
+   if (argc > 2)
+   {
+      for (i = 2; i < argc; i++)
+         if (bench_run(dir, strtoul(argv[i], NULL, 0)) < 0)
+            return 1;
+      return 0;
+   }
+
+   for (i = 0; i < 3; i++)
+      if (bench_run(dir, default_counts[i]) < 0)
+         return 1;
+
+   return 0;
+}
@@ -4,6 +4,8 @@
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 
+#define MAX_INDEXES 16
+
 int main(int argc, char ** argv)
 {
    int rv;
@@ -18,7 +20,7 @@ int main(int argc, char ** argv)
       printf("Usage: %s <db file> <command> [extra args...]\n", argv[0]);
       printf("Available Commands:\n");
       printf("\tlist\n");
-      printf("\tcreate-index <index name> <field name>\n");
+      printf("\tcreate-index <index name> <field name> [...]\n");
       printf("\tfind <query expression>\n");
       return 1;
    }
@@ -85,18 +87,23 @@ int main(int argc, char ** argv)
    }
    else if (strcmp(command, "create-index") == 0)
    {
-      const char * index_name, * field_name;
+      const char * index_names[MAX_INDEXES], * field_names[MAX_INDEXES];
+      unsigned i, count = (argc - 3) / 2;
 
-      if (argc != 5)
+      if (argc < 5 || (argc - 3) % 2 != 0 || count > MAX_INDEXES)
       {
-         printf("Usage: %s <db file> create-index <index name> <field name>\n", argv[0]);
+         printf("Usage: %s <db file> create-index <index name> <field name> [<index name> <field name> ...]\n", argv[0]);
          return 1;
       }
 
-      index_name = argv[3];
-      field_name = argv[4];
+      /* All indexes are built in the same pass over the items. */
+      for (i = 0; i < count; i++)
+      {
+         index_names[i] = argv[3 + i * 2];
+         field_names[i] = argv[4 + i * 2];
+      }
 
-      libretrodb_create_index(&db, index_name, field_name);
+      libretrodb_create_indexes(&db, index_names, field_names, count);
    }
    else
    {
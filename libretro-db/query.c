@@ -58,6 +58,18 @@ static void raise_expected_string(off_t where, const char ** error)
    *error = tmp_error_buff;
 }
 
+static void raise_expected_hex(off_t where, const char ** error)
+{
+   snprintf(tmp_error_buff, MAX_ERROR_LEN,
+#ifdef _WIN32
+         "%I64u::Expected hex string",
+#else
+         "%llu::Expected hex string",
+#endif
+         (unsigned long long)where);
+   *error = tmp_error_buff;
+}
+
 static void raise_unexpected_eof(off_t where, const char ** error)
 {
    snprintf(tmp_error_buff, MAX_ERROR_LEN,
@@ -71,6 +83,13 @@ static void raise_unexpected_eof(off_t where, const char ** error)
    *error = tmp_error_buff;
 }
 
+static void raise_too_deep(const char **error)
+{
+   snprintf(tmp_error_buff, MAX_ERROR_LEN,
+         "Tables nested too deeply.");
+   *error = tmp_error_buff;
+}
+
 static void raise_enomem(const char **error)
 {
    snprintf(tmp_error_buff, MAX_ERROR_LEN, "Out of memory");
@@ -128,17 +147,23 @@ enum argument_type
    AT_VALUE
 };
 
-struct argument;
+enum query_func
+{
+   QF_NONE = 0,
+   QF_IS_TRUE,
+   QF_OR,
+   QF_AND,
+   QF_BETWEEN,
+   QF_GLOB,
+   /* A table, {field: test, ...}. */
+   QF_ALL_MAP
+};
 
-typedef struct rmsgpack_dom_value (*rarch_query_func)(
-        struct rmsgpack_dom_value input,
-        unsigned argc,
-        const struct argument *argv
-);
+struct argument;
 
 struct invocation
 {
-	rarch_query_func func;
+	enum query_func func;
 	unsigned argc;
 	struct argument *argv;
 };
@@ -167,240 +192,322 @@ static void argument_free(struct argument *arg)
       argument_free(&arg->invocation.argv[i]);
 }
 
+/* Queries are flattened into a program once parsed, so filtering an
+ * item is a loop over it instead of a walk of the invocation tree.
+ * Every instruction leaves its verdict in one result flag, and the
+ * jumps skip the rest of an and(), or() or table once it is decided. */
+enum query_op
+{
+   QOP_FALSE = 0,
+   QOP_EQUALS,
+   QOP_GLOB,
+   QOP_BETWEEN,
+   QOP_IS_TRUE,
+   /* Result is true, jumps to target if the input is not a map. */
+   QOP_MAP,
+   /* Makes a field of the input map the input. */
+   QOP_FIELD,
+   /* Goes back to the input from before the matching QOP_FIELD. */
+   QOP_POP,
+   QOP_JUMP_FALSE,
+   QOP_JUMP_TRUE
+};
+
+/* Tables nest at most this deep. */
+#define QUERY_MAX_DEPTH 32
+
+struct query_insn
+{
+   enum query_op op;
+   unsigned target;
+   /* Value, pattern, lower bound or field name, points into the
+    * invocation tree. */
+   const struct rmsgpack_dom_value *arg;
+   /* Upper bound. */
+   const struct rmsgpack_dom_value *arg2;
+   /* Where QOP_FIELD last found its field. Items of a database
+    * usually list their fields in the same order. */
+   unsigned hint;
+};
+
 struct query
 {
 	unsigned ref_count;
 	struct invocation root;
+	struct query_insn *program;
+	unsigned program_len;
+	unsigned program_cap;
 };
 
 struct registered_func
 {
 	const char *name;
-	rarch_query_func func;
+	enum query_func func;
 };
 
 static struct buffer parse_argument(struct buffer buff, struct argument *arg,
       const char **error);
 
-static struct rmsgpack_dom_value is_true(struct rmsgpack_dom_value input,
-        unsigned argc, const struct argument *argv)
+static const struct rmsgpack_dom_value query_nil_value;
+
+static int query_equals(const struct rmsgpack_dom_value *input,
+      const struct rmsgpack_dom_value *value)
 {
-   struct rmsgpack_dom_value res;
+   if (input->type == RDT_UINT && value->type == RDT_INT)
+      return input->uint_ == (uint64_t)value->int_;
 
-   res.type = RDT_BOOL;
-   res.bool_ = 0;
+   return rmsgpack_dom_value_cmp(input, value) == 0;
+}
 
-   if (argc > 0 || input.type != RDT_BOOL)
-      res.bool_ = 0;
-   else
-      res.bool_ = input.bool_;
+static int query_between(const struct rmsgpack_dom_value *input,
+      const struct rmsgpack_dom_value *lower,
+      const struct rmsgpack_dom_value *upper)
+{
+   switch (input->type)
+   {
+      case RDT_INT:
+         return input->int_ >= lower->int_ && input->int_ <= upper->int_;
+      case RDT_UINT:
+         return input->int_ >= lower->uint_ && input->int_ <= upper->int_;
+      default:
+         break;
+   }
 
-   return res;
+   return 0;
 }
 
-static struct rmsgpack_dom_value equals(struct rmsgpack_dom_value input,
-        unsigned argc, const struct argument * argv)
+static const struct rmsgpack_dom_value *query_field(
+      const struct rmsgpack_dom_value *map, struct query_insn *insn)
 {
-   struct rmsgpack_dom_value res;
-   struct argument arg;
+   unsigned i;
 
-   res.type = RDT_BOOL;
+   if (insn->hint < map->map.len &&
+         rmsgpack_dom_value_cmp(&map->map.items[insn->hint].key,
+            insn->arg) == 0)
+      return &map->map.items[insn->hint].value;
 
-   if (argc != 1)
-      res.bool_ = 0;
-   else
+   for (i = 0; i < map->map.len; i++)
    {
-      arg = argv[0];
-
-      if (arg.type != AT_VALUE)
-         res.bool_ = 0;
-      else
+      if (rmsgpack_dom_value_cmp(&map->map.items[i].key, insn->arg) == 0)
       {
-         if (input.type == RDT_UINT && arg.value.type == RDT_INT)
-         {
-            arg.value.type = RDT_UINT;
-            arg.value.uint_ = arg.value.int_;
-         }
-         res.bool_ = (rmsgpack_dom_value_cmp(&input, &arg.value) == 0);
+         /* Only ever a guess, so racing writers do no harm. */
+         insn->hint = i;
+         return &map->map.items[i].value;
       }
    }
-   return res;
+
+   /* All missing fields are nil */
+   return &query_nil_value;
 }
 
-static struct rmsgpack_dom_value operator_or(struct rmsgpack_dom_value input,
-        unsigned argc, const struct argument * argv)
+static int query_run(struct query *q, const struct rmsgpack_dom_value *item)
 {
-   struct rmsgpack_dom_value res;
-   unsigned i;
-
-   res.type = RDT_BOOL;
-   res.bool_ = 0;
+   const struct rmsgpack_dom_value *stack[QUERY_MAX_DEPTH];
+   const struct rmsgpack_dom_value *input = item;
+   unsigned depth                         = 0;
+   unsigned pc                            = 0;
+   int result                             = 0;
 
-   for (i = 0; i < argc; i++)
+   while (pc < q->program_len)
    {
-      if (argv[i].type == AT_VALUE)
-         res = equals(input, 1, &argv[i]);
-      else
+      struct query_insn *insn = &q->program[pc++];
+
+      switch (insn->op)
       {
-         res = is_true(argv[i].invocation.func(input,
-                  argv[i].invocation.argc,
-                  argv[i].invocation.argv
-                  ), 0, NULL);
+         case QOP_FALSE:
+            result = 0;
+            break;
+         case QOP_EQUALS:
+            result = query_equals(input, insn->arg);
+            break;
+         case QOP_GLOB:
+            result = input->type == RDT_STRING &&
+               rl_fnmatch(insn->arg->string.buff,
+                     input->string.buff, 0) == 0;
+            break;
+         case QOP_BETWEEN:
+            result = query_between(input, insn->arg, insn->arg2);
+            break;
+         case QOP_IS_TRUE:
+            result = input->type == RDT_BOOL && input->bool_;
+            break;
+         case QOP_MAP:
+            result = 1;
+            if (input->type != RDT_MAP)
+               pc = insn->target;
+            break;
+         case QOP_FIELD:
+            stack[depth++] = input;
+            input          = query_field(input, insn);
+            break;
+         case QOP_POP:
+            input = stack[--depth];
+            break;
+         case QOP_JUMP_FALSE:
+            if (!result)
+               pc = insn->target;
+            break;
+         case QOP_JUMP_TRUE:
+            if (result)
+               pc = insn->target;
+            break;
       }
-
-      if (res.bool_)
-         return res;
    }
 
-   return res;
+   return result;
 }
 
-static struct rmsgpack_dom_value between(struct rmsgpack_dom_value input,
-      unsigned argc, const struct argument * argv)
+static struct query_insn *query_emit(struct query *q, enum query_op op,
+      const struct rmsgpack_dom_value *arg)
 {
-   struct rmsgpack_dom_value res;
-   unsigned i = 0;
+   struct query_insn *insn;
 
-   res.type = RDT_BOOL;
-   res.bool_ = 0;
-
-   (void)i;
+   if (q->program_len == q->program_cap)
+   {
+      unsigned cap = q->program_cap ? q->program_cap * 2 : 16;
+      struct query_insn *program = (struct query_insn*)
+         realloc(q->program, cap * sizeof(*program));
 
-   if (argc != 2)
-      return res;
-   if (argv[0].type != AT_VALUE || argv[1].type != AT_VALUE)
-      return res;
-   if (argv[0].value.type != RDT_INT || argv[1].value.type != RDT_INT)
-      return res;
+      if (!program)
+         return NULL;
 
-   switch (input.type)
-   {
-      case RDT_INT:
-         res.bool_ = input.int_ >= argv[0].value.int_ && input.int_ <= argv[1].value.int_;
-         break;
-      case RDT_UINT:
-         res.bool_ = input.int_ >= argv[0].value.uint_ && input.int_ <= argv[1].value.int_;
-         break;
-      default:
-         return res;
+      q->program     = program;
+      q->program_cap = cap;
    }
 
-   return res;
+   insn = &q->program[q->program_len++];
+   memset(insn, 0, sizeof(*insn));
+   insn->op  = op;
+   insn->arg = arg;
+   return insn;
 }
 
-static struct rmsgpack_dom_value operator_and(struct rmsgpack_dom_value input,
-      unsigned argc, const struct argument * argv)
+static int query_compile_invocation(struct query *q,
+      const struct invocation *inv, unsigned depth, const char **error);
+
+/* A value in place of a test means equality with it. */
+static int query_compile_argument(struct query *q,
+      const struct argument *arg, unsigned depth, const char **error)
 {
-   struct rmsgpack_dom_value res;
-   unsigned i;
+   if (arg->type == AT_VALUE)
+      return query_emit(q, QOP_EQUALS, &arg->value) ? 0 : -1;
 
-   res.type = RDT_BOOL;
-   res.bool_ = 0;
+   return query_compile_invocation(q, &arg->invocation, depth, error);
+}
+
+/* Points the jumps emitted since @first that are still unresolved
+ * at the end of the program. */
+static void query_patch_jumps(struct query *q, unsigned first)
+{
+   unsigned i;
 
-   for (i = 0; i < argc; i++)
+   for (i = first; i < q->program_len; i++)
    {
-      if (argv[i].type == AT_VALUE)
-         res = equals(input, 1, &argv[i]);
-      else
-      {
-         res = is_true(
-               argv[i].invocation.func(input,
-                  argv[i].invocation.argc,
-                  argv[i].invocation.argv
-                  ),
-               0, NULL);
-      }
+      struct query_insn *insn = &q->program[i];
 
-      if (!res.bool_)
-         return res;
+      if ((insn->op == QOP_JUMP_FALSE || insn->op == QOP_JUMP_TRUE ||
+               insn->op == QOP_MAP) && !insn->target)
+         insn->target = q->program_len;
    }
-   return res;
 }
 
-static struct rmsgpack_dom_value q_glob(struct rmsgpack_dom_value input,
-      unsigned argc, const struct argument * argv)
+static int query_compile_invocation(struct query *q,
+      const struct invocation *inv, unsigned depth, const char **error)
 {
-   struct rmsgpack_dom_value res;
-   unsigned i = 0;
-
-   res.type = RDT_BOOL;
-   res.bool_ = 0;
+   unsigned i;
+   unsigned first = q->program_len;
+   const struct argument *argv = inv->argv;
 
-   (void)i;
+   switch (inv->func)
+   {
+      case QF_IS_TRUE:
+         if (inv->argc > 0)
+            break;
+         return query_emit(q, QOP_IS_TRUE, NULL) ? 0 : -1;
+      case QF_OR:
+      case QF_AND:
+         if (!query_emit(q, QOP_FALSE, NULL))
+            return -1;
+
+         for (i = 0; i < inv->argc; i++)
+         {
+            if (query_compile_argument(q, &argv[i], depth, error) != 0)
+               return -1;
 
-   if (argc != 1)
-      return res;
-   if (argv[0].type != AT_VALUE || argv[0].value.type != RDT_STRING)
-      return res;
-   if (input.type != RDT_STRING)
-      return res;
-   res.bool_ = rl_fnmatch(
-         argv[0].value.string.buff,
-         input.string.buff,
-         0
-         ) == 0;
-   return res;
-}
+            if (i + 1 < inv->argc && !query_emit(q, inv->func == QF_OR
+                     ? QOP_JUMP_TRUE : QOP_JUMP_FALSE, NULL))
+               return -1;
+         }
 
-static struct rmsgpack_dom_value all_map(struct rmsgpack_dom_value input,
-      unsigned argc, const struct argument *argv)
-{
-   unsigned i;
-   struct rmsgpack_dom_value res;
-   struct argument arg;
-   struct rmsgpack_dom_value nil_value;
-   struct rmsgpack_dom_value *value = NULL;
+         /* Jumps of nested invocations are already resolved. */
+         query_patch_jumps(q, first);
+         return 0;
+      case QF_BETWEEN:
+         if (inv->argc != 2
+               || argv[0].type != AT_VALUE || argv[1].type != AT_VALUE
+               || argv[0].value.type != RDT_INT
+               || argv[1].value.type != RDT_INT)
+            break;
 
-   nil_value.type = RDT_NULL;
-   res.type       = RDT_BOOL;
-   res.bool_      = 1;
+         {
+            struct query_insn *insn =
+               query_emit(q, QOP_BETWEEN, &argv[0].value);
+            if (!insn)
+               return -1;
+            insn->arg2 = &argv[1].value;
+         }
+         return 0;
+      case QF_GLOB:
+         if (inv->argc != 1 || argv[0].type != AT_VALUE
+               || argv[0].value.type != RDT_STRING)
+            break;
+         return query_emit(q, QOP_GLOB, &argv[0].value) ? 0 : -1;
+      case QF_ALL_MAP:
+         if (inv->argc % 2 != 0)
+            break;
+
+         if (depth >= QUERY_MAX_DEPTH)
+         {
+            raise_too_deep(error);
+            return -1;
+         }
 
-   if (argc % 2 != 0)
-   {
-      res.bool_ = 0;
-      return res;
-   }
+         if (!query_emit(q, QOP_MAP, NULL))
+            return -1;
 
-   if (input.type != RDT_MAP)
-      return res;
+         for (i = 0; i < inv->argc; i += 2)
+         {
+            if (argv[i].type != AT_VALUE)
+            {
+               if (!query_emit(q, QOP_FALSE, NULL))
+                  return -1;
+               break;
+            }
+
+            if (!query_emit(q, QOP_FIELD, &argv[i].value)
+                  || query_compile_argument(q, &argv[i + 1], depth + 1, error) != 0
+                  || !query_emit(q, QOP_POP, NULL)
+                  || !query_emit(q, QOP_JUMP_FALSE, NULL))
+               return -1;
+         }
 
-   for (i = 0; i < argc; i += 2)
-   {
-      arg = argv[i];
-      if (arg.type != AT_VALUE)
-      {
-         res.bool_ = 0;
-         goto clean;
-      }
-      value = rmsgpack_dom_value_map_value(&input, &arg.value);
-      if (!value) /* All missing fields are nil */
-         value = &nil_value;
-      arg = argv[i + 1];
-      if (arg.type == AT_VALUE)
-         res = equals(*value, 1, &arg);
-      else
-      {
-         res = is_true(arg.invocation.func(
-                  *value,
-                  arg.invocation.argc,
-                  arg.invocation.argv
-                  ), 0, NULL);
-         value = NULL;
-      }
-      if (!res.bool_)
+         query_patch_jumps(q, first);
+         return 0;
+      case QF_NONE:
          break;
    }
-clean:
-   return res;
+
+   /* Malformed invocations never match. */
+   return query_emit(q, QOP_FALSE, NULL) ? 0 : -1;
 }
 
 struct registered_func registered_functions[100] = {
-	{"is_true", is_true},
-	{"or", operator_or},
-	{"and", operator_and},
-	{"between", between},
-	{"glob", q_glob},
-	{NULL, NULL}
+	{"is_true", QF_IS_TRUE},
+	{"or", QF_OR},
+	{"and", QF_AND},
+	{"between", QF_BETWEEN},
+	{"glob", QF_GLOB},
+	{NULL, QF_NONE}
 };
 
 static struct buffer chomp(struct buffer buff)
@@ -520,6 +627,52 @@ static struct buffer parse_string(struct buffer buff,
    return buff;
 }
 
+static int hex_digit(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+   return -1;
+}
+
+/* b"DEADBEEF" is the binary value 0xde 0xad 0xbe 0xef. */
+static struct buffer parse_binary(struct buffer buff,
+      struct rmsgpack_dom_value *value, const char **error)
+{
+   uint32_t i;
+   off_t where = buff.offset;
+
+   buff.offset++;
+   buff = parse_string(buff, value, error);
+
+   if (*error)
+      return buff;
+
+   for (i = 0; i < value->string.len; i++)
+   {
+      if (hex_digit(value->string.buff[i]) < 0)
+         break;
+   }
+
+   if (i != value->string.len || i % 2 != 0)
+   {
+      rmsgpack_dom_value_free(value);
+      raise_expected_hex(where, error);
+      return buff;
+   }
+
+   for (i = 0; i < value->string.len / 2; i++)
+      value->string.buff[i] = (hex_digit(value->string.buff[i * 2]) << 4)
+         | hex_digit(value->string.buff[i * 2 + 1]);
+
+   value->type       = RDT_BINARY;
+   value->binary.len = value->string.len / 2;
+   return buff;
+}
+
 static struct buffer parse_integer(struct buffer buff,
       struct rmsgpack_dom_value *value, const char **error)
 {
@@ -565,6 +718,8 @@ static struct buffer parse_value(struct buffer buff,
    }
    else if (peek(buff, "\"") || peek(buff, "'"))
       buff = parse_string(buff, value, error);
+   else if (peek(buff, "b\"") || peek(buff, "b'"))
+      buff = parse_binary(buff, value, error);
    else if (isdigit(buff.data[buff.offset]))
       buff = parse_integer(buff, value, error);
    return buff;
@@ -618,7 +773,7 @@ static struct buffer parse_method_call(struct buffer buff,
    unsigned argi = 0;
    struct registered_func * rf = registered_functions;
 
-   invocation->func = NULL;
+   invocation->func = QF_NONE;
 
    buff = get_ident(buff, &func_name, &func_name_len, error);
    if (*error)
@@ -789,7 +944,7 @@ static struct buffer parse_table(struct buffer buff,
    if (*error)
       goto clean;
 
-   invocation->func = all_map;
+   invocation->func = QF_ALL_MAP;
    invocation->argc = argi;
    invocation->argv = (struct argument*)
       malloc(sizeof(struct argument) * argi);
@@ -821,6 +976,8 @@ static struct buffer parse_argument(struct buffer buff,
             peek(buff, "nil")
             || peek(buff, "true")
             || peek(buff, "false")
+            || peek(buff, "b\"")
+            || peek(buff, "b'")
             )
       )
    {
@@ -853,6 +1010,8 @@ void libretrodb_query_free(void *q)
 
 	for (i = 0; i < real_q->root.argc; i++)
 		argument_free(&real_q->root.argv[i]);
+	free(real_q->program);
+	real_q->program = NULL;
 }
 
 void *libretrodb_query_compile(libretrodb_t *db,
@@ -892,6 +1051,13 @@ void *libretrodb_query_compile(libretrodb_t *db,
       raise_unexpected_eof(buff.offset, error);
       return NULL;
    }
+
+   if (query_compile_invocation(q, &q->root, 0, error) != 0)
+   {
+      if (!*error)
+         raise_enomem(error);
+      goto clean;
+   }
    goto success;
 clean:
    if (q)
@@ -907,10 +1073,55 @@ void libretrodb_query_inc_ref(libretrodb_query_t *q)
       rq->ref_count += 1;
 }
 
+int libretrodb_query_index_key(libretrodb_query_t *q, unsigned n,
+      const char **field, struct rmsgpack_dom_value *key, int *prefix)
+{
+   unsigned i;
+   struct invocation inv = ((struct query *)q)->root;
+
+   if (inv.func != QF_ALL_MAP)
+      return -1;
+
+   for (i = 0; i + 1 < inv.argc; i += 2)
+   {
+      const struct argument *name = &inv.argv[i];
+      const struct argument *test = &inv.argv[i + 1];
+
+      if (name->type != AT_VALUE || name->value.type != RDT_STRING)
+         continue;
+
+      if (test->type == AT_VALUE)
+      {
+         *key    = test->value;
+         *prefix = 0;
+      }
+      else if (test->invocation.func == QF_GLOB
+            && test->invocation.argc == 1
+            && test->invocation.argv[0].type == AT_VALUE
+            && test->invocation.argv[0].value.type == RDT_STRING)
+      {
+         *key                = test->invocation.argv[0].value;
+         key->string.len     = strcspn(key->string.buff, "*?[\\");
+         *prefix             = 1;
+
+         if (!key->string.len)
+            continue;
+      }
+      else
+         continue;
+
+      if (n-- == 0)
+      {
+         *field = name->value.string.buff;
+         return 0;
+      }
+   }
+
+   return -1;
+}
+
 int libretrodb_query_filter(libretrodb_query_t *q,
       struct rmsgpack_dom_value *v)
 {
-   struct invocation inv = ((struct query *)q)->root;
-   struct rmsgpack_dom_value res = inv.func(*v, inv.argc, inv.argv);
-   return (res.type == RDT_BOOL && res.bool_);
+   return query_run((struct query *)q, v);
 }
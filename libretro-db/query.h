@@ -10,4 +10,21 @@ void libretrodb_query_dec_ref(libretrodb_query_t *q);
 int libretrodb_query_filter(libretrodb_query_t *q,
       struct rmsgpack_dom_value * v);
 
+/**
+ * libretrodb_query_index_key:
+ * @q                   : Query.
+ * @n                   : Which candidate to return.
+ * @field               : Field the candidate tests.
+ * @key                 : Value the field is tested against. Points
+ *                        into @q and must not be freed.
+ * @prefix              : Set if @key only has to be a prefix.
+ *
+ * Lists the tests of a table query that an index could answer:
+ * equality with a value, and glob() patterns with a literal prefix.
+ *
+ * Returns: 0 if there is an @n-th candidate, otherwise -1.
+ **/
+int libretrodb_query_index_key(libretrodb_query_t *q, unsigned n,
+      const char **field, struct rmsgpack_dom_value *key, int *prefix);
+
 #endif
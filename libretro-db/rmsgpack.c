@@ -21,6 +21,8 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <retro_inline.h>
+
 #include "libretrodb_endian.h"
 
 static const uint8_t MPF_FIXMAP = 0x80;
@@ -213,8 +215,7 @@ int rmsgpack_write_bool(int fd, int value)
       if (write(fd, &MPF_TRUE, sizeof(MPF_TRUE)) == -1)
          return -errno;
    }
-
-   if (write(fd, &MPF_FALSE, sizeof(MPF_FALSE)) == -1)
+   else if (write(fd, &MPF_FALSE, sizeof(MPF_FALSE)) == -1)
       return -errno;
 
    return sizeof(uint8_t);
@@ -328,13 +329,143 @@ int rmsgpack_write_uint(int fd, uint64_t value)
    return written;
 }
 
-static int read_uint(int fd, uint64_t *out, size_t size)
+int rmsgpack_reader_init(struct rmsgpack_reader *reader,
+      int fd, size_t size)
 {
-   uint64_t tmp;
+   memset(reader, 0, sizeof(*reader));
+   reader->fd = fd;
+
+   if (!size)
+      return 0;
+
+   reader->buff = (uint8_t *)malloc(size);
+   if (!reader->buff)
+      return -ENOMEM;
+
+   reader->size     = size;
+   reader->file_pos = lseek(fd, 0, SEEK_CUR);
+   return 0;
+}
+
+void rmsgpack_reader_free(struct rmsgpack_reader *reader)
+{
+   if (reader->buff)
+      free(reader->buff);
+   reader->buff = NULL;
+   reader->size = 0;
+   reader->pos  = 0;
+   reader->len  = 0;
+}
+
+void rmsgpack_reader_seek(struct rmsgpack_reader *reader, uint64_t offset)
+{
+   /* Seeking inside the buffered window is free. */
+   if (offset >= reader->file_pos && offset <= reader->file_pos + reader->len)
+   {
+      reader->pos = offset - reader->file_pos;
+      return;
+   }
+
+   reader->file_pos = offset;
+   reader->pos      = 0;
+   reader->len      = 0;
+}
+
+uint64_t rmsgpack_reader_tell(const struct rmsgpack_reader *reader)
+{
+   if (!reader->buff)
+      return lseek(reader->fd, 0, SEEK_CUR);
+   return reader->file_pos + reader->pos;
+}
+
+static int read_fd(int fd, uint8_t *out, size_t len, size_t *nread)
+{
+   ssize_t rv;
+
+   *nread = 0;
 
-   if (read(fd, &tmp, size) == -1)
+   while (*nread < len)
+   {
+      if ((rv = read(fd, out + *nread, len - *nread)) == -1)
+         return -errno;
+      if (rv == 0)
+         break;
+      *nread += rv;
+   }
+
+   return 0;
+}
+
+static int reader_fetch_slow(struct rmsgpack_reader *reader,
+      void *dst, size_t len)
+{
+   int rv;
+   size_t nread;
+   uint8_t *out = (uint8_t *)dst;
+   size_t avail = reader->len - reader->pos;
+
+   if (!reader->buff)
+   {
+      if ((rv = read_fd(reader->fd, out, len, &nread)) < 0)
+         return rv;
+      return nread == len ? 0 : -EINVAL;
+   }
+
+   memcpy(out, reader->buff + reader->pos, avail);
+   out += avail;
+   len -= avail;
+
+   reader->file_pos += reader->len;
+   reader->pos       = 0;
+   reader->len       = 0;
+
+   /* The descriptor may be shared with other cursors of the same
+    * database, so always seek to where this reader left off. */
+   if (lseek(reader->fd, reader->file_pos, SEEK_SET) == -1)
       return -errno;
 
+   /* Items larger than the buffer go straight to the caller. */
+   if (len >= reader->size)
+   {
+      if ((rv = read_fd(reader->fd, out, len, &nread)) < 0)
+         return rv;
+      reader->file_pos += nread;
+      return nread == len ? 0 : -EINVAL;
+   }
+
+   if ((rv = read_fd(reader->fd, reader->buff, reader->size, &nread)) < 0)
+      return rv;
+
+   reader->len = nread;
+   if (nread < len)
+      return -EINVAL;
+
+   memcpy(out, reader->buff, len);
+   reader->pos = len;
+   return 0;
+}
+
+static INLINE int reader_fetch(struct rmsgpack_reader *reader,
+      void *dst, size_t len)
+{
+   if (reader->len - reader->pos >= len)
+   {
+      memcpy(dst, reader->buff + reader->pos, len);
+      reader->pos += len;
+      return 0;
+   }
+
+   return reader_fetch_slow(reader, dst, len);
+}
+
+static int read_uint(struct rmsgpack_reader *reader, uint64_t *out, size_t size)
+{
+   int rv;
+   uint64_t tmp;
+
+   if ((rv = reader_fetch(reader, &tmp, size)) < 0)
+      return rv;
+
    switch (size)
    {
       case 1:
@@ -353,15 +484,16 @@ static int read_uint(int fd, uint64_t *out, size_t size)
    return 0;
 }
 
-static int read_int(int fd, int64_t *out, size_t size)
+static int read_int(struct rmsgpack_reader *reader, int64_t *out, size_t size)
 {
+   int rv;
    uint8_t tmp8 = 0;
    uint16_t tmp16;
    uint32_t tmp32;
    uint64_t tmp64;
 
-   if (read(fd, &tmp64, size) == -1)
-      return -errno;
+   if ((rv = reader_fetch(reader, &tmp64, size)) < 0)
+      return rv;
 
    (void)tmp8;
 
@@ -386,26 +518,52 @@ static int read_int(int fd, int64_t *out, size_t size)
    return 0;
 }
 
-static int read_buff(int fd, size_t size, char **pbuff, uint64_t *len)
+static char *alloc_buff(struct rmsgpack_read_callbacks *callbacks,
+      void *data, uint64_t len)
+{
+   char *buff;
+
+   if (!callbacks->alloc_buff)
+      return (char *)calloc(len + 1, sizeof(char));
+
+   buff = (char *)callbacks->alloc_buff(len + 1, data);
+   if (buff)
+      buff[len] = '\0';
+   return buff;
+}
+
+static void free_buff(struct rmsgpack_read_callbacks *callbacks, char *buff)
+{
+   /* Buffers from alloc_buff belong to the callbacks. */
+   if (!callbacks->alloc_buff)
+      free(buff);
+}
+
+static int read_buff(struct rmsgpack_reader *reader, size_t size,
+      char **pbuff, uint64_t *len,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
 {
+   int rv;
    uint64_t tmp_len = 0;
 
-   if (read_uint(fd, &tmp_len, size) == -1)
-      return -errno;
+   if ((rv = read_uint(reader, &tmp_len, size)) < 0)
+      return rv;
 
-   *pbuff = (char *)calloc(tmp_len + 1, sizeof(char));
+   *pbuff = alloc_buff(callbacks, data, tmp_len);
+   if (!*pbuff)
+      return -ENOMEM;
 
-   if (read(fd, *pbuff, tmp_len) == -1)
+   if ((rv = reader_fetch(reader, *pbuff, tmp_len)) < 0)
    {
-      free(*pbuff);
-      return -errno;
+      free_buff(callbacks, *pbuff);
+      return rv;
    }
 
    *len = tmp_len;
    return 0;
 }
 
-static int read_map(int fd, uint32_t len,
+static int read_map(struct rmsgpack_reader *reader, uint32_t len,
         struct rmsgpack_read_callbacks *callbacks, void *data)
 {
    int rv;
@@ -417,16 +575,16 @@ static int read_map(int fd, uint32_t len,
 
    for (i = 0; i < len; i++)
    {
-      if ((rv = rmsgpack_read(fd, callbacks, data)) < 0)
+      if ((rv = rmsgpack_reader_read(reader, callbacks, data)) < 0)
          return rv;
-      if ((rv = rmsgpack_read(fd, callbacks, data)) < 0)
+      if ((rv = rmsgpack_reader_read(reader, callbacks, data)) < 0)
          return rv;
    }
 
    return 0;
 }
 
-static int read_array(int fd, uint32_t len,
+static int read_array(struct rmsgpack_reader *reader, uint32_t len,
       struct rmsgpack_read_callbacks *callbacks, void *data)
 {
    int rv;
@@ -438,7 +596,7 @@ static int read_array(int fd, uint32_t len,
 
    for (i = 0; i < len; i++)
    {
-      if ((rv = rmsgpack_read(fd, callbacks, data)) < 0)
+      if ((rv = rmsgpack_reader_read(reader, callbacks, data)) < 0)
          return rv;
    }
 
@@ -447,6 +605,15 @@ static int read_array(int fd, uint32_t len,
 
 int rmsgpack_read(int fd,
       struct rmsgpack_read_callbacks *callbacks, void *data)
+{
+   struct rmsgpack_reader reader;
+
+   rmsgpack_reader_init(&reader, fd, 0);
+   return rmsgpack_reader_read(&reader, callbacks, data);
+}
+
+int rmsgpack_reader_read(struct rmsgpack_reader *reader,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
 {
    int rv;
    uint64_t tmp_len  = 0;
@@ -455,8 +622,10 @@ int rmsgpack_read(int fd,
    uint8_t type      = 0;
    char *buff        = NULL;
 
-   if (read(fd, &type, sizeof(uint8_t)) == -1)
-      return -errno;
+   if (reader->pos < reader->len)
+      type = reader->buff[reader->pos++];
+   else if ((rv = reader_fetch_slow(reader, &type, sizeof(uint8_t))) < 0)
+      return rv;
 
    if (type < MPF_FIXMAP)
    {
@@ -467,28 +636,28 @@ int rmsgpack_read(int fd,
    else if (type < MPF_FIXARRAY)
    {
       tmp_len = type - MPF_FIXMAP;
-      return read_map(fd, tmp_len, callbacks, data);
+      return read_map(reader, tmp_len, callbacks, data);
    }
    else if (type < MPF_FIXSTR)
    {
       tmp_len = type - MPF_FIXARRAY;
-      return read_array(fd, tmp_len, callbacks, data);
+      return read_array(reader, tmp_len, callbacks, data);
    }
    else if (type < MPF_NIL)
    {
       tmp_len = type - MPF_FIXSTR;
-      buff = (char *)calloc(tmp_len + 1, sizeof(char));
+      buff = alloc_buff(callbacks, data, tmp_len);
       if (!buff)
          return -ENOMEM;
-      if (read(fd, buff, tmp_len) == -1)
+      if ((rv = reader_fetch(reader, buff, tmp_len)) < 0)
       {
-         free(buff);
-         return -errno;
+         free_buff(callbacks, buff);
+         return rv;
       }
       buff[tmp_len] = '\0';
       if (!callbacks->read_string)
       {
-         free(buff);
+         free_buff(callbacks, buff);
          return 0;
       }
       return callbacks->read_string(buff, tmp_len, data);
@@ -517,8 +686,8 @@ int rmsgpack_read(int fd,
       case 0xc4:
       case 0xc5:
       case 0xc6:
-         if ((rv = read_buff(fd, 1<<(type - 0xc4),
-                     &buff, &tmp_len)) < 0)
+         if ((rv = read_buff(reader, 1<<(type - 0xc4),
+                     &buff, &tmp_len, callbacks, data)) < 0)
             return rv;
 
          if (callbacks->read_bin)
@@ -530,8 +699,8 @@ int rmsgpack_read(int fd,
       case 0xcf:
          tmp_len = 1ULL << (type - 0xcc);
          tmp_uint = 0;
-         if (read_uint(fd, &tmp_uint, tmp_len) == -1)
-            return -errno;
+         if ((rv = read_uint(reader, &tmp_uint, tmp_len)) < 0)
+            return rv;
 
          if (callbacks->read_uint)
             return callbacks->read_uint(tmp_uint, data);
@@ -542,8 +711,8 @@ int rmsgpack_read(int fd,
       case 0xd3:
          tmp_len = 1ULL << (type - 0xd0);
          tmp_int = 0;
-         if (read_int(fd, &tmp_int, tmp_len) == -1)
-            return -errno;
+         if ((rv = read_int(reader, &tmp_int, tmp_len)) < 0)
+            return rv;
 
          if (callbacks->read_int)
             return callbacks->read_int(tmp_int, data);
@@ -551,7 +720,8 @@ int rmsgpack_read(int fd,
       case 0xd9:
       case 0xda:
       case 0xdb:
-         if ((rv = read_buff(fd, 1<<(type - 0xd9), &buff, &tmp_len)) < 0)
+         if ((rv = read_buff(reader, 1<<(type - 0xd9),
+                     &buff, &tmp_len, callbacks, data)) < 0)
             return rv;
 
          if (callbacks->read_string)
@@ -559,16 +729,16 @@ int rmsgpack_read(int fd,
          break;
       case 0xdc:
       case 0xdd:
-         if (read_uint(fd, &tmp_len, 2<<(type - 0xdc)) == -1)
-            return -errno;
+         if ((rv = read_uint(reader, &tmp_len, 2<<(type - 0xdc))) < 0)
+            return rv;
 
-         return read_array(fd, tmp_len, callbacks, data);
+         return read_array(reader, tmp_len, callbacks, data);
       case 0xde:
       case 0xdf:
-         if (read_uint(fd, &tmp_len, 2<<(type - 0xde)) == -1)
-            return -errno;
+         if ((rv = read_uint(reader, &tmp_len, 2<<(type - 0xde))) < 0)
+            return rv;
 
-         return read_map(fd, tmp_len, callbacks, data);
+         return read_map(reader, tmp_len, callbacks, data);
    }
 
    return 0;
@@ -1,6 +1,7 @@
 #ifndef __RARCHDB_MSGPACK_H__
 #define __RARCHDB_MSGPACK_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 struct rmsgpack_read_callbacks {
@@ -35,6 +36,12 @@ struct rmsgpack_read_callbacks {
 	        uint32_t,
 	        void *
 	);
+	/* Optional. Allocates string and binary buffers, which are then
+	 * owned by the callbacks. Defaults to calloc(). */
+	void * (* alloc_buff)(
+	        size_t,
+	        void *
+	);
 };
 
 
@@ -70,6 +77,38 @@ int rmsgpack_write_uint(
         uint64_t value
 );
 
+/* Reads from a window of the file held in memory, so walking
+ * many small items costs a pointer bump per field instead of a
+ * read() call. A reader with no buffer reads the descriptor directly
+ * and leaves its offset right past the item read. */
+struct rmsgpack_reader {
+	int fd;
+	uint8_t * buff;
+	size_t size;
+	/* File offset of buff[0]. */
+	uint64_t file_pos;
+	size_t pos;
+	size_t len;
+};
+
+int rmsgpack_reader_init(
+        struct rmsgpack_reader * reader,
+        int fd,
+        size_t size
+);
+void rmsgpack_reader_free(struct rmsgpack_reader * reader);
+void rmsgpack_reader_seek(
+        struct rmsgpack_reader * reader,
+        uint64_t offset
+);
+uint64_t rmsgpack_reader_tell(const struct rmsgpack_reader * reader);
+
+int rmsgpack_reader_read(
+        struct rmsgpack_reader * reader,
+        struct rmsgpack_read_callbacks * callbacks,
+        void * data
+);
+
 int rmsgpack_read(
         int fd,
         struct rmsgpack_read_callbacks * callbacks,
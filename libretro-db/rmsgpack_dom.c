@@ -1,5 +1,6 @@
 #include "rmsgpack_dom.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <errno.h>
@@ -15,8 +16,49 @@ struct dom_reader_state
 {
 	int i;
 	struct rmsgpack_dom_value *stack[MAX_DEPTH];
+	struct rmsgpack_dom_arena *arena;
 };
 
+void rmsgpack_dom_arena_init(struct rmsgpack_dom_arena *arena,
+      size_t block_size)
+{
+   ralloc_arena_init(&arena->base, block_size, RALLOC_TAG_DATABASE);
+}
+
+void rmsgpack_dom_arena_mark(const struct rmsgpack_dom_arena *arena,
+      struct rmsgpack_dom_arena_mark *mark)
+{
+   ralloc_arena_mark(&arena->base, &mark->base);
+}
+
+void rmsgpack_dom_arena_rewind(struct rmsgpack_dom_arena *arena,
+      const struct rmsgpack_dom_arena_mark *mark)
+{
+   ralloc_arena_rewind(&arena->base, &mark->base);
+}
+
+void rmsgpack_dom_arena_reset(struct rmsgpack_dom_arena *arena)
+{
+   ralloc_arena_reset(&arena->base);
+}
+
+void rmsgpack_dom_arena_free(struct rmsgpack_dom_arena *arena)
+{
+   ralloc_arena_free(&arena->base);
+}
+
+static void *dom_alloc_items(struct dom_reader_state *s, size_t size)
+{
+   void *items;
+
+   if (!s->arena)
+      return calloc(1, size);
+
+   if ((items = ralloc_arena_alloc(&s->arena->base, size)))
+      memset(items, 0, size);
+   return items;
+}
+
 static struct rmsgpack_dom_value *dom_reader_state_pop(
       struct dom_reader_state *s)
 {
@@ -112,8 +154,8 @@ static int dom_read_map_start(uint32_t len, void *data)
    v->map.len = len;
    v->map.items = NULL;
 
-   items = (struct rmsgpack_dom_pair *)calloc(len,
-         sizeof(struct rmsgpack_dom_pair));
+   items = (struct rmsgpack_dom_pair *)dom_alloc_items(dom_state,
+         len * sizeof(struct rmsgpack_dom_pair));
 
    if (!items)
       return -ENOMEM;
@@ -142,7 +184,8 @@ static int dom_read_array_start(uint32_t len, void *data)
 	v->array.len = len;
 	v->array.items = NULL;
 
-	items = (struct rmsgpack_dom_value *)calloc(len, sizeof(struct rmsgpack_dom_pair));
+	items = (struct rmsgpack_dom_value *)dom_alloc_items(dom_state,
+         len * sizeof(struct rmsgpack_dom_value));
 
 	if (!items)
 		return -ENOMEM;
@@ -158,6 +201,12 @@ static int dom_read_array_start(uint32_t len, void *data)
 	return 0;
 }
 
+static void *dom_alloc_buff(size_t size, void *data)
+{
+   struct dom_reader_state *dom_state = (struct dom_reader_state *)data;
+   return ralloc_arena_alloc(&dom_state->arena->base, size);
+}
+
 static struct rmsgpack_read_callbacks dom_reader_callbacks = {
 	dom_read_nil,
 	dom_read_bool,
@@ -166,7 +215,20 @@ static struct rmsgpack_read_callbacks dom_reader_callbacks = {
 	dom_read_string,
 	dom_read_bin,
 	dom_read_map_start,
-	dom_read_array_start
+	dom_read_array_start,
+	NULL
+};
+
+static struct rmsgpack_read_callbacks dom_arena_reader_callbacks = {
+	dom_read_nil,
+	dom_read_bool,
+	dom_read_int,
+	dom_read_uint,
+	dom_read_string,
+	dom_read_bin,
+	dom_read_map_start,
+	dom_read_array_start,
+	dom_alloc_buff
 };
 
 void rmsgpack_dom_value_free(struct rmsgpack_dom_value *v)
@@ -391,14 +453,24 @@ int rmsgpack_dom_write(int fd, const struct rmsgpack_dom_value *obj)
 }
 
 int rmsgpack_dom_read(int fd, struct rmsgpack_dom_value *out)
+{
+   struct rmsgpack_reader reader;
+
+   rmsgpack_reader_init(&reader, fd, 0);
+   return rmsgpack_dom_reader_read(&reader, out);
+}
+
+int rmsgpack_dom_reader_read(struct rmsgpack_reader *reader,
+      struct rmsgpack_dom_value *out)
 {
    struct dom_reader_state s;
    int rv = 0;
 
    s.i        = 0;
    s.stack[0] = out;
+   s.arena    = NULL;
 
-   rv = rmsgpack_read(fd, &dom_reader_callbacks, &s);
+   rv = rmsgpack_reader_read(reader, &dom_reader_callbacks, &s);
 
    if (rv < 0)
       rmsgpack_dom_value_free(out);
@@ -406,6 +478,18 @@ int rmsgpack_dom_read(int fd, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+int rmsgpack_dom_reader_read_arena(struct rmsgpack_reader *reader,
+      struct rmsgpack_dom_value *out, struct rmsgpack_dom_arena *arena)
+{
+   struct dom_reader_state s;
+
+   s.i        = 0;
+   s.stack[0] = out;
+   s.arena    = arena;
+
+   return rmsgpack_reader_read(reader, &dom_arena_reader_callbacks, &s);
+}
+
 int rmsgpack_dom_read_into(int fd, ...)
 {
    va_list ap;
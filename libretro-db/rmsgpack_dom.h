@@ -1,8 +1,13 @@
 #ifndef __RARCHDB_MSGPACK_DOM_H__
 #define __RARCHDB_MSGPACK_DOM_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <memory/ralloc.h>
+
+#include "rmsgpack.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,6 +69,45 @@ int rmsgpack_dom_read(
         int fd,
         struct rmsgpack_dom_value * out
 );
+int rmsgpack_dom_reader_read(
+        struct rmsgpack_reader * reader,
+        struct rmsgpack_dom_value * out
+);
+
+/* Bump allocator for DOM values. Values read into an arena share its
+ * blocks and are released all at once by resetting or freeing the
+ * arena, never with rmsgpack_dom_value_free(). The blocks are counted
+ * as RALLOC_TAG_DATABASE. */
+struct rmsgpack_dom_arena {
+	struct ralloc_arena base;
+};
+
+struct rmsgpack_dom_arena_mark {
+	struct ralloc_arena_mark base;
+};
+
+void rmsgpack_dom_arena_init(
+        struct rmsgpack_dom_arena * arena,
+        size_t block_size
+);
+void rmsgpack_dom_arena_mark(
+        const struct rmsgpack_dom_arena * arena,
+        struct rmsgpack_dom_arena_mark * mark
+);
+/* Releases everything allocated since @mark was taken. */
+void rmsgpack_dom_arena_rewind(
+        struct rmsgpack_dom_arena * arena,
+        const struct rmsgpack_dom_arena_mark * mark
+);
+/* Releases all values but keeps the first block for reuse. */
+void rmsgpack_dom_arena_reset(struct rmsgpack_dom_arena * arena);
+void rmsgpack_dom_arena_free(struct rmsgpack_dom_arena * arena);
+
+int rmsgpack_dom_reader_read_arena(
+        struct rmsgpack_reader * reader,
+        struct rmsgpack_dom_value * out,
+        struct rmsgpack_dom_arena * arena
+);
 int rmsgpack_dom_write(
         int fd,
         const struct rmsgpack_dom_value * obj
@@ -37,6 +37,11 @@ static struct retro_hw_render_callback hw_render;
 static unsigned width = BASE_WIDTH;
 static unsigned height = BASE_HEIGHT;
 
+// Stress settings, see the testgl_stress_* options. They load the
+// frontend and the driver while the core itself does next to none.
+static unsigned stress_draws = 2;
+static bool stress_size;
+
 static GLuint prog;
 static GLuint vbo;
 
@@ -261,6 +266,8 @@ void retro_set_environment(retro_environment_t cb)
 #ifdef CORE
       { "testgl_multisample", "Multisampling; 1x|2x|4x" },
 #endif
+      { "testgl_stress_draws", "Stress: Draw calls per frame; 2|100|1000|10000" },
+      { "testgl_stress_size", "Stress: Alternate resolution every frame; false|true" },
       { NULL, NULL },
    };
 
@@ -316,6 +323,17 @@ static void update_variables(void)
       fprintf(stderr, "[libretro-test]: Got size: %u x %u.\n", width, height);
    }
 
+   var.key = "testgl_stress_draws";
+   var.value = NULL;
+   stress_draws = 2;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      stress_draws = strtoul(var.value, NULL, 10);
+
+   var.key = "testgl_stress_size";
+   var.value = NULL;
+   stress_size = environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var)
+      && var.value && !strcmp(var.value, "true");
+
 #ifdef CORE
    var.key = "testgl_multisample";
    var.value = NULL;
@@ -356,8 +374,19 @@ void retro_run(void)
 #endif
       glBindFramebuffer(RARCH_GL_FRAMEBUFFER, hw_render.get_current_framebuffer());
 
+   static unsigned frame_count;
+   frame_count++;
+
+   unsigned frame_width  = width;
+   unsigned frame_height = height;
+   if (stress_size && (frame_count & 1))
+   {
+      frame_width  = BASE_WIDTH;
+      frame_height = BASE_HEIGHT;
+   }
+
    glClearColor(0.3, 0.4, 0.5, 1.0);
-   glViewport(0, 0, width, height);
+   glViewport(0, 0, frame_width, frame_height);
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
    glUseProgram(prog);
@@ -375,8 +404,6 @@ void retro_run(void)
 
    int loc = glGetUniformLocation(prog, "uMVP");
 
-   static unsigned frame_count;
-   frame_count++;
    float angle = frame_count / 100.0;
    float cos_angle = cos(angle);
    float sin_angle = sin(angle);
@@ -401,6 +428,23 @@ void retro_run(void)
 
    glUniformMatrix4fv(loc, 1, GL_FALSE, mvp2);
    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+   // Small quads in a grid, each with a draw call and uniform update of its own.
+   for (unsigned i = 2; i < stress_draws; i++)
+   {
+      float x = ((i * 37) % 100) / 50.0f - 1.0f;
+      float y = ((i * 61) % 100) / 50.0f - 1.0f;
+      const GLfloat mvp3[] = {
+         0.05, 0, 0, 0,
+         0, 0.05, 0, 0,
+         0, 0, 1, 0,
+         x, y, 0.1, 1,
+      };
+
+      glUniformMatrix4fv(loc, 1, GL_FALSE, mvp3);
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   }
+
    glDisableVertexAttribArray(vloc);
    glDisableVertexAttribArray(cloc);
 
@@ -412,14 +456,14 @@ void retro_run(void)
    {
       glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
       glBindFramebuffer(GL_DRAW_FRAMEBUFFER, hw_render.get_current_framebuffer());
-      glBlitFramebuffer(0, 0, width, height,
-            0, 0, width, height,
+      glBlitFramebuffer(0, 0, frame_width, frame_height,
+            0, 0, frame_width, frame_height,
             GL_COLOR_BUFFER_BIT, GL_NEAREST);
       glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
       glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
    }
 #endif
-   video_cb(RETRO_HW_FRAME_BUFFER_VALID, width, height, 0);
+   video_cb(RETRO_HW_FRAME_BUFFER_VALID, frame_width, frame_height, 0);
 }
 
 static void context_reset(void)
@@ -6,12 +6,40 @@
 #include <stdio.h>
 #include <stdarg.h>
 
-static uint16_t *frame_buf;
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define MAX_WIDTH 640
+#define MAX_HEIGHT 480
+
+static void *frame_buf;
+static enum retro_pixel_format pixel_format = RETRO_PIXEL_FORMAT_RGB565;
 static struct retro_log_callback logging;
 static bool use_audio_cb;
 static float last_aspect;
 static float last_sample_rate;
 
+// Stress settings, see the test_stress_* options. They make the frontend
+// do as much work as possible while the core itself does next to none,
+// to benchmark frontend overhead with --benchmark.
+enum stress_audio
+{
+   STRESS_AUDIO_SAMPLE = 0, // One audio_cb call per sample.
+   STRESS_AUDIO_BATCH,      // One audio_batch_cb call per video frame.
+   STRESS_AUDIO_BATCH_SINGLE // One audio_batch_cb call per audio frame.
+};
+
+static bool stress_size;
+static enum stress_audio stress_audio;
+static unsigned stress_input;
+static uint8_t *stress_state;
+static size_t stress_state_size;
+static unsigned stress_frame;
+
+// Cycled through every frame with test_stress_size, all within the max geometry.
+static const unsigned stress_sizes[][2] = {
+   { 320, 240 }, { 640, 480 }, { 512, 448 }, { 384, 288 },
+};
+
 static void fallback_log(enum retro_log_level level, const char *fmt, ...)
 {
    (void)level;
@@ -23,13 +51,16 @@ static void fallback_log(enum retro_log_level level, const char *fmt, ...)
 
 void retro_init(void)
 {
-   frame_buf = calloc(320 * 240, sizeof(uint16_t));
+   frame_buf = calloc(MAX_WIDTH * MAX_HEIGHT, sizeof(uint32_t));
 }
 
 void retro_deinit(void)
 {
    free(frame_buf);
    frame_buf = NULL;
+   free(stress_state);
+   stress_state = NULL;
+   stress_state_size = 0;
 }
 
 unsigned retro_api_version(void)
@@ -83,8 +114,8 @@ void retro_get_system_av_info(struct retro_system_av_info *info)
    info->geometry = (struct retro_game_geometry) {
       .base_width   = 320,
       .base_height  = 240,
-      .max_width    = 320,
-      .max_height   = 240,
+      .max_width    = MAX_WIDTH,
+      .max_height   = MAX_HEIGHT,
       .aspect_ratio = aspect,
    };
 
@@ -100,10 +131,15 @@ void retro_set_environment(retro_environment_t cb)
 
    static const struct retro_variable vars[] = {
       { "test_aspect", "Aspect Ratio; 4:3|16:9" },
-      { "test_samplerate", "Sample Rate; 30000|20000" },
+      { "test_samplerate", "Sample Rate; 30000|20000|48000|96000|192000" },
       { "test_opt0", "Test option #0; false|true" },
       { "test_opt1", "Test option #1; 0" },
       { "test_opt2", "Test option #2; 0|1|foo|3" },
+      { "test_stress_size", "Stress: Change frame size every frame; false|true" },
+      { "test_stress_format", "Stress: Pixel format (restart); RGB565|XRGB8888|0RGB1555" },
+      { "test_stress_state", "Stress: Save state size in KB (restart); 0|64|1024|16384" },
+      { "test_stress_audio", "Stress: Audio calls; sample|batch|batch-single" },
+      { "test_stress_input", "Stress: Input queries per frame; 0|1000|10000|100000" },
       { NULL, NULL },
    };
 
@@ -181,6 +217,22 @@ void retro_reset(void)
    y_coord = 0;
 }
 
+// Queries every button and axis of the first eight ports over and over.
+static void stress_input_queries(void)
+{
+   int16_t sink = 0;
+   for (unsigned i = 0; i < stress_input; i++)
+   {
+      unsigned port = (i >> 5) & 7;
+      if (i & 16)
+         sink |= input_state_cb(port, RETRO_DEVICE_ANALOG,
+               (i >> 1) & 1, i & 1);
+      else
+         sink |= input_state_cb(port, RETRO_DEVICE_JOYPAD, 0, i & 15);
+   }
+   (void)sink;
+}
+
 static void update_input(void)
 {
    int dir_x = 0;
@@ -249,6 +301,8 @@ static void update_input(void)
    x_coord = (x_coord + dir_x) & 31;
    y_coord = (y_coord + dir_y) & 31;
 
+   stress_input_queries();
+
    if (rumble.set_rumble_state)
    {
       static bool old_start;
@@ -270,32 +324,96 @@ static void update_input(void)
    }
 }
 
+static inline void put_pixel(uint8_t *line, unsigned x, uint32_t color)
+{
+   if (pixel_format == RETRO_PIXEL_FORMAT_XRGB8888)
+      ((uint32_t*)line)[x] = color;
+   else
+      ((uint16_t*)line)[x] = color;
+}
+
 static void render_checkered(void)
 {
-   uint16_t color_r = 31 << 11;
-   uint16_t color_g = 63 <<  5;
+   unsigned width    = 320;
+   unsigned height   = 240;
+   unsigned bpp      = pixel_format == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+   uint32_t color_r  = 31 << 11;
+   uint32_t color_g  = 63 <<  5;
+   uint32_t color_b  = 0x1f;
+
+   if (pixel_format == RETRO_PIXEL_FORMAT_XRGB8888)
+   {
+      color_r = 0xff0000;
+      color_g = 0x00ff00;
+      color_b = 0x0000ff;
+   }
+   else if (pixel_format == RETRO_PIXEL_FORMAT_0RGB1555)
+   {
+      color_r = 31 << 10;
+      color_g = 31 <<  5;
+   }
 
-   uint16_t *line = frame_buf;
-   for (unsigned y = 0; y < 240; y++, line += 320)
+   if (stress_size)
+   {
+      width  = stress_sizes[stress_frame % ARRAY_SIZE(stress_sizes)][0];
+      height = stress_sizes[stress_frame % ARRAY_SIZE(stress_sizes)][1];
+   }
+
+   /* Try rendering straight into the frontend's framebuffer. */
+   struct retro_framebuffer fb = {0};
+   uint8_t *buf      = frame_buf;
+   size_t pitch      = width * bpp;
+   fb.width          = width;
+   fb.height         = height;
+   fb.access_flags   = RETRO_MEMORY_ACCESS_WRITE;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb)
+         && fb.format == pixel_format)
+   {
+      buf   = (uint8_t*)fb.data;
+      pitch = fb.pitch;
+   }
+
+   uint8_t *line = buf;
+   for (unsigned y = 0; y < height; y++, line += pitch)
    {
       unsigned index_y = ((y - y_coord) >> 4) & 1;
-      for (unsigned x = 0; x < 320; x++)
+      for (unsigned x = 0; x < width; x++)
       {
          unsigned index_x = ((x - x_coord) >> 4) & 1;
-         line[x] = (index_y ^ index_x) ? color_r : color_g;
+         put_pixel(line, x, (index_y ^ index_x) ? color_r : color_g);
       }
    }
 
    for (unsigned y = mouse_rel_y - 5; y <= mouse_rel_y + 5; y++)
       for (unsigned x = mouse_rel_x - 5; x <= mouse_rel_x + 5; x++)
-         frame_buf[y * 320 + x] = 0x1f;
+         put_pixel(buf + y * pitch, x, color_b);
 
-   video_cb(frame_buf, 320, 240, 320 << 1);
+   video_cb(buf, width, height, pitch);
 }
 
 static void check_variables(void)
 {
    struct retro_variable var = {0};
+
+   var.key = "test_stress_size";
+   stress_size = environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var)
+      && var.value && !strcmp(var.value, "true");
+
+   stress_audio = STRESS_AUDIO_SAMPLE;
+   var.key = "test_stress_audio";
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "batch"))
+         stress_audio = STRESS_AUDIO_BATCH;
+      else if (!strcmp(var.value, "batch-single"))
+         stress_audio = STRESS_AUDIO_BATCH_SINGLE;
+   }
+
+   stress_input = 0;
+   var.key = "test_stress_input";
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      stress_input = strtoul(var.value, NULL, 10);
+
    var.key = "test_opt0";
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
       logging.log(RETRO_LOG_INFO, "Key -> Val: %s -> %s.\n", var.key, var.value);
@@ -329,12 +447,28 @@ static void check_variables(void)
 
 static void audio_callback(void)
 {
-   for (unsigned i = 0; i < 30000 / 60; i++, phase++)
+   static int16_t samples[2 * 192000 / 60];
+   unsigned frames = last_sample_rate / 60.0f;
+
+   if (frames > ARRAY_SIZE(samples) / 2)
+      frames = ARRAY_SIZE(samples) / 2;
+
+   for (unsigned i = 0; i < frames; i++, phase++)
    {
       int16_t val = 0x800 * sinf(2.0f * M_PI * phase * 300.0f / 30000.0f);
-      audio_cb(val, val);
+
+      if (stress_audio == STRESS_AUDIO_SAMPLE)
+         audio_cb(val, val);
+      samples[2 * i + 0] = val;
+      samples[2 * i + 1] = val;
    }
 
+   if (stress_audio == STRESS_AUDIO_BATCH)
+      audio_batch_cb(samples, frames);
+   else if (stress_audio == STRESS_AUDIO_BATCH_SINGLE)
+      for (unsigned i = 0; i < frames; i++)
+         audio_batch_cb(samples + 2 * i, 1);
+
    phase %= 100;
 }
 
@@ -343,8 +477,29 @@ static void audio_set_state(bool enable)
    (void)enable;
 }
 
+// Rewrites a sixteenth of the save state every frame, with noise,
+// so rewind and netplay see states which never compress well.
+static void stress_state_update(void)
+{
+   static uint32_t seed = 1;
+   size_t chunk = stress_state_size / 16;
+   uint8_t *data = stress_state + (stress_frame % 16) * chunk;
+
+   for (size_t i = 0; i < chunk; i++)
+   {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      data[i] = seed;
+   }
+}
+
 void retro_run(void)
 {
+   stress_frame++;
+   if (stress_state)
+      stress_state_update();
+
    update_input();
    render_checkered();
    if (!use_audio_cb)
@@ -375,12 +530,36 @@ bool retro_load_game(const struct retro_game_info *info)
 
    environ_cb(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc);
 
+   // The pixel format and save state size can't change while running.
+   struct retro_variable var = { .key = "test_stress_format" };
    enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_RGB565;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "XRGB8888"))
+         fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+      else if (!strcmp(var.value, "0RGB1555"))
+         fmt = RETRO_PIXEL_FORMAT_0RGB1555;
+   }
+
    if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
    {
-      logging.log(RETRO_LOG_INFO, "RGB565 is not supported.\n");
+      logging.log(RETRO_LOG_INFO, "Pixel format %d is not supported.\n", fmt);
       return false;
    }
+   pixel_format = fmt;
+
+   free(stress_state);
+   stress_state      = NULL;
+   stress_state_size = 0;
+   var.key = "test_stress_state";
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      stress_state_size = strtoul(var.value, NULL, 10) * 1024;
+   if (stress_state_size)
+   {
+      stress_state = calloc(stress_state_size, 1);
+      if (!stress_state)
+         stress_state_size = 0;
+   }
 
    struct retro_keyboard_callback cb = { keyboard_cb };
    environ_cb(RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK, &cb);
@@ -420,28 +599,32 @@ bool retro_load_game_special(unsigned type, const struct retro_game_info *info,
 
 size_t retro_serialize_size(void)
 {
-   return 2;
+   return 2 + stress_state_size;
 }
 
 bool retro_serialize(void *data_, size_t size)
 {
-   if (size < 2)
+   if (size < 2 + stress_state_size)
       return false;
 
    uint8_t *data = data_;
    data[0] = x_coord;
    data[1] = y_coord;
+   if (stress_state_size)
+      memcpy(data + 2, stress_state, stress_state_size);
    return true;
 }
 
 bool retro_unserialize(const void *data_, size_t size)
 {
-   if (size < 2)
+   if (size < 2 + stress_state_size)
       return false;
 
    const uint8_t *data = data_;
    x_coord = data[0] & 31;
    y_coord = data[1] & 31;
+   if (stress_state_size)
+      memcpy(stress_state, data + 2, stress_state_size);
    return true;
 }
 
@@ -59,6 +59,18 @@
                                             * path to game is passed in 
                                             * _EXEC. NULL means no game.
                                             */
+#define RETRO_ENVIRONMENT_SET_CHEAT_INCREMENTAL (RETRO_ENVIRONMENT_PRIVATE | 3)
+                                           /* const bool * --
+                                            * If true, the core applies each retro_cheat_set() call on
+                                            * its own, without re-applying the other codes. The frontend
+                                            * may then call retro_cheat_set() only for codes which were
+                                            * enabled, disabled or edited, with enabled set to false to
+                                            * remove a code, and index staying the same for a code as
+                                            * long as retro_cheat_reset() is not called.
+                                            *
+                                            * Otherwise, the frontend calls retro_cheat_reset() and then
+                                            * retro_cheat_set() for every enabled code whenever one changes.
+                                            */
 
 
 #endif
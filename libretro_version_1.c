@@ -32,15 +32,36 @@
 #include "performance.h"
 #include "input/keyboard_line.h"
 #include "input/input_remapping.h"
+#include "input/input_latency.h"
 #include "audio/audio_utils.h"
+#include "audio/audio_thread_wrapper.h"
 #include "retroarch_logger.h"
 #include "record/record_driver.h"
+#include "gfx/video_pixel_converter.h"
+#include "gfx/video_monitor.h"
 #include "intl/intl.h"
 
+#ifdef HAVE_SHM
+#include "shm_export.h"
+#endif
+
 #ifdef HAVE_NETPLAY
 #include "netplay.h"
 #endif
 
+#ifdef HAVE_LIBCO
+#include <libco.h>
+#endif
+
+/* Cleared while frames are run that aren't meant to be seen or
+ * heard, see retro_set_frame_output(). */
+static bool retro_output_video = true;
+static bool retro_output_audio = true;
+
+/* Set while a fast forwarded frame runs which comes too soon
+ * to be shown, see retro_set_frame_skip(). */
+static bool retro_skip_output;
+
 static bool video_frame_scale(const void *data,
       unsigned width, unsigned height,
       size_t pitch)
@@ -66,7 +87,7 @@ static bool video_frame_scale(const void *data,
    driver->scaler.in_stride     = pitch;
    driver->scaler.out_stride    = width * sizeof(uint16_t);
 
-   scaler_ctx_scale(&driver->scaler, driver->scaler_out, data);
+   video_pixel_scale(driver->scaler_out, data);
 
    RARCH_PERFORMANCE_STOP(video_frame_conv);
    
@@ -120,19 +141,41 @@ static void video_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
    unsigned output_width  = 0, output_height = 0, output_pitch = 0;
+   const void *flash_frame = NULL;
    const char *msg      = NULL;
+   runloop_t *runloop   = rarch_main_get_ptr();
    driver_t  *driver    = driver_get_ptr();
    global_t  *global    = global_get_ptr();
    settings_t *settings = config_get_ptr();
+   retro_time_t start_usec;
+   enum rarch_zone zone;
+
+   RARCH_PERFORMANCE_INIT(video_frame_total);
 
-   if (!driver->video_active)
+   if (!driver->video_active || !retro_output_video || retro_skip_output)
       return;
 
+#ifdef HAVE_SHM
+   shm_export_video(data, width, height, pitch);
+#endif
+
+   RARCH_PERFORMANCE_START(video_frame_total);
+   start_usec = rarch_get_time_usec();
+   zone       = rarch_zone_enter(RARCH_ZONE_VIDEO);
+
+   if (settings->video.frame_delay_auto && 
+         !runloop->frames.delay.video_time)
+      runloop->frames.delay.video_time = rarch_get_time_usec();
+
    global->frame_cache.data   = data;
    global->frame_cache.width  = width;
    global->frame_cache.height = height;
    global->frame_cache.pitch  = pitch;
 
+   flash_frame = input_latency_frame(height, pitch);
+   if (flash_frame && data && data != RETRO_HW_FRAME_BUFFER_VALID)
+      data = flash_frame;
+
    if (video_frame_scale(data, width, height, pitch))
    {
       data                        = driver->scaler_out;
@@ -164,103 +207,130 @@ static void video_frame(const void *data, unsigned width,
 
    if (!video_driver_frame(data, width, height, pitch, msg))
       driver->video_active = false;
+
+   rarch_zone_enter(zone);
+   video_monitor_frame_time_add(VIDEO_MONITOR_STAGE_PRESENT,
+         rarch_get_time_usec() - start_usec);
+   RARCH_PERFORMANCE_STOP(video_frame_total);
 }
 
 /**
- * retro_flush_audio:
+ * retro_process_audio:
  * @data                 : pointer to audio buffer.
- * @right                : amount of samples to write.
+ * @samples              : amount of samples to write.
+ *
+ * Performs DSP processing (if enabled) and resampling, and
+ * writes the result to the audio driver.
  *
- * Writes audio samples to audio driver. Will first
- * perform DSP processing (if enabled) and resampling.
+ * Samples go through every stage AUDIO_BLOCK_FRAMES at a time,
+ * so only the final output is ever held in full.
  *
  * Returns: true (1) if audio samples were written to the audio
  * driver, false (0) in case of an error.
  **/
-bool retro_flush_audio(const int16_t *data, size_t samples)
+bool retro_process_audio(const int16_t *data, size_t samples)
 {
+   size_t i, frames;
+   bool   written                = false;
+   bool   convert_blocks         = false;
    const void *output_data        = NULL;
-   unsigned output_frames         = 0;
+   size_t   output_frames         = 0;
    size_t   output_size           = sizeof(float);
-   struct resampler_data src_data = {0};
-   struct rarch_dsp_data dsp_data = {0};
+   double   ratio                 = 0.0;
    runloop_t *runloop             = rarch_main_get_ptr();
    driver_t  *driver              = driver_get_ptr();
    global_t  *global              = global_get_ptr();
    settings_t *settings           = config_get_ptr();
+   RARCH_PERFORMANCE_INIT(audio_flush);
 
-   if (driver->recording_data)
-   {
-      struct ffemu_audio_data ffemu_data = {0};
-      ffemu_data.data                    = data;
-      ffemu_data.frames                  = samples / 2;
-
-      if (driver->recording && driver->recording->push_audio)
-         driver->recording->push_audio(driver->recording_data, &ffemu_data);
-   }
+   RARCH_PERFORMANCE_START(audio_flush);
 
-   if (runloop->is_paused || settings->audio.mute_enable)
-      return true;
-   if (!driver->audio_active || !global->audio_data.data)
-      return false;
+   if (global->audio_data.rate_control)
+      audio_driver_readjust_input_rate();
 
-   RARCH_PERFORMANCE_INIT(audio_convert_s16);
-   RARCH_PERFORMANCE_START(audio_convert_s16);
-   audio_convert_s16_to_float(global->audio_data.data, data, samples,
-         global->audio_data.volume_gain);
-   RARCH_PERFORMANCE_STOP(audio_convert_s16);
+   ratio = global->audio_data.src_ratio;
+   if (runloop->is_slowmotion)
+      ratio *= settings->slowmotion_ratio;
 
-   src_data.data_in               = global->audio_data.data;
-   src_data.input_frames          = samples >> 1;
+   /* s16 output is converted block by block into conv_outsamples. */
+   convert_blocks = !global->audio_data.use_float;
 
-   dsp_data.input                 = global->audio_data.data;
-   dsp_data.input_frames          = samples >> 1;
+   frames = samples >> 1;
 
-   if (global->audio_data.dsp)
+   for (i = 0; i < frames; i += AUDIO_BLOCK_FRAMES)
    {
-      RARCH_PERFORMANCE_INIT(audio_dsp);
-      RARCH_PERFORMANCE_START(audio_dsp);
-      rarch_dsp_filter_process(global->audio_data.dsp, &dsp_data);
-      RARCH_PERFORMANCE_STOP(audio_dsp);
+      struct resampler_data src_data = {0};
+      struct rarch_dsp_data dsp_data = {0};
+      size_t block                   = frames - i;
+
+      if (block > AUDIO_BLOCK_FRAMES)
+         block = AUDIO_BLOCK_FRAMES;
+
+      RARCH_PERFORMANCE_INIT(audio_convert_s16);
+      RARCH_PERFORMANCE_START(audio_convert_s16);
+      audio_convert_s16_to_float(global->audio_data.data, data + i * 2,
+            block * 2, global->audio_data.volume_gain);
+      RARCH_PERFORMANCE_STOP(audio_convert_s16);
 
-      if (dsp_data.output)
+      src_data.data_in               = global->audio_data.data;
+      src_data.input_frames          = block;
+
+      dsp_data.input                 = global->audio_data.data;
+      dsp_data.input_frames          = block;
+
+      if (global->audio_data.dsp)
       {
-         src_data.data_in      = dsp_data.output;
-         src_data.input_frames = dsp_data.output_frames;
+         RARCH_PERFORMANCE_INIT(audio_dsp);
+         RARCH_PERFORMANCE_START(audio_dsp);
+         rarch_dsp_filter_process(global->audio_data.dsp, &dsp_data);
+         RARCH_PERFORMANCE_STOP(audio_dsp);
+
+         if (dsp_data.output)
+         {
+            src_data.data_in      = dsp_data.output;
+            src_data.input_frames = dsp_data.output_frames;
+         }
       }
-   }
 
-   src_data.data_out = global->audio_data.outsamples;
+      /* Converted blocks reuse the head of outsamples as scratch. */
+      src_data.data_out = global->audio_data.outsamples;
+      if (!convert_blocks)
+         src_data.data_out += output_frames * 2;
+      src_data.ratio    = ratio;
 
-   if (global->audio_data.rate_control)
-      audio_driver_readjust_input_rate();
+      RARCH_PERFORMANCE_INIT(resampler_proc);
+      RARCH_PERFORMANCE_START(resampler_proc);
+      rarch_resampler_process(driver->resampler,
+            driver->resampler_data, &src_data);
+      RARCH_PERFORMANCE_STOP(resampler_proc);
 
-   src_data.ratio = global->audio_data.src_ratio;
-   if (runloop->is_slowmotion)
-      src_data.ratio *= settings->slowmotion_ratio;
+      if (convert_blocks)
+      {
+         RARCH_PERFORMANCE_INIT(audio_convert_float);
+         RARCH_PERFORMANCE_START(audio_convert_float);
+         audio_convert_float_to_s16(
+               global->audio_data.conv_outsamples + output_frames * 2,
+               src_data.data_out, src_data.output_frames * 2);
+         RARCH_PERFORMANCE_STOP(audio_convert_float);
+      }
 
-   RARCH_PERFORMANCE_INIT(resampler_proc);
-   RARCH_PERFORMANCE_START(resampler_proc);
-   rarch_resampler_process(driver->resampler,
-         driver->resampler_data, &src_data);
-   RARCH_PERFORMANCE_STOP(resampler_proc);
+      output_frames += src_data.output_frames;
+   }
 
-   output_data   = global->audio_data.outsamples;
-   output_frames = src_data.output_frames;
+   output_data = global->audio_data.outsamples;
 
-   if (!global->audio_data.use_float)
+   if (convert_blocks)
    {
-      RARCH_PERFORMANCE_INIT(audio_convert_float);
-      RARCH_PERFORMANCE_START(audio_convert_float);
-      audio_convert_float_to_s16(global->audio_data.conv_outsamples,
-            (const float*)output_data, output_frames * 2);
-      RARCH_PERFORMANCE_STOP(audio_convert_float);
-
       output_data = global->audio_data.conv_outsamples;
       output_size = sizeof(int16_t);
    }
 
-   if (audio_driver_write(output_data, output_frames * output_size * 2) < 0)
+   written = audio_driver_write(output_data,
+         output_frames * output_size * 2) >= 0;
+
+   RARCH_PERFORMANCE_STOP(audio_flush);
+
+   if (!written)
    {
       RARCH_ERR(RETRO_LOG_AUDIO_WRITE_FAILED);
 
@@ -271,26 +341,148 @@ bool retro_flush_audio(const int16_t *data, size_t samples)
    return true;
 }
 
+/**
+ * retro_flush_audio:
+ * @data                 : pointer to audio buffer.
+ * @samples              : amount of samples to write.
+ *
+ * Hands audio samples to the recording driver, then
+ * to retro_process_audio(), or to the audio thread
+ * when DSP and resampling run there.
+ *
+ * Returns: true (1) if audio samples were written to the audio
+ * driver, false (0) in case of an error.
+ **/
+bool retro_flush_audio(const int16_t *data, size_t samples)
+{
+   enum rarch_zone zone;
+   bool       ret                 = false;
+   runloop_t *runloop             = rarch_main_get_ptr();
+   driver_t  *driver              = driver_get_ptr();
+   global_t  *global              = global_get_ptr();
+   settings_t *settings           = config_get_ptr();
+
+   if (driver->recording_data)
+   {
+      struct ffemu_audio_data ffemu_data = {0};
+      ffemu_data.data                    = data;
+      ffemu_data.frames                  = samples / 2;
+
+      if (driver->recording && driver->recording->push_audio)
+         driver->recording->push_audio(driver->recording_data, &ffemu_data);
+   }
+
+   if (runloop->is_paused || settings->audio.mute_enable)
+      return true;
+   if (!driver->audio_active || !global->audio_data.data)
+      return false;
+
+#ifdef HAVE_THREADS
+   if (global->audio_data.threaded_dsp)
+   {
+      /* Pacing comes from the queue filling up, as long as
+       * the driver itself would block. */
+      audio_thread_dsp_push(data, samples,
+            driver->nonblock_state || !settings->audio.sync);
+      return true;
+   }
+#endif
+
+   zone = rarch_zone_enter(RARCH_ZONE_AUDIO);
+   ret  = retro_process_audio(data, samples);
+   rarch_zone_enter(zone);
+
+   return ret;
+}
+
+/**
+ * audio_rewind_history_push:
+ * @data                 : pointer to audio samples.
+ * @samples              : amount of samples (not frames) in @data.
+ *
+ * Keeps forward audio around, so it can be played 
+ * back in reverse while rewinding.
+ **/
+static INLINE void audio_rewind_history_push(const int16_t *data,
+      size_t samples)
+{
+   size_t i;
+   global_t *global = global_get_ptr();
+   int16_t *history = global->audio_data.rewind_history;
+   size_t size      = global->audio_data.rewind_history_size;
+   size_t ptr       = global->audio_data.rewind_history_ptr;
+
+   if (!history || !global->rewind.state)
+      return;
+
+   for (i = 0; i < samples; i++)
+   {
+      history[ptr] = data[i];
+      if (++ptr == size)
+         ptr = 0;
+   }
+
+   global->audio_data.rewind_history_ptr    = ptr;
+   global->audio_data.rewind_history_avail += samples;
+   if (global->audio_data.rewind_history_avail > size)
+      global->audio_data.rewind_history_avail = size;
+}
+
+/**
+ * retro_flush_audio_samples:
+ * @force                : flush even if less than a chunk is pending.
+ *
+ * Writes out the samples audio_sample() has batched up. Called
+ * at the end of every retro_run(), which only flushes once a chunk
+ * (audio_data.chunk_size) is pending, so fast-forwarding still
+ * writes large enough pieces to the audio driver.
+ **/
+void retro_flush_audio_samples(bool force)
+{
+   global_t *global = global_get_ptr();
+   size_t samples   = global->audio_data.data_ptr;
+   RARCH_PERFORMANCE_INIT(audio_sample_flush);
+
+   if (!samples || (!force && samples < global->audio_data.chunk_size))
+      return;
+
+   RARCH_PERFORMANCE_START(audio_sample_flush);
+
+   audio_rewind_history_push(global->audio_data.sample_buf, samples);
+   retro_flush_audio(global->audio_data.sample_buf, samples);
+   global->audio_data.data_ptr = 0;
+
+   RARCH_PERFORMANCE_STOP(audio_sample_flush);
+}
+
 /**
  * audio_sample:
  * @left                 : value of the left audio channel.
  * @right                : value of the right audio channel.
  *
- * Audio sample render callback function.
+ * Audio sample render callback function. Only appends
+ * to audio_data.sample_buf, which is flushed once per frame
+ * by retro_flush_audio_samples(), or early if it fills up.
  **/
 static void audio_sample(int16_t left, int16_t right)
 {
    global_t *global = global_get_ptr();
+   int16_t *out     = global->audio_data.sample_buf +
+      global->audio_data.data_ptr;
 
-   global->audio_data.conv_outsamples[global->audio_data.data_ptr++] = left;
-   global->audio_data.conv_outsamples[global->audio_data.data_ptr++] = right;
-
-   if (global->audio_data.data_ptr < global->audio_data.chunk_size)
+   if (!retro_output_audio || retro_skip_output)
       return;
 
-   retro_flush_audio(global->audio_data.conv_outsamples, global->audio_data.data_ptr);
+   out[0] = left;
+   out[1] = right;
 
-   global->audio_data.data_ptr = 0;
+#ifdef HAVE_SHM
+   shm_export_audio(out, 2);
+#endif
+
+   global->audio_data.data_ptr += 2;
+   if (global->audio_data.data_ptr >= global->audio_data.sample_buf_size)
+      retro_flush_audio_samples(true);
 }
 
 /**
@@ -305,9 +497,20 @@ static void audio_sample(int16_t left, int16_t right)
  **/
 static size_t audio_sample_batch(const int16_t *data, size_t frames)
 {
+   if (!retro_output_audio || retro_skip_output)
+      return frames;
+
    if (frames > (AUDIO_CHUNK_SIZE_NONBLOCKING >> 1))
       frames = AUDIO_CHUNK_SIZE_NONBLOCKING >> 1;
 
+   /* Keep the order if a core mixes both callbacks. */
+   retro_flush_audio_samples(true);
+
+#ifdef HAVE_SHM
+   shm_export_audio(data, frames << 1);
+#endif
+
+   audio_rewind_history_push(data, frames << 1);
    retro_flush_audio(data, frames << 1);
 
    return frames;
@@ -320,11 +523,16 @@ static size_t audio_sample_batch(const int16_t *data, size_t frames)
  *
  * Audio sample render callback function (rewind version). This callback
  * function will be used instead of audio_sample when rewinding is activated.
+ * Like audio_sample_batch_rewind, it drops what does not fit in rewind_buf.
  **/
 static void audio_sample_rewind(int16_t left, int16_t right)
 {
    global_t *global = global_get_ptr();
 
+   if (global->audio_data.rewind_from_history
+         || global->audio_data.rewind_ptr < 2)
+      return;
+
    global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] = right;
    global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] = left;
 }
@@ -346,6 +554,12 @@ static size_t audio_sample_batch_rewind(const int16_t *data, size_t frames)
    size_t samples   = frames << 1;
    global_t *global = global_get_ptr();
 
+   if (global->audio_data.rewind_from_history)
+      return frames;
+
+   if (samples > global->audio_data.rewind_ptr)
+      samples = global->audio_data.rewind_ptr;
+
    for (i = 0; i < samples; i++)
       global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] = data[i];
 
@@ -385,6 +599,115 @@ static bool input_apply_turbo(unsigned port, unsigned id, bool res)
    return res;
 }
 
+static void input_poll_core(void);
+
+#ifdef HAVE_LIBCO
+/* Cores may recurse as deep as on a main thread. */
+#define RETRO_COROUTINE_STACK_SIZE (8 * 1024 * 1024)
+
+static cothread_t retro_main_thread;
+static cothread_t retro_core_thread;
+static bool retro_core_frame_done;
+
+/* Suspend the core at its next input poll. */
+static bool retro_core_yield_on_poll;
+
+static void retro_core_thread_entry(void)
+{
+   for (;;)
+   {
+      pretro_run();
+      retro_core_frame_done = true;
+      co_switch(retro_main_thread);
+   }
+}
+#endif
+
+/* Set while input_poll_deferred holds back a poll the core asked for. */
+static bool input_poll_pending;
+
+/* Set from a core poll until the core first queries input. */
+static bool input_poll_unread;
+static struct retro_perf_counter input_poll_to_read = {"input_poll_to_read"};
+
+/* Joypad buttons and analog axes of every user, as reported by
+ * the input driver. Each port is fetched on its first query after
+ * input_poll(), the rest of the frame is served from here. */
+static struct
+{
+   uint32_t buttons_valid;
+   uint32_t analog_valid;
+   uint16_t buttons[MAX_USERS];
+   int16_t  analog[MAX_USERS][4];
+} input_snapshot;
+
+/**
+ * input_snapshot_state:
+ * @binds                : keybinds of all users.
+ * @port                 : user number.
+ * @device               : device identifier of user.
+ * @idx                  : index value of user.
+ * @id                   : identifier of key pressed by user.
+ *
+ * Looks up joypad buttons and analog axes in the snapshot,
+ * filling the snapshot of @port on first use.
+ * Anything else is forwarded to the input driver.
+ *
+ * Returns: input state as input_driver_state() would.
+ **/
+static int16_t input_snapshot_state(const struct retro_keybind **binds,
+      unsigned port, unsigned device, unsigned idx, unsigned id)
+{
+   unsigned i;
+
+   if (port >= MAX_USERS)
+      return input_driver_state(binds, port, device, idx, id);
+
+   switch (device)
+   {
+      case RETRO_DEVICE_JOYPAD:
+         if (id > RETRO_DEVICE_ID_JOYPAD_R3)
+            break;
+
+         if (!(input_snapshot.buttons_valid & (1 << port)))
+         {
+            RARCH_PERFORMANCE_INIT(input_snapshot_buttons);
+            RARCH_PERFORMANCE_START(input_snapshot_buttons);
+
+            input_snapshot.buttons[port] = 0;
+            for (i = 0; i <= RETRO_DEVICE_ID_JOYPAD_R3; i++)
+               if (input_driver_state(binds, port, device, 0, i))
+                  input_snapshot.buttons[port] |= 1 << i;
+            input_snapshot.buttons_valid |= 1 << port;
+
+            RARCH_PERFORMANCE_STOP(input_snapshot_buttons);
+         }
+
+         return (input_snapshot.buttons[port] >> id) & 1;
+      case RETRO_DEVICE_ANALOG:
+         if (idx > RETRO_DEVICE_INDEX_ANALOG_RIGHT ||
+               id > RETRO_DEVICE_ID_ANALOG_Y)
+            break;
+
+         if (!(input_snapshot.analog_valid & (1 << port)))
+         {
+            RARCH_PERFORMANCE_INIT(input_snapshot_analog);
+            RARCH_PERFORMANCE_START(input_snapshot_analog);
+
+            for (i = 0; i < 4; i++)
+               input_snapshot.analog[port][i] = input_driver_state(
+                     binds, port, device, i >> 1, i & 1);
+            input_snapshot.analog_valid |= 1 << port;
+
+            RARCH_PERFORMANCE_STOP(input_snapshot_analog);
+         }
+
+         return input_snapshot.analog[port][idx * 2 + id];
+   }
+
+   return input_driver_state(binds, port, device, idx, id);
+}
+
 /**
  * input_state:
  * @port                 : user number.
@@ -423,6 +746,18 @@ static int16_t input_state(unsigned port, unsigned device,
       settings->input.binds[15],
    };
 
+   if (input_poll_pending)
+   {
+      input_poll_pending = false;
+      input_poll_core();
+   }
+
+   if (input_poll_unread)
+   {
+      RARCH_PERFORMANCE_STOP(input_poll_to_read);
+      input_poll_unread = false;
+   }
+
    device &= RETRO_DEVICE_MASK;
 
    if (global->bsv.movie && global->bsv.movie_playback)
@@ -441,7 +776,8 @@ static int16_t input_state(unsigned port, unsigned device,
 
    {
       if (((id < RARCH_FIRST_META_KEY) || (device == RETRO_DEVICE_KEYBOARD)))
-         res = input_driver_state(libretro_input_binds, port, device, idx, id);
+         res = input_snapshot_state(libretro_input_binds,
+               port, device, idx, id);
 
 #ifdef HAVE_OVERLAY
       if (port == 0)
@@ -637,9 +973,13 @@ static void input_poll(void)
 {
    driver_t *driver               = driver_get_ptr();
    settings_t *settings           = config_get_ptr();
+   enum rarch_zone zone           = rarch_zone_enter(RARCH_ZONE_INPUT);
 
    input_driver_poll();
 
+   input_snapshot.buttons_valid = 0;
+   input_snapshot.analog_valid  = 0;
+
 #ifdef HAVE_OVERLAY
    if (driver->overlay)
       input_poll_overlay(driver->overlay,
@@ -650,6 +990,197 @@ static void input_poll(void)
    if (driver->command)
       rarch_cmd_poll(driver->command);
 #endif
+
+   rarch_zone_enter(zone);
+}
+
+/**
+ * input_poll_core:
+ *
+ * Input polling callback function of the core.
+ * Starts timing the poll until the core reads input.
+ **/
+static void input_poll_core(void)
+{
+#ifdef HAVE_LIBCO
+   if (retro_core_yield_on_poll && co_active() == retro_core_thread)
+   {
+      retro_core_yield_on_poll = false;
+      co_switch(retro_main_thread);
+   }
+#endif
+
+   input_poll();
+
+   if (input_latency_active())
+   {
+      settings_t *settings = config_get_ptr();
+      const struct retro_keybind *binds[MAX_USERS] = {
+         settings->input.binds[0],
+      };
+
+      input_snapshot_state(binds, 0, RETRO_DEVICE_JOYPAD, 0, 0);
+      input_latency_poll(input_snapshot.buttons[0]);
+   }
+
+   if (!input_poll_to_read.registered)
+      rarch_perf_register(&input_poll_to_read);
+
+   RARCH_PERFORMANCE_START(input_poll_to_read);
+   input_poll_unread = true;
+}
+
+/**
+ * input_poll_deferred:
+ *
+ * Input polling callback function of the core with input_poll_late.
+ * Holds back the poll until the core's first input_state query.
+ **/
+static void input_poll_deferred(void)
+{
+   input_poll_pending = true;
+}
+
+/**
+ * retro_flush_input_poll:
+ *
+ * Performs an input poll the core asked for, but which
+ * input_poll_deferred held back and the core never caught up on
+ * by querying input.
+ **/
+void retro_flush_input_poll(void)
+{
+   if (!input_poll_pending)
+      return;
+
+   input_poll_pending = false;
+   input_poll();
+}
+
+/**
+ * retro_coroutine_init:
+ *
+ * Creates the coroutine retro_coroutine_run() runs the core on,
+ * unless it exists already.
+ *
+ * Returns: true (1) if the core can run on a coroutine,
+ * otherwise false (0).
+ **/
+bool retro_coroutine_init(void)
+{
+#ifdef HAVE_LIBCO
+   if (retro_core_thread)
+      return true;
+
+   retro_main_thread     = co_active();
+   retro_core_thread     = co_create(RETRO_COROUTINE_STACK_SIZE,
+         retro_core_thread_entry);
+   retro_core_frame_done = true;
+
+   if (!retro_core_thread)
+   {
+      RARCH_ERR("Failed to create core coroutine.\n");
+      return false;
+   }
+
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * retro_coroutine_deinit:
+ *
+ * Frees the core's coroutine. Must not be called while the core
+ * is suspended mid-frame.
+ **/
+void retro_coroutine_deinit(void)
+{
+#ifdef HAVE_LIBCO
+   if (!retro_core_thread)
+      return;
+
+   co_delete(retro_core_thread);
+   retro_core_thread        = NULL;
+   retro_core_yield_on_poll = false;
+#endif
+}
+
+/**
+ * retro_coroutine_run:
+ * @yield_on_poll  : suspend the core when it polls input.
+ *
+ * Runs a frame of the core on its coroutine, or resumes the one
+ * suspended at its input poll. The core is suspended at most once
+ * per call, and only at a poll it asked for itself.
+ *
+ * Returns: true (1) when the frame is done, false (0) if the
+ * core was suspended.
+ **/
+bool retro_coroutine_run(bool yield_on_poll)
+{
+#ifdef HAVE_LIBCO
+   if (!retro_core_thread)
+   {
+      pretro_run();
+      return true;
+   }
+
+   retro_core_frame_done    = false;
+   retro_core_yield_on_poll = yield_on_poll;
+   co_switch(retro_core_thread);
+   retro_core_yield_on_poll = false;
+
+   return retro_core_frame_done;
+#else
+   pretro_run();
+   return true;
+#endif
+}
+
+/**
+ * retro_set_frame_output:
+ * @video          : show the frames the core renders.
+ * @audio          : play the audio the core renders.
+ *
+ * Lets the core run frames which are not shown or heard,
+ * e.g. to run ahead of what the user sees.
+ **/
+void retro_set_frame_output(bool video, bool audio)
+{
+   retro_output_video = video;
+   retro_output_audio = audio;
+}
+
+/**
+ * retro_set_frame_skip:
+ * @skip           : neither show nor play the frame about to run.
+ *
+ * Drops the output of a frame on top of retro_set_frame_output(),
+ * before any conversion, filtering or resampling is done.
+ **/
+void retro_set_frame_skip(bool skip)
+{
+   retro_skip_output = skip;
+}
+
+/**
+ * retro_get_audio_video_enable:
+ *
+ * Returns: output the frontend will use of the frame about to
+ * run, as for RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE.
+ * Bit 0 is set if it is shown, bit 1 if it is heard.
+ **/
+int retro_get_audio_video_enable(void)
+{
+   int enable = 0;
+
+   if (retro_output_video && !retro_skip_output)
+      enable |= 1;
+   if (retro_output_audio && !retro_skip_output)
+      enable |= 2;
+   return enable;
 }
 
 /**
@@ -682,8 +1213,9 @@ void retro_set_default_callbacks(void *data)
 void retro_init_libretro_cbs(void *data)
 {
    struct retro_callbacks *cbs = (struct retro_callbacks*)data;
-   driver_t *driver = driver_get_ptr();
-   global_t *global = global_get_ptr();
+   driver_t *driver     = driver_get_ptr();
+   global_t *global     = global_get_ptr();
+   settings_t *settings = config_get_ptr();
 
    if (!cbs)
       return;
@@ -691,11 +1223,18 @@ void retro_init_libretro_cbs(void *data)
    (void)driver;
    (void)global;
 
+   input_poll_pending = false;
+   input_poll_unread  = false;
+   retro_output_video = true;
+   retro_output_audio = true;
+   retro_skip_output  = false;
+
    pretro_set_video_refresh(video_frame);
    pretro_set_audio_sample(audio_sample);
    pretro_set_audio_sample_batch(audio_sample_batch);
    pretro_set_input_state(input_state);
-   pretro_set_input_poll(input_poll);
+   pretro_set_input_poll(settings->input.poll_late ?
+         input_poll_deferred : input_poll_core);
 
    retro_set_default_callbacks(cbs);
 
@@ -50,6 +50,35 @@ void retro_init_libretro_cbs(void *data);
  **/
 void retro_set_default_callbacks(void *data);
 
+/**
+ * retro_set_frame_output:
+ * @video          : show the frames the core renders.
+ * @audio          : play the audio the core renders.
+ *
+ * Lets the core run frames which are not shown or heard,
+ * e.g. to run ahead of what the user sees. Both are on
+ * after retro_init_libretro_cbs().
+ **/
+void retro_set_frame_output(bool video, bool audio);
+
+/**
+ * retro_set_frame_skip:
+ * @skip           : neither show nor play the frame about to run.
+ *
+ * Drops the output of a frame on top of retro_set_frame_output(),
+ * before any conversion, filtering or resampling is done.
+ **/
+void retro_set_frame_skip(bool skip);
+
+/**
+ * retro_get_audio_video_enable:
+ *
+ * Returns: output the frontend will use of the frame about to
+ * run, as for RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE.
+ * Bit 0 is set if it is shown, bit 1 if it is heard.
+ **/
+int retro_get_audio_video_enable(void);
+
 /**
  * retro_set_rewind_callbacks:
  *
@@ -58,13 +87,27 @@ void retro_set_default_callbacks(void *data);
  **/
 void retro_set_rewind_callbacks(void);
 
+/**
+ * retro_process_audio:
+ * @data                 : pointer to audio buffer.
+ * @samples              : amount of samples to write.
+ *
+ * Performs DSP processing (if enabled) and resampling, and
+ * writes the result to the audio driver. Runs on the audio
+ * thread when audio.threaded_dsp is on.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool retro_process_audio(const int16_t *data, size_t samples);
+
 /**
  * retro_flush_audio:
  * @data                 : pointer to audio buffer.
  * @samples              : amount of samples to write.
  *
  * Writes audio samples to audio driver. Will first
- * perform DSP processing (if enabled) and resampling.
+ * perform DSP processing (if enabled) and resampling,
+ * or queue them for the audio thread to do so.
  *
  * driver.audio_active will be set to false (0) in case
  * of an error, otherwise will be set to true (1).
@@ -73,6 +116,57 @@ void retro_set_rewind_callbacks(void);
  **/
 bool retro_flush_audio(const int16_t *data, size_t samples);
 
+/**
+ * retro_flush_audio_samples:
+ * @force                : flush even if less than a chunk is pending.
+ *
+ * Writes out the samples batched up from the per-sample
+ * audio callback.
+ **/
+void retro_flush_audio_samples(bool force);
+
+/**
+ * retro_flush_input_poll:
+ *
+ * Performs an input poll the core asked for, but which
+ * input_poll_late deferred and the core never caught up on
+ * by querying input.
+ **/
+void retro_flush_input_poll(void);
+
+/**
+ * retro_coroutine_init:
+ *
+ * Creates the coroutine retro_coroutine_run() runs the core on,
+ * unless it exists already. Needs HAVE_LIBCO.
+ *
+ * Returns: true (1) if the core can run on a coroutine,
+ * otherwise false (0).
+ **/
+bool retro_coroutine_init(void);
+
+/**
+ * retro_coroutine_deinit:
+ *
+ * Frees the core's coroutine. Must not be called while the core
+ * is suspended mid-frame.
+ **/
+void retro_coroutine_deinit(void);
+
+/**
+ * retro_coroutine_run:
+ * @yield_on_poll  : suspend the core when it polls input.
+ *
+ * Runs a frame of the core on its coroutine, or resumes the one
+ * suspended at its input poll. Lets the frontend do work in the
+ * middle of the core's frame, e.g. wait to read input later.
+ * Without the coroutine, runs a whole frame.
+ *
+ * Returns: true (1) when the frame is done, false (0) if the
+ * core was suspended.
+ **/
+bool retro_coroutine_run(bool yield_on_poll);
+
 #ifdef __cplusplus
 }
 #endif
@@ -176,56 +176,24 @@ static void glui_render_background(settings_t *settings, gl_t *gl,
    gl->coords.color = gl->white_color_ptr;
 }
 
+/* Queued up for the next menu_display_batch_flush(). */
 static void glui_render_quad(gl_t *gl, int x, int y, int w, int h,
       float r, float g, float b, float a)
 {
-   static const GLfloat vertex[] = {
-      0, 0,
-      1, 0,
-      0, 1,
-      1, 1,
-   };
+   GLfloat color[4];
 
-   static const GLfloat tex_coord[] = {
-      0, 1,
-      1, 1,
-      0, 0,
-      1, 0,
-   };
+   color[0] = r;
+   color[1] = g;
+   color[2] = b;
+   color[3] = a;
 
-   struct gl_coords coords;
-
-   GLfloat color[] = {
-      r, g, b, a,
-      r, g, b, a,
-      r, g, b, a,
-      r, g, b, a,
-   };
-
-   glViewport(x, gl->win_height - y - h, w, h);
-
-   coords.vertices      = 4;
-   coords.vertex        = vertex;
-   coords.tex_coord     = tex_coord;
-   coords.lut_tex_coord = tex_coord;
-
-   coords.color = color;
-   glBindTexture(GL_TEXTURE_2D, 0);
-
-   gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
-   gl->shader->set_coords(&coords);
-   gl->shader->set_mvp(gl, &gl->mvp_no_rot);
-
-   glEnable(GL_BLEND);
-   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-   glDisable(GL_BLEND);
-
-   gl->coords.color = gl->white_color_ptr;
+   menu_display_batch_quad(0, x, gl->win_height - y - h, w, h, color);
 }
 
 static void glui_draw_cursor(gl_t *gl, float x, float y)
 {
    glui_render_quad(gl, x-5, y-5, 10, 10, 1, 1, 1, 1);
+   menu_display_batch_flush(gl);
 }
 
 static void glui_draw_scrollbar(gl_t *gl)
@@ -503,6 +471,7 @@ static void glui_frame(void)
          menu->header_height - menu->scroll_y + glui->line_height *
          menu->navigation.selection_ptr,
          gl->win_width, glui->line_height, 1, 1, 1, 0.1);
+   menu_display_batch_flush(gl);
 
    glui_render_menu_list(runloop, gl, glui, menu,
          label, normal_color, hover_color);
@@ -511,9 +480,19 @@ static void glui_frame(void)
    runloop->frames.video.current.menu.label.is_updated    = false;
    runloop->frames.video.current.menu.framebuf.dirty      = false;
 
+   /* Header, footer and scrollbar go out in one batch,
+    * before the text drawn over them. */
    glui_render_quad(gl, 0, 0, gl->win_width,
          menu->header_height, 0.2, 0.2, 0.2, 1);
 
+   glui_render_quad(gl, 0,
+         gl->win_height - menu->header_height,
+         gl->win_width, menu->header_height,
+         0.2, 0.2, 0.2, 1);
+
+   glui_draw_scrollbar(gl);
+   menu_display_batch_flush(gl);
+
    menu_animation_ticker_line(title_buf, glui->ticker_limit,
          runloop->frames.video.count / 100, title, true);
    glui_blit_line(gl, gl->win_width/2, 0, title_buf,
@@ -523,13 +502,6 @@ static void glui_frame(void)
       glui_blit_line(gl, glui->margin, 0, "BACK",
             title_color, TEXT_ALIGN_LEFT);
 
-   glui_render_quad(gl, 0,
-         gl->win_height - menu->header_height,
-         gl->win_width, menu->header_height,
-         0.2, 0.2, 0.2, 1);
-
-   glui_draw_scrollbar(gl);
-
    core_name = global->menu.info.library_name;
    if (!core_name)
       core_name = global->system.info.library_name;
@@ -568,6 +540,7 @@ static void glui_frame(void)
       if (!str)
          str = "";
       glui_render_quad(gl, 0, 0, gl->win_width, gl->win_height, 0, 0, 0, 0.75);
+      menu_display_batch_flush(gl);
       snprintf(msg, sizeof(msg), "%s\n%s", menu->keyboard.label, str);
       glui_render_messagebox(msg);
    }
@@ -575,6 +548,7 @@ static void glui_frame(void)
    if (glui->box_message[0] != '\0')
    {
       glui_render_quad(gl, 0, 0, gl->win_width, gl->win_height, 0, 0, 0, 0.75);
+      menu_display_batch_flush(gl);
       glui_render_messagebox(glui->box_message);
       glui->box_message[0] = '\0';
    }
@@ -773,11 +747,7 @@ static bool glui_font_init_first(const void **font_driver,
       void **font_handle, void *video_data, const char *font_path,
       float font_size)
 {
-   settings_t *settings = config_get_ptr();
-   global_t   *global   = global_get_ptr();
-
-   if (settings->video.threaded
-         && !global->system.hw_render_callback.context_type)
+   if (video_driver_is_threaded())
    {
       driver_t *driver    = driver_get_ptr();
       thread_video_t *thr = driver ? (thread_video_t*)driver->video_data : NULL;
@@ -22,6 +22,7 @@
 
 #include "../menu.h"
 #include "../menu_animation.h"
+#include "../menu_display.h"
 
 #include <file/file_path.h>
 #include "../../gfx/video_thread_wrapper.h"
@@ -43,6 +44,26 @@
 #define XMB_DELAY 10
 #endif
 
+/* Entries beyond the screen edges that still get nodes,
+ * so short scrolls find them already in place. */
+#ifndef XMB_LIST_PREFETCH
+#define XMB_LIST_PREFETCH 8
+#endif
+
+/* Thumbnail textures kept around, how much texture memory
+ * they may take, and how many get uploaded per frame. */
+#ifndef XMB_THUMBNAIL_SLOTS
+#define XMB_THUMBNAIL_SLOTS 64
+#endif
+
+#ifndef XMB_THUMBNAIL_BUDGET
+#define XMB_THUMBNAIL_BUDGET (32 * 1024 * 1024)
+#endif
+
+#ifndef XMB_THUMBNAIL_UPLOADS_PER_FRAME
+#define XMB_THUMBNAIL_UPLOADS_PER_FRAME 2
+#endif
+
 typedef struct
 {
    float alpha;
@@ -52,6 +73,7 @@ typedef struct
    float y;
    GLuint icon;
    GLuint content_icon;
+   GLuint thumbnail;
 } xmb_node_t;
 
 enum
@@ -90,11 +112,38 @@ struct xmb_texture_item
    char path[PATH_MAX_LENGTH];
 };
 
+enum
+{
+   XMB_THUMBNAIL_NONE = 0,
+   XMB_THUMBNAIL_LOADING,
+   XMB_THUMBNAIL_LOADED,
+   XMB_THUMBNAIL_MISSING
+};
+
+struct xmb_thumbnail
+{
+   char path[PATH_MAX_LENGTH];
+   GLuint id;
+   size_t size;
+   /* Last frame an entry on screen wanted this thumbnail. */
+   uint64_t frame;
+   unsigned state;
+};
+
 typedef struct xmb_handle
 {
    file_list_t *menu_stack_old;
    file_list_t *selection_buf_old;
    size_t selection_ptr_old;
+
+   /* Entries of the selection buffer that were last animated,
+    * and the selection they were animated to. */
+   struct
+   {
+      size_t first;
+      size_t last;
+      size_t current;
+   } window;
    int depth;
    int old_depth;
    char box_message[PATH_MAX_LENGTH];
@@ -142,6 +191,13 @@ typedef struct xmb_handle
       struct xmb_texture_item list[XMB_TEXTURE_LAST];
    } textures;
 
+   struct
+   {
+      struct xmb_thumbnail list[XMB_THUMBNAIL_SLOTS];
+      size_t size;
+      uint64_t frame;
+   } thumbnails;
+
    struct
    {
       float item;
@@ -218,20 +274,6 @@ typedef struct xmb_handle
    gl_font_raster_block_t raster_block;
 } xmb_handle_t;
 
-static const GLfloat rmb_vertex[] = {
-   0, 0,
-   1, 0,
-   0, 1,
-   1, 1,
-};
-
-static const GLfloat rmb_tex_coord[] = {
-   0, 1,
-   1, 1,
-   0, 0,
-   1, 0,
-};
-
 static float xmb_item_y(xmb_handle_t *xmb, int i, size_t current)
 {
    float iy = xmb->icon.spacing.vertical;
@@ -250,6 +292,79 @@ static float xmb_item_y(xmb_handle_t *xmb, int i, size_t current)
    return iy;
 }
 
+/**
+ * xmb_list_window:
+ * @xmb                      : XMB handle.
+ * @current                  : Selected entry.
+ * @size                     : Number of entries in the list.
+ * @first                    : First entry of the window.
+ * @last                     : One past the last entry of the window.
+ *
+ * Gets the entries around @current that can be on screen,
+ * plus XMB_LIST_PREFETCH on either side. Only these get nodes,
+ * animations and draw calls, whatever the size of the list.
+ **/
+static void xmb_list_window(xmb_handle_t *xmb, size_t current,
+      size_t size, size_t *first, size_t *last)
+{
+   size_t rows         = XMB_LIST_PREFETCH;
+   menu_handle_t *menu = menu_driver_get_ptr();
+
+   if (menu && xmb->icon.spacing.vertical >= 1.0f)
+      rows += menu->frame_buf.height / xmb->icon.spacing.vertical + 1;
+
+   *first = current > rows ? current - rows : 0;
+   *last  = min(current + rows + 1, size);
+}
+
+/**
+ * xmb_list_get_node:
+ * @xmb                      : XMB handle.
+ * @list                     : File list handle.
+ * @i                        : Offset index of element.
+ * @current                  : Selected entry the node is placed for.
+ *
+ * Gets the node of an element. Nodes of the selection buffer are
+ * only allocated once the element comes into the window, resting
+ * where it would be for @current.
+ *
+ * Returns: node of the element, or NULL.
+ **/
+static xmb_node_t *xmb_list_get_node(xmb_handle_t *xmb,
+      file_list_t *list, size_t i, size_t current)
+{
+   xmb_node_t *node    = (xmb_node_t*)file_list_get_userdata_at_offset(list, i);
+   menu_handle_t *menu = menu_driver_get_ptr();
+
+   if (node || !menu || !menu->menu_list
+         || list != menu->menu_list->selection_buf)
+      return node;
+
+   node = (xmb_node_t*)calloc(1, sizeof(xmb_node_t));
+
+   if (!node)
+   {
+      RARCH_ERR("XMB node could not be allocated.\n");
+      return NULL;
+   }
+
+   node->alpha       = xmb->item.passive.alpha;
+   node->zoom        = xmb->item.passive.zoom;
+   node->label_alpha = node->alpha;
+   node->y           = xmb_item_y(xmb, i, current);
+   node->x           = 0;
+
+   if (i == current)
+   {
+      node->alpha       = xmb->item.active.alpha;
+      node->label_alpha = xmb->item.active.alpha;
+      node->zoom        = xmb->item.active.zoom;
+   }
+
+   list->list[i].userdata = node;
+   return node;
+}
+
 static int xmb_entry_iterate(unsigned action)
 {
    const char *label         = NULL;
@@ -271,80 +386,24 @@ static int xmb_entry_iterate(unsigned action)
    return -1;
 }
 
-static void xmb_draw_icon_begin(gl_t *gl, xmb_handle_t *xmb)
-{
-   if (!gl)
-      return;
-
-   glEnable(GL_BLEND);
-   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-}
-
-static void xmb_draw_icon_end(gl_t *gl, xmb_handle_t *xmb)
-{
-   if (!gl)
-      return;
-
-   glDisable(GL_BLEND);
-}
-
+/**
+ * xmb_draw_icon:
+ * @gl                       : GL driver handle.
+ * @xmb                      : XMB handle.
+ * @texture                  : Icon texture.
+ * @x                        : Left edge of the icon.
+ * @y                        : Bottom edge of the icon, from the top.
+ * @alpha                    : Opacity, capped at the menu opacity.
+ * @scale_factor             : Zoom of the icon around its center.
+ *
+ * Queues an icon up for the next menu_display_batch_flush().
+ **/
 static void xmb_draw_icon(gl_t *gl, xmb_handle_t *xmb,
       GLuint texture, float x, float y,
-      float alpha, float rotation, float scale_factor)
-{
-   struct gl_coords coords;
-   math_matrix_4x4 mymat, mrot, mscal;
-
-   if (alpha > xmb->alpha)
-      alpha = xmb->alpha;
-
-   if (alpha == 0)
-      return;
-
-   if (
-         x < -xmb->icon.size/2 || 
-         x > gl->win_width ||
-         y < xmb->icon.size/2 ||
-         y > gl->win_height + xmb->icon.size)
-      return;
-
-   GLfloat color[] = {
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-   };
-
-   if (gl->shader && gl->shader->use)
-      gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
-
-   glViewport(x, gl->win_height - y, xmb->icon.size, xmb->icon.size);
-
-   coords.vertices      = 4;
-   coords.vertex        = rmb_vertex;
-   coords.tex_coord     = rmb_tex_coord;
-   coords.lut_tex_coord = rmb_tex_coord;
-   coords.color         = color;
-   glBindTexture(GL_TEXTURE_2D, texture);
-
-   matrix_4x4_rotate_z(&mrot, rotation);
-   matrix_4x4_multiply(&mymat, &mrot, &gl->mvp_no_rot);
-
-   matrix_4x4_scale(&mscal, scale_factor, scale_factor, 1);
-   matrix_4x4_multiply(&mymat, &mscal, &mymat);
-
-   gl->shader->set_coords(&coords);
-   gl->shader->set_mvp(gl, &mymat);
-
-   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-}
-
-static void xmb_draw_icon_predone(gl_t *gl, xmb_handle_t *xmb,
-      math_matrix_4x4 *mymat,
-      GLuint texture, float x, float y,
-      float alpha, float rotation, float scale_factor)
+      float alpha, float scale_factor)
 {
-   struct gl_coords coords;
+   float size, offset;
+   GLfloat color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 
    if (alpha > xmb->alpha)
       alpha = xmb->alpha;
@@ -359,29 +418,12 @@ static void xmb_draw_icon_predone(gl_t *gl, xmb_handle_t *xmb,
          y > gl->win_height + xmb->icon.size)
       return;
 
-   GLfloat color[] = {
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-      1.0f, 1.0f, 1.0f, alpha,
-   };
-
-   if (gl->shader && gl->shader->use)
-      gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
-
-   glViewport(x, gl->win_height - y, xmb->icon.size, xmb->icon.size);
+   color[3] = alpha;
+   size     = xmb->icon.size * scale_factor;
+   offset   = (xmb->icon.size - size) / 2.0;
 
-   coords.vertices      = 4;
-   coords.vertex        = rmb_vertex;
-   coords.tex_coord     = rmb_tex_coord;
-   coords.lut_tex_coord = rmb_tex_coord;
-   coords.color         = color;
-   glBindTexture(GL_TEXTURE_2D, texture);
-
-   gl->shader->set_coords(&coords);
-   gl->shader->set_mvp(gl, mymat);
-
-   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   menu_display_batch_quad(texture, x + offset,
+         gl->win_height - y + offset, size, size, color);
 }
 
 static void xmb_draw_text(gl_t *gl, xmb_handle_t *xmb,
@@ -546,9 +588,34 @@ end:
    string_list_free(list);
 }
 
+static void xmb_selection_pointer_animate(xmb_handle_t *xmb,
+      xmb_node_t *node, size_t i, size_t current)
+{
+   float ia            = xmb->item.passive.alpha;
+   float iz            = xmb->item.passive.zoom;
+   float iy            = xmb_item_y(xmb, i, current);
+   menu_handle_t *menu = menu_driver_get_ptr();
+
+   if (i == current)
+   {
+      ia = xmb->item.active.alpha;
+      iz = xmb->item.active.zoom;
+   }
+
+   menu_animation_push(menu->animation,
+         XMB_DELAY, ia, &node->alpha, EASING_IN_OUT_QUAD, NULL);
+   menu_animation_push(menu->animation,
+         XMB_DELAY, ia, &node->label_alpha, EASING_IN_OUT_QUAD, NULL);
+   menu_animation_push(menu->animation,
+         XMB_DELAY, iz, &node->zoom,  EASING_IN_OUT_QUAD, NULL);
+   menu_animation_push(menu->animation,
+         XMB_DELAY, iy, &node->y,     EASING_IN_OUT_QUAD, NULL);
+}
+
 static void xmb_selection_pointer_changed(void)
 {
-   unsigned i, current, end;
+   size_t i, current, end, first, last;
+   file_list_t *list   = NULL;
    xmb_handle_t *xmb   = NULL;
    menu_handle_t *menu = menu_driver_get_ptr();
 
@@ -560,49 +627,52 @@ static void xmb_selection_pointer_changed(void)
    if (!xmb)
       return;
 
+   list    = menu->menu_list->selection_buf;
    current = menu->navigation.selection_ptr;
    end     = menu_list_get_size(menu->menu_list);
 
-   for (i = 0; i < end; i++)
+   xmb_list_window(xmb, current, end, &first, &last);
+
+   /* Entries outside the window are neither animated nor drawn,
+    * so the ones coming into it start from where they would have
+    * rested for the previous selection. */
+   for (i = first; i < last; i++)
    {
-      float iy;
-      float ia = xmb->item.passive.alpha;
-      float iz = xmb->item.passive.zoom;
-      xmb_node_t *node = (xmb_node_t*)file_list_get_userdata_at_offset(
-            menu->menu_list->selection_buf, i);
+      xmb_node_t *node = xmb_list_get_node(xmb, list, i,
+            xmb->window.current);
 
       if (!node)
          continue;
 
-      iy = xmb_item_y(xmb, i, current);
-
-      if (i == current)
+      if (i < xmb->window.first || i >= xmb->window.last)
       {
-         ia = xmb->item.active.alpha;
-         iz = xmb->item.active.zoom;
+         node->alpha       = xmb->item.passive.alpha;
+         node->label_alpha = xmb->item.passive.alpha;
+         node->zoom        = xmb->item.passive.zoom;
+         node->x           = 0;
+         node->y           = xmb_item_y(xmb, i, xmb->window.current);
       }
 
-      menu_animation_push(menu->animation,
-            XMB_DELAY, ia, &node->alpha, EASING_IN_OUT_QUAD, NULL);
-      menu_animation_push(menu->animation,
-            XMB_DELAY, ia, &node->label_alpha, EASING_IN_OUT_QUAD, NULL);
-      menu_animation_push(menu->animation,
-            XMB_DELAY, iz, &node->zoom,  EASING_IN_OUT_QUAD, NULL);
-      menu_animation_push(menu->animation,
-            XMB_DELAY, iy, &node->y,     EASING_IN_OUT_QUAD, NULL);
+      xmb_selection_pointer_animate(xmb, node, i, current);
    }
+
+   xmb->window.first   = first;
+   xmb->window.last    = last;
+   xmb->window.current = current;
 }
 
 static void xmb_list_open_old(xmb_handle_t *xmb,
       file_list_t *list, int dir, size_t current)
 {
-   unsigned i;
+   size_t i, first, last;
    menu_handle_t *menu = menu_driver_get_ptr();
 
    if (!menu)
       return;
 
-   for (i = 0; i < file_list_get_size(list); i++)
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
+
+   for (i = first; i < last; i++)
    {
       float ia = 0;
       xmb_node_t *node = (xmb_node_t*)file_list_get_userdata_at_offset(list, i);
@@ -628,16 +698,17 @@ static void xmb_list_open_old(xmb_handle_t *xmb,
 static void xmb_list_open_new(xmb_handle_t *xmb,
       file_list_t *list, int dir, size_t current)
 {
-   unsigned i;
+   size_t i, first, last;
    menu_handle_t *menu = menu_driver_get_ptr();
 
    if (!menu)
       return;
 
-   for (i = 0; i < file_list_get_size(list); i++)
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
+
+   for (i = first; i < last; i++)
    {
-      xmb_node_t *node = (xmb_node_t*)
-         file_list_get_userdata_at_offset(list, i);
+      xmb_node_t *node = xmb_list_get_node(xmb, list, i, current);
 
       if (!node)
          continue;
@@ -654,7 +725,7 @@ static void xmb_list_open_new(xmb_handle_t *xmb,
       if (i == current)
          node->zoom = 1;
    }
-   for (i = 0; i < file_list_get_size(list); i++)
+   for (i = first; i < last; i++)
    {
       float ia;
       xmb_node_t *node = (xmb_node_t*)file_list_get_userdata_at_offset(list, i);
@@ -674,6 +745,10 @@ static void xmb_list_open_new(xmb_handle_t *xmb,
             XMB_DELAY, 0, &node->x, EASING_IN_OUT_QUAD, NULL);
    }
 
+   xmb->window.first   = first;
+   xmb->window.last    = last;
+   xmb->window.current = current;
+
    xmb->old_depth = xmb->depth;
 }
 
@@ -764,16 +839,15 @@ static void xmb_push_animations(xmb_node_t *node, float ia, float ix)
 static void xmb_list_switch_old(xmb_handle_t *xmb,
       file_list_t *list, int dir, size_t current)
 {
-   unsigned i;
-   size_t end          = 0;
+   size_t i, first, last;
    menu_handle_t *menu = menu_driver_get_ptr();
 
    if (!menu)
       return;
 
-   end = file_list_get_size(list);
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
 
-   for (i = 0; i < end; i++)
+   for (i = first; i < last; i++)
    {
       xmb_node_t *node = (xmb_node_t*)
          file_list_get_userdata_at_offset(list, i);
@@ -789,19 +863,17 @@ static void xmb_list_switch_old(xmb_handle_t *xmb,
 static void xmb_list_switch_new(xmb_handle_t *xmb,
       file_list_t *list, int dir, size_t current)
 {
-   unsigned i;
-   size_t end          = 0;
+   size_t i, first, last;
    menu_handle_t *menu = menu_driver_get_ptr();
 
    if (!menu)
       return;
 
-   end = file_list_get_size(list);
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
 
-   for (i = 0; i < end; i++)
+   for (i = first; i < last; i++)
    {
-      xmb_node_t *node = (xmb_node_t*)
-         file_list_get_userdata_at_offset(list, i);
+      xmb_node_t *node = xmb_list_get_node(xmb, list, i, current);
       float ia         = 0.5;
 
       if (!node)
@@ -816,6 +888,10 @@ static void xmb_list_switch_new(xmb_handle_t *xmb,
       
       xmb_push_animations(node, ia, 0);
    }
+
+   xmb->window.first   = first;
+   xmb->window.last    = last;
+   xmb->window.current = current;
 }
 
 static void xmb_set_title(xmb_handle_t *xmb)
@@ -1056,12 +1132,10 @@ static void xmb_draw_items(xmb_handle_t *xmb, gl_t *gl,
       file_list_t *list, file_list_t *stack,
       size_t current, size_t cat_selection_ptr)
 {
-   unsigned i;
-   math_matrix_4x4 mymat, mrot, mscal;
+   size_t i, first, last;
    core_info_t *info     = NULL;
    const char *label     = NULL;
    xmb_node_t *core_node = NULL;
-   size_t end            = 0;
 
    if (!list || !list->size)
       return;
@@ -1071,15 +1145,9 @@ static void xmb_draw_items(xmb_handle_t *xmb, gl_t *gl,
    if (cat_selection_ptr)
       core_node = xmb_get_userdata_from_core(xmb, info, cat_selection_ptr - 1);
 
-   end = file_list_get_size(list);
-
-   matrix_4x4_rotate_z(&mrot, 0 /* rotation */);
-   matrix_4x4_multiply(&mymat, &mrot, &gl->mvp_no_rot);
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
 
-   matrix_4x4_scale(&mscal, 1 /* scale_factor */, 1 /* scale_factor */, 1);
-   matrix_4x4_multiply(&mymat, &mscal, &mymat);
-
-   for (i = 0; i < end; i++)
+   for (i = first; i < last; i++)
    {
       float icon_x, icon_y;
       char type_str[PATH_MAX_LENGTH], path_buf[PATH_MAX_LENGTH];
@@ -1088,11 +1156,13 @@ static void xmb_draw_items(xmb_handle_t *xmb, gl_t *gl,
       unsigned type = 0, w                  = 0;
       menu_file_list_cbs_t *cbs             = NULL;
       GLuint icon                           = 0;
-      xmb_node_t *node = (xmb_node_t*)file_list_get_userdata_at_offset(list, i);
+      xmb_node_t *node = xmb_list_get_node(xmb, list, i, current);
       runloop_t *runloop = rarch_main_get_ptr();
 
       if (!node)
          continue;
+
+      type_str[0] = path_buf[0] = '\0';
       
       icon_x = node->x + xmb->margins.screen.left + 
          xmb->icon.spacing.horizontal - xmb->icon.size / 2.0;
@@ -1142,6 +1212,8 @@ static void xmb_draw_items(xmb_handle_t *xmb, gl_t *gl,
       else if (!strcmp(entry_label, "resume_content"))
          icon = xmb->textures.list[XMB_TEXTURE_RESUME].id;
 
+      if (node->thumbnail)
+         icon = node->thumbnail;
 
       menu_animation_ticker_line(name, 35,
             runloop->frames.video.count / 20, path_buf,
@@ -1179,78 +1251,327 @@ static void xmb_draw_items(xmb_handle_t *xmb, gl_t *gl,
                TEXT_ALIGN_LEFT);
 
 
-      xmb_draw_icon_begin(gl, xmb);
-
-      xmb_draw_icon(gl, xmb, icon, icon_x, icon_y, node->alpha, 0, node->zoom);
+      xmb_draw_icon(gl, xmb, icon, icon_x, icon_y, node->alpha, node->zoom);
 
       if (!strcmp(type_str, "ON") && xmb->textures.list[XMB_TEXTURE_SWITCH_ON].id)
       {
-         xmb_draw_icon_predone(gl, xmb, &mymat,
+         xmb_draw_icon(gl, xmb,
                xmb->textures.list[XMB_TEXTURE_SWITCH_ON].id,
                node->x + xmb->margins.screen.left + xmb->icon.spacing.horizontal
                + xmb->icon.size / 2.0 + xmb->margins.setting.left,
                xmb->margins.screen.top + node->y + xmb->icon.size / 2.0,
                node->alpha,
-               0,
                1);
       }
 
       if (!strcmp(type_str, "OFF") && xmb->textures.list[XMB_TEXTURE_SWITCH_OFF].id)
       {
-         xmb_draw_icon_predone(gl, xmb, &mymat,
+         xmb_draw_icon(gl, xmb,
                xmb->textures.list[XMB_TEXTURE_SWITCH_OFF].id,
                node->x + xmb->margins.screen.left + xmb->icon.spacing.horizontal
                + xmb->icon.size / 2.0 + xmb->margins.setting.left,
                xmb->margins.screen.top + node->y + xmb->icon.size / 2.0,
                node->alpha,
-               0,
                1);
       }
-
-      xmb_draw_icon_end(gl, xmb);
    }
 
 }
 
 static void xmb_draw_cursor(gl_t *gl, xmb_handle_t *xmb, float x, float y)
 {
-   struct gl_coords coords;
-   math_matrix_4x4 mymat, mrot;
+   GLfloat color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-   GLfloat color[] = {
-      1.0f, 1.0f, 1.0f, xmb->alpha,
-      1.0f, 1.0f, 1.0f, xmb->alpha,
-      1.0f, 1.0f, 1.0f, xmb->alpha,
-      1.0f, 1.0f, 1.0f, xmb->alpha,
-   };
+   color[3] = xmb->alpha;
 
-   glViewport(x, gl->win_height - y, xmb->cursor.size, xmb->cursor.size);
+   menu_display_batch_quad(xmb->textures.list[XMB_TEXTURE_POINTER].id,
+         x, gl->win_height - y, xmb->cursor.size, xmb->cursor.size, color);
+   menu_display_batch_flush(gl);
+}
 
-   coords.vertices      = 4;
-   coords.vertex        = rmb_vertex;
-   coords.tex_coord     = rmb_tex_coord;
-   coords.lut_tex_coord = rmb_tex_coord;
-   coords.color         = color;
+#ifdef HAVE_RPNG
+/**
+ * xmb_thumbnail_path:
+ * @dir                      : Thumbnails directory.
+ * @path                     : Path of the entry.
+ * @type                     : Type of the entry.
+ * @s                        : Buffer the thumbnail path is written to.
+ * @len                      : Size of @s.
+ *
+ * Thumbnails are looked up as <entry name>.png, where the
+ * name of a content file loses its extension and the name
+ * of a playlist entry loses the core it runs on.
+ *
+ * Returns: true (1) if the entry can have a thumbnail,
+ * otherwise false (0).
+ **/
+static bool xmb_thumbnail_path(const char *dir, const char *path,
+      unsigned type, char *s, size_t len)
+{
+   char name[PATH_MAX_LENGTH];
 
-   glBindTexture(GL_TEXTURE_2D, xmb->textures.list[XMB_TEXTURE_POINTER].id);
+   if (!*dir || !path || !*path)
+      return false;
 
-   matrix_4x4_rotate_z(&mrot, 0);
-   matrix_4x4_multiply(&mymat, &mrot, &gl->mvp_no_rot);
+   strlcpy(name, path_basename(path), sizeof(name));
 
-   glEnable(GL_BLEND);
-   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   switch (type)
+   {
+      case MENU_FILE_PLAYLIST_ENTRY:
+         {
+            char *core = strrchr(name, '(');
 
-   gl->shader->set_coords(&coords);
-   gl->shader->set_mvp(gl, &mymat);
+            if (core && core > name && core[-1] == ' ')
+               core[-1] = '\0';
+         }
+         break;
+      case MENU_FILE_PLAIN:
+      case MENU_FILE_CONTENTLIST_ENTRY:
+         path_remove_extension(name);
+         break;
+      default:
+         return false;
+   }
 
-   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   fill_pathname_join(s, dir, name, len);
+   strlcat(s, ".png", len);
+   return true;
+}
 
-   glDisable(GL_BLEND);
+static struct xmb_thumbnail *xmb_thumbnail_find(xmb_handle_t *xmb,
+      const char *path)
+{
+   unsigned i;
+
+   for (i = 0; i < XMB_THUMBNAIL_SLOTS; i++)
+   {
+      struct xmb_thumbnail *thumb = &xmb->thumbnails.list[i];
+
+      if (thumb->state != XMB_THUMBNAIL_NONE && !strcmp(thumb->path, path))
+         return thumb;
+   }
+
+   return NULL;
+}
+
+static void xmb_thumbnail_free(xmb_handle_t *xmb,
+      struct xmb_thumbnail *thumb)
+{
+   if (thumb->state == XMB_THUMBNAIL_LOADING)
+      rarch_main_data_thumbnail_cancel(thumb->path);
+   if (thumb->id)
+      glDeleteTextures(1, &thumb->id);
+
+   xmb->thumbnails.size -= thumb->size;
+   memset(thumb, 0, sizeof(*thumb));
+}
+
+/**
+ * xmb_thumbnail_lru:
+ * @xmb                      : XMB handle.
+ * @state                    : State the slot has to be in,
+ *                             XMB_THUMBNAIL_NONE for any.
+ *
+ * Returns: the least recently used slot no entry on screen
+ * wanted this frame, or NULL.
+ **/
+static struct xmb_thumbnail *xmb_thumbnail_lru(xmb_handle_t *xmb,
+      unsigned state)
+{
+   unsigned i;
+   struct xmb_thumbnail *lru = NULL;
+
+   for (i = 0; i < XMB_THUMBNAIL_SLOTS; i++)
+   {
+      struct xmb_thumbnail *thumb = &xmb->thumbnails.list[i];
+
+      if (thumb->frame == xmb->thumbnails.frame)
+         continue;
+      if (state != XMB_THUMBNAIL_NONE && thumb->state != state)
+         continue;
+      if (thumb->state == XMB_THUMBNAIL_NONE)
+         return thumb;
+      if (!lru || thumb->frame < lru->frame)
+         lru = thumb;
+   }
+
+   return lru;
+}
+
+/**
+ * xmb_thumbnail_get:
+ * @xmb                      : XMB handle.
+ * @path                     : Path of the PNG thumbnail.
+ *
+ * Marks a thumbnail as wanted this frame, requesting it
+ * from the data runloop the first time.
+ *
+ * Returns: the texture of the thumbnail, 0 if it is not
+ * loaded (yet).
+ **/
+static GLuint xmb_thumbnail_get(xmb_handle_t *xmb, const char *path)
+{
+   struct xmb_thumbnail *thumb = xmb_thumbnail_find(xmb, path);
+
+   if (!thumb)
+   {
+      if (!(thumb = xmb_thumbnail_lru(xmb, XMB_THUMBNAIL_NONE)))
+         return 0;
+
+      xmb_thumbnail_free(xmb, thumb);
+
+      /* Queue is full, try again next frame. */
+      if (!rarch_main_data_thumbnail_request(path))
+         return 0;
+
+      strlcpy(thumb->path, path, sizeof(thumb->path));
+      thumb->state = XMB_THUMBNAIL_LOADING;
+   }
+
+   thumb->frame = xmb->thumbnails.frame;
+
+   return thumb->id;
+}
+
+/**
+ * xmb_thumbnails_list_update:
+ * @xmb                      : XMB handle.
+ * @list                     : File list handle.
+ * @current                  : Selected entry of @list.
+ * @dir                      : Thumbnails directory.
+ *
+ * Points the nodes of the entries that can be on screen
+ * at their thumbnails.
+ **/
+static void xmb_thumbnails_list_update(xmb_handle_t *xmb,
+      file_list_t *list, size_t current, const char *dir)
+{
+   size_t i, first, last;
+
+   if (!list || !list->size)
+      return;
+
+   xmb_list_window(xmb, current, file_list_get_size(list), &first, &last);
+
+   for (i = first; i < last; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+      const char *entry_path = NULL;
+      unsigned type          = 0;
+      xmb_node_t *node       = xmb_list_get_node(xmb, list, i, current);
+
+      if (!node)
+         continue;
+
+      node->thumbnail = 0;
+
+      menu_list_get_at_offset(list, i, &entry_path, NULL, &type);
+
+      if (xmb_thumbnail_path(dir, entry_path, type, path, sizeof(path)))
+         node->thumbnail = xmb_thumbnail_get(xmb, path);
+   }
+}
+
+/**
+ * xmb_thumbnails_update:
+ * @xmb                      : XMB handle.
+ * @menu                     : Menu handle.
+ *
+ * Uploads up to XMB_THUMBNAIL_UPLOADS_PER_FRAME decoded
+ * thumbnails, cancels the ones scrolled out of view before
+ * they were decoded and evicts the least recently used ones
+ * past XMB_THUMBNAIL_BUDGET. Has to be called on the main
+ * thread, as textures are uploaded through the video driver.
+ **/
+static void xmb_thumbnails_update(xmb_handle_t *xmb, menu_handle_t *menu)
+{
+   unsigned i;
+   struct xmb_thumbnail *thumb = NULL;
+   runloop_t *runloop          = rarch_main_get_ptr();
+   settings_t *settings        = config_get_ptr();
+
+   xmb->thumbnails.frame++;
+
+   xmb_thumbnails_list_update(xmb, xmb->selection_buf_old,
+         xmb->selection_ptr_old, settings->thumbnails_directory);
+   xmb_thumbnails_list_update(xmb, menu->menu_list->selection_buf,
+         menu->navigation.selection_ptr, settings->thumbnails_directory);
+
+   for (i = 0; i < XMB_THUMBNAIL_UPLOADS_PER_FRAME; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+      struct texture_image ti = {0};
+      int ret = rarch_main_data_thumbnail_pull(path, sizeof(path), &ti);
+
+      if (ret == -1)
+         break;
+
+      thumb = xmb_thumbnail_find(xmb, path);
+
+      if (thumb && thumb->state == XMB_THUMBNAIL_LOADING)
+      {
+         thumb->state = XMB_THUMBNAIL_MISSING;
+
+         if (ret == 1)
+         {
+            thumb->id    = video_texture_load(&ti,
+                  TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+            /* Mipmaps take another third. */
+            thumb->size  = ti.width * ti.height * sizeof(uint32_t) * 4 / 3;
+            thumb->state = XMB_THUMBNAIL_LOADED;
+            xmb->thumbnails.size += thumb->size;
+         }
+      }
+
+      texture_image_free(&ti);
+   }
+
+   for (i = 0; i < XMB_THUMBNAIL_SLOTS; i++)
+   {
+      thumb = &xmb->thumbnails.list[i];
+
+      if (thumb->state == XMB_THUMBNAIL_LOADING
+            && thumb->frame != xmb->thumbnails.frame)
+         xmb_thumbnail_free(xmb, thumb);
+   }
+
+   while (xmb->thumbnails.size > XMB_THUMBNAIL_BUDGET
+         && (thumb = xmb_thumbnail_lru(xmb, XMB_THUMBNAIL_LOADED)))
+      xmb_thumbnail_free(xmb, thumb);
+
+   for (i = 0; i < XMB_THUMBNAIL_SLOTS; i++)
+   {
+      /* Keep drawing until every thumbnail on screen is in. */
+      if (xmb->thumbnails.list[i].state == XMB_THUMBNAIL_LOADING)
+      {
+         runloop->frames.video.current.menu.framebuf.dirty = true;
+         break;
+      }
+   }
+}
+
+/**
+ * xmb_thumbnails_free:
+ * @xmb                      : XMB handle.
+ *
+ * Drops every thumbnail, loaded or still on its way.
+ **/
+static void xmb_thumbnails_free(xmb_handle_t *xmb)
+{
+   unsigned i;
+
+   for (i = 0; i < XMB_THUMBNAIL_SLOTS; i++)
+      xmb_thumbnail_free(xmb, &xmb->thumbnails.list[i]);
+
+   rarch_main_data_thumbnail_cancel(NULL);
+
+   xmb->thumbnails.size = 0;
 }
+#endif
 
 static void xmb_render(void)
 {
-   unsigned i, current, end;
+   size_t i, current, first, last;
    runloop_t *runloop = rarch_main_get_ptr();
    settings_t *settings = config_get_ptr();
 
@@ -1267,11 +1588,13 @@ static void xmb_render(void)
    menu_animation_update(menu->animation, menu->dt / IDEAL_DT);
 
    current = menu->navigation.selection_ptr;
-   end     = menu_list_get_size(menu->menu_list);
+
+   xmb_list_window(xmb, current, menu_list_get_size(menu->menu_list),
+         &first, &last);
 
    if (settings->menu.pointer.enable)
    {
-      for (i = 0; i < end; i++)
+      for (i = first; i < last; i++)
       {
          float item_y = xmb->margins.screen.top + xmb_item_y(xmb, i, current);
 
@@ -1283,7 +1606,7 @@ static void xmb_render(void)
 
    if (settings->menu.mouse.enable)
    {
-      for (i = 0; i < end; i++)
+      for (i = first; i < last; i++)
       {
          float item_y = xmb->margins.screen.top + xmb_item_y(xmb, i, current);
 
@@ -1295,11 +1618,14 @@ static void xmb_render(void)
    runloop->frames.video.current.menu.animation.is_active = false;
    runloop->frames.video.current.menu.label.is_updated    = false;
    runloop->frames.video.current.menu.framebuf.dirty      = false;
+
+#ifdef HAVE_RPNG
+   xmb_thumbnails_update(xmb, menu);
+#endif
 }
 
 static void xmb_frame(void)
 {
-   math_matrix_4x4 mymat, mrot, mscal;
    unsigned i, depth;
    char msg[PATH_MAX_LENGTH];
    char title_msg[PATH_MAX_LENGTH], timedate[PATH_MAX_LENGTH];
@@ -1388,25 +1714,17 @@ static void xmb_frame(void)
          menu->navigation.selection_ptr,
          menu->categories.selection_ptr);
 
-   matrix_4x4_rotate_z(&mrot, 0 /* rotation */);
-   matrix_4x4_multiply(&mymat, &mrot, &gl->mvp_no_rot);
-
-   matrix_4x4_scale(&mscal, 1 /* scale_factor */, 1 /* scale_factor */, 1);
-   matrix_4x4_multiply(&mymat, &mscal, &mymat);
-
-   xmb_draw_icon_begin(gl, xmb);
-
    if (settings->menu.timedate_enable)
-      xmb_draw_icon_predone(gl, xmb, &mymat, xmb->textures.list[XMB_TEXTURE_CLOCK].id,
-            gl->win_width - xmb->icon.size, xmb->icon.size, 1, 0, 1);
+      xmb_draw_icon(gl, xmb, xmb->textures.list[XMB_TEXTURE_CLOCK].id,
+            gl->win_width - xmb->icon.size, xmb->icon.size, 1, 1);
 
-   xmb_draw_icon_predone(gl, xmb, &mymat, xmb->textures.list[XMB_TEXTURE_ARROW].id,
+   xmb_draw_icon(gl, xmb, xmb->textures.list[XMB_TEXTURE_ARROW].id,
          xmb->x + xmb->margins.screen.left + 
          xmb->icon.spacing.horizontal - xmb->icon.size / 2.0 + xmb->icon.size,
          xmb->margins.screen.top + 
          xmb->icon.size / 2.0 + xmb->icon.spacing.vertical 
          * xmb->item.active.factor,
-         xmb->textures.arrow.alpha, 0, 1);
+         xmb->textures.arrow.alpha, 1);
 
    for (i = 0; i < menu->categories.size; i++)
    {
@@ -1417,20 +1735,20 @@ static void xmb_frame(void)
          node = xmb_get_userdata_from_core(xmb, info, i - 1);
 
       if (node)
-      {
-         xmb_draw_icon_begin(gl, xmb);
          xmb_draw_icon(gl, xmb, node->icon, 
                xmb->x + xmb->categories.x_pos + 
                xmb->margins.screen.left + 
                xmb->icon.spacing.horizontal * (i + 1) - xmb->icon.size / 2.0,
                xmb->margins.screen.top + xmb->icon.size / 2.0, 
                node->alpha, 
-               0, 
                node->zoom);
-         xmb_draw_icon_end(gl, xmb);
-      }
    }
 
+   /* Icons only overlap while lists slide past each other, so
+    * all of them go out in one batch. The text is drawn over
+    * them by the font flush below. */
+   menu_display_batch_flush(gl);
+
    if (font_driver->flush)
    {
       font_driver->flush(xmb->font.buf);
@@ -1602,6 +1920,10 @@ static void xmb_free(void *data)
 
       gl_coord_array_free(&xmb->raster_block.carr);
 
+#ifdef HAVE_RPNG
+      rarch_main_data_thumbnail_cancel(NULL);
+#endif
+
       free(menu->userdata);
       menu->userdata = NULL;
    }
@@ -1614,11 +1936,7 @@ static bool xmb_font_init_first(const void **font_driver,
       void **font_handle, void *video_data, const char *font_path,
       float xmb_font_size)
 {
-   settings_t *settings = config_get_ptr();
-   global_t   *global   = global_get_ptr();
-
-   if (settings->video.threaded
-         && !global->system.hw_render_callback.context_type)
+   if (video_driver_is_threaded())
    {
       driver_t *driver    = driver_get_ptr();
       thread_video_t *thr = (thread_video_t*)driver->video_data;
@@ -1675,10 +1993,14 @@ static void xmb_context_reset(void)
    char bgpath[PATH_MAX_LENGTH];
    char mediapath[PATH_MAX_LENGTH], themepath[PATH_MAX_LENGTH],
         iconpath[PATH_MAX_LENGTH],  fontpath[PATH_MAX_LENGTH],
-        core_id[PATH_MAX_LENGTH],   texturepath[PATH_MAX_LENGTH],
-        content_texturepath[PATH_MAX_LENGTH];
-
-   struct texture_image ti     = {0};
+        core_id[PATH_MAX_LENGTH];
+   char *texturepath           = NULL;
+   char *content_texturepath   = NULL;
+   char *icon_paths            = NULL;
+   const char **icon_ptrs      = NULL;
+   xmb_node_t **icon_nodes     = NULL;
+   struct texture_image *icon_images = NULL;
+   unsigned icon_count         = 0;
    core_info_list_t* info_list = NULL;
    gl_t *gl                    = NULL;
    xmb_handle_t *xmb           = NULL;
@@ -1764,18 +2086,29 @@ static void xmb_context_reset(void)
    fill_pathname_join(xmb->textures.list[XMB_TEXTURE_POINTER].path, iconpath,
          "pointer.png", sizeof(xmb->textures.list[XMB_TEXTURE_POINTER].path));
 
-   for (k = 0; k < XMB_TEXTURE_LAST; k++)
    {
-      const char *path = xmb->textures.list[k].path;
-      if (! path_file_exists(path))
-         continue;
+      /* Decode all icons at once, only the uploads need the GL context. */
+      const char *paths[XMB_TEXTURE_LAST];
+      struct texture_image images[XMB_TEXTURE_LAST];
 
-      texture_image_load(&ti, path);
+      for (k = 0; k < XMB_TEXTURE_LAST; k++)
+      {
+         const char *path = xmb->textures.list[k].path;
+         paths[k]         = path_file_exists(path) ? path : NULL;
+      }
 
-      xmb->textures.list[k].id   = video_texture_load(&ti,
-            TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+      texture_image_load_batch(images, paths, XMB_TEXTURE_LAST, true);
 
-      texture_image_free(&ti);
+      for (k = 0; k < XMB_TEXTURE_LAST; k++)
+      {
+         if (!paths[k])
+            continue;
+
+         xmb->textures.list[k].id   = video_texture_load(&images[k],
+               TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+
+         texture_image_free(&images[k]);
+      }
    }
 
    {
@@ -1798,13 +2131,25 @@ static void xmb_context_reset(void)
 
    info_list = (core_info_list_t*)global->core_info;
 
-   if (!info_list)
+   if (!info_list || menu->categories.size < 2)
       return;
 
+   /* Two icons per core category, the path of each is kept 
+    * until the whole batch is decoded. */
+   icon_count  = (menu->categories.size - 1) * 2;
+   icon_paths  = (char*)calloc(icon_count, PATH_MAX_LENGTH);
+   icon_ptrs   = (const char**)calloc(icon_count, sizeof(*icon_ptrs));
+   icon_nodes  = (xmb_node_t**)calloc(menu->categories.size - 1,
+         sizeof(*icon_nodes));
+   icon_images = (struct texture_image*)calloc(icon_count,
+         sizeof(*icon_images));
+
+   if (!icon_paths || !icon_ptrs || !icon_nodes || !icon_images)
+      goto end;
+
    for (i = 1; i < menu->categories.size; i++)
    {
       core_info_t *info           = NULL;
-      struct texture_image ti = {0};
       node = xmb_get_userdata_from_core(xmb, info, i - 1);
 
       if (!node)
@@ -1838,30 +2183,23 @@ static void xmb_context_reset(void)
       else
          strlcpy(core_id, "default", sizeof(core_id));
 
-      strlcpy(texturepath, iconpath, sizeof(texturepath));
-      strlcat(texturepath, core_id, sizeof(texturepath));
-      strlcat(texturepath, ".png", sizeof(texturepath));
-
-      strlcpy(content_texturepath, iconpath, sizeof(content_texturepath));
-      strlcat(content_texturepath, core_id, sizeof(content_texturepath));
-      strlcat(content_texturepath, "-content.png", sizeof(content_texturepath));
-
-      node->alpha        = 0;
-      node->zoom         = xmb->categories.passive.zoom;
-
-      texture_image_load(&ti, texturepath);
+      texturepath         = icon_paths + (i - 1) * 2 * PATH_MAX_LENGTH;
+      content_texturepath = texturepath + PATH_MAX_LENGTH;
 
-      node->icon         = video_texture_load(&ti,
-            TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
-
-      texture_image_free(&ti);
+      strlcpy(texturepath, iconpath, PATH_MAX_LENGTH);
+      strlcat(texturepath, core_id, PATH_MAX_LENGTH);
+      strlcat(texturepath, ".png", PATH_MAX_LENGTH);
 
-      texture_image_load(&ti, content_texturepath);
+      strlcpy(content_texturepath, iconpath, PATH_MAX_LENGTH);
+      strlcat(content_texturepath, core_id, PATH_MAX_LENGTH);
+      strlcat(content_texturepath, "-content.png", PATH_MAX_LENGTH);
 
-      node->content_icon = video_texture_load(&ti,
-            TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+      icon_ptrs[(i - 1) * 2]     = texturepath;
+      icon_ptrs[(i - 1) * 2 + 1] = content_texturepath;
+      icon_nodes[i - 1]          = node;
 
-      texture_image_free(&ti);
+      node->alpha        = 0;
+      node->zoom         = xmb->categories.passive.zoom;
 
       if (i == xmb->categories.active.idx)
       {
@@ -1871,6 +2209,29 @@ static void xmb_context_reset(void)
       else if (xmb->depth <= 1)
          node->alpha = xmb->categories.passive.alpha;
    }
+
+   texture_image_load_batch(icon_images, icon_ptrs, icon_count, true);
+
+   for (i = 1; i < menu->categories.size; i++)
+   {
+      node = icon_nodes[i - 1];
+      if (!node)
+         continue;
+
+      node->icon         = video_texture_load(&icon_images[(i - 1) * 2],
+            TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+      node->content_icon = video_texture_load(&icon_images[(i - 1) * 2 + 1],
+            TEXTURE_BACKEND_OPENGL, TEXTURE_FILTER_MIPMAP_LINEAR);
+   }
+
+   for (k = 0; k < icon_count; k++)
+      texture_image_free(&icon_images[k]);
+
+end:
+   free(icon_paths);
+   free(icon_ptrs);
+   free(icon_nodes);
+   free(icon_images);
 }
 
 static void xmb_navigation_clear(bool pending_push)
@@ -1909,51 +2270,6 @@ static void xmb_navigation_ascend_alphabet(size_t *unused)
    xmb_selection_pointer_changed();
 }
 
-static void xmb_list_insert(file_list_t *list,
-      const char *path, const char *unused, size_t list_size)
-{
-   int current = 0, i = list_size;
-   xmb_node_t *node = NULL;
-   xmb_handle_t *xmb = NULL;
-   menu_handle_t *menu = menu_driver_get_ptr();
-
-   if (!menu)
-      return;
-   
-   xmb = (xmb_handle_t*)menu->userdata;
-
-   if (!list || !xmb)
-      return;
-
-   list->list[i].userdata = (xmb_node_t*)calloc(1, sizeof(xmb_node_t));
-
-   if (!list->list[i].userdata)
-   {
-      RARCH_ERR("XMB node could not be allocated.\n");
-      return;
-   }
-
-   node = (xmb_node_t*)list->list[i].userdata;
-
-   if (!node)
-      return;
-
-   current           = menu->navigation.selection_ptr;
-
-   node->alpha       = xmb->item.passive.alpha;
-   node->zoom        = xmb->item.passive.zoom;
-   node->label_alpha = node->alpha;
-   node->y           = xmb_item_y(xmb, i, current);
-   node->x           = 0;
-
-   if (i == current)
-   {
-      node->alpha       = xmb->item.active.alpha;
-      node->label_alpha = xmb->item.active.alpha;
-      node->zoom        = xmb->item.active.zoom;
-   }
-}
-
 static void xmb_list_delete(file_list_t *list,
       size_t idx, size_t list_size)
 {
@@ -2000,21 +2316,17 @@ static void xmb_list_cache(bool horizontal, unsigned action)
 
    stack_size = menu->menu_list->menu_stack->size;
 
-   if (menu->menu_list->menu_stack->list[stack_size - 1].label)
-	   free(menu->menu_list->menu_stack->list[stack_size - 1].label);
-   menu->menu_list->menu_stack->list[stack_size - 1].label = NULL;
-
    if (menu->categories.selection_ptr == 0)
    {
-	   menu->menu_list->menu_stack->list[stack_size - 1].label = 
-         strdup("Main Menu");
+      file_list_set_label_at_offset(menu->menu_list->menu_stack,
+            stack_size - 1, "Main Menu");
 	   menu->menu_list->menu_stack->list[stack_size - 1].type = 
       MENU_SETTINGS;
    }
    else
    {
-	   menu->menu_list->menu_stack->list[stack_size - 1].label = 
-         strdup("Horizontal Menu");
+      file_list_set_label_at_offset(menu->menu_list->menu_stack,
+            stack_size - 1, "Horizontal Menu");
 	   menu->menu_list->menu_stack->list[stack_size - 1].type = 
       MENU_SETTING_HORIZONTAL_MENU;
    }
@@ -2048,6 +2360,10 @@ static void xmb_context_destroy(void)
       glDeleteTextures(1, &node->icon);
       glDeleteTextures(1, &node->content_icon);
    }
+
+#ifdef HAVE_RPNG
+   xmb_thumbnails_free(xmb);
+#endif
 }
 
 static void xmb_toggle(bool menu_on)
@@ -2119,7 +2435,7 @@ menu_ctx_driver_t menu_ctx_xmb = {
    xmb_navigation_set_last,
    xmb_navigation_descend_alphabet,
    xmb_navigation_ascend_alphabet,
-   xmb_list_insert,
+   NULL,
    xmb_list_delete,
    NULL,
    xmb_list_cache,
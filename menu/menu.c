@@ -268,6 +268,13 @@ void menu_free(menu_handle_t *menu)
    menu_list_free(menu->menu_list);
    menu->menu_list = NULL;
 
+   /* Freed in the middle of a search. */
+   if (menu->search.list)
+      file_list_free(menu->search.list);
+   menu->search.list = NULL;
+   menu_search_free(menu->search.index);
+   menu->search.index = NULL;
+
    event_command(EVENT_CMD_HISTORY_DEINIT);
 
    if (global->core_info)
@@ -352,6 +359,7 @@ int menu_iterate(retro_input_t input,
 {
    static retro_time_t last_clock_update = 0;
    int32_t ret          = 0;
+   bool changed         = false;
    unsigned action      = menu_input_frame(input, trigger_input);
    runloop_t *runloop   = rarch_main_get_ptr();
    menu_handle_t *menu  = menu_driver_get_ptr();
@@ -366,16 +374,33 @@ int menu_iterate(retro_input_t input,
       menu->dt = IDEAL_DT / 4;
    menu->old_time = menu->cur_time;
 
+   if (menu_input_search_iterate())
+      action = MENU_ACTION_NOOP;
+
    if (menu->cur_time - last_clock_update > 1000000 && settings->menu.timedate_enable)
    {
       runloop->frames.video.current.menu.label.is_updated = true;
       last_clock_update = menu->cur_time;
    }
 
+   changed = action != MENU_ACTION_NOOP || menu->need_refresh ||
+      menu->keyboard.display || menu_display_update_pending() ||
+      menu->animation->size;
+
+   menu_entries_parse_list_iterate();
+
    menu_driver_entry_iterate(action);
 
+   /* Animations the driver started or finished this frame. */
+   changed = changed || menu->animation->size;
+
    if (runloop->is_menu && !runloop->is_idle)
-      menu_display_fb();
+   {
+      if (menu_display_frame_is_retained(changed))
+         rarch_sleep(1000 / max(settings->video.refresh_rate, 1.0f));
+      else
+         menu_display_fb();
+   }
 
    menu_driver_set_texture();
 
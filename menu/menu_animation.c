@@ -249,207 +249,202 @@ static float easing_out_in_bounce(float t, float b, float c, float d)
    return easing_in_bounce((t * 2) - d, b + c / 2, c / 2, d);
 }
 
+static const easingFunc menu_animation_easings[EASING_LAST] = {
+   /* Linear */
+   easing_linear,
+   /* Quad */
+   easing_in_quad,
+   easing_out_quad,
+   easing_in_out_quad,
+   easing_out_in_quad,
+   /* Cubic */
+   easing_in_cubic,
+   easing_out_cubic,
+   easing_in_out_cubic,
+   easing_out_in_cubic,
+   /* Quart */
+   easing_in_quart,
+   easing_out_quart,
+   easing_in_out_quart,
+   easing_out_in_quart,
+   /* Quint */
+   easing_in_quint,
+   easing_out_quint,
+   easing_in_out_quint,
+   easing_out_in_quint,
+   /* Sine */
+   easing_in_sine,
+   easing_out_sine,
+   easing_in_out_sine,
+   easing_out_in_sine,
+   /* Expo */
+   easing_in_expo,
+   easing_out_expo,
+   easing_in_out_expo,
+   easing_out_in_expo,
+   /* Circ */
+   easing_in_circ,
+   easing_out_circ,
+   easing_in_out_circ,
+   easing_out_in_circ,
+   /* Bounce */
+   easing_in_bounce,
+   easing_out_bounce,
+   easing_in_out_bounce,
+   easing_out_in_bounce,
+};
+
 void menu_animation_free(animation_t *animation)
 {
-   size_t i;
+   unsigned i;
 
    if (!animation)
       return;
 
-   for (i = 0; i < animation->size; i++)
+   for (i = 0; i < EASING_LAST; i++)
    {
-      if (animation->list[i].subject)
-         animation->list[i].subject = NULL;
+      struct tween_list *list = &animation->tweens[i];
+
+      free(list->duration);
+      free(list->running_since);
+      free(list->initial_value);
+      free(list->target_value);
+      free(list->subject);
+      free(list->cb);
    }
 
-   free(animation->list);
    free(animation);
 }
 
+static bool menu_animation_reserve(struct tween_list *list, size_t capacity)
+{
+   void *ptr;
+
+   if (!(ptr = realloc(list->duration, capacity * sizeof(float))))
+      return false;
+   list->duration = (float*)ptr;
+
+   if (!(ptr = realloc(list->running_since, capacity * sizeof(float))))
+      return false;
+   list->running_since = (float*)ptr;
+
+   if (!(ptr = realloc(list->initial_value, capacity * sizeof(float))))
+      return false;
+   list->initial_value = (float*)ptr;
+
+   if (!(ptr = realloc(list->target_value, capacity * sizeof(float))))
+      return false;
+   list->target_value = (float*)ptr;
+
+   if (!(ptr = realloc(list->subject, capacity * sizeof(float*))))
+      return false;
+   list->subject = (float**)ptr;
+
+   if (!(ptr = realloc(list->cb, capacity * sizeof(tween_cb))))
+      return false;
+   list->cb = (tween_cb*)ptr;
+
+   list->capacity = capacity;
+   return true;
+}
+
 bool menu_animation_push(animation_t *animation,
       float duration, float target_value, float* subject,
       enum animation_easing_type easing_enum, tween_cb cb)
 {
-   if (animation->size >= animation->capacity)
-   {
-      animation->capacity++;
-      animation->list = (struct tween*)realloc(animation->list,
-            animation->capacity * sizeof(struct tween));
-   }
+   struct tween_list *list;
 
-   animation->list[animation->size].alive         = 1;
-   animation->list[animation->size].duration      = duration;
-   animation->list[animation->size].running_since = 0;
-   animation->list[animation->size].initial_value = *subject;
-   animation->list[animation->size].target_value  = target_value;
-   animation->list[animation->size].subject       = subject;
-   animation->list[animation->size].cb            = cb;
+   if ((unsigned)easing_enum >= EASING_LAST)
+      return false;
 
-   switch (easing_enum)
-   {
-      case EASING_LINEAR:
-         animation->list[animation->size].easing        = &easing_linear;
-         break;
-         /* Quad */
-      case EASING_IN_QUAD:
-         animation->list[animation->size].easing        = &easing_in_quad;
-         break;
-      case EASING_OUT_QUAD:
-         animation->list[animation->size].easing        = &easing_out_quad;
-         break;
-      case EASING_IN_OUT_QUAD:
-         animation->list[animation->size].easing        = &easing_in_out_quad;
-         break;
-      case EASING_OUT_IN_QUAD:
-         animation->list[animation->size].easing        = &easing_out_in_quad;
-         break;
-         /* Cubic */
-      case EASING_IN_CUBIC:
-         animation->list[animation->size].easing        = &easing_in_cubic;
-         break;
-      case EASING_OUT_CUBIC:
-         animation->list[animation->size].easing        = &easing_out_cubic;
-         break;
-      case EASING_IN_OUT_CUBIC:
-         animation->list[animation->size].easing        = &easing_in_out_cubic;
-         break;
-      case EASING_OUT_IN_CUBIC:
-         animation->list[animation->size].easing        = &easing_out_in_cubic;
-         break;
-         /* Quart */
-      case EASING_IN_QUART:
-         animation->list[animation->size].easing        = &easing_in_quart;
-         break;
-      case EASING_OUT_QUART:
-         animation->list[animation->size].easing        = &easing_out_quart;
-         break;
-      case EASING_IN_OUT_QUART:
-         animation->list[animation->size].easing        = &easing_in_out_quart;
-         break;
-      case EASING_OUT_IN_QUART:
-         animation->list[animation->size].easing        = &easing_out_in_quart;
-         break;
-         /* Quint */
-      case EASING_IN_QUINT:
-         animation->list[animation->size].easing        = &easing_in_quint;
-         break;
-      case EASING_OUT_QUINT:
-         animation->list[animation->size].easing        = &easing_out_quint;
-         break;
-      case EASING_IN_OUT_QUINT:
-         animation->list[animation->size].easing        = &easing_in_out_quint;
-         break;
-      case EASING_OUT_IN_QUINT:
-         animation->list[animation->size].easing        = &easing_out_in_quint;
-         break;
-         /* Sine */
-      case EASING_IN_SINE:
-         animation->list[animation->size].easing        = &easing_in_sine;
-         break;
-      case EASING_OUT_SINE:
-         animation->list[animation->size].easing        = &easing_out_sine;
-         break;
-      case EASING_IN_OUT_SINE:
-         animation->list[animation->size].easing        = &easing_in_out_sine;
-         break;
-      case EASING_OUT_IN_SINE:
-         animation->list[animation->size].easing        = &easing_out_in_sine;
-         break;
-         /* Expo */
-      case EASING_IN_EXPO:
-         animation->list[animation->size].easing        = &easing_in_expo;
-         break;
-      case EASING_OUT_EXPO:
-         animation->list[animation->size].easing        = &easing_out_expo;
-         break;
-      case EASING_IN_OUT_EXPO:
-         animation->list[animation->size].easing        = &easing_in_out_expo;
-         break;
-      case EASING_OUT_IN_EXPO:
-         animation->list[animation->size].easing        = &easing_out_in_expo;
-         break;
-         /* Circ */
-      case EASING_IN_CIRC:
-         animation->list[animation->size].easing        = &easing_in_circ;
-         break;
-      case EASING_OUT_CIRC:
-         animation->list[animation->size].easing        = &easing_out_circ;
-         break;
-      case EASING_IN_OUT_CIRC:
-         animation->list[animation->size].easing        = &easing_in_out_circ;
-         break;
-      case EASING_OUT_IN_CIRC:
-         animation->list[animation->size].easing        = &easing_out_in_circ;
-         break;
-         /* Bounce */
-      case EASING_IN_BOUNCE:
-         animation->list[animation->size].easing        = &easing_in_bounce;
-         break;
-      case EASING_OUT_BOUNCE:
-         animation->list[animation->size].easing        = &easing_out_bounce;
-         break;
-      case EASING_IN_OUT_BOUNCE:
-         animation->list[animation->size].easing        = &easing_in_out_bounce;
-         break;
-      case EASING_OUT_IN_BOUNCE:
-         animation->list[animation->size].easing        = &easing_out_in_bounce;
-         break;
-      default:
-         animation->list[animation->size].easing        = NULL;
-         break;
-   }
+   list = &animation->tweens[easing_enum];
+
+   if (list->size >= list->capacity &&
+         !menu_animation_reserve(list, list->capacity ? list->capacity * 2 : 16))
+      return false;
+
+   list->duration[list->size]      = duration;
+   list->running_since[list->size] = 0;
+   list->initial_value[list->size] = *subject;
+   list->target_value[list->size]  = target_value;
+   list->subject[list->size]       = subject;
+   list->cb[list->size]            = cb;
 
+   list->size++;
    animation->size++;
 
    return true;
 }
 
-static int menu_animation_iterate(struct tween *tween, float dt,
-      unsigned *active_tweens)
+/**
+ * menu_animation_update_list:
+ * @list                     : Tweens of one easing type.
+ * @easing                   : Easing function of @list.
+ * @dt                       : Time elapsed.
+ *
+ * Advances the tweens of @list, and removes the ones which
+ * finished. Callbacks may push new tweens, which are updated
+ * in the same pass if they go into @list.
+ **/
+static void menu_animation_update_list(struct tween_list *list,
+      easingFunc easing, float dt)
 {
-   if (!tween)
-      return -1;
-   if (tween->running_since >= tween->duration)
-      return -1;
-
-   tween->running_since += dt;
+   size_t i, j;
 
-   if (tween->easing)
-      *tween->subject = tween->easing(
-            tween->running_since,
-            tween->initial_value,
-            tween->target_value - tween->initial_value,
-            tween->duration);
-
-   if (tween->running_since >= tween->duration)
+   for (i = j = 0; i < list->size; i++)
    {
-      *tween->subject = tween->target_value;
-
-      if (tween->cb)
-         tween->cb();
+      float running_since = list->running_since[i] + dt;
+      float duration      = list->duration[i];
+
+      if (running_since >= duration)
+      {
+         *list->subject[i] = list->target_value[i];
+
+         if (list->cb[i])
+            list->cb[i]();
+         continue;
+      }
+
+      *list->subject[i] = easing(running_since, list->initial_value[i],
+            list->target_value[i] - list->initial_value[i], duration);
+
+      list->duration[j]      = duration;
+      list->running_since[j] = running_since;
+      list->initial_value[j] = list->initial_value[i];
+      list->target_value[j]  = list->target_value[i];
+      list->subject[j]       = list->subject[i];
+      list->cb[j]            = list->cb[i];
+      j++;
    }
 
-   if (tween->running_since < tween->duration)
-      *active_tweens += 1;
-
-   return 0;
+   list->size = j;
 }
 
 bool menu_animation_update(animation_t *animation, float dt)
 {
    unsigned i;
-   unsigned active_tweens = 0;
-   runloop_t *runloop = rarch_main_get_ptr();
+   size_t active_tweens = 0;
+   runloop_t *runloop   = rarch_main_get_ptr();
 
-   for(i = 0; i < animation->size; i++)
-      menu_animation_iterate(&animation->list[i], dt, &active_tweens);
+   if (!animation->size)
+      return false;
 
-   if (!active_tweens)
+   for (i = 0; i < EASING_LAST; i++)
    {
-      animation->size = 0;
-      return false;
+      if (animation->tweens[i].size)
+         menu_animation_update_list(&animation->tweens[i],
+               menu_animation_easings[i], dt);
    }
 
+   /* After all lists, as callbacks may push to any of them. */
+   for (i = 0; i < EASING_LAST; i++)
+      active_tweens += animation->tweens[i].size;
+
+   animation->size = active_tweens;
+
+   if (!active_tweens)
+      return false;
+
    runloop->frames.video.current.menu.animation.is_active = true;
 
    return true;
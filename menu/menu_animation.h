@@ -28,26 +28,6 @@ extern "C" {
 typedef float (*easingFunc)(float, float, float, float);
 typedef void  (*tween_cb) (void);
 
-struct tween
-{
-   int    alive;
-   float  duration;
-   float  running_since;
-   float  initial_value;
-   float  target_value;
-   float* subject;
-   easingFunc easing;
-   tween_cb cb;
-};
-
-typedef struct animation
-{
-   struct tween *list;
-
-   size_t capacity;
-   size_t size;
-} animation_t;
-
 enum animation_easing_type
 {
    /* Linear */
@@ -92,8 +72,34 @@ enum animation_easing_type
    EASING_OUT_BOUNCE,
    EASING_IN_OUT_BOUNCE,
    EASING_OUT_IN_BOUNCE,
+
+   EASING_LAST
 };
 
+/* The tweens of one easing type, as parallel arrays, so that
+ * updating them is a loop over each array. Finished tweens are
+ * removed, keeping the others in the order they were pushed. */
+struct tween_list
+{
+   float    *duration;
+   float    *running_since;
+   float    *initial_value;
+   float    *target_value;
+   float   **subject;
+   tween_cb *cb;
+
+   size_t capacity;
+   size_t size;
+};
+
+typedef struct animation
+{
+   struct tween_list tweens[EASING_LAST];
+
+   /* Tweens still running, of all easing types. */
+   size_t size;
+} animation_t;
+
 void menu_animation_free(animation_t *animation);
 
 bool menu_animation_push(animation_t *animation, float duration,
@@ -40,7 +40,7 @@ void menu_common_list_insert(void *data,
       return;
 
    list->list[idx].actiondata = (menu_file_list_cbs_t*)
-      calloc(1, sizeof(menu_file_list_cbs_t));
+      file_list_alloc(list, sizeof(menu_file_list_cbs_t));
 
    if (!list->list[idx].actiondata)
    {
@@ -62,14 +62,6 @@ void menu_common_list_delete(void *data, size_t idx,
 
    cbs = (menu_file_list_cbs_t*)list->list[idx].actiondata;
 
-   if (cbs)
-   {
-      cbs->action_start         = NULL;
-      cbs->action_ok            = NULL;
-      cbs->action_cancel        = NULL;
-      cbs->action_toggle        = NULL;
-      cbs->action_deferred_push = NULL;
-      free(list->list[idx].actiondata);
-   }
+   file_list_release(list, cbs);
    list->list[idx].actiondata = NULL;
 }
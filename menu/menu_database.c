@@ -13,34 +13,229 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <string/string_list.h>
+
 #include "menu.h"
 #include "menu_database.h"
 #include "menu_list.h"
 #include "menu_entries.h"
 #include "../playlist.h"
-#include <string.h>
 
-int menu_database_populate_query(file_list_t *list, const char *path,
+#ifdef HAVE_LIBRETRODB
+/* Results of the last few queries, so going back and forth
+ * between database lists doesn't read and sort the whole
+ * database again. Entries are dropped when the database file
+ * changes size or mtime. */
+#define MENU_DATABASE_CACHE_SIZE 8
+
+struct menu_database_cache
+{
+   char path[PATH_MAX_LENGTH];
+   char *query;
+   time_t mtime;
+   long size;
+   /* Names of the matching entries, sorted. */
+   struct string_list *names;
+   /* Or, for menu_database_info_list(), the entries themselves. */
+   database_info_list_t *info;
+};
+
+static struct menu_database_cache
+   menu_database_cache[MENU_DATABASE_CACHE_SIZE];
+static unsigned menu_database_cache_next;
+
+static void menu_database_cache_entry_free(struct menu_database_cache *entry)
+{
+   if (entry->names)
+      string_list_free(entry->names);
+   if (entry->info)
+      database_info_list_free(entry->info);
+   free(entry->query);
+
+   memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * menu_database_cache_find:
+ * @path                  : Path of the database.
+ * @query                 : Query, or NULL for all entries.
+ * @st                    : Status of the database file.
+ * @info                  : Look for a menu_database_info_list()
+ *                          result rather than a list of names.
+ *
+ * Returns: the cached result of @query on @path, or NULL if there
+ * is none for the database as it is now.
+ **/
+static struct menu_database_cache *menu_database_cache_find(
+      const char *path, const char *query, const struct stat *st,
+      bool info)
+{
+   unsigned i;
+
+   if (!query)
+      query = "";
+
+   for (i = 0; i < MENU_DATABASE_CACHE_SIZE; i++)
+   {
+      struct menu_database_cache *entry = &menu_database_cache[i];
+
+      if (!entry->query || (entry->info != NULL) != info)
+         continue;
+      if (entry->mtime != st->st_mtime || entry->size != (long)st->st_size)
+         continue;
+      if (!strcmp(entry->path, path) && !strcmp(entry->query, query))
+         return entry;
+   }
+
+   return NULL;
+}
+
+static struct menu_database_cache *menu_database_cache_add(
+      const char *path, const char *query, const struct stat *st)
+{
+   struct menu_database_cache *entry =
+      &menu_database_cache[menu_database_cache_next];
+
+   menu_database_cache_entry_free(entry);
+
+   entry->query = strdup(query ? query : "");
+   if (!entry->query)
+      return NULL;
+
+   strlcpy(entry->path, path, sizeof(entry->path));
+   entry->mtime = st->st_mtime;
+   entry->size  = (long)st->st_size;
+
+   menu_database_cache_next = (menu_database_cache_next + 1)
+      % MENU_DATABASE_CACHE_SIZE;
+
+   return entry;
+}
+
+static int menu_database_read_query(file_list_t *list, const char *path,
     const char *query)
 {
-#ifdef HAVE_LIBRETRODB
+   int ret = 0;
    libretrodb_t db;
    libretrodb_cursor_t cur;
 
    if ((libretrodb_open(path, &db)) != 0)
       return -1;
    if ((database_open_cursor(&db, &cur, query) != 0))
+   {
+      libretrodb_close(&db);
       return -1;
-   if ((menu_entries_push_query(&db, &cur, list)) != 0)
-      return -1;
+   }
+
+   ret = menu_entries_push_query(&db, &cur, list);
 
    libretrodb_cursor_close(&cur);
    libretrodb_close(&db);
+
+   return ret;
+}
+#endif
+
+void menu_database_cache_clear(void)
+{
+#ifdef HAVE_LIBRETRODB
+   unsigned i;
+
+   for (i = 0; i < MENU_DATABASE_CACHE_SIZE; i++)
+      menu_database_cache_entry_free(&menu_database_cache[i]);
+   menu_database_cache_next = 0;
+#endif
+}
+
+int menu_database_populate_query(file_list_t *list, const char *path,
+    const char *query)
+{
+#ifdef HAVE_LIBRETRODB
+   size_t i, start;
+   struct stat st;
+   union string_list_elem_attr attr;
+   struct menu_database_cache *entry = NULL;
+   bool cacheable = (stat(path, &st) == 0);
+
+   if (cacheable &&
+         (entry = menu_database_cache_find(path, query, &st, false)))
+   {
+      for (i = 0; i < entry->names->size; i++)
+         menu_list_push(list, entry->names->elems[i].data, path,
+               MENU_FILE_RDB_ENTRY, 0);
+      return 0;
+   }
+
+   start = file_list_get_size(list);
+
+   if (menu_database_read_query(list, path, query) != 0)
+      return -1;
+
+   menu_list_sort_on_alt(list);
+
+   if (!cacheable || !(entry = menu_database_cache_add(path, query, &st)))
+      return 0;
+
+   if (!(entry->names = string_list_new()))
+   {
+      menu_database_cache_entry_free(entry);
+      return 0;
+   }
+
+   attr.i = 0;
+
+   for (i = start; i < file_list_get_size(list); i++)
+   {
+      const char *name = NULL;
+
+      menu_list_get_at_offset(list, i, &name, NULL, NULL);
+
+      if (!string_list_append(entry->names, name ? name : "", attr))
+      {
+         menu_database_cache_entry_free(entry);
+         break;
+      }
+   }
 #endif
 
    return 0;
 }
 
+database_info_list_t *menu_database_info_list(const char *path,
+      const char *query)
+{
+#ifdef HAVE_LIBRETRODB
+   struct stat st;
+   struct menu_database_cache *entry = NULL;
+   database_info_list_t *info        = NULL;
+
+   if (stat(path, &st) != 0)
+      return NULL;
+
+   if ((entry = menu_database_cache_find(path, query, &st, true)))
+      return entry->info;
+
+   if (!(info = database_info_list_new(path, query)))
+      return NULL;
+
+   if (!(entry = menu_database_cache_add(path, query, &st)))
+   {
+      database_info_list_free(info);
+      return NULL;
+   }
+
+   entry->info = info;
+   return info;
+#else
+   return NULL;
+#endif
+}
+
 static void menu_database_playlist_free(menu_handle_t *menu)
 {
    if (menu->db_playlist)
@@ -54,6 +249,7 @@ void menu_database_free(void *data)
    if (!menu)
       return;
    menu_database_playlist_free(menu);
+   menu_database_cache_clear();
 }
 
 bool menu_database_realloc(const char *path,
@@ -28,9 +28,41 @@
 extern "C" {
 #endif
     
+/**
+ * menu_database_populate_query:
+ * @list                  : List to append the entries to.
+ * @path                  : Path of the database.
+ * @query                 : Query, or NULL for all entries.
+ *
+ * Appends the names of the entries of @path matching @query,
+ * sorted. Results are cached until the database file changes.
+ *
+ * Returns: 0 if successful, otherwise -1.
+ **/
 int menu_database_populate_query(file_list_t *list, const char *path,
                                      const char *query);
 
+/**
+ * menu_database_info_list:
+ * @path                  : Path of the database.
+ * @query                 : Query, or NULL for all entries.
+ *
+ * Like database_info_list_new(), but the result is cached until
+ * the database file changes. It belongs to the cache, and stays
+ * valid until the next call or until menu_database_cache_clear().
+ *
+ * Returns: the entries of @path matching @query, or NULL.
+ **/
+database_info_list_t *menu_database_info_list(const char *path,
+      const char *query);
+
+/**
+ * menu_database_cache_clear:
+ *
+ * Drops all cached query results.
+ **/
+void menu_database_cache_clear(void);
+
 void menu_database_free(void *data);
 
 bool menu_database_realloc(const char *path,
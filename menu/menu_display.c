@@ -18,8 +18,13 @@
 #include "menu_animation.h"
 #include "../dynamic.h"
 #include "../../retroarch.h"
+#include "../performance.h"
 #include "../gfx/video_context_driver.h"
 
+#ifdef HAVE_OPENGL
+#include "../gfx/drivers/gl_common.h"
+#endif
+
 bool menu_display_update_pending(void)
 {
    runloop_t *runloop = rarch_main_get_ptr();
@@ -32,6 +37,50 @@ bool menu_display_update_pending(void)
    return false;
 }
 
+/**
+ * menu_display_frame_is_retained:
+ * @changed                  : did input, animations or labels change
+ *                             anything this frame?
+ *
+ * With menu throttling enabled, an idle menu keeps its last frame
+ * on screen instead of drawing a new one, except every
+ * MENU_IDLE_FRAME_USEC, so the window keeps getting pumped.
+ * Content running behind the menu and OSD messages that still
+ * have to expire always get their frames.
+ *
+ * Returns: true (1) if drawing this frame can be skipped,
+ * otherwise false (0).
+ **/
+bool menu_display_frame_is_retained(bool changed)
+{
+   retro_time_t now;
+   runloop_t *runloop   = rarch_main_get_ptr();
+   global_t *global     = global_get_ptr();
+   settings_t *settings = config_get_ptr();
+
+   if (!runloop || !settings->menu.throttle)
+      return false;
+
+   if (!settings->menu.pause_libretro
+         && global->main_is_init && !global->libretro_dummy)
+      return false;
+
+   if (runloop->frames.video.current.menu.msg.frames)
+   {
+      runloop->frames.video.current.menu.msg.frames--;
+      changed = true;
+   }
+
+   now = rarch_get_time_usec();
+
+   if (!changed && now - runloop->frames.video.current.menu.idle.time
+         < MENU_IDLE_FRAME_USEC)
+      return true;
+
+   runloop->frames.video.current.menu.idle.time = now;
+   return false;
+}
+
 /**
  ** menu_display_fb:
  *
@@ -50,6 +99,7 @@ void menu_display_fb(void)
       if (global->main_is_init && !global->libretro_dummy)
       {
          bool block_libretro_input = driver->block_libretro_input;
+         init_drivers_deferred();
          driver->block_libretro_input = true;
          pretro_run();
          driver->block_libretro_input = block_libretro_input;
@@ -60,11 +110,208 @@ void menu_display_fb(void)
    rarch_render_cached_frame();
 }
 
+#ifdef HAVE_OPENGL
+typedef struct menu_display_quad
+{
+   GLuint texture;
+   /* Submission order, keeps sorting by texture stable. */
+   unsigned order;
+   GLfloat x, y, w, h;
+   GLfloat color[4];
+} menu_display_quad_t;
+
+static struct
+{
+   menu_display_quad_t *quads;
+   size_t size;
+   size_t capacity;
+
+   /* Vertices of the last flush, six per quad. */
+   GLfloat *vertex;
+   GLfloat *tex_coord;
+   GLfloat *color;
+   size_t vertex_capacity;
+} menu_display_batch;
+
+/**
+ * menu_display_batch_quad:
+ * @texture             : texture of the quad, 0 for a solid color.
+ * @x                   : left edge, in window pixels.
+ * @y                   : bottom edge, in window pixels from the bottom.
+ * @w                   : width, in window pixels.
+ * @h                   : height, in window pixels.
+ * @color               : RGBA the texture is modulated with.
+ *
+ * Queues up a quad for the next menu_display_batch_flush().
+ * Quads are drawn grouped by texture, so quads that overlap
+ * and have to be drawn in order belong to different batches.
+ **/
+void menu_display_batch_quad(unsigned texture,
+      float x, float y, float w, float h, const float *color)
+{
+   menu_display_quad_t *quad = NULL;
+
+   if (menu_display_batch.size == menu_display_batch.capacity)
+   {
+      size_t capacity = menu_display_batch.capacity ?
+         menu_display_batch.capacity * 2 : 64;
+      menu_display_quad_t *quads = (menu_display_quad_t*)
+         realloc(menu_display_batch.quads, capacity * sizeof(*quads));
+
+      if (!quads)
+         return;
+
+      menu_display_batch.quads    = quads;
+      menu_display_batch.capacity = capacity;
+   }
+
+   quad          = &menu_display_batch.quads[menu_display_batch.size];
+   quad->texture = texture;
+   quad->order   = menu_display_batch.size++;
+   quad->x       = x;
+   quad->y       = y;
+   quad->w       = w;
+   quad->h       = h;
+   memcpy(quad->color, color, sizeof(quad->color));
+}
+
+static int menu_display_quad_compare(const void *a_, const void *b_)
+{
+   const menu_display_quad_t *a = (const menu_display_quad_t*)a_;
+   const menu_display_quad_t *b = (const menu_display_quad_t*)b_;
+
+   if (a->texture != b->texture)
+      return a->texture < b->texture ? -1 : 1;
+   return a->order < b->order ? -1 : (a->order > b->order);
+}
+
+static bool menu_display_batch_reserve(size_t vertices)
+{
+   GLfloat *vertex, *tex_coord, *color;
+
+   if (vertices <= menu_display_batch.vertex_capacity)
+      return true;
+
+   vertex    = (GLfloat*)realloc(menu_display_batch.vertex,
+         2 * vertices * sizeof(GLfloat));
+   if (vertex)
+      menu_display_batch.vertex = vertex;
+   tex_coord = (GLfloat*)realloc(menu_display_batch.tex_coord,
+         2 * vertices * sizeof(GLfloat));
+   if (tex_coord)
+      menu_display_batch.tex_coord = tex_coord;
+   color     = (GLfloat*)realloc(menu_display_batch.color,
+         4 * vertices * sizeof(GLfloat));
+   if (color)
+      menu_display_batch.color = color;
+
+   if (!vertex || !tex_coord || !color)
+      return false;
+
+   menu_display_batch.vertex_capacity = vertices;
+   return true;
+}
+
+/**
+ * menu_display_batch_flush:
+ * @data                : GL driver handle.
+ *
+ * Draws the quads queued up since the last flush with one
+ * vertex upload and one draw call per texture, blended over
+ * the whole window with the stock shader.
+ **/
+void menu_display_batch_flush(void *data)
+{
+   size_t i, first;
+   struct gl_coords coords;
+   gl_t *gl = (gl_t*)data;
+   size_t size = menu_display_batch.size;
+
+   menu_display_batch.size = 0;
+
+   if (!gl || !size || !menu_display_batch_reserve(size * 6))
+      return;
+
+   qsort(menu_display_batch.quads, size,
+         sizeof(*menu_display_batch.quads), menu_display_quad_compare);
+
+   for (i = 0; i < size; i++)
+   {
+      unsigned j;
+      const menu_display_quad_t *quad = &menu_display_batch.quads[i];
+      GLfloat *vertex    = menu_display_batch.vertex    + i * 12;
+      GLfloat *tex_coord = menu_display_batch.tex_coord + i * 12;
+      GLfloat *color     = menu_display_batch.color     + i * 24;
+      GLfloat x0 = quad->x / gl->win_width;
+      GLfloat y0 = quad->y / gl->win_height;
+      GLfloat x1 = (quad->x + quad->w) / gl->win_width;
+      GLfloat y1 = (quad->y + quad->h) / gl->win_height;
+      /* Two triangles, textures are stored upside down. */
+      const GLfloat quad_vertex[]    = {
+         x0, y0, x1, y0, x0, y1,
+         x0, y1, x1, y0, x1, y1 };
+      const GLfloat quad_tex_coord[] = {
+         0, 1, 1, 1, 0, 0,
+         0, 0, 1, 1, 1, 0 };
+
+      memcpy(vertex,    quad_vertex,    sizeof(quad_vertex));
+      memcpy(tex_coord, quad_tex_coord, sizeof(quad_tex_coord));
+      for (j = 0; j < 6; j++)
+         memcpy(color + j * 4, quad->color, sizeof(quad->color));
+   }
+
+   glViewport(0, 0, gl->win_width, gl->win_height);
+
+   coords.vertices      = size * 6;
+   coords.vertex        = menu_display_batch.vertex;
+   coords.tex_coord     = menu_display_batch.tex_coord;
+   coords.lut_tex_coord = menu_display_batch.tex_coord;
+   coords.color         = menu_display_batch.color;
+
+   if (gl->shader && gl->shader->use)
+      gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
+
+   gl->shader->set_coords(&coords);
+   gl->shader->set_mvp(gl, &gl->mvp_no_rot);
+
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+   for (first = 0, i = 1; i <= size; i++)
+   {
+      if (i < size && menu_display_batch.quads[i].texture
+            == menu_display_batch.quads[first].texture)
+         continue;
+
+      glBindTexture(GL_TEXTURE_2D, menu_display_batch.quads[first].texture);
+      glDrawArrays(GL_TRIANGLES, first * 6, (i - first) * 6);
+      first = i;
+   }
+
+   glDisable(GL_BLEND);
+
+   gl->coords.color = gl->white_color_ptr;
+}
+
+static void menu_display_batch_free(void)
+{
+   free(menu_display_batch.quads);
+   free(menu_display_batch.vertex);
+   free(menu_display_batch.tex_coord);
+   free(menu_display_batch.color);
+   memset(&menu_display_batch, 0, sizeof(menu_display_batch));
+}
+#endif
+
 void menu_display_free(menu_handle_t *menu)
 {
    if (!menu)
       return;
 
+#ifdef HAVE_OPENGL
+   menu_display_batch_free();
+#endif
+
    menu_animation_free(menu->animation);
    menu->animation = NULL;
 }
@@ -18,6 +18,9 @@
 
 #include "menu_driver.h"
 
+/* How often an idle, throttled menu is still drawn. */
+#define MENU_IDLE_FRAME_USEC 100000
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,8 +33,38 @@ bool menu_display_init(menu_handle_t *menu);
 
 bool menu_display_update_pending(void);
 
+bool menu_display_frame_is_retained(bool changed);
+
 float menu_display_get_dpi(menu_handle_t *menu);
 
+#ifdef HAVE_OPENGL
+/**
+ * menu_display_batch_quad:
+ * @texture             : texture of the quad, 0 for a solid color.
+ * @x                   : left edge, in window pixels.
+ * @y                   : bottom edge, in window pixels from the bottom.
+ * @w                   : width, in window pixels.
+ * @h                   : height, in window pixels.
+ * @color               : RGBA the texture is modulated with.
+ *
+ * Queues up a quad for the next menu_display_batch_flush().
+ * Quads are drawn grouped by texture, so quads that overlap
+ * and have to be drawn in order belong to different batches.
+ **/
+void menu_display_batch_quad(unsigned texture,
+      float x, float y, float w, float h, const float *color);
+
+/**
+ * menu_display_batch_flush:
+ * @data                : GL driver handle.
+ *
+ * Draws the quads queued up since the last flush with one
+ * vertex upload and one draw call per texture, blended over
+ * the whole window with the stock shader.
+ **/
+void menu_display_batch_flush(void *data);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
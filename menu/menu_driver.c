@@ -21,6 +21,7 @@
 #include "menu_entries.h"
 #include "../driver.h"
 #include "../general.h"
+#include "../performance.h"
 
 static const menu_ctx_driver_t *menu_ctx_drivers[] = {
 #if defined(HAVE_RMENU)
@@ -280,8 +281,12 @@ void menu_driver_context_reset(void)
 {
    const menu_ctx_driver_t *driver = menu_ctx_driver_get_ptr();
 
-   if (driver->context_reset)
-      driver->context_reset();
+   if (!driver->context_reset)
+      return;
+
+   RARCH_TRACE_BEGIN("menu_driver_context_reset");
+   driver->context_reset();
+   RARCH_TRACE_END("menu_driver_context_reset");
 }
 
 void menu_driver_frame(void)
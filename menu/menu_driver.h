@@ -24,6 +24,7 @@
 #include <queues/message_queue.h>
 #include "menu_animation.h"
 #include "menu_list.h"
+#include "menu_search.h"
 #include "menu_database.h"
 #include "../settings_list.h"
 #include "../playlist.h"
@@ -203,6 +204,20 @@ typedef struct
       unsigned idx;
    } keyboard;
 
+   /* Type-ahead search. While the user types, the selection
+    * buffer only holds the matches, and the full list waits
+    * in 'list'. */
+   struct
+   {
+      menu_search_t *index;
+      file_list_t *list;
+      const size_t *matches;
+      size_t matches_size;
+      size_t selection;
+      char needle[PATH_MAX_LENGTH];
+      char label[64];
+   } search;
+
    rarch_setting_t *list_settings;
    animation_t *animation;
 
@@ -21,6 +21,7 @@
 #include <file/file_path.h>
 #include <file/file_extract.h>
 #include <file/dir_list.h>
+#include "../runloop_data.h"
 
 int menu_entries_setting_set_flags(rarch_setting_t *setting)
 {
@@ -53,11 +54,17 @@ int menu_entries_push_query(libretrodb_t *db,
 {
    unsigned i;
    struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_arena arena;
     
-   while (libretrodb_cursor_read_item(cur, &item) == 0)
+   rmsgpack_dom_arena_init(&arena, LIBRETRODB_ARENA_BLOCK_SIZE);
+    
+   while (libretrodb_cursor_read_item_arena(cur, &item, &arena) == 0)
    {
       if (item.type != RDT_MAP)
+      {
+         rmsgpack_dom_arena_reset(&arena);
          continue;
+      }
         
       for (i = 0; i < item.map.len; i++)
       {
@@ -74,7 +81,11 @@ int menu_entries_push_query(libretrodb_t *db,
             break;
          }
       }
+
+      rmsgpack_dom_arena_reset(&arena);
    }
+
+   rmsgpack_dom_arena_free(&arena);
     
    return 0;
 }
@@ -321,66 +332,36 @@ static void menu_entries_parse_drive_list(file_list_t *list)
 }
 
 
-int menu_entries_parse_list(
-      file_list_t *list, file_list_t *menu_list,
-      const char *dir, const char *label, unsigned type,
-      unsigned default_type_plain, const char *exts,
-      rarch_setting_t *setting)
-{
-   size_t i, list_size;
-   bool path_is_compressed, push_dir;
-   int                   device = 0;
-   struct string_list *str_list = NULL;
-   settings_t *settings         = config_get_ptr();
-   menu_handle_t *menu          = menu_driver_get_ptr();
-   global_t *global             = global_get_ptr();
-
-   (void)device;
-
-   if (!list || !menu_list)
-      return -1;
-
-   menu_list_clear(list);
-
-   if (!*dir)
-   {
-      menu_entries_parse_drive_list(list);
-      menu_driver_populate_entries(dir, label, type);
-      return 0;
-   }
-
-#if defined(GEKKO) && defined(HW_RVL)
-   slock_lock(gx_device_mutex);
-   device = gx_get_device_from_path(dir);
-
-   if (device != -1 && !gx_devices[device].mounted &&
-         gx_devices[device].interface->isInserted())
-      fatMountSimple(gx_devices[device].name, gx_devices[device].interface);
-
-   slock_unlock(gx_device_mutex);
-#endif
-
-   path_is_compressed = path_is_compressed_file(dir);
-   push_dir           = (setting && setting->browser_selection_type == ST_DIR);
-
-   if (path_is_compressed)
-      str_list = compressed_file_list_new(dir,exts);
-   else
-      str_list = dir_list_new(dir,
-            settings->menu.navigation.browser.filter.supported_extensions_enable 
-            ? exts : NULL, true);
-
-   if (push_dir)
-      menu_list_push(list, "<Use this directory>", "",
-            MENU_FILE_USE_DIRECTORY, 0);
-
-   if (!str_list)
-      return -1;
-
-   dir_list_sort(str_list, true);
+/* How long menu_entries_parse_list may read a directory before
+ * the rest of it is listed by the data runloop. */
+#define MENU_ENTRIES_DIR_LIST_USEC 20000
 
+/* Directory listing still being read by the data runloop. */
+static struct
+{
+   bool is_pending;
+   file_list_t *list;
+   char dir[PATH_MAX_LENGTH];
+   char label[PATH_MAX_LENGTH];
+   unsigned type;
+   unsigned default_type_plain;
+   bool push_dir;
+   /* Menu stack top the listing belongs to. */
+   size_t stack_size;
+   char stack_path[PATH_MAX_LENGTH];
+   char stack_label[PATH_MAX_LENGTH];
+   /* Selection asked for, and the one shown while streaming. */
+   size_t selection;
+   size_t selection_partial;
+} menu_entries_dir_list;
+
+static void menu_entries_parse_list_push(file_list_t *list,
+      const struct string_list *str_list, const char *dir,
+      const char *label, unsigned default_type_plain,
+      bool path_is_compressed, bool push_dir)
+{
+   size_t i;
 
-   list_size = str_list->size;
    for (i = 0; i < str_list->size; i++)
    {
       bool is_dir;
@@ -450,9 +431,235 @@ int menu_entries_parse_list(
       menu_list_push(list, path, "",
             file_type, 0);
    }
+}
+
+/**
+ * menu_entries_dir_list_is_current:
+ * @menu                     : Menu handle.
+ *
+ * Is the menu still showing the list the pending
+ * directory listing was started for?
+ *
+ * Returns: true (1) if it is, otherwise false (0).
+ **/
+static bool menu_entries_dir_list_is_current(menu_handle_t *menu)
+{
+   const char *path  = NULL;
+   const char *label = NULL;
+
+   if (!menu || menu_entries_dir_list.list != menu->menu_list->selection_buf)
+      return false;
+   if (menu_list_get_stack_size(menu->menu_list) !=
+         menu_entries_dir_list.stack_size)
+      return false;
+
+   menu_list_get_last_stack(menu->menu_list, &path, &label, NULL);
+
+   return !strcmp(path ? path : "", menu_entries_dir_list.stack_path) &&
+      !strcmp(label ? label : "", menu_entries_dir_list.stack_label);
+}
+
+/**
+ * menu_entries_parse_list_iterate:
+ *
+ * Adds the entries of a directory listing that is still being
+ * read in the background to the menu, and once it is complete,
+ * replaces them with the sorted listing. To be called every frame.
+ **/
+void menu_entries_parse_list_iterate(void)
+{
+   int ret;
+   size_t selection;
+   const char *selected         = NULL;
+   char selected_path[PATH_MAX_LENGTH];
+   struct string_list *str_list = NULL;
+   menu_handle_t *menu          = menu_driver_get_ptr();
+   file_list_t *list            = menu_entries_dir_list.list;
+
+   if (!menu_entries_dir_list.is_pending)
+      return;
+
+   if (!menu_entries_dir_list_is_current(menu))
+   {
+      rarch_main_data_dir_list_cancel();
+      menu_entries_dir_list.is_pending = false;
+      return;
+   }
+
+   ret = rarch_main_data_dir_list_poll(&str_list);
+
+   if (ret == 1)
+   {
+      if (str_list)
+         menu_entries_parse_list_push(list, str_list,
+               menu_entries_dir_list.dir, menu_entries_dir_list.label,
+               menu_entries_dir_list.default_type_plain, false,
+               menu_entries_dir_list.push_dir);
+      dir_list_free(str_list);
+      return;
+   }
+
+   menu_entries_dir_list.is_pending = false;
+
+   if (ret == -1)
+      return;
+
+   /* Keep what the user selected while the
+    * listing was streaming in, if anything. */
+   selection         = menu->navigation.selection_ptr;
+   selected_path[0]  = '\0';
+   if (selection != menu_entries_dir_list.selection_partial &&
+         selection < file_list_get_size(list))
+   {
+      menu_list_get_at_offset(list, selection, &selected, NULL, NULL);
+      if (selected)
+         strlcpy(selected_path, selected, sizeof(selected_path));
+   }
+   else
+      selection = menu_entries_dir_list.selection;
+
+   menu_list_clear(list);
+
+   if (menu_entries_dir_list.push_dir)
+      menu_list_push(list, "<Use this directory>", "",
+            MENU_FILE_USE_DIRECTORY, 0);
+
+   menu_entries_parse_list_push(list, str_list,
+         menu_entries_dir_list.dir, menu_entries_dir_list.label,
+         menu_entries_dir_list.default_type_plain, false,
+         menu_entries_dir_list.push_dir);
+   dir_list_free(str_list);
+
+   if (selected_path[0] != '\0')
+   {
+      size_t i;
+
+      for (i = 0; i < file_list_get_size(list); i++)
+      {
+         const char *path = NULL;
+
+         menu_list_get_at_offset(list, i, &path, NULL, NULL);
+         if (path && !strcmp(path, selected_path))
+         {
+            selection = i;
+            break;
+         }
+      }
+   }
+
+   menu->navigation.selection_ptr = selection;
+   menu_list_populate_generic(list, menu_entries_dir_list.dir,
+         menu_entries_dir_list.label, menu_entries_dir_list.type);
+   menu_navigation_set(&menu->navigation,
+         min(selection, file_list_get_size(list) ?
+            file_list_get_size(list) - 1 : 0), true);
+}
+
+int menu_entries_parse_list(
+      file_list_t *list, file_list_t *menu_list,
+      const char *dir, const char *label, unsigned type,
+      unsigned default_type_plain, const char *exts,
+      rarch_setting_t *setting)
+{
+   size_t i, list_size;
+   bool path_is_compressed, push_dir;
+   bool pending                 = false;
+   int                   device = 0;
+   struct string_list *str_list = NULL;
+   settings_t *settings         = config_get_ptr();
+   menu_handle_t *menu          = menu_driver_get_ptr();
+   global_t *global             = global_get_ptr();
+
+   (void)device;
+
+   if (!list || !menu_list)
+      return -1;
+
+   /* A new listing replaces the one still being read, if any. */
+   if (menu_entries_dir_list.is_pending)
+   {
+      rarch_main_data_dir_list_cancel();
+      menu_entries_dir_list.is_pending = false;
+   }
+
+   menu_list_clear(list);
+
+   if (!*dir)
+   {
+      menu_entries_parse_drive_list(list);
+      menu_driver_populate_entries(dir, label, type);
+      return 0;
+   }
+
+#if defined(GEKKO) && defined(HW_RVL)
+   slock_lock(gx_device_mutex);
+   device = gx_get_device_from_path(dir);
+
+   if (device != -1 && !gx_devices[device].mounted &&
+         gx_devices[device].interface->isInserted())
+      fatMountSimple(gx_devices[device].name, gx_devices[device].interface);
+
+   slock_unlock(gx_device_mutex);
+#endif
+
+   path_is_compressed = path_is_compressed_file(dir);
+   push_dir           = (setting && setting->browser_selection_type == ST_DIR);
+
+   if (path_is_compressed)
+      str_list = compressed_file_list_new(dir,exts);
+   else if (!strcmp(label, "core_list"))
+      str_list = dir_list_new(dir,
+            settings->menu.navigation.browser.filter.supported_extensions_enable 
+            ? exts : NULL, true);
+   else
+      str_list = rarch_main_data_dir_list_push(dir,
+            settings->menu.navigation.browser.filter.supported_extensions_enable 
+            ? exts : NULL, true, MENU_ENTRIES_DIR_LIST_USEC, &pending);
+
+   if (push_dir)
+      menu_list_push(list, "<Use this directory>", "",
+            MENU_FILE_USE_DIRECTORY, 0);
+
+   if (!str_list)
+      return -1;
+
+   if (path_is_compressed)
+      dir_list_sort(str_list, true);
+
+   menu_entries_parse_list_push(list, str_list, dir, label,
+         default_type_plain, path_is_compressed, push_dir);
 
    string_list_free(str_list);
 
+   if (pending)
+   {
+      const char *stack_path  = NULL;
+      const char *stack_label = NULL;
+
+      /* The rest of the directory streams in from the data runloop,
+       * see menu_entries_parse_list_iterate. */
+      menu_entries_dir_list.is_pending         = true;
+      menu_entries_dir_list.list               = list;
+      menu_entries_dir_list.type               = type;
+      menu_entries_dir_list.default_type_plain = default_type_plain;
+      menu_entries_dir_list.push_dir           = push_dir;
+      menu_entries_dir_list.selection          = menu->navigation.selection_ptr;
+      menu_entries_dir_list.stack_size         =
+         menu_list_get_stack_size(menu->menu_list);
+
+      menu_list_get_last_stack(menu->menu_list,
+            &stack_path, &stack_label, NULL);
+
+      strlcpy(menu_entries_dir_list.dir, dir,
+            sizeof(menu_entries_dir_list.dir));
+      strlcpy(menu_entries_dir_list.label, label,
+            sizeof(menu_entries_dir_list.label));
+      strlcpy(menu_entries_dir_list.stack_path, stack_path ? stack_path : "",
+            sizeof(menu_entries_dir_list.stack_path));
+      strlcpy(menu_entries_dir_list.stack_label, stack_label ? stack_label : "",
+            sizeof(menu_entries_dir_list.stack_label));
+   }
+
    if (!strcmp(label, "core_list"))
    {
       menu_list_get_last_stack(menu->menu_list, &dir, NULL, NULL);
@@ -480,6 +687,9 @@ int menu_entries_parse_list(
 
    menu_list_populate_generic(list, dir, label, type);
 
+   if (pending)
+      menu_entries_dir_list.selection_partial = menu->navigation.selection_ptr;
+
    return 0;
 }
 
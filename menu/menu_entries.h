@@ -34,6 +34,15 @@ int menu_entries_parse_list(file_list_t *list, file_list_t *menu_list,
       unsigned default_type_plain, const char *exts,
       rarch_setting_t *setting);
 
+/**
+ * menu_entries_parse_list_iterate:
+ *
+ * Adds the entries of a directory listing that is still being
+ * read in the background to the menu, and once it is complete,
+ * replaces them with the sorted listing. To be called every frame.
+ **/
+void menu_entries_parse_list_iterate(void);
+
 void menu_entries_cbs_init_bind_toggle(menu_file_list_cbs_t *cbs,
       const char *path, const char *label, unsigned type, size_t idx,
       const char *elem0, const char *elem1, const char *menu_label);
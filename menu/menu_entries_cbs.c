@@ -26,6 +26,7 @@
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../file_ops.h"
+#include "../hash.h"
 
 void menu_entries_common_load_content(bool persist)
 {
@@ -45,6 +46,36 @@ void menu_entries_common_load_content(bool persist)
  * call each other. */
 
 #ifdef HAVE_ZLIB
+/**
+ * zlib_extract_core_is_current:
+ * @path                  : Where the file would be extracted to.
+ * @size                  : Uncompressed size of the file in the archive.
+ * @crc32                 : CRC32 of the file in the archive.
+ *
+ * Returns: true (1) if @path already holds the file,
+ * otherwise false (0).
+ **/
+static bool zlib_extract_core_is_current(const char *path,
+      uint32_t size, uint32_t crc32)
+{
+   long file_size;
+   uint32_t file_crc = 0;
+   FILE *file        = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   /* Hashing is only worth it when the sizes match. */
+   fseek(file, 0, SEEK_END);
+   file_size = ftell(file);
+   fclose(file);
+
+   if (file_size != (long)size)
+      return false;
+
+   return crc32_calculate_file(path, &file_crc) && file_crc == crc32;
+}
+
 static int zlib_extract_core_callback(const char *name, const char *valid_exts,
       const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
       uint32_t crc32, void *userdata)
@@ -67,6 +98,13 @@ static int zlib_extract_core_callback(const char *name, const char *valid_exts,
 
    fill_pathname_join(path, (const char*)userdata, name, sizeof(path));
 
+   /* Only files that changed get inflated and written. */
+   if (zlib_extract_core_is_current(path, size, crc32))
+   {
+      RARCH_LOG("path is: %s, CRC32: 0x%x, up to date.\n", path, crc32);
+      return 1;
+   }
+
    RARCH_LOG("path is: %s, CRC32: 0x%x\n", path, crc32);
 
    if (!zlib_perform_mode(path, valid_exts,
@@ -91,20 +129,16 @@ error:
 int cb_core_updater_download(void *data, size_t len)
 {
    const char* file_ext = NULL;
-   char output_path[PATH_MAX_LENGTH], msg[PATH_MAX_LENGTH];
+   const char *output_path = (const char*)data;
+   char msg[PATH_MAX_LENGTH];
    settings_t *settings = config_get_ptr();
 
-   if (!data)
+   /* The download has already been written to output_path. */
+   if (!output_path)
       return -1;
 
-   fill_pathname_join(output_path, settings->libretro_directory,
-         core_updater_path, sizeof(output_path));
-
-   if (!write_file(output_path, data, len))
-      return -1;
-   
    snprintf(msg, sizeof(msg), "Download complete: %s.",
-         core_updater_path);
+         path_basename(output_path));
 
    rarch_main_msg_queue_push(msg, 1, 90, true);
 
@@ -157,7 +191,6 @@ void menu_entries_cbs_init(void *data,
       unsigned type, size_t idx)
 {
    char elem0[PATH_MAX_LENGTH], elem1[PATH_MAX_LENGTH];
-   struct string_list *str_list = NULL;
    const char *menu_label       = NULL;
    menu_file_list_cbs_t *cbs    = NULL;
    file_list_t *list            = (file_list_t*)data;
@@ -174,20 +207,20 @@ void menu_entries_cbs_init(void *data,
    menu_list_get_last_stack(menu->menu_list,
          NULL, &menu_label, NULL);
 
-   if (label)
-      str_list = string_split(label, "|");
-
-   if (str_list && str_list->size > 0)
-      strlcpy(elem0, str_list->elems[0].data, sizeof(elem0));
-   else elem0[0]='\0';
-   if (str_list && str_list->size > 1)
-      strlcpy(elem1, str_list->elems[1].data, sizeof(elem1));
-   else elem1[0]='\0';
+   elem0[0] = '\0';
+   elem1[0] = '\0';
 
-   if (str_list)
+   /* Done for every entry, so don't split into a list. */
+   if (label)
    {
-      string_list_free(str_list);
-      str_list = NULL;
+      size_t len;
+      const char *str = label;
+      const char *tok = string_tokenize(&str, "|", &len);
+
+      if (tok)
+         strlcpy(elem0, tok, min(len + 1, sizeof(elem0)));
+      if ((tok = string_tokenize(&str, "|", &len)))
+         strlcpy(elem1, tok, min(len + 1, sizeof(elem1)));
    }
 
    menu_entries_cbs_init_bind_ok(cbs, path, label, type, idx, elem0, elem1, menu_label);
@@ -17,6 +17,7 @@
 #define MENU_ENTRIES_CBS_H__
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <boolean.h>
 
 #ifdef __cplusplus
@@ -26,14 +27,21 @@ extern "C" {
 /* FIXME - Externs, refactor */
 extern size_t hack_shader_pass;
 extern unsigned rdb_entry_start_game_selection_ptr;
-#ifdef HAVE_NETWORKING
-extern char core_updater_path[PATH_MAX_LENGTH];
-#endif
 
 void menu_entries_common_load_content(bool persist);
 
 int menu_entries_common_is_settings_entry(const char *label);
 
+/**
+ * menu_entries_core_updater_crc:
+ * @name                  : File name, as listed by the buildbot.
+ * @crc                   : Set to the CRC32 of the file.
+ *
+ * Returns: true (1) if the buildbot listed a CRC32 for @name,
+ * otherwise false (0).
+ **/
+bool menu_entries_core_updater_crc(const char *name, uint32_t *crc);
+
 void menu_entries_cbs_init_bind_refresh(menu_file_list_cbs_t *cbs,
       const char *path, const char *label, unsigned type, size_t idx,
       const char *elem0, const char *elem1);
@@ -14,6 +14,7 @@
  */
 
 #include <file/file_path.h>
+#include <string/string_list.h>
 #include "menu.h"
 #include "menu_entries_cbs.h"
 #include "menu_setting.h"
@@ -585,6 +586,11 @@ static int deferred_push_system_information(void *data, void *userdata,
       menu_list_push(list, feat_str, "",
             MENU_SETTINGS_CORE_INFO_NONE, 0);
 
+      snprintf(feat_str, sizeof(feat_str),
+            "WASAPI support: %s", _wasapi_supp ? "true" : "false");
+      menu_list_push(list, feat_str, "",
+            MENU_SETTINGS_CORE_INFO_NONE, 0);
+
       snprintf(feat_str, sizeof(feat_str),
             "XAudio2 support: %s", _xaudio_supp ? "true" : "false");
       menu_list_push(list, feat_str, "",
@@ -713,7 +719,7 @@ static int deferred_push_rdb_entry_detail(void *data, void *userdata,
 
    menu_list_clear(list);
 
-   if (!(db_info = database_info_list_new(path, query)))
+   if (!(db_info = menu_database_info_list(path, query)))
    {
       ret = -1;
       goto done;
@@ -1015,8 +1021,6 @@ static int deferred_push_database_manager_list_deferred(void *data, void *userda
 
    menu_database_populate_query(list, path, NULL);
 
-   menu_list_sort_on_alt(list);
-
    menu_list_populate_generic(list, path, label, type);
 
    return 0;
@@ -1065,8 +1069,6 @@ static int deferred_push_cursor_manager_list_deferred(void *data, void *userdata
 
    menu_database_populate_query(list, rdb_path, query);
 
-   menu_list_sort_on_alt(list);
-
    menu_list_populate_generic(list, path, label, type);
 
    config_file_free(conf);
@@ -1172,8 +1174,6 @@ static int deferred_push_cursor_manager_list_deferred_query_subsearch(
 
    menu_database_populate_query(list, str_list->elems[1].data, query);
 
-   menu_list_sort_on_alt(list);
-
    menu_list_populate_generic(list, str_list->elems[0].data, label, type);
 
    string_list_free(str_list);
@@ -1961,9 +1961,68 @@ static void print_buf_lines(file_list_t *list, char *buf, int buf_size,
 static char *core_buf;
 static size_t core_len;
 
+/* Files on the buildbot, with the CRC32 it lists for them. */
+struct core_updater_entry
+{
+   char *name;
+   uint32_t crc;
+   bool has_crc;
+};
+
+static struct core_updater_entry *core_manifest;
+static size_t core_manifest_size;
+
+static void core_updater_manifest_free(void)
+{
+   size_t i;
+
+   for (i = 0; i < core_manifest_size; i++)
+      free(core_manifest[i].name);
+   free(core_manifest);
+
+   core_manifest      = NULL;
+   core_manifest_size = 0;
+}
+
+/**
+ * menu_entries_core_updater_crc:
+ * @name                  : File name, as listed by the buildbot.
+ * @crc                   : Set to the CRC32 of the file.
+ *
+ * Returns: true (1) if the buildbot listed a CRC32 for @name,
+ * otherwise false (0).
+ **/
+bool menu_entries_core_updater_crc(const char *name, uint32_t *crc)
+{
+   size_t i;
+
+   for (i = 0; i < core_manifest_size; i++)
+   {
+      if (core_manifest[i].has_crc && !strcmp(core_manifest[i].name, name))
+      {
+         *crc = core_manifest[i].crc;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+ * cb_core_updater_list:
+ * @data_                 : Contents of .index-extended.
+ * @len                   : Size of @data_.
+ *
+ * Lines are "date crc32 file", or just "file" as in the plain
+ * .index. The files are listed, the CRC32s kept to tell which
+ * files are already up to date.
+ **/
 int cb_core_updater_list(void *data_, size_t len)
 {
+   size_t i;
+   struct string_list *lines = NULL;
    char *data = (char*)data_;
+   char *buf  = NULL;
    menu_handle_t *menu    = menu_driver_get_ptr();
    if (!menu)
       return -1;
@@ -1971,16 +2030,60 @@ int cb_core_updater_list(void *data_, size_t len)
    if (!data)
       return -1;
 
-   if (core_buf)
-      free(core_buf);
+   buf = (char*)malloc(len + 1);
+   if (!buf)
+      return -1;
 
-   core_buf = (char*)malloc(len * sizeof(char));
+   memcpy(buf, data, len);
+   buf[len] = '\0';
 
-   if (!core_buf)
+   lines = string_split(buf, "\r\n");
+   if (!lines)
+   {
+      free(buf);
       return -1;
+   }
+
+   core_updater_manifest_free();
+   core_manifest = (struct core_updater_entry*)
+      calloc(lines->size + 1, sizeof(*core_manifest));
+
+   /* The names alone, one per line, take no more room. */
+   core_len = 0;
+
+   for (i = 0; core_manifest && i < lines->size; i++)
+   {
+      char date[64], crc[64], name[PATH_MAX_LENGTH];
+      struct core_updater_entry *entry = &core_manifest[core_manifest_size];
+      int fields = sscanf(lines->elems[i].data, "%63s %63s %1023s",
+            date, crc, name);
+
+      if (fields == 3)
+      {
+         char *end    = NULL;
+         entry->crc     = strtoul(crc, &end, 16);
+         entry->has_crc = *crc && !*end;
+         entry->name    = strdup(name);
+      }
+      else if (fields == 1)
+         entry->name    = strdup(date);
+      else
+         continue;
+
+      if (!entry->name)
+         continue;
+
+      core_manifest_size++;
+      core_len += snprintf(buf + core_len, len + 1 - core_len, "%s\n",
+            entry->name);
+   }
+
+   string_list_free(lines);
+
+   if (core_buf)
+      free(core_buf);
 
-   memcpy(core_buf, data, len * sizeof(char));
-   core_len = len;
+   core_buf = buf;
 
    menu->nonblocking_refresh = false;
 
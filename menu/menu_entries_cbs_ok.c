@@ -23,6 +23,7 @@
 
 #include "../retroarch.h"
 #include "../runloop_data.h"
+#include "../hash.h"
 
 #include "../input/input_remapping.h"
 
@@ -30,7 +31,6 @@
 unsigned rdb_entry_start_game_selection_ptr;
 size_t hack_shader_pass = 0;
 #ifdef HAVE_NETWORKING
-char core_updater_path[PATH_MAX_LENGTH];
 #endif
 
 static int menu_action_setting_set_current_string_path(
@@ -292,8 +292,10 @@ static int action_ok_core_updater_list(const char *path,
 #ifdef HAVE_NETWORKING
    event_command(EVENT_CMD_NETWORK_INIT);
 
+   /* Also lists the CRC32 of each file, for downloads to be
+    * skipped when the file on disk matches already. */
    fill_pathname_join(url_path, settings->network.buildbot_url,
-         ".index", sizeof(url_path));
+         ".index-extended", sizeof(url_path));
 
    rarch_main_data_msg_queue_push(DATA_TYPE_HTTP, url_path, "cb_core_updater_list", 0, 1,
          true);
@@ -1010,19 +1012,43 @@ static int action_ok_core_updater_download(const char *path,
       const char *label, unsigned type, size_t idx)
 {
 #ifdef HAVE_NETWORKING
-   char core_path[PATH_MAX_LENGTH], msg[PATH_MAX_LENGTH];
+   char core_path[PATH_MAX_LENGTH], output_path[PATH_MAX_LENGTH];
+   char msg[PATH_MAX_LENGTH], cmd[PATH_MAX_LENGTH];
+   uint32_t remote_crc   = 0;
+   uint32_t local_crc    = 0;
    settings_t *settings  = config_get_ptr();
 
    fill_pathname_join(core_path, settings->network.buildbot_url,
          path, sizeof(core_path));
+   fill_pathname_join(output_path, settings->libretro_directory,
+         path, sizeof(output_path));
+
+   /* The last download is kept next to the core, so an
+    * unchanged file doesn't have to be fetched again. */
+   if (menu_entries_core_updater_crc(path, &remote_crc)
+         && crc32_calculate_file(output_path, &local_crc)
+         && local_crc == remote_crc)
+   {
+      snprintf(msg, sizeof(msg), "Already up to date: %s.", path);
+      rarch_main_msg_queue_push(msg, 1, 90, true);
+      return 0;
+   }
+
+   /* Streamed straight to the cores directory. Several 
+    * downloads can be queued and run at the same time. */
+   if ((size_t)snprintf(cmd, sizeof(cmd), "cb_core_updater_download|%s",
+            output_path) >= sizeof(cmd))
+   {
+      RARCH_ERR("Core path is too long: \"%s\".\n", output_path);
+      return -1;
+   }
 
-   strlcpy(core_updater_path, path, sizeof(core_updater_path));
    snprintf(msg, sizeof(msg), "Starting download: %s.", path);
 
    rarch_main_msg_queue_push(msg, 1, 90, true);
 
    rarch_main_data_msg_queue_push(DATA_TYPE_HTTP, core_path,
-         "cb_core_updater_download", 0, 1, true);
+         cmd, 0, 1, false);
 #endif
    return 0;
 }
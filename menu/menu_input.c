@@ -64,6 +64,100 @@ static void menu_input_key_end_line(void)
    driver->flushing_input = true;
 }
 
+static void menu_input_search_populate(menu_handle_t *menu)
+{
+   const char *path  = NULL;
+   const char *label = NULL;
+   unsigned type     = 0;
+
+   menu_list_get_last_stack(menu->menu_list, &path, &label, &type);
+   menu_list_populate_generic(menu->menu_list->selection_buf,
+         path, label, type);
+}
+
+/**
+ * menu_input_search_restore:
+ * @menu                     : Menu handle.
+ *
+ * Puts the full list back in place of the matches.
+ **/
+static void menu_input_search_restore(menu_handle_t *menu)
+{
+   file_list_t *filtered = menu->menu_list->selection_buf;
+
+   if (!menu->search.list)
+      return;
+
+   menu_list_clear(filtered);
+   file_list_free(filtered);
+
+   menu->menu_list->selection_buf = menu->search.list;
+   menu->search.list              = NULL;
+
+   menu_input_search_populate(menu);
+}
+
+/**
+ * menu_input_search_show:
+ * @menu                     : Menu handle.
+ * @needle                   : String typed so far.
+ *
+ * Fills the selection buffer with the entries matching
+ * @needle, selecting the first one starting with it.
+ * Shows the full list again once @needle is empty.
+ **/
+static void menu_input_search_show(menu_handle_t *menu,
+      const char *needle)
+{
+   size_t i, best    = 0;
+   file_list_t *full = menu->search.list;
+   file_list_t *list = NULL;
+
+   strlcpy(menu->search.needle, needle, sizeof(menu->search.needle));
+   menu->search.matches_size = menu_search_filter(menu->search.index,
+         needle, &menu->search.matches, &best);
+
+   if (!*needle)
+   {
+      menu_input_search_restore(menu);
+      menu_navigation_set(&menu->navigation, menu->search.selection, true);
+      strlcpy(menu->search.label, "Search: ", sizeof(menu->search.label));
+      return;
+   }
+
+   if (!full)
+   {
+      list = (file_list_t*)calloc(1, sizeof(*list));
+      if (!list)
+         return;
+
+      full                           = menu->menu_list->selection_buf;
+      menu->search.list              = full;
+      menu->menu_list->selection_buf = list;
+   }
+
+   list = menu->menu_list->selection_buf;
+   menu_list_clear(list);
+
+   for (i = 0; i < menu->search.matches_size; i++)
+   {
+      const struct item_file *item = &full->list[menu->search.matches[i]];
+
+      menu_list_push(list, item->path, item->label,
+            item->type, item->directory_ptr);
+      if (item->alt)
+         menu_list_set_alt_at_offset(list, i, item->alt);
+   }
+
+   menu_input_search_populate(menu);
+
+   if (menu->search.matches_size)
+      menu_navigation_set(&menu->navigation, best, true);
+
+   snprintf(menu->search.label, sizeof(menu->search.label),
+         "Search (%u): ", (unsigned)menu->search.matches_size);
+}
+
 static void menu_input_search_callback(void *userdata, const char *str)
 {
    size_t idx;
@@ -72,12 +166,61 @@ static void menu_input_search_callback(void *userdata, const char *str)
    if (!menu)
       return;
 
-   if (str && *str && file_list_search(menu->menu_list->selection_buf, str, &idx))
+   if (!menu->search.index)
+   {
+      if (str && *str && file_list_search(menu->menu_list->selection_buf, str, &idx))
          menu_navigation_set(&menu->navigation, idx, true);
 
+      menu_input_key_end_line();
+      return;
+   }
+
+   /* Return may come in the same frame as the last characters. */
+   if (strcmp(str ? str : "", menu->search.needle))
+      menu_input_search_show(menu, str ? str : "");
+
+   idx = menu->search.selection;
+   if (menu->search.list
+         && menu->navigation.selection_ptr < menu->search.matches_size)
+      idx = menu->search.matches[menu->navigation.selection_ptr];
+
+   menu_input_search_restore(menu);
+   menu_search_free(menu->search.index);
+   menu->search.index = NULL;
+
+   menu_navigation_set(&menu->navigation, idx, true);
+
    menu_input_key_end_line();
 }
 
+/**
+ * menu_input_search_iterate:
+ *
+ * Filters the list whenever the search string changed
+ * since the last frame.
+ *
+ * Returns: true (1) while a search is going on, in which
+ * case the entries must not be acted on, as their offsets
+ * are not the ones of the full list.
+ **/
+bool menu_input_search_iterate(void)
+{
+   const char *str     = NULL;
+   menu_handle_t *menu = menu_driver_get_ptr();
+
+   if (!menu || !menu->search.index)
+      return false;
+
+   str = *menu->keyboard.buffer;
+   if (!str)
+      str = "";
+
+   if (strcmp(str, menu->search.needle))
+      menu_input_search_show(menu, str);
+
+   return true;
+}
+
 void menu_input_st_uint_callback(void *userdata, const char *str)
 {
    menu_handle_t *menu = menu_driver_get_ptr();
@@ -166,7 +309,7 @@ void menu_input_st_cheat_callback(void *userdata, const char *str)
       unsigned cheat_index = menu->keyboard.type - MENU_SETTINGS_CHEAT_BEGIN;
       RARCH_LOG("cheat_index is: %u\n", cheat_index);
 
-      cheat->cheats[cheat_index].code  = strdup(str);
+      cheat_manager_set_code(cheat, cheat_index, str);
       cheat->cheats[cheat_index].state = true;
    }
 
@@ -179,8 +322,19 @@ void menu_input_search_start(void)
    if (!menu)
       return;
 
+   /* Without an index, the search only jumps to the
+    * first match once return is pressed. */
+   if (!menu->search.index)
+   {
+      menu->search.index     = menu_search_new(menu->menu_list->selection_buf);
+      menu->search.selection = menu->navigation.selection_ptr;
+      *menu->search.needle   = '\0';
+   }
+
+   strlcpy(menu->search.label, "Search: ", sizeof(menu->search.label));
+
    menu->keyboard.display = true;
-   menu->keyboard.label = "Search: ";
+   menu->keyboard.label = menu->search.label;
    menu->keyboard.buffer = 
       input_keyboard_start_line(menu, menu_input_search_callback);
 }
@@ -79,6 +79,8 @@ void menu_input_post_iterate(int *ret, menu_file_list_cbs_t *cbs, const char *pa
 
 void menu_input_search_start(void);
 
+bool menu_input_search_iterate(void);
+
 int menu_input_set_keyboard_bind_mode(void *data, enum menu_input_bind_mode type);
 
 int menu_input_set_input_device_bind_mode(void *data, enum menu_input_bind_mode type);
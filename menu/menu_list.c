@@ -222,10 +222,39 @@ void menu_list_get_last_stack(const menu_list_t *list,
       file_list_get_last(list->menu_stack, path, label, file_type);
 }
 
+/**
+ * menu_list_get_actiondata_at_offset:
+ * @list                     : File list handle.
+ * @idx                      : Offset index of element.
+ *
+ * Gets the callbacks of an element. Elements of the selection
+ * buffer only get them bound here, the first time they are
+ * needed, so that pushing a directory or playlist with thousands
+ * of entries only pays for the few that are shown or selected.
+ *
+ * Returns: callbacks of the element, or NULL.
+ **/
 void *menu_list_get_actiondata_at_offset(const file_list_t *list, size_t idx)
 {
+   void *actiondata    = NULL;
+   const char *path    = NULL;
+   const char *label   = NULL;
+   unsigned type       = 0;
+   driver_t *driver    = driver_get_ptr();
+   menu_handle_t *menu = menu_driver_get_ptr();
+
    if (!list)
       return NULL;
+
+   actiondata = file_list_get_actiondata_at_offset(list, idx);
+
+   if (actiondata || !driver->menu_ctx || !menu || !menu->menu_list
+         || list != menu->menu_list->selection_buf || idx >= list->size)
+      return actiondata;
+
+   file_list_get_at_offset(list, idx, &path, &label, &type);
+   menu_common_list_insert((file_list_t*)list, path, label, type, idx);
+
    return file_list_get_actiondata_at_offset(list, idx);
 }
 
@@ -352,11 +381,17 @@ static void menu_list_insert(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr)
 {
-   driver_t *driver = driver_get_ptr();
+   driver_t *driver    = driver_get_ptr();
+   menu_handle_t *menu = menu_driver_get_ptr();
    if (!driver->menu_ctx)
       return;
 
    menu_driver_list_insert(list, path, label, list->size - 1);
+
+   /* Bound on first use by menu_list_get_actiondata_at_offset(). */
+   if (menu && menu->menu_list && list == menu->menu_list->selection_buf)
+      return;
+
    menu_common_list_insert(list, path, label, type, list->size - 1);
 }
 
@@ -0,0 +1,274 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <retro_inline.h>
+
+#include "menu_search.h"
+
+/* Trigrams are hashed into this many buckets, a power of two.
+ * Entries of colliding trigrams share a bucket, which only
+ * costs a few extra substring checks. */
+#define MENU_SEARCH_BUCKETS 4096
+
+struct menu_search
+{
+   /* Lowercase labels, each one NUL terminated. */
+   char *labels;
+   size_t *offsets;
+   size_t size;
+
+   /* Entries of bucket b are postings[buckets[b]]
+    * up to postings[buckets[b + 1]], in list order. */
+   uint32_t *buckets;
+   uint32_t *postings;
+
+   /* Result of the last search. */
+   char *needle;
+   size_t *matches;
+   size_t matches_size;
+};
+
+/* Multiplicative hash, keeping the top 12 bits. */
+static INLINE uint32_t menu_search_bucket(const char *str)
+{
+   uint32_t key = (uint8_t)str[0]
+      | ((uint32_t)(uint8_t)str[1] << 8)
+      | ((uint32_t)(uint8_t)str[2] << 16);
+
+   return (key * 2654435761U) >> 20;
+}
+
+static const char *menu_search_get_label(const file_list_t *list,
+      size_t idx)
+{
+   const char *str = NULL;
+
+   file_list_get_alt_at_offset(list, idx, &str);
+   if (!str)
+      str = list->list[idx].path;
+   if (!str)
+      str = list->list[idx].label;
+   return str ? str : "";
+}
+
+/**
+ * menu_search_build_postings:
+ * @search               : Search index, with its labels.
+ *
+ * Counts the entries of every bucket, then fills them in, both
+ * times skipping trigrams which occur more than once in a label.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool menu_search_build_postings(menu_search_t *search)
+{
+   size_t i, b;
+   uint32_t *last = (uint32_t*)malloc(MENU_SEARCH_BUCKETS * sizeof(*last));
+   uint32_t *fill = (uint32_t*)malloc(MENU_SEARCH_BUCKETS * sizeof(*fill));
+
+   search->buckets = (uint32_t*)calloc(MENU_SEARCH_BUCKETS + 1,
+         sizeof(*search->buckets));
+
+   if (!last || !fill || !search->buckets)
+      goto error;
+
+   memset(last, 0xff, MENU_SEARCH_BUCKETS * sizeof(*last));
+
+   for (i = 0; i < search->size; i++)
+   {
+      const char *str = search->labels + search->offsets[i];
+
+      for (; str[0] && str[1] && str[2]; str++)
+      {
+         b = menu_search_bucket(str);
+         if (last[b] == i)
+            continue;
+         last[b] = i;
+         search->buckets[b + 1]++;
+      }
+   }
+
+   for (b = 0; b < MENU_SEARCH_BUCKETS; b++)
+   {
+      search->buckets[b + 1] += search->buckets[b];
+      fill[b]                 = search->buckets[b];
+   }
+
+   search->postings = (uint32_t*)malloc(
+         (search->buckets[MENU_SEARCH_BUCKETS] + 1) * sizeof(uint32_t));
+   if (!search->postings)
+      goto error;
+
+   memset(last, 0xff, MENU_SEARCH_BUCKETS * sizeof(*last));
+
+   for (i = 0; i < search->size; i++)
+   {
+      const char *str = search->labels + search->offsets[i];
+
+      for (; str[0] && str[1] && str[2]; str++)
+      {
+         b = menu_search_bucket(str);
+         if (last[b] == i)
+            continue;
+         last[b] = i;
+         search->postings[fill[b]++] = i;
+      }
+   }
+
+   free(last);
+   free(fill);
+   return true;
+
+error:
+   free(last);
+   free(fill);
+   return false;
+}
+
+menu_search_t *menu_search_new(const file_list_t *list)
+{
+   size_t i, len = 0;
+   char *dst             = NULL;
+   menu_search_t *search = NULL;
+
+   if (!list || list->size >= UINT32_MAX)
+      return NULL;
+
+   search = (menu_search_t*)calloc(1, sizeof(*search));
+   if (!search)
+      return NULL;
+
+   search->size    = list->size;
+   search->offsets = (size_t*)malloc((list->size + 1) * sizeof(size_t));
+   search->matches = (size_t*)malloc((list->size + 1) * sizeof(size_t));
+   if (!search->offsets || !search->matches)
+      goto error;
+
+   for (i = 0; i < list->size; i++)
+      len += strlen(menu_search_get_label(list, i)) + 1;
+
+   search->labels = (char*)malloc(len + 1);
+   if (!search->labels)
+      goto error;
+
+   for (i = 0, dst = search->labels; i < list->size; i++)
+   {
+      const char *src = menu_search_get_label(list, i);
+
+      search->offsets[i] = dst - search->labels;
+      while (*src)
+         *dst++ = tolower((unsigned char)*src++);
+      *dst++ = '\0';
+   }
+
+   if (!menu_search_build_postings(search))
+      goto error;
+
+   return search;
+
+error:
+   menu_search_free(search);
+   return NULL;
+}
+
+void menu_search_free(menu_search_t *search)
+{
+   if (!search)
+      return;
+
+   free(search->labels);
+   free(search->offsets);
+   free(search->buckets);
+   free(search->postings);
+   free(search->needle);
+   free(search->matches);
+   free(search);
+}
+
+size_t menu_search_filter(menu_search_t *search, const char *needle,
+      const size_t **matches, size_t *best)
+{
+   size_t i, len, count   = 0;
+   const uint32_t *list   = NULL;
+   size_t list_size       = search->size;
+   bool narrowing         = false;
+   bool prefix_found      = false;
+   char *lower            = NULL;
+
+   *matches = search->matches;
+   *best    = 0;
+
+   if (!needle || !*needle || !(lower = strdup(needle)))
+   {
+      free(search->needle);
+      search->needle       = NULL;
+      search->matches_size = 0;
+      return 0;
+   }
+
+   for (len = 0; lower[len]; len++)
+      lower[len] = tolower((unsigned char)lower[len]);
+
+   /* Typing on only ever narrows the last search down. */
+   if (search->needle && strstr(lower, search->needle))
+   {
+      narrowing = true;
+      list_size = search->matches_size;
+   }
+
+   /* Unless the rarest trigram of the needle has fewer entries. */
+   for (i = 0; i + 3 <= len; i++)
+   {
+      uint32_t b  = menu_search_bucket(lower + i);
+      size_t size = search->buckets[b + 1] - search->buckets[b];
+
+      if (size < list_size)
+      {
+         list      = search->postings + search->buckets[b];
+         list_size = size;
+         narrowing = false;
+      }
+   }
+
+   /* Matches are written in place when narrowing,
+    * which never gets ahead of the entry being read. */
+   for (i = 0; i < list_size; i++)
+   {
+      size_t idx = narrowing ? search->matches[i] : list ? list[i] : i;
+      const char *label = search->labels + search->offsets[idx];
+      const char *found = strstr(label, lower);
+
+      if (!found)
+         continue;
+
+      if (found == label && !prefix_found)
+      {
+         *best        = count;
+         prefix_found = true;
+      }
+
+      search->matches[count++] = idx;
+   }
+
+   free(search->needle);
+   search->needle       = lower;
+   search->matches_size = count;
+
+   return count;
+}
@@ -0,0 +1,69 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MENU_SEARCH_H
+#define _MENU_SEARCH_H
+
+#include <stddef.h>
+#include <boolean.h>
+#include <file/file_list.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Search index over the labels of a menu list, for filtering
+ * it by substring as the user types. Keeps the labels in
+ * lowercase, and for every trigram the entries containing it,
+ * so a search only has to check the entries of its rarest
+ * trigram, or the matches of the search it extends. */
+typedef struct menu_search menu_search_t;
+
+/**
+ * menu_search_new:
+ * @list                 : Menu list to index.
+ *
+ * Indexes the entries of @list by their alt string, or path
+ * when there is none, which is what the drivers display.
+ *
+ * Returns: search index on success, otherwise NULL.
+ **/
+menu_search_t *menu_search_new(const file_list_t *list);
+
+void menu_search_free(menu_search_t *search);
+
+/**
+ * menu_search_filter:
+ * @search               : Search index.
+ * @needle               : String to search for, case insensitive.
+ * @matches              : Set to the offsets of the matching
+ *                         entries, in list order. Valid until
+ *                         the next search.
+ * @best                 : Set to the position in @matches of the
+ *                         first entry starting with @needle, or 0.
+ *
+ * Finds the entries containing @needle. An empty @needle
+ * matches nothing.
+ *
+ * Returns: number of matching entries.
+ **/
+size_t menu_search_filter(menu_search_t *search, const char *needle,
+      const size_t **matches, size_t *best);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,10 +22,21 @@
 #include "general.h"
 #include "dynamic.h"
 
+/* Recorded input is written out in blocks of this size. */
+#define BSV_MOVIE_BLOCK_SIZE (64 * 1024)
+
 struct bsv_movie
 {
    FILE *file;
 
+   /* Playback: the whole input stream, read in one go.
+    * Recording: input not written to the file yet. */
+   uint8_t *buf;
+   size_t buf_len;
+   /* Playback: read offset in buf.
+    * Recording: file position buf is written to. */
+   size_t buf_pos;
+
    /* A ring buffer keeping track of positions
     * in the file for each frame. */
    size_t *frame_pos;
@@ -44,6 +55,7 @@ struct bsv_movie
 
 static bool init_playback(bsv_movie_t *handle, const char *path)
 {
+   long file_size;
    uint32_t state_size;
    uint32_t header[4] = {0};
    global_t *global   = global_get_ptr();
@@ -98,10 +110,34 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
 
    handle->min_file_pos = sizeof(header) + state_size;
 
+   /* Read all input at once, rather than a value at a time,
+    * so playback and seeking don't go through stdio. */
+   if (fseek(handle->file, 0, SEEK_END) != 0)
+      return false;
+   file_size = ftell(handle->file);
+   if (file_size < (long)handle->min_file_pos)
+   {
+      RARCH_ERR("Movie is truncated.\n");
+      return false;
+   }
+
+   handle->buf_len = file_size - handle->min_file_pos;
+   handle->buf     = (uint8_t*)malloc(handle->buf_len + 1);
+   if (!handle->buf)
+      return false;
+
+   fseek(handle->file, handle->min_file_pos, SEEK_SET);
+   if (fread(handle->buf, 1, handle->buf_len, handle->file) != handle->buf_len)
+   {
+      RARCH_ERR("Couldn't read input from movie.\n");
+      return false;
+   }
+
    return true;
 }
 
-static bool init_record(bsv_movie_t *handle, const char *path)
+static bool init_record(bsv_movie_t *handle, const char *path,
+      const void *state, size_t size)
 {
    uint32_t state_size;
    uint32_t header[4] = {0};
@@ -118,7 +154,7 @@ static bool init_record(bsv_movie_t *handle, const char *path)
     * BSV1 in a HEX editor, big-endian. */
    header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
    header[CRC_INDEX]        = swap_if_big32(global->content_crc);
-   state_size               = pretro_serialize_size();
+   state_size               = state ? size : pretro_serialize_size();
    header[STATE_SIZE_INDEX] = swap_if_big32(state_size);
 
    fwrite(header, 4, sizeof(uint32_t), handle->file);
@@ -132,20 +168,89 @@ static bool init_record(bsv_movie_t *handle, const char *path)
       if (!handle->state)
          return false;
 
-      pretro_serialize(handle->state, state_size);
+      if (state)
+         memcpy(handle->state, state, state_size);
+      else
+         pretro_serialize(handle->state, state_size);
       fwrite(handle->state, 1, state_size, handle->file);
    }
 
+   handle->buf_pos = handle->min_file_pos;
+   handle->buf     = (uint8_t*)malloc(BSV_MOVIE_BLOCK_SIZE);
+   if (!handle->buf)
+      return false;
+
    return true;
 }
 
+/**
+ * bsv_movie_flush:
+ * @handle               : Movie being recorded.
+ *
+ * Writes out the input buffered so far.
+ **/
+static void bsv_movie_flush(bsv_movie_t *handle)
+{
+   if (!handle->buf_len)
+      return;
+
+   fwrite(handle->buf, 1, handle->buf_len, handle->file);
+   handle->buf_pos += handle->buf_len;
+   handle->buf_len  = 0;
+}
+
+static size_t bsv_movie_tell(bsv_movie_t *handle)
+{
+   if (handle->playback)
+      return handle->min_file_pos + handle->buf_pos;
+   return handle->buf_pos + handle->buf_len;
+}
+
+/**
+ * bsv_movie_seek:
+ * @handle               : Movie handle.
+ * @pos                  : File position of a frame seen before.
+ *
+ * Moves to @pos. Recording continues from there,
+ * dropping what was recorded after it.
+ **/
+static void bsv_movie_seek(bsv_movie_t *handle, size_t pos)
+{
+   if (pos < handle->min_file_pos)
+      pos = handle->min_file_pos;
+
+   if (handle->playback)
+   {
+      handle->buf_pos = pos - handle->min_file_pos;
+      if (handle->buf_pos > handle->buf_len)
+         handle->buf_pos = handle->buf_len;
+      return;
+   }
+
+   if (pos >= handle->buf_pos && pos <= handle->buf_pos + handle->buf_len)
+   {
+      /* Still buffered, nothing was written past it yet. */
+      handle->buf_len = pos - handle->buf_pos;
+      return;
+   }
+
+   handle->buf_len = 0;
+   handle->buf_pos = pos;
+   fseek(handle->file, pos, SEEK_SET);
+}
+
 void bsv_movie_free(bsv_movie_t *handle)
 {
    if (!handle)
       return;
 
    if (handle->file)
+   {
+      if (!handle->playback && handle->buf)
+         bsv_movie_flush(handle);
       fclose(handle->file);
+   }
+   free(handle->buf);
    free(handle->state);
    free(handle->frame_pos);
    free(handle);
@@ -153,20 +258,28 @@ void bsv_movie_free(bsv_movie_t *handle)
 
 bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input)
 {
-   if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
+   if (handle->buf_len - handle->buf_pos < sizeof(int16_t))
       return false;
 
+   memcpy(input, handle->buf + handle->buf_pos, sizeof(int16_t));
+   handle->buf_pos += sizeof(int16_t);
+
    *input = swap_if_big16(*input);
    return true;
 }
 
 void bsv_movie_set_input(bsv_movie_t *handle, int16_t input)
 {
+   if (handle->buf_len + sizeof(int16_t) > BSV_MOVIE_BLOCK_SIZE)
+      bsv_movie_flush(handle);
+
    input = swap_if_big16(input);
-   fwrite(&input, sizeof(int16_t), 1, handle->file);
+   memcpy(handle->buf + handle->buf_len, &input, sizeof(int16_t));
+   handle->buf_len += sizeof(int16_t);
 }
 
-bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
+static bsv_movie_t *bsv_movie_new(const char *path,
+      enum rarch_movie_type type, const void *state, size_t size)
 {
    bsv_movie_t *handle = (bsv_movie_t*)calloc(1, sizeof(*handle));
    if (!handle)
@@ -177,7 +290,7 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
       if (!init_playback(handle, path))
          goto error;
    }
-   else if (!init_record(handle, path))
+   else if (!init_record(handle, path, state, size))
       goto error;
 
    /* Just pick something really large 
@@ -195,11 +308,22 @@ error:
    return NULL;
 }
 
+bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
+{
+   return bsv_movie_new(path, type, NULL, 0);
+}
+
+bsv_movie_t *bsv_movie_init_state(const char *path,
+      const void *state, size_t state_size)
+{
+   return bsv_movie_new(path, RARCH_MOVIE_RECORD, state, state_size);
+}
+
 void bsv_movie_set_frame_start(bsv_movie_t *handle)
 {
    if (!handle)
       return;
-   handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
+   handle->frame_pos[handle->frame_ptr] = bsv_movie_tell(handle);
 }
 
 void bsv_movie_set_frame_end(bsv_movie_t *handle)
@@ -221,7 +345,7 @@ void bsv_movie_frame_rewind(bsv_movie_t *handle)
    {
       /* If we're at the beginning... */
       handle->frame_ptr = 0;
-      fseek(handle->file, handle->min_file_pos, SEEK_SET);
+      bsv_movie_seek(handle, handle->min_file_pos);
    }
    else
    {
@@ -233,10 +357,10 @@ void bsv_movie_frame_rewind(bsv_movie_t *handle)
        * plus another. */
       handle->frame_ptr = (handle->frame_ptr -
             (handle->first_rewind ? 1 : 2)) & handle->frame_mask;
-      fseek(handle->file, handle->frame_pos[handle->frame_ptr], SEEK_SET);
+      bsv_movie_seek(handle, handle->frame_pos[handle->frame_ptr]);
    }
 
-   if (ftell(handle->file) <= (long)handle->min_file_pos)
+   if (bsv_movie_tell(handle) <= handle->min_file_pos)
    {
       /* We rewound past the beginning. */
 
@@ -244,12 +368,14 @@ void bsv_movie_frame_rewind(bsv_movie_t *handle)
       {
          /* If recording, we simply reset
           * the starting point. Nice and easy. */
+         handle->buf_len = 0;
+         handle->buf_pos = handle->min_file_pos;
          fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
          pretro_serialize(handle->state, handle->state_size);
          fwrite(handle->state, 1, handle->state_size, handle->file);
       }
       else
-         fseek(handle->file, handle->min_file_pos, SEEK_SET);
+         bsv_movie_seek(handle, handle->min_file_pos);
    }
 }
 
@@ -42,6 +42,20 @@ enum rarch_movie_type
 
 bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type);
 
+/**
+ * bsv_movie_init_state:
+ * @path                 : path of the movie to record to.
+ * @state                : savestate the movie starts from.
+ * @state_size           : size of @state.
+ *
+ * Starts recording a movie from @state rather than 
+ * from the current state of the core.
+ *
+ * Returns: movie handle, or NULL on failure.
+ **/
+bsv_movie_t *bsv_movie_init_state(const char *path,
+      const void *state, size_t state_size);
+
 /* Playback. */
 bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input);
 
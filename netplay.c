@@ -21,49 +21,219 @@
 #include <stdlib.h>
 #include <string.h>
 #include <net/net_compat.h>
+#include <net/net_resolve.h>
+#include <file/file_path.h>
 #include "netplay.h"
 #include "general.h"
 #include "autosave.h"
 #include "dynamic.h"
+#include "content.h"
 #include "intl/intl.h"
+#include "hash.h"
+#include "performance.h"
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <file/file_extract.h>
+#endif
+
+#define NETPLAY_MAX_USERS 4
+
+/* Bump whenever the handshake, the packet layout or the session
+ * messages change, so mismatched peers are turned away. The
+ * original protocol counts as version 1. */
+#define NETPLAY_PROTOCOL_VERSION 2
 
 struct delta_frame
 {
    void *state;
 
-   uint16_t real_input_state;
-   uint16_t simulated_input_state;
+   /* Indexed by port. */
+   uint16_t real_input_state[NETPLAY_MAX_USERS];
+   uint16_t simulated_input_state[NETPLAY_MAX_USERS];
    uint16_t self_state;
 
    bool is_simulated;
    bool used_real;
+
+   /* What input_state_net() returned to the core when 
+    * this frame was last run, for recording. */
+   int16_t *record;
+   size_t record_ptr;
+   size_t record_size;
 };
 
 #define UDP_FRAME_PACKETS 16
-#define MAX_SPECTATORS 16
+#define MAX_SPECTATORS 64
+
+/* Input packets start with the port of the sender, the amount of frames 
+ * in the packet, a sequence number, how many frames of input we have 
+ * from the receiver (the ack) and the first frame in the packet. Only 
+ * frames the receiver has not acked yet are sent.
+ *
+ * Then follow the time the packet was sent, in microseconds of the 
+ * sender's clock, and the last such time we received from the 
+ * receiver, advanced by how long we held on to it. Subtracting it 
+ * from the receiver's clock gives the round trip time.
+ *
+ * Every frame is a byte with a bit for each port whose input changed 
+ * since the frame before, followed by the new input of those ports. 
+ * The first frame in the packet is relative to the frame before it, 
+ * which the receiver already acked. */
+#define UDP_HEADER_SIZE 20
+#define UDP_PACKET_SIZE (UDP_HEADER_SIZE \
+      + UDP_FRAME_PACKETS * (1 + 2 * (NETPLAY_MAX_USERS - 1)))
+
+/* Input sent to and received from a peer is remembered this long, 
+ * so we can encode against the frame the peer acked last. */
+#define NETPLAY_HISTORY (UDP_FRAME_PACKETS * 2)
+
+/* Savestates are sent in chunks of this size. */
+#define NETPLAY_CHUNK_SIZE (16 * 1024)
+#define NETPLAY_BLOB_HEADER_SIZE 8
+/* BSV header in front of the savestate sent to spectators. */
+#define BSV_HEADER_SIZE (4 * sizeof(uint32_t))
+/* Spectators joining at most this many frames after the last one 
+ * share its keyframe and replay the input since. */
+#define NETPLAY_SPECTATE_LOG_FRAMES 300
+/* Spectators falling further behind than this are dropped. */
+#define NETPLAY_SPECTATE_QUEUE_MAX (4 * 1024 * 1024)
 
 #define NETPLAY_CMD_ACK 0
 #define NETPLAY_CMD_NAK 1
 #define NETPLAY_CMD_FLIP_PLAYERS 2
+/* Commands below are not answered with ACK or NAK. */
+#define NETPLAY_CMD_CRC 3
+#define NETPLAY_CMD_REQUEST_SAVESTATE 4
+#define NETPLAY_CMD_LOAD_SAVESTATE 5
+
+/* CRCs from the host waiting for us to reach their frame. */
+#define NETPLAY_MAX_CRCS 8
+
+/* Recordings start a new movie from a savestate this often, 
+ * so they can be replayed from any of them. */
+#define NETPLAY_RECORD_KEYFRAME_FRAMES 3600
+
+/* Rendezvous-assisted hole punching, for when neither side can 
+ * accept inbound connections.
+ *
+ * Both sides connect over TCP to the rendezvous server and send 
+ * "RARCH_RDV 1 HOST <session>\n" or "RARCH_RDV 1 JOIN <session>\n". 
+ * They send the same line from their netplay UDP socket until 
+ * the server answers on TCP with "PEER <ip> <port>\n", the public 
+ * UDP endpoint of the other side as the server saw it. From then 
+ * on the server relays the TCP stream between both sides, while 
+ * they punch through their NATs by sending each other UDP packets 
+ * until one arrives. The host registers once for every client. */
+#define NETPLAY_RENDEZVOUS_MAGIC "RARCH_RDV 1"
+#define NETPLAY_PUNCH_MAGIC "RARCH_PUNCH"
+#define NETPLAY_PUNCH_MAGIC_SIZE (sizeof(NETPLAY_PUNCH_MAGIC) - 1)
+#define NETPLAY_REGISTER_MS 500
+#define NETPLAY_PUNCH_MS 100
+#define NETPLAY_PUNCH_TIMEOUT_MS 10000
+
+/* Netplay can't start without the address, but a DNS server 
+ * which doesn't answer shouldn't hang it for longer. */
+#define NETPLAY_RESOLVE_TIMEOUT_MS 5000
+/* Punches sent after we got through, in case ours were dropped 
+ * by the other NAT before it opened. */
+#define NETPLAY_PUNCH_EXTRA 3
 
 #define PREV_PTR(x) ((x) == 0 ? netplay->buffer_size - 1 : (x) - 1)
 #define NEXT_PTR(x) ((x + 1) % netplay->buffer_size)
 
+/* Another user we exchange input with. 
+ * A client only has the host as peer, while the host has every client 
+ * as peer and relays the input of all other users to each of them. */
+struct netplay_peer
+{
+   char nick[32];
+   /* TCP connection for state sending, etc. Also used for commands */
+   int fd;
+   /* Which port does this user control? */
+   unsigned port;
+
+   /* Where this user sends its UDP packets from. */
+   struct sockaddr_storage addr;
+   bool has_addr;
+
+   /* Input of this user has been received up to this frame. */
+   uint32_t read_frame_count;
+   /* Input has been sent to this user up to this frame. */
+   uint32_t send_frame_count;
+   /* This user has our input up to this frame. */
+   uint32_t ack_frame_count;
+
+   /* To compat UDP packet loss we keep sending 
+    * frames until they are acked. Indexed by frame. */
+   uint16_t send_history[NETPLAY_HISTORY][NETPLAY_MAX_USERS];
+   uint16_t read_history[NETPLAY_HISTORY][NETPLAY_MAX_USERS];
+
+   /* This user desynced and waits for our savestate. */
+   bool needs_savestate;
+
+   /* Telemetry, see netplay_update_telemetry(). */
+   uint16_t send_seq;
+   uint16_t read_seq;
+   bool has_read_seq;
+   unsigned packets_received;
+   unsigned packets_lost;
+   /* Last send time of the peer, when we received it, 
+    * and how long it took to arrive, in our clock. */
+   uint32_t peer_time;
+   uint32_t peer_time_received;
+   uint32_t transit;
+   bool has_peer_time;
+   /* Smoothed, in microseconds. */
+   unsigned rtt;
+   unsigned jitter;
+};
+
+/* An input packet as received from a peer. */
+struct netplay_packet
+{
+   struct sockaddr_storage addr;
+   retro_time_t time;
+   size_t size;
+   uint8_t data[UDP_PACKET_SIZE];
+};
+
+/* Packets the network thread can queue up before it drops them. */
+#define NETPLAY_NET_QUEUE_SIZE 64
+/* How often the network thread checks if it should quit. */
+#define NETPLAY_NET_THREAD_MS 50
+
+/* Data a spectator still has to receive. */
+struct netplay_spectate_queue
+{
+   uint8_t *data;
+   size_t size;
+   size_t pos;
+};
+
 struct netplay
 {
    char nick[32];
    char other_nick[32];
-   struct sockaddr_storage other_addr;
 
    struct retro_callbacks cbs;
-   /* TCP connection for state sending, etc. Also used for commands */
+   /* TCP socket the host listens on, or the connection 
+    * to the host when spectating. */
    int fd;
    /* UDP connection for game state updates. */
    int udp_fd;
-   /* Which port is governed by netplay (other user)? */
-   unsigned port;
+   /* Which port do we control? The host always has port 0. */
+   unsigned self_port;
+   /* Amount of users in the session, including ourselves. */
+   unsigned users;
    bool has_connection;
 
+   struct netplay_peer peers[NETPLAY_MAX_USERS - 1];
+   unsigned num_peers;
+
    struct delta_frame *buffer;
    size_t buffer_size;
 
@@ -71,31 +241,50 @@ struct netplay
    size_t self_ptr; 
    /* Points to the last reliable state that self ever had. */
    size_t other_ptr;
-   /* Pointer to where we are reading. 
-    * Generally, other_ptr <= read_ptr <= self_ptr. */
+   /* Pointer to where we have input from every peer. 
+    * Generally, other_ptr <= read_ptr <= self_ptr + input_delay. */
    size_t read_ptr;
    /* A temporary pointer used on replay. */
    size_t tmp_ptr;
 
    size_t state_size;
 
+   /* Maximum amount of frames we may run ahead of the other user's input. */
+   unsigned max_rollback;
+   /* Local input is sent this many frames ahead of the frame it applies to. */
+   unsigned input_delay;
+
    /* Are we replaying old frames? */
    bool is_replay;
    /* We don't want to poll several times on a frame. */
    bool can_poll;
 
-   /* To compat UDP packet loss we also send 
-    * old data along with the packets. */
-   uint32_t packet_buffer[UDP_FRAME_PACKETS * 2];
    uint32_t frame_count;
    uint32_t read_frame_count;
    uint32_t other_frame_count;
    uint32_t tmp_frame_count;
    struct addrinfo *addr;
-   struct sockaddr_storage their_addr;
-   bool has_client_addr;
+
+   /* Rendezvous server "server[:port]" to meet peers at 
+    * behind NATs, or empty to connect directly. */
+   char rendezvous[256];
+   uint16_t rendezvous_port;
 
    unsigned timeout_cnt;
+   /* When we started waiting at the rollback limit, or 0. */
+   retro_time_t stall_time;
+
+#ifdef HAVE_THREADS
+   /* Receives input packets, so we never wait on the socket. 
+    * Packets net_read up to net_write are queued in net_queue. */
+   sthread_t *net_thread;
+   slock_t *net_lock;
+   struct netplay_packet *net_queue;
+   unsigned net_read;
+   unsigned net_write;
+   bool net_quit;
+   bool net_error;
+#endif
 
    /* Spectating. */
    bool spectate;
@@ -104,14 +293,69 @@ struct netplay
    uint16_t *spectate_input;
    size_t spectate_input_ptr;
    size_t spectate_input_size;
+   struct netplay_spectate_queue spectate_queue[MAX_SPECTATORS];
+   /* Keyframe for joining spectators, and the input 
+    * of the spectate_log_frames frames since. */
+   uint8_t *spectate_keyframe;
+   size_t spectate_keyframe_size;
+   uint16_t *spectate_log;
+   size_t spectate_log_ptr;
+   size_t spectate_log_size;
+   unsigned spectate_log_frames;
+   /* Frames a spectator has to run to catch up with the host. */
+   uint32_t spectate_catchup;
 
    /* User flipping
     * Flipping state. If ptr >= flip_frame, we apply the flip.
-    * If not, we apply the opposite, effectively creating a trigger point.
+    * If not, we apply the previous one, effectively creating a trigger point.
+    * Every flip rotates the ports by one user, so with two users 
+    * this swaps them.
     * To avoid collition we need to make sure our client/host is synced up 
     * well after flip_frame before allowing another flip. */
-   bool flip;
+   unsigned flip;
    uint32_t flip_frame;
+
+   /* Desync detection.
+    * Every check_frames frames the host sends the CRC32 of its 
+    * savestate, which clients compare with their own once they 
+    * have every input of that frame. On mismatch, a client asks 
+    * the host for its savestate and replays from there. */
+   unsigned check_frames;
+   uint32_t check_frame_count;
+   struct
+   {
+      uint32_t frame;
+      uint32_t crc;
+   } crcs[NETPLAY_MAX_CRCS];
+   unsigned num_crcs;
+
+   /* Savestate from the host to load once we reach resync_frame. */
+   void *resync_state;
+   uint32_t resync_frame;
+   bool has_resync_state;
+   bool resync_requested;
+   /* Replay from other_ptr even if we predicted correctly. */
+   bool force_replay;
+
+   /* Recording of every frame we ran with the input of all users, 
+    * written once no rollback can change it anymore. Empty path 
+    * if we do not record. */
+   char record_path[PATH_MAX_LENGTH];
+   bsv_movie_t *record;
+   uint32_t record_frame_count;
+   /* Start a new movie on the next recorded frame. */
+   bool record_keyframe;
+
+   /* Session statistics, logged when the session ends. */
+   struct
+   {
+      unsigned rollbacks;
+      unsigned resimulated_frames;
+      unsigned max_depth;
+      unsigned stalls;
+      unsigned desyncs;
+      uint64_t bytes_sent;
+   } stats;
 };
 
 /**
@@ -149,29 +393,188 @@ static bool netplay_can_poll(netplay_t *netplay)
    return netplay->can_poll;
 }
 
-static bool send_chunk(netplay_t *netplay)
+/**
+ * netplay_port_sent:
+ * @netplay              : pointer to netplay object
+ * @peer                 : peer the input is exchanged with
+ * @port                 : port to check
+ * @to_peer              : true if we send to @peer, false if @peer sends to us
+ *
+ * A client only sends its own input, which is all the host takes from it.
+ * The host sends the input of every other user to a client.
+ *
+ * Returns: true (1) if input of @port is part of the packets, 
+ * otherwise false (0).
+ **/
+static bool netplay_port_sent(netplay_t *netplay,
+      const struct netplay_peer *peer, unsigned port, bool to_peer)
 {
-   const struct sockaddr *addr = NULL;
+   if (port >= netplay->users)
+      return false;
+   /* The host relays everyone but the receiving client. */
+   if (to_peer ? netplay->self_port == 0 : netplay->self_port != 0)
+      return port != (to_peer ? peer->port : netplay->self_port);
+   /* Clients only send their own input. */
+   return port == (to_peer ? netplay->self_port : peer->port);
+}
 
-   if (netplay->addr)
-      addr = netplay->addr->ai_addr;
-   else if (netplay->has_client_addr)
-      addr = (const struct sockaddr*)&netplay->their_addr;
+static void write_u32(uint8_t *data, uint32_t value)
+{
+   data[0] = value >> 24;
+   data[1] = value >> 16;
+   data[2] = value >>  8;
+   data[3] = value >>  0;
+}
+
+static uint32_t read_u32(const uint8_t *data)
+{
+   return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+      ((uint32_t)data[2] << 8) | data[3];
+}
+
+/**
+ * build_packet:
+ * @netplay              : pointer to netplay object
+ * @peer                 : peer to send to
+ * @data                 : buffer of UDP_PACKET_SIZE bytes
+ *
+ * Encodes every frame @peer has not acked yet.
+ *
+ * Returns: size of the packet.
+ **/
+static size_t build_packet(netplay_t *netplay, struct netplay_peer *peer,
+      uint8_t *data)
+{
+   unsigned i, j;
+   uint32_t now;
+   size_t size        = UDP_HEADER_SIZE;
+   uint32_t frame     = peer->ack_frame_count;
+   unsigned count     = peer->send_frame_count - frame;
+   const uint16_t *prev = peer->send_history[(frame - 1) % NETPLAY_HISTORY];
+
+   if (count > UDP_FRAME_PACKETS)
+      count = UDP_FRAME_PACKETS;
+
+   for (i = 0; i < count; i++)
+   {
+      const uint16_t *curr = peer->send_history[
+         (frame + i) % NETPLAY_HISTORY];
+      uint8_t *mask = &data[size++];
+
+      *mask = 0;
 
-   if (addr)
+      for (j = 0; j < netplay->users; j++)
+      {
+         if (!netplay_port_sent(netplay, peer, j, true) || curr[j] == prev[j])
+            continue;
+
+         *mask |= 1 << j;
+         data[size++] = curr[j] >> 8;
+         data[size++] = curr[j] & 0xff;
+      }
+
+      prev = curr;
+   }
+
+   now = (uint32_t)rarch_get_time_usec();
+
+   data[0] = netplay->self_port;
+   data[1] = count;
+   data[2] = peer->send_seq >> 8;
+   data[3] = peer->send_seq & 0xff;
+   write_u32(data + 4, peer->read_frame_count);
+   write_u32(data + 8, frame);
+   write_u32(data + 12, now);
+   write_u32(data + 16, peer->has_peer_time ? 
+         peer->peer_time + (now - peer->peer_time_received) : 0);
+
+   peer->send_seq++;
+   return size;
+}
+
+static bool send_chunk(netplay_t *netplay)
+{
+   unsigned i;
+
+   for (i = 0; i < netplay->num_peers; i++)
    {
-      if (sendto(netplay->udp_fd, (const char*)netplay->packet_buffer,
-               sizeof(netplay->packet_buffer), 0, addr,
-               sizeof(struct sockaddr)) != sizeof(netplay->packet_buffer))
+      uint8_t data[UDP_PACKET_SIZE];
+      size_t size;
+      struct netplay_peer *peer   = &netplay->peers[i];
+      const struct sockaddr *addr = NULL;
+
+      if (netplay->addr)
+         addr = netplay->addr->ai_addr;
+      else if (peer->has_addr)
+         addr = (const struct sockaddr*)&peer->addr;
+
+      if (!addr)
+         continue;
+
+      size = build_packet(netplay, peer, data);
+
+      if (sendto(netplay->udp_fd, (const char*)data, size, 0, addr,
+               sizeof(struct sockaddr)) != (ssize_t)size)
       {
          warn_hangup();
          netplay->has_connection = false;
          return false;
       }
+
+      netplay->stats.bytes_sent += size;
    }
    return true;
 }
 
+/**
+ * netplay_relay_input:
+ * @netplay              : pointer to netplay object
+ *
+ * Queues up input for every peer, for each frame where we know 
+ * the input of every user except that peer. A client only knows 
+ * its own input, while the host also relays input it got from 
+ * the other clients.
+ *
+ * Returns: true (1) if there is new input to send, otherwise false (0).
+ **/
+static bool netplay_relay_input(netplay_t *netplay)
+{
+   unsigned i, j;
+   bool queued = false;
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      struct netplay_peer *peer = &netplay->peers[i];
+      uint32_t end = netplay->frame_count + netplay->input_delay + 1;
+
+      for (j = 0; j < netplay->num_peers; j++)
+      {
+         if (j != i && netplay->peers[j].read_frame_count < end)
+            end = netplay->peers[j].read_frame_count;
+      }
+
+      /* Frames older than the history can not be resent. */
+      if (end > peer->ack_frame_count + NETPLAY_HISTORY - 1)
+         end = peer->ack_frame_count + NETPLAY_HISTORY - 1;
+
+      for (; peer->send_frame_count < end; peer->send_frame_count++)
+      {
+         const struct delta_frame *frame = &netplay->buffer[
+            peer->send_frame_count % netplay->buffer_size];
+         uint16_t *states = peer->send_history[
+            peer->send_frame_count % NETPLAY_HISTORY];
+
+         memcpy(states, frame->real_input_state,
+               sizeof(frame->real_input_state));
+         states[netplay->self_port] = frame->self_state;
+
+         queued = true;
+      }
+   }
+
+   return queued;
+}
+
 /**
  * get_self_input_state:
  * @netplay              : pointer to netplay object
@@ -184,7 +587,8 @@ static bool get_self_input_state(netplay_t *netplay)
 {
    unsigned i;
    uint32_t state          = 0;
-   struct delta_frame *ptr = &netplay->buffer[netplay->self_ptr];
+   struct delta_frame *ptr = &netplay->buffer[(netplay->self_ptr
+         + netplay->input_delay) % netplay->buffer_size];
    driver_t *driver        = driver_get_ptr();
    settings_t *settings    = config_get_ptr();
 
@@ -196,16 +600,14 @@ static bool get_self_input_state(netplay_t *netplay)
       for (i = 0; i < RARCH_FIRST_META_KEY; i++)
       {
          int16_t tmp = cb(settings->input.netplay_client_swap_input ?
-               0 : !netplay->port,
+               0 : netplay->self_port,
                RETRO_DEVICE_JOYPAD, 0, i);
          state |= tmp ? 1 << i : 0;
       }
    }
 
-   memmove(netplay->packet_buffer, netplay->packet_buffer + 2,
-         sizeof (netplay->packet_buffer) - 2 * sizeof(uint32_t));
-   netplay->packet_buffer[(UDP_FRAME_PACKETS - 1) * 2] = htonl(netplay->frame_count); 
-   netplay->packet_buffer[(UDP_FRAME_PACKETS - 1) * 2 + 1] = htonl(state);
+   ptr->self_state = state;
+   netplay_relay_input(netplay);
 
    if (!send_chunk(netplay))
    {
@@ -214,44 +616,423 @@ static bool get_self_input_state(netplay_t *netplay)
       return false;
    }
 
-   ptr->self_state = state;
    netplay->self_ptr = NEXT_PTR(netplay->self_ptr);
    return true;
 }
 
-static bool netplay_cmd_ack(netplay_t *netplay)
+/**
+ * netplay_blob_new:
+ * @data                 : data to send.
+ * @size                 : size of @data.
+ * @blob_size            : set to the size of the returned blob.
+ *
+ * Packs savestates and SRAM for sending. A blob is the raw size and 
+ * the deflated size, followed by the deflated data. A deflated size 
+ * of zero means the data is sent as is, which happens without zlib 
+ * or when the data does not compress.
+ *
+ * Returns: blob, which has to be free()'d, or NULL on error.
+ **/
+static uint8_t *netplay_blob_new(const void *data, size_t size,
+      size_t *blob_size)
+{
+   uint32_t comp_size = 0;
+   size_t bound       = NETPLAY_BLOB_HEADER_SIZE + size + (size >> 8) + 64;
+   uint8_t *blob      = (uint8_t*)malloc(bound);
+
+   if (!blob)
+      return NULL;
+
+#ifdef HAVE_ZLIB_DEFLATE
+   if (size)
+   {
+      void *stream = zlib_stream_new();
+
+      if (stream)
+      {
+         zlib_set_stream(stream, size, bound - NETPLAY_BLOB_HEADER_SIZE,
+               (const uint8_t*)data, blob + NETPLAY_BLOB_HEADER_SIZE);
+         zlib_deflate_init(stream, 6);
+
+         if (zlib_deflate_data_to_file(stream) == 1
+               && zlib_stream_get_total_out(stream) < size)
+            comp_size = zlib_stream_get_total_out(stream);
+
+         zlib_stream_deflate_free(stream);
+         free(stream);
+      }
+   }
+#endif
+
+   if (!comp_size)
+      memcpy(blob + NETPLAY_BLOB_HEADER_SIZE, data, size);
+
+   write_u32(blob + 0, size);
+   write_u32(blob + 4, comp_size);
+
+   *blob_size = NETPLAY_BLOB_HEADER_SIZE + (comp_size ? comp_size : size);
+   return blob;
+}
+
+/**
+ * netplay_blob_size:
+ * @header               : first NETPLAY_BLOB_HEADER_SIZE bytes of a blob.
+ *
+ * Returns: amount of bytes following the header.
+ **/
+static size_t netplay_blob_size(const uint8_t *header)
+{
+   uint32_t comp_size = read_u32(header + 4);
+   return comp_size ? comp_size : read_u32(header + 0);
+}
+
+/**
+ * netplay_blob_read:
+ * @blob                 : blob to unpack.
+ * @blob_size            : size of @blob.
+ * @data                 : buffer to unpack into.
+ * @size                 : size @data is expected to have.
+ *
+ * Unpacks a blob made by netplay_blob_new().
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool netplay_blob_read(const uint8_t *blob, size_t blob_size,
+      void *data, size_t size)
+{
+   uint32_t comp_size;
+
+   if (blob_size < NETPLAY_BLOB_HEADER_SIZE || read_u32(blob) != size
+         || blob_size != NETPLAY_BLOB_HEADER_SIZE + netplay_blob_size(blob))
+      return false;
+
+   comp_size = read_u32(blob + 4);
+
+   if (!comp_size)
+   {
+      memcpy(data, blob + NETPLAY_BLOB_HEADER_SIZE, size);
+      return true;
+   }
+
+#ifdef HAVE_ZLIB_DEFLATE
+   {
+      bool ret     = false;
+      void *stream = zlib_stream_new();
+
+      if (stream && zlib_inflate_init(stream))
+      {
+         zlib_set_stream(stream, comp_size, size,
+               blob + NETPLAY_BLOB_HEADER_SIZE, (uint8_t*)data);
+         ret = zlib_inflate_data_to_file_iterate(stream) == 1
+            && zlib_stream_get_total_out(stream) == size;
+      }
+
+      if (stream)
+      {
+         zlib_stream_free(stream);
+         free(stream);
+      }
+      return ret;
+   }
+#else
+   RARCH_ERR("Netplay peer sent compressed data, but zlib is not available.\n");
+   return false;
+#endif
+}
+
+static bool send_blob(int fd, const void *data, size_t size)
+{
+   size_t blob_size;
+   bool ret      = false;
+   uint8_t *blob = netplay_blob_new(data, size, &blob_size);
+
+   if (blob)
+      ret = socket_send_all_blocking(fd, blob, blob_size);
+
+   free(blob);
+   return ret;
+}
+
+static bool receive_blob(int fd, void *data, size_t size)
+{
+   size_t blob_size;
+   bool ret = false;
+   uint8_t header[NETPLAY_BLOB_HEADER_SIZE];
+   uint8_t *blob = NULL;
+
+   if (!socket_receive_all_blocking(fd, header, sizeof(header)))
+      return false;
+
+   if (read_u32(header) != size)
+   {
+      RARCH_ERR("Netplay peer sent %u bytes, expected %u.\n",
+            (unsigned)read_u32(header), (unsigned)size);
+      return false;
+   }
+
+   blob_size = NETPLAY_BLOB_HEADER_SIZE + netplay_blob_size(header);
+   blob      = (uint8_t*)malloc(blob_size);
+
+   if (blob)
+   {
+      memcpy(blob, header, sizeof(header));
+      ret = socket_receive_all_blocking(fd, blob + sizeof(header),
+               blob_size - sizeof(header))
+         && netplay_blob_read(blob, blob_size, data, size);
+   }
+
+   free(blob);
+   return ret;
+}
+
+static bool netplay_send_cmd(struct netplay_peer *peer, uint32_t cmd,
+      const void *data, size_t size)
+{
+   cmd = (cmd << 16) | (size & 0xffff);
+   cmd = htonl(cmd);
+
+   if (!socket_send_all_blocking(peer->fd, &cmd, sizeof(cmd)))
+      return false;
+
+   if (!socket_send_all_blocking(peer->fd, data, size))
+      return false;
+
+   return true;
+}
+
+static bool netplay_cmd_ack(struct netplay_peer *peer)
 {
    uint32_t cmd = htonl(NETPLAY_CMD_ACK);
-   return socket_send_all_blocking(netplay->fd, &cmd, sizeof(cmd));
+   return socket_send_all_blocking(peer->fd, &cmd, sizeof(cmd));
 }
 
-static bool netplay_cmd_nak(netplay_t *netplay)
+static bool netplay_cmd_nak(struct netplay_peer *peer)
 {
    uint32_t cmd = htonl(NETPLAY_CMD_NAK);
-   return socket_send_all_blocking(netplay->fd, &cmd, sizeof(cmd));
+   return socket_send_all_blocking(peer->fd, &cmd, sizeof(cmd));
 }
 
-static bool netplay_get_response(netplay_t *netplay)
+/**
+ * netplay_state_crc:
+ * @netplay              : pointer to netplay object
+ * @frame                : frame to get the savestate CRC of.
+ * @crc                  : set to the CRC32 of the savestate.
+ *
+ * Only savestates of frames we have every input for can be 
+ * compared, and only as long as they are kept in the buffer.
+ *
+ * Returns: true (1) if the savestate of @frame is available, 
+ * otherwise false (0).
+ **/
+static bool netplay_state_crc(netplay_t *netplay, uint32_t frame,
+      uint32_t *crc)
 {
-   uint32_t response;
-   if (!socket_receive_all_blocking(netplay->fd, &response, sizeof(response)))
+   if (frame > netplay->other_frame_count 
+         || netplay->frame_count - frame >= netplay->buffer_size)
       return false;
 
-   return ntohl(response) == NETPLAY_CMD_ACK;
+   *crc = crc32_calculate((const uint8_t*)
+         netplay->buffer[frame % netplay->buffer_size].state,
+         netplay->state_size);
+   return true;
 }
 
-static bool netplay_get_cmd(netplay_t *netplay)
+static bool netplay_request_savestate(netplay_t *netplay)
 {
-   uint32_t cmd, flip_frame;
-   size_t cmd_size;
-
-   if (!socket_receive_all_blocking(netplay->fd, &cmd, sizeof(cmd)))
+   if (!netplay_send_cmd(&netplay->peers[0],
+            NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0))
       return false;
 
-   cmd = ntohl(cmd);
+   netplay->resync_requested = true;
+   return true;
+}
+
+/**
+ * netplay_check_crcs:
+ * @netplay              : pointer to netplay object
+ *
+ * Compares the CRCs the host sent with our own savestates, 
+ * and asks the host for its savestate if we diverged.
+ *
+ * Returns: false (0) if the host disconnected, otherwise true (1).
+ **/
+static bool netplay_check_crcs(netplay_t *netplay)
+{
+   unsigned i = 0;
+
+   while (i < netplay->num_crcs)
+   {
+      uint32_t crc;
+      uint32_t frame = netplay->crcs[i].frame;
+
+      if (frame > netplay->other_frame_count)
+      {
+         i++;
+         continue;
+      }
+
+      if (netplay_state_crc(netplay, frame, &crc) 
+            && crc != netplay->crcs[i].crc && !netplay->resync_requested)
+      {
+         RARCH_WARN("Netplay desynced on frame %u, resyncing with host ...\n",
+               (unsigned)frame);
+         netplay->stats.desyncs++;
+
+         if (!netplay_request_savestate(netplay))
+            return false;
+      }
+
+      netplay->num_crcs--;
+      memmove(&netplay->crcs[i], &netplay->crcs[i + 1],
+            (netplay->num_crcs - i) * sizeof(netplay->crcs[0]));
+   }
+
+   return true;
+}
+
+/**
+ * netplay_load_resync_state:
+ * @netplay              : pointer to netplay object
+ *
+ * Loads the savestate the host sent us after a desync. Frames we 
+ * already ran since then are replayed in netplay_post_frame_net(). 
+ * Call this before running the current frame.
+ **/
+static void netplay_load_resync_state(netplay_t *netplay)
+{
+   unsigned i;
+   uint32_t frame = netplay->resync_frame;
+
+   if (frame > netplay->frame_count)
+      return;
+
+   netplay->has_resync_state = false;
+
+   if (netplay->frame_count + netplay->input_delay - frame
+         >= netplay->buffer_size)
+   {
+      RARCH_WARN("Netplay savestate from host is too old, asking again ...\n");
+      if (!netplay_request_savestate(netplay))
+         netplay->has_connection = false;
+      return;
+   }
+
+   memcpy(netplay->buffer[frame % netplay->buffer_size].state,
+         netplay->resync_state, netplay->state_size);
+
+   if (frame == netplay->frame_count)
+      pretro_unserialize(netplay->resync_state, netplay->state_size);
+   else
+      netplay->force_replay = true;
+
+   netplay->other_frame_count = frame;
+   netplay->other_ptr         = frame % netplay->buffer_size;
+   netplay->resync_requested  = false;
+
+   /* The recording goes on from the host's state. */
+   netplay->record_frame_count = frame;
+   netplay->record_keyframe    = true;
+
+   /* Older savestates are not comparable anymore. */
+   for (i = 0; i < netplay->num_crcs; )
+   {
+      if (netplay->crcs[i].frame >= frame)
+      {
+         i++;
+         continue;
+      }
+
+      netplay->num_crcs--;
+      memmove(&netplay->crcs[i], &netplay->crcs[i + 1],
+            (netplay->num_crcs - i) * sizeof(netplay->crcs[0]));
+   }
+
+   RARCH_LOG("Netplay resynced with host on frame %u.\n", (unsigned)frame);
+   rarch_main_msg_queue_push("Netplay resynced with host.", 1, 180, false);
+}
+
+/**
+ * netplay_send_crcs:
+ * @netplay              : pointer to netplay object
+ *
+ * Sends the CRC of every check_frames'th savestate to all clients 
+ * once we have every input of its frame.
+ *
+ * Returns: false (0) if a user disconnected, otherwise true (1).
+ **/
+static bool netplay_send_crcs(netplay_t *netplay)
+{
+   unsigned i;
+
+   while (netplay->check_frames 
+         && netplay->check_frame_count <= netplay->other_frame_count)
+   {
+      uint32_t crc[2];
+      uint32_t frame = netplay->check_frame_count;
+
+      netplay->check_frame_count += netplay->check_frames;
+
+      if (!netplay_state_crc(netplay, frame, &crc[1]))
+         continue;
+
+      crc[0] = htonl(frame);
+      crc[1] = htonl(crc[1]);
+
+      for (i = 0; i < netplay->num_peers; i++)
+         if (!netplay_send_cmd(&netplay->peers[i], NETPLAY_CMD_CRC,
+                  crc, sizeof(crc)))
+            return false;
+   }
+
+   return true;
+}
+
+/**
+ * netplay_send_savestates:
+ * @netplay              : pointer to netplay object
+ *
+ * Sends our last reliable savestate to every user that desynced. 
+ * Call this after serializing the current frame.
+ *
+ * Returns: false (0) if a user disconnected, otherwise true (1).
+ **/
+static bool netplay_send_savestates(netplay_t *netplay)
+{
+   unsigned i;
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      uint32_t frame;
+      struct netplay_peer *peer = &netplay->peers[i];
+
+      if (!peer->needs_savestate)
+         continue;
+
+      frame = htonl(netplay->other_frame_count);
+
+      if (!netplay_send_cmd(peer, NETPLAY_CMD_LOAD_SAVESTATE,
+               &frame, sizeof(frame))
+            || !send_blob(peer->fd,
+               netplay->buffer[netplay->other_ptr].state,
+               netplay->state_size))
+         return false;
+
+      RARCH_LOG("Sent savestate of frame %u to user %u.\n",
+            (unsigned)netplay->other_frame_count, peer->port + 1);
+      peer->needs_savestate = false;
+   }
 
-   cmd_size = cmd & 0xffff;
-   cmd      = cmd >> 16;
+   return true;
+}
+
+static bool netplay_handle_cmd(netplay_t *netplay,
+      struct netplay_peer *peer, uint32_t cmd)
+{
+   uint32_t flip_frame;
+   uint32_t crc[2];
+   size_t cmd_size = cmd & 0xffff;
+
+   cmd = cmd >> 16;
 
    switch (cmd)
    {
@@ -259,13 +1040,13 @@ static bool netplay_get_cmd(netplay_t *netplay)
          if (cmd_size != sizeof(uint32_t))
          {
             RARCH_ERR("CMD_FLIP_PLAYERS has unexpected command size.\n");
-            return netplay_cmd_nak(netplay);
+            return netplay_cmd_nak(peer);
          }
 
-         if (!socket_receive_all_blocking(netplay->fd, &flip_frame, sizeof(flip_frame)))
+         if (!socket_receive_all_blocking(peer->fd, &flip_frame, sizeof(flip_frame)))
          {
             RARCH_ERR("Failed to receive CMD_FLIP_PLAYERS argument.\n");
-            return netplay_cmd_nak(netplay);
+            return netplay_cmd_nak(peer);
          }
 
          flip_frame = ntohl(flip_frame);
@@ -273,141 +1054,607 @@ static bool netplay_get_cmd(netplay_t *netplay)
          if (flip_frame < netplay->flip_frame)
          {
             RARCH_ERR("Host asked us to flip users in the past. Not possible ...\n");
-            return netplay_cmd_nak(netplay);
+            return netplay_cmd_nak(peer);
          }
 
-         netplay->flip ^= true;
+         netplay->flip = (netplay->flip + 1) % netplay->users;
          netplay->flip_frame = flip_frame;
 
          RARCH_LOG("Netplay users are flipped.\n");
          rarch_main_msg_queue_push("Netplay users are flipped.", 1, 180, false);
 
-         return netplay_cmd_ack(netplay);
+         return netplay_cmd_ack(peer);
+
+      case NETPLAY_CMD_CRC:
+         if (cmd_size != sizeof(crc) 
+               || !socket_receive_all_blocking(peer->fd, crc, sizeof(crc)))
+         {
+            RARCH_ERR("Failed to receive CMD_CRC argument.\n");
+            return false;
+         }
+
+         if (netplay->num_crcs == NETPLAY_MAX_CRCS)
+         {
+            netplay->num_crcs--;
+            memmove(&netplay->crcs[0], &netplay->crcs[1],
+                  netplay->num_crcs * sizeof(netplay->crcs[0]));
+         }
+
+         netplay->crcs[netplay->num_crcs].frame = ntohl(crc[0]);
+         netplay->crcs[netplay->num_crcs].crc   = ntohl(crc[1]);
+         netplay->num_crcs++;
+         return true;
+
+      case NETPLAY_CMD_REQUEST_SAVESTATE:
+         if (netplay->self_port != 0 || cmd_size != 0)
+         {
+            RARCH_ERR("Unexpected CMD_REQUEST_SAVESTATE.\n");
+            return false;
+         }
+
+         peer->needs_savestate = true;
+         return true;
+
+      case NETPLAY_CMD_LOAD_SAVESTATE:
+         if (cmd_size != sizeof(uint32_t) 
+               || !socket_receive_all_blocking(peer->fd,
+                  &netplay->resync_frame, sizeof(netplay->resync_frame))
+               || !receive_blob(peer->fd, netplay->resync_state,
+                  netplay->state_size))
+         {
+            RARCH_ERR("Failed to receive savestate from host.\n");
+            return false;
+         }
+
+         netplay->resync_frame     = ntohl(netplay->resync_frame);
+         netplay->has_resync_state = true;
+         netplay_load_resync_state(netplay);
+         return true;
 
       default:
          break;
    }
 
    RARCH_ERR("Unknown netplay command received.\n");
-   return netplay_cmd_nak(netplay);
+   return netplay_cmd_nak(peer);
+}
+
+static bool netplay_get_response(netplay_t *netplay,
+      struct netplay_peer *peer)
+{
+   uint32_t response;
+
+   for (;;)
+   {
+      if (!socket_receive_all_blocking(peer->fd, &response, sizeof(response)))
+         return false;
+
+      response = ntohl(response);
+
+      if (response == NETPLAY_CMD_ACK)
+         return true;
+      if (response == NETPLAY_CMD_NAK)
+         return false;
+
+      /* A command that crossed ours. */
+      if (!netplay_handle_cmd(netplay, peer, response))
+         return false;
+   }
+}
+
+static bool netplay_get_cmd(netplay_t *netplay, struct netplay_peer *peer)
+{
+   uint32_t cmd;
+
+   if (!socket_receive_all_blocking(peer->fd, &cmd, sizeof(cmd)))
+      return false;
+
+   return netplay_handle_cmd(netplay, peer, ntohl(cmd));
 }
 
 #define MAX_RETRIES 16
 #define RETRY_MS 500
 
-static int poll_input(netplay_t *netplay, bool block)
+/**
+ * poll_cmds:
+ * @netplay              : pointer to netplay object
+ *
+ * Handles commands peers sent over TCP, without blocking.
+ *
+ * Returns: false (0) if a peer disconnected, otherwise true (1).
+ **/
+static bool poll_cmds(netplay_t *netplay)
+{
+   unsigned i;
+   fd_set fds;
+   int max_fd            = -1;
+   struct timeval tmp_tv = {0};
+
+   FD_ZERO(&fds);
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      FD_SET(netplay->peers[i].fd, &fds);
+      if (netplay->peers[i].fd > max_fd)
+         max_fd = netplay->peers[i].fd;
+   }
+
+   if (socket_select(max_fd + 1, &fds, NULL, NULL, &tmp_tv) < 0)
+      return false;
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      if (FD_ISSET(netplay->peers[i].fd, &fds)
+            && !netplay_get_cmd(netplay, &netplay->peers[i]))
+         return false;
+   }
+
+   return true;
+}
+
+#ifdef HAVE_THREADS
+/**
+ * netplay_net_thread:
+ * @data                 : pointer to netplay object
+ *
+ * Receives input packets as soon as they arrive and queues 
+ * them for the main thread, which never waits on the socket.
+ **/
+static void netplay_net_thread(void *data)
 {
-   int max_fd        = (netplay->fd > netplay->udp_fd ? netplay->fd : netplay->udp_fd) + 1;
-   struct timeval tv = {0};
-   tv.tv_sec         = 0;
-   tv.tv_usec        = block ? (RETRY_MS * 1000) : 0;
+   netplay_t *netplay = (netplay_t*)data;
 
-   do
-   { 
+   for (;;)
+   {
       fd_set fds;
-      /* select() does not take pointer to const struct timeval.
-       * Technically possible for select() to modify tmp_tv, so 
-       * we go paranoia mode. */
-      struct timeval tmp_tv = tv;
+      ssize_t ret;
+      bool quit, full;
+      struct netplay_packet *packet;
+      struct netplay_packet dropped;
+      struct timeval tmp_tv = {0};
+      socklen_t addrlen     = sizeof(packet->addr);
 
-      netplay->timeout_cnt++;
+      slock_lock(netplay->net_lock);
+      quit = netplay->net_quit;
+      full = netplay->net_write - netplay->net_read == NETPLAY_NET_QUEUE_SIZE;
+      slock_unlock(netplay->net_lock);
+
+      if (quit)
+         return;
 
       FD_ZERO(&fds);
       FD_SET(netplay->udp_fd, &fds);
-      FD_SET(netplay->fd, &fds);
+      tmp_tv.tv_usec = NETPLAY_NET_THREAD_MS * 1000;
 
-      if (socket_select(max_fd, &fds, NULL, NULL, &tmp_tv) < 0)
-         return -1;
+      if (socket_select(netplay->udp_fd + 1, &fds, NULL, NULL, &tmp_tv) < 0)
+         break;
+
+      if (!FD_ISSET(netplay->udp_fd, &fds))
+         continue;
+
+      /* Only we write to the slot after the last queued packet. 
+       * If the main thread fell this far behind, the packet is 
+       * dropped and resent by the peer like a lost one. */
+      packet = full ? &dropped 
+         : &netplay->net_queue[netplay->net_write % NETPLAY_NET_QUEUE_SIZE];
 
-      /* Somewhat hacky,
-       * but we aren't using the TCP connection for anything useful atm. */
-      if (FD_ISSET(netplay->fd, &fds) && !netplay_get_cmd(netplay))
-         return -1; 
+      ret = recvfrom(netplay->udp_fd, (char*)packet->data,
+            sizeof(packet->data), 0,
+            (struct sockaddr*)&packet->addr, &addrlen);
+      if (ret < 0)
+         break;
 
-      if (FD_ISSET(netplay->udp_fd, &fds))
-         return 1;
+      packet->size = ret;
+      packet->time = rarch_get_time_usec();
 
-      if (!block)
+      if (full)
          continue;
 
-      if (!send_chunk(netplay))
+      slock_lock(netplay->net_lock);
+      netplay->net_write++;
+      slock_unlock(netplay->net_lock);
+   }
+
+   slock_lock(netplay->net_lock);
+   netplay->net_error = true;
+   slock_unlock(netplay->net_lock);
+}
+#endif
+
+/**
+ * read_packet:
+ * @netplay              : pointer to netplay object
+ * @packet               : set to the next received packet.
+ *
+ * Gets the next input packet without blocking, from the 
+ * network thread if there is one.
+ *
+ * Returns: 1 if a packet was received, 0 if there is none 
+ * and -1 if no packet could be received.
+ **/
+static int read_packet(netplay_t *netplay, struct netplay_packet *packet)
+{
+   fd_set fds;
+   ssize_t ret;
+   struct timeval tmp_tv = {0};
+   socklen_t addrlen     = sizeof(packet->addr);
+
+#ifdef HAVE_THREADS
+   if (netplay->net_thread)
+   {
+      int res = 0;
+
+      slock_lock(netplay->net_lock);
+      if (netplay->net_read != netplay->net_write)
+      {
+         *packet = netplay->net_queue[
+            netplay->net_read % NETPLAY_NET_QUEUE_SIZE];
+         netplay->net_read++;
+         res = 1;
+      }
+      else if (netplay->net_error)
+         res = -1;
+      slock_unlock(netplay->net_lock);
+
+      return res;
+   }
+#endif
+
+   FD_ZERO(&fds);
+   FD_SET(netplay->udp_fd, &fds);
+
+   if (socket_select(netplay->udp_fd + 1, &fds, NULL, NULL, &tmp_tv) < 0)
+      return -1;
+
+   if (!FD_ISSET(netplay->udp_fd, &fds))
+      return 0;
+
+   ret = recvfrom(netplay->udp_fd, (char*)packet->data,
+         sizeof(packet->data), 0,
+         (struct sockaddr*)&packet->addr, &addrlen);
+   if (ret < 0)
+      return -1;
+
+   packet->size = ret;
+   packet->time = rarch_get_time_usec();
+   return 1;
+}
+
+/**
+ * packet_peer:
+ * @netplay              : pointer to netplay object
+ * @packet               : received packet.
+ *
+ * Finds the peer that sent a packet.
+ *
+ * Returns: the peer, or NULL if the packet is truncated 
+ * or came from an unknown port.
+ **/
+static struct netplay_peer *packet_peer(netplay_t *netplay,
+      const struct netplay_packet *packet)
+{
+   unsigned i, port;
+
+   /* Late hole punches of a rendezvous session. */
+   if (packet->size == NETPLAY_PUNCH_MAGIC_SIZE
+         && !memcmp(packet->data, NETPLAY_PUNCH_MAGIC,
+            NETPLAY_PUNCH_MAGIC_SIZE))
+      return NULL;
+
+   if (packet->size < UDP_HEADER_SIZE)
+   {
+      RARCH_WARN("Got truncated netplay packet.\n");
+      return NULL;
+   }
+
+   port = packet->data[0];
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      /* A client only hears from the host, which sends 
+       * the input of every other user. */
+      if (netplay->self_port != 0 || netplay->peers[i].port == port)
+      {
+         struct netplay_peer *peer = &netplay->peers[i];
+         peer->addr     = packet->addr;
+         peer->has_addr = true;
+         return peer;
+      }
+   }
+
+   RARCH_WARN("Got netplay packet from unknown port %u.\n", port);
+   return NULL;
+}
+
+/**
+ * netplay_update_read:
+ * @netplay              : pointer to netplay object
+ *
+ * Marks the frames we have input of every peer for as real.
+ **/
+static void netplay_update_read(netplay_t *netplay)
+{
+   unsigned i;
+   uint32_t read_frame_count = netplay->peers[0].read_frame_count;
+
+   for (i = 1; i < netplay->num_peers; i++)
+      if (netplay->peers[i].read_frame_count < read_frame_count)
+         read_frame_count = netplay->peers[i].read_frame_count;
+
+   while (netplay->read_frame_count < read_frame_count)
+   {
+      netplay->buffer[netplay->read_ptr].is_simulated = false;
+      netplay->read_ptr = NEXT_PTR(netplay->read_ptr);
+      netplay->read_frame_count++;
+      netplay->timeout_cnt = 0;
+   }
+}
+
+static void parse_packet(netplay_t *netplay, struct netplay_peer *peer,
+      const uint8_t *data, size_t size)
+{
+   unsigned i, j;
+   uint16_t states[NETPLAY_MAX_USERS];
+   unsigned count  = data[1];
+   uint32_t ack    = read_u32(data + 4);
+   uint32_t first  = read_u32(data + 8);
+   size_t pos      = UDP_HEADER_SIZE;
+
+   if (ack > peer->ack_frame_count && ack <= peer->send_frame_count)
+      peer->ack_frame_count = ack;
+
+   /* We can only decode against a frame we still have, 
+    * and we did not ack anything after what we have. */
+   if (first > peer->read_frame_count
+         || peer->read_frame_count - first >= NETPLAY_HISTORY)
+      return;
+
+   memcpy(states, peer->read_history[(first - 1) % NETPLAY_HISTORY],
+         sizeof(states));
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t frame_count = first + i;
+      uint8_t mask;
+
+      if (pos >= size)
+         break;
+
+      mask = data[pos++];
+
+      for (j = 0; j < netplay->users; j++)
+      {
+         if (!(mask & (1 << j)))
+            continue;
+
+         if (pos + 2 > size || !netplay_port_sent(netplay, peer, j, false))
+         {
+            RARCH_WARN("Got malformed netplay packet.\n");
+            return;
+         }
+
+         states[j] = (data[pos] << 8) | data[pos + 1];
+         pos += 2;
+      }
+
+      if (frame_count != peer->read_frame_count)
+         continue;
+      if (peer->read_frame_count > netplay->frame_count + netplay->input_delay)
+         break;
+
+      memcpy(peer->read_history[frame_count % NETPLAY_HISTORY], states,
+            sizeof(states));
+
+      for (j = 0; j < netplay->users; j++)
+      {
+         /* The host only takes the input of the port the client 
+          * controls, clients take everything but their own. */
+         if (netplay_port_sent(netplay, peer, j, false))
+            netplay->buffer[frame_count % netplay->buffer_size]
+               .real_input_state[j] = states[j];
+      }
+
+      peer->read_frame_count++;
+   }
+
+   netplay_update_read(netplay);
+}
+
+/**
+ * netplay_rollback_full:
+ * @netplay              : pointer to netplay object
+ *
+ * Checks if running the current frame would take us further 
+ * ahead of the other users' input than we are able to roll back.
+ *
+ * Returns: true (1) if we have to block for input, otherwise false (0).
+ **/
+static bool netplay_rollback_full(netplay_t *netplay)
+{
+   return netplay->frame_count + 1
+      > netplay->read_frame_count + netplay->max_rollback;
+}
+
+/* TODO: Somewhat better prediction. :P */
+static void simulate_input(netplay_t *netplay)
+{
+   size_t ptr  = PREV_PTR(netplay->self_ptr);
+   size_t prev = PREV_PTR(netplay->read_ptr);
+
+   memcpy(netplay->buffer[ptr].simulated_input_state,
+         netplay->buffer[prev].real_input_state,
+         sizeof(netplay->buffer[ptr].simulated_input_state));
+   netplay->buffer[ptr].is_simulated = true;
+   netplay->buffer[ptr].used_real = false;
+}
+
+static struct retro_perf_counter netplay_rtt_usec    = {"netplay_rtt_usec"};
+static struct retro_perf_counter netplay_jitter_usec = {"netplay_jitter_usec"};
+static struct retro_perf_counter netplay_frames_ahead = {"netplay_frames_ahead"};
+
+/**
+ * netplay_perf_sample:
+ * @perf                 : counter to add to.
+ * @value                : sample.
+ *
+ * Adds a sample to a performance counter, which is logged 
+ * as the average of the samples instead of ticks.
+ **/
+static void netplay_perf_sample(struct retro_perf_counter *perf,
+      uint64_t value)
+{
+   global_t *global = global_get_ptr();
+
+   if (!global->perfcnt_enable)
+      return;
+
+   if (!perf->registered)
+      rarch_perf_register(perf);
+
+   perf->call_cnt++;
+   perf->total += value;
+}
+
+/**
+ * netplay_update_telemetry:
+ * @peer                 : peer that sent @packet.
+ * @packet               : received packet.
+ *
+ * Updates packet loss, round trip time and jitter of @peer. 
+ * Jitter is the smoothed change in transit time from one 
+ * packet to the next, as in RFC 3550.
+ **/
+static void netplay_update_telemetry(struct netplay_peer *peer,
+      const struct netplay_packet *packet)
+{
+   uint16_t seq     = (packet->data[2] << 8) | packet->data[3];
+   uint32_t time    = read_u32(packet->data + 12);
+   uint32_t echo    = read_u32(packet->data + 16);
+   uint32_t now     = (uint32_t)packet->time;
+   uint32_t transit = now - time;
+
+   if (!peer->has_read_seq)
+   {
+      peer->read_seq     = seq;
+      peer->has_read_seq = true;
+      peer->packets_received++;
+   }
+   else if ((int16_t)(seq - peer->read_seq) > 0)
+   {
+      peer->packets_lost += (uint16_t)(seq - peer->read_seq) - 1;
+      peer->read_seq = seq;
+      peer->packets_received++;
+   }
+   else
+      /* Reordered, it was not lost after all. */
+      if (peer->packets_lost)
+         peer->packets_lost--;
+
+   if (echo)
+   {
+      int32_t rtt = (int32_t)(now - echo);
+
+      if (rtt >= 0)
       {
-         warn_hangup();
-         netplay->has_connection = false;
-         return -1;
+         peer->rtt += (rtt - (int32_t)peer->rtt) / 8;
+         netplay_perf_sample(&netplay_rtt_usec, rtt);
       }
+   }
 
-      RARCH_LOG("Network is stalling, resending packet... Count %u of %d ...\n",
-            netplay->timeout_cnt, MAX_RETRIES);
-   } while ((netplay->timeout_cnt < MAX_RETRIES) && block);
+   if (peer->has_peer_time)
+   {
+      int32_t d = (int32_t)(transit - peer->transit);
 
-   if (block)
-      return -1;
-   return 0;
+      if (d < 0)
+         d = -d;
+      peer->jitter += (d - (int32_t)peer->jitter) / 16;
+      netplay_perf_sample(&netplay_jitter_usec, peer->jitter);
+   }
+
+   peer->peer_time          = time;
+   peer->peer_time_received = now;
+   peer->transit            = transit;
+   peer->has_peer_time      = true;
 }
 
-static bool receive_data(netplay_t *netplay, uint32_t *buffer, size_t size)
+/**
+ * netplay_receive_input:
+ * @netplay              : pointer to netplay object
+ *
+ * Handles pending commands and parses every input packet 
+ * received so far. Never blocks.
+ *
+ * Returns: false (0) if we lost the connection, otherwise true (1).
+ **/
+static bool netplay_receive_input(netplay_t *netplay)
 {
-   socklen_t addrlen = sizeof(netplay->their_addr);
+   int res;
+   struct netplay_packet packet;
 
-   if (recvfrom(netplay->udp_fd, (char*)buffer, size, 0,
-            (struct sockaddr*)&netplay->their_addr, &addrlen) != (ssize_t)size)
+   if (!poll_cmds(netplay))
       return false;
 
-   netplay->has_client_addr = true;
+   while ((res = read_packet(netplay, &packet)) == 1)
+   {
+      struct netplay_peer *peer = packet_peer(netplay, &packet);
+      if (!peer)
+         continue;
+
+      netplay_update_telemetry(peer, &packet);
+      parse_packet(netplay, peer, packet.data, packet.size);
+   }
 
-   return true;
+   return res == 0;
 }
 
-static void parse_packet(netplay_t *netplay, uint32_t *buffer, unsigned size)
+/**
+ * netplay_stall:
+ * @netplay              : pointer to netplay object
+ *
+ * Called instead of running a frame while we are at the rollback 
+ * limit. Resends our input every RETRY_MS, in case it got lost, 
+ * and gives up on the connection after MAX_RETRIES tries.
+ **/
+static void netplay_stall(netplay_t *netplay)
 {
-   unsigned i;
+   retro_time_t now = rarch_get_time_usec();
 
-   for (i = 0; i < size * 2; i++)
-      buffer[i] = ntohl(buffer[i]);
-
-   for (i = 0; i < size && netplay->read_frame_count <= netplay->frame_count; i++)
+   if (!netplay->stall_time)
    {
-      uint32_t frame = buffer[2 * i + 0];
-      uint32_t state = buffer[2 * i + 1];
-
-      if (frame != netplay->read_frame_count)
-         continue;
-
-      netplay->buffer[netplay->read_ptr].is_simulated = false;
-      netplay->buffer[netplay->read_ptr].real_input_state = state;
-      netplay->read_ptr = NEXT_PTR(netplay->read_ptr);
-      netplay->read_frame_count++;
+      netplay->stall_time  = now;
       netplay->timeout_cnt = 0;
+      netplay->stats.stalls++;
+      return;
    }
-}
 
-/* TODO: Somewhat better prediction. :P */
-static void simulate_input(netplay_t *netplay)
-{
-   size_t ptr  = PREV_PTR(netplay->self_ptr);
-   size_t prev = PREV_PTR(netplay->read_ptr);
+   if (now - netplay->stall_time 
+         < (retro_time_t)(netplay->timeout_cnt + 1) * RETRY_MS * 1000)
+      return;
 
-   netplay->buffer[ptr].simulated_input_state = 
-      netplay->buffer[prev].real_input_state;
-   netplay->buffer[ptr].is_simulated = true;
-   netplay->buffer[ptr].used_real = false;
+   netplay->timeout_cnt++;
+
+   if (netplay->timeout_cnt >= MAX_RETRIES || !send_chunk(netplay))
+   {
+      warn_hangup();
+      netplay->has_connection = false;
+      return;
+   }
+
+   RARCH_LOG("Network is stalling, resending packet... Count %u of %d ...\n",
+         netplay->timeout_cnt, MAX_RETRIES);
 }
 
 /**
  * netplay_poll:
  * @netplay              : pointer to netplay object
  *
- * Polls network to see if we have anything new. If our 
- * network buffer is full, we simply have to block 
- * for new input data.
+ * Polls network to see if we have anything new. 
+ * netplay_pre_frame() made sure we are not at the 
+ * rollback limit, so this never has to wait for input.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
 static bool netplay_poll(netplay_t *netplay)
 {
-   int res;
-
    if (!netplay->has_connection)
       return false;
 
@@ -416,57 +1663,18 @@ static bool netplay_poll(netplay_t *netplay)
    if (!get_self_input_state(netplay))
       return false;
 
-   /* We skip reading the first frame so the host has a chance to grab 
-    * our host info so we don't block forever :') */
-   if (netplay->frame_count == 0)
-   {
-      netplay->buffer[0].used_real        = true;
-      netplay->buffer[0].is_simulated     = false;
-      netplay->buffer[0].real_input_state = 0;
-      netplay->read_ptr                   = NEXT_PTR(netplay->read_ptr);
-      netplay->read_frame_count++;
-      return true;
-   }
-
-   /* We might have reached the end of the buffer, where we 
-    * simply have to block. */
-   res = poll_input(netplay, netplay->other_ptr == netplay->self_ptr);
-   if (res == -1)
+   if (!netplay_receive_input(netplay))
    {
       netplay->has_connection = false;
       warn_hangup();
       return false;
    }
 
-   if (res == 1)
-   {
-      uint32_t first_read = netplay->read_frame_count;
-      do 
-      {
-         uint32_t buffer[UDP_FRAME_PACKETS * 2];
-         if (!receive_data(netplay, buffer, sizeof(buffer)))
-         {
-            warn_hangup();
-            netplay->has_connection = false;
-            return false;
-         }
-         parse_packet(netplay, buffer, UDP_FRAME_PACKETS);
-
-      } while ((netplay->read_frame_count <= netplay->frame_count) && 
-            poll_input(netplay, (netplay->other_ptr == netplay->self_ptr) && 
-               (first_read == netplay->read_frame_count)) == 1);
-   }
-   else
-   {
-      /* Cannot allow this. Should not happen though. */
-      if (netplay->self_ptr == netplay->other_ptr)
-      {
-         warn_hangup();
-         return false;
-      }
-   }
+   /* As host, pass on what we just got to the other clients. */
+   if (netplay_relay_input(netplay) && !send_chunk(netplay))
+      return false;
 
-   if (netplay->read_ptr != netplay->self_ptr)
+   if (netplay->read_frame_count <= netplay->frame_count)
       simulate_input(netplay);
    else
       netplay->buffer[PREV_PTR(netplay->self_ptr)].used_real = true;
@@ -523,8 +1731,9 @@ static bool netplay_is_alive(netplay_t *netplay)
    return netplay->has_connection;
 }
 
-static bool netplay_flip_port(netplay_t *netplay, bool port)
+static unsigned netplay_flip_port(netplay_t *netplay, unsigned port)
 {
+   unsigned flip;
    size_t frame = netplay->frame_count;
 
    if (netplay->flip_frame == 0)
@@ -533,34 +1742,77 @@ static bool netplay_flip_port(netplay_t *netplay, bool port)
    if (netplay->is_replay)
       frame = netplay->tmp_frame_count;
 
-   return port ^ netplay->flip ^ (frame < netplay->flip_frame);
+   flip = netplay->flip;
+   if (frame < netplay->flip_frame)
+      flip += netplay->users - 1;
+
+   return (port + flip) % netplay->users;
 }
 
-static int16_t netplay_input_state(netplay_t *netplay, bool port, unsigned device,
-      unsigned idx, unsigned id)
+static int16_t netplay_input_state(netplay_t *netplay, unsigned port,
+      unsigned device, unsigned idx, unsigned id)
 {
    size_t ptr = netplay->is_replay ? 
       netplay->tmp_ptr : PREV_PTR(netplay->self_ptr);
-   uint16_t curr_input_state = netplay->buffer[ptr].self_state;
+   const struct delta_frame *frame = &netplay->buffer[ptr];
+   uint16_t curr_input_state = frame->self_state;
+
+   /* Ports nobody controls have to look the same for everyone. */
+   if (port >= netplay->users)
+      return 0;
 
-   if (netplay->port == (netplay_flip_port(netplay, port) ? 1 : 0))
+   port = netplay_flip_port(netplay, port);
+
+   if (port != netplay->self_port)
    {
-      if (netplay->buffer[ptr].is_simulated)
-         curr_input_state = netplay->buffer[ptr].simulated_input_state;
+      if (frame->is_simulated)
+         curr_input_state = frame->simulated_input_state[port];
       else
-         curr_input_state = netplay->buffer[ptr].real_input_state;
+         curr_input_state = frame->real_input_state[port];
    }
 
    return ((1 << id) & curr_input_state) ? 1 : 0;
 }
 
+/**
+ * netplay_record_input:
+ * @netplay              : pointer to netplay object
+ * @input                : input returned to the core.
+ *
+ * Appends @input to the recording of the frame being run.
+ **/
+static void netplay_record_input(netplay_t *netplay, int16_t input)
+{
+   struct delta_frame *frame = &netplay->buffer[netplay->is_replay ? 
+      netplay->tmp_ptr : PREV_PTR(netplay->self_ptr)];
+
+   if (frame->record_ptr >= frame->record_size)
+   {
+      size_t size = frame->record_size ? 2 * frame->record_size : 64;
+      int16_t *record = (int16_t*)realloc(frame->record,
+            size * sizeof(int16_t));
+      if (!record)
+         return;
+
+      frame->record      = record;
+      frame->record_size = size;
+   }
+
+   frame->record[frame->record_ptr++] = input;
+}
+
 int16_t input_state_net(unsigned port, unsigned device,
       unsigned idx, unsigned id)
 {
    driver_t *driver = driver_get_ptr();
    netplay_t *netplay = (netplay_t*)driver->netplay_data;
    if (netplay_is_alive(netplay))
-      return netplay_input_state(netplay, port, device, idx, id);
+   {
+      int16_t ret = netplay_input_state(netplay, port, device, idx, id);
+      if (*netplay->record_path)
+         netplay_record_input(netplay, ret);
+      return ret;
+   }
    return netplay->cbs.state_cb(port, device, idx, id);
 }
 
@@ -620,8 +1872,7 @@ static void log_connection(const struct sockaddr_storage *their_addr,
 #endif
 
 static int init_tcp_connection(const struct addrinfo *res,
-      bool server, bool spectate,
-      struct sockaddr *other_addr, socklen_t addr_size)
+      bool server, bool spectate)
 {
    bool ret = true;
    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
@@ -646,24 +1897,11 @@ static int init_tcp_connection(const struct addrinfo *res,
       setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(int));
 
       if (bind(fd, res->ai_addr, res->ai_addrlen) < 0 ||
-            listen(fd, spectate ? MAX_SPECTATORS : 1) < 0)
+            listen(fd, spectate ? MAX_SPECTATORS : NETPLAY_MAX_USERS - 1) < 0)
       {
          ret = false;
          goto end;
       }
-
-      if (!spectate)
-      {
-         int new_fd = accept(fd, other_addr, &addr_size);
-         if (new_fd < 0)
-         {
-            ret = false;
-            goto end;
-         }
-
-         socket_close(fd);
-         fd = new_fd;
-      }
    }
 
 end:
@@ -679,84 +1917,371 @@ end:
 static bool init_tcp_socket(netplay_t *netplay, const char *server,
       uint16_t port, bool spectate)
 {
-   char port_buf[16];
-   bool ret = false;
+   char port_buf[16];
+   bool ret = false;
+   const struct addrinfo *tmp_info = NULL;
+   struct addrinfo hints, *res = NULL;
+
+   memset(&hints, 0, sizeof(hints));
+
+#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
+   hints.ai_family = AF_INET;
+#else
+   hints.ai_family = AF_UNSPEC;
+#endif
+
+   hints.ai_socktype = SOCK_STREAM;
+   if (!server)
+      hints.ai_flags = AI_PASSIVE;
+
+   snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
+   if (net_resolve_addrinfo(server, port_buf, &hints, &res,
+            NETPLAY_RESOLVE_TIMEOUT_MS) < 0)
+      return false;
+
+   if (!res)
+      return false;
+
+   /* If "localhost" is used, it is important to check every possible 
+    * address for IPv4/IPv6. */
+   tmp_info = res;
+
+   while (tmp_info)
+   {
+      int fd;
+      if ((fd = init_tcp_connection(tmp_info, server, netplay->spectate)) >= 0)
+      {
+         ret = true;
+         netplay->fd = fd;
+         break;
+      }
+
+      tmp_info = tmp_info->ai_next;
+   }
+
+   if (res)
+      net_resolve_freeaddrinfo(res);
+
+   if (!ret)
+      RARCH_ERR("Failed to set up netplay sockets.\n");
+
+   return ret;
+}
+
+static bool init_udp_socket(netplay_t *netplay, const char *server,
+      uint16_t port)
+{
+   char port_buf[16];
+   struct addrinfo hints;
+
+   memset(&hints, 0, sizeof(hints));
+#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
+   hints.ai_family = AF_INET;
+#else
+   hints.ai_family = AF_UNSPEC;
+#endif
+   hints.ai_socktype = SOCK_DGRAM;
+   if (!server)
+      hints.ai_flags = AI_PASSIVE;
+
+   snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
+
+   if (net_resolve_addrinfo(server, port_buf, &hints, &netplay->addr,
+            NETPLAY_RESOLVE_TIMEOUT_MS) < 0)
+      return false;
+
+   if (!netplay->addr)
+      return false;
+
+   netplay->udp_fd = socket(netplay->addr->ai_family,
+         netplay->addr->ai_socktype, netplay->addr->ai_protocol);
+
+   if (netplay->udp_fd < 0)
+   {
+      RARCH_ERR("Failed to initialize socket.\n");
+      return false;
+   }
+
+   if (!server)
+   {
+      /* Not sure if we have to do this for UDP, but hey :) */
+      int yes = 1;
+
+      setsockopt(netplay->udp_fd, SOL_SOCKET, SO_REUSEADDR,
+            (const char*)&yes, sizeof(int));
+
+      if (bind(netplay->udp_fd, netplay->addr->ai_addr,
+               netplay->addr->ai_addrlen) < 0)
+      {
+         RARCH_ERR("Failed to bind socket.\n");
+         socket_close(netplay->udp_fd);
+         netplay->udp_fd = -1;
+      }
+
+      net_resolve_freeaddrinfo(netplay->addr);
+      netplay->addr = NULL;
+   }
+
+   return true;
+}
+
+/**
+ * rendezvous_resolve:
+ * @netplay              : pointer to netplay object
+ * @socktype             : SOCK_STREAM or SOCK_DGRAM.
+ * @res                  : set to the resolved addresses.
+ *
+ * Resolves the "server[:port]" address of the rendezvous server. 
+ * The netplay port is used if none is given.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool rendezvous_resolve(netplay_t *netplay, int socktype,
+      struct addrinfo **res)
+{
+   char host[256], port_buf[16];
+   struct addrinfo hints;
+   char *delim = NULL;
+
+   strlcpy(host, netplay->rendezvous, sizeof(host));
+   snprintf(port_buf, sizeof(port_buf), "%hu",
+         (unsigned short)netplay->rendezvous_port);
+
+   /* More than one colon is an IPv6 address without port. */
+   delim = strrchr(host, ':');
+   if (delim && delim == strchr(host, ':'))
+   {
+      *delim = '\0';
+      strlcpy(port_buf, delim + 1, sizeof(port_buf));
+   }
+
+   memset(&hints, 0, sizeof(hints));
+#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
+   hints.ai_family = AF_INET;
+#else
+   hints.ai_family = AF_UNSPEC;
+#endif
+   hints.ai_socktype = socktype;
+
+   *res = NULL;
+   if (net_resolve_addrinfo(host, port_buf, &hints, res,
+            NETPLAY_RESOLVE_TIMEOUT_MS) < 0)
+   {
+      RARCH_ERR("Failed to resolve rendezvous server \"%s\".\n",
+            netplay->rendezvous);
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * rendezvous_punch:
+ * @netplay              : pointer to netplay object
+ * @addr                 : public UDP endpoint of the other side.
+ * @addrlen              : size of @addr.
+ * @their_addr           : set to where the punch came from.
+ *
+ * Sends punches to @addr until one of the other side arrives, 
+ * which opens both NATs for the UDP input packets.
+ *
+ * Returns: true (1) if we got through, otherwise false (0).
+ **/
+static bool rendezvous_punch(netplay_t *netplay,
+      const struct sockaddr *addr, socklen_t addrlen,
+      struct sockaddr_storage *their_addr)
+{
+   unsigned i;
+   retro_time_t start = rarch_get_time_usec();
+
+   while (rarch_get_time_usec() - start < 
+         NETPLAY_PUNCH_TIMEOUT_MS * 1000LL)
+   {
+      fd_set fds;
+      uint8_t buf[UDP_PACKET_SIZE];
+      struct timeval tmp_tv = {0};
+      socklen_t their_addrlen = sizeof(*their_addr);
+
+      sendto(netplay->udp_fd, NETPLAY_PUNCH_MAGIC,
+            NETPLAY_PUNCH_MAGIC_SIZE, 0, addr, addrlen);
+
+      FD_ZERO(&fds);
+      FD_SET(netplay->udp_fd, &fds);
+      tmp_tv.tv_usec = NETPLAY_PUNCH_MS * 1000;
+
+      if (socket_select(netplay->udp_fd + 1, &fds, NULL, NULL, &tmp_tv) < 0)
+         return false;
+
+      if (!FD_ISSET(netplay->udp_fd, &fds))
+         continue;
+
+      /* The NAT may have mapped the other side to another port 
+       * than the one the server saw, so trust the source. */
+      if (recvfrom(netplay->udp_fd, (char*)buf, sizeof(buf), 0,
+               (struct sockaddr*)their_addr, &their_addrlen)
+            != (ssize_t)NETPLAY_PUNCH_MAGIC_SIZE
+            || memcmp(buf, NETPLAY_PUNCH_MAGIC, NETPLAY_PUNCH_MAGIC_SIZE))
+         continue;
+
+      for (i = 0; i < NETPLAY_PUNCH_EXTRA; i++)
+         sendto(netplay->udp_fd, NETPLAY_PUNCH_MAGIC,
+               NETPLAY_PUNCH_MAGIC_SIZE, 0,
+               (const struct sockaddr*)their_addr, their_addrlen);
+      return true;
+   }
+
+   RARCH_ERR("Failed to punch through to netplay peer.\n");
+   return false;
+}
+
+/**
+ * rendezvous_connect:
+ * @netplay              : pointer to netplay object
+ * @host                 : true if we host the session.
+ * @session              : name of the session.
+ * @their_addr           : set to the UDP endpoint of the other side.
+ *
+ * Meets the other side of @session at the rendezvous server 
+ * and punches a UDP path to it.
+ *
+ * Returns: TCP connection to the other side, relayed by the 
+ * rendezvous server, or -1 on failure.
+ **/
+static int rendezvous_connect(netplay_t *netplay, bool host,
+      const char *session, struct sockaddr_storage *their_addr)
+{
+   char reg[128], line[128];
+   char ip[INET6_ADDRSTRLEN + 1], port_buf[16];
+   size_t line_size = 0;
+   retro_time_t last_reg = 0;
+   int fd = -1;
    const struct addrinfo *tmp_info = NULL;
-   struct addrinfo hints, *res = NULL;
+   struct addrinfo *res = NULL, *udp_res = NULL, *peer_res = NULL;
+   struct addrinfo hints;
 
-   memset(&hints, 0, sizeof(hints));
+   snprintf(reg, sizeof(reg), "%s %s %s\n", NETPLAY_RENDEZVOUS_MAGIC,
+         host ? "HOST" : "JOIN", session);
 
-#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
-   hints.ai_family = AF_INET;
-#else
-   hints.ai_family = AF_UNSPEC;
-#endif
+   if (!rendezvous_resolve(netplay, SOCK_STREAM, &res)
+         || !rendezvous_resolve(netplay, SOCK_DGRAM, &udp_res))
+      goto end;
 
-   hints.ai_socktype = SOCK_STREAM;
-   if (!server)
-      hints.ai_flags = AI_PASSIVE;
+   for (tmp_info = res; tmp_info && fd < 0; tmp_info = tmp_info->ai_next)
+      fd = init_tcp_connection(tmp_info, true, false);
 
-   snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
-   if (getaddrinfo_rarch(server, port_buf, &hints, &res) < 0)
-      return false;
+   if (fd < 0)
+   {
+      RARCH_ERR("Failed to connect to rendezvous server.\n");
+      goto end;
+   }
 
-   if (!res)
-      return false;
+   if (!socket_send_all_blocking(fd, reg, strlen(reg)))
+      goto error;
 
-   /* If "localhost" is used, it is important to check every possible 
-    * address for IPv4/IPv6. */
-   tmp_info = res;
+   RARCH_LOG("Netplay: Waiting for %s at rendezvous server...\n",
+         host ? "a client" : "the host");
 
-   while (tmp_info)
+   /* Keep registering our UDP endpoint until the other side shows up. */
+   for (;;)
    {
-      int fd;
-      if ((fd = init_tcp_connection(tmp_info, server, netplay->spectate,
-               (struct sockaddr*)&netplay->other_addr,
-               sizeof(netplay->other_addr))) >= 0)
+      fd_set fds;
+      char c;
+      retro_time_t now      = rarch_get_time_usec();
+      struct timeval tmp_tv = {0};
+
+      if (now - last_reg >= NETPLAY_REGISTER_MS * 1000LL)
       {
-         ret = true;
-         netplay->fd = fd;
-         break;
+         sendto(netplay->udp_fd, reg, strlen(reg), 0,
+               udp_res->ai_addr, udp_res->ai_addrlen);
+         last_reg = now;
       }
 
-      tmp_info = tmp_info->ai_next;
+      FD_ZERO(&fds);
+      FD_SET(fd, &fds);
+      tmp_tv.tv_usec = NETPLAY_REGISTER_MS * 1000;
+
+      if (socket_select(fd + 1, &fds, NULL, NULL, &tmp_tv) < 0)
+         goto error;
+
+      if (!FD_ISSET(fd, &fds))
+         continue;
+
+      if (recv(fd, &c, 1, 0) != 1)
+      {
+         RARCH_ERR("Rendezvous server closed the connection.\n");
+         goto error;
+      }
+
+      if (c == '\n')
+         break;
+
+      if (line_size + 1 >= sizeof(line))
+         goto error;
+      line[line_size++] = c;
    }
+   line[line_size] = '\0';
 
-   if (res)
-      freeaddrinfo_rarch(res);
+   if (sscanf(line, "PEER %46s %15s", ip, port_buf) != 2)
+   {
+      RARCH_ERR("Rendezvous server refused: \"%s\".\n", line);
+      goto error;
+   }
 
-   if (!ret)
-      RARCH_ERR("Failed to set up netplay sockets.\n");
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = udp_res->ai_family;
+   hints.ai_socktype = SOCK_DGRAM;
+   if (getaddrinfo_rarch(ip, port_buf, &hints, &peer_res) < 0 || !peer_res)
+      goto error;
 
-   return ret;
+   RARCH_LOG("Netplay: Punching through to %s:%s...\n", ip, port_buf);
+
+   if (!rendezvous_punch(netplay, peer_res->ai_addr,
+            peer_res->ai_addrlen, their_addr))
+      goto error;
+
+   goto end;
+
+error:
+   socket_close(fd);
+   fd = -1;
+
+end:
+   if (res)
+      net_resolve_freeaddrinfo(res);
+   if (udp_res)
+      net_resolve_freeaddrinfo(udp_res);
+   if (peer_res)
+      freeaddrinfo_rarch(peer_res);
+   return fd;
 }
 
-static bool init_udp_socket(netplay_t *netplay, const char *server,
+/**
+ * init_rendezvous_socket:
+ * @netplay              : pointer to netplay object
+ * @server               : session to join, or NULL if hosting.
+ * @port                 : port to bind the UDP socket to if hosting.
+ *
+ * Sets up the UDP socket for a rendezvous session. A client 
+ * also meets the host here, clients of the host are met 
+ * one by one in netplay_new().
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool init_rendezvous_socket(netplay_t *netplay, const char *server,
       uint16_t port)
 {
-   char port_buf[16];
-   struct addrinfo hints;
+   struct addrinfo *res = NULL;
 
-   memset(&hints, 0, sizeof(hints));
-#if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
-   hints.ai_family = AF_INET;
-#else
-   hints.ai_family = AF_UNSPEC;
-#endif
-   hints.ai_socktype = SOCK_DGRAM;
    if (!server)
-      hints.ai_flags = AI_PASSIVE;
-
-   snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
-
-   if (getaddrinfo_rarch(server, port_buf, &hints, &netplay->addr) < 0)
-      return false;
+      return init_udp_socket(netplay, NULL, port) && netplay->udp_fd >= 0;
 
-   if (!netplay->addr)
+   /* Any local port does, the server tells the host which one we got. */
+   if (!rendezvous_resolve(netplay, SOCK_DGRAM, &res))
       return false;
 
-   netplay->udp_fd = socket(netplay->addr->ai_family,
-         netplay->addr->ai_socktype, netplay->addr->ai_protocol);
+   netplay->udp_fd = socket(res->ai_family, res->ai_socktype,
+         res->ai_protocol);
+   net_resolve_freeaddrinfo(res);
 
    if (netplay->udp_fd < 0)
    {
@@ -764,26 +2289,12 @@ static bool init_udp_socket(netplay_t *netplay, const char *server,
       return false;
    }
 
-   if (!server)
-   {
-      /* Not sure if we have to do this for UDP, but hey :) */
-      int yes = 1;
-
-      setsockopt(netplay->udp_fd, SOL_SOCKET, SO_REUSEADDR,
-            (const char*)&yes, sizeof(int));
-
-      if (bind(netplay->udp_fd, netplay->addr->ai_addr,
-               netplay->addr->ai_addrlen) < 0)
-      {
-         RARCH_ERR("Failed to bind socket.\n");
-         socket_close(netplay->udp_fd);
-         netplay->udp_fd = -1;
-      }
-
-      freeaddrinfo_rarch(netplay->addr);
-      netplay->addr = NULL;
-   }
+   netplay->fd = rendezvous_connect(netplay, false, server,
+         &netplay->peers[0].addr);
+   if (netplay->fd < 0)
+      return false;
 
+   netplay->peers[0].has_addr = true;
    return true;
 }
 
@@ -792,6 +2303,9 @@ static bool init_socket(netplay_t *netplay, const char *server, uint16_t port)
    if (!network_init())
       return false;
 
+   if (*netplay->rendezvous)
+      return init_rendezvous_socket(netplay, server, port);
+
    if (!init_tcp_socket(netplay, server, port, netplay->spectate))
       return false;
    if (!netplay->spectate && !init_udp_socket(netplay, server, port))
@@ -837,9 +2351,85 @@ static uint32_t implementation_magic_value(void)
    for (i = 0; i < len; i++)
       res ^= ver[i] << ((i & 0xf) + 16);
 
+   res ^= (uint32_t)NETPLAY_PROTOCOL_VERSION << 24;
+
    return res;
 }
 
+/**
+ * spectate_queue_push:
+ * @queue                : queue of a spectator.
+ * @data                 : data to append.
+ * @size                 : size of @data.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool spectate_queue_push(struct netplay_spectate_queue *queue,
+      const void *data, size_t size)
+{
+   uint8_t *tmp = (uint8_t*)realloc(queue->data, queue->size + size);
+
+   if (!tmp)
+      return false;
+
+   memcpy(tmp + queue->size, data, size);
+   queue->data  = tmp;
+   queue->size += size;
+   return true;
+}
+
+/**
+ * spectate_queue_send:
+ * @fd                   : socket of a spectator.
+ * @queue                : queue of the spectator.
+ *
+ * Sends up to NETPLAY_CHUNK_SIZE bytes of the queue if the 
+ * spectator can take them right away, so a spectator catching up 
+ * does not stall our own frames.
+ *
+ * Returns: false (0) if the spectator disconnected, otherwise true (1).
+ **/
+static bool spectate_queue_send(int fd, struct netplay_spectate_queue *queue)
+{
+   fd_set fds;
+   size_t size;
+   struct timeval tmp_tv = {0};
+
+   FD_ZERO(&fds);
+   FD_SET(fd, &fds);
+
+   if (socket_select(fd + 1, NULL, &fds, NULL, &tmp_tv) < 0)
+      return false;
+
+   if (!FD_ISSET(fd, &fds))
+      return true;
+
+   size = queue->size - queue->pos;
+   if (size > NETPLAY_CHUNK_SIZE)
+      size = NETPLAY_CHUNK_SIZE;
+
+   if (!socket_send_all_blocking(fd, queue->data + queue->pos, size))
+      return false;
+
+   queue->pos += size;
+
+   if (queue->pos == queue->size)
+   {
+      free(queue->data);
+      memset(queue, 0, sizeof(*queue));
+   }
+   else if (queue->pos >= queue->size / 2)
+   {
+      /* Do not keep what was sent around forever. */
+      memmove(queue->data, queue->data + queue->pos,
+            queue->size - queue->pos);
+      queue->size -= queue->pos;
+      queue->pos   = 0;
+   }
+
+   return true;
+}
+
 static bool send_nickname(netplay_t *netplay, int fd)
 {
    uint8_t nick_size = strlen(netplay->nick);
@@ -881,13 +2471,16 @@ static bool get_nickname(netplay_t *netplay, int fd)
       return false;
    }
 
+   netplay->other_nick[nick_size] = '\0';
+
    return true;
 }
 
-static bool send_info(netplay_t *netplay)
+static bool send_info(netplay_t *netplay, struct netplay_peer *peer)
 {
    unsigned sram_size;
    char msg[512];
+   uint32_t session[3];
    void *sram = NULL;
    uint32_t header[3];
    global_t *global = global_get_ptr();
@@ -896,10 +2489,10 @@ static bool send_info(netplay_t *netplay)
    header[1] = htonl(implementation_magic_value());
    header[2] = htonl(pretro_get_memory_size(RETRO_MEMORY_SAVE_RAM));
 
-   if (!socket_send_all_blocking(netplay->fd, header, sizeof(header)))
+   if (!socket_send_all_blocking(peer->fd, header, sizeof(header)))
       return false;
 
-   if (!send_nickname(netplay, netplay->fd))
+   if (!send_nickname(netplay, peer->fd))
    {
       RARCH_ERR("Failed to send nick to host.\n");
       return false;
@@ -909,33 +2502,63 @@ static bool send_info(netplay_t *netplay)
    sram      = pretro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
    sram_size = pretro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
 
-   if (!socket_receive_all_blocking(netplay->fd, sram, sram_size))
+   if (!receive_blob(peer->fd, sram, sram_size))
    {
       RARCH_ERR("Failed to receive SRAM data from host.\n");
       return false;
    }
 
-   if (!get_nickname(netplay, netplay->fd))
+   if (!get_nickname(netplay, peer->fd))
    {
       RARCH_ERR("Failed to receive nick from host.\n");
       return false;
    }
 
+   strlcpy(peer->nick, netplay->other_nick, sizeof(peer->nick));
+
    snprintf(msg, sizeof(msg), "Connected to: \"%s\"", netplay->other_nick);
    RARCH_LOG("%s\n", msg);
    rarch_main_msg_queue_push(msg, 1, 180, false);
 
+   /* The host sends the session once every user has connected. */
+   if (!socket_receive_all_blocking(peer->fd, session, sizeof(session)))
+   {
+      RARCH_ERR("Failed to receive session info from host.\n");
+      return false;
+   }
+
+   /* Every user has to send their input equally far ahead, 
+    * so we use the input delay of the host. */
+   if (ntohl(session[0]) != netplay->input_delay)
+      RARCH_LOG("Using input delay of host: %u frames.\n",
+            (unsigned)ntohl(session[0]));
+   netplay->input_delay = ntohl(session[0]);
+   netplay->users       = ntohl(session[1]);
+   netplay->self_port   = ntohl(session[2]);
+
+   if (netplay->users < 2 || netplay->users > NETPLAY_MAX_USERS
+         || netplay->self_port == 0 || netplay->self_port >= netplay->users)
+   {
+      RARCH_ERR("Received invalid session info from host.\n");
+      return false;
+   }
+
+   snprintf(msg, sizeof(msg), "Playing as user %u of %u.",
+         netplay->self_port + 1, netplay->users);
+   RARCH_LOG("%s\n", msg);
+   rarch_main_msg_queue_push(msg, 1, 180, false);
+
    return true;
 }
 
-static bool get_info(netplay_t *netplay)
+static bool get_info(netplay_t *netplay, struct netplay_peer *peer)
 {
    unsigned sram_size;
    uint32_t header[3];
    const void *sram = NULL;
    global_t *global = global_get_ptr();
 
-   if (!socket_receive_all_blocking(netplay->fd, header, sizeof(header)))
+   if (!socket_receive_all_blocking(peer->fd, header, sizeof(header)))
    {
       RARCH_ERR("Failed to receive header from client.\n");
       return false;
@@ -959,31 +2582,56 @@ static bool get_info(netplay_t *netplay)
       return false;
    }
 
-   if (!get_nickname(netplay, netplay->fd))
+   if (!get_nickname(netplay, peer->fd))
    {
       RARCH_ERR("Failed to get nickname from client.\n");
       return false;
    }
 
-   /* Send SRAM data to our User 2. */
+   /* Send SRAM data to the client. */
    sram      = pretro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
    sram_size = pretro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
 
-   if (!socket_send_all_blocking(netplay->fd, sram, sram_size))
+   if (!send_blob(peer->fd, sram, sram_size))
    {
       RARCH_ERR("Failed to send SRAM data to client.\n");
       return false;
    }
 
-   if (!send_nickname(netplay, netplay->fd))
+   if (!send_nickname(netplay, peer->fd))
    {
       RARCH_ERR("Failed to send nickname to client.\n");
       return false;
    }
 
-#ifndef HAVE_SOCKET_LEGACY
-   log_connection(&netplay->other_addr, 0, netplay->other_nick);
-#endif
+   strlcpy(peer->nick, netplay->other_nick, sizeof(peer->nick));
+
+   return true;
+}
+
+/**
+ * send_session:
+ * @netplay              : pointer to netplay object
+ * @peer                 : client to send the session to
+ *
+ * Tells a client which port it controls once every user 
+ * has connected, which also lets it start running.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool send_session(netplay_t *netplay, struct netplay_peer *peer)
+{
+   uint32_t session[3];
+
+   session[0] = htonl(netplay->input_delay);
+   session[1] = htonl(netplay->users);
+   session[2] = htonl(peer->port);
+
+   if (!socket_send_all_blocking(peer->fd, session, sizeof(session)))
+   {
+      RARCH_ERR("Failed to send session info to client.\n");
+      return false;
+   }
 
    return true;
 }
@@ -1093,23 +2741,29 @@ static bool get_info_spectate(netplay_t *netplay)
       return false;
    }
 
-   buf = malloc(save_state_size);
+   buf = content_state_buffer_get(save_state_size);
    if (!buf)
       return false;
 
    size = save_state_size;
 
-   if (!socket_receive_all_blocking(netplay->fd, buf, size))
+   if (!receive_blob(netplay->fd, buf, size))
    {
       RARCH_ERR("Failed to receive save state from host.\n");
-      free(buf);
       return false;
    }
 
+   if (!socket_receive_all_blocking(netplay->fd, &netplay->spectate_catchup,
+            sizeof(netplay->spectate_catchup)))
+   {
+      RARCH_ERR("Failed to receive catch-up frames from host.\n");
+      return false;
+   }
+   netplay->spectate_catchup = ntohl(netplay->spectate_catchup);
+
    if (save_state_size)
       ret = pretro_unserialize(buf, save_state_size);
 
-   free(buf);
    return ret;
 }
 
@@ -1138,33 +2792,120 @@ static bool init_buffers(netplay_t *netplay)
       netplay->buffer[i].is_simulated = true;
    }
 
+   /* Input for the frames before our first delayed input arrives 
+    * is known to be zero, so we do not have to wait for it. */
+   netplay->read_frame_count = netplay->input_delay ? netplay->input_delay : 1;
+
+   for (i = 0; i < netplay->read_frame_count; i++)
+   {
+      netplay->buffer[i].is_simulated = false;
+      memset(netplay->buffer[i].real_input_state, 0,
+            sizeof(netplay->buffer[i].real_input_state));
+   }
+
+   netplay->read_ptr = netplay->read_frame_count % netplay->buffer_size;
+
+   if (netplay->self_port != 0)
+   {
+      netplay->resync_state = malloc(netplay->state_size);
+      if (!netplay->resync_state)
+         return false;
+   }
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      netplay->peers[i].read_frame_count = netplay->read_frame_count;
+      netplay->peers[i].send_frame_count = netplay->read_frame_count;
+      netplay->peers[i].ack_frame_count  = netplay->read_frame_count;
+   }
+
    return true;
 }
 
+#ifdef HAVE_THREADS
+static void deinit_net_thread(netplay_t *netplay)
+{
+   if (netplay->net_thread)
+   {
+      slock_lock(netplay->net_lock);
+      netplay->net_quit = true;
+      slock_unlock(netplay->net_lock);
+
+      sthread_join(netplay->net_thread);
+   }
+
+   if (netplay->net_lock)
+      slock_free(netplay->net_lock);
+   free(netplay->net_queue);
+
+   netplay->net_thread = NULL;
+   netplay->net_lock   = NULL;
+   netplay->net_queue  = NULL;
+}
+
+/**
+ * init_net_thread:
+ * @netplay              : pointer to netplay object
+ *
+ * Starts receiving input packets on their own thread. 
+ * If that fails, we read the socket ourselves.
+ **/
+static void init_net_thread(netplay_t *netplay)
+{
+   netplay->net_queue = (struct netplay_packet*)calloc(
+         NETPLAY_NET_QUEUE_SIZE, sizeof(*netplay->net_queue));
+   netplay->net_lock  = slock_new();
+
+   if (netplay->net_queue && netplay->net_lock)
+      netplay->net_thread = sthread_create(netplay_net_thread, netplay);
+
+   if (!netplay->net_thread)
+   {
+      RARCH_WARN("Failed to start netplay thread, polling instead.\n");
+      deinit_net_thread(netplay);
+   }
+}
+#endif
+
 /**
  * netplay_new:
  * @server               : IP address of server.
  * @port                 : Port of server.
  * @frames               : Amount of lag frames.
+ * @delay                : Amount of local input delay frames.
+ * @users                : Amount of users when hosting, including the host.
+ * @check_frames         : Interval in frames the host sends savestate 
+ *                         CRCs to detect desyncs, or 0 to disable.
  * @cb                   : Libretro callbacks.
  * @spectate             : If true, enable spectator mode.
  * @nick                 : Nickname of user.
+ * @rendezvous           : Rendezvous server "server[:port]" to meet 
+ *                         peers at, or NULL to connect directly.
  *
  * Creates a new netplay handle. A NULL host means we're 
- * hosting (user 1).
+ * hosting (user 1), in which case we wait for @users - 1 
+ * clients to connect and relay input between them.
+ *
+ * With @rendezvous, the host registers the session under @nick 
+ * and clients join the session named @server.
  *
  * Returns: new netplay handle.
  **/
 netplay_t *netplay_new(const char *server, uint16_t port,
-      unsigned frames, const struct retro_callbacks *cb,
+      unsigned frames, unsigned delay, unsigned users,
+      unsigned check_frames, const struct retro_callbacks *cb,
       bool spectate,
-      const char *nick)
+      const char *nick, const char *rendezvous)
 {
    unsigned i;
    netplay_t *netplay = NULL;
 
-   if (frames > UDP_FRAME_PACKETS)
-      frames = UDP_FRAME_PACKETS;
+   if (delay > UDP_FRAME_PACKETS / 2)
+      delay = UDP_FRAME_PACKETS / 2;
+   if (users < 2)
+      users = 2;
+   if (users > NETPLAY_MAX_USERS)
+      users = NETPLAY_MAX_USERS;
 
    netplay = (netplay_t*)calloc(1, sizeof(*netplay));
    if (!netplay)
@@ -1173,17 +2914,31 @@ netplay_t *netplay_new(const char *server, uint16_t port,
    netplay->fd              = -1;
    netplay->udp_fd          = -1;
    netplay->cbs             = *cb;
-   netplay->port            = server ? 0 : 1;
+   netplay->users           = users;
    netplay->spectate        = spectate;
    netplay->spectate_client = server != NULL;
+   netplay->max_rollback    = frames;
+   netplay->input_delay     = delay;
+   netplay->check_frames    = check_frames;
+   netplay->check_frame_count = check_frames;
    strlcpy(netplay->nick, nick, sizeof(netplay->nick));
 
-   if (!init_socket(netplay, server, port))
+   if (rendezvous && *rendezvous)
    {
-      free(netplay);
-      return NULL;
+      if (spectate)
+      {
+         RARCH_ERR("Netplay spectating does not support rendezvous servers.\n");
+         free(netplay);
+         return NULL;
+      }
+
+      strlcpy(netplay->rendezvous, rendezvous, sizeof(netplay->rendezvous));
+      netplay->rendezvous_port = port;
    }
 
+   if (!init_socket(netplay, server, port))
+      goto error;
+
    if (spectate)
    {
       if (server)
@@ -1199,20 +2954,78 @@ netplay_t *netplay_new(const char *server, uint16_t port,
    {
       if (server)
       {
-         if (!send_info(netplay))
+         netplay->num_peers   = 1;
+         netplay->peers[0].fd = netplay->fd;
+         netplay->fd          = -1;
+
+         if (!send_info(netplay, &netplay->peers[0]))
             goto error;
       }
       else
       {
-         if (!get_info(netplay))
-            goto error;
+         if (users > 2)
+            RARCH_LOG("Waiting for %u clients...\n", users - 1);
+
+         for (i = 0; i + 1 < users; i++)
+         {
+            struct netplay_peer *peer = &netplay->peers[i];
+            struct sockaddr_storage their_addr;
+            socklen_t addr_size = sizeof(their_addr);
+
+            if (*netplay->rendezvous)
+            {
+               peer->fd = rendezvous_connect(netplay, true,
+                     *netplay->nick ? netplay->nick : "RetroArch",
+                     &their_addr);
+               peer->addr     = their_addr;
+               peer->has_addr = peer->fd >= 0;
+            }
+            else
+               peer->fd = accept(netplay->fd,
+                     (struct sockaddr*)&their_addr, &addr_size);
+            if (peer->fd < 0)
+            {
+               RARCH_ERR("Failed to accept netplay client.\n");
+               goto error;
+            }
+
+            netplay->num_peers++;
+            peer->port = i + 1;
+
+            if (!get_info(netplay, peer))
+               goto error;
+
+#ifndef HAVE_SOCKET_LEGACY
+            log_connection(&their_addr, i, peer->nick);
+#endif
+         }
+
+         if (netplay->fd >= 0)
+            socket_close(netplay->fd);
+         netplay->fd = -1;
+
+         for (i = 0; i < netplay->num_peers; i++)
+            if (!send_session(netplay, &netplay->peers[i]))
+               goto error;
       }
 
-      netplay->buffer_size = frames + 1;
+      /* Every frame we can roll back or delay has to fit 
+       * in the redundant packet history. */
+      if (netplay->input_delay > UDP_FRAME_PACKETS / 2)
+         netplay->input_delay = UDP_FRAME_PACKETS / 2;
+      if (netplay->max_rollback + netplay->input_delay > UDP_FRAME_PACKETS)
+         netplay->max_rollback = UDP_FRAME_PACKETS - netplay->input_delay;
+
+      netplay->buffer_size = netplay->max_rollback 
+         + netplay->input_delay + 2;
 
       if (!init_buffers(netplay))
          goto error;
 
+#ifdef HAVE_THREADS
+      init_net_thread(netplay);
+#endif
+
       netplay->has_connection = true;
    }
 
@@ -1223,34 +3036,23 @@ error:
       socket_close(netplay->fd);
    if (netplay->udp_fd >= 0)
       socket_close(netplay->udp_fd);
+   for (i = 0; i < netplay->num_peers; i++)
+      socket_close(netplay->peers[i].fd);
 
    free(netplay);
    return NULL;
 }
 
-static bool netplay_send_cmd(netplay_t *netplay, uint32_t cmd,
-      const void *data, size_t size)
-{
-   cmd = (cmd << 16) | (size & 0xffff);
-   cmd = htonl(cmd);
-
-   if (!socket_send_all_blocking(netplay->fd, &cmd, sizeof(cmd)))
-      return false;
-
-   if (!socket_send_all_blocking(netplay->fd, data, size))
-      return false;
-
-   return true;
-}
-
 /**
  * netplay_flip_users:
  * @netplay              : pointer to netplay object
  *
  * On regular netplay, flip who controls user 1 and 2.
+ * With more users, every user moves up one port.
  **/
 void netplay_flip_users(netplay_t *netplay)
 {
+   unsigned i;
    uint32_t flip_frame     = netplay->frame_count + 2 * UDP_FRAME_PACKETS;
    uint32_t flip_frame_net = htonl(flip_frame);
    const char *msg         = NULL;
@@ -1261,7 +3063,7 @@ void netplay_flip_users(netplay_t *netplay)
       goto error;
    }
 
-   if (netplay->port == 0)
+   if (netplay->self_port != 0)
    {
       msg = "Cannot flip users if you're not the host.";
       goto error;
@@ -1274,23 +3076,24 @@ void netplay_flip_users(netplay_t *netplay)
       goto error;
    }
 
-   if (netplay_send_cmd(netplay, NETPLAY_CMD_FLIP_PLAYERS,
-            &flip_frame_net, sizeof(flip_frame_net))
-         && netplay_get_response(netplay))
-   {
-      RARCH_LOG("Netplay users are flipped.\n");
-      rarch_main_msg_queue_push("Netplay users are flipped.", 1, 180, false);
-
-      /* Queue up a flip well enough in the future. */
-      netplay->flip ^= true;
-      netplay->flip_frame = flip_frame;
-   }
-   else
+   for (i = 0; i < netplay->num_peers; i++)
    {
-      msg = "Failed to flip users.";
-      goto error;
+      if (!netplay_send_cmd(&netplay->peers[i], NETPLAY_CMD_FLIP_PLAYERS,
+               &flip_frame_net, sizeof(flip_frame_net))
+            || !netplay_get_response(netplay, &netplay->peers[i]))
+      {
+         msg = "Failed to flip users.";
+         goto error;
+      }
    }
 
+   RARCH_LOG("Netplay users are flipped.\n");
+   rarch_main_msg_queue_push("Netplay users are flipped.", 1, 180, false);
+
+   /* Queue up a flip well enough in the future. */
+   netplay->flip = (netplay->flip + 1) % netplay->users;
+   netplay->flip_frame = flip_frame;
+
    return;
 
 error:
@@ -1308,28 +3111,70 @@ void netplay_free(netplay_t *netplay)
 {
    unsigned i;
 
-   socket_close(netplay->fd);
+   if (netplay->fd >= 0)
+      socket_close(netplay->fd);
+
+   if (!netplay->spectate)
+      RARCH_LOG("Netplay: %u frames, %u rollbacks, %u frames re-simulated "
+            "(deepest %u), stalled %u times, desynced %u times, "
+            "sent %.1f bytes of input per frame.\n",
+            netplay->frame_count, netplay->stats.rollbacks,
+            netplay->stats.resimulated_frames, netplay->stats.max_depth,
+            netplay->stats.stalls, netplay->stats.desyncs,
+            netplay->frame_count ?
+            (double)netplay->stats.bytes_sent / netplay->frame_count : 0.0);
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      const struct netplay_peer *peer = &netplay->peers[i];
+      unsigned packets = peer->packets_received + peer->packets_lost;
+
+      RARCH_LOG("Netplay: user %u: RTT %.1f ms, jitter %.1f ms, "
+            "%.1f%% packet loss.\n", peer->port + 1,
+            peer->rtt / 1000.0f, peer->jitter / 1000.0f,
+            packets ? 100.0f * peer->packets_lost / packets : 0.0f);
+   }
 
    if (netplay->spectate)
    {
       for (i = 0; i < MAX_SPECTATORS; i++)
+      {
          if (netplay->spectate_fds[i] >= 0)
             socket_close(netplay->spectate_fds[i]);
+         free(netplay->spectate_queue[i].data);
+      }
 
       free(netplay->spectate_input);
+      free(netplay->spectate_keyframe);
+      free(netplay->spectate_log);
    }
    else
    {
+#ifdef HAVE_THREADS
+      deinit_net_thread(netplay);
+#endif
       socket_close(netplay->udp_fd);
 
+      for (i = 0; i < netplay->num_peers; i++)
+         socket_close(netplay->peers[i].fd);
+
       for (i = 0; i < netplay->buffer_size; i++)
+      {
          free(netplay->buffer[i].state);
+         free(netplay->buffer[i].record);
+      }
+
+      if (netplay->record)
+         RARCH_LOG("Netplay: Recorded %u frames.\n",
+               (unsigned)netplay->record_frame_count);
+      bsv_movie_free(netplay->record);
 
       free(netplay->buffer);
+      free(netplay->resync_state);
    }
 
    if (netplay->addr)
-      freeaddrinfo_rarch(netplay->addr);
+      net_resolve_freeaddrinfo(netplay->addr);
 
    free(netplay);
 }
@@ -1339,14 +3184,56 @@ void netplay_free(netplay_t *netplay)
  * @netplay              : pointer to netplay object
  *
  * Pre-frame for Netplay (normal version).
+ *
+ * Returns: false (0) if we are at the rollback limit and 
+ * the frame has to wait for input of other users.
  **/
-static void netplay_pre_frame_net(netplay_t *netplay)
+static bool netplay_pre_frame_net(netplay_t *netplay)
 {
+   if (netplay->has_connection)
+   {
+      if (!netplay_receive_input(netplay))
+      {
+         warn_hangup();
+         netplay->has_connection = false;
+      }
+      else if (netplay_rollback_full(netplay))
+      {
+         netplay_stall(netplay);
+         return !netplay->has_connection;
+      }
+   }
+
+   netplay->stall_time = 0;
+
    pretro_serialize(netplay->buffer[netplay->self_ptr].state,
          netplay->state_size);
+   netplay->buffer[netplay->self_ptr].record_ptr = 0;
+
+   if (netplay->has_connection)
+   {
+      bool ret;
+
+      if (netplay->self_port == 0)
+         ret = netplay_send_crcs(netplay) && netplay_send_savestates(netplay);
+      else
+      {
+         if (netplay->has_resync_state)
+            netplay_load_resync_state(netplay);
+         ret = netplay->has_connection && netplay_check_crcs(netplay);
+      }
+
+      if (!ret)
+      {
+         warn_hangup();
+         netplay->has_connection = false;
+      }
+   }
+
    netplay->can_poll = true;
 
    input_poll_net();
+   return true;
 }
 
 static void netplay_set_spectate_input(netplay_t *netplay, int16_t input)
@@ -1397,101 +3284,208 @@ int16_t input_state_spectate_client(unsigned port, unsigned device,
 }
 
 /**
- * netplay_pre_frame_spectate:   
+ * spectate_keyframe_new:
  * @netplay              : pointer to netplay object
  *
- * Pre-frame for Netplay (spectate mode version).
+ * Serializes the savestate spectators joining from now on start 
+ * with, followed by the input logged since. Spectators joining 
+ * on the same keyframe share it, so a crowd of viewers joining 
+ * at once costs a single serialization.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
  **/
-static void netplay_pre_frame_spectate(netplay_t *netplay)
+static bool spectate_keyframe_new(netplay_t *netplay)
 {
-   unsigned i;
-   uint32_t *header;
-   int new_fd, idx, bufsize;
-   size_t header_size;
-   struct sockaddr_storage their_addr;
-   socklen_t addr_size;
-   fd_set fds;
-   struct timeval tmp_tv = {0};
-
-   if (netplay->spectate_client)
-      return;
+   size_t header_size, blob_size;
+   uint8_t *blob    = NULL;
+   uint32_t *header = bsv_header_generate(&header_size,
+         implementation_magic_value());
 
-   FD_ZERO(&fds);
-   FD_SET(netplay->fd, &fds);
+   if (!header)
+   {
+      RARCH_ERR("Failed to generate BSV header.\n");
+      return false;
+   }
 
-   if (socket_select(netplay->fd + 1, &fds, NULL, NULL, &tmp_tv) <= 0)
-      return;
+   blob = netplay_blob_new((const uint8_t*)header + BSV_HEADER_SIZE,
+         header_size - BSV_HEADER_SIZE, &blob_size);
 
-   if (!FD_ISSET(netplay->fd, &fds))
-      return;
+   free(netplay->spectate_keyframe);
+   netplay->spectate_keyframe = blob ? 
+      (uint8_t*)malloc(BSV_HEADER_SIZE + blob_size) : NULL;
 
-   addr_size = sizeof(their_addr);
-   new_fd = accept(netplay->fd, (struct sockaddr*)&their_addr, &addr_size);
-   if (new_fd < 0)
+   if (netplay->spectate_keyframe)
    {
-      RARCH_ERR("Failed to accept incoming spectator.\n");
-      return;
-   }
+      memcpy(netplay->spectate_keyframe, header, BSV_HEADER_SIZE);
+      memcpy(netplay->spectate_keyframe + BSV_HEADER_SIZE, blob, blob_size);
+      netplay->spectate_keyframe_size = BSV_HEADER_SIZE + blob_size;
 
-   idx = -1;
-   for (i = 0; i < MAX_SPECTATORS; i++)
-   {
-      if (netplay->spectate_fds[i] == -1)
-      {
-         idx = i;
-         break;
-      }
+      RARCH_LOG("Sending %u byte savestate to spectators as %u bytes.\n",
+            (unsigned)(header_size - BSV_HEADER_SIZE), (unsigned)blob_size);
    }
 
-   /* No vacant client streams :( */
-   if (idx == -1)
+   netplay->spectate_log_ptr    = 0;
+   netplay->spectate_log_frames = 0;
+
+   free(header);
+   free(blob);
+   return netplay->spectate_keyframe != NULL;
+}
+
+/**
+ * spectate_accept:
+ * @netplay              : pointer to netplay object
+ * @idx                  : vacant spectator slot.
+ *
+ * Accepts a spectator and queues the keyframe and input it 
+ * needs to catch up with us.
+ *
+ * Returns: false (0) if no spectator could be accepted, 
+ * otherwise true (1).
+ **/
+static bool spectate_accept(netplay_t *netplay, unsigned idx)
+{
+   uint32_t catchup;
+   struct sockaddr_storage their_addr;
+   struct netplay_spectate_queue *queue = &netplay->spectate_queue[idx];
+   socklen_t addr_size                  = sizeof(their_addr);
+   int new_fd = accept(netplay->fd, (struct sockaddr*)&their_addr, &addr_size);
+
+   if (new_fd < 0)
    {
-      socket_close(new_fd);
-      return;
+      RARCH_ERR("Failed to accept incoming spectator.\n");
+      return false;
    }
 
    if (!get_nickname(netplay, new_fd))
    {
       RARCH_ERR("Failed to get nickname from client.\n");
-      socket_close(new_fd);
-      return;
+      goto error;
    }
 
    if (!send_nickname(netplay, new_fd))
    {
       RARCH_ERR("Failed to send nickname to client.\n");
-      socket_close(new_fd);
-      return;
+      goto error;
    }
 
-   header = bsv_header_generate(&header_size,
-         implementation_magic_value());
-
-   if (!header)
-   {
-      RARCH_ERR("Failed to generate BSV header.\n");
-      socket_close(new_fd);
-      return;
-   }
+   if (!netplay->spectate_keyframe && !spectate_keyframe_new(netplay))
+      goto error;
 
-   bufsize = header_size;
-   setsockopt(new_fd, SOL_SOCKET, SO_SNDBUF, (const char*)&bufsize,
-         sizeof(int));
+   /* The keyframe is streamed to the spectator over the 
+    * next frames, see netplay_post_frame_spectate(). */
+   catchup = htonl(netplay->spectate_log_frames);
 
-   if (!socket_send_all_blocking(new_fd, header, header_size))
+   if (!spectate_queue_push(queue, netplay->spectate_keyframe,
+            netplay->spectate_keyframe_size)
+         || !spectate_queue_push(queue, &catchup, sizeof(catchup))
+         || !spectate_queue_push(queue, netplay->spectate_log,
+            netplay->spectate_log_ptr * sizeof(uint16_t)))
    {
       RARCH_ERR("Failed to send header to client.\n");
-      socket_close(new_fd);
-      free(header);
-      return;
+      goto error;
    }
 
-   free(header);
    netplay->spectate_fds[idx] = new_fd;
 
 #ifndef HAVE_SOCKET_LEGACY
    log_connection(&their_addr, idx, netplay->other_nick);
 #endif
+   return true;
+
+error:
+   free(queue->data);
+   memset(queue, 0, sizeof(*queue));
+   socket_close(new_fd);
+   return true;
+}
+
+static void netplay_skip_video(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+}
+
+static void netplay_skip_audio(int16_t left, int16_t right)
+{
+}
+
+static size_t netplay_skip_audio_batch(const int16_t *data, size_t frames)
+{
+   return frames;
+}
+
+/**
+ * netplay_spectate_catch_up:
+ * @netplay              : pointer to netplay object
+ *
+ * Runs the frames the host ran since the keyframe we joined on, 
+ * without presenting them.
+ **/
+static void netplay_spectate_catch_up(netplay_t *netplay)
+{
+   if (!netplay->spectate_catchup)
+      return;
+
+   RARCH_LOG("Catching up %u frames with host ...\n",
+         (unsigned)netplay->spectate_catchup);
+
+   pretro_set_video_refresh(netplay_skip_video);
+   pretro_set_audio_sample(netplay_skip_audio);
+   pretro_set_audio_sample_batch(netplay_skip_audio_batch);
+
+   for (; netplay->spectate_catchup; netplay->spectate_catchup--)
+      pretro_run();
+
+   pretro_set_video_refresh(netplay->cbs.frame_cb);
+   pretro_set_audio_sample(netplay->cbs.sample_cb);
+   pretro_set_audio_sample_batch(netplay->cbs.sample_batch_cb);
+}
+
+/**
+ * netplay_pre_frame_spectate:   
+ * @netplay              : pointer to netplay object
+ *
+ * Pre-frame for Netplay (spectate mode version).
+ **/
+static void netplay_pre_frame_spectate(netplay_t *netplay)
+{
+   if (netplay->spectate_client)
+   {
+      netplay_spectate_catch_up(netplay);
+      return;
+   }
+
+   for (;;)
+   {
+      unsigned i;
+      fd_set fds;
+      struct timeval tmp_tv = {0};
+
+      FD_ZERO(&fds);
+      FD_SET(netplay->fd, &fds);
+
+      if (socket_select(netplay->fd + 1, &fds, NULL, NULL, &tmp_tv) <= 0)
+         return;
+
+      if (!FD_ISSET(netplay->fd, &fds))
+         return;
+
+      for (i = 0; i < MAX_SPECTATORS; i++)
+         if (netplay->spectate_fds[i] == -1)
+            break;
+
+      /* No vacant client streams :( */
+      if (i == MAX_SPECTATORS)
+      {
+         int new_fd = accept(netplay->fd, NULL, NULL);
+         if (new_fd >= 0)
+            socket_close(new_fd);
+         return;
+      }
+
+      if (!spectate_accept(netplay, i))
+         return;
+   }
 }
 
 /**
@@ -1500,13 +3494,71 @@ static void netplay_pre_frame_spectate(netplay_t *netplay)
  *
  * Pre-frame for Netplay.
  * Call this before running retro_run().
+ *
+ * Returns: false (0) if retro_run() and netplay_post_frame() 
+ * must be skipped this time, because we are waiting for input 
+ * of other users.
  **/
-void netplay_pre_frame(netplay_t *netplay)
+bool netplay_pre_frame(netplay_t *netplay)
 {
+   bool ret = true;
+   RARCH_PERFORMANCE_INIT(netplay_frame_pre);
+   RARCH_PERFORMANCE_START(netplay_frame_pre);
+
    if (netplay->spectate)
       netplay_pre_frame_spectate(netplay);
    else
-      netplay_pre_frame_net(netplay);
+      ret = netplay_pre_frame_net(netplay);
+
+   RARCH_PERFORMANCE_STOP(netplay_frame_pre);
+   return ret;
+}
+
+/* How often the OSD telemetry line is updated, in frames. */
+#define NETPLAY_STATS_FRAMES 60
+
+/**
+ * netplay_update_stats_osd:
+ * @netplay              : pointer to netplay object
+ *
+ * Samples how far we run ahead of the other users, and shows 
+ * the round trip time, jitter and packet loss of the worst 
+ * connection on screen if netplay_show_stats is enabled.
+ **/
+static void netplay_update_stats_osd(netplay_t *netplay)
+{
+   unsigned i;
+   char msg[128];
+   unsigned rtt = 0, jitter = 0;
+   float loss   = 0.0f;
+   int ahead    = (int)(netplay->frame_count - netplay->read_frame_count);
+   settings_t *settings = config_get_ptr();
+
+   netplay_perf_sample(&netplay_frames_ahead, ahead > 0 ? ahead : 0);
+
+   if (!settings->netplay_show_stats || !netplay->has_connection
+         || netplay->frame_count % NETPLAY_STATS_FRAMES)
+      return;
+
+   for (i = 0; i < netplay->num_peers; i++)
+   {
+      const struct netplay_peer *peer = &netplay->peers[i];
+      unsigned packets = peer->packets_received + peer->packets_lost;
+
+      if (peer->rtt > rtt)
+         rtt = peer->rtt;
+      if (peer->jitter > jitter)
+         jitter = peer->jitter;
+      if (packets && 100.0f * peer->packets_lost / packets > loss)
+         loss = 100.0f * peer->packets_lost / packets;
+   }
+
+   snprintf(msg, sizeof(msg),
+         "Netplay: RTT %.1f ms, jitter %.1f ms, %.1f%% loss, "
+         "%d frames ahead, %u stalls",
+         rtt / 1000.0f, jitter / 1000.0f, loss, ahead,
+         netplay->stats.stalls);
+   rarch_main_msg_queue_push(msg, 1, NETPLAY_STATS_FRAMES, true);
 }
 
 /**
@@ -1518,28 +3570,46 @@ void netplay_pre_frame(netplay_t *netplay)
  **/
 static void netplay_post_frame_net(netplay_t *netplay)
 {
+   uint32_t read_frame_count;
+
    netplay->frame_count++;
+   netplay_update_stats_osd(netplay);
+
+   /* With input delay we may have read input for frames 
+    * we have not run yet. */
+   read_frame_count = netplay->read_frame_count;
+   if (read_frame_count > netplay->frame_count)
+      read_frame_count = netplay->frame_count;
 
    /* Nothing to do... */
-   if (netplay->other_frame_count == netplay->read_frame_count)
+   if (netplay->other_frame_count == read_frame_count 
+         && !netplay->force_replay)
       return;
 
    /* Skip ahead if we predicted correctly.
     * Skip until our simulation failed. */
-   while (netplay->other_frame_count < netplay->read_frame_count)
+   while (!netplay->force_replay 
+         && netplay->other_frame_count < read_frame_count)
    {
       const struct delta_frame *ptr = &netplay->buffer[netplay->other_ptr];
 
-      if ((ptr->simulated_input_state != ptr->real_input_state)
-            && !ptr->used_real)
+      if (memcmp(ptr->simulated_input_state, ptr->real_input_state,
+               sizeof(ptr->real_input_state)) && !ptr->used_real)
          break;
       netplay->other_ptr = NEXT_PTR(netplay->other_ptr);
       netplay->other_frame_count++;
    }
 
-   if (netplay->other_frame_count < netplay->read_frame_count)
+   if (netplay->force_replay 
+         || netplay->other_frame_count < read_frame_count)
    {
-      bool first = true;
+      bool first     = true;
+      unsigned depth = netplay->frame_count - netplay->other_frame_count;
+
+      netplay->stats.rollbacks++;
+      netplay->stats.resimulated_frames += depth;
+      if (depth > netplay->stats.max_depth)
+         netplay->stats.max_depth = depth;
 
       /* Replay frames. */
       netplay->is_replay = true;
@@ -1553,6 +3623,7 @@ static void netplay_post_frame_net(netplay_t *netplay)
       {
          pretro_serialize(netplay->buffer[netplay->tmp_ptr].state,
                netplay->state_size);
+         netplay->buffer[netplay->tmp_ptr].record_ptr = 0;
 #if defined(HAVE_THREADS) && !defined(RARCH_CONSOLE)
          lock_autosave();
 #endif
@@ -1565,10 +3636,138 @@ static void netplay_post_frame_net(netplay_t *netplay)
          first = false;
       }
 
-      netplay->other_ptr = netplay->read_ptr;
-      netplay->other_frame_count = netplay->read_frame_count;
+      /* After a resync we may be reliable beyond our input. */
+      if (netplay->other_frame_count < read_frame_count)
+      {
+         netplay->other_ptr = read_frame_count % netplay->buffer_size;
+         netplay->other_frame_count = read_frame_count;
+      }
       netplay->is_replay = false;
+      netplay->force_replay = false;
+   }
+}
+
+/**
+ * netplay_record_keyframe:
+ * @netplay              : pointer to netplay object
+ * @frame                : frame the new movie starts at.
+ *
+ * Ends the current movie of the recording and starts a new one 
+ * from the savestate of @frame. The first movie is written to 
+ * the path given by the user, later ones get the frame appended.
+ **/
+static void netplay_record_keyframe(netplay_t *netplay,
+      const struct delta_frame *frame)
+{
+   char path[PATH_MAX_LENGTH];
+
+   bsv_movie_free(netplay->record);
+   netplay->record          = NULL;
+   netplay->record_keyframe = false;
+
+   strlcpy(path, netplay->record_path, sizeof(path));
+   if (netplay->record_frame_count)
+   {
+      int len;
+      char base[PATH_MAX_LENGTH];
+
+      strlcpy(base, netplay->record_path, sizeof(base));
+      path_remove_extension(base);
+      len = snprintf(path, sizeof(path), "%s-%06u.bsv", base,
+            (unsigned)netplay->record_frame_count);
+
+      /* A truncated name could be another movie. */
+      if (len < 0 || (size_t)len >= sizeof(path))
+         *path = '\0';
+   }
+
+   if (*path)
+      netplay->record = bsv_movie_init_state(path,
+            frame->state, netplay->state_size);
+   if (!netplay->record)
+   {
+      RARCH_ERR("Failed to record netplay to \"%s\".\n", path);
+      *netplay->record_path = '\0';
+      return;
+   }
+
+   RARCH_LOG("Netplay: Recording from frame %u to \"%s\".\n",
+         (unsigned)netplay->record_frame_count, path);
+}
+
+/**
+ * netplay_record_frames:
+ * @netplay              : pointer to netplay object
+ *
+ * Writes the frames every user agreed on since the last call 
+ * to the recording. Replaying it runs the core with exactly 
+ * the input it got during the session, ports merged.
+ **/
+static void netplay_record_frames(netplay_t *netplay)
+{
+   while (*netplay->record_path 
+         && netplay->record_frame_count < netplay->other_frame_count)
+   {
+      size_t i;
+      const struct delta_frame *frame = &netplay->buffer[
+         netplay->record_frame_count % netplay->buffer_size];
+
+      if (!netplay->record || netplay->record_keyframe ||
+            netplay->record_frame_count % NETPLAY_RECORD_KEYFRAME_FRAMES == 0)
+      {
+         netplay_record_keyframe(netplay, frame);
+         if (!netplay->record)
+            return;
+      }
+
+      for (i = 0; i < frame->record_ptr; i++)
+         bsv_movie_set_input(netplay->record, frame->record[i]);
+
+      netplay->record_frame_count++;
+   }
+}
+
+/**
+ * spectate_log_input:
+ * @netplay              : pointer to netplay object
+ *
+ * Appends the input of this frame to the input following the 
+ * keyframe. Once the keyframe is too old for spectators to catch 
+ * up from in reasonable time, it is dropped, and the next 
+ * spectator gets a new one.
+ **/
+static void spectate_log_input(netplay_t *netplay)
+{
+   size_t size = netplay->spectate_log_ptr + netplay->spectate_input_ptr;
+
+   if (!netplay->spectate_keyframe)
+      return;
+
+   if (netplay->spectate_log_frames >= NETPLAY_SPECTATE_LOG_FRAMES)
+      goto drop;
+
+   if (size > netplay->spectate_log_size)
+   {
+      uint16_t *log = (uint16_t*)realloc(netplay->spectate_log,
+            2 * size * sizeof(uint16_t));
+      if (!log)
+         goto drop;
+
+      netplay->spectate_log      = log;
+      netplay->spectate_log_size = 2 * size;
    }
+
+   memcpy(netplay->spectate_log + netplay->spectate_log_ptr,
+         netplay->spectate_input,
+         netplay->spectate_input_ptr * sizeof(uint16_t));
+   netplay->spectate_log_ptr = size;
+   netplay->spectate_log_frames++;
+   return;
+
+drop:
+   free(netplay->spectate_keyframe);
+   netplay->spectate_keyframe      = NULL;
+   netplay->spectate_keyframe_size = 0;
 }
 
 /**
@@ -1588,13 +3787,17 @@ static void netplay_post_frame_spectate(netplay_t *netplay)
    for (i = 0; i < MAX_SPECTATORS; i++)
    {
       char msg[PATH_MAX_LENGTH];
+      struct netplay_spectate_queue *queue = &netplay->spectate_queue[i];
 
       if (netplay->spectate_fds[i] == -1)
          continue;
 
-      if (socket_send_all_blocking(netplay->spectate_fds[i],
-               netplay->spectate_input,
-               netplay->spectate_input_ptr * sizeof(int16_t)))
+      /* Input waits behind the keyframe, and behind whatever 
+       * a slow spectator has not taken yet. */
+      if (spectate_queue_push(queue, netplay->spectate_input,
+               netplay->spectate_input_ptr * sizeof(int16_t))
+            && spectate_queue_send(netplay->spectate_fds[i], queue)
+            && queue->size - queue->pos <= NETPLAY_SPECTATE_QUEUE_MAX)
          continue;
 
       RARCH_LOG("Client (#%u) disconnected ...\n", i);
@@ -1604,9 +3807,11 @@ static void netplay_post_frame_spectate(netplay_t *netplay)
 
       socket_close(netplay->spectate_fds[i]);
       netplay->spectate_fds[i] = -1;
-      break;
+      free(queue->data);
+      memset(queue, 0, sizeof(*queue));
    }
 
+   spectate_log_input(netplay);
    netplay->spectate_input_ptr = 0;
 }
 
@@ -1620,10 +3825,18 @@ static void netplay_post_frame_spectate(netplay_t *netplay)
  **/
 void netplay_post_frame(netplay_t *netplay)
 {
+   RARCH_PERFORMANCE_INIT(netplay_frame_post);
+   RARCH_PERFORMANCE_START(netplay_frame_post);
+
    if (netplay->spectate)
       netplay_post_frame_spectate(netplay);
    else
+   {
       netplay_post_frame_net(netplay);
+      netplay_record_frames(netplay);
+   }
+
+   RARCH_PERFORMANCE_STOP(netplay_frame_post);
 }
 
 void deinit_netplay(void)
@@ -1676,11 +3889,27 @@ bool init_netplay(void)
    driver->netplay_data = (netplay_t*)netplay_new(
          global->netplay_is_client ? global->netplay_server : NULL,
          global->netplay_port ? global->netplay_port : RARCH_DEFAULT_PORT,
-         global->netplay_sync_frames, &cbs, global->netplay_is_spectate,
-         settings->username);
+         global->netplay_sync_frames, global->netplay_input_delay_frames,
+         global->netplay_users, settings->netplay_check_frames,
+         &cbs, global->netplay_is_spectate,
+         settings->username, global->netplay_rendezvous);
 
    if (driver->netplay_data)
+   {
+      netplay_t *netplay = (netplay_t*)driver->netplay_data;
+
+      /* Our own input alone cannot replay a netplay session, 
+       * so record what the core got from every user instead. */
+      if (global->bsv.movie && !global->bsv.movie_playback 
+            && !netplay->spectate)
+      {
+         bsv_movie_free(global->bsv.movie);
+         global->bsv.movie = NULL;
+         strlcpy(netplay->record_path, global->bsv.movie_start_path,
+               sizeof(netplay->record_path));
+      }
       return true;
+   }
 
    global->netplay_is_client = false;
    RARCH_WARN(RETRO_LOG_INIT_NETPLAY_FAILED);
@@ -49,19 +49,30 @@ int16_t input_state_spectate_client(unsigned port, unsigned device,
  * @server               : IP address of server.
  * @port                 : Port of server.
  * @frames               : Amount of lag frames.
+ * @delay                : Amount of local input delay frames.
+ * @users                : Amount of users when hosting, including the host.
+ * @check_frames         : Interval in frames the host sends savestate 
+ *                         CRCs to detect desyncs, or 0 to disable.
  * @cb                   : Libretro callbacks.
  * @spectate             : If true, enable spectator mode.
  * @nick                 : Nickname of user.
+ * @rendezvous           : Rendezvous server "server[:port]" to meet 
+ *                         peers at, or NULL to connect directly.
  *
  * Creates a new netplay handle. A NULL host means we're 
- * hosting (user 1).
+ * hosting (user 1), in which case we wait for @users - 1 
+ * clients to connect and relay input between them.
+ *
+ * With @rendezvous, the host registers the session under @nick 
+ * and clients join the session named @server.
  *
  * Returns: new netplay handle.
  **/
 netplay_t *netplay_new(const char *server,
-      uint16_t port, unsigned frames,
-      const struct retro_callbacks *cb, bool spectate,
-      const char *nick);
+      uint16_t port, unsigned frames, unsigned delay, unsigned users,
+      unsigned check_frames, const struct retro_callbacks *cb,
+      bool spectate,
+      const char *nick, const char *rendezvous);
 
 /**
  * netplay_free:
@@ -76,6 +87,7 @@ void netplay_free(netplay_t *handle);
  * @netplay              : pointer to netplay object
  *
  * On regular netplay, flip who controls user 1 and 2.
+ * With more users, every user moves up one port.
  **/
 void netplay_flip_users(netplay_t *handle);
 
@@ -85,8 +97,12 @@ void netplay_flip_users(netplay_t *handle);
  *
  * Pre-frame for Netplay.
  * Call this before running retro_run().
+ *
+ * Returns: false (0) if retro_run() and netplay_post_frame() 
+ * must be skipped this time, because we are waiting for input 
+ * of other users.
  **/
-void netplay_pre_frame(netplay_t *handle);
+bool netplay_pre_frame(netplay_t *handle);
 
 /**
  * netplay_post_frame:   
@@ -24,7 +24,7 @@
 #include <string.h>
 #include "patch.h"
 #include "file_ops.h"
-#include <file/file_extract.h>
+#include "hash.h"
 #include "general.h"
 #include "retroarch_logger.h"
 
@@ -36,162 +36,234 @@ enum bps_mode
    TARGET_COPY
 };
 
-struct bps_data
-{
-   const uint8_t *modify_data, *source_data; 
-   uint8_t *target_data;
-   size_t modify_length, source_length, target_length;
-   size_t modify_offset, source_offset, target_offset;
-   uint32_t modify_checksum, source_checksum, target_checksum;
-
-   size_t source_relative_offset, target_relative_offset, output_offset;
-};
-
-static uint8_t bps_read(struct bps_data *bps)
-{
-   uint8_t data = bps->modify_data[bps->modify_offset++];
-#ifdef HAVE_ZLIB
-   bps->modify_checksum = zlib_crc32_adjust(bps->modify_checksum, data);
-#endif
-   return data;
-}
-
-static uint64_t bps_decode(struct bps_data *bps)
+/**
+ * patch_decode:
+ * @data         : patch data.
+ * @length       : size of @data.
+ * @offset       : offset of the number in @data, advanced past it.
+ * @out          : decoded number.
+ *
+ * Decodes a variable-length number as used by BPS and UPS.
+ *
+ * Returns: true (1) if successful, false (0) if the number is
+ * truncated or too large.
+ **/
+static bool patch_decode(const uint8_t *data, size_t length,
+      size_t *offset, uint64_t *out)
 {
-   uint64_t data = 0, shift = 1;
+   uint64_t value = 0, shift = 1;
 
    for (;;)
    {
-      uint8_t x = bps_read(bps);
-      data += (x & 0x7f) * shift;
+      uint8_t x;
+
+      if (*offset >= length || shift > (UINT64_C(1) << 56))
+         return false;
+
+      x      = data[(*offset)++];
+      value += (x & 0x7f) * shift;
       if (x & 0x80)
          break;
       shift <<= 7;
-      data += shift;
+      value += shift;
    }
 
-   return data;
+   *out = value;
+   return true;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+static uint32_t patch_read_le32(const uint8_t *data)
 {
-   if (!bps)
-      return;
-
-   bps->target_data[bps->output_offset++] = data;
-#ifdef HAVE_ZLIB
-   bps->target_checksum = zlib_crc32_adjust(bps->target_checksum, data);
-#endif
+   return (uint32_t)data[0]       | ((uint32_t)data[1] << 8) |
+         ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
 }
 
-patch_error_t bps_apply_patch(
+/**
+ * bps_read_header:
+ * @modify_data  : BPS patch data.
+ * @modify_length: size of @modify_data.
+ * @offset       : set to the offset of the first action.
+ * @source_size  : source size stored in the patch.
+ * @target_size  : target size stored in the patch.
+ *
+ * Returns: PATCH_SUCCESS if the header is valid.
+ **/
+static patch_error_t bps_read_header(
       const uint8_t *modify_data, size_t modify_length,
-      const uint8_t *source_data, size_t source_length,
-      uint8_t *target_data, size_t *target_length)
+      size_t *offset, uint64_t *source_size, uint64_t *target_size)
 {
-   size_t i;
-   size_t modify_source_size, modify_target_size,
-          modify_markup_size;
-   struct bps_data bps = {0};
-   uint32_t modify_source_checksum = 0, modify_target_checksum = 0,
-            modify_modify_checksum = 0, checksum;
+   uint64_t markup_size;
 
    if (modify_length < 19)
       return PATCH_PATCH_TOO_SMALL;
 
-   bps.modify_data = modify_data;
-   bps.modify_length = modify_length;
-   bps.target_data = target_data;
-   bps.target_length = *target_length;
-   bps.source_data = source_data;
-   bps.source_length = source_length;
-   bps.modify_checksum = ~0;
-   bps.target_checksum = ~0;
-
-   if ((bps_read(&bps) != 'B') || (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') || (bps_read(&bps) != '1'))
+   if (modify_data[0] != 'B' || modify_data[1] != 'P' ||
+         modify_data[2] != 'S' || modify_data[3] != '1')
       return PATCH_PATCH_INVALID_HEADER;
 
-   modify_source_size = bps_decode(&bps);
-   modify_target_size = bps_decode(&bps);
-   modify_markup_size = bps_decode(&bps);
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+   *offset = 4;
+
+   if (!patch_decode(modify_data, modify_length, offset, source_size))
+      return PATCH_PATCH_INVALID;
+   if (!patch_decode(modify_data, modify_length, offset, target_size))
+      return PATCH_PATCH_INVALID;
+   if (!patch_decode(modify_data, modify_length, offset, &markup_size))
+      return PATCH_PATCH_INVALID;
+   if (*offset > modify_length - 12
+         || markup_size > modify_length - 12 - *offset)
+      return PATCH_PATCH_INVALID;
+
+   *offset += markup_size;
+
+   return PATCH_SUCCESS;
+}
 
-   if (modify_source_size > bps.source_length)
+patch_error_t bps_get_target_size(
+      const uint8_t *modify_data, size_t modify_length,
+      size_t source_length, size_t *target_length)
+{
+   size_t offset;
+   uint64_t source_size, target_size;
+   patch_error_t err = bps_read_header(modify_data, modify_length,
+         &offset, &source_size, &target_size);
+
+   if (err != PATCH_SUCCESS)
+      return err;
+   if (source_size > source_length)
       return PATCH_SOURCE_TOO_SMALL;
-   if (modify_target_size > bps.target_length)
+   if (target_size > SIZE_MAX)
+      return PATCH_PATCH_INVALID;
+
+   *target_length = target_size;
+   return PATCH_SUCCESS;
+}
+
+patch_error_t bps_apply_patch(
+      const uint8_t *modify_data, size_t modify_length,
+      const uint8_t *source_data, size_t source_length,
+      uint8_t *target_data, size_t *target_length)
+{
+   size_t offset, end;
+   uint64_t modify_source_size, modify_target_size;
+   size_t output_offset          = 0;
+   size_t source_relative_offset = 0;
+   size_t target_relative_offset = 0;
+   uint32_t target_checksum      = 0;
+   patch_error_t err             = bps_read_header(modify_data,
+         modify_length, &offset, &modify_source_size, &modify_target_size);
+
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   if (modify_source_size > source_length)
+      return PATCH_SOURCE_TOO_SMALL;
+   if (modify_target_size > *target_length)
       return PATCH_TARGET_TOO_SMALL;
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   end = modify_length - 12;
+
+   /* Every action produces a run of target bytes, copied as one
+    * block. Their checksum is updated while they are still hot
+    * in the cache. */
+   while (offset < end)
    {
-      size_t length = bps_decode(&bps);
-      unsigned mode = length & 3;
+      uint64_t data;
+      size_t length;
+      uint8_t *out   = target_data + output_offset;
+
+      if (!patch_decode(modify_data, end, &offset, &data))
+         return PATCH_PATCH_INVALID;
+
+      if ((data >> 2) >= modify_target_size - output_offset)
+         return PATCH_TARGET_TOO_SMALL;
 
-      length = (length >> 2) + 1;
+      length = (size_t)(data >> 2) + 1;
 
-      switch (mode)
+      switch (data & 3)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (output_offset > source_length
+                  || length > source_length - output_offset)
+               return PATCH_SOURCE_TOO_SMALL;
+            memcpy(out, source_data + output_offset, length);
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > end - offset)
+               return PATCH_PATCH_INVALID;
+            memcpy(out, modify_data + offset, length);
+            offset += length;
             break;
 
          case SOURCE_COPY:
          case TARGET_COPY:
          {
-            int offset = bps_decode(&bps);
-            bool negative = offset & 1;
-            offset >>= 1;
-            if (negative)
-               offset = -offset;
+            uint64_t encoded;
+            size_t relative;
+
+            if (!patch_decode(modify_data, end, &offset, &encoded))
+               return PATCH_PATCH_INVALID;
+
+            relative = (size_t)(encoded >> 1);
 
-            if (mode == SOURCE_COPY)
+            if ((data & 3) == SOURCE_COPY)
             {
-               bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (encoded & 1)
+                  source_relative_offset -= relative;
+               else
+                  source_relative_offset += relative;
+
+               if (source_relative_offset > source_length
+                     || length > source_length - source_relative_offset)
+                  return PATCH_SOURCE_TOO_SMALL;
+
+               memcpy(out, source_data + source_relative_offset, length);
+               source_relative_offset += length;
             }
             else
             {
-               bps.target_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+               size_t distance;
+
+               if (encoded & 1)
+                  target_relative_offset -= relative;
+               else
+                  target_relative_offset += relative;
+
+               if (target_relative_offset >= output_offset)
+                  return PATCH_PATCH_INVALID;
+
+               /* Overlapping copies repeat the bytes already
+                * written, so they have to go forwards in steps
+                * of at most the distance between both ends. */
+               distance = output_offset - target_relative_offset;
+
+               if (length <= distance)
+                  memcpy(out, target_data + target_relative_offset, length);
+               else
+               {
+                  size_t i;
+                  const uint8_t *in = target_data + target_relative_offset;
+
+                  for (i = 0; i < length; i++)
+                     out[i] = in[i];
+               }
+               target_relative_offset += length;
             }
             break;
          }
       }
-   }
-
-
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
 
-   checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
-
-#ifdef HAVE_ZLIB
-   bps.source_checksum = zlib_crc32_calculate(bps.source_data, bps.source_length);
-#else
-   return PATCH_PATCH_CHECKSUM_INVALID;
-#endif
-
-   bps.target_checksum = ~bps.target_checksum;
+      target_checksum = crc32_update(target_checksum, out, length);
+      output_offset  += length;
+   }
 
-   if (bps.source_checksum != modify_source_checksum)
+   if (crc32_calculate(source_data, source_length)
+         != patch_read_le32(modify_data + end))
       return PATCH_SOURCE_CHECKSUM_INVALID;
-   if (bps.target_checksum != modify_target_checksum)
+   if (target_checksum != patch_read_le32(modify_data + end + 4))
       return PATCH_TARGET_CHECKSUM_INVALID;
-   if (checksum != modify_modify_checksum)
+   if (crc32_calculate(modify_data, modify_length - 4)
+         != patch_read_le32(modify_data + end + 8))
       return PATCH_PATCH_CHECKSUM_INVALID;
 
    *target_length = modify_target_size;
@@ -199,68 +271,96 @@ patch_error_t bps_apply_patch(
    return PATCH_SUCCESS;
 }
 
-struct ups_data
+/**
+ * ups_read_header:
+ * @patchdata    : UPS patch data.
+ * @patchlength  : size of @patchdata.
+ * @sourcelength : size of the source.
+ * @offset       : set to the offset of the first record.
+ * @source_size  : source size stored in the patch.
+ * @target_size  : target size stored in the patch.
+ * @targetlength : size of the target, UPS patches apply both ways.
+ *
+ * Returns: PATCH_SUCCESS if the header is valid and matches
+ * the source.
+ **/
+static patch_error_t ups_read_header(
+      const uint8_t *patchdata, size_t patchlength, size_t sourcelength,
+      size_t *offset, uint64_t *source_size, uint64_t *target_size,
+      size_t *targetlength)
 {
-   const uint8_t *patch_data, *source_data; 
-   uint8_t *target_data;
-   unsigned patch_length, source_length, target_length;
-   unsigned patch_offset, source_offset, target_offset;
-   unsigned patch_checksum, source_checksum, target_checksum;
-};
+   if (patchlength < 18)
+      return PATCH_PATCH_INVALID;
+   if (patchdata[0] != 'U' || patchdata[1] != 'P' ||
+         patchdata[2] != 'S' || patchdata[3] != '1')
+      return PATCH_PATCH_INVALID;
 
-static uint8_t ups_patch_read(struct ups_data *data) 
-{
-   if (data && data->patch_offset < data->patch_length) 
-   {
-      uint8_t n = data->patch_data[data->patch_offset++];
-#ifdef HAVE_ZLIB
-      data->patch_checksum = zlib_crc32_adjust(data->patch_checksum, n);
-#endif
-      return n;
-   }
-   return 0x00;
+   *offset = 4;
+
+   if (!patch_decode(patchdata, patchlength, offset, source_size))
+      return PATCH_PATCH_INVALID;
+   if (!patch_decode(patchdata, patchlength, offset, target_size))
+      return PATCH_PATCH_INVALID;
+
+   if (sourcelength != *source_size && sourcelength != *target_size)
+      return PATCH_SOURCE_INVALID;
+
+   *targetlength = (size_t)(sourcelength == *source_size ?
+         *target_size : *source_size);
+
+   return PATCH_SUCCESS;
 }
 
-static uint8_t ups_source_read(struct ups_data *data) 
+patch_error_t ups_get_target_size(
+      const uint8_t *patchdata, size_t patchlength,
+      size_t sourcelength, size_t *targetlength)
 {
-   if (data && data->source_offset < data->source_length) 
-   {
-      uint8_t n = data->source_data[data->source_offset++];
-#ifdef HAVE_ZLIB
-      data->source_checksum = zlib_crc32_adjust(data->source_checksum, n);
-#endif
-      return n;
-   }
-   return 0x00;
+   size_t offset;
+   uint64_t source_size, target_size;
+
+   return ups_read_header(patchdata, patchlength, sourcelength,
+         &offset, &source_size, &target_size, targetlength);
 }
 
-static void ups_target_write(struct ups_data *data, uint8_t n) 
+/**
+ * ups_copy:
+ *
+ * Copies @length bytes of the source to the target at their
+ * current offsets. The source reads as zeros past its end and
+ * writes past the end of the target are dropped.
+ **/
+static void ups_copy(const uint8_t *sourcedata, size_t sourcelength,
+      size_t *source_offset, uint8_t *targetdata, size_t targetlength,
+      size_t *target_offset, size_t length)
 {
-   if (data && data->target_offset < data->target_length) 
+   size_t readable = sourcelength - *source_offset;
+
+   if (*target_offset < targetlength)
    {
-      data->target_data[data->target_offset] = n;
-#ifdef HAVE_ZLIB
-      data->target_checksum = zlib_crc32_adjust(data->target_checksum, n);
-#endif
+      size_t writable = targetlength - *target_offset;
+      size_t count    = length < writable ? length : writable;
+      size_t copied   = count  < readable ? count  : readable;
+
+      memcpy(targetdata + *target_offset,
+            sourcedata + *source_offset, copied);
+      memset(targetdata + *target_offset + copied, 0, count - copied);
    }
 
-   if (data)
-      data->target_offset++;
+   *source_offset += length < readable ? length : readable;
+   *target_offset += length;
 }
 
-static uint64_t ups_decode(struct ups_data *data) 
+/* Reads past the end of the patch give zeros. */
+static uint32_t ups_read_le32(const uint8_t *patchdata,
+      size_t patchlength, size_t *offset)
 {
-   uint64_t offset = 0, shift = 1;
-   while (true) 
-   {
-      uint8_t x = ups_patch_read(data);
-      offset += (x & 0x7f) * shift;
-      if (x & 0x80) 
-         break;
-      shift <<= 7;
-      offset += shift;
-   }
-   return offset;
+   size_t i;
+   uint8_t bytes[4] = {0};
+
+   for (i = 0; i < 4 && *offset < patchlength; i++)
+      bytes[i] = patchdata[(*offset)++];
+
+   return patch_read_le32(bytes);
 }
 
 patch_error_t ups_apply_patch(
@@ -268,106 +368,108 @@ patch_error_t ups_apply_patch(
       const uint8_t *sourcedata, size_t sourcelength,
       uint8_t *targetdata, size_t *targetlength)
 {
-   size_t i;
-   unsigned source_read_length, target_read_length;
-   uint32_t patch_read_checksum = 0, source_read_checksum = 0,
-            target_read_checksum = 0, patch_result_checksum;
-   struct ups_data data = {0};
-
-   data.patch_data      = patchdata;
-   data.source_data     = sourcedata;
-   data.target_data     = targetdata;
-   data.patch_length    = patchlength;
-   data.source_length   = sourcelength;
-   data.target_length   = *targetlength;
-   data.patch_checksum  = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
-
-   if (data.patch_length < 18) 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'U') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'P') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'S') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != '1') 
-      return PATCH_PATCH_INVALID;
-
-   source_read_length = ups_decode(&data);
-   target_read_length = ups_decode(&data);
-
-   if (data.source_length != source_read_length
-         && data.source_length != target_read_length) 
-      return PATCH_SOURCE_INVALID;
-   *targetlength = (data.source_length == source_read_length ?
-         target_read_length : source_read_length);
-   if (data.target_length < *targetlength) 
+   size_t offset, length;
+   uint64_t source_read_length, target_read_length;
+   uint32_t source_read_checksum, target_read_checksum;
+   uint32_t patch_read_checksum, patch_result_checksum;
+   uint32_t source_checksum, target_checksum;
+   size_t source_offset = 0;
+   size_t target_offset = 0;
+   patch_error_t err    = ups_read_header(patchdata, patchlength,
+         sourcelength, &offset, &source_read_length,
+         &target_read_length, &length);
+
+   if (err != PATCH_SUCCESS)
+      return err;
+   if (*targetlength < length)
       return PATCH_TARGET_TOO_SMALL;
-   data.target_length = *targetlength;
+   *targetlength = length;
 
-   while (data.patch_offset < data.patch_length - 12) 
+   while (offset < patchlength - 12)
    {
-      unsigned length = ups_decode(&data);
-      while (length--) 
-         ups_target_write(&data, ups_source_read(&data));
-      while (true) 
+      uint64_t skip;
+
+      if (!patch_decode(patchdata, patchlength, &offset, &skip))
+         return PATCH_PATCH_INVALID;
+      if (skip > SIZE_MAX - target_offset)
+         return PATCH_PATCH_INVALID;
+
+      ups_copy(sourcedata, sourcelength, &source_offset,
+            targetdata, *targetlength, &target_offset, (size_t)skip);
+
+      for (;;)
       {
-         uint8_t patch_xor = ups_patch_read(&data);
-         ups_target_write(&data, patch_xor ^ ups_source_read(&data));
+         uint8_t patch_xor = 0, source = 0;
+
+         if (offset < patchlength)
+            patch_xor = patchdata[offset++];
+         if (source_offset < sourcelength)
+            source    = sourcedata[source_offset++];
+         if (target_offset < *targetlength)
+            targetdata[target_offset] = patch_xor ^ source;
+         target_offset++;
+
          if (patch_xor == 0)
             break;
       }
    }
 
-   while (data.source_offset < data.source_length) 
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length) 
-      ups_target_write(&data, ups_source_read(&data));
-
-
-   for (i = 0; i < 4; i++) 
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
-   for (i = 0; i < 4; i++) 
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
+   if (target_offset < *targetlength)
+      ups_copy(sourcedata, sourcelength, &source_offset,
+            targetdata, *targetlength, &target_offset,
+            *targetlength - target_offset);
 
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
+   source_read_checksum  = ups_read_le32(patchdata, patchlength, &offset);
+   target_read_checksum  = ups_read_le32(patchdata, patchlength, &offset);
+   patch_result_checksum = crc32_calculate(patchdata, offset);
+   patch_read_checksum   = ups_read_le32(patchdata, patchlength, &offset);
 
-   for (i = 0; i < 4; i++) 
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
+   source_checksum = crc32_calculate(sourcedata, sourcelength);
+   target_checksum = crc32_calculate(targetdata, *targetlength);
 
-   if (patch_result_checksum != patch_read_checksum) 
+   if (patch_result_checksum != patch_read_checksum)
       return PATCH_PATCH_INVALID;
 
-   if (data.source_checksum == source_read_checksum
-         && data.source_length == source_read_length) 
+   if (source_checksum == source_read_checksum
+         && sourcelength == source_read_length)
    {
-      if (data.target_checksum == target_read_checksum
-            && data.target_length == target_read_length) 
+      if (target_checksum == target_read_checksum
+            && *targetlength == target_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
-   } 
-   else if (data.source_checksum == target_read_checksum
-         && data.source_length == target_read_length) 
+   }
+   else if (source_checksum == target_read_checksum
+         && sourcelength == target_read_length)
    {
-      if (data.target_checksum == source_read_checksum
-            && data.target_length == source_read_length) 
+      if (target_checksum == source_read_checksum
+            && *targetlength == source_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
-   } 
+   }
 
    return PATCH_SOURCE_INVALID;
 }
 
-patch_error_t ips_apply_patch(
-      const uint8_t *patchdata, size_t patchlen,
-      const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+/**
+ * ips_process:
+ * @patchdata    : IPS patch data.
+ * @patchlen     : size of @patchdata.
+ * @targetdata   : target holding a copy of the source, or NULL
+ *                 to only validate the patch.
+ * @buffer_size  : size of the target, grown to the end of the
+ *                 furthest record.
+ * @targetlength : set to the size of the patched content.
+ *
+ * Walks the records of an IPS patch, applying them to
+ * @targetdata unless it is NULL. @targetdata has to be at
+ * least as large as @buffer_size ends up.
+ *
+ * Returns: PATCH_SUCCESS if the patch is valid.
+ **/
+static patch_error_t ips_process(const uint8_t *patchdata, size_t patchlen,
+      uint8_t *targetdata, size_t *buffer_size, size_t *targetlength)
 {
-   uint32_t offset = 5;
+   size_t offset = 5;
 
    if (patchlen < 8 ||
          patchdata[0] != 'P' ||
@@ -377,14 +479,9 @@ patch_error_t ips_apply_patch(
          patchdata[4] != 'H')
       return PATCH_PATCH_INVALID;
 
-   memcpy(targetdata, sourcedata, sourcelength);
-
-   *targetlength = sourcelength;
-
    for (;;)
    {
-      uint32_t address;
-      unsigned length;
+      size_t address, length;
 
       if (offset > patchlen - 3)
          break;
@@ -396,12 +493,24 @@ patch_error_t ips_apply_patch(
       if (address == 0x454f46) /* EOF */
       {
          if (offset == patchlen)
+         {
+            *targetlength = *buffer_size;
             return PATCH_SUCCESS;
+         }
          else if (offset == patchlen - 3)
          {
-            uint32_t size = patchdata[offset++] << 16;
-            size |= patchdata[offset++] << 8;
-            size |= patchdata[offset++] << 0;
+            size_t size  = patchdata[offset++] << 16;
+            size        |= patchdata[offset++] << 8;
+            size        |= patchdata[offset++] << 0;
+
+            /* Truncation can also extend the target. */
+            if (size > *buffer_size)
+            {
+               if (targetdata)
+                  memset(targetdata + *buffer_size, 0,
+                        size - *buffer_size);
+               *buffer_size = size;
+            }
             *targetlength = size;
             return PATCH_SUCCESS;
          }
@@ -418,8 +527,9 @@ patch_error_t ips_apply_patch(
          if (offset > patchlen - length)
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         if (targetdata)
+            memcpy(targetdata + address, patchdata + offset, length);
+         offset += length;
       }
       else /* RLE */
       {
@@ -432,22 +542,76 @@ patch_error_t ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
-
+         if (targetdata)
+            memset(targetdata + address, patchdata[offset], length);
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if (address + length > *buffer_size)
+      {
+         /* Records may start past the current end of the target. */
+         if (targetdata && address > *buffer_size)
+            memset(targetdata + *buffer_size, 0, address - *buffer_size);
+         *buffer_size = address + length;
+      }
    }
 
    return PATCH_PATCH_INVALID;
 }
 
+patch_error_t ips_get_target_size(
+      const uint8_t *patchdata, size_t patchlen,
+      size_t sourcelength, size_t *targetlength)
+{
+   size_t size;
+
+   *targetlength = sourcelength;
+   return ips_process(patchdata, patchlen, NULL, targetlength, &size);
+}
+
+patch_error_t ips_apply_patch(
+      const uint8_t *patchdata, size_t patchlen,
+      const uint8_t *sourcedata, size_t sourcelength,
+      uint8_t *targetdata, size_t *targetlength)
+{
+   size_t buffer_size = sourcelength;
+   patch_error_t err  = ips_get_target_size(patchdata, patchlen,
+         sourcelength, &buffer_size);
+
+   /* Validate the whole patch before writing anything,
+    * so a patch applied in place can't fail halfway. */
+   if (err != PATCH_SUCCESS)
+      return err;
+   if (buffer_size > *targetlength)
+      return PATCH_TARGET_TOO_SMALL;
+
+   if (targetdata != sourcedata)
+      memcpy(targetdata, sourcedata, sourcelength);
+
+   buffer_size = sourcelength;
+   return ips_process(patchdata, patchlen, targetdata,
+         &buffer_size, targetlength);
+}
+
+/**
+ * apply_patch_content:
+ * @buf          : buffer of the content file.
+ * @size         : size   of the content file.
+ * @patch_desc   : name of the patch format.
+ * @patch_path   : path of the patch file.
+ * @size_func    : returns the size of the patched content.
+ * @func         : applies the patch.
+ * @in_place     : the patch can be applied in @buf itself.
+ *
+ * Patches the content into a buffer sized for the result.
+ * Patches that can be applied in place and don't grow the
+ * content are applied to @buf directly.
+ *
+ * Returns: true (1) if a patch file was found, otherwise false (0).
+ **/
 static bool apply_patch_content(uint8_t **buf,
       ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func)
+      patch_size_func_t size_func, patch_func_t func, bool in_place)
 {
    size_t target_size;
    ssize_t patch_size;
@@ -470,18 +634,25 @@ static bool apply_patch_content(uint8_t **buf,
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
-   target_size = ret_size * 4; /* Just to be sure. */
-
-   patched_content = (uint8_t*)malloc(target_size);
+   err = size_func((const uint8_t*)patch_data, patch_size,
+         ret_size, &target_size);
 
-   if (!patched_content)
+   if (err == PATCH_SUCCESS)
    {
-      RARCH_ERR("Failed to allocate memory for patched content ...\n");
-      goto error;
-   }
+      if (in_place && target_size <= (size_t)ret_size)
+         patched_content = ret_buf;
+      else
+         patched_content = (uint8_t*)malloc(target_size ? target_size : 1);
 
-   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+      if (!patched_content)
+      {
+         RARCH_ERR("Failed to allocate memory for patched content ...\n");
+         goto error;
+      }
+
+      err = func((const uint8_t*)patch_data, patch_size, ret_buf,
+            ret_size, patched_content, &target_size);
+   }
 
    if (err == PATCH_SUCCESS)
    {
@@ -492,12 +663,14 @@ static bool apply_patch_content(uint8_t **buf,
       RARCH_ERR("Failed to patch %s: Error #%u\n", patch_desc,
             (unsigned)err);
 
+   /* The caller still owns the unpatched content. */
    if (success)
    {
-      free(ret_buf);
       *buf = patched_content;
       *size = target_size;
    }
+   else if (patched_content != ret_buf)
+      free(patched_content);
 
    free(patch_data);
    return true;
@@ -521,7 +694,7 @@ static bool try_bps_patch(uint8_t **buf, ssize_t *size)
       return false;
 
    return apply_patch_content(buf, size, "BPS", global->bps_name,
-         bps_apply_patch);
+         bps_get_target_size, bps_apply_patch, false);
 }
 
 static bool try_ups_patch(uint8_t **buf, ssize_t *size)
@@ -535,7 +708,7 @@ static bool try_ups_patch(uint8_t **buf, ssize_t *size)
       return false;
 
    return apply_patch_content(buf, size, "UPS", global->ups_name,
-         ups_apply_patch);
+         ups_get_target_size, ups_apply_patch, false);
 }
 
 static bool try_ips_patch(uint8_t **buf, ssize_t *size)
@@ -549,7 +722,7 @@ static bool try_ips_patch(uint8_t **buf, ssize_t *size)
       return false;
 
    return apply_patch_content(buf, size, "IPS", global->ips_name,
-         ips_apply_patch);
+         ips_get_target_size, ips_apply_patch, true);
 }
 
 /**
@@ -557,7 +730,10 @@ static bool try_ips_patch(uint8_t **buf, ssize_t *size)
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
  *
- * Apply patch to the content file in-memory.
+ * Apply patch to the content file in-memory. If patched, @buf is
+ * either patched in place or set to a newly allocated buffer, in
+ * which case the caller remains responsible for releasing the
+ * original one.
  *
  **/
 void patch_content(uint8_t **buf, ssize_t *size)
@@ -42,6 +42,25 @@ typedef enum
 typedef patch_error_t (*patch_func_t)(const uint8_t*, size_t,
       const uint8_t*, size_t, uint8_t*, size_t*);
 
+/* Returns the size of the patched content for a source of the
+ * given size, validating as much of the patch as that needs. */
+typedef patch_error_t (*patch_size_func_t)(const uint8_t*, size_t,
+      size_t, size_t*);
+
+patch_error_t bps_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length, size_t *target_length);
+
+patch_error_t ups_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length, size_t *target_length);
+
+/* IPS patches are validated in full, and can be applied with
+ * source_data == target_data when target_length is large enough. */
+patch_error_t ips_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length, size_t *target_length);
+
 patch_error_t bps_apply_patch(
       const uint8_t *patch_data, size_t patch_length,
       const uint8_t *source_data, size_t source_length,
@@ -63,7 +82,10 @@ patch_error_t ips_apply_patch(
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
  *
- * Apply patch to the content file in-memory.
+ * Apply patch to the content file in-memory. If patched, @buf is
+ * either patched in place or set to a newly allocated buffer, in
+ * which case the caller remains responsible for releasing the
+ * original one.
  *
  **/
 void patch_content(uint8_t **buf, ssize_t *size);
@@ -19,6 +19,8 @@
 #include "performance.h"
 #include "general.h"
 #include "compat/strl.h"
+#include <memory/ralloc.h>
+#include <retro_miscellaneous.h>
 
 #ifdef ANDROID
 #include "performance/performance_android.h"
@@ -97,6 +99,10 @@ static int clock_gettime(int clk_ik, struct timespec *t)
 
 #include <string.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 const struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 const struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 unsigned perf_ptr_rarch;
@@ -129,6 +135,106 @@ void retro_perf_clear(void)
    memset(perf_counters_libretro, 0, sizeof(perf_counters_libretro));
 }
 
+static const char *rarch_zone_names[RARCH_ZONE_LAST] = {
+   "frontend",
+   "core",
+   "video",
+   "audio",
+   "input",
+   "menu",
+   "data",
+   "idle",
+};
+
+volatile int rarch_zone_current;
+
+static struct
+{
+   unsigned samples[RARCH_ZONE_LAST];
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   volatile bool quit;
+#endif
+} rarch_zone_sampler;
+
+#ifdef HAVE_THREADS
+static void rarch_zone_sampler_thread(void *data)
+{
+   (void)data;
+
+   while (!rarch_zone_sampler.quit)
+   {
+      unsigned zone;
+
+      rarch_sleep(1);
+
+      zone = (unsigned)rarch_zone_current;
+      if (zone < RARCH_ZONE_LAST)
+         rarch_zone_sampler.samples[zone]++;
+   }
+}
+#endif
+
+bool rarch_zone_sampler_init(void)
+{
+#ifdef HAVE_THREADS
+   if (rarch_zone_sampler.thread)
+      return true;
+
+   rarch_zone_sampler.quit   = false;
+   rarch_zone_sampler.thread = sthread_create(rarch_zone_sampler_thread, NULL);
+   if (!rarch_zone_sampler.thread)
+   {
+      RARCH_ERR("Failed to start the zone sampler.\n");
+      return false;
+   }
+
+   return true;
+#else
+   return false;
+#endif
+}
+
+void rarch_zone_sampler_free(void)
+{
+#ifdef HAVE_THREADS
+   if (!rarch_zone_sampler.thread)
+      return;
+
+   rarch_zone_sampler.quit = true;
+   sthread_join(rarch_zone_sampler.thread);
+   rarch_zone_sampler.thread = NULL;
+#endif
+}
+
+unsigned rarch_zone_samples(enum rarch_zone zone)
+{
+   return rarch_zone_sampler.samples[zone];
+}
+
+const char *rarch_zone_name(enum rarch_zone zone)
+{
+   if ((unsigned)zone >= RARCH_ZONE_LAST)
+      return "unknown";
+   return rarch_zone_names[zone];
+}
+
+static void log_zones(void)
+{
+   unsigned i, total = 0;
+
+   for (i = 0; i < RARCH_ZONE_LAST; i++)
+      total += rarch_zone_sampler.samples[i];
+
+   if (!total)
+      return;
+
+   RARCH_LOG("[PERF]: Main thread zones (%u samples):\n", total);
+   for (i = 0; i < RARCH_ZONE_LAST; i++)
+      RARCH_LOG("[PERF]: %s: %.1f %%\n", rarch_zone_names[i],
+            100.0 * rarch_zone_sampler.samples[i] / total);
+}
+
 static void log_counters(
       const struct retro_perf_counter **counters, unsigned num)
 {
@@ -146,6 +252,28 @@ static void log_counters(
    }
 }
 
+#define MEMORY_FMT "%s: %u KB (peak %u KB), %u allocations (%u total)"
+
+static void log_memory(void)
+{
+   unsigned i;
+
+   for (i = 0; i < RALLOC_TAG_LAST; i++)
+   {
+      struct ralloc_stats stats;
+
+      if (!ralloc_get_stats((enum ralloc_tag)i, &stats))
+         return;
+
+      if (i == 0)
+         RARCH_LOG("[PERF]: Memory (RetroArch):\n");
+
+      RARCH_LOG("[PERF]: " MEMORY_FMT ".\n", ralloc_tag_name((enum ralloc_tag)i),
+            (unsigned)(stats.bytes / 1024), (unsigned)(stats.peak / 1024),
+            (unsigned)stats.allocs, (unsigned)stats.total_allocs);
+   }
+}
+
 void rarch_perf_log(void)
 {
    global_t *global = global_get_ptr();
@@ -155,6 +283,119 @@ void rarch_perf_log(void)
 
    RARCH_LOG("[PERF]: Performance counters (RetroArch):\n");
    log_counters(perf_counters_rarch, perf_ptr_rarch);
+   log_memory();
+   log_zones();
+}
+
+bool rarch_memory_dump(const char *path)
+{
+   unsigned i;
+   FILE *file = NULL;
+   struct ralloc_stats stats;
+
+   if (!ralloc_get_stats((enum ralloc_tag)0, &stats))
+   {
+      RARCH_ERR("Memory tracking is not built in (HAVE_RALLOC_STATS).\n");
+      return false;
+   }
+
+   if (!(file = fopen(path, "w")))
+   {
+      RARCH_ERR("Failed to open \"%s\" for the memory report.\n", path);
+      return false;
+   }
+
+   for (i = 0; i < RALLOC_TAG_LAST; i++)
+   {
+      ralloc_get_stats((enum ralloc_tag)i, &stats);
+      fprintf(file, MEMORY_FMT "\n", ralloc_tag_name((enum ralloc_tag)i),
+            (unsigned)(stats.bytes / 1024), (unsigned)(stats.peak / 1024),
+            (unsigned)stats.allocs, (unsigned)stats.total_allocs);
+   }
+
+   fclose(file);
+   RARCH_LOG("Wrote memory report to \"%s\".\n", path);
+   return true;
+}
+
+static void json_write_string(FILE *file, const char *str)
+{
+   fputc('"', file);
+   for (; str && *str; str++)
+   {
+      unsigned char c = (unsigned char)*str;
+
+      if (c == '"' || c == '\\')
+         fprintf(file, "\\%c", c);
+      else if (c < 0x20)
+         fprintf(file, "\\u%04x", c);
+      else
+         fputc(c, file);
+   }
+   fputc('"', file);
+}
+
+static void json_write_counters(FILE *file,
+      const struct retro_perf_counter **counters, unsigned num,
+      double ticks_per_usec)
+{
+   unsigned i;
+   bool first = true;
+
+   fputc('[', file);
+   for (i = 0; i < num; i++)
+   {
+      double avg;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      avg = (double)counters[i]->total / counters[i]->call_cnt;
+
+      fputs(first ? "\n    {\"name\": " : ",\n    {\"name\": ", file);
+      json_write_string(file, counters[i]->ident);
+      fprintf(file, ", \"calls\": %llu, \"total_ticks\": %llu, "
+            "\"avg_ticks\": %.1f, \"avg_usec\": %.3f}",
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->total, avg,
+            ticks_per_usec > 0.0 ? avg / ticks_per_usec : 0.0);
+      first = false;
+   }
+   fputs(first ? "]" : "\n  ]", file);
+}
+
+void rarch_benchmark_report(FILE *file, unsigned frames,
+      retro_time_t usec, retro_perf_tick_t ticks)
+{
+   unsigned i;
+   global_t *global      = global_get_ptr();
+   double seconds        = usec / 1000000.0;
+   double fps            = seconds > 0.0 ? frames / seconds : 0.0;
+   double core_fps       = global->system.av_info.timing.fps;
+   double ticks_per_usec = usec > 0 ? (double)ticks / usec : 0.0;
+
+   fputs("{\n  \"core\": ", file);
+   json_write_string(file, global->system.info.library_name);
+   fputs(",\n  \"core_version\": ", file);
+   json_write_string(file, global->system.info.library_version);
+   fputs(",\n  \"content\": ", file);
+   json_write_string(file, global->fullpath);
+   fprintf(file, ",\n  \"frames\": %u,\n  \"seconds\": %.6f,"
+         "\n  \"fps\": %.2f,\n  \"realtime\": %.3f,"
+         "\n  \"ticks_per_usec\": %.3f,\n  \"frontend\": ",
+         frames, seconds, fps, core_fps > 0.0 ? fps / core_fps : 0.0,
+         ticks_per_usec);
+   json_write_counters(file, perf_counters_rarch, perf_ptr_rarch,
+         ticks_per_usec);
+   fputs(",\n  \"core_counters\": ", file);
+   json_write_counters(file, perf_counters_libretro, perf_ptr_libretro,
+         ticks_per_usec);
+   fputs(",\n  \"zones\": {", file);
+   for (i = 0; i < RARCH_ZONE_LAST; i++)
+      fprintf(file, "%s\"%s\": %u", i ? ", " : "",
+            rarch_zone_names[i], rarch_zone_sampler.samples[i]);
+   fputs("}\n}\n", file);
+   fflush(file);
 }
 
 void retro_perf_log(void)
@@ -163,6 +404,147 @@ void retro_perf_log(void)
    log_counters(perf_counters_libretro, perf_ptr_libretro);
 }
 
+static bool print_counters(char *buf, size_t size, size_t *len,
+      const char *scope, const struct retro_perf_counter **counters,
+      unsigned num)
+{
+   unsigned i;
+
+   for (i = 0; i < num; i++)
+   {
+      int ret;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      ret = snprintf(buf + *len, size - *len, "PERF %s %llu %llu %llu %s\n",
+            scope, (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->total,
+            (unsigned long long)(counters[i]->total / counters[i]->call_cnt),
+            counters[i]->ident);
+      if (ret < 0 || (size_t)ret >= size - *len)
+      {
+         buf[*len] = '\0';
+         return false;
+      }
+      *len += ret;
+   }
+
+   return true;
+}
+
+size_t rarch_perf_print(char *buf, size_t size)
+{
+   unsigned i;
+   size_t len = 0;
+
+   if (!size)
+      return 0;
+
+   *buf = '\0';
+   if (!print_counters(buf, size, &len, "frontend",
+            perf_counters_rarch, perf_ptr_rarch)
+         || !print_counters(buf, size, &len, "core",
+            perf_counters_libretro, perf_ptr_libretro))
+      return len;
+
+   for (i = 0; i < RARCH_ZONE_LAST; i++)
+   {
+      int ret;
+
+      if (!rarch_zone_sampler.samples[i])
+         continue;
+
+      ret = snprintf(buf + len, size - len, "ZONE %u %s\n",
+            rarch_zone_sampler.samples[i], rarch_zone_names[i]);
+      if (ret < 0 || (size_t)ret >= size - len)
+      {
+         buf[len] = '\0';
+         break;
+      }
+      len += ret;
+   }
+
+   return len;
+}
+
+static struct
+{
+   FILE *file;
+   retro_time_t start;
+   bool first;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+} rarch_trace;
+
+bool rarch_trace_init(const char *path)
+{
+   rarch_trace_free();
+
+   rarch_trace.file = fopen(path, "w");
+   if (!rarch_trace.file)
+   {
+      RARCH_ERR("Failed to open trace: \"%s\".\n", path);
+      return false;
+   }
+
+#ifdef HAVE_THREADS
+   rarch_trace.lock = slock_new();
+#endif
+   rarch_trace.start = rarch_get_time_usec();
+   rarch_trace.first = true;
+
+   fputs("{\"traceEvents\":[", rarch_trace.file);
+
+   RARCH_LOG("Writing trace to: \"%s\".\n", path);
+   return true;
+}
+
+void rarch_trace_free(void)
+{
+   if (!rarch_trace.file)
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(rarch_trace.lock);
+#endif
+   fputs("\n],\"displayTimeUnit\":\"ms\"}\n", rarch_trace.file);
+   fclose(rarch_trace.file);
+   rarch_trace.file = NULL;
+#ifdef HAVE_THREADS
+   slock_unlock(rarch_trace.lock);
+   slock_free(rarch_trace.lock);
+#endif
+
+   memset(&rarch_trace, 0, sizeof(rarch_trace));
+}
+
+void rarch_trace_event(const char *name, char phase)
+{
+   unsigned long long tid = 0;
+   retro_time_t now       = 0;
+
+   if (!rarch_trace.file)
+      return;
+
+   now = rarch_get_time_usec();
+#ifdef HAVE_THREADS
+   tid = sthread_get_current_thread_id();
+   slock_lock(rarch_trace.lock);
+#endif
+
+   fprintf(rarch_trace.file,
+         "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%llu}",
+         rarch_trace.first ? "" : ",", name, phase,
+         (long long)(now - rarch_trace.start), tid);
+   rarch_trace.first = false;
+
+#ifdef HAVE_THREADS
+   slock_unlock(rarch_trace.lock);
+#endif
+}
+
 /**
  * rarch_get_perf_counter:
  *
@@ -17,6 +17,7 @@
 #ifndef _RARCH_PERF_H
 #define _RARCH_PERF_H
 
+#include <stdio.h>
 #include "general.h"
 #include <retro_inline.h>
 
@@ -41,6 +42,28 @@ extern "C" {
 #define RARCH_PERFORMANCE_START(X) rarch_perf_start(&(X))
 #define RARCH_PERFORMANCE_STOP(X) rarch_perf_stop(&(X))
 
+#define RARCH_TRACE_BEGIN(name) rarch_trace_event(name, 'B')
+#define RARCH_TRACE_END(name) rarch_trace_event(name, 'E')
+
+/* What the main thread is busy with, for the zone sampler. */
+enum rarch_zone
+{
+   /* Anything not covered below. */
+   RARCH_ZONE_FRONTEND = 0,
+   RARCH_ZONE_CORE,
+   RARCH_ZONE_VIDEO,
+   RARCH_ZONE_AUDIO,
+   RARCH_ZONE_INPUT,
+   RARCH_ZONE_MENU,
+   RARCH_ZONE_DATA,
+   /* Sleeping for frame delay, frame limiting or pause. */
+   RARCH_ZONE_IDLE,
+
+   RARCH_ZONE_LAST
+};
+
+extern volatile int rarch_zone_current;
+
 #ifndef MAX_COUNTERS
 #define MAX_COUNTERS 64
 #endif
@@ -78,14 +101,116 @@ void retro_perf_clear(void);
 
 void rarch_perf_log(void);
 
+/**
+ * rarch_memory_dump:
+ * @path                 : File to write the numbers to.
+ *
+ * Writes how much memory the frontend subsystems using ralloc
+ * hold, as plain text. Needs a build with HAVE_RALLOC_STATS.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rarch_memory_dump(const char *path);
+
 void retro_perf_log(void);
 
+/* Prints "PERF <scope> <calls> <total ticks> <avg ticks> <name>\n"
+ * for every counter that ran, where scope is "frontend" or "core"
+ * for counters registered with retro_perf_register(), then
+ * "ZONE <samples> <name>\n" for every zone the sampler found the
+ * main thread in. Stops at the last whole line that fits, and
+ * returns the length printed. */
+size_t rarch_perf_print(char *buf, size_t size);
+
+/**
+ * rarch_benchmark_report:
+ * @file                 : Stream to write the report to.
+ * @frames               : Frames that were run.
+ * @usec                 : Time they took, in microseconds.
+ * @ticks                : Same time, in rarch_get_perf_counter() ticks.
+ *
+ * Writes frames per second, the speed relative to the core's 
+ * own frame rate and every performance counter that ran, as JSON.
+ * Counters are also converted to microseconds, using @ticks 
+ * over @usec as the tick rate.
+ **/
+void rarch_benchmark_report(FILE *file, unsigned frames,
+      retro_time_t usec, retro_perf_tick_t ticks);
+
+/**
+ * rarch_trace_init:
+ * @path                 : Path of the trace to write.
+ *
+ * Starts writing the events marked with RARCH_TRACE_BEGIN()
+ * and RARCH_TRACE_END() to @path, in the Trace Event format
+ * read by chrome://tracing and Perfetto.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rarch_trace_init(const char *path);
+
+/**
+ * rarch_trace_free:
+ *
+ * Finishes the trace and stops tracing.
+ **/
+void rarch_trace_free(void);
+
+/**
+ * rarch_trace_event:
+ * @name                 : Name of the event.
+ * @phase                : 'B' at the beginning of the event,
+ *                         'E' at its end.
+ *
+ * Adds an event to the trace, on the calling thread.
+ * Beginnings and ends nest per thread.
+ **/
+void rarch_trace_event(const char *name, char phase);
+
 /**
  * rarch_perf_start:
  * @perf               : pointer to performance counter
  *
  * Start performance counter. 
  **/
+/**
+ * rarch_zone_sampler_init:
+ *
+ * Starts a thread which samples rarch_zone_current about 1000
+ * times a second, see rarch_zone_enter().
+ *
+ * Returns: true (1) if the thread runs, otherwise false (0).
+ **/
+bool rarch_zone_sampler_init(void);
+
+void rarch_zone_sampler_free(void);
+
+/**
+ * rarch_zone_samples:
+ * @zone                 : Zone to get the samples of.
+ *
+ * Returns: how often the main thread was found in @zone.
+ **/
+unsigned rarch_zone_samples(enum rarch_zone zone);
+
+const char *rarch_zone_name(enum rarch_zone zone);
+
+/**
+ * rarch_zone_enter:
+ * @zone                 : Zone the main thread enters.
+ *
+ * Cheap enough for every subsystem boundary of every frame,
+ * whether the sampler runs or not.
+ *
+ * Returns: the zone left, to enter again when done with @zone.
+ **/
+static INLINE enum rarch_zone rarch_zone_enter(enum rarch_zone zone)
+{
+   enum rarch_zone prev = (enum rarch_zone)rarch_zone_current;
+   rarch_zone_current   = zone;
+   return prev;
+}
+
 static INLINE void rarch_perf_start(struct retro_perf_counter *perf)
 {
    global_t *global = global_get_ptr();
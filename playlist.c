@@ -17,6 +17,7 @@
 
 #include "playlist.h"
 #include <compat/posix_string.h>
+#include <retro_miscellaneous.h>
 #include <boolean.h>
 #include "retroarch_logger.h"
 
@@ -24,6 +25,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* Pushes journaled before the playlist file gets rewritten. */
+#define PLAYLIST_JOURNAL_SIZE 64
+
 /**
  * content_playlist_get_index:
  * @playlist        	   : Playlist handle.
@@ -50,31 +54,6 @@ void content_playlist_get_index(content_playlist_t *playlist,
       *core_name = playlist->entries[idx].core_name;
 }
 
-void content_playlist_get_index_by_path(content_playlist_t *playlist,
-      const char *search_path,
-      char **path, char **core_path,
-      char **core_name)
-{
-   size_t i;
-   if (!playlist)
-      return;
-
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (strcmp(playlist->entries[i].path, search_path) != 0)
-         continue;
-
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      break;
-   }
-
-}
-
 /**
  * content_playlist_free_entry:
  * @entry           	   : Playlist entry handle.
@@ -100,63 +79,246 @@ static void content_playlist_free_entry(content_playlist_entry_t *entry)
 }
 
 /**
- * content_playlist_push:
+ * content_playlist_hash:
+ * @path                : Path of a playlist entry, or NULL.
+ *
+ * Returns: hash of @path, NULL hashes like an empty path.
+ **/
+static uint32_t content_playlist_hash(const char *path)
+{
+   uint32_t hash = 5381;
+
+   if (path)
+      for (; *path; path++)
+         hash = (hash << 5) + hash + (uint8_t)*path;
+
+   return hash;
+}
+
+/**
+ * content_playlist_seq_index:
+ * @playlist        	   : Playlist handle.
+ * @seq                 : Order of the entry.
+ *
+ * Entries are kept sorted by descending seq, so the entry
+ * can be found by bisection.
+ *
+ * Returns: index of the entry with @seq.
+ **/
+static size_t content_playlist_seq_index(content_playlist_t *playlist,
+      size_t seq)
+{
+   size_t lo = 0, hi = playlist->size;
+
+   while (hi - lo > 1)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (playlist->entries[mid].seq < seq)
+         hi = mid;
+      else
+         lo = mid;
+   }
+
+   return lo;
+}
+
+/**
+ * content_playlist_index_find:
+ * @playlist        	   : Playlist handle.
+ * @path                : Path of the entry, or NULL.
+ * @core_path           : Core path of the entry, or NULL for any core.
+ *
+ * Returns: index slot of the topmost entry with @path and
+ * @core_path, or NULL if there is none.
+ **/
+static content_playlist_slot_t *content_playlist_index_find(
+      content_playlist_t *playlist, const char *path, const char *core_path)
+{
+   content_playlist_slot_t *found = NULL;
+   uint32_t hash                  = content_playlist_hash(path);
+   size_t mask                    = playlist->index_cap - 1;
+   size_t i;
+
+   for (i = hash & mask; playlist->index[i].seq; i = (i + 1) & mask)
+   {
+      content_playlist_slot_t *slot  = &playlist->index[i];
+      content_playlist_entry_t *entry = NULL;
+
+      if (slot->hash != hash || (found && found->seq > slot->seq))
+         continue;
+
+      entry = &playlist->entries[
+         content_playlist_seq_index(playlist, slot->seq - 1)];
+
+      if (path ? (!entry->path || strcmp(path, entry->path))
+            : entry->path != NULL)
+         continue;
+      if (core_path && strcmp(core_path, entry->core_path))
+         continue;
+
+      found = slot;
+   }
+
+   return found;
+}
+
+static void content_playlist_index_add(content_playlist_t *playlist,
+      const content_playlist_entry_t *entry)
+{
+   uint32_t hash = content_playlist_hash(entry->path);
+   size_t mask   = playlist->index_cap - 1;
+   size_t i      = hash & mask;
+
+   while (playlist->index[i].seq)
+      i = (i + 1) & mask;
+
+   playlist->index[i].hash = hash;
+   playlist->index[i].seq  = entry->seq + 1;
+}
+
+static void content_playlist_index_remove(content_playlist_t *playlist,
+      const content_playlist_entry_t *entry)
+{
+   size_t mask = playlist->index_cap - 1;
+   size_t i    = content_playlist_hash(entry->path) & mask;
+   size_t j;
+
+   while (playlist->index[i].seq != entry->seq + 1)
+      i = (i + 1) & mask;
+
+   /* Shift the rest of the cluster back, so that lookups
+    * don't stop at the hole. */
+   for (j = (i + 1) & mask; playlist->index[j].seq; j = (j + 1) & mask)
+   {
+      size_t home = playlist->index[j].hash & mask;
+
+      if (((j - home) & mask) < ((j - i) & mask))
+         continue;
+
+      playlist->index[i] = playlist->index[j];
+      i = j;
+   }
+
+   playlist->index[i].seq = 0;
+}
+
+/**
+ * content_playlist_index_build:
+ * @playlist        	   : Playlist handle.
+ *
+ * Numbers the entries from the top down and indexes them.
+ **/
+static void content_playlist_index_build(content_playlist_t *playlist)
+{
+   size_t i;
+
+   memset(playlist->index, 0,
+         playlist->index_cap * sizeof(*playlist->index));
+
+   playlist->seq = playlist->size;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      playlist->entries[i].seq = playlist->size - 1 - i;
+      content_playlist_index_add(playlist, &playlist->entries[i]);
+   }
+}
+
+/**
+ * content_playlist_get_index_by_path:
+ * @playlist        	   : Playlist handle.
+ * @search_path         : Path of playlist entry to look for.
+ * @path                : Path of playlist entry.
+ * @core_path           : Core path of playlist entry.
+ * @core_name           : Core name of playlist entry.
+ *
+ * Gets values of the topmost playlist entry with @search_path,
+ * if there is one.
+ **/
+void content_playlist_get_index_by_path(content_playlist_t *playlist,
+      const char *search_path,
+      char **path, char **core_path,
+      char **core_name)
+{
+   size_t i;
+   content_playlist_slot_t *slot = NULL;
+
+   if (!playlist)
+      return;
+
+   slot = content_playlist_index_find(playlist, search_path, NULL);
+
+   if (!slot)
+      return;
+
+   i = content_playlist_seq_index(playlist, slot->seq - 1);
+
+   if (path)
+      *path      = playlist->entries[i].path;
+   if (core_path)
+      *core_path = playlist->entries[i].core_path;
+   if (core_name)
+      *core_name = playlist->entries[i].core_name;
+}
+
+/**
+ * content_playlist_push_entry:
  * @playlist        	   : Playlist handle.
  * @path                : Path of new playlist entry.
  * @core_path           : Core path of new playlist entry.
  * @core_name           : Core name of new playlist entry.
  *
- * Push entry to top of playlist.
+ * Push entry to top of playlist, without journaling it.
+ *
+ * Returns: true (1) if the playlist changed, otherwise false (0).
  **/
-void content_playlist_push(content_playlist_t *playlist,
+static bool content_playlist_push_entry(content_playlist_t *playlist,
       const char *path, const char *core_path,
       const char *core_name)
 {
    size_t i;
-
-   if (!playlist)
-      return;
+   content_playlist_slot_t *slot = NULL;
 
    if (!core_path || !*core_path || !core_name || !*core_name)
    {
       RARCH_ERR("cannot push NULL or empty core info into the playlist");
-      return;
+      return false;
    }
 
    if (path && !*path)
       path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
+   slot = content_playlist_index_find(playlist, path, core_path);
+
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. */
+   if (slot)
    {
       content_playlist_entry_t tmp;
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          !strcmp(path,playlist->entries[i].path));
 
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (strcmp(playlist->entries[i].core_path, core_path))
-         continue;
+      i = content_playlist_seq_index(playlist, slot->seq - 1);
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
       if (i == 0)
-         return;
+         return false;
 
       /* Seen it before, bump to top. */
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
 		      i * sizeof(content_playlist_entry_t));
-      playlist->entries[0] = tmp;
+      playlist->entries[0]     = tmp;
+      playlist->entries[0].seq = playlist->seq++;
+      slot->seq                = playlist->entries[0].seq + 1;
 
-      return;
+      return true;
    }
 
    if (playlist->size == playlist->cap)
    {
+      content_playlist_index_remove(playlist,
+            &playlist->entries[playlist->cap - 1]);
       content_playlist_free_entry(&playlist->entries[playlist->cap - 1]);
       playlist->size--;
    }
@@ -167,7 +329,12 @@ void content_playlist_push(content_playlist_t *playlist,
    playlist->entries[0].path      = path ? strdup(path) : NULL;
    playlist->entries[0].core_path = strdup(core_path);
    playlist->entries[0].core_name = strdup(core_name);
+   playlist->entries[0].seq       = playlist->seq++;
    playlist->size++;
+
+   content_playlist_index_add(playlist, &playlist->entries[0]);
+
+   return true;
 }
 
 static void content_playlist_write_file(content_playlist_t *playlist)
@@ -190,6 +357,53 @@ static void content_playlist_write_file(content_playlist_t *playlist)
             playlist->entries[i].core_name);
 
    fclose(file);
+
+   /* Everything journaled is in the file now. */
+   remove(playlist->journal_path);
+   playlist->journal_size = 0;
+   playlist->modified     = false;
+}
+
+/**
+ * content_playlist_push:
+ * @playlist        	   : Playlist handle.
+ * @path                : Path of new playlist entry.
+ * @core_path           : Core path of new playlist entry.
+ * @core_name           : Core name of new playlist entry.
+ *
+ * Push entry to top of playlist. The entry is appended to the
+ * journal of the playlist file, which gets folded back into the
+ * file once it is long enough or the playlist is freed.
+ **/
+void content_playlist_push(content_playlist_t *playlist,
+      const char *path, const char *core_path,
+      const char *core_name)
+{
+   FILE *file = NULL;
+
+   if (!playlist)
+      return;
+
+   if (!content_playlist_push_entry(playlist, path, core_path, core_name))
+      return;
+
+   playlist->modified = true;
+
+   if (playlist->journal_size >= PLAYLIST_JOURNAL_SIZE)
+   {
+      content_playlist_write_file(playlist);
+      return;
+   }
+
+   file = fopen(playlist->journal_path, "a");
+
+   if (!file)
+      return;
+
+   fprintf(file, "%s\n%s\n%s\n", path ? path : "", core_path, core_name);
+   fclose(file);
+
+   playlist->journal_size++;
 }
 
 /**
@@ -205,13 +419,15 @@ void content_playlist_free(content_playlist_t *playlist)
    if (!playlist)
       return;
 
-   if (playlist->conf_path)
+   if (playlist->conf_path && playlist->modified)
       content_playlist_write_file(playlist);
    free(playlist->conf_path);
+   free(playlist->journal_path);
 
    for (i = 0; i < playlist->cap; i++)
       content_playlist_free_entry(&playlist->entries[i]);
    free(playlist->entries);
+   free(playlist->index);
 
    free(playlist);
 }
@@ -231,6 +447,10 @@ void content_playlist_clear(content_playlist_t *playlist)
    for (i = 0; i < playlist->cap; i++)
       content_playlist_free_entry(&playlist->entries[i]);
    playlist->size = 0;
+   content_playlist_index_build(playlist);
+
+   /* Pushes journaled until now must not come back. */
+   content_playlist_write_file(playlist);
 }
 
 /**
@@ -247,13 +467,40 @@ size_t content_playlist_size(content_playlist_t *playlist)
    return playlist->size;
 }
 
+/**
+ * content_playlist_read_entry:
+ * @file                : Playlist or journal file.
+ * @buf                 : Path, core path and core name of the entry.
+ *
+ * Reads the three lines of the next entry.
+ *
+ * Returns: true (1) if an entry was read, false (0) at end of file.
+ **/
+static bool content_playlist_read_entry(FILE *file, char buf[3][1024])
+{
+   unsigned i;
+   char *last = NULL;
+
+   for (i = 0; i < 3; i++)
+   {
+      *buf[i] = '\0';
+
+      if (!fgets(buf[i], sizeof(buf[i]), file))
+         return false;
+
+      last = strrchr(buf[i], '\n');
+      if (last)
+         *last = '\0';
+   }
+
+   return true;
+}
+
 static bool content_playlist_read_file(
       content_playlist_t *playlist, const char *path)
 {
    char buf[3][1024];
-   unsigned i;
    content_playlist_entry_t *entry = NULL;
-   char *last = NULL;
    FILE *file = fopen(path, "r");
 
    /* If playlist file does not exist,
@@ -264,17 +511,8 @@ static bool content_playlist_read_file(
 
    for (playlist->size = 0; playlist->size < playlist->cap; )
    {
-      for (i = 0; i < 3; i++)
-      {
-         *buf[i] = '\0';
-
-         if (!fgets(buf[i], sizeof(buf[i]), file))
-            goto end;
-
-         last = strrchr(buf[i], '\n');
-         if (last)
-            *last = '\0';
-      }
+      if (!content_playlist_read_entry(file, buf))
+         break;
 
       entry = &playlist->entries[playlist->size];
 
@@ -288,11 +526,37 @@ static bool content_playlist_read_file(
       playlist->size++;
    }
 
-end:
    fclose(file);
+
+   content_playlist_index_build(playlist);
    return true;
 }
 
+/**
+ * content_playlist_read_journal:
+ * @playlist        	   : Playlist handle.
+ *
+ * Replays the pushes journaled after the playlist file was
+ * last written, i.e. when it wasn't freed properly.
+ **/
+static void content_playlist_read_journal(content_playlist_t *playlist)
+{
+   char buf[3][1024];
+   FILE *file = fopen(playlist->journal_path, "r");
+
+   if (!file)
+      return;
+
+   while (content_playlist_read_entry(file, buf))
+   {
+      if (content_playlist_push_entry(playlist, buf[0], buf[1], buf[2]))
+         playlist->modified = true;
+      playlist->journal_size++;
+   }
+
+   fclose(file);
+}
+
 /**
  * content_playlist_init:
  * @path            	   : Path to playlist contents file.
@@ -304,6 +568,7 @@ end:
  **/
 content_playlist_t *content_playlist_init(const char *path, size_t size)
 {
+   char journal_path[PATH_MAX_LENGTH];
    content_playlist_t *playlist = (content_playlist_t*)
       calloc(1, sizeof(*playlist));
    if (!playlist)
@@ -316,9 +581,25 @@ content_playlist_t *content_playlist_init(const char *path, size_t size)
 
    playlist->cap = size;
 
+   /* Keep the index at most half full, so probe runs stay short. */
+   for (playlist->index_cap = 2; playlist->index_cap < size * 2; )
+      playlist->index_cap <<= 1;
+
+   playlist->index = (content_playlist_slot_t*)calloc(playlist->index_cap,
+         sizeof(*playlist->index));
+   if (!playlist->index)
+      goto error;
+
    content_playlist_read_file(playlist, path);
 
-   playlist->conf_path = strdup(path);
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", path);
+
+   playlist->conf_path    = strdup(path);
+   playlist->journal_path = strdup(journal_path);
+   if (!playlist->conf_path || !playlist->journal_path)
+      goto error;
+
+   content_playlist_read_journal(playlist);
    return playlist;
 
 error:
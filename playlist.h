@@ -19,6 +19,8 @@
 #define CONTENT_HISTORY_H__
 
 #include <stddef.h>
+#include <stdint.h>
+#include <boolean.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,15 +31,36 @@ typedef struct content_playlist_entry
    char *path;
    char *core_path;
    char *core_name;
+
+   /* Order of the entry, higher is closer to the top. */
+   size_t seq;
 } content_playlist_entry_t;
 
+typedef struct content_playlist_slot
+{
+   uint32_t hash;
+   /* seq of the entry plus one, zero if the slot is empty. */
+   size_t seq;
+} content_playlist_slot_t;
+
 typedef struct content_playlist
 {
    struct content_playlist_entry *entries;
    size_t size;
    size_t cap;
 
+   /* Hash of entry paths, open addressed. */
+   content_playlist_slot_t *index;
+   size_t index_cap;
+   size_t seq;
+
    char *conf_path;
+
+   /* Entries pushed since conf_path was last written are
+    * appended here, so a push doesn't rewrite the whole file. */
+   char *journal_path;
+   unsigned journal_size;
+   bool modified;
 } content_playlist_t;
 
 /**
@@ -98,12 +121,25 @@ void content_playlist_get_index(content_playlist_t *playlist,
  * @core_path           : Core path of new playlist entry.
  * @core_name           : Core name of new playlist entry.
  *
- * Push entry to top of playlist.
+ * Push entry to top of playlist. The entry is appended to the
+ * journal of the playlist file, which gets folded back into the
+ * file once it is long enough or the playlist is freed.
  **/
 void content_playlist_push(content_playlist_t *playlist,
       const char *path, const char *core_path,
       const char *core_name);
 
+/**
+ * content_playlist_get_index_by_path:
+ * @playlist        	   : Playlist handle.
+ * @search_path         : Path of playlist entry to look for.
+ * @path                : Path of playlist entry.
+ * @core_path           : Core path of playlist entry.
+ * @core_name           : Core name of playlist entry.
+ *
+ * Gets values of the topmost playlist entry with @search_path,
+ * if there is one.
+ **/
 void content_playlist_get_index_by_path(content_playlist_t *playlist,
       const char *search_path,
       char **path, char **core_path,
@@ -51,5 +51,9 @@ HAVE_SSE=no             # Forcefully enable x86 SSE optimizations (SSE, SSE2)
 HAVE_FLOATHARD=no       # Force hard float ABI (for ARM)
 HAVE_FLOATSOFTFP=no     # Force soft float ABI (for ARM)
 HAVE_7ZIP=yes           # Compile in 7z support
+HAVE_LIBCO=yes          # Compile in libco, to run cores on a coroutine
+HAVE_RALLOC_STATS=no    # Track frontend memory use per subsystem
 HAVE_PRESERVE_DYLIB=no  # Disable dlclose() for Valgrind support
 HAVE_PARPORT=auto       # Parallel port joypad support
+HAVE_IO_URING=auto      # Asynchronous file loading with io_uring (Linux)
+HAVE_SHM=auto           # Export frames and core memory to POSIX shared memory
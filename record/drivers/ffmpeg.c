@@ -47,6 +47,7 @@ extern "C" {
 #include <queues/fifo_buffer.h>
 #include <rthreads/rthreads.h>
 #include "../../general.h"
+#include "../../performance.h"
 #include <gfx/scaler/scaler.h>
 #include <file/config_file.h>
 #include "../../audio/audio_utils.h"
@@ -82,6 +83,14 @@ struct ff_video_info
    unsigned frame_drop_ratio;
    unsigned frame_drop_count;
 
+   /* Frames dropped since the last one queued, the thread 
+    * repeats the previous frame in their place. */
+   unsigned dropped_pending;
+   uint64_t frames;
+   uint64_t dropped;
+   /* Running average of the time taken to encode a frame. */
+   volatile unsigned encode_usec;
+
    /* Input pixel size. */
    size_t pix_size;
 
@@ -151,6 +160,11 @@ struct ff_config_param
    unsigned scale_factor;
 
    bool audio_enable;
+   /* Drop frames instead of stalling the emulator 
+    * when the encoder falls behind. */
+   bool drop_frames;
+   /* Try hardware video encoders before software ones. */
+   bool hw_encoder;
    /* Keep same naming conventions as libavcodec. */
    bool audio_qscale;
    int audio_global_quality;
@@ -184,6 +198,9 @@ typedef struct ffmpeg
    volatile bool can_sleep;
 } ffmpeg_t;
 
+/* Registered from ffmpeg_new(), as it runs on the encoder thread. */
+static struct retro_perf_counter ffmpeg_encode_video = {"ffmpeg_encode_video"};
+
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
       const enum AVSampleFormat *fmts)
 {
@@ -306,7 +323,8 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
       rarch_resampler_realloc(&audio->resampler_data,
             &audio->resampler,
             settings->audio.resampler,
-            audio->ratio);
+            audio->ratio,
+            (enum resampler_quality)settings->audio.resampler_quality);
    }
    else
    {
@@ -355,30 +373,41 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
    return true;
 }
 
-static bool ffmpeg_init_video(ffmpeg_t *handle)
+/* Hardware encoders to try, in order, with hw_encoder = true.
+ * They take frames from system memory. VAAPI is left out
+ * as it only takes frames uploaded to the GPU beforehand. */
+static const char *ffmpeg_hw_encoders[] = {
+#if defined(__APPLE__)
+   "h264_videotoolbox",
+#else
+   "h264_nvenc",
+   "h264_qsv",
+#if defined(_WIN32)
+   "h264_amf",
+#endif
+#endif
+   NULL
+};
+
+static bool ffmpeg_codec_has_pix_fmt(enum PixelFormat fmt,
+      const enum PixelFormat *fmts)
 {
-   struct ff_config_param *params = &handle->config;
-   struct ff_video_info *video    = &handle->video;
-   struct ffemu_params *param     = &handle->params;
-   AVCodec *codec = NULL;
+   unsigned i;
 
-   if (*params->vcodec)
-      codec = avcodec_find_encoder_by_name(params->vcodec);
-   else
-   {
-      /* By default, lossless video. */
-      av_dict_set(&params->video_opts, "qp", "0", 0);
-      codec = avcodec_find_encoder_by_name("libx264rgb");
-   }
+   /* Codec takes any format. */
+   if (!fmts)
+      return true;
 
-   if (!codec)
-   {
-      RARCH_ERR("[FFmpeg]: Cannot find vcodec %s.\n",
-            *params->vcodec ? params->vcodec : "libx264rgb");
-      return false;
-   }
+   for (i = 0; fmts[i] != PIX_FMT_NONE; i++)
+      if (fmt == fmts[i])
+         return true;
+   return false;
+}
 
-   video->encoder = codec;
+static void ffmpeg_video_resolve_format(struct ff_video_info *video,
+      const AVCodec *codec, enum PixelFormat out_pix_fmt)
+{
+   video->use_sws = false;
 
    /* Don't use swscaler unless format is not something "in-house" scaler
     * supports.
@@ -387,9 +416,9 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
     * and it's non-trivial to fix upstream as it's heavily geared towards YUV.
     * If we're dealing with strange formats or YUV, just use libswscale.
     */
-   if (params->out_pix_fmt != PIX_FMT_NONE)
+   if (out_pix_fmt != PIX_FMT_NONE)
    {
-      video->pix_fmt = params->out_pix_fmt;
+      video->pix_fmt = out_pix_fmt;
       if (video->pix_fmt != PIX_FMT_BGR24 && video->pix_fmt != PIX_FMT_RGB32)
          video->use_sws = true;
 
@@ -407,11 +436,128 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
             break;
       }
    }
-   else /* Use BGR24 as default out format. */
+   else if (video->in_pix_fmt == PIX_FMT_YUV420P &&
+         ffmpeg_codec_has_pix_fmt(PIX_FMT_YUV420P, codec->pix_fmts))
    {
+      /* Already converted by the video driver, 
+       * libswscale only has to copy the planes. */
+      video->pix_fmt = PIX_FMT_YUV420P;
+      video->use_sws = true;
+   }
+   else if (ffmpeg_codec_has_pix_fmt(PIX_FMT_BGR24, codec->pix_fmts))
+   {
+      /* Use BGR24 as default out format. */
       video->pix_fmt        = PIX_FMT_BGR24;
       video->scaler.out_fmt = SCALER_FMT_BGR24;
    }
+   else
+   {
+      /* Hardware encoders mostly take NV12 or YUV420P only,
+       * use the first format the codec prefers. */
+      video->pix_fmt = codec->pix_fmts[0];
+      video->use_sws = true;
+   }
+
+   /* The in-house scaler only takes RGB. */
+   if (video->in_pix_fmt == PIX_FMT_YUV420P)
+      video->use_sws = true;
+}
+
+/**
+ * ffmpeg_video_frame_size:
+ * @video                : Video info.
+ * @pitch                : Pitch of the frame.
+ * @height               : Height of the frame.
+ *
+ * Returns: size in bytes of a tightly packed input frame,
+ * chroma planes included.
+ **/
+static size_t ffmpeg_video_frame_size(const struct ff_video_info *video,
+      size_t pitch, unsigned height)
+{
+   if (video->in_pix_fmt == PIX_FMT_YUV420P)
+      return pitch * height + pitch * height / 2;
+   return pitch * height;
+}
+
+/**
+ * ffmpeg_open_video:
+ * @handle               : FFmpeg handle.
+ * @codec                : Video encoder.
+ * @opts                 : Encoder options.
+ *
+ * Sets up and opens a video encoder context for @codec.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool ffmpeg_open_video(ffmpeg_t *handle, AVCodec *codec,
+      AVDictionary *opts)
+{
+   bool ret                       = false;
+   struct ff_config_param *params = &handle->config;
+   struct ff_video_info *video    = &handle->video;
+   struct ffemu_params *param     = &handle->params;
+   AVDictionary *codec_opts       = NULL;
+
+   /* avcodec_open2() takes out the options it used. */
+   if (opts)
+      av_dict_copy(&codec_opts, opts, 0);
+
+   ffmpeg_video_resolve_format(video, codec, params->out_pix_fmt);
+
+   video->codec = avcodec_alloc_context3(codec);
+   if (!video->codec)
+      goto end;
+
+   /* Useful to set scale_factor to 2 for chroma subsampled formats to
+    * maintain full chroma resolution. (Or just use 4:4:4 or RGB ...)
+    */
+   video->codec->codec_type          = AVMEDIA_TYPE_VIDEO;
+   video->codec->width               = param->out_width * params->scale_factor;
+   video->codec->height              = param->out_height * params->scale_factor;
+   video->codec->time_base           = av_d2q((double)
+         params->frame_drop_ratio /param->fps, 1000000); /* Arbitrary big number. */
+   video->codec->sample_aspect_ratio = av_d2q(
+         param->aspect_ratio * param->out_height / param->out_width, 255);
+   video->codec->pix_fmt             = video->pix_fmt;
+
+   video->codec->thread_count = params->threads;
+
+   if (params->video_qscale)
+   {
+      video->codec->flags |= CODEC_FLAG_QSCALE;
+      video->codec->global_quality = params->video_global_quality;
+   }
+   else if (params->video_bit_rate)
+      video->codec->bit_rate = params->video_bit_rate;
+
+   if (handle->muxer.ctx->oformat->flags & AVFMT_GLOBALHEADER)
+      video->codec->flags |= CODEC_FLAG_GLOBAL_HEADER;
+
+   if (avcodec_open2(video->codec, codec, codec_opts ?
+            &codec_opts : NULL) != 0)
+   {
+      av_free(video->codec);
+      video->codec = NULL;
+      goto end;
+   }
+
+   video->encoder = codec;
+   ret            = true;
+
+end:
+   if (codec_opts)
+      av_dict_free(&codec_opts);
+   return ret;
+}
+
+static bool ffmpeg_init_video(ffmpeg_t *handle)
+{
+   size_t size;
+   struct ff_config_param *params = &handle->config;
+   struct ff_video_info *video    = &handle->video;
+   struct ffemu_params *param     = &handle->params;
+   AVCodec *codec = NULL;
 
    switch (param->pix_fmt)
    {
@@ -433,43 +579,63 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
          video->pix_size      = 4;
          break;
 
+      case FFEMU_PIX_YUV420P:
+         /* pix_size is that of the Y plane. */
+         video->in_pix_fmt    = PIX_FMT_YUV420P;
+         video->pix_size      = 1;
+         break;
+
       default:
          return false;
    }
 
-   video->codec = avcodec_alloc_context3(codec);
+   if (!*params->vcodec && params->hw_encoder)
+   {
+      unsigned i;
 
-   /* Useful to set scale_factor to 2 for chroma subsampled formats to
-    * maintain full chroma resolution. (Or just use 4:4:4 or RGB ...)
-    */
-   param->out_width  *= params->scale_factor;
-   param->out_height *= params->scale_factor;
+      /* Encoders are built in whether or not there is hardware
+       * for them, only opening one tells if it works. */
+      for (i = 0; ffmpeg_hw_encoders[i]; i++)
+      {
+         codec = avcodec_find_encoder_by_name(ffmpeg_hw_encoders[i]);
 
-   video->codec->codec_type          = AVMEDIA_TYPE_VIDEO;
-   video->codec->width               = param->out_width;
-   video->codec->height              = param->out_height;
-   video->codec->time_base           = av_d2q((double)
-         params->frame_drop_ratio /param->fps, 1000000); /* Arbitrary big number. */
-   video->codec->sample_aspect_ratio = av_d2q(
-         param->aspect_ratio * param->out_height / param->out_width, 255);
-   video->codec->pix_fmt             = video->pix_fmt;
+         if (codec && ffmpeg_open_video(handle, codec, params->video_opts))
+         {
+            RARCH_LOG("[FFmpeg]: Using hardware encoder %s.\n",
+                  ffmpeg_hw_encoders[i]);
+            break;
+         }
+      }
 
-   video->codec->thread_count = params->threads;
+      if (!video->codec)
+         RARCH_WARN("[FFmpeg]: No hardware encoder available, "
+               "falling back to software encoding.\n");
+   }
 
-   if (params->video_qscale)
+   if (!video->codec)
    {
-      video->codec->flags |= CODEC_FLAG_QSCALE;
-      video->codec->global_quality = params->video_global_quality;
-   }
-   else if (params->video_bit_rate)
-      video->codec->bit_rate = params->video_bit_rate;
+      if (*params->vcodec)
+         codec = avcodec_find_encoder_by_name(params->vcodec);
+      else
+      {
+         /* By default, lossless video. */
+         av_dict_set(&params->video_opts, "qp", "0", 0);
+         codec = avcodec_find_encoder_by_name("libx264rgb");
+      }
 
-   if (handle->muxer.ctx->oformat->flags & AVFMT_GLOBALHEADER)
-      video->codec->flags |= CODEC_FLAG_GLOBAL_HEADER;
+      if (!codec)
+      {
+         RARCH_ERR("[FFmpeg]: Cannot find vcodec %s.\n",
+               *params->vcodec ? params->vcodec : "libx264rgb");
+         return false;
+      }
 
-   if (avcodec_open2(video->codec, codec, params->video_opts ?
-            &params->video_opts : NULL) != 0)
-      return false;
+      if (!ffmpeg_open_video(handle, codec, params->video_opts))
+         return false;
+   }
+
+   param->out_width  *= params->scale_factor;
+   param->out_height *= params->scale_factor;
 
    /* Allocate a big buffer. ffmpeg API doesn't seem to give us some
     * clues how big this buffer should be. */
@@ -478,7 +644,7 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 
    video->frame_drop_ratio = params->frame_drop_ratio;
 
-   size_t size = avpicture_get_size(video->pix_fmt, param->out_width,
+   size = avpicture_get_size(video->pix_fmt, param->out_width,
          param->out_height);
    video->conv_frame_buf = (uint8_t*)av_malloc(size);
    video->conv_frame = av_frame_alloc();
@@ -491,7 +657,8 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 static bool ffmpeg_init_config(struct ff_config_param *params,
       const char *config)
 {
-   char pix_fmt[64] = {0};
+   char pix_fmt[64]      = {0};
+   char queue_policy[64] = {0};
 
    params->out_pix_fmt = PIX_FMT_NONE;
    params->scale_factor = 1;
@@ -524,6 +691,18 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
    if (!config_get_bool(params->conf, "audio_enable", &params->audio_enable))
       params->audio_enable = true;
 
+   config_get_bool(params->conf, "hw_encoder", &params->hw_encoder);
+
+   if (config_get_array(params->conf, "queue_policy",
+            queue_policy, sizeof(queue_policy)))
+   {
+      if (!strcmp(queue_policy, "drop"))
+         params->drop_frames = true;
+      else if (strcmp(queue_policy, "block"))
+         RARCH_WARN("Unknown queue_policy \"%s\", blocking.\n",
+               queue_policy);
+   }
+
    config_get_uint(params->conf, "sample_rate", &params->sample_rate);
    config_get_uint(params->conf, "scale_factor", &params->scale_factor);
 
@@ -625,8 +804,9 @@ static bool init_thread(ffmpeg_t *handle)
    handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
    handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+   handle->video_fifo = fifo_new(ffmpeg_video_frame_size(&handle->video,
+            handle->params.fb_width * handle->video.pix_size,
+            handle->params.fb_height) * MAX_FRAMES);
 
    handle->alive = true;
    handle->can_sleep = true;
@@ -742,6 +922,9 @@ static void *ffmpeg_new(const struct ffemu_params *params)
 
    handle->params = *params;
 
+   if (!ffmpeg_encode_video.registered)
+      rarch_perf_register(&ffmpeg_encode_video);
+
    if (!ffmpeg_init_config(&handle->config, params->config))
       goto error;
 
@@ -778,6 +961,8 @@ static bool ffmpeg_push_video(void *data,
    if (!handle || !video_data)
       return false;
 
+   RARCH_PERFORMANCE_INIT(ffmpeg_push_video_wait);
+
    drop_frame = handle->video.frame_drop_count++ %
       handle->video.frame_drop_ratio;
 
@@ -796,9 +981,24 @@ static bool ffmpeg_push_video(void *data,
       if (!handle->alive)
          return false;
 
-      if (avail >= sizeof(*video_data))
+      /* Room for the frame and for the repeats 
+       * standing in for frames dropped before it. */
+      if (avail >= (handle->video.dropped_pending + 1) * sizeof(*video_data))
          break;
 
+      /* Block anyway once the repeats would fill the queue. */
+      if (handle->config.drop_frames &&
+            handle->video.dropped_pending + 1 < MAX_FRAMES)
+      {
+         handle->video.dropped_pending++;
+         handle->video.dropped++;
+         handle->video.frames++;
+         scond_signal(handle->cond);
+         return true;
+      }
+
+      /* Time the emulator is stalled waiting for the encoder. */
+      RARCH_PERFORMANCE_START(ffmpeg_push_video_wait);
       slock_lock(handle->cond_lock);
       if (handle->can_sleep)
       {
@@ -810,10 +1010,20 @@ static bool ffmpeg_push_video(void *data,
          scond_signal(handle->cond);
 
       slock_unlock(handle->cond_lock);
+      RARCH_PERFORMANCE_STOP(ffmpeg_push_video_wait);
    }
 
    slock_lock(handle->lock);
 
+   for (; handle->video.dropped_pending; handle->video.dropped_pending--)
+   {
+      struct ffemu_video_data repeat = {0};
+      repeat.is_dupe = true;
+      fifo_write(handle->attr_fifo, &repeat, sizeof(repeat));
+   }
+
+   handle->video.frames++;
+
    /* Tightly pack our frame to conserve memory.
     * libretro tends to use a very large pitch.
     */
@@ -826,10 +1036,20 @@ static bool ffmpeg_push_video(void *data,
 
    fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
 
-   int offset = 0;
-   for (y = 0; y < attr_data.height; y++, offset += video_data->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)video_data->data + offset, attr_data.pitch);
+   if (handle->video.in_pix_fmt == PIX_FMT_YUV420P)
+   {
+      /* Planes are tightly packed already. */
+      fifo_write(handle->video_fifo, video_data->data,
+            ffmpeg_video_frame_size(&handle->video,
+               attr_data.pitch, attr_data.height));
+   }
+   else
+   {
+      int offset = 0;
+      for (y = 0; y < attr_data.height; y++, offset += video_data->pitch)
+         fifo_write(handle->video_fifo,
+               (const uint8_t*)video_data->data + offset, attr_data.pitch);
+   }
 
    slock_unlock(handle->lock);
    scond_signal(handle->cond);
@@ -934,9 +1154,18 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
             handle->video.pix_fmt,
             shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
 
-      int linesize = data->pitch;
-      sws_scale(handle->video.sws, (const uint8_t* const*)&data->data,
-            &linesize, 0, data->height, handle->video.conv_frame->data,
+      const uint8_t *planes[4] = { (const uint8_t*)data->data };
+      int linesize[4]          = { data->pitch };
+
+      if (handle->video.in_pix_fmt == PIX_FMT_YUV420P)
+      {
+         planes[1]   = planes[0] + data->pitch * data->height;
+         planes[2]   = planes[1] + data->pitch * data->height / 4;
+         linesize[1] = linesize[2] = data->pitch / 2;
+      }
+
+      sws_scale(handle->video.sws, planes,
+            linesize, 0, data->height, handle->video.conv_frame->data,
             handle->video.conv_frame->linesize);
    }
    else
@@ -949,7 +1178,7 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
          handle->video.scaler.in_stride = data->pitch;
 
          handle->video.scaler.scaler_type = shrunk ?
-            SCALER_TYPE_BILINEAR : SCALER_TYPE_POINT;
+            SCALER_TYPE_LANCZOS3 : SCALER_TYPE_POINT;
 
          handle->video.scaler.out_width  = handle->params.out_width;
          handle->video.scaler.out_height = handle->params.out_height;
@@ -968,6 +1197,9 @@ static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
       const struct ffemu_video_data *data)
 {
    AVPacket pkt;
+   retro_time_t start = rarch_get_time_usec();
+
+   RARCH_PERFORMANCE_START(ffmpeg_encode_video);
 
    if (!data->is_dupe)
       ffmpeg_scale_input(handle, data);
@@ -983,6 +1215,10 @@ static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
          return false;
    }
 
+   RARCH_PERFORMANCE_STOP(ffmpeg_encode_video);
+
+   handle->video.encode_usec = (handle->video.encode_usec * 7 +
+         (unsigned)(rarch_get_time_usec() - start)) / 8;
    handle->video.frame_cnt++;
    return true;
 }
@@ -1292,7 +1528,8 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
       {
          fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
          fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
+               ffmpeg_video_frame_size(&handle->video,
+                  attr_buf.pitch, attr_buf.height));
          attr_buf.data = video_buf;
          ffmpeg_push_video_thread(handle, &attr_buf);
 
@@ -1323,6 +1560,12 @@ static bool ffmpeg_finalize(void *data)
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
    ffmpeg_flush_buffers(handle);
 
+   if (handle->video.dropped)
+      RARCH_WARN("[FFmpeg]: Dropped %llu of %llu video frames, "
+            "the encoder could not keep up.\n",
+            (unsigned long long)handle->video.dropped,
+            (unsigned long long)handle->video.frames);
+
    deinit_thread_buf(handle);
 
    /* Write final data. */
@@ -1381,7 +1624,8 @@ static void ffmpeg_thread(void *data)
          slock_lock(ff->lock);
          fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
          fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
+               ffmpeg_video_frame_size(&ff->video,
+                  attr_buf.pitch, attr_buf.height));
          slock_unlock(ff->lock);
          scond_signal(ff->cond);
 
@@ -1408,12 +1652,28 @@ static void ffmpeg_thread(void *data)
    av_free(audio_buf);
 }
 
+static void ffmpeg_get_stats(void *data, struct ffemu_stats *stats)
+{
+   ffmpeg_t *handle = (ffmpeg_t*)data;
+
+   slock_lock(handle->lock);
+   stats->queued = fifo_read_avail(handle->attr_fifo) /
+      sizeof(struct ffemu_video_data);
+   slock_unlock(handle->lock);
+
+   stats->queue_size  = MAX_FRAMES;
+   stats->frames      = handle->video.frames;
+   stats->dropped     = handle->video.dropped;
+   stats->encode_usec = handle->video.encode_usec;
+}
+
 const record_driver_t ffemu_ffmpeg = {
    ffmpeg_new,
    ffmpeg_free,
    ffmpeg_push_video,
    ffmpeg_push_audio,
    ffmpeg_finalize,
+   ffmpeg_get_stats,
    "ffmpeg",
 };
 
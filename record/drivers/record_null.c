@@ -58,5 +58,6 @@ const record_driver_t ffemu_null = {
    record_null_push_video,
    record_null_push_audio,
    record_null_finalize,
+   NULL,
    "null",
 };
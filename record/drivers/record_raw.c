@@ -0,0 +1,629 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compat/msvc.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+/* Written through a file descriptor, preallocated and
+ * bypassing the page cache where the filesystem allows. */
+#define RECORD_RAW_FD
+#endif
+
+#include "../../general.h"
+#include "../../performance.h"
+#include "../record_driver.h"
+
+/* Raw dump format, all fields in host byte order:
+ *
+ * struct raw_dump_header, then packets until the end of the file
+ * or a packet of type 0 (a preallocated tail left by a crash).
+ * Each packet is a struct raw_dump_packet followed by @size bytes.
+ *
+ * Video packets hold the frame as delivered, in the pixel format
+ * of the header, rows packed top-down. Dupe packets repeat the
+ * previous frame. Audio packets hold interleaved signed 16-bit
+ * samples. tools/rawdump2video.py transcodes a dump with ffmpeg. */
+
+#define RAW_DUMP_MAGIC   "RARAWDMP"
+#define RAW_DUMP_VERSION 1
+
+/* Data goes to disk in blocks of this size, taken from a ring
+ * buffer which lets emulation run ahead of the disk. */
+#define RAW_DUMP_BLOCK_SIZE   (4 << 20)
+#define RAW_DUMP_BLOCKS       16
+#define RAW_DUMP_BUFFER_SIZE  (RAW_DUMP_BLOCK_SIZE * RAW_DUMP_BLOCKS)
+
+/* O_DIRECT alignment of buffers, offsets and sizes. */
+#define RAW_DUMP_ALIGN        4096
+/* Disk space reserved ahead of the write position. */
+#define RAW_DUMP_PREALLOC     ((off_t)256 << 20)
+
+enum raw_dump_packet_type
+{
+   RAW_DUMP_PACKET_VIDEO = 1,
+   RAW_DUMP_PACKET_DUPE,
+   RAW_DUMP_PACKET_AUDIO
+};
+
+struct raw_dump_header
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t header_size;
+   double fps;
+   double samplerate;
+   uint32_t channels;
+   uint32_t pix_fmt;
+   uint32_t width;
+   uint32_t height;
+   float aspect_ratio;
+   uint32_t reserved[5];
+};
+
+struct raw_dump_packet
+{
+   uint32_t type;
+   uint32_t size;
+   /* Frame size for video, sample frames for audio. */
+   uint32_t width;
+   uint32_t height;
+   uint32_t pitch;
+   uint32_t reserved;
+};
+
+typedef struct raw_dump
+{
+#ifdef RECORD_RAW_FD
+   int fd;
+   bool direct;
+   off_t prealloc;
+#else
+   FILE *file;
+#endif
+
+   uint8_t *buffer;
+   /* Bytes queued and bytes written. Only the writer moves
+    * @tail, only the pushing thread moves @head. */
+   uint64_t head;
+   uint64_t tail;
+
+   enum ffemu_pix_format pix_fmt;
+   unsigned bpp;
+   unsigned channels;
+
+   uint64_t frames;
+   uint64_t stalls;
+   retro_time_t write_usec;
+   bool failed;
+   bool finalized;
+
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool finishing;
+#endif
+} raw_dump_t;
+
+static bool raw_dump_write(raw_dump_t *dump, const uint8_t *data, size_t size)
+{
+   bool ret         = true;
+   retro_time_t start = rarch_get_time_usec();
+
+#ifdef RECORD_RAW_FD
+   off_t offset     = dump->tail;
+
+   if (dump->prealloc && offset + (off_t)size > dump->prealloc)
+   {
+      /* Fails harmlessly where the filesystem can't do it. */
+      if (posix_fallocate(dump->fd, dump->prealloc, RAW_DUMP_PREALLOC) == 0)
+         dump->prealloc += RAW_DUMP_PREALLOC;
+      else
+         dump->prealloc  = 0;
+   }
+
+   while (size)
+   {
+      ssize_t written = pwrite(dump->fd, data, size, offset);
+
+      if (written < 0 && errno == EINTR)
+         continue;
+#ifdef O_DIRECT
+      if (written < 0 && errno == EINVAL && dump->direct)
+      {
+         /* Some filesystems take O_DIRECT at open time only. */
+         dump->direct = false;
+         fcntl(dump->fd, F_SETFL, fcntl(dump->fd, F_GETFL) & ~O_DIRECT);
+         continue;
+      }
+#endif
+      if (written <= 0)
+      {
+         ret = false;
+         break;
+      }
+
+      data   += written;
+      offset += written;
+      size   -= written;
+   }
+#else
+   ret = fwrite(data, 1, size, dump->file) == size;
+#endif
+
+   dump->write_usec += rarch_get_time_usec() - start;
+
+   if (!ret && !dump->failed)
+   {
+      RARCH_ERR("[raw]: Failed to write to the dump, disk full?\n");
+      dump->failed = true;
+   }
+
+   return ret;
+}
+
+/* Writes the last, partial block. */
+static void raw_dump_write_tail(raw_dump_t *dump)
+{
+   size_t size   = dump->head - dump->tail;
+   uint8_t *data = dump->buffer + dump->tail % RAW_DUMP_BUFFER_SIZE;
+
+#ifdef RECORD_RAW_FD
+   if (dump->direct)
+   {
+      /* O_DIRECT needs whole sectors, the padding is cut off below. */
+      size_t padded = (size + RAW_DUMP_ALIGN - 1) & ~(RAW_DUMP_ALIGN - 1);
+      memset(data + size, 0, padded - size);
+      raw_dump_write(dump, data, padded);
+   }
+   else
+#endif
+      raw_dump_write(dump, data, size);
+
+   dump->tail = dump->head;
+
+#ifdef RECORD_RAW_FD
+   /* Drops the preallocated space and the padding. */
+   if (ftruncate(dump->fd, dump->head) != 0)
+      RARCH_WARN("[raw]: Failed to truncate the dump.\n");
+#endif
+}
+
+#ifdef HAVE_THREADS
+static void raw_dump_thread(void *data)
+{
+   raw_dump_t *dump = (raw_dump_t*)data;
+
+   slock_lock(dump->lock);
+
+   for (;;)
+   {
+      const uint8_t *block;
+
+      while (!dump->finishing
+            && dump->head - dump->tail < RAW_DUMP_BLOCK_SIZE)
+         scond_wait(dump->cond, dump->lock);
+
+      if (dump->head - dump->tail < RAW_DUMP_BLOCK_SIZE)
+         break;
+
+      block = dump->buffer + dump->tail % RAW_DUMP_BUFFER_SIZE;
+
+      slock_unlock(dump->lock);
+      raw_dump_write(dump, block, RAW_DUMP_BLOCK_SIZE);
+      slock_lock(dump->lock);
+
+      dump->tail += RAW_DUMP_BLOCK_SIZE;
+      scond_signal(dump->cond);
+   }
+
+   slock_unlock(dump->lock);
+}
+#endif
+
+/* Waits for room for @size more bytes in the ring buffer. */
+static bool raw_dump_reserve(raw_dump_t *dump, size_t size)
+{
+   if (size > RAW_DUMP_BUFFER_SIZE)
+      return false;
+
+#ifdef HAVE_THREADS
+   if (dump->thread)
+   {
+      slock_lock(dump->lock);
+      if (RAW_DUMP_BUFFER_SIZE - (dump->head - dump->tail) < size)
+      {
+         /* Only happens when the disk can't keep up. */
+         dump->stalls++;
+         while (RAW_DUMP_BUFFER_SIZE - (dump->head - dump->tail) < size)
+            scond_wait(dump->cond, dump->lock);
+      }
+      slock_unlock(dump->lock);
+      return true;
+   }
+#endif
+
+   while (RAW_DUMP_BUFFER_SIZE - (dump->head - dump->tail) < size)
+   {
+      raw_dump_write(dump, dump->buffer + dump->tail % RAW_DUMP_BUFFER_SIZE,
+            RAW_DUMP_BLOCK_SIZE);
+      dump->tail += RAW_DUMP_BLOCK_SIZE;
+   }
+
+   return true;
+}
+
+/* Copies into the ring buffer at @pos, past the queued data. */
+static void raw_dump_copy(raw_dump_t *dump, uint64_t *pos,
+      const void *data, size_t size)
+{
+   const uint8_t *src = (const uint8_t*)data;
+
+   while (size)
+   {
+      size_t offset = *pos % RAW_DUMP_BUFFER_SIZE;
+      size_t chunk  = RAW_DUMP_BUFFER_SIZE - offset;
+
+      if (chunk > size)
+         chunk = size;
+
+      memcpy(dump->buffer + offset, src, chunk);
+      src  += chunk;
+      *pos += chunk;
+      size -= chunk;
+   }
+}
+
+static void raw_dump_commit(raw_dump_t *dump, uint64_t pos)
+{
+#ifdef HAVE_THREADS
+   if (dump->thread)
+   {
+      slock_lock(dump->lock);
+      dump->head = pos;
+      scond_signal(dump->cond);
+      slock_unlock(dump->lock);
+      return;
+   }
+#endif
+
+   dump->head = pos;
+}
+
+static bool raw_dump_open(raw_dump_t *dump, const char *path)
+{
+#ifdef RECORD_RAW_FD
+#ifdef O_DIRECT
+   dump->fd     = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+   dump->direct = dump->fd >= 0;
+   if (dump->fd < 0)
+#endif
+      dump->fd  = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+   if (dump->fd < 0)
+      return false;
+
+   dump->prealloc = 0;
+   if (posix_fallocate(dump->fd, 0, RAW_DUMP_PREALLOC) == 0)
+      dump->prealloc = RAW_DUMP_PREALLOC;
+#else
+   dump->file = fopen(path, "wb");
+   if (!dump->file)
+      return false;
+   setvbuf(dump->file, NULL, _IONBF, 0);
+#endif
+
+   return true;
+}
+
+static void raw_dump_close(raw_dump_t *dump)
+{
+#ifdef RECORD_RAW_FD
+   if (dump->fd >= 0)
+      close(dump->fd);
+   dump->fd = -1;
+#else
+   if (dump->file)
+      fclose(dump->file);
+   dump->file = NULL;
+#endif
+}
+
+static bool record_raw_finalize(void *data)
+{
+   raw_dump_t *dump = (raw_dump_t*)data;
+
+   if (!dump || dump->finalized)
+      return false;
+
+#ifdef HAVE_THREADS
+   if (dump->thread)
+   {
+      slock_lock(dump->lock);
+      dump->finishing = true;
+      scond_signal(dump->cond);
+      slock_unlock(dump->lock);
+
+      sthread_join(dump->thread);
+      dump->thread = NULL;
+   }
+#endif
+
+   while (dump->head - dump->tail >= RAW_DUMP_BLOCK_SIZE)
+   {
+      raw_dump_write(dump, dump->buffer + dump->tail % RAW_DUMP_BUFFER_SIZE,
+            RAW_DUMP_BLOCK_SIZE);
+      dump->tail += RAW_DUMP_BLOCK_SIZE;
+   }
+   raw_dump_write_tail(dump);
+   raw_dump_close(dump);
+
+   RARCH_LOG("[raw]: Dumped %llu frames, %llu MiB. "
+         "Waited for the disk %llu times.\n",
+         (unsigned long long)dump->frames,
+         (unsigned long long)(dump->head >> 20),
+         (unsigned long long)dump->stalls);
+
+   dump->finalized = true;
+   return !dump->failed;
+}
+
+static void record_raw_free(void *data)
+{
+   raw_dump_t *dump = (raw_dump_t*)data;
+
+   if (!dump)
+      return;
+
+   record_raw_finalize(dump);
+
+#ifdef HAVE_THREADS
+   if (dump->lock)
+      slock_free(dump->lock);
+   if (dump->cond)
+      scond_free(dump->cond);
+#endif
+
+#if defined(RECORD_RAW_FD)
+   free(dump->buffer);
+#elif defined(_WIN32)
+   _aligned_free(dump->buffer);
+#else
+   free(dump->buffer);
+#endif
+   free(dump);
+}
+
+static void *record_raw_new(const struct ffemu_params *params)
+{
+   struct raw_dump_header header = {{0}};
+   uint64_t pos                  = 0;
+   raw_dump_t *dump              = (raw_dump_t*)calloc(1, sizeof(*dump));
+
+   if (!dump)
+      return NULL;
+
+#ifdef RECORD_RAW_FD
+   dump->fd = -1;
+   if (posix_memalign((void**)&dump->buffer,
+            RAW_DUMP_ALIGN, RAW_DUMP_BUFFER_SIZE) != 0)
+      dump->buffer = NULL;
+#elif defined(_WIN32)
+   dump->buffer = (uint8_t*)_aligned_malloc(RAW_DUMP_BUFFER_SIZE, RAW_DUMP_ALIGN);
+#else
+   dump->buffer = (uint8_t*)malloc(RAW_DUMP_BUFFER_SIZE);
+#endif
+
+   if (!dump->buffer)
+      goto error;
+
+   switch (params->pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         dump->bpp = 2;
+         break;
+      case FFEMU_PIX_BGR24:
+         dump->bpp = 3;
+         break;
+      case FFEMU_PIX_ARGB8888:
+         dump->bpp = 4;
+         break;
+      case FFEMU_PIX_YUV420P:
+         /* Packed as a whole, see record_raw_push_video(). */
+         dump->bpp = 1;
+         break;
+   }
+
+   dump->pix_fmt  = params->pix_fmt;
+   dump->channels = params->channels;
+
+   if (!raw_dump_open(dump, params->filename))
+   {
+      RARCH_ERR("[raw]: Failed to open \"%s\".\n", params->filename);
+      goto error;
+   }
+
+   memcpy(header.magic, RAW_DUMP_MAGIC, sizeof(header.magic));
+   header.version      = RAW_DUMP_VERSION;
+   header.header_size  = sizeof(header);
+   header.fps          = params->fps;
+   header.samplerate   = params->samplerate;
+   header.channels     = params->channels;
+   header.pix_fmt      = params->pix_fmt;
+   header.width        = params->out_width;
+   header.height       = params->out_height;
+   header.aspect_ratio = params->aspect_ratio;
+
+   raw_dump_copy(dump, &pos, &header, sizeof(header));
+   raw_dump_commit(dump, pos);
+
+#ifdef HAVE_THREADS
+   dump->lock   = slock_new();
+   dump->cond   = scond_new();
+   if (dump->lock && dump->cond)
+      dump->thread = sthread_create(raw_dump_thread, dump);
+   if (!dump->thread)
+      RARCH_WARN("[raw]: Failed to start the writer thread, writing synchronously.\n");
+#endif
+
+   RARCH_LOG("[raw]: Dumping to \"%s\"%s.\n", params->filename,
+#ifdef RECORD_RAW_FD
+         dump->direct ? " with O_DIRECT" : ""
+#else
+         ""
+#endif
+         );
+
+   return dump;
+
+error:
+   record_raw_free(dump);
+   return NULL;
+}
+
+static bool record_raw_push_video(void *data,
+      const struct ffemu_video_data *video_data)
+{
+   unsigned y;
+   size_t line_size;
+   struct raw_dump_packet packet = {0};
+   raw_dump_t *dump              = (raw_dump_t*)data;
+   uint64_t pos;
+
+   if (!dump || dump->finalized)
+      return false;
+
+   dump->frames++;
+
+   if (video_data->is_dupe || !video_data->data)
+   {
+      packet.type = RAW_DUMP_PACKET_DUPE;
+      line_size   = 0;
+   }
+   else
+   {
+      packet.type   = RAW_DUMP_PACKET_VIDEO;
+      packet.width  = video_data->width;
+      packet.height = video_data->height;
+      line_size     = video_data->width * dump->bpp;
+      packet.pitch  = line_size;
+      packet.size   = line_size * video_data->height;
+
+      /* The planes are back to back already. */
+      if (dump->pix_fmt == FFEMU_PIX_YUV420P)
+         packet.size = packet.size * 3 / 2;
+   }
+
+   if (!raw_dump_reserve(dump, sizeof(packet) + packet.size))
+      return false;
+
+   pos = dump->head;
+   raw_dump_copy(dump, &pos, &packet, sizeof(packet));
+
+   if (packet.type == RAW_DUMP_PACKET_VIDEO)
+   {
+      if (dump->pix_fmt == FFEMU_PIX_YUV420P)
+         raw_dump_copy(dump, &pos, video_data->data, packet.size);
+      else
+      {
+         const uint8_t *src = (const uint8_t*)video_data->data;
+
+         for (y = 0; y < video_data->height; y++, src += video_data->pitch)
+            raw_dump_copy(dump, &pos, src, line_size);
+      }
+   }
+
+   raw_dump_commit(dump, pos);
+   return true;
+}
+
+static bool record_raw_push_audio(void *data,
+      const struct ffemu_audio_data *audio_data)
+{
+   struct raw_dump_packet packet = {0};
+   raw_dump_t *dump              = (raw_dump_t*)data;
+   uint64_t pos;
+
+   if (!dump || dump->finalized || !audio_data->frames)
+      return false;
+
+   packet.type  = RAW_DUMP_PACKET_AUDIO;
+   packet.width = audio_data->frames;
+   packet.size  = audio_data->frames * dump->channels * sizeof(int16_t);
+
+   if (!raw_dump_reserve(dump, sizeof(packet) + packet.size))
+      return false;
+
+   pos = dump->head;
+   raw_dump_copy(dump, &pos, &packet, sizeof(packet));
+   raw_dump_copy(dump, &pos, audio_data->data, packet.size);
+   raw_dump_commit(dump, pos);
+
+   return true;
+}
+
+static void record_raw_get_stats(void *data, struct ffemu_stats *stats)
+{
+   raw_dump_t *dump = (raw_dump_t*)data;
+   uint64_t queued;
+
+   if (!dump)
+      return;
+
+#ifdef HAVE_THREADS
+   if (dump->thread)
+      slock_lock(dump->lock);
+#endif
+   queued = dump->head - dump->tail;
+#ifdef HAVE_THREADS
+   if (dump->thread)
+      slock_unlock(dump->lock);
+#endif
+
+   stats->queued      = (queued + RAW_DUMP_BLOCK_SIZE - 1) / RAW_DUMP_BLOCK_SIZE;
+   stats->queue_size  = RAW_DUMP_BLOCKS;
+   stats->frames      = dump->frames;
+   stats->dropped     = 0;
+   /* Disk time per frame, it is never spent on this thread
+    * unless the buffer fills up. */
+   stats->encode_usec = dump->frames ? dump->write_usec / dump->frames : 0;
+}
+
+const record_driver_t ffemu_raw = {
+   record_raw_new,
+   record_raw_free,
+   record_raw_push_video,
+   record_raw_push_audio,
+   record_raw_finalize,
+   record_raw_get_stats,
+   "raw",
+};
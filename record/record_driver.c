@@ -35,6 +35,7 @@ static const record_driver_t *record_drivers[] = {
 #ifdef HAVE_FFMPEG
    &ffemu_ffmpeg,
 #endif
+   &ffemu_raw,
    &ffemu_null,
    NULL,
 };
@@ -163,12 +164,13 @@ const record_driver_t *ffemu_find_backend(const char *ident)
 
 
 /**
- * gfx_ctx_init_first:
+ * record_driver_init_first:
  * @backend                 : Recording backend handle.
  * @data                    : Recording data handle.
  * @params                  : Recording info parameters.
  *
- * Finds first suitable recording context driver and initializes.
+ * Initializes the configured recording driver, or else the
+ * first suitable one. Raw dumps are only made when asked for.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
@@ -176,10 +178,29 @@ bool record_driver_init_first(const record_driver_t **backend, void **data,
       const struct ffemu_params *params)
 {
    unsigned i;
+   settings_t *settings       = config_get_ptr();
+   const record_driver_t *drv = ffemu_find_backend(settings->record.driver);
+
+   if (drv)
+   {
+      void *handle = drv->init(params);
+
+      if (handle)
+      {
+         *backend = drv;
+         *data    = handle;
+         return true;
+      }
+   }
 
    for (i = 0; record_drivers[i]; i++)
    {
-      void *handle = record_drivers[i]->init(params);
+      void *handle;
+
+      if (record_drivers[i] == drv || record_drivers[i] == &ffemu_raw)
+         continue;
+
+      handle = record_drivers[i]->init(params);
 
       if (!handle)
          continue;
@@ -192,6 +213,52 @@ bool record_driver_init_first(const record_driver_t **backend, void **data,
    return false;
 }
 
+/* Frames between checks of the encoder backpressure. */
+#define RECORDING_STATS_INTERVAL 60
+
+static unsigned recording_stats_frames;
+static uint64_t recording_stats_dropped;
+
+/**
+ * recording_check_stats:
+ *
+ * Warns on screen when the encoder falls behind, so long
+ * recordings that drop frames or stall the emulator
+ * don't go unnoticed.
+ **/
+static void recording_check_stats(void)
+{
+   char msg[256]            = {0};
+   struct ffemu_stats stats = {0};
+   driver_t *driver         = driver_get_ptr();
+
+   if (!driver->recording || !driver->recording->get_stats)
+      return;
+
+   if (++recording_stats_frames < RECORDING_STATS_INTERVAL)
+      return;
+   recording_stats_frames = 0;
+
+   driver->recording->get_stats(driver->recording_data, &stats);
+
+   if (stats.dropped > recording_stats_dropped)
+      snprintf(msg, sizeof(msg),
+            "Recording fell behind, %llu of %llu frames dropped (%.1f ms per frame).",
+            (unsigned long long)stats.dropped,
+            (unsigned long long)stats.frames,
+            stats.encode_usec / 1000.0f);
+   else if (stats.queued >= stats.queue_size * 3 / 4)
+      snprintf(msg, sizeof(msg),
+            "Recording is falling behind, %u of %u frames queued (%.1f ms per frame).",
+            stats.queued, stats.queue_size,
+            stats.encode_usec / 1000.0f);
+
+   recording_stats_dropped = stats.dropped;
+
+   if (*msg)
+      rarch_main_msg_queue_push(msg, 1, 180, false);
+}
+
 void recording_dump_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
@@ -234,19 +301,33 @@ void recording_dump_frame(const void *data, unsigned width,
          return;
       }
 
-      /* Big bottleneck.
-       * Since we might need to do read-backs asynchronously,
-       * it might take 3-4 times before this returns true. */
-      if (!video_driver_read_viewport(global->record.gpu_buffer))
+      if (global->record.gpu_yuv420)
+      {
+         /* Converted by the video driver, top row first. */
+         if (!video_driver_read_viewport_yuv420(global->record.gpu_buffer))
+            return;
+
+         ffemu_data.pitch  = global->record.gpu_yuv420_width;
+         ffemu_data.width  = global->record.gpu_yuv420_width;
+         ffemu_data.height = global->record.gpu_yuv420_height;
+         ffemu_data.data   = global->record.gpu_buffer;
+      }
+      else
+      {
+         /* Big bottleneck.
+          * Since we might need to do read-backs asynchronously,
+          * it might take 3-4 times before this returns true. */
+         if (!video_driver_read_viewport(global->record.gpu_buffer))
             return;
 
-      ffemu_data.pitch  = global->record.gpu_width * 3;
-      ffemu_data.width  = global->record.gpu_width;
-      ffemu_data.height = global->record.gpu_height;
-      ffemu_data.data   = global->record.gpu_buffer +
-         (ffemu_data.height - 1) * ffemu_data.pitch;
+         ffemu_data.pitch  = global->record.gpu_width * 3;
+         ffemu_data.width  = global->record.gpu_width;
+         ffemu_data.height = global->record.gpu_height;
+         ffemu_data.data   = global->record.gpu_buffer +
+            (ffemu_data.height - 1) * ffemu_data.pitch;
 
-      ffemu_data.pitch  = -ffemu_data.pitch;
+         ffemu_data.pitch  = -ffemu_data.pitch;
+      }
    }
 
    if (!global->record.gpu_buffer)
@@ -254,6 +335,8 @@ void recording_dump_frame(const void *data, unsigned width,
 
    if (driver->recording && driver->recording->push_video)
       driver->recording->push_video(driver->recording_data, &ffemu_data);
+
+   recording_check_stats();
 }
 
 bool recording_deinit(void)
@@ -313,6 +396,9 @@ bool recording_init(void)
          (float)global->system.av_info.timing.fps,
          (float)global->system.av_info.timing.sample_rate);
 
+   recording_stats_frames  = 0;
+   recording_stats_dropped = 0;
+
    strlcpy(recording_file, global->record.path, sizeof(recording_file));
 
    if (global->record.use_output_dir)
@@ -337,6 +423,7 @@ bool recording_init(void)
 
    if (settings->video.gpu_record && driver->video->read_viewport)
    {
+      unsigned yuv_width, yuv_height;
       struct video_viewport vp = {0};
 
       video_driver_viewport_info(&vp);
@@ -359,14 +446,43 @@ bool recording_init(void)
       else
          params.aspect_ratio  = (float)vp.width / vp.height;
 
+      yuv_width  = vp.width;
+      yuv_height = vp.height;
+
+      /* The video driver scales to the requested size where it 
+       * converts to YUV, or else the recording driver does. */
+      if (global->record.width || global->record.height)
+      {
+         params.out_width  = global->record.width;
+         params.out_height = global->record.height;
+         yuv_width         = params.out_width  & ~7;
+         yuv_height        = params.out_height & ~3;
+      }
+
       params.pix_fmt             = FFEMU_PIX_BGR24;
       global->record.gpu_width   = vp.width;
       global->record.gpu_height  = vp.height;
+      global->record.gpu_yuv420  = 
+         video_driver_init_viewport_yuv420(yuv_width, yuv_height);
 
       RARCH_LOG("Detected viewport of %u x %u\n",
             vp.width, vp.height);
 
-      global->record.gpu_buffer = (uint8_t*)malloc(vp.width * vp.height * 3);
+      if (global->record.gpu_yuv420)
+      {
+         params.pix_fmt                   = FFEMU_PIX_YUV420P;
+         params.out_width                 = yuv_width;
+         params.out_height                = yuv_height;
+         params.fb_width                  = next_pow2(yuv_width);
+         params.fb_height                 = next_pow2(yuv_height);
+         global->record.gpu_yuv420_width  = yuv_width;
+         global->record.gpu_yuv420_height = yuv_height;
+         global->record.gpu_buffer        = (uint8_t*)
+            malloc(yuv_width * yuv_height * 3 / 2);
+      }
+      else
+         global->record.gpu_buffer = (uint8_t*)
+            malloc(vp.width * vp.height * 3);
       if (!global->record.gpu_buffer)
       {
          RARCH_ERR("Failed to allocate GPU record buffer.\n");
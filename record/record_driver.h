@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <boolean.h>
 
 #ifdef __cplusplus
@@ -28,7 +29,10 @@ enum ffemu_pix_format
 {
    FFEMU_PIX_RGB565 = 0,
    FFEMU_PIX_BGR24,
-   FFEMU_PIX_ARGB8888
+   FFEMU_PIX_ARGB8888,
+   /* Planar I420, planes packed back to back,
+    * pitch is that of the Y plane. */
+   FFEMU_PIX_YUV420P
 };
 
 /* Parameters passed to ffemu_new() */
@@ -80,6 +84,20 @@ struct ffemu_audio_data
    size_t frames;
 };
 
+/* Encoder backpressure, see record_driver_t::get_stats. */
+struct ffemu_stats
+{
+   /* Video frames waiting to be encoded. */
+   unsigned queued;
+   unsigned queue_size;
+   /* Video frames pushed and how many of them were dropped 
+    * because the encoder fell behind. */
+   uint64_t frames;
+   uint64_t dropped;
+   /* Average time taken to encode a video frame. */
+   unsigned encode_usec;
+};
+
 typedef struct record_driver
 {
    void *(*init)(const struct ffemu_params *params);
@@ -87,10 +105,12 @@ typedef struct record_driver
    bool  (*push_video)(void *data,const struct ffemu_video_data *video_data);
    bool  (*push_audio)(void *data, const struct ffemu_audio_data *audio_data);
    bool  (*finalize)(void *data);
+   void  (*get_stats)(void *data, struct ffemu_stats *stats);
    const char *ident;
 } record_driver_t;
 
 extern const record_driver_t ffemu_ffmpeg;
+extern const record_driver_t ffemu_raw;
 extern const record_driver_t ffemu_null;
 
 /**
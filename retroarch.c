@@ -37,6 +37,10 @@
 #include "git_version.h"
 #include "intl/intl.h"
 
+#ifdef HAVE_7ZIP
+#include "decompress/7zip_support.h"
+#endif
+
 #ifdef HAVE_MENU
 #include "menu/menu.h"
 #include "menu/menu_shader.h"
@@ -69,6 +73,7 @@ void rarch_render_cached_frame(void)
 
    /* Cannot allow recording when pushing duped frames. */
    driver->recording_data = NULL;
+   global->frame_cache.redraw = true;
 
    /* Not 100% safe, since the library might have
     * freed the memory, but no known implementations do this.
@@ -82,6 +87,7 @@ void rarch_render_cached_frame(void)
             global->frame_cache.height,
             global->frame_cache.pitch);
 
+   global->frame_cache.redraw = false;
    driver->recording_data = recording;
 }
 
@@ -115,6 +121,7 @@ static void print_features(void)
    _PSUPP(roar, "RoarAudio", "Audio driver");
    _PSUPP(pulse, "PulseAudio", "Audio driver");
    _PSUPP(dsound, "DirectSound", "Audio driver");
+   _PSUPP(wasapi, "WASAPI", "Audio driver");
    _PSUPP(xaudio, "XAudio2", "Audio driver");
    _PSUPP(al, "OpenAL", "Audio driver");
    _PSUPP(sl, "OpenSL", "Audio driver");
@@ -217,6 +224,10 @@ static void print_help(void)
 
    puts("\t-P/--bsvplay: Playback a BSV movie file.");
    puts("\t-R/--bsvrecord: Start recording a BSV movie file from the beginning.");
+#ifdef HAVE_NETPLAY
+   puts("\t\tDuring netplay, records the input of every user, starting a new file from");
+   puts("\t\ta savestate every minute and after a resync with the host.");
+#endif
    puts("\t--eof-exit: Exit upon reaching the end of the BSV movie file.");
    puts("\t-M/--sram-mode: Takes an argument telling how SRAM should be handled in the session.");
    puts("\t\t{no,}load-{no,}save describes if SRAM should be loaded, and if SRAM should be saved.");
@@ -227,6 +238,13 @@ static void print_help(void)
    puts("\t-C/--connect: Connect to netplay as user 2.");
    puts("\t--port: Port used to netplay. Default is 55435.");
    puts("\t-F/--frames: Sync frames when using netplay.");
+   puts("\t\tThis is the maximum amount of frames that can be rolled back.");
+   puts("\t--input-delay: Frames of delay added to local input when using netplay.");
+   puts("\t\tEach frame of delay hides one frame of network latency from rollback.");
+   puts("\t--users: Amount of users to wait for when hosting netplay, up to 4.");
+   puts("\t\tThe host relays the input of every user to all clients.");
+   puts("\t--rendezvous: Meet netplay peers at this server[:port] to get through NATs.");
+   puts("\t\tThe host registers its nick as session, -C names the session to join.");
    puts("\t--spectate: Netplay will become spectating mode.");
    puts("\t\tHost can live stream the game content to users that connect.");
    puts("\t\tHowever, the client will not be able to play. Multiple clients can connect to the host.");
@@ -235,6 +253,7 @@ static void print_help(void)
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    puts("\t--command: Sends a command over UDP to an already running " RETRO_FRONTEND " process.");
    puts("\t\tAvailable commands are listed if command is invalid.");
+   puts("\t\tReplies to commands like GET_PERF are printed to stdout.");
 #endif
 
    puts("\t-r/--record: Path to record video file.\n\t\tUsing .mkv extension is recommended.");
@@ -246,7 +265,12 @@ static void print_help(void)
    puts("\t--ips: Specifies path for IPS patch that will be applied to content.");
    puts("\t--no-patch: Disables all forms of content patching.");
    puts("\t-D/--detach: Detach " RETRO_FRONTEND " from the running console. Not relevant for all platforms.");
-   puts("\t--max-frames: Runs for the specified number of frames, then exits.\n");
+   puts("\t--max-frames: Runs for the specified number of frames, then exits.");
+   puts("\t--benchmark: Runs the specified number of frames as fast as possible, then exits.");
+   puts("\t\tUses the null video, audio and input drivers, and prints frames per second");
+   puts("\t\tand the performance counters to stdout as JSON.");
+   puts("\t--benchmark-drivers: Keeps the configured drivers during --benchmark.");
+   puts("\t--trace: Writes a trace of the time spent starting up, for chrome://tracing or Perfetto.\n");
 }
 
 static void set_basename(const char *path)
@@ -404,7 +428,10 @@ static void parse_input(int argc, char *argv[])
    global->has_set_username              = false;
    global->has_set_netplay_ip_address    = false;
    global->has_set_netplay_delay_frames  = false;
+   global->has_set_netplay_input_delay_frames = false;
+   global->has_set_netplay_users         = false;
    global->has_set_netplay_ip_port       = false;
+   global->has_set_netplay_rendezvous    = false;
 
    global->has_set_ups_pref              = false;
    global->has_set_bps_pref              = false;
@@ -458,6 +485,9 @@ static void parse_input(int argc, char *argv[])
       { "frames", 1, NULL, 'F' },
       { "port", 1, &val, 'p' },
       { "spectate", 0, &val, 'S' },
+      { "input-delay", 1, &val, 'D' },
+      { "users", 1, &val, 'u' },
+      { "rendezvous", 1, &val, 'r' },
 #endif
       { "nick", 1, &val, 'N' },
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
@@ -471,7 +501,10 @@ static void parse_input(int argc, char *argv[])
       { "features", 0, &val, 'f' },
       { "subsystem", 1, NULL, 'Z' },
       { "max-frames", 1, NULL, 'm' },
+      { "benchmark", 1, &val, 'b' },
+      { "benchmark-drivers", 0, &val, 'K' },
       { "eof-exit", 0, &val, 'e' },
+      { "trace", 1, &val, 't' },
       { NULL, 0, NULL, 0 }
    };
 
@@ -695,6 +728,22 @@ static void parse_input(int argc, char *argv[])
                   global->netplay_is_spectate = true;
                   break;
 
+               case 'D':
+                  global->netplay_input_delay_frames = strtoul(optarg, NULL, 0);
+                  global->has_set_netplay_input_delay_frames = true;
+                  break;
+
+               case 'u':
+                  global->netplay_users = strtoul(optarg, NULL, 0);
+                  global->has_set_netplay_users = true;
+                  break;
+
+               case 'r':
+                  global->has_set_netplay_rendezvous = true;
+                  strlcpy(global->netplay_rendezvous, optarg,
+                        sizeof(global->netplay_rendezvous));
+                  break;
+
 #endif
                case 'N':
                   global->has_set_username = true;
@@ -758,6 +807,18 @@ static void parse_input(int argc, char *argv[])
                   global->bsv.eof_exit = true;
                   break;
 
+               case 't':
+                  rarch_trace_init(optarg);
+                  break;
+
+               case 'b':
+                  global->benchmark.frames = strtoul(optarg, NULL, 10);
+                  break;
+
+               case 'K':
+                  global->benchmark.real_drivers = true;
+                  break;
+
                default:
                   break;
             }
@@ -988,6 +1049,10 @@ void rarch_main_free(void)
    rarch_main_state_free();
    rarch_main_global_free();
    config_free();
+
+#ifdef HAVE_7ZIP
+   read_7zip_file_cache_free();
+#endif
 }
 
 #ifdef HAVE_ZLIB
@@ -1113,6 +1178,8 @@ int rarch_main_init(int argc, char *argv[])
    global->error_in_init = true;
    parse_input(argc, argv);
 
+   RARCH_TRACE_BEGIN("rarch_main_init");
+
    if (global->verbosity)
    {
       char str[PATH_MAX_LENGTH];
@@ -1129,10 +1196,15 @@ int rarch_main_init(int argc, char *argv[])
    }
 
    validate_cpu_features();
+
+   RARCH_TRACE_BEGIN("config_load");
    config_load();
+   RARCH_TRACE_END("config_load");
 
+   RARCH_TRACE_BEGIN("init_libretro_sym");
    init_libretro_sym(global->libretro_dummy);
    init_system_info();
+   RARCH_TRACE_END("init_libretro_sym");
 
    init_drivers_pre();
 
@@ -1160,14 +1232,19 @@ int rarch_main_init(int argc, char *argv[])
    }
 #endif
 
+   if (global->perfcnt_enable)
+      rarch_zone_sampler_init();
+
    global->error_in_init = false;
    global->main_is_init  = true;
+   RARCH_TRACE_END("rarch_main_init");
    return 0;
 
 error:
    event_command(EVENT_CMD_CORE_DEINIT);
 
    global->main_is_init = false;
+   RARCH_TRACE_END("rarch_main_init");
    return 1;
 }
 
@@ -17,13 +17,31 @@
 
 #define __STDC_LIMIT_MACROS
 #include "rewind.h"
-#include "performance.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <retro_inline.h>
+
+#ifdef REWIND_TEST
+/* Standalone build for tests/rewind, without the rest of the frontend. */
+#include "libretro.h"
+#define RARCH_PERFORMANCE_INIT(X)
+#define RARCH_PERFORMANCE_START(X)
+#define RARCH_PERFORMANCE_STOP(X)
+#else
+#include "performance.h"
 #include "intl/intl.h"
 #include "dynamic.h"
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#ifdef HAVE_ZLIB_DEFLATE
+#include <zlib.h>
+#define HAVE_REWIND_COLD
+#endif
 
 #ifndef UINT16_MAX
 #define UINT16_MAX 0xffff
@@ -98,6 +116,44 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+/* Every block starts with a header holding the size of the state in it,
+ * so states with different sizes can share the ring; the delta encoder 
+ * picks up size changes like any other change. 16 bytes to keep the 
+ * state itself aligned. */
+#define STATE_HEADER_SIZE 16
+#define STATE_DATA(block) ((block) + STATE_HEADER_SIZE)
+
+/* Blocks grow in whole pages, so a core whose state size changes 
+ * a bit now and then doesn't reallocate them every time. */
+#define STATE_PAGE_SIZE 4096
+
+/* Padding after a block: end marker plus scanner read-ahead. */
+#define STATE_BLOCK_PAD (sizeof(uint16_t) * 4 + 16)
+
+#ifdef HAVE_REWIND_COLD
+/* Number of deltas deflated together when moving to the cold tier. */
+#define COLD_CHUNK_ENTRIES 64
+
+/* A batch of consecutive deltas, oldest first, deflated as one stream. */
+struct state_manager_chunk
+{
+   struct state_manager_chunk *newer;
+   struct state_manager_chunk *older;
+   size_t size;
+   size_t raw_size;
+   unsigned entries;
+};
+#endif
+
+/* A full state stored after the delta of a ring entry. */
+struct state_manager_keyframe
+{
+   /* Sequence number of the entry, as in state_manager::hot_seq. */
+   unsigned seq;
+   /* Offset of the state in state_manager::data. */
+   size_t offset;
+};
+
 struct state_manager
 {
    uint8_t *data;
@@ -110,8 +166,10 @@ struct state_manager
    uint8_t *thisblock;
    uint8_t *nextblock;
 
-   /* This one is rounded up from reset::blocksize. */
+   /* Header plus state, rounded up to whole pages. Only ever grows. */
    size_t blocksize;
+   /* Size of the states pushed from now on. */
+   size_t state_size;
 
    /* size_t + (blocksize + 131071) / 131072 * 
     * (blocksize + u16 + u16) + u16 + u32 + size_t
@@ -119,56 +177,252 @@ struct state_manager
    size_t maxcompsize;
 
    unsigned entries;
+   /* Deltas in the ring, as opposed to the cold tier. */
+   unsigned hot_entries;
+   /* Sequence number of the newest delta in the ring. */
+   unsigned hot_seq;
    bool thisblock_valid;
+
+   /* Every keyframe_interval-th ring entry also carries a copy of the 
+    * state its delta decodes to, so state_manager_seek() doesn't have 
+    * to apply every delta in between. 0 disables keyframes.
+    *
+    * The index is a circular array, oldest first. */
+   unsigned keyframe_interval;
+   struct state_manager_keyframe *keyframes;
+   unsigned keyframes_cap;
+   unsigned keyframes_first;
+   unsigned keyframes_count;
+
+#ifdef HAVE_REWIND_COLD
+   /* Deltas beyond the newest cold_after are moved out of the ring
+    * in batches and deflated. 0 disables the cold tier. */
+   unsigned cold_after;
+   unsigned cold_entries;
+   size_t cold_capacity;
+   size_t cold_size;
+   struct state_manager_chunk *cold_newest;
+   struct state_manager_chunk *cold_oldest;
+
+   /* Newest chunk, inflated on demand by state_manager_pop(). 
+    * Also used as scratch when building a new chunk. */
+   uint8_t *cold_raw;
+   size_t cold_raw_cap;
+   size_t *cold_offsets;
+   unsigned cold_raw_entries;
+#endif
+
+#ifdef HAVE_THREADS
+   /* Threaded mode keeps a third block around, so the main thread
+    * can serialize the next state while the worker is still diffing
+    * the previous pair. */
+   uint8_t *spareblock;
+
+   /* Blocks the worker is currently comparing. */
+   const uint8_t *job_old;
+   const uint8_t *job_new;
+
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool job_pending;
+   bool thread_alive;
+#endif
 };
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
+static void state_manager_init_simd(void);
+
+#ifdef HAVE_THREADS
+static void state_manager_thread_loop(void *data);
+#endif
+
+#ifndef REWIND_TEST
+/* Rewind statistics, listed with the other performance counters.
+ * rewind_encode_usec and rewind_delta_bytes are accumulated per 
+ * pushed state, so their average is the per-state cost. The other 
+ * two are gauges: they always have one run and show the current value. */
+static struct retro_perf_counter rewind_encode_usec   = {"rewind_encode_usec"};
+static struct retro_perf_counter rewind_delta_bytes   = {"rewind_delta_bytes"};
+static struct retro_perf_counter rewind_used_permille = {"rewind_used_permille"};
+static struct retro_perf_counter rewind_history_msec  = {"rewind_history_msec"};
+
+/* Timed on the worker thread, so they are registered up front
+ * rather than with RARCH_PERFORMANCE_INIT. */
+static struct retro_perf_counter gen_deltas           = {"gen_deltas"};
+static struct retro_perf_counter rewind_deflate       = {"rewind_deflate"};
+static struct retro_perf_counter rewind_inflate       = {"rewind_inflate"};
+
+static void state_manager_stats_register(void)
+{
+   rarch_perf_register(&rewind_encode_usec);
+   rarch_perf_register(&rewind_delta_bytes);
+   rarch_perf_register(&rewind_used_permille);
+   rarch_perf_register(&rewind_history_msec);
+   rarch_perf_register(&gen_deltas);
+   rarch_perf_register(&rewind_deflate);
+   rarch_perf_register(&rewind_inflate);
+}
+
+static void state_manager_stats_update(state_manager_t *state,
+      retro_time_t encode_usec, size_t delta_bytes);
+#else
+#define state_manager_stats_register()
+#define state_manager_stats_update(state, encode_usec, delta_bytes) \
+   ((void)(encode_usec), (void)(delta_bytes))
+#define rarch_get_time_usec() 0
+#endif
+
+static size_t state_manager_block_size(size_t state_size)
+{
+   return (STATE_HEADER_SIZE + state_size + STATE_PAGE_SIZE - 1) & 
+      ~(size_t)(STATE_PAGE_SIZE - 1);
+}
+
+/**
+ * state_manager_grow_block:
+ * @block                : block to grow, may be NULL
+ * @oldsize              : current block size, 0 for new blocks
+ * @newsize              : new block size
+ * @marker               : end marker of the block
+ *
+ * (Re)allocates a block, zero filling everything past @oldsize.
+ *
+ * Force in a different byte at the end, so we don't need to check 
+ * bounds in the innermost loop (it's expensive).
+ *
+ * There is also a large amount of data that's the same, to stop 
+ * the other scan.
+ *
+ * There is also some padding at the end. This is so we don't 
+ * read outside the buffer end if we're reading in large blocks;
+ *
+ * It doesn't make any difference to us, but sacrificing 16 bytes to get 
+ * Valgrind happy is worth it (the vector scanners read 16 bytes at a time).
+ *
+ * Returns: new block, or NULL if out of memory (@block is left alone).
+ **/
+static uint8_t *state_manager_grow_block(uint8_t *block,
+      size_t oldsize, size_t newsize, uint16_t marker)
+{
+   uint8_t *ret = (uint8_t*)realloc(block, newsize + STATE_BLOCK_PAD);
+
+   if (!ret)
+      return NULL;
+
+   memset(ret + oldsize, 0, newsize + STATE_BLOCK_PAD - oldsize);
+   *(uint16_t*)(ret + newsize + sizeof(uint16_t) * 3) = marker;
+   return ret;
+}
+
+static void state_manager_set_blocksize(state_manager_t *state,
+      size_t blocksize)
 {
-   size_t newblocksize;
-   int maxcblks;
    const int maxcblkcover = UINT16_MAX * sizeof(uint16_t);
+   int maxcblks = (blocksize + maxcblkcover - 1) / maxcblkcover;
+
+   state->blocksize   = blocksize;
+   state->maxcompsize = blocksize + maxcblks * sizeof(uint16_t) * 2 +
+      sizeof(uint16_t) + sizeof(uint32_t) + sizeof(size_t) * 2;
+
+   /* Any entry might be a keyframe as far as the capacity
+    * checks are concerned. */
+   if (state->keyframe_interval)
+      state->maxcompsize += blocksize;
+}
+
+state_manager_t *state_manager_new(size_t state_size, size_t buffer_size,
+      bool threaded, unsigned cold_after, unsigned keyframe_interval)
+{
    state_manager_t *state = (state_manager_t*)calloc(1, sizeof(*state));
 
    if (!state)
       return NULL;
 
-   newblocksize = ((state_size - 1) | (sizeof(uint16_t) - 1)) + 1;
-   state->blocksize = newblocksize;
+   state_manager_init_simd();
+   state_manager_stats_register();
 
-   maxcblks = (state->blocksize + maxcblkcover - 1) / maxcblkcover;
-   state->maxcompsize = state->blocksize + maxcblks * sizeof(uint16_t) * 2 +
-      sizeof(uint16_t) + sizeof(uint32_t) + sizeof(size_t) * 2;
+   state->state_size        = state_size;
+   state->keyframe_interval = keyframe_interval;
+   state_manager_set_blocksize(state, state_manager_block_size(state_size));
+
+#ifdef HAVE_REWIND_COLD
+   if (cold_after)
+   {
+      /* The ring only needs to hold the uncompressed part of 
+       * the history, the rest of the budget goes to the cold tier.
+       * It still has to fit a couple of deltas though, or every
+       * push would be dropped. */
+      size_t hot_size = buffer_size / 4;
+      size_t min_size = 2 * state->maxcompsize + sizeof(size_t);
+
+      if (hot_size < min_size)
+         hot_size = min_size;
+
+      /* No room left for a cold tier, keep it all in the ring. */
+      if (hot_size < buffer_size)
+      {
+         state->cold_after    = cold_after;
+         state->cold_capacity = buffer_size - hot_size;
+         state->cold_offsets  = (size_t*)
+            malloc((COLD_CHUNK_ENTRIES + 1) * sizeof(size_t));
+         buffer_size          = hot_size;
+
+         if (!state->cold_offsets)
+            goto error;
+      }
+   }
+#else
+   (void)cold_after;
+#endif
+
+   if (keyframe_interval)
+   {
+      state->keyframes_cap     = buffer_size / state->blocksize + 2;
+      state->keyframes         = (struct state_manager_keyframe*)
+         calloc(state->keyframes_cap, sizeof(*state->keyframes));
+
+      if (!state->keyframes)
+         goto error;
+   }
 
    state->data = (uint8_t*)malloc(buffer_size);
 
-   state->thisblock = (uint8_t*)
-      calloc(state->blocksize + sizeof(uint16_t) * 4 + 16, 1);
-   state->nextblock = (uint8_t*)
-      calloc(state->blocksize + sizeof(uint16_t) * 4 + 16, 1);
+   state->thisblock = state_manager_grow_block(NULL, 0,
+         state->blocksize, 0xFFFF);
+   state->nextblock = state_manager_grow_block(NULL, 0,
+         state->blocksize, 0x0000);
    if (!state->data || !state->thisblock || !state->nextblock)
       goto error;
 
-   /* Force in a different byte at the end, so we don't need to check 
-    * bounds in the innermost loop (it's expensive).
-    *
-    * There is also a large amount of data that's the same, to stop 
-    * the other scan.
-    *
-    * There is also some padding at the end. This is so we don't 
-    * read outside the buffer end if we're reading in large blocks;
-    *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get 
-    * Valgrind happy is worth it. */
-   *(uint16_t*)(state->thisblock + state->blocksize + sizeof(uint16_t) * 3) =
-      0xFFFF;
-   *(uint16_t*)(state->nextblock + state->blocksize + sizeof(uint16_t) * 3) =
-      0x0000;
-
    state->capacity = buffer_size;
 
    state->head = state->data + sizeof(size_t);
    state->tail = state->data + sizeof(size_t);
 
+#ifdef HAVE_THREADS
+   if (threaded)
+   {
+      /* The blocks rotate between three roles, the end markers 
+       * have to differ for every possible pair. */
+      state->spareblock = state_manager_grow_block(NULL, 0,
+            state->blocksize, 0x5555);
+      state->lock       = slock_new();
+      state->cond       = scond_new();
+      if (!state->spareblock || !state->lock || !state->cond)
+         goto error;
+
+      state->thread_alive = true;
+      state->thread = sthread_create(state_manager_thread_loop, state);
+      if (!state->thread)
+      {
+         state->thread_alive = false;
+         goto error;
+      }
+   }
+#else
+   (void)threaded;
+#endif
+
    return state;
 
 error:
@@ -181,43 +435,99 @@ void state_manager_free(state_manager_t *state)
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      state->thread_alive = false;
+      scond_broadcast(state->cond);
+      slock_unlock(state->lock);
+
+      sthread_join(state->thread);
+   }
+
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+   free(state->spareblock);
+#endif
+
+#ifdef HAVE_REWIND_COLD
+   while (state->cold_newest)
+   {
+      struct state_manager_chunk *chunk = state->cold_newest;
+      state->cold_newest = chunk->older;
+      free(chunk);
+   }
+   free(state->cold_raw);
+   free(state->cold_offsets);
+#endif
+
+   free(state->keyframes);
    free(state->data);
    free(state->thisblock);
    free(state->nextblock);
    free(state);
 }
 
-bool state_manager_pop(state_manager_t *state, const void **data)
-{
-   size_t start;
-   uint8_t *out;
-   uint16_t *out16;
-   const uint8_t *compressed = NULL;
-   const uint16_t *compressed16 = NULL;
+#define KEYFRAME_AT(state, i) \
+   (&(state)->keyframes[((state)->keyframes_first + (i)) % (state)->keyframes_cap])
 
-   *data = NULL;
+/* Drops index entries for deltas which are no longer in the ring. */
+static void state_manager_keyframes_trim(state_manager_t *state)
+{
+   unsigned oldest = state->hot_seq - state->hot_entries;
 
-   if (state->thisblock_valid)
+   while (state->keyframes_count && 
+         (int)(KEYFRAME_AT(state, 0)->seq - oldest) <= 0)
    {
-      state->thisblock_valid = false;
-      state->entries--;
-      *data = state->thisblock;
-      return true;
+      state->keyframes_first = (state->keyframes_first + 1) %
+         state->keyframes_cap;
+      state->keyframes_count--;
    }
 
-   if (state->head == state->tail)
-      return false;
+   while (state->keyframes_count && (int)(KEYFRAME_AT(state, 
+               state->keyframes_count - 1)->seq - state->hot_seq) > 0)
+      state->keyframes_count--;
+}
 
-   start = read_size_t(state->head - sizeof(size_t));
-   state->head = state->data + start;
+/**
+ * state_manager_wait:
+ * @state                : state manager handle
+ *
+ * Waits until the compression worker (if any) is done
+ * with the last pushed state, so that the ring and the
+ * uncompressed blocks can safely be touched by the caller.
+ **/
+static INLINE void state_manager_wait(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (!state->thread)
+      return;
 
-   compressed = state->data + start + sizeof(size_t);
-   out = state->thisblock;
+   slock_lock(state->lock);
+   while (state->job_pending)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+#else
+   (void)state;
+#endif
+}
 
+/**
+ * state_manager_apply_delta:
+ * @out                  : state to patch
+ * @compressed           : delta generated by state_manager_compress()
+ *
+ * Turns @out back into the state the delta was generated against.
+ **/
+static void state_manager_apply_delta(uint8_t *out, const uint8_t *compressed)
+{
    /* Begin decompression code
     * out is the last pushed (or returned) state */
-   compressed16 = (const uint16_t*)compressed;
-   out16 = (uint16_t*)out;
+   const uint16_t *compressed16 = (const uint16_t*)compressed;
+   uint16_t *out16 = (uint16_t*)out;
 
    for (;;)
    {
@@ -250,9 +560,405 @@ bool state_manager_pop(state_manager_t *state, const void **data)
       }
    }
    /* End decompression code */
+}
+
+#ifdef HAVE_REWIND_COLD
+/* Returns a pointer past the end of a delta, without applying it. */
+static const uint8_t *state_manager_delta_end(const uint8_t *compressed)
+{
+   const uint16_t *compressed16 = (const uint16_t*)compressed;
+
+   for (;;)
+   {
+      uint16_t numchanged = *(compressed16++);
+
+      if (numchanged)
+         compressed16 += numchanged + 1;
+      else
+      {
+         uint32_t numunchanged = compressed16[0] | (compressed16[1] << 16);
+
+         compressed16 += 2;
+         if (!numunchanged)
+            break;
+      }
+   }
+
+   return (const uint8_t*)compressed16;
+}
+
+static void state_manager_cold_free_chunks(state_manager_t *state)
+{
+   /* Without the newer deltas the older ones are useless, 
+    * so losing a chunk means losing the entire cold tier. */
+   while (state->cold_newest)
+   {
+      struct state_manager_chunk *chunk = state->cold_newest;
+      state->cold_newest = chunk->older;
+      free(chunk);
+   }
+
+   state->entries         -= state->cold_entries;
+   state->cold_entries     = 0;
+   state->cold_raw_entries = 0;
+   state->cold_size        = 0;
+   state->cold_oldest      = NULL;
+}
+
+static bool state_manager_cold_reserve(state_manager_t *state, size_t size)
+{
+   uint8_t *raw = NULL;
+
+   if (size <= state->cold_raw_cap)
+      return true;
+
+   if (size < state->cold_raw_cap * 2)
+      size = state->cold_raw_cap * 2;
+
+   raw = (uint8_t*)realloc(state->cold_raw, size);
+   if (!raw)
+      return false;
+
+   state->cold_raw     = raw;
+   state->cold_raw_cap = size;
+   return true;
+}
+
+/**
+ * state_manager_cold_push:
+ * @state                : state manager handle
+ * @raw                  : deltas, oldest first
+ * @raw_size             : size of @raw in bytes
+ * @entries              : number of deltas in @raw
+ *
+ * Deflates @raw into a new chunk, newer than all other chunks,
+ * and drops the oldest chunks if the cold budget is exceeded.
+ * Does not touch the entry counts.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool state_manager_cold_push(state_manager_t *state,
+      const uint8_t *raw, size_t raw_size, unsigned entries)
+{
+   struct state_manager_chunk *chunk = NULL, *shrunk = NULL;
+   uLongf size = compressBound(raw_size);
+
+   RARCH_PERFORMANCE_START(rewind_deflate);
+
+   chunk = (struct state_manager_chunk*)malloc(sizeof(*chunk) + size);
+   if (!chunk)
+      return false;
+
+   if (compress2((Bytef*)(chunk + 1), &size, raw, raw_size,
+            Z_BEST_SPEED) != Z_OK)
+   {
+      free(chunk);
+      return false;
+   }
+
+   shrunk = (struct state_manager_chunk*)realloc(chunk, sizeof(*chunk) + size);
+   if (shrunk)
+      chunk = shrunk;
+
+   chunk->size     = sizeof(*chunk) + size;
+   chunk->raw_size = raw_size;
+   chunk->entries  = entries;
+   chunk->newer    = NULL;
+   chunk->older    = state->cold_newest;
+
+   if (state->cold_newest)
+      state->cold_newest->newer = chunk;
+   else
+      state->cold_oldest = chunk;
+   state->cold_newest = chunk;
+   state->cold_size  += chunk->size;
+
+   while (state->cold_size > state->cold_capacity && 
+         state->cold_oldest != state->cold_newest)
+   {
+      struct state_manager_chunk *oldest = state->cold_oldest;
+
+      state->cold_oldest        = oldest->newer;
+      state->cold_oldest->older = NULL;
+      state->cold_size         -= oldest->size;
+      state->cold_entries      -= oldest->entries;
+      state->entries           -= oldest->entries;
+      free(oldest);
+   }
+
+   RARCH_PERFORMANCE_STOP(rewind_deflate);
+   return true;
+}
+
+/* Puts whatever is left of a partially popped chunk back into 
+ * the chunk list, so new chunks can go on top of it. */
+static void state_manager_cold_flush(state_manager_t *state)
+{
+   if (!state->cold_raw_entries)
+      return;
+
+   if (!state_manager_cold_push(state, state->cold_raw,
+            state->cold_offsets[state->cold_raw_entries],
+            state->cold_raw_entries))
+      state_manager_cold_free_chunks(state);
+
+   state->cold_raw_entries = 0;
+}
+
+/**
+ * state_manager_cold_migrate:
+ * @state                : state manager handle
+ * @count                : number of deltas to move
+ *
+ * Moves the @count oldest deltas out of the ring into a new chunk.
+ **/
+static void state_manager_cold_migrate(state_manager_t *state,
+      unsigned count)
+{
+   unsigned i;
+   size_t raw_size = 0;
+   bool ok         = true;
+
+   state_manager_cold_flush(state);
+
+   for (i = 0; i < count; i++)
+   {
+      const uint8_t *start = state->tail + sizeof(size_t);
+      size_t len           = state_manager_delta_end(start) - start;
+
+      /* The deltas leave the ring either way. */
+      if (ok)
+         ok = state_manager_cold_reserve(state, raw_size + len);
+      if (ok)
+      {
+         memcpy(state->cold_raw + raw_size, start, len);
+         raw_size += len;
+      }
+
+      state->tail = state->data + read_size_t(state->tail);
+   }
+
+   state->hot_entries -= count;
+
+   if (ok && state_manager_cold_push(state, state->cold_raw, raw_size, count))
+      state->cold_entries += count;
+   else
+   {
+      state->entries -= count;
+      state_manager_cold_free_chunks(state);
+   }
+}
+
+/* Inflates the newest chunk, so its deltas can be popped. */
+static bool state_manager_cold_inflate(state_manager_t *state)
+{
+   unsigned i;
+   uLongf raw_size;
+   const uint8_t *ptr = NULL;
+   struct state_manager_chunk *chunk = state->cold_newest;
+
+   if (!chunk)
+      return false;
+
+   RARCH_PERFORMANCE_START(rewind_inflate);
+
+   raw_size = chunk->raw_size;
+   if (!state_manager_cold_reserve(state, raw_size) ||
+         uncompress(state->cold_raw, &raw_size, (const Bytef*)(chunk + 1),
+            chunk->size - sizeof(*chunk)) != Z_OK)
+   {
+      state_manager_cold_free_chunks(state);
+      return false;
+   }
+
+   ptr = state->cold_raw;
+   for (i = 0; i < chunk->entries; i++)
+   {
+      state->cold_offsets[i] = ptr - state->cold_raw;
+      ptr = state_manager_delta_end(ptr);
+   }
+   state->cold_offsets[chunk->entries] = ptr - state->cold_raw;
+   state->cold_raw_entries = chunk->entries;
+
+   state->cold_newest = chunk->older;
+   if (state->cold_newest)
+      state->cold_newest->newer = NULL;
+   else
+      state->cold_oldest = NULL;
+   state->cold_size -= chunk->size;
+   free(chunk);
+
+   RARCH_PERFORMANCE_STOP(rewind_inflate);
+   return true;
+}
+#endif
+
+bool state_manager_pop(state_manager_t *state, const void **data)
+{
+   *data = NULL;
+
+   state_manager_wait(state);
+
+   if (state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      *data = STATE_DATA(state->thisblock);
+      return true;
+   }
+
+   if (state->head != state->tail)
+   {
+      size_t start = read_size_t(state->head - sizeof(size_t));
+      state->head  = state->data + start;
+
+      state_manager_apply_delta(state->thisblock,
+            state->data + start + sizeof(size_t));
+      state->hot_entries--;
+      state->hot_seq--;
+      state_manager_keyframes_trim(state);
+   }
+#ifdef HAVE_REWIND_COLD
+   else if (state->cold_raw_entries || state_manager_cold_inflate(state))
+   {
+      state->cold_raw_entries--;
+      state_manager_apply_delta(state->thisblock,
+            state->cold_raw + state->cold_offsets[state->cold_raw_entries]);
+      state->cold_entries--;
+   }
+#endif
+   else
+      return false;
 
    state->entries--;
-   *data = state->thisblock;
+   *data = STATE_DATA(state->thisblock);
+   return true;
+}
+
+unsigned state_manager_seek(state_manager_t *state, unsigned count,
+      const void **data)
+{
+   unsigned popped = 0;
+
+   *data = NULL;
+
+   state_manager_wait(state);
+
+   if (count && state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      popped++;
+   }
+
+   if (popped < count && state->keyframes_count)
+   {
+      unsigned i;
+      unsigned in_ring = count - popped < state->hot_entries ?
+         count - popped : state->hot_entries;
+      unsigned target  = state->hot_seq - in_ring + 1;
+      struct state_manager_keyframe *key = NULL;
+
+      /* Closest keyframe on the newer side of the target. */
+      for (i = 0; i < state->keyframes_count; i++)
+      {
+         struct state_manager_keyframe *cur = KEYFRAME_AT(state, i);
+
+         if ((int)(cur->seq - target) >= 0)
+         {
+            key = cur;
+            break;
+         }
+      }
+
+      if (key)
+      {
+         unsigned skip = state->hot_seq - key->seq + 1;
+
+         /* Keyframes are always in the ring, so no need
+          * to worry about the head running into the tail. */
+         for (i = 0; i < skip; i++)
+            state->head = state->data + 
+               read_size_t(state->head - sizeof(size_t));
+
+         memcpy(state->thisblock, state->data + key->offset, 
+               state->blocksize);
+
+         state->hot_entries -= skip;
+         state->hot_seq     -= skip;
+         state->entries     -= skip;
+         popped             += skip;
+
+         state_manager_keyframes_trim(state);
+      }
+   }
+
+   while (popped < count && state_manager_pop(state, data))
+      popped++;
+
+   if (popped)
+      *data = STATE_DATA(state->thisblock);
+
+   return popped;
+}
+
+size_t state_manager_popped_size(state_manager_t *state)
+{
+   return read_size_t(state->thisblock);
+}
+
+bool state_manager_resize(state_manager_t *state, size_t state_size)
+{
+   unsigned i, j;
+   uint8_t **blocks[3];
+   unsigned num_blocks = 0;
+   size_t blocksize    = state_manager_block_size(state_size);
+
+   if (state_size == state->state_size)
+      return true;
+
+   state_manager_wait(state);
+
+   if (blocksize <= state->blocksize)
+   {
+      state->state_size = state_size;
+      return true;
+   }
+
+   blocks[num_blocks++] = &state->thisblock;
+   blocks[num_blocks++] = &state->nextblock;
+#ifdef HAVE_THREADS
+   if (state->spareblock)
+      blocks[num_blocks++] = &state->spareblock;
+#endif
+
+   for (i = 0; i < num_blocks; i++)
+   {
+      uint16_t marker = *(uint16_t*)(*blocks[i] + state->blocksize + 
+            sizeof(uint16_t) * 3);
+      uint8_t *block  = state_manager_grow_block(*blocks[i],
+            state->blocksize, blocksize, marker);
+
+      if (!block)
+      {
+         /* Put the end markers of the blocks grown so far back, 
+          * and carry on with the old size. */
+         for (j = 0; j < i; j++)
+            *(uint16_t*)(*blocks[j] + state->blocksize + 
+                  sizeof(uint16_t) * 3) = *(uint16_t*)(*blocks[j] + 
+                     blocksize + sizeof(uint16_t) * 3);
+         return false;
+      }
+
+      *blocks[i] = block;
+   }
+
+   /* Deltas already in the history still apply to the bigger blocks, 
+    * they just never touch the new tail. Keyframes don't, though. */
+   state->keyframes_count = 0;
+   state->state_size      = state_size;
+   state_manager_set_blocksize(state, blocksize);
+
    return true;
 }
 
@@ -272,10 +978,28 @@ void state_manager_push_where(state_manager_t *state, void **data)
       }
    }
    
-   *data = state->nextblock;
+   write_size_t(state->nextblock, state->state_size);
+   /* Stale bytes from a bigger state would only bloat the delta. */
+   memset(STATE_DATA(state->nextblock) + state->state_size, 0,
+         state->blocksize - STATE_HEADER_SIZE - state->state_size);
+
+   *data = STATE_DATA(state->nextblock);
 }
 
-#if __SSE2__
+/* Scanners used by the delta encoder. 
+ *
+ * find_change returns the number of leading uint16s that are equal,
+ * find_same returns the number of leading uint16s that differ (it
+ * only has to be exact at uint32 granularity, see find_same_C).
+ *
+ * Both rely on the end markers set up in state_manager_new() to stop, 
+ * so no bounds checks are done. Read-ahead is at most 16 bytes past the
+ * position that stops the scan, which is covered by the block padding. */
+typedef size_t (*state_manager_scan_t)(const uint16_t *a, const uint16_t *b);
+
+static state_manager_scan_t find_change;
+static state_manager_scan_t find_same;
+
 #if defined(__GNUC__)
 static INLINE int compat_ctz(unsigned x)
 {
@@ -300,35 +1024,10 @@ static INLINE int compat_ctz(unsigned x)
 }
 #endif
 
-#include <emmintrin.h>
 /* There's no equivalent in libc, you'd think so ...
  * std::mismatch exists, but it's not optimized at all. */
 
-static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
-{
-   const __m128i *a128 = (const __m128i*)a;
-   const __m128i *b128 = (const __m128i*)b;
-	
-   for (;;)
-   {
-      __m128i v0    = _mm_loadu_si128(a128);
-      __m128i v1    = _mm_loadu_si128(b128);
-      __m128i c     = _mm_cmpeq_epi32(v0, v1);
-      uint32_t mask = _mm_movemask_epi8(c);
-
-      if (mask != 0xffff) /* Something has changed, figure out where. */
-      {
-         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) |
-               (compat_ctz(~mask))) >> 1;
-			return ret | (a[ret] == b[ret]);
-      }
-
-      a128++;
-      b128++;
-   }
-}
-#else
-static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
+static size_t find_change_C(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
 #ifdef NO_UNALIGNED_MEM
@@ -359,9 +1058,8 @@ static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
    }
    return a - a_org;
 }
-#endif
 
-static INLINE size_t find_same(const uint16_t *a, const uint16_t *b)
+static size_t find_same_C(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
 #ifdef NO_UNALIGNED_MEM
@@ -401,108 +1099,406 @@ static INLINE size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
-void state_manager_push_do(state_manager_t *state)
+#if __SSE2__
+#include <emmintrin.h>
+
+static size_t find_change_sse2(const uint16_t *a, const uint16_t *b)
 {
-   if (state->thisblock_valid)
+   const __m128i *a128 = (const __m128i*)a;
+   const __m128i *b128 = (const __m128i*)b;
+	
+   for (;;)
    {
-      if (state->capacity < sizeof(size_t) + state->maxcompsize)
-         return;
+      __m128i v0    = _mm_loadu_si128(a128);
+      __m128i v1    = _mm_loadu_si128(b128);
+      __m128i c     = _mm_cmpeq_epi32(v0, v1);
+      uint32_t mask = _mm_movemask_epi8(c);
 
-recheckcapacity:;
+      if (mask != 0xffff) /* Something has changed, figure out where. */
+      {
+         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) |
+               (compat_ctz(~mask))) >> 1;
+			return ret | (a[ret] == b[ret]);
+      }
+
+      a128++;
+      b128++;
+   }
+}
+
+/* Same result as find_same_C, four uint32s at a time. */
+static size_t find_same_sse2(const uint16_t *a, const uint16_t *b)
+{
+   const __m128i *a128 = (const __m128i*)a;
+   const __m128i *b128 = (const __m128i*)b;
 
-      size_t headpos = state->head - state->data;
-      size_t tailpos = state->tail - state->data;
-      size_t remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
+   for (;;)
+   {
+      __m128i v0    = _mm_loadu_si128(a128);
+      __m128i v1    = _mm_loadu_si128(b128);
+      __m128i c     = _mm_cmpeq_epi32(v0, v1);
+      uint32_t mask = _mm_movemask_epi8(c);
 
-      if (remaining <= state->maxcompsize)
+      if (mask)
       {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
+         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) +
+               compat_ctz(mask)) >> 1;
+         return ret - (ret && a[ret - 1] == b[ret - 1]);
       }
 
-      RARCH_PERFORMANCE_INIT(gen_deltas);
-      RARCH_PERFORMANCE_START(gen_deltas);
+      a128++;
+      b128++;
+   }
+}
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define HAVE_REWIND_NEON
+#include <arm_neon.h>
 
-      const uint8_t *oldb = state->thisblock;
-      const uint8_t *newb = state->nextblock;
-      uint8_t *compressed = state->head + sizeof(size_t);
+/* NEON has no movemask; test 8 uint16s at a time and let the 
+ * scalar code pinpoint the first mismatch in the last vector. */
+static size_t find_change_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+
+   for (;;)
+   {
+      uint16x8_t c  = vceqq_u16(vld1q_u16(a), vld1q_u16(b));
+      uint32x2_t m  = vreinterpret_u32_u16(
+            vand_u16(vget_low_u16(c), vget_high_u16(c)));
 
-      /* Begin compression code; 'compressed' will point to 
-       * the end of the compressed data (excluding the prev pointer). */
-      const uint16_t *old16 = (const uint16_t*)oldb;
-      const uint16_t *new16 = (const uint16_t*)newb;
-      uint16_t *compressed16 = (uint16_t*)compressed;
-      size_t num16s = state->blocksize / sizeof(uint16_t);
+      if ((vget_lane_u32(m, 0) & vget_lane_u32(m, 1)) != 0xffffffffu)
+         break;
 
-      while (num16s)
-      {
-         size_t i;
-         size_t skip = find_change(old16, new16);
+      a += 8;
+      b += 8;
+   }
 
-         if (skip >= num16s)
-            break;
+   while (*a == *b)
+   {
+      a++;
+      b++;
+   }
+   return a - a_org;
+}
+
+static size_t find_same_neon(const uint16_t *a, const uint16_t *b)
+{
+   size_t ret;
+   const uint32_t *a_big = (const uint32_t*)a;
+   const uint32_t *b_big = (const uint32_t*)b;
+
+   if ((uintptr_t)a & (sizeof(uint32_t) - 1))
+      return find_same_C(a, b);
+
+   for (;;)
+   {
+      uint32x4_t c = vceqq_u32(vld1q_u32(a_big), vld1q_u32(b_big));
+      uint32x2_t m = vorr_u32(vget_low_u32(c), vget_high_u32(c));
+
+      if (vget_lane_u32(m, 0) | vget_lane_u32(m, 1))
+         break;
+
+      a_big += 4;
+      b_big += 4;
+   }
+
+   while (*a_big != *b_big)
+   {
+      a_big++;
+      b_big++;
+   }
+
+   ret = (const uint16_t*)a_big - a;
+   return ret - (ret && a[ret - 1] == b[ret - 1]);
+}
+#endif
+
+#ifdef REWIND_TEST
+unsigned rewind_test_get_cpu_features(void);
+#endif
+
+/**
+ * state_manager_init_simd:
+ *
+ * Picks the delta scanners based on CPU features.
+ **/
+static void state_manager_init_simd(void)
+{
+#ifdef REWIND_TEST
+   unsigned cpu = rewind_test_get_cpu_features();
+#else
+   unsigned cpu = rarch_get_cpu_features();
+#endif
+
+   (void)cpu;
+
+   find_change = find_change_C;
+   find_same   = find_same_C;
+
+#if __SSE2__
+   if (cpu & RETRO_SIMD_SSE2)
+   {
+      find_change = find_change_sse2;
+      find_same   = find_same_sse2;
+   }
+#endif
+
+#ifdef HAVE_REWIND_NEON
+   if (cpu & RETRO_SIMD_NEON)
+   {
+      find_change = find_change_neon;
+      find_same   = find_same_neon;
+   }
+#endif
+}
+
+/**
+ * state_manager_evict:
+ * @state                : state manager handle
+ *
+ * Makes room in the ring by dropping the oldest delta, or by
+ * moving the oldest deltas into cold storage when enabled.
+ *
+ * Returns: true (1) if room was made, false (0) if the ring
+ * is empty already.
+ **/
+static bool state_manager_evict(state_manager_t *state)
+{
+   if (!state->hot_entries)
+      return false;
+
+#ifdef HAVE_REWIND_COLD
+   if (state->cold_after)
+   {
+      state_manager_cold_migrate(state, 
+            state->hot_entries < COLD_CHUNK_ENTRIES ?
+            state->hot_entries : COLD_CHUNK_ENTRIES);
+      return true;
+   }
+#endif
+
+   state->tail = state->data + read_size_t(state->tail);
+   state->hot_entries--;
+   state->entries--;
+   return true;
+}
+
+/**
+ * state_manager_compress:
+ * @state                : state manager handle
+ * @oldb                 : last pushed state
+ * @newb                 : state being pushed
+ *
+ * Generates the delta between @newb and @oldb, and appends it
+ * to the ring, evicting old entries from the tail as needed.
+ **/
+static void state_manager_compress(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb)
+{
+   retro_time_t start_usec = rarch_get_time_usec();
+   size_t delta_bytes;
+
+#ifdef HAVE_REWIND_COLD
+   /* New deltas go on top of the partially popped chunk. */
+   state_manager_cold_flush(state);
+#endif
+
+recheckcapacity:;
+
+   size_t headpos = state->head - state->data;
+   size_t tailpos = state->tail - state->data;
+   size_t remaining = (tailpos + state->capacity -
+         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+   if (remaining <= state->maxcompsize)
+   {
+      if (state_manager_evict(state))
+         goto recheckcapacity;
+
+      /* Not even an empty ring holds the delta. Without it the
+       * older states can't be reached, so only keep the new one. */
+#ifdef HAVE_REWIND_COLD
+      state_manager_cold_free_chunks(state);
+#endif
+      state->keyframes_count = 0;
+      state->entries--;
+      return;
+   }
+
+   RARCH_PERFORMANCE_START(gen_deltas);
 
-         old16 += skip;
-         new16 += skip;
-         num16s -= skip;
+   uint8_t *compressed = state->head + sizeof(size_t);
 
-         if (skip > UINT16_MAX)
+   /* Begin compression code; 'compressed' will point to 
+    * the end of the compressed data (excluding the prev pointer). */
+   const uint16_t *old16 = (const uint16_t*)oldb;
+   const uint16_t *new16 = (const uint16_t*)newb;
+   uint16_t *compressed16 = (uint16_t*)compressed;
+   size_t num16s = state->blocksize / sizeof(uint16_t);
+
+   while (num16s)
+   {
+      size_t i;
+      size_t skip = find_change(old16, new16);
+
+      if (skip >= num16s)
+         break;
+
+      old16 += skip;
+      new16 += skip;
+      num16s -= skip;
+
+      if (skip > UINT16_MAX)
+      {
+         if (skip > UINT32_MAX)
          {
-            if (skip > UINT32_MAX)
-            {
-               /* This will make it scan the entire thing again, 
-                * but it only hits on 8GB unchanged data anyways,
-                * and if you're doing that, you've got bigger problems. */
-               skip = UINT32_MAX;
-            }
-            *compressed16++ = 0;
-            *compressed16++ = skip;
-            *compressed16++ = skip >> 16;
-            skip = 0;
-            continue;
+            /* This will make it scan the entire thing again, 
+             * but it only hits on 8GB unchanged data anyways,
+             * and if you're doing that, you've got bigger problems. */
+            skip = UINT32_MAX;
          }
+         *compressed16++ = 0;
+         *compressed16++ = skip;
+         *compressed16++ = skip >> 16;
+         skip = 0;
+         continue;
+      }
 
-         size_t changed = find_same(old16, new16);
-         if (changed > UINT16_MAX)
-            changed = UINT16_MAX;
+      size_t changed = find_same(old16, new16);
+      if (changed > UINT16_MAX)
+         changed = UINT16_MAX;
 
-         *compressed16++ = changed;
-         *compressed16++ = skip;
+      *compressed16++ = changed;
+      *compressed16++ = skip;
 
-         for (i = 0; i < changed; i++)
-            compressed16[i] = old16[i];
+      for (i = 0; i < changed; i++)
+         compressed16[i] = old16[i];
 
-         old16 += changed;
-         new16 += changed;
-         num16s -= changed;
-         compressed16 += changed;
-      }
+      old16 += changed;
+      new16 += changed;
+      num16s -= changed;
+      compressed16 += changed;
+   }
+
+   compressed16[0] = 0;
+   compressed16[1] = 0;
+   compressed16[2] = 0;
+   compressed = (uint8_t*)(compressed16 + 3);
+   /* End compression code. */
+
+   if (state->keyframe_interval && 
+         (state->hot_seq + 1) % state->keyframe_interval == 0 &&
+         state->keyframes_count < state->keyframes_cap)
+   {
+      struct state_manager_keyframe *key = 
+         KEYFRAME_AT(state, state->keyframes_count);
+
+      key->seq    = state->hot_seq + 1;
+      key->offset = compressed - state->data;
+      state->keyframes_count++;
+
+      memcpy(compressed, oldb, state->blocksize);
+      compressed += state->blocksize;
+   }
+
+   delta_bytes = compressed - state->head + sizeof(size_t);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+         state_manager_evict(state);
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head = compressed;
+   state->hot_entries++;
+   state->hot_seq++;
+
+   RARCH_PERFORMANCE_STOP(gen_deltas);
+
+#ifdef HAVE_REWIND_COLD
+   if (state->cold_after && 
+         state->hot_entries >= state->cold_after + COLD_CHUNK_ENTRIES)
+      state_manager_cold_migrate(state, COLD_CHUNK_ENTRIES);
+#endif
+
+   state_manager_keyframes_trim(state);
+
+   state_manager_stats_update(state, 
+         rarch_get_time_usec() - start_usec, delta_bytes);
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_thread_loop(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+
+   for (;;)
+   {
+      while (state->thread_alive && !state->job_pending)
+         scond_wait(state->cond, state->lock);
+
+      if (!state->thread_alive)
+         break;
+
+      /* The main thread won't touch the ring 
+       * until job_pending is cleared. */
+      slock_unlock(state->lock);
+      state_manager_compress(state, state->job_old, state->job_new);
+      slock_lock(state->lock);
+
+      state->job_pending = false;
+      scond_signal(state->cond);
+   }
+
+   slock_unlock(state->lock);
+}
+#endif
 
-      compressed16[0] = 0;
-      compressed16[1] = 0;
-      compressed16[2] = 0;
-      compressed = (uint8_t*)(compressed16 + 3);
-      /* End compression code. */
+void state_manager_push_do(state_manager_t *state)
+{
+   uint8_t *swap = NULL;
+
+   state_manager_wait(state);
+
+   if (state->thisblock_valid)
+   {
+      if (state->capacity < sizeof(size_t) + state->maxcompsize)
+         return;
 
-      if (compressed - state->data + state->maxcompsize > state->capacity)
+#ifdef HAVE_THREADS
+      if (state->thread)
       {
-         compressed = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         /* Hand the pair over to the worker, and give the 
+          * spare block to the next push_where() call. */
+         swap              = state->thisblock;
+         state->thisblock  = state->nextblock;
+         state->nextblock  = state->spareblock;
+         state->spareblock = swap;
+
+         slock_lock(state->lock);
+         state->entries++;
+         state->job_old     = state->spareblock;
+         state->job_new     = state->thisblock;
+         state->job_pending = true;
+         scond_signal(state->cond);
+         slock_unlock(state->lock);
+         return;
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head = compressed;
+#endif
 
-      RARCH_PERFORMANCE_STOP(gen_deltas);
+      state_manager_compress(state, state->thisblock, state->nextblock);
    }
    else
       state->thisblock_valid = true;
 
-   uint8_t *swap = state->thisblock;
+   swap = state->thisblock;
    state->thisblock = state->nextblock;
    state->nextblock = swap;
 
@@ -512,22 +1508,78 @@ recheckcapacity:;
 void state_manager_capacity(state_manager_t *state,
       unsigned *entries, size_t *bytes, bool *full)
 {
-   size_t headpos   = state->head - state->data;
-   size_t tailpos   = state->tail - state->data;
-   size_t remaining = (tailpos + state->capacity -
+   size_t headpos, tailpos, remaining;
+
+   state_manager_wait(state);
+
+   headpos   = state->head - state->data;
+   tailpos   = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
          sizeof(size_t) - headpos - 1) % state->capacity + 1;
 
    if (entries)
       *entries = state->entries;
    if (bytes)
       *bytes = state->capacity-remaining;
+#ifdef HAVE_REWIND_COLD
+   if (bytes)
+      *bytes += state->cold_size;
+#endif
    if (full)
       *full = remaining <= state->maxcompsize * 2;
 }
 
+#ifndef REWIND_TEST
+/**
+ * state_manager_stats_update:
+ * @state                : state manager handle
+ * @encode_usec          : time spent encoding the newest state
+ * @delta_bytes          : ring space taken by the newest state
+ *
+ * Updates the rewind performance counters after a state has 
+ * been pushed. May be called from the worker thread.
+ **/
+static void state_manager_stats_update(state_manager_t *state,
+      retro_time_t encode_usec, size_t delta_bytes)
+{
+   size_t headpos, tailpos, used, total;
+   double fps;
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+
+   if (!global->perfcnt_enable)
+      return;
+
+   rewind_encode_usec.total += encode_usec;
+   rewind_encode_usec.call_cnt++;
+   rewind_delta_bytes.total += delta_bytes;
+   rewind_delta_bytes.call_cnt++;
+
+   headpos = state->head - state->data;
+   tailpos = state->tail - state->data;
+   used    = (headpos + state->capacity - tailpos) % state->capacity;
+   total   = state->capacity;
+#ifdef HAVE_REWIND_COLD
+   used  += state->cold_size;
+   total += state->cold_capacity;
+#endif
+
+   rewind_used_permille.total    = total ? (used * 1000) / total : 0;
+   rewind_used_permille.call_cnt = 1;
+
+   fps = global->system.av_info.timing.fps > 0.0 ?
+      global->system.av_info.timing.fps : 60.0;
+   rewind_history_msec.total     = state->entries * 1000.0 *
+      (settings->rewind_granularity ? settings->rewind_granularity : 1) / fps;
+   rewind_history_msec.call_cnt  = 1;
+}
+
 void init_rewind(void)
 {
-   void *state          = NULL;
+   double fps;
+   unsigned cold_after        = 0;
+   unsigned keyframe_interval = 0;
+   void *state                = NULL;
    driver_t *driver     = driver_get_ptr();
    settings_t *settings = config_get_ptr();
    global_t *global     = global_get_ptr();
@@ -559,13 +1611,26 @@ void init_rewind(void)
    RARCH_LOG(RETRO_MSG_REWIND_INIT "%u MB\n",
          (unsigned)(settings->rewind_buffer_size / 1000000));
 
+   /* The cold tier works in pushed states, not seconds. */
+   fps = global->system.av_info.timing.fps > 0.0 ?
+      global->system.av_info.timing.fps : 60.0;
+   cold_after = settings->rewind_cold_after * fps /
+      (settings->rewind_granularity ? settings->rewind_granularity : 1);
+   keyframe_interval = settings->rewind_keyframe_interval * fps /
+      (settings->rewind_granularity ? settings->rewind_granularity : 1);
+
    global->rewind.state = state_manager_new(global->rewind.size,
-         settings->rewind_buffer_size);
+         settings->rewind_buffer_size, settings->rewind_threaded,
+         cold_after, keyframe_interval);
 
    if (!global->rewind.state)
+   {
       RARCH_WARN(RETRO_LOG_REWIND_INIT_FAILED);
+      return;
+   }
 
    state_manager_push_where(global->rewind.state, &state);
    pretro_serialize(state, global->rewind.size);
    state_manager_push_do(global->rewind.state);
 }
+#endif
@@ -27,12 +27,50 @@ extern "C" {
 
 typedef struct state_manager state_manager_t;
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size);
+state_manager_t *state_manager_new(size_t state_size, size_t buffer_size,
+      bool threaded, unsigned cold_after, unsigned keyframe_interval);
 
 void state_manager_free(state_manager_t *state);
 
 bool state_manager_pop(state_manager_t *state, const void **data);
 
+/**
+ * state_manager_seek:
+ * @state                : state manager handle
+ * @count                : number of states to go back
+ * @data                 : set to the resulting state
+ *
+ * Same as calling state_manager_pop() @count times, but starts 
+ * from the closest keyframe when possible.
+ *
+ * Returns: number of states actually popped.
+ **/
+unsigned state_manager_seek(state_manager_t *state, unsigned count,
+      const void **data);
+
+/**
+ * state_manager_popped_size:
+ * @state                : state manager handle
+ *
+ * Returns: size of the state last returned by state_manager_pop() 
+ * or state_manager_seek(), which may differ from the current size 
+ * if the core's state size changed in between.
+ **/
+size_t state_manager_popped_size(state_manager_t *state);
+
+/**
+ * state_manager_resize:
+ * @state                : state manager handle
+ * @state_size           : new state size
+ *
+ * Sets the size of the states pushed from now on, 
+ * keeping the history.
+ *
+ * Returns: true (1) if successful, otherwise false (0),
+ * in which case the old size is kept.
+ **/
+bool state_manager_resize(state_manager_t *state, size_t state_size);
+
 void state_manager_push_where(state_manager_t *state, void **data);
 
 void state_manager_push_do(state_manager_t *state);
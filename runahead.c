@@ -0,0 +1,480 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <compat/strl.h>
+
+#include "runahead.h"
+#include "dynamic.h"
+#include "general.h"
+#include "runloop.h"
+#include "performance.h"
+#include "file_ops.h"
+#include "core_options.h"
+#include "libretro_version_1.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* State of the frame the core really ran, which it is rolled
+ * back to, or the second instance synced to. */
+static void *runahead_state;
+static size_t runahead_state_size;
+
+/* Set once the core failed to save a state, until it is unloaded. */
+static bool runahead_unsupported;
+
+#ifdef HAVE_DYNAMIC
+/* Another copy of the core, running the same content. It has its
+ * own memory, so it needs a copy of the library file as well,
+ * loading the same file twice only hands out the same library. */
+struct runahead_core
+{
+   dylib_t lib;
+   char path[PATH_MAX_LENGTH];
+   unsigned port_device[MAX_USERS];
+   /* Generation of the core options it last saw. */
+   unsigned options_generation;
+
+   void (*retro_init)(void);
+   void (*retro_deinit)(void);
+   unsigned (*retro_api_version)(void);
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_set_controller_port_device)(unsigned, unsigned);
+   void (*retro_run)(void);
+   bool (*retro_unserialize)(const void*, size_t);
+   bool (*retro_load_game)(const struct retro_game_info*);
+   bool (*retro_load_game_special)(unsigned,
+         const struct retro_game_info*, size_t);
+   void (*retro_unload_game)(void);
+};
+
+#define RUNAHEAD_SYM(core, x) do { \
+   function_t func = dylib_proc((core)->lib, #x); \
+   memcpy(&(core)->x, &func, sizeof(func)); \
+   if ((core)->x == NULL) { RARCH_ERR("Failed to load symbol: \"%s\"\n", #x); goto error; } \
+} while (0)
+
+static struct runahead_core *runahead_secondary;
+
+static void runahead_secondary_audio_sample(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t runahead_secondary_audio_sample_batch(const int16_t *data,
+      size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+/**
+ * runahead_secondary_environment_cb:
+ * @cmd                  : environment command.
+ * @data                 : data of the command.
+ *
+ * Environment callback of the second instance. Questions are
+ * answered like for the main core, but whatever the second
+ * instance sets is ignored, as the main core has set it already.
+ * Interfaces with side effects (rumble, camera, ...) are denied.
+ *
+ * Returns: true (1) if the command is supported, otherwise false (0).
+ **/
+static bool runahead_secondary_environment_cb(unsigned cmd, void *data)
+{
+   global_t *global = global_get_ptr();
+
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_OVERSCAN:
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_CORE_ASSETS_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_LIBRETRO_PATH:
+      case RETRO_ENVIRONMENT_GET_USERNAME:
+      case RETRO_ENVIRONMENT_GET_LANGUAGE:
+      case RETRO_ENVIRONMENT_GET_INPUT_DEVICE_CAPABILITIES:
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+         return rarch_environment_cb(cmd, data);
+
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+      {
+         /* Reading a variable clears the flag for everyone,
+          * so the second instance keeps track of its own. */
+         unsigned generation = core_option_generation(
+               global->system.core_options);
+
+         *(bool*)data = generation != runahead_secondary->options_generation;
+         runahead_secondary->options_generation = generation;
+         break;
+      }
+
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+         return *(const enum retro_pixel_format*)data ==
+            global->system.pix_fmt;
+
+      case RETRO_ENVIRONMENT_SET_ROTATION:
+      case RETRO_ENVIRONMENT_SHUTDOWN:
+      case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+      case RETRO_ENVIRONMENT_SET_MESSAGE:
+      case RETRO_ENVIRONMENT_SET_VARIABLES:
+      case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+      case RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_DISK_CONTROL_INTERFACE:
+      case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+      case RETRO_ENVIRONMENT_SET_AUDIO_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+      case RETRO_ENVIRONMENT_SET_SUBSYSTEM_INFO:
+      case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+      case RETRO_ENVIRONMENT_SET_GEOMETRY:
+         break;
+
+      default:
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * runahead_secondary_free:
+ *
+ * Unloads the second instance and deletes its library copy.
+ **/
+static void runahead_secondary_free(void)
+{
+   if (!runahead_secondary)
+      return;
+
+   if (runahead_secondary->lib)
+      dylib_close(runahead_secondary->lib);
+   remove(runahead_secondary->path);
+
+   free(runahead_secondary);
+   runahead_secondary = NULL;
+}
+
+/**
+ * runahead_secondary_copy_lib:
+ * @core                 : second instance.
+ *
+ * Copies the core library next to extracted content, or next to
+ * the core itself if there is no extraction directory.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool runahead_secondary_copy_lib(struct runahead_core *core)
+{
+   char name[PATH_MAX_LENGTH], dir[PATH_MAX_LENGTH];
+   void *buf            = NULL;
+   ssize_t len          = 0;
+   bool ret             = false;
+   settings_t *settings = config_get_ptr();
+
+   if (*settings->extraction_directory &&
+         path_is_directory(settings->extraction_directory))
+      strlcpy(dir, settings->extraction_directory, sizeof(dir));
+   else
+      fill_pathname_basedir(dir, settings->libretro, sizeof(dir));
+
+   snprintf(name, sizeof(name), "runahead_%s",
+         path_basename(settings->libretro));
+   fill_pathname_join(core->path, dir, name, sizeof(core->path));
+
+   if (!read_file(settings->libretro, &buf, &len) || len <= 0)
+      goto end;
+
+   ret = write_file(core->path, buf, len);
+
+end:
+   free(buf);
+   if (!ret)
+      RARCH_ERR("Failed to copy core to \"%s\".\n", core->path);
+   return ret;
+}
+
+/**
+ * runahead_secondary_sync:
+ * @size                 : size of the state in runahead_state.
+ *
+ * Brings the second instance up to the state of the main core,
+ * including its controllers and core option changes.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool runahead_secondary_sync(size_t size)
+{
+   unsigned i;
+   bool ret;
+   struct runahead_core *core = runahead_secondary;
+   settings_t *settings       = config_get_ptr();
+   global_t   *global         = global_get_ptr();
+
+   for (i = 0; i < MAX_USERS; i++)
+   {
+      unsigned device = settings->input.libretro_device[i];
+
+      /* Unknown devices fall back to the joypad, as for the
+       * main core in event_init_controllers(). */
+      if (device != RETRO_DEVICE_NONE &&
+            (i >= global->system.num_ports ||
+             !libretro_find_controller_description(
+                &global->system.ports[i], device)))
+         device = RETRO_DEVICE_JOYPAD;
+
+      if (device == core->port_device[i])
+         continue;
+
+      core->retro_set_controller_port_device(i, device);
+      core->port_device[i] = device;
+   }
+
+   RARCH_PERFORMANCE_INIT(runahead_secondary_unserialize);
+   RARCH_PERFORMANCE_START(runahead_secondary_unserialize);
+   ret = core->retro_unserialize(runahead_state, size);
+   RARCH_PERFORMANCE_STOP(runahead_secondary_unserialize);
+
+   return ret;
+}
+#endif
+
+bool runahead_load_secondary(const struct retro_subsystem_info *special,
+      const struct retro_game_info *info, size_t num_info)
+{
+#ifdef HAVE_DYNAMIC
+   unsigned i;
+   struct retro_callbacks cbs = {0};
+   struct runahead_core *core = NULL;
+   settings_t *settings       = config_get_ptr();
+   global_t   *global         = global_get_ptr();
+
+   runahead_secondary_free();
+
+   if (!settings->run_ahead_secondary_instance || !*settings->libretro)
+      return false;
+
+   if (global->system.hw_render_callback.context_type
+         != RETRO_HW_CONTEXT_NONE)
+   {
+      RARCH_WARN("Run-ahead can't use a second instance of a hardware rendered core.\n");
+      return false;
+   }
+
+   core = (struct runahead_core*)calloc(1, sizeof(*core));
+   if (!core)
+      return false;
+
+   runahead_secondary = core;
+   core->options_generation = core_option_generation(
+         global->system.core_options);
+
+   if (!runahead_secondary_copy_lib(core))
+      goto error;
+
+   core->lib = dylib_load(core->path);
+   if (!core->lib)
+   {
+      RARCH_ERR("Failed to open dynamic library: \"%s\"\n", core->path);
+      goto error;
+   }
+
+   RUNAHEAD_SYM(core, retro_init);
+   RUNAHEAD_SYM(core, retro_deinit);
+   RUNAHEAD_SYM(core, retro_api_version);
+   RUNAHEAD_SYM(core, retro_set_environment);
+   RUNAHEAD_SYM(core, retro_set_video_refresh);
+   RUNAHEAD_SYM(core, retro_set_audio_sample);
+   RUNAHEAD_SYM(core, retro_set_audio_sample_batch);
+   RUNAHEAD_SYM(core, retro_set_input_poll);
+   RUNAHEAD_SYM(core, retro_set_input_state);
+   RUNAHEAD_SYM(core, retro_set_controller_port_device);
+   RUNAHEAD_SYM(core, retro_run);
+   RUNAHEAD_SYM(core, retro_unserialize);
+   RUNAHEAD_SYM(core, retro_load_game);
+   RUNAHEAD_SYM(core, retro_load_game_special);
+   RUNAHEAD_SYM(core, retro_unload_game);
+
+   if (core->retro_api_version() != RETRO_API_VERSION)
+      goto error;
+
+   core->retro_set_environment(runahead_secondary_environment_cb);
+   core->retro_init();
+
+   /* Shown through the same callbacks, but never heard. */
+   retro_set_default_callbacks(&cbs);
+   core->retro_set_video_refresh(cbs.frame_cb);
+   core->retro_set_audio_sample(runahead_secondary_audio_sample);
+   core->retro_set_audio_sample_batch(runahead_secondary_audio_sample_batch);
+   core->retro_set_input_poll(cbs.poll_cb);
+   core->retro_set_input_state(cbs.state_cb);
+
+   for (i = 0; i < MAX_USERS; i++)
+      core->port_device[i] = RETRO_DEVICE_JOYPAD;
+
+   if (special ? !core->retro_load_game_special(special->id, info, num_info)
+         : !core->retro_load_game(info))
+   {
+      core->retro_deinit();
+      goto error;
+   }
+
+   RARCH_LOG("Loaded second instance of the core for run-ahead.\n");
+   return true;
+
+error:
+   RARCH_WARN("Run-ahead falls back to rolling back the core.\n");
+   runahead_secondary_free();
+#else
+   (void)special;
+   (void)info;
+   (void)num_info;
+#endif
+   return false;
+}
+
+void runahead_deinit(void)
+{
+#ifdef HAVE_DYNAMIC
+   if (runahead_secondary)
+   {
+      runahead_secondary->retro_unload_game();
+      runahead_secondary->retro_deinit();
+   }
+   runahead_secondary_free();
+#endif
+
+   free(runahead_state);
+   runahead_state       = NULL;
+   runahead_state_size  = 0;
+   runahead_unsupported = false;
+}
+
+bool runahead_begin(void)
+{
+   driver_t   *driver   = driver_get_ptr();
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+
+   (void)driver;
+
+   if (!settings->run_ahead_frames || runahead_unsupported)
+      return false;
+
+   /* Neither may see input that is thrown away again. */
+   if (global->rewind.frame_is_reverse || global->bsv.movie)
+      return false;
+#ifdef HAVE_NETPLAY
+   if (driver->netplay_data)
+      return false;
+#endif
+
+   retro_set_frame_output(false, true);
+   return true;
+}
+
+void runahead_end(void)
+{
+   unsigned i;
+   bool saved;
+   size_t size          = pretro_serialize_size();
+   settings_t *settings = config_get_ptr();
+
+   RARCH_PERFORMANCE_INIT(runahead_serialize);
+
+   if (size > runahead_state_size)
+   {
+      void *state = realloc(runahead_state, size);
+
+      if (!state)
+         goto error;
+
+      runahead_state      = state;
+      runahead_state_size = size;
+   }
+
+   RARCH_PERFORMANCE_START(runahead_serialize);
+   saved = size && pretro_serialize(runahead_state, size);
+   RARCH_PERFORMANCE_STOP(runahead_serialize);
+
+   if (!saved)
+      goto error;
+
+#ifdef HAVE_DYNAMIC
+   if (runahead_secondary)
+   {
+      if (runahead_secondary_sync(size))
+      {
+         retro_set_frame_output(false, false);
+
+         for (i = 1; i <= settings->run_ahead_frames; i++)
+         {
+            if (i == settings->run_ahead_frames)
+               retro_set_frame_output(true, false);
+            runahead_secondary->retro_run();
+            retro_flush_input_poll();
+         }
+
+         retro_set_frame_output(true, true);
+         return;
+      }
+
+      RARCH_WARN("Second instance of the core failed to load state, unloading it.\n");
+      runahead_secondary->retro_unload_game();
+      runahead_secondary->retro_deinit();
+      runahead_secondary_free();
+   }
+#endif
+
+   retro_set_frame_output(false, false);
+
+   for (i = 1; i <= settings->run_ahead_frames; i++)
+   {
+      if (i == settings->run_ahead_frames)
+         retro_set_frame_output(true, false);
+      retro_coroutine_run(false);
+      retro_flush_input_poll();
+   }
+
+   retro_set_frame_output(true, true);
+
+   RARCH_PERFORMANCE_INIT(runahead_unserialize);
+   RARCH_PERFORMANCE_START(runahead_unserialize);
+   pretro_unserialize(runahead_state, size);
+   RARCH_PERFORMANCE_STOP(runahead_unserialize);
+   return;
+
+error:
+   RARCH_WARN("Core can't save states, run-ahead is disabled for it.\n");
+   runahead_unsupported = true;
+   retro_set_frame_output(true, true);
+}
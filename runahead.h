@@ -0,0 +1,79 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RUNAHEAD_H
+#define __RARCH_RUNAHEAD_H
+
+#include <stddef.h>
+#include <boolean.h>
+#include "libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * runahead_begin:
+ *
+ * Checks whether this frame is run ahead (run_ahead_frames).
+ * If so, the frame the core runs next is heard, but not seen,
+ * and runahead_end() has to be called right after it.
+ *
+ * Returns: true (1) if the frame is run ahead, otherwise false (0).
+ **/
+bool runahead_begin(void);
+
+/**
+ * runahead_end:
+ *
+ * Saves the state of the frame the core just ran, then runs
+ * run_ahead_frames more frames on the same input, of which only
+ * the last is shown, and none heard. Afterwards the core is back
+ * to the saved state, or never left it if the frames ran on the
+ * second instance.
+ **/
+void runahead_end(void);
+
+/**
+ * runahead_load_secondary:
+ * @special        : subsystem of the content, or NULL.
+ * @info           : content, as just loaded by the main core.
+ * @num_info       : number of entries in @info.
+ *
+ * Loads a second instance of the core with the same content
+ * when run_ahead_secondary_instance is enabled. Only dynamically
+ * loaded cores without hardware rendering can have one,
+ * run-ahead falls back to rolling back the main core otherwise.
+ *
+ * Returns: true (1) if the second instance was loaded,
+ * otherwise false (0).
+ **/
+bool runahead_load_secondary(const struct retro_subsystem_info *special,
+      const struct retro_game_info *info, size_t num_info);
+
+/**
+ * runahead_deinit:
+ *
+ * Frees the second instance of the core and the state buffer.
+ * Called when the core is unloaded.
+ **/
+void runahead_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,7 +25,15 @@
 #include "retroarch.h"
 #include "runloop.h"
 #include "runloop_data.h"
+#include "libretro_version_1.h"
+#include "runahead.h"
+#include "cheat_search.h"
 #include "input/keyboard_line.h"
+#include "gfx/video_monitor.h"
+
+#ifdef HAVE_SHM
+#include "shm_export.h"
+#endif
 
 #ifdef HAVE_MENU
 #include "menu/menu.h"
@@ -35,6 +43,12 @@
 #include "netplay.h"
 #endif
 
+/* Same limit as video_frame_delay. */
+#define FRAME_DELAY_MAX_MSEC 15
+/* Headroom automatic frame delay leaves for polling, presenting 
+ * and oversleeping. */
+#define FRAME_DELAY_AUTO_MARGIN_USEC 2000
+
 static struct runloop *g_runloop;
 
 static struct global *g_extern;
@@ -142,24 +156,64 @@ static void check_stateslots(bool pressed_increase, bool pressed_decrease)
    RARCH_LOG("%s\n", msg);
 }
 
-static INLINE void setup_rewind_audio(void)
+/**
+ * setup_rewind_audio:
+ * @frames               : number of frames that were just rewound.
+ *
+ * Sets up the audio to play for a rewound frame. Plays the
+ * history of forward audio in reverse, skipping ahead to keep up 
+ * with @frames. Once the history has run dry, the audio the core 
+ * renders for the rewound frame is reversed instead.
+ *
+ * Forward audio still batched up from the per-sample callback
+ * is flushed first, so it is played and in the history.
+ **/
+static INLINE void setup_rewind_audio(unsigned frames)
 {
    unsigned i;
+   double fps;
+   size_t out_frames, step, ptr;
    global_t *global = global_get_ptr();
+   size_t size      = global->audio_data.rewind_history_size;
+
+   /* The audio thread owns the batch with an audio callback. */
+   if (!global->system.audio_callback.callback)
+      retro_flush_audio_samples(true);
 
    /* Push audio ready to be played. */
    global->audio_data.rewind_ptr = global->audio_data.rewind_size;
 
-   for (i = 0; i < global->audio_data.data_ptr; i += 2)
+   fps = global->system.av_info.timing.fps > 0.0 ?
+      global->system.av_info.timing.fps : 60.0;
+   step       = frames ? frames : 1;
+   out_frames = global->audio_data.in_rate / fps;
+   if (out_frames > global->audio_data.rewind_size / 2)
+      out_frames = global->audio_data.rewind_size / 2;
+   if (out_frames * step * 2 > global->audio_data.rewind_history_avail)
+      out_frames = global->audio_data.rewind_history_avail / (step * 2);
+
+   global->audio_data.rewind_from_history = out_frames != 0;
+
+   if (global->audio_data.rewind_from_history)
    {
-      global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] =
-         global->audio_data.conv_outsamples[i + 1];
+      /* Oldest first, the buffer is played back from rewind_ptr up. */
+      ptr = (global->audio_data.rewind_history_ptr + size -
+            (out_frames * step * 2) % size) % size;
 
-      global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] =
-         global->audio_data.conv_outsamples[i + 0];
-   }
+      for (i = 0; i < out_frames; i++)
+      {
+         global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] =
+            global->audio_data.rewind_history[ptr + 1];
+         global->audio_data.rewind_buf[--global->audio_data.rewind_ptr] =
+            global->audio_data.rewind_history[ptr + 0];
+         ptr = (ptr + step * 2) % size;
+      }
 
-   global->audio_data.data_ptr = 0;
+      global->audio_data.rewind_history_ptr    = (
+            global->audio_data.rewind_history_ptr + size - 
+            (out_frames * step * 2) % size) % size;
+      global->audio_data.rewind_history_avail -= out_frames * step * 2;
+   }
 }
 
 /**
@@ -180,7 +234,8 @@ static void check_rewind(bool pressed)
             + global->audio_data.rewind_ptr,
             global->audio_data.rewind_size - global->audio_data.rewind_ptr);
 
-      global->rewind.frame_is_reverse = false;
+      global->rewind.frame_is_reverse          = false;
+      global->audio_data.rewind_from_history = false;
    }
 
    if (first)
@@ -192,19 +247,66 @@ static void check_rewind(bool pressed)
    if (!global->rewind.state)
       return;
 
+   /* Movies can only be rewound one frame at a time. */
+   if (global->rewind.seek && !global->bsv.movie)
+   {
+      const void *buf = NULL;
+      unsigned popped = state_manager_seek(global->rewind.state,
+            global->rewind.seek, &buf);
+
+      if (popped)
+      {
+         char msg[64];
+
+         pretro_unserialize(buf,
+               state_manager_popped_size(global->rewind.state));
+         snprintf(msg, sizeof(msg), "Rewound %u states.", popped);
+         rarch_main_msg_queue_push(msg, 0, 60, true);
+      }
+      else
+         rarch_main_msg_queue_push(RETRO_MSG_REWIND_REACHED_END,
+               0, 30, true);
+   }
+   global->rewind.seek = 0;
+
    if (pressed)
    {
-      const void *buf    = NULL;
-      runloop_t *runloop = rarch_main_get_ptr();
+      double fps;
+      retro_time_t start, budget;
+      unsigned popped      = 0;
+      const void *buf      = NULL;
+      runloop_t *runloop   = rarch_main_get_ptr();
+      settings_t *settings = config_get_ptr();
+      unsigned speed       = settings->rewind_speed ?
+         settings->rewind_speed : 1;
+
+      /* Movies can only be rewound one frame at a time. */
+      if (global->bsv.movie)
+         speed = 1;
+
+      /* Leave at least half the frame to the core and the drivers. */
+      fps    = global->system.av_info.timing.fps > 0.0 ?
+         global->system.av_info.timing.fps : 60.0;
+      budget = 500000.0 / fps;
+      start  = rarch_get_time_usec();
+
+      while (popped < speed && state_manager_pop(global->rewind.state, &buf))
+      {
+         popped++;
+         if (rarch_get_time_usec() - start > budget)
+            break;
+      }
 
-      if (state_manager_pop(global->rewind.state, &buf))
+      if (popped)
       {
          global->rewind.frame_is_reverse = true;
-         setup_rewind_audio();
+         setup_rewind_audio(popped * (settings->rewind_granularity ?
+                  settings->rewind_granularity : 1));
 
          rarch_main_msg_queue_push(RETRO_MSG_REWINDING, 0,
                runloop->is_paused ? 1 : 30, true);
-         pretro_unserialize(buf, global->rewind.size);
+         pretro_unserialize(buf,
+               state_manager_popped_size(global->rewind.state));
 
          if (global->bsv.movie)
             bsv_movie_frame_rewind(global->bsv.movie);
@@ -224,6 +326,25 @@ static void check_rewind(bool pressed)
       if ((cnt == 0) || global->bsv.movie)
       {
          void *state = NULL;
+         size_t size = pretro_serialize_size();
+
+         /* Some cores change their state size at runtime,
+          * e.g. when swapping disks. */
+         if (size != global->rewind.size)
+         {
+            if (!size || !state_manager_resize(global->rewind.state, size))
+            {
+               RARCH_WARN("Failed to resize rewind buffer to %u bytes.\n",
+                     (unsigned)size);
+               retro_set_rewind_callbacks();
+               return;
+            }
+
+            RARCH_LOG("Rewind state size changed to %u bytes.\n",
+                  (unsigned)size);
+            global->rewind.size = size;
+         }
+
          state_manager_push_where(global->rewind.state, &state);
 
          RARCH_PERFORMANCE_INIT(rewind_serialize);
@@ -608,6 +729,7 @@ static int do_state_checks(event_cmd_state_t *cmd)
  * c) Frame count exceeds or equals maximum amount of frames to run.
  * d) Video driver no longer alive.
  * e) End of BSV movie and BSV EOF exit is true. (TODO/FIXME - explain better)
+ * f) All frames of --benchmark were run.
  *
  * Returns: 1 if any of the above conditions are true, otherwise 0.
  **/
@@ -620,9 +742,11 @@ static INLINE int time_to_exit(event_cmd_state_t *cmd)
    bool movie_end                = (global->bsv.movie_end && global->bsv.eof_exit);
    bool frame_count_end          = (runloop->frames.video.max && 
          runloop->frames.video.count >= runloop->frames.video.max);
+   bool benchmark_end            = (global->benchmark.frames &&
+         global->benchmark.count >= global->benchmark.frames);
 
    if (shutdown_pressed || cmd->quit_key_pressed || frame_count_end || movie_end
-         || !video_alive)
+         || benchmark_end || !video_alive)
       return 1;
    return 0;
 }
@@ -659,40 +783,205 @@ static void rarch_update_frame_time(void)
 }
 
 
+/* rarch_limit_frame_time() sleeps until this long before the
+ * target time and spins for the rest, as sleeps can overshoot
+ * by a scheduler tick. */
+#define FRAME_LIMIT_SPIN_USEC 2000
+
 /**
  * rarch_limit_frame_time:
  *
- * Limit frame time if fast forward ratio throttle is enabled.
+ * Limits frame time to the core's frame rate with variable
+ * refresh rate, or to its fast forward ratio if fast forward
+ * ratio throttle is enabled.
  **/
 static void rarch_limit_frame_time(void)
 {
-   retro_time_t target      = 0;
-   retro_time_t to_sleep_ms = 0;
+   enum rarch_zone zone;
+   double ratio;
+   retro_time_t target, now;
    runloop_t *runloop       = rarch_main_get_ptr();
+   driver_t *driver         = driver_get_ptr();
    settings_t *settings     = config_get_ptr();
    global_t  *global        = global_get_ptr();
    retro_time_t current     = rarch_get_time_usec();
-   double effective_fps     = global->system.av_info.timing.fps 
-      * settings->fastforward_ratio;
-   double mft_f             = 1000000.0f / effective_fps;
 
-   runloop->frames.limit.minimum_time = (retro_time_t) roundf(mft_f);
+   if (settings->video.vrr_enable && !driver->nonblock_state)
+      ratio = 1.0;
+   else if (settings->fastforward_ratio_throttle_enable)
+      ratio = settings->fastforward_ratio;
+   else
+      return;
+
+   if (global->system.av_info.timing.fps <= 0.0)
+      return;
+
+   runloop->frames.limit.minimum_time = (retro_time_t)
+      (1000000.0 / (global->system.av_info.timing.fps * ratio) + 0.5);
 
-   target        = runloop->frames.limit.last_time + 
-                   runloop->frames.limit.minimum_time;
-   to_sleep_ms   = (target - current) / 1000;
+   target = runloop->frames.limit.last_time + 
+            runloop->frames.limit.minimum_time;
 
-   if (to_sleep_ms <= 0)
+   if (current >= target)
    {
-      runloop->frames.limit.last_time = rarch_get_time_usec();
+      /* Late frames keep the cadence, unless a whole frame late. */
+      runloop->frames.limit.last_time = 
+         current - target < runloop->frames.limit.minimum_time ?
+         target : current;
       return;
    }
 
-   rarch_sleep((unsigned int)to_sleep_ms);
+   zone = rarch_zone_enter(RARCH_ZONE_IDLE);
+   for (now = current; now < target; now = rarch_get_time_usec())
+   {
+      if (target - now >= FRAME_LIMIT_SPIN_USEC + 1000)
+         rarch_sleep((unsigned)((target - now - FRAME_LIMIT_SPIN_USEC) / 1000));
+   }
+   rarch_zone_enter(zone);
+   video_monitor_frame_time_add(VIDEO_MONITOR_STAGE_WAIT, now - current);
 
-   /* Combat jitter a bit. */
-   runloop->frames.limit.last_time += 
-      runloop->frames.limit.minimum_time;
+   runloop->frames.limit.last_time = target;
+}
+
+/**
+ * rarch_get_frame_delay:
+ *
+ * Gets how many milliseconds to sleep after VSync before 
+ * running the core. With automatic frame delay, this is 
+ * what's left of the VSync period after the estimated time 
+ * the core needs for a frame, so input is polled as late 
+ * as possible.
+ *
+ * Returns: frame delay in milliseconds.
+ **/
+static unsigned rarch_get_frame_delay(void)
+{
+   retro_time_t period, delay;
+   runloop_t *runloop   = rarch_main_get_ptr();
+   driver_t *driver     = driver_get_ptr();
+   settings_t *settings = config_get_ptr();
+
+   if (driver->nonblock_state)
+      return 0;
+
+   if (!settings->video.frame_delay_auto)
+      return settings->video.frame_delay;
+
+   /* Sleeping only helps when the main thread blocks on VSync. */
+   if (!settings->video.vsync || settings->video.threaded
+         || settings->video.refresh_rate <= 0.0f)
+      return 0;
+
+   period = (retro_time_t)(1000000.0f * settings->video.swap_interval 
+         / settings->video.refresh_rate);
+   delay  = period - runloop->frames.delay.estimate 
+      - FRAME_DELAY_AUTO_MARGIN_USEC;
+
+   if (delay <= 0)
+      return 0;
+   if (delay > FRAME_DELAY_MAX_MSEC * 1000)
+      return FRAME_DELAY_MAX_MSEC;
+   return delay / 1000;
+}
+
+/**
+ * rarch_update_frame_skip:
+ *
+ * While fast forwarding, checks whether the frame about to run
+ * comes sooner than the display can show it. If so, it is
+ * neither shown nor heard, and all video and audio work on it
+ * is skipped, down to the core's own rendering if it asks
+ * with RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE.
+ **/
+static void rarch_update_frame_skip(void)
+{
+   retro_time_t now, interval;
+   runloop_t *runloop   = rarch_main_get_ptr();
+   driver_t *driver     = driver_get_ptr();
+   settings_t *settings = config_get_ptr();
+
+   /* Recordings get every frame. */
+   if (!settings->fastforward_frameskip || !driver->nonblock_state
+         || driver->recording_data || settings->video.refresh_rate <= 0.0f)
+      return;
+
+   now      = rarch_get_time_usec();
+   interval = (retro_time_t)(1000000.0f / settings->video.refresh_rate);
+
+   if (now - runloop->frames.skip.last_time < interval)
+   {
+      retro_set_frame_skip(true);
+      return;
+   }
+
+   runloop->frames.skip.last_time = now;
+}
+
+/**
+ * rarch_run_core:
+ * @delay                : frame delay to spend at the core's input
+ *                         poll, in milliseconds, or 0.
+ *
+ * Runs the core for one frame. With a delay, the core runs on its
+ * coroutine until it polls input, and only waits there for what is
+ * left of the delay. Its work before the poll then fits in the
+ * delay, instead of adding to the time input waits to be used.
+ **/
+static void rarch_run_core(unsigned delay)
+{
+   retro_time_t start, left;
+   runloop_t *runloop = rarch_main_get_ptr();
+
+   if (!delay)
+   {
+      retro_coroutine_run(false);
+      return;
+   }
+
+   start = rarch_get_time_usec();
+
+   if (retro_coroutine_run(true))
+      return;
+
+   left = delay * 1000LL - (rarch_get_time_usec() - start);
+
+   if (left >= 1000)
+   {
+      retro_time_t slept   = rarch_get_time_usec();
+      enum rarch_zone zone = rarch_zone_enter(RARCH_ZONE_IDLE);
+
+      rarch_sleep((unsigned)(left / 1000));
+      rarch_zone_enter(zone);
+
+      /* Automatic frame delay times the core, not the wait. */
+      slept = rarch_get_time_usec() - slept;
+      runloop->frames.delay.run_start += slept;
+      video_monitor_frame_time_add(VIDEO_MONITOR_STAGE_WAIT, slept);
+   }
+
+   retro_coroutine_run(false);
+}
+
+/**
+ * rarch_update_frame_delay:
+ *
+ * Updates the estimated time the core takes to produce a frame 
+ * with the frame it just ran. Slow frames raise the estimate 
+ * at once so we back off before stuttering, fast frames only 
+ * lower it gradually.
+ **/
+static void rarch_update_frame_delay(void)
+{
+   runloop_t *runloop  = rarch_main_get_ptr();
+   retro_time_t end    = runloop->frames.delay.video_time ?
+      runloop->frames.delay.video_time : rarch_get_time_usec();
+   retro_time_t sample = end - runloop->frames.delay.run_start;
+
+   if (sample > runloop->frames.delay.estimate)
+      runloop->frames.delay.estimate  = sample;
+   else
+      runloop->frames.delay.estimate -= 
+         (runloop->frames.delay.estimate - sample) / 16;
 }
 
 /**
@@ -905,6 +1194,10 @@ void rarch_main_msg_queue_push(const char *msg, unsigned prio, unsigned duration
    if (flush)
       msg_queue_clear(runloop->msg_queue);
    msg_queue_push(runloop->msg_queue, msg, prio, duration);
+
+   /* A throttled menu has to keep drawing until the message expired. */
+   if (duration > runloop->frames.video.current.menu.msg.frames)
+      runloop->frames.video.current.menu.msg.frames = duration;
 }
 
 void rarch_main_msg_queue_free(void)
@@ -1077,18 +1370,28 @@ static void rarch_main_cmd_get_state(event_cmd_state_t *cmd,
  **/
 int rarch_main_iterate(void)
 {
-   unsigned i;
+   unsigned i, delay;
+   bool yield_delay, run_ahead;
    retro_input_t trigger_input;
    event_cmd_state_t    cmd        = {0};
    runloop_t *runloop              = rarch_main_get_ptr();
    int ret                         = 0;
    static retro_input_t last_input = 0;
    retro_input_t old_input         = last_input;
-   retro_input_t input             = input_keys_pressed();
-   last_input                      = input;
+   retro_input_t input             = 0;
    driver_t *driver                = driver_get_ptr();
    settings_t *settings            = config_get_ptr();
    global_t   *global              = global_get_ptr();
+   RARCH_PERFORMANCE_INIT(core_run);
+
+#if defined(HAVE_COMMAND) && defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   /* Before reading input, so hotkeys sent this way count now. */
+   if (driver->command)
+      rarch_cmd_poll_binary(driver->command);
+#endif
+
+   input      = input_keys_pressed();
+   last_input = input;
 
    if (driver->flushing_input)
       driver->flushing_input = (input) ? input_flush(&input) : false;
@@ -1109,15 +1412,28 @@ int rarch_main_iterate(void)
    rarch_main_iterate_linefeed_overlay();
 #endif
    
+   rarch_zone_enter(RARCH_ZONE_DATA);
    rarch_main_data_iterate();
+   rarch_zone_enter(RARCH_ZONE_FRONTEND);
 
 #ifdef HAVE_MENU
    if (runloop->is_menu)
    {
       menu_handle_t *menu = menu_driver_get_ptr();
       if (menu)
-         if (menu_iterate(input, old_input, trigger_input) == -1)
+      {
+         int ret_menu;
+
+         RARCH_PERFORMANCE_INIT(menu_frame);
+         RARCH_PERFORMANCE_START(menu_frame);
+         rarch_zone_enter(RARCH_ZONE_MENU);
+         ret_menu = menu_iterate(input, old_input, trigger_input);
+         rarch_zone_enter(RARCH_ZONE_FRONTEND);
+         RARCH_PERFORMANCE_STOP(menu_frame);
+
+         if (ret_menu == -1)
             rarch_main_set_state(RARCH_ACTION_STATE_MENU_RUNNING_FINISHED);
+      }
 
       if (!input && settings->menu.pause_libretro)
         ret = 1;
@@ -1135,23 +1451,39 @@ int rarch_main_iterate(void)
    {
       /* RetroArch has been paused */
       driver->retro_ctx.poll_cb();
+      rarch_zone_enter(RARCH_ZONE_IDLE);
       rarch_sleep(10);
+      rarch_zone_enter(RARCH_ZONE_FRONTEND);
 
       return 1;
    }
 
+   init_drivers_deferred();
+
 #if defined(HAVE_THREADS)
    lock_autosave();
 #endif
 
 #ifdef HAVE_NETPLAY
-   if (driver->netplay_data)
-      netplay_pre_frame((netplay_t*)driver->netplay_data);
+   if (driver->netplay_data 
+         && !netplay_pre_frame((netplay_t*)driver->netplay_data))
+   {
+      /* Waiting for input of the other users, 
+       * keep presenting the last frame meanwhile. */
+#if defined(HAVE_THREADS)
+      unlock_autosave();
+#endif
+      rarch_render_cached_frame();
+      rarch_sleep(1);
+      goto success;
+   }
 #endif
 
    if (global->bsv.movie)
       bsv_movie_set_frame_start(global->bsv.movie);
 
+   cheat_search_poke_apply();
+
    if (global->system.camera_callback.caps)
       driver_camera_poll();
 
@@ -1167,12 +1499,59 @@ int rarch_main_iterate(void)
             settings->input.analog_dpad_mode[i]);
    }
 
-   if ((settings->video.frame_delay > 0) && !driver->nonblock_state)
-      rarch_sleep(settings->video.frame_delay);
+   delay       = rarch_get_frame_delay();
+   yield_delay = settings->input.poll_yield && retro_coroutine_init();
+   if (delay > 0 && !yield_delay)
+   {
+      retro_time_t slept = rarch_get_time_usec();
+
+      rarch_zone_enter(RARCH_ZONE_IDLE);
+      rarch_sleep(delay);
+      rarch_zone_enter(RARCH_ZONE_FRONTEND);
+      video_monitor_frame_time_add(VIDEO_MONITOR_STAGE_WAIT,
+            rarch_get_time_usec() - slept);
+   }
+
+   rarch_update_frame_skip();
+   run_ahead   = runahead_begin();
 
+   if (global->benchmark.frames && !global->benchmark.count)
+   {
+      global->benchmark.start_usec  = rarch_get_time_usec();
+      global->benchmark.start_ticks = rarch_get_perf_counter();
+   }
+
+   RARCH_PERFORMANCE_START(core_run);
+   video_monitor_frame_time_core_begin();
+   rarch_zone_enter(RARCH_ZONE_CORE);
 
    /* Run libretro for one frame. */
-   pretro_run();
+   if (settings->video.frame_delay_auto)
+   {
+      runloop->frames.delay.run_start  = rarch_get_time_usec();
+      runloop->frames.delay.video_time = 0;
+      rarch_run_core(yield_delay ? delay : 0);
+      if (run_ahead)
+         runahead_end();
+      rarch_update_frame_delay();
+   }
+   else
+   {
+      rarch_run_core(yield_delay ? delay : 0);
+      if (run_ahead)
+         runahead_end();
+   }
+
+   rarch_zone_enter(RARCH_ZONE_FRONTEND);
+   video_monitor_frame_time_core_end();
+   RARCH_PERFORMANCE_STOP(core_run);
+
+   retro_set_frame_skip(false);
+
+   if (!global->system.audio_callback.callback)
+      retro_flush_audio_samples(false);
+
+   retro_flush_input_poll();
 
    for (i = 0; i < settings->input.max_users; i++)
    {
@@ -1191,13 +1570,25 @@ int rarch_main_iterate(void)
       netplay_post_frame((netplay_t*)driver->netplay_data);
 #endif
 
+#ifdef HAVE_SHM
+   shm_export_commit();
+#endif
+
 #if defined(HAVE_THREADS)
    unlock_autosave();
 #endif
 
+   if (global->benchmark.frames &&
+         ++global->benchmark.count == global->benchmark.frames)
+      rarch_benchmark_report(stdout, global->benchmark.count,
+            rarch_get_time_usec() - global->benchmark.start_usec,
+            rarch_get_perf_counter() - global->benchmark.start_ticks);
+
 success:
-   if (settings->fastforward_ratio_throttle_enable)
+   if (!global->benchmark.frames)
       rarch_limit_frame_time();
 
+   video_monitor_frame_time_commit();
+
    return ret;
 }
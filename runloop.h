@@ -75,6 +75,18 @@ typedef struct runloop
                   bool dirty;
                } framebuf;
 
+               struct
+               {
+                  /* Frames the last OSD message still has to be shown for. */
+                  unsigned frames;
+               } msg;
+
+               struct
+               {
+                  /* When the menu was last drawn with nothing changing. */
+                  retro_time_t time;
+               } idle;
+
                struct
                {
                   bool active;
@@ -88,6 +100,22 @@ typedef struct runloop
          retro_time_t minimum_time;
          retro_time_t last_time;
       } limit;
+
+      struct
+      {
+         /* When the core started running this frame, 
+          * and when it handed over its video. */
+         retro_time_t run_start;
+         retro_time_t video_time;
+         /* How long the core takes to produce a frame. */
+         retro_time_t estimate;
+      } delay;
+
+      struct
+      {
+         /* When fast forward last showed a frame. */
+         retro_time_t last_time;
+      } skip;
    } frames;
 
    struct
@@ -97,6 +125,10 @@ typedef struct runloop
 
       retro_time_t frame_time_samples[MEASURE_FRAME_TIME_SAMPLES_COUNT];
       uint64_t frame_time_samples_count;
+      /* Set once the context reports when frames were shown,
+       * see video_monitor_frame_presented(). */
+      bool frame_time_presented;
+      retro_time_t last_presented;
    } measure_data;
 
    msg_queue_t *msg_queue;
@@ -139,7 +171,10 @@ typedef struct global
    bool has_set_username;
    bool has_set_netplay_ip_address;
    bool has_set_netplay_delay_frames;
+   bool has_set_netplay_input_delay_frames;
+   bool has_set_netplay_users;
    bool has_set_netplay_ip_port;
+   bool has_set_netplay_rendezvous;
 
    bool has_set_ups_pref;
    bool has_set_bps_pref;
@@ -207,6 +242,8 @@ typedef struct global
       bool block_extract;
       bool force_nonblock;
       bool no_content;
+      /* Core applies retro_cheat_set() calls one by one. */
+      bool cheat_incremental;
 
       const char *input_desc_btn[MAX_USERS][RARCH_FIRST_META_KEY];
       char valid_extensions[PATH_MAX_LENGTH];
@@ -236,7 +273,12 @@ typedef struct global
    {
       float *data;
 
+      /* Samples from the per-sample callback, batched up 
+       * until the end of retro_run(). */
+      int16_t *sample_buf;
+      size_t sample_buf_size;
       size_t data_ptr;
+      /* Least amount of samples worth a flush at the end of a frame. */
       size_t chunk_size;
       size_t nonblock_chunk_size;
       size_t block_chunk_size;
@@ -253,12 +295,34 @@ typedef struct global
       size_t rewind_ptr;
       size_t rewind_size;
 
+      /* Ring of the most recent audio played forward,
+       * played back in reverse while rewinding. */
+      int16_t *rewind_history;
+      size_t rewind_history_size;
+      size_t rewind_history_ptr;
+      size_t rewind_history_avail;
+      /* Rewind audio comes from the history, drop what the core renders. */
+      bool rewind_from_history;
+
       rarch_dsp_filter_t *dsp;
+      /* DSP, resampling and driver writes happen on
+       * the thread from audio_thread_dsp_init(). */
+      bool threaded_dsp;
 
       bool rate_control; 
       double orig_src_ratio;
       size_t driver_buffer_size;
 
+      /* State of the rate control loop, see 
+       * audio_driver_readjust_input_rate(). */
+      double rate_control_error;
+      double rate_control_integral;
+      size_t last_write_size;
+      /* Times the driver buffer was found empty, or too 
+       * full to take the previous write without blocking. */
+      unsigned underruns;
+      unsigned overruns;
+
       float volume_gain;
    } audio_data;
 
@@ -290,6 +354,8 @@ typedef struct global
       state_manager_t *state;
       size_t size;
       bool frame_is_reverse;
+      /* Pushed states to jump back on the next frame. */
+      unsigned seek;
    } rewind;
 
    struct
@@ -307,6 +373,17 @@ typedef struct global
       bool movie_end;
    } bsv;
 
+   struct
+   {
+      /* --benchmark: frames to run, and how many ran so far. */
+      unsigned frames;
+      unsigned count;
+      /* --benchmark-drivers: keep the configured drivers. */
+      bool real_drivers;
+      retro_time_t start_usec;
+      retro_perf_tick_t start_ticks;
+   } benchmark;
+
    bool sram_load_disable;
    bool sram_save_disable;
    bool use_sram;
@@ -328,7 +405,10 @@ typedef struct global
    bool netplay_is_client;
    bool netplay_is_spectate;
    unsigned netplay_sync_frames;
+   unsigned netplay_input_delay_frames;
+   unsigned netplay_users;
    unsigned netplay_port;
+   char netplay_rendezvous[PATH_MAX_LENGTH];
 #endif
 
    /* Recording. */
@@ -343,6 +423,11 @@ typedef struct global
       uint8_t *gpu_buffer;
       size_t gpu_width;
       size_t gpu_height;
+      /* gpu_buffer holds YUV 4:2:0 of this size, scaled and 
+       * converted by the video driver. */
+      bool gpu_yuv420;
+      unsigned gpu_yuv420_width;
+      unsigned gpu_yuv420_height;
       char output_dir[PATH_MAX_LENGTH];
       char config_dir[PATH_MAX_LENGTH];
       bool use_output_dir;
@@ -354,6 +439,8 @@ typedef struct global
       unsigned width;
       unsigned height;
       size_t pitch;
+      /* The cached frame is being presented again. */
+      bool redraw;
    } frame_cache;
 
 
@@ -448,6 +535,8 @@ global_t *global_get_ptr(void);
  **/
 int rarch_main_iterate(void);
 
+/* Safe to call from any thread, e.g. to report 
+ * progress from the data runloop. */
 void rarch_main_msg_queue_push(const char *msg, unsigned prio,
       unsigned duration, bool flush);
 
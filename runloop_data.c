@@ -14,9 +14,15 @@
  */
 
 #include <retro_miscellaneous.h>
+#include <file/dir_list.h>
+#include <file/file_path.h>
 #include "runloop_data.h"
 #include "general.h"
+#include "performance.h"
+#include "file_ops.h"
 #include "input/input_overlay.h"
+#include "screenshot.h"
+#include "intl/intl.h"
 
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
@@ -37,7 +43,11 @@ enum
    HTTP_STATUS_TRANSFER_PARSE_FREE,
 } http_status_enum;
 
-typedef struct http_handle
+/* Transfers running at the same time. Connections to 
+ * the same server are reused once a transfer is done. */
+#define HTTP_MAX_TRANSFERS 4
+
+typedef struct http_transfer
 {
    struct
    {
@@ -45,10 +55,19 @@ typedef struct http_handle
       transfer_cb_t  cb;
       char elem1[PATH_MAX_LENGTH];
    } connection;
-   msg_queue_t *msg_queue;
    struct http_t *handle;
    transfer_cb_t  cb;
+   /* File the body is streamed to, empty to keep it in 
+    * memory. Written as path_tmp until complete. */
+   char path[PATH_MAX_LENGTH];
+   char path_tmp[PATH_MAX_LENGTH + sizeof(".part")];
    unsigned status;
+} http_transfer_t;
+
+typedef struct http_handle
+{
+   http_transfer_t transfers[HTTP_MAX_TRANSFERS];
+   msg_queue_t *msg_queue;
 } http_handle_t;
 #endif
 
@@ -101,6 +120,78 @@ typedef struct nbio_handle
    unsigned status;
 } nbio_handle_t;
 
+typedef struct state_save_handle
+{
+   char path[PATH_MAX_LENGTH];
+   char msg[PATH_MAX_LENGTH];
+   void *data;
+   size_t size;
+   bool is_pending;
+} state_save_handle_t;
+
+typedef struct screenshot_handle
+{
+   char path[PATH_MAX_LENGTH];
+   /* BGR24, top row first. */
+   uint8_t *data;
+   unsigned width;
+   unsigned height;
+   bool is_pending;
+} screenshot_handle_t;
+
+/* Directory entries read per chunk, and how long a frame may
+ * keep reading chunks before the rest is left to the next one. */
+#define DIR_LIST_CHUNK_SIZE     64
+#define DIR_LIST_FRAME_USEC  10000
+
+typedef struct dir_list_handle
+{
+   struct dir_list_reader *reader;
+   /* Every entry read so far, sorted once the reader is done. */
+   struct string_list *list;
+   /* Entries of list already handed out by rarch_main_data_dir_list_poll. */
+   size_t taken;
+   /* Bumped whenever the listing is replaced or cancelled. */
+   unsigned id;
+   bool is_busy;
+   bool is_finished;
+} dir_list_handle_t;
+
+#ifdef HAVE_RPNG
+/* Thumbnails waiting to be decoded, decoded thumbnails waiting
+ * to be pulled, and how long a frame may keep decoding. */
+#define THUMBNAIL_QUEUE_SIZE   32
+#define THUMBNAIL_DONE_SIZE     4
+#define THUMBNAIL_FRAME_USEC 4000
+
+typedef struct thumbnail_result
+{
+   char path[PATH_MAX_LENGTH];
+   struct texture_image ti;
+   bool success;
+} thumbnail_result_t;
+
+typedef struct thumbnail_handle
+{
+   /* Requested thumbnails, oldest first. */
+   char queue[THUMBNAIL_QUEUE_SIZE][PATH_MAX_LENGTH];
+   unsigned queue_size;
+   thumbnail_result_t done[THUMBNAIL_DONE_SIZE];
+   unsigned done_size;
+
+   /* Thumbnail being decoded. Only path and is_cancelled are
+    * shared with the main thread, the decoder state belongs
+    * to the data runloop. */
+   char path[PATH_MAX_LENGTH];
+   bool is_cancelled;
+   struct rpng_t *handle;
+   uint8_t *buf;
+   uint8_t *buf_end;
+   bool is_processing;
+   struct texture_image ti;
+} thumbnail_handle_t;
+#endif
+
 typedef struct db_handle
 {
    msg_queue_t *msg_queue;
@@ -125,6 +216,12 @@ typedef struct data_runloop
 #endif
 
    nbio_handle_t nbio;
+   state_save_handle_t state_save;
+   screenshot_handle_t screenshot;
+   dir_list_handle_t dir_list;
+#ifdef HAVE_RPNG
+   thumbnail_handle_t thumbnail;
+#endif
    bool inited;
 
 #ifdef HAVE_THREADS
@@ -135,6 +232,8 @@ typedef struct data_runloop
    slock_t *lock;
    slock_t *cond_lock;
    slock_t *overlay_lock;
+   slock_t *dir_list_lock;
+   slock_t *thumbnail_lock;
    scond_t *cond;
    sthread_t *thread;
 #endif
@@ -155,96 +254,134 @@ int cb_core_updater_list(void *data_, size_t len);
 
 /**
  * rarch_main_data_http_iterate_transfer:
+ * @transfer             : HTTP transfer.
+ * @pos                  : Bytes received so far are added to this.
+ * @tot                  : Total size is added to this, if known.
  *
  * Resumes HTTP transfer update.
  *
  * Returns: 0 when finished, -1 when we should continue
  * with the transfer on the next frame.
  **/
-static int rarch_main_data_http_iterate_transfer(http_handle_t *http)
+static int rarch_main_data_http_iterate_transfer(http_transfer_t *transfer,
+      size_t *pos, size_t *tot)
 {
-   size_t pos = 0, tot = 0;
-   int percent = 0;
-   if (!net_http_update(http->handle, &pos, &tot))
-   {
-      if(tot != 0)
-         percent=(unsigned long long)pos*100/(unsigned long long)tot;
-      else
-         percent=0;   
-
-      if (percent > 0)
-      {
-         snprintf(data_runloop_msg,
-               sizeof(data_runloop_msg), "Download progress: %d%%", percent);
-      }
+   size_t this_pos = 0, this_tot = 0;
 
-      return -1;
-   }
+   if (net_http_update(transfer->handle, &this_pos, &this_tot))
+      return 0;
 
-   return 0;
+   *pos += this_pos;
+   *tot += this_tot;
+   return -1;
 }
 
-static int rarch_main_data_http_con_iterate_transfer(http_handle_t *http)
+static int rarch_main_data_http_con_iterate_transfer(http_transfer_t *transfer)
 {
-   if (!net_http_connection_iterate(http->connection.handle))
+   if (!net_http_connection_iterate(transfer->connection.handle))
       return -1;
    return 0;
 }
 
-static int rarch_main_data_http_conn_iterate_transfer_parse(http_handle_t *http)
+static int rarch_main_data_http_conn_iterate_transfer_parse(
+      http_transfer_t *transfer)
 {
-   if (net_http_connection_done(http->connection.handle))
+   int ret = -1;
+
+   if (net_http_connection_done(transfer->connection.handle))
    {
-      if (http->connection.handle && http->connection.cb)
-         http->connection.cb(http, 0);
+      if (transfer->connection.handle && transfer->connection.cb)
+         ret = transfer->connection.cb(transfer, 0);
    }
    
-   net_http_connection_free(http->connection.handle);
+   net_http_connection_free(transfer->connection.handle);
 
-   http->connection.handle = NULL;
+   transfer->connection.handle = NULL;
 
-   return 0;
+   return ret;
 }
 
-static int rarch_main_data_http_iterate_transfer_parse(http_handle_t *http)
+static int rarch_main_data_http_iterate_transfer_parse(
+      http_transfer_t *transfer)
 {
    size_t len = 0;
-   char *data = (char*)net_http_data(http->handle, &len, false);
+   int status = net_http_status(transfer->handle);
+   char *data = (char*)net_http_data(transfer->handle, &len, false);
+
+   if (!*transfer->path)
+   {
+      if (data && transfer->cb)
+         transfer->cb(data, len);
+
+      net_http_delete(transfer->handle);
+      transfer->handle = NULL;
+      return 0;
+   }
+
+   /* Closes the file, and keeps the connection 
+    * around for the next transfer. */
+   net_http_delete(transfer->handle);
+   transfer->handle = NULL;
 
-   if (data && http->cb)
-      http->cb(data, len);
+   if (status < 200 || status > 299)
+   {
+      RARCH_ERR("Download of %s failed.\n", transfer->path);
+      remove(transfer->path_tmp);
+      return -1;
+   }
 
-   net_http_delete(http->handle);
+   /* Only replaces the old file once the new one is complete. */
+   remove(transfer->path);
+   if (rename(transfer->path_tmp, transfer->path) != 0)
+   {
+      RARCH_ERR("Could not move download to %s.\n", transfer->path);
+      remove(transfer->path_tmp);
+      return -1;
+   }
 
-   http->handle = NULL;
-   msg_queue_clear(http->msg_queue);
+   if (transfer->cb)
+      transfer->cb(transfer->path, len);
 
    return 0;
 }
 
 static int cb_http_conn_default(void *data_, size_t len)
 {
-   http_handle_t *http = (http_handle_t*)data_;
+   http_transfer_t *transfer = (http_transfer_t*)data_;
 
-   if (!http)
+   if (!transfer)
       return -1;
 
-   http->handle = net_http_new(http->connection.handle);
+   transfer->handle = net_http_new(transfer->connection.handle);
 
-   if (!http->handle)
+   if (!transfer->handle)
    {
       RARCH_ERR("Could not create new HTTP session handle.\n");
       return -1;
    }
 
-   http->cb     = NULL;
+   if (*transfer->path)
+   {
+      snprintf(transfer->path_tmp, sizeof(transfer->path_tmp),
+            "%s.part", transfer->path);
+
+      if (!net_http_set_output_file(transfer->handle, transfer->path_tmp))
+      {
+         RARCH_ERR("Could not create %s.\n", transfer->path_tmp);
+         net_http_delete(transfer->handle);
+         transfer->handle = NULL;
+         return -1;
+      }
+   }
+
+   transfer->cb     = NULL;
 
-   if (http->connection.elem1[0] != '\0')
+   if (transfer->connection.elem1[0] != '\0')
    {
-      if (!strcmp(http->connection.elem1, "cb_core_updater_download"))
-         http->cb = &cb_core_updater_download;
-      if (!strcmp(http->connection.elem1, "cb_core_updater_list"))
-         http->cb = &cb_core_updater_list;
+      if (!strcmp(transfer->connection.elem1, "cb_core_updater_download"))
+         transfer->cb = &cb_core_updater_download;
+      if (!strcmp(transfer->connection.elem1, "cb_core_updater_list"))
+         transfer->cb = &cb_core_updater_list;
    }
 
    return 0;
@@ -252,18 +389,21 @@ static int cb_http_conn_default(void *data_, size_t len)
 
 /**
  * rarch_main_data_http_iterate_poll:
+ * @http                 : HTTP handle.
+ * @transfer             : Idle transfer to set up.
  *
  * Polls HTTP message queue to see if any new URLs 
- * are pending.
+ * are pending. Messages are "url|callback", or 
+ * "url|callback|path" to stream the download to a file.
  *
- * If handle is freed, will set up a new http handle. 
  * The transfer will be started on the next frame.
  *
  * Returns: 0 when an URL has been pulled and we will
  * begin transferring on the next frame. Returns -1 if
  * no HTTP URL has been pulled. Do nothing in that case.
  **/
-static int rarch_main_data_http_iterate_poll(http_handle_t *http)
+static int rarch_main_data_http_iterate_poll(http_handle_t *http,
+      http_transfer_t *transfer)
 {
    char elem0[PATH_MAX_LENGTH];
    struct string_list *str_list = NULL;
@@ -272,34 +412,62 @@ static int rarch_main_data_http_iterate_poll(http_handle_t *http)
    if (!url)
       return -1;
 
-   /* Can only deal with one HTTP transfer at a time for now */
-   if (http->handle)
-      return -1; 
-
    str_list                     = string_split(url, "|");
 
    if (!str_list)
       return -1;
 
+   *elem0                       = '\0';
+   *transfer->connection.elem1  = '\0';
+   *transfer->path              = '\0';
+
    if (str_list->size > 0)
       strlcpy(elem0, str_list->elems[0].data, sizeof(elem0));
-
-   http->connection.handle = net_http_connection_new(elem0);
-
-   if (!http->connection.handle)
-      return -1;
-
-   http->connection.cb     = &cb_http_conn_default;
-
    if (str_list->size > 1)
-      strlcpy(http->connection.elem1,
+      strlcpy(transfer->connection.elem1,
             str_list->elems[1].data,
-            sizeof(http->connection.elem1));
+            sizeof(transfer->connection.elem1));
+   if (str_list->size > 2)
+      strlcpy(transfer->path, str_list->elems[2].data,
+            sizeof(transfer->path));
 
    string_list_free(str_list);
+
+   transfer->connection.handle = net_http_connection_new(elem0);
+
+   if (!transfer->connection.handle)
+      return -1;
+
+   transfer->connection.cb     = &cb_http_conn_default;
    
    return 0;
 }
+
+static void rarch_main_data_http_free(http_handle_t *http)
+{
+   unsigned i;
+
+   for (i = 0; i < HTTP_MAX_TRANSFERS; i++)
+   {
+      http_transfer_t *transfer = &http->transfers[i];
+
+      net_http_connection_free(transfer->connection.handle);
+      transfer->connection.handle = NULL;
+
+      if (transfer->handle)
+      {
+         net_http_delete(transfer->handle);
+         transfer->handle = NULL;
+
+         if (*transfer->path)
+            remove(transfer->path_tmp);
+      }
+
+      transfer->status = HTTP_STATUS_POLL;
+   }
+
+   net_http_close_idle();
+}
 #endif
 
 #ifdef HAVE_MENU
@@ -652,6 +820,723 @@ static int rarch_main_data_nbio_iterate_parse(nbio_handle_t *nbio)
    return 0;
 }
 
+/**
+ * rarch_main_data_state_save_write:
+ * @state_save          : savestate write handle.
+ *
+ * Writes out the pending savestate snapshot, if any,
+ * and queues up its completion message.
+ **/
+static void rarch_main_data_state_save_write(state_save_handle_t *state_save)
+{
+   if (!state_save || !state_save->is_pending)
+      return;
+
+   if (write_file_atomic(state_save->path, state_save->data, state_save->size))
+   {
+      RARCH_LOG("%s\n", state_save->msg);
+      strlcpy(data_runloop_msg, state_save->msg, sizeof(data_runloop_msg));
+   }
+   else
+   {
+      RARCH_ERR("Failed to save state to \"%s\".\n", state_save->path);
+      /* The full path is in the log, the OSD only needs the name. */
+      snprintf(data_runloop_msg, sizeof(data_runloop_msg),
+            "Failed to save state to \"%s\".",
+            path_basename(state_save->path));
+   }
+
+   free(state_save->data);
+   state_save->data       = NULL;
+   state_save->size       = 0;
+   state_save->is_pending = false;
+}
+
+static void rarch_main_data_state_save_iterate(bool is_thread,
+      data_runloop_t *runloop)
+{
+   (void)is_thread;
+
+   if (!runloop)
+      return;
+
+   rarch_main_data_state_save_write(&runloop->state_save);
+}
+
+/**
+ * rarch_main_data_screenshot_write:
+ * @screenshot          : screenshot write handle.
+ *
+ * Encodes and writes out the pending screenshot, if any,
+ * and queues up its completion message.
+ **/
+static void rarch_main_data_screenshot_write(screenshot_handle_t *screenshot)
+{
+   if (!screenshot || !screenshot->is_pending)
+      return;
+
+   if (screenshot_write(screenshot->path, screenshot->data,
+            screenshot->width, screenshot->height))
+   {
+      RARCH_LOG("Screenshot saved to \"%s\".\n", screenshot->path);
+      strlcpy(data_runloop_msg, RETRO_MSG_TAKE_SCREENSHOT_SAVED,
+            sizeof(data_runloop_msg));
+   }
+   else
+   {
+      RARCH_ERR("Failed to save screenshot to \"%s\".\n", screenshot->path);
+      strlcpy(data_runloop_msg, RETRO_MSG_TAKE_SCREENSHOT_FAILED,
+            sizeof(data_runloop_msg));
+   }
+
+   free(screenshot->data);
+   screenshot->data       = NULL;
+   screenshot->is_pending = false;
+}
+
+static void rarch_main_data_screenshot_iterate(bool is_thread,
+      data_runloop_t *runloop)
+{
+   (void)is_thread;
+
+   if (!runloop)
+      return;
+
+   rarch_main_data_screenshot_write(&runloop->screenshot);
+}
+
+/**
+ * rarch_main_data_dir_list_read:
+ * @reader              : directory reader.
+ * @list                : listing the entries are appended to.
+ *
+ * Reads directory entries until the reader is done or
+ * DIR_LIST_FRAME_USEC have passed.
+ *
+ * Returns: 1 if there are entries left to read, otherwise 0
+ * (an error ends the listing with what was read until then).
+ **/
+static int rarch_main_data_dir_list_read(struct dir_list_reader *reader,
+      struct string_list *list)
+{
+   retro_time_t start = rarch_get_time_usec();
+
+   do
+   {
+      if (dir_list_reader_iterate(reader, list, DIR_LIST_CHUNK_SIZE) != 1)
+         return 0;
+   } while (rarch_get_time_usec() - start < DIR_LIST_FRAME_USEC);
+
+   return 1;
+}
+
+static void rarch_main_data_dir_list_lock(data_runloop_t *runloop)
+{
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->dir_list_lock);
+#endif
+}
+
+static void rarch_main_data_dir_list_unlock(data_runloop_t *runloop)
+{
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->dir_list_lock);
+#endif
+}
+
+/**
+ * rarch_main_data_dir_list_reset:
+ * @dir_list            : directory listing handle.
+ *
+ * Drops the pending listing. Must be called with the
+ * listing locked. A reader the data thread is still busy
+ * with is freed by the data thread once it sees the new id.
+ **/
+static void rarch_main_data_dir_list_reset(dir_list_handle_t *dir_list)
+{
+   if (!dir_list->is_busy)
+      dir_list_reader_free(dir_list->reader);
+   string_list_free(dir_list->list);
+
+   dir_list->reader      = NULL;
+   dir_list->list        = NULL;
+   dir_list->taken       = 0;
+   dir_list->is_busy     = false;
+   dir_list->is_finished = false;
+   dir_list->id++;
+}
+
+static void rarch_main_data_dir_list_iterate(bool is_thread,
+      data_runloop_t *runloop)
+{
+   int ret;
+   unsigned id;
+   bool is_busy;
+   struct string_list *chunk      = NULL;
+   struct dir_list_reader *reader = NULL;
+   dir_list_handle_t *dir_list    = runloop ? &runloop->dir_list : NULL;
+
+   (void)is_thread;
+
+   if (!dir_list)
+      return;
+
+   rarch_main_data_dir_list_lock(runloop);
+   reader            = dir_list->reader;
+   id                = dir_list->id;
+   is_busy           = reader && !dir_list->is_finished;
+   dir_list->is_busy = is_busy;
+   rarch_main_data_dir_list_unlock(runloop);
+
+   if (!is_busy)
+      return;
+
+   /* Read without holding the lock, so the menu can keep
+    * taking what has been read so far. */
+   chunk = string_list_new();
+   ret   = chunk ? rarch_main_data_dir_list_read(reader, chunk) : 0;
+
+   rarch_main_data_dir_list_lock(runloop);
+
+   if (dir_list->id != id)
+   {
+      /* Listing was cancelled or replaced while we were reading. */
+      dir_list_reader_free(reader);
+      string_list_free(chunk);
+      rarch_main_data_dir_list_unlock(runloop);
+      return;
+   }
+
+   dir_list->is_busy = false;
+
+   if (chunk)
+   {
+      union string_list_elem_attr attr;
+      size_t i;
+
+      for (i = 0; i < chunk->size; i++)
+      {
+         attr.i = chunk->elems[i].attr.i;
+         if (!string_list_append(dir_list->list, chunk->elems[i].data, attr))
+            ret = 0;
+      }
+      string_list_free(chunk);
+   }
+
+   if (ret == 0)
+   {
+      dir_list_sort(dir_list->list, true);
+      dir_list_reader_free(dir_list->reader);
+      dir_list->reader      = NULL;
+      dir_list->is_finished = true;
+   }
+
+   rarch_main_data_dir_list_unlock(runloop);
+}
+
+/**
+ * rarch_main_data_dir_list_copy:
+ * @list                : listing to copy from.
+ * @start               : index of the first entry to copy.
+ *
+ * Returns: new listing holding the entries of @list from
+ * @start onwards, or NULL on error.
+ **/
+static struct string_list *rarch_main_data_dir_list_copy(
+      const struct string_list *list, size_t start)
+{
+   size_t i;
+   struct string_list *copy = string_list_new();
+
+   if (!copy)
+      return NULL;
+
+   for (i = start; list && i < list->size; i++)
+   {
+      if (!string_list_append(copy, list->elems[i].data, list->elems[i].attr))
+      {
+         string_list_free(copy);
+         return NULL;
+      }
+   }
+
+   return copy;
+}
+
+/**
+ * rarch_main_data_dir_list_push:
+ * @dir                 : directory path.
+ * @ext                 : allowed extensions of file entries to include.
+ * @include_dirs        : include directories in the listing?
+ * @usec                : how long to read on the calling thread first.
+ * @pending             : set to true if the listing is not complete yet.
+ *
+ * Lists a directory, reading for at most @usec before handing
+ * the rest of the directory to the data runloop. Any listing
+ * still pending is cancelled.
+ *
+ * Returns: the whole sorted listing if it could be read in
+ * time, otherwise the unsorted entries read so far, the rest
+ * of which has to be collected with rarch_main_data_dir_list_poll.
+ * NULL on error. Has to be freed with dir_list_free().
+ **/
+struct string_list *rarch_main_data_dir_list_push(const char *dir,
+      const char *ext, bool include_dirs, retro_time_t usec, bool *pending)
+{
+   struct string_list *list       = NULL;
+   struct string_list *partial    = NULL;
+   struct dir_list_reader *reader = NULL;
+   data_runloop_t *runloop        = (data_runloop_t*)rarch_main_data_get_ptr();
+   retro_time_t start             = rarch_get_time_usec();
+
+   *pending = false;
+
+   rarch_main_data_dir_list_cancel();
+
+   if (!(reader = dir_list_reader_new(dir, ext, include_dirs)))
+      return NULL;
+
+   if (!(list = string_list_new()))
+      goto error;
+
+   do
+   {
+      int ret = dir_list_reader_iterate(reader, list, DIR_LIST_CHUNK_SIZE);
+
+      if (ret == -1)
+         goto error;
+
+      if (ret == 0)
+      {
+         dir_list_reader_free(reader);
+         dir_list_sort(list, true);
+         return list;
+      }
+   } while (!runloop || rarch_get_time_usec() - start < usec);
+
+   if (!(partial = rarch_main_data_dir_list_copy(list, 0)))
+      goto error;
+
+   rarch_main_data_dir_list_lock(runloop);
+   runloop->dir_list.reader = reader;
+   runloop->dir_list.list   = list;
+   runloop->dir_list.taken  = list->size;
+   rarch_main_data_dir_list_unlock(runloop);
+
+   *pending = true;
+   return partial;
+
+error:
+   dir_list_reader_free(reader);
+   string_list_free(list);
+   return NULL;
+}
+
+/**
+ * rarch_main_data_dir_list_poll:
+ * @list                : set to the entries read since the last call.
+ *
+ * Collects the progress of the listing started with
+ * rarch_main_data_dir_list_push. @list has to be
+ * freed with dir_list_free().
+ *
+ * Returns: 1 while the directory is still being read, with @list
+ * holding the unsorted entries read since the last call (or NULL).
+ * 0 once it has been read, with @list holding the whole sorted
+ * listing. -1 if there is no pending listing.
+ **/
+int rarch_main_data_dir_list_poll(struct string_list **list)
+{
+   int ret                 = -1;
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+   dir_list_handle_t *dir_list = runloop ? &runloop->dir_list : NULL;
+
+   *list = NULL;
+
+   if (!dir_list)
+      return -1;
+
+   rarch_main_data_dir_list_lock(runloop);
+
+   if (dir_list->is_finished)
+   {
+      *list          = dir_list->list;
+      dir_list->list = NULL;
+      rarch_main_data_dir_list_reset(dir_list);
+      ret            = 0;
+   }
+   else if (dir_list->reader)
+   {
+      if (dir_list->list->size > dir_list->taken)
+      {
+         *list = rarch_main_data_dir_list_copy(dir_list->list, dir_list->taken);
+         if (*list)
+            dir_list->taken = dir_list->list->size;
+      }
+      ret = 1;
+   }
+
+   rarch_main_data_dir_list_unlock(runloop);
+
+   return ret;
+}
+
+/**
+ * rarch_main_data_dir_list_cancel:
+ *
+ * Stops reading the directory listing still pending, if any.
+ **/
+void rarch_main_data_dir_list_cancel(void)
+{
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   if (!runloop)
+      return;
+
+   rarch_main_data_dir_list_lock(runloop);
+   if (runloop->dir_list.reader || runloop->dir_list.list)
+      rarch_main_data_dir_list_reset(&runloop->dir_list);
+   rarch_main_data_dir_list_unlock(runloop);
+}
+
+#ifdef HAVE_RPNG
+static void rarch_main_data_thumbnail_lock(data_runloop_t *runloop)
+{
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->thumbnail_lock);
+#endif
+}
+
+static void rarch_main_data_thumbnail_unlock(data_runloop_t *runloop)
+{
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->thumbnail_lock);
+#endif
+}
+
+/**
+ * rarch_main_data_thumbnail_decode_free:
+ * @thumbnail           : thumbnail handle.
+ *
+ * Drops the decoder state of the thumbnail being decoded.
+ **/
+static void rarch_main_data_thumbnail_decode_free(
+      thumbnail_handle_t *thumbnail)
+{
+   if (thumbnail->handle)
+      rpng_nbio_load_image_free(thumbnail->handle);
+   free(thumbnail->buf);
+   texture_image_free(&thumbnail->ti);
+
+   thumbnail->handle        = NULL;
+   thumbnail->buf           = NULL;
+   thumbnail->buf_end       = NULL;
+   thumbnail->is_processing = false;
+}
+
+/**
+ * rarch_main_data_thumbnail_decode_start:
+ * @thumbnail           : thumbnail handle.
+ *
+ * Reads the PNG file of the thumbnail at the front of the
+ * queue into memory and sets up the decoder for it.
+ *
+ * Returns: true (1) if decoding can start, otherwise false (0).
+ **/
+static bool rarch_main_data_thumbnail_decode_start(
+      thumbnail_handle_t *thumbnail)
+{
+   void *buf      = NULL;
+   ssize_t len    = 0;
+
+   if (!read_file(thumbnail->path, &buf, &len) || !buf || len < 8)
+   {
+      free(buf);
+      return false;
+   }
+
+   thumbnail->buf     = (uint8_t*)buf;
+   thumbnail->buf_end = thumbnail->buf + len;
+   thumbnail->handle  = (struct rpng_t*)calloc(1, sizeof(struct rpng_t));
+
+   if (!thumbnail->handle)
+      return false;
+
+   thumbnail->handle->buff_data = thumbnail->buf;
+
+   return rpng_nbio_load_image_argb_start(thumbnail->handle);
+}
+
+/**
+ * rarch_main_data_thumbnail_decode_step:
+ * @thumbnail           : thumbnail handle.
+ *
+ * Parses a single PNG chunk or, once all of them have been
+ * parsed, decodes a bit more of the image.
+ *
+ * Returns: 1 if there is more to decode, 0 once the image
+ * has been decoded, -1 on error.
+ **/
+static int rarch_main_data_thumbnail_decode_step(
+      thumbnail_handle_t *thumbnail)
+{
+   int ret;
+   struct rpng_t *rpng = thumbnail->handle;
+
+   if (!thumbnail->is_processing)
+   {
+      unsigned len;
+      const uint8_t *buf = rpng->buff_data;
+      size_t left        = thumbnail->buf_end - rpng->buff_data;
+
+      /* The chunk parser trusts chunk sizes, so never let it
+       * run past the end of a truncated file. */
+      if (left < 12 || left - 12 <
+            (((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) |
+             ((uint32_t)buf[2] <<  8) |  (uint32_t)buf[3]))
+         return -1;
+
+      if (rpng_nbio_load_image_argb_iterate(rpng->buff_data, rpng, &len))
+      {
+         rpng->buff_data += len;
+         return 1;
+      }
+
+      if (!rpng->has_ihdr || !rpng->has_idat || !rpng->has_iend)
+         return -1;
+
+      thumbnail->is_processing = true;
+      return 1;
+   }
+
+   ret = rpng_nbio_load_image_argb_process(rpng,
+         &thumbnail->ti.pixels, &thumbnail->ti.width, &thumbnail->ti.height);
+
+   if (ret == IMAGE_PROCESS_NEXT)
+      return 1;
+   if (ret == IMAGE_PROCESS_END)
+      return 0;
+   return -1;
+}
+
+static void rarch_main_data_thumbnail_iterate(bool is_thread,
+      data_runloop_t *runloop)
+{
+   int ret                       = -1;
+   retro_time_t start            = rarch_get_time_usec();
+   thumbnail_handle_t *thumbnail = runloop ? &runloop->thumbnail : NULL;
+
+   (void)is_thread;
+
+   if (!thumbnail)
+      return;
+
+   if (!thumbnail->handle && !thumbnail->buf)
+   {
+      rarch_main_data_thumbnail_lock(runloop);
+
+      if (!thumbnail->queue_size || thumbnail->done_size == THUMBNAIL_DONE_SIZE)
+      {
+         rarch_main_data_thumbnail_unlock(runloop);
+         return;
+      }
+
+      strlcpy(thumbnail->path, thumbnail->queue[0], sizeof(thumbnail->path));
+      memmove(thumbnail->queue[0], thumbnail->queue[1],
+            --thumbnail->queue_size * sizeof(thumbnail->queue[0]));
+      thumbnail->is_cancelled = false;
+
+      rarch_main_data_thumbnail_unlock(runloop);
+
+      if (!rarch_main_data_thumbnail_decode_start(thumbnail))
+         goto finish;
+   }
+   else
+   {
+      bool is_cancelled;
+
+      rarch_main_data_thumbnail_lock(runloop);
+      is_cancelled = thumbnail->is_cancelled;
+      rarch_main_data_thumbnail_unlock(runloop);
+
+      if (is_cancelled)
+         goto finish;
+   }
+
+   /* Decode without holding the lock, so the menu can keep
+    * queueing and cancelling thumbnails. */
+   do
+   {
+      ret = rarch_main_data_thumbnail_decode_step(thumbnail);
+   } while (ret == 1 && rarch_get_time_usec() - start < THUMBNAIL_FRAME_USEC);
+
+   if (ret == 1)
+      return;
+
+finish:
+   rarch_main_data_thumbnail_lock(runloop);
+
+   if (!thumbnail->is_cancelled)
+   {
+      thumbnail_result_t *result = &thumbnail->done[thumbnail->done_size++];
+
+      strlcpy(result->path, thumbnail->path, sizeof(result->path));
+      result->success = ret == 0;
+      memset(&result->ti, 0, sizeof(result->ti));
+
+      if (result->success)
+      {
+         result->ti = thumbnail->ti;
+         memset(&thumbnail->ti, 0, sizeof(thumbnail->ti));
+      }
+   }
+
+   *thumbnail->path = '\0';
+
+   rarch_main_data_thumbnail_unlock(runloop);
+
+   rarch_main_data_thumbnail_decode_free(thumbnail);
+}
+
+/**
+ * rarch_main_data_thumbnail_request:
+ * @path                : path of the PNG thumbnail.
+ *
+ * Queues a thumbnail to be decoded by the data runloop.
+ * Requesting a thumbnail that is already queued, being
+ * decoded or waiting to be pulled does nothing.
+ *
+ * Returns: true (1) if the thumbnail is on its way, false (0)
+ * if the queue is full and it has to be requested again later.
+ **/
+bool rarch_main_data_thumbnail_request(const char *path)
+{
+   unsigned i;
+   bool ret                      = true;
+   data_runloop_t *runloop       = (data_runloop_t*)rarch_main_data_get_ptr();
+   thumbnail_handle_t *thumbnail = runloop ? &runloop->thumbnail : NULL;
+
+   if (!thumbnail || !path || !*path)
+      return false;
+
+   rarch_main_data_thumbnail_lock(runloop);
+
+   if (!strcmp(thumbnail->path, path))
+      goto end;
+
+   for (i = 0; i < thumbnail->queue_size; i++)
+      if (!strcmp(thumbnail->queue[i], path))
+         goto end;
+
+   for (i = 0; i < thumbnail->done_size; i++)
+      if (!strcmp(thumbnail->done[i].path, path))
+         goto end;
+
+   if (thumbnail->queue_size == THUMBNAIL_QUEUE_SIZE)
+      ret = false;
+   else
+      strlcpy(thumbnail->queue[thumbnail->queue_size++], path,
+            sizeof(thumbnail->queue[0]));
+
+end:
+   rarch_main_data_thumbnail_unlock(runloop);
+
+   return ret;
+}
+
+/**
+ * rarch_main_data_thumbnail_cancel:
+ * @path                : path of the PNG thumbnail, or NULL.
+ *
+ * Drops a requested thumbnail, whether it is still queued,
+ * being decoded or waiting to be pulled. NULL drops all of them.
+ **/
+void rarch_main_data_thumbnail_cancel(const char *path)
+{
+   unsigned i;
+   data_runloop_t *runloop       = (data_runloop_t*)rarch_main_data_get_ptr();
+   thumbnail_handle_t *thumbnail = runloop ? &runloop->thumbnail : NULL;
+
+   if (!thumbnail)
+      return;
+
+   rarch_main_data_thumbnail_lock(runloop);
+
+   if (*thumbnail->path && (!path || !strcmp(thumbnail->path, path)))
+      thumbnail->is_cancelled = true;
+
+   for (i = 0; i < thumbnail->queue_size; )
+   {
+      if (path && strcmp(thumbnail->queue[i], path))
+      {
+         i++;
+         continue;
+      }
+      memmove(thumbnail->queue[i], thumbnail->queue[i + 1],
+            (--thumbnail->queue_size - i) * sizeof(thumbnail->queue[0]));
+   }
+
+   for (i = 0; i < thumbnail->done_size; )
+   {
+      if (path && strcmp(thumbnail->done[i].path, path))
+      {
+         i++;
+         continue;
+      }
+      texture_image_free(&thumbnail->done[i].ti);
+      memmove(&thumbnail->done[i], &thumbnail->done[i + 1],
+            (--thumbnail->done_size - i) * sizeof(thumbnail->done[0]));
+   }
+
+   rarch_main_data_thumbnail_unlock(runloop);
+}
+
+/**
+ * rarch_main_data_thumbnail_pull:
+ * @path                : buffer the path of the thumbnail is copied to.
+ * @size                : size of @path.
+ * @ti                  : set to the decoded image.
+ *
+ * Takes the oldest thumbnail the data runloop is done with.
+ * The pixels of @ti belong to the caller and have to be freed
+ * with texture_image_free().
+ *
+ * Returns: 1 if a thumbnail was decoded, 0 if one could not be
+ * decoded (@ti is left empty), -1 if none is ready yet.
+ **/
+int rarch_main_data_thumbnail_pull(char *path, size_t size,
+      struct texture_image *ti)
+{
+   int ret                       = -1;
+   data_runloop_t *runloop       = (data_runloop_t*)rarch_main_data_get_ptr();
+   thumbnail_handle_t *thumbnail = runloop ? &runloop->thumbnail : NULL;
+
+   memset(ti, 0, sizeof(*ti));
+
+   if (!thumbnail)
+      return -1;
+
+   rarch_main_data_thumbnail_lock(runloop);
+
+   if (thumbnail->done_size)
+   {
+      strlcpy(path, thumbnail->done[0].path, size);
+      *ti = thumbnail->done[0].ti;
+      ret = thumbnail->done[0].success;
+      memmove(&thumbnail->done[0], &thumbnail->done[1],
+            --thumbnail->done_size * sizeof(thumbnail->done[0]));
+   }
+
+   rarch_main_data_thumbnail_unlock(runloop);
+
+   return ret;
+}
+#endif
+
 #ifdef HAVE_LIBRETRODB
 #ifdef HAVE_MENU
 
@@ -750,34 +1635,50 @@ static void rarch_main_data_nbio_iterate(bool is_thread, data_runloop_t *runloop
 #ifdef HAVE_NETWORKING
 static void rarch_main_data_http_iterate(bool is_thread, data_runloop_t *runloop)
 {
+   unsigned i;
+   size_t pos = 0, tot = 0;
+   bool active         = false;
    http_handle_t *http = runloop ? &runloop->http : NULL;
    if (!http)
       return;
 
-   switch (http->status)
+   for (i = 0; i < HTTP_MAX_TRANSFERS; i++)
    {
-      case HTTP_STATUS_CONNECTION_TRANSFER_PARSE:
-         rarch_main_data_http_conn_iterate_transfer_parse(http);
-         http->status = HTTP_STATUS_TRANSFER;
-         break;
-      case HTTP_STATUS_CONNECTION_TRANSFER:
-         if (!rarch_main_data_http_con_iterate_transfer(http))
-            http->status = HTTP_STATUS_CONNECTION_TRANSFER_PARSE;
-         break;
-      case HTTP_STATUS_TRANSFER_PARSE:
-         rarch_main_data_http_iterate_transfer_parse(http);
-         http->status = HTTP_STATUS_POLL;
-         break;
-      case HTTP_STATUS_TRANSFER:
-         if (!rarch_main_data_http_iterate_transfer(http))
-            http->status = HTTP_STATUS_TRANSFER_PARSE;
-         break;
-      case HTTP_STATUS_POLL:
-      default:
-         if (rarch_main_data_http_iterate_poll(http) == 0)
-            http->status = HTTP_STATUS_CONNECTION_TRANSFER;
-         break;
+      http_transfer_t *transfer = &http->transfers[i];
+
+      switch (transfer->status)
+      {
+         case HTTP_STATUS_CONNECTION_TRANSFER_PARSE:
+            if (rarch_main_data_http_conn_iterate_transfer_parse(transfer) == 0)
+               transfer->status = HTTP_STATUS_TRANSFER;
+            else
+               transfer->status = HTTP_STATUS_POLL;
+            break;
+         case HTTP_STATUS_CONNECTION_TRANSFER:
+            if (!rarch_main_data_http_con_iterate_transfer(transfer))
+               transfer->status = HTTP_STATUS_CONNECTION_TRANSFER_PARSE;
+            break;
+         case HTTP_STATUS_TRANSFER_PARSE:
+            rarch_main_data_http_iterate_transfer_parse(transfer);
+            transfer->status = HTTP_STATUS_POLL;
+            break;
+         case HTTP_STATUS_TRANSFER:
+            active = true;
+            if (!rarch_main_data_http_iterate_transfer(transfer, &pos, &tot))
+               transfer->status = HTTP_STATUS_TRANSFER_PARSE;
+            break;
+         case HTTP_STATUS_POLL:
+         default:
+            if (rarch_main_data_http_iterate_poll(http, transfer) == 0)
+               transfer->status = HTTP_STATUS_CONNECTION_TRANSFER;
+            break;
+      }
    }
+
+   if (active && tot != 0 && pos < tot)
+      snprintf(data_runloop_msg, sizeof(data_runloop_msg),
+            "Download progress: %d%%",
+            (int)((unsigned long long)pos * 100 / tot));
 }
 #endif
 
@@ -829,6 +1730,9 @@ static void rarch_main_data_overlay_iterate(bool is_thread, data_runloop_t *runl
       case OVERLAY_STATUS_DEFERRED_LOAD:
          input_overlay_load_overlays(driver->overlay);
          break;
+      case OVERLAY_STATUS_DEFERRED_LOADING_IMAGE:
+         input_overlay_load_overlays_image_iterate(driver->overlay);
+         break;
       case OVERLAY_STATUS_NONE:
       case OVERLAY_STATUS_ALIVE:
          break;
@@ -866,11 +1770,153 @@ static void data_runloop_thread_deinit(data_runloop_t *runloop)
       slock_free(runloop->lock);
       slock_free(runloop->cond_lock);
       slock_free(runloop->overlay_lock);
+      slock_free(runloop->dir_list_lock);
+      slock_free(runloop->thumbnail_lock);
       scond_free(runloop->cond);
    }
 }
 #endif
 
+/**
+ * rarch_main_data_state_flush:
+ *
+ * Blocks until a pending asynchronous savestate
+ * write (if any) has been written out.
+ **/
+void rarch_main_data_state_flush(void)
+{
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   if (!runloop || !runloop->state_save.is_pending)
+      return;
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->lock);
+#endif
+
+   rarch_main_data_state_save_write(&runloop->state_save);
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->lock);
+#endif
+}
+
+/**
+ * rarch_main_data_state_push:
+ * @path                : path the savestate shall be written to.
+ * @msg                 : message to display once it has been written.
+ * @data                : serialized state, allocated with malloc().
+ * @size                : size of @data.
+ *
+ * Hands a serialized savestate over to the data runloop, which
+ * takes ownership of @data and writes it out in the background.
+ * A previously queued write is finished first.
+ *
+ * Returns: true if the write was queued, otherwise false, in
+ * which case the caller still owns @data.
+ **/
+bool rarch_main_data_state_push(const char *path, const char *msg,
+      void *data, size_t size)
+{
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   if (!runloop || !data)
+      return false;
+
+   rarch_main_data_state_flush();
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->lock);
+#endif
+
+   strlcpy(runloop->state_save.path, path, sizeof(runloop->state_save.path));
+   strlcpy(runloop->state_save.msg,  msg,  sizeof(runloop->state_save.msg));
+   runloop->state_save.data       = data;
+   runloop->state_save.size       = size;
+   runloop->state_save.is_pending = true;
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->lock);
+#endif
+
+   return true;
+}
+
+/**
+ * rarch_main_data_screenshot_flush:
+ *
+ * Blocks until a pending asynchronous screenshot
+ * (if any) has been written out.
+ **/
+void rarch_main_data_screenshot_flush(void)
+{
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   if (!runloop || !runloop->screenshot.is_pending)
+      return;
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->lock);
+#endif
+
+   rarch_main_data_screenshot_write(&runloop->screenshot);
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->lock);
+#endif
+}
+
+/**
+ * rarch_main_data_screenshot_push:
+ * @path                : path the screenshot shall be written to.
+ * @data                : BGR24 frame, top row first, allocated
+ *                        with malloc().
+ * @width               : width of @data.
+ * @height              : height of @data.
+ *
+ * Hands a captured frame over to the data runloop, which
+ * takes ownership of @data, encodes it and writes it out
+ * in the background. A previously queued screenshot is 
+ * finished first.
+ *
+ * Returns: true if the screenshot was queued, otherwise false,
+ * in which case the caller still owns @data.
+ **/
+bool rarch_main_data_screenshot_push(const char *path, uint8_t *data,
+      unsigned width, unsigned height)
+{
+   data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   if (!runloop || !data)
+      return false;
+
+   rarch_main_data_screenshot_flush();
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_lock(runloop->lock);
+#endif
+
+   strlcpy(runloop->screenshot.path, path, sizeof(runloop->screenshot.path));
+   runloop->screenshot.data       = data;
+   runloop->screenshot.width      = width;
+   runloop->screenshot.height     = height;
+   runloop->screenshot.is_pending = true;
+
+#ifdef HAVE_THREADS
+   if (runloop->alive)
+      slock_unlock(runloop->lock);
+#endif
+
+   return true;
+}
+
 void rarch_main_data_deinit(void)
 {
    data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
@@ -878,6 +1924,9 @@ void rarch_main_data_deinit(void)
    if (!runloop)
       return;
 
+   rarch_main_data_state_flush();
+   rarch_main_data_screenshot_flush();
+
 #ifdef HAVE_THREADS
    if (runloop->thread_inited)
    {
@@ -895,13 +1944,32 @@ void rarch_main_data_free(void)
 {
    data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
 
+   rarch_main_data_state_flush();
+   rarch_main_data_screenshot_flush();
+
    if (runloop)
+   {
+#ifdef HAVE_NETWORKING
+      rarch_main_data_http_free(&runloop->http);
+#endif
+      rarch_main_data_dir_list_reset(&runloop->dir_list);
+#ifdef HAVE_RPNG
+      rarch_main_data_thumbnail_cancel(NULL);
+      rarch_main_data_thumbnail_decode_free(&runloop->thumbnail);
+#endif
       free(runloop);
+   }
    runloop = NULL;
 }
 
 static void data_runloop_iterate(bool is_thread, data_runloop_t *runloop)
 {
+   rarch_main_data_state_save_iterate (is_thread, runloop);
+   rarch_main_data_screenshot_iterate (is_thread, runloop);
+   rarch_main_data_dir_list_iterate   (is_thread, runloop);
+#ifdef HAVE_RPNG
+   rarch_main_data_thumbnail_iterate  (is_thread, runloop);
+#endif
    rarch_main_data_nbio_iterate       (is_thread, runloop);
 #ifdef HAVE_RPNG
    rarch_main_data_nbio_image_iterate (is_thread, runloop);
@@ -961,6 +2029,8 @@ static void rarch_main_data_thread_init(void)
    runloop->lock            = slock_new();
    runloop->cond_lock       = slock_new();
    runloop->overlay_lock    = slock_new();
+   runloop->dir_list_lock   = slock_new();
+   runloop->thumbnail_lock  = slock_new();
    runloop->cond            = scond_new();
 
    runloop->thread    = sthread_create(data_thread_loop, runloop);
@@ -978,6 +2048,8 @@ error:
    slock_free(runloop->lock);
    slock_free(runloop->cond_lock);
    slock_free(runloop->overlay_lock);
+   slock_free(runloop->dir_list_lock);
+   slock_free(runloop->thumbnail_lock);
    scond_free(runloop->cond);
 }
 #endif
@@ -1079,17 +2151,23 @@ void rarch_main_data_clear_state(void)
 void rarch_main_data_init_queues(void)
 {
    data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
+
+   /* Messages carry paths, see rarch_main_data_msg_queue_push(). */
 #ifdef HAVE_NETWORKING
    if (!runloop->http.msg_queue)
-      rarch_assert(runloop->http.msg_queue = msg_queue_new(8));
+      rarch_assert(runloop->http.msg_queue = 
+            msg_queue_new_sized(32, PATH_MAX_LENGTH));
 #endif
    if (!runloop->nbio.msg_queue)
-      rarch_assert(runloop->nbio.msg_queue = msg_queue_new(8));
+      rarch_assert(runloop->nbio.msg_queue = 
+            msg_queue_new_sized(8, PATH_MAX_LENGTH));
    if (!runloop->nbio.image.msg_queue)
-      rarch_assert(runloop->nbio.image.msg_queue = msg_queue_new(8));
+      rarch_assert(runloop->nbio.image.msg_queue = 
+            msg_queue_new_sized(8, PATH_MAX_LENGTH));
 #ifdef HAVE_LIBRETRODB
    if (!runloop->db.msg_queue)
-      rarch_assert(runloop->db.msg_queue = msg_queue_new(8));
+      rarch_assert(runloop->db.msg_queue = 
+            msg_queue_new_sized(8, PATH_MAX_LENGTH));
 #endif
 }
 
@@ -1098,6 +2176,7 @@ void rarch_main_data_msg_queue_push(unsigned type,
       unsigned prio, unsigned duration, bool flush)
 {
    char new_msg[PATH_MAX_LENGTH];
+   int len            = 0;
    msg_queue_t *queue = NULL;
    data_runloop_t *runloop = (data_runloop_t*)rarch_main_data_get_ptr();
 
@@ -1107,21 +2186,21 @@ void rarch_main_data_msg_queue_push(unsigned type,
          break;
       case DATA_TYPE_FILE:
          queue = runloop->nbio.msg_queue;
-         snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
+         len   = snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
          break;
       case DATA_TYPE_IMAGE:
          queue = runloop->nbio.image.msg_queue;
-         snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
+         len   = snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
          break;
 #ifdef HAVE_NETWORKING
       case DATA_TYPE_HTTP:
          queue = runloop->http.msg_queue;
-         snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
+         len   = snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
          break;
 #endif
 #ifdef HAVE_OVERLAY
       case DATA_TYPE_OVERLAY:
-         snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
+         len   = snprintf(new_msg, sizeof(new_msg), "%s|%s", msg, msg2);
          break;
 #endif
    }
@@ -1129,6 +2208,13 @@ void rarch_main_data_msg_queue_push(unsigned type,
    if (!queue)
       return;
 
+   /* A truncated message could name the wrong file to write to. */
+   if (len < 0 || (size_t)len >= sizeof(new_msg))
+   {
+      RARCH_ERR("Data runloop message is too long: \"%s\".\n", msg);
+      return;
+   }
+
    if (flush)
       msg_queue_clear(queue);
    msg_queue_push(queue, new_msg, prio, duration);
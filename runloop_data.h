@@ -20,6 +20,8 @@
 #include <formats/image.h>
 #include <formats/rpng.h>
 #include <queues/message_queue.h>
+#include <string/string_list.h>
+#include "libretro.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +44,98 @@ void rarch_main_data_msg_queue_push(unsigned type,
 
 void rarch_main_data_clear_state(void);
 
+bool rarch_main_data_state_push(const char *path, const char *msg,
+      void *data, size_t size);
+
+void rarch_main_data_state_flush(void);
+
+bool rarch_main_data_screenshot_push(const char *path, uint8_t *data,
+      unsigned width, unsigned height);
+
+void rarch_main_data_screenshot_flush(void);
+
+/**
+ * rarch_main_data_dir_list_push:
+ * @dir                 : directory path.
+ * @ext                 : allowed extensions of file entries to include.
+ * @include_dirs        : include directories in the listing?
+ * @usec                : how long to read on the calling thread first.
+ * @pending             : set to true if the listing is not complete yet.
+ *
+ * Lists a directory, reading for at most @usec before handing
+ * the rest of the directory to the data runloop. Any listing
+ * still pending is cancelled.
+ *
+ * Returns: the whole sorted listing if it could be read in
+ * time, otherwise the unsorted entries read so far, the rest
+ * of which has to be collected with rarch_main_data_dir_list_poll.
+ * NULL on error. Has to be freed with dir_list_free().
+ **/
+struct string_list *rarch_main_data_dir_list_push(const char *dir,
+      const char *ext, bool include_dirs, retro_time_t usec, bool *pending);
+
+/**
+ * rarch_main_data_dir_list_poll:
+ * @list                : set to the entries read since the last call.
+ *
+ * Collects the progress of the listing started with
+ * rarch_main_data_dir_list_push. @list has to be
+ * freed with dir_list_free().
+ *
+ * Returns: 1 while the directory is still being read, with @list
+ * holding the unsorted entries read since the last call (or NULL).
+ * 0 once it has been read, with @list holding the whole sorted
+ * listing. -1 if there is no pending listing.
+ **/
+int rarch_main_data_dir_list_poll(struct string_list **list);
+
+/**
+ * rarch_main_data_dir_list_cancel:
+ *
+ * Stops reading the directory listing still pending, if any.
+ **/
+void rarch_main_data_dir_list_cancel(void);
+
+#ifdef HAVE_RPNG
+/**
+ * rarch_main_data_thumbnail_request:
+ * @path                : path of the PNG thumbnail.
+ *
+ * Queues a thumbnail to be decoded by the data runloop.
+ * Requesting a thumbnail that is already queued, being
+ * decoded or waiting to be pulled does nothing.
+ *
+ * Returns: true (1) if the thumbnail is on its way, false (0)
+ * if the queue is full and it has to be requested again later.
+ **/
+bool rarch_main_data_thumbnail_request(const char *path);
+
+/**
+ * rarch_main_data_thumbnail_cancel:
+ * @path                : path of the PNG thumbnail, or NULL.
+ *
+ * Drops a requested thumbnail, whether it is still queued,
+ * being decoded or waiting to be pulled. NULL drops all of them.
+ **/
+void rarch_main_data_thumbnail_cancel(const char *path);
+
+/**
+ * rarch_main_data_thumbnail_pull:
+ * @path                : buffer the path of the thumbnail is copied to.
+ * @size                : size of @path.
+ * @ti                  : set to the decoded image.
+ *
+ * Takes the oldest thumbnail the data runloop is done with.
+ * The pixels of @ti belong to the caller and have to be freed
+ * with texture_image_free().
+ *
+ * Returns: 1 if a thumbnail was decoded, 0 if one could not be
+ * decoded (@ti is left empty), -1 if none is ready yet.
+ **/
+int rarch_main_data_thumbnail_pull(char *path, size_t size,
+      struct texture_image *ti);
+#endif
+
 void rarch_main_data_iterate(void);
 
 void rarch_main_data_deinit(void);
@@ -27,6 +27,7 @@
 #include "gfx/scaler/scaler.h"
 #include "retroarch.h"
 #include "runloop.h"
+#include "runloop_data.h"
 #include "retroarch_logger.h"
 #include "screenshot.h"
 #include "gfx/video_driver.h"
@@ -44,9 +45,7 @@
 #if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
 #include <formats/rpng.h>
 #define IMG_EXT "png"
-
 #else
-
 #define IMG_EXT "bmp"
 
 static bool write_header_bmp(FILE *file, unsigned width, unsigned height)
@@ -81,99 +80,46 @@ static bool write_header_bmp(FILE *file, unsigned width, unsigned height)
    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
 }
 
-static void dump_lines_file(FILE *file, uint8_t **lines,
-      size_t line_size, unsigned height)
+static bool write_bmp(const char *path, const uint8_t *data,
+      unsigned width, unsigned height)
 {
    unsigned i;
+   bool ret            = false;
+   size_t line_size    = (width * 3 + 3) & ~3;
+   uint8_t *line       = (uint8_t*)calloc(1, line_size);
+   FILE *file          = NULL;
 
-   for (i = 0; i < height; i++)
-      fwrite(lines[i], 1, line_size, file);
-}
-
-static void dump_line_bgr(uint8_t *line, const uint8_t *src, unsigned width)
-{
-   memcpy(line, src, width * 3);
-}
-
-static void dump_line_16(uint8_t *line, const uint16_t *src, unsigned width)
-{
-   unsigned i;
+   if (!line)
+      return false;
 
-   for (i = 0; i < width; i++)
+   file = fopen(path, "wb");
+   if (!file)
    {
-      uint16_t pixel = *src++;
-      uint8_t b = (pixel >>  0) & 0x1f;
-      uint8_t g = (pixel >>  5) & 0x3f;
-      uint8_t r = (pixel >> 11) & 0x1f;
-      *line++   = (b << 3) | (b >> 2);
-      *line++   = (g << 2) | (g >> 4);
-      *line++   = (r << 3) | (r >> 2);
+      RARCH_ERR("Failed to open file \"%s\" for screenshot.\n", path);
+      goto end;
    }
-}
-
-static void dump_line_32(uint8_t *line, const uint32_t *src, unsigned width)
-{
-   unsigned i;
 
-   for (i = 0; i < width; i++)
+   if (!write_header_bmp(file, width, height))
    {
-      uint32_t pixel = *src++;
-      *line++ = (pixel >>  0) & 0xff;
-      *line++ = (pixel >>  8) & 0xff;
-      *line++ = (pixel >> 16) & 0xff;
+      RARCH_ERR("Failed to write image header.\n");
+      goto end;
    }
-}
 
-static void dump_content(FILE *file, const void *frame,
-      int width, int height, int pitch, bool bgr24)
-{
-   size_t line_size;
-   int i, j;
-   global_t *global = NULL;
-   union
+   /* BMP is stored bottom-up, with lines padded to 4 bytes. */
+   for (i = height; i > 0; i--)
    {
-      const uint8_t *u8;
-      const uint16_t *u16;
-      const uint32_t *u32;
-   } u;
-   uint8_t **lines = (uint8_t**)calloc(height, sizeof(uint8_t*));
-
-   if (!lines)
-      return;
-
-   u.u8      = (const uint8_t*)frame;
-   line_size = (width * 3 + 3) & ~3;
-   global    = global_get_ptr();
-
-   for (i = 0; i < height; i++)
-   {
-      lines[i] = (uint8_t*)calloc(1, line_size);
-      if (!lines[i])
+      memcpy(line, data + (i - 1) * width * 3, width * 3);
+      if (fwrite(line, 1, line_size, file) != line_size)
          goto end;
    }
 
-   if (bgr24) /* BGR24 byte order. Can directly copy. */
-   {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_bgr(lines[j], u.u8, width);
-   }
-   else if (global->system.pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
-   {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_32(lines[j], u.u32, width);
-   }
-   else /* RGB565 */
-   {
-      for (j = 0; j < height; j++, u.u8 += pitch)
-         dump_line_16(lines[j], u.u16, width);
-   }
-
-   dump_lines_file(file, lines, line_size, height);
+   ret = true;
 
 end:
-   for (i = 0; i < height; i++)
-      free(lines[i]);
-   free(lines);
+   if (file)
+      fclose(file);
+   free(line);
+   return ret;
 }
 #endif
 
@@ -339,6 +285,29 @@ bool take_screenshot(void)
 }
 
 
+/**
+ * screenshot_write:
+ * @path                : path of the image to write.
+ * @data                : BGR24 frame, top row first.
+ * @width               : width of @data.
+ * @height              : height of @data.
+ *
+ * Encodes a frame captured by screenshot_dump() and writes
+ * it out. Called from the data runloop, so it must not touch
+ * any driver state.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool screenshot_write(const char *path, const uint8_t *data,
+      unsigned width, unsigned height)
+{
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+   return rpng_save_image_bgr24(path, data, width, height, width * 3);
+#else
+   return write_bmp(path, data, width, height);
+#endif
+}
+
 /* Take frame bottom-up. */
 bool screenshot_dump(const char *folder, const void *frame,
       unsigned width, unsigned height, int pitch, bool bgr24)
@@ -346,13 +315,11 @@ bool screenshot_dump(const char *folder, const void *frame,
    char filename[PATH_MAX_LENGTH];
    char shotname[PATH_MAX_LENGTH];
    struct scaler_ctx scaler = {0};
-   FILE *file          = NULL;
    uint8_t *out_buffer = NULL;
    bool ret            = false;
    global_t *global    = global_get_ptr();
    driver_t *driver    = driver_get_ptr();
 
-   (void)file;
    (void)out_buffer;
    (void)scaler;
    (void)global;
@@ -378,7 +345,9 @@ bool screenshot_dump(const char *folder, const void *frame,
    }
 
    ret = false;
-#elif defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+#else
+   /* Only the conversion to top-down BGR24 happens here,
+    * encoding and writing is left to the data runloop. */
    out_buffer = (uint8_t*)malloc(width * height * 3);
    if (!out_buffer)
       return false;
@@ -404,30 +373,14 @@ bool screenshot_dump(const char *folder, const void *frame,
          (const uint8_t*)frame + ((int)height - 1) * pitch);
    scaler_ctx_gen_reset(&scaler);
 
-   RARCH_LOG("Using RPNG for PNG screenshots.\n");
-   ret = rpng_save_image_bgr24(filename,
-         out_buffer, width, height, width * 3);
+   if (rarch_main_data_screenshot_push(filename, out_buffer, width, height))
+      return true;
+
+   ret = screenshot_write(filename, out_buffer, width, height);
    if (!ret)
       RARCH_ERR("Failed to take screenshot.\n");
    free(out_buffer);
-#else
-   file = fopen(filename, "wb");
-   if (!file)
-   {
-      RARCH_ERR("Failed to open file \"%s\" for screenshot.\n", filename);
-      return false;
-   }
-
-   ret = write_header_bmp(file, width, height);
-
-   if (ret)
-      dump_content(file, frame, width, height, pitch, bgr24);
-   else
-      RARCH_ERR("Failed to write image header.\n");
-
-   fclose(file);
 #endif
 
    return ret;
 }
-
@@ -32,6 +32,9 @@ void screenshot_generate_filename(char *filename, size_t size);
 
 bool take_screenshot(void);
 
+bool screenshot_write(const char *path, const uint8_t *data,
+      unsigned width, unsigned height);
+
 #ifdef __cplusplus
 }
 #endif
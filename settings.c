@@ -126,21 +126,31 @@ rarch_setting_t* setting_find_setting(rarch_setting_t* settings,
       const char* name)
 {
    bool found = false;
+   rarch_setting_t *setting = NULL;
 
    if (!settings || !name)
       return NULL;
 
-   for (; settings->type != ST_NONE; settings++)
+   if (settings_list_find(settings, name, &setting))
+   {
+      if (!setting)
+         return NULL;
+      settings = setting;
+   }
+   else
    {
-      if (settings->type <= ST_GROUP && !strcmp(settings->name, name))
+      for (; settings->type != ST_NONE; settings++)
       {
-         found = true;
-         break;
+         if (settings->type <= ST_GROUP && !strcmp(settings->name, name))
+         {
+            found = true;
+            break;
+         }
       }
-   }
 
-   if (!found)
-      return NULL;
+      if (!found)
+         return NULL;
+   }
 
    if (settings->short_description && settings->short_description[0] == '\0')
       return NULL;
@@ -1309,6 +1319,39 @@ static void setting_get_string_representation_uint_archive_mode(void *data,
    strlcpy(type_str, name, type_str_size);
 }
 
+static void setting_get_string_representation_uint_audio_resampler_quality(
+      void *data, char *type_str, size_t type_str_size)
+{
+   const char *name = "Unknown";
+   settings_t      *settings = config_get_ptr();
+
+   (void)data;
+
+   switch (settings->audio.resampler_quality)
+   {
+      case RESAMPLER_QUALITY_DONTCARE:
+         name = "Don't Care";
+         break;
+      case RESAMPLER_QUALITY_LOWEST:
+         name = "Lowest";
+         break;
+      case RESAMPLER_QUALITY_LOWER:
+         name = "Lower";
+         break;
+      case RESAMPLER_QUALITY_NORMAL:
+         name = "Normal";
+         break;
+      case RESAMPLER_QUALITY_HIGHER:
+         name = "Higher";
+         break;
+      case RESAMPLER_QUALITY_HIGHEST:
+         name = "Highest";
+         break;
+   }
+
+   strlcpy(type_str, name, type_str_size);
+}
+
 static void setting_get_string_representation_uint_analog_dpad_mode(void *data,
       char *type_str, size_t type_str_size)
 {
@@ -1984,6 +2027,17 @@ int setting_get_description(const char *label, char *msg,
          snprintf(msg, sizeof_msg,
                " -- Convoluted Cosine implementation.");
    }
+   else if (!strcmp(label, "audio_resampler_quality"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Audio resampler quality level. \n"
+            " \n"
+            "Higher levels use more filter taps and \n"
+            "phases, improving SNR at a higher CPU \n"
+            "cost. Lower levels can help slow devices. \n"
+            " \n"
+            "Only the SINC resampler honors this.");
+   }
    else if (!strcmp(label, "video_driver"))
    {
       if (!strcmp(settings->video.driver, "gl"))
@@ -2095,7 +2149,11 @@ int setting_get_description(const char *label, char *msg,
    {
       snprintf(msg, sizeof_msg,
             "-- Enable or disable frontend \n"
-            "performance counters.");
+            "performance counters.\n"
+            " \n"
+            "When enabled at startup, also samples \n"
+            "which subsystem the main thread spends \n"
+            "its time in.");
    }
    else if (!strcmp(label, "system_directory"))
    {
@@ -2159,6 +2217,16 @@ int setting_get_description(const char *label, char *msg,
       snprintf(msg, sizeof_msg,
             " -- Video V-Sync.\n");
    }
+   else if (!strcmp(label, "video_vrr_enable"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Variable refresh rate.\n"
+            " \n"
+            "For FreeSync and G-Sync displays. \n"
+            "Frames are shown as soon as they are \n"
+            "ready, paced at exactly the core's \n"
+            "frame rate instead of the monitor's.");
+   }
    else if (!strcmp(label, "video_hard_sync"))
    {
       snprintf(msg, sizeof_msg,
@@ -2181,6 +2249,26 @@ int setting_get_description(const char *label, char *msg,
             " 1: Syncs to previous frame.\n"
             " 2: Etc ...");
    }
+   else if (!strcmp(label, "video_hard_sync_adaptive"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Lets Hard GPU Sync run more frames\n"
+            "ahead when waiting on the GPU makes\n"
+            "frames miss VSync.\n"
+            " \n"
+            "Goes back to Hard GPU Sync Frames\n"
+            "once frames are on time again.");
+   }
+   else if (!strcmp(label, "video_max_swapchain_images"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Sets how many images the video\n"
+            "driver may have in flight.\n"
+            " \n"
+            "More than 2 lets the next frame be\n"
+            "written while a flip is pending,\n"
+            "at the cost of latency.");
+   }
    else if (!strcmp(label, "video_frame_delay"))
    {
       snprintf(msg, sizeof_msg,
@@ -2192,6 +2280,52 @@ int setting_get_description(const char *label, char *msg,
             " \n"
             "Maximum is 15.");
    }
+   else if (!strcmp(label, "video_dirty_rows"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Uploads only the rows of a frame\n"
+            "which changed since the last one.\n"
+            " \n"
+            "Saves bandwidth with mostly static\n"
+            "frames, at the cost of comparing\n"
+            "every frame on the CPU.");
+   }
+   else if (!strcmp(label, "video_frame_delay_auto"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Picks the frame delay automatically.\n"
+            " \n"
+            "Measures how long the core takes to\n"
+            "run a frame and delays it as long as\n"
+            "possible while still making VSync.\n"
+            " \n"
+            "Overrides Frame Delay.");
+   }
+   else if (!strcmp(label, "run_ahead_frames"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Runs the core this many frames\n"
+            "ahead of what is shown, and rolls it\n"
+            "back every frame.\n"
+            " \n"
+            "Hides input lag built into the game\n"
+            "itself. Set it to the number of frames\n"
+            "the game lags, more makes it skip.\n"
+            " \n"
+            "Needs a core that can save states.\n"
+            "0 disables it.");
+   }
+   else if (!strcmp(label, "run_ahead_secondary_instance"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Runs ahead on a second instance\n"
+            "of the core instead of rolling back\n"
+            "the main one.\n"
+            " \n"
+            "For cores that misbehave when states\n"
+            "are loaded all the time. Takes effect\n"
+            "when content is loaded.");
+   }
    else if (!strcmp(label, "audio_rate_control_delta"))
    {
       snprintf(msg, sizeof_msg,
@@ -2207,6 +2341,42 @@ int setting_get_description(const char *label, char *msg,
             " Input rate is defined as: \n"
             " input rate * (1.0 +/- (rate control delta))");
    }
+   else if (!strcmp(label, "audio_exclusive_mode"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Take the audio device exclusively.\n"
+            " \n"
+            "Bypasses the system mixer for lower \n"
+            "latency. Other programs cannot play \n"
+            "sound while RetroArch runs. \n"
+            " \n"
+            "WASAPI opens the device in exclusive, \n"
+            "event-driven mode. ALSA writes directly \n"
+            "into the mapped device buffer.");
+   }
+   else if (!strcmp(label, "audio_lazy_init"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Open the audio device lazily.\n"
+            " \n"
+            "The audio driver and resampler start \n"
+            "when content first runs rather than \n"
+            "at startup, so the menu comes up \n"
+            "sooner.");
+   }
+   else if (!strcmp(label, "audio_show_stats"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Show audio buffer statistics.\n"
+            " \n"
+            "Shows how full the audio driver buffer is, \n"
+            "the current rate control adjustment and how \n"
+            "often the buffer ran empty or too full. \n"
+            " \n"
+            "Useful to find the lowest audio latency \n"
+            "that plays without crackling. Needs audio \n"
+            "rate control.");
+   }
    else if (!strcmp(label, "audio_max_timing_skew"))
    {
       snprintf(msg, sizeof_msg,
@@ -2260,6 +2430,10 @@ int setting_get_description(const char *label, char *msg,
             " \n"
             "RSound wants an IP address to an RSound \n"
             "server."
+#endif
+#ifdef HAVE_WASAPI
+            " \n"
+            "WASAPI wants an endpoint ID string."
 #endif
             );
    }
@@ -2277,6 +2451,17 @@ int setting_get_description(const char *label, char *msg,
             "configured as if it is a 60 Hz monitor \n"
             "(divide refresh rate by 2).");
    }
+   else if (!strcmp(label, "audio_threaded_dsp"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Run audio DSP and resampling\n"
+            "on a thread of their own.\n"
+            " \n"
+            "Frees up time on the emulation thread\n"
+            "when a heavy DSP filter or resampler\n"
+            "is in use, at the cost of a little\n"
+            "more audio latency.");
+   }
    else if (!strcmp(label, "video_threaded"))
    {
       snprintf(msg, sizeof_msg,
@@ -2336,6 +2521,37 @@ int setting_get_description(const char *label, char *msg,
             "Gain can be controlled in runtime with Input\n"
             "Volume Up / Input Volume Down.");
    }
+   else if (!strcmp(label, "savestate_async_write"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Write save states in the background.\n"
+            " \n"
+            "The state is snapshotted into memory and \n"
+            "written out by the data runloop, so slow \n"
+            "storage doesn't stall the content. A \n"
+            "message is shown once it has been written.");
+   }
+   else if (!strcmp(label, "savestate_compression"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Compress save states.\n"
+            " \n"
+            "Save states are deflated before being \n"
+            "written to disk. Compressed states are \n"
+            "detected automatically when loading.");
+   }
+   else if (!strcmp(label, "savestate_delta"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Store compressed save states as a delta \n"
+            "against the state in slot 0.\n"
+            " \n"
+            "Saves a lot of disk space for cores with big \n"
+            "states. Each delta refers to a compressed copy \n"
+            "of slot 0 kept next to it as <slot>.<crc32>, \n"
+            "so slot 0 can be overwritten. Copies no slot \n"
+            "refers to any more are deleted on the next save.");
+   }
    else if (!strcmp(label, "block_sram_overwrite"))
    {
       snprintf(msg, sizeof_msg,
@@ -2360,6 +2576,26 @@ int setting_get_description(const char *label, char *msg,
             "Do not rely on this cap to be perfectly \n"
             "accurate.");
    }
+   else if (!strcmp(label, "frame_time_graph_show"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Shows a graph of the last frame times.\n"
+            " \n"
+            "Followed by the 99th percentile of the \n"
+            "frame time, and of the time spent running \n"
+            "the core, presenting the frame and waiting.");
+   }
+   else if (!strcmp(label, "fastforward_frameskip"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Fast forward frame skip.\n"
+            " \n"
+            "While fast forwarding faster than the \n"
+            "display refresh rate, frames which can't \n"
+            "be shown are neither converted, filtered, \n"
+            "uploaded nor heard. Cores which support it \n"
+            "also skip rendering them.");
+   }
    else if (!strcmp(label, "pause_nonactive"))
    {
       snprintf(msg, sizeof_msg,
@@ -2489,6 +2725,51 @@ int setting_get_description(const char *label, char *msg,
             "at a time, increasing the rewinding \n"
             "speed.");
    }
+   else if (!strcmp(label, "rewind_speed"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Rewind speed.\n"
+            " \n"
+            "Maximum number of states to rewind \n"
+            "per frame. Fewer are rewound when it \n"
+            "would take too long to keep up the \n"
+            "frame rate.");
+   }
+   else if (!strcmp(label, "rewind_keyframe_interval"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Rewind keyframe interval.\n"
+            " \n"
+            "Stores a full savestate in the rewind \n"
+            "buffer every this many seconds, so \n"
+            "seeking far back doesn't need to go \n"
+            "through every frame in between. \n"
+            " \n"
+            "Uses a lot of rewind buffer with big \n"
+            "savestates. 0 disables it.");
+   }
+   else if (!strcmp(label, "rewind_cold_after"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Rewind history compression.\n"
+            " \n"
+            "Rewind history older than this many \n"
+            "seconds is deflated, so more of it \n"
+            "fits in the rewind buffer. \n"
+            " \n"
+            "Rewinding past this point costs some \n"
+            "extra CPU time. 0 disables it.");
+   }
+   else if (!strcmp(label, "rewind_threaded"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Threaded rewind compression.\n"
+            " \n"
+            "Generates rewind deltas on a separate \n"
+            "thread. Reduces frame time spikes with \n"
+            "large savestates, at the cost of \n"
+            "an extra state-sized buffer.");
+   }
    else if (!strcmp(label, "rewind_enable"))
    {
       snprintf(msg, sizeof_msg,
@@ -2505,6 +2786,29 @@ int setting_get_description(const char *label, char *msg,
             "Will attempt to auto-configure \n"
             "joypads, Plug-and-Play style.");
    }
+   else if (!strcmp(label, "input_poll_late"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Poll input late.\n"
+            " \n"
+            "Holds back the input poll a core asks \n"
+            "for until it first reads input. \n"
+            " \n"
+            "Can reduce latency with cores that \n"
+            "read input late in their frame.");
+   }
+   else if (!strcmp(label, "input_poll_yield"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Yield at input poll.\n"
+            " \n"
+            "Suspends the core when it polls input, \n"
+            "and spends the frame delay there \n"
+            "instead of before the frame. \n"
+            " \n"
+            "Work the core does before reading \n"
+            "input then no longer delays it.");
+   }
    else if (!strcmp(label, "camera_allow"))
    {
       snprintf(msg, sizeof_msg,
@@ -3014,6 +3318,10 @@ static void general_write_handler(void *data)
       global->audio_data.volume_gain = db_to_gain(*setting->value.fraction);
    else if (!strcmp(setting->name, "audio_latency"))
       rarch_cmd = EVENT_CMD_AUDIO_REINIT;
+   else if (!strcmp(setting->name, "audio_exclusive_mode"))
+      rarch_cmd = EVENT_CMD_AUDIO_REINIT;
+   else if (!strcmp(setting->name, "audio_resampler_quality"))
+      rarch_cmd = EVENT_CMD_AUDIO_REINIT;
    else if (!strcmp(setting->name, "audio_rate_control_delta"))
    {
       if (*setting->value.fraction < 0.0005)
@@ -3072,6 +3380,14 @@ static void general_write_handler(void *data)
    }
    else if (!strcmp(setting->name, "netplay_delay_frames"))
       global->has_set_netplay_delay_frames = (global->netplay_sync_frames > 0);
+   else if (!strcmp(setting->name, "netplay_input_delay_frames"))
+      global->has_set_netplay_input_delay_frames =
+         (global->netplay_input_delay_frames > 0);
+   else if (!strcmp(setting->name, "netplay_users"))
+      global->has_set_netplay_users = true;
+   else if (!strcmp(setting->name, "netplay_rendezvous_server"))
+      global->has_set_netplay_rendezvous =
+         (setting->value.string[0] != '\0');
 #endif
    else if (!strcmp(setting->name, "log_verbosity"))
    {
@@ -3746,6 +4062,72 @@ static bool setting_append_list_general_options(
    settings_list_current_add_range(list, list_info, 1, 32768, 1, true, false);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_UINT(
+         settings->rewind_speed,
+         "rewind_speed",
+         "Rewind Speed",
+         rewind_speed,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 1, 8, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_THREADS
+   CONFIG_BOOL(
+         settings->rewind_threaded,
+         "rewind_threaded",
+         "Threaded Rewind",
+         rewind_threaded,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
+#ifdef HAVE_ZLIB_DEFLATE
+   CONFIG_UINT(
+         settings->rewind_cold_after,
+         "rewind_cold_after",
+         "Rewind Compress After (sec)",
+         rewind_cold_after,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 3600, 5, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
+   CONFIG_UINT(
+         settings->rewind_keyframe_interval,
+         "rewind_keyframe_interval",
+         "Rewind Keyframe Interval (sec)",
+         rewind_keyframe_interval,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 600, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_BOOL(
+         settings->netplay_show_stats,
+         "netplay_show_stats",
+         "Show Netplay Stats",
+         netplay_show_stats,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    END_SUB_GROUP(list, list_info);
 
    START_SUB_GROUP(list, list_info, "Saving", group_info.name, subgroup_info);
@@ -3791,6 +4173,46 @@ static bool setting_append_list_general_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         settings->savestate_async_write,
+         "savestate_async_write",
+         "Save State Background Write",
+         savestate_async_write,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_ZLIB_DEFLATE
+   CONFIG_BOOL(
+         settings->savestate_compression,
+         "savestate_compression",
+         "Save State Compression",
+         savestate_compression,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
+   CONFIG_BOOL(
+         settings->savestate_delta,
+         "savestate_delta",
+         "Save State Delta Against Slot 0",
+         savestate_delta,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
    CONFIG_BOOL(
          settings->savestate_auto_save,
          "savestate_auto_save",
@@ -3844,6 +4266,19 @@ static bool setting_append_list_general_options(
          general_read_handler);
    settings_list_current_add_range(list, list_info, 1, 10, 0.1, true, true);
 
+   CONFIG_BOOL(
+         settings->fastforward_frameskip,
+         "fastforward_frameskip",
+         "Fast Forward Frame Skip",
+         fastforward_frameskip,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_FLOAT(
          settings->slowmotion_ratio,
          "slowmotion_ratio",
@@ -3980,6 +4415,18 @@ static bool setting_append_list_video_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(settings->frame_time_graph_show,
+         "frame_time_graph_show",
+         "Show Frame Time Graph",
+         frame_time_graph_show,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_BOOL(
          settings->video.shared_context,
          "video_shared_context",
@@ -3993,6 +4440,19 @@ static bool setting_append_list_video_options(
          general_read_handler);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->video.dirty_rows,
+         "video_dirty_rows",
+         "Upload Changed Rows Only",
+         video_dirty_rows,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    END_SUB_GROUP(list, list_info);
    START_SUB_GROUP(list, list_info, "Monitor", group_info.name, subgroup_info);
 
@@ -4367,6 +4827,20 @@ static bool setting_append_list_video_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         settings->video.vrr_enable,
+         "video_vrr_enable",
+         "Variable Refresh Rate",
+         vrr_enable,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_cmd(list, list_info, EVENT_CMD_REINIT);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO|SD_FLAG_ADVANCED);
+
    CONFIG_UINT(
          settings->video.swap_interval,
          "video_swap_interval",
@@ -4404,6 +4878,31 @@ static bool setting_append_list_video_options(
    settings_list_current_add_range(list, list_info, 0, 3, 1, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->video.hard_sync_adaptive,
+         "video_hard_sync_adaptive",
+         "Adaptive Hard GPU Sync",
+         hard_sync_adaptive,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_UINT(
+         settings->video.max_swapchain_images,
+         "video_max_swapchain_images",
+         "Max Swapchain Images",
+         max_swapchain_images,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 2, 4, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_UINT(
          settings->video.frame_delay,
          "video_frame_delay",
@@ -4416,6 +4915,46 @@ static bool setting_append_list_video_options(
    settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->video.frame_delay_auto,
+         "video_frame_delay_auto",
+         "Automatic Frame Delay",
+         frame_delay_auto,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_UINT(
+         settings->run_ahead_frames,
+         "run_ahead_frames",
+         "Run-Ahead Frames",
+         run_ahead_frames,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 6, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_DYNAMIC
+   CONFIG_BOOL(
+         settings->run_ahead_secondary_instance,
+         "run_ahead_secondary_instance",
+         "Run-Ahead Second Instance",
+         run_ahead_secondary_instance,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
 #if !defined(RARCH_MOBILE)
    CONFIG_BOOL(
          settings->video.black_frame_insertion,
@@ -4689,6 +5228,48 @@ static bool setting_append_list_audio_options(
    settings_list_current_add_range(list, list_info, 1, 256, 1.0, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_IS_DEFERRED|SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->audio.exclusive_mode,
+         "audio_exclusive_mode",
+         "Audio Exclusive Mode",
+         audio_exclusive_mode,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_IS_DEFERRED|SD_FLAG_ADVANCED);
+
+   CONFIG_BOOL(
+         settings->audio.lazy_init,
+         "audio_lazy_init",
+         "Audio Lazy Init",
+         audio_lazy_init,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_THREADS
+   CONFIG_BOOL(
+         settings->audio.threaded_dsp,
+         "audio_threaded_dsp",
+         "Threaded Audio DSP",
+         audio_threaded_dsp,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_cmd(list, list_info, EVENT_CMD_AUDIO_REINIT);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO|SD_FLAG_ADVANCED);
+#endif
+
    CONFIG_FLOAT(
          settings->audio.rate_control_delta,
          "audio_rate_control_delta",
@@ -4709,6 +5290,19 @@ static bool setting_append_list_audio_options(
          false);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->audio.show_stats,
+         "audio_show_stats",
+         "Show Audio Stats",
+         audio_show_stats,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_FLOAT(
          settings->audio.max_timing_skew,
          "audio_max_timing_skew",
@@ -4771,6 +5365,21 @@ static bool setting_append_list_audio_options(
          general_read_handler);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_UINT(
+         settings->audio.resampler_quality,
+         "audio_resampler_quality",
+         "Audio Resampler Quality",
+         audio_resampler_quality,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info,
+         RESAMPLER_QUALITY_DONTCARE, RESAMPLER_QUALITY_HIGHEST, 1, true, true);
+   (*list)[list_info->index - 1].get_string_representation = 
+      &setting_get_string_representation_uint_audio_resampler_quality;
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_PATH(
          settings->audio.dsp_plugin,
          "audio_dsp_plugin",
@@ -4838,6 +5447,32 @@ static bool setting_append_list_input_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         settings->input.poll_late,
+         "input_poll_late",
+         "Poll Input Late",
+         input_poll_late,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
+#ifdef HAVE_LIBCO
+   CONFIG_BOOL(
+         settings->input.poll_yield,
+         "input_poll_yield",
+         "Yield at Input Poll",
+         input_poll_yield,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+#endif
+
    CONFIG_BOOL(
          settings->input.autoconfig_descriptor_label_show,
          "autoconfig_descriptor_label_show",
@@ -5379,6 +6014,19 @@ static bool setting_append_list_menu_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         settings->menu.throttle,
+         "menu_throttle",
+         "Throttle Idle Menu",
+         menu_throttle,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
 #ifdef HAVE_THREADS
    CONFIG_BOOL(
          settings->menu.threaded_data_runloop_enable,
@@ -5737,6 +6385,42 @@ static bool setting_append_list_netplay_options(
    settings_list_current_add_range(list, list_info, 0, 10, 1, true, false);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_UINT(
+         global->netplay_input_delay_frames,
+         "netplay_input_delay_frames",
+         "Netplay Input Delay Frames",
+         0,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 8, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_UINT(
+         global->netplay_users,
+         "netplay_users",
+         "Netplay Users",
+         2,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 2, 4, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_UINT(
+         settings->netplay_check_frames,
+         "netplay_check_frames",
+         "Netplay Check Frames",
+         netplay_check_frames,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 600, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_UINT(
          global->netplay_port,
          "netplay_tcp_udp_port",
@@ -5749,6 +6433,17 @@ static bool setting_append_list_netplay_options(
    settings_list_current_add_range(list, list_info, 1, 99999, 1, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ALLOW_INPUT);
 
+   CONFIG_STRING(
+         global->netplay_rendezvous,
+         "netplay_rendezvous_server",
+         "Netplay Rendezvous Server",
+         "",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ALLOW_INPUT | SD_FLAG_ADVANCED);
+
    END_SUB_GROUP(list, list_info);
 
    START_SUB_GROUP(
@@ -6158,6 +6853,21 @@ static bool setting_append_list_path_options(
          list_info,
          SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
 
+   CONFIG_DIR(
+         settings->video.shader_cache_dir,
+         "video_shader_cache_dir",
+         "Shader Cache Directory",
+         "",
+         "<None>",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(
+         list,
+         list_info,
+         SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
+
    CONFIG_DIR(
          global->record.output_dir,
          "recording_output_directory",
@@ -6280,6 +6990,21 @@ static bool setting_append_list_path_options(
          list_info,
          SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
 
+   CONFIG_DIR(
+         settings->thumbnails_directory,
+         "thumbnails_directory",
+         "Thumbnails Directory",
+         "",
+         "<default>",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(
+         list,
+         list_info,
+         SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
+
    CONFIG_DIR(
          global->savefile_dir,
          "savefile_directory",
@@ -6543,6 +7268,8 @@ rarch_setting_t *setting_new(unsigned mask)
 
    settings_info_list_free(list_info);
 
+   settings_list_build_index(list);
+
    return list;
 
 error:
@@ -14,8 +14,160 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "settings_list.h"
 
+/* Live setting lists that can have a name index at the same time. */
+#define SETTINGS_LIST_INDEXES 4
+
+typedef struct settings_list_index
+{
+   const rarch_setting_t *list;
+   const rarch_setting_t **table;
+   uint32_t *hashes;
+   size_t mask;
+} settings_list_index_t;
+
+static settings_list_index_t settings_list_indexes[SETTINGS_LIST_INDEXES];
+
+static uint32_t settings_list_hash(const char *str)
+{
+   uint32_t hash = 5381;
+
+   while (*str)
+      hash = (hash << 5) + hash + (unsigned char)*str++;
+
+   return hash;
+}
+
+static void settings_list_index_free(settings_list_index_t *index)
+{
+   free(index->table);
+   free(index->hashes);
+   memset(index, 0, sizeof(*index));
+}
+
+/**
+ * settings_list_build_index:
+ * @list               : pointer to settings list, terminated by ST_NONE.
+ *
+ * Hashes the names of the actions and groups of @list,
+ * for settings_list_find() to look them up without walking
+ * the whole list. The list must not be resized afterwards.
+ **/
+void settings_list_build_index(const rarch_setting_t *list)
+{
+   size_t i, count = 0, size = 16;
+   const rarch_setting_t *setting = NULL;
+   settings_list_index_t *index   = NULL;
+
+   if (!list)
+      return;
+
+   for (i = 0; i < SETTINGS_LIST_INDEXES; i++)
+   {
+      if (settings_list_indexes[i].list == list)
+         settings_list_index_free(&settings_list_indexes[i]);
+      if (!index && !settings_list_indexes[i].list)
+         index = &settings_list_indexes[i];
+   }
+
+   /* Too many lists around, this one gets searched linearly. */
+   if (!index)
+      return;
+
+   for (setting = list; setting->type != ST_NONE; setting++)
+      count++;
+
+   while (size < count * 2)
+      size *= 2;
+
+   index->table  = (const rarch_setting_t**)calloc(size, sizeof(*index->table));
+   index->hashes = (uint32_t*)calloc(size, sizeof(*index->hashes));
+
+   if (!index->table || !index->hashes)
+   {
+      settings_list_index_free(index);
+      return;
+   }
+
+   index->list = list;
+   index->mask = size - 1;
+
+   for (setting = list; setting->type != ST_NONE; setting++)
+   {
+      uint32_t hash;
+
+      if (setting->type > ST_GROUP || !setting->name)
+         continue;
+
+      hash = settings_list_hash(setting->name);
+
+      /* Keep the first of several settings sharing a name,
+       * that is the one a linear search would find. */
+      for (i = hash & index->mask; index->table[i]; i = (i + 1) & index->mask)
+      {
+         if (index->hashes[i] == hash && !strcmp(index->table[i]->name,
+                  setting->name))
+            break;
+      }
+
+      if (index->table[i])
+         continue;
+
+      index->table[i]  = setting;
+      index->hashes[i] = hash;
+   }
+}
+
+/**
+ * settings_list_find:
+ * @list               : pointer to settings list.
+ * @name               : name of the setting to search for.
+ * @setting            : set to the setting found, or NULL.
+ *
+ * Looks @name up in the index settings_list_build_index() made
+ * for @list, considering only actions and groups.
+ *
+ * Returns: true (1) if @list has an index, otherwise false (0),
+ * in which case the caller has to search @list itself.
+ **/
+bool settings_list_find(const rarch_setting_t *list, const char *name,
+      rarch_setting_t **setting)
+{
+   size_t i;
+   uint32_t hash;
+   settings_list_index_t *index = NULL;
+
+   *setting = NULL;
+
+   for (i = 0; i < SETTINGS_LIST_INDEXES; i++)
+   {
+      if (list && settings_list_indexes[i].list == list)
+      {
+         index = &settings_list_indexes[i];
+         break;
+      }
+   }
+
+   if (!index)
+      return false;
+
+   hash = settings_list_hash(name);
+
+   for (i = hash & index->mask; index->table[i]; i = (i + 1) & index->mask)
+   {
+      if (index->hashes[i] == hash && !strcmp(index->table[i]->name, name))
+      {
+         *setting = (rarch_setting_t*)index->table[i];
+         break;
+      }
+   }
+
+   return true;
+}
+
 void settings_info_list_free(rarch_setting_info_t *list_info)
 {
    if (list_info)
@@ -122,6 +274,12 @@ void settings_list_current_add_cmd(
 
 void settings_list_free(rarch_setting_t *list)
 {
+   unsigned i;
+
+   for (i = 0; i < SETTINGS_LIST_INDEXES; i++)
+      if (list && settings_list_indexes[i].list == list)
+         settings_list_index_free(&settings_list_indexes[i]);
+
    if (list)
       free(list);
 }
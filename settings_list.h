@@ -227,6 +227,31 @@ void settings_info_list_free(rarch_setting_info_t *list_info);
 
 void settings_list_free(rarch_setting_t *list);
 
+/**
+ * settings_list_build_index:
+ * @list               : pointer to settings list, terminated by ST_NONE.
+ *
+ * Hashes the names of the actions and groups of @list,
+ * for settings_list_find() to look them up without walking
+ * the whole list. The list must not be resized afterwards.
+ **/
+void settings_list_build_index(const rarch_setting_t *list);
+
+/**
+ * settings_list_find:
+ * @list               : pointer to settings list.
+ * @name               : name of the setting to search for.
+ * @setting            : set to the setting found, or NULL.
+ *
+ * Looks @name up in the index settings_list_build_index() made
+ * for @list, considering only actions and groups.
+ *
+ * Returns: true (1) if @list has an index, otherwise false (0),
+ * in which case the caller has to search @list itself.
+ **/
+bool settings_list_find(const rarch_setting_t *list, const char *name,
+      rarch_setting_t **setting);
+
 rarch_setting_info_t *settings_info_list_new(void);
 
 rarch_setting_t *settings_list_new(unsigned size);
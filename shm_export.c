@@ -0,0 +1,279 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <compat/strl.h>
+
+#include "shm_export.h"
+#include "dynamic.h"
+#include "general.h"
+#include "performance.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define SHM_EXPORT_ALIGN(x) (((x) + 63) & ~(size_t)63)
+
+static struct shm_export_header *shm_header;
+static size_t shm_size;
+static char shm_name[PATH_MAX_LENGTH];
+
+/* Frame the core rendered this frame, if any. */
+static const void *shm_video_data;
+static unsigned shm_video_width, shm_video_height;
+static size_t shm_video_pitch;
+static bool shm_video_pending;
+
+/* Audio the core rendered this frame. */
+static int16_t *shm_audio;
+static size_t shm_audio_frames;
+
+static const unsigned shm_memory_ids[SHM_EXPORT_MAX_MEMORY] = {
+   RETRO_MEMORY_SAVE_RAM,
+   RETRO_MEMORY_RTC,
+   RETRO_MEMORY_SYSTEM_RAM,
+   RETRO_MEMORY_VIDEO_RAM,
+};
+
+bool shm_export_init(const char *name)
+{
+   int fd;
+   unsigned i;
+   size_t offset;
+   void *map;
+   struct shm_export_header header = {0};
+   global_t *global = global_get_ptr();
+   const struct retro_system_av_info *av_info = &global->system.av_info;
+   double fps = av_info->timing.fps > 0.0 ? av_info->timing.fps : 60.0;
+
+   shm_export_free();
+
+   header.magic          = SHM_EXPORT_MAGIC;
+   header.version        = SHM_EXPORT_VERSION;
+   header.video_format   = global->system.pix_fmt;
+   header.video_offset   = SHM_EXPORT_ALIGN(sizeof(header));
+   header.video_capacity = av_info->geometry.max_width *
+      av_info->geometry.max_height * sizeof(uint32_t);
+   header.audio_rate     = av_info->timing.sample_rate;
+   header.audio_offset   = SHM_EXPORT_ALIGN(header.video_offset +
+         header.video_capacity);
+   /* Cores don't render the same amount of audio every frame,
+    * twice the average leaves enough room for the uneven ones. */
+   header.audio_capacity = 2 * (uint32_t)(av_info->timing.sample_rate / fps)
+      + 1024;
+
+   offset = SHM_EXPORT_ALIGN(header.audio_offset +
+         header.audio_capacity * 2 * sizeof(int16_t));
+
+   for (i = 0; i < SHM_EXPORT_MAX_MEMORY; i++)
+   {
+      struct shm_export_region *region = &header.memory[header.num_memory];
+      size_t size = pretro_get_memory_size(shm_memory_ids[i]);
+
+      if (!size || !pretro_get_memory_data(shm_memory_ids[i]))
+         continue;
+
+      region->id     = shm_memory_ids[i];
+      region->offset = offset;
+      region->size   = size;
+      offset         = SHM_EXPORT_ALIGN(offset + size);
+      header.num_memory++;
+   }
+
+   header.size = offset;
+
+   fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+   if (fd < 0)
+   {
+      RARCH_ERR("Could not create shared memory \"%s\".\n", name);
+      return false;
+   }
+
+   if (ftruncate(fd, offset) != 0)
+      goto error;
+
+   map = mmap(NULL, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (map == MAP_FAILED)
+      goto error;
+   close(fd);
+
+   shm_audio = (int16_t*)malloc(header.audio_capacity * 2 * sizeof(int16_t));
+   if (!shm_audio)
+   {
+      munmap(map, offset);
+      shm_unlink(name);
+      return false;
+   }
+
+   memcpy(map, &header, sizeof(header));
+   shm_header = (struct shm_export_header*)map;
+   shm_size   = offset;
+   strlcpy(shm_name, name, sizeof(shm_name));
+
+   RARCH_LOG("Exporting frames and %u memory regions to shared memory \"%s\" (%u bytes).\n",
+         header.num_memory, name, (unsigned)offset);
+   return true;
+
+error:
+   RARCH_ERR("Could not map shared memory \"%s\".\n", name);
+   close(fd);
+   shm_unlink(name);
+   return false;
+}
+
+void shm_export_free(void)
+{
+   if (!shm_header)
+      return;
+
+   munmap(shm_header, shm_size);
+   shm_unlink(shm_name);
+   free(shm_audio);
+
+   shm_header        = NULL;
+   shm_audio         = NULL;
+   shm_audio_frames  = 0;
+   shm_video_pending = false;
+}
+
+void shm_export_video(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   if (!shm_header || !data)
+      return;
+
+   shm_video_data    = data;
+   shm_video_width   = width;
+   shm_video_height  = height;
+   shm_video_pitch   = pitch;
+   shm_video_pending = true;
+}
+
+void shm_export_audio(const int16_t *data, size_t samples)
+{
+   size_t frames = samples >> 1;
+
+   if (!shm_header)
+      return;
+
+   /* Drops what doesn't fit, rather than holding up the core. */
+   if (frames > shm_header->audio_capacity - shm_audio_frames)
+      frames = shm_header->audio_capacity - shm_audio_frames;
+
+   memcpy(shm_audio + shm_audio_frames * 2, data,
+         frames * 2 * sizeof(int16_t));
+   shm_audio_frames += frames;
+}
+
+static void shm_export_copy_video(struct shm_export_header *header)
+{
+   unsigned y;
+   size_t line_size;
+   global_t *global = global_get_ptr();
+   uint8_t *out     = (uint8_t*)header + header->video_offset;
+   const uint8_t *in = (const uint8_t*)shm_video_data;
+
+   header->video_format = global->system.pix_fmt;
+   header->video_frame  = header->frame;
+
+   if (shm_video_data == RETRO_HW_FRAME_BUFFER_VALID)
+   {
+      header->video_width  = 0;
+      header->video_height = 0;
+      header->video_pitch  = 0;
+      return;
+   }
+
+   line_size = shm_video_width *
+      (header->video_format == RETRO_PIXEL_FORMAT_XRGB8888 ?
+       sizeof(uint32_t) : sizeof(uint16_t));
+
+   /* Larger than the core said its frames would get. */
+   if (line_size * shm_video_height > header->video_capacity)
+   {
+      header->video_width  = 0;
+      header->video_height = 0;
+      header->video_pitch  = 0;
+      return;
+   }
+
+   header->video_width  = shm_video_width;
+   header->video_height = shm_video_height;
+   header->video_pitch  = line_size;
+
+   if (shm_video_pitch == line_size)
+   {
+      memcpy(out, in, line_size * shm_video_height);
+      return;
+   }
+
+   for (y = 0; y < shm_video_height; y++,
+         out += line_size, in += shm_video_pitch)
+      memcpy(out, in, line_size);
+}
+
+void shm_export_commit(void)
+{
+   unsigned i;
+   struct shm_export_header *header = shm_header;
+   RARCH_PERFORMANCE_INIT(shm_export_commit);
+
+   if (!header)
+      return;
+
+   RARCH_PERFORMANCE_START(shm_export_commit);
+
+   header->seq++;
+   __sync_synchronize();
+
+   header->frame++;
+
+   if (shm_video_pending)
+      shm_export_copy_video(header);
+
+   memcpy((uint8_t*)header + header->audio_offset, shm_audio,
+         shm_audio_frames * 2 * sizeof(int16_t));
+   header->audio_frames = shm_audio_frames;
+
+   for (i = 0; i < header->num_memory; i++)
+   {
+      const struct shm_export_region *region = &header->memory[i];
+      const void *data = pretro_get_memory_data(region->id);
+      size_t size      = pretro_get_memory_size(region->id);
+
+      if (size > region->size)
+         size = region->size;
+      if (data)
+         memcpy((uint8_t*)header + region->offset, data, size);
+   }
+
+   __sync_synchronize();
+   header->seq++;
+
+   /* The frame is only valid until the core runs again. */
+   shm_video_pending = false;
+   shm_video_data    = NULL;
+   shm_audio_frames  = 0;
+
+   RARCH_PERFORMANCE_STOP(shm_export_commit);
+}
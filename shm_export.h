@@ -0,0 +1,136 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_SHM_EXPORT_H
+#define __RARCH_SHM_EXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Layout of the shared memory segment (shm_export_name).
+ *
+ * The segment starts with struct shm_export_header, the offsets
+ * in it are from the start of the segment. Everything is in the
+ * native byte order of the host.
+ *
+ * The frame, its audio and the memory of the core are written
+ * together after every frame the core ran, guarded by seq:
+ * it is odd while they are written, and goes up by two for every
+ * frame. A reader copies what it needs, and retries if seq was
+ * odd before, or has changed after. */
+
+#define SHM_EXPORT_MAGIC      0x4d485352 /* "RSHM" */
+#define SHM_EXPORT_VERSION    1
+#define SHM_EXPORT_MAX_MEMORY 4
+
+struct shm_export_region
+{
+   /* RETRO_MEMORY_*. */
+   uint32_t id;
+   uint32_t offset;
+   /* Bytes the core has, and that were exported of it. */
+   uint32_t size;
+};
+
+struct shm_export_header
+{
+   uint32_t magic;
+   uint32_t version;
+   /* Size of the whole segment. */
+   uint32_t size;
+   volatile uint32_t seq;
+   /* Frames the core ran since the segment was created. */
+   uint64_t frame;
+
+   /* Last frame the core rendered, as it rendered it.
+    * Width and height are 0 for hardware rendered frames. */
+   uint32_t video_format; /* enum retro_pixel_format */
+   uint32_t video_width;
+   uint32_t video_height;
+   uint32_t video_pitch;
+   uint32_t video_offset;
+   uint32_t video_capacity;
+   /* Frame the video was last rendered in. */
+   uint64_t video_frame;
+
+   /* Interleaved stereo int16_t samples of the last frame. */
+   uint32_t audio_rate;
+   uint32_t audio_frames;
+   uint32_t audio_offset;
+   uint32_t audio_capacity; /* in frames */
+
+   uint32_t num_memory;
+   struct shm_export_region memory[SHM_EXPORT_MAX_MEMORY];
+};
+
+/**
+ * shm_export_init:
+ * @name                     : Name of the POSIX shared memory
+ *                             object, e.g. "/retroarch".
+ *
+ * Creates the segment for the loaded content, sized for its
+ * largest frames and the memory regions the core has.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool shm_export_init(const char *name);
+
+/**
+ * shm_export_free:
+ *
+ * Unmaps and removes the segment.
+ **/
+void shm_export_free(void);
+
+/**
+ * shm_export_video:
+ * @data                     : Frame as the core rendered it.
+ * @width                    : Width of the frame.
+ * @height                   : Height of the frame.
+ * @pitch                    : Pitch of the frame.
+ *
+ * Takes note of the frame, to be copied by shm_export_commit().
+ **/
+void shm_export_video(const void *data, unsigned width,
+      unsigned height, size_t pitch);
+
+/**
+ * shm_export_audio:
+ * @data                     : Interleaved stereo samples.
+ * @samples                  : Amount of samples (not frames).
+ *
+ * Stages the audio the core rendered this frame.
+ **/
+void shm_export_audio(const int16_t *data, size_t samples);
+
+/**
+ * shm_export_commit:
+ *
+ * Publishes the frame, its audio and the memory of the core.
+ * Called once the core ran a frame.
+ **/
+void shm_export_commit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,444 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2014-2015 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks the rewind delta encoder with every scanner the 
+ * host can run, and checks that popping gives back the pushed states.
+ *
+ * Feed it a series of savestate dumps of the same game (in push order),
+ * or run it without arguments to use synthetic states.
+ *
+ * Before that, the cold tier is checked on small synthetic states,
+ * with rings small enough that deltas get deflated, inflated again
+ * and dropped once over budget, and seeking through keyframes is
+ * checked against popping one state at a time. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../../rewind.h"
+#include "../../libretro.h"
+
+#define SYNTH_STATE_SIZE  (4 << 20)
+#define SYNTH_STATES      64
+#define BUFFER_SIZE       (256 << 20)
+#define PASSES            8
+
+#define CHECK_STATE_SIZE  (64 << 10)
+#define CHECK_STATES      200
+
+static unsigned cpu_features;
+
+unsigned rewind_test_get_cpu_features(void)
+{
+   return cpu_features;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static uint8_t *load_state(const char *path, size_t *size)
+{
+   long len;
+   uint8_t *buf = NULL;
+   FILE *file   = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   fseek(file, 0, SEEK_END);
+   len = ftell(file);
+   rewind(file);
+
+   if (len > 0 && (buf = (uint8_t*)malloc(len)))
+   {
+      if (fread(buf, 1, len, file) != (size_t)len)
+      {
+         free(buf);
+         buf = NULL;
+      }
+   }
+
+   fclose(file);
+   *size = len;
+   return buf;
+}
+
+/* Mostly static state with a few scattered writes per frame, 
+ * and one contiguous 'framebuffer' region that always changes. */
+static void synth_states(uint8_t **states, unsigned num, size_t size)
+{
+   unsigned i, j;
+   uint32_t seed = 1;
+
+   states[0] = (uint8_t*)malloc(size);
+   for (j = 0; j < size; j++)
+   {
+      seed = seed * 1103515245 + 12345;
+      states[0][j] = seed >> 24;
+   }
+
+   for (i = 1; i < num; i++)
+   {
+      states[i] = (uint8_t*)malloc(size);
+      memcpy(states[i], states[i - 1], size);
+
+      for (j = 0; j < 2048; j++)
+      {
+         seed = seed * 1103515245 + 12345;
+         states[i][(seed >> 4) % size] ^= seed >> 24;
+      }
+
+      for (j = 0; j < size / 64; j++)
+         states[i][size / 2 + j] += i;
+   }
+}
+
+static int run(const char *ident, unsigned features,
+      uint8_t **states, unsigned num, size_t size, double *usec)
+{
+   unsigned i, pass;
+   double start, elapsed = 0.0;
+   state_manager_t *state;
+
+   cpu_features = features;
+   state = state_manager_new(size, BUFFER_SIZE, false, 0, 0);
+   if (!state)
+   {
+      fprintf(stderr, "Failed to allocate state manager.\n");
+      return -1;
+   }
+
+   for (pass = 0; pass < PASSES; pass++)
+   {
+      for (i = 0; i < num; i++)
+      {
+         void *dst;
+         state_manager_push_where(state, &dst);
+         memcpy(dst, states[i], size);
+
+         start = get_time();
+         state_manager_push_do(state);
+         elapsed += get_time() - start;
+      }
+   }
+
+   /* The newest states have to come back exactly. */
+   for (i = num; i-- > 0; )
+   {
+      const void *src;
+
+      if (!state_manager_pop(state, &src))
+         break;
+
+      if (memcmp(src, states[i], size))
+      {
+         fprintf(stderr, "[%s] State %u does not match after pop.\n",
+               ident, i);
+         state_manager_free(state);
+         return -1;
+      }
+   }
+
+   state_manager_free(state);
+
+   *usec = elapsed * 1000000.0 / (PASSES * num);
+   printf("%-8s %10.1f us/push\n", ident, *usec);
+   return 0;
+}
+
+/* Expected history, oldest first, mirroring what has been
+ * pushed and popped so far. */
+struct check_stack
+{
+   unsigned idx[CHECK_STATES * 2];
+   unsigned size;
+};
+
+static void check_push(state_manager_t *state, struct check_stack *stack,
+      uint8_t **states, unsigned i, size_t size)
+{
+   void *dst;
+
+   state_manager_push_where(state, &dst);
+   memcpy(dst, states[i], size);
+   state_manager_push_do(state);
+
+   stack->idx[stack->size++] = i;
+}
+
+/* Pops up to @count states (all of them for ~0u), which have to be
+ * the newest ones on @stack in order. The oldest states may have
+ * been dropped, but at least @min_count have to come back. */
+static int check_pop(const char *ident, state_manager_t *state,
+      struct check_stack *stack, uint8_t **states, size_t size,
+      unsigned count, unsigned min_count)
+{
+   unsigned popped = 0;
+
+   while (popped < count && stack->size)
+   {
+      const void *src;
+      unsigned i = stack->idx[stack->size - 1];
+
+      if (!state_manager_pop(state, &src))
+         break;
+
+      if (memcmp(src, states[i], size))
+      {
+         fprintf(stderr, "[%s] State %u does not match after pop %u.\n",
+               ident, i, popped);
+         return -1;
+      }
+
+      stack->size--;
+      popped++;
+   }
+
+   if (popped < min_count)
+   {
+      fprintf(stderr, "[%s] Only %u of %u states came back.\n",
+            ident, popped, min_count);
+      return -1;
+   }
+
+   return 0;
+}
+
+static int check_cold(const char *ident, bool threaded,
+      size_t buffer_size, unsigned depth, uint8_t **states)
+{
+   unsigned i;
+   int ret                  = -1;
+   struct check_stack stack = {{0}};
+   state_manager_t *state   = state_manager_new(CHECK_STATE_SIZE,
+         buffer_size, threaded, 2, 0);
+
+   if (!state)
+   {
+      fprintf(stderr, "[%s] Failed to allocate state manager.\n", ident);
+      return -1;
+   }
+
+   for (i = 0; i < CHECK_STATES; i++)
+      check_push(state, &stack, states, i, CHECK_STATE_SIZE);
+
+   /* Deep enough to inflate a chunk, whose rest is deflated
+    * again by the pushes that follow. */
+   if (check_pop(ident, state, &stack, states, CHECK_STATE_SIZE,
+            depth, depth) < 0)
+      goto end;
+
+   for (i = 0; i < CHECK_STATES / 4; i++)
+      check_push(state, &stack, states, i, CHECK_STATE_SIZE);
+
+   if (check_pop(ident, state, &stack, states, CHECK_STATE_SIZE,
+            ~0u, depth) < 0)
+      goto end;
+
+   printf("%-8s %-28s ok\n", "cold", ident);
+   ret = 0;
+
+end:
+   state_manager_free(state);
+   return ret;
+}
+
+/* Seeks back by random steps in one state manager and pops the
+ * same number of states one at a time in another, fed the same
+ * states. Both have to end up on the same state. */
+static int check_seek(const char *ident, bool threaded,
+      unsigned cold_after, uint8_t **states)
+{
+   unsigned i, round;
+   int ret                  = -1;
+   uint32_t seed            = 1;
+   state_manager_t *seeker  = state_manager_new(CHECK_STATE_SIZE,
+         4 << 20, threaded, cold_after, 8);
+   state_manager_t *popper  = state_manager_new(CHECK_STATE_SIZE,
+         4 << 20, threaded, cold_after, 8);
+
+   if (!seeker || !popper)
+   {
+      fprintf(stderr, "[%s] Failed to allocate state manager.\n", ident);
+      goto end;
+   }
+
+   for (round = 0; round < 4; round++)
+   {
+      for (i = 0; i < CHECK_STATES; i++)
+      {
+         void *dst;
+
+         state_manager_push_where(seeker, &dst);
+         memcpy(dst, states[i], CHECK_STATE_SIZE);
+         state_manager_push_do(seeker);
+
+         state_manager_push_where(popper, &dst);
+         memcpy(dst, states[i], CHECK_STATE_SIZE);
+         state_manager_push_do(popper);
+      }
+
+      for (i = 0; i < 16; i++)
+      {
+         unsigned step, popped = 0;
+         const void *sought = NULL, *src = NULL;
+
+         seed  = seed * 1103515245 + 12345;
+         step  = 1 + (seed >> 16) % 24;
+
+         if (state_manager_seek(seeker, step, &sought) != step)
+            break;
+
+         while (popped < step && state_manager_pop(popper, &src))
+            popped++;
+
+         if (popped != step || memcmp(sought, src, CHECK_STATE_SIZE))
+         {
+            fprintf(stderr, "[%s] Seeking back %u states in round %u "
+                  "doesn't match popping them.\n", ident, step, round);
+            goto end;
+         }
+      }
+   }
+
+   printf("%-8s %-28s ok\n", "seek", ident);
+   ret = 0;
+
+end:
+   state_manager_free(seeker);
+   state_manager_free(popper);
+   return ret;
+}
+
+static int check_all(void)
+{
+   unsigned i, t;
+   int ret          = 0;
+   uint8_t **states = (uint8_t**)calloc(CHECK_STATES, sizeof(*states));
+
+   synth_states(states, CHECK_STATES, CHECK_STATE_SIZE);
+
+   for (t = 0; t < 2 && !ret; t++)
+   {
+      bool threaded = t;
+
+      /* Ring of a few deltas, most of the history is deflated
+       * and the oldest chunks are dropped. */
+      if (check_cold(threaded ? "1 MiB threaded" : "1 MiB",
+               threaded, 1 << 20, 40, states) < 0)
+         ret = -1;
+      /* A quarter of the buffer can't even hold one state,
+       * and the cold tier only fits a few deltas. */
+      else if (check_cold(threaded ? "undersized ring threaded" :
+               "undersized ring", threaded, 200000, 4, states) < 0)
+         ret = -1;
+      else if (check_seek(threaded ? "keyframes threaded" : "keyframes",
+               threaded, 0, states) < 0)
+         ret = -1;
+      else if (check_seek(threaded ? "keyframes cold threaded" :
+               "keyframes cold", threaded, 2, states) < 0)
+         ret = -1;
+   }
+
+   for (i = 0; i < CHECK_STATES; i++)
+      free(states[i]);
+   free(states);
+
+   return ret;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, host = 0;
+   unsigned num     = 0;
+   size_t size      = 0;
+   double base, usec;
+   uint8_t **states = NULL;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse2"))
+      host |= RETRO_SIMD_SSE2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   host |= RETRO_SIMD_NEON;
+#endif
+
+   cpu_features = host;
+   if (check_all() < 0)
+      return 1;
+
+   if (argc > 1)
+   {
+      num    = argc - 1;
+      states = (uint8_t**)calloc(num, sizeof(*states));
+
+      for (i = 0; i < num; i++)
+      {
+         size_t len;
+         if (!(states[i] = load_state(argv[i + 1], &len)))
+         {
+            fprintf(stderr, "Failed to load %s.\n", argv[i + 1]);
+            return 1;
+         }
+
+         if (i && len != size)
+         {
+            fprintf(stderr, "%s differs in size from %s.\n",
+                  argv[i + 1], argv[1]);
+            return 1;
+         }
+         size = len;
+      }
+   }
+   else
+   {
+      num    = SYNTH_STATES;
+      size   = SYNTH_STATE_SIZE;
+      states = (uint8_t**)calloc(num, sizeof(*states));
+      synth_states(states, num, size);
+   }
+
+   printf("%u states of %u bytes.\n", num, (unsigned)size);
+
+   if (run("C", 0, states, num, size, &base) < 0)
+      return 1;
+
+   if (host & RETRO_SIMD_SSE2)
+   {
+      if (run("SSE2", RETRO_SIMD_SSE2, states, num, size, &usec) < 0)
+         return 1;
+      printf("%-8s %10.2fx\n", "", base / usec);
+   }
+
+   if (host & RETRO_SIMD_NEON)
+   {
+      if (run("NEON", RETRO_SIMD_NEON, states, num, size, &usec) < 0)
+         return 1;
+      printf("%-8s %10.2fx\n", "", base / usec);
+   }
+
+   for (i = 0; i < num; i++)
+      free(states[i]);
+   free(states);
+
+   return 0;
+}
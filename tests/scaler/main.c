@@ -0,0 +1,214 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks the ARGB8888 scaler with every kernel the host can run,
+ * on the kind of jobs screenshots, recording and the software
+ * pixel converter give it, and checks that all kernels give the
+ * same output as the C one. Also times setting up a context, which
+ * screenshots do for every shot.
+ *
+ * Usage: ./scaler-bench [frames per case] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <gfx/scaler/scaler.h>
+
+/* Same bits as in scaler_int.c. */
+#define SCALER_SIMD_VECTOR (1 << 0)
+#define SCALER_SIMD_AVX2   (1 << 1)
+
+struct bench_case
+{
+   const char *ident;
+   enum scaler_type type;
+   enum scaler_pix_fmt in_fmt;
+   int in_width, in_height;
+   int out_width, out_height;
+};
+
+static const struct bench_case cases[] = {
+   { "bilinear 256x224 -> 1280x960",  SCALER_TYPE_BILINEAR, SCALER_FMT_ARGB8888, 256,  224,  1280, 960 },
+   { "sinc 256x224 -> 1280x960",      SCALER_TYPE_SINC,     SCALER_FMT_ARGB8888, 256,  224,  1280, 960 },
+   { "point 256x224 -> 1280x960",     SCALER_TYPE_POINT,    SCALER_FMT_ARGB8888, 256,  224,  1280, 960 },
+   { "bilinear 1920x1080 -> 1279x719", SCALER_TYPE_BILINEAR, SCALER_FMT_ARGB8888, 1920, 1080, 1279, 719 },
+   { "sinc 640x480 -> 320x240",       SCALER_TYPE_SINC,     SCALER_FMT_ARGB8888, 640,  480,  320,  240 },
+   { "bilinear rgb565 320x240 -> 641x481", SCALER_TYPE_BILINEAR, SCALER_FMT_RGB565, 320, 240, 641, 481 },
+   { "lanczos3 256x224 -> 1280x960",  SCALER_TYPE_LANCZOS3, SCALER_FMT_ARGB8888, 256,  224,  1280, 960 },
+   { "lanczos3 1920x1080 -> 1279x719", SCALER_TYPE_LANCZOS3, SCALER_FMT_ARGB8888, 1920, 1080, 1279, 719 },
+   { "lanczos3 640x480 -> 320x240",   SCALER_TYPE_LANCZOS3, SCALER_FMT_ARGB8888, 640,  480,  320,  240 },
+};
+
+static unsigned simd;
+
+unsigned scaler_test_get_simd(void)
+{
+   return simd;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void setup(struct scaler_ctx *ctx, const struct bench_case *c)
+{
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->scaler_type = c->type;
+   ctx->in_fmt      = c->in_fmt;
+   ctx->out_fmt     = SCALER_FMT_ARGB8888;
+   ctx->in_width    = c->in_width;
+   ctx->in_height   = c->in_height;
+   ctx->in_stride   = c->in_width * (c->in_fmt == SCALER_FMT_ARGB8888 ? 4 : 2);
+   ctx->out_width   = c->out_width;
+   ctx->out_height  = c->out_height;
+   ctx->out_stride  = c->out_width * 4;
+}
+
+/* Sets up and tears down a context, the first time
+ * generates the filters, the others find them cached. */
+static void run_setup(const struct bench_case *c)
+{
+   unsigned i;
+   double first, cached;
+   struct scaler_ctx ctx;
+
+   setup(&ctx, c);
+   first = get_time();
+   scaler_ctx_gen_filter(&ctx);
+   scaler_ctx_gen_reset(&ctx);
+   first = get_time() - first;
+
+   cached = get_time();
+   for (i = 0; i < 100; i++)
+   {
+      setup(&ctx, c);
+      scaler_ctx_gen_filter(&ctx);
+      scaler_ctx_gen_reset(&ctx);
+   }
+   cached = (get_time() - cached) / 100;
+
+   printf("  setup  %8.3f ms, %.3f ms cached\n", first * 1000.0, cached * 1000.0);
+}
+
+static double run(const struct bench_case *c, unsigned mask,
+      const void *input, uint32_t *output, unsigned frames)
+{
+   unsigned i;
+   double start;
+   struct scaler_ctx ctx;
+
+   setup(&ctx, c);
+
+   if (!scaler_ctx_gen_filter(&ctx))
+      return -1.0;
+
+   simd  = mask;
+   start = get_time();
+   for (i = 0; i < frames; i++)
+      scaler_ctx_scale(&ctx, output, input);
+   start = get_time() - start;
+
+   scaler_ctx_gen_reset(&ctx);
+   return start * 1000.0 / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j, host = 0;
+   unsigned frames = argc > 1 ? strtoul(argv[1], NULL, 0) : 100;
+   uint32_t seed   = 1;
+   int ret         = 0;
+   static const struct
+   {
+      const char *ident;
+      unsigned mask;
+   } kernels[] = {
+      { "C",    0 },
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+      { "NEON", SCALER_SIMD_VECTOR },
+#else
+      { "SSE2", SCALER_SIMD_VECTOR },
+#endif
+      { "AVX2", SCALER_SIMD_VECTOR | SCALER_SIMD_AVX2 },
+   };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse2"))
+      host |= SCALER_SIMD_VECTOR;
+   if (__builtin_cpu_supports("avx2"))
+      host |= SCALER_SIMD_AVX2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   host |= SCALER_SIMD_VECTOR;
+#endif
+
+   for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      const struct bench_case *c = &cases[i];
+      size_t in_size  = c->in_width * c->in_height * sizeof(uint32_t);
+      size_t out_size = c->out_width * c->out_height * sizeof(uint32_t);
+      uint8_t *input  = (uint8_t*)malloc(in_size);
+      uint32_t *ref   = (uint32_t*)malloc(out_size);
+      uint32_t *out   = (uint32_t*)malloc(out_size);
+      double base     = 0.0;
+
+      for (j = 0; j < in_size; j++)
+      {
+         seed = seed * 1103515245 + 12345;
+         input[j] = seed >> 24;
+      }
+
+      printf("%s\n", c->ident);
+      run_setup(c);
+
+      for (j = 0; j < sizeof(kernels) / sizeof(kernels[0]); j++)
+      {
+         double msec;
+
+         if ((kernels[j].mask & host) != kernels[j].mask)
+            continue;
+
+         memset(out, 0, out_size);
+         msec = run(c, kernels[j].mask, input, j ? out : ref, frames);
+         if (msec < 0.0)
+         {
+            fprintf(stderr, "Failed to create the scaler.\n");
+            return 1;
+         }
+
+         if (!j)
+            base = msec;
+         else if (memcmp(out, ref, out_size))
+         {
+            fprintf(stderr, "  %s output differs from C.\n", kernels[j].ident);
+            ret = 1;
+         }
+
+         printf("  %-6s %8.3f ms/frame (%.2fx)\n", kernels[j].ident, msec, base / msec);
+      }
+
+      free(input);
+      free(ref);
+      free(out);
+   }
+
+   return ret;
+}
@@ -0,0 +1,237 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that the vector implementations of the softfilters give
+ * the same output as the generic ones, on frames of flat areas,
+ * edges and noise in both pixel formats, and times both.
+ *
+ * Usage: ./softfilter-bench [frames per case] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Builds the filters in, with their entry points renamed. */
+#define RARCH_INTERNAL
+#include "../../gfx/video_filters/lq2x.c"
+#include "../../gfx/video_filters/2xbr.c"
+#include "../../gfx/video_filters/super2xsai.c"
+#include "../../gfx/video_filters/supereagle.c"
+
+/* Rows and columns around the frame that filters may read. */
+#define MARGIN 4
+
+static const struct
+{
+   const char *ident;
+   softfilter_get_implementation_t get;
+} filters[] = {
+   { "lq2x",       lq2x_get_implementation },
+   { "2xbr",       twoxbr_get_implementation },
+   { "super2xsai", supertwoxsai_get_implementation },
+   { "supereagle", supereagle_get_implementation },
+};
+
+static const struct
+{
+   unsigned width, height;
+} sizes[] = {
+   { 256, 224 },
+   { 320, 240 },
+   { 301, 17 },
+   { 13, 9 },
+   { 9, 5 },
+   { 5, 3 },
+};
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Blocks of a few colours, so that pixels often match their 
+ * neighbours, some noise, and a gradient. */
+static void gen_frame(uint8_t *buf, size_t size, unsigned fmt, 
+      unsigned stride, unsigned width, unsigned height)
+{
+   unsigned x, y;
+   uint32_t palette[6];
+   unsigned bpp = fmt == SOFTFILTER_FMT_RGB565 ? 2 : 4;
+
+   for (x = 0; x < size; x++)
+      buf[x] = rnd();
+   for (x = 0; x < 6; x++)
+      palette[x] = rnd() ^ (rnd() << 24);
+
+   for (y = 0; y < height; y++)
+   {
+      uint8_t *row = buf + (y + MARGIN) * stride + MARGIN * bpp;
+
+      for (x = 0; x < width; x++)
+      {
+         uint32_t c;
+         unsigned band = (x / 11 + y / 7) % 4;
+
+         if (band == 0)
+            c = palette[((x * x + y) / 13) % 6];
+         else if (band == 1)
+            c = rnd();
+         else if (band == 2)
+            c = palette[(x + y) & 1];
+         else
+            c = (x * 0x010203 + y * 0x030201) << (fmt == SOFTFILTER_FMT_RGB565 ? 0 : 2);
+
+         if (bpp == 2)
+            ((uint16_t*)row)[x] = c;
+         else
+            ((uint32_t*)row)[x] = c;
+      }
+   }
+}
+
+/* Runs a frame the way the host does, in bands if the 
+ * implementation has process_rows, otherwise in packets. */
+static void run_frame(const struct softfilter_implementation *impl,
+      void *data, uint8_t *out, size_t out_stride,
+      const uint8_t *in, unsigned width, unsigned height, size_t in_stride)
+{
+   unsigned i, threads;
+   struct softfilter_work_packet packets[16];
+
+   if (impl->process_rows)
+   {
+      for (i = 0; i < height; i += 16)
+         impl->process_rows(data, out, out_stride, in, width, height,
+               in_stride, i, height - i < 16 ? height - i : 16);
+      return;
+   }
+
+   threads = impl->query_num_threads(data);
+   impl->get_work_packets(data, packets, out, out_stride,
+         in, width, height, in_stride);
+   for (i = 0; i < threads; i++)
+      packets[i].work(data, packets[i].thread_data);
+}
+
+static double run(const struct softfilter_implementation *impl,
+      unsigned fmt, uint8_t *out, size_t out_stride,
+      const uint8_t *in, unsigned width, unsigned height, size_t in_stride,
+      unsigned frames)
+{
+   unsigned i;
+   double start;
+   void *data = impl->create(NULL, fmt, fmt, width, height, 1,
+         impl->simd, NULL);
+
+   if (!data)
+      return -1.0;
+
+   start = get_time();
+   for (i = 0; i < frames; i++)
+      run_frame(impl, data, out, out_stride, in, width, height, in_stride);
+   start = get_time() - start;
+
+   impl->destroy(data);
+   return start * 1000.0 / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j, k;
+   unsigned frames = argc > 1 ? strtoul(argv[1], NULL, 0) : 100;
+   int ret         = 0;
+   static const unsigned fmts[] = {
+      SOFTFILTER_FMT_RGB565, SOFTFILTER_FMT_XRGB8888
+   };
+
+   for (i = 0; i < sizeof(filters) / sizeof(filters[0]); i++)
+   {
+      const struct softfilter_implementation *generic = filters[i].get(0);
+      const struct softfilter_implementation *vec     = 
+         filters[i].get(~0u);
+
+      if (vec == generic)
+      {
+         printf("%s: no vector implementation\n", filters[i].ident);
+         continue;
+      }
+
+      for (j = 0; j < sizeof(fmts) / sizeof(fmts[0]); j++)
+      {
+         for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+         {
+            unsigned width   = sizes[k].width;
+            unsigned height  = sizes[k].height;
+            unsigned bpp     = fmts[j] == SOFTFILTER_FMT_RGB565 ? 2 : 4;
+            size_t in_stride = (width + 2 * MARGIN) * bpp;
+            size_t in_size   = in_stride * (height + 2 * MARGIN);
+            size_t out_stride = 2 * width * bpp;
+            size_t out_size  = out_stride * 2 * height;
+            uint8_t *input   = (uint8_t*)malloc(in_size);
+            uint8_t *ref     = (uint8_t*)malloc(out_size);
+            uint8_t *out     = (uint8_t*)malloc(out_size);
+            const uint8_t *in = input + MARGIN * in_stride + MARGIN * bpp;
+            unsigned n = width * height > 10000 ? frames : 1;
+            double base, msec;
+
+            gen_frame(input, in_size, fmts[j], in_stride, width, height);
+            memset(ref, 0, out_size);
+            memset(out, 0xff, out_size);
+
+            base = run(generic, fmts[j], ref, out_stride, in,
+                  width, height, in_stride, n);
+            msec = run(vec, fmts[j], out, out_stride, in,
+                  width, height, in_stride, n);
+
+            if (base < 0.0 || msec < 0.0)
+            {
+               fprintf(stderr, "Failed to create %s.\n", filters[i].ident);
+               return 1;
+            }
+
+            if (memcmp(out, ref, out_size))
+            {
+               printf("%-10s %-8s %3ux%-3u MISMATCH\n", filters[i].ident,
+                     bpp == 2 ? "rgb565" : "xrgb8888", width, height);
+               ret = 1;
+            }
+            else if (n > 1)
+               printf("%-10s %-8s %3ux%-3u %7.3f ms -> %7.3f ms (%.2fx)\n",
+                     filters[i].ident, bpp == 2 ? "rgb565" : "xrgb8888",
+                     width, height, base, msec, base / msec);
+
+            free(input);
+            free(ref);
+            free(out);
+         }
+      }
+   }
+
+   if (!ret)
+      printf("All vector implementations match the generic ones.\n");
+   return ret;
+}
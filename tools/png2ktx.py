@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+
+"""
+Python 3 script which converts PNG menu and overlay assets to
+pre-compressed KTX textures, written next to each PNG.
+RetroArch loads foo.ktx instead of foo.png when the GPU supports
+its format, and falls back to the PNG otherwise.
+License: Public domain
+"""
+
+import sys
+if sys.version_info<(3,0,0):
+    sys.stderr.write("You need python 3.0 or later to run this script\n")
+    exit(1)
+
+import os
+import shutil
+import struct
+import subprocess
+
+# PVRTexToolCLI format names. Only formats with alpha, as most
+# assets have it.
+formats = {
+   'etc2' : 'ETC2_RGBA,UBN,lRGB',
+   'astc' : 'ASTC_4x4,UBN,lRGB',
+   'bc3'  : 'BC3,UBN,lRGB',
+}
+
+ktx_identifier = b'\xabKTX 11\xbb\r\n\x1a\n'
+
+def check_ktx(path):
+   with open(path, 'rb') as f:
+      header = f.read(64)
+
+   if len(header) < 64 or header[0:12] != ktx_identifier:
+      return False
+
+   endian = '<' if struct.unpack('<I', header[12:16])[0] == 0x04030201 else '>'
+   gl_type = struct.unpack(endian + 'I', header[16:20])[0]
+   # Uncompressed textures would not save anything.
+   return gl_type == 0
+
+def convert(tool, fmt, mipmaps, source, dest):
+   cmd = [tool, '-i', source, '-o', dest, '-f', formats[fmt]]
+   if mipmaps:
+      cmd.append('-m')
+
+   ret = subprocess.call(cmd, stdout = subprocess.DEVNULL)
+   if ret != 0 or not os.path.isfile(dest):
+      return False
+
+   if not check_ktx(dest):
+      os.remove(dest)
+      return False
+
+   return True
+
+def up_to_date(source, dest):
+   return os.path.isfile(dest) and \
+         os.path.getmtime(dest) >= os.path.getmtime(source)
+
+def main():
+   args = sys.argv[1:]
+   mipmaps = True
+   force = False
+
+   while args and args[0].startswith('--'):
+      opt = args.pop(0)
+      if opt == '--no-mipmaps':
+         mipmaps = False
+      elif opt == '--force':
+         force = True
+      else:
+         args = []
+
+   if len(args) != 2 or args[0] not in formats:
+      print('Usage: {} [--no-mipmaps] [--force] format assets-dir'.format(sys.argv[0]))
+      print('Formats: {}.'.format(', '.join(sorted(formats))))
+      print('Pick etc2 or astc for GLES devices, bc3 for desktop GPUs.')
+      print('Requires Python 3 and PVRTexToolCLI in PATH.')
+      return 1
+
+   fmt, root = args
+   tool = shutil.which('PVRTexToolCLI')
+   if not tool:
+      print('PVRTexToolCLI not found.')
+      return 1
+
+   success_cnt = 0
+   skipped_cnt = 0
+   failed_files = []
+
+   for dirname, _, filenames in os.walk(root):
+      for filename in sorted(filenames):
+         if os.path.splitext(filename)[1].lower() != '.png':
+            continue
+
+         source = os.path.join(dirname, filename)
+         dest = os.path.splitext(source)[0] + '.ktx'
+
+         if not force and up_to_date(source, dest):
+            skipped_cnt += 1
+            continue
+
+         if convert(tool, fmt, mipmaps, source, dest):
+            print(source, '->', dest)
+            success_cnt += 1
+         else:
+            failed_files.append(source)
+
+   print(success_cnt, 'textures converted,', skipped_cnt, 'up to date.')
+   if failed_files:
+      print(len(failed_files), 'textures failed:')
+      for path in failed_files:
+         print(path)
+      return 1
+
+   return 0
+
+if __name__ == '__main__':
+   sys.exit(main())
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+
+"""
+Python 3 script which encodes a dump made by the "raw" record
+driver with ffmpeg. Any ffmpeg output options may follow the file
+names, the default is lossless x264 with FLAC audio.
+License: Public domain
+"""
+
+import sys
+if sys.version_info<(3,0,0):
+   sys.stderr.write("You need python 3.0 or later to run this script\n")
+   exit(1)
+
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+
+header_format = '=8sIIddIIIIf5I'
+packet_format = '=6I'
+packet_size = struct.calcsize(packet_format)
+
+PACKET_VIDEO = 1
+PACKET_DUPE = 2
+PACKET_AUDIO = 3
+
+# ffemu_pix_format to ffmpeg pixel format and bytes per pixel.
+pix_fmts = {
+   0 : ('rgb565le', 2),
+   1 : ('bgr24', 3),
+   2 : ('bgr0', 4),
+   3 : ('yuv420p', 1),
+}
+
+default_options = ['-c:v', 'libx264', '-qp', '0', '-preset', 'fast',
+      '-c:a', 'flac']
+
+class Dump:
+   def __init__(self, path):
+      self.f = open(path, 'rb')
+      data = self.f.read(struct.calcsize(header_format))
+      if len(data) < struct.calcsize(header_format):
+         raise ValueError('truncated header')
+
+      fields = struct.unpack(header_format, data)
+      if fields[0] != b'RARAWDMP' or fields[1] != 1:
+         raise ValueError('not a raw dump, or an unknown version')
+
+      (self.fps, self.samplerate, self.channels, self.pix_fmt,
+            self.width, self.height, self.aspect) = fields[3:10]
+      if self.pix_fmt not in pix_fmts:
+         raise ValueError('unknown pixel format {}'.format(self.pix_fmt))
+
+      self.data_start = fields[2]
+
+   def packets(self):
+      self.f.seek(self.data_start)
+      while True:
+         data = self.f.read(packet_size)
+         if len(data) < packet_size:
+            return
+
+         ptype, size, width, height, pitch, _ = struct.unpack(packet_format, data)
+         # Zeroes are preallocated space left by a crash.
+         if ptype == 0:
+            return
+
+         yield ptype, size, width, height, pitch
+
+   def read(self, size):
+      data = self.f.read(size)
+      if len(data) < size:
+         raise EOFError
+      return data
+
+   def skip(self, size):
+      self.f.seek(size, os.SEEK_CUR)
+
+# Places a frame top-left on a canvas of the largest frame size.
+def pad_plane(frame, width, height, bpp, out_width, out_height, fill = 0):
+   if width == out_width and height == out_height:
+      return frame
+
+   line = width * bpp
+   pad = bytes([fill]) * ((out_width - width) * bpp)
+   out = bytearray()
+   for y in range(height):
+      out += frame[y * line:(y + 1) * line]
+      out += pad
+   out += bytes([fill]) * (out_width * bpp * (out_height - height))
+   return bytes(out)
+
+def pad_frame(frame, pix_fmt, width, height, out_width, out_height):
+   fmt, bpp = pix_fmts[pix_fmt]
+   if fmt != 'yuv420p':
+      return pad_plane(frame, width, height, bpp, out_width, out_height)
+
+   # I420 planes are padded separately, black has neutral chroma.
+   y_size = width * height
+   c_size = y_size // 4
+   out = pad_plane(frame[:y_size], width, height, 1, out_width, out_height)
+   for start in (y_size, y_size + c_size):
+      out += pad_plane(frame[start:start + c_size], width // 2, height // 2,
+            1, out_width // 2, out_height // 2, 0x80)
+   return out
+
+def main():
+   args = sys.argv[1:]
+   if len(args) < 2:
+      print('Usage: {} dump output [ffmpeg options]'.format(sys.argv[0]))
+      print('Example: {} game.rawdump game.mkv'.format(sys.argv[0]))
+      print('Requires Python 3 and ffmpeg in PATH.')
+      return 1
+
+   ffmpeg = shutil.which('ffmpeg')
+   if not ffmpeg:
+      print('ffmpeg not found.')
+      return 1
+
+   try:
+      dump = Dump(args[0])
+   except (OSError, ValueError) as e:
+      print('Failed to open {}: {}.'.format(args[0], e))
+      return 1
+
+   pix_fmt = pix_fmts[dump.pix_fmt][0]
+
+   # First pass: audio goes to a temporary file, since ffmpeg can't
+   # take two streams on its stdin, and frames may change size.
+   width, height = 0, 0
+   frames = 0
+   audio = tempfile.NamedTemporaryFile(suffix = '.s16le', delete = False)
+   try:
+      try:
+         for ptype, size, w, h, _ in dump.packets():
+            if ptype == PACKET_AUDIO:
+               audio.write(dump.read(size))
+               continue
+
+            if ptype == PACKET_VIDEO:
+               width = max(width, w)
+               height = max(height, h)
+            frames += 1
+            dump.skip(size)
+      except EOFError:
+         print('Dump is truncated, encoding what is there.')
+      audio.close()
+
+      if not frames or not width:
+         print('Dump has no video.')
+         return 1
+
+      if pix_fmt == 'yuv420p':
+         width += width & 1
+         height += height & 1
+
+      cmd = [ffmpeg, '-y', '-loglevel', 'warning',
+            '-f', 'rawvideo', '-pix_fmt', pix_fmt,
+            '-s', '{}x{}'.format(width, height),
+            '-r', repr(dump.fps), '-i', '-',
+            '-f', 's16le', '-ar', str(int(round(dump.samplerate))),
+            '-ac', str(dump.channels), '-i', audio.name]
+      if dump.aspect > 0:
+         cmd += ['-aspect', '{:.6f}'.format(dump.aspect)]
+      cmd += args[2:] or default_options
+      cmd.append(args[1])
+
+      # Second pass: frames go to ffmpeg, dupes repeat the last one.
+      encoder = subprocess.Popen(cmd, stdin = subprocess.PIPE)
+      last = pad_frame(b'', dump.pix_fmt, 0, 0, width, height)
+      try:
+         for ptype, size, w, h, _ in dump.packets():
+            if ptype == PACKET_VIDEO:
+               last = pad_frame(dump.read(size), dump.pix_fmt,
+                     w, h, width, height)
+            elif ptype != PACKET_DUPE:
+               dump.skip(size)
+               continue
+
+            encoder.stdin.write(last)
+      except (EOFError, BrokenPipeError):
+         pass
+
+      try:
+         encoder.stdin.close()
+      except BrokenPipeError:
+         pass
+      ret = encoder.wait()
+   finally:
+      os.remove(audio.name)
+
+   if ret != 0:
+      print('ffmpeg failed.')
+      return 1
+
+   print(frames, 'frames encoded to', args[1])
+   return 0
+
+if __name__ == '__main__':
+   sys.exit(main())
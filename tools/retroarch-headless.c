@@ -0,0 +1,784 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs many pieces of content on one core at once, without any
+ * drivers, and reports a hash of the frame each one ends up on.
+ *
+ * RetroArch itself runs one core per process, its runloop state
+ * is global. This tool keeps everything a run needs in a
+ * struct headless_session instead, and runs sessions on a thread
+ * pool. Callbacks from the core find their session through a
+ * thread-local pointer, and every worker thread loads its own
+ * copy of the core library, so no two sessions share core
+ * memory either. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <compat/getopt.h>
+#include <compat/strl.h>
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <rthreads/rpool.h>
+#include "../libretro.h"
+#include "../dynamic.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER)
+#define HEADLESS_THREAD_LOCAL __declspec(thread)
+#else
+#define HEADLESS_THREAD_LOCAL __thread
+#endif
+
+struct headless_session
+{
+   const char *content;
+
+   dylib_t lib;
+   void (*retro_init)(void);
+   void (*retro_deinit)(void);
+   unsigned (*retro_api_version)(void);
+   void (*retro_get_system_info)(struct retro_system_info*);
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_run)(void);
+   bool (*retro_load_game)(const struct retro_game_info*);
+   void (*retro_unload_game)(void);
+
+   enum retro_pixel_format pix_fmt;
+   struct retro_frame_time_callback frame_time;
+   bool shutdown;
+   /* Only the frames of the last retro_run() are kept. */
+   bool last_run;
+
+   /* Last frame, BGR24 and top row first. */
+   uint8_t *frame;
+   unsigned width;
+   unsigned height;
+   uint32_t hash;
+
+   unsigned frames_run;
+   double seconds;
+   bool ok;
+};
+
+/* A worker thread, and the copy of the core it loads. */
+struct headless_slot
+{
+   char path[PATH_MAX_LENGTH];
+   bool copied;
+};
+
+static HEADLESS_THREAD_LOCAL struct headless_session *headless_current;
+
+static char *g_core;
+static char *g_output_dir;
+static char *g_system_dir;
+static unsigned g_frames = 600;
+static unsigned g_jobs   = 1;
+static bool g_verbose;
+
+static struct headless_slot *g_slots;
+
+bool rarch_main_verbosity(void)
+{
+   return g_verbose;
+}
+
+static double headless_time(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER count, freq;
+   QueryPerformanceCounter(&count);
+   QueryPerformanceFrequency(&freq);
+   return (double)count.QuadPart / freq.QuadPart;
+#else
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+#endif
+}
+
+#define HEADLESS_SYM(session, x) do { \
+   function_t func = dylib_proc((session)->lib, #x); \
+   memcpy(&(session)->x, &func, sizeof(func)); \
+   if ((session)->x == NULL) { fprintf(stderr, "Failed to load symbol: \"%s\"\n", #x); return false; } \
+} while (0)
+
+static void print_help(void)
+{
+   puts("====================");
+   puts(" retroarch-headless");
+   puts("====================");
+   puts("Usage: retroarch-headless -L <core> [ options ... ] <content> ...");
+   puts("");
+   puts("Runs every content file on the core for a number of frames, without");
+   puts("video, audio or input, several at once. For each one, prints a hash of");
+   puts("the last frame, the frames run, the frames per second and the path.");
+   puts("");
+   puts("-L/--libretro: Path to the libretro core.");
+   puts("-f/--frames: Frames to run every content file for. Default is 600.");
+   puts("-j/--jobs: Content files to run at once. Default is 1.");
+   puts("\tEvery job after the first runs on a copy of the core library.");
+   puts("-o/--output: Directory to write the last frame of every content file to, as BMP.");
+   puts("\tCopies of the core library are also made here.");
+   puts("-s/--system: System directory handed to the core.");
+   puts("-v/--verbose: Show the log of the core.");
+   puts("-h/--help: Show this help message.");
+}
+
+static void headless_log(enum retro_log_level level, const char *fmt, ...)
+{
+   va_list ap;
+
+   if (!g_verbose && level < RETRO_LOG_ERROR)
+      return;
+
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static bool headless_environment_cb(unsigned cmd, void *data)
+{
+   struct headless_session *session = headless_current;
+
+   if (!session)
+      return false;
+
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_OVERSCAN:
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = false;
+         break;
+
+      /* Duplicated frames would leave nothing to hash. */
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+         *(bool*)data = false;
+         break;
+
+      /* Only the last frame is looked at, nothing is heard. */
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+         *(int*)data = session->last_run ? 1 : 0;
+         break;
+
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+         *(const char**)data = g_system_dir;
+         break;
+
+      /* Sessions of the same content would share save files. */
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+         *(const char**)data = NULL;
+         break;
+
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+         ((struct retro_log_callback*)data)->log = headless_log;
+         break;
+
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      {
+         enum retro_pixel_format fmt = *(const enum retro_pixel_format*)data;
+
+         if (fmt != RETRO_PIXEL_FORMAT_0RGB1555 &&
+               fmt != RETRO_PIXEL_FORMAT_XRGB8888 &&
+               fmt != RETRO_PIXEL_FORMAT_RGB565)
+            return false;
+         session->pix_fmt = fmt;
+         break;
+      }
+
+      case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+         session->frame_time = *(const struct retro_frame_time_callback*)data;
+         break;
+
+      case RETRO_ENVIRONMENT_SHUTDOWN:
+         session->shutdown = true;
+         break;
+
+      case RETRO_ENVIRONMENT_SET_ROTATION:
+      case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+      case RETRO_ENVIRONMENT_SET_MESSAGE:
+      case RETRO_ENVIRONMENT_SET_VARIABLES:
+      case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+      case RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_DISK_CONTROL_INTERFACE:
+      case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+      case RETRO_ENVIRONMENT_SET_SUBSYSTEM_INFO:
+      case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+      case RETRO_ENVIRONMENT_SET_GEOMETRY:
+         break;
+
+      /* No hardware rendering, no audio callback,
+       * no core options beyond their defaults. */
+      default:
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * headless_convert_frame:
+ * @session              : session the frame belongs to.
+ * @data                 : frame in the pixel format of @session.
+ * @width                : width of @data.
+ * @height               : height of @data.
+ * @pitch                : pitch of @data.
+ *
+ * Keeps the frame as BGR24, the same layout the BMP is written
+ * in, so the hash is independent of the pitch the core uses.
+ **/
+static void headless_convert_frame(struct headless_session *session,
+      const void *data, unsigned width, unsigned height, size_t pitch)
+{
+   unsigned x, y;
+   uint8_t *out = (uint8_t*)realloc(session->frame, width * height * 3);
+
+   if (!out)
+      return;
+
+   session->frame  = out;
+   session->width  = width;
+   session->height = height;
+
+   for (y = 0; y < height; y++)
+   {
+      const uint8_t *line = (const uint8_t*)data + y * pitch;
+
+      for (x = 0; x < width; x++, out += 3)
+      {
+         unsigned r, g, b;
+
+         if (session->pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+         {
+            uint32_t col = ((const uint32_t*)line)[x];
+            r = (col >> 16) & 0xff;
+            g = (col >>  8) & 0xff;
+            b = (col >>  0) & 0xff;
+         }
+         else if (session->pix_fmt == RETRO_PIXEL_FORMAT_RGB565)
+         {
+            uint16_t col = ((const uint16_t*)line)[x];
+            r = ((col >> 11) & 0x1f) << 3;
+            g = ((col >>  5) & 0x3f) << 2;
+            b = ((col >>  0) & 0x1f) << 3;
+         }
+         else
+         {
+            uint16_t col = ((const uint16_t*)line)[x];
+            r = ((col >> 10) & 0x1f) << 3;
+            g = ((col >>  5) & 0x1f) << 3;
+            b = ((col >>  0) & 0x1f) << 3;
+         }
+
+         out[0] = b;
+         out[1] = g;
+         out[2] = r;
+      }
+   }
+}
+
+static void headless_video_refresh(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   struct headless_session *session = headless_current;
+
+   if (!session || !session->last_run || !data
+         || data == RETRO_HW_FRAME_BUFFER_VALID)
+      return;
+
+   headless_convert_frame(session, data, width, height, pitch);
+}
+
+static void headless_audio_sample(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t headless_audio_sample_batch(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+static void headless_input_poll(void)
+{
+}
+
+static int16_t headless_input_state(unsigned port, unsigned device,
+      unsigned index, unsigned id)
+{
+   (void)port;
+   (void)device;
+   (void)index;
+   (void)id;
+   return 0;
+}
+
+/**
+ * headless_copy_core:
+ * @dst                  : path to copy the core library to.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool headless_copy_core(const char *dst)
+{
+   char buf[64 * 1024];
+   size_t len;
+   bool ret  = true;
+   FILE *in  = fopen(g_core, "rb");
+   FILE *out = in ? fopen(dst, "wb") : NULL;
+
+   if (!out)
+   {
+      if (in)
+         fclose(in);
+      return false;
+   }
+
+   while ((len = fread(buf, 1, sizeof(buf), in)) > 0)
+   {
+      if (fwrite(buf, 1, len, out) != len)
+      {
+         ret = false;
+         break;
+      }
+   }
+
+   fclose(in);
+   if (fclose(out) != 0)
+      ret = false;
+   return ret;
+}
+
+/**
+ * headless_slot_core:
+ * @thread               : worker thread, as passed by rpool_run().
+ *
+ * The first thread loads the core itself, the others a copy
+ * of it, made the first time they need one.
+ *
+ * Returns: path of the core library for @thread, or NULL.
+ **/
+static const char *headless_slot_core(unsigned thread)
+{
+   char name[PATH_MAX_LENGTH], dir[PATH_MAX_LENGTH];
+   struct headless_slot *slot = &g_slots[thread];
+
+   if (thread == 0)
+      return g_core;
+   if (slot->copied)
+      return slot->path;
+
+   if (g_output_dir)
+      strlcpy(dir, g_output_dir, sizeof(dir));
+   else
+      fill_pathname_basedir(dir, g_core, sizeof(dir));
+
+   snprintf(name, sizeof(name), "headless%u_%s",
+         thread, path_basename(g_core));
+   fill_pathname_join(slot->path, dir, name, sizeof(slot->path));
+
+   if (!headless_copy_core(slot->path))
+   {
+      fprintf(stderr, "Failed to copy core to \"%s\".\n", slot->path);
+      remove(slot->path);
+      return NULL;
+   }
+
+   slot->copied = true;
+   return slot->path;
+}
+
+static bool headless_load_core(struct headless_session *session,
+      const char *path)
+{
+   session->lib = dylib_load(path);
+   if (!session->lib)
+      return false;
+
+   HEADLESS_SYM(session, retro_init);
+   HEADLESS_SYM(session, retro_deinit);
+   HEADLESS_SYM(session, retro_api_version);
+   HEADLESS_SYM(session, retro_get_system_info);
+   HEADLESS_SYM(session, retro_set_environment);
+   HEADLESS_SYM(session, retro_set_video_refresh);
+   HEADLESS_SYM(session, retro_set_audio_sample);
+   HEADLESS_SYM(session, retro_set_audio_sample_batch);
+   HEADLESS_SYM(session, retro_set_input_poll);
+   HEADLESS_SYM(session, retro_set_input_state);
+   HEADLESS_SYM(session, retro_run);
+   HEADLESS_SYM(session, retro_load_game);
+   HEADLESS_SYM(session, retro_unload_game);
+
+   return session->retro_api_version() == RETRO_API_VERSION;
+}
+
+/**
+ * headless_read_content:
+ * @info                 : set to the content, with its data.
+ *
+ * For cores which don't load the content from its path.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+static bool headless_read_content(struct retro_game_info *info)
+{
+   long len;
+   void *data = NULL;
+   FILE *file = fopen(info->path, "rb");
+
+   if (!file)
+      return false;
+
+   fseek(file, 0, SEEK_END);
+   len = ftell(file);
+   rewind(file);
+
+   if (len >= 0 && (data = malloc(len + 1)) &&
+         fread(data, 1, len, file) == (size_t)len)
+   {
+      info->data = data;
+      info->size = len;
+   }
+   else
+   {
+      free(data);
+      data = NULL;
+   }
+
+   fclose(file);
+   return data != NULL;
+}
+
+/**
+ * headless_run:
+ * @session              : session to run.
+ * @thread               : worker thread running it.
+ *
+ * Loads the core, runs the content for g_frames frames, or until
+ * the core shuts down, and unloads the core again, so the next
+ * session on this thread starts from a clean library.
+ **/
+static void headless_run(struct headless_session *session, unsigned thread)
+{
+   double start;
+   struct retro_system_info sys = {0};
+   struct retro_game_info info  = {0};
+   const char *path             = headless_slot_core(thread);
+
+   if (!path || !headless_load_core(session, path))
+   {
+      fprintf(stderr, "Failed to load core \"%s\".\n", path ? path : g_core);
+      goto end;
+   }
+
+   headless_current = session;
+   session->pix_fmt = RETRO_PIXEL_FORMAT_0RGB1555;
+
+   session->retro_set_environment(headless_environment_cb);
+   session->retro_init();
+   session->retro_set_video_refresh(headless_video_refresh);
+   session->retro_set_audio_sample(headless_audio_sample);
+   session->retro_set_audio_sample_batch(headless_audio_sample_batch);
+   session->retro_set_input_poll(headless_input_poll);
+   session->retro_set_input_state(headless_input_state);
+
+   session->retro_get_system_info(&sys);
+   info.path = session->content;
+   if (!sys.need_fullpath && !headless_read_content(&info))
+   {
+      fprintf(stderr, "Failed to read \"%s\".\n", session->content);
+      goto deinit;
+   }
+
+   if (!session->retro_load_game(&info))
+   {
+      fprintf(stderr, "Core failed to load \"%s\".\n", session->content);
+      goto deinit;
+   }
+
+   start = headless_time();
+
+   while (session->frames_run < g_frames && !session->shutdown)
+   {
+      session->last_run = session->frames_run + 1 == g_frames;
+
+      if (session->frame_time.callback)
+         session->frame_time.callback(session->frame_time.reference);
+      session->retro_run();
+      session->frames_run++;
+   }
+
+   session->seconds = headless_time() - start;
+   session->ok      = true;
+
+   session->retro_unload_game();
+
+deinit:
+   session->retro_deinit();
+   free((void*)info.data);
+end:
+   headless_current = NULL;
+   if (session->lib)
+      dylib_close(session->lib);
+   session->lib = NULL;
+}
+
+static uint32_t headless_hash(const uint8_t *data, size_t size)
+{
+   size_t i;
+   uint32_t hash = 2166136261u;
+
+   for (i = 0; i < size; i++)
+   {
+      hash ^= data[i];
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static bool headless_write_bmp(const char *path, const uint8_t *data,
+      unsigned width, unsigned height)
+{
+   unsigned i;
+   bool ret               = true;
+   unsigned line_size     = (width * 3 + 3) & ~3;
+   unsigned size_array    = line_size * height;
+   unsigned size          = size_array + 54;
+   static const uint8_t pad[3];
+   uint8_t header[54]     = {'B', 'M'};
+   FILE *file             = fopen(path, "wb");
+
+   if (!file)
+      return false;
+
+#define HEADLESS_DWORD(off, val) do { \
+   header[(off) + 0] = (uint8_t)((val) >>  0); \
+   header[(off) + 1] = (uint8_t)((val) >>  8); \
+   header[(off) + 2] = (uint8_t)((val) >> 16); \
+   header[(off) + 3] = (uint8_t)((val) >> 24); \
+} while (0)
+   HEADLESS_DWORD(2, size);
+   HEADLESS_DWORD(10, 54);
+   HEADLESS_DWORD(14, 40);
+   HEADLESS_DWORD(18, width);
+   HEADLESS_DWORD(22, height);
+   header[26] = 1;
+   header[28] = 24;
+   HEADLESS_DWORD(34, size_array);
+   HEADLESS_DWORD(38, 2835);
+   HEADLESS_DWORD(42, 2835);
+#undef HEADLESS_DWORD
+
+   if (fwrite(header, 1, sizeof(header), file) != sizeof(header))
+      ret = false;
+
+   /* BMP is stored bottom-up, with lines padded to 4 bytes. */
+   for (i = height; ret && i > 0; i--)
+   {
+      if (fwrite(data + (i - 1) * width * 3, 1, width * 3, file) != width * 3
+            || fwrite(pad, 1, line_size - width * 3, file)
+            != line_size - width * 3)
+         ret = false;
+   }
+
+   if (fclose(file) != 0)
+      ret = false;
+   return ret;
+}
+
+static void headless_work(void *userdata, unsigned index, unsigned thread)
+{
+   struct headless_session *session =
+      &((struct headless_session*)userdata)[index];
+
+   headless_run(session, thread);
+
+   if (!session->ok || !session->frame)
+      return;
+
+   session->hash = headless_hash(session->frame,
+         session->width * session->height * 3);
+
+   if (g_output_dir)
+   {
+      char name[PATH_MAX_LENGTH], path[PATH_MAX_LENGTH];
+
+      fill_pathname_base(name, session->content, sizeof(name));
+      path_remove_extension(name);
+      strlcat(name, ".bmp", sizeof(name));
+      fill_pathname_join(path, g_output_dir, name, sizeof(path));
+
+      if (!headless_write_bmp(path, session->frame,
+               session->width, session->height))
+         fprintf(stderr, "Failed to write \"%s\".\n", path);
+   }
+}
+
+static void parse_input(int argc, char *argv[])
+{
+   char optstring[] = "L:f:j:o:s:vh";
+   struct option opts[] = {
+      { "libretro", 1, NULL, 'L' },
+      { "frames", 1, NULL, 'f' },
+      { "jobs", 1, NULL, 'j' },
+      { "output", 1, NULL, 'o' },
+      { "system", 1, NULL, 's' },
+      { "verbose", 0, NULL, 'v' },
+      { "help", 0, NULL, 'h' },
+      { NULL, 0, NULL, 0 }
+   };
+
+   int option_index = 0;
+   for (;;)
+   {
+      int c = getopt_long(argc, argv, optstring, opts, &option_index);
+      if (c == -1)
+         break;
+
+      switch (c)
+      {
+         case 'h':
+            print_help();
+            exit(0);
+
+         case 'L':
+            g_core = strdup(optarg);
+            break;
+
+         case 'f':
+            g_frames = strtoul(optarg, NULL, 0);
+            break;
+
+         case 'j':
+            g_jobs = strtoul(optarg, NULL, 0);
+            if (g_jobs < 1)
+            {
+               fprintf(stderr, "At least one job is needed.\n");
+               exit(1);
+            }
+            break;
+
+         case 'o':
+            g_output_dir = strdup(optarg);
+            break;
+
+         case 's':
+            g_system_dir = strdup(optarg);
+            break;
+
+         case 'v':
+            g_verbose = true;
+            break;
+
+         default:
+            print_help();
+            exit(1);
+      }
+   }
+
+   if (!g_core || optind >= argc)
+   {
+      print_help();
+      exit(1);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, count, threads;
+   struct rpool_attr attr           = {0};
+   rpool_t *pool                    = NULL;
+   struct headless_session *session = NULL;
+   int ret                          = 0;
+
+   parse_input(argc, argv);
+
+   count   = argc - optind;
+   session = (struct headless_session*)calloc(count, sizeof(*session));
+   if (!session)
+      return 1;
+
+   for (i = 0; i < count; i++)
+      session[i].content = argv[optind + i];
+
+   /* The calling thread runs sessions as well. */
+   if (g_jobs > 1)
+   {
+      attr.num_threads = g_jobs - 1;
+      pool             = rpool_new(&attr);
+   }
+
+   threads = rpool_num_threads(pool) + 1;
+   g_slots = (struct headless_slot*)calloc(threads, sizeof(*g_slots));
+   if (!g_slots)
+      return 1;
+
+   rpool_run(pool, headless_work, session, count);
+   rpool_free(pool);
+
+   for (i = 0; i < count; i++)
+   {
+      if (!session[i].ok)
+      {
+         printf("failed   - - %s\n", session[i].content);
+         ret = 1;
+         continue;
+      }
+
+      if (session[i].frame)
+         printf("%08x", (unsigned)session[i].hash);
+      else
+         printf("--------");
+
+      printf(" %u %.1f %s\n", session[i].frames_run,
+            session[i].seconds > 0.0 ?
+            session[i].frames_run / session[i].seconds : 0.0,
+            session[i].content);
+      free(session[i].frame);
+   }
+
+   for (i = 0; i < threads; i++)
+   {
+      if (g_slots[i].copied)
+         remove(g_slots[i].path);
+   }
+
+   free(g_slots);
+   free(session);
+   free(g_core);
+   free(g_output_dir);
+   free(g_system_dir);
+   return ret;
+}
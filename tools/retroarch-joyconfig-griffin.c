@@ -46,6 +46,7 @@
 
 #include "../libretro-common/queues/fifo_buffer.c"
 #include "../libretro-common/file/config_file.c"
+#include "../libretro-common/memory/ralloc.c"
 #include "../libretro-common/file/file_path.c"
 #include "../file_path_special.c"
 #include "../libretro-common/string/string_list.c"
@@ -76,6 +77,7 @@
 #include "../input/connect/connect_ps3.c"
 #include "../input/connect/connect_ps4.c"
 #include "../input/connect/connect_wii.c"
+#include "../input/connect/connect_generic.c"
 #endif
 
 #include "../input/drivers_joypad/hid_joypad.c"